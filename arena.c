@@ -10,8 +10,10 @@ static inline size_t align_up(size_t n, size_t align) {
     return (n + align - 1) & ~(align - 1);
 }
 
-static ArenaBlock *block_new(size_t min_size) {
-    size_t sz = min_size > ARENA_DEFAULT_BLOCK ? min_size : ARENA_DEFAULT_BLOCK;
+static ArenaBlock *block_new(size_t block_size, size_t min_size) {
+    // block_size is 0 for zero-initialised arenas that never saw arena_init.
+    if (block_size == 0) block_size = ARENA_DEFAULT_BLOCK;
+    size_t sz = min_size > block_size ? min_size : block_size;
     // Allocate the header and the usable memory in one shot.
     ArenaBlock *b = malloc(sizeof(ArenaBlock) + sz);
     if (!b) {
@@ -82,7 +84,7 @@ void *arena_alloc(Arena *a, size_t size) {
     }
 
     // Slow path: allocate a new block.
-    ArenaBlock *b = block_new(size);
+    ArenaBlock *b = block_new(a->block_size, size);
     b->next           = a->current;
     a->current        = b;
     a->total_allocated += b->size;
@@ -179,3 +181,39 @@ void arena_print_stats(const Arena *a, const char *label) {
                 ? 100.0 * (double)a->total_used / (double)a->total_allocated
                 : 0.0);
 }
+
+///  Fixed-size pools
+
+void arena_pool_init(ArenaPool *p, size_t obj_size, size_t block_size) {
+    if (obj_size < sizeof(ArenaPoolFree)) obj_size = sizeof(ArenaPoolFree);
+    arena_init(&p->arena, block_size);
+    p->free_list = NULL;
+    p->obj_size  = align_up(obj_size, ARENA_ALIGN);
+    p->allocs    = 0;
+    p->releases  = 0;
+    p->reused    = 0;
+}
+
+void arena_pool_free(ArenaPool *p) {
+    arena_free(&p->arena);
+    p->free_list = NULL;
+}
+
+void *arena_pool_alloc(ArenaPool *p) {
+    p->allocs++;
+    ArenaPoolFree *f = p->free_list;
+    if (f) {
+        p->free_list = f->next;
+        p->reused++;
+        return f;
+    }
+    return arena_alloc(&p->arena, p->obj_size);
+}
+
+void arena_pool_release(ArenaPool *p, void *obj) {
+    if (!obj) return;
+    ArenaPoolFree *f = obj;
+    f->next      = p->free_list;
+    p->free_list = f;
+    p->releases++;
+}
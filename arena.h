@@ -110,4 +110,47 @@ void arena_restore(Arena *a, ArenaCheckpoint cp);
 // Print a one-line summary of arena state to stderr.
 void arena_print_stats(const Arena *a, const char *label);
 
+///  Fixed-size pools
+//
+//  An ArenaPool hands out objects of a single size carved from its own
+//  arena blocks.  Released objects are threaded onto an intrusive free list
+//  and handed out again before the arena is bumped, so both alloc and
+//  release are O(1) and the steady state never calls malloc.
+//
+//  Blocks are only returned to the OS by arena_pool_free(); releasing an
+//  object just recycles it.
+//
+//    ArenaPool cells;
+//    arena_pool_init(&cells, sizeof(Cell), 0);
+//    Cell *c = arena_pool_alloc(&cells);
+//    arena_pool_release(&cells, c);
+//    arena_pool_free(&cells);
+//
+
+typedef struct ArenaPoolFree {
+    struct ArenaPoolFree *next;
+} ArenaPoolFree;
+
+typedef struct {
+    Arena          arena;       // backing blocks
+    ArenaPoolFree *free_list;   // recycled objects, LIFO
+    size_t         obj_size;    // rounded up to ARENA_ALIGN
+    size_t         allocs;      // lifetime allocations
+    size_t         releases;    // lifetime releases
+    size_t         reused;      // allocations served from the free list
+} ArenaPool;
+
+// Initialise a pool for objects of `obj_size` bytes.  block_size=0 uses
+// ARENA_DEFAULT_BLOCK for the backing arena.
+void  arena_pool_init(ArenaPool *p, size_t obj_size, size_t block_size);
+
+// Free every block owned by the pool.  All objects become invalid.
+void  arena_pool_free(ArenaPool *p);
+
+// Allocate one object.  Never returns NULL (aborts on OOM).
+void *arena_pool_alloc(ArenaPool *p);
+
+// Return an object to the pool's free list.  NULL is ignored.
+void  arena_pool_release(ArenaPool *p, void *obj);
+
 #endif // ARENA_H
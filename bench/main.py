@@ -0,0 +1,468 @@
+#!/usr/bin/env python3
+"""Benchmark harness behind `monad bench`.
+
+Every benchmark is timed as a fresh process: a compiled program, a
+`--bc` run on the bytecode VM, or a whole compile with a cold or warm
+module cache.  Results can be written as JSON, saved as a baseline, and
+compared against one with a rank test so a noisy run is not reported as
+a regression.
+"""
+
+import argparse
+import json
+import math
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from dataclasses import dataclass
+from datetime import datetime, timezone
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+CORPUS = ROOT / "bench" / "corpus"
+sys.path.insert(0, str(ROOT / "tests"))
+
+from monad_binary import generated_executable, resolve_monad_binary, resolve_runtime_archive  # noqa: E402
+
+
+SCHEMA = "monad-bench/1"
+DEFAULT_BASELINE = Path.home() / ".cache" / "monad" / "bench" / "baseline.json"
+
+
+@dataclass(frozen=True)
+class Benchmark:
+    name: str
+    source: str
+    kind: str          # run | bytecode | compile-cold | compile-warm
+    description: str
+    flags: tuple[str, ...] = ("-O2",)
+
+
+BENCHMARKS: dict[str, Benchmark] = {
+    "nbody": Benchmark(
+        "nbody", "NBody.mon", "run",
+        "Float arithmetic over mutable globals in a tight integration loop.",
+    ),
+    "binary-trees": Benchmark(
+        "binary-trees", "BinaryTrees.mon", "run",
+        "Short-lived ADT trees: allocator and collector throughput.",
+    ),
+    "map-set-churn": Benchmark(
+        "map-set-churn", "MapSetChurn.mon", "run",
+        "Insert, delete and probe mutable maps and sets.",
+    ),
+    "lazy-pipeline": Benchmark(
+        "lazy-pipeline", "LazyPipeline.mon", "run",
+        "map/filter/take/foldl over infinite lazy ranges.",
+    ),
+    "pmatch-interp": Benchmark(
+        "pmatch-interp", "PmatchInterp.mon", "run",
+        "Tree-walking interpreter dispatching on constructor patterns.",
+    ),
+    "typeclass-numeric": Benchmark(
+        "typeclass-numeric", "TypeclassNumeric.mon", "run",
+        "Numeric loops through class methods with Int and Float instances.",
+    ),
+    "bytecode-loop": Benchmark(
+        "bytecode-loop", "BytecodeLoop.mon", "bytecode",
+        "Straight-line module on the bytecode VM: lowering plus dispatch.",
+        ("--bc",),
+    ),
+    "prelude-cold": Benchmark(
+        "prelude-cold", "PreludeCompile.mon", "compile-cold",
+        "Compile a prelude-importing program with an empty module cache.",
+    ),
+    "prelude-warm": Benchmark(
+        "prelude-warm", "PreludeCompile.mon", "compile-warm",
+        "Compile the same program against a warm module cache.",
+    ),
+}
+
+
+def median(xs: list[float]) -> float:
+    s = sorted(xs)
+    n = len(s)
+    if n == 0:
+        return math.nan
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2
+
+
+def summarize(samples: list[float]) -> dict:
+    n = len(samples)
+    mean = sum(samples) / n
+    var = sum((x - mean) ** 2 for x in samples) / (n - 1) if n > 1 else 0.0
+    med = median(samples)
+    return {
+        "median": med,
+        "mean": mean,
+        "stdev": math.sqrt(var),
+        "min": min(samples),
+        "max": max(samples),
+        "mad": median([abs(x - med) for x in samples]),
+    }
+
+
+def mann_whitney_p(a: list[float], b: list[float]) -> float:
+    """Two-sided p-value of the Mann-Whitney U test, normal approximation
+    with tie correction.  Needs no assumption about the timing
+    distribution, which is skewed by scheduler and cache noise."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    pooled = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(pooled)
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        rank = (i + j) / 2 + 1
+        for k in range(i, j + 1):
+            ranks[k] = rank
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, group) in zip(ranks, pooled) if group == 0)
+    u = r1 - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    sigma2 = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if sigma2 <= 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2) - 0.5) / math.sqrt(sigma2)
+    return max(0.0, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2))))
+
+
+def compare(current: dict, baseline: dict, threshold: float, alpha: float = 0.05) -> str:
+    """Classify one benchmark against its baseline: a change counts only
+    when the medians differ by more than threshold and the rank test
+    rejects equal distributions."""
+    ratio = current["median"] / baseline["median"] if baseline["median"] > 0 else math.inf
+    p = mann_whitney_p(current["samples"], baseline["samples"])
+    if p < alpha and ratio > 1 + threshold:
+        return "regression"
+    if p < alpha and ratio < 1 - threshold:
+        return "improvement"
+    return "unchanged"
+
+
+def host_info() -> dict:
+    return {
+        "system": platform.system(),
+        "machine": platform.machine(),
+        "node": platform.node(),
+        "cpus": os.cpu_count() or 1,
+        "python": platform.python_version(),
+    }
+
+
+def git_commit() -> str | None:
+    try:
+        result = subprocess.run(
+            ["git", "rev-parse", "--short", "HEAD"], cwd=ROOT,
+            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True, check=False,
+        )
+    except OSError:
+        return None
+    return result.stdout.strip() or None
+
+
+@dataclass
+class Sample:
+    seconds: float
+    max_rss_kb: int
+    returncode: int
+    stdout: str
+    stderr: str
+
+
+def run_timed(command: list[str], env: dict, cwd: Path, timeout: float) -> Sample:
+    """Run one process and time it from spawn to reap.  On POSIX the
+    child's peak RSS comes from wait4; elsewhere it is reported as 0."""
+    with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err:
+        start = time.perf_counter()
+        proc = subprocess.Popen(command, cwd=cwd, env=env, stdout=out, stderr=err)
+        rss = 0
+        if hasattr(os, "wait4"):
+            timer = threading.Timer(timeout, proc.kill)
+            timer.start()
+            try:
+                _, status, usage = os.wait4(proc.pid, 0)
+            finally:
+                timer.cancel()
+            elapsed = time.perf_counter() - start
+            proc.returncode = os.waitstatus_to_exitcode(status)
+            # ru_maxrss is kilobytes on Linux and bytes on macOS.
+            rss = usage.ru_maxrss // 1024 if sys.platform == "darwin" else usage.ru_maxrss
+        else:
+            try:
+                proc.wait(timeout=timeout)
+            except subprocess.TimeoutExpired:
+                proc.kill()
+                proc.wait()
+            elapsed = time.perf_counter() - start
+        out.seek(0)
+        err.seek(0)
+        return Sample(elapsed, int(rss), proc.returncode,
+                      out.read().decode("utf-8", "replace"),
+                      err.read().decode("utf-8", "replace"))
+
+
+class BenchError(Exception):
+    pass
+
+
+class Runner:
+    def __init__(self, monad: Path, work: Path, timeout: float, check: bool):
+        self.monad = monad
+        self.work = work
+        self.timeout = timeout
+        self.check = check
+        self.home = work / "home"
+        self.home.mkdir()
+        self.env = os.environ.copy()
+        self.env["MONAD_CORE"] = str(ROOT / "core")
+        runtime = resolve_runtime_archive(monad)
+        if runtime.exists():
+            self.env["MONAD_RUNTIME_LIB"] = str(runtime)
+
+    def env_with_home(self, home: Path) -> dict:
+        env = dict(self.env)
+        env["HOME"] = str(home)
+        return env
+
+    def step(self, bench: Benchmark) -> list[str]:
+        """The command timed for one run of bench."""
+        source = str(CORPUS / bench.source)
+        if bench.kind == "run":
+            return [str(self.program(bench))]
+        if bench.kind == "bytecode":
+            return [str(self.monad), source, *bench.flags]
+        return [str(self.monad), source, *bench.flags, "-o", str(self.work / bench.name)]
+
+    def program(self, bench: Benchmark) -> Path:
+        return generated_executable(self.work / bench.name)
+
+    def prepare(self, bench: Benchmark) -> None:
+        if bench.kind != "run":
+            return
+        command = [str(self.monad), str(CORPUS / bench.source), *bench.flags,
+                   "-o", str(self.work / bench.name)]
+        result = run_timed(command, self.env_with_home(self.home), self.work, self.timeout)
+        if result.returncode != 0 or not self.program(bench).exists():
+            raise BenchError(f"compile failed ({result.returncode})\n"
+                             f"{(result.stdout + result.stderr)[-2000:]}")
+
+    def home_for(self, bench: Benchmark, index: int) -> Path:
+        if bench.kind != "compile-cold":
+            return self.home
+        home = self.work / f"cold-home-{index}"
+        shutil.rmtree(home, ignore_errors=True)
+        home.mkdir()
+        return home
+
+    def verify(self, bench: Benchmark, sample: Sample) -> None:
+        if sample.returncode != 0:
+            raise BenchError(f"exited with {sample.returncode}\n"
+                             f"{(sample.stdout + sample.stderr)[-2000:]}")
+        if bench.kind == "bytecode" and "compiling with LLVM instead" in sample.stderr:
+            raise BenchError("module no longer lowers to bytecode\n" + sample.stderr[-2000:])
+        if not self.check:
+            return
+        expected_path = (CORPUS / bench.source).with_suffix(".stdout")
+        if bench.kind.startswith("compile"):
+            sample = run_timed([str(self.program(bench))], self.env, self.work, self.timeout)
+        expected = expected_path.read_text(encoding="utf-8")
+        if sample.stdout != expected:
+            raise BenchError(f"output differs from {expected_path.name}\n"
+                             f"expected:\n{expected[-1000:]}\nactual:\n{sample.stdout[-1000:]}")
+
+    def measure(self, bench: Benchmark, runs: int, warmup: int) -> dict:
+        self.prepare(bench)
+        # A warm compile needs at least one compile to fill the cache.
+        warmup = max(warmup, 1) if bench.kind == "compile-warm" else warmup
+        samples: list[Sample] = []
+        for i in range(warmup + runs):
+            home = self.home_for(bench, i)
+            sample = run_timed(self.step(bench), self.env_with_home(home),
+                               self.work, self.timeout)
+            if i == 0:
+                self.verify(bench, sample)
+            elif sample.returncode != 0:
+                raise BenchError(f"run {i} exited with {sample.returncode}")
+            if i >= warmup:
+                samples.append(sample)
+            if home != self.home:
+                shutil.rmtree(home, ignore_errors=True)
+        seconds = [s.seconds for s in samples]
+        result = {"kind": bench.kind, "source": bench.source,
+                  "flags": list(bench.flags), "samples": seconds}
+        result.update(summarize(seconds))
+        result["max_rss_kb"] = max(s.max_rss_kb for s in samples)
+        return result
+
+
+def load_baseline(path: Path) -> dict | None:
+    try:
+        data = json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return None
+    if data.get("schema") != SCHEMA:
+        print(f"warning: {path} is not a {SCHEMA} document; ignoring it", file=sys.stderr)
+        return None
+    return data
+
+
+def format_ms(seconds: float) -> str:
+    return f"{seconds * 1000:.1f}"
+
+
+def report(results: dict, failures: dict, baseline: dict | None, threshold: float) -> int:
+    regressions = 0
+    base = baseline["benchmarks"] if baseline else {}
+    header = f"{'benchmark':<18} {'median ms':>10} {'± mad':>8} {'min ms':>9} {'rss KiB':>9}"
+    if baseline:
+        header += f" {'baseline':>9} {'ratio':>7} {'p':>6}  status"
+    print(header)
+    for name, r in results.items():
+        line = (f"{name:<18} {format_ms(r['median']):>10} {format_ms(r['mad']):>8}"
+                f" {format_ms(r['min']):>9} {r['max_rss_kb']:>9}")
+        b = base.get(name)
+        if baseline and b and b.get("samples"):
+            status = compare(r, b, threshold)
+            ratio = r["median"] / b["median"] if b["median"] > 0 else math.inf
+            p = mann_whitney_p(r["samples"], b["samples"])
+            r["comparison"] = {"baseline_median": b["median"], "ratio": ratio,
+                               "p": p, "status": status}
+            regressions += status == "regression"
+            line += f" {format_ms(b['median']):>9} {ratio:>7.3f} {p:>6.3f}  {status}"
+        elif baseline:
+            line += f" {'-':>9} {'-':>7} {'-':>6}  new"
+        print(line)
+    for name, message in failures.items():
+        print(f"{name:<18} FAILED: {message.splitlines()[0] if message else ''}")
+    if baseline and baseline.get("host", {}).get("node") != platform.node():
+        print(f"note: baseline was recorded on {baseline.get('host', {}).get('node')!r}; "
+              "timings are only comparable on one machine", file=sys.stderr)
+    return regressions
+
+
+def list_benchmarks() -> int:
+    print("Available benchmarks:")
+    width = max(len(name) for name in BENCHMARKS)
+    for name, bench in BENCHMARKS.items():
+        print(f"  {name:<{width}}  {bench.kind:<12}  {bench.description}")
+    return 0
+
+
+def parse_args(argv: list[str] | None = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        prog="monad bench",
+        description="Run the standard Monad benchmark corpus and track regressions.",
+    )
+    parser.add_argument("names", nargs="*",
+                        help="Benchmarks to run (default: all), or 'list' to show them.")
+    parser.add_argument("--runs", type=int, default=10, help="Timed runs per benchmark (default 10).")
+    parser.add_argument("--warmup", type=int, default=2, help="Untimed runs first (default 2).")
+    parser.add_argument("--json", metavar="FILE",
+                        help="Write machine-readable results to FILE ('-' for stdout).")
+    parser.add_argument("--baseline", metavar="FILE", type=Path,
+                        help=f"Compare against FILE (default {DEFAULT_BASELINE} when it exists).")
+    parser.add_argument("--no-baseline", action="store_true", help="Skip the baseline comparison.")
+    parser.add_argument("--save-baseline", metavar="FILE", nargs="?", const=DEFAULT_BASELINE,
+                        type=Path, help=f"Store these results as the baseline (default {DEFAULT_BASELINE}).")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="Median change, in percent, below which nothing is reported (default 5).")
+    parser.add_argument("--timeout", type=float, default=300.0, help="Seconds before one run is killed.")
+    parser.add_argument("--no-check", action="store_true",
+                        help="Do not compare program output with the expected .stdout.")
+    parser.add_argument("--monad", help="Compiler to benchmark (default: MONAD_BINARY or the checkout build).")
+    args = parser.parse_args(argv)
+    if args.runs < 1 or args.warmup < 0:
+        parser.error("--runs must be positive and --warmup non-negative")
+    return args
+
+
+def main(argv: list[str] | None = None) -> int:
+    args = parse_args(argv)
+    if args.names == ["list"]:
+        return list_benchmarks()
+    unknown = [n for n in args.names if n not in BENCHMARKS]
+    if unknown:
+        print(f"unknown benchmark: {', '.join(unknown)}", file=sys.stderr)
+        list_benchmarks()
+        return 2
+    selected = [BENCHMARKS[n] for n in (args.names or BENCHMARKS)]
+
+    monad = resolve_monad_binary(args.monad)
+    if not monad.exists():
+        print(f"monad binary not found: {monad}", file=sys.stderr)
+        return 2
+
+    baseline = None
+    if not args.no_baseline:
+        path = args.baseline or DEFAULT_BASELINE
+        baseline = load_baseline(path)
+        if args.baseline and baseline is None:
+            print(f"cannot read baseline {path}", file=sys.stderr)
+            return 2
+
+    quiet = args.json == "-"
+    results: dict = {}
+    failures: dict = {}
+    with tempfile.TemporaryDirectory(prefix="monad-bench-") as td:
+        runner = Runner(monad, Path(td), args.timeout, not args.no_check)
+        for bench in selected:
+            if not quiet:
+                print(f"==> {bench.name}", file=sys.stderr, flush=True)
+            try:
+                results[bench.name] = runner.measure(bench, args.runs, args.warmup)
+            except BenchError as exc:
+                failures[bench.name] = str(exc)
+                print(f"<== {bench.name} failed: {exc}", file=sys.stderr, flush=True)
+
+    document = {
+        "schema": SCHEMA,
+        "created": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+        "commit": git_commit(),
+        "monad": str(monad),
+        "host": host_info(),
+        "runs": args.runs,
+        "warmup": args.warmup,
+        "threshold": args.threshold,
+        "benchmarks": results,
+        "failures": failures,
+    }
+    threshold = args.threshold / 100
+    if quiet:
+        regressions = sum(
+            compare(r, baseline["benchmarks"][n], threshold) == "regression"
+            for n, r in results.items()
+            if baseline and baseline["benchmarks"].get(n, {}).get("samples")
+        )
+        json.dump(document, sys.stdout, indent=2)
+        print()
+    else:
+        regressions = report(results, failures, baseline, threshold)
+        if args.json:
+            Path(args.json).write_text(json.dumps(document, indent=2) + "\n", encoding="utf-8")
+
+    if args.save_baseline:
+        if failures:
+            print("not saving a baseline from a run with failures", file=sys.stderr)
+        else:
+            args.save_baseline.parent.mkdir(parents=True, exist_ok=True)
+            args.save_baseline.write_text(json.dumps(document, indent=2) + "\n", encoding="utf-8")
+            if not quiet:
+                print(f"baseline saved to {args.save_baseline}", file=sys.stderr)
+    return 1 if failures or regressions else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -5,6 +5,7 @@
 #include "buildsystem.h"
 #include "module.h"
 #include "reader.h"
+#include "wisp.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -101,6 +102,10 @@ void build_artifact_free(ModuleArtifact *artifact)
     free(artifact->module_name);
     free(artifact->source_path);
     free(artifact->object_path);
+    free(artifact->declared_name);
+    for (size_t i = 0; i < artifact->import_count; i++)
+        free(artifact->imports[i]);
+    free(artifact->imports);
     /* decl and env are managed elsewhere (registry / interpreter). */
     free(artifact);
 }
@@ -233,11 +238,14 @@ ModuleArtifact *build_context_find_by_source(BuildContext *ctx, const char *sour
  //  Line 1: cache version (must equal BUILD_CACHE_VERSION)
  //  Lines 2..N, one per module:
  //
- //      module_name<TAB>source_path<TAB>object_path<TAB>source_hash<TAB>dep1,dep2,...
+ //      module_name<TAB>source_path<TAB>object_path<TAB>source_hash<TAB>imp1,imp2,...<TAB>declared_name
  //
- //  Fields are tab-separated; the dependency list is comma-separated and
- //  may be empty. Lines that don't parse are skipped (forward/backward
- //  compatibility: a malformed manifest just yields a cold cache).
+ //  Fields are tab-separated; the import list is comma-separated and may
+ //  be empty, as may the declared name. The imports are the file's own
+ //  header imports; prelude imports are injected at discovery time, so
+ //  adding a prelude module never needs a cache bump. Lines that don't
+ //  parse are skipped (forward/backward compatibility: a malformed
+ //  manifest just yields a cold cache).
  //
 static char *cache_file_path(const char *build_dir)
 {
@@ -279,18 +287,18 @@ BuildCache *build_cache_load(const char *build_dir)
             continue;
         }
 
-        /* module_name\tsource_path\tobject_path\tsource_hash\tdeps */
-        char *fields[5] = {0};
+        /* module_name\tsource_path\tobject_path\tsource_hash\timports\tdeclared */
+        char *fields[6] = {0};
         char *p = line;
         int nf = 0;
-        for (; nf < 5; nf++) {
+        for (; nf < 6; nf++) {
             fields[nf] = p;
             char *tab = strchr(p, '\t');
             if (!tab) { nf++; break; }
             *tab = '\0';
             p = tab + 1;
         }
-        if (nf < 4) continue; /* malformed line, skip */
+        if (nf < 6) continue; /* malformed line, skip */
 
         ModuleArtifact *a = bs_xmalloc(sizeof(*a));
         memset(a, 0, sizeof(*a));
@@ -301,8 +309,16 @@ BuildCache *build_cache_load(const char *build_dir)
             memcpy(a->source_hash, fields[3], MODULE_HASH_HEX_LEN + 1);
             a->source_hash_valid = true;
         }
-        /* deps (fields[4]) are not needed for freshness checks; the
-           build driver re-discovers deps for any module it compiles. */
+        for (char *imp = fields[4]; imp && *imp; ) {
+            char *comma = strchr(imp, ',');
+            if (comma) *comma = '\0';
+            a->imports = bs_xrealloc(a->imports,
+                                     sizeof(char *) * (a->import_count + 1));
+            a->imports[a->import_count++] = bs_xstrdup(imp);
+            imp = comma ? comma + 1 : NULL;
+        }
+        if (fields[5] && *fields[5])
+            a->declared_name = bs_xstrdup(fields[5]);
 
         cache_grow(cache);
         cache->entries[cache->count++] = a;
@@ -360,14 +376,11 @@ bool build_cache_save(BuildContext *ctx)
         fprintf(f, "%s\t%s\t%s\t%s\t",
                 a->module_name, a->source_path, a->object_path, a->source_hash);
 
-        ModuleRegistryEntry *entry = module_registry_find(ctx->registry, a->module_name);
-        if (entry) {
-            for (size_t d = 0; d < entry->dep_count; d++) {
-                if (d) fputc(',', f);
-                fputs(entry->dep_names[d], f);
-            }
+        for (size_t d = 0; d < a->import_count; d++) {
+            if (d) fputc(',', f);
+            fputs(a->imports[d], f);
         }
-        fputc('\n', f);
+        fprintf(f, "\t%s\n", a->declared_name ? a->declared_name : "");
     }
 
     fclose(f);
@@ -388,12 +401,12 @@ void build_cache_free(BuildCache *cache)
 
 //// Module declaration / import extraction
  //
- //  Reads and parses a source file just far enough to collect its
- //  `(module ...)`, `(export ...)`, and `(import ...)` forms — stopping at
- //  the first declaration that isn't one of those three, since by
- //  language convention all module-level declarations come first.
+ //  Reads a source file and parses only its prologue, as delimited by
+ //  module_scan_header: the `module`, `export` and `import` forms, which
+ //  by language convention come before every other declaration.  The body
+ //  is never lexed, so discovery cost tracks header size, not file size.
  //
-ModuleContext *build_extract_module_context(const char *source_path)
+static ModuleContext *extract_header_context(const char *source_path)
 {
     FILE *f = fopen(source_path, "r");
     if (!f) return NULL;
@@ -408,8 +421,12 @@ ModuleContext *build_extract_module_context(const char *source_path)
     source[got] = '\0';
     fclose(f);
 
-    parser_set_context(source_path, source);
-    ASTList exprs = parse_all(source);
+    ModuleHeader header;
+    module_scan_header(source, &header);
+    source[header.end] = '\0';
+    module_header_free(&header);
+
+    ASTList exprs = wisp_parse_all(source, source_path);
 
     ModuleContext *mod_ctx = module_context_create();
     module_context_set_file(mod_ctx, source_path);
@@ -457,8 +474,14 @@ ModuleContext *build_extract_module_context(const char *source_path)
     free(exprs.exprs);
     free(source);
 
-    module_context_add_prelude_imports(mod_ctx);
+    return mod_ctx;
+}
 
+ModuleContext *build_extract_module_context(const char *source_path)
+{
+    ModuleContext *mod_ctx = extract_header_context(source_path);
+    if (mod_ctx)
+        module_context_add_prelude_imports(mod_ctx);
     return mod_ctx;
 }
 
@@ -498,6 +521,47 @@ static char *discover_module_name(const char *source_path)
     return name; /* caller frees */
 }
 
+//// Header cache
+ //
+ //  While a module's source hash matches its manifest entry, the entry's
+ //  declared name and imports stand in for its header, and discovery
+ //  reads the file only to hash it.  Only the import names are cached;
+ //  the build graph needs nothing else.
+ //
+static ModuleContext *discover_cached_context(BuildContext *build_ctx,
+                                              ModuleArtifact *artifact)
+{
+    if (build_ctx->force_rebuild || !artifact->source_hash_valid) return NULL;
+
+    ModuleArtifact *cached = build_cache_find(build_ctx->cache, artifact->module_name);
+    if (!cached || !cached->source_hash_valid ||
+        strcmp(cached->source_hash, artifact->source_hash) != 0 ||
+        strcmp(cached->source_path, artifact->source_path) != 0)
+        return NULL;
+
+    ModuleContext *mod_ctx = module_context_create();
+    module_context_set_file(mod_ctx, artifact->source_path);
+    if (cached->declared_name)
+        module_context_set_decl(mod_ctx,
+            module_decl_create(cached->declared_name, EXPORT_ALL));
+    for (size_t i = 0; i < cached->import_count; i++)
+        module_context_add_import(mod_ctx,
+            import_decl_create(cached->imports[i], NULL, IMPORT_UNQUALIFIED));
+    return mod_ctx;
+}
+
+/* Remember the header just read so the manifest can carry it. */
+static void discover_record_header(ModuleArtifact *artifact, ModuleContext *mod_ctx)
+{
+    free(artifact->declared_name);
+    for (size_t i = 0; i < artifact->import_count; i++)
+        free(artifact->imports[i]);
+    free(artifact->imports);
+
+    artifact->declared_name = mod_ctx->decl ? bs_xstrdup(mod_ctx->decl->name) : NULL;
+    artifact->imports = module_dep_list_from_context(mod_ctx, &artifact->import_count);
+}
+
 static bool discover_recursive(BuildContext *build_ctx, const char *module_name,
                                 const char *source_path)
 {
@@ -510,22 +574,27 @@ static bool discover_recursive(BuildContext *build_ctx, const char *module_name,
         return false;
     }
 
-    if (build_ctx->verbose)
-        printf("Discovering %s (%s)\n", module_name, source_path);
-
-    ModuleContext *mod_ctx = build_extract_module_context(source_path);
-    if (!mod_ctx) {
-        fprintf(stderr, "Error: Failed to read module '%s' from %s\n",
-                module_name, source_path);
-        return false;
-    }
-
     ModuleArtifact *artifact = build_context_find_by_source(build_ctx, source_path);
     if (!artifact) {
         artifact = build_artifact_create(module_name, source_path);
         build_context_add_artifact(build_ctx, artifact);
     }
 
+    ModuleContext *mod_ctx = discover_cached_context(build_ctx, artifact);
+    if (build_ctx->verbose)
+        printf("Discovering %s (%s)%s\n", module_name, source_path,
+               mod_ctx ? " [cached header]" : "");
+    if (!mod_ctx) {
+        mod_ctx = extract_header_context(source_path);
+        if (!mod_ctx) {
+            fprintf(stderr, "Error: Failed to read module '%s' from %s\n",
+                    module_name, source_path);
+            return false;
+        }
+    }
+    discover_record_header(artifact, mod_ctx);
+    module_context_add_prelude_imports(mod_ctx);
+
     /* Register the module declaration (or a default all-exporting one
        if the file has no explicit `(module ...)` form). */
     ModuleDecl *decl = mod_ctx->decl;
@@ -573,7 +642,9 @@ static bool compile_one(BuildContext *build_ctx, const char *module_name)
         return true;
     }
 
-    build_artifact_update_hash(artifact);
+    /* Discovery hashed the source moments ago. */
+    if (!artifact->source_hash_valid)
+        build_artifact_update_hash(artifact);
 
     bool fresh_in_cache = !build_ctx->force_rebuild &&
                           build_cache_is_fresh(build_ctx->cache, artifact);
@@ -660,38 +731,32 @@ bool build_link_executable(BuildContext *build_ctx,
         output_name = output_with_suffix;
     }
 
-    char cmd[4096] = "gcc ";
-
-    for (size_t i = 0; i < artifact_count; i++) {
-        strcat(cmd, artifacts[i]->object_path);
-        strcat(cmd, " ");
-    }
-
     char *runtime_archive = build_runtime_archive_path();
-    char llvm_flags[1024] = "";
-    FILE *llvm_pipe = popen("llvm-config --ldflags --libs core orcjit native passes", "r");
-    if (llvm_pipe) {
-        size_t used = fread(llvm_flags, 1, sizeof(llvm_flags) - 1, llvm_pipe);
-        pclose(llvm_pipe);
-        llvm_flags[used] = '\0';
-        for (size_t i = 0; i < used; i++) {
-            if (llvm_flags[i] == '\r' || llvm_flags[i] == '\n')
-                llvm_flags[i] = ' ';
-        }
+    char rsp_path[1100];
+    snprintf(rsp_path, sizeof(rsp_path), "%s.rsp", output_name);
+    FILE *rsp = fopen(rsp_path, "w");
+    if (!rsp) {
+        perror(rsp_path);
+        free(runtime_archive);
+        return false;
     }
-    strcat(cmd, runtime_archive);
-    strcat(cmd, " -o ");
-    strcat(cmd, output_name);
-    strcat(cmd, " ");
-    strcat(cmd, llvm_flags);
-    strcat(cmd, " -lm -lgmp");
-    strcat(cmd, host_no_pie_flag);
+    for (size_t i = 0; i < artifact_count; i++)
+        build_rsp_put_path(rsp, artifacts[i]->object_path);
+    build_rsp_put_path(rsp, runtime_archive);
+    fputs("-o\n", rsp);
+    build_rsp_put_path(rsp, output_name);
+    fprintf(rsp, "%s -lm -lgmp -lpthread%s\n", build_llvm_link_flags(), host_no_pie_flag);
+    bool rsp_ok = !ferror(rsp);
+    if (fclose(rsp) != 0) rsp_ok = false;
     free(runtime_archive);
 
+    char cmd[1200];
+    snprintf(cmd, sizeof(cmd), "gcc \"@%s\"", rsp_path);
     if (build_ctx->verbose)
         printf("Linking: %s\n", cmd);
 
-    int ret = system(cmd);
+    int ret = rsp_ok ? system(cmd) : -1;
+    remove(rsp_path);
     if (ret == 0) {
         printf("Created executable: %s\n", output_name);
         return true;
@@ -760,3 +825,40 @@ char *build_module_name_to_object_path(const char *module_name, const char *buil
     snprintf(path, len, "%s/%s.o", build_dir, module_name);
     return path;
 }
+
+const char *build_llvm_link_flags(void)
+{
+    static char *memo = NULL;
+    if (memo) return memo;
+
+    size_t cap = 1024, used = 0;
+    memo = bs_xmalloc(cap);
+    FILE *llvm_pipe = popen("llvm-config --ldflags --libs core orcjit native passes", "r");
+    if (llvm_pipe) {
+        for (;;) {
+            if (used + 1 >= cap) memo = bs_xrealloc(memo, cap *= 2);
+            size_t n = fread(memo + used, 1, cap - used - 1, llvm_pipe);
+            used += n;
+            if (n == 0) break;
+        }
+        pclose(llvm_pipe);
+    }
+    memo[used] = '\0';
+    for (size_t i = 0; i < used; i++) {
+        if (memo[i] == '\r' || memo[i] == '\n')
+            memo[i] = ' ';
+    }
+    while (used > 0 && (memo[used - 1] == ' ' || memo[used - 1] == '\t'))
+        memo[--used] = '\0';
+    return memo;
+}
+
+void build_rsp_put_path(FILE *rsp, const char *arg)
+{
+    fputc('"', rsp);
+    for (const char *p = arg; *p; p++) {
+        if (*p == '"' || *p == '\\') fputc('\\', rsp);
+        fputc(*p, rsp);
+    }
+    fputs("\"\n", rsp);
+}
@@ -15,6 +15,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <time.h>
 
 #include "module.h"
@@ -29,7 +30,7 @@
  //  forces a cold cache on all existing builds (do this whenever the line
  //  format changes incompatibly).
  //
-#define BUILD_CACHE_VERSION   1
+#define BUILD_CACHE_VERSION   2
 #define BUILD_CACHE_FILENAME  ".monad_cache"
 
 
@@ -38,7 +39,8 @@
 //// ModuleArtifact
  //
  //  Everything the build system needs to know about one compiled module.
- //  Owns module_name, source_path, and object_path (heap strings).
+ //  Owns module_name, source_path, object_path, declared_name and
+ //  imports (heap strings).
  //  decl and env are owned by the registry / interpreter respectively.
  //
 typedef struct {
@@ -47,9 +49,12 @@ typedef struct {
     char   *object_path;                        // "build/Std.Math.o"
     time_t  source_mtime;                       // mtime of source file
     time_t  object_mtime;                       // mtime of object file
-    char    source_hash[MODULE_HASH_HEX_LEN+1]; // hex SHA-256 of source
+    char    source_hash[MODULE_HASH_HEX_LEN+1]; // hex XXH64 of source
     bool    source_hash_valid;                  // true once hash computed
     bool    needs_recompile;                    // set by build planner
+    char   *declared_name;                      // from `module`, or NULL
+    char  **imports;                            // header imports, no prelude
+    size_t  import_count;
     ModuleDecl *decl;                           // NULL until discovered
     void       *env;                            // Env* - opaque to build layer
 } ModuleArtifact;
@@ -102,7 +107,9 @@ ModuleArtifact *build_context_find_by_source(BuildContext *ctx,
  //
  //  In-memory image of the cache manifest file.  Entries are
  //  ModuleArtifact* carrying only the fields that matter for freshness
- //  checks (module_name, object_path, source_hash / source_hash_valid).
+ //  checks (module_name, object_path, source_hash / source_hash_valid)
+ //  and the scanned header (declared_name, imports), which discovery
+ //  reuses while the hash still matches.
  //  The entries array is owned by the cache; free with build_cache_free().
  //
 typedef struct BuildCache {
@@ -148,4 +155,11 @@ char   *build_module_name_to_source_path(const char *module_name);
 char   *build_module_name_to_object_path(const char *module_name,
                                          const char *build_dir);
 
+//  Link helpers, shared with the driver in main.c.  build_llvm_link_flags
+//  runs `llvm-config --ldflags --libs` once per process and keeps the
+//  result ("" when llvm-config is missing).  build_rsp_put_path writes one
+//  quoted argument per line of a gcc/clang @response file.
+const char *build_llvm_link_flags(void);
+void        build_rsp_put_path(FILE *rsp, const char *arg);
+
 #endif /* BUILDSYSTEM_H */
@@ -1,3 +1,7 @@
+/* MAP_ANONYMOUS (the baseline JIT's code buffers) is a BSD/glibc extension
+   that -std=c99 hides unless a feature test macro asks for it.            */
+#define _DEFAULT_SOURCE
+
 #include "bytecode.h"
 
 #include <inttypes.h>
@@ -7,9 +11,14 @@
 
 // We should probably take advantage that the language is a lisp somehow.
 
-#if defined(__x86_64__) && defined(__unix__)
+#if !defined(_WIN32)
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#endif
+
+#if defined(__x86_64__) && defined(__unix__)
 #define BC_HAS_X64_JIT 1
 #else
 #define BC_HAS_X64_JIT 0
@@ -44,6 +53,38 @@ typedef struct {
     size_t capacity;
 } CodeBuf;
 
+/* Cursor over one section payload; a failed read latches ok = false and
+ * yields zeroes from then on, so a section is checked once at its end. */
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+    bool                 ok;
+} BinReader;
+
+/* A bc_program_map file.  debug/deopt are the payloads of sections not yet
+ * decoded into the program. */
+struct BcProgramMap {
+    const unsigned char *data;
+    size_t               size;
+    bool                 mmapped;   /* data came from mmap, not malloc */
+    BinReader            debug;
+    BinReader            deopt;
+    bool                 debug_pending;
+    bool                 deopt_pending;
+    bool                 corrupt;   /* a lazily decoded section did not parse */
+};
+
+static void program_page_in(const BcProgram *program, bool debug, bool deopt);
+static void program_own_arrays(BcProgram *program);
+
+typedef struct {
+    BcOp    kind;        /* BLOCK, IF (ELSE once its else is seen) or LOOP */
+    size_t  patch;       /* rel32 the next else/end retargets */
+    BcType *entry;       /* register types where the if/loop was entered */
+    BcType *then_types;  /* register types leaving a live then-branch */
+    bool    then_live;
+} JitFrame;
+
 typedef struct {
     bool known;
     BcValue value;
@@ -90,8 +131,10 @@ static void cb_emit_i64(CodeBuf *cb, int64_t value) {
     for (int i = 0; i < 8; i++) cb_emit_u8(cb, (uint8_t)(((uint64_t)value >> (8u * (uint32_t)i)) & 0xffu));
 }
 
-static int32_t reg_slot(uint16_t reg) {
-    return -(int32_t)(((uint32_t)reg + 1u) * 8u);
+/* Compiled code addresses its state array ("slots" of 64-bit words)
+ * through rbx; see JIT_KIND and friends below. */
+static int32_t reg_slot(size_t slot) {
+    return (int32_t)(slot * 8u);
 }
 
 static void x64_mov_rax_imm64(CodeBuf *cb, int64_t imm) {
@@ -99,21 +142,48 @@ static void x64_mov_rax_imm64(CodeBuf *cb, int64_t imm) {
     cb_emit_i64(cb, imm);
 }
 
-static void x64_mov_rax_slot(CodeBuf *cb, uint16_t reg) {
-    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x8b); cb_emit_u8(cb, 0x85);
-    cb_emit_i32(cb, reg_slot(reg));
+static void x64_mov_rax_slot(CodeBuf *cb, size_t slot) {
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x8b); cb_emit_u8(cb, 0x83);
+    cb_emit_i32(cb, reg_slot(slot));
 }
 
-static void x64_mov_slot_rax(CodeBuf *cb, uint16_t reg) {
-    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0x85);
-    cb_emit_i32(cb, reg_slot(reg));
+static void x64_mov_slot_rax(CodeBuf *cb, size_t slot) {
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0x83);
+    cb_emit_i32(cb, reg_slot(slot));
 }
 
-static void x64_binop_slot(CodeBuf *cb, uint8_t op_ext, uint16_t reg) {
+static void x64_binop_slot(CodeBuf *cb, uint8_t op_ext, size_t slot) {
     cb_emit_u8(cb, 0x48);
     cb_emit_u8(cb, op_ext);
-    cb_emit_u8(cb, 0x85);
-    cb_emit_i32(cb, reg_slot(reg));
+    cb_emit_u8(cb, 0x83);
+    cb_emit_i32(cb, reg_slot(slot));
+}
+
+static void x64_mov_slot_imm32(CodeBuf *cb, size_t slot, int32_t imm) {
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xc7); cb_emit_u8(cb, 0x83);
+    cb_emit_i32(cb, reg_slot(slot));
+    cb_emit_i32(cb, imm);
+}
+
+static void x64_cmp_slot_imm8(CodeBuf *cb, size_t slot, int8_t imm) {
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x83); cb_emit_u8(cb, 0xbb);
+    cb_emit_i32(cb, reg_slot(slot));
+    cb_emit_u8(cb, (uint8_t)imm);
+}
+
+/* push rbp; mov rbp,rsp; push rbx; sub rsp,8 -- rsp stays 16-aligned. */
+static void x64_prologue(CodeBuf *cb) {
+    cb_emit_u8(cb, 0x55);
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xe5);
+    cb_emit_u8(cb, 0x53);
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x83); cb_emit_u8(cb, 0xec); cb_emit_u8(cb, 0x08);
+}
+
+/* mov rbx,[rbp-8]; leave; ret */
+static void x64_epilogue(CodeBuf *cb) {
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x8b); cb_emit_u8(cb, 0x5d); cb_emit_u8(cb, 0xf8);
+    cb_emit_u8(cb, 0xc9);
+    cb_emit_u8(cb, 0xc3);
 }
 
 #define BC_JIT_PROBE_STRIDE 4096
@@ -160,6 +230,7 @@ static void x64_emit_probed_stack_alloc(CodeBuf *cb, size_t frame_bytes) {
 }
 
 static BcSourceSpan instr_span(const BcProgram *program, size_t index) {
+    program_page_in(program, true, false);
     if (program && program->debug_mode == BC_DEBUG_FULL_SPANS && program->spans && index < program->code_count)
         return program->spans[index];
     if (program && program->debug_mode == BC_DEBUG_LINES && program->lines && index < program->code_count)
@@ -209,7 +280,8 @@ static void print_location_blank(FILE *out, size_t column_width) {
 }
 
 static const char *op_color(BcOp op) {
-    if (op == BC_OP_IF || op == BC_OP_ELSE || op == BC_OP_LOOP || op == BC_OP_BLOCK || op == BC_OP_END)
+    if (op == BC_OP_IF || op == BC_OP_IF_LT || op == BC_OP_IF_LE || op == BC_OP_ELSE || op == BC_OP_LOOP ||
+        op == BC_OP_BLOCK || op == BC_OP_END)
         return BC_CLR_YELLOW;
     if (op == BC_OP_RETURN || op == BC_OP_HALT)
         return BC_CLR_MAGENTA;
@@ -251,6 +323,7 @@ static void bc_errorf(BcError *error,
     if (!error) return;
     error->instr = instr;
     error->opcode = opcode;
+    program_page_in(program, true, false);
     if (program && instr < program->code_count && program->debug_mode == BC_DEBUG_FULL_SPANS && program->spans) {
         error->span = program->spans[instr];
     } else if (program && instr < program->code_count && program->debug_mode == BC_DEBUG_LINES && program->lines) {
@@ -266,6 +339,7 @@ static void bc_errorf(BcError *error,
 }
 
 static void ensure_code(BcProgram *program) {
+    if (program->map) program_own_arrays(program);
     if (program->code_count < program->code_capacity) return;
     size_t cap = program->code_capacity ? program->code_capacity * 2 : 64;
     program->code = bc_realloc_array(program->code, cap, sizeof(program->code[0]));
@@ -284,6 +358,7 @@ static bool reserve_array(void **ptr, size_t *capacity, size_t requested, size_t
 }
 
 static void ensure_constants(BcProgram *program) {
+    if (program->map) program_own_arrays(program);
     if (program->const_count < program->const_capacity) return;
     size_t cap = program->const_capacity ? program->const_capacity * 2 : 16;
     program->constants = bc_realloc_array(program->constants, cap, sizeof(program->constants[0]));
@@ -292,6 +367,7 @@ static void ensure_constants(BcProgram *program) {
 
 static void ensure_registers(BcProgram *program, uint32_t reg) {
     if ((size_t)reg < program->register_count) return;
+    if (program->map) program_own_arrays(program);
     size_t need = (size_t)reg + 1;
     size_t cap = program->register_capacity ? program->register_capacity : 32;
     while (cap < need) cap *= 2;
@@ -316,6 +392,7 @@ static void ensure_inline_caches(BcProgram *program) {
 }
 
 static void ensure_deopts(BcProgram *program) {
+    program_page_in(program, false, true);
     if (program->deopt_count < program->deopt_capacity) return;
     size_t cap = program->deopt_capacity ? program->deopt_capacity * 2 : 16;
     program->deopts = bc_realloc_array(program->deopts, cap, sizeof(program->deopts[0]));
@@ -366,7 +443,10 @@ static bool section_is_known(uint32_t id) {
         id == BC_SECTION_TYPES ||
         id == BC_SECTION_DEBUG ||
         id == BC_SECTION_DEOPT ||
-        id == BC_SECTION_IC;
+        id == BC_SECTION_IC ||
+        id == BC_SECTION_CODE_IMAGE ||
+        id == BC_SECTION_CONSTANTS_IMAGE ||
+        id == BC_SECTION_TYPES_IMAGE;
 }
 
 static const char *section_name(uint32_t id) {
@@ -377,6 +457,9 @@ static const char *section_name(uint32_t id) {
         case BC_SECTION_DEBUG: return "debug";
         case BC_SECTION_DEOPT: return "deopt";
         case BC_SECTION_IC: return "inline-cache";
+        case BC_SECTION_CODE_IMAGE: return "code-image";
+        case BC_SECTION_CONSTANTS_IMAGE: return "const-image";
+        case BC_SECTION_TYPES_IMAGE: return "types-image";
         default: return "unknown";
     }
 }
@@ -391,7 +474,14 @@ static void write_f64(FILE *out, double value, bool *ok) {
     for (int i = 0; i < 8; i++) write_byte(out, (uint8_t)((bits >> (8u * (uint32_t)i)) & 0xffu), ok);
 }
 
-static bool write_section(const BcProgram *program, FILE *out, uint32_t id, void (*writer)(const BcProgram *, FILE *, bool *), BcError *error) {
+static uint64_t leb_size(uint64_t value) {
+    uint64_t bytes = 1;
+    while (value >>= 7u) bytes++;
+    return bytes;
+}
+
+/* offset, when given, tracks the file position for image alignment. */
+static bool write_section(const BcProgram *program, FILE *out, uint32_t id, void (*writer)(const BcProgram *, FILE *, bool *), uint64_t *offset, BcError *error) {
     FILE *tmp = tmpfile();
     if (!tmp) {
         bc_errorf(error, program, 0, 0, "could not create temporary section buffer");
@@ -410,6 +500,7 @@ static bool write_section(const BcProgram *program, FILE *out, uint32_t id, void
         else write_byte(out, (uint8_t)ch, &ok);
     }
     fclose(tmp);
+    if (offset) *offset += leb_size(id) + leb_size((uint64_t)size) + (uint64_t)size;
     if (!ok) bc_errorf(error, program, 0, 0, "failed writing bytecode section %u", id);
     return ok;
 }
@@ -423,6 +514,18 @@ static BcType numeric_result(BcType a, BcType b) {
     return BC_TYPE_I64;
 }
 
+static bool op_is_quickened(BcOp op) {
+    return op >= BC_OP_ADD_I64 && op <= BC_OP_GE_I64;
+}
+
+static BcType quickened_operand_type(BcOp op) {
+    return op >= BC_OP_ADD_F64 && op <= BC_OP_MUL_F64 ? BC_TYPE_F64 : BC_TYPE_I64;
+}
+
+static BcType quickened_result_type(BcOp op) {
+    return op >= BC_OP_LT_I64 ? BC_TYPE_BOOL : quickened_operand_type(op);
+}
+
 static bool value_equal(BcValue a, BcValue b) {
     if (a.kind != b.kind) return false;
     switch (a.kind) {
@@ -533,12 +636,27 @@ const char *bc_op_name(BcOp op) {
         "bc.sub", "bc.mul", "bc.div", "bc.mod", "bc.neg", "bc.eq",
         "bc.lt", "bc.le", "bc.gt", "bc.ge", "bc.not", "bc.call-native",
         "bc.block", "bc.if", "bc.else", "bc.loop", "bc.end", "bc.return",
-        "bc.halt",
+        "bc.halt", "bc.add.i64", "bc.sub.i64", "bc.mul.i64", "bc.add.f64",
+        "bc.sub.f64", "bc.mul.f64", "bc.lt.i64", "bc.le.i64", "bc.gt.i64",
+        "bc.ge.i64", "bc.addk", "bc.subk", "bc.if.lt", "bc.if.le",
     };
     if ((unsigned)op >= BC_OP_COUNT) return "bc.<invalid>";
     return names[op];
 }
 
+BcOp bc_op_generic(BcOp op) {
+    switch (op) {
+        case BC_OP_ADD_I64: case BC_OP_ADD_F64: return BC_OP_ADD;
+        case BC_OP_SUB_I64: case BC_OP_SUB_F64: return BC_OP_SUB;
+        case BC_OP_MUL_I64: case BC_OP_MUL_F64: return BC_OP_MUL;
+        case BC_OP_LT_I64: return BC_OP_LT;
+        case BC_OP_LE_I64: return BC_OP_LE;
+        case BC_OP_GT_I64: return BC_OP_GT;
+        case BC_OP_GE_I64: return BC_OP_GE;
+        default: return op;
+    }
+}
+
 const char *bc_type_name(BcType type) {
     switch (type) {
         case BC_TYPE_UNKNOWN: return "Unknown";
@@ -551,14 +669,44 @@ const char *bc_type_name(BcType type) {
     return "<type>";
 }
 
+const char *bc_ic_state_name(BcInlineCacheState state) {
+    switch (state) {
+        case BC_IC_UNINITIALIZED: return "uninitialized";
+        case BC_IC_MONOMORPHIC: return "monomorphic";
+        case BC_IC_POLYMORPHIC: return "polymorphic";
+        case BC_IC_MEGAMORPHIC: return "megamorphic";
+    }
+    return "<ic>";
+}
+
 void bc_program_init(BcProgram *program, const char *name) {
     memset(program, 0, sizeof(*program));
     program->name = bc_strdup(name ? name : "<bytecode>");
     program->debug_mode = BC_DEBUG_FULL_SPANS;
 }
 
+static void map_release(BcProgramMap *map) {
+#if !defined(_WIN32)
+    if (map->mmapped) munmap((void *)map->data, map->size);
+    else
+#endif
+    free((void *)map->data);
+    free(map);
+}
+
+static bool map_holds(const BcProgramMap *map, const void *ptr) {
+    const unsigned char *p = ptr;
+    return map && p >= map->data && p < map->data + map->size;
+}
+
 void bc_program_free(BcProgram *program) {
     if (!program) return;
+    if (program->map) {
+        if (map_holds(program->map, program->code)) program->code = NULL;
+        if (map_holds(program->map, program->constants)) program->constants = NULL;
+        if (map_holds(program->map, program->register_types)) program->register_types = NULL;
+        map_release(program->map);
+    }
     free(program->name);
     free(program->code);
     free(program->spans);
@@ -569,6 +717,8 @@ void bc_program_free(BcProgram *program) {
     free(program->natives);
     free(program->inline_caches);
     free(program->deopts);
+    for (size_t i = 0; i < program->file_count; i++) free(program->files[i]);
+    free(program->files);
     memset(program, 0, sizeof(*program));
 }
 
@@ -590,6 +740,7 @@ bool bc_program_reserve(BcProgram *program,
         bc_errorf(error, program, 0, 0, "bytecode reserve size overflow");
         return false;
     }
+    if (program->map) program_own_arrays(program);
 
     reserve_array((void **)&program->code, &program->code_capacity, code_capacity, sizeof(program->code[0]));
     if (program->debug_mode == BC_DEBUG_FULL_SPANS)
@@ -608,6 +759,7 @@ bool bc_program_reserve(BcProgram *program,
 
 void bc_program_shrink_to_fit(BcProgram *program) {
     if (!program) return;
+    if (program->map) program_own_arrays(program);
     size_t code_count = program->code_count;
     if (code_count != program->code_capacity) {
         program->code = bc_realloc_array(program->code, code_count, sizeof(program->code[0]));
@@ -634,13 +786,17 @@ BcProgramMemoryStats bc_program_memory_stats(const BcProgram *program) {
     stats.instruction_capacity = program->code_capacity;
     stats.register_count = program->register_count;
     stats.constant_count = program->const_count;
-    stats.code_bytes = program->code_capacity * sizeof(program->code[0]);
+    const BcProgramMap *map = program->map;
+    if (map) stats.mapped_bytes = map->size;
+    if (!map_holds(map, program->code)) stats.code_bytes = program->code_capacity * sizeof(program->code[0]);
     if (program->debug_mode == BC_DEBUG_FULL_SPANS)
         stats.debug_bytes = program->code_capacity * sizeof(program->spans[0]);
     else if (program->debug_mode == BC_DEBUG_LINES)
         stats.debug_bytes = program->code_capacity * sizeof(program->lines[0]);
-    stats.register_type_bytes = program->register_capacity * sizeof(program->register_types[0]);
-    stats.constant_bytes = program->const_capacity * sizeof(program->constants[0]);
+    if (!map_holds(map, program->register_types))
+        stats.register_type_bytes = program->register_capacity * sizeof(program->register_types[0]);
+    if (!map_holds(map, program->constants))
+        stats.constant_bytes = program->const_capacity * sizeof(program->constants[0]);
     stats.metadata_bytes =
         program->native_capacity * sizeof(program->natives[0]) +
         program->inline_cache_capacity * sizeof(program->inline_caches[0]) +
@@ -685,13 +841,33 @@ uint32_t bc_program_add_native_typed(BcProgram *program,
     native->return_type = return_type;
     native->min_arity = min_arity;
     native->max_arity = max_arity;
+    native->receiver_type = BC_TYPE_UNKNOWN;
+    native->generic = index;
+    return index;
+}
+
+uint32_t bc_program_add_native_variant(BcProgram *program,
+                                       uint32_t generic,
+                                       BcType receiver_type,
+                                       const char *name,
+                                       BcNativeFn fn,
+                                       void *userdata) {
+    if (generic >= program->native_count || receiver_type == BC_TYPE_UNKNOWN) abort();
+    BcNative base = program->natives[generic];
+    uint32_t index = bc_program_add_native_typed(program, name, fn, userdata,
+                                                 base.return_type, base.min_arity, base.max_arity);
+    program->natives[index].receiver_type = receiver_type;
+    program->natives[index].generic = base.generic;
     return index;
 }
 
 uint32_t bc_program_add_inline_cache(BcProgram *program, uint32_t callsite) {
     ensure_inline_caches(program);
     uint32_t index = (uint32_t)program->inline_cache_count;
-    program->inline_caches[program->inline_cache_count++] = (BcInlineCache){callsite, BC_TYPE_UNKNOWN, 0, 0};
+    BcInlineCache *ic = &program->inline_caches[program->inline_cache_count++];
+    memset(ic, 0, sizeof(*ic));
+    ic->callsite = callsite;
+    ic->state = BC_IC_UNINITIALIZED;
     return index;
 }
 
@@ -805,6 +981,37 @@ bool bc_verify(const BcProgram *program, BcError *error) {
                 if (types[in.b] == BC_TYPE_UNKNOWN) goto unknown_operand;
                 types[in.a] = BC_TYPE_BOOL;
                 break;
+            case BC_OP_ADD_I64:
+            case BC_OP_SUB_I64:
+            case BC_OP_MUL_I64:
+            case BC_OP_ADD_F64:
+            case BC_OP_SUB_F64:
+            case BC_OP_MUL_F64:
+            case BC_OP_LT_I64:
+            case BC_OP_LE_I64:
+            case BC_OP_GT_I64:
+            case BC_OP_GE_I64:
+                if (types[in.b] != quickened_operand_type(op) ||
+                    types[in.c] != quickened_operand_type(op)) goto type_error;
+                types[in.a] = quickened_result_type(op);
+                break;
+            case BC_OP_ADDK:
+            case BC_OP_SUBK: {
+                if (in.imm >= program->const_count) {
+                    bc_errorf(error, program, i, in.op, "constant index %u out of range", in.imm);
+                    free(types);
+                    return false;
+                }
+                BcType k = bc_type_of_value(program->constants[in.imm]);
+                if (!same_numeric(types[in.b], k)) {
+                    bc_errorf(error, program, i, in.op, "type mismatch in %s: r%u=%s const[%u]=%s",
+                              bc_op_name(op), in.b, bc_type_name(types[in.b]), in.imm, bc_type_name(k));
+                    free(types);
+                    return false;
+                }
+                types[in.a] = numeric_result(types[in.b], k);
+                break;
+            }
             case BC_OP_CALL_NATIVE:
                 if (in.imm >= program->native_count) {
                     bc_errorf(error, program, i, in.op, "native index %u out of range", in.imm);
@@ -843,6 +1050,17 @@ bool bc_verify(const BcProgram *program, BcError *error) {
                 frames[depth++] = (VerifyFrame){FRAME_IF, i};
                 terminated = false;
                 break;
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+                if (!same_numeric(types[in.b], types[in.c])) goto type_error;
+                if (depth == BC_STRUCTURED_DEPTH_MAX) {
+                    bc_errorf(error, program, i, in.op, "structured block nesting too deep");
+                    free(types);
+                    return false;
+                }
+                frames[depth++] = (VerifyFrame){FRAME_IF, i};
+                terminated = false;
+                break;
             case BC_OP_ELSE:
                 if (!depth || frames[depth - 1].kind != FRAME_IF) {
                     bc_errorf(error, program, i, in.op, "else without matching if");
@@ -954,12 +1172,15 @@ bool bc_verify_trace(const BcProgram *program, FILE *out, BcError *error) {
         print_dim(out, "%04zu ", i);
         print_padded_op(out, op, 14);
         if (op == BC_OP_CONST) fprintf(out, "r%u const[%u]", in.a, in.imm);
+        else if (op == BC_OP_ADDK || op == BC_OP_SUBK) fprintf(out, "r%u <- r%u const[%u]", in.a, in.b, in.imm);
+        else if (op == BC_OP_IF_LT || op == BC_OP_IF_LE) fprintf(out, "r%u r%u", in.b, in.c);
         else if (op == BC_OP_IF) fprintf(out, "r%u", in.a);
         else if (op == BC_OP_RETURN) fprintf(out, "r%u", in.a);
         else if (op == BC_OP_MOV || op == BC_OP_NEG || op == BC_OP_NOT) fprintf(out, "r%u <- r%u", in.a, in.b);
         else if (op == BC_OP_ADD || op == BC_OP_SUB || op == BC_OP_MUL ||
                  op == BC_OP_DIV || op == BC_OP_MOD || op == BC_OP_EQ ||
-                 op == BC_OP_LT || op == BC_OP_LE || op == BC_OP_GT || op == BC_OP_GE)
+                 op == BC_OP_LT || op == BC_OP_LE || op == BC_OP_GT || op == BC_OP_GE ||
+                 op_is_quickened(op))
             fprintf(out, "r%u <- r%u r%u", in.a, in.b, in.c);
         fputc('\n', out);
 
@@ -1027,6 +1248,39 @@ bool bc_verify_trace(const BcProgram *program, FILE *out, BcError *error) {
                 types[in.a] = BC_TYPE_BOOL;
                 trace_reg_type(out, depth + 1, loc_col, in.a, types[in.a]);
                 break;
+            case BC_OP_ADD_I64:
+            case BC_OP_SUB_I64:
+            case BC_OP_MUL_I64:
+            case BC_OP_ADD_F64:
+            case BC_OP_SUB_F64:
+            case BC_OP_MUL_F64:
+            case BC_OP_LT_I64:
+            case BC_OP_LE_I64:
+            case BC_OP_GT_I64:
+            case BC_OP_GE_I64:
+                if (types[in.b] != quickened_operand_type(op) ||
+                    types[in.c] != quickened_operand_type(op)) goto trace_type_error;
+                types[in.a] = quickened_result_type(op);
+                trace_reg_type(out, depth + 1, loc_col, in.a, types[in.a]);
+                break;
+            case BC_OP_ADDK:
+            case BC_OP_SUBK: {
+                if (in.imm >= program->const_count) {
+                    bc_errorf(error, program, i, in.op, "constant index %u out of range", in.imm);
+                    ok = false;
+                    break;
+                }
+                BcType k = bc_type_of_value(program->constants[in.imm]);
+                if (!same_numeric(types[in.b], k)) {
+                    bc_errorf(error, program, i, in.op, "type mismatch in %s: r%u=%s const[%u]=%s",
+                              bc_op_name(op), in.b, bc_type_name(types[in.b]), in.imm, bc_type_name(k));
+                    ok = false;
+                    break;
+                }
+                types[in.a] = numeric_result(types[in.b], k);
+                trace_reg_type(out, depth + 1, loc_col, in.a, types[in.a]);
+                break;
+            }
             case BC_OP_CALL_NATIVE:
                 if (in.imm >= program->native_count) {
                     bc_errorf(error, program, i, in.op, "native index %u out of range", in.imm);
@@ -1067,6 +1321,17 @@ bool bc_verify_trace(const BcProgram *program, FILE *out, BcError *error) {
                 frames[depth++] = (VerifyFrame){FRAME_IF, i};
                 terminated = false;
                 break;
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+                if (!same_numeric(types[in.b], types[in.c])) goto trace_type_error;
+                if (depth == BC_STRUCTURED_DEPTH_MAX) {
+                    bc_errorf(error, program, i, in.op, "structured block nesting too deep");
+                    ok = false;
+                    break;
+                }
+                frames[depth++] = (VerifyFrame){FRAME_IF, i};
+                terminated = false;
+                break;
             case BC_OP_ELSE:
                 if (!depth || frames[depth - 1].kind != FRAME_IF) {
                     bc_errorf(error, program, i, in.op, "else without matching if");
@@ -1173,6 +1438,7 @@ static void write_types_section(const BcProgram *program, FILE *out, bool *ok) {
 }
 
 static void write_debug_section(const BcProgram *program, FILE *out, bool *ok) {
+    program_page_in(program, true, false);
     write_leb_u64(out, program->code_count, ok);
     for (size_t i = 0; i < program->code_count; i++) {
         BcSourceSpan span = bc_span("", 0, 0);
@@ -1190,6 +1456,7 @@ static void write_debug_section(const BcProgram *program, FILE *out, bool *ok) {
 }
 
 static void write_deopt_section(const BcProgram *program, FILE *out, bool *ok) {
+    program_page_in(program, false, true);
     write_leb_u64(out, program->deopt_count, ok);
     for (size_t i = 0; i < program->deopt_count; i++) {
         BcDeoptPoint d = program->deopts[i];
@@ -1205,8 +1472,12 @@ static void write_ic_section(const BcProgram *program, FILE *out, bool *ok) {
     for (size_t i = 0; i < program->inline_cache_count; i++) {
         BcInlineCache ic = program->inline_caches[i];
         write_leb_u64(out, ic.callsite, ok);
-        write_leb_u64(out, ic.receiver_type, ok);
-        write_leb_u64(out, ic.target, ok);
+        write_leb_u64(out, ic.state, ok);
+        write_leb_u64(out, ic.entry_count, ok);
+        for (uint32_t e = 0; e < ic.entry_count; e++) {
+            write_leb_u64(out, ic.entries[e].receiver_type, ok);
+            write_leb_u64(out, ic.entries[e].target, ok);
+        }
         write_leb_u64(out, ic.misses, ok);
     }
 }
@@ -1224,12 +1495,12 @@ bool bc_write_binary(const BcProgram *program, FILE *out, BcError *error) {
     write_leb_u64(out, BC_VERSION_MAJOR, &ok);
     write_leb_u64(out, BC_VERSION_MINOR, &ok);
     write_leb_u64(out, 6, &ok);
-    if (!write_section(program, out, BC_SECTION_CODE, write_code_section, error)) return false;
-    if (!write_section(program, out, BC_SECTION_CONSTANTS, write_constants_section, error)) return false;
-    if (!write_section(program, out, BC_SECTION_TYPES, write_types_section, error)) return false;
-    if (!write_section(program, out, BC_SECTION_DEBUG, write_debug_section, error)) return false;
-    if (!write_section(program, out, BC_SECTION_DEOPT, write_deopt_section, error)) return false;
-    if (!write_section(program, out, BC_SECTION_IC, write_ic_section, error)) return false;
+    if (!write_section(program, out, BC_SECTION_CODE, write_code_section, NULL, error)) return false;
+    if (!write_section(program, out, BC_SECTION_CONSTANTS, write_constants_section, NULL, error)) return false;
+    if (!write_section(program, out, BC_SECTION_TYPES, write_types_section, NULL, error)) return false;
+    if (!write_section(program, out, BC_SECTION_DEBUG, write_debug_section, NULL, error)) return false;
+    if (!write_section(program, out, BC_SECTION_DEOPT, write_deopt_section, NULL, error)) return false;
+    if (!write_section(program, out, BC_SECTION_IC, write_ic_section, NULL, error)) return false;
     if (!ok) {
         bc_errorf(error, program, 0, 0, "failed writing bytecode header");
         return false;
@@ -1237,19 +1508,346 @@ bool bc_write_binary(const BcProgram *program, FILE *out, BcError *error) {
     return true;
 }
 
+static uint8_t host_byte_order(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t *)&probe ? 1 : 2;
+}
+
+/*
+ * An image section payload is: count, element size and byte order (LEB),
+ * a pad length and that many zero bytes, then count elements in memory
+ * layout.  The pad puts the elements on a BC_IMAGE_ALIGN boundary of the
+ * file, given the section's file offset.
+ */
+static void write_image_section(FILE *out, uint32_t id, const void *data, size_t count, size_t elem_size,
+                                uint64_t *offset, bool *ok) {
+    uint64_t data_bytes = (uint64_t)count * elem_size;
+    uint64_t prefix = leb_size(count) + leb_size(elem_size) + 1 + 1;
+    uint64_t pad = 0, size = 0;
+    for (;; pad++) {
+        size = prefix + pad + data_bytes;
+        if ((*offset + leb_size(id) + leb_size(size) + prefix + pad) % BC_IMAGE_ALIGN == 0) break;
+    }
+    write_leb_u64(out, id, ok);
+    write_leb_u64(out, size, ok);
+    write_leb_u64(out, count, ok);
+    write_leb_u64(out, elem_size, ok);
+    write_leb_u64(out, host_byte_order(), ok);
+    write_leb_u64(out, pad, ok);
+    for (uint64_t i = 0; i < pad; i++) write_byte(out, 0, ok);
+    if (*ok && data_bytes && fwrite(data, 1, (size_t)data_bytes, out) != data_bytes) *ok = false;
+    *offset += leb_size(id) + leb_size(size) + size;
+}
+
+/* Copies with zeroed padding, and pointer constants cleared the way the
+ * portable encoding drops them. */
+static BcInstr *image_code(const BcProgram *program) {
+    BcInstr *code = bc_realloc_array(NULL, program->code_count ? program->code_count : 1, sizeof(code[0]));
+    memset(code, 0, (program->code_count ? program->code_count : 1) * sizeof(code[0]));
+    for (size_t i = 0; i < program->code_count; i++) {
+        code[i].op = program->code[i].op;
+        code[i].a = program->code[i].a;
+        code[i].b = program->code[i].b;
+        code[i].c = program->code[i].c;
+        code[i].imm = program->code[i].imm;
+    }
+    return code;
+}
+
+static BcValue *image_constants(const BcProgram *program) {
+    BcValue *values = bc_realloc_array(NULL, program->const_count ? program->const_count : 1, sizeof(values[0]));
+    memset(values, 0, (program->const_count ? program->const_count : 1) * sizeof(values[0]));
+    for (size_t i = 0; i < program->const_count; i++) {
+        BcValue v = program->constants[i];
+        values[i].kind = v.kind;
+        switch (v.kind) {
+            case BC_VALUE_NIL: break;
+            case BC_VALUE_BOOL: values[i].as.boolean = v.as.boolean; break;
+            case BC_VALUE_I64: values[i].as.i64 = v.as.i64; break;
+            case BC_VALUE_F64: values[i].as.f64 = v.as.f64; break;
+            case BC_VALUE_PTR: values[i].as.ptr = NULL; break;
+        }
+    }
+    return values;
+}
+
+bool bc_write_binary_image(const BcProgram *program, FILE *out, BcError *error) {
+    bc_error_clear(error);
+    BcError verify_error;
+    if (!bc_verify(program, &verify_error)) {
+        if (error) *error = verify_error;
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t offset = leb_size(BC_MAGIC) + leb_size(BC_VERSION_MAJOR) + leb_size(BC_VERSION_MINOR) + leb_size(6);
+    write_leb_u64(out, BC_MAGIC, &ok);
+    write_leb_u64(out, BC_VERSION_MAJOR, &ok);
+    write_leb_u64(out, BC_VERSION_MINOR, &ok);
+    write_leb_u64(out, 6, &ok);
+    BcInstr *code = image_code(program);
+    BcValue *constants = image_constants(program);
+    write_image_section(out, BC_SECTION_CODE_IMAGE, code, program->code_count, sizeof(code[0]), &offset, &ok);
+    write_image_section(out, BC_SECTION_CONSTANTS_IMAGE, constants, program->const_count, sizeof(constants[0]),
+                        &offset, &ok);
+    write_image_section(out, BC_SECTION_TYPES_IMAGE, program->register_types, program->register_count,
+                        sizeof(program->register_types[0]), &offset, &ok);
+    free(code);
+    free(constants);
+    if (!ok) {
+        bc_errorf(error, program, 0, 0, "failed writing bytecode image");
+        return false;
+    }
+    if (!write_section(program, out, BC_SECTION_DEBUG, write_debug_section, &offset, error)) return false;
+    if (!write_section(program, out, BC_SECTION_DEOPT, write_deopt_section, &offset, error)) return false;
+    if (!write_section(program, out, BC_SECTION_IC, write_ic_section, &offset, error)) return false;
+    return true;
+}
+
 static void bc_binary_error(BcError *error, const char *message) {
     if (!error) return;
     bc_error_clear(error);
     snprintf(error->message, sizeof(error->message), "%s", message);
 }
 
-bool bc_read_binary_info(FILE *in, BcBinaryInfo *info, BcError *error) {
+static uint64_t bin_leb(BinReader *r) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; r->ok; shift += 7) {
+        if (r->p == r->end || shift >= 64) break;
+        uint8_t byte = *r->p++;
+        result |= (uint64_t)(byte & 0x7fu) << shift;
+        if (!(byte & 0x80u)) return result;
+    }
+    r->ok = false;
+    return 0;
+}
+
+static uint64_t bin_leb_max(BinReader *r, uint64_t max) {
+    uint64_t value = bin_leb(r);
+    if (value > max) r->ok = false;
+    return r->ok ? value : 0;
+}
+
+static uint64_t bin_u64le(BinReader *r) {
+    if (!r->ok || (size_t)(r->end - r->p) < 8) {
+        r->ok = false;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)r->p[i] << (8u * (uint32_t)i);
+    r->p += 8;
+    return value;
+}
+
+/* An element count, rejected unless that many elements of at least
+ * min_bytes each fit in what is left of the payload. */
+static size_t bin_count(BinReader *r, size_t min_bytes) {
+    uint64_t n = bin_leb(r);
+    if (r->ok && n > (uint64_t)(r->end - r->p) / min_bytes) r->ok = false;
+    return r->ok ? (size_t)n : 0;
+}
+
+static const char *intern_file(BcProgram *program, const unsigned char *name, size_t len) {
+    for (size_t i = 0; i < program->file_count; i++)
+        if (strlen(program->files[i]) == len && memcmp(program->files[i], name, len) == 0) return program->files[i];
+    program->files = bc_realloc_array(program->files, program->file_count + 1, sizeof(program->files[0]));
+    char *copy = bc_realloc_array(NULL, len + 1, 1);
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    program->files[program->file_count++] = copy;
+    return copy;
+}
+
+static void read_code_section(BcProgram *program, BinReader *r) {
+    size_t n = bin_count(r, 5);
+    bc_program_reserve(program, n, 0, 0, NULL);
+    for (size_t i = 0; i < n && r->ok; i++) {
+        uint64_t op = bin_leb_max(r, UINT8_MAX);
+        uint64_t a = bin_leb_max(r, UINT16_MAX);
+        uint64_t b = bin_leb_max(r, UINT16_MAX);
+        uint64_t c = bin_leb_max(r, UINT16_MAX);
+        uint64_t imm = bin_leb_max(r, UINT32_MAX);
+        program->code[i] = (BcInstr){(uint8_t)op, (uint16_t)a, (uint16_t)b, (uint16_t)c, (uint32_t)imm};
+        if (program->debug_mode == BC_DEBUG_FULL_SPANS) program->spans[i] = bc_span("", 0, 0);
+        else if (program->debug_mode == BC_DEBUG_LINES) program->lines[i] = 0;
+    }
+    if (r->ok) program->code_count = n;
+}
+
+static void read_constants_section(BcProgram *program, BinReader *r) {
+    size_t n = bin_count(r, 1);
+    bc_program_reserve(program, 0, n, 0, NULL);
+    for (size_t i = 0; i < n && r->ok; i++) {
+        BcValue v = bc_value_nil();
+        uint64_t bits;
+        switch (bin_leb(r)) {
+            case BC_VALUE_NIL: break;
+            case BC_VALUE_BOOL: v = bc_value_bool(bin_leb(r) != 0); break;
+            case BC_VALUE_I64: v = bc_value_i64((int64_t)bin_u64le(r)); break;
+            case BC_VALUE_F64:
+                bits = bin_u64le(r);
+                v.kind = BC_VALUE_F64;
+                memcpy(&v.as.f64, &bits, sizeof(bits));
+                break;
+            case BC_VALUE_PTR: bin_leb(r); v = bc_value_ptr(NULL); break;
+            default: r->ok = false; break;
+        }
+        program->constants[i] = v;
+    }
+    if (r->ok) program->const_count = n;
+}
+
+static void read_types_section(BcProgram *program, BinReader *r) {
+    size_t n = bin_count(r, 1);
+    if (n > BC_MAX_REGISTERS) r->ok = false;
+    if (!r->ok) return;
+    bc_program_reserve(program, 0, 0, n, NULL);
+    for (size_t i = 0; i < n && r->ok; i++)
+        program->register_types[i] = (BcType)bin_leb_max(r, BC_TYPE_PTR);
+    if (r->ok) program->register_count = n;
+}
+
+/* Needs the code section first, which bc_write_binary guarantees. */
+static void read_debug_section(BcProgram *program, BinReader *r) {
+    size_t n = bin_count(r, 3);
+    if (n != program->code_count) r->ok = false;
+    for (size_t i = 0; i < n && r->ok; i++) {
+        size_t len = bin_count(r, 1);
+        const unsigned char *name = r->p;
+        r->p += len;
+        uint32_t line = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        uint32_t column = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        if (!r->ok) break;
+        if (program->debug_mode == BC_DEBUG_FULL_SPANS)
+            program->spans[i] = bc_span(intern_file(program, name, len), line, column);
+        else if (program->debug_mode == BC_DEBUG_LINES)
+            program->lines[i] = line;
+    }
+}
+
+static void read_deopt_section(BcProgram *program, BinReader *r) {
+    size_t n = bin_count(r, 4);
+    for (size_t i = 0; i < n && r->ok; i++) {
+        uint32_t safepoint = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        uint32_t first = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        uint32_t count = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        uint32_t source = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        if (r->ok) bc_program_add_deopt_point(program, safepoint, first, count, source);
+    }
+}
+
+/* v1.1 caches held one receiver type and target; they read back as
+ * monomorphic (or uninitialized) caches. */
+static void read_ic_section(BcProgram *program, BinReader *r, uint64_t minor) {
+    size_t n = bin_count(r, 3);
+    for (size_t i = 0; i < n && r->ok; i++) {
+        uint32_t callsite = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        BcInlineCache ic;
+        memset(&ic, 0, sizeof(ic));
+        ic.callsite = callsite;
+        if (minor >= 2) {
+            ic.state = (BcInlineCacheState)bin_leb_max(r, BC_IC_MEGAMORPHIC);
+            ic.entry_count = (uint32_t)bin_leb_max(r, BC_IC_MAX_ENTRIES);
+            for (uint32_t e = 0; e < ic.entry_count; e++) {
+                ic.entries[e].receiver_type = (BcType)bin_leb_max(r, BC_TYPE_PTR);
+                ic.entries[e].target = (uint32_t)bin_leb_max(r, UINT32_MAX);
+            }
+        } else {
+            BcType t = (BcType)bin_leb_max(r, BC_TYPE_PTR);
+            uint32_t target = (uint32_t)bin_leb_max(r, UINT32_MAX);
+            if (t != BC_TYPE_UNKNOWN) {
+                ic.state = BC_IC_MONOMORPHIC;
+                ic.entry_count = 1;
+                ic.entries[0] = (BcInlineCacheEntry){t, target};
+            }
+        }
+        ic.misses = (uint32_t)bin_leb_max(r, UINT32_MAX);
+        if (!r->ok) break;
+        uint32_t k = bc_program_add_inline_cache(program, callsite);
+        program->inline_caches[k] = ic;
+    }
+}
+
+/* Parses an image section header and returns its elements, count of them
+ * elem_size bytes each; NULL (and r->ok false) if the image is not in
+ * this host's layout. */
+static const unsigned char *bin_image(BinReader *r, size_t elem_size, size_t *count) {
+    uint64_t n = bin_leb(r);
+    uint64_t size = bin_leb(r);
+    uint64_t order = bin_leb(r);
+    uint64_t pad = bin_leb(r);
+    if (r->ok && (size != elem_size || order != host_byte_order() || pad > (uint64_t)(r->end - r->p))) r->ok = false;
+    if (!r->ok) return NULL;
+    r->p += pad;
+    if (n != (uint64_t)(r->end - r->p) / elem_size || (uint64_t)(r->end - r->p) % elem_size) {
+        r->ok = false;
+        return NULL;
+    }
+    const unsigned char *data = r->p;
+    r->p = r->end;
+    *count = (size_t)n;
+    return data;
+}
+
+static bool image_constants_valid(const BcValue *values, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        if ((unsigned)values[i].kind > BC_VALUE_PTR) return false;
+    return true;
+}
+
+static bool image_types_valid(const BcType *types, size_t count) {
+    if (count > BC_MAX_REGISTERS) return false;
+    for (size_t i = 0; i < count; i++)
+        if ((unsigned)types[i] > BC_TYPE_PTR) return false;
+    return true;
+}
+
+/* Reads an image section into the program's own arrays. */
+static void read_image_section(BcProgram *program, BinReader *r, uint32_t id) {
+    size_t n = 0;
+    const unsigned char *data;
+    switch (id) {
+        case BC_SECTION_CODE_IMAGE:
+            if (!(data = bin_image(r, sizeof(BcInstr), &n))) return;
+            bc_program_reserve(program, n, 0, 0, NULL);
+            if (n) memcpy(program->code, data, n * sizeof(BcInstr));
+            for (size_t i = 0; i < n; i++) {
+                if (program->debug_mode == BC_DEBUG_FULL_SPANS) program->spans[i] = bc_span("", 0, 0);
+                else if (program->debug_mode == BC_DEBUG_LINES) program->lines[i] = 0;
+            }
+            program->code_count = n;
+            break;
+        case BC_SECTION_CONSTANTS_IMAGE:
+            if (!(data = bin_image(r, sizeof(BcValue), &n))) return;
+            bc_program_reserve(program, 0, n, 0, NULL);
+            if (n) memcpy(program->constants, data, n * sizeof(BcValue));
+            if (!image_constants_valid(program->constants, n)) r->ok = false;
+            else program->const_count = n;
+            break;
+        case BC_SECTION_TYPES_IMAGE:
+            if (!(data = bin_image(r, sizeof(BcType), &n))) return;
+            if (n > BC_MAX_REGISTERS) {
+                r->ok = false;
+                return;
+            }
+            bc_program_reserve(program, 0, 0, n, NULL);
+            if (n) memcpy(program->register_types, data, n * sizeof(BcType));
+            if (!image_types_valid(program->register_types, n)) r->ok = false;
+            else program->register_count = n;
+            break;
+    }
+}
+
+bool bc_read_binary(FILE *in, BcProgram *program, BcError *error) {
     bc_error_clear(error);
-    if (!in || !info) {
-        bc_binary_error(error, "bytecode binary info requires input and output");
+    if (!in || !program) {
+        bc_binary_error(error, "bytecode read requires input and a program");
+        return false;
+    }
+    if (program->code_count || program->const_count || program->inline_cache_count || program->deopt_count) {
+        bc_binary_error(error, "bytecode read requires an empty program");
         return false;
     }
-    memset(info, 0, sizeof(*info));
 
     uint64_t magic = 0, major = 0, minor = 0, sections = 0;
     if (!read_leb_u64(in, &magic) ||
@@ -1263,10 +1861,10 @@ bool bc_read_binary_info(FILE *in, BcBinaryInfo *info, BcError *error) {
         bc_binary_error(error, "invalid bytecode magic");
         return false;
     }
-
-    info->major = (uint32_t)major;
-    info->minor = (uint32_t)minor;
-    info->section_count = sections;
+    if (major != BC_VERSION_MAJOR) {
+        bc_binary_error(error, "unsupported bytecode major version");
+        return false;
+    }
 
     for (uint64_t i = 0; i < sections; i++) {
         uint64_t id = 0, size = 0;
@@ -1274,73 +1872,848 @@ bool bc_read_binary_info(FILE *in, BcBinaryInfo *info, BcError *error) {
             bc_binary_error(error, "truncated bytecode section header");
             return false;
         }
-        bool known = id <= UINT32_MAX && section_is_known((uint32_t)id);
-        if (!known) info->unknown_section_count++;
-        info->total_payload_bytes += size;
-        if (info->stored_section_count < sizeof(info->sections) / sizeof(info->sections[0])) {
-            BcSectionInfo *slot = &info->sections[info->stored_section_count++];
-            slot->id = id <= UINT32_MAX ? (uint32_t)id : BC_SECTION_UNKNOWN;
-            slot->size = size;
-            slot->known = known;
+        if (id > UINT32_MAX || !section_is_known((uint32_t)id)) {
+            if (!skip_bytes(in, size)) {
+                bc_binary_error(error, "truncated bytecode section payload");
+                return false;
+            }
+            continue;
         }
-        if (!skip_bytes(in, size)) {
+        unsigned char *payload = size <= SIZE_MAX - 1 ? malloc((size_t)size + 1) : NULL;
+        if (!payload || fread(payload, 1, (size_t)size, in) != (size_t)size) {
+            free(payload);
             bc_binary_error(error, "truncated bytecode section payload");
             return false;
         }
+        BinReader r = {payload, payload + size, true};
+        switch ((BcSectionId)id) {
+            case BC_SECTION_CODE: read_code_section(program, &r); break;
+            case BC_SECTION_CONSTANTS: read_constants_section(program, &r); break;
+            case BC_SECTION_TYPES: read_types_section(program, &r); break;
+            case BC_SECTION_DEBUG: read_debug_section(program, &r); break;
+            case BC_SECTION_DEOPT: read_deopt_section(program, &r); break;
+            case BC_SECTION_IC: read_ic_section(program, &r, minor); break;
+            case BC_SECTION_CODE_IMAGE:
+            case BC_SECTION_CONSTANTS_IMAGE:
+            case BC_SECTION_TYPES_IMAGE: read_image_section(program, &r, (uint32_t)id); break;
+        }
+        bool ok = r.ok && r.p == r.end;
+        free(payload);
+        if (!ok) {
+            char message[64];
+            snprintf(message, sizeof(message), "corrupt bytecode %s section", section_name((uint32_t)id));
+            bc_binary_error(error, message);
+            return false;
+        }
     }
     return true;
 }
 
-bool bc_dump_binary_sections(FILE *in, FILE *out, BcError *error) {
-    if (!out) out = stdout;
-    BcBinaryInfo info;
-    if (!bc_read_binary_info(in, &info, error)) return false;
-    fprintf(out, "== bytecode sections v%u.%u ==\n", info.major, info.minor);
-    fprintf(out, "sections=%" PRIu64 " payload=%" PRIu64 " unknown=%" PRIu64 "\n",
-            info.section_count, info.total_payload_bytes, info.unknown_section_count);
-    for (size_t i = 0; i < info.stored_section_count; i++) {
-        BcSectionInfo section = info.sections[i];
-        fprintf(out, "section %u %-12s size=%" PRIu64 "%s\n",
-                section.id,
-                section_name(section.id),
-                section.size,
-                section.known ? "" : " skipped");
+static bool map_open(BcProgramMap *map, const char *path) {
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
     }
-    if (info.stored_section_count < info.section_count)
-        fprintf(out, "... %" PRIu64 " more section(s) not shown\n",
-                info.section_count - (uint64_t)info.stored_section_count);
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p != MAP_FAILED) {
+        map->data = p;
+        map->size = (size_t)st.st_size;
+        map->mmapped = true;
+        return true;
+    }
+#endif
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(fp);
+        return false;
+    }
+    unsigned char *buf = malloc((size_t)size);
+    size_t n = buf ? fread(buf, 1, (size_t)size, fp) : 0;
+    fclose(fp);
+    if (n != (size_t)size) {
+        free(buf);
+        return false;
+    }
+    map->data = buf;
+    map->size = n;
     return true;
 }
 
-BcOptimizeOptions bc_optimize_options_default(void) {
-    BcOptimizeOptions options;
-    options.fold_constants = true;
-    options.remove_self_moves = true;
-    options.compact_nops = true;
-    options.verify_after = true;
-    return options;
-}
-
-static void clear_const_facts(ConstFact *facts, size_t count) {
-    for (size_t i = 0; i < count; i++) facts[i].known = false;
+/* Drops the program's pointers into the mapping. */
+static void map_detach(BcProgram *program, const BcProgramMap *map) {
+    if (map_holds(map, program->code)) {
+        program->code = NULL;
+        program->code_count = program->code_capacity = 0;
+    }
+    if (map_holds(map, program->constants)) {
+        program->constants = NULL;
+        program->const_count = program->const_capacity = 0;
+    }
+    if (map_holds(map, program->register_types)) {
+        program->register_types = NULL;
+        program->register_count = program->register_capacity = 0;
+    }
 }
 
-static void set_const_fact(ConstFact *facts, size_t count, uint16_t reg, BcValue value) {
-    if ((size_t)reg >= count) return;
-    facts[reg].known = true;
-    facts[reg].value = value;
+/* Points the program at one section of a mapped file, or decodes it;
+ * returns what is wrong with the section, or NULL. */
+static const char *map_section(BcProgram *program, BcProgramMap *map, BinReader *r, uint32_t id, uint64_t minor) {
+    size_t n = 0;
+    const unsigned char *data = NULL;
+    switch ((BcSectionId)id) {
+        case BC_SECTION_CODE_IMAGE:
+        case BC_SECTION_CONSTANTS_IMAGE:
+        case BC_SECTION_TYPES_IMAGE: {
+            size_t elem = id == BC_SECTION_CODE_IMAGE ? sizeof(BcInstr)
+                        : id == BC_SECTION_CONSTANTS_IMAGE ? sizeof(BcValue) : sizeof(BcType);
+            if (!(data = bin_image(r, elem, &n))) return "corrupt";
+            if ((uintptr_t)data % BC_IMAGE_ALIGN) return "misaligned";
+            if (id == BC_SECTION_CODE_IMAGE) {
+                program->code = (BcInstr *)data;
+                program->code_count = program->code_capacity = n;
+            } else if (id == BC_SECTION_CONSTANTS_IMAGE) {
+                if (!image_constants_valid((const BcValue *)data, n)) return "corrupt";
+                program->constants = (BcValue *)data;
+                program->const_count = program->const_capacity = n;
+            } else {
+                if (!image_types_valid((const BcType *)data, n)) return "corrupt";
+                program->register_types = (BcType *)data;
+                program->register_count = program->register_capacity = n;
+            }
+            return NULL;
+        }
+        case BC_SECTION_DEBUG:
+            map->debug = *r;
+            map->debug_pending = true;
+            return NULL;
+        case BC_SECTION_DEOPT:
+            map->deopt = *r;
+            map->deopt_pending = true;
+            return NULL;
+        case BC_SECTION_CODE: read_code_section(program, r); break;
+        case BC_SECTION_CONSTANTS: read_constants_section(program, r); break;
+        case BC_SECTION_TYPES: read_types_section(program, r); break;
+        case BC_SECTION_IC: read_ic_section(program, r, minor); break;
+    }
+    return r->ok && r->p == r->end ? NULL : "corrupt";
 }
 
-static void clear_const_fact(ConstFact *facts, size_t count, uint16_t reg) {
-    if ((size_t)reg < count) facts[reg].known = false;
-}
+bool bc_program_map(BcProgram *program, const char *path, BcError *error) {
+    bc_error_clear(error);
+    if (!program || !path) {
+        bc_binary_error(error, "bytecode map requires a program and a path");
+        return false;
+    }
+    if (program->map || program->code_count || program->const_count ||
+        program->inline_cache_count || program->deopt_count) {
+        bc_binary_error(error, "bytecode map requires an empty program");
+        return false;
+    }
+    BcProgramMap *map = bc_realloc_array(NULL, 1, sizeof(*map));
+    memset(map, 0, sizeof(*map));
+    if (!map_open(map, path)) {
+        free(map);
+        bc_binary_error(error, "could not open bytecode file");
+        return false;
+    }
 
-static bool get_const_fact(const ConstFact *facts, size_t count, uint16_t reg, BcValue *value) {
+    char problem[96] = {0};
+    BinReader r = {map->data, map->data + map->size, true};
+    uint64_t magic = bin_leb(&r);
+    uint64_t major = bin_leb(&r);
+    uint64_t minor = bin_leb(&r);
+    uint64_t sections = bin_leb(&r);
+    if (!r.ok) snprintf(problem, sizeof(problem), "truncated bytecode binary header");
+    else if (magic != BC_MAGIC) snprintf(problem, sizeof(problem), "invalid bytecode magic");
+    else if (major != BC_VERSION_MAJOR) snprintf(problem, sizeof(problem), "unsupported bytecode major version");
+
+    /* An image section stands in for its portable counterpart. */
+    uint32_t seen = 0;
+    for (uint64_t i = 0; !problem[0] && i < sections; i++) {
+        uint64_t id = bin_leb(&r);
+        uint64_t size = bin_leb(&r);
+        if (!r.ok) {
+            snprintf(problem, sizeof(problem), "truncated bytecode section header");
+            break;
+        }
+        if (size > (uint64_t)(r.end - r.p)) {
+            snprintf(problem, sizeof(problem), "truncated bytecode section payload");
+            break;
+        }
+        BinReader section = {r.p, r.p + size, true};
+        r.p += size;
+        if (id > UINT32_MAX || !section_is_known((uint32_t)id)) continue;
+        uint32_t slot = (uint32_t)id >= BC_SECTION_CODE_IMAGE
+            ? (uint32_t)id - (BC_SECTION_CODE_IMAGE - BC_SECTION_CODE) : (uint32_t)id;
+        if (seen & (1u << slot)) {
+            snprintf(problem, sizeof(problem), "duplicate bytecode %s section", section_name((uint32_t)id));
+            break;
+        }
+        seen |= 1u << slot;
+        const char *wrong = map_section(program, map, &section, (uint32_t)id, minor);
+        if (wrong) snprintf(problem, sizeof(problem), "%s bytecode %s section", wrong, section_name((uint32_t)id));
+    }
+    if (problem[0]) {
+        map_detach(program, map);
+        map_release(map);
+        bc_binary_error(error, problem);
+        return false;
+    }
+    program->map = map;
+    return true;
+}
+
+/*
+ * Decodes the debug and deopt sections of a mapped program the first time
+ * something reads them.  Only bc_program_map attaches a mapping, to a
+ * program it was handed as mutable, so dropping const here is sound.
+ */
+static void program_page_in(const BcProgram *program, bool debug, bool deopt) {
+    BcProgramMap *map = program ? program->map : NULL;
+    if (!map) return;
+    BcProgram *p = (BcProgram *)program;
+    if (debug && map->debug_pending) {
+        map->debug_pending = false;
+        size_t cap = p->code_capacity ? p->code_capacity : 1;
+        if (p->debug_mode == BC_DEBUG_FULL_SPANS) {
+            p->spans = bc_realloc_array(p->spans, cap, sizeof(p->spans[0]));
+            for (size_t i = 0; i < cap; i++) p->spans[i] = bc_span("", 0, 0);
+        } else if (p->debug_mode == BC_DEBUG_LINES) {
+            p->lines = bc_realloc_array(p->lines, cap, sizeof(p->lines[0]));
+            memset(p->lines, 0, cap * sizeof(p->lines[0]));
+        }
+        BinReader r = map->debug;
+        read_debug_section(p, &r);
+        if (!r.ok || r.p != r.end) map->corrupt = true;
+    }
+    if (deopt && map->deopt_pending) {
+        map->deopt_pending = false;
+        BinReader r = map->deopt;
+        read_deopt_section(p, &r);
+        if (!r.ok || r.p != r.end) map->corrupt = true;
+    }
+}
+
+/* Copies a mapped program's arrays out of the mapping before anything
+ * grows or rewrites them, then releases the mapping. */
+static void program_own_arrays(BcProgram *program) {
+    BcProgramMap *map = program->map;
+    if (!map) return;
+    program_page_in(program, true, true);
+    if (map_holds(map, program->code)) {
+        BcInstr *code = bc_realloc_array(NULL, program->code_count ? program->code_count : 1, sizeof(code[0]));
+        if (program->code_count) memcpy(code, program->code, program->code_count * sizeof(code[0]));
+        program->code = code;
+    }
+    if (map_holds(map, program->constants)) {
+        BcValue *constants = bc_realloc_array(NULL, program->const_count ? program->const_count : 1,
+                                              sizeof(constants[0]));
+        if (program->const_count) memcpy(constants, program->constants, program->const_count * sizeof(constants[0]));
+        program->constants = constants;
+    }
+    if (map_holds(map, program->register_types)) {
+        BcType *types = bc_realloc_array(NULL, program->register_count ? program->register_count : 1,
+                                         sizeof(types[0]));
+        if (program->register_count)
+            memcpy(types, program->register_types, program->register_count * sizeof(types[0]));
+        program->register_types = types;
+    }
+    size_t cap = program->code_capacity ? program->code_capacity : 1;
+    if (program->debug_mode == BC_DEBUG_FULL_SPANS && !program->spans) {
+        program->spans = bc_realloc_array(NULL, cap, sizeof(program->spans[0]));
+        for (size_t i = 0; i < cap; i++) program->spans[i] = bc_span("", 0, 0);
+    } else if (program->debug_mode == BC_DEBUG_LINES && !program->lines) {
+        program->lines = bc_realloc_array(NULL, cap, sizeof(program->lines[0]));
+        memset(program->lines, 0, cap * sizeof(program->lines[0]));
+    }
+    program->map = NULL;
+    map_release(map);
+}
+
+bool bc_program_page_in(BcProgram *program, BcError *error) {
+    bc_error_clear(error);
+    if (!program || !program->map) return true;
+    program_page_in(program, true, true);
+    if (program->map->corrupt) {
+        bc_binary_error(error, "corrupt bytecode debug or deopt section");
+        return false;
+    }
+    return true;
+}
+
+bool bc_read_binary_info(FILE *in, BcBinaryInfo *info, BcError *error) {
+    bc_error_clear(error);
+    if (!in || !info) {
+        bc_binary_error(error, "bytecode binary info requires input and output");
+        return false;
+    }
+    memset(info, 0, sizeof(*info));
+
+    uint64_t magic = 0, major = 0, minor = 0, sections = 0;
+    if (!read_leb_u64(in, &magic) ||
+        !read_leb_u64(in, &major) ||
+        !read_leb_u64(in, &minor) ||
+        !read_leb_u64(in, &sections)) {
+        bc_binary_error(error, "truncated bytecode binary header");
+        return false;
+    }
+    if (magic != BC_MAGIC) {
+        bc_binary_error(error, "invalid bytecode magic");
+        return false;
+    }
+
+    info->major = (uint32_t)major;
+    info->minor = (uint32_t)minor;
+    info->section_count = sections;
+
+    for (uint64_t i = 0; i < sections; i++) {
+        uint64_t id = 0, size = 0;
+        if (!read_leb_u64(in, &id) || !read_leb_u64(in, &size)) {
+            bc_binary_error(error, "truncated bytecode section header");
+            return false;
+        }
+        bool known = id <= UINT32_MAX && section_is_known((uint32_t)id);
+        if (!known) info->unknown_section_count++;
+        info->total_payload_bytes += size;
+        if (info->stored_section_count < sizeof(info->sections) / sizeof(info->sections[0])) {
+            BcSectionInfo *slot = &info->sections[info->stored_section_count++];
+            slot->id = id <= UINT32_MAX ? (uint32_t)id : BC_SECTION_UNKNOWN;
+            slot->size = size;
+            slot->known = known;
+        }
+        if (!skip_bytes(in, size)) {
+            bc_binary_error(error, "truncated bytecode section payload");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bc_dump_binary_sections(FILE *in, FILE *out, BcError *error) {
+    if (!out) out = stdout;
+    BcBinaryInfo info;
+    if (!bc_read_binary_info(in, &info, error)) return false;
+    fprintf(out, "== bytecode sections v%u.%u ==\n", info.major, info.minor);
+    fprintf(out, "sections=%" PRIu64 " payload=%" PRIu64 " unknown=%" PRIu64 "\n",
+            info.section_count, info.total_payload_bytes, info.unknown_section_count);
+    for (size_t i = 0; i < info.stored_section_count; i++) {
+        BcSectionInfo section = info.sections[i];
+        fprintf(out, "section %u %-12s size=%" PRIu64 "%s\n",
+                section.id,
+                section_name(section.id),
+                section.size,
+                section.known ? "" : " skipped");
+    }
+    if (info.stored_section_count < info.section_count)
+        fprintf(out, "... %" PRIu64 " more section(s) not shown\n",
+                info.section_count - (uint64_t)info.stored_section_count);
+    return true;
+}
+
+BcOptimizeOptions bc_optimize_options_default(void) {
+    BcOptimizeOptions options;
+    options.fold_constants = true;
+    options.remove_self_moves = true;
+    options.forward_moves = true;
+    options.fuse_superinstructions = true;
+    options.compact_nops = true;
+    options.coalesce_registers = true;
+    options.verify_after = true;
+    return options;
+}
+
+static void clear_const_facts(ConstFact *facts, size_t count) {
+    for (size_t i = 0; i < count; i++) facts[i].known = false;
+}
+
+static void set_const_fact(ConstFact *facts, size_t count, uint16_t reg, BcValue value) {
+    if ((size_t)reg >= count) return;
+    facts[reg].known = true;
+    facts[reg].value = value;
+}
+
+static void clear_const_fact(ConstFact *facts, size_t count, uint16_t reg) {
+    if ((size_t)reg < count) facts[reg].known = false;
+}
+
+static bool get_const_fact(const ConstFact *facts, size_t count, uint16_t reg, BcValue *value) {
     if ((size_t)reg >= count || !facts[reg].known) return false;
     *value = facts[reg].value;
     return true;
 }
 
+/*
+ * Operand roles for the rewriting passes.  op_writes_a: the op stores into
+ * r[a].  instr_read_fields: the register fields the instruction reads, in
+ * place; a native call reading more than one register reads the window
+ * r[b..b+c) instead, which has to stay contiguous and is left alone.
+ */
+static bool op_writes_a(BcOp op) {
+    switch (op) {
+        case BC_OP_NOP:
+        case BC_OP_BLOCK:
+        case BC_OP_IF:
+        case BC_OP_IF_LT:
+        case BC_OP_IF_LE:
+        case BC_OP_ELSE:
+        case BC_OP_LOOP:
+        case BC_OP_END:
+        case BC_OP_RETURN:
+        case BC_OP_HALT:
+        case BC_OP_COUNT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+static size_t instr_read_fields(BcInstr *in, uint16_t *fields[2]) {
+    switch ((BcOp)in->op) {
+        case BC_OP_MOV:
+        case BC_OP_NEG:
+        case BC_OP_NOT:
+        case BC_OP_ADDK:
+        case BC_OP_SUBK:
+            fields[0] = &in->b;
+            return 1;
+        case BC_OP_IF:
+        case BC_OP_LOOP:
+        case BC_OP_RETURN:
+            fields[0] = &in->a;
+            return 1;
+        case BC_OP_CALL_NATIVE:
+            if (in->c != 1) return 0;
+            fields[0] = &in->b;
+            return 1;
+        case BC_OP_NOP:
+        case BC_OP_CONST:
+        case BC_OP_NIL:
+        case BC_OP_BOOL:
+        case BC_OP_BLOCK:
+        case BC_OP_ELSE:
+        case BC_OP_END:
+        case BC_OP_HALT:
+        case BC_OP_COUNT:
+            return 0;
+        default:
+            fields[0] = &in->b;
+            fields[1] = &in->c;
+            return 2;
+    }
+}
+
+static bool native_window(BcInstr in) {
+    return in.op == BC_OP_CALL_NATIVE && in.c > 1;
+}
+
+static bool op_is_structured(BcOp op) {
+    return op == BC_OP_BLOCK || op == BC_OP_IF || op == BC_OP_IF_LT || op == BC_OP_IF_LE ||
+           op == BC_OP_ELSE || op == BC_OP_LOOP || op == BC_OP_END;
+}
+
+/* The instruction last written to a register within one straight-line
+ * region; an entry from an older epoch (region) is stale. */
+typedef struct {
+    uint32_t reg;      /* copy pass: the register this one holds a copy of */
+    uint32_t version;  /* copy pass: reg's write count when copied */
+    size_t   instr;    /* fusion pass: the defining instruction */
+    uint32_t epoch;
+} RegionFact;
+
+/*
+ * Copy propagation: within a straight-line region, reads of a register a
+ * mov filled are served by the mov's source while neither is rewritten,
+ * so chains like mov r1 r0; mov r2 r1; add r3 r2 r2 read r0 directly.  A
+ * backward sweep then drops the movs nothing reads anymore.
+ */
+static void forward_moves(BcProgram *program, BcOptimizeReport *r) {
+    size_t n = program->register_count ? program->register_count : 1;
+    RegionFact *copy = calloc(n, sizeof(copy[0]));
+    uint32_t *version = calloc(n, sizeof(version[0]));
+    if (!copy || !version) bc_die_oom(n * sizeof(copy[0]));
+    uint32_t epoch = 1;
+
+    for (size_t i = 0; i < program->code_count; i++) {
+        BcInstr *in = &program->code[i];
+        uint16_t *fields[2];
+        size_t nf = instr_read_fields(in, fields);
+        for (size_t f = 0; f < nf; f++) {
+            RegionFact c = copy[*fields[f]];
+            if (c.epoch == epoch && version[c.reg] == c.version) {
+                *fields[f] = (uint16_t)c.reg;
+                r->moves_forwarded++;
+            }
+        }
+        if (op_is_structured((BcOp)in->op)) {
+            epoch++;
+            continue;
+        }
+        if (!op_writes_a((BcOp)in->op)) continue;
+        if (in->op == BC_OP_MOV && in->a == in->b) {
+            in->op = BC_OP_NOP;
+            r->moves_eliminated++;
+            r->nops_removed++;
+            continue;
+        }
+        version[in->a]++;
+        copy[in->a].epoch = 0;
+        if (in->op == BC_OP_MOV) copy[in->a] = (RegionFact){in->b, version[in->b], 0, epoch};
+    }
+
+    /* Control only flows forward, so a mov is dead once no later
+     * instruction reads its register. */
+    bool *read_later = calloc(n, sizeof(read_later[0]));
+    if (!read_later) bc_die_oom(n * sizeof(read_later[0]));
+    for (size_t i = program->code_count; i-- > 0;) {
+        BcInstr *in = &program->code[i];
+        if (in->op == BC_OP_MOV && !read_later[in->a]) {
+            in->op = BC_OP_NOP;
+            r->moves_eliminated++;
+            r->nops_removed++;
+            continue;
+        }
+        uint16_t *fields[2];
+        size_t nf = instr_read_fields(in, fields);
+        for (size_t f = 0; f < nf; f++) read_later[*fields[f]] = true;
+        if (native_window(*in))
+            for (uint16_t k = 0; k < in->c; k++) read_later[in->b + k] = true;
+    }
+    free(read_later);
+    free(version);
+    free(copy);
+}
+
+static bool numeric_const(const BcProgram *program, const BcInstr *in) {
+    if (in->op != BC_OP_CONST || in->imm >= program->const_count) return false;
+    BcValueKind kind = program->constants[in->imm].kind;
+    return kind == BC_VALUE_I64 || kind == BC_VALUE_F64;
+}
+
+/*
+ * Superinstructions: an add/sub whose operand was just loaded from a
+ * numeric constant becomes addk/subk reading the constant itself, and a
+ * compare feeding only the if right after it becomes if.lt/if.le.  The
+ * load or compare left behind is dropped once nothing else reads it.
+ */
+static void fuse_superinstructions(BcProgram *program, BcOptimizeReport *r) {
+    size_t n = program->register_count ? program->register_count : 1;
+    uint32_t *reads = calloc(n, sizeof(reads[0]));
+    RegionFact *def = calloc(n, sizeof(def[0]));
+    if (!reads || !def) bc_die_oom(n * sizeof(def[0]));
+    for (size_t i = 0; i < program->code_count; i++) {
+        BcInstr *in = &program->code[i];
+        uint16_t *fields[2];
+        size_t nf = instr_read_fields(in, fields);
+        for (size_t f = 0; f < nf; f++) reads[*fields[f]]++;
+        if (native_window(*in))
+            for (uint16_t k = 0; k < in->c; k++) reads[in->b + k]++;
+    }
+    uint32_t epoch = 1;
+
+    for (size_t i = 0; i < program->code_count; i++) {
+        BcInstr *in = &program->code[i];
+        BcOp op = bc_op_generic((BcOp)in->op);
+        if (op == BC_OP_ADD || op == BC_OP_SUB) {
+            BcInstr *k = NULL;
+            uint16_t other = in->b;
+            if (def[in->c].epoch == epoch && numeric_const(program, &program->code[def[in->c].instr])) {
+                k = &program->code[def[in->c].instr];
+            } else if (op == BC_OP_ADD && def[in->b].epoch == epoch &&
+                       numeric_const(program, &program->code[def[in->b].instr])) {
+                k = &program->code[def[in->b].instr];
+                other = in->c;
+            }
+            if (k) {
+                if (reads[k->a] == 1) {
+                    k->op = BC_OP_NOP;
+                    r->nops_removed++;
+                }
+                *in = (BcInstr){(uint8_t)(op == BC_OP_ADD ? BC_OP_ADDK : BC_OP_SUBK), in->a, other, 0, k->imm};
+                r->superinstructions_fused++;
+            }
+        } else if ((op == BC_OP_LT || op == BC_OP_LE || op == BC_OP_GT || op == BC_OP_GE) && reads[in->a] == 1) {
+            size_t next = i + 1;
+            while (next < program->code_count && program->code[next].op == BC_OP_NOP) next++;
+            if (next < program->code_count && program->code[next].op == BC_OP_IF && program->code[next].a == in->a) {
+                bool swap = op == BC_OP_GT || op == BC_OP_GE;
+                BcOp fused = op == BC_OP_LT || op == BC_OP_GT ? BC_OP_IF_LT : BC_OP_IF_LE;
+                program->code[next] = (BcInstr){(uint8_t)fused, 0, swap ? in->c : in->b, swap ? in->b : in->c, 0};
+                in->op = BC_OP_NOP;
+                r->nops_removed++;
+                r->superinstructions_fused++;
+                continue;
+            }
+        }
+        if (op_is_structured((BcOp)in->op)) epoch++;
+        else if (op_writes_a((BcOp)in->op)) def[in->a] = (RegionFact){0, 0, i, epoch};
+    }
+    free(def);
+    free(reads);
+}
+
+/* Widens deopt point dp to also restore registers [first, end). */
+static void deopt_cover(BcDeoptPoint *dp, uint32_t first, uint32_t end) {
+    if (first >= end) return;
+    if (!dp->register_count) {
+        dp->first_register = first;
+        dp->register_count = end - first;
+        return;
+    }
+    uint32_t lo = dp->first_register < first ? dp->first_register : first;
+    uint32_t hi = dp->first_register + dp->register_count > end ? dp->first_register + dp->register_count : end;
+    dp->first_register = lo;
+    dp->register_count = hi - lo;
+}
+
+/* Drops nops, moving debug info, inline cache call sites and deopt
+ * safepoints along; a safepoint on a dropped instruction moves to the
+ * next one, merging with a map already there. */
+static void compact_nops(BcProgram *program) {
+    size_t *remap = bc_realloc_array(NULL, program->code_count + 1, sizeof(remap[0]));
+    size_t out = 0;
+    for (size_t i = 0; i < program->code_count; i++) {
+        remap[i] = out;
+        if (program->code[i].op == BC_OP_NOP) continue;
+        if (out != i) {
+            program->code[out] = program->code[i];
+            if (program->debug_mode == BC_DEBUG_FULL_SPANS && program->spans)
+                program->spans[out] = program->spans[i];
+            else if (program->debug_mode == BC_DEBUG_LINES && program->lines)
+                program->lines[out] = program->lines[i];
+        }
+        out++;
+    }
+    remap[program->code_count] = out;
+
+    for (size_t k = 0; k < program->inline_cache_count; k++) {
+        BcInlineCache *ic = &program->inline_caches[k];
+        if (ic->callsite < program->code_count) ic->callsite = (uint32_t)remap[ic->callsite];
+    }
+    size_t kept = 0;
+    for (size_t d = 0; d < program->deopt_count; d++) {
+        BcDeoptPoint dp = program->deopts[d];
+        if (dp.safepoint <= program->code_count) dp.safepoint = (uint32_t)remap[dp.safepoint];
+        size_t e = 0;
+        while (e < kept && program->deopts[e].safepoint != dp.safepoint) e++;
+        if (e < kept) deopt_cover(&program->deopts[e], dp.first_register, dp.first_register + dp.register_count);
+        else program->deopts[kept++] = dp;
+    }
+    program->deopt_count = kept;
+    program->code_count = out;
+    free(remap);
+}
+
+/* A register's live range in read/write positions: instruction i reads at
+ * 2i+1 and writes at 2i+2, and 0 is the all-nil entry state. */
+typedef struct {
+    size_t start;
+    size_t end;
+    bool   used;
+    bool   pinned;  /* part of a native call window: keeps its number */
+} LiveRange;
+
+typedef struct {
+    bool *entry;     /* definitely assigned where the if/loop was entered */
+    bool *then_set;  /* ... leaving the then-branch */
+    bool  then_dead;
+    bool  branches;  /* if/loop, not a plain block */
+} AssignFrame;
+
+static void live_use(LiveRange *live, uint16_t reg, size_t pos, bool assigned) {
+    LiveRange *l = &live[reg];
+    size_t start = assigned ? pos : 0;
+    if (!l->used || start < l->start) l->start = start;
+    if (!l->used || pos > l->end) l->end = pos;
+    l->used = true;
+}
+
+static void assign_meet(bool *set, const bool *other, size_t n) {
+    for (size_t k = 0; k < n; k++) set[k] = set[k] && other[k];
+}
+
+/*
+ * Live ranges for register coalescing.  Control only flows forward, so
+ * the span from a register's first write to its last read covers every
+ * path between them; a register read where some path has not written it
+ * yet reads nil and is live from the entry.  That is a structured walk:
+ * if/else meet their branches, a loop body (run at most once) meets the
+ * skip path, and return/halt assign everything.
+ */
+static void live_ranges(const BcProgram *program, LiveRange *live, size_t n) {
+    bool *assigned = calloc(n, sizeof(assigned[0]));
+    AssignFrame *frames = calloc(BC_STRUCTURED_DEPTH_MAX, sizeof(frames[0]));
+    if (!assigned || !frames) bc_die_oom(n * sizeof(assigned[0]));
+    size_t depth = 0;
+    bool dead = false;
+
+    for (size_t i = 0; i < program->code_count; i++) {
+        BcInstr in = program->code[i];
+        uint16_t *fields[2];
+        size_t nf = instr_read_fields(&in, fields);
+        for (size_t f = 0; f < nf; f++) live_use(live, *fields[f], 2 * i + 1, dead || assigned[*fields[f]]);
+        if (native_window(in)) {
+            for (uint16_t k = 0; k < in.c; k++) {
+                live_use(live, (uint16_t)(in.b + k), 2 * i + 1, dead || assigned[in.b + k]);
+                live[in.b + k].pinned = true;
+            }
+        }
+        if (op_writes_a((BcOp)in.op)) {
+            live_use(live, in.a, 2 * i + 2, true);
+            assigned[in.a] = true;
+        }
+
+        switch ((BcOp)in.op) {
+            case BC_OP_BLOCK:
+                frames[depth++] = (AssignFrame){NULL, NULL, false, false};
+                break;
+            case BC_OP_IF:
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+            case BC_OP_LOOP: {
+                AssignFrame *f = &frames[depth++];
+                *f = (AssignFrame){bc_realloc_array(NULL, n, sizeof(bool)), NULL, false, true};
+                memcpy(f->entry, assigned, n * sizeof(bool));
+                break;
+            }
+            case BC_OP_ELSE: {
+                AssignFrame *f = &frames[depth - 1];
+                f->then_set = bc_realloc_array(NULL, n, sizeof(bool));
+                memcpy(f->then_set, assigned, n * sizeof(bool));
+                f->then_dead = dead;
+                memcpy(assigned, f->entry, n * sizeof(bool));
+                dead = false;
+                break;
+            }
+            case BC_OP_END: {
+                AssignFrame f = frames[--depth];
+                if (!f.branches) break;
+                /* The other way out: the then-branch, or skipping the body. */
+                const bool *other = f.then_set ? f.then_set : f.entry;
+                bool other_dead = f.then_set ? f.then_dead : false;
+                if (dead && !other_dead) memcpy(assigned, other, n * sizeof(bool));
+                else if (!dead && !other_dead) assign_meet(assigned, other, n);
+                dead = dead && other_dead;
+                free(f.entry);
+                free(f.then_set);
+                break;
+            }
+            case BC_OP_RETURN:
+            case BC_OP_HALT:
+                dead = true;
+                break;
+            default:
+                break;
+        }
+    }
+    while (depth) {
+        depth--;
+        free(frames[depth].entry);
+        free(frames[depth].then_set);
+    }
+    free(frames);
+    free(assigned);
+}
+
+/*
+ * Register coalescing: registers of one declared type whose live ranges
+ * do not overlap share a number, taken lowest first in order of range
+ * start (a linear scan over a forward-only program).  Window registers
+ * keep theirs.  Deopt maps restore the range the renamed registers land
+ * in, a superset of what they listed.
+ */
+static void coalesce_registers(BcProgram *program) {
+    size_t n = program->register_count;
+    if (!n) return;
+    LiveRange *live = calloc(n, sizeof(live[0]));
+    uint32_t *color = bc_realloc_array(NULL, n, sizeof(color[0]));
+    size_t *free_from = calloc(n, sizeof(free_from[0]));  /* position after the last range given each color */
+    BcType *color_type = bc_realloc_array(NULL, n, sizeof(color_type[0]));
+    bool *taken = calloc(n, sizeof(taken[0]));
+    size_t *order = bc_realloc_array(NULL, n, sizeof(order[0]));
+    if (!live || !free_from || !taken) bc_die_oom(n * sizeof(live[0]));
+    live_ranges(program, live, n);
+
+    size_t count = 0;
+    for (size_t k = 0; k < n; k++) {
+        color[k] = UINT32_MAX;
+        color_type[k] = BC_TYPE_UNKNOWN;
+        BcType t = program->register_types ? program->register_types[k] : BC_TYPE_UNKNOWN;
+        if (live[k].pinned) {
+            color[k] = (uint32_t)k;
+            color_type[k] = t;
+            taken[k] = true;
+        } else if (live[k].used) {
+            order[count++] = k;
+        }
+    }
+    /* Insertion sort by range start; ties keep register order. */
+    for (size_t x = 1; x < count; x++) {
+        size_t reg = order[x], y = x;
+        while (y > 0 && live[order[y - 1]].start > live[reg].start) {
+            order[y] = order[y - 1];
+            y--;
+        }
+        order[y] = reg;
+    }
+    for (size_t x = 0; x < count; x++) {
+        size_t reg = order[x];
+        BcType t = program->register_types ? program->register_types[reg] : BC_TYPE_UNKNOWN;
+        for (size_t c = 0; c < n; c++) {
+            if (taken[c] && (color_type[c] != t || free_from[c] > live[reg].start)) continue;
+            if (live[c].pinned && live[c].start <= live[reg].end && live[reg].start <= live[c].end) continue;
+            color[reg] = (uint32_t)c;
+            color_type[c] = t;
+            taken[c] = true;
+            free_from[c] = live[reg].end + 1;
+            break;
+        }
+    }
+
+    size_t used = 0;
+    for (size_t k = 0; k < n; k++)
+        if (color[k] != UINT32_MAX && color[k] + 1 > used) used = color[k] + 1;
+    for (size_t i = 0; i < program->code_count; i++) {
+        BcInstr *in = &program->code[i];
+        uint16_t *fields[2];
+        size_t nf = instr_read_fields(in, fields);
+        for (size_t f = 0; f < nf; f++) *fields[f] = (uint16_t)color[*fields[f]];
+        if (op_writes_a((BcOp)in->op)) in->a = (uint16_t)color[in->a];
+        if (in->op == BC_OP_CALL_NATIVE && in->c == 0) in->b = in->a;
+    }
+    for (size_t d = 0; d < program->deopt_count; d++) {
+        BcDeoptPoint *dp = &program->deopts[d];
+        uint32_t lo = UINT32_MAX, hi = 0;
+        for (size_t k = dp->first_register; k < (size_t)dp->first_register + dp->register_count && k < n; k++) {
+            if (color[k] == UINT32_MAX) continue;
+            if (color[k] < lo) lo = color[k];
+            if (color[k] + 1 > hi) hi = color[k] + 1;
+        }
+        dp->first_register = lo == UINT32_MAX ? 0 : lo;
+        dp->register_count = lo == UINT32_MAX ? 0 : hi - lo;
+    }
+    if (program->register_types) {
+        for (size_t k = 0; k < used; k++) program->register_types[k] = color_type[k];
+        for (size_t k = used; k < program->register_capacity; k++) program->register_types[k] = BC_TYPE_UNKNOWN;
+    }
+    program->register_count = used;
+
+    free(order);
+    free(taken);
+    free(color_type);
+    free(free_from);
+    free(color);
+    free(live);
+}
+
 bool bc_optimize_program(BcProgram *program,
                          const BcOptimizeOptions *options,
                          BcOptimizeReport *report,
@@ -1350,9 +2723,11 @@ bool bc_optimize_program(BcProgram *program,
         bc_errorf(error, program, 0, 0, "bytecode optimizer requires a program");
         return false;
     }
+    if (program->map) program_own_arrays(program);
     BcOptimizeOptions local = options ? *options : bc_optimize_options_default();
     BcOptimizeReport r = {0};
     r.before_instructions = program->code_count;
+    r.registers_before = program->register_count;
 
     BcError verify_error;
     if (!bc_verify(program, &verify_error)) {
@@ -1407,10 +2782,20 @@ bool bc_optimize_program(BcProgram *program,
             case BC_OP_LE:
             case BC_OP_GT:
             case BC_OP_GE:
+            case BC_OP_ADD_I64:
+            case BC_OP_SUB_I64:
+            case BC_OP_MUL_I64:
+            case BC_OP_ADD_F64:
+            case BC_OP_SUB_F64:
+            case BC_OP_MUL_F64:
+            case BC_OP_LT_I64:
+            case BC_OP_LE_I64:
+            case BC_OP_GT_I64:
+            case BC_OP_GE_I64:
                 if (local.fold_constants &&
                     get_const_fact(facts, program->register_count, in->b, &left) &&
                     get_const_fact(facts, program->register_count, in->c, &right) &&
-                    value_i64_binary((BcOp)in->op, left, right, &folded)) {
+                    value_i64_binary(bc_op_generic((BcOp)in->op), left, right, &folded)) {
                     uint32_t constant = bc_program_add_const(program, folded);
                     r.constants_added++;
                     in->op = BC_OP_CONST;
@@ -1457,10 +2842,14 @@ bool bc_optimize_program(BcProgram *program,
                 }
                 break;
             case BC_OP_CALL_NATIVE:
+            case BC_OP_ADDK:
+            case BC_OP_SUBK:
                 clear_const_fact(facts, program->register_count, in->a);
                 break;
             case BC_OP_BLOCK:
             case BC_OP_IF:
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
             case BC_OP_ELSE:
             case BC_OP_LOOP:
             case BC_OP_END:
@@ -1475,23 +2864,13 @@ bool bc_optimize_program(BcProgram *program,
     }
     free(facts);
 
-    if (local.compact_nops && r.nops_removed) {
-        size_t out = 0;
-        for (size_t i = 0; i < program->code_count; i++) {
-            if (program->code[i].op == BC_OP_NOP) continue;
-            if (out != i) {
-                program->code[out] = program->code[i];
-                if (program->debug_mode == BC_DEBUG_FULL_SPANS && program->spans)
-                    program->spans[out] = program->spans[i];
-                else if (program->debug_mode == BC_DEBUG_LINES && program->lines)
-                    program->lines[out] = program->lines[i];
-            }
-            out++;
-        }
-        program->code_count = out;
-    }
+    if (local.forward_moves) forward_moves(program, &r);
+    if (local.fuse_superinstructions) fuse_superinstructions(program, &r);
+    if (local.compact_nops && r.nops_removed) compact_nops(program);
+    if (local.coalesce_registers) coalesce_registers(program);
 
     r.after_instructions = program->code_count;
+    r.registers_after = program->register_count;
     if (local.verify_after && !bc_verify(program, &verify_error)) {
         if (error) *error = verify_error;
         if (report) *report = r;
@@ -1538,8 +2917,11 @@ bool bc_optimize_trace(BcProgram *program,
     fprintf(out, "%s├─ %spasses\n", BC_CLR_GRAY, BC_CLR_RESET);
     fprintf(out, "%s│   ├─ %sconstant folds: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.constants_folded);
     fprintf(out, "%s│   ├─ %sdead/self moves: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.moves_eliminated);
+    fprintf(out, "%s│   ├─ %smoves forwarded: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.moves_forwarded);
+    fprintf(out, "%s│   ├─ %ssuperinstructions: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.superinstructions_fused);
     fprintf(out, "%s│   ├─ %snops removed: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.nops_removed);
-    fprintf(out, "%s│   └─ %sconstants added: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.constants_added);
+    fprintf(out, "%s│   ├─ %sconstants added: %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.constants_added);
+    fprintf(out, "%s│   └─ %sregisters %zu -> %zu\n", BC_CLR_GRAY, BC_CLR_RESET, r.registers_before, r.registers_after);
     fprintf(out, "%s├─ %sinstructions %zu -> %zu\n", BC_CLR_GRAY, BC_CLR_RESET, before, program->code_count);
     fprintf(out, "%s├─ %safter\n", BC_CLR_GRAY, BC_CLR_RESET);
     for (size_t i = 0; i < program->code_count; i++) {
@@ -1553,12 +2935,281 @@ bool bc_optimize_trace(BcProgram *program,
     return ok;
 }
 
+/*
+ * Baseline JIT.  Compiled code runs on a state array of 64-bit words,
+ * addressed through rbx: the payload of every register, then every
+ * register's BcValueKind, then the exit words below.  Payloads carry the
+ * raw I64, 0/1 for Bool, 0 for Nil, the bits for F64 and the pointer for
+ * Ptr, so the VM can hand the array over at an OSR entry and take it back
+ * at a deoptimization without knowing what the code assumed.
+ *
+ * The compiler tracks, per register, the one type it holds on every path
+ * reaching the current instruction (BC_TYPE_UNKNOWN once two paths
+ * disagree).  An operand whose type is unknown is read behind a guard on
+ * its kind word; a failed guard exits with JIT_RESUME set to the guarded
+ * instruction, before any of its effects.
+ */
+#define JIT_KIND(n, reg)    ((size_t)(n) + (size_t)(reg))
+#define JIT_RESUME(n)       (2u * (size_t)(n))       /* instruction to resume at, or -1 */
+#define JIT_RESULT_KIND(n)  (2u * (size_t)(n) + 1u)  /* kind of the result, or -1 */
+#define JIT_VM(n)           (2u * (size_t)(n) + 2u)  /* BcVM * handed to natives */
+#define JIT_STATE_WORDS(n)  (2u * (size_t)(n) + 3u)
+#define JIT_NATIVE_FAILED   (-1)
+
+typedef struct {
+    size_t patch;     /* rel32 of the guard's jump */
+    size_t instr;
+    bool   failed;    /* a native call returned false */
+} JitExit;
+
+typedef struct {
+    const BcProgram    *program;
+    const BcJitOptions *options;
+    BcError            *error;
+    CodeBuf             cb;
+    size_t              n;        /* state registers: register_count, at least 1 */
+    BcType             *types;
+    JitExit            *exits;
+    size_t              exit_count;
+    size_t              exit_capacity;
+    size_t              guards;
+    bool                calls_natives;
+} JitCompile;
+
+static const BcDeoptPoint *deopt_point_at(const BcProgram *program, size_t safepoint) {
+    program_page_in(program, false, true);
+    for (size_t d = 0; d < program->deopt_count; d++)
+        if (program->deopts[d].safepoint == safepoint) return &program->deopts[d];
+    return NULL;
+}
+
+static const BcInlineCache *inline_cache_at(const BcProgram *program, size_t callsite) {
+    for (size_t k = 0; k < program->inline_cache_count; k++)
+        if (program->inline_caches[k].callsite == callsite) return &program->inline_caches[k];
+    return NULL;
+}
+
+/* The native serving receiver type t at a call of generic: generic's
+ * variant for t if one is registered, else generic itself. */
+static uint32_t native_for_receiver(const BcProgram *program, uint32_t generic, BcType t) {
+    for (size_t k = 0; k < program->native_count; k++)
+        if (program->natives[k].generic == generic && program->natives[k].receiver_type == t) return (uint32_t)k;
+    return generic;
+}
+
+/* Whether a cache entry still names a native serving its type at a call
+ * of generic; a program read from disk may bind fewer natives. */
+static bool ic_entry_serves(const BcProgram *program, uint32_t generic, BcInlineCacheEntry entry) {
+    if (entry.target >= program->native_count) return false;
+    const BcNative *native = &program->natives[entry.target];
+    return entry.target == generic || (native->generic == generic && native->receiver_type == entry.receiver_type);
+}
+
+static BcValueKind kind_of_type(BcType type) {
+    switch (type) {
+        case BC_TYPE_BOOL: return BC_VALUE_BOOL;
+        case BC_TYPE_I64: return BC_VALUE_I64;
+        case BC_TYPE_F64: return BC_VALUE_F64;
+        case BC_TYPE_PTR: return BC_VALUE_PTR;
+        default: return BC_VALUE_NIL;
+    }
+}
+
+static BcValue jit_unbox(int64_t kind, int64_t raw) {
+    switch ((BcValueKind)kind) {
+        case BC_VALUE_BOOL: return bc_value_bool(raw != 0);
+        case BC_VALUE_I64: return bc_value_i64(raw);
+        case BC_VALUE_F64: {
+            double d;
+            memcpy(&d, &raw, sizeof(d));
+            return bc_value_f64(d);
+        }
+        case BC_VALUE_PTR: return bc_value_ptr((void *)(intptr_t)raw);
+        default: return bc_value_nil();
+    }
+}
+
+static BcValue jit_state_get(const int64_t *state, size_t n, size_t reg) {
+    return jit_unbox(state[JIT_KIND(n, reg)], state[reg]);
+}
+
+static void jit_state_set(int64_t *state, size_t n, size_t reg, BcValue value) {
+    int64_t raw = 0;
+    switch (value.kind) {
+        case BC_VALUE_BOOL: raw = value.as.boolean ? 1 : 0; break;
+        case BC_VALUE_I64: raw = value.as.i64; break;
+        case BC_VALUE_F64: memcpy(&raw, &value.as.f64, sizeof(raw)); break;
+        case BC_VALUE_PTR: raw = (int64_t)(intptr_t)value.as.ptr; break;
+        case BC_VALUE_NIL: break;
+    }
+    state[reg] = raw;
+    state[JIT_KIND(n, reg)] = (int64_t)value.kind;
+}
+
+/* Called from compiled code for bc.call-native; 0 means the native failed. */
+static int jit_call_native(const BcProgram *program, int64_t *state, uint32_t instr, uint32_t native_index) {
+    size_t n = program->register_count ? program->register_count : 1;
+    BcInstr in = program->code[instr];
+    BcValue args[256];
+    for (uint16_t k = 0; k < in.c; k++) args[k] = jit_state_get(state, n, (size_t)in.b + k);
+    BcNative native = program->natives[native_index];
+    BcValue out = bc_value_nil();
+    if (!native.fn((BcVM *)(intptr_t)state[JIT_VM(n)], args, (uint8_t)in.c, &out, native.userdata)) return 0;
+    jit_state_set(state, n, in.a, out);
+    return 1;
+}
+
+static void jit_merge_types(BcType *types, const BcType *other, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        if (types[i] != other[i]) types[i] = BC_TYPE_UNKNOWN;
+}
+
+static BcType *jit_snapshot(const BcType *types, size_t count) {
+    BcType *copy = bc_realloc_array(NULL, count, sizeof(BcType));
+    memcpy(copy, types, count * sizeof(BcType));
+    return copy;
+}
+
+static size_t x64_jcc_rel32(CodeBuf *cb, uint8_t cc) {
+    cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, cc);
+    cb_emit_i32(cb, 0);
+    return cb->count - 4;
+}
+
+static size_t x64_jmp_rel32(CodeBuf *cb) {
+    cb_emit_u8(cb, 0xe9);
+    cb_emit_i32(cb, 0);
+    return cb->count - 4;
+}
+
+/* Points the rel32 at `at` to `target`. */
+static void x64_patch_rel32(CodeBuf *cb, size_t at, size_t target) {
+    int32_t rel = (int32_t)((int64_t)target - (int64_t)(at + 4));
+    for (int i = 0; i < 4; i++) cb->data[at + (size_t)i] = (uint8_t)(((uint32_t)rel >> (8u * (uint32_t)i)) & 0xffu);
+}
+
+static void jit_add_exit(JitCompile *jc, size_t patch, size_t instr, bool failed) {
+    if (jc->exit_count == jc->exit_capacity) {
+        jc->exit_capacity = jc->exit_capacity ? jc->exit_capacity * 2 : 16;
+        jc->exits = bc_realloc_array(jc->exits, jc->exit_capacity, sizeof(jc->exits[0]));
+    }
+    jc->exits[jc->exit_count++] = (JitExit){patch, instr, failed};
+}
+
+/* Stores rax into reg and records its (static) type and kind. */
+static void jit_set_reg(JitCompile *jc, uint16_t reg, BcType type) {
+    x64_mov_slot_rax(&jc->cb, reg);
+    x64_mov_slot_imm32(&jc->cb, JIT_KIND(jc->n, reg), (int32_t)kind_of_type(type));
+    jc->types[reg] = type;
+}
+
+static bool jit_can_deopt(const JitCompile *jc, size_t i) {
+    return !jc->options->require_deopt_maps || deopt_point_at(jc->program, i);
+}
+
+/* Exits to the interpreter at i unless reg's kind word is (or, with
+ * jcc = je, is not) `kind`. */
+static void jit_guard(JitCompile *jc, size_t i, uint16_t reg, BcValueKind kind, uint8_t jcc) {
+    x64_cmp_slot_imm8(&jc->cb, JIT_KIND(jc->n, reg), (int8_t)kind);
+    jit_add_exit(jc, x64_jcc_rel32(&jc->cb, jcc), i, false);
+    jc->guards++;
+}
+
+/*
+ * Operand reg of instruction i must be `want`; BC_TYPE_UNKNOWN asks for
+ * any value whose payload tests truthiness directly (everything but F64).
+ * A path-dependent operand is guarded where a deopt map allows it.
+ */
+static bool jit_operand(JitCompile *jc, size_t i, uint16_t reg, BcType want) {
+    BcType t = jc->types[reg];
+    if (want == BC_TYPE_UNKNOWN ? t != BC_TYPE_F64 && t != BC_TYPE_UNKNOWN : t == want) return true;
+    if (t == BC_TYPE_UNKNOWN && jit_can_deopt(jc, i)) {
+        if (want == BC_TYPE_UNKNOWN) {
+            jit_guard(jc, i, reg, BC_VALUE_F64, 0x84 /* je */);
+        } else {
+            jit_guard(jc, i, reg, kind_of_type(want), 0x85 /* jne */);
+            jc->types[reg] = want;
+        }
+        return true;
+    }
+    bc_errorf(jc->error, jc->program, i, jc->program->code[i].op,
+              "baseline JIT needs r%u to be %s on every path into %s; it is %s", reg,
+              want == BC_TYPE_UNKNOWN ? "I64/Bool/Nil/Ptr" : bc_type_name(want),
+              bc_op_name((BcOp)jc->program->code[i].op), bc_type_name(t));
+    return false;
+}
+
+static bool jit_i64_operands(JitCompile *jc, size_t i, BcInstr in) {
+    return jit_operand(jc, i, in.b, BC_TYPE_I64) && jit_operand(jc, i, in.c, BC_TYPE_I64);
+}
+
+static void jit_emit_native_call(JitCompile *jc, size_t i, uint32_t target) {
+    CodeBuf *cb = &jc->cb;
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xbf);
+    cb_emit_i64(cb, (int64_t)(intptr_t)jc->program);                 /* mov rdi, program */
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xde); /* mov rsi, rbx */
+    cb_emit_u8(cb, 0xba); cb_emit_i32(cb, (int32_t)i);                /* mov edx, instr */
+    cb_emit_u8(cb, 0xb9); cb_emit_i32(cb, (int32_t)target);           /* mov ecx, native */
+    x64_mov_rax_imm64(cb, (int64_t)(intptr_t)&jit_call_native);
+    cb_emit_u8(cb, 0xff); cb_emit_u8(cb, 0xd0);                       /* call rax */
+    cb_emit_u8(cb, 0x85); cb_emit_u8(cb, 0xc0);                       /* test eax,eax */
+    jit_add_exit(jc, x64_jcc_rel32(cb, 0x84 /* jz */), i, true);
+}
+
+/*
+ * r[a] = natives[..](r[b..b+c)) through jit_call_native.  A monomorphic
+ * or polymorphic inline cache speculates that the receiver r[b] has one
+ * of the cached types: the code dispatches on its kind to each type's
+ * cached target, and any other kind deoptimizes.  Where the receiver's
+ * type is already known the cached target is called without a guard.
+ * Megamorphic sites call the generic native.
+ */
+static void jit_call(JitCompile *jc, size_t i, BcInstr in) {
+    const BcInlineCache *ic = jc->options->enable_inline_caches ? inline_cache_at(jc->program, i) : NULL;
+    BcInlineCacheEntry entries[BC_IC_MAX_ENTRIES];
+    size_t count = 0;
+    if (ic && in.c > 0 && (ic->state == BC_IC_MONOMORPHIC || ic->state == BC_IC_POLYMORPHIC))
+        for (uint32_t e = 0; e < ic->entry_count; e++)
+            if (ic->entries[e].receiver_type != BC_TYPE_UNKNOWN && ic_entry_serves(jc->program, in.imm, ic->entries[e]))
+                entries[count++] = ic->entries[e];
+
+    BcType t = count ? jc->types[in.b] : BC_TYPE_UNKNOWN;
+    uint32_t target = in.imm;
+    for (size_t e = 0; e < count; e++)
+        if (entries[e].receiver_type == t) target = entries[e].target;
+    if (t != BC_TYPE_UNKNOWN || !count || !jit_can_deopt(jc, i)) {
+        jit_emit_native_call(jc, i, target);
+    } else {
+        size_t joins[BC_IC_MAX_ENTRIES];
+        for (size_t e = 0; e < count; e++) {
+            BcValueKind kind = kind_of_type(entries[e].receiver_type);
+            size_t skip = 0;
+            if (e + 1 < count) {
+                x64_cmp_slot_imm8(&jc->cb, JIT_KIND(jc->n, in.b), (int8_t)kind);
+                skip = x64_jcc_rel32(&jc->cb, 0x85 /* jne */);
+            } else {
+                jit_guard(jc, i, in.b, kind, 0x85 /* jne */);
+            }
+            jit_emit_native_call(jc, i, entries[e].target);
+            if (e + 1 < count) {
+                joins[e] = x64_jmp_rel32(&jc->cb);
+                x64_patch_rel32(&jc->cb, skip, jc->cb.count);
+            }
+        }
+        for (size_t e = 0; e + 1 < count; e++) x64_patch_rel32(&jc->cb, joins[e], jc->cb.count);
+        if (count == 1) jc->types[in.b] = entries[0].receiver_type;
+    }
+    jc->types[in.a] = jc->program->natives[in.imm].return_type;
+    jc->calls_natives = true;
+}
+
 BcJitOptions bc_jit_options_default(void) {
     BcJitOptions options;
     options.tier = BC_JIT_BASELINE_TEMPLATE;
     options.enable_inline_caches = true;
     options.require_deopt_maps = true;
     options.trace = false;
+    options.osr_instr = SIZE_MAX;
     return options;
 }
 
@@ -1584,164 +3235,331 @@ bool bc_jit_compile_baseline(const BcProgram *program,
         return false;
     }
 
-    BcType *types = calloc(program->register_count ? program->register_count : 1, sizeof(BcType));
-    if (!types) bc_die_oom(program->register_count * sizeof(BcType));
-    CodeBuf cb = {0};
+    BcJitOptions defaults = bc_jit_options_default();
+    JitCompile jcs = {0};
+    JitCompile *jc = &jcs;
+    jc->program = program;
+    jc->options = options ? options : &defaults;
+    jc->error = error;
+    jc->n = program->register_count ? program->register_count : 1;
+    jc->types = bc_realloc_array(NULL, jc->n, sizeof(BcType));
+    for (size_t r = 0; r < jc->n; r++) jc->types[r] = BC_TYPE_NIL;
+    CodeBuf *cb = &jc->cb;
+    BcType *types = jc->types;
+    size_t nregs = jc->n;
+
+    JitFrame frames[BC_STRUCTURED_DEPTH_MAX];
+    size_t depth = 0;
     bool returned = false;
-
-    size_t frame_bytes = program->register_count ? program->register_count * 8 : 8;
-    frame_bytes = (frame_bytes + 15u) & ~(size_t)15u;
-
-    cb_emit_u8(&cb, 0x55);                         /* push rbp */
-    cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x89); cb_emit_u8(&cb, 0xe5); /* mov rbp,rsp */
-    x64_emit_probed_stack_alloc(&cb, frame_bytes);
+    bool live = true;
+    BcType result_type = BC_TYPE_NIL;
+    size_t osr_target = SIZE_MAX;
+    size_t osr_at = jc->options->osr_instr;
+    if (osr_at >= program->code_count || program->code[osr_at].op != BC_OP_LOOP || !jit_can_deopt(jc, osr_at))
+        osr_at = SIZE_MAX;
+
+    /* vm_entry: the caller's state array arrives in rdi. */
+    x64_prologue(cb);
+    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xfb); /* mov rbx,rdi */
+    size_t body = cb->count;
 
     for (size_t i = 0; i < program->code_count; i++) {
         BcInstr in = program->code[i];
+        if (i == osr_at) osr_target = cb->count;
         switch ((BcOp)in.op) {
             case BC_OP_NOP:
-            case BC_OP_BLOCK:
-            case BC_OP_END:
                 break;
-            case BC_OP_CONST:
-                if (program->constants[in.imm].kind != BC_VALUE_I64 &&
-                    program->constants[in.imm].kind != BC_VALUE_BOOL &&
-                    program->constants[in.imm].kind != BC_VALUE_NIL) {
-                    bc_errorf(error, program, i, in.op, "baseline JIT supports only I64/Bool/Nil constants");
-                    free(types); free(cb.data); return false;
+            case BC_OP_CONST: {
+                BcValue k = program->constants[in.imm];
+                if (k.kind != BC_VALUE_I64 && k.kind != BC_VALUE_BOOL && k.kind != BC_VALUE_NIL) {
+                    bc_errorf(error, program, i, in.op, "baseline JIT supports only I64/Bool/Nil constants; unsupported %s",
+                              bc_type_name(bc_type_of_value(k)));
+                    goto fail;
                 }
-                types[in.a] = bc_type_of_value(program->constants[in.imm]);
-                if (program->constants[in.imm].kind == BC_VALUE_BOOL)
-                    x64_mov_rax_imm64(&cb, program->constants[in.imm].as.boolean ? 1 : 0);
-                else if (program->constants[in.imm].kind == BC_VALUE_NIL)
-                    x64_mov_rax_imm64(&cb, 0);
-                else
-                    x64_mov_rax_imm64(&cb, program->constants[in.imm].as.i64);
-                x64_mov_slot_rax(&cb, in.a);
+                x64_mov_rax_imm64(cb, k.kind == BC_VALUE_BOOL ? (k.as.boolean ? 1 : 0) :
+                                      k.kind == BC_VALUE_NIL ? 0 : k.as.i64);
+                jit_set_reg(jc, in.a, bc_type_of_value(k));
                 break;
+            }
             case BC_OP_NIL:
-                types[in.a] = BC_TYPE_NIL;
-                x64_mov_rax_imm64(&cb, 0);
-                x64_mov_slot_rax(&cb, in.a);
+                x64_mov_rax_imm64(cb, 0);
+                jit_set_reg(jc, in.a, BC_TYPE_NIL);
                 break;
             case BC_OP_BOOL:
-                types[in.a] = BC_TYPE_BOOL;
-                x64_mov_rax_imm64(&cb, in.imm ? 1 : 0);
-                x64_mov_slot_rax(&cb, in.a);
+                x64_mov_rax_imm64(cb, in.imm ? 1 : 0);
+                jit_set_reg(jc, in.a, BC_TYPE_BOOL);
                 break;
             case BC_OP_MOV:
+                x64_mov_rax_slot(cb, JIT_KIND(nregs, in.b));
+                x64_mov_slot_rax(cb, JIT_KIND(nregs, in.a));
+                x64_mov_rax_slot(cb, in.b);
+                x64_mov_slot_rax(cb, in.a);
                 types[in.a] = types[in.b];
-                x64_mov_rax_slot(&cb, in.b);
-                x64_mov_slot_rax(&cb, in.a);
                 break;
             case BC_OP_ADD:
-                types[in.a] = numeric_result(types[in.b], types[in.c]);
-                x64_mov_rax_slot(&cb, in.b);
-                x64_binop_slot(&cb, 0x03, in.c); /* add rax, mem */
-                x64_mov_slot_rax(&cb, in.a);
+            case BC_OP_ADD_I64:
+                if (!jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                x64_binop_slot(cb, 0x03, in.c); /* add rax, mem */
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
                 break;
             case BC_OP_SUB:
-                types[in.a] = numeric_result(types[in.b], types[in.c]);
-                x64_mov_rax_slot(&cb, in.b);
-                x64_binop_slot(&cb, 0x2b, in.c); /* sub rax, mem */
-                x64_mov_slot_rax(&cb, in.a);
+            case BC_OP_SUB_I64:
+                if (!jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                x64_binop_slot(cb, 0x2b, in.c); /* sub rax, mem */
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
+                break;
+            case BC_OP_ADDK:
+            case BC_OP_SUBK: {
+                BcValue k = program->constants[in.imm];
+                if (k.kind != BC_VALUE_I64) {
+                    bc_errorf(error, program, i, in.op, "baseline JIT supports I64 arithmetic only; unsupported %s constant",
+                              bc_type_name(bc_type_of_value(k)));
+                    goto fail;
+                }
+                if (!jit_operand(jc, i, in.b, BC_TYPE_I64)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xb9); cb_emit_i64(cb, k.as.i64); /* mov rcx, imm64 */
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, in.op == BC_OP_ADDK ? 0x01 : 0x29);
+                cb_emit_u8(cb, 0xc8); /* add/sub rax, rcx */
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
                 break;
+            }
             case BC_OP_MUL:
-                types[in.a] = numeric_result(types[in.b], types[in.c]);
-                x64_mov_rax_slot(&cb, in.b);
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x0f); cb_emit_u8(&cb, 0xaf); cb_emit_u8(&cb, 0x85);
-                cb_emit_i32(&cb, reg_slot(in.c)); /* imul rax, mem */
-                x64_mov_slot_rax(&cb, in.a);
+            case BC_OP_MUL_I64:
+                if (!jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, 0xaf); cb_emit_u8(cb, 0x83);
+                cb_emit_i32(cb, reg_slot(in.c)); /* imul rax, mem */
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
                 break;
             case BC_OP_DIV:
             case BC_OP_MOD:
-                types[in.a] = BC_TYPE_I64;
-                x64_mov_rax_slot(&cb, in.b);
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x99); /* cqo */
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0xf7); cb_emit_u8(&cb, 0xbd);
-                cb_emit_i32(&cb, reg_slot(in.c)); /* idiv qword [rbp+disp] */
+                if (!jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x99); /* cqo */
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xf7); cb_emit_u8(cb, 0xbb);
+                cb_emit_i32(cb, reg_slot(in.c)); /* idiv qword [rbx+disp] */
                 if (in.op == BC_OP_MOD) {
-                    cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x89); cb_emit_u8(&cb, 0xd0); /* mov rax,rdx */
+                    cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xd0); /* mov rax,rdx */
                 }
-                x64_mov_slot_rax(&cb, in.a);
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
                 break;
             case BC_OP_NEG:
-                types[in.a] = types[in.b];
-                x64_mov_rax_slot(&cb, in.b);
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0xf7); cb_emit_u8(&cb, 0xd8); /* neg rax */
-                x64_mov_slot_rax(&cb, in.a);
+                if (!jit_operand(jc, i, in.b, BC_TYPE_I64)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xf7); cb_emit_u8(cb, 0xd8); /* neg rax */
+                jit_set_reg(jc, in.a, BC_TYPE_I64);
                 break;
-            case BC_OP_EQ:
+            case BC_OP_EQ: {
+                /* Speculate a path-dependent side has the other side's type. */
+                BcType tb = types[in.b], tc = types[in.c];
+                if ((tb == BC_TYPE_UNKNOWN) != (tc == BC_TYPE_UNKNOWN) &&
+                    !jit_operand(jc, i, tb == BC_TYPE_UNKNOWN ? in.b : in.c, tb == BC_TYPE_UNKNOWN ? tc : tb)) goto fail;
+                if (!jit_operand(jc, i, in.b, BC_TYPE_UNKNOWN) || !jit_operand(jc, i, in.c, BC_TYPE_UNKNOWN) ||
+                    types[in.b] == BC_TYPE_UNKNOWN || types[in.c] == BC_TYPE_UNKNOWN) {
+                    bc_errorf(error, program, i, in.op, "baseline JIT needs a known type on one side of %s",
+                              bc_op_name(BC_OP_EQ));
+                    goto fail;
+                }
+                if (types[in.b] != types[in.c]) {
+                    /* Values of different kinds are never equal. */
+                    x64_mov_rax_imm64(cb, 0);
+                    jit_set_reg(jc, in.a, BC_TYPE_BOOL);
+                    break;
+                }
+            }
+                /* fall through */
             case BC_OP_LT:
             case BC_OP_LE:
             case BC_OP_GT:
-            case BC_OP_GE: {
-                types[in.a] = BC_TYPE_BOOL;
-                x64_mov_rax_slot(&cb, in.b);
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x3b); cb_emit_u8(&cb, 0x85);
-                cb_emit_i32(&cb, reg_slot(in.c)); /* cmp rax, mem */
-                uint8_t cc = in.op == BC_OP_EQ ? 0x94 : in.op == BC_OP_LT ? 0x9c :
-                    in.op == BC_OP_LE ? 0x9e : in.op == BC_OP_GT ? 0x9f : 0x9d;
-                cb_emit_u8(&cb, 0x0f); cb_emit_u8(&cb, cc); cb_emit_u8(&cb, 0xc0); /* setcc al */
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x0f); cb_emit_u8(&cb, 0xb6); cb_emit_u8(&cb, 0xc0); /* movzx rax,al */
-                x64_mov_slot_rax(&cb, in.a);
+            case BC_OP_GE:
+            case BC_OP_LT_I64:
+            case BC_OP_LE_I64:
+            case BC_OP_GT_I64:
+            case BC_OP_GE_I64: {
+                BcOp cmp = bc_op_generic((BcOp)in.op);
+                if (cmp != BC_OP_EQ && !jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                x64_binop_slot(cb, 0x3b, in.c); /* cmp rax, mem */
+                uint8_t cc = cmp == BC_OP_EQ ? 0x94 : cmp == BC_OP_LT ? 0x9c :
+                    cmp == BC_OP_LE ? 0x9e : cmp == BC_OP_GT ? 0x9f : 0x9d;
+                cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, cc); cb_emit_u8(cb, 0xc0); /* setcc al */
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, 0xb6); cb_emit_u8(cb, 0xc0); /* movzx rax,al */
+                jit_set_reg(jc, in.a, BC_TYPE_BOOL);
                 break;
             }
             case BC_OP_NOT:
-                types[in.a] = BC_TYPE_BOOL;
-                x64_mov_rax_slot(&cb, in.b);
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x83); cb_emit_u8(&cb, 0xf8); cb_emit_u8(&cb, 0x00); /* cmp rax,0 */
-                cb_emit_u8(&cb, 0x0f); cb_emit_u8(&cb, 0x94); cb_emit_u8(&cb, 0xc0); /* sete al */
-                cb_emit_u8(&cb, 0x48); cb_emit_u8(&cb, 0x0f); cb_emit_u8(&cb, 0xb6); cb_emit_u8(&cb, 0xc0);
-                x64_mov_slot_rax(&cb, in.a);
+                if (!jit_operand(jc, i, in.b, BC_TYPE_UNKNOWN)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x83); cb_emit_u8(cb, 0xf8); cb_emit_u8(cb, 0x00); /* cmp rax,0 */
+                cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, 0x94); cb_emit_u8(cb, 0xc0); /* sete al */
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x0f); cb_emit_u8(cb, 0xb6); cb_emit_u8(cb, 0xc0);
+                jit_set_reg(jc, in.a, BC_TYPE_BOOL);
                 break;
-            case BC_OP_RETURN:
-                if (types[in.a] != BC_TYPE_I64 && types[in.a] != BC_TYPE_BOOL && types[in.a] != BC_TYPE_NIL) {
-                    bc_errorf(error, program, i, in.op, "baseline JIT can return only I64/Bool/Nil values");
-                    free(types); free(cb.data); return false;
-                }
-                x64_mov_rax_slot(&cb, in.a);
-                cb_emit_u8(&cb, 0xc9); /* leave */
-                cb_emit_u8(&cb, 0xc3); /* ret */
-                returned = true;
+            case BC_OP_CALL_NATIVE:
+                jit_call(jc, i, in);
+                break;
+            case BC_OP_BLOCK:
+                frames[depth++] = (JitFrame){BC_OP_BLOCK, 0, NULL, NULL, false};
                 break;
             case BC_OP_IF:
-            case BC_OP_ELSE:
+                if (!jit_operand(jc, i, in.a, BC_TYPE_UNKNOWN)) goto fail;
+                x64_mov_rax_slot(cb, in.a);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x85); cb_emit_u8(cb, 0xc0); /* test rax,rax */
+                frames[depth++] = (JitFrame){BC_OP_IF, x64_jcc_rel32(cb, 0x84) /* jz */,
+                                             jit_snapshot(types, nregs), NULL, false};
+                break;
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+                if (!jit_i64_operands(jc, i, in)) goto fail;
+                x64_mov_rax_slot(cb, in.b);
+                x64_binop_slot(cb, 0x3b, in.c); /* cmp rax, mem */
+                frames[depth++] = (JitFrame){BC_OP_IF, x64_jcc_rel32(cb, in.op == BC_OP_IF_LT ? 0x8d /* jge */ : 0x8f /* jg */),
+                                             jit_snapshot(types, nregs), NULL, false};
+                break;
             case BC_OP_LOOP:
-            case BC_OP_CALL_NATIVE:
+                /* As in the VM, the body runs once when r[a] > 0. */
+                if (!jit_operand(jc, i, in.a, BC_TYPE_I64)) goto fail;
+                x64_mov_rax_slot(cb, in.a);
+                cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x83); cb_emit_u8(cb, 0xf8); cb_emit_u8(cb, 0x00); /* cmp rax,0 */
+                frames[depth++] = (JitFrame){BC_OP_LOOP, x64_jcc_rel32(cb, 0x8e) /* jle */,
+                                             jit_snapshot(types, nregs), NULL, false};
+                break;
+            case BC_OP_ELSE: {
+                JitFrame *f = &frames[depth - 1];
+                f->then_live = live;
+                if (live) f->then_types = jit_snapshot(types, nregs);
+                size_t over_else = x64_jmp_rel32(cb);
+                x64_patch_rel32(cb, f->patch, cb->count);
+                f->patch = over_else;
+                f->kind = BC_OP_ELSE;
+                memcpy(types, f->entry, nregs * sizeof(BcType));
+                live = true;
+                break;
+            }
+            case BC_OP_END: {
+                JitFrame f = frames[--depth];
+                if (f.kind == BC_OP_BLOCK) break;
+                x64_patch_rel32(cb, f.patch, cb->count);
+                /* Join the fall-through path with the skip (or then) path. */
+                const BcType *other = f.kind == BC_OP_ELSE ? f.then_types : f.entry;
+                bool other_live = f.kind == BC_OP_ELSE ? f.then_live : true;
+                if (live && other_live) jit_merge_types(types, other, nregs);
+                else if (other_live) memcpy(types, other, nregs * sizeof(BcType));
+                live = live || other_live;
+                free(f.entry);
+                free(f.then_types);
+                break;
+            }
+            case BC_OP_RETURN:
+                result_type = !returned || result_type == types[in.a] ? types[in.a] : BC_TYPE_UNKNOWN;
+                returned = true;
+                x64_mov_rax_slot(cb, JIT_KIND(nregs, in.a));
+                x64_mov_slot_rax(cb, JIT_RESULT_KIND(nregs));
+                x64_mov_rax_slot(cb, in.a);
+                x64_epilogue(cb);
+                live = false;
+                break;
             case BC_OP_HALT:
+                result_type = !returned || result_type == BC_TYPE_NIL ? BC_TYPE_NIL : BC_TYPE_UNKNOWN;
+                returned = true;
+                x64_mov_slot_imm32(cb, JIT_RESULT_KIND(nregs), BC_VALUE_NIL);
+                x64_mov_rax_imm64(cb, 0);
+                x64_epilogue(cb);
+                live = false;
+                break;
+            case BC_OP_ADD_F64:
+            case BC_OP_SUB_F64:
+            case BC_OP_MUL_F64:
             case BC_OP_COUNT:
-                bc_errorf(error, program, i, in.op, "baseline JIT supports straight-line I64 bytecode only; unsupported %s", bc_op_name((BcOp)in.op));
-                free(types); free(cb.data); return false;
+                bc_errorf(error, program, i, in.op, "baseline JIT supports I64/Bool/Nil arithmetic only; unsupported %s", bc_op_name((BcOp)in.op));
+                goto fail;
         }
     }
 
     if (!returned) {
         bc_errorf(error, program, 0, 0, "baseline JIT program has no return");
-        free(types); free(cb.data); return false;
+        goto fail;
+    }
+
+    /* Exits: the guarded instruction goes to JIT_RESUME, failures also
+     * set JIT_RESULT_KIND to JIT_NATIVE_FAILED. */
+    for (size_t e = 0; e < jc->exit_count; e++) {
+        x64_patch_rel32(cb, jc->exits[e].patch, cb->count);
+        x64_mov_slot_imm32(cb, JIT_RESUME(nregs), (int32_t)jc->exits[e].instr);
+        if (jc->exits[e].failed) x64_mov_slot_imm32(cb, JIT_RESULT_KIND(nregs), JIT_NATIVE_FAILED);
+        cb_emit_u8(cb, 0x31); cb_emit_u8(cb, 0xc0); /* xor eax,eax */
+        x64_epilogue(cb);
+    }
+
+    /* Plain entry: a zeroed (all nil) state array on its own stack. */
+    size_t plain = SIZE_MAX;
+    if (!jc->guards && !jc->calls_natives && result_type != BC_TYPE_UNKNOWN) {
+        plain = cb->count;
+        size_t state_bytes = (JIT_STATE_WORDS(nregs) * 8u + 15u) & ~(size_t)15u;
+        x64_prologue(cb);
+        x64_emit_probed_stack_alloc(cb, state_bytes);
+        cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xe3); /* mov rbx,rsp */
+        cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xe7); /* mov rdi,rsp */
+        cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xc7); cb_emit_u8(cb, 0xc1);
+        cb_emit_i32(cb, (int32_t)(state_bytes / 8));   /* mov rcx, words */
+        cb_emit_u8(cb, 0x31); cb_emit_u8(cb, 0xc0);    /* xor eax,eax */
+        cb_emit_u8(cb, 0xf3); cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0xab); /* rep stosq */
+        x64_patch_rel32(cb, x64_jmp_rel32(cb), body);
+    }
+
+    size_t osr = SIZE_MAX;
+    if (osr_target != SIZE_MAX) {
+        osr = cb->count;
+        x64_prologue(cb);
+        cb_emit_u8(cb, 0x48); cb_emit_u8(cb, 0x89); cb_emit_u8(cb, 0xfb); /* mov rbx,rdi */
+        x64_patch_rel32(cb, x64_jmp_rel32(cb), osr_target);
     }
 
     size_t page = (size_t)sysconf(_SC_PAGESIZE);
-    size_t alloc_size = (cb.count + page - 1u) & ~(page - 1u);
+    size_t alloc_size = (cb->count + page - 1u) & ~(page - 1u);
     void *mem = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (mem == MAP_FAILED) {
         bc_errorf(error, program, 0, 0, "baseline JIT mmap failed");
-        free(types); free(cb.data); return false;
+        goto fail;
     }
-    memcpy(mem, cb.data, cb.count);
+    memcpy(mem, cb->data, cb->count);
     if (mprotect(mem, alloc_size, PROT_READ | PROT_EXEC) != 0) {
         munmap(mem, alloc_size);
         bc_errorf(error, program, 0, 0, "baseline JIT mprotect failed");
-        free(types); free(cb.data); return false;
+        goto fail;
     }
 
-    artifact->entry = mem;
+    artifact->vm_entry = mem;
+    artifact->entry = plain != SIZE_MAX ? (uint8_t *)mem + plain : NULL;
+    artifact->osr_entry = osr != SIZE_MAX ? (uint8_t *)mem + osr : NULL;
+    artifact->osr_instr = osr != SIZE_MAX ? osr_at : SIZE_MAX;
     artifact->code = mem;
     artifact->code_size = alloc_size;
-    artifact->tier = options ? options->tier : BC_JIT_BASELINE_TEMPLATE;
+    artifact->guards = jc->guards;
+    artifact->tier = jc->options->tier;
+    artifact->result_type = result_type;
+    if (jc->options->trace)
+        fprintf(stderr, "[bc-jit] %s: %zu instructions -> %zu bytes, %zu guards, returns %s\n",
+                program->name ? program->name : "<bytecode>", program->code_count, cb->count,
+                jc->guards, bc_type_name(result_type));
     free(types);
-    free(cb.data);
+    free(cb->data);
+    free(jc->exits);
     return true;
+
+fail:
+    while (depth) {
+        depth--;
+        free(frames[depth].entry);
+        free(frames[depth].then_types);
+    }
+    free(types);
+    free(cb->data);
+    free(jc->exits);
+    return false;
 #endif
 }
 
@@ -1773,6 +3591,7 @@ bool bc_tier_plan_trace(const BcProgram *program,
                         FILE *out,
                         BcError *error) {
     if (!out) out = stderr;
+    program_page_in(program, false, true);
     BcTierPlan local = plan ? *plan : bc_tier_plan_default();
     BcError verify_error;
     if (!bc_verify(program, &verify_error)) {
@@ -1789,6 +3608,18 @@ bool bc_tier_plan_trace(const BcProgram *program,
     fprintf(out, "%s├─ %sbaseline template JIT: %s\n", BC_CLR_GRAY, BC_CLR_RESET, local.enable_baseline_jit ? "enabled" : "disabled");
     fprintf(out, "%s├─ %soptimizing JIT: %s\n", BC_CLR_GRAY, BC_CLR_RESET, local.enable_optimizing_jit ? "enabled" : "disabled");
     fprintf(out, "%s├─ %shotness call=%u loop=%u\n", BC_CLR_GRAY, BC_CLR_RESET, local.call_hot_threshold, local.loop_hot_threshold);
+    if (local.enable_baseline_jit) {
+        BcJitOptions jit_options = bc_jit_options_default();
+        BcJitArtifact artifact;
+        BcError jit_error;
+        if (bc_jit_compile_baseline(program, &jit_options, &artifact, &jit_error)) {
+            fprintf(out, "%s├─ %sbaseline code: %zu bytes mapped, %zu guards, returns %s\n", BC_CLR_GRAY, BC_CLR_RESET,
+                    artifact.code_size, artifact.guards, bc_type_name(artifact.result_type));
+            bc_jit_artifact_free(&artifact);
+        } else {
+            fprintf(out, "%s├─ %sbaseline code: interpreter only (%s)\n", BC_CLR_GRAY, BC_CLR_RESET, jit_error.message);
+        }
+    }
     fprintf(out, "%s├─ %sOSR: %s\n", BC_CLR_GRAY, BC_CLR_RESET, local.enable_osr ? "enabled" : "disabled");
     for (size_t i = 0; i < program->code_count; i++) {
         if (program->code[i].op == BC_OP_LOOP) {
@@ -1812,149 +3643,554 @@ bool bc_tier_plan_trace(const BcProgram *program,
 void bc_vm_init(BcVM *vm) {
     memset(vm, 0, sizeof(*vm));
     vm->trace_out = stderr;
+    vm->quicken = true;
+    vm->tier = bc_tier_plan_default();
 }
 
 void bc_vm_free(BcVM *vm) {
     if (!vm) return;
+    bc_jit_artifact_free(&vm->jit);
     free(vm->registers);
+    free(vm->code);
+    free(vm->code_source);
+    free(vm->const_source);
+    free(vm->site_ic);
+    free(vm->jit_state);
     memset(vm, 0, sizeof(*vm));
 }
 
-static size_t find_else_or_end(const BcProgram *program, size_t ip) {
-    size_t depth = 0;
-    for (size_t i = ip; i < program->code_count; i++) {
-        BcOp op = (BcOp)program->code[i].op;
-        if (op == BC_OP_IF || op == BC_OP_BLOCK || op == BC_OP_LOOP) depth++;
-        else if (op == BC_OP_END) {
-            if (!depth) return i;
-            depth--;
-        } else if (op == BC_OP_ELSE && !depth) return i;
-    }
-    return program->code_count;
+/*
+ * Dispatch.  GCC and Clang get a direct-threaded loop: each handler ends in
+ * its own indirect jump through a label table, so the branch predictor sees
+ * one dispatch site per opcode instead of the switch's single shared one.
+ * Other compilers, and builds with -DBC_SWITCH_DISPATCH, use the switch.
+ * Both run the same handlers below.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(BC_SWITCH_DISPATCH)
+#define BC_THREADED_DISPATCH 1
+#else
+#define BC_THREADED_DISPATCH 0
+#endif
+
+/* Set in the VM's copy of a generic op whose quickened form met other
+ * operand kinds; arithmetic ops do not use imm otherwise. */
+#define BC_QUICKEN_NEVER UINT32_MAX
+
+const char *bc_vm_dispatch_name(void) {
+    return BC_THREADED_DISPATCH ? "threaded" : "switch";
 }
 
-static size_t find_end(const BcProgram *program, size_t ip) {
-    size_t depth = 0;
-    for (size_t i = ip; i < program->code_count; i++) {
-        BcOp op = (BcOp)program->code[i].op;
-        if (op == BC_OP_IF || op == BC_OP_BLOCK || op == BC_OP_LOOP) depth++;
-        else if (op == BC_OP_END) {
-            if (!depth) return i;
-            depth--;
+static BcOp quicken_for(BcOp op, BcValueKind x, BcValueKind y) {
+    if (x != y) return op;
+    if (x == BC_VALUE_I64) {
+        switch (op) {
+            case BC_OP_ADD: return BC_OP_ADD_I64;
+            case BC_OP_SUB: return BC_OP_SUB_I64;
+            case BC_OP_MUL: return BC_OP_MUL_I64;
+            case BC_OP_LT: return BC_OP_LT_I64;
+            case BC_OP_LE: return BC_OP_LE_I64;
+            case BC_OP_GT: return BC_OP_GT_I64;
+            case BC_OP_GE: return BC_OP_GE_I64;
+            default: return op;
         }
     }
-    return program->code_count;
+    if (x == BC_VALUE_F64) {
+        switch (op) {
+            case BC_OP_ADD: return BC_OP_ADD_F64;
+            case BC_OP_SUB: return BC_OP_SUB_F64;
+            case BC_OP_MUL: return BC_OP_MUL_F64;
+            default: return op;
+        }
+    }
+    return op;
 }
 
-bool bc_vm_run(BcVM *vm, const BcProgram *program, BcValue *result, BcError *error) {
-    BcError verify_error;
-    if (!bc_verify(program, &verify_error)) {
-        if (error) *error = verify_error;
-        return false;
-    }
+static BcValueKind declared_kind(const BcProgram *program, uint16_t reg) {
+    BcType t = (size_t)reg < program->register_count ? program->register_types[reg] : BC_TYPE_UNKNOWN;
+    return t == BC_TYPE_I64 ? BC_VALUE_I64 : t == BC_TYPE_F64 ? BC_VALUE_F64 : BC_VALUE_NIL;
+}
 
-    if (program->register_count > vm->register_count) {
-        vm->registers = bc_realloc_array(vm->registers, program->register_count, sizeof(vm->registers[0]));
-        vm->register_count = program->register_count;
-    }
-    for (size_t i = 0; i < vm->register_count; i++) vm->registers[i] = bc_value_nil();
+static bool vm_code_current(const BcVM *vm, const BcProgram *program) {
+    return vm->code && vm->code_program == program && vm->code_count == program->code_count &&
+           vm->const_count == program->const_count && vm->native_count == program->native_count &&
+           vm->ic_count == program->inline_cache_count &&
+           (!program->code_count ||
+            memcmp(vm->code_source, program->code, program->code_count * sizeof(BcInstr)) == 0) &&
+           (!program->const_count ||
+            memcmp(vm->const_source, program->constants, program->const_count * sizeof(BcValue)) == 0);
+}
 
-    for (size_t ip = 0; ip < program->code_count; ip++) {
-        BcInstr in = program->code[ip];
-        BcValue x, y;
-        if (vm->trace) fprintf(vm->trace_out ? vm->trace_out : stderr, "[bc] %04zu %s\n", ip, bc_op_name((BcOp)in.op));
-        switch ((BcOp)in.op) {
-            case BC_OP_NOP:
+/*
+ * Builds the VM's copy of a verified program: imm of if/else/loop becomes
+ * the index execution continues at when the branch is not taken, and ops
+ * whose operand registers are declared I64/F64 in register_types start out
+ * quickened.  A trailing halt covers falling off the end.
+ */
+static void vm_prepare_code(BcVM *vm, const BcProgram *program) {
+    size_t n = program->code_count;
+    if (n + 1 > vm->code_capacity) {
+        vm->code = bc_realloc_array(vm->code, n + 1, sizeof(vm->code[0]));
+        vm->code_source = bc_realloc_array(vm->code_source, n + 1, sizeof(vm->code_source[0]));
+        vm->code_capacity = n + 1;
+    }
+    if (n) {
+        memcpy(vm->code, program->code, n * sizeof(vm->code[0]));
+        memcpy(vm->code_source, program->code, n * sizeof(vm->code_source[0]));
+    }
+    vm->const_source = bc_realloc_array(vm->const_source, program->const_count ? program->const_count : 1,
+                                        sizeof(vm->const_source[0]));
+    if (program->const_count)
+        memcpy(vm->const_source, program->constants, program->const_count * sizeof(vm->const_source[0]));
+    vm->const_count = program->const_count;
+    vm->native_count = program->native_count;
+    vm->ic_count = program->inline_cache_count;
+    free(vm->site_ic);
+    vm->site_ic = NULL;
+    if (program->inline_cache_count) {
+        vm->site_ic = bc_realloc_array(NULL, n + 1, sizeof(vm->site_ic[0]));
+        for (size_t i = 0; i <= n; i++) vm->site_ic[i] = UINT32_MAX;
+        for (size_t k = 0; k < program->inline_cache_count; k++) {
+            uint32_t site = program->inline_caches[k].callsite;
+            if (site < n && program->code[site].op == BC_OP_CALL_NATIVE) vm->site_ic[site] = (uint32_t)k;
+        }
+    }
+    memset(&vm->code[n], 0, sizeof(vm->code[n]));
+    vm->code[n].op = BC_OP_HALT;
+    vm->code_count = n;
+    vm->code_program = program;
+    vm->quickened = 0;
+    vm->dequickened = 0;
+    vm->ic_links = 0;
+    bc_jit_artifact_free(&vm->jit);
+    vm->calls = 0;
+    vm->loop_entries = 0;
+    vm->jit_rejected = false;
+    vm->jit_runs = 0;
+    vm->osr_entries = 0;
+    vm->deopts = 0;
+
+    size_t open[BC_STRUCTURED_DEPTH_MAX];
+    size_t depth = 0;
+    for (size_t i = 0; i < n; i++) {
+        BcInstr *in = &vm->code[i];
+        switch ((BcOp)in->op) {
             case BC_OP_BLOCK:
-            case BC_OP_END:
-                break;
-            case BC_OP_CONST:
-                vm->registers[in.a] = program->constants[in.imm];
-                break;
-            case BC_OP_NIL:
-                vm->registers[in.a] = bc_value_nil();
+            case BC_OP_IF:
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+            case BC_OP_LOOP:
+                open[depth++] = i;
                 break;
-            case BC_OP_BOOL:
-                vm->registers[in.a] = bc_value_bool(in.imm != 0);
+            case BC_OP_ELSE:
+                vm->code[open[depth - 1]].imm = (uint32_t)(i + 1);
+                open[depth - 1] = i;
                 break;
-            case BC_OP_MOV:
-                vm->registers[in.a] = vm->registers[in.b];
+            case BC_OP_END: {
+                BcInstr *start = &vm->code[open[--depth]];
+                if (start->op != BC_OP_BLOCK) start->imm = (uint32_t)(i + 1);
                 break;
+            }
             case BC_OP_ADD:
             case BC_OP_SUB:
             case BC_OP_MUL:
-            case BC_OP_DIV:
-            case BC_OP_MOD:
-                x = vm->registers[in.b];
-                y = vm->registers[in.c];
-                if (x.kind == BC_VALUE_I64 && y.kind == BC_VALUE_I64) {
-                    if (in.op == BC_OP_ADD) vm->registers[in.a] = bc_value_i64(x.as.i64 + y.as.i64);
-                    else if (in.op == BC_OP_SUB) vm->registers[in.a] = bc_value_i64(x.as.i64 - y.as.i64);
-                    else if (in.op == BC_OP_MUL) vm->registers[in.a] = bc_value_i64(x.as.i64 * y.as.i64);
-                    else if (in.op == BC_OP_DIV) vm->registers[in.a] = bc_value_i64(x.as.i64 / y.as.i64);
-                    else vm->registers[in.a] = bc_value_i64(x.as.i64 % y.as.i64);
-                } else {
-                    double a = x.kind == BC_VALUE_I64 ? (double)x.as.i64 : x.as.f64;
-                    double b = y.kind == BC_VALUE_I64 ? (double)y.as.i64 : y.as.f64;
-                    if (in.op == BC_OP_ADD) vm->registers[in.a] = bc_value_f64(a + b);
-                    else if (in.op == BC_OP_SUB) vm->registers[in.a] = bc_value_f64(a - b);
-                    else if (in.op == BC_OP_MUL) vm->registers[in.a] = bc_value_f64(a * b);
-                    else vm->registers[in.a] = bc_value_f64(a / b);
-                }
-                break;
-            case BC_OP_NEG:
-                x = vm->registers[in.b];
-                vm->registers[in.a] = x.kind == BC_VALUE_I64 ? bc_value_i64(-x.as.i64) : bc_value_f64(-x.as.f64);
-                break;
-            case BC_OP_EQ:
-                vm->registers[in.a] = bc_value_bool(value_equal(vm->registers[in.b], vm->registers[in.c]));
-                break;
             case BC_OP_LT:
             case BC_OP_LE:
             case BC_OP_GT:
-            case BC_OP_GE: {
-                double a = vm->registers[in.b].kind == BC_VALUE_I64 ? (double)vm->registers[in.b].as.i64 : vm->registers[in.b].as.f64;
-                double b = vm->registers[in.c].kind == BC_VALUE_I64 ? (double)vm->registers[in.c].as.i64 : vm->registers[in.c].as.f64;
-                bool r = in.op == BC_OP_LT ? a < b : in.op == BC_OP_LE ? a <= b : in.op == BC_OP_GT ? a > b : a >= b;
-                vm->registers[in.a] = bc_value_bool(r);
-                break;
-            }
-            case BC_OP_NOT:
-                vm->registers[in.a] = bc_value_bool(!bc_value_truthy(vm->registers[in.b]));
-                break;
-            case BC_OP_CALL_NATIVE: {
-                BcNative native = program->natives[in.imm];
-                BcValue out = bc_value_nil();
-                if (!native.fn(vm, &vm->registers[in.b], (uint8_t)in.c, &out, native.userdata)) {
-                    bc_errorf(error, program, ip, in.op, "native '%s' failed", native.name);
-                    return false;
+            case BC_OP_GE:
+                in->imm = 0;
+                if (vm->quicken && program->register_types) {
+                    BcOp q = quicken_for((BcOp)in->op, declared_kind(program, in->b),
+                                         declared_kind(program, in->c));
+                    if (q != in->op) {
+                        in->op = (uint8_t)q;
+                        vm->quickened++;
+                    }
                 }
-                vm->registers[in.a] = out;
-                break;
-            }
-            case BC_OP_IF:
-                if (!bc_value_truthy(vm->registers[in.a])) ip = find_else_or_end(program, ip + 1);
-                break;
-            case BC_OP_ELSE:
-                ip = find_end(program, ip + 1);
-                break;
-            case BC_OP_LOOP:
-                if (vm->registers[in.a].as.i64 <= 0) ip = find_end(program, ip + 1);
                 break;
-            case BC_OP_RETURN:
-                if (result) *result = vm->registers[in.a];
-                return true;
-            case BC_OP_HALT:
-                if (result) *result = bc_value_nil();
-                return true;
-            case BC_OP_COUNT:
+            default:
                 break;
         }
     }
-    if (result) *result = bc_value_nil();
+}
+
+static BcValue vm_arith_values(BcOp op, BcValue x, BcValue y) {
+    if (x.kind == BC_VALUE_I64 && y.kind == BC_VALUE_I64) {
+        if (op == BC_OP_ADD) return bc_value_i64(x.as.i64 + y.as.i64);
+        if (op == BC_OP_SUB) return bc_value_i64(x.as.i64 - y.as.i64);
+        if (op == BC_OP_MUL) return bc_value_i64(x.as.i64 * y.as.i64);
+        if (op == BC_OP_DIV) return bc_value_i64(x.as.i64 / y.as.i64);
+        return bc_value_i64(x.as.i64 % y.as.i64);
+    }
+    double a = x.kind == BC_VALUE_I64 ? (double)x.as.i64 : x.as.f64;
+    double b = y.kind == BC_VALUE_I64 ? (double)y.as.i64 : y.as.f64;
+    if (op == BC_OP_ADD) return bc_value_f64(a + b);
+    if (op == BC_OP_SUB) return bc_value_f64(a - b);
+    if (op == BC_OP_MUL) return bc_value_f64(a * b);
+    return bc_value_f64(a / b);
+}
+
+static void vm_arith(BcValue *r, const BcInstr *in) {
+    r[in->a] = vm_arith_values((BcOp)in->op, r[in->b], r[in->c]);
+}
+
+static void vm_compare(BcValue *r, const BcInstr *in) {
+    double a = r[in->b].kind == BC_VALUE_I64 ? (double)r[in->b].as.i64 : r[in->b].as.f64;
+    double b = r[in->c].kind == BC_VALUE_I64 ? (double)r[in->c].as.i64 : r[in->c].as.f64;
+    bool v = in->op == BC_OP_LT ? a < b : in->op == BC_OP_LE ? a <= b : in->op == BC_OP_GT ? a > b : a >= b;
+    r[in->a] = bc_value_bool(v);
+}
+
+/* The condition of if.lt/if.le: exact for I64 pairs, else compared as F64
+ * like the generic compares. */
+static bool vm_if_less(BcValue x, BcValue y, bool or_equal) {
+    if (x.kind == BC_VALUE_I64 && y.kind == BC_VALUE_I64)
+        return or_equal ? x.as.i64 <= y.as.i64 : x.as.i64 < y.as.i64;
+    double a = x.kind == BC_VALUE_I64 ? (double)x.as.i64 : x.as.f64;
+    double b = y.kind == BC_VALUE_I64 ? (double)y.as.i64 : y.as.f64;
+    return or_equal ? a <= b : a < b;
+}
+
+/* Rewrites a generic op into its quickened form when both operands agree;
+ * the caller re-dispatches the same instruction. */
+static bool vm_quicken(BcVM *vm, BcInstr *in) {
+    if (!vm->quicken || in->imm == BC_QUICKEN_NEVER) return false;
+    BcOp q = quicken_for((BcOp)in->op, vm->registers[in->b].kind, vm->registers[in->c].kind);
+    if (q == in->op) return false;
+    in->op = (uint8_t)q;
+    vm->quickened++;
     return true;
 }
 
+/*
+ * Inline caches are the program's runtime metadata: the interpreter
+ * learns a call site's receiver types, and compiled code speculates on
+ * what it finds there.  Returns the native serving receiver at a call of
+ * generic, recording a type the cache does not hold yet.
+ */
+static uint32_t vm_ic_target(const BcProgram *program, uint32_t k, uint32_t generic, BcValue receiver) {
+    BcInlineCache *ic = &program->inline_caches[k];
+    if (ic->state == BC_IC_MEGAMORPHIC) return generic;
+    BcType t = bc_type_of_value(receiver);
+    for (uint32_t e = 0; e < ic->entry_count; e++) {
+        if (ic->entries[e].receiver_type != t) continue;
+        if (!ic_entry_serves(program, generic, ic->entries[e]))
+            ic->entries[e].target = native_for_receiver(program, generic, t);
+        return ic->entries[e].target;
+    }
+    if (ic->state != BC_IC_UNINITIALIZED) ic->misses++;
+    if (ic->entry_count == BC_IC_MAX_ENTRIES) {
+        ic->state = BC_IC_MEGAMORPHIC;
+        ic->entry_count = 0;
+        return generic;
+    }
+    uint32_t target = native_for_receiver(program, generic, t);
+    ic->entries[ic->entry_count++] = (BcInlineCacheEntry){t, target};
+    ic->state = ic->entry_count == 1 ? BC_IC_MONOMORPHIC : BC_IC_POLYMORPHIC;
+    return target;
+}
+
+/* Relinks call site `in` after its cache changed: a monomorphic site whose
+ * receiver has a variant calls that variant straight from imm, guarded
+ * only by the variant's receiver type; every other site calls generic and
+ * consults the cache. */
+static void vm_ic_link(BcVM *vm, const BcProgram *program, BcInstr *in, uint32_t k, uint32_t generic) {
+    const BcInlineCache *ic = &program->inline_caches[k];
+    uint32_t linked = generic;
+    if (vm->quicken && ic->state == BC_IC_MONOMORPHIC && ic->entries[0].target != generic)
+        linked = ic->entries[0].target;
+    if (linked != generic && in->imm != linked) vm->ic_links++;
+    in->imm = linked;
+}
+
+static void vm_reset_registers(BcVM *vm, const BcProgram *program) {
+    if (program->register_count > vm->register_count) {
+        vm->registers = bc_realloc_array(vm->registers, program->register_count, sizeof(vm->registers[0]));
+        vm->register_count = program->register_count;
+    }
+    for (size_t i = 0; i < vm->register_count; i++) vm->registers[i] = bc_value_nil();
+}
+
+/* Compiles the cached program once the tier plan finds it hot, with an
+ * OSR entry at loop header osr_at unless that is SIZE_MAX. */
+static bool vm_compile(BcVM *vm, const BcProgram *program, size_t osr_at) {
+    if (vm->jit_rejected || !vm->tier.enable_baseline_jit) return false;
+    if (vm->calls < vm->tier.call_hot_threshold && vm->loop_entries < vm->tier.loop_hot_threshold)
+        return false;
+    BcJitOptions options = bc_jit_options_default();
+    options.tier = BC_JIT_BASELINE_NATIVE;
+    options.osr_instr = osr_at;
+    BcError jit_error;
+    if (!bc_jit_compile_baseline(program, &options, &vm->jit, &jit_error)) {
+        vm->jit_rejected = true;
+        return false;
+    }
+    return true;
+}
+
+/* At a loop header: whether execution can continue in compiled code here. */
+static bool vm_osr_ready(BcVM *vm, const BcProgram *program, size_t ip) {
+    if (!vm->tier.enable_osr || vm->trace || vm->jit.code || vm->loop_entries < vm->tier.loop_hot_threshold)
+        return false;
+    return vm_compile(vm, program, ip) && vm->jit.osr_entry && vm->jit.osr_instr == ip;
+}
+
+/* Registers a deopt map lists at safepoint, or all of them without one. */
+static void live_range(const BcProgram *program, size_t safepoint, size_t n, size_t *first, size_t *end) {
+    const BcDeoptPoint *dp = deopt_point_at(program, safepoint);
+    *first = dp && dp->first_register < n ? dp->first_register : 0;
+    *end = dp ? *first + dp->register_count : n;
+    if (*end > n) *end = n;
+}
+
+static bool vm_interpret(BcVM *vm, const BcProgram *program, size_t ip, BcValue *result, BcError *error);
+
+/*
+ * Runs the compiled program, from the start or (osr_at != SIZE_MAX) from
+ * the OSR entry with the interpreter's live registers.  A deoptimization
+ * copies the live registers back, drops the code and finishes the run in
+ * the interpreter from the instruction that missed.
+ */
+static bool vm_run_compiled(BcVM *vm, const BcProgram *program, size_t osr_at, BcValue *result, BcError *error) {
+    size_t n = program->register_count ? program->register_count : 1;
+    if (JIT_STATE_WORDS(n) > vm->jit_state_words) {
+        vm->jit_state = bc_realloc_array(vm->jit_state, JIT_STATE_WORDS(n), sizeof(vm->jit_state[0]));
+        vm->jit_state_words = JIT_STATE_WORDS(n);
+    }
+    int64_t *state = vm->jit_state;
+    memset(state, 0, JIT_STATE_WORDS(n) * sizeof(state[0]));
+    size_t first, end;
+    if (osr_at != SIZE_MAX) {
+        live_range(program, osr_at, program->register_count, &first, &end);
+        for (size_t i = first; i < end; i++) jit_state_set(state, n, i, vm->registers[i]);
+        vm->osr_entries++;
+    }
+    state[JIT_RESUME(n)] = -1;
+    state[JIT_VM(n)] = (int64_t)(intptr_t)vm;
+
+    typedef int64_t (*StateEntry)(int64_t *);
+    int64_t raw = ((StateEntry)(osr_at != SIZE_MAX ? vm->jit.osr_entry : vm->jit.vm_entry))(state);
+    if (state[JIT_RESUME(n)] < 0) {
+        vm->jit_runs++;
+        if (result) *result = jit_unbox(state[JIT_RESULT_KIND(n)], raw);
+        return true;
+    }
+
+    size_t resume = (size_t)state[JIT_RESUME(n)];
+    if (state[JIT_RESULT_KIND(n)] == JIT_NATIVE_FAILED) {
+        BcInstr in = program->code[resume];
+        bc_errorf(error, program, resume, in.op, "native '%s' failed", program->natives[in.imm].name);
+        return false;
+    }
+    vm_reset_registers(vm, program);
+    live_range(program, resume, program->register_count, &first, &end);
+    for (size_t i = first; i < end; i++) vm->registers[i] = jit_state_get(state, n, i);
+    vm->deopts++;
+    bc_jit_artifact_free(&vm->jit);
+    vm->calls = 0;
+    vm->loop_entries = 0;
+    if (vm->deopts >= BC_JIT_MAX_DEOPTS) vm->jit_rejected = true;
+    return vm_interpret(vm, program, resume, result, error);
+}
+
+bool bc_vm_run(BcVM *vm, const BcProgram *program, BcValue *result, BcError *error) {
+    /* A program unchanged since the cached copy was built was verified
+     * then; the baseline code also bakes its constants in. */
+    if (!vm_code_current(vm, program)) {
+        BcError verify_error;
+        if (!bc_verify(program, &verify_error)) {
+            if (error) *error = verify_error;
+            return false;
+        }
+        if (program->code_count >= UINT32_MAX) {
+            bc_errorf(error, program, 0, 0, "program has too many instructions for the VM");
+            return false;
+        }
+        vm_prepare_code(vm, program);
+    }
+    if (!vm->trace && (vm->jit.code || vm_compile(vm, program, SIZE_MAX)))
+        return vm_run_compiled(vm, program, SIZE_MAX, result, error);
+    vm->calls++;
+    vm_reset_registers(vm, program);
+    return vm_interpret(vm, program, 0, result, error);
+}
+
+static bool vm_interpret(BcVM *vm, const BcProgram *program, size_t ip, BcValue *result, BcError *error) {
+    BcInstr *code = vm->code;
+    BcValue *r = vm->registers;
+    BcInstr *in;
+    BcValue  x, y;
+
+#if BC_THREADED_DISPATCH
+    static const void *const labels[BC_OP_COUNT] = {
+        [BC_OP_NOP] = &&op_NOP, [BC_OP_CONST] = &&op_CONST, [BC_OP_NIL] = &&op_NIL,
+        [BC_OP_BOOL] = &&op_BOOL, [BC_OP_MOV] = &&op_MOV, [BC_OP_ADD] = &&op_ADD,
+        [BC_OP_SUB] = &&op_SUB, [BC_OP_MUL] = &&op_MUL, [BC_OP_DIV] = &&op_DIV,
+        [BC_OP_MOD] = &&op_MOD, [BC_OP_NEG] = &&op_NEG, [BC_OP_EQ] = &&op_EQ,
+        [BC_OP_LT] = &&op_LT, [BC_OP_LE] = &&op_LE, [BC_OP_GT] = &&op_GT,
+        [BC_OP_GE] = &&op_GE, [BC_OP_NOT] = &&op_NOT, [BC_OP_CALL_NATIVE] = &&op_CALL_NATIVE,
+        [BC_OP_BLOCK] = &&op_BLOCK, [BC_OP_IF] = &&op_IF, [BC_OP_ELSE] = &&op_ELSE,
+        [BC_OP_LOOP] = &&op_LOOP, [BC_OP_END] = &&op_END, [BC_OP_RETURN] = &&op_RETURN,
+        [BC_OP_HALT] = &&op_HALT, [BC_OP_ADD_I64] = &&op_ADD_I64, [BC_OP_SUB_I64] = &&op_SUB_I64,
+        [BC_OP_MUL_I64] = &&op_MUL_I64, [BC_OP_ADD_F64] = &&op_ADD_F64,
+        [BC_OP_SUB_F64] = &&op_SUB_F64, [BC_OP_MUL_F64] = &&op_MUL_F64,
+        [BC_OP_LT_I64] = &&op_LT_I64, [BC_OP_LE_I64] = &&op_LE_I64,
+        [BC_OP_GT_I64] = &&op_GT_I64, [BC_OP_GE_I64] = &&op_GE_I64,
+        [BC_OP_ADDK] = &&op_ADDK, [BC_OP_SUBK] = &&op_SUBK,
+        [BC_OP_IF_LT] = &&op_IF_LT, [BC_OP_IF_LE] = &&op_IF_LE,
+    };
+#define BC_TARGET(name) op_##name:
+#define BC_REDISPATCH() goto *labels[in->op]
+#else
+#define BC_TARGET(name) case BC_OP_##name:
+#define BC_REDISPATCH() goto redispatch
+#endif
+#define BC_DISPATCH() do {                                                         \
+        in = &code[ip];                                                            \
+        if (vm->trace) fprintf(vm->trace_out ? vm->trace_out : stderr,            \
+                               "[bc] %04zu %s\n", ip, bc_op_name((BcOp)in->op));   \
+        BC_REDISPATCH();                                                           \
+    } while (0)
+#define BC_NEXT() do { ip++; BC_DISPATCH(); } while (0)
+#define BC_QUICK(want, value) do {                                                 \
+        x = r[in->b];                                                              \
+        y = r[in->c];                                                              \
+        if (x.kind != (want) || y.kind != (want)) goto dequicken;                  \
+        r[in->a] = (value);                                                        \
+        BC_NEXT();                                                                 \
+    } while (0)
+
+    BC_DISPATCH();
+#if !BC_THREADED_DISPATCH
+redispatch:
+    switch ((BcOp)in->op) {
+#endif
+    BC_TARGET(NOP)
+    BC_TARGET(BLOCK)
+    BC_TARGET(END)
+        BC_NEXT();
+    BC_TARGET(CONST)
+        r[in->a] = program->constants[in->imm];
+        BC_NEXT();
+    BC_TARGET(NIL)
+        r[in->a] = bc_value_nil();
+        BC_NEXT();
+    BC_TARGET(BOOL)
+        r[in->a] = bc_value_bool(in->imm != 0);
+        BC_NEXT();
+    BC_TARGET(MOV)
+        r[in->a] = r[in->b];
+        BC_NEXT();
+    BC_TARGET(ADD)
+    BC_TARGET(SUB)
+    BC_TARGET(MUL)
+        if (vm_quicken(vm, in)) BC_REDISPATCH();
+        vm_arith(r, in);
+        BC_NEXT();
+    BC_TARGET(DIV)
+    BC_TARGET(MOD)
+        vm_arith(r, in);
+        BC_NEXT();
+    BC_TARGET(NEG)
+        x = r[in->b];
+        r[in->a] = x.kind == BC_VALUE_I64 ? bc_value_i64(-x.as.i64) : bc_value_f64(-x.as.f64);
+        BC_NEXT();
+    BC_TARGET(EQ)
+        r[in->a] = bc_value_bool(value_equal(r[in->b], r[in->c]));
+        BC_NEXT();
+    BC_TARGET(LT)
+    BC_TARGET(LE)
+    BC_TARGET(GT)
+    BC_TARGET(GE)
+        if (vm_quicken(vm, in)) BC_REDISPATCH();
+        vm_compare(r, in);
+        BC_NEXT();
+    BC_TARGET(NOT)
+        r[in->a] = bc_value_bool(!bc_value_truthy(r[in->b]));
+        BC_NEXT();
+    BC_TARGET(CALL_NATIVE) {
+        uint32_t target = in->imm;
+        if (vm->site_ic && vm->site_ic[ip] != UINT32_MAX && in->c > 0) {
+            const BcNative *linked = &program->natives[in->imm];
+            if (linked->receiver_type == BC_TYPE_UNKNOWN || linked->receiver_type != bc_type_of_value(r[in->b])) {
+                target = vm_ic_target(program, vm->site_ic[ip], linked->generic, r[in->b]);
+                vm_ic_link(vm, program, in, vm->site_ic[ip], linked->generic);
+            }
+        }
+        BcNative native = program->natives[target];
+        BcValue out = bc_value_nil();
+        if (!native.fn(vm, &r[in->b], (uint8_t)in->c, &out, native.userdata)) {
+            bc_errorf(error, program, ip, in->op, "native '%s' failed", native.name);
+            return false;
+        }
+        r[in->a] = out;
+        BC_NEXT();
+    }
+    BC_TARGET(IF)
+        if (!bc_value_truthy(r[in->a])) {
+            ip = in->imm;
+            BC_DISPATCH();
+        }
+        BC_NEXT();
+    BC_TARGET(ELSE)
+        ip = in->imm;
+        BC_DISPATCH();
+    BC_TARGET(LOOP)
+        if (vm_osr_ready(vm, program, ip)) return vm_run_compiled(vm, program, ip, result, error);
+        if (r[in->a].as.i64 <= 0) {
+            ip = in->imm;
+            BC_DISPATCH();
+        }
+        vm->loop_entries++;
+        BC_NEXT();
+    BC_TARGET(RETURN)
+        if (result) *result = r[in->a];
+        return true;
+    BC_TARGET(HALT)
+        if (result) *result = bc_value_nil();
+        return true;
+    BC_TARGET(ADD_I64) BC_QUICK(BC_VALUE_I64, bc_value_i64(x.as.i64 + y.as.i64));
+    BC_TARGET(SUB_I64) BC_QUICK(BC_VALUE_I64, bc_value_i64(x.as.i64 - y.as.i64));
+    BC_TARGET(MUL_I64) BC_QUICK(BC_VALUE_I64, bc_value_i64(x.as.i64 * y.as.i64));
+    BC_TARGET(ADD_F64) BC_QUICK(BC_VALUE_F64, bc_value_f64(x.as.f64 + y.as.f64));
+    BC_TARGET(SUB_F64) BC_QUICK(BC_VALUE_F64, bc_value_f64(x.as.f64 - y.as.f64));
+    BC_TARGET(MUL_F64) BC_QUICK(BC_VALUE_F64, bc_value_f64(x.as.f64 * y.as.f64));
+    BC_TARGET(LT_I64) BC_QUICK(BC_VALUE_I64, bc_value_bool(x.as.i64 < y.as.i64));
+    BC_TARGET(LE_I64) BC_QUICK(BC_VALUE_I64, bc_value_bool(x.as.i64 <= y.as.i64));
+    BC_TARGET(GT_I64) BC_QUICK(BC_VALUE_I64, bc_value_bool(x.as.i64 > y.as.i64));
+    BC_TARGET(GE_I64) BC_QUICK(BC_VALUE_I64, bc_value_bool(x.as.i64 >= y.as.i64));
+    BC_TARGET(ADDK)
+        r[in->a] = vm_arith_values(BC_OP_ADD, r[in->b], program->constants[in->imm]);
+        BC_NEXT();
+    BC_TARGET(SUBK)
+        r[in->a] = vm_arith_values(BC_OP_SUB, r[in->b], program->constants[in->imm]);
+        BC_NEXT();
+    BC_TARGET(IF_LT)
+    BC_TARGET(IF_LE)
+        if (!vm_if_less(r[in->b], r[in->c], in->op == BC_OP_IF_LE)) {
+            ip = in->imm;
+            BC_DISPATCH();
+        }
+        BC_NEXT();
+#if !BC_THREADED_DISPATCH
+    case BC_OP_COUNT:
+        BC_NEXT();
+    }
+#endif
+
+dequicken:
+    /* Back to the generic op for good: it handles every operand kind. */
+    in->op = (uint8_t)bc_op_generic((BcOp)in->op);
+    in->imm = BC_QUICKEN_NEVER;
+    vm->dequickened++;
+    BC_REDISPATCH();
+
+#undef BC_QUICK
+#undef BC_NEXT
+#undef BC_DISPATCH
+#undef BC_REDISPATCH
+#undef BC_TARGET
+}
+
 static void print_value(FILE *out, BcValue value) {
     switch (value.kind) {
         case BC_VALUE_NIL: fprintf(out, "nil"); break;
@@ -1973,7 +4209,7 @@ void bc_disassemble(const BcProgram *program, FILE *out) {
         print_dim(out, "%04zu  ", i);
         print_padded_op(out, (BcOp)in.op, 16);
         print_dim(out, "r%u r%u r%u imm=%u", in.a, in.b, in.c, in.imm);
-        if (in.op == BC_OP_CONST && in.imm < program->const_count) {
+        if ((in.op == BC_OP_CONST || in.op == BC_OP_ADDK || in.op == BC_OP_SUBK) && in.imm < program->const_count) {
             fprintf(out, " ; ");
             print_value(out, program->constants[in.imm]);
         } else if (in.op == BC_OP_CALL_NATIVE && in.imm < program->native_count) {
@@ -2017,6 +4253,7 @@ void bc_decompile_monad(const BcProgram *program, FILE *out) {
     for (size_t i = 0; i < program->code_count; i++) {
         BcInstr in = program->code[i];
         char *a, *b;
+        in.op = (uint8_t)bc_op_generic((BcOp)in.op);
         switch ((BcOp)in.op) {
             case BC_OP_CONST:
                 free(expr[in.a]);
@@ -2034,8 +4271,9 @@ void bc_decompile_monad(const BcProgram *program, FILE *out) {
                 fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
                 break;
             case BC_OP_MOV:
+                a = bc_strdup(expr[in.b] ? expr[in.b] : "<unknown>");
                 free(expr[in.a]);
-                expr[in.a] = bc_strdup(expr[in.b] ? expr[in.b] : "<unknown>");
+                expr[in.a] = a;
                 fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
                 break;
             case BC_OP_ADD:
@@ -2055,19 +4293,34 @@ void bc_decompile_monad(const BcProgram *program, FILE *out) {
                     in.op == BC_OP_GT ? ">" : ">=";
                 a = expr[in.b] ? expr[in.b] : "<unknown>";
                 b = expr[in.c] ? expr[in.c] : "<unknown>";
+                /* Operands may name r[a] itself: format before freeing it. */
+                char *e = fmt_expr("(%s %s %s)", sym, a, b);
                 free(expr[in.a]);
-                expr[in.a] = fmt_expr("(%s %s %s)", sym, a, b);
+                expr[in.a] = e;
+                fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
+                break;
+            }
+            case BC_OP_ADDK:
+            case BC_OP_SUBK: {
+                char *k = in.imm < program->const_count ? value_expr(program->constants[in.imm]) : bc_strdup("<bad-const>");
+                char *e = fmt_expr("(%s %s %s)", in.op == BC_OP_ADDK ? "+" : "-",
+                                   expr[in.b] ? expr[in.b] : "<unknown>", k);
+                free(k);
+                free(expr[in.a]);
+                expr[in.a] = e;
                 fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
                 break;
             }
             case BC_OP_NEG:
+                a = fmt_expr("(- %s)", expr[in.b] ? expr[in.b] : "<unknown>");
                 free(expr[in.a]);
-                expr[in.a] = fmt_expr("(- %s)", expr[in.b] ? expr[in.b] : "<unknown>");
+                expr[in.a] = a;
                 fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
                 break;
             case BC_OP_NOT:
+                a = fmt_expr("(not %s)", expr[in.b] ? expr[in.b] : "<unknown>");
                 free(expr[in.a]);
-                expr[in.a] = fmt_expr("(not %s)", expr[in.b] ? expr[in.b] : "<unknown>");
+                expr[in.a] = a;
                 fprintf(out, ";; r%u = %s\n", in.a, expr[in.a]);
                 break;
             case BC_OP_CALL_NATIVE:
@@ -2081,6 +4334,11 @@ void bc_decompile_monad(const BcProgram *program, FILE *out) {
             case BC_OP_IF:
                 fprintf(out, "(if %s\n", expr[in.a] ? expr[in.a] : "<unknown>");
                 break;
+            case BC_OP_IF_LT:
+            case BC_OP_IF_LE:
+                fprintf(out, "(if (%s %s %s)\n", in.op == BC_OP_IF_LT ? "<" : "<=",
+                        expr[in.b] ? expr[in.b] : "<unknown>", expr[in.c] ? expr[in.c] : "<unknown>");
+                break;
             case BC_OP_ELSE:
                 fprintf(out, " else\n");
                 break;
@@ -28,14 +28,18 @@ extern "C" {
 
 #define BC_MAGIC 0x31434442u /* "BDC1" little endian */
 #define BC_VERSION_MAJOR 1u
-#define BC_VERSION_MINOR 0u
+#define BC_VERSION_MINOR 4u
 #define BC_MAX_REGISTERS 65535u
 #define BC_STRUCTURED_DEPTH_MAX 1024u
 #define BC_SECTION_UNKNOWN UINT32_MAX
+#define BC_JIT_MAX_DEOPTS 4u
+#define BC_IC_MAX_ENTRIES 4u
+#define BC_IMAGE_ALIGN 8u
 
 typedef struct BcProgram BcProgram;
 typedef struct BcVM BcVM;
 typedef struct BcJitArtifact BcJitArtifact;
+typedef struct BcProgramMap BcProgramMap;
 
 typedef enum {
     BC_VALUE_NIL,
@@ -109,6 +113,24 @@ typedef enum {
     BC_OP_END,
     BC_OP_RETURN,      /* return r[a] */
     BC_OP_HALT,
+    /* Quickened forms (v1.1): the generic op's operands, with both known to
+     * be I64 (or F64).  bc_vm_run rewrites generic ops into these in its own
+     * copy of the code and reverts one that meets other operand kinds. */
+    BC_OP_ADD_I64,
+    BC_OP_SUB_I64,
+    BC_OP_MUL_I64,
+    BC_OP_ADD_F64,
+    BC_OP_SUB_F64,
+    BC_OP_MUL_F64,
+    BC_OP_LT_I64,
+    BC_OP_LE_I64,
+    BC_OP_GT_I64,
+    BC_OP_GE_I64,
+    /* Superinstructions (v1.4), formed by bc_optimize_program. */
+    BC_OP_ADDK,        /* r[a] = r[b] + constants[imm] */
+    BC_OP_SUBK,        /* r[a] = r[b] - constants[imm] */
+    BC_OP_IF_LT,       /* if r[b] < r[c] then ... optional else ... end */
+    BC_OP_IF_LE,       /* if r[b] <= r[c] then ... */
     BC_OP_COUNT,
 } BcOp;
 
@@ -119,6 +141,12 @@ typedef enum {
     BC_SECTION_DEBUG = 4,
     BC_SECTION_DEOPT = 5,
     BC_SECTION_IC = 6,
+    /* Image sections (v1.3) hold an array in the host's in-memory layout,
+     * BC_IMAGE_ALIGN-aligned in the file, so bc_program_map can point the
+     * program straight at it. */
+    BC_SECTION_CODE_IMAGE = 7,
+    BC_SECTION_CONSTANTS_IMAGE = 8,
+    BC_SECTION_TYPES_IMAGE = 9,
 } BcSectionId;
 
 typedef struct {
@@ -148,13 +176,37 @@ typedef struct {
     BcType      return_type;
     uint8_t     min_arity;
     uint8_t     max_arity;
+    BcType      receiver_type;  /* variants: the r[b] type they serve */
+    uint32_t    generic;        /* variants: the native they specialise; else own index */
 } BcNative;
 
+/*
+ * A call site's inline cache.  The interpreter records each receiver type
+ * the site meets together with the native serving it -- the called
+ * native's variant for that type when one is registered, else the native
+ * itself.  The cache goes monomorphic, then polymorphic (up to
+ * BC_IC_MAX_ENTRIES types), then megamorphic, where it stops recording
+ * and the site calls the generic native.  misses counts receiver types
+ * the cache did not hold.
+ */
+typedef enum {
+    BC_IC_UNINITIALIZED,
+    BC_IC_MONOMORPHIC,
+    BC_IC_POLYMORPHIC,
+    BC_IC_MEGAMORPHIC,
+} BcInlineCacheState;
+
 typedef struct {
-    uint32_t callsite;
     BcType   receiver_type;
     uint32_t target;
-    uint32_t misses;
+} BcInlineCacheEntry;
+
+typedef struct {
+    uint32_t           callsite;
+    BcInlineCacheState state;
+    uint32_t           entry_count;
+    BcInlineCacheEntry entries[BC_IC_MAX_ENTRIES];
+    uint32_t           misses;
 } BcInlineCache;
 
 typedef struct {
@@ -164,6 +216,8 @@ typedef struct {
     uint32_t source_id;
 } BcDeoptPoint;
 
+/* Both baseline tiers share one x86-64 emitter; on other hosts
+ * bc_jit_compile_baseline reports the JIT unavailable. */
 typedef enum {
     BC_JIT_BASELINE_TEMPLATE,
     BC_JIT_BASELINE_NATIVE,
@@ -171,15 +225,19 @@ typedef enum {
 
 typedef struct {
     BcJitTier tier;
-    bool      enable_inline_caches;
-    bool      require_deopt_maps;
+    bool      enable_inline_caches;  /* speculate call receivers from primed ICs */
+    bool      require_deopt_maps;    /* guards and OSR only at BcDeoptPoint safepoints */
     bool      trace;
+    size_t    osr_instr;             /* loop header to give an OSR entry, or SIZE_MAX */
 } BcJitOptions;
 
 typedef struct {
     bool fold_constants;
     bool remove_self_moves;
+    bool forward_moves;           /* read through mov chains, drop the dead movs */
+    bool fuse_superinstructions;  /* const+add/sub -> addk/subk, compare+if -> if.lt/if.le */
     bool compact_nops;
+    bool coalesce_registers;      /* share registers whose live ranges don't overlap */
     bool verify_after;
 } BcOptimizeOptions;
 
@@ -190,6 +248,10 @@ typedef struct {
     size_t moves_eliminated;
     size_t nops_removed;
     size_t constants_added;
+    size_t moves_forwarded;          /* operands read through a mov instead */
+    size_t superinstructions_fused;
+    size_t registers_before;
+    size_t registers_after;
 } BcOptimizeReport;
 
 typedef struct {
@@ -200,11 +262,29 @@ typedef struct {
     bool     enable_osr;
 } BcTierPlan;
 
+/*
+ * Baseline code for a whole program.  Compiled code keeps every register
+ * as a 64-bit payload plus its BcValueKind, so a register whose type
+ * differs between paths is read behind a guard; a failed guard (or a
+ * call whose receiver misses the inline cache it was speculated from)
+ * deoptimizes back to the interpreter at that instruction.
+ *
+ * entry is a BcJitEntry returning the raw I64/Bool/Nil bits of the result,
+ * set only for programs with no guards or native calls whose returns all
+ * have result_type.  bc_vm_run uses the state-passing vm_entry/osr_entry.
+ */
+typedef int64_t (*BcJitEntry)(void);
+
 struct BcJitArtifact {
     void    *entry;
+    void    *vm_entry;
+    void    *osr_entry;     /* enters at osr_instr with live registers */
+    size_t   osr_instr;
     void    *code;
     size_t   code_size;
+    size_t   guards;        /* speculation sites that can deoptimize */
     BcJitTier tier;
+    BcType   result_type;   /* BC_TYPE_UNKNOWN if returns disagree */
 };
 
 typedef struct {
@@ -218,6 +298,7 @@ typedef struct {
     size_t constant_bytes;
     size_t metadata_bytes;
     size_t total_bytes;
+    size_t mapped_bytes;     /* file mapping of bc_program_map, not in total_bytes */
 } BcProgramMemoryStats;
 
 typedef struct {
@@ -259,13 +340,61 @@ struct BcProgram {
     BcDeoptPoint *deopts;
     size_t        deopt_count;
     size_t        deopt_capacity;
+
+    char  **files;       /* span file names owned by a program read from disk */
+    size_t  file_count;
+
+    BcProgramMap *map;   /* set by bc_program_map */
 };
 
+/*
+ * The VM runs a private copy of the program's code with structured jumps
+ * resolved and generic arithmetic quickened in place.  The copy survives
+ * across runs of an unchanged program, so quickening learned on one run
+ * pays off on the next.
+ */
 struct BcVM {
     BcValue *registers;
     size_t   register_count;
     bool     trace;
     FILE    *trace_out;
+    bool     quicken;        /* default true; false runs generic ops only */
+
+    BcInstr *code;           /* private copy, plus a trailing halt */
+    BcInstr *code_source;    /* snapshot of the program code it was built from */
+    BcValue *const_source;   /* ... and of its constants */
+    size_t   const_count;
+    size_t   native_count;
+    uint32_t *site_ic;       /* inline cache per instruction, UINT32_MAX for none */
+    size_t   ic_count;
+    size_t   code_count;
+    size_t   code_capacity;
+    const BcProgram *code_program;
+
+    size_t   quickened;      /* typed rewrites, cumulative for the cached copy */
+    size_t   dequickened;    /* typed ops that met other operand kinds */
+    size_t   ic_links;       /* call sites patched to call a native variant */
+
+    /* Tier-up.  Once the cached program has run call_hot_threshold times,
+     * or entered loop bodies loop_hot_threshold times, the next run
+     * compiles it with the baseline JIT and later runs call the native
+     * code instead of interpreting; those runs leave the register file
+     * untouched.  With enable_osr a loop header that trips the threshold
+     * mid-run compiles the program and continues in native code from
+     * there.  A deoptimization drops the code, and the program must turn
+     * hot again to be recompiled, at most BC_JIT_MAX_DEOPTS times.  A
+     * program the JIT rejects stays interpreted.  Tracing always
+     * interprets. */
+    BcTierPlan    tier;          /* bc_tier_plan_default() */
+    size_t        calls;         /* interpreted runs of the cached program */
+    size_t        loop_entries;  /* loop bodies entered by those runs */
+    BcJitArtifact jit;
+    bool          jit_rejected;
+    size_t        jit_runs;      /* runs that executed compiled code */
+    size_t        osr_entries;   /* interpreted runs continued in compiled code */
+    size_t        deopts;        /* compiled runs resumed in the interpreter */
+    int64_t      *jit_state;
+    size_t        jit_state_words;
 };
 
 BcValue bc_value_nil(void);
@@ -279,7 +408,9 @@ bool    bc_value_truthy(BcValue value);
 BcSourceSpan bc_span(const char *file, uint32_t line, uint32_t column);
 void         bc_error_clear(BcError *error);
 const char  *bc_op_name(BcOp op);
+BcOp         bc_op_generic(BcOp op);   /* quickened op -> generic op, else op */
 const char  *bc_type_name(BcType type);
+const char  *bc_ic_state_name(BcInlineCacheState state);
 
 void     bc_program_init(BcProgram *program, const char *name);
 void     bc_program_free(BcProgram *program);
@@ -305,6 +436,15 @@ uint32_t bc_program_add_native_typed(BcProgram *program,
                                      BcType return_type,
                                      uint8_t min_arity,
                                      uint8_t max_arity);
+/* Registers fn as generic's variant for receivers of receiver_type; a
+ * call site whose inline cache has seen only that type calls it directly.
+ * It takes generic's return type and arity. */
+uint32_t bc_program_add_native_variant(BcProgram *program,
+                                       uint32_t generic,
+                                       BcType receiver_type,
+                                       const char *name,
+                                       BcNativeFn fn,
+                                       void *userdata);
 uint32_t bc_program_add_inline_cache(BcProgram *program, uint32_t callsite);
 uint32_t bc_program_add_deopt_point(BcProgram *program,
                                     uint32_t safepoint,
@@ -320,9 +460,28 @@ size_t bc_emit_return(BcProgram *program, uint16_t src, BcSourceSpan span);
 bool bc_verify(const BcProgram *program, BcError *error);
 bool bc_verify_trace(const BcProgram *program, FILE *out, BcError *error);
 bool bc_write_binary(const BcProgram *program, FILE *out, BcError *error);
+/* Reads a program written by bc_write_binary into an initialised, empty
+ * program, inline caches included.  Natives are not part of the format:
+ * the host registers them afterwards, in the order they were written. */
+bool bc_read_binary(FILE *in, BcProgram *program, BcError *error);
 bool bc_read_binary_info(FILE *in, BcBinaryInfo *info, BcError *error);
 bool bc_dump_binary_sections(FILE *in, FILE *out, BcError *error);
 
+/*
+ * bc_write_binary_image writes code, constants and register types as image
+ * sections.  bc_program_map maps such a file and points code, constants
+ * and register_types straight into the mapping; the inline caches, which
+ * the VM updates, are read into memory, and the debug and deopt sections
+ * are decoded the first time something asks for a span or a deopt point.
+ * Sections in the portable encoding are decoded as bc_read_binary does.
+ * Growing or rewriting a mapped program first copies its arrays out of
+ * the mapping; bc_program_free unmaps it.  bc_program_page_in decodes the
+ * lazy sections now and reports a corrupt one.
+ */
+bool bc_write_binary_image(const BcProgram *program, FILE *out, BcError *error);
+bool bc_program_map(BcProgram *program, const char *path, BcError *error);
+bool bc_program_page_in(BcProgram *program, BcError *error);
+
 BcOptimizeOptions bc_optimize_options_default(void);
 bool              bc_optimize_program(BcProgram *program,
                                       const BcOptimizeOptions *options,
@@ -345,6 +504,8 @@ bool         bc_tier_plan_trace(const BcProgram *program,
                                 FILE *out,
                                 BcError *error);
 
+const char *bc_vm_dispatch_name(void);  /* "threaded" or "switch" */
+
 void bc_vm_init(BcVM *vm);
 void bc_vm_free(BcVM *vm);
 bool bc_vm_run(BcVM *vm, const BcProgram *program, BcValue *result, BcError *error);
@@ -0,0 +1,585 @@
+#include "bytecode_lower.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+
+/*
+ * bytecode_lower.c - Monad AST -> register bytecode
+ *
+ * One recursive walk.  Every node lowers into a register and reports the
+ * BcType it holds; registers are handed out in order and never reused, and
+ * bc_optimize_program coalesces them afterwards.  A name bound by let or a
+ * top-level define is just the register its value was lowered into -- the
+ * subset has no set!, so sharing it is safe.
+ *
+ * The walk never emits code it has not type-checked: operand types are
+ * known exactly at every node, so bc_verify at the end is a cross-check
+ * rather than the thing that rejects programs.
+ */
+
+typedef struct {
+    const char *name;
+    uint16_t    reg;
+    BcType      type;
+} Binding;
+
+typedef struct {
+    BcProgram            *program;
+    const BcLowerOptions *options;
+    BcError              *error;
+    const char           *file;
+    Binding              *scope;
+    size_t                scope_count;
+    size_t                scope_cap;
+    size_t                next_reg;
+    uint32_t              show_native;   /* UINT32_MAX until first show */
+} Lower;
+
+static bool lower_node(Lower *L, const AST *ast, uint16_t *reg, BcType *type);
+
+BcLowerOptions bc_lower_options_default(void) {
+    BcLowerOptions options;
+    options.file = NULL;
+    options.is_builtin = NULL;
+    options.userdata = NULL;
+    options.out = NULL;
+    options.optimize = true;
+    return options;
+}
+
+/// Errors
+
+static BcSourceSpan span_of(const Lower *L, const AST *ast) {
+    uint32_t line = ast && ast->line > 0 ? (uint32_t)ast->line : 0;
+    uint32_t column = ast && ast->column > 0 ? (uint32_t)ast->column : 0;
+    return bc_span(L->file, line, column);
+}
+
+static bool lower_fail(Lower *L, const AST *at, const char *fmt, ...) {
+    if (!L->error) return false;
+    bc_error_clear(L->error);
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(L->error->message, sizeof(L->error->message), fmt, ap);
+    va_end(ap);
+    L->error->instr = L->program->code_count;
+    L->error->span = span_of(L, at);
+    return false;
+}
+
+static const char *head_name(const AST *ast) {
+    if (ast && ast->type == AST_LIST && ast->list.count > 0 &&
+        ast->list.items[0]->type == AST_SYMBOL)
+        return ast->list.items[0]->symbol;
+    return NULL;
+}
+
+/// Registers and scope
+
+static bool fresh_reg(Lower *L, const AST *at, uint16_t *out) {
+    if (L->next_reg >= BC_MAX_REGISTERS)
+        return lower_fail(L, at, "expression needs more than %u registers", BC_MAX_REGISTERS);
+    *out = (uint16_t)L->next_reg++;
+    return true;
+}
+
+static void scope_push(Lower *L, const char *name, uint16_t reg, BcType type) {
+    if (L->scope_count == L->scope_cap) {
+        L->scope_cap = L->scope_cap ? L->scope_cap * 2 : 16;
+        L->scope = realloc(L->scope, L->scope_cap * sizeof(L->scope[0]));
+        if (!L->scope) abort();
+    }
+    L->scope[L->scope_count++] = (Binding){name, reg, type};
+}
+
+static const Binding *scope_find(const Lower *L, const char *name) {
+    for (size_t i = L->scope_count; i-- > 0;)
+        if (strcmp(L->scope[i].name, name) == 0) return &L->scope[i];
+    return NULL;
+}
+
+static void emit(Lower *L, const AST *at, BcOp op, uint16_t a, uint16_t b, uint16_t c, uint32_t imm) {
+    bc_emit(L->program, (BcInstr){(uint8_t)op, a, b, c, imm}, span_of(L, at));
+}
+
+/// Types
+
+static bool is_numeric(BcType t) {
+    return t == BC_TYPE_I64 || t == BC_TYPE_F64;
+}
+
+/* Whether HM agrees with the type the walk lowered `ast` to.  No
+ * annotation or a type variable agrees with anything. */
+static bool inferred_agrees(const AST *ast, BcType lowered) {
+    const Type *t = ast->inferred_type;
+    if (!t) return true;
+    switch (t->kind) {
+        case TYPE_VAR:
+        case TYPE_UNKNOWN:
+            return true;
+        case TYPE_INT:
+        case TYPE_I64:
+            return lowered == BC_TYPE_I64;
+        case TYPE_FLOAT:
+            return lowered == BC_TYPE_F64;
+        case TYPE_BOOL:
+            return lowered == BC_TYPE_BOOL;
+        case TYPE_FINITE_SET:
+            return lowered == BC_TYPE_BOOL && t->finite_name &&
+                   strcmp(t->finite_name, "Bool") == 0;
+        default:
+            return false;
+    }
+}
+
+static const char *type_word(BcType t) {
+    switch (t) {
+        case BC_TYPE_I64:  return "Int";
+        case BC_TYPE_F64:  return "Float";
+        case BC_TYPE_BOOL: return "Bool";
+        case BC_TYPE_NIL:  return "nil";
+        default:           return bc_type_name(t);
+    }
+}
+
+static bool expect(Lower *L, const AST *at, BcType got, bool ok, const char *what) {
+    if (ok) return true;
+    return lower_fail(L, at, "%s got %s", what, type_word(got));
+}
+
+/// Literals
+
+/* The reader keeps the spelling: a '.', 'e' or 'E' makes a Float, a radix
+ * prefix keeps its own Hex/Bin/Oct type. */
+static bool literal_is_radix(const AST *ast) {
+    const char *s = ast->literal_str;
+    return s && s[0] == '0' &&
+           (s[1] == 'x' || s[1] == 'X' || s[1] == 'b' || s[1] == 'B' || s[1] == 'o' || s[1] == 'O');
+}
+
+static bool literal_is_float(const AST *ast) {
+    if (ast->inferred_type && ast->inferred_type->kind == TYPE_FLOAT) return true;
+    if (ast->literal_str) return strpbrk(ast->literal_str, ".eE") != NULL;
+    if (ast->number < -9223372036854775808.0 || ast->number >= 9223372036854775808.0) return true;
+    return ast->number != (double)(int64_t)ast->number;
+}
+
+static bool literal_int(const AST *ast, int64_t *out) {
+    if (ast->type != AST_NUMBER || literal_is_radix(ast) || literal_is_float(ast)) return false;
+    if (!ast->literal_str) {
+        *out = (int64_t)ast->number;
+        return true;
+    }
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(ast->literal_str, &end, 10);
+    if (errno == ERANGE || !end || *end != '\0' || end == ast->literal_str) return false;
+    *out = (int64_t)v;
+    return true;
+}
+
+static bool lower_number(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    if (literal_is_radix(ast))
+        return lower_fail(L, ast, "radix literal %s keeps its own type", ast->literal_str);
+    BcValue value;
+    if (literal_is_float(ast)) {
+        value = bc_value_f64(ast->number);
+    } else {
+        int64_t v;
+        if (!literal_int(ast, &v))
+            return lower_fail(L, ast, "integer literal %s does not fit in 64 bits",
+                              ast->literal_str ? ast->literal_str : "?");
+        value = bc_value_i64(v);
+    }
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, BC_OP_CONST, *reg, 0, 0, bc_program_add_const(L->program, value));
+    *type = bc_type_of_value(value);
+    return true;
+}
+
+static bool lower_symbol(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    const Binding *b = scope_find(L, ast->symbol);
+    if (b) {
+        *reg = b->reg;
+        *type = b->type;
+        return true;
+    }
+    bool is_true = strcmp(ast->symbol, "True") == 0;
+    if (!is_true && strcmp(ast->symbol, "False") != 0)
+        return lower_fail(L, ast, "`%s` is not a local or top-level value", ast->symbol);
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, BC_OP_BOOL, *reg, 0, 0, is_true ? 1u : 0u);
+    *type = BC_TYPE_BOOL;
+    return true;
+}
+
+/// Operators
+
+static bool lower_arith(Lower *L, const AST *ast, BcOp op, uint16_t *reg, BcType *type) {
+    const char *name = head_name(ast);
+    size_t argc = ast->list.count - 1;
+    if (argc < 2 || (op == BC_OP_MOD && argc != 2))
+        return lower_fail(L, ast, "`%s` with %zu operand%s is outside the bytecode subset",
+                          name, argc, argc == 1 ? "" : "s");
+
+    uint16_t acc;
+    BcType acc_type;
+    if (!lower_node(L, ast->list.items[1], &acc, &acc_type)) return false;
+    if (!expect(L, ast->list.items[1], acc_type, is_numeric(acc_type), "arithmetic operand")) return false;
+
+    for (size_t i = 2; i < ast->list.count; i++) {
+        const AST *arg = ast->list.items[i];
+        uint16_t rhs;
+        BcType rhs_type;
+        if (!lower_node(L, arg, &rhs, &rhs_type)) return false;
+        if (!expect(L, arg, rhs_type, is_numeric(rhs_type), "arithmetic operand")) return false;
+        BcType result = acc_type == BC_TYPE_F64 || rhs_type == BC_TYPE_F64 ? BC_TYPE_F64 : BC_TYPE_I64;
+        if (op == BC_OP_MOD && result != BC_TYPE_I64)
+            return lower_fail(L, ast, "`%s` needs Int operands", name);
+        if ((op == BC_OP_DIV || op == BC_OP_MOD) && result == BC_TYPE_I64) {
+            int64_t divisor;
+            if (!literal_int(arg, &divisor) || divisor == 0 || divisor == -1)
+                return lower_fail(L, arg, "integer `%s` needs a literal divisor other than 0 and -1", name);
+        }
+        uint16_t dst;
+        if (!fresh_reg(L, ast, &dst)) return false;
+        emit(L, ast, op, dst, acc, rhs, 0);
+        acc = dst;
+        acc_type = result;
+    }
+    *reg = acc;
+    *type = acc_type;
+    return true;
+}
+
+static bool lower_binary_args(Lower *L, const AST *ast, uint16_t *lhs, BcType *lt, uint16_t *rhs, BcType *rt) {
+    if (ast->list.count != 3)
+        return lower_fail(L, ast, "`%s` with %zu operands is outside the bytecode subset",
+                          head_name(ast), ast->list.count - 1);
+    return lower_node(L, ast->list.items[1], lhs, lt) &&
+           lower_node(L, ast->list.items[2], rhs, rt);
+}
+
+static bool lower_compare(Lower *L, const AST *ast, BcOp op, uint16_t *reg, BcType *type) {
+    uint16_t lhs, rhs;
+    BcType lt, rt;
+    if (!lower_binary_args(L, ast, &lhs, &lt, &rhs, &rt)) return false;
+    if (!expect(L, ast->list.items[1], lt, is_numeric(lt), "comparison operand") ||
+        !expect(L, ast->list.items[2], rt, is_numeric(rt), "comparison operand"))
+        return false;
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, op, *reg, lhs, rhs, 0);
+    *type = BC_TYPE_BOOL;
+    return true;
+}
+
+/* bc.eq is false across value kinds, where Monad compares 1 and 1.0 as
+ * numbers, so only same-typed operands lower. */
+static bool lower_equal(Lower *L, const AST *ast, bool negate, uint16_t *reg, BcType *type) {
+    uint16_t lhs, rhs;
+    BcType lt, rt;
+    if (!lower_binary_args(L, ast, &lhs, &lt, &rhs, &rt)) return false;
+    if (lt != rt || lt == BC_TYPE_NIL)
+        return lower_fail(L, ast, "`%s` of %s and %s is outside the bytecode subset",
+                          head_name(ast), type_word(lt), type_word(rt));
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, BC_OP_EQ, *reg, lhs, rhs, 0);
+    if (negate) emit(L, ast, BC_OP_NOT, *reg, *reg, 0, 0);
+    *type = BC_TYPE_BOOL;
+    return true;
+}
+
+static bool lower_not(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    if (ast->list.count != 2)
+        return lower_fail(L, ast, "`not` takes one operand");
+    uint16_t src;
+    BcType t;
+    if (!lower_node(L, ast->list.items[1], &src, &t)) return false;
+    if (!expect(L, ast->list.items[1], t, t == BC_TYPE_BOOL, "`not` operand")) return false;
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, BC_OP_NOT, *reg, src, 0, 0);
+    *type = BC_TYPE_BOOL;
+    return true;
+}
+
+/* (and a b c) -> dst = a; if dst { dst = b; if dst { dst = c } }, and `or`
+ * tests the negation.  Each operand after the first runs only when the
+ * ones before it did not decide the result. */
+static bool lower_logic(Lower *L, const AST *ast, bool is_or, uint16_t *reg, BcType *type) {
+    size_t argc = ast->list.count - 1;
+    if (argc < 2)
+        return lower_fail(L, ast, "`%s` needs at least two operands", head_name(ast));
+    if (argc > BC_STRUCTURED_DEPTH_MAX / 2)
+        return lower_fail(L, ast, "`%s` has too many operands to nest", head_name(ast));
+
+    uint16_t dst, test = 0;
+    if (!fresh_reg(L, ast, &dst)) return false;
+    if (is_or && !fresh_reg(L, ast, &test)) return false;
+    for (size_t i = 1; i <= argc; i++) {
+        const AST *arg = ast->list.items[i];
+        uint16_t src;
+        BcType t;
+        if (!lower_node(L, arg, &src, &t)) return false;
+        if (!expect(L, arg, t, t == BC_TYPE_BOOL, "logical operand")) return false;
+        emit(L, arg, BC_OP_MOV, dst, src, 0, 0);
+        if (i == argc) break;
+        if (is_or) {
+            emit(L, arg, BC_OP_NOT, test, dst, 0, 0);
+            emit(L, arg, BC_OP_IF, test, 0, 0, 0);
+        } else {
+            emit(L, arg, BC_OP_IF, dst, 0, 0, 0);
+        }
+    }
+    for (size_t i = 1; i < argc; i++) emit(L, ast, BC_OP_END, 0, 0, 0, 0);
+    *reg = dst;
+    *type = BC_TYPE_BOOL;
+    return true;
+}
+
+static bool lower_if(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    if (ast->list.count != 4)
+        return lower_fail(L, ast, "`if` needs a condition and two branches");
+    uint16_t cond, then_reg, else_reg, dst;
+    BcType cond_type, then_type, else_type;
+    if (!lower_node(L, ast->list.items[1], &cond, &cond_type)) return false;
+    if (!expect(L, ast->list.items[1], cond_type, cond_type == BC_TYPE_BOOL, "`if` condition")) return false;
+    if (!fresh_reg(L, ast, &dst)) return false;
+
+    emit(L, ast, BC_OP_IF, cond, 0, 0, 0);
+    if (!lower_node(L, ast->list.items[2], &then_reg, &then_type)) return false;
+    emit(L, ast->list.items[2], BC_OP_MOV, dst, then_reg, 0, 0);
+    emit(L, ast, BC_OP_ELSE, 0, 0, 0, 0);
+    if (!lower_node(L, ast->list.items[3], &else_reg, &else_type)) return false;
+    emit(L, ast->list.items[3], BC_OP_MOV, dst, else_reg, 0, 0);
+    emit(L, ast, BC_OP_END, 0, 0, 0, 0);
+
+    if (then_type != else_type)
+        return lower_fail(L, ast, "`if` branches lower to %s and %s",
+                          type_word(then_type), type_word(else_type));
+    *reg = dst;
+    *type = then_type;
+    return true;
+}
+
+static bool show_native(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *result, void *userdata) {
+    (void)vm;
+    (void)argc;
+    FILE *out = userdata ? (FILE *)userdata : stdout;
+    switch (args[0].kind) {
+        case BC_VALUE_I64:  fprintf(out, "%" PRId64 "\n", args[0].as.i64); break;
+        case BC_VALUE_F64:  fprintf(out, "%.16g\n", args[0].as.f64); break;
+        case BC_VALUE_BOOL: fputs(args[0].as.boolean ? "True\n" : "False\n", out); break;
+        default:            return false;
+    }
+    *result = bc_value_nil();
+    return true;
+}
+
+/* (show x) with a scalar x, printed the way codegen_show_value prints it. */
+static bool lower_show(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    if (ast->list.count != 2 || ast->list.items[1]->type == AST_STRING)
+        return lower_fail(L, ast, "only `show` of one Int, Float or Bool lowers to bytecode");
+    uint16_t src;
+    BcType t;
+    if (!lower_node(L, ast->list.items[1], &src, &t)) return false;
+    if (!expect(L, ast->list.items[1], t, is_numeric(t) || t == BC_TYPE_BOOL, "`show` operand")) return false;
+    if (L->show_native == UINT32_MAX)
+        L->show_native = bc_program_add_native_typed(L->program, "show", show_native,
+                                                     L->options->out, BC_TYPE_NIL, 1, 1);
+    if (!fresh_reg(L, ast, reg)) return false;
+    emit(L, ast, BC_OP_CALL_NATIVE, *reg, src, 1, L->show_native);
+    *type = BC_TYPE_NIL;
+    return true;
+}
+
+/* ((lambda (x y) body...) a b) is what the reader makes of let: the
+ * arguments lower in the outer scope, then the body sees them by name. */
+static bool lower_apply_lambda(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    const AST *lambda = ast->list.items[0];
+    size_t argc = ast->list.count - 1;
+    if ((size_t)lambda->lambda.param_count != argc || lambda->lambda.body_count < 1)
+        return lower_fail(L, lambda, "only a let-shaped lambda application lowers to bytecode");
+
+    size_t mark = L->scope_count;
+    uint16_t *regs = malloc((argc ? argc : 1) * sizeof(regs[0]));
+    BcType *types = malloc((argc ? argc : 1) * sizeof(types[0]));
+    if (!regs || !types) abort();
+    bool ok = true;
+    for (size_t i = 0; ok && i < argc; i++) {
+        const ASTParam *p = &lambda->lambda.params[i];
+        ok = lower_node(L, ast->list.items[i + 1], &regs[i], &types[i]);
+        if (ok && (p->is_rest || !p->name))
+            ok = lower_fail(L, lambda, "rest parameters are outside the bytecode subset");
+        if (ok && p->type_name && strcmp(p->type_name, type_word(types[i])) != 0)
+            ok = lower_fail(L, ast->list.items[i + 1], "`%s :: %s` bound to %s",
+                            p->name, p->type_name, type_word(types[i]));
+    }
+    for (size_t i = 0; ok && i < argc; i++)
+        scope_push(L, lambda->lambda.params[i].name, regs[i], types[i]);
+    for (int i = 0; ok && i < lambda->lambda.body_count; i++)
+        ok = lower_node(L, lambda->lambda.body_exprs[i], reg, type);
+    L->scope_count = mark;
+    free(regs);
+    free(types);
+    return ok;
+}
+
+/// Dispatch
+
+typedef enum {
+    FORM_ARITH,
+    FORM_COMPARE,
+    FORM_EQ,
+    FORM_NE,
+    FORM_NOT,
+    FORM_AND,
+    FORM_OR,
+    FORM_IF,
+    FORM_SHOW,
+} FormKind;
+
+static const struct {
+    const char *name;
+    FormKind    kind;
+    BcOp        op;
+} FORMS[] = {
+    {"+",   FORM_ARITH,   BC_OP_ADD}, {"-",  FORM_ARITH,   BC_OP_SUB},
+    {"*",   FORM_ARITH,   BC_OP_MUL}, {"/",  FORM_ARITH,   BC_OP_DIV},
+    {"%",   FORM_ARITH,   BC_OP_MOD}, {"mod", FORM_ARITH,  BC_OP_MOD},
+    {"<",   FORM_COMPARE, BC_OP_LT},  {"<=", FORM_COMPARE, BC_OP_LE},
+    {">",   FORM_COMPARE, BC_OP_GT},  {">=", FORM_COMPARE, BC_OP_GE},
+    {"=",   FORM_EQ,      BC_OP_EQ},  {"!=", FORM_NE,      BC_OP_EQ},
+    {"not", FORM_NOT,     BC_OP_NOT}, {"and", FORM_AND,    BC_OP_NOP},
+    {"or",  FORM_OR,      BC_OP_NOP}, {"if", FORM_IF,      BC_OP_NOP},
+    {"show", FORM_SHOW,   BC_OP_NOP},
+};
+
+static bool lower_list(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    if (ast->list.count == 0)
+        return lower_fail(L, ast, "the empty list is outside the bytecode subset");
+    const AST *head = ast->list.items[0];
+    if (head->type == AST_LAMBDA) return lower_apply_lambda(L, ast, reg, type);
+    if (head->type != AST_SYMBOL)
+        return lower_fail(L, ast, "calls of computed functions are outside the bytecode subset");
+
+    const char *name = head->symbol;
+    if (!scope_find(L, name) &&
+        (!L->options->is_builtin || L->options->is_builtin(name, L->options->userdata))) {
+        for (size_t i = 0; i < sizeof(FORMS) / sizeof(FORMS[0]); i++) {
+            if (strcmp(FORMS[i].name, name) != 0) continue;
+            switch (FORMS[i].kind) {
+                case FORM_ARITH:   return lower_arith(L, ast, FORMS[i].op, reg, type);
+                case FORM_COMPARE: return lower_compare(L, ast, FORMS[i].op, reg, type);
+                case FORM_EQ:      return lower_equal(L, ast, false, reg, type);
+                case FORM_NE:      return lower_equal(L, ast, true, reg, type);
+                case FORM_NOT:     return lower_not(L, ast, reg, type);
+                case FORM_AND:     return lower_logic(L, ast, false, reg, type);
+                case FORM_OR:      return lower_logic(L, ast, true, reg, type);
+                case FORM_IF:      return lower_if(L, ast, reg, type);
+                case FORM_SHOW:    return lower_show(L, ast, reg, type);
+            }
+        }
+    }
+    return lower_fail(L, ast, "`(%s ...)` is outside the bytecode subset", name);
+}
+
+static bool lower_node(Lower *L, const AST *ast, uint16_t *reg, BcType *type) {
+    bool ok;
+    switch (ast->type) {
+        case AST_NUMBER: ok = lower_number(L, ast, reg, type); break;
+        case AST_SYMBOL: ok = lower_symbol(L, ast, reg, type); break;
+        case AST_LIST:   ok = lower_list(L, ast, reg, type); break;
+        case AST_STRING: return lower_fail(L, ast, "string values are outside the bytecode subset");
+        case AST_LAMBDA: return lower_fail(L, ast, "closures are outside the bytecode subset");
+        default:         return lower_fail(L, ast, "this form is outside the bytecode subset");
+    }
+    if (ok && *type != BC_TYPE_NIL && !inferred_agrees(ast, *type))
+        return lower_fail(L, ast, "HM inferred a type this %s value does not have", type_word(*type));
+    return ok;
+}
+
+/// Entry points
+
+static void lower_init(Lower *L, BcProgram *program, const BcLowerOptions *options, BcError *error) {
+    memset(L, 0, sizeof(*L));
+    L->program = program;
+    L->options = options;
+    L->error = error;
+    L->file = options->file ? options->file : "<input>";
+    L->next_reg = program->register_count;
+    L->show_native = UINT32_MAX;
+    bc_error_clear(error);
+    bc_program_set_debug_mode(program, BC_DEBUG_FULL_SPANS);
+}
+
+static bool lower_finish(Lower *L, bool ok) {
+    free(L->scope);
+    L->scope = NULL;
+    if (!ok) return false;
+    if (L->options->optimize) return bc_optimize_program(L->program, NULL, NULL, L->error);
+    return bc_verify(L->program, L->error);
+}
+
+bool bc_lower_expr(BcProgram *program, const AST *expr,
+                   const BcLowerOptions *options, BcError *error) {
+    BcLowerOptions defaults = bc_lower_options_default();
+    Lower L;
+    lower_init(&L, program, options ? options : &defaults, error);
+    uint16_t reg;
+    BcType type;
+    bool ok = lower_node(&L, expr, &reg, &type);
+    if (ok) emit(&L, expr, BC_OP_RETURN, reg, 0, 0, 0);
+    return lower_finish(&L, ok);
+}
+
+/* (define name value "doc"...) with a symbol name: the value to bind. */
+static const AST *value_define(const AST *ast) {
+    const char *head = head_name(ast);
+    if (!head || strcmp(head, "define") != 0 || ast->list.count < 3 ||
+        ast->list.items[1]->type != AST_SYMBOL)
+        return NULL;
+    for (size_t i = 3; i < ast->list.count; i++)
+        if (ast->list.items[i]->type != AST_STRING) return NULL;
+    return ast->list.items[2];
+}
+
+bool bc_lower_module(BcProgram *program, AST *const *exprs, size_t count,
+                     const BcLowerOptions *options, BcError *error) {
+    BcLowerOptions defaults = bc_lower_options_default();
+    Lower L;
+    lower_init(&L, program, options ? options : &defaults, error);
+    bool ok = true;
+    for (size_t i = 0; ok && i < count; i++) {
+        const AST *form = exprs[i];
+        const char *head = head_name(form);
+        uint16_t reg;
+        BcType type;
+        if (head && strcmp(head, "module") == 0) continue;
+        if (head && strcmp(head, "define") == 0) {
+            const AST *value = value_define(form);
+            if (!value)
+                ok = lower_fail(&L, form, "only value defines lower to bytecode");
+            else if (value->type == AST_LAMBDA)
+                ok = lower_fail(&L, form, "function defines are outside the bytecode subset");
+            else if ((ok = lower_node(&L, value, &reg, &type)))
+                scope_push(&L, form->list.items[1]->symbol, reg, type);
+            continue;
+        }
+        ok = lower_node(&L, form, &reg, &type);
+    }
+    if (ok) {
+        uint16_t nil;
+        const AST *last = count ? exprs[count - 1] : NULL;
+        ok = fresh_reg(&L, last, &nil);
+        if (ok) {
+            emit(&L, last, BC_OP_NIL, nil, 0, 0, 0);
+            emit(&L, last, BC_OP_RETURN, nil, 0, 0, 0);
+        }
+    }
+    return lower_finish(&L, ok);
+}
@@ -0,0 +1,64 @@
+#ifndef BYTECODE_LOWER_H
+#define BYTECODE_LOWER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "bytecode.h"
+#include "reader.h"
+
+///  Monad AST -> register bytecode
+//
+//  Lowers the scalar core of a typed Monad program into a BcProgram, so the
+//  REPL and `monad run --bc` can run it on the register VM without an LLVM
+//  module.  The input is the AST after wisp desugaring and infer_toplevel:
+//  inferred_type decides Int versus Float for literals the reader could not
+//  tell apart, and a node whose inferred type is not Int, Float or Bool (or
+//  still a type variable) is outside the subset.
+//
+//  The subset is what the VM can express without a heap:
+//
+//    Int / Float literals, True, False
+//    + - * /  (n-ary, Float if any operand is)   % mod  (Int)
+//    < <= > >=  = !=  not  and  or  if
+//    let  (desugared to an applied lambda)
+//    top-level value defines and (show <scalar>)
+//
+//  Integer / and % only lower with a literal divisor other than 0 and -1,
+//  so a lowered program cannot trap.  Anything else -- function defines,
+//  strings, imports, calls to user functions -- fails with the first node
+//  that is outside the subset in `error`, and the caller compiles the form
+//  with LLVM instead.  The lowered program is verified and optimized.
+//
+//    BcProgram p;
+//    bc_program_init(&p, "<repl>");
+//    BcLowerOptions o = bc_lower_options_default();
+//    if (bc_lower_expr(&p, ast, &o, &err)) bc_vm_run(&vm, &p, &value, &err);
+//    bc_program_free(&p);
+
+// Whether a free `name` in head position still names the builtin operator
+// (the REPL answers from its Env, where a define can shadow `+`).
+typedef bool (*BcLowerBuiltinFn)(const char *name, void *userdata);
+
+typedef struct {
+    const char      *file;        // span file name; NULL = "<input>"
+    BcLowerBuiltinFn is_builtin;  // NULL: every builtin name is the builtin
+    void            *userdata;
+    FILE            *out;         // where show prints; NULL = stdout
+    bool             optimize;    // run bc_optimize_program on the result
+} BcLowerOptions;
+
+BcLowerOptions bc_lower_options_default(void);
+
+// One expression; the program returns its value (nil for show).
+bool bc_lower_expr(BcProgram *program, const AST *expr,
+                   const BcLowerOptions *options, BcError *error);
+
+// A whole module: value defines bind registers visible to later forms,
+// other forms run for their effects, and the program returns nil.
+// (module ...) declarations are accepted and ignored.
+bool bc_lower_module(BcProgram *program, AST *const *exprs, size_t count,
+                     const BcLowerOptions *options, BcError *error);
+
+#endif
@@ -297,8 +297,8 @@ static int levenshtein(const char *a, const char *b)
 }
 
 static const char *SUBCOMMANDS[] = {
-    "new", "build", "run", "clean", "install",
-    "test", "check", "trace", "debug", "lsp", "eval",
+    "new", "build", "run", "clean", "install", "prelude",
+    "test", "bench", "daemon", "check", "trace", "debug", "lsp", "eval",
     "repl", "jit", "menu", "flags", "help", NULL
 };
 
@@ -327,6 +327,102 @@ static bool parse_optimization_flag(const char *arg, int *level)
     return false;
 }
 
+static bool parse_jobs_value(const char *val, int *jobs)
+{
+    if (!*val) return false;
+    for (const char *p = val; *p; p++)
+        if (*p < '0' || *p > '9') return false;
+    *jobs = atoi(val);
+    return true;
+}
+
+// -jN, -j N, --jobs=N, --jobs N, jobs=N
+static bool parse_jobs_flag(int argc, char **argv, int *index, int *jobs)
+{
+    const char *arg = argv[*index];
+    if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) {
+        if (*index + 1 >= argc || !parse_jobs_value(argv[*index + 1], jobs)) {
+            fprintf(stderr, "%s requires a job count\n", arg);
+            exit(1);
+        }
+        (*index)++;
+        return true;
+    }
+    if (arg[0] == '-' && arg[1] == 'j' && parse_jobs_value(arg + 2, jobs))
+        return true;
+    if (strncmp(arg, "--jobs=", 7) == 0) return parse_jobs_value(arg + 7, jobs);
+    if (strncmp(arg, "jobs=", 5) == 0)   return parse_jobs_value(arg + 5, jobs);
+    return false;
+}
+
+// --lto, --lto=thin, --lto=full, lto=thin, lto=full
+static bool parse_lto_flag(const char *arg, LtoMode *mode)
+{
+    const char *val = NULL;
+    if (strcmp(arg, "--lto") == 0 || strcmp(arg, "lto") == 0) val = "thin";
+    else if (strncmp(arg, "--lto=", 6) == 0) val = arg + 6;
+    else if (strncmp(arg, "lto=", 4) == 0)   val = arg + 4;
+    if (!val) return false;
+    if      (strcmp(val, "thin") == 0) *mode = LTO_THIN;
+    else if (strcmp(val, "full") == 0) *mode = LTO_FULL;
+    else if (strcmp(val, "off")  == 0) *mode = LTO_OFF;
+    else {
+        fprintf(stderr, "%s: expected thin, full or off\n", arg);
+        exit(1);
+    }
+    return true;
+}
+
+// -mcpu=NAME, -march=native, mcpu=NAME
+static bool parse_cpu_flag(const char *arg, char **cpu)
+{
+    const char *val = NULL;
+    if      (strncmp(arg, "-mcpu=", 6) == 0)  val = arg + 6;
+    else if (strncmp(arg, "-march=", 7) == 0) val = arg + 7;
+    else if (strncmp(arg, "mcpu=", 5) == 0)   val = arg + 5;
+    if (!val) return false;
+    if (!*val) {
+        fprintf(stderr, "%s: expected a CPU name or native\n", arg);
+        exit(1);
+    }
+    *cpu = (char *)val;
+    return true;
+}
+
+// --time-trace, --time-trace=FILE, time-trace
+static bool parse_time_trace_flag(const char *arg, CompilerFlags *flags)
+{
+    if (strcmp(arg, "--time-trace") == 0 || strcmp(arg, "time-trace") == 0)
+        flags->time_trace = "";
+    else if (strncmp(arg, "--time-trace=", 13) == 0)
+        flags->time_trace = (char *)arg + 13;
+    else if (strncmp(arg, "time-trace=", 11) == 0)
+        flags->time_trace = (char *)arg + 11;
+    else
+        return false;
+    return true;
+}
+
+// --profile-generate, --profile-use=FILE, --profile-use FILE, profile-use=FILE
+static bool parse_profile_flag(int argc, char **argv, int *index, CompilerFlags *flags)
+{
+    const char *arg = argv[*index];
+    if (strcmp(arg, "--profile-generate") == 0 || strcmp(arg, "profile-generate") == 0) {
+        flags->profile_generate = true;
+        return true;
+    }
+    if (strcmp(arg, "--profile-use") == 0 || strcmp(arg, "profile-use") == 0) {
+        if (*index + 1 >= argc) { fprintf(stderr, "%s requires a profile file\n", arg); exit(1); }
+        flags->profile_use = argv[++(*index)];
+        return true;
+    }
+    if (strncmp(arg, "--profile-use=", 14) == 0) flags->profile_use = (char *)arg + 14;
+    else if (strncmp(arg, "profile-use=", 12) == 0) flags->profile_use = (char *)arg + 12;
+    else return false;
+    if (!*flags->profile_use) { fprintf(stderr, "%s requires a profile file\n", arg); exit(1); }
+    return true;
+}
+
 static void trace_set_all(CompilerFlags *flags, bool enabled)
 {
     flags->trace_ast = enabled;
@@ -472,6 +568,10 @@ static bool parse_bytecode_flag(const char *arg, CompilerFlags *flags)
         flags->bytecode_baseline_jit = true;
         return true;
     }
+    if (!strcmp(arg, "--bc") || !strcmp(arg, "--run-bytecode") || !strcmp(arg, "run-bytecode")) {
+        flags->run_bytecode = true;
+        return true;
+    }
     if (!strcmp(arg, "-jit") || !strcmp(arg, "jit") || !strcmp(arg, "--jit")) {
         flags->jit = true;
         flags->emit_bytecode = true;
@@ -491,10 +591,34 @@ static bool parse_positive_int(const char *value, int *out)
     return true;
 }
 
+static void push_debug_point(char ***list, int *count, char *spec)
+{
+    char **grown = realloc(*list, (size_t)(*count + 1) * sizeof(char *));
+    if (!grown) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    grown[(*count)++] = spec;
+    *list = grown;
+}
+
 static bool parse_debug_flag(int argc, char **argv, int *index, CompilerFlags *flags)
 {
     const char *arg = argv[*index];
 
+    if (!strcmp(arg, "--break") || !strcmp(arg, "--watch")) {
+        bool is_break = arg[2] == 'b';
+        if (*index + 1 >= argc || !argv[*index + 1][0]) {
+            fprintf(stderr, "%s requires %s\n", arg,
+                    is_break ? "a [FILE:]LINE[ if COND] spec" : "a variable name");
+            exit(1);
+        }
+        if (is_break) push_debug_point(&flags->breakpoints, &flags->breakpoint_count, argv[*index + 1]);
+        else          push_debug_point(&flags->watches, &flags->watch_count, argv[*index + 1]);
+        (*index)++;
+        return true;
+    }
+
     if (!strcmp(arg, "--debug-no-mouse")) {
         flags->debug_no_mouse = true;
         return true;
@@ -555,6 +679,15 @@ static bool parse_common_flag(int argc, char **argv, int *index, CompilerFlags *
     else if (!strcmp(arg, "-Wextra"     ) || !strcmp(arg, "Wextra"    ) ||
              !strcmp(arg, "extra-warnings")) {}
     else if (parse_optimization_flag(arg, &flags->optimization_level)) {}
+    else if (parse_jobs_flag(argc, argv, index, &flags->jobs)) {}
+    else if (parse_lto_flag(arg, &flags->lto)) {}
+    else if (parse_cpu_flag(arg, &flags->target_cpu)) {}
+    else if (!strcmp(arg, "--time-passes") || !strcmp(arg, "time-passes")) flags->time_passes = true;
+    else if (parse_time_trace_flag(arg, flags)) {}
+    else if (!strcmp(arg, "--report-escapes") || !strcmp(arg, "report-escapes")) flags->report_escapes = true;
+    else if (!strcmp(arg, "--report-tail-calls") || !strcmp(arg, "report-tail-calls")) flags->report_tail_calls = true;
+    else if (!strcmp(arg, "--profile-sites") || !strcmp(arg, "profile-sites")) flags->profile_sites = true;
+    else if (parse_profile_flag(argc, argv, index, flags)) {}
     else if (parse_trace_flag(arg, flags)) {}
     else if (!strcmp(arg, "trace")) {
         if (*index + 1 >= argc) { fprintf(stderr, "trace requires an argument\n"); exit(1); }
@@ -596,6 +729,7 @@ static bool is_test_suite_word(const char *arg)
             strcmp(arg, "cmake") == 0 ||
             strcmp(arg, "readme") == 0 ||
             strcmp(arg, "bytecode") == 0 ||
+            strcmp(arg, "runtime") == 0 ||
             strcmp(arg, "all") == 0);
 }
 
@@ -621,6 +755,7 @@ static void print_test_help(void)
     printf("  cmake     CMake and CI contract tests\n");
     printf("  readme    Human-facing README product contract\n");
     printf("  bytecode  Bytecode VM, verifier, serialization, and visual diagnostics\n");
+    printf("  runtime   libmonad runtime harnesses: allocation, collections, and laziness\n");
     printf("  all       Runner plus core suites\n\n");
     printf("Examples:\n");
     printf("  monad test list\n");
@@ -661,6 +796,7 @@ static bool is_common_option_word(const char *arg)
            strcmp(arg, "bytecode-sections") == 0 ||
            strcmp(arg, "bytecode-trace") == 0 ||
            strcmp(arg, "bytecode-baseline-jit") == 0 ||
+           strcmp(arg, "run-bytecode") == 0 ||
            strcmp(arg, "Wall") == 0 ||
            strcmp(arg, "warnings") == 0 ||
            strcmp(arg, "Wextra") == 0 ||
@@ -803,6 +939,16 @@ CompilerFlags parse_flags(int argc, char **argv) {
     }
     if (strcmp(argv[1], "clean")   == 0) { flags.mode = CMD_CLEAN;   return flags; }
     if (strcmp(argv[1], "install") == 0) { flags.mode = CMD_INSTALL; return flags; }
+    if (strcmp(argv[1], "prelude") == 0) {
+        flags.mode = CMD_PRELUDE;
+        for (int i = 2; i < argc; i++) {
+            if (!parse_common_flag(argc, argv, &i, &flags)) {
+                fprintf(stderr, "Unknown prelude flag: %s\n", argv[i]);
+                print_usage(argv[0]); exit(1);
+            }
+        }
+        return flags;
+    }
     if (strcmp(argv[1], "check")   == 0) {
         flags.mode = CMD_CHECK;
         if (argc >= 3) flags.input_file = argv[2];
@@ -853,6 +999,30 @@ CompilerFlags parse_flags(int argc, char **argv) {
         return flags;
     }
 
+    // monad bench [names] [options]  ->  run the benchmark corpus; every
+    // argument is left for bench/main.py to parse.
+    if (strcmp(argv[1], "bench") == 0) {
+        flags.mode       = CMD_BENCH;
+        flags.bench_argc = argc - 2;
+        flags.bench_argv = argv + 2;
+        return flags;
+    }
+
+    // monad daemon [run|start|stop|status]  ->  compile server (daemon.c)
+    if (strcmp(argv[1], "daemon") == 0) {
+        flags.mode = CMD_DAEMON;
+        flags.daemon_action = argc >= 3 ? argv[2] : "run";
+        if (argc > 3 ||
+            (strcmp(flags.daemon_action, "run")    != 0 &&
+             strcmp(flags.daemon_action, "start")  != 0 &&
+             strcmp(flags.daemon_action, "stop")   != 0 &&
+             strcmp(flags.daemon_action, "status") != 0)) {
+            fprintf(stderr, "Usage: %s daemon [run|start|stop|status]\n", argv[0]);
+            exit(1);
+        }
+        return flags;
+    }
+
     // monad --test <file.mon>  ->  compile with tests embedded, keep binary
     if (strcmp(argv[1], "--test") == 0) {
         if (argc < 3) { fprintf(stderr, "Usage: %s --test <file.mon>\n", argv[0]); exit(1); }
@@ -1156,8 +1326,14 @@ static int do_build(const BuildInfo *bi, const CompilerFlags *flags) {
     char opt_flag[8] = "";
     char emit_flags[512] = "";
     char trace_flags[128] = "";
+    char profile_flags[1100] = "";
+    char time_trace_flag[1100] = "";
+    char debug_point_flags[1100] = "";
     if (flags && flags->optimization_level > 0)
         snprintf(opt_flag, sizeof(opt_flag), " -O%d", flags->optimization_level);
+    char jobs_flag[16] = "";
+    if (flags && flags->jobs > 0)
+        snprintf(jobs_flag, sizeof(jobs_flag), " -j%d", flags->jobs);
     if (flags) {
         if (flags->emit_ir)
             strncat(emit_flags, " --emit-ir", sizeof(emit_flags) - strlen(emit_flags) - 1);
@@ -1187,6 +1363,63 @@ static int do_build(const BuildInfo *bi, const CompilerFlags *flags) {
             strncat(emit_flags, " --bytecode-baseline-jit", sizeof(emit_flags) - strlen(emit_flags) - 1);
         if (flags->jit)
             strncat(emit_flags, " -jit", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->run_bytecode)
+            strncat(emit_flags, " --bc", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->lto == LTO_THIN)
+            strncat(emit_flags, " --lto=thin", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->lto == LTO_FULL)
+            strncat(emit_flags, " --lto=full", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->time_passes)
+            strncat(emit_flags, " --time-passes", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->report_escapes)
+            strncat(emit_flags, " --report-escapes", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->report_tail_calls)
+            strncat(emit_flags, " --report-tail-calls", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->profile_sites)
+            strncat(emit_flags, " --profile-sites", sizeof(emit_flags) - strlen(emit_flags) - 1);
+        if (flags->target_cpu && strlen(flags->target_cpu) < 64) {
+            char cpu_flag[80];
+            snprintf(cpu_flag, sizeof(cpu_flag), " -mcpu=%s", flags->target_cpu);
+            strncat(emit_flags, cpu_flag, sizeof(emit_flags) - strlen(emit_flags) - 1);
+        }
+        if (flags->profile_generate)
+            strcpy(profile_flags, " --profile-generate");
+        if (flags->profile_use) {
+            char quoted_profile[1024];
+            if (!shell_quote_arg(flags->profile_use, quoted_profile, sizeof(quoted_profile))) {
+                fprintf(stderr, "Error: profile path is too long\n");
+                return 1;
+            }
+            snprintf(profile_flags, sizeof(profile_flags), " --profile-use %s", quoted_profile);
+        }
+        if (flags->time_trace && !flags->time_trace[0]) {
+            strcpy(time_trace_flag, " --time-trace");
+        } else if (flags->time_trace) {
+            char quoted_trace[1024];
+            if (!shell_quote_arg(flags->time_trace, quoted_trace, sizeof(quoted_trace))) {
+                fprintf(stderr, "Error: time-trace path is too long\n");
+                return 1;
+            }
+            snprintf(time_trace_flag, sizeof(time_trace_flag), " --time-trace=%s", quoted_trace);
+        }
+        for (int i = 0; i < flags->breakpoint_count + flags->watch_count; i++) {
+            bool is_break = i < flags->breakpoint_count;
+            const char *spec = is_break ? flags->breakpoints[i]
+                                        : flags->watches[i - flags->breakpoint_count];
+            char quoted_spec[512];
+            char point_flag[540];
+            if (!shell_quote_arg(spec, quoted_spec, sizeof(quoted_spec))) {
+                fprintf(stderr, "Error: %s spec is too long\n", is_break ? "--break" : "--watch");
+                return 1;
+            }
+            snprintf(point_flag, sizeof(point_flag), " %s %s",
+                     is_break ? "--break" : "--watch", quoted_spec);
+            if (strlen(debug_point_flags) + strlen(point_flag) >= sizeof(debug_point_flags)) {
+                fprintf(stderr, "Error: too many --break/--watch flags\n");
+                return 1;
+            }
+            strcat(debug_point_flags, point_flag);
+        }
         if (flags->trace_ast)
             strncat(trace_flags, " --trace=ast", sizeof(trace_flags) - strlen(trace_flags) - 1);
         if (flags->trace_semantic)
@@ -1202,15 +1435,19 @@ static int do_build(const BuildInfo *bi, const CompilerFlags *flags) {
 #if defined(_WIN32)
     /* Windows cmd.exe requires an outer quote when the command itself starts
      * with a quoted executable path; otherwise it discards the opening quote. */
-    snprintf(cmd, sizeof(cmd), "\"%s %s -o %s%s%s%s%s%s\"",
+    snprintf(cmd, sizeof(cmd), "\"%s %s -o %s%s%s%s%s%s%s%s%s%s\"",
 #else
-    snprintf(cmd, sizeof(cmd), "%s %s -o %s%s%s%s%s%s",
+    snprintf(cmd, sizeof(cmd), "%s %s -o %s%s%s%s%s%s%s%s%s%s",
 #endif
              quoted_self, quoted_main, quoted_out,
              bi->monad_options[0] ? " " : "",
              bi->monad_options[0] ? bi->monad_options : "",
              opt_flag,
+             jobs_flag,
              emit_flags,
+             profile_flags,
+             time_trace_flag,
+             debug_point_flags,
              trace_flags);
     return system(cmd);
 }
@@ -1236,12 +1473,23 @@ void cmd_run(const CompilerFlags *flags) {
     printf("╭─ Run %s\n╰", bi.pkg_name);
     fflush(stdout);
 
+    /* With --bc the compiler runs the main module on the bytecode VM
+       and links nothing when it lowers, so a missing executable after
+       the build means the program has already run.                  */
+    if (flags->run_bytecode) remove(bi.out_path);
+
     int rc = do_build(&bi, flags);
     if (rc != 0) {
         printf("─ failed\n");
         build_info_free(&bi); exit(1);
     }
 
+    if (flags->run_bytecode && access(bi.out_path, F_OK) != 0) {
+        printf("\n");
+        build_info_free(&bi);
+        exit(0);
+    }
+
     /* compile() already printed [done] ./build/exe with no newline.
        We print the connecting line immediately after on the same line,
        then the program output follows on the next line.             */
@@ -1308,7 +1556,8 @@ void cmd_clean(void) {
     clean_ext_in_dir(src_full, ".o");
     clean_ext_in_dir(src_full, ".ll");
     clean_ext_in_dir(src_full, ".s");
-    printf("│  removed *.o *.ll *.s from %s/\n", bi.src_dirs);
+    clean_ext_in_dir(src_full, ".moni");
+    printf("│  removed *.o *.ll *.s *.moni from %s/\n", bi.src_dirs);
 
     printf("╰─ \x1b[32m✓\x1b[0m done\n");
 
@@ -1466,6 +1715,38 @@ void cmd_lsp(void) {
     exit(rc);
 }
 
+void cmd_bench(const CompilerFlags *flags) {
+    const char *script = "bench/main.py";
+    if (access(script, F_OK) != 0) {
+        fprintf(stderr, "monad bench: %s not found; run it from the repository root\n", script);
+        exit(2);
+    }
+
+    char self[1024] = {0};
+    host_self_path(self, sizeof(self));
+
+    char cmd[8192];
+    char quoted[2048];
+    size_t used = (size_t)snprintf(cmd, sizeof(cmd), "python3 %s", script);
+    if (self[0] && shell_quote_arg(self, quoted, sizeof(quoted)))
+        used += (size_t)snprintf(cmd + used, sizeof(cmd) - used, " --monad %s", quoted);
+    for (int i = 0; i < flags->bench_argc; i++) {
+        if (!shell_quote_arg(flags->bench_argv[i], quoted, sizeof(quoted)) ||
+            used + strlen(quoted) + 2 > sizeof(cmd)) {
+            fprintf(stderr, "monad bench: argument too long: %s\n", flags->bench_argv[i]);
+            exit(2);
+        }
+        used += (size_t)snprintf(cmd + used, sizeof(cmd) - used, " %s", quoted);
+    }
+
+    /* The harness exits 1 on a failure or regression and 2 on bad usage;
+       keep that status so scripts and CI can tell them apart. */
+    int rc = system(cmd);
+    if (host_system_success(rc)) exit(0);
+    int code = host_system_exit_code(rc);
+    exit(code > 0 ? code : 1);
+}
+
 void cmd_test(const CompilerFlags *flags) {
     const char *input_file = flags ? flags->input_file : NULL;
     if (!input_file) {
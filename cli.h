@@ -15,8 +15,17 @@ typedef enum {
     CMD_LSP,
     CMD_EVAL,
     CMD_DEBUG,
+    CMD_PRELUDE,
+    CMD_BENCH,
+    CMD_DAEMON,
 } CommandMode;
 
+typedef enum {
+    LTO_OFF,
+    LTO_THIN,            // per-module summaries, parallel link-time backend
+    LTO_FULL,            // one merged module at link time
+} LtoMode;
+
 typedef struct {
     CommandMode mode;
     bool emit_ir;
@@ -33,7 +42,18 @@ typedef struct {
     bool bytecode_trace;
     bool bytecode_baseline_jit;
     bool jit;
+    bool run_bytecode;   // --bc: run the main module on the bytecode VM when it lowers
     int optimization_level;
+    int jobs;            // object-emission threads; 0 = one per CPU
+    LtoMode lto;         // emit bitcode and optimize across modules at link
+    char *target_cpu;    // -mcpu=; NULL = "generic", "native" = the host CPU
+    bool time_passes;    // report LLVM pass and codegen timings per module
+    char *time_trace;    // --time-trace[=FILE]: phase trace path, "" = beside the input
+    bool report_escapes; // report closures/arg arrays demoted to the stack
+    bool report_tail_calls; // list recursive calls left outside tail position
+    bool profile_sites;  // record source spans for MONAD_PROF=alloc
+    bool profile_generate; // instrument for PGO; the program writes default.profraw
+    char *profile_use;     // .profdata (or .profraw) that drives PGO, or NULL
     int verbose_level;
     bool trace_ast;
     bool trace_semantic;
@@ -44,9 +64,16 @@ typedef struct {
     int debug_target_fps;
     int debug_blink_ms;
     int debug_blink_count;
+    char **breakpoints;  // --break [FILE:]LINE[ if COND], compiled into the program
+    int breakpoint_count;
+    char **watches;      // --watch NAME: hardware watchpoint on a top-level variable
+    int watch_count;
     bool start_repl;    bool test_mode;      // emit test blocks
     bool test_run;       // run and delete test binary (monad test)
     char *test_suite;
+    int bench_argc;      // arguments after `monad bench`, passed to bench/main.py
+    char **bench_argv;
+    char *daemon_action; // run | start | stop | status (monad daemon)
     char *output_name;
     char *input_file;
     char *eval_code;
@@ -67,4 +94,6 @@ void cmd_check(const char *input_file);
 void cmd_lsp(void);
 void cmd_eval(const char *code);
 void cmd_debug(const CompilerFlags *flags);
+void cmd_prelude(const CompilerFlags *flags);
+void cmd_bench(const CompilerFlags *flags);
 #endif
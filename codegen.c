@@ -14,6 +14,8 @@
 #include "infer.h"
 #include "typeclass.h"
 #include "pmatch.h"
+#include "intern.h"
+#include "time_trace.h"
 #include <ctype.h>
 #include <math.h>
 #include <llvm-c/Core.h>
@@ -36,6 +38,7 @@ static LLVMValueRef emit_call_2(CodegenContext *ctx, LLVMValueRef fn, LLVMTypeRe
 static LLVMValueRef emit_call_3(CodegenContext *ctx, LLVMValueRef fn, LLVMTypeRef ret_t, LLVMValueRef a1, LLVMValueRef a2, LLVMValueRef a3, const char *name);
 static void emit_runtime_error_val(CodegenContext *ctx, AST *ast, LLVMValueRef msg_val);
 static void emit_runtime_error(CodegenContext *ctx, AST *ast, const char *msg);
+static LLVMValueRef emit_value_tag(CodegenContext *ctx, LLVMValueRef val, const char *name);
 
 static bool g_codegen_trace_enabled = false;
 
@@ -43,6 +46,279 @@ void codegen_set_trace(bool enabled) {
     g_codegen_trace_enabled = enabled;
 }
 
+/// Profile sites (--profile-sites)
+//
+//  Before each call to a runtime declaration, store a pointer to a
+//  constant RtProfSite for the innermost list form being compiled into
+//  the thread-local __monad_prof_site, so MONAD_PROF=alloc can charge the
+//  allocations that call makes to a source span.  The store goes before
+//  the call, never between it and a return, so tail calls stay tail
+//  calls.  Every LLVMBuildCall2 in this file goes through codegen_call2.
+
+static bool        g_codegen_profile_sites = false;
+static int         g_site_line, g_site_col;
+static const char *g_site_fn;
+
+void codegen_set_profile_sites(bool enabled) {
+    g_codegen_profile_sites = enabled;
+}
+
+static LLVMValueRef codegen_site_global(LLVMModuleRef mod, LLVMBuilderRef b) {
+    char name[64];
+    snprintf(name, sizeof(name), "__monad_site.%d.%d", g_site_line, g_site_col);
+    LLVMValueRef site = LLVMGetNamedGlobal(mod, name);
+    if (site) return site;
+
+    LLVMContextRef llctx = LLVMGetModuleContext(mod);
+    LLVMTypeRef    ptr_t = LLVMPointerType(LLVMInt8TypeInContext(llctx), 0);
+    LLVMTypeRef    i32_t = LLVMInt32TypeInContext(llctx);
+    LLVMValueRef   file  = LLVMGetNamedGlobal(mod, "__monad_site_file");
+    if (!file) {
+        file = LLVMBuildGlobalString(b, parser_get_filename(), "__monad_site_file");
+        LLVMSetLinkage(file, LLVMPrivateLinkage);
+    }
+    LLVMValueRef fn = g_site_fn
+        ? LLVMConstBitCast(LLVMBuildGlobalString(b, g_site_fn, "site_fn"), ptr_t)
+        : LLVMConstNull(ptr_t);
+    LLVMValueRef fields[] = {
+        LLVMConstBitCast(file, ptr_t),
+        fn,
+        LLVMConstInt(i32_t, (unsigned long long)g_site_line, 0),
+        LLVMConstInt(i32_t, (unsigned long long)g_site_col, 0),
+    };
+    LLVMValueRef init = LLVMConstStructInContext(llctx, fields, 4, 0);
+    site = LLVMAddGlobal(mod, LLVMTypeOf(init), name);
+    LLVMSetInitializer(site, init);
+    LLVMSetGlobalConstant(site, 1);
+    LLVMSetLinkage(site, LLVMPrivateLinkage);
+    return site;
+}
+
+static LLVMValueRef codegen_call2(LLVMBuilderRef b, LLVMTypeRef fn_t, LLVMValueRef fn,
+                                  LLVMValueRef *args, unsigned n, const char *name) {
+    LLVMBasicBlockRef bb;
+    if (g_codegen_profile_sites && g_site_line > 0 && LLVMIsAFunction(fn) &&
+        LLVMIsDeclaration(fn) && strncmp(LLVMGetValueName(fn), "rt_", 3) == 0 &&
+        (bb = LLVMGetInsertBlock(b)) && !LLVMGetBasicBlockTerminator(bb)) {
+        LLVMModuleRef mod = LLVMGetGlobalParent(fn);
+        LLVMTypeRef   ptr_t = LLVMPointerType(
+            LLVMInt8TypeInContext(LLVMGetModuleContext(mod)), 0);
+        LLVMValueRef  slot  = LLVMGetNamedGlobal(mod, "__monad_prof_site");
+        if (!slot) {
+            slot = LLVMAddGlobal(mod, ptr_t, "__monad_prof_site");
+            LLVMSetThreadLocal(slot, 1);
+            LLVMSetLinkage(slot, LLVMExternalLinkage);
+        }
+        LLVMBuildStore(b, LLVMConstBitCast(codegen_site_global(mod, b), ptr_t), slot);
+    }
+    return LLVMBuildCall2(b, fn_t, fn, args, n, name);
+}
+
+#define LLVMBuildCall2 codegen_call2
+
+/// Breakpoints and watchpoints (--break, --watch)
+//
+//  A breakpoint is compiled into the program rather than planted by a
+//  debugger: the first list form that starts on the breakpoint's line gets
+//  its condition evaluated in place, in that form's scope, and a branch to
+//  a cold block that calls rt_debug_break.  A false condition costs a
+//  compare and a not-taken branch.  Forms nested in the instrumented one,
+//  and later forms on the same line of the same function, are left alone.
+//
+//  A watch registers the address of a top-level variable with
+//  rt_debug_watch right after its definition stores the initial value;
+//  the runtime arms a hardware watchpoint on it.
+
+typedef struct {
+    char        *file;      // NULL = any file
+    int          line;
+    char        *cond_src;  // NULL = unconditional
+    AST         *cond;
+    LLVMValueRef last_fn;   // function last instrumented for this line
+} CodegenBreakpoint;
+
+static CodegenBreakpoint g_breakpoints[RT_DEBUG_MAX_POINTS];
+static int               g_breakpoint_count;
+static char             *g_watches[RT_DEBUG_MAX_POINTS];
+static int               g_watch_count;
+static int               g_break_open_line;     // line of the form being instrumented
+static bool              g_break_in_condition;  // compiling a condition
+
+static char *trim_dup(const char *start, const char *end) {
+    while (start < end && isspace((unsigned char)*start)) start++;
+    while (end > start && isspace((unsigned char)end[-1])) end--;
+    return strndup(start, (size_t)(end - start));
+}
+
+bool codegen_add_breakpoint(const char *spec, const char *default_file) {
+    if (g_breakpoint_count >= RT_DEBUG_MAX_POINTS) {
+        fprintf(stderr, "error: at most %d breakpoints\n", RT_DEBUG_MAX_POINTS);
+        return false;
+    }
+    const char *cond = strstr(spec, " if ");
+    const char *where_end = cond ? cond : spec + strlen(spec);
+    char *where = trim_dup(spec, where_end);
+    char *colon = strrchr(where, ':');
+    const char *line_text = colon ? colon + 1 : where;
+    char *end = NULL;
+    long line = strtol(line_text, &end, 10);
+    if (!*line_text || *end || line <= 0 || line > INT32_MAX || (colon && colon == where)) {
+        fprintf(stderr, "error: --break expects [FILE:]LINE[ if COND], got '%s'\n", spec);
+        free(where);
+        return false;
+    }
+
+    CodegenBreakpoint *bp = &g_breakpoints[g_breakpoint_count];
+    memset(bp, 0, sizeof(*bp));
+    bp->line = (int)line;
+    if (colon) bp->file = strndup(where, (size_t)(colon - where));
+    else if (default_file) bp->file = strdup(default_file);
+    free(where);
+    if (cond) {
+        bp->cond_src = trim_dup(cond + 4, cond + strlen(cond));
+        const char *filename = parser_get_filename();
+        parser_set_context("<break>", bp->cond_src);
+        bp->cond = parse(bp->cond_src);
+        parser_set_context(filename, NULL);
+        if (!bp->cond) {
+            fprintf(stderr, "error: --break condition '%s' does not parse\n", bp->cond_src);
+            free(bp->file);
+            free(bp->cond_src);
+            return false;
+        }
+    }
+    g_breakpoint_count++;
+    return true;
+}
+
+bool codegen_add_watch(const char *name) {
+    if (g_watch_count >= RT_DEBUG_MAX_POINTS) {
+        fprintf(stderr, "error: at most %d watches\n", RT_DEBUG_MAX_POINTS);
+        return false;
+    }
+    g_watches[g_watch_count++] = strdup(name);
+    return true;
+}
+
+void codegen_clear_debug_points(void) {
+    for (int i = 0; i < g_breakpoint_count; i++) {
+        free(g_breakpoints[i].file);
+        free(g_breakpoints[i].cond_src);
+        if (g_breakpoints[i].cond) ast_free(g_breakpoints[i].cond);
+    }
+    for (int i = 0; i < g_watch_count; i++) free(g_watches[i]);
+    g_breakpoint_count = g_watch_count = 0;
+    g_break_open_line = 0;
+    g_break_in_condition = false;
+}
+
+static const char *skip_dot_slash(const char *path) {
+    while (path[0] == '.' && path[1] == '/') path += 2;
+    return path;
+}
+
+// "Main.mon" matches "src/Main.mon" and the other way round, but not
+// "OtherMain.mon": the shorter path must be a whole-component suffix.
+static bool breakpoint_file_matches(const char *want, const char *have) {
+    if (!want) return true;
+    if (!have) return false;
+    want = skip_dot_slash(want);
+    have = skip_dot_slash(have);
+    size_t wl = strlen(want), hl = strlen(have);
+    const char *longer  = wl >= hl ? want : have;
+    const char *shorter = wl >= hl ? have : want;
+    size_t ll = wl >= hl ? wl : hl, sl = wl >= hl ? hl : wl;
+    return strcmp(longer + ll - sl, shorter) == 0 &&
+           (ll == sl || longer[ll - sl - 1] == '/');
+}
+
+static void codegen_breakpoint_check(CodegenContext *ctx, AST *ast) {
+    if (g_break_in_condition || g_break_open_line == ast->line) return;
+    LLVMBasicBlockRef bb = LLVMGetInsertBlock(ctx->builder);
+    if (!bb || LLVMGetBasicBlockTerminator(bb)) return;
+    LLVMValueRef fn = LLVMGetBasicBlockParent(bb);
+
+    for (int id = 0; id < g_breakpoint_count; id++) {
+        CodegenBreakpoint *bp = &g_breakpoints[id];
+        if (bp->line != ast->line || bp->last_fn == fn ||
+            !breakpoint_file_matches(bp->file, parser_get_filename()))
+            continue;
+        bp->last_fn = fn;
+
+        LLVMBasicBlockRef hit  = LLVMAppendBasicBlockInContext(ctx->context, fn, "break.hit");
+        LLVMBasicBlockRef cont = LLVMAppendBasicBlockInContext(ctx->context, fn, "break.cont");
+        if (bp->cond) {
+            g_break_in_condition = true;
+            CodegenResult r = codegen_expr(ctx, ast_clone(bp->cond));
+            g_break_in_condition = false;
+            LLVMTypeRef  i1 = LLVMInt1TypeInContext(ctx->context);
+            LLVMValueRef holds = r.value;
+            if (LLVMTypeOf(holds) == LLVMPointerTypeInContext(ctx->context, 0))
+                holds = emit_call_1(ctx, get_rt_unbox_int(ctx),
+                                    LLVMInt64TypeInContext(ctx->context), holds, "break_unbox");
+            if (LLVMTypeOf(holds) != i1)
+                holds = LLVMBuildICmp(ctx->builder, LLVMIntNE, holds,
+                                      LLVMConstNull(LLVMTypeOf(holds)), "break_cond");
+            LLVMBuildCondBr(ctx->builder, holds, hit, cont);
+        } else {
+            LLVMBuildBr(ctx->builder, hit);
+        }
+
+        LLVMPositionBuilderAtEnd(ctx->builder, hit);
+        int         line = g_site_line, col = g_site_col;
+        const char *site_fn = g_site_fn;
+        g_site_line = ast->line;
+        g_site_col  = ast->column;
+        g_site_fn   = ctx->current_function_name;
+        LLVMValueRef site = codegen_site_global(ctx->module, ctx->builder);
+        g_site_line = line;
+        g_site_col  = col;
+        g_site_fn   = site_fn;
+
+        LLVMValueRef rt_break = get_rt_debug_break(ctx);
+        unsigned cold = LLVMGetEnumAttributeKindForName("cold", 4);
+        if (!LLVMGetEnumAttributeAtIndex(rt_break, LLVMAttributeFunctionIndex, cold))
+            LLVMAddAttributeAtIndex(rt_break, LLVMAttributeFunctionIndex,
+                                    LLVMCreateEnumAttribute(ctx->context, cold, 0));
+        LLVMValueRef args[] = {
+            LLVMConstInt(LLVMInt32TypeInContext(ctx->context), (unsigned long long)id, 0),
+            site,
+        };
+        LLVMBuildCall2(ctx->builder, LLVMGlobalGetValueType(rt_break), rt_break, args, 2, "");
+        LLVMBuildBr(ctx->builder, cont);
+        LLVMPositionBuilderAtEnd(ctx->builder, cont);
+    }
+}
+
+static void codegen_watch_define(CodegenContext *ctx, const char *name, LLVMValueRef var) {
+    int id = 0;
+    while (id < g_watch_count && strcmp(g_watches[id], name) != 0) id++;
+    if (id == g_watch_count) return;
+
+    LLVMTypeRef ty = LLVMGlobalGetValueType(var);
+    int64_t size;
+    int32_t kind;
+    switch (LLVMGetTypeKind(ty)) {
+    case LLVMIntegerTypeKind: size = (LLVMGetIntTypeWidth(ty) + 7) / 8; kind = RT_WATCH_INT;   break;
+    case LLVMDoubleTypeKind:  size = 8;                                 kind = RT_WATCH_FLOAT; break;
+    case LLVMFloatTypeKind:   size = 4;                                 kind = RT_WATCH_FLOAT; break;
+    case LLVMPointerTypeKind: size = 8;                                 kind = RT_WATCH_PTR;   break;
+    default:
+        fprintf(stderr, "warning: --watch %s: only scalar variables can be watched\n", name);
+        return;
+    }
+
+    LLVMValueRef rt_watch = get_rt_debug_watch(ctx);
+    LLVMValueRef args[] = {
+        LLVMConstInt(LLVMInt32TypeInContext(ctx->context), (unsigned long long)id, 0),
+        LLVMBuildGlobalStringPtr(ctx->builder, name, "watch_name"),
+        var,
+        LLVMConstInt(LLVMInt64TypeInContext(ctx->context), (unsigned long long)size, 0),
+        LLVMConstInt(LLVMInt32TypeInContext(ctx->context), (unsigned long long)kind, 0),
+    };
+    LLVMBuildCall2(ctx->builder, LLVMGlobalGetValueType(rt_watch), rt_watch, args, 5, "");
+}
+
 void monad_repl_global_getter_name(const char *global_name, char *buf, size_t buf_size) {
     if (!buf || buf_size == 0) return;
     const char *name = (global_name && *global_name) ? global_name : "anon";
@@ -76,18 +352,26 @@ static bool codegen_ast_is_undefined_expr(AST *ast) {
            strcmp(ast->list.items[0]->symbol, "undefined") == 0;
 }
 
-static void emit_bounds_check(CodegenContext *ctx, AST *ast, LLVMValueRef idx, LLVMValueRef size, const char *err_msg) {
-    LLVMValueRef ge_zero = LLVMBuildICmp(ctx->builder, LLVMIntSGE, idx, LLVMConstInt(LLVMInt64TypeInContext(ctx->context), 0, 0), "ge_z");
-    LLVMValueRef lt_size = LLVMBuildICmp(ctx->builder, LLVMIntSLT, idx, size, "lt_s");
-    LLVMValueRef in_bounds = LLVMBuildAnd(ctx->builder, ge_zero, lt_size, "in_bounds");
+/* Branch to a runtime error unless `ok` holds; codegen continues in the ok block. */
+static void emit_runtime_check(CodegenContext *ctx, AST *ast, LLVMValueRef ok, const char *err_msg) {
     LLVMBasicBlockRef ok_bb = LLVMAppendBasicBlockInContext(ctx->context, LLVMGetBasicBlockParent(LLVMGetInsertBlock(ctx->builder)), "ok");
     LLVMBasicBlockRef err_bb = LLVMAppendBasicBlockInContext(ctx->context, LLVMGetBasicBlockParent(LLVMGetInsertBlock(ctx->builder)), "err");
-    LLVMBuildCondBr(ctx->builder, in_bounds, ok_bb, err_bb);
+    LLVMBuildCondBr(ctx->builder, ok, ok_bb, err_bb);
     LLVMPositionBuilderAtEnd(ctx->builder, err_bb);
     emit_runtime_error(ctx, ast, err_msg);
     LLVMPositionBuilderAtEnd(ctx->builder, ok_bb);
 }
 
+static LLVMValueRef emit_in_bounds(CodegenContext *ctx, LLVMValueRef idx, LLVMValueRef size) {
+    LLVMValueRef ge_zero = LLVMBuildICmp(ctx->builder, LLVMIntSGE, idx, LLVMConstInt(LLVMInt64TypeInContext(ctx->context), 0, 0), "ge_z");
+    LLVMValueRef lt_size = LLVMBuildICmp(ctx->builder, LLVMIntSLT, idx, size, "lt_s");
+    return LLVMBuildAnd(ctx->builder, ge_zero, lt_size, "in_bounds");
+}
+
+static void emit_bounds_check(CodegenContext *ctx, AST *ast, LLVMValueRef idx, LLVMValueRef size, const char *err_msg) {
+    emit_runtime_check(ctx, ast, emit_in_bounds(ctx, idx, size), err_msg);
+}
+
 static LLVMValueRef emit_type_cast(CodegenContext *ctx, LLVMValueRef val, LLVMTypeRef dst_t) {
     LLVMTypeRef src_t = LLVMTypeOf(val);
     if (src_t == dst_t) return val;
@@ -146,14 +430,6 @@ void codegen_init(CodegenContext *ctx, const char *module_name) {
     ctx->is_top_level = false;
     ctx->init_fn = NULL;
     ctx->top_level_fn = NULL;
-    // Initialize format strings to NULL - will be created lazily
-    ctx->fmt_str   = NULL;
-    ctx->fmt_char  = NULL;
-    ctx->fmt_int   = NULL;
-    ctx->fmt_float = NULL;
-    ctx->fmt_hex   = NULL;
-    ctx->fmt_bin   = NULL;
-    ctx->fmt_oct   = NULL;
     ctx->error_jmp_set = false;
     ctx->ffi = NULL;
     ctx->test_mode = false;
@@ -162,6 +438,7 @@ void codegen_init(CodegenContext *ctx, const char *module_name) {
     ctx->tail_position = false;
     ctx->current_closure_abi = false;
     ctx->current_closure_param_count = 0;
+    ctx->loop = NULL;
     // Initialize monomorphization cache
     ctx->mono_cache.entries  = NULL;
     ctx->mono_cache.count    = 0;
@@ -172,6 +449,22 @@ void codegen_init(CodegenContext *ctx, const char *module_name) {
 
 /// Monomorphization
 
+// Each polymorphic function gets at most this many specialized clones
+// (MONAD_MONO_LIMIT overrides it).  Call sites beyond the budget use the
+// generic definition, so code size stays bounded however many instance
+// types a program touches.
+#define MONO_SPECIALIZATION_LIMIT 64
+
+static int mono_specialization_limit(void) {
+    static int limit = -1;
+    if (limit < 0) {
+        const char *v = getenv("MONAD_MONO_LIMIT");
+        limit = v && *v ? atoi(v) : MONO_SPECIALIZATION_LIMIT;
+        if (limit < 0) limit = 0;
+    }
+    return limit;
+}
+
 static bool mono_types_match(Type **a, Type **b, int count) {
     for (int i = 0; i < count; i++) {
         if (!a[i] || !b[i]) return false;
@@ -192,6 +485,13 @@ LLVMValueRef mono_cache_lookup(MonoCache *cache, const char *fn_name,
     return NULL;
 }
 
+static int mono_cache_count(MonoCache *cache, const char *fn_name) {
+    int n = 0;
+    for (int i = 0; i < cache->count; i++)
+        if (strcmp(cache->entries[i].key.fn_name, fn_name) == 0) n++;
+    return n;
+}
+
 void mono_cache_insert(MonoCache *cache, const char *fn_name,
                         Type **type_args, int type_arg_count,
                         LLVMValueRef fn, const char *specialized_name) {
@@ -934,6 +1234,106 @@ static const char *codegen_projection_symbol(AST *expr) {
     return NULL;
 }
 
+//// Worker/wrapper
+
+// Parameter and result types a closure-ABI worker passes raw.  Char stays
+// boxed: its box is not an Int box, and the unboxing helpers differ.
+static bool codegen_type_is_unboxed_scalar(Type *t) {
+    if (!t || t->kind == TYPE_CHAR) return false;
+    return type_is_integer(t) || type_is_float(t) || t->kind == TYPE_BOOL;
+}
+
+static bool codegen_closure_wants_worker(AST *lambda, EnvParam *params, int n,
+                                         Env *outer, char **captured,
+                                         int captured_count) {
+    if (n == 0 || lambda->lambda.naked) return false;
+    if (lambda->lambda.body && lambda->lambda.body->type == AST_ASM) return false;
+    for (int i = 0; i < n; i++)
+        if (lambda->lambda.params[i].is_rest ||
+            !codegen_type_is_unboxed_scalar(params[i].type))
+            return false;
+    /* A captured closure called in tail position reuses the caller's args
+     * array (tail_clo_call), which a worker does not have. */
+    for (int i = 0; i < captured_count; i++) {
+        EnvEntry *e = env_lookup(outer, captured[i]);
+        Type     *t = e ? e->type : NULL;
+        if (!t || t->kind == TYPE_FN || t->kind == TYPE_ARROW ||
+            t->kind == TYPE_UNKNOWN || t->kind == TYPE_VAR)
+            return false;
+    }
+    return true;
+}
+
+static bool codegen_worker_callable(CodegenContext *ctx, EnvEntry *entry) {
+    return entry && entry->worker_ref &&
+           LLVMGetGlobalParent(entry->worker_ref) == ctx->module;
+}
+
+// Calls the unboxed worker behind `entry` with the closure environment
+// `env`, coercing each argument to the worker's parameter type instead of
+// boxing it into an args array.
+static CodegenResult codegen_call_worker(CodegenContext *ctx, EnvEntry *entry,
+                                         LLVMValueRef env, AST **args, int n) {
+    LLVMValueRef  worker = entry->worker_ref;
+    LLVMTypeRef   ft     = LLVMGlobalGetValueType(worker);
+    LLVMValueRef *vals   = malloc(sizeof(LLVMValueRef) * (n + 1));
+    bool saved_tail = ctx->tail_position;
+    ctx->tail_position = false;
+    vals[0] = env;
+    for (int i = 0; i < n; i++) {
+        CodegenResult ar = codegen_expr(ctx, args[i]);
+        vals[i + 1] = emit_type_cast(ctx, ar.value,
+                                     LLVMTypeOf(LLVMGetParam(worker, i + 1)));
+    }
+    ctx->tail_position = saved_tail;
+
+    /* The tail_clo_call prefix lets codegen_mark_direct_tail_return turn a
+     * directly returned self-call into a musttail call. */
+    CodegenResult r;
+    r.value = LLVMBuildCall2(ctx->builder, ft, worker, vals, n + 1,
+                             saved_tail ? "tail_clo_call_worker" : "worker_call");
+    r.type  = LLVMGetTypeKind(LLVMGetReturnType(ft)) == LLVMPointerTypeKind
+            ? type_unknown()
+            : type_clone(entry->return_type);
+    free(vals);
+    return r;
+}
+
+// Binds a closure-ABI function's own name inside its body to a closure over
+// `fn` and the current environment, so recursive references see captures.
+// Returns the store that initializes the binding.
+static LLVMValueRef codegen_closure_bind_self(CodegenContext *ctx, LLVMValueRef fn,
+                                              LLVMValueRef worker, LLVMValueRef env,
+                                              const char *name, int captured_count,
+                                              EnvParam *params, int param_count,
+                                              Type *ret_type) {
+    LLVMTypeRef  ptr_t  = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMValueRef fn_ptr = LLVMBuildBitCast(ctx->builder, fn, ptr_t, "fn_ptr");
+    LLVMTypeRef  i32t   = LLVMInt32TypeInContext(ctx->context);
+    LLVMValueRef clo_fn = get_rt_value_closure(ctx);
+    LLVMTypeRef  clo_params[] = {ptr_t, ptr_t, i32t, i32t};
+    LLVMTypeRef  clo_ft = LLVMFunctionType(ptr_t, clo_params, 4, 0);
+    LLVMValueRef clo_args[] = {
+        fn_ptr, env,
+        LLVMConstInt(i32t, captured_count, 0),
+        LLVMConstInt(i32t, param_count, 0)
+    };
+    LLVMValueRef self_clo    = LLVMBuildCall2(ctx->builder, clo_ft, clo_fn, clo_args, 4, "self_clo");
+    LLVMValueRef self_alloca = LLVMBuildAlloca(ctx->builder, ptr_t, name);
+    LLVMValueRef store       = LLVMBuildStore(ctx->builder, self_clo, self_alloca);
+    env_insert(ctx->env, name, type_fn(NULL, 0, NULL), self_alloca);
+    EnvEntry *clo_var = env_lookup(ctx->env, name);
+    if (clo_var) {
+        clo_var->func_ref       = fn;
+        clo_var->worker_ref     = worker;
+        clo_var->is_closure_abi = true;
+        clo_var->param_count    = param_count;
+        clo_var->params         = clone_params(params, param_count);
+        clo_var->return_type    = type_clone(ret_type);
+    }
+    return store;
+}
+
 //// Specialization
 
 // Recompile a polymorphic function with concrete types substituted in.
@@ -958,8 +1358,9 @@ static LLVMValueRef codegen_specialize(CodegenContext *ctx,
     // Check if already in current LLVM module
     LLVMValueRef existing = LLVMGetNamedFunction(ctx->module, spec_name);
     if (existing) {
-        mono_cache_insert(&ctx->mono_cache, fn_name, concrete, ts->count,
-                          existing, spec_name);
+        if (!mono_cache_lookup(&ctx->mono_cache, fn_name, concrete, ts->count))
+            mono_cache_insert(&ctx->mono_cache, fn_name, concrete, ts->count,
+                              existing, spec_name);
         free(spec_name);
         free(concrete);
         return existing;
@@ -990,6 +1391,13 @@ static LLVMValueRef codegen_specialize(CodegenContext *ctx,
         return cached;
     }
 
+    // Over budget: the caller falls back to the generic definition.
+    if (mono_cache_count(&ctx->mono_cache, fn_name) >= mono_specialization_limit()) {
+        free(spec_name);
+        free(concrete);
+        return NULL;
+    }
+
     // Get the source AST — must be a (define (name params) body) form
     AST *source = entry->source_ast;
     if (!source) {
@@ -1281,26 +1689,29 @@ static LLVMValueRef codegen_specialize(CodegenContext *ctx,
     return func;
 }
 
-static LLVMValueRef get_or_build_fmt(CodegenContext *ctx, LLVMValueRef *cache, const char *fmt, const char *name) {
-    if (cache && !*cache) *cache = LLVMBuildGlobalStringPtr(ctx->builder, fmt, name);
-    return cache ? *cache : LLVMBuildGlobalStringPtr(ctx->builder, fmt, name);
+static LLVMValueRef get_or_build_fmt(CodegenContext *ctx, CodegenFmt which, const char *fmt, const char *name) {
+    if (ctx->cache_module != ctx->module) declare_runtime_functions(ctx);
+    if (!ctx->fmt[which]) ctx->fmt[which] = LLVMBuildGlobalStringPtr(ctx->builder, fmt, name);
+    return ctx->fmt[which];
 }
 
-LLVMValueRef get_fmt_str             (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_str,   "%s\n",    "fmt_str"     ); }
-LLVMValueRef get_fmt_char            (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_char,  "%c\n",    "fmt_char"    ); }
-LLVMValueRef get_fmt_int             (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_int,   "%ld\n",   "fmt_int"     ); }
-LLVMValueRef get_fmt_float           (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_float, "%.16g\n", "fmt_float"   ); }
-LLVMValueRef get_fmt_hex             (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_hex,   "0x%lX\n", "fmt_hex"     ); }
-LLVMValueRef get_fmt_oct             (CodegenContext *ctx) { return get_or_build_fmt(ctx, &ctx->fmt_oct,   "0o%lo\n", "fmt_oct"     ); }
-LLVMValueRef get_fmt_str_no_newline  (CodegenContext *ctx) { return get_or_build_fmt(ctx, NULL,            "%s",      "fmt_str_nn"  ); }
-LLVMValueRef get_fmt_char_no_newline (CodegenContext *ctx) { return get_or_build_fmt(ctx, NULL,            "%c",      "fmt_char_nn" ); }
-LLVMValueRef get_fmt_int_no_newline  (CodegenContext *ctx) { return get_or_build_fmt(ctx, NULL,            "%ld",     "fmt_int_nn"  ); }
-LLVMValueRef get_fmt_float_no_newline(CodegenContext *ctx) { return get_or_build_fmt(ctx, NULL,            "%.16g",   "fmt_float_nn"); }
+LLVMValueRef get_fmt_str             (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_STR,      "%s\n",    "fmt_str"     ); }
+LLVMValueRef get_fmt_char            (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_CHAR,     "%c\n",    "fmt_char"    ); }
+LLVMValueRef get_fmt_int             (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_INT,      "%ld\n",   "fmt_int"     ); }
+LLVMValueRef get_fmt_float           (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_FLOAT,    "%.16g\n", "fmt_float"   ); }
+LLVMValueRef get_fmt_hex             (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_HEX,      "0x%lX\n", "fmt_hex"     ); }
+LLVMValueRef get_fmt_oct             (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_OCT,      "0o%lo\n", "fmt_oct"     ); }
+LLVMValueRef get_fmt_str_no_newline  (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_STR_NN,   "%s",      "fmt_str_nn"  ); }
+LLVMValueRef get_fmt_char_no_newline (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_CHAR_NN,  "%c",      "fmt_char_nn" ); }
+LLVMValueRef get_fmt_int_no_newline  (CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_INT_NN,   "%ld",     "fmt_int_nn"  ); }
+LLVMValueRef get_fmt_float_no_newline(CodegenContext *ctx) { return get_or_build_fmt(ctx, CODEGEN_FMT_FLOAT_NN, "%.16g",   "fmt_float_nn"); }
 
 void codegen_dispose(CodegenContext *ctx) {
-    LLVMDisposeBuilder(ctx->builder);
-    LLVMDisposeModule(ctx->module);
-    LLVMContextDispose(ctx->context);
+    /* The module and context are NULL when they were handed off to the
+     * parallel object emitter (see emit_pool_submit in main.c). */
+    if (ctx->builder) LLVMDisposeBuilder(ctx->builder);
+    if (ctx->module)  LLVMDisposeModule(ctx->module);
+    if (ctx->context) LLVMContextDispose(ctx->context);
     mono_cache_free(&ctx->mono_cache);
     env_free(ctx->env);
     tc_registry_free(ctx->tc_registry);
@@ -1623,66 +2034,55 @@ static LLVMTypeRef get_arr_fat_type(CodegenContext *ctx) {
     return fat;
 }
 
-/* Wrap a stack-allocated [N x T]* into a heap-allocated fat pointer.
- * Returns an arr.fat* whose data field points to the stack array. */
-static LLVMValueRef arr_make_fat(CodegenContext *ctx,
-                                  LLVMValueRef stack_ptr,
-                                  int size,
-                                  Type *elem_type) {
+/* Heap-allocate a fat header over existing data.  Nothing is copied: the
+ * array aliases `data` for as long as whoever owns it keeps it alive. */
+static LLVMValueRef arr_wrap_fat(CodegenContext *ctx,
+                                 LLVMValueRef data,
+                                 LLVMValueRef n) {
     LLVMTypeRef fat_t = get_arr_fat_type(ctx);
     LLVMTypeRef i64_t = LLVMInt64TypeInContext(ctx->context);
     LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
 
-    /* Heap-allocate both the data and the fat struct so they survive
-     * across REPL modules and stack frames */
-    LLVMValueRef malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-    if (!malloc_fn) {
-        LLVMTypeRef ft = LLVMFunctionType(ptr_t, &i64_t, 1, 0);
-        malloc_fn = LLVMAddFunction(ctx->module, "malloc", ft);
-        LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-    }
-    LLVMValueRef memcpy_fn = LLVMGetNamedFunction(ctx->module, "memcpy");
-    if (!memcpy_fn) {
-        LLVMTypeRef p3[] = {ptr_t, ptr_t, i64_t};
-        LLVMTypeRef ft   = LLVMFunctionType(ptr_t, p3, 3, 0);
-        memcpy_fn = LLVMAddFunction(ctx->module, "memcpy", ft);
-        LLVMSetLinkage(memcpy_fn, LLVMExternalLinkage);
-    }
-
-    /* Allocate heap copy of the element data */
-    LLVMTypeRef  elem_llvm   = elem_type ? type_to_llvm(ctx, elem_type) : i64_t;
-    LLVMValueRef elem_size   = LLVMSizeOf(elem_llvm);
-    LLVMValueRef n           = LLVMConstInt(i64_t, size, 0);
-    LLVMValueRef data_bytes  = LLVMBuildMul(ctx->builder, elem_size, n, "data_bytes");
-    LLVMValueRef data_heap   = LLVMBuildCall2(ctx->builder,
-                                   LLVMFunctionType(ptr_t, &i64_t, 1, 0),
-                                   malloc_fn, &data_bytes, 1, "data_heap");
-    /* Copy stack data to heap */
-    LLVMValueRef src_ptr     = LLVMBuildBitCast(ctx->builder, stack_ptr, ptr_t, "src");
-    LLVMValueRef mc_args[]   = {data_heap, src_ptr, data_bytes};
-    LLVMBuildCall2(ctx->builder,
-        LLVMFunctionType(ptr_t, (LLVMTypeRef[]){ptr_t, ptr_t, i64_t}, 3, 0),
-        memcpy_fn, mc_args, 3, "");
-
-    /* Heap-allocate the fat struct */
     LLVMValueRef fat_size  = LLVMSizeOf(fat_t);
     LLVMValueRef fat_heap  = LLVMBuildCall2(ctx->builder,
                                  LLVMFunctionType(ptr_t, &i64_t, 1, 0),
-                                 malloc_fn, &fat_size, 1, "fat_heap");
+                                 get_rt_alloc(ctx), &fat_size, 1, "fat_heap");
     LLVMValueRef fat       = LLVMBuildBitCast(ctx->builder, fat_heap,
                                  LLVMPointerType(fat_t, 0), "fat_ptr");
 
     /* Store data pointer and size into fat struct */
     LLVMValueRef data_field = LLVMBuildStructGEP2(ctx->builder, fat_t, fat, 0, "data_field");
-    LLVMBuildStore(ctx->builder, data_heap, data_field);
+    LLVMBuildStore(ctx->builder, LLVMBuildBitCast(ctx->builder, data, ptr_t, "data_raw"),
+                   data_field);
 
     LLVMValueRef size_field = LLVMBuildStructGEP2(ctx->builder, fat_t, fat, 1, "size_field");
-    LLVMBuildStore(ctx->builder, LLVMConstInt(i64_t, size, 0), size_field);
-
+    LLVMBuildStore(ctx->builder, n, size_field);
     return fat;
 }
 
+/* Heap-allocate an uninitialised fat array of n elements.  Both the data
+ * and the fat struct come from rt_alloc so they survive across REPL
+ * modules and stack frames and stay visible to the collector.  The raw
+ * data pointer is returned through data_out. */
+static LLVMValueRef arr_alloc_fat(CodegenContext *ctx,
+                                  LLVMValueRef n,
+                                  Type *elem_type,
+                                  LLVMValueRef *data_out) {
+    LLVMTypeRef i64_t = LLVMInt64TypeInContext(ctx->context);
+    LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMValueRef malloc_fn = get_rt_alloc(ctx);
 
+    /* Element data */
+    LLVMTypeRef  elem_llvm   = elem_type ? type_to_llvm(ctx, elem_type) : i64_t;
+    LLVMValueRef elem_size   = LLVMSizeOf(elem_llvm);
+    LLVMValueRef data_bytes  = LLVMBuildMul(ctx->builder, elem_size, n, "data_bytes");
+    LLVMValueRef data_heap   = LLVMBuildCall2(ctx->builder,
+                                   LLVMFunctionType(ptr_t, &i64_t, 1, 0),
+                                   malloc_fn, &data_bytes, 1, "data_heap");
+
+    if (data_out) *data_out = data_heap;
+    return arr_wrap_fat(ctx, data_heap, n);
+}
 
 /* Extract data pointer from fat array, cast to elem_type* */
 LLVMValueRef arr_fat_data(CodegenContext *ctx,
@@ -1725,6 +2125,153 @@ static LLVMValueRef codegen_load_arr_fat_entry(CodegenContext *ctx, EnvEntry *en
 }
 
 
+/// Loop bounds checks
+//
+//  A counted `for` with step 1 visits exactly [start, end), so one test
+//  before the loop covers every (xs i) in its body: the per-read check
+//  becomes `in_range || (0 <= i < size)`, which LLVM unswitches out of
+//  the loop.  Reads are only recorded while neither i nor xs can change.
+
+/* Does `ast` assign, redefine or take the address of `name` anywhere,
+ * including inside nested lambdas? */
+static bool loop_name_is_written(AST *ast, const char *name) {
+    if (!ast) return false;
+    switch (ast->type) {
+    case AST_LIST:
+        if (ast->list.count >= 2 && ast->list.items[0]->type == AST_SYMBOL &&
+            ast->list.items[1]->type == AST_SYMBOL &&
+            (strcmp(ast->list.items[0]->symbol, "set!") == 0 ||
+             strcmp(ast->list.items[0]->symbol, "define") == 0) &&
+            strcmp(ast->list.items[1]->symbol, name) == 0)
+            return true;
+        for (size_t i = 0; i < ast->list.count; i++)
+            if (loop_name_is_written(ast->list.items[i], name))
+                return true;
+        return false;
+    case AST_ARRAY:
+        for (size_t i = 0; i < ast->array.element_count; i++)
+            if (loop_name_is_written(ast->array.elements[i], name))
+                return true;
+        return false;
+    case AST_LAMBDA:
+        for (int i = 0; i < ast->lambda.body_count; i++)
+            if (loop_name_is_written(ast->lambda.body_exprs[i], name))
+                return true;
+        return false;
+    case AST_ADDRESS_OF:
+        return ast->list.count > 0 && ast_contains_symbol(ast->list.items[0], name);
+    default:
+        return false;
+    }
+}
+
+/* Local, runtime-sized array bound to `name`, or NULL. */
+static EnvEntry *loop_local_array(CodegenContext *ctx, const char *name) {
+    EnvEntry *e = env_lookup(ctx->env, name);
+    if (!e || e->kind != ENV_VAR || !e->value || !type_arr_runtime_sized(e->type))
+        return NULL;
+    if (LLVMGetValueKind(e->value) == LLVMGlobalVariableValueKind)
+        return NULL;
+    return e;
+}
+
+/* Record every (xs var) read in `ast`.  Nested loops have frames of their
+ * own and lambdas are separate functions, so neither is entered. */
+static void loop_collect_sites(CodegenContext *ctx, AST *ast, const char *var,
+                               CodegenLoopSite **sites, int *count, int *cap) {
+    if (!ast) return;
+    if (ast->type == AST_ARRAY) {
+        for (size_t i = 0; i < ast->array.element_count; i++)
+            loop_collect_sites(ctx, ast->array.elements[i], var, sites, count, cap);
+        return;
+    }
+    if (ast->type != AST_LIST || ast->list.count == 0) return;
+
+    AST *head = ast->list.items[0];
+    if (head->type == AST_SYMBOL) {
+        if (strcmp(head->symbol, "for") == 0 || strcmp(head->symbol, "while") == 0)
+            return;
+        if (ast->list.count == 2 && ast->list.items[1]->type == AST_SYMBOL &&
+            strcmp(ast->list.items[1]->symbol, var) == 0 &&
+            strcmp(head->symbol, var) != 0) {
+            EnvEntry *arr = loop_local_array(ctx, head->symbol);
+            if (arr) {
+                if (*count == *cap) {
+                    *cap   = *cap ? *cap * 2 : 4;
+                    *sites = realloc(*sites, (size_t)*cap * sizeof(**sites));
+                }
+                (*sites)[(*count)++] = (CodegenLoopSite){ast, arr, NULL};
+                return;
+            }
+        }
+    }
+    for (size_t i = 0; i < ast->list.count; i++)
+        loop_collect_sites(ctx, ast->list.items[i], var, sites, count, cap);
+}
+
+/* Set up `loop` for the body of a step-1 `for` over [start, end).  Emits
+ * one range test per distinct array at the current insert point. */
+static void loop_enter(CodegenContext *ctx, CodegenLoop *loop, AST *for_ast,
+                       const char *var, LLVMValueRef var_ptr,
+                       LLVMValueRef start, LLVMValueRef end) {
+    memset(loop, 0, sizeof(*loop));
+    loop->var_ptr = var_ptr;
+    loop->outer   = ctx->loop;
+    ctx->loop     = loop;
+
+    for (size_t bi = 2; bi < for_ast->list.count; bi++)
+        if (loop_name_is_written(for_ast->list.items[bi], var))
+            return;
+
+    int cap = 0;
+    for (size_t bi = 2; bi < for_ast->list.count; bi++)
+        loop_collect_sites(ctx, for_ast->list.items[bi], var,
+                           &loop->sites, &loop->site_count, &cap);
+
+    LLVMTypeRef  i64  = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef zero = LLVMConstInt(i64, 0, 0);
+    int kept = 0;
+    for (int i = 0; i < loop->site_count; i++) {
+        CodegenLoopSite site = loop->sites[i];
+        for (int j = 0; j < kept && !site.in_range; j++)
+            if (loop->sites[j].array == site.array)
+                site.in_range = loop->sites[j].in_range;
+        if (!site.in_range) {
+            bool written = false;
+            for (size_t bi = 2; bi < for_ast->list.count && !written; bi++)
+                written = loop_name_is_written(for_ast->list.items[bi], site.array->name);
+            if (written) continue;
+            LLVMValueRef sz    = arr_fat_size(ctx, codegen_load_arr_fat_entry(ctx, site.array, "fat_sz"));
+            LLVMValueRef empty = LLVMBuildICmp(ctx->builder, LLVMIntSGE, start, end, "range_empty");
+            LLVMValueRef lo    = LLVMBuildICmp(ctx->builder, LLVMIntSGE, start, zero, "range_lo");
+            LLVMValueRef hi    = LLVMBuildICmp(ctx->builder, LLVMIntSLE, end, sz, "range_hi");
+            site.in_range = LLVMBuildOr(ctx->builder, empty,
+                                LLVMBuildAnd(ctx->builder, lo, hi, "range_fits"),
+                                "in_range");
+        }
+        loop->sites[kept++] = site;
+    }
+    loop->site_count = kept;
+}
+
+static void loop_leave(CodegenContext *ctx, CodegenLoop *loop) {
+    ctx->loop = loop->outer;
+    free(loop->sites);
+}
+
+/* Hoisted range test covering the read `ast` of `array`, or NULL. */
+static LLVMValueRef loop_hoisted_range(CodegenContext *ctx, AST *ast, EnvEntry *array) {
+    CodegenLoop *loop = ctx->loop;
+    if (!loop) return NULL;
+    for (int i = 0; i < loop->site_count; i++) {
+        CodegenLoopSite *site = &loop->sites[i];
+        if (site->read != ast || site->array != array) continue;
+        EnvEntry *var = env_lookup(ctx->env, ast->list.items[1]->symbol);
+        return (var && var->value == loop->var_ptr) ? site->in_range : NULL;
+    }
+    return NULL;
+}
+
 /// Type checking for operations
 
 bool type_is_numeric (Type *t) { return t && (t->kind == TYPE_INT   || t->kind == TYPE_FLOAT || t->kind == TYPE_HEX || t->kind == TYPE_BIN || t->kind == TYPE_OCT  || t->kind == TYPE_CHAR || t->kind == TYPE_BYTE || t->kind == TYPE_RATIO); }
@@ -1918,6 +2465,45 @@ char *mangle_unicode_name(const char *name) {
     return mangled;
 }
 
+/* resolve_symbol_with_modules asks for the `__alias_` spelling of every
+ * symbol it resolves, and the answer depends only on the name.  Keep it
+ * per interned name ("" when the name needs none) so a reference costs a
+ * probe instead of a scan, a malloc and a hex dump. */
+typedef struct { const char *name; const char *alias; } AliasMemo;
+
+static AliasMemo *g_alias_memo;
+static size_t     g_alias_memo_cap;
+static size_t     g_alias_memo_count;
+
+static const char *mangle_unicode_alias(const char *name) {
+    const char *key = intern(name);
+    if ((g_alias_memo_count + 1) * 10 > g_alias_memo_cap * 7) {
+        size_t     cap  = g_alias_memo_cap ? g_alias_memo_cap * 2 : 1024;
+        AliasMemo *memo = calloc(cap, sizeof(AliasMemo));
+        for (size_t i = 0; i < g_alias_memo_cap; i++) {
+            if (!g_alias_memo[i].name) continue;
+            size_t j = intern_hash(g_alias_memo[i].name) & (cap - 1);
+            while (memo[j].name) j = (j + 1) & (cap - 1);
+            memo[j] = g_alias_memo[i];
+        }
+        free(g_alias_memo);
+        g_alias_memo     = memo;
+        g_alias_memo_cap = cap;
+    }
+    size_t mask = g_alias_memo_cap - 1;
+    size_t i    = intern_hash(key) & mask;
+    while (g_alias_memo[i].name && g_alias_memo[i].name != key)
+        i = (i + 1) & mask;
+    if (!g_alias_memo[i].name) {
+        char *mangled = mangle_unicode_name(name);
+        g_alias_memo[i].name  = key;
+        g_alias_memo[i].alias = mangled ? intern(mangled) : "";
+        free(mangled);
+        g_alias_memo_count++;
+    }
+    return g_alias_memo[i].alias[0] ? g_alias_memo[i].alias : NULL;
+}
+
 // Helper: are we currently emitting into a top-level main function?
 // If yes, `define` should produce globals rather than stack allocas.
 static bool is_at_top_level(CodegenContext *ctx) {
@@ -1939,12 +2525,11 @@ static bool type_has_adt_constructors(CodegenContext *ctx, Type *type) {
     if (!lay_name) return false;
 
     for (size_t bi = 0; bi < ctx->env->size; bi++) {
-        for (EnvEntry *e = ctx->env->buckets[bi]; e; e = e->next) {
-            if (e->kind == ENV_ADT_CTOR && e->type &&
-                e->type->kind == TYPE_LAYOUT && e->type->layout_name &&
-                strcmp(e->type->layout_name, lay_name) == 0) {
-                return true;
-            }
+        EnvEntry *e = ctx->env->slots[bi];
+        if (e && e->kind == ENV_ADT_CTOR && e->type &&
+            e->type->kind == TYPE_LAYOUT && e->type->layout_name &&
+            strcmp(e->type->layout_name, lay_name) == 0) {
+            return true;
         }
     }
     return false;
@@ -2141,10 +2726,9 @@ static EnvEntry *resolve_symbol_with_modules(CodegenContext *ctx, const char *sy
     /* For non-ASCII names, try the mangled name first to get the entry
      * — the entry's func_ref still points to the real function         */
     {
-        char *mangled = mangle_unicode_name(symbol_name);
-        if (mangled) {
-            EnvEntry *me = env_lookup(ctx->env, mangled);
-            free(mangled);
+        const char *alias = mangle_unicode_alias(symbol_name);
+        if (alias) {
+            EnvEntry *me = env_lookup(ctx->env, alias);
             if (me) return me;
         }
     }
@@ -2557,16 +3141,15 @@ static void codegen_show_value(CodegenContext *ctx, LLVMValueRef val, Type *type
             CtorInfo ctors[64];
         int nctors = 0;
         for (size_t _bi = 0; _bi < ctx->env->size && nctors < 64; _bi++) {
-            for (EnvEntry *_e = ctx->env->buckets[_bi]; _e; _e = _e->next) {
-                if (_e->kind == ENV_ADT_CTOR && _e->type &&
-                    _e->type->kind == TYPE_LAYOUT && lay_name &&
-                    strcmp(_e->type->layout_name, lay_name) == 0) {
-                    ctors[nctors].name    = _e->name;
-                    ctors[nctors].tag     = _e->adt_tag;
-                    ctors[nctors].nfields = _e->param_count;
-                    ctors[nctors].params  = _e->params;
-                    nctors++;
-                }
+            EnvEntry *_e = ctx->env->slots[_bi];
+            if (_e && _e->kind == ENV_ADT_CTOR && _e->type &&
+                _e->type->kind == TYPE_LAYOUT && lay_name &&
+                strcmp(_e->type->layout_name, lay_name) == 0) {
+                ctors[nctors].name    = _e->name;
+                ctors[nctors].tag     = _e->adt_tag;
+                ctors[nctors].nfields = _e->param_count;
+                ctors[nctors].params  = _e->params;
+                nctors++;
             }
         }
         if (nctors > 0) {
@@ -2786,6 +3369,47 @@ static void build_br_if_no_terminator(LLVMBuilderRef builder, LLVMBasicBlockRef
         LLVMBuildBr(builder, dest);
 }
 
+/* Inline rt_type_of(): the i32 RuntimeValueType of a boxed value.  Heap
+ * values (below RT_IMM_BASE) load the tag at offset 0; immediates decode it
+ * from the word, so ints, floats, chars and nil are never dereferenced.    */
+static LLVMValueRef emit_value_tag(CodegenContext *ctx, LLVMValueRef val, const char *name) {
+    LLVMTypeRef  i32 = LLVMInt32TypeInContext(ctx->context);
+    LLVMTypeRef  i64 = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef w   = LLVMBuildPtrToInt(ctx->builder, val, i64, "tag_w");
+
+    LLVMValueRef      fn      = LLVMGetBasicBlockParent(LLVMGetInsertBlock(ctx->builder));
+    LLVMBasicBlockRef heap_bb = LLVMAppendBasicBlockInContext(ctx->context, fn, "tag_heap");
+    LLVMBasicBlockRef imm_bb  = LLVMAppendBasicBlockInContext(ctx->context, fn, "tag_imm");
+    LLVMBasicBlockRef done_bb = LLVMAppendBasicBlockInContext(ctx->context, fn, "tag_done");
+    LLVMValueRef is_heap = LLVMBuildICmp(ctx->builder, LLVMIntULT, w,
+                                         LLVMConstInt(i64, RT_IMM_BASE, 0), "tag_is_heap");
+    LLVMBuildCondBr(ctx->builder, is_heap, heap_bb, imm_bb);
+
+    LLVMPositionBuilderAtEnd(ctx->builder, heap_bb);
+    LLVMValueRef heap_tag = LLVMBuildLoad2(ctx->builder, i32, val, "tag_load");
+    LLVMBuildBr(ctx->builder, done_bb);
+
+    LLVMPositionBuilderAtEnd(ctx->builder, imm_bb);
+    LLVMValueRef is_int = LLVMBuildICmp(ctx->builder, LLVMIntUGE, w,
+                                        LLVMConstInt(i64, RT_IMM_INT, 0), "tag_is_int");
+    LLVMValueRef is_flt = LLVMBuildICmp(ctx->builder, LLVMIntUGE, w,
+                                        LLVMConstInt(i64, RT_IMM_FLOAT, 0), "tag_is_flt");
+    LLVMValueRef is_nil = LLVMBuildICmp(ctx->builder, LLVMIntEQ, w,
+                                        LLVMConstInt(i64, RT_IMM_NIL, 0), "tag_is_nil");
+    LLVMValueRef imm_tag = LLVMBuildSelect(ctx->builder, is_nil,
+                              LLVMConstInt(i32, RT_NIL, 0), LLVMConstInt(i32, RT_CHAR, 0), "tag_sp");
+    imm_tag = LLVMBuildSelect(ctx->builder, is_flt, LLVMConstInt(i32, RT_FLOAT, 0), imm_tag, "tag_fl");
+    imm_tag = LLVMBuildSelect(ctx->builder, is_int, LLVMConstInt(i32, RT_INT, 0), imm_tag, "tag_in");
+    LLVMBuildBr(ctx->builder, done_bb);
+
+    LLVMPositionBuilderAtEnd(ctx->builder, done_bb);
+    LLVMValueRef phi = LLVMBuildPhi(ctx->builder, i32, name);
+    LLVMValueRef      vals[]   = {heap_tag, imm_tag};
+    LLVMBasicBlockRef blocks[] = {heap_bb, imm_bb};
+    LLVMAddIncoming(phi, vals, blocks, 2);
+    return phi;
+}
+
 static LLVMValueRef emit_call_0(CodegenContext *ctx, LLVMValueRef fn, LLVMTypeRef ret_t, const char *name) {
     return LLVMBuildCall2(ctx->builder, LLVMFunctionType(ret_t, NULL, 0, 0), fn, NULL, 0, name);
 }
@@ -2855,11 +3479,7 @@ static LLVMValueRef codegen_box(CodegenContext *ctx, LLVMValueRef val, Type *typ
             LLVMValueRef len = arr_fat_size(ctx, val);
 
             // Allocate the RuntimeValue* Array wrapper
-            LLVMValueRef alloc_fn = LLVMGetNamedFunction(ctx->module, "rt_value_array");
-            if (!alloc_fn) {
-                LLVMTypeRef ft = LLVMFunctionType(ptr_t, &i64_t, 1, 0);
-                alloc_fn = LLVMAddFunction(ctx->module, "rt_value_array", ft);
-            }
+            LLVMValueRef alloc_fn = get_rt_value_array(ctx);
             LLVMValueRef boxed_arr = LLVMBuildCall2(ctx->builder, LLVMFunctionType(ptr_t, &i64_t, 1, 0), alloc_fn, &len, 1, "boxed_arr");
 
             // Loop and copy elements into the boxed array
@@ -2887,11 +3507,7 @@ static LLVMValueRef codegen_box(CodegenContext *ctx, LLVMValueRef val, Type *typ
             // Recursively box the inner element
             LLVMValueRef boxed_ev = codegen_box(ctx, ev, type->arr_element_type);
 
-            LLVMValueRef set_fn = LLVMGetNamedFunction(ctx->module, "rt_array_set");
-            if (!set_fn) {
-                LLVMTypeRef set_args[] = {ptr_t, i64_t, ptr_t};
-                set_fn = LLVMAddFunction(ctx->module, "rt_array_set", LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), set_args, 3, 0));
-            }
+            LLVMValueRef set_fn = get_rt_array_set(ctx);
             LLVMValueRef set_args[] = {boxed_arr, phi_i, boxed_ev};
             LLVMBuildCall2(ctx->builder, LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), (LLVMTypeRef[]){ptr_t, i64_t, ptr_t}, 3, 0), set_fn, set_args, 3, "");
 
@@ -2947,6 +3563,28 @@ static void emit_runtime_error(CodegenContext *ctx, AST *ast, const char *msg) {
     emit_runtime_error_val(ctx, ast, LLVMBuildGlobalStringPtr(ctx->builder, msg, "err_msg"));
 }
 
+/* Call a RuntimeValue*(RT_CLOSURE) with boxed args through
+ * rt_closure_call1/2/3, which enter the closure's direct entry when it
+ * has one.  Only for 1..RT_CLOSURE_DIRECT_MAX args; larger calls build
+ * an argv for rt_closure_calln.                                        */
+static LLVMValueRef codegen_closure_call_direct(CodegenContext *ctx, LLVMValueRef clo,
+                                                LLVMValueRef *args, int n, const char *name) {
+    LLVMTypeRef  ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMTypeRef  params[1 + RT_CLOSURE_DIRECT_MAX];
+    LLVMValueRef cargs[1 + RT_CLOSURE_DIRECT_MAX];
+    params[0] = ptr;
+    cargs[0]  = LLVMTypeOf(clo) == ptr ? clo : LLVMBuildBitCast(ctx->builder, clo, ptr, "clo_cast");
+    for (int i = 0; i < n; i++) {
+        params[i + 1] = ptr;
+        cargs[i + 1]  = args[i];
+    }
+    LLVMValueRef fn = n == 1 ? get_rt_closure_call1(ctx)
+                    : n == 2 ? get_rt_closure_call2(ctx)
+                    :          get_rt_closure_call3(ctx);
+    return LLVMBuildCall2(ctx->builder, LLVMFunctionType(ptr, params, n + 1, 0),
+                          fn, cargs, n + 1, name);
+}
+
 static LLVMValueRef codegen_arity_wrapper(CodegenContext *ctx, LLVMValueRef *out_closure_env, int arity) {
     LLVMTypeRef ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
     LLVMTypeRef i32 = LLVMInt32TypeInContext(ctx->context);
@@ -3159,7 +3797,7 @@ static AST *derive_show_nullary_lambda(AST *data_ast, const char *type_name,
 
     AST *pm = ast_new_pmatch(clauses, nctors);
     AST *desugared = pmatch_desugar(pm, params, 1);
-    free(pm);
+    ast_node_release(pm);
 
     AST **body_exprs = malloc(sizeof(AST*));
     body_exprs[0] = desugared;
@@ -3225,7 +3863,7 @@ static AST *derive_eq_nullary_lambda(AST *data_ast, const char *type_name,
 
     AST *pm = ast_new_pmatch(clauses, total_clauses);
     AST *desugared = pmatch_desugar(pm, params, 2);
-    free(pm);
+    ast_node_release(pm);
 
     AST **body_exprs = malloc(sizeof(AST*));
     body_exprs[0] = desugared;
@@ -3327,13 +3965,8 @@ void codegen_data(CodegenContext *ctx, AST *ast) {
                                             ctx->context, func, "entry");
         LLVMPositionBuilderAtEnd(ctx->builder, entry_block);
 
-        // malloc(sizeof(struct))
-        LLVMValueRef malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-        if (!malloc_fn) {
-            LLVMTypeRef mft = LLVMFunctionType(ptr_t, &i64, 1, 0);
-            malloc_fn = LLVMAddFunction(ctx->module, "malloc", mft);
-            LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-        }
+        // rt_alloc(sizeof(struct)) — fields may hold boxed values
+        LLVMValueRef malloc_fn = get_rt_alloc(ctx);
         LLVMValueRef size     = LLVMSizeOf(struct_t);
         LLVMValueRef heap_ptr = LLVMBuildCall2(ctx->builder,
                                     LLVMFunctionType(ptr_t, &i64, 1, 0),
@@ -3960,15 +4593,395 @@ static CodegenResult codegen_map_op(CodegenContext *ctx, AST *ast,
     return result;
 }
 
+/* Private parallel collection intrinsics behind pmap, pfilter and pfold.
+ * Every operand is passed boxed; the result is a boxed collection, or the
+ * boxed fold value. */
+static CodegenResult codegen_par_op(CodegenContext *ctx, AST *ast,
+                                    LLVMValueRef (*fn_getter)(CodegenContext *),
+                                    const char *op_name, int expect_args) {
+    CodegenResult result = {NULL, NULL};
+    if ((int)ast->list.count != expect_args + 1) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: ‘%s’ requires %d arguments",
+                      parser_get_filename(), ast->line, ast->column,
+                      op_name, expect_args);
+    }
+    LLVMTypeRef  ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMValueRef boxed[3];
+    for (int i = 0; i < expect_args; i++) {
+        CodegenResult r = codegen_expr(ctx, ast->list.items[i + 1]);
+        boxed[i] = codegen_box(ctx, r.value, r.type);
+    }
+    if (expect_args == 2) {
+        result.value = emit_call_2(ctx, fn_getter(ctx), ptr, boxed[0], boxed[1], op_name);
+        result.type  = ast->inferred_type
+            ? type_clone(ast->inferred_type)
+            : type_coll();
+        return result;
+    }
+    result.value = emit_call_3(ctx, fn_getter(ctx), ptr, boxed[0], boxed[1], boxed[2], op_name);
+    result.type  = type_unknown();
+    return result;
+}
+
+/* Private fiber intrinsics behind Control.Fiber and System.Posix.Async.
+ * Each char of `sig` is one operand's ABI: 'i' an Int as i64, 'p' a raw
+ * pointer, 'b' a boxed value.  `ret` is 'i' for an Int result or 'b' for
+ * a boxed one. */
+typedef struct {
+    const char   *name;
+    LLVMValueRef (*fn)(CodegenContext *);
+    const char   *sig;
+    char          ret;
+} FiberOp;
+
+static const FiberOp FIBER_OPS[] = {
+    {"__rt_fiber_spawn",  get_rt_fiber_spawn,  "b",   'i'},
+    {"__rt_fiber_yield",  get_rt_fiber_yield,  "b",   'b'},
+    {"__rt_fiber_run",    get_rt_fiber_run,    "b",   'i'},
+    {"__rt_fiber_read",   get_rt_fiber_read,   "ipi", 'i'},
+    {"__rt_fiber_write",  get_rt_fiber_write,  "ipi", 'i'},
+    {"__rt_fiber_accept", get_rt_fiber_accept, "i",   'i'},
+};
+
+static const FiberOp *fiber_op_lookup(const char *name) {
+    if (strncmp(name, "__rt_fiber_", 11) != 0) return NULL;
+    for (size_t i = 0; i < sizeof(FIBER_OPS) / sizeof(FIBER_OPS[0]); i++)
+        if (strcmp(FIBER_OPS[i].name, name) == 0) return &FIBER_OPS[i];
+    return NULL;
+}
+
+static CodegenResult codegen_fiber_op(CodegenContext *ctx, AST *ast, const FiberOp *op) {
+    CodegenResult result = {NULL, NULL};
+    int argc = (int)strlen(op->sig);
+    if ((int)ast->list.count != argc + 1) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: ‘%s’ requires %d arguments",
+                      parser_get_filename(), ast->line, ast->column, op->name, argc);
+    }
+    LLVMTypeRef  ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMTypeRef  i64 = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef args[3];
+    for (int i = 0; i < argc; i++) {
+        CodegenResult r = codegen_expr(ctx, ast->list.items[i + 1]);
+        args[i] = op->sig[i] == 'b' ? codegen_box(ctx, r.value, r.type)
+                : emit_type_cast(ctx, r.value, op->sig[i] == 'i' ? i64 : ptr);
+    }
+    LLVMValueRef fn = op->fn(ctx);
+    result.value = LLVMBuildCall2(ctx->builder, LLVMGlobalGetValueType(fn), fn,
+                                  args, (unsigned)argc, op->name);
+    result.type  = op->ret == 'i' ? type_int() : type_unknown();
+    return result;
+}
+
+/// Unboxed array kernels
+//
+//  (array-sum xs) (array-dot xs ys) (array-affine xs scale offset)
+//  (array-min xs ys) (array-max xs ys) (array-scan xs)
+//
+//  Int and Float arrays already hold raw int64_t / double elements, so
+//  each form passes the data pointer and length straight to the matching
+//  rt_arr_* kernel in the runtime.  Result arrays are fresh fat arrays.
+
+typedef enum {
+    ARR_KERNEL_SUM,
+    ARR_KERNEL_DOT,
+    ARR_KERNEL_AFFINE,
+    ARR_KERNEL_MIN,
+    ARR_KERNEL_MAX,
+    ARR_KERNEL_SCAN,
+} ArrKernelOp;
+
+typedef struct {
+    const char  *name;
+    ArrKernelOp  op;
+    int          args;
+    LLVMValueRef (*int_fn)(CodegenContext *);
+    LLVMValueRef (*float_fn)(CodegenContext *);
+} ArrKernel;
+
+static const ArrKernel ARR_KERNELS[] = {
+    {"array-sum",    ARR_KERNEL_SUM,    1, get_rt_arr_sum_i64,    get_rt_arr_sum_f64},
+    {"array-dot",    ARR_KERNEL_DOT,    2, get_rt_arr_dot_i64,    get_rt_arr_dot_f64},
+    {"array-affine", ARR_KERNEL_AFFINE, 3, get_rt_arr_affine_i64, get_rt_arr_affine_f64},
+    {"array-min",    ARR_KERNEL_MIN,    2, get_rt_arr_min_i64,    get_rt_arr_min_f64},
+    {"array-max",    ARR_KERNEL_MAX,    2, get_rt_arr_max_i64,    get_rt_arr_max_f64},
+    {"array-scan",   ARR_KERNEL_SCAN,   1, get_rt_arr_scan_i64,   get_rt_arr_scan_f64},
+};
+
+/* Index into ARR_KERNELS, or -1.  A user binding of the same name wins. */
+static int arr_kernel_index(CodegenContext *ctx, const char *name) {
+    for (size_t i = 0; i < sizeof(ARR_KERNELS) / sizeof(ARR_KERNELS[0]); i++) {
+        if (strcmp(ARR_KERNELS[i].name, name) != 0) continue;
+        EnvEntry *e = env_lookup(ctx->env, name);
+        return (!e || e->kind == ENV_BUILTIN) ? (int)i : -1;
+    }
+    return -1;
+}
+
+/* Data pointer and length of an Int or Float array operand.  Returns the
+ * element type, or NULL when the operand is not such an array. */
+static Type *arr_kernel_operand(CodegenContext *ctx, AST *arg,
+                                LLVMValueRef *data, LLVMValueRef *n) {
+    LLVMTypeRef ptr_t  = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMTypeRef fat_pt = LLVMPointerType(get_arr_fat_type(ctx), 0);
+    Type       *t;
+    LLVMValueRef fat;
+
+    EnvEntry *e = (arg->type == AST_SYMBOL) ? env_lookup(ctx->env, arg->symbol) : NULL;
+    if (e && e->kind == ENV_VAR && e->type && e->type->kind == TYPE_ARR) {
+        t = e->type;
+        if (!t->arr_element_type ||
+            (t->arr_element_type->kind != TYPE_INT && t->arr_element_type->kind != TYPE_FLOAT))
+            return NULL;
+        if (!type_arr_runtime_sized(t)) {
+            /* Known-size stack or global [N x T] */
+            LLVMValueRef base = e->value;
+            if (LLVMGetValueKind(base) == LLVMGlobalVariableValueKind) {
+                const char *gname = (e->llvm_name && e->llvm_name[0]) ? e->llvm_name : e->name;
+                LLVMValueRef gv = LLVMGetNamedGlobal(ctx->module, gname);
+                if (gv) base = gv;
+            }
+            *data = LLVMBuildBitCast(ctx->builder, base, ptr_t, "arr_data");
+            *n    = LLVMConstInt(LLVMInt64TypeInContext(ctx->context), (uint64_t)t->arr_size, 0);
+            return t->arr_element_type;
+        }
+        fat = codegen_load_arr_fat_entry(ctx, e, "fat_ptr");
+    } else {
+        CodegenResult r = codegen_expr(ctx, arg);
+        t = r.type;
+        if (!type_arr_runtime_sized(t) || !t->arr_element_type ||
+            (t->arr_element_type->kind != TYPE_INT && t->arr_element_type->kind != TYPE_FLOAT))
+            return NULL;
+        fat = (LLVMTypeOf(r.value) == fat_pt)
+            ? r.value : LLVMBuildBitCast(ctx->builder, r.value, fat_pt, "fat_ptr");
+    }
+    *data = LLVMBuildBitCast(ctx->builder, arr_fat_data(ctx, fat, t->arr_element_type),
+                             ptr_t, "arr_data");
+    *n    = arr_fat_size(ctx, fat);
+    return t->arr_element_type;
+}
+
+static CodegenResult codegen_array_kernel(CodegenContext *ctx, AST *ast, const ArrKernel *k) {
+    CodegenResult result = {NULL, NULL};
+    if ((int)ast->list.count != k->args + 1) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: '%s' requires %d argument(s)",
+                      parser_get_filename(), ast->line, ast->column, k->name, k->args);
+    }
+
+    LLVMTypeRef  i64   = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef a_data, a_n, b_data = NULL, b_n = NULL;
+
+    Type *elem = arr_kernel_operand(ctx, ast->list.items[1], &a_data, &a_n);
+    if (!elem) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: '%s' expects an Arr :: Int or Arr :: Float",
+                      parser_get_filename(), ast->line, ast->column, k->name);
+    }
+    bool          is_float = elem->kind == TYPE_FLOAT;
+    LLVMTypeRef   scalar_t = is_float ? LLVMDoubleTypeInContext(ctx->context) : i64;
+    LLVMValueRef  fn       = is_float ? k->float_fn(ctx) : k->int_fn(ctx);
+    LLVMTypeRef   fn_t     = LLVMGlobalGetValueType(fn);
+
+    bool binary = k->op == ARR_KERNEL_DOT || k->op == ARR_KERNEL_MIN || k->op == ARR_KERNEL_MAX;
+    if (binary) {
+        Type *b_elem = arr_kernel_operand(ctx, ast->list.items[2], &b_data, &b_n);
+        if (!b_elem || b_elem->kind != elem->kind) {
+            CODEGEN_ERROR(ctx, "%s:%d:%d: error: '%s' expects two arrays of the same element type",
+                          parser_get_filename(), ast->line, ast->column, k->name);
+        }
+        emit_runtime_check(ctx, ast,
+            LLVMBuildICmp(ctx->builder, LLVMIntEQ, a_n, b_n, "same_len"),
+            "array lengths differ");
+    }
+
+    if (k->op == ARR_KERNEL_SUM || k->op == ARR_KERNEL_DOT) {
+        LLVMValueRef args[] = {a_data, binary ? b_data : a_n, a_n};
+        result.value = LLVMBuildCall2(ctx->builder, fn_t, fn, args, binary ? 3 : 2, k->name);
+        result.type  = is_float ? type_float() : type_int();
+        return result;
+    }
+
+    LLVMValueRef dst;
+    LLVMValueRef fat = arr_alloc_fat(ctx, a_n, elem, &dst);
+    if (k->op == ARR_KERNEL_AFFINE) {
+        CodegenResult scale_r  = codegen_expr(ctx, ast->list.items[2]);
+        CodegenResult offset_r = codegen_expr(ctx, ast->list.items[3]);
+        LLVMValueRef args[] = {dst, a_data, a_n,
+                               emit_type_cast(ctx, scale_r.value, scalar_t),
+                               emit_type_cast(ctx, offset_r.value, scalar_t)};
+        LLVMBuildCall2(ctx->builder, fn_t, fn, args, 5, "");
+    } else if (binary) {
+        LLVMValueRef args[] = {dst, a_data, b_data, a_n};
+        LLVMBuildCall2(ctx->builder, fn_t, fn, args, 4, "");
+    } else {
+        LLVMValueRef args[] = {dst, a_data, a_n};
+        LLVMBuildCall2(ctx->builder, fn_t, fn, args, 3, "");
+    }
+    result.value = fat;
+    result.type  = type_arr_fat(type_clone(elem));
+    return result;
+}
+
+/* (array-borrow ptr n): view n elements of a buffer C returned as an
+ * array.  Only the fat header is allocated; the elements are never
+ * copied, so the view lives exactly as long as the C side's buffer. */
+static CodegenResult codegen_array_borrow(CodegenContext *ctx, AST *ast) {
+    CodegenResult result = {NULL, NULL};
+    if (ast->list.count != 3) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: 'array-borrow' requires 2 argument(s)",
+                      parser_get_filename(), ast->line, ast->column);
+    }
+
+    CodegenResult p_r = codegen_expr(ctx, ast->list.items[1]);
+    CodegenResult n_r = codegen_expr(ctx, ast->list.items[2]);
+    Type         *pt  = p_r.type;
+    if (pt && pt->kind != TYPE_PTR && pt->kind != TYPE_STRING && pt->kind != TYPE_UNKNOWN) {
+        CODEGEN_ERROR(ctx, "%s:%d:%d: error: 'array-borrow' expects a pointer, got %s",
+                      parser_get_filename(), ast->line, ast->column, type_to_string(pt));
+    }
+
+    /* void *, char * and opaque pointers are viewed as bytes */
+    Type *elem = (pt && pt->kind == TYPE_PTR && pt->element_type &&
+                  pt->element_type->kind != TYPE_UNKNOWN)
+        ? type_clone(pt->element_type) : type_u8();
+
+    LLVMTypeRef  i64 = LLVMInt64TypeInContext(ctx->context);
+    LLVMValueRef n   = emit_type_cast(ctx, n_r.value, i64);
+    emit_runtime_check(ctx, ast,
+        LLVMBuildICmp(ctx->builder, LLVMIntSGE, n, LLVMConstInt(i64, 0, 0), "len_ok"),
+        "negative array-borrow length");
+
+    LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    result.value = arr_wrap_fat(ctx, emit_type_cast(ctx, p_r.value, ptr_t), n);
+    result.type  = type_arr_fat(elem);
+    return result;
+}
+
+/* Trampoline from boxed arguments to a typed-ABI function: unboxes the
+ * args, calls the real function, boxes the result.  The calln form is
+ * (ptr env, i32 n, ptr args_array) — what rt_closure_calln expects; the
+ * direct form (ptr env, ptr a0, ...) is the closure's direct entry that
+ * rt_closure_call1/2/3 use, so small-arity calls never build an argv.   */
+static LLVMValueRef emit_closure_trampoline(CodegenContext *ctx, EnvEntry *e,
+                                            LLVMValueRef fn_to_wrap,
+                                            int declared, int direct) {
+    LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    LLVMTypeRef i32   = LLVMInt32TypeInContext(ctx->context);
+    LLVMTypeRef i64   = LLVMInt64TypeInContext(ctx->context);
+    LLVMTypeRef dbl   = LLVMDoubleTypeInContext(ctx->context);
+    LLVMTypeRef i1    = LLVMInt1TypeInContext(ctx->context);
+
+    LLVMTypeRef tp[1 + RT_CLOSURE_DIRECT_MAX] = {ptr_t, i32, ptr_t};
+    int         tn = 3;
+    if (direct) {
+        tn = 1 + declared;
+        for (int i = 1; i < tn; i++) tp[i] = ptr_t;
+    }
+    LLVMTypeRef tft = LLVMFunctionType(ptr_t, tp, tn, 0);
+
+    static int tramp_count = 0;
+    char tname[64];
+    if (direct) snprintf(tname, sizeof(tname), "__tramp_%d_call%d", tramp_count++, declared);
+    else        snprintf(tname, sizeof(tname), "__tramp_%d", tramp_count++);
+
+    LLVMValueRef      tramp  = LLVMAddFunction(ctx->module, tname, tft);
+    LLVMBasicBlockRef tentry = LLVMAppendBasicBlockInContext(
+                                   ctx->context, tramp, "entry");
+    LLVMBasicBlockRef tsaved = LLVMGetInsertBlock(ctx->builder);
+    LLVMPositionBuilderAtEnd(ctx->builder, tentry);
+
+    /* Unbox each argument from the args array, or the direct params */
+    LLVMValueRef args_param  = direct ? NULL : LLVMGetParam(tramp, 2);
+    LLVMValueRef *real_args  = malloc(sizeof(LLVMValueRef) * (declared ? declared : 1));
+    LLVMTypeRef  *real_types = malloc(sizeof(LLVMTypeRef)  * (declared ? declared : 1));
+    for (int i = 0; i < declared; i++) {
+        LLVMValueRef boxed;
+        if (direct) {
+            boxed = LLVMGetParam(tramp, i + 1);
+        } else {
+            LLVMValueRef idx  = LLVMConstInt(LLVMInt32TypeInContext(ctx->context), i, 0);
+            LLVMValueRef slot = LLVMBuildGEP2(ctx->builder, ptr_t,
+                                              args_param, &idx, 1, "arg_slot");
+            boxed = LLVMBuildLoad2(ctx->builder, ptr_t, slot, "boxed");
+        }
+        Type *pt = (e->params && i < e->param_count) ? e->params[i].type : NULL;
+        LLVMTypeRef native = pt ? type_to_llvm(ctx, pt) : ptr_t;
+        real_types[i] = native;
+        if (native == i64) {
+            LLVMTypeRef uft = LLVMFunctionType(i64, &ptr_t, 1, 0);
+            real_args[i] = LLVMBuildCall2(ctx->builder, uft,
+                               get_rt_unbox_int(ctx), &boxed, 1, "ua");
+        } else if (native == dbl) {
+            LLVMTypeRef uft = LLVMFunctionType(dbl, &ptr_t, 1, 0);
+            real_args[i] = LLVMBuildCall2(ctx->builder, uft,
+                               get_rt_unbox_float(ctx), &boxed, 1, "ua");
+        } else if (LLVMGetTypeKind(native) == LLVMIntegerTypeKind && native != LLVMInt1TypeInContext(ctx->context)) {
+            LLVMTypeRef i8 = LLVMInt8TypeInContext(ctx->context);
+            if (native == i8) {
+                LLVMTypeRef uft = LLVMFunctionType(i8, &ptr_t, 1, 0);
+                real_args[i] = LLVMBuildCall2(ctx->builder, uft,
+                                   get_rt_unbox_char(ctx), &boxed, 1, "ua");
+            } else {
+                LLVMTypeRef uft = LLVMFunctionType(i64, &ptr_t, 1, 0);
+                LLVMValueRef unboxed64 = LLVMBuildCall2(ctx->builder, uft,
+                                   get_rt_unbox_int(ctx), &boxed, 1, "ua");
+                real_args[i] = LLVMBuildTrunc(ctx->builder, unboxed64, native, "ua_trunc");
+            }
+        } else {
+            real_args[i] = boxed;
+        }
+    }
+
+    /* Call the real typed function */
+    Type *rt = e->return_type;
+    LLVMTypeRef native_ret = rt ? type_to_llvm(ctx, rt) : ptr_t;
+    LLVMTypeRef real_ft = LLVMFunctionType(native_ret, real_types, declared, 0);
+    LLVMValueRef raw = LLVMBuildCall2(ctx->builder, real_ft,
+                                       fn_to_wrap, real_args, declared, "raw");
+    free(real_args);
+    free(real_types);
+
+    /* Box result */
+    LLVMValueRef boxed_ret;
+    if (native_ret == i64) {
+        LLVMTypeRef bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
+        boxed_ret = LLVMBuildCall2(ctx->builder, bft,
+                                   get_rt_value_int(ctx), &raw, 1, "br");
+    } else if (native_ret == dbl) {
+        LLVMTypeRef bft = LLVMFunctionType(ptr_t, &dbl, 1, 0);
+        boxed_ret = LLVMBuildCall2(ctx->builder, bft,
+                                   get_rt_value_float(ctx), &raw, 1, "br");
+        } else if (native_ret == i1) {
+        LLVMValueRef ext = LLVMBuildZExt(ctx->builder, raw, i64, "ext");
+        LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
+        boxed_ret = LLVMBuildCall2(ctx->builder, bft,
+                                   get_rt_value_int(ctx), &ext, 1, "br");
+    } else if (LLVMGetTypeKind(native_ret) == LLVMIntegerTypeKind) {
+        LLVMTypeRef i8 = LLVMInt8TypeInContext(ctx->context);
+        if (native_ret == i8) {
+            LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i8, 1, 0);
+            boxed_ret = LLVMBuildCall2(ctx->builder, bft,
+                                       get_rt_value_char(ctx), &raw, 1, "br");
+        } else {
+            LLVMValueRef ext = LLVMBuildSExt(ctx->builder, raw, i64, "ext");
+            LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
+            boxed_ret = LLVMBuildCall2(ctx->builder, bft,
+                                       get_rt_value_int(ctx), &ext, 1, "br");
+        }
+    } else {
+        boxed_ret = raw;
+    }
+
+    LLVMBuildRet(ctx->builder, boxed_ret);
+    if (tsaved) LLVMPositionBuilderAtEnd(ctx->builder, tsaved);
+
+    return tramp;
+}
+
 /* Generate a closure-ABI trampoline for a typed-ABI function, then wrap
  * it in a RuntimeValue*(RT_CLOSURE). Used when a typed function needs to
  * be passed as a first-class value to a HOF or closure call site.       */
 static LLVMValueRef wrap_func_as_closure(CodegenContext *ctx, EnvEntry *e) {
     LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
     LLVMTypeRef i32   = LLVMInt32TypeInContext(ctx->context);
-    LLVMTypeRef i64   = LLVMInt64TypeInContext(ctx->context);
-    LLVMTypeRef dbl   = LLVMDoubleTypeInContext(ctx->context);
-    LLVMTypeRef i1    = LLVMInt1TypeInContext(ctx->context);
     int declared = e->param_count - e->lifted_count;
 
     LLVMValueRef fn_to_wrap = e->func_ref;
@@ -3993,123 +5006,27 @@ static LLVMValueRef wrap_func_as_closure(CodegenContext *ctx, EnvEntry *e) {
         return LLVMBuildCall2(ctx->builder, cft, clo_fn, cargs, 5, "closure");
     }
 
-    if (!e->is_closure_abi) {
-        /* Build a calln-ABI trampoline:
-         * (ptr env, i32 n, ptr args_array) -> ptr
-         * Unboxes args from args_array, calls the real typed function,
-         * boxes result. This matches what rt_closure_calln expects.   */
-        LLVMTypeRef  i32   = LLVMInt32TypeInContext(ctx->context);
-        LLVMTypeRef  tp[]  = {ptr_t, i32, ptr_t};
-        LLVMTypeRef  tft   = LLVMFunctionType(ptr_t, tp, 3, 0);
-
-        static int tramp_count = 0;
-        char tname[64];
-        snprintf(tname, sizeof(tname), "__tramp_%d", tramp_count++);
-
-        LLVMValueRef      tramp  = LLVMAddFunction(ctx->module, tname, tft);
-        LLVMBasicBlockRef tentry = LLVMAppendBasicBlockInContext(
-                                       ctx->context, tramp, "entry");
-        LLVMBasicBlockRef tsaved = LLVMGetInsertBlock(ctx->builder);
-        LLVMPositionBuilderAtEnd(ctx->builder, tentry);
-
-        /* Unbox each argument from the args array */
-        LLVMValueRef args_param  = LLVMGetParam(tramp, 2);
-        LLVMValueRef *real_args  = malloc(sizeof(LLVMValueRef) * (declared ? declared : 1));
-        LLVMTypeRef  *real_types = malloc(sizeof(LLVMTypeRef)  * (declared ? declared : 1));
-        for (int i = 0; i < declared; i++) {
-            LLVMValueRef idx   = LLVMConstInt(LLVMInt32TypeInContext(ctx->context), i, 0);
-            LLVMValueRef slot  = LLVMBuildGEP2(ctx->builder, ptr_t,
-                                               args_param, &idx, 1, "arg_slot");
-            LLVMValueRef boxed = LLVMBuildLoad2(ctx->builder, ptr_t, slot, "boxed");
-            Type *pt = (e->params && i < e->param_count) ? e->params[i].type : NULL;
-            LLVMTypeRef native = pt ? type_to_llvm(ctx, pt) : ptr_t;
-            real_types[i] = native;
-            if (native == i64) {
-                LLVMTypeRef uft = LLVMFunctionType(i64, &ptr_t, 1, 0);
-                real_args[i] = LLVMBuildCall2(ctx->builder, uft,
-                                   get_rt_unbox_int(ctx), &boxed, 1, "ua");
-            } else if (native == dbl) {
-                LLVMTypeRef uft = LLVMFunctionType(dbl, &ptr_t, 1, 0);
-                real_args[i] = LLVMBuildCall2(ctx->builder, uft,
-                                   get_rt_unbox_float(ctx), &boxed, 1, "ua");
-            } else if (LLVMGetTypeKind(native) == LLVMIntegerTypeKind && native != LLVMInt1TypeInContext(ctx->context)) {
-                LLVMTypeRef i8 = LLVMInt8TypeInContext(ctx->context);
-                if (native == i8) {
-                    LLVMTypeRef uft = LLVMFunctionType(i8, &ptr_t, 1, 0);
-                    real_args[i] = LLVMBuildCall2(ctx->builder, uft,
-                                       get_rt_unbox_char(ctx), &boxed, 1, "ua");
-                } else {
-                    LLVMTypeRef uft = LLVMFunctionType(i64, &ptr_t, 1, 0);
-                    LLVMValueRef unboxed64 = LLVMBuildCall2(ctx->builder, uft,
-                                       get_rt_unbox_int(ctx), &boxed, 1, "ua");
-                    real_args[i] = LLVMBuildTrunc(ctx->builder, unboxed64, native, "ua_trunc");
-                }
-            } else {
-                real_args[i] = boxed;
-            }
-        }
+    LLVMValueRef direct = LLVMConstPointerNull(ptr_t);
+    fn_to_wrap = emit_closure_trampoline(ctx, e, e->func_ref, declared, 0);
+    if (declared >= 1 && declared <= RT_CLOSURE_DIRECT_MAX)
+        direct = emit_closure_trampoline(ctx, e, e->func_ref, declared, 1);
 
-        /* Call the real typed function */
-        Type *rt = e->return_type;
-        LLVMTypeRef native_ret = rt ? type_to_llvm(ctx, rt) : ptr_t;
-        LLVMTypeRef real_ft = LLVMFunctionType(native_ret, real_types, declared, 0);
-        LLVMValueRef raw = LLVMBuildCall2(ctx->builder, real_ft,
-                                           fn_to_wrap, real_args, declared, "raw");
-        free(real_args);
-        free(real_types);
-
-        /* Box result */
-        LLVMValueRef boxed_ret;
-        if (native_ret == i64) {
-            LLVMTypeRef bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
-            boxed_ret = LLVMBuildCall2(ctx->builder, bft,
-                                       get_rt_value_int(ctx), &raw, 1, "br");
-        } else if (native_ret == dbl) {
-            LLVMTypeRef bft = LLVMFunctionType(ptr_t, &dbl, 1, 0);
-            boxed_ret = LLVMBuildCall2(ctx->builder, bft,
-                                       get_rt_value_float(ctx), &raw, 1, "br");
-            } else if (native_ret == i1) {
-            LLVMValueRef ext = LLVMBuildZExt(ctx->builder, raw, i64, "ext");
-            LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
-            boxed_ret = LLVMBuildCall2(ctx->builder, bft,
-                                       get_rt_value_int(ctx), &ext, 1, "br");
-        } else if (LLVMGetTypeKind(native_ret) == LLVMIntegerTypeKind) {
-            LLVMTypeRef i8 = LLVMInt8TypeInContext(ctx->context);
-            if (native_ret == i8) {
-                LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i8, 1, 0);
-                boxed_ret = LLVMBuildCall2(ctx->builder, bft,
-                                           get_rt_value_char(ctx), &raw, 1, "br");
-            } else {
-                LLVMValueRef ext = LLVMBuildSExt(ctx->builder, raw, i64, "ext");
-                LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
-                boxed_ret = LLVMBuildCall2(ctx->builder, bft,
-                                           get_rt_value_int(ctx), &ext, 1, "br");
-            }
-        } else {
-            boxed_ret = raw;
-        }
-
-        LLVMBuildRet(ctx->builder, boxed_ret);
-        if (tsaved) LLVMPositionBuilderAtEnd(ctx->builder, tsaved);
-
-        fn_to_wrap = tramp;
-    }
-
-    /* Wrap fn_to_wrap in rt_value_closure_named with empty env */
+    /* Wrap fn_to_wrap (and its direct entry) in a closure with empty env */
     LLVMValueRef fn_ptr = LLVMBuildBitCast(ctx->builder, fn_to_wrap, ptr_t, "fn_ptr");
-    LLVMValueRef clo_fn = get_rt_value_closure_named(ctx);
-    LLVMTypeRef  cp[]   = {ptr_t, ptr_t, i32, i32, ptr_t};
-    LLVMTypeRef  cft    = LLVMFunctionType(ptr_t, cp, 5, 0);
+    LLVMValueRef clo_fn = get_rt_value_closure_direct(ctx);
+    LLVMTypeRef  cp[]   = {ptr_t, ptr_t, ptr_t, i32, i32, ptr_t};
+    LLVMTypeRef  cft    = LLVMFunctionType(ptr_t, cp, 6, 0);
     const char *fn_name = e->name ? e->name : "?";
     LLVMValueRef name_str = LLVMBuildGlobalStringPtr(ctx->builder, fn_name, "fn_name");
     LLVMValueRef cargs[] = {
         fn_ptr,
+        LLVMBuildBitCast(ctx->builder, direct, ptr_t, "direct_ptr"),
         LLVMConstPointerNull(ptr_t),
         LLVMConstInt(i32, 0, 0),
         LLVMConstInt(i32, declared, 0),
         name_str
     };
-    return LLVMBuildCall2(ctx->builder, cft, clo_fn, cargs, 5, "closure");
+    return LLVMBuildCall2(ctx->builder, cft, clo_fn, cargs, 6, "closure");
 }
 
 static LLVMValueRef resolve_to_closure(CodegenContext *ctx, AST *fn_node) {
@@ -4451,35 +5368,35 @@ static int jit_eval_refinement(CodegenContext *ctx,
 
     /* Pre-declare user-defined predicate functions (Bool-returning) as externs.
      * Only Bool/integer returning functions are needed in the JIT predicate module. */
-    for (size_t bi = 0; bi < ctx->env->size; bi++) {
-        for (EnvEntry *e = ctx->env->buckets[bi]; e; e = e->next) {
-            if (e->kind != ENV_FUNC || !e->func_ref) continue;
-            if (!e->return_type) continue;
-            /* Only include Bool-returning functions (predicates).
-             * Exclude Int/Float returning functions like constructors
-             * which generate complex IR incompatible with the JIT module. */
-            if (!type_is_bool(e->return_type)) continue;
-            const char *fname = e->name;
-            if (LLVMGetNamedFunction(tmp_mod, fname)) continue;
-            int np = e->param_count;
-            LLVMTypeRef *pt = malloc(sizeof(LLVMTypeRef) * (np ? np : 1));
-            for (int pi = 0; pi < np; pi++)
-                pt[pi] = type_to_llvm(&jit_ctx, e->params[pi].type);
-            LLVMTypeRef ft = LLVMFunctionType(
-                type_to_llvm(&jit_ctx, e->return_type), pt, np, 0);
-            free(pt);
-            LLVMValueRef decl = LLVMAddFunction(tmp_mod, fname, ft);
-            LLVMSetLinkage(decl, LLVMExternalLinkage);
-            /* Register in jit_ctx.env so codegen_expr finds it */
-            env_insert_func(jit_ctx.env, fname,
-                            clone_params(e->params, np), np,
-                            type_clone(e->return_type), decl, NULL, NULL);
-            EnvEntry *je = env_lookup(jit_ctx.env, fname);
-            if (je) {
-                je->is_closure_abi = e->is_closure_abi;
-                je->lifted_count   = e->lifted_count;
-                je->source_ast     = e->source_ast;
-            }
+    for (size_t bi = 0; bi < ctx->env->size; bi++) {
+        EnvEntry *e = ctx->env->slots[bi];
+        if (!e) continue;
+        if (e->kind != ENV_FUNC || !e->func_ref) continue;
+        if (!e->return_type) continue;
+        /* Only include Bool-returning functions (predicates).
+         * Exclude Int/Float returning functions like constructors
+         * which generate complex IR incompatible with the JIT module. */
+        if (!type_is_bool(e->return_type)) continue;
+        const char *fname = e->name;
+        if (LLVMGetNamedFunction(tmp_mod, fname)) continue;
+        int np = e->param_count;
+        LLVMTypeRef *pt = malloc(sizeof(LLVMTypeRef) * (np ? np : 1));
+        for (int pi = 0; pi < np; pi++)
+            pt[pi] = type_to_llvm(&jit_ctx, e->params[pi].type);
+        LLVMTypeRef ft = LLVMFunctionType(
+            type_to_llvm(&jit_ctx, e->return_type), pt, np, 0);
+        free(pt);
+        LLVMValueRef decl = LLVMAddFunction(tmp_mod, fname, ft);
+        LLVMSetLinkage(decl, LLVMExternalLinkage);
+        /* Register in jit_ctx.env so codegen_expr finds it */
+        env_insert_func(jit_ctx.env, fname,
+                        clone_params(e->params, np), np,
+                        type_clone(e->return_type), decl, NULL, NULL);
+        EnvEntry *je = env_lookup(jit_ctx.env, fname);
+        if (je) {
+            je->is_closure_abi = e->is_closure_abi;
+            je->lifted_count   = e->lifted_count;
+            je->source_ast     = e->source_ast;
         }
     }
 
@@ -5293,6 +6210,43 @@ void codegen_predeclare_toplevel_functions(CodegenContext *ctx, AST **exprs,
     if (!ctx || !exprs)
         return;
 
+    /* Infer in dependency order first, so each define's scheme is built
+     * from the finished schemes of what it calls even when those come
+     * later in the file.  The declaration loop below then takes every
+     * scheme from env_hm_infer_define's cache. */
+    {
+        const char **names = malloc(sizeof(char *) * (count ? count : 1));
+        AST **lambdas = malloc(sizeof(AST *) * (count ? count : 1));
+        Env *seen = env_create();
+        int n = 0;
+        for (size_t i = first_code; i < count; i++) {
+            const char *name = NULL;
+            AST *lambda = NULL;
+            if (!codegen_define_lambda_parts(exprs[i], &name, &lambda))
+                continue;
+            if (env_lookup(seen, name) ||
+                (env_lookup(ctx->env, name) &&
+                 env_lookup(ctx->env, name)->module_name == NULL))
+                continue;
+            env_insert(seen, name, NULL, NULL);
+            names[n] = name;
+            lambdas[n] = lambda;
+            n++;
+        }
+        env_free(seen);
+
+        time_trace_begin("infer", parser_get_filename());
+        InferDefGraph graph;
+        infer_def_graph_build(&graph, names, lambdas, n);
+        for (int k = 0; k < graph.count; k++)
+            env_hm_infer_define(ctx->env, names[graph.order[k]],
+                                lambdas[graph.order[k]], parser_get_filename());
+        infer_def_graph_free(&graph);
+        time_trace_end();
+        free(names);
+        free(lambdas);
+    }
+
     for (size_t i = first_code; i < count; i++) {
         const char *name = NULL;
         AST *lambda = NULL;
@@ -6141,28 +7095,41 @@ static bool codegen_finite_literal(CodegenContext *ctx, AST *ast,
 /* Inline an imported core definition through the language's ordinary lambda
  * application path.  Exported source is optimization metadata, not a second
  * implementation: semantics remain owned by the defining .mon module. */
-static bool codegen_inline_imported(CodegenContext *ctx, AST *call,
-                                    EnvEntry *entry, CodegenResult *out) {
+static AST *codegen_inline_candidate(CodegenContext *ctx, EnvEntry *entry,
+                                     int argc) {
     if (ctx->optimization_level <= 0 || ctx->core_inline_depth >= 8 ||
         !entry || !entry->module_name || entry->is_ffi ||
         entry->is_closure_abi || !entry->source_ast)
-        return false;
+        return NULL;
 
     AST *lambda = entry->source_ast;
     if (lambda->type == AST_LIST && lambda->list.count >= 3)
         lambda = lambda->list.items[2];
     if (!lambda || lambda->type != AST_LAMBDA ||
-        lambda->lambda.param_count != (int)call->list.count - 1)
-        return false;
+        lambda->lambda.param_count != argc)
+        return NULL;
+    return lambda;
+}
 
-    Env *saved_env = ctx->env;
+/* Bind already-evaluated arguments to the lambda's parameters and emit its
+ * body.  `as_fn` stands in for the current function while the body is
+ * emitted, so an instance method keeps the self-dispatch guards it has when
+ * compiled on its own (e.g. `=` inside __impl_Eq_* is primitive equality). */
+static bool codegen_inline_bind(CodegenContext *ctx, AST *lambda,
+                                CodegenResult *args, const char *as_fn,
+                                CodegenResult *out) {
+    Env        *saved_env = ctx->env;
+    const char *saved_fn  = ctx->current_function_name;
     ctx->env = env_create_child(saved_env);
+    if (as_fn) ctx->current_function_name = as_fn;
     ctx->core_inline_depth++;
 
     for (int i = 0; i < lambda->lambda.param_count; i++) {
-        CodegenResult init = codegen_expr(ctx, call->list.items[i + 1]);
+        CodegenResult init = args[i];
         ASTParam *param = &lambda->lambda.params[i];
         LLVMTypeRef llvm_type = type_to_llvm(ctx, init.type);
+        if (LLVMTypeOf(init.value) != llvm_type)
+            init.value = emit_type_cast(ctx, init.value, llvm_type);
         LLVMValueRef slot = LLVMBuildAlloca(ctx->builder, llvm_type,
                                             param->name ? param->name
                                                         : "core_inline_arg");
@@ -6179,11 +7146,27 @@ static bool codegen_inline_imported(CodegenContext *ctx, AST *call,
     }
 
     ctx->core_inline_depth--;
+    ctx->current_function_name = saved_fn;
     ctx->env = saved_env;
     *out = body;
     return body.value != NULL;
 }
 
+static bool codegen_inline_imported(CodegenContext *ctx, AST *call,
+                                    EnvEntry *entry, const char *as_fn,
+                                    CodegenResult *out) {
+    int  argc   = (int)call->list.count - 1;
+    AST *lambda = codegen_inline_candidate(ctx, entry, argc);
+    if (!lambda) return false;
+
+    CodegenResult *args = malloc(sizeof(CodegenResult) * (argc ? argc : 1));
+    for (int i = 0; i < argc; i++)
+        args[i] = codegen_expr(ctx, call->list.items[i + 1]);
+    bool ok = codegen_inline_bind(ctx, lambda, args, as_fn, out);
+    free(args);
+    return ok;
+}
+
 static AST *finite_member_to_ast(const FiniteTypeMember *member,
                                  const char *type_name,
                                  size_t cardinality) {
@@ -6948,7 +7931,7 @@ static CodegenResult codegen_check_laws(CodegenContext *ctx, AST *ast) {
     return result;
 }
 
-CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
+static CodegenResult codegen_expr_node(CodegenContext *ctx, AST *ast) {
     CodegenResult result = {NULL, NULL};
 
     /* setenv("REPL_DUMP_IR", "1", 1); */
@@ -7259,14 +8242,14 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                  * Otherwise use integer arithmetic.                    */
                 const char *sym = ast->symbol;
 
-                /* Check if either arg is a float by inspecting the type tag.
-                 * RuntimeValue.type is the first field (int at offset 0).   */
+                /* Check if either arg is a float by inspecting the type tag
+                 * (immediate or RuntimeValue.type at offset 0).             */
                 LLVMTypeRef  i32_t   = LLVMInt32TypeInContext(ctx->context);
                 LLVMValueRef rt_float_tag = LLVMConstInt(i32_t, RT_FLOAT, 0);
 
                 /* Load type tag of ba and bb */
-                LLVMValueRef tag_a = LLVMBuildLoad2(ctx->builder, i32_t, ba, "tag_a");
-                LLVMValueRef tag_b = LLVMBuildLoad2(ctx->builder, i32_t, bb, "tag_b");
+                LLVMValueRef tag_a = emit_value_tag(ctx, ba, "tag_a");
+                LLVMValueRef tag_b = emit_value_tag(ctx, bb, "tag_b");
                 LLVMValueRef is_float_a = LLVMBuildICmp(ctx->builder, LLVMIntEQ,
                                                          tag_a, rt_float_tag, "ifa");
                 LLVMValueRef is_float_b = LLVMBuildICmp(ctx->builder, LLVMIntEQ,
@@ -7496,19 +8479,24 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
             elem_type = first.type ? type_clone(first.type) : type_int();
         } else elem_type = type_int();
 
+        /* Elements are stored straight into the heap data, so the literal
+         * is built once and never copied on its way to a C pointer. */
         int n = (int)ast->array.element_count;
-        LLVMTypeRef elem_llvm = type_to_llvm(ctx, elem_type);
-        LLVMTypeRef arr_llvm  = LLVMArrayType(elem_llvm, n);
-        LLVMValueRef stack    = LLVMBuildAlloca(ctx->builder, arr_llvm, "arr_stack");
+        LLVMTypeRef  elem_llvm = type_to_llvm(ctx, elem_type);
+        LLVMValueRef data_heap;
+        LLVMValueRef fat  = arr_alloc_fat(ctx, LLVMConstInt(LLVMInt64TypeInContext(ctx->context), n, 0),
+                                          elem_type, &data_heap);
+        LLVMValueRef data = LLVMBuildBitCast(ctx->builder, data_heap,
+                                             LLVMPointerType(elem_llvm, 0), "arr_data");
 
         for (int i = 0; i < n; i++) {
             CodegenResult elem = codegen_expr(ctx, ast->array.elements[i]);
             LLVMValueRef ev = elem.type && elem_type ? emit_type_cast(ctx, elem.value, elem_llvm) : elem.value;
-            LLVMValueRef idxs[] = {LLVMConstInt(LLVMInt32TypeInContext(ctx->context), 0, 0), LLVMConstInt(LLVMInt32TypeInContext(ctx->context), i, 0)};
-            LLVMBuildStore(ctx->builder, ev, LLVMBuildGEP2(ctx->builder, arr_llvm, stack, idxs, 2, "ep"));
+            LLVMValueRef idx = LLVMConstInt(LLVMInt64TypeInContext(ctx->context), i, 0);
+            LLVMBuildStore(ctx->builder, ev, LLVMBuildGEP2(ctx->builder, elem_llvm, data, &idx, 1, "ep"));
         }
 
-        result.value = arr_make_fat(ctx, stack, n, elem_type);
+        result.value = fat;
         result.type  = ast->array.is_heap
             ? type_arr_heap(type_clone(elem_type))
             : type_arr_fat(type_clone(elem_type));
@@ -8655,39 +9643,22 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
 
                     // env param (index 0 in closure ABI)
                     LLVMValueRef env_llvm_param = NULL;
+                    LLVMValueRef worker         = NULL;
                     if (use_closure_abi) {
                         env_llvm_param = LLVMGetParam(func, 0);
                         LLVMSetValueName2(env_llvm_param, "env", 3);
 
                         // Self-bind the function inside its own body to avoid outer scope access
-                        if (ctx->current_function_name != NULL) {
-                            LLVMTypeRef ptr_t = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
-                            LLVMValueRef fn_ptr = LLVMBuildBitCast(ctx->builder, func, ptr_t, "fn_ptr");
-                            LLVMTypeRef i32t = LLVMInt32TypeInContext(ctx->context);
-                            LLVMValueRef clo_fn = get_rt_value_closure(ctx);
-                            LLVMTypeRef clo_params[] = {ptr_t, ptr_t, i32t, i32t};
-                            LLVMTypeRef clo_ft = LLVMFunctionType(ptr_t, clo_params, 4, 0);
-                            LLVMValueRef clo_args[] = {
-                                fn_ptr, env_llvm_param,
-                                LLVMConstInt(i32t, captured_count, 0),
-                                LLVMConstInt(i32t, total_params, 0)
-                            };
-                            LLVMValueRef self_clo = LLVMBuildCall2(ctx->builder, clo_ft, clo_fn, clo_args, 4, "self_clo");
-                            LLVMValueRef self_alloca = LLVMBuildAlloca(ctx->builder, ptr_t, var_name);
-                            LLVMBuildStore(ctx->builder, self_clo, self_alloca);
-                            env_insert(ctx->env, var_name, type_fn(NULL, 0, NULL), self_alloca);
-                            EnvEntry *clo_var = env_lookup(ctx->env, var_name);
-                            if (clo_var) {
-                                clo_var->func_ref       = func;
-                                clo_var->is_closure_abi = true;
-                                clo_var->param_count    = total_params;
-                                clo_var->params         = clone_params(env_params, total_params);
-                                clo_var->return_type    = type_clone(ret_type);
-                            }
-                        }
+                        LLVMValueRef self_bind = NULL;
+                        if (ctx->current_function_name != NULL)
+                            self_bind = codegen_closure_bind_self(ctx, func, NULL, env_llvm_param,
+                                                                  var_name, captured_count,
+                                                                  env_params, total_params, ret_type);
 
                         /* param 1 = n (ignored), param 2 = args array */
                         LLVMValueRef args_param = LLVMGetParam(func, 2);
+                        LLVMValueRef *param_slots = calloc(total_params ? total_params : 1,
+                                                           sizeof(LLVMValueRef));
 
                         for (int i = 0; i < total_params; i++) {
                             if (lambda->lambda.naked) continue;
@@ -8778,7 +9749,77 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                             LLVMBuildStore(ctx->builder, unboxed, alloca);
                             env_insert(ctx->env, lambda->lambda.params[i].name,
                                        type_clone(param_type), alloca);
+                            param_slots[i] = alloca;
+                        }
+
+                        /* Worker/wrapper: once every parameter is known to be an
+                         * Int, Float or Bool, the body goes into an unboxed worker
+                         * (env, params...) returning the raw result, and this
+                         * function shrinks to a wrapper that unboxes args[], calls
+                         * the worker and boxes the result for rt_closure_call*.
+                         * Calls that can see the closure (self-recursion, a local
+                         * binding) go to the worker and never box.               */
+                        if (codegen_closure_wants_worker(lambda, env_params, total_params,
+                                                         saved_env, captured_vars,
+                                                         captured_count)) {
+                            LLVMTypeRef  w_ret    = codegen_type_is_unboxed_scalar(ret_type)
+                                                  ? type_to_llvm(ctx, ret_type) : ptr_t;
+                            LLVMTypeRef *w_params = malloc(sizeof(LLVMTypeRef) * (total_params + 1));
+                            w_params[0] = ptr_t;
+                            for (int i = 0; i < total_params; i++)
+                                w_params[i + 1] = type_to_llvm(ctx, env_params[i].type);
+                            LLVMTypeRef w_ft = LLVMFunctionType(w_ret, w_params, total_params + 1, 0);
+                            char w_name[320];
+                            snprintf(w_name, sizeof(w_name), "%s__worker", LLVMGetValueName(func));
+                            worker = LLVMAddFunction(ctx->module, w_name, w_ft);
+                            LLVMSetLinkage(worker, LLVMInternalLinkage);
+                            EnvEntry *fwd = env_lookup(saved_env, var_name);
+                            if (fwd && fwd->func_ref == func) fwd->worker_ref = worker;
+
+                            LLVMValueRef *w_args = malloc(sizeof(LLVMValueRef) * (total_params + 1));
+                            w_args[0] = env_llvm_param;
+                            for (int i = 0; i < total_params; i++)
+                                w_args[i + 1] = LLVMBuildLoad2(ctx->builder, w_params[i + 1],
+                                                               param_slots[i], "w_arg");
+                            LLVMValueRef w_res = LLVMBuildCall2(ctx->builder, w_ft, worker, w_args,
+                                                                total_params + 1, "worker");
+                            LLVMBuildRet(ctx->builder, emit_type_cast(ctx, w_res, ptr_t));
+                            free(w_args);
+
+                            /* The wrapper no longer runs the body, so its self
+                             * binding (an allocation per call) is dead. */
+                            if (self_bind) {
+                                LLVMValueRef self_clo  = LLVMGetOperand(self_bind, 0);
+                                LLVMValueRef self_slot = LLVMGetOperand(self_bind, 1);
+                                LLVMInstructionEraseFromParent(self_bind);
+                                LLVMInstructionEraseFromParent(self_slot);
+                                LLVMInstructionEraseFromParent(self_clo);
+                            }
+
+                            LLVMBasicBlockRef w_entry = LLVMAppendBasicBlockInContext(
+                                                            ctx->context, worker, "entry");
+                            LLVMPositionBuilderAtEnd(ctx->builder, w_entry);
+                            ctx->init_fn = worker;
+                            env_free(ctx->env);
+                            ctx->env = env_create_child(saved_env);
+                            env_llvm_param = LLVMGetParam(worker, 0);
+                            LLVMSetValueName2(env_llvm_param, "env", 3);
+                            if (ctx->current_function_name != NULL)
+                                codegen_closure_bind_self(ctx, func, worker, env_llvm_param,
+                                                          var_name, captured_count,
+                                                          env_params, total_params, ret_type);
+                            for (int i = 0; i < total_params; i++) {
+                                const char  *pname  = lambda->lambda.params[i].name;
+                                LLVMValueRef param  = LLVMGetParam(worker, i + 1);
+                                LLVMSetValueName2(param, pname, strlen(pname));
+                                LLVMValueRef alloca = LLVMBuildAlloca(ctx->builder, w_params[i + 1], pname);
+                                LLVMBuildStore(ctx->builder, param, alloca);
+                                env_insert(ctx->env, pname, type_clone(env_params[i].type), alloca);
+                            }
+                            ret_llvm_type = w_ret;
+                            free(w_params);
                         }
+                        free(param_slots);
                     } else {
                         // Typed ABI — bind parameters normally
                         for (int i = 0; i < total_params; i++) {
@@ -8976,7 +10017,7 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                             int prev_closure_param_count = ctx->current_closure_param_count;
                             char *owned_fn = strdup(var_name);
                             ctx->current_function_name = owned_fn;
-                            ctx->current_closure_abi = use_closure_abi;
+                            ctx->current_closure_abi = use_closure_abi && !worker;
                             ctx->current_closure_param_count = total_params;
                             int last_body_index = -1;
                             for (int i = lambda->lambda.body_count - 1; i >= 0; i--) {
@@ -9038,22 +10079,9 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
 
                         if (captured_count > 0) {
                             LLVMTypeRef  arr_t = LLVMArrayType(ptr_t, captured_count);
-                            /* Heap-allocate the env array so it survives across
-                             * module boundaries and dlopen'd .so calls          */
-                            LLVMValueRef malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-                            if (!malloc_fn) {
-                                LLVMTypeRef i64_t = LLVMInt64TypeInContext(ctx->context);
-                                LLVMTypeRef mft = LLVMFunctionType(ptr_t, &i64_t, 1, 0);
-                                malloc_fn = LLVMAddFunction(ctx->module, "malloc", mft);
-                                LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-                            }
-                            LLVMTypeRef  i64_t    = LLVMInt64TypeInContext(ctx->context);
-                            LLVMValueRef arr_size = LLVMSizeOf(arr_t);
-                            LLVMValueRef heap_ptr = LLVMBuildCall2(ctx->builder,
-                                LLVMFunctionType(ptr_t, &i64_t, 1, 0),
-                                malloc_fn, &arr_size, 1, "clo_env_heap");
-                            LLVMValueRef arr = LLVMBuildBitCast(ctx->builder,
-                                heap_ptr, LLVMPointerType(arr_t, 0), "clo_env");
+                            /* Staging only — rt_value_closure copies the
+                             * captures into the closure's own allocation   */
+                            LLVMValueRef arr   = LLVMBuildAlloca(ctx->builder, arr_t, "clo_env");
                             for (int i = 0; i < captured_count; i++) {
                                 EnvEntry    *cap_e   = env_lookup(ctx->env, captured_vars[i]);
                                 LLVMValueRef cap_val = LLVMConstPointerNull(ptr_t);
@@ -9090,10 +10118,17 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
 
          ///// Register in symbol table
 
+                    // source_ast is read-only once registered, so the alias
+                    // below shares this snapshot instead of cloning it again.
+                    AST *lambda_snapshot = NULL;
                     if (self_alloca) {
                         if (hm_scheme) env_set_scheme(ctx->env, var_name, hm_scheme);
                         EnvEntry *efinal = env_lookup(ctx->env, var_name);
-                        if (efinal) efinal->source_ast = ast_clone(lambda);
+                        if (efinal) {
+                            efinal->source_ast = ast_clone(lambda);
+                            efinal->worker_ref = worker;
+                            lambda_snapshot    = efinal->source_ast;
+                        }
                     } else {
                         env_insert_func(ctx->env, var_name, env_params, total_params,
                                         ret_type, func, lambda->lambda.docstring, NULL);
@@ -9102,9 +10137,11 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                         if (efinal) {
                             efinal->lifted_count   = 0;
                             efinal->is_closure_abi = use_closure_abi;
+                            efinal->worker_ref     = worker;
                             // Clone the lambda AFTER body desugaring so source_ast
                             // contains the expanded if-chain, not the raw AST_PMATCH.
                             efinal->source_ast     = ast_clone(lambda);
+                            lambda_snapshot        = efinal->source_ast;
                         }
                     }
 
@@ -9113,7 +10150,9 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                         if (self_alloca) {
                             if (hm_scheme) env_set_scheme(ctx->env, alias_sym, hm_scheme);
                             EnvEntry *alias_e = env_lookup(ctx->env, alias_sym);
-                            if (alias_e) alias_e->source_ast = ast_clone(lambda);
+                            if (alias_e)
+                                alias_e->source_ast = lambda_snapshot ? lambda_snapshot
+                                                                      : ast_clone(lambda);
                         } else {
                             env_insert_func(ctx->env, alias_sym,
                                             clone_params(env_params, total_params),
@@ -9125,7 +10164,8 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                             if (alias_e) {
                                 alias_e->is_closure_abi = use_closure_abi;
                                 alias_e->lifted_count   = 0;
-                                alias_e->source_ast     = ast_clone(lambda);
+                                alias_e->source_ast     = lambda_snapshot ? lambda_snapshot
+                                                                          : ast_clone(lambda);
                                 alias_e->func_ref       = func;
                                 alias_e->llvm_name      = strdup(LLVMGetValueName(func));
                             }
@@ -9190,6 +10230,7 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                             EnvEntry *clo_var = env_lookup(ctx->env, var_name);
                             if (clo_var) {
                                 clo_var->func_ref       = func;
+                                clo_var->worker_ref     = worker;
                                 clo_var->is_closure_abi = true;
                                 clo_var->param_count    = total_params;
                                 clo_var->params         = clone_params(env_params, total_params);
@@ -9439,6 +10480,7 @@ CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
                         LLVMSetLinkage(var, linkage);
                     }
                     LLVMBuildStore(ctx->builder, stored_value, var);
+                    if (g_watch_count) codegen_watch_define(ctx, var_name, var);
                 } else {
                     var = LLVMBuildAlloca(ctx->builder, llvm_type, var_name);
                     LLVMBuildStore(ctx->builder, stored_value, var);
@@ -9576,8 +10618,7 @@ if (ast->list.count >= 5) {
                     }
                     if (type_preds[_pi].tag < 0) { result.value = LLVMConstInt(i1, 0, 0); result.type = type_bool(); return result; }
                     LLVMValueRef val = LLVMTypeOf(arg.value) != ptr ? LLVMBuildBitCast(ctx->builder, arg.value, ptr, "rv_ptr") : arg.value;
-                    LLVMValueRef tag_ptr = LLVMBuildGEP2(ctx->builder, LLVMInt8TypeInContext(ctx->context), val, (LLVMValueRef[]){LLVMConstInt(i32, 0, 0)}, 1, "tp");
-                    LLVMValueRef tag = LLVMBuildLoad2(ctx->builder, i32, LLVMBuildBitCast(ctx->builder, tag_ptr, LLVMPointerType(i32, 0), "tp32"), "tag");
+                    LLVMValueRef tag = emit_value_tag(ctx, val, "tag");
                     LLVMValueRef cmp = LLVMBuildICmp(ctx->builder, LLVMIntEQ, tag, LLVMConstInt(i32, type_preds[_pi].tag, 0), "eq");
                     if (type_preds[_pi].tag2 >= 0) cmp = LLVMBuildOr(ctx->builder, cmp, LLVMBuildICmp(ctx->builder, LLVMIntEQ, tag, LLVMConstInt(i32, type_preds[_pi].tag2, 0), "eq2"), "or");
                     result.value = cmp; result.type = type_bool(); return result;
@@ -10942,12 +11983,7 @@ if (ast->list.count >= 5) {
                 // Pack free vars into heap env array (boxed)
                 LLVMValueRef env_array_ptr = LLVMConstNull(ptr);
                 if (free_count > 0) {
-                    LLVMValueRef malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-                    if (!malloc_fn) {
-                        LLVMTypeRef mft = LLVMFunctionType(ptr, &i64, 1, 0);
-                        malloc_fn = LLVMAddFunction(ctx->module, "malloc", mft);
-                        LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-                    }
+                    LLVMValueRef malloc_fn = get_rt_alloc(ctx);
                     LLVMValueRef arr_bytes = LLVMConstInt(i64, sizeof(void*) * free_count, 0);
                     LLVMValueRef heap_arr  = LLVMBuildCall2(ctx->builder,
                                                             LLVMFunctionType(ptr, &i64, 1, 0),
@@ -11306,6 +12342,17 @@ if (ast->list.count >= 5) {
                     ast->list.items[2]->type == AST_STRING ||
                     (right_r.type && right_r.type->kind == TYPE_STRING);
 
+                /* String ++ String: both sides are already C strings, so
+                 * join them directly instead of boxing each into a runtime
+                 * string (a copy apiece) and unboxing the result. */
+                if (left_is_string && right_is_string) {
+                    result.value = emit_call_2(ctx, get_rt_string_concat(ctx), ptr,
+                                               left_r.value, right_r.value,
+                                               "concat_string");
+                    result.type = type_string();
+                    return result;
+                }
+
                 /* String-involved collection concat.
                  * A string can be rebuilt by Char ++ String during filter,
                  * takeWhile, map, etc. append also uses String ++ Char.
@@ -11555,6 +12602,18 @@ if (ast->list.count >= 5) {
                 result.value = lr.value; result.type = type_list(NULL, 0); return result;
             }
 
+            {
+                int kernel = arr_kernel_index(ctx, head->symbol);
+                if (kernel >= 0)
+                    return codegen_array_kernel(ctx, ast, &ARR_KERNELS[kernel]);
+            }
+
+            if (strcmp(head->symbol, "array-borrow") == 0) {
+                EnvEntry *e = env_lookup(ctx->env, head->symbol);
+                if (!e || e->kind == ENV_BUILTIN)
+                    return codegen_array_borrow(ctx, ast);
+            }
+
             // (make-list n) or (make-list n val) -> List
             if (strcmp(head->symbol, "make-list") == 0) {
                 LLVMTypeRef  ptr   = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
@@ -12259,6 +13318,7 @@ if (ast->list.count >= 5) {
                 const char  *var_name;
                 bool         has_var;
                 bool         negative_step;
+                bool         unit_step = true;
 
                 if (binding->type == AST_NUMBER || binding->type == AST_SYMBOL) {
                     if (binding->type == AST_SYMBOL && ast->list.count > 3 &&
@@ -12379,6 +13439,9 @@ if (ast->list.count >= 5) {
                     negative_step = (binding->array.element_count == 4 &&
                                      binding->array.elements[3]->type == AST_NUMBER &&
                                      binding->array.elements[3]->number < 0);
+                    unit_step     = (binding->array.element_count == 3 ||
+                                     (binding->array.elements[3]->type == AST_NUMBER &&
+                                      binding->array.elements[3]->number == 1));
                 }
 
                 LLVMValueRef i_ptr = LLVMBuildAlloca(ctx->builder, i64, var_name);
@@ -12388,6 +13451,11 @@ if (ast->list.count >= 5) {
                 LLVMBasicBlockRef body_bb  = LLVMAppendBasicBlockInContext(ctx->context, func, "for_body");
                 LLVMBasicBlockRef after_bb = LLVMAppendBasicBlockInContext(ctx->context, func, "for_after");
 
+                CodegenLoop loop;
+                bool        counted = has_var && unit_step;
+                if (counted)
+                    loop_enter(ctx, &loop, ast, var_name, i_ptr, start_val, end_val);
+
                 LLVMBuildBr(ctx->builder, cond_bb);
 
                 // Condition
@@ -12408,6 +13476,8 @@ if (ast->list.count >= 5) {
                 for (size_t bi = 2; bi < ast->list.count; bi++)
                     codegen_expr(ctx, ast->list.items[bi]);
 
+                if (counted)
+                    loop_leave(ctx, &loop);
                 env_free(ctx->env);
                 ctx->env = saved_env;
 
@@ -12561,6 +13631,13 @@ if (ast->list.count >= 5) {
             if (strcmp(head->symbol, "__rt_map_keys")    == 0) return codegen_map_op(ctx, ast, get_rt_map_keys,       "__rt_map_keys",    1);
             if (strcmp(head->symbol, "__rt_map_values")  == 0) return codegen_map_op(ctx, ast, get_rt_map_vals,       "__rt_map_values",  1);
 
+            // Private parallel intrinsics. Public pmap/pfilter/pfold live in Data.List.
+            if (strcmp(head->symbol, "__rt_par_map")    == 0) return codegen_par_op(ctx, ast, get_rt_par_map,    "__rt_par_map",    2);
+            if (strcmp(head->symbol, "__rt_par_filter") == 0) return codegen_par_op(ctx, ast, get_rt_par_filter, "__rt_par_filter", 2);
+            if (strcmp(head->symbol, "__rt_par_fold")   == 0) return codegen_par_op(ctx, ast, get_rt_par_fold,   "__rt_par_fold",   3);
+            const FiberOp *fiber_op = fiber_op_lookup(head->symbol);
+            if (fiber_op) return codegen_fiber_op(ctx, ast, fiber_op);
+
             if (strcmp(head->symbol, "__rt_map_find") == 0) {
                 REQUIRE_ARGS(2);
                 LLVMTypeRef ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
@@ -13075,20 +14152,9 @@ if (ast->list.count >= 5) {
 
                     LLVMPositionBuilderAtEnd(ctx->builder, saved_bb);
 
-                    /* Build env: [op_ptr, boxed_captured_arg] — heap alloc so closure outlives stack frame */
+                    /* Build env: [op_ptr, boxed_captured_arg] — the closure copies it */
                     LLVMTypeRef  env_arr_t = LLVMArrayType(ptr_t, 2);
-                    LLVMValueRef env_sz    = LLVMConstInt(LLVMInt64TypeInContext(ctx->context),
-                                                          2 * sizeof(void*), 0);
-                    LLVMValueRef malloc_fn2 = LLVMGetNamedFunction(ctx->module, "malloc");
-                    if (!malloc_fn2) {
-                        LLVMTypeRef i64t2 = LLVMInt64TypeInContext(ctx->context);
-                        LLVMTypeRef ft2   = LLVMFunctionType(ptr_t, &i64t2, 1, 0);
-                        malloc_fn2 = LLVMAddFunction(ctx->module, "malloc", ft2);
-                        LLVMSetLinkage(malloc_fn2, LLVMExternalLinkage);
-                    }
-                    LLVMValueRef env_arr   = LLVMBuildCall2(ctx->builder,
-                        LLVMFunctionType(ptr_t, &(LLVMTypeRef){LLVMInt64TypeInContext(ctx->context)}, 1, 0),
-                        malloc_fn2, &env_sz, 1, "pcmp_env");
+                    LLVMValueRef env_arr   = LLVMBuildAlloca(ctx->builder, env_arr_t, "pcmp_env");
                     LLVMValueRef s0 = LLVMBuildGEP2(ctx->builder, env_arr_t, env_arr,
                                          (LLVMValueRef[]){LLVMConstInt(i32,0,0),LLVMConstInt(i32,0,0)}, 2, "s0");
                     LLVMValueRef s1 = LLVMBuildGEP2(ctx->builder, env_arr_t, env_arr,
@@ -13268,32 +14334,31 @@ if (ast->list.count >= 5) {
                     LLVMTypeRef  i32_t = LLVMInt32TypeInContext(ctx->context);
                     LLVMTypeRef  i64_t = LLVMInt64TypeInContext(ctx->context);
 
-                    /* Pass raw values — typed ABI methods take the concrete
-                     * type directly (ADT heap ptr, int, etc.)               */
+                    /* Devirtualize: an imported instance whose source was
+                     * exported is emitted in place, so `(= a b)` on Int
+                     * becomes the icmp its Eq Int method is written as. */
+                    {
+                        const char *impl_name   = strstr(fn_name, "__impl_");
+                        EnvEntry   *impl_entry  = impl_name ? env_lookup(ctx->env, impl_name) : NULL;
+                        AST        *impl_lambda = codegen_inline_candidate(ctx, impl_entry, 2);
+                        CodegenResult tc_args[2] = {lhs, rhs};
+                        CodegenResult inlined;
+                        if (impl_lambda &&
+                            codegen_inline_bind(ctx, impl_lambda, tc_args, impl_name, &inlined)) {
+                            LLVMValueRef v = inlined.value;
+                            if (LLVMGetTypeKind(LLVMTypeOf(v)) == LLVMPointerTypeKind)
+                                v = emit_call_1(ctx, get_rt_unbox_int(ctx), i64_t, v, "tc_unbox");
+                            if (LLVMTypeOf(v) != LLVMInt1TypeInContext(ctx->context))
+                                v = LLVMBuildICmp(ctx->builder, LLVMIntNE, v,
+                                                  LLVMConstNull(LLVMTypeOf(v)), "tc_bool");
+                            result.value = v;
+                            result.type  = type_bool();
+                            return result;
+                        }
+                    }
+
                     LLVMValueRef lv = lhs.value;
                     LLVMValueRef rv = rhs.value;
-                    /* Ensure ptr type for layout args */
-                    if (LLVMGetTypeKind(LLVMTypeOf(lv)) != LLVMPointerTypeKind &&
-                        lhs.type && lhs.type->kind != TYPE_LAYOUT)
-                        lv = codegen_box(ctx, lv, lhs.type);
-                    if (LLVMGetTypeKind(LLVMTypeOf(rv)) != LLVMPointerTypeKind &&
-                        rhs.type && rhs.type->kind != TYPE_LAYOUT)
-                        rv = codegen_box(ctx, rv, rhs.type);
-
-                    /* Method uses closure ABI: (ptr env, i32 n, ptr args[]) -> ptr
-                     * Build a 2-element args array on the stack and call directly */
-                    LLVMTypeRef  arr_t   = LLVMArrayType(ptr_t, 2);
-                    LLVMValueRef arr_ptr = LLVMBuildAlloca(ctx->builder, arr_t, "tc_args");
-                    LLVMValueRef zero    = LLVMConstInt(i32_t, 0, 0);
-                    LLVMValueRef one     = LLVMConstInt(i32_t, 1, 0);
-                    LLVMValueRef slot0   = LLVMBuildGEP2(ctx->builder, arr_t, arr_ptr,
-                                              (LLVMValueRef[]){zero, zero}, 2, "slot0");
-                    LLVMValueRef slot1   = LLVMBuildGEP2(ctx->builder, arr_t, arr_ptr,
-                                              (LLVMValueRef[]){zero, one},  2, "slot1");
-                    LLVMBuildStore(ctx->builder, lv, slot0);
-                    LLVMBuildStore(ctx->builder, rv, slot1);
-                    LLVMValueRef args_ptr = LLVMBuildBitCast(ctx->builder,
-                                               arr_ptr, ptr_t, "tc_args_ptr");
 
                     /* Determine the implementation ABI from its emitted signature. */
                     /* Instance registration can retain closure metadata after
@@ -13303,6 +14368,29 @@ if (ast->list.count >= 5) {
                     bool impl_is_clo = LLVMCountParams(fn) == 3;
                     LLVMValueRef call_r;
                     if (impl_is_clo) {
+                        /* Ensure ptr type for layout args */
+                        if (LLVMGetTypeKind(LLVMTypeOf(lv)) != LLVMPointerTypeKind &&
+                            lhs.type && lhs.type->kind != TYPE_LAYOUT)
+                            lv = codegen_box(ctx, lv, lhs.type);
+                        if (LLVMGetTypeKind(LLVMTypeOf(rv)) != LLVMPointerTypeKind &&
+                            rhs.type && rhs.type->kind != TYPE_LAYOUT)
+                            rv = codegen_box(ctx, rv, rhs.type);
+
+                        /* Closure ABI: (ptr env, i32 n, ptr args[]) -> ptr.
+                         * Build a 2-element args array on the stack. */
+                        LLVMTypeRef  arr_t   = LLVMArrayType(ptr_t, 2);
+                        LLVMValueRef arr_ptr = LLVMBuildAlloca(ctx->builder, arr_t, "tc_args");
+                        LLVMValueRef zero    = LLVMConstInt(i32_t, 0, 0);
+                        LLVMValueRef one     = LLVMConstInt(i32_t, 1, 0);
+                        LLVMValueRef slot0   = LLVMBuildGEP2(ctx->builder, arr_t, arr_ptr,
+                                                  (LLVMValueRef[]){zero, zero}, 2, "slot0");
+                        LLVMValueRef slot1   = LLVMBuildGEP2(ctx->builder, arr_t, arr_ptr,
+                                                  (LLVMValueRef[]){zero, one},  2, "slot1");
+                        LLVMBuildStore(ctx->builder, lv, slot0);
+                        LLVMBuildStore(ctx->builder, rv, slot1);
+                        LLVMValueRef args_ptr = LLVMBuildBitCast(ctx->builder,
+                                                   arr_ptr, ptr_t, "tc_args_ptr");
+
                         /* Closure ABI: fn(null_env, 2, args[]) -> ptr */
                         LLVMTypeRef  clo_params[] = {ptr_t, i32_t, ptr_t};
                         LLVMTypeRef  clo_ft       = LLVMFunctionType(ptr_t, clo_params, 3, 0);
@@ -13326,6 +14414,17 @@ if (ast->list.count >= 5) {
                         LLVMTypeRef *actual_params  = malloc(sizeof(LLVMTypeRef) * 2);
                         LLVMGetParamTypes(typed_ft, actual_params);
 
+                        /* Scalars go across unboxed unless the method takes
+                         * boxed values. */
+                        if (LLVMGetTypeKind(actual_params[0]) == LLVMPointerTypeKind &&
+                            LLVMGetTypeKind(LLVMTypeOf(lv)) != LLVMPointerTypeKind &&
+                            lhs.type && lhs.type->kind != TYPE_LAYOUT)
+                            lv = codegen_box(ctx, lv, lhs.type);
+                        if (LLVMGetTypeKind(actual_params[1]) == LLVMPointerTypeKind &&
+                            LLVMGetTypeKind(LLVMTypeOf(rv)) != LLVMPointerTypeKind &&
+                            rhs.type && rhs.type->kind != TYPE_LAYOUT)
+                            rv = codegen_box(ctx, rv, rhs.type);
+
                         LLVMValueRef typed_args[]   = {
                             emit_type_cast(ctx, lv, actual_params[0]),
                             emit_type_cast(ctx, rv, actual_params[1])
@@ -13757,20 +14856,9 @@ if (ast->list.count >= 5) {
 
                     LLVMPositionBuilderAtEnd(ctx->builder, saved_bb);
 
-                    /* Build env: [op_ptr, boxed_captured_arg] */
+                    /* Build env: [op_ptr, boxed_captured_arg] — the closure copies it */
                     LLVMTypeRef  env_arr_t = LLVMArrayType(ptr_t, 2);
-                    LLVMValueRef env_sz    = LLVMConstInt(LLVMInt64TypeInContext(ctx->context),
-                                                          2 * sizeof(void*), 0);
-                    LLVMValueRef malloc_fn2 = LLVMGetNamedFunction(ctx->module, "malloc");
-                    if (!malloc_fn2) {
-                        LLVMTypeRef i64t2 = LLVMInt64TypeInContext(ctx->context);
-                        LLVMTypeRef ft2   = LLVMFunctionType(ptr_t, &i64t2, 1, 0);
-                        malloc_fn2 = LLVMAddFunction(ctx->module, "malloc", ft2);
-                        LLVMSetLinkage(malloc_fn2, LLVMExternalLinkage);
-                    }
-                    LLVMValueRef env_arr   = LLVMBuildCall2(ctx->builder,
-                        LLVMFunctionType(ptr_t, &(LLVMTypeRef){LLVMInt64TypeInContext(ctx->context)}, 1, 0),
-                        malloc_fn2, &env_sz, 1, "parith_env");
+                    LLVMValueRef env_arr   = LLVMBuildAlloca(ctx->builder, env_arr_t, "parith_env");
                     LLVMValueRef s0 = LLVMBuildGEP2(ctx->builder, env_arr_t, env_arr,
                                          (LLVMValueRef[]){LLVMConstInt(i32,0,0),LLVMConstInt(i32,0,0)}, 2, "s0");
                     LLVMValueRef s1 = LLVMBuildGEP2(ctx->builder, env_arr_t, env_arr,
@@ -14117,8 +15205,12 @@ if (ast->list.count >= 5) {
                                 } else {
                                     /* Imported instance implementations are
                                      * deliberately not ordinary public API
-                                     * entries. Call their exported dictionary
+                                     * entries. Emit the exported body in place
+                                     * when there is one, otherwise call the
                                      * implementation symbol directly. */
+                                    if (codegen_inline_imported(ctx, ast, impl_entry,
+                                                                impl_name, &result))
+                                        return result;
                                     return codegen_forward_declared_call(ctx, ast,
                                                                          impl_name);
                                 }
@@ -14257,9 +15349,16 @@ if (ast->list.count >= 5) {
                         fat_for_size = LLVMBuildLoad2(ctx->builder, fat_pt,
                                                       entry->value, "fat_sz");
                     }
-                    LLVMValueRef arr_sz = arr_fat_size(ctx, fat_for_size);
-
-                    emit_bounds_check(ctx, ast, idx, arr_sz, "array index out of bounds");
+                    LLVMValueRef arr_sz   = arr_fat_size(ctx, fat_for_size);
+                    LLVMValueRef in_range = loop_hoisted_range(ctx, ast, entry);
+
+                    if (in_range)
+                        emit_runtime_check(ctx, ast,
+                            LLVMBuildOr(ctx->builder, in_range,
+                                        emit_in_bounds(ctx, idx, arr_sz), "idx_ok"),
+                            "array index out of bounds");
+                    else
+                        emit_bounds_check(ctx, ast, idx, arr_sz, "array index out of bounds");
                 }
 
                 /* Element type: use known type if available, fall back to i64. */
@@ -14375,7 +15474,7 @@ if (ast->list.count >= 5) {
                     idx = LLVMBuildZExt(ctx->builder, idx, i64, "idx64");
 
                 LLVMTypeRef i32_t = LLVMInt32TypeInContext(ctx->context);
-                LLVMValueRef tag = LLVMBuildLoad2(ctx->builder, i32_t, coll_val, "cidx_tag");
+                LLVMValueRef tag = emit_value_tag(ctx, coll_val, "cidx_tag");
                 LLVMValueRef is_str = LLVMBuildICmp(ctx->builder, LLVMIntEQ, tag,
                                                      LLVMConstInt(i32_t, RT_STRING, 0), "cidx_is_str");
 
@@ -14548,12 +15647,7 @@ if (ast->list.count >= 5) {
                             ? LLVMBuildBitCast(ctx->builder, arr_ptr2, ptr, "args_ptr")
                             : LLVMConstPointerNull(ptr);
                         /* Extract env from closure value via rt_closure_get_env */
-                        LLVMValueRef get_env_fn = LLVMGetNamedFunction(ctx->module, "rt_closure_get_env");
-                        if (!get_env_fn) {
-                            LLVMTypeRef ft = LLVMFunctionType(ptr, &ptr, 1, 0);
-                            get_env_fn = LLVMAddFunction(ctx->module, "rt_closure_get_env", ft);
-                            LLVMSetLinkage(get_env_fn, LLVMExternalLinkage);
-                        }
+                        LLVMValueRef get_env_fn = get_rt_closure_get_env(ctx);
                         LLVMValueRef env_ptr2 = LLVMBuildCall2(ctx->builder,
                             LLVMFunctionType(ptr, &ptr, 1, 0),
                             get_env_fn, &clo_val2, 1, "clo_env");
@@ -14628,11 +15722,7 @@ if (ast->list.count >= 5) {
                     free(boxed_args);
 
                     LLVMTypeRef get_ptr_ft = LLVMFunctionType(ptr, &ptr, 1, 0);
-                    LLVMValueRef get_env_fn = LLVMGetNamedFunction(ctx->module, "rt_closure_get_env");
-                    if (!get_env_fn) {
-                        get_env_fn = LLVMAddFunction(ctx->module, "rt_closure_get_env", get_ptr_ft);
-                        LLVMSetLinkage(get_env_fn, LLVMExternalLinkage);
-                    }
+                    LLVMValueRef get_env_fn = get_rt_closure_get_env(ctx);
                     LLVMValueRef get_fn_fn = get_rt_closure_get_fn_ptr(ctx);
                     LLVMValueRef clo_env = LLVMBuildCall2(ctx->builder, get_ptr_ft,
                                                           get_env_fn, &clo_val, 1, "tail_clo_env");
@@ -14652,6 +15742,18 @@ if (ast->list.count >= 5) {
                     return result;
                 }
 
+                /* One to three args: rt_closure_call1/2/3, no argv */
+                if (n_args >= 1 && n_args <= RT_CLOSURE_DIRECT_MAX) {
+                    LLVMValueRef bargs[RT_CLOSURE_DIRECT_MAX];
+                    for (int i = 0; i < n_args; i++) {
+                        CodegenResult ar = codegen_expr(ctx, ast->list.items[i + 1]);
+                        bargs[i]         = codegen_box(ctx, ar.value, ar.type);
+                    }
+                    result.value = codegen_closure_call_direct(ctx, clo_val, bargs, n_args, "clo_call");
+                    result.type  = type_unknown();
+                    return result;
+                }
+
                 /* Build args array on stack — array of ptr_t (RuntimeValue*) */
                 LLVMTypeRef  arr_t   = LLVMArrayType(ptr, n_args ? n_args : 1);
                 LLVMValueRef arr_ptr = LLVMBuildAlloca(ctx->builder, arr_t, "clo_args");
@@ -14774,11 +15876,7 @@ if (ast->list.count >= 5) {
                         free(boxed_args);
 
                         LLVMTypeRef get_ptr_ft = LLVMFunctionType(ptr_t, &ptr_t, 1, 0);
-                        LLVMValueRef get_env_fn = LLVMGetNamedFunction(ctx->module, "rt_closure_get_env");
-                        if (!get_env_fn) {
-                            get_env_fn = LLVMAddFunction(ctx->module, "rt_closure_get_env", get_ptr_ft);
-                            LLVMSetLinkage(get_env_fn, LLVMExternalLinkage);
-                        }
+                        LLVMValueRef get_env_fn = get_rt_closure_get_env(ctx);
                         LLVMValueRef get_fn_fn = get_rt_closure_get_fn_ptr(ctx);
                         LLVMValueRef clo_env = LLVMBuildCall2(ctx->builder, get_ptr_ft,
                                                               get_env_fn, &fn_value, 1, "tail_clo_env");
@@ -15055,6 +16153,9 @@ if (ast->list.count >= 5) {
                                     if (impl_entry && !impl_entry->module_name) {
                                         entry = impl_entry;
                                     } else {
+                                        if (codegen_inline_imported(ctx, ast, impl_entry,
+                                                                    impl_name, &result))
+                                            return result;
                                         return codegen_forward_declared_call(ctx, ast,
                                                                              impl_name);
                                     }
@@ -15441,7 +16542,7 @@ if (ast->list.count >= 5) {
                 }
 
                 if (!has_rest && arg_count == (size_t)declared_params &&
-                    codegen_inline_imported(ctx, ast, entry, &result))
+                    codegen_inline_imported(ctx, ast, entry, NULL, &result))
                     return result;
 
                 /* ── Monomorphization: specialize if polymorphic ─────────── */
@@ -15582,6 +16683,14 @@ if (ast->list.count >= 5) {
                      * and correctly passes the captured environment.          */
                     LLVMValueRef cur_fn                                   = LLVMGetBasicBlockParent(
                                              LLVMGetInsertBlock(ctx->builder));
+                    /* Self-recursion inside a worker stays unboxed. */
+                    if (ctx->current_function_name &&
+                        strcmp(head->symbol, ctx->current_function_name) == 0 &&
+                        entry->worker_ref && cur_fn == entry->worker_ref &&
+                        declared_params == entry->param_count) {
+                        return codegen_call_worker(ctx, entry, LLVMGetParam(cur_fn, 0),
+                                                   &ast->list.items[1], declared_params);
+                    }
                     if (ctx->current_function_name &&
                         strcmp(head->symbol, ctx->current_function_name) == 0 &&
                         cur_fn                                           == entry->func_ref) {
@@ -15663,17 +16772,34 @@ if (ast->list.count >= 5) {
                             LLVMValueRef  clo   = LLVMBuildLoad2(ctx->builder, ptr_t,
                                                               var_e->value, "clo_load");
 
+                            if (codegen_worker_callable(ctx, var_e) &&
+                                declared_params == var_e->param_count) {
+                                LLVMTypeRef  get_env_ft = LLVMFunctionType(ptr_t, &ptr_t, 1, 0);
+                                LLVMValueRef get_env_fn = get_rt_closure_get_env(ctx);
+                                LLVMValueRef clo_env = LLVMBuildCall2(ctx->builder, get_env_ft,
+                                                                      get_env_fn, &clo, 1, "clo_env");
+                                return codegen_call_worker(ctx, var_e, clo_env,
+                                                           &ast->list.items[1], declared_params);
+                            }
+
+                            /* One to three args: rt_closure_call1/2/3, no argv */
+                            if (declared_params >= 1 && declared_params <= RT_CLOSURE_DIRECT_MAX) {
+                                LLVMValueRef bargs[RT_CLOSURE_DIRECT_MAX];
+                                for (int i = 0; i < declared_params; i++) {
+                                    CodegenResult ar = codegen_expr(ctx, ast->list.items[i + 1]);
+                                    bargs[i]         = codegen_box(ctx, ar.value, ar.type);
+                                }
+                                result.value = codegen_closure_call_direct(ctx, clo, bargs, declared_params, "clo_call");
+                                result.type  = type_unknown();
+                                return result;
+                            }
+
                             /* Build args array on heap */
                             LLVMTypeRef     arr_t     = LLVMArrayType(ptr_t, declared_params ? declared_params : 1);
                             LLVMTypeRef     i64_t     = LLVMInt64TypeInContext(ctx->context);
                             LLVMValueRef    arr_size  = LLVMConstInt(i64_t,
                                                sizeof(void*) * (declared_params ? declared_params : 1), 0);
-                            LLVMValueRef    malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-                            if (!malloc_fn) {
-                                LLVMTypeRef ft        = LLVMFunctionType(ptr_t, &i64_t, 1, 0);
-                                malloc_fn             = LLVMAddFunction(ctx->module, "malloc", ft);
-                                LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-                            }
+                            LLVMValueRef    malloc_fn = get_rt_alloc(ctx);
                             LLVMValueRef      arr_ptr = LLVMBuildCall2(ctx->builder,
                                 LLVMFunctionType(ptr_t, &i64_t, 1, 0), malloc_fn, &arr_size, 1, "clo_args_heap");
                             for (int i = 0; i < declared_params; i++) {
@@ -15700,20 +16826,23 @@ if (ast->list.count >= 5) {
                             };
                             result.value              = LLVMBuildCall2(ctx->builder, calln_ft,
                                                           calln_fn, calln_a, 3, "clo_calln");
-                            LLVMValueRef    free_fn   = LLVMGetNamedFunction(ctx->module, "free");
-                            if (!free_fn) {
-                                LLVMTypeRef ft        = LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), &ptr_t, 1, 0);
-                                free_fn               = LLVMAddFunction(ctx->module, "free", ft);
-                                LLVMSetLinkage(free_fn, LLVMExternalLinkage);
-                            }
+                            LLVMValueRef    free_fn   = get_rt_free_sized(ctx);
+                            LLVMTypeRef     free_p[]  = {ptr_t, i64_t};
+                            LLVMValueRef    free_a[]  = {arr_ptr, arr_size};
                             LLVMBuildCall2(ctx->builder,
-                                LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), &ptr_t, 1, 0),
-                                free_fn, &arr_ptr, 1, "");
+                                LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), free_p, 2, 0),
+                                free_fn, free_a, 2, "");
                             result.type = type_unknown();
                             return result;
                         }
                     }
 
+                    /* Nothing captured: the worker runs with a null env too. */
+                    if (codegen_worker_callable(ctx, entry) &&
+                        declared_params == entry->param_count)
+                        return codegen_call_worker(ctx, entry, LLVMConstPointerNull(ptr_t),
+                                                   &ast->list.items[1], declared_params);
+
                     /* Wrap function in closure with empty env */
                     LLVMValueRef fn_ptr     = LLVMBuildBitCast(ctx->builder,
                                                             entry->func_ref, ptr_t, "fn_ptr");
@@ -15729,17 +16858,24 @@ if (ast->list.count >= 5) {
                     LLVMValueRef clo        = LLVMBuildCall2(ctx->builder, cft,
                                                       clo_fn, clo_args, 4, "direct_clo");
 
+                    /* One to three args: rt_closure_call1/2/3, no argv */
+                    if (declared_params >= 1 && declared_params <= RT_CLOSURE_DIRECT_MAX) {
+                        LLVMValueRef bargs[RT_CLOSURE_DIRECT_MAX];
+                        for (int i = 0; i < declared_params; i++) {
+                            CodegenResult ar = codegen_expr(ctx, ast->list.items[i + 1]);
+                            bargs[i]         = codegen_box(ctx, ar.value, ar.type);
+                        }
+                        result.value = codegen_closure_call_direct(ctx, clo, bargs, declared_params, "clo_call");
+                        result.type  = type_unknown();
+                        return result;
+                    }
+
                     /* Build args array on heap to avoid dynamic alloca in branches */
                     LLVMTypeRef     arr_t     = LLVMArrayType(ptr_t, declared_params ? declared_params : 1);
                     LLVMTypeRef     i64_t     = LLVMInt64TypeInContext(ctx->context);
                     LLVMValueRef    arr_size  = LLVMConstInt(i64_t,
                                                sizeof(void*) * (declared_params ? declared_params : 1), 0);
-                    LLVMValueRef    malloc_fn = LLVMGetNamedFunction(ctx->module, "malloc");
-                    if (!malloc_fn) {
-                        LLVMTypeRef ft        = LLVMFunctionType(ptr_t, &i64_t, 1, 0);
-                        malloc_fn             = LLVMAddFunction(ctx->module, "malloc", ft);
-                        LLVMSetLinkage(malloc_fn, LLVMExternalLinkage);
-                    }
+                    LLVMValueRef    malloc_fn = get_rt_alloc(ctx);
                     LLVMValueRef      arr_ptr_raw = LLVMBuildCall2(ctx->builder,
                         LLVMFunctionType(ptr_t, &i64_t, 1, 0), malloc_fn, &arr_size, 1, "clo_args_heap");
                     LLVMValueRef      arr_ptr     = arr_ptr_raw;
@@ -15771,15 +16907,12 @@ if (ast->list.count >= 5) {
                     result.value              = LLVMBuildCall2(ctx->builder, calln_ft,
                                                   calln_fn, calln_a, 3, "clo_calln");
                     /* Free the heap-allocated args array */
-                    LLVMValueRef    free_fn   = LLVMGetNamedFunction(ctx->module, "free");
-                    if (!free_fn) {
-                        LLVMTypeRef ft        = LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), &ptr_t, 1, 0);
-                        free_fn               = LLVMAddFunction(ctx->module, "free", ft);
-                        LLVMSetLinkage(free_fn, LLVMExternalLinkage);
-                    }
+                    LLVMValueRef    free_fn   = get_rt_free_sized(ctx);
+                    LLVMTypeRef     free_p[]  = {ptr_t, i64_t};
+                    LLVMValueRef    free_a[]  = {arr_ptr_raw, arr_size};
                     LLVMBuildCall2(ctx->builder,
-                        LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), &ptr_t, 1, 0),
-                        free_fn, &arr_ptr_raw, 1, "");
+                        LLVMFunctionType(LLVMVoidTypeInContext(ctx->context), free_p, 2, 0),
+                        free_fn, free_a, 2, "");
                     result.type = type_unknown();
                     return result;
                 }
@@ -16225,11 +17358,7 @@ if (ast->list.count >= 5) {
                                     if (LLVMGetTypeKind(raw_t) == LLVMIntegerTypeKind) {
                                         LLVMValueRef ext = LLVMBuildZExt(ctx->builder, raw, i64, "ext");
                                         LLVMTypeRef  bft = LLVMFunctionType(ptr_t, &i64, 1, 0);
-                                        LLVMValueRef vi  = LLVMGetNamedFunction(ctx->module, "rt_value_int");
-                                        if (!vi) {
-                                            vi = LLVMAddFunction(ctx->module, "rt_value_int", bft);
-                                            LLVMSetLinkage(vi, LLVMExternalLinkage);
-                                        }
+                                        LLVMValueRef vi  = get_rt_value_int(ctx);
                                         boxed = LLVMBuildCall2(ctx->builder, bft, vi, &ext, 1, "boxed");
                                     } else {
                                         boxed = LLVMBuildBitCast(ctx->builder, raw, ptr_t, "boxed");
@@ -16261,11 +17390,7 @@ if (ast->list.count >= 5) {
                                     LLVMBuildRetVoid(ctx->builder);
                                 } else if (LLVMGetTypeKind(cb_ret) == LLVMIntegerTypeKind) {
                                     LLVMTypeRef  uft     = LLVMFunctionType(i64, &ptr_t, 1, 0);
-                                    LLVMValueRef vi_fn   = LLVMGetNamedFunction(ctx->module, "rt_unbox_int");
-                                    if (!vi_fn) {
-                                        vi_fn = LLVMAddFunction(ctx->module, "rt_unbox_int", uft);
-                                        LLVMSetLinkage(vi_fn, LLVMExternalLinkage);
-                                    }
+                                    LLVMValueRef vi_fn   = get_rt_unbox_int(ctx);
                                     LLVMValueRef unboxed = LLVMBuildCall2(ctx->builder, uft, vi_fn, &ret, 1, "r");
                                     LLVMValueRef cast    = LLVMBuildIntCast2(ctx->builder, unboxed, cb_ret, 0, "r");
                                     LLVMBuildRet(ctx->builder, cast);
@@ -16362,12 +17487,11 @@ if (ast->list.count >= 5) {
                         if (!is_adt) {
                             /* Walk env to find if layout_name matches any ADT ctor's type */
                             for (size_t _bi = 0; _bi < ctx->env->size && !is_adt; _bi++) {
-                                for (EnvEntry *_e = ctx->env->buckets[_bi]; _e && !is_adt; _e = _e->next) {
-                                    if (_e->kind == ENV_ADT_CTOR && _e->type &&
-                                        _e->type->kind == TYPE_LAYOUT &&
-                                        strcmp(_e->type->layout_name, expected_type->layout_name) == 0)
-                                        is_adt = true;
-                                }
+                                EnvEntry *_e = ctx->env->slots[_bi];
+                                if (_e && _e->kind == ENV_ADT_CTOR && _e->type &&
+                                    _e->type->kind == TYPE_LAYOUT &&
+                                    strcmp(_e->type->layout_name, expected_type->layout_name) == 0)
+                                    is_adt = true;
                             }
                         }
                         if (is_adt) {
@@ -17387,6 +18511,18 @@ if (ast->list.count >= 5) {
                         LLVMTypeRef ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
                         LLVMTypeRef i32 = LLVMInt32TypeInContext(ctx->context);
                         int n_args = (int)ast->list.count - 1;
+                        /* One to three args: rt_closure_call1/2/3, no argv */
+                        if (n_args >= 1 && n_args <= RT_CLOSURE_DIRECT_MAX) {
+                            LLVMValueRef bargs[RT_CLOSURE_DIRECT_MAX];
+                            for (int i = 0; i < n_args; i++) {
+                                CodegenResult ar = codegen_expr(ctx, ast->list.items[i + 1]);
+                                bargs[i]         = codegen_box(ctx, ar.value, ar.type);
+                            }
+                            result.value = codegen_closure_call_direct(ctx, dot_val, bargs, n_args, "clo_call");
+                            result.type  = type_unknown();
+                            return result;
+                        }
+
                         LLVMTypeRef arr_t = LLVMArrayType(ptr, n_args ? n_args : 1);
                         LLVMValueRef arr_ptr = LLVMBuildAlloca(ctx->builder, arr_t, "call_args");
                         for (int i = 0; i < n_args; i++) {
@@ -17646,7 +18782,7 @@ if (ast->list.count >= 5) {
                     idx = LLVMBuildZExt(ctx->builder, idx, i64, "idx64");
 
                 LLVMTypeRef i32_t = LLVMInt32TypeInContext(ctx->context);
-                LLVMValueRef tag = LLVMBuildLoad2(ctx->builder, i32_t, fn_r.value, "cidx_tag");
+                LLVMValueRef tag = emit_value_tag(ctx, fn_r.value, "cidx_tag");
                 LLVMValueRef is_str = LLVMBuildICmp(ctx->builder, LLVMIntEQ, tag,
                                                      LLVMConstInt(i32_t, RT_STRING, 0), "cidx_is_str");
 
@@ -17711,6 +18847,18 @@ if (ast->list.count >= 5) {
                 return result;
             }
 
+            /* One to three args: rt_closure_call1/2/3, no argv */
+            if (n_args >= 1 && n_args <= RT_CLOSURE_DIRECT_MAX) {
+                LLVMValueRef bargs[RT_CLOSURE_DIRECT_MAX];
+                for (int i = 0; i < n_args; i++) {
+                    CodegenResult ar = codegen_expr(ctx, ast->list.items[i + 1]);
+                    bargs[i]         = codegen_box(ctx, ar.value, ar.type);
+                }
+                result.value = codegen_closure_call_direct(ctx, fn_r.value, bargs, n_args, "clo_call");
+                result.type  = type_unknown();
+                return result;
+            }
+
             LLVMTypeRef  arr_t   = LLVMArrayType(ptr_t, n_args ? n_args : 1);
             LLVMValueRef arr_ptr = LLVMBuildAlloca(ctx->builder, arr_t, "call_args");
             for (int i = 0; i < n_args; i++) {
@@ -18085,6 +19233,34 @@ if (ast->list.count >= 5) {
     return result;
 }
 
+static CodegenResult codegen_expr_sited(CodegenContext *ctx, AST *ast) {
+    if (!g_codegen_profile_sites)
+        return codegen_expr_node(ctx, ast);
+    int         line = g_site_line, col = g_site_col;
+    const char *fn   = g_site_fn;
+    g_site_line = ast->line;
+    g_site_col  = ast->column;
+    g_site_fn   = ctx->current_function_name;
+    CodegenResult result = codegen_expr_node(ctx, ast);
+    g_site_line = line;
+    g_site_col  = col;
+    g_site_fn   = fn;
+    return result;
+}
+
+CodegenResult codegen_expr(CodegenContext *ctx, AST *ast) {
+    if (!ast || ast->type != AST_LIST)
+        return codegen_expr_node(ctx, ast);
+    if (!g_breakpoint_count || g_break_in_condition)
+        return codegen_expr_sited(ctx, ast);
+    int open_line = g_break_open_line;
+    codegen_breakpoint_check(ctx, ast);
+    g_break_open_line = ast->line;
+    CodegenResult result = codegen_expr_sited(ctx, ast);
+    g_break_open_line = open_line;
+    return result;
+}
+
 
 /// Module
 
@@ -18123,6 +19299,15 @@ static void register_legacy_collection_builtins(CodegenContext *ctx) {
     env_insert_builtin(ctx->env, "__rt_map_dissoc",   2, 0, "Private immutable map deletion", NULL);
     env_insert_builtin(ctx->env, "__rt_map_dissoc!",  2, 0, "Private mutable map deletion", NULL);
     env_insert_builtin(ctx->env, "__rt_map_find",      2, 0, "Private map lookup", NULL);
+    env_insert_builtin(ctx->env, "__rt_par_map",       2, 0, "Private parallel map", NULL);
+    env_insert_builtin(ctx->env, "__rt_par_filter",    2, 0, "Private parallel filter", NULL);
+    env_insert_builtin(ctx->env, "__rt_par_fold",      3, 0, "Private parallel associative fold", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_spawn",   1, 0, "Private fiber spawn", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_yield",   1, 0, "Private fiber yield", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_run",     1, 0, "Private fiber scheduler loop", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_read",    3, 0, "Private fiber-aware read", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_write",   3, 0, "Private fiber-aware write", NULL);
+    env_insert_builtin(ctx->env, "__rt_fiber_accept",  1, 0, "Private fiber-aware accept", NULL);
     env_insert_builtin(ctx->env, "__rt_map_keys",      1, 0, "Private map key enumeration", NULL);
     env_insert_builtin(ctx->env, "__rt_map_values",    1, 0, "Private map value enumeration", NULL);
     env_insert_builtin(ctx->env, "__rt_map_merge",     2, 0, "Private map merge", NULL);
@@ -18149,6 +19334,13 @@ static void register_legacy_collection_builtins(CodegenContext *ctx) {
     env_insert_builtin(ctx->env, "rt_coll_head", 1, 0, "Private collection pattern projection", NULL);
     env_insert_builtin(ctx->env, "pair?",   1,  0, "Test if a list is a dotted pair (tail is an atom)", NULL);
     env_insert_builtin(ctx->env, "append!", 2,  0, "Destructively append a value to a list in place: (append! xs val)", NULL);
+    env_insert_builtin(ctx->env, "array-sum",    1,  0, "Sum of an Int or Float array: (array-sum xs)", NULL);
+    env_insert_builtin(ctx->env, "array-dot",    2,  0, "Dot product of two equal-length arrays: (array-dot xs ys)", NULL);
+    env_insert_builtin(ctx->env, "array-affine", 3,  0, "New array of x * scale + offset for each x: (array-affine xs scale offset)", NULL);
+    env_insert_builtin(ctx->env, "array-min",    2,  0, "Element-wise minimum of two equal-length arrays: (array-min xs ys)", NULL);
+    env_insert_builtin(ctx->env, "array-max",    2,  0, "Element-wise maximum of two equal-length arrays: (array-max xs ys)", NULL);
+    env_insert_builtin(ctx->env, "array-scan",   1,  0, "Inclusive prefix sums of an array: (array-scan xs)", NULL);
+    env_insert_builtin(ctx->env, "array-borrow", 2,  0, "View n elements of a C-owned buffer as an array, without copying: (array-borrow ptr n)", NULL);
 }
 
 void register_builtins(CodegenContext *ctx) {
@@ -18270,3 +19462,615 @@ void register_builtins(CodegenContext *ctx) {
     env_insert_builtin(ctx->env, "rt_coll_empty", 1, 0, "Internal polymorphic empty collection", NULL);
     env_insert_builtin(ctx->env, "rt_coll_is_empty", 1, 0, "Internal polymorphic empty check (O(1))", NULL);
 }
+
+//// Allocation demotion
+
+// Closures with more captures, and argument arrays above this size, stay on
+// the heap; so does anything past a function's stack budget.
+#define DEMOTE_MAX_CAPTURES   16
+#define DEMOTE_MAX_ARRAY      256
+#define DEMOTE_FRAME_BUDGET   2048
+
+typedef struct {
+    LLVMValueRef *items;
+    int           count;
+    int           cap;
+} DemoteList;
+
+static void demote_list_push(DemoteList *l, LLVMValueRef v) {
+    if (l->count == l->cap) {
+        l->cap   = l->cap ? l->cap * 2 : 8;
+        l->items = realloc(l->items, sizeof(LLVMValueRef) * l->cap);
+    }
+    l->items[l->count++] = v;
+}
+
+static const char *demote_callee_name(LLVMValueRef call) {
+    LLVMValueRef callee = LLVMGetCalledValue(call);
+    if (!callee || !LLVMIsAFunction(callee)) return NULL;
+    size_t len;
+    return LLVMGetValueName2(callee, &len);
+}
+
+// True when `v` is passed to `call` as argument `arg` and nowhere else.
+static bool demote_only_operand(LLVMValueRef call, LLVMValueRef v, unsigned arg) {
+    unsigned n = LLVMGetNumArgOperands(call);
+    bool     seen = false;
+    for (unsigned i = 0; i < n; i++) {
+        if (LLVMGetOperand(call, i) != v) continue;
+        if (i != arg) return false;
+        seen = true;
+    }
+    return seen;
+}
+
+// The block is about to become an alloca, which a `tail` callee may not
+// touch.  A call that returns straight into `ret` may be musttail, which we
+// cannot drop, so that site keeps its heap allocation.
+static bool demote_untail(LLVMValueRef call, DemoteList *untail) {
+    if (!LLVMIsTailCall(call)) return true;
+    LLVMValueRef next = LLVMGetNextInstruction(call);
+    if (next && LLVMIsABitCastInst(next) && LLVMGetOperand(next, 0) == call)
+        next = LLVMGetNextInstruction(next);
+    if (next && LLVMIsAReturnInst(next)) return false;
+    demote_list_push(untail, call);
+    return true;
+}
+
+// A closure does not escape when every use only calls it or reads its code
+// and environment pointers: rt_closure_call* copy nothing out of the block,
+// and a closure body that rebinds itself copies its captures into a fresh
+// heap closure.  Phis, stores and every other call count as escapes.
+static bool demote_closure_uses_ok(LLVMValueRef v, DemoteList *untail) {
+    for (LLVMUseRef u = LLVMGetFirstUse(v); u; u = LLVMGetNextUse(u)) {
+        LLVMValueRef user = LLVMGetUser(u);
+        if (LLVMIsABitCastInst(user)) {
+            if (!demote_closure_uses_ok(user, untail)) return false;
+            continue;
+        }
+        if (!LLVMIsACallInst(user) || !demote_only_operand(user, v, 0)) return false;
+        const char *name = demote_callee_name(user);
+        if (!name) return false;
+        if (strcmp(name, "rt_closure_call1") == 0 || strcmp(name, "rt_closure_call2") == 0 ||
+            strcmp(name, "rt_closure_call3") == 0 || strcmp(name, "rt_closure_calln") == 0) {
+            if (!demote_untail(user, untail)) return false;
+            continue;
+        }
+        if (strcmp(name, "rt_closure_get_fn_ptr") == 0) continue;
+        if (strcmp(name, "rt_closure_get_env") != 0) return false;
+        /* The environment points into the block: it may only be handed to
+         * a known function as its env argument, as rt_closure_call1 would. */
+        for (LLVMUseRef eu = LLVMGetFirstUse(user); eu; eu = LLVMGetNextUse(eu)) {
+            LLVMValueRef call = LLVMGetUser(eu);
+            if (!LLVMIsACallInst(call) || !demote_only_operand(call, user, 0) ||
+                !LLVMIsAFunction(LLVMGetCalledValue(call)) ||
+                !demote_untail(call, untail))
+                return false;
+        }
+    }
+    return true;
+}
+
+// An argument array is scratch when codegen frees it itself: it is only
+// indexed, stored into, passed as rt_closure_calln's argv and released with
+// rt_free_sized.
+static bool demote_array_uses_ok(LLVMValueRef v, DemoteList *untail,
+                                 DemoteList *frees) {
+    for (LLVMUseRef u = LLVMGetFirstUse(v); u; u = LLVMGetNextUse(u)) {
+        LLVMValueRef user = LLVMGetUser(u);
+        if (LLVMIsABitCastInst(user) || LLVMIsAGetElementPtrInst(user)) {
+            if (LLVMGetOperand(user, 0) != v ||
+                !demote_array_uses_ok(user, untail, frees))
+                return false;
+            continue;
+        }
+        if (LLVMIsALoadInst(user)) continue;
+        if (LLVMIsAStoreInst(user)) {
+            if (LLVMGetOperand(user, 0) == v) return false;
+            continue;
+        }
+        const char *name = LLVMIsACallInst(user) ? demote_callee_name(user) : NULL;
+        if (name && strcmp(name, "rt_closure_calln") == 0 && demote_only_operand(user, v, 2)) {
+            if (!demote_untail(user, untail)) return false;
+            continue;
+        }
+        if (name && strcmp(name, "rt_free_sized") == 0 && demote_only_operand(user, v, 0)) {
+            demote_list_push(frees, user);
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+static LLVMValueRef demote_closure_init_fn(LLVMModuleRef mod, LLVMTypeRef *ft_out) {
+    LLVMContextRef c     = LLVMGetModuleContext(mod);
+    LLVMTypeRef    ptr   = LLVMPointerType(LLVMInt8TypeInContext(c), 0);
+    LLVMTypeRef    i32   = LLVMInt32TypeInContext(c);
+    LLVMTypeRef    ps[]  = {ptr, ptr, ptr, ptr, i32, i32, ptr};
+    *ft_out = LLVMFunctionType(ptr, ps, 7, 0);
+    LLVMValueRef fn = LLVMGetNamedFunction(mod, "rt_value_closure_init");
+    return fn ? fn : LLVMAddFunction(mod, "rt_value_closure_init", *ft_out);
+}
+
+static LLVMValueRef demote_entry_alloca(LLVMBuilderRef b, LLVMValueRef fn,
+                                        unsigned long long size, const char *name) {
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(fn);
+    LLVMValueRef      first = LLVMGetFirstInstruction(entry);
+    if (first) LLVMPositionBuilderBefore(b, first);
+    else       LLVMPositionBuilderAtEnd(b, entry);
+    LLVMContextRef c     = LLVMGetModuleContext(LLVMGetGlobalParent(fn));
+    LLVMValueRef   slot  = LLVMBuildAlloca(b, LLVMArrayType(LLVMInt8TypeInContext(c),
+                                                            (unsigned)size), name);
+    LLVMSetAlignment(slot, 16);
+    return slot;
+}
+
+static LLVMValueRef demote_coerce(LLVMBuilderRef b, LLVMValueRef v, LLVMTypeRef t) {
+    return LLVMTypeOf(v) == t ? v : LLVMBuildPointerCast(b, v, t, "");
+}
+
+// rt_value_closure{,_named,_direct}(...) -> rt_value_closure_init(slot, ...)
+static void demote_closure(LLVMBuilderRef b, LLVMModuleRef mod, LLVMValueRef fn,
+                           LLVMValueRef call, const char *name, unsigned env_size) {
+    LLVMTypeRef  ft;
+    LLVMValueRef init = demote_closure_init_fn(mod, &ft);
+    LLVMTypeRef  ps[7];
+    LLVMGetParamTypes(ft, ps);
+    LLVMValueRef slot = demote_entry_alloca(b, fn, RT_CLOSURE_BLOCK_SIZE(env_size), "clo_stack");
+
+    LLVMPositionBuilderBefore(b, call);
+    LLVMValueRef null = LLVMConstPointerNull(ps[0]);
+    LLVMValueRef args[7];
+    args[0] = demote_coerce(b, slot, ps[0]);
+    args[1] = LLVMGetOperand(call, 0);
+    if (strcmp(name, "rt_value_closure_direct") == 0) {
+        for (unsigned i = 1; i < 6; i++) args[i + 1] = LLVMGetOperand(call, i);
+    } else {
+        args[2] = null;
+        args[3] = LLVMGetOperand(call, 1);
+        args[4] = LLVMGetOperand(call, 2);
+        args[5] = LLVMGetOperand(call, 3);
+        args[6] = strcmp(name, "rt_value_closure_named") == 0 ? LLVMGetOperand(call, 4) : null;
+    }
+    for (unsigned i = 0; i < 7; i++)
+        if (i != 4 && i != 5) args[i] = demote_coerce(b, args[i], ps[i]);
+    LLVMValueRef v = LLVMBuildCall2(b, ft, init, args, 7, "");
+    LLVMReplaceAllUsesWith(call, demote_coerce(b, v, LLVMTypeOf(call)));
+    LLVMInstructionEraseFromParent(call);
+}
+
+static void demote_array(LLVMBuilderRef b, LLVMValueRef fn, LLVMValueRef call,
+                         unsigned long long size, DemoteList *frees) {
+    LLVMValueRef slot = demote_entry_alloca(b, fn, size, "clo_args_stack");
+    LLVMPositionBuilderBefore(b, call);
+    LLVMReplaceAllUsesWith(call, demote_coerce(b, slot, LLVMTypeOf(call)));
+    LLVMInstructionEraseFromParent(call);
+    for (int i = 0; i < frees->count; i++)
+        LLVMInstructionEraseFromParent(frees->items[i]);
+}
+
+// Only allocation calls are collected: demoting one erases rt_free_sized
+// calls, which must not still be on the site list.
+static bool demote_is_site(const char *name) {
+    return name && (strcmp(name, "rt_value_closure") == 0 ||
+                    strcmp(name, "rt_value_closure_named") == 0 ||
+                    strcmp(name, "rt_value_closure_direct") == 0 ||
+                    strcmp(name, "rt_alloc") == 0);
+}
+
+static unsigned long long demote_const_arg(LLVMValueRef call, unsigned i) {
+    LLVMValueRef v = LLVMGetOperand(call, i);
+    return v && LLVMIsAConstantInt(v) ? LLVMConstIntGetZExtValue(v) : ~0ull;
+}
+
+void codegen_demote_allocations(LLVMModuleRef mod, DemotionStats *stats) {
+    LLVMBuilderRef b = LLVMCreateBuilderInContext(LLVMGetModuleContext(mod));
+    DemoteList sites = {0}, untail = {0}, frees = {0};
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn)) continue;
+        unsigned long long budget = DEMOTE_FRAME_BUDGET;
+
+        sites.count = 0;
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(fn); bb; bb = LLVMGetNextBasicBlock(bb))
+            for (LLVMValueRef i = LLVMGetFirstInstruction(bb); i; i = LLVMGetNextInstruction(i))
+                if (LLVMIsACallInst(i) && demote_is_site(demote_callee_name(i)))
+                    demote_list_push(&sites, i);
+
+        for (int s = 0; s < sites.count; s++) {
+            LLVMValueRef call = sites.items[s];
+            const char  *name = demote_callee_name(call);
+            untail.count = frees.count = 0;
+
+            if (strcmp(name, "rt_value_closure") == 0 ||
+                strcmp(name, "rt_value_closure_named") == 0 ||
+                strcmp(name, "rt_value_closure_direct") == 0) {
+                stats->closures++;
+                unsigned long long n = demote_const_arg(
+                    call, strcmp(name, "rt_value_closure_direct") == 0 ? 3 : 2);
+                if (n > DEMOTE_MAX_CAPTURES) continue;
+                unsigned long long size = RT_CLOSURE_BLOCK_SIZE(n);
+                if (size > budget || !demote_closure_uses_ok(call, &untail)) continue;
+                for (int t = 0; t < untail.count; t++) LLVMSetTailCall(untail.items[t], 0);
+                demote_closure(b, mod, fn, call, name, (unsigned)n);
+                budget -= size;
+                stats->closures_demoted++;
+            } else if (strcmp(name, "rt_alloc") == 0) {
+                unsigned long long size = demote_const_arg(call, 0);
+                if (size == 0 || size > DEMOTE_MAX_ARRAY) continue;
+                if (!demote_array_uses_ok(call, &untail, &frees) || frees.count == 0) continue;
+                stats->arg_arrays++;
+                if (size > budget) continue;
+                for (int t = 0; t < untail.count; t++) LLVMSetTailCall(untail.items[t], 0);
+                demote_array(b, fn, call, size, &frees);
+                budget -= size;
+                stats->arg_arrays_demoted++;
+            }
+        }
+    }
+
+    free(sites.items);
+    free(untail.items);
+    free(frees.items);
+    LLVMDisposeBuilder(b);
+}
+
+//// Tail calls
+
+// Debug intrinsics sit between a call and its ret at -g; they carry no
+// semantics, so the self-call scan looks through them.
+static bool tail_is_debug(LLVMValueRef i) {
+    if (!LLVMIsACallInst(i)) return false;
+    LLVMValueRef callee = LLVMGetCalledValue(i);
+    if (!callee || !LLVMIsAFunction(callee)) return false;
+    size_t      len;
+    const char *name = LLVMGetValueName2(callee, &len);
+    return strncmp(name, "llvm.dbg.", 9) == 0;
+}
+
+// True when `ret` returns exactly what `call` produced.
+static bool tail_ret_of(LLVMValueRef call, LLVMValueRef ret) {
+    if (!ret || !LLVMIsAReturnInst(ret)) return false;
+    if (LLVMGetNumOperands(ret) == 0)
+        return LLVMGetTypeKind(LLVMTypeOf(call)) == LLVMVoidTypeKind;
+    return LLVMGetOperand(ret, 0) == call;
+}
+
+// `call; ret call` with nothing between them: the only shape musttail
+// accepts.
+static bool tail_is_return_site(LLVMValueRef call) {
+    return tail_ret_of(call, LLVMGetNextInstruction(call));
+}
+
+// A computed frame address never leaves the function: every use is a load,
+// a store *to* it, a lifetime/debug marker or an address computation that
+// obeys the same rule.  Only then may a `tail` callee reuse the frame.
+static bool tail_alloca_private(LLVMValueRef v) {
+    for (LLVMUseRef u = LLVMGetFirstUse(v); u; u = LLVMGetNextUse(u)) {
+        LLVMValueRef user = LLVMGetUser(u);
+        if (LLVMIsALoadInst(user)) continue;
+        if (LLVMIsAStoreInst(user)) {
+            if (LLVMGetOperand(user, 0) == v) return false;
+            continue;
+        }
+        if (LLVMIsAGetElementPtrInst(user) || LLVMIsABitCastInst(user)) {
+            if (LLVMGetOperand(user, 0) != v || !tail_alloca_private(user)) return false;
+            continue;
+        }
+        if (LLVMIsACallInst(user)) {
+            LLVMValueRef callee = LLVMGetCalledValue(user);
+            size_t       len;
+            const char  *name = callee && LLVMIsAFunction(callee)
+                                    ? LLVMGetValueName2(callee, &len) : "";
+            if (strncmp(name, "llvm.lifetime.", 14) == 0 || tail_is_debug(user)) continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// One pass over the function's allocas: `*fixed` is cleared by a dynamic
+// size, which a loop header cannot re-execute without growing the stack.
+static bool tail_frame_private(LLVMValueRef fn, bool *fixed) {
+    *fixed = true;
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(fn); bb; bb = LLVMGetNextBasicBlock(bb))
+        for (LLVMValueRef i = LLVMGetFirstInstruction(bb); i; i = LLVMGetNextInstruction(i)) {
+            if (!LLVMIsAAllocaInst(i)) continue;
+            if (!LLVMIsAConstantInt(LLVMGetOperand(i, 0))) *fixed = false;
+            if (!tail_alloca_private(i)) return false;
+        }
+    return true;
+}
+
+// `if` and `match` join their arms in a block that is nothing but
+// `phi; ret phi`, which hides every arm's call from the ret.  Give each
+// predecessor its own ret instead, then drop the join.  Returns the number
+// of joins split.
+static int tail_split_returns(LLVMBuilderRef b, LLVMValueRef fn) {
+    int split = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (LLVMBasicBlockRef bb = LLVMGetNextBasicBlock(LLVMGetEntryBasicBlock(fn));
+             bb; bb = LLVMGetNextBasicBlock(bb)) {
+            LLVMValueRef phi = LLVMGetFirstInstruction(bb);
+            if (!phi || !LLVMIsAPHINode(phi)) continue;
+            LLVMValueRef ret = LLVMGetNextInstruction(phi);
+            while (ret && tail_is_debug(ret)) ret = LLVMGetNextInstruction(ret);
+            if (!tail_ret_of(phi, ret) || LLVMGetNextUse(LLVMGetFirstUse(phi))) continue;
+
+            unsigned n = LLVMCountIncoming(phi);
+            bool     ok = n > 0, feeds_call = false;
+            for (unsigned k = 0; k < n && ok; k++) {
+                LLVMValueRef term = LLVMGetBasicBlockTerminator(LLVMGetIncomingBlock(phi, k));
+                ok = term && LLVMIsABranchInst(term) && !LLVMIsConditional(term);
+                LLVMValueRef v = LLVMGetIncomingValue(phi, k);
+                if (ok && LLVMIsACallInst(v) && LLVMGetPreviousInstruction(term) == v)
+                    feeds_call = true;
+            }
+            if (!ok || !feeds_call) continue;
+
+            for (unsigned k = 0; k < n; k++) {
+                LLVMBasicBlockRef pred = LLVMGetIncomingBlock(phi, k);
+                LLVMValueRef      v    = LLVMGetIncomingValue(phi, k);
+                LLVMInstructionEraseFromParent(LLVMGetBasicBlockTerminator(pred));
+                LLVMPositionBuilderAtEnd(b, pred);
+                LLVMBuildRet(b, v);
+            }
+            LLVMDeleteBasicBlock(bb);
+            split++;
+            changed = true;
+            break;
+        }
+    }
+    return split;
+}
+
+// LLVMInsertIntoBuilder names the instruction ""; keep the old name.
+static void tail_move_to(LLVMBuilderRef b, LLVMValueRef i) {
+    size_t len;
+    char  *name = strdup(LLVMGetValueName2(i, &len));
+    LLVMInstructionRemoveFromParent(i);
+    LLVMInsertIntoBuilderWithName(b, i, name);
+    free(name);
+}
+
+static bool tail_is_self_site(LLVMValueRef fn, LLVMValueRef call) {
+    if (!LLVMIsACallInst(call) || LLVMGetCalledValue(call) != fn) return false;
+    if (LLVMGetInstructionCallConv(call) != LLVMGetFunctionCallConv(fn)) return false;
+    if (LLVMGetNumArgOperands(call) != LLVMCountParams(fn)) return false;
+    LLVMValueRef ret = LLVMGetNextInstruction(call);
+    while (ret && tail_is_debug(ret)) ret = LLVMGetNextInstruction(ret);
+    if (!tail_ret_of(call, ret)) return false;
+    LLVMUseRef u = LLVMGetFirstUse(call);
+    return !u || (LLVMGetUser(u) == ret && !LLVMGetNextUse(u));
+}
+
+// Self tail calls become a back edge.  The entry block keeps the allocas
+// (plus any hoisted from later blocks) and branches to a loop header that
+// holds one phi per parameter; each `call f(args); ret` becomes
+// `br header` with args feeding the phis.
+static void tail_loopify(LLVMBuilderRef b, LLVMValueRef fn, DemoteList *sites) {
+    LLVMContextRef    c     = LLVMGetModuleContext(LLVMGetGlobalParent(fn));
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(fn);
+
+    LLVMValueRef first = LLVMGetFirstInstruction(entry);
+    while (first && LLVMIsAAllocaInst(first)) first = LLVMGetNextInstruction(first);
+    for (LLVMBasicBlockRef bb = LLVMGetNextBasicBlock(entry); bb; bb = LLVMGetNextBasicBlock(bb))
+        for (LLVMValueRef i = LLVMGetFirstInstruction(bb), next; i; i = next) {
+            next = LLVMGetNextInstruction(i);
+            if (!LLVMIsAAllocaInst(i)) continue;
+            LLVMPositionBuilderBefore(b, first);
+            tail_move_to(b, i);
+        }
+
+    LLVMBasicBlockRef after  = LLVMGetNextBasicBlock(entry);
+    LLVMBasicBlockRef header = after ? LLVMInsertBasicBlockInContext(c, after, "tail_loop")
+                                     : LLVMAppendBasicBlockInContext(c, fn, "tail_loop");
+    LLVMReplaceAllUsesWith(LLVMBasicBlockAsValue(entry), LLVMBasicBlockAsValue(header));
+
+    LLVMPositionBuilderAtEnd(b, header);
+    for (LLVMValueRef i = first, next; i; i = next) {
+        next = LLVMGetNextInstruction(i);
+        tail_move_to(b, i);
+    }
+    LLVMPositionBuilderAtEnd(b, entry);
+    LLVMBuildBr(b, header);
+
+    unsigned      n    = LLVMCountParams(fn);
+    LLVMValueRef *phis = malloc(sizeof(LLVMValueRef) * (n ? n : 1));
+    LLVMPositionBuilderBefore(b, LLVMGetFirstInstruction(header));
+    for (unsigned p = 0; p < n; p++) {
+        LLVMValueRef param = LLVMGetParam(fn, p);
+        phis[p] = LLVMBuildPhi(b, LLVMTypeOf(param), "tail_arg");
+        LLVMReplaceAllUsesWith(param, phis[p]);
+        LLVMAddIncoming(phis[p], &param, &entry, 1);
+    }
+
+    for (int s = 0; s < sites->count; s++) {
+        LLVMValueRef      call = sites->items[s];
+        LLVMBasicBlockRef bb   = LLVMGetInstructionParent(call);
+        for (unsigned p = 0; p < n; p++) {
+            LLVMValueRef arg = LLVMGetOperand(call, p);
+            LLVMAddIncoming(phis[p], &arg, &bb, 1);
+        }
+        LLVMInstructionEraseFromParent(LLVMGetBasicBlockTerminator(bb));
+        LLVMInstructionEraseFromParent(call);
+        LLVMPositionBuilderAtEnd(b, bb);
+        LLVMBuildBr(b, header);
+    }
+    free(phis);
+}
+
+// musttail across any call whose prototype and convention equal the
+// caller's: every closure-ABI function is `ptr (ptr, i32, ptr)`, so a
+// closure body returning another closure's call, or two mutually recursive
+// direct functions of one shape, run in constant stack.  Other returned
+// calls get the `tail` hint, which the backend honours when it can.
+static void tail_mark_returns(LLVMValueRef fn, TailCallStats *stats) {
+    LLVMTypeRef caller_ft = LLVMGlobalGetValueType(fn);
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(fn); bb; bb = LLVMGetNextBasicBlock(bb)) {
+        LLVMValueRef term = LLVMGetBasicBlockTerminator(bb);
+        LLVMValueRef call = term ? LLVMGetPreviousInstruction(term) : NULL;
+        if (!call || !LLVMIsACallInst(call) || !tail_is_return_site(call)) continue;
+        LLVMValueRef callee = LLVMGetCalledValue(call);
+        if (LLVMIsAInlineAsm(callee)) continue;
+        if (LLVMIsAFunction(callee) && LLVMGetIntrinsicID(callee)) continue;
+        if (LLVMGetTailCallKind(call) == LLVMTailCallKindMustTail) {
+            stats->musttail++;
+            continue;
+        }
+        if (LLVMGetInstructionCallConv(call) == LLVMGetFunctionCallConv(fn) &&
+            codegen_function_types_match(caller_ft, LLVMGetCalledFunctionType(call))) {
+            LLVMSetTailCallKind(call, LLVMTailCallKindMustTail);
+            stats->musttail++;
+        } else {
+            LLVMSetTailCall(call, 1);
+        }
+    }
+}
+
+/* Per-module call graph over defined functions, for the recursion report.
+ * Functions are numbered through an open-addressed table keyed by the
+ * LLVMValueRef. */
+typedef struct {
+    LLVMValueRef *fns;
+    int           count;
+    LLVMValueRef *slot_fn;
+    int          *slot_idx;
+    unsigned      mask;
+    DemoteList   *callees;     // defined direct callees of fns[i]
+    int          *stamp;
+} TailGraph;
+
+static unsigned tail_hash(LLVMValueRef v) {
+    uintptr_t x = (uintptr_t)v;
+    x ^= x >> 17;
+    x *= 0xed5ad4bbU;
+    return (unsigned)(x ^ (x >> 11));
+}
+
+static int tail_graph_index(const TailGraph *g, LLVMValueRef fn) {
+    for (unsigned h = tail_hash(fn) & g->mask;; h = (h + 1) & g->mask) {
+        if (!g->slot_fn[h]) return -1;
+        if (g->slot_fn[h] == fn) return g->slot_idx[h];
+    }
+}
+
+static void tail_graph_build(TailGraph *g, LLVMModuleRef mod) {
+    memset(g, 0, sizeof(*g));
+    int cap = 0;
+    for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn))
+        if (!LLVMIsDeclaration(fn)) cap++;
+    unsigned slots = 16;
+    while (slots < (unsigned)cap * 2) slots <<= 1;
+    g->mask     = slots - 1;
+    g->fns      = malloc(sizeof(LLVMValueRef) * (cap ? cap : 1));
+    g->slot_fn  = calloc(slots, sizeof(LLVMValueRef));
+    g->slot_idx = calloc(slots, sizeof(int));
+    g->callees  = calloc(cap ? cap : 1, sizeof(DemoteList));
+    g->stamp    = calloc(cap ? cap : 1, sizeof(int));
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn)) continue;
+        unsigned h = tail_hash(fn) & g->mask;
+        while (g->slot_fn[h]) h = (h + 1) & g->mask;
+        g->slot_fn[h]  = fn;
+        g->slot_idx[h] = g->count;
+        g->fns[g->count++] = fn;
+    }
+    for (int f = 0; f < g->count; f++)
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(g->fns[f]); bb; bb = LLVMGetNextBasicBlock(bb))
+            for (LLVMValueRef i = LLVMGetFirstInstruction(bb); i; i = LLVMGetNextInstruction(i)) {
+                if (!LLVMIsACallInst(i)) continue;
+                LLVMValueRef callee = LLVMGetCalledValue(i);
+                if (callee && LLVMIsAFunction(callee) && tail_graph_index(g, callee) >= 0)
+                    demote_list_push(&g->callees[f], callee);
+            }
+}
+
+// Depth-first search from `from` for `to`; stamps keep it linear per query.
+static bool tail_graph_reaches(TailGraph *g, int from, int to, int stamp, DemoteList *stack) {
+    stack->count = 0;
+    demote_list_push(stack, g->fns[from]);
+    g->stamp[from] = stamp;
+    while (stack->count) {
+        int f = tail_graph_index(g, stack->items[--stack->count]);
+        if (f == to) return true;
+        for (int k = 0; k < g->callees[f].count; k++) {
+            int c = tail_graph_index(g, g->callees[f].items[k]);
+            if (g->stamp[c] == stamp) continue;
+            g->stamp[c] = stamp;
+            demote_list_push(stack, g->fns[c]);
+        }
+    }
+    return false;
+}
+
+static void tail_graph_free(TailGraph *g) {
+    for (int f = 0; f < g->count; f++) free(g->callees[f].items);
+    free(g->fns);
+    free(g->slot_fn);
+    free(g->slot_idx);
+    free(g->callees);
+    free(g->stamp);
+}
+
+// Recursive calls (to a function that can reach the caller again) that are
+// not `call; ret`: each one costs a frame per level.
+static void tail_report(LLVMModuleRef mod, FILE *report, const char *label,
+                        TailCallStats *stats) {
+    TailGraph  g;
+    DemoteList stack = {0};
+    int        stamp = 0;
+    tail_graph_build(&g, mod);
+    for (int f = 0; f < g.count; f++) {
+        int pending = 0;
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(g.fns[f]); bb; bb = LLVMGetNextBasicBlock(bb))
+            for (LLVMValueRef i = LLVMGetFirstInstruction(bb); i; i = LLVMGetNextInstruction(i)) {
+                if (!LLVMIsACallInst(i) || tail_is_return_site(i)) continue;
+                LLVMValueRef callee = LLVMGetCalledValue(i);
+                int          c = callee && LLVMIsAFunction(callee) ? tail_graph_index(&g, callee) : -1;
+                if (c >= 0 && tail_graph_reaches(&g, c, f, ++stamp, &stack)) pending++;
+            }
+        if (!pending) continue;
+        stats->non_tail_recursive += pending;
+        size_t len;
+        fprintf(report, "[tail] %s: %s: %d recursive call%s not in tail position\n",
+                label, LLVMGetValueName2(g.fns[f], &len), pending,
+                pending == 1 ? "" : "s");
+    }
+    free(stack.items);
+    tail_graph_free(&g);
+}
+
+void codegen_lower_tail_calls(LLVMModuleRef mod, TailCallStats *stats,
+                              FILE *report, const char *label) {
+    LLVMBuilderRef b = LLVMCreateBuilderInContext(LLVMGetModuleContext(mod));
+    DemoteList     sites = {0};
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn) || LLVMIsFunctionVarArg(LLVMGlobalGetValueType(fn)))
+            continue;
+        if (LLVMGetEnumAttributeAtIndex(fn, LLVMAttributeFunctionIndex,
+                                        LLVMGetEnumAttributeKindForName("naked", 5)))
+            continue;
+        bool fixed;
+        if (!tail_frame_private(fn, &fixed)) continue;
+        stats->returns_split += tail_split_returns(b, fn);
+
+        sites.count = 0;
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(fn); bb; bb = LLVMGetNextBasicBlock(bb))
+            for (LLVMValueRef i = LLVMGetFirstInstruction(bb); i; i = LLVMGetNextInstruction(i))
+                if (tail_is_self_site(fn, i)) demote_list_push(&sites, i);
+        if (sites.count && fixed) {
+            tail_loopify(b, fn, &sites);
+            stats->self_loops += sites.count;
+        }
+        tail_mark_returns(fn, stats);
+    }
+    if (report) tail_report(mod, report, label, stats);
+
+    free(sites.items);
+    LLVMDisposeBuilder(b);
+}
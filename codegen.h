@@ -4,6 +4,7 @@
 #include <llvm-c/Core.h>
 #include <setjmp.h>
 #include <stddef.h>
+#include <stdio.h>
 #include "reader.h"
 #include "types.h"
 #include "env.h"
@@ -40,6 +41,37 @@ typedef struct MonoCache {
 } MonoCache;
 
 
+/// Loop bounds checks
+//
+// While codegen is inside a counted `for` with step 1, the loop frame
+// records the unconditional (xs i) reads of its body.  A recorded read
+// is in bounds on every iteration whenever the whole range is, so its
+// check is or'ed with one range test computed before the loop.
+//
+typedef struct CodegenLoopSite {
+    AST          *read;      // the (xs i) list node
+    EnvEntry     *array;     // binding of xs when the loop was entered
+    LLVMValueRef  in_range;  // i1: start >= end || (start >= 0 && end <= size)
+} CodegenLoopSite;
+
+typedef struct CodegenLoop {
+    LLVMValueRef        var_ptr;   // alloca of the loop variable
+    CodegenLoopSite    *sites;
+    int                 site_count;
+    struct CodegenLoop *outer;
+} CodegenLoop;
+
+// Format strings get_fmt_* builds once per module.
+typedef enum {
+    CODEGEN_FMT_STR, CODEGEN_FMT_CHAR, CODEGEN_FMT_INT, CODEGEN_FMT_FLOAT,
+    CODEGEN_FMT_HEX, CODEGEN_FMT_OCT,
+    CODEGEN_FMT_STR_NN, CODEGEN_FMT_CHAR_NN, CODEGEN_FMT_INT_NN, CODEGEN_FMT_FLOAT_NN,
+    CODEGEN_FMT_COUNT
+} CodegenFmt;
+
+// Upper bound on runtime.c's declaration table (checked there).
+#define CODEGEN_RUNTIME_FN_MAX 192
+
 typedef struct CodegenContext {
     LLVMModuleRef module;
     LLVMBuilderRef builder;
@@ -49,14 +81,12 @@ typedef struct CodegenContext {
     bool is_top_level;          // Are we generating top-level (global init) code?
     LLVMValueRef init_fn;       // The __module_init_<name> function for side-effects
     LLVMValueRef top_level_fn;  // The original top-level init, never overwritten
-    // Cached format strings
-    LLVMValueRef fmt_str;
-    LLVMValueRef fmt_char;
-    LLVMValueRef fmt_int;
-    LLVMValueRef fmt_float;
-    LLVMValueRef fmt_hex;
-    LLVMValueRef fmt_bin;
-    LLVMValueRef fmt_oct;
+    // Per-module caches, valid while cache_module == module and cleared
+    // by declare_runtime_functions: printf formats by CodegenFmt, and
+    // runtime declarations by their row in runtime.c's table.
+    LLVMModuleRef cache_module;
+    LLVMValueRef fmt[CODEGEN_FMT_COUNT];
+    LLVMValueRef rt_fns[CODEGEN_RUNTIME_FN_MAX];
     bool test_mode;
     const char *current_function_name;  // NULL at top level, set when inside a define
     int in_coalesce_depth;
@@ -66,6 +96,7 @@ typedef struct CodegenContext {
     bool repl_host_globals;
     int optimization_level;
     int core_inline_depth;
+    CodegenLoop *loop;          // innermost counted `for` being generated
 
     // Monomorphization cache
     MonoCache mono_cache;
@@ -86,6 +117,14 @@ typedef struct {
 void codegen_init(CodegenContext *ctx, const char *module_name);
 void codegen_dispose(CodegenContext *ctx);
 void codegen_set_trace(bool enabled);
+void codegen_set_profile_sites(bool enabled);
+
+// --break [FILE:]LINE[ if COND] and --watch NAME.  FILE defaults to
+// default_file (NULL = any file).  Both print an error and return false
+// on a malformed spec or past RT_DEBUG_MAX_POINTS.
+bool codegen_add_breakpoint(const char *spec, const char *default_file);
+bool codegen_add_watch(const char *name);
+void codegen_clear_debug_points(void);
 
 // Format string getters
 LLVMValueRef get_fmt_str(CodegenContext *ctx);
@@ -139,6 +178,45 @@ void monad_repl_global_getter_name(const char *global_name, char *buf, size_t bu
 LLVMValueRef arr_fat_data(CodegenContext *ctx, LLVMValueRef fat_ptr, Type *elem_type);
 LLVMValueRef arr_fat_size(CodegenContext *ctx, LLVMValueRef fat_ptr);
 
+/// Allocation demotion
+//
+//  Escape analysis over an optimized module.  Closures that are only ever
+//  called (rt_value_closure* results reaching nothing but rt_closure_call*,
+//  rt_closure_get_fn_ptr and the env argument of a known callee) are built
+//  in an entry-block alloca with rt_value_closure_init, and rt_closure_calln
+//  argument arrays that codegen frees itself become allocas with the
+//  rt_free_sized dropped.  The SSA value is the only reference, so a block
+//  reused by a later loop iteration is never observed stale.
+
+typedef struct {
+    int closures;             // rt_value_closure* call sites seen
+    int closures_demoted;
+    int arg_arrays;           // scratch rt_closure_calln argv arrays seen
+    int arg_arrays_demoted;
+} DemotionStats;
+
+void codegen_demote_allocations(LLVMModuleRef mod, DemotionStats *stats);
+
+/// Tail calls
+//
+//  Runs on every module before verification, at every -O level.  Join
+//  blocks that only return a phi are split so each arm returns its own
+//  call; a function's self tail calls become a loop over its parameters;
+//  remaining `call; ret` sites are musttail when the callee's prototype and
+//  convention equal the caller's (always so between closure-ABI bodies),
+//  else `tail`.  Functions whose allocas escape are left alone.  With a
+//  report stream, recursive calls still outside tail position are listed.
+
+typedef struct {
+    int self_loops;           // self tail calls turned into back edges
+    int musttail;             // returned calls guaranteed not to grow the stack
+    int returns_split;        // phi-return joins duplicated into their arms
+    int non_tail_recursive;   // only counted when reporting
+} TailCallStats;
+
+void codegen_lower_tail_calls(LLVMModuleRef mod, TailCallStats *stats,
+                              FILE *report, const char *label);
+
 /// Monomorphization API
 LLVMValueRef mono_cache_lookup(MonoCache *cache, const char *fn_name,
                                 Type **type_args, int type_arg_count);
@@ -99,8 +99,14 @@ static const Entry ENTRIES[] = {
      "Remove build artifacts", "Deletes build/ and generated object/IR/assembly files."},
     {ENTRY_COMMAND, "commands", 'c', "i", "install", "", "monad install",
      "Install into ~/.local/bin", "Builds if needed, then installs the executable."},
+    {ENTRY_COMMAND, "commands", 'c', "p", "prelude", "[-O<n>] [--test]", "monad prelude -O2",
+     "Precompile the prelude", "Compiles core/prelude once and caches its interface so builds load it instead of recompiling it."},
     {ENTRY_COMMAND, "commands", 'c', "t", "test", "[suite|file.mon]", "monad test [list|runner|core|laws|windows|how-to|file.mon]",
      "Run tests", "Without a file or with list, prints the self-documenting test suite menu. With a suite, runs it. With a file, builds and runs that test binary."},
+    {ENTRY_COMMAND, "commands", 'c', "B", "bench", "[names|list] [options]", "monad bench nbody --runs 20 --json out.json",
+     "Run benchmarks", "Times the bench/ corpus with warmup and repeated runs, compares against a stored baseline with a rank test, and can write JSON (--json, --save-baseline, --threshold)."},
+    {ENTRY_COMMAND, "commands", 'c', "D", "daemon", "[run|start|stop|status]", "monad daemon start",
+     "Run the compile server", "Keeps LLVM, the FFI context and the prelude warm; with MONAD_DAEMON=1, compile and check commands are forwarded to it over a Unix socket."},
     {ENTRY_COMMAND, "commands", 'c', "k", "check", "[file.mon]", "monad check file.mon",
      "Type-check only", "Useful for editors because the exit status is the diagnostic result."},
     {ENTRY_COMMAND, "commands", 'c', "e", "eval", "<code>", "monad eval \"3 + 3\"",
@@ -132,6 +138,26 @@ static const Entry ENTRIES[] = {
      "Set output path", "Overrides the executable or artifact output path."},
     {ENTRY_FLAG, "general", 'g', "O", "-O, optimize", "", "monad file.mon -O2",
      "Enable optimizations", "Controls compiler optimization level."},
+    {ENTRY_FLAG, "general", 'g', "L", "--lto=thin|full", "", "monad build -O2 --lto=thin",
+     "Link-time optimization", "Emits LLVM bitcode per module and optimizes across modules and libmonad-lto.a at link time (needs clang and ld.lld)."},
+    {ENTRY_FLAG, "general", 'g', "m", "-mcpu=native|<cpu>", "", "monad build -O2 -mcpu=native",
+     "Target CPU", "Tunes code generation for a CPU instead of the portable \"generic\" target; native uses the host's CPU and features."},
+    {ENTRY_FLAG, "general", 'g', "t", "--time-passes", "", "monad build -O2 --time-passes",
+     "Time LLVM passes", "Prints each module's LLVM pass report plus pipeline and codegen wall time."},
+    {ENTRY_FLAG, "general", 'g', "T", "--time-trace[=<file>]", "", "monad build --time-trace",
+     "Trace compiler phases", "Writes a Chrome trace of every phase (parse, wisp, macros, inference, dep checks, AST passes, codegen per form, LLVM passes, object emission, link) and prints self time, allocation and peak RSS per phase; the file defaults to <input>.time-trace.json."},
+    {ENTRY_FLAG, "general", 'g', "s", "--report-escapes", "", "monad build -O2 --report-escapes",
+     "Report stack allocation", "Prints, per module, how many closure and argument-array allocation sites escape analysis moved from the heap to the stack (-O1 and up)."},
+    {ENTRY_FLAG, "general", 'g', "r", "--report-tail-calls", "", "monad build --report-tail-calls",
+     "Report non-tail recursion", "Lists, per function, the recursive calls that are not in tail position and so still take a stack frame per level; self tail calls are already loops and closure tail calls musttail."},
+    {ENTRY_FLAG, "general", 'g', "a", "--profile-sites", "", "monad build --profile-sites && MONAD_PROF=alloc ./main",
+     "Attribute allocations", "Records the source span of every runtime call, so MONAD_PROF=alloc reports allocations per file:line:col; MONAD_PROF=cpu samples any build."},
+    {ENTRY_FLAG, "general", 'g', "p", "--profile-generate", "", "monad build -O2 --profile-generate",
+     "Instrument for PGO", "Adds edge, branch and indirect-call counters; running the program writes default.profraw (or $LLVM_PROFILE_FILE)."},
+    {ENTRY_FLAG, "general", 'g', "u", "--profile-use=<file>", "", "monad build -O2 --profile-use=default.profraw",
+     "Optimize with a profile", "Feeds a .profdata (a .profraw is merged with llvm-profdata first) into branch weights, block layout and indirect-call promotion."},
+    {ENTRY_FLAG, "general", 'g', "j", "-jN, --jobs=N", "", "monad build -j8",
+     "Parallel object emission", "Emits module objects on N threads (default: all CPUs, -j1 is serial)."},
     {ENTRY_FLAG, "general", 'g', "q", "-q, --quiet", "", "monad file.mon -q",
      "Disable chatter", "Turns off progress output and trace flags."},
     {ENTRY_FLAG, "general", 'g', "v", "-v", "", "monad file.mon -v",
@@ -189,6 +215,8 @@ static const Entry ENTRIES[] = {
      "Request baseline JIT", "Selects the baseline JIT bytecode tier."},
     {ENTRY_FLAG, "bytecode", 'b', "J", "-jit, jit", "", "monad -jit file.mon",
      "Use JIT path", "Shortcut that enables bytecode and baseline JIT."},
+    {ENTRY_FLAG, "bytecode", 'b', "r", "--bc, run-bytecode", "", "monad run --bc",
+     "Run on the bytecode VM", "Lowers the main module to bytecode and runs it without LLVM; falls back to a normal build."},
 
     {ENTRY_FLAG, "debugger", 'd', "m", "--debug-no-mouse", "", "monad debug file.mon --debug-no-mouse",
      "Disable mouse", "Turns off mouse reporting in the debugger TUI."},
@@ -200,6 +228,10 @@ static const Entry ENTRIES[] = {
      "Set blink period", "Controls debugger cursor blink period."},
     {ENTRY_FLAG, "debugger", 'd', "n", "--debug-blinks", "N", "monad debug file.mon --debug-blinks 4",
      "Set blink count", "Controls idle cursor blink count."},
+    {ENTRY_FLAG, "debugger", 'd', "B", "--break", "[FILE:]LINE[ if COND]", "monad file.mon --break 'file.mon:12 if (> i 1000)'",
+     "Compiled breakpoint", "Checks COND inline at LINE and reports hits; MONAD_BREAK=log|trap|count picks the action."},
+    {ENTRY_FLAG, "debugger", 'd', "w", "--watch", "NAME", "monad file.mon --watch counter",
+     "Hardware watchpoint", "Traps every store to the top-level variable NAME once it is defined (Linux)."},
 
     {ENTRY_FLAG, "project", 'p', "T", "--test", "<file>", "monad --test file.mon",
      "Embed tests", "Compiles tests into the binary and keeps the binary."},
@@ -206,6 +206,11 @@ static void config_apply_flag_token(CompilerFlags *flags, const char *token)
         flags->bytecode_baseline_jit = true;
         return;
     }
+    if (strcmp(token, "--bc") == 0 || strcmp(token, "--run-bytecode") == 0 ||
+        strcmp(token, "run-bytecode") == 0) {
+        flags->run_bytecode = true;
+        return;
+    }
     if (strcmp(token, "-jit") == 0 || strcmp(token, "jit") == 0 || strcmp(token, "--jit") == 0) {
         flags->jit = true;
         flags->emit_bytecode = true;
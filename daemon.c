@@ -0,0 +1,758 @@
+#include "daemon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+int daemon_main(const CompilerFlags *flags) {
+    (void)flags;
+    fprintf(stderr, "monad daemon: not supported on this platform\n");
+    return 1;
+}
+
+bool daemon_wants(const CompilerFlags *flags) { (void)flags; return false; }
+
+bool daemon_forward(int argc, char **argv, int *exit_code) {
+    (void)argc; (void)argv; (void)exit_code;
+    return false;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "compat.h"
+#include "iface.h"
+#include "repl.h"
+
+extern char **environ;
+
+#define DAEMON_MAGIC    0x444e4f4du   /* "MOND" */
+#define DAEMON_VERSION  1u
+#define DAEMON_MAX_MSG  (4u << 20)
+#define DAEMON_MAX_CONN 128
+
+enum { OP_RUN = 1, OP_PING, OP_STOP };
+enum { REPLY_EXIT = 0, REPLY_SIGNAL, REPLY_STALE, REPLY_STATUS, REPLY_BUSY, REPLY_ERROR };
+
+/// Shared helpers
+
+static bool socket_path(char *out, size_t size) {
+    const char *env = getenv("MONAD_DAEMON_SOCKET");
+    int n;
+    if (env && *env) {
+        n = snprintf(out, size, "%s", env);
+    } else if ((env = getenv("XDG_RUNTIME_DIR")) && *env) {
+        n = snprintf(out, size, "%s/monad-daemon.sock", env);
+    } else {
+        char dir[64];
+        snprintf(dir, sizeof(dir), "/tmp/monad-%u", (unsigned)getuid());
+        /* A shared /tmp needs a private directory: refuse one we do not own. */
+        struct stat st;
+        if (monad_mkdir(dir) != 0 && errno != EEXIST) return false;
+        if (lstat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid())
+            return false;
+        chmod(dir, 0700);
+        n = snprintf(out, size, "%s/daemon.sock", dir);
+    }
+    return n > 0 && (size_t)n < size &&
+           (size_t)n < sizeof(((struct sockaddr_un *)0)->sun_path);
+}
+
+// Identifies the compiler binary cheaply, so a client never hands its
+// request to a server built from different sources.
+static char *binary_stamp(void) {
+    char buf[256];
+    struct stat st;
+#if defined(__linux__)
+    if (stat("/proc/self/exe", &st) == 0) {
+        snprintf(buf, sizeof(buf), "%llu:%llu:%lld:%lld",
+                 (unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+                 (long long)st.st_size, (long long)st.st_mtime);
+        return strdup(buf);
+    }
+#else
+    (void)st;
+#endif
+    snprintf(buf, sizeof(buf), "%s", compiler_identity_hash());
+    return strdup(buf);
+}
+
+static bool write_all(int fd, const void *data, size_t len) {
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t len) {
+    char *p = data;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Sends one length-prefixed message, attaching `fds` to its first byte.
+static bool send_msg(int sock, const IfaceWriter *w, const int *fds, int nfds) {
+    if (!w->ok || w->len > DAEMON_MAX_MSG) return false;
+    uint32_t len = (uint32_t)w->len;
+    unsigned char prefix[4] = { len & 0xff, (len >> 8) & 0xff,
+                                (len >> 16) & 0xff, (len >> 24) & 0xff };
+    struct iovec iov = { prefix, sizeof(prefix) };
+    union { struct cmsghdr h; char buf[CMSG_SPACE(3 * sizeof(int))]; } ctl;
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (nfds > 0) {
+        memset(&ctl, 0, sizeof(ctl));
+        msg.msg_control = ctl.buf;
+        msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+        struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type  = SCM_RIGHTS;
+        c->cmsg_len   = CMSG_LEN(nfds * sizeof(int));
+        memcpy(CMSG_DATA(c), fds, nfds * sizeof(int));
+    }
+    ssize_t n;
+    do n = sendmsg(sock, &msg, 0); while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)sizeof(prefix)) return false;
+    return write_all(sock, w->buf, w->len);
+}
+
+// Receives one message into a malloc'd buffer.  Up to three descriptors
+// passed with it land in fds[] (unused slots are -1).
+static unsigned char *recv_msg(int sock, size_t *len, int fds[3]) {
+    for (int i = 0; i < 3; i++) fds[i] = -1;
+    unsigned char prefix[4];
+    struct iovec iov = { prefix, sizeof(prefix) };
+    union { struct cmsghdr h; char buf[CMSG_SPACE(3 * sizeof(int))]; } ctl;
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+    ssize_t n;
+    do n = recvmsg(sock, &msg, MSG_WAITALL); while (n < 0 && errno == EINTR);
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); n > 0 && c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+            if (i < 3) fds[i] = fd; else close(fd);
+        }
+    }
+    uint32_t size = (uint32_t)prefix[0] | (uint32_t)prefix[1] << 8 |
+                    (uint32_t)prefix[2] << 16 | (uint32_t)prefix[3] << 24;
+    unsigned char *buf = NULL;
+    if (n == (ssize_t)sizeof(prefix) && size <= DAEMON_MAX_MSG &&
+        (buf = malloc(size ? size : 1)) && read_all(sock, buf, size)) {
+        *len = size;
+        return buf;
+    }
+    free(buf);
+    for (int i = 0; i < 3; i++) if (fds[i] >= 0) { close(fds[i]); fds[i] = -1; }
+    return NULL;
+}
+
+static IfaceReader buffer_reader(const unsigned char *buf, size_t len) {
+    IfaceReader r = { buf, buf + len, buf != NULL };
+    return r;
+}
+
+static void put_header(IfaceWriter *w, uint8_t op, const char *stamp) {
+    iface_put_u32(w, DAEMON_MAGIC);
+    iface_put_u32(w, DAEMON_VERSION);
+    iface_put_u8(w, op);
+    iface_put_str(w, stamp);
+}
+
+static int connect_server(void) {
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    if (!socket_path(path, sizeof(path))) return -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    fcntl(sock, F_SETFD, FD_CLOEXEC);
+    return sock;
+}
+
+typedef struct {
+    uint8_t kind;
+    int64_t value;
+    char   *message;
+} Reply;
+
+static bool read_reply(int sock, Reply *out) {
+    int fds[3];
+    size_t len = 0;
+    unsigned char *buf = recv_msg(sock, &len, fds);
+    if (!buf) return false;
+    IfaceReader r = buffer_reader(buf, len);
+    out->kind    = iface_get_u8(&r);
+    out->value   = iface_get_i64(&r);
+    out->message = iface_get_str(&r);
+    free(buf);
+    if (!r.ok) { free(out->message); out->message = NULL; }
+    return r.ok;
+}
+
+// One request/reply round trip for the control operations.
+static bool control_request(uint8_t op, Reply *reply) {
+    int sock = connect_server();
+    if (sock < 0) return false;
+    char *stamp = binary_stamp();
+    IfaceWriter w;
+    iface_writer_init(&w);
+    put_header(&w, op, stamp);
+    bool ok = send_msg(sock, &w, NULL, 0) && read_reply(sock, reply);
+    iface_writer_free(&w);
+    free(stamp);
+    close(sock);
+    return ok;
+}
+
+/// Client
+
+static volatile sig_atomic_t g_client_sock = -1;
+
+// Relays a terminating signal to the worker; the reply still arrives once
+// it has exited.
+static void client_relay_signal(int sig) {
+    if (g_client_sock >= 0) {
+        unsigned char b = (unsigned char)sig;
+        ssize_t n = write(g_client_sock, &b, 1);
+        (void)n;
+    }
+}
+
+bool daemon_wants(const CompilerFlags *flags) {
+    const char *env = getenv("MONAD_DAEMON");
+    if (!env || !*env || strcmp(env, "0") == 0) return false;
+    /* check, test and build run the compiler as a subprocess, which is
+     * forwarded in turn. */
+    return flags->mode == CMD_COMPILE && !flags->start_repl && flags->input_file;
+}
+
+bool daemon_forward(int argc, char **argv, int *exit_code) {
+    int sock = connect_server();
+    if (sock < 0) return false;
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) { close(sock); return false; }
+    mode_t mask = umask(0);
+    umask(mask);
+
+    char *stamp = binary_stamp();
+    IfaceWriter w;
+    iface_writer_init(&w);
+    put_header(&w, OP_RUN, stamp);
+    iface_put_u32(&w, (uint32_t)argc);
+    for (int i = 0; i < argc; i++) iface_put_str(&w, argv[i]);
+    iface_put_str(&w, cwd);
+    iface_put_u32(&w, (uint32_t)mask);
+    uint32_t envc = 0;
+    while (environ && environ[envc]) envc++;
+    iface_put_u32(&w, envc);
+    for (uint32_t i = 0; i < envc; i++) iface_put_str(&w, environ[i]);
+    free(stamp);
+
+    int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    fflush(stdout);
+    fflush(stderr);
+    bool sent = send_msg(sock, &w, fds, 3);
+    iface_writer_free(&w);
+    if (!sent) { close(sock); return false; }
+
+    static const int relayed[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
+    struct sigaction sa = {0}, old[4];
+    sa.sa_handler = client_relay_signal;
+    sigemptyset(&sa.sa_mask);
+    g_client_sock = sock;
+    for (int i = 0; i < 4; i++) sigaction(relayed[i], &sa, &old[i]);
+
+    Reply reply = {0};
+    bool got = read_reply(sock, &reply);
+
+    g_client_sock = -1;
+    for (int i = 0; i < 4; i++) sigaction(relayed[i], &old[i], NULL);
+    close(sock);
+
+    if (!got) {
+        /* The server vanished after taking the request; the worker may have
+         * produced output already, so running again here would repeat it. */
+        fprintf(stderr, "monad: lost connection to the compile server\n");
+        *exit_code = 1;
+        return true;
+    }
+    bool handled = true;
+    switch (reply.kind) {
+    case REPLY_EXIT:
+        *exit_code = (int)reply.value;
+        break;
+    case REPLY_SIGNAL:
+        signal((int)reply.value, SIG_DFL);
+        raise((int)reply.value);
+        *exit_code = 128 + (int)reply.value;
+        break;
+    case REPLY_ERROR:
+        fprintf(stderr, "monad: compile server: %s\n", reply.message ? reply.message : "error");
+        *exit_code = 1;
+        break;
+    default:            /* stale or busy: compile here instead */
+        handled = false;
+        break;
+    }
+    free(reply.message);
+    return handled;
+}
+
+/// Server
+
+typedef struct {
+    int   fd;
+    pid_t pid;          // worker serving this connection, or 0
+    bool  hung_up;      // client went away; only the worker's exit is left
+} Conn;
+
+static struct {
+    int      listen_fd;
+    int      wake[2];   // self-pipe written by the signal handlers
+    char     path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    char    *stamp;
+    char    *warm;
+    Conn     conns[DAEMON_MAX_CONN];
+    int      nconns;
+    time_t   started;
+    time_t   last_request;
+    uint64_t served;
+    bool     stopping;
+} g_srv;
+
+static volatile sig_atomic_t g_srv_stop = 0;
+
+static void server_on_signal(int sig) {
+    if (sig != SIGCHLD) g_srv_stop = 1;
+    int saved = errno;
+    unsigned char b = 0;
+    ssize_t n = write(g_srv.wake[1], &b, 1);
+    (void)n;
+    errno = saved;
+}
+
+static void server_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void server_log(const char *fmt, ...) {
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    fprintf(stderr, "[daemon %s] ", stamp);
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+static void send_reply(int fd, uint8_t kind, int64_t value, const char *message) {
+    IfaceWriter w;
+    iface_writer_init(&w);
+    iface_put_u8(&w, kind);
+    iface_put_i64(&w, value);
+    iface_put_str(&w, message);
+    send_msg(fd, &w, NULL, 0);
+    iface_writer_free(&w);
+}
+
+static void conn_close(int index) {
+    close(g_srv.conns[index].fd);
+    g_srv.conns[index] = g_srv.conns[--g_srv.nconns];
+}
+
+// Worker side of OP_RUN: adopt the client's process context and run.
+static void worker_run(IfaceReader *r, const int fds[3]) {
+    for (int i = 0; i < g_srv.nconns; i++) close(g_srv.conns[i].fd);
+    close(g_srv.listen_fd);
+    close(g_srv.wake[0]);
+    close(g_srv.wake[1]);
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    signal(SIGINT,  SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGHUP,  SIG_DFL);
+
+    uint32_t argc = iface_get_u32(r);
+    if (argc == 0 || argc > 4096) _exit(2);
+    char **argv = calloc(argc + 1, sizeof(*argv));
+    for (uint32_t i = 0; i < argc; i++)
+        if (!(argv[i] = iface_get_str(r))) _exit(2);
+    char *cwd = iface_get_str(r);
+    mode_t mask = (mode_t)iface_get_u32(r);
+    uint32_t envc = iface_get_u32(r);
+    if (!r->ok || envc > 65536) _exit(2);
+    char **env = calloc(envc + 1, sizeof(*env));
+    for (uint32_t i = 0; i < envc; i++)
+        if (!(env[i] = iface_get_str(r))) _exit(2);
+
+    for (int i = 0; i < 3; i++) {
+        dup2(fds[i], i);
+        if (fds[i] > 2) close(fds[i]);
+    }
+    /* The server never writes to stdout, so the stream can still be given
+     * the buffering a directly started compiler would choose. */
+    setvbuf(stdout, NULL, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, BUFSIZ);
+    environ = env;
+    umask(mask);
+    if (!cwd || chdir(cwd) != 0) {
+        fprintf(stderr, "monad: compile server cannot enter %s\n", cwd ? cwd : "(null)");
+        _exit(1);
+    }
+    exit(daemon_run_request((int)argc, argv));
+}
+
+static void server_handle_request(int index) {
+    Conn *c = &g_srv.conns[index];
+    int fds[3];
+    size_t len = 0;
+    unsigned char *buf = recv_msg(c->fd, &len, fds);
+    if (!buf) { conn_close(index); return; }
+
+    IfaceReader r = buffer_reader(buf, len);
+    uint32_t magic   = iface_get_u32(&r);
+    uint32_t version = iface_get_u32(&r);
+    uint8_t  op      = iface_get_u8(&r);
+    char    *stamp   = iface_get_str(&r);
+    bool same_binary = stamp && strcmp(stamp, g_srv.stamp) == 0;
+    free(stamp);
+
+    if (!r.ok || magic != DAEMON_MAGIC || version != DAEMON_VERSION) {
+        send_reply(c->fd, REPLY_ERROR, 0, "malformed request");
+        goto done;
+    }
+    if (!same_binary) {
+        /* The compiler was rebuilt: this server is of no further use. */
+        send_reply(c->fd, REPLY_STALE, 0, "compile server runs another compiler build");
+        server_log("client uses another compiler build; shutting down");
+        g_srv.stopping = true;
+        goto done;
+    }
+    g_srv.last_request = time(NULL);
+
+    if (op == OP_PING) {
+        char msg[1024];
+        snprintf(msg, sizeof(msg), "pid %ld, up %lds, %llu requests, %d active; %s",
+                 (long)getpid(), (long)(time(NULL) - g_srv.started),
+                 (unsigned long long)g_srv.served, g_srv.nconns - 1,
+                 g_srv.warm ? g_srv.warm : "no warm state");
+        send_reply(c->fd, REPLY_STATUS, getpid(), msg);
+        goto done;
+    }
+    if (op == OP_STOP) {
+        send_reply(c->fd, REPLY_STATUS, getpid(), "stopping");
+        g_srv.stopping = true;
+        goto done;
+    }
+    if (op != OP_RUN || fds[0] < 0 || fds[1] < 0 || fds[2] < 0) {
+        send_reply(c->fd, REPLY_ERROR, 0, "malformed request");
+        goto done;
+    }
+    if (g_srv.stopping) {
+        send_reply(c->fd, REPLY_BUSY, 0, "compile server is stopping");
+        goto done;
+    }
+
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) worker_run(&r, fds);
+    if (pid < 0) {
+        send_reply(c->fd, REPLY_BUSY, 0, strerror(errno));
+        goto done;
+    }
+    c->pid = pid;
+    g_srv.served++;
+    free(buf);
+    for (int i = 0; i < 3; i++) close(fds[i]);
+    return;
+
+done:
+    free(buf);
+    for (int i = 0; i < 3; i++) if (fds[i] >= 0) close(fds[i]);
+    conn_close(index);
+}
+
+static void server_reap(void) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < g_srv.nconns; i++) {
+            if (g_srv.conns[i].pid != pid) continue;
+            if (WIFSIGNALED(status))
+                send_reply(g_srv.conns[i].fd, REPLY_SIGNAL, WTERMSIG(status), NULL);
+            else
+                send_reply(g_srv.conns[i].fd, REPLY_EXIT, WEXITSTATUS(status), NULL);
+            conn_close(i);
+            break;
+        }
+    }
+}
+
+// Input on a busy connection is a signal number relayed by the client;
+// end of file means the client is gone.
+static void server_handle_cancel(int index) {
+    Conn *c = &g_srv.conns[index];
+    unsigned char sig = 0;
+    ssize_t n = read(c->fd, &sig, 1);
+    if (n < 0 && errno == EINTR) return;
+    int target = n == 1 && sig > 0 && sig < 64 ? sig : SIGKILL;
+    kill(c->pid, target);
+    if (n != 1) c->hung_up = true;
+}
+
+static bool server_listen(void) {
+    if (!socket_path(g_srv.path, sizeof(g_srv.path))) {
+        fprintf(stderr, "monad daemon: no usable socket path\n");
+        return false;
+    }
+    int probe = connect_server();
+    if (probe >= 0) {
+        close(probe);
+        fprintf(stderr, "monad daemon: a server is already listening on %s\n", g_srv.path);
+        return false;
+    }
+    unlink(g_srv.path);   /* left behind by a server that did not exit cleanly */
+
+    g_srv.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (g_srv.listen_fd < 0) { perror("monad daemon: socket"); return false; }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, g_srv.path, strlen(g_srv.path) + 1);
+    mode_t old = umask(0077);
+    int rc = bind(g_srv.listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old);
+    if (rc != 0 || listen(g_srv.listen_fd, 64) != 0) {
+        fprintf(stderr, "monad daemon: cannot listen on %s: %s\n", g_srv.path, strerror(errno));
+        close(g_srv.listen_fd);
+        return false;
+    }
+    fcntl(g_srv.listen_fd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+static long idle_limit(void) {
+    const char *env = getenv("MONAD_DAEMON_IDLE");
+    if (!env || !*env) return 1800;
+    char *end;
+    long v = strtol(env, &end, 10);
+    return *end || v < 0 ? 1800 : v;
+}
+
+static int server_run(void) {
+    if (!server_listen()) return 1;
+    if (pipe(g_srv.wake) != 0) { perror("monad daemon: pipe"); return 1; }
+    fcntl(g_srv.wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(g_srv.wake[1], F_SETFL, O_NONBLOCK);
+
+    struct sigaction sa = {0};
+    sa.sa_handler = server_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGCHLD, &sa, NULL);
+    sigaction(SIGINT,  &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP,  &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    g_srv.stamp = binary_stamp();
+    g_srv.warm  = daemon_warm_state();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    g_srv.started = g_srv.last_request = time(NULL);
+    server_log("listening on %s (warm-up %.0f ms; %s)", g_srv.path,
+               (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_nsec - t0.tv_nsec) / 1e6,
+               g_srv.warm ? g_srv.warm : "no warm state");
+
+    long idle = idle_limit();
+    struct pollfd pfds[DAEMON_MAX_CONN + 2];
+    for (;;) {
+        if (g_srv_stop) g_srv.stopping = true;
+        bool busy = false;
+        for (int i = 0; i < g_srv.nconns; i++) busy |= g_srv.conns[i].pid > 0;
+        if (g_srv.stopping && !busy) break;
+        if (!busy && idle > 0 && time(NULL) - g_srv.last_request >= idle) {
+            server_log("idle for %lds; exiting", idle);
+            break;
+        }
+
+        int n = 0;
+        pfds[n++] = (struct pollfd){ g_srv.wake[0], POLLIN, 0 };
+        bool accepting = !g_srv.stopping && g_srv.nconns < DAEMON_MAX_CONN;
+        pfds[n++] = (struct pollfd){ accepting ? g_srv.listen_fd : -1, POLLIN, 0 };
+        for (int i = 0; i < g_srv.nconns; i++)
+            pfds[n++] = (struct pollfd){ g_srv.conns[i].hung_up ? -1 : g_srv.conns[i].fd,
+                                         POLLIN, 0 };
+
+        int ready = poll(pfds, (nfds_t)n, 1000);
+        if (ready < 0 && errno != EINTR) { perror("monad daemon: poll"); break; }
+        if (ready <= 0) continue;
+
+        if (pfds[0].revents) {
+            unsigned char drain[64];
+            while (read(g_srv.wake[0], drain, sizeof(drain)) > 0) {}
+            server_reap();
+            continue;   /* connection indices may have moved */
+        }
+        /* Walk backwards: handlers may close a connection, which moves the
+         * last one into its slot. */
+        for (int i = g_srv.nconns - 1; i >= 0; i--) {
+            if (!pfds[i + 2].revents) continue;
+            if (g_srv.conns[i].pid > 0) server_handle_cancel(i);
+            else server_handle_request(i);
+        }
+        if (pfds[1].revents & POLLIN) {
+            int fd = accept(g_srv.listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                struct timeval tv = { 5, 0 };   /* a stuck client cannot stall the loop */
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                g_srv.conns[g_srv.nconns++] = (Conn){ fd, 0, false };
+            }
+        }
+    }
+
+    for (int i = 0; i < g_srv.nconns; i++)
+        if (g_srv.conns[i].pid > 0) kill(g_srv.conns[i].pid, SIGTERM);
+    while (g_srv.nconns > 0) {
+        bool busy = false;
+        for (int i = 0; i < g_srv.nconns; i++) busy |= g_srv.conns[i].pid > 0;
+        if (!busy) break;
+        server_reap();
+        usleep(10000);
+    }
+    while (g_srv.nconns > 0) conn_close(g_srv.nconns - 1);
+    close(g_srv.listen_fd);
+    unlink(g_srv.path);
+    server_log("stopped after %llu requests", (unsigned long long)g_srv.served);
+    return 0;
+}
+
+/// monad daemon
+
+static int daemon_start(void) {
+    Reply reply = {0};
+    if (control_request(OP_PING, &reply) && reply.kind == REPLY_STATUS) {
+        printf("monad daemon: already running (%s)\n", reply.message);
+        free(reply.message);
+        return 0;
+    }
+    free(reply.message);
+
+    char self[4096] = "monad";
+#if defined(__linux__)
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    self[len > 0 ? len : 5] = '\0';
+#endif
+    char log_path[4096] = "/dev/null";
+    const char *home = getenv("HOME");
+    if (home && *home) {
+        snprintf(log_path, sizeof(log_path), "%s/.cache", home);
+        monad_mkdir(log_path);
+        snprintf(log_path, sizeof(log_path), "%s/.cache/monad", home);
+        monad_mkdir(log_path);
+        snprintf(log_path, sizeof(log_path), "%s/.cache/monad/daemon.log", home);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) { perror("monad daemon: fork"); return 1; }
+    if (pid == 0) {
+        setsid();
+        int in  = open("/dev/null", O_RDONLY);
+        int log = open(log_path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+        if (log < 0) log = open("/dev/null", O_WRONLY);
+        if (in >= 0)  { dup2(in, STDIN_FILENO); close(in); }
+        if (log >= 0) { dup2(log, STDOUT_FILENO); dup2(log, STDERR_FILENO); close(log); }
+        char *args[] = { self, "daemon", "run", NULL };
+        execvp(self, args);
+        _exit(127);
+    }
+
+    /* Wait for the warm-up to finish so the next command already hits it. */
+    for (int i = 0; i < 600; i++) {
+        if (control_request(OP_PING, &reply) && reply.kind == REPLY_STATUS) {
+            printf("monad daemon: started (%s)\n", reply.message);
+            free(reply.message);
+            return 0;
+        }
+        free(reply.message);
+        reply.message = NULL;
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid) break;
+        usleep(50000);
+    }
+    fprintf(stderr, "monad daemon: server did not come up; see %s\n", log_path);
+    return 1;
+}
+
+int daemon_main(const CompilerFlags *flags) {
+    const char *action = flags->daemon_action ? flags->daemon_action : "run";
+    if (strcmp(action, "run") == 0) return server_run();
+    if (strcmp(action, "start") == 0) return daemon_start();
+
+    Reply reply = {0};
+    if (strcmp(action, "status") == 0) {
+        if (!control_request(OP_PING, &reply)) {
+            printf("monad daemon: not running\n");
+            return 1;
+        }
+        bool ok = reply.kind == REPLY_STATUS;
+        printf("monad daemon: %s\n", reply.message ? reply.message : "unknown reply");
+        free(reply.message);
+        return ok ? 0 : 1;
+    }
+    if (strcmp(action, "stop") == 0) {
+        if (!control_request(OP_STOP, &reply)) {
+            printf("monad daemon: not running\n");
+            return 0;
+        }
+        printf("monad daemon: %s\n", reply.message ? reply.message : "stopped");
+        free(reply.message);
+        return 0;
+    }
+    fprintf(stderr, "Usage: monad daemon [run|start|stop|status]\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <stdbool.h>
+#include "cli.h"
+
+///  Compile server (monad daemon)
+//
+//  A long-lived process that pays compiler start-up once: LLVM target
+//  initialization, the host target description, the FFI context and the
+//  prelude registry loaded from its bundle.  Clients connect over a Unix
+//  socket and the server forks one worker per request.  The worker starts
+//  from that warm state, takes over the client's stdin/stdout/stderr (passed
+//  as descriptors), cwd, environment and umask, and runs the request
+//  exactly as `monad <args>` would.  The client exits with the worker's
+//  status.  Forking keeps requests isolated from each other and from the
+//  warm state, which only the server itself ever mutates.
+//
+//  Clients opt in with MONAD_DAEMON=1.  Compile requests then go to a
+//  running server; check, test and build reach it through the compiler
+//  subprocesses they start.  When no server is reachable, or it was started
+//  from a different compiler binary, the client compiles in-process.  The socket is $MONAD_DAEMON_SOCKET, else
+//  $XDG_RUNTIME_DIR/monad-daemon.sock, else /tmp/monad-<uid>/daemon.sock.
+//
+//    monad daemon start      # detach, log to ~/.cache/monad/daemon.log
+//    MONAD_DAEMON=1 monad Main.mon
+//    monad daemon status
+//    monad daemon stop
+//
+//  An idle server exits after MONAD_DAEMON_IDLE seconds (default 1800,
+//  0 to never exit).  Unix only; elsewhere `monad daemon` reports that it
+//  is unsupported and clients always compile in-process.
+
+// `monad daemon [run|start|stop|status]`.  Returns the process exit code.
+int daemon_main(const CompilerFlags *flags);
+
+// True when `flags` names a request the client should try to forward.
+bool daemon_wants(const CompilerFlags *flags);
+
+// Forwards argv to a running server and waits for it.  Returns false,
+// having run nothing, when no compatible server accepted the request;
+// otherwise stores the worker's exit status in *exit_code.
+bool daemon_forward(int argc, char **argv, int *exit_code);
+
+/// Provided by main.c
+
+// Builds the warm state in the server before it accepts requests.
+// Returns a malloc'd one-line summary for `monad daemon status`.
+char *daemon_warm_state(void);
+
+// Runs one request in a forked worker whose cwd and environment are
+// already the client's.  Returns the exit code.
+int daemon_run_request(int argc, char **argv);
+
+#endif // DAEMON_H
@@ -884,9 +884,12 @@ EvalEnv *eval_env_clone(EvalEnv *e) {
 
 /// Values and closures
 
+static unsigned g_val_next_id;
+
 static Value *val_alloc(ValKind kind) {
     Value *v = calloc(1, sizeof(Value));
     v->kind  = kind;
+    v->id    = ++g_val_next_id;
     return v;
 }
 
@@ -982,6 +985,17 @@ void val_spine_push(Spine *sp, Value *arg) {
     sp->args[sp->count++] = arg;
 }
 
+// dep_eval applies a neutral or meta by extending its spine in place.
+// The longer application is a different value: it takes a fresh id, since
+// the conversion memo is keyed on ids, and drops any δ-unfolding glued onto
+// the shorter one.
+static void val_spine_extend(Value *v, Value *arg) {
+    val_spine_push(&v->spine, arg);
+    v->id       = ++g_val_next_id;
+    v->glue     = NULL;
+    v->glue_src = NULL;
+}
+
 Spine val_spine_clone(Spine sp) {
     Spine ns = val_spine_empty();
     for (int i = 0; i < sp.count; i++) val_spine_push(&ns, sp.args[i]);
@@ -1253,9 +1267,9 @@ Value *dep_eval(Term *t, EvalEnv *env, MetaCtx *mctx) {
                 fn = dep_closure_apply(fn->closure, arg);
             } else if (fn->kind == VAL_NEUTRAL) {
                 // Accumulate onto the neutral spine
-                val_spine_push(&fn->spine, arg);
+                val_spine_extend(fn, arg);
             } else if (fn->kind == VAL_META) {
-                val_spine_push(&fn->spine, arg);
+                val_spine_extend(fn, arg);
             } else {
                 /* Type ERROR: applying a non-function.  The type checker
                  * should have caught this; produce a neutral to continue. */
@@ -1509,6 +1523,102 @@ Term *dep_normalise(Term *t, EvalEnv *env, MetaCtx *mctx) {
 
 /// Definitional equality  — conversion checking
 
+/// Conversion memo
+//
+//  Open-addressed over a power-of-two array, linear probing, grown at
+//  70% load.  Ids start at 1, so a zero `a` marks an empty slot.  Keys
+//  use value ids rather than pointers because val_free'd addresses come
+//  back from calloc.
+
+typedef struct DepConvMemoEntry {
+    unsigned a, b;
+    int      depth;
+} DepConvMemoEntry;
+
+typedef struct DepConvMemo {
+    DepConvMemoEntry *slots;
+    size_t            size;
+    size_t            count;
+    unsigned          generation;  // g_dep_env_generation when filled
+} DepConvMemo;
+
+// Bumped whenever dep_env_define overwrites a definition.
+static unsigned g_dep_env_generation;
+
+static bool conv_memo_enabled(void) {
+    static int enabled = -1;
+    if (enabled < 0) {
+        const char *v = getenv("MONAD_DEP_CACHE");
+        enabled = !v || strcmp(v, "0") != 0;
+    }
+    return enabled;
+}
+
+static size_t conv_memo_hash(unsigned a, unsigned b, int depth) {
+    uint64_t h = 1469598103934665603ULL;
+    h = (h ^ a) * 1099511628211ULL;
+    h = (h ^ b) * 1099511628211ULL;
+    h = (h ^ (unsigned)depth) * 1099511628211ULL;
+    return (size_t)(h ^ (h >> 29));
+}
+
+static DepConvMemoEntry *conv_memo_slot(DepConvMemo *m, unsigned a, unsigned b, int depth) {
+    size_t mask = m->size - 1;
+    for (size_t i = conv_memo_hash(a, b, depth) & mask;; i = (i + 1) & mask) {
+        DepConvMemoEntry *e = &m->slots[i];
+        if (!e->a || (e->a == a && e->b == b && e->depth == depth)) return e;
+    }
+}
+
+static void conv_memo_free(DepConvMemo *m) {
+    if (!m) return;
+    free(m->slots);
+    free(m);
+}
+
+// Forget everything recorded before a definition changed.
+static void conv_memo_sync(DepConvMemo *m) {
+    if (m->generation == g_dep_env_generation) return;
+    memset(m->slots, 0, m->size * sizeof(DepConvMemoEntry));
+    m->count      = 0;
+    m->generation = g_dep_env_generation;
+}
+
+static bool conv_memo_hit(ConvCtx *cctx, Value *v1, Value *v2) {
+    DepConvMemo *m = cctx->dctx ? cctx->dctx->conv_memo : NULL;
+    if (!m || !v1 || !v2) return false;
+    conv_memo_sync(m);
+    return m->count && conv_memo_slot(m, v1->id, v2->id, cctx->depth)->a != 0;
+}
+
+static void conv_memo_record(ConvCtx *cctx, Value *v1, Value *v2) {
+    if (!cctx->dctx || !v1 || !v2 || !conv_memo_enabled()) return;
+    DepConvMemo *m = cctx->dctx->conv_memo;
+    if (!m) {
+        m = calloc(1, sizeof(DepConvMemo));
+        m->size  = 256;
+        m->slots = calloc(m->size, sizeof(DepConvMemoEntry));
+        m->generation = g_dep_env_generation;
+        cctx->dctx->conv_memo = m;
+    }
+    conv_memo_sync(m);
+    if ((m->count + 1) * 10 > m->size * 7) {
+        DepConvMemoEntry *old  = m->slots;
+        size_t            osz  = m->size;
+        m->size *= 2;
+        m->slots = calloc(m->size, sizeof(DepConvMemoEntry));
+        for (size_t i = 0; i < osz; i++)
+            if (old[i].a) *conv_memo_slot(m, old[i].a, old[i].b, old[i].depth) = old[i];
+        free(old);
+    }
+    DepConvMemoEntry *e = conv_memo_slot(m, v1->id, v2->id, cctx->depth);
+    if (e->a) return;
+    e->a     = v1->id;
+    e->b     = v2->id;
+    e->depth = cctx->depth;
+    m->count++;
+}
+
 ConvCtx conv_ctx_make(DepCtx *dctx, int depth) {
     ConvCtx c;
     c.dctx      = dctx;
@@ -1635,6 +1745,19 @@ static Value *fresh_neutral(ConvCtx *cctx, const char *hint) {
     return val_neutral(name, cctx->depth, val_spine_empty());
 }
 
+//  δ-unfold a global neutral: its definition applied to the spine.  The
+//  result is glued onto the neutral, so a value compared many times
+//  unfolds once; `glue_src` notices when the definition was replaced.
+static Value *neutral_unfold(Value *v, DepEnvEntry *e) {
+    if (v->glue && v->glue_src == e->def_val) return v->glue;
+    Value *unf = e->def_val;
+    for (int i = 0; i < v->spine.count; i++)
+        unf = dep_closure_apply(unf->closure, v->spine.args[i]);
+    v->glue     = unf;
+    v->glue_src = e->def_val;
+    return unf;
+}
+
 static bool dep_conv_vals_internal(ConvCtx *cctx, Value *v1, Value *v2, Value *ty);
 
 static bool dep_conv_vals(ConvCtx *cctx, Value *v1, Value *v2, Value *ty) {
@@ -1651,7 +1774,11 @@ static bool dep_conv_vals(ConvCtx *cctx, Value *v1, Value *v2, Value *ty) {
         g_trace_depth++;
     }
 
-    bool res = dep_conv_vals_internal(cctx, v1, v2, ty);
+    bool res = conv_memo_hit(cctx, v1, v2);
+    if (!res) {
+        res = dep_conv_vals_internal(cctx, v1, v2, ty);
+        if (res && !cctx->had_error) conv_memo_record(cctx, v1, v2);
+    }
 
     if (g_trace_enabled) {
         g_trace_depth--;
@@ -1722,16 +1849,25 @@ static bool dep_conv_vals_internal(ConvCtx *cctx, Value *v1, Value *v2, Value *t
 
     if (!v1 || !v2) return v1 == v2;
 
+    /* Conversion is reflexive; an embed without a type is the one value
+     * the structural cases below reject against itself. */
+    if (v1 == v2 && !(v1->kind == VAL_EMBED && !v1->embed_type)) return true;
+
+    /* Same head: compare spines in the NEUTRAL case, no unfolding needed. */
+    bool same_head = v1->kind == VAL_NEUTRAL && v2->kind == VAL_NEUTRAL &&
+                     v1->neutral_name && v2->neutral_name &&
+                     strcmp(v1->neutral_name, v2->neutral_name) == 0;
+
     /* delta-unfold refinement/alias neutrals early, before the kind check.
      * When one side is a named neutral (e.g. N) that resolves to a ground
      * embed (e.g. val_embed(Int)), unfold it so Nat vs N succeeds. */
-    if (v1->kind == VAL_NEUTRAL && v1->spine.count == 0 && cctx->dctx) {
+    if (!same_head && v1->kind == VAL_NEUTRAL && v1->spine.count == 0 && cctx->dctx) {
         DepEnvEntry *e = dep_env_lookup(cctx->dctx->globals, v1->neutral_name);
         if (e && e->def_val && e->def_val->kind == VAL_EMBED) {
             return dep_conv_vals(cctx, e->def_val, v2, ty);
         }
     }
-    if (v2->kind == VAL_NEUTRAL && v2->spine.count == 0 && cctx->dctx) {
+    if (!same_head && v2->kind == VAL_NEUTRAL && v2->spine.count == 0 && cctx->dctx) {
         DepEnvEntry *e = dep_env_lookup(cctx->dctx->globals, v2->neutral_name);
         if (e && e->def_val && e->def_val->kind == VAL_EMBED) {
             return dep_conv_vals(cctx, v1, e->def_val, ty);
@@ -1947,20 +2083,12 @@ static bool dep_conv_vals_internal(ConvCtx *cctx, Value *v1, Value *v2, Value *t
                 ? dep_env_lookup(cctx->dctx->globals, v1->neutral_name) : NULL;
             DepEnvEntry *e2 = (cctx->dctx && v2->neutral_name)
                 ? dep_env_lookup(cctx->dctx->globals, v2->neutral_name) : NULL;
-            bool unfolded = false;
-            if (e1 && e1->def_val && !e1->opaque) {
-                Value *unf1 = e1->def_val;
-                for (int i = 0; i < v1->spine.count; i++)
-                    unf1 = dep_closure_apply(unf1->closure, v1->spine.args[i]);
-                return dep_conv_vals(cctx, unf1, v2, ty);
-            }
-            if (e2 && e2->def_val && !e2->opaque) {
-                Value *unf2 = e2->def_val;
-                for (int i = 0; i < v2->spine.count; i++)
-                    unf2 = dep_closure_apply(unf2->closure, v2->spine.args[i]);
-                return dep_conv_vals(cctx, v1, unf2, ty);
-            }
-            (void)unfolded;
+            bool can1 = e1 && e1->def_val && !e1->opaque;
+            bool can2 = e2 && e2->def_val && !e2->opaque;
+            if (can1 && (!can2 || e1->height >= e2->height))
+                return dep_conv_vals(cctx, neutral_unfold(v1, e1), v2, ty);
+            if (can2)
+                return dep_conv_vals(cctx, v1, neutral_unfold(v2, e2), ty);
             snprintf(cctx->error_msg, sizeof(cctx->error_msg),
                      "dep: cannot unify %s with %s",
                      v1->neutral_name ? v1->neutral_name : "?null",
@@ -2010,7 +2138,27 @@ static size_t dep_env_hash(const char *name) {
     if (!name) return 0;
     size_t h = 5381;
     for (; *name; name++) h = h * 33 ^ (unsigned char)*name;
-    return h % DEP_ENV_BUCKETS;
+    return h;
+}
+
+static unsigned g_dep_env_height;
+
+static void dep_env_grow(DepEnv *env) {
+    size_t        size    = env->size * 2;
+    DepEnvEntry **buckets = calloc(size, sizeof(DepEnvEntry *));
+    for (size_t i = 0; i < env->size; i++) {
+        DepEnvEntry *e = env->buckets[i];
+        while (e) {
+            DepEnvEntry *next = e->next;
+            size_t idx = dep_env_hash(e->name) & (size - 1);
+            e->next      = buckets[idx];
+            buckets[idx] = e;
+            e = next;
+        }
+    }
+    free(env->buckets);
+    env->buckets = buckets;
+    env->size    = size;
 }
 
 DepEnv *dep_env_create(void) {
@@ -2049,32 +2197,44 @@ void dep_env_declare(DepEnv *env, const char *name, Value *type) {
 
 void dep_env_define(DepEnv *env, const char *name, Value *type,
                     Term *def_term, Value *def_val, bool opaque) {
-    size_t idx = dep_env_hash(name);
+    size_t h   = dep_env_hash(name);
+    size_t idx = h & (env->size - 1);
     /* Overwrite if present */
     for (DepEnvEntry *e = env->buckets[idx]; e; e = e->next) {
         if (strcmp(e->name, name) == 0) {
+            /* A stored conversion may have unfolded the old body. */
+            if (e->def_val && !e->opaque &&
+                (e->def_val != def_val || opaque))
+                g_dep_env_generation++;
             e->type     = type;
             e->def_term = def_term;
             e->def_val  = def_val;
             e->opaque   = opaque;
+            e->height   = ++g_dep_env_height;
             return;
         }
     }
+    if (env->count >= env->size) {
+        dep_env_grow(env);
+        idx = h & (env->size - 1);
+    }
     DepEnvEntry *e = calloc(1, sizeof(DepEnvEntry));
     e->name     = strdup(name);
     e->type     = type;
     e->def_term = def_term;
     e->def_val  = def_val;
     e->opaque   = opaque;
+    e->height   = ++g_dep_env_height;
     e->next     = env->buckets[idx];
     env->buckets[idx] = e;
+    env->count++;
 }
 
 DepEnvEntry *dep_env_lookup(DepEnv *env, const char *name) {
     if (!env || !name) return NULL;
+    size_t h = dep_env_hash(name);
     for (DepEnv *cur = env; cur; cur = cur->parent) {
-        size_t idx = dep_env_hash(name);
-        for (DepEnvEntry *e = cur->buckets[idx]; e; e = e->next)
+        for (DepEnvEntry *e = cur->buckets[h & (cur->size - 1)]; e; e = e->next)
             if (e->name && strcmp(e->name, name) == 0) return e;
     }
     return NULL;
@@ -2118,6 +2278,7 @@ void dep_ctx_free(DepCtx *ctx) {
         e = next;
     }
     eval_env_free(ctx->env);
+    conv_memo_free(ctx->conv_memo);
     // globals and mctx are either shared or freed by the caller
     free(ctx);
 }
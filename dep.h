@@ -352,7 +352,8 @@ struct Spine {
 };
 
 struct Value {
-    ValKind kind;
+    ValKind  kind;
+    unsigned id;          // allocation serial, never reused; keys the conversion memo
 
     // VAL_UNIVERSE
     Level   *level;
@@ -389,6 +390,8 @@ struct Value {
     int       neutral_level;  // VAL_NEUTRAL: binding level (-1 for globals)
     int       meta_id;        // VAL_META: metavariable ID
     Spine     spine;          // arguments accumulated on the neutral
+    Value    *glue;           // VAL_NEUTRAL: cached δ-unfolding, computed on demand
+    Value    *glue_src;       // the def_val `glue` was unfolded from
 
     // VAL_EMBED
     Type     *embed_type;
@@ -543,6 +546,18 @@ bool      meta_all_solved(MetaCtx *mctx);                    // post-elab check
 //  Non-termination in the user's code can cause the checker to loop;
 //  a fuel/step counter (DEP_CONV_FUEL) is provided as a safeguard.
 //
+//  Three things keep repeated checks cheap:
+//    · A value is convertible with itself, so identical pointers succeed
+//      without a walk.
+//    · Definitions unfold lazily.  Neutrals with the same head compare
+//      their spines without unfolding, and a neutral that does need
+//      unfolding keeps the result in `glue`, so the next comparison
+//      reuses it instead of re-applying the definition to its spine.
+//    · The DepCtx remembers every (v₁ id, v₂ id, depth) triple that
+//      converted.  Failures are never stored, and metas only move from
+//      unsolved to solved, so a stored success stays true.  Redefining a
+//      global clears the memo.  MONAD_DEP_CACHE=0 turns it off.
+//
 #define DEP_CONV_FUEL 100000  // max reduction steps before timeout
 
 typedef struct ConvCtx {
@@ -590,6 +605,7 @@ struct DepCtx {
     DepEnv       *globals;  // global definitions
     MetaCtx      *mctx;     // metavariable table (shared across ctx)
     EvalEnv      *env;      // semantic environment for NbE
+    struct DepConvMemo *conv_memo; // successful conversions (dep_conv); owned
     const char   *filename; // for error messages
     bool          had_error;
     char          error_msg[512];
@@ -623,6 +639,12 @@ Value       *dep_ctx_type_at_level(DepCtx *ctx, int level);
 //  dep_env_define   — adds a name with both type and definition
 //                     (enabling δ-reduction / unfolding).
 //
+//  The bucket array starts at DEP_ENV_BUCKETS and doubles whenever the
+//  entry count passes the bucket count.  Every definition gets a height,
+//  its position in definition order; when conversion has to unfold one
+//  of two different heads it unfolds the higher one first, since a later
+//  definition can only be built from earlier ones.
+//
 #define DEP_ENV_BUCKETS 128
 
 typedef struct DepEnvEntry {
@@ -631,12 +653,14 @@ typedef struct DepEnvEntry {
     Term             *def_term; // the definition's core term (or NULL)
     Value            *def_val;  // the definition's value (or NULL)
     bool              opaque;   // if true, never δ-unfold
+    unsigned          height;   // definition order (see above)
     struct DepEnvEntry *next;
 } DepEnvEntry;
 
 struct DepEnv {
     DepEnvEntry    **buckets;
-    size_t           size;
+    size_t           size;      // power of two
+    size_t           count;
     struct DepEnv   *parent;
 };
 
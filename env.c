@@ -1,18 +1,15 @@
 #include "env.h"
 #include "infer.h"
+#include "intern.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-#define INITIAL_SIZE 16
+#define INITIAL_SIZE 16   // power of two
+
+static void hm_cache_free(struct HmDefCache *c);
 
-static unsigned int hash(const char *str) {
-    unsigned int h = 5381;
-    int c;
-    while ((c = *str++))
-        h = ((h << 5) + h) + c;
-    return h;
-}
 
 static bool adt_type_application_compatible(Type *a, Type *b) {
     if (!a || !b) return false;
@@ -42,12 +39,10 @@ static bool adt_type_application_compatible(Type *a, Type *b) {
 }
 
 Env *env_create(void) {
-    Env *t     = malloc(sizeof(Env));
+    Env *t     = calloc(1, sizeof(Env));
     t->size    = INITIAL_SIZE;
     t->count   = 0;
-    t->buckets = calloc(t->size, sizeof(EnvEntry *));
-    t->parent  = NULL;
-    t->infer_env = NULL;
+    t->slots   = calloc(t->size, sizeof(EnvEntry *));
     return t;
 }
 
@@ -87,36 +82,52 @@ static void free_entry_fields(EnvEntry *e) {
 void env_free(Env *table) {
     if (!table) return;
     for (size_t i = 0; i < table->size; i++) {
-        EnvEntry *e = table->buckets[i];
-        while (e) {
-            EnvEntry *next = e->next;
-            free_entry_fields(e);
-            free(e);
-            e = next;
-        }
+        EnvEntry *e = table->slots[i];
+        if (!e) continue;
+        free_entry_fields(e);
+        free(e);
     }
-    free(table->buckets);
+    free(table->slots);
     if (table->infer_env) {
         infer_env_free(table->infer_env);
         table->infer_env = NULL;
     }
+    hm_cache_free(table->hm_defs);
     free(table);
 }
 
-static EnvEntry *find(Env *table, const char *name) {
-    unsigned int idx = hash(name) % table->size;
-    EnvEntry *e = table->buckets[idx];
-    while (e) {
-        if (strcmp(e->name, name) == 0) return e;
-        e = e->next;
+/* Entries are keyed by their interned name, so a lookup interns (or
+ * finds) the query once and then compares pointers in every scope.  A
+ * name that was never interned cannot be in any table.
+ *
+ * Returns the slot holding `key`, or the empty slot that ends its probe
+ * run.  The table is never full, so the probe terminates. */
+static EnvEntry **probe(Env *table, const char *key) {
+    size_t mask = table->size - 1;
+    size_t i    = intern_hash(key) & mask;
+    for (;;) {
+        EnvEntry **slot = &table->slots[i];
+        if (!*slot || (*slot)->key == key) return slot;
+        i = (i + 1) & mask;
     }
-    return NULL;
+}
+
+static EnvEntry *find_key(Env *table, const char *key) {
+    return *probe(table, key);
+}
+
+static EnvEntry *find(Env *table, const char *name) {
+    const char *key = intern_find(name);
+    return key ? find_key(table, key) : NULL;
 }
 
 bool env_is_local(Env *table, const char *name) {
+    const char *key = intern_find(name);
+    if (!key) return false;
     while (table) {
-        EnvEntry *e = find(table, name);
+        EnvEntry *e = find_key(table, key);
         if (e) {
+            if (table->on_lookup) table->on_lookup(e, table->on_lookup_data);
             if (!e->value) return (table->parent != NULL);
             return LLVMGetValueKind(e->value) != LLVMGlobalVariableValueKind;
         }
@@ -128,16 +139,32 @@ bool env_is_local(Env *table, const char *name) {
 static EnvEntry *new_entry(const char *name) {
     EnvEntry *e  = calloc(1, sizeof(EnvEntry));
     e->name      = strdup(name);
+    e->key       = intern(name);
     e->arity_min = -1;
     e->arity_max = -1;
     e->adt_tag   = -1;
     return e;
 }
 
+static void grow(Env *table) {
+    size_t     size  = table->size * 2;
+    EnvEntry **slots = calloc(size, sizeof(EnvEntry *));
+    for (size_t i = 0; i < table->size; i++) {
+        EnvEntry *e = table->slots[i];
+        if (!e) continue;
+        size_t j = intern_hash(e->key) & (size - 1);
+        while (slots[j]) j = (j + 1) & (size - 1);
+        slots[j] = e;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->size  = size;
+}
+
+// Add `e`, whose key the caller has checked is not in `table`.
 static void chain(Env *table, EnvEntry *e) {
-    unsigned int idx = hash(e->name) % table->size;
-    e->next = table->buckets[idx];
-    table->buckets[idx] = e;
+    if ((table->count + 1) * 10 > table->size * 7) grow(table);
+    *probe(table, e->key) = e;
     table->count++;
 }
 
@@ -174,13 +201,12 @@ Type *env_lookup_layout(Env *table, const char *name) {
 Type *env_find_layout_with_field(Env *table, const char *field_name) {
     for (Env *e = table; e; e = e->parent) {
         for (size_t i = 0; i < e->size; i++) {
-            for (EnvEntry *entry = e->buckets[i]; entry; entry = entry->next) {
-                if (entry->kind != ENV_LAYOUT || !entry->type) continue;
-                Type *t = entry->type;
-                for (int f = 0; f < t->layout_field_count; f++) {
-                    if (strcmp(t->layout_fields[f].name, field_name) == 0)
-                        return t;
-                }
+            EnvEntry *entry = e->slots[i];
+            if (!entry || entry->kind != ENV_LAYOUT || !entry->type) continue;
+            Type *t = entry->type;
+            for (int f = 0; f < t->layout_field_count; f++) {
+                if (strcmp(t->layout_fields[f].name, field_name) == 0)
+                    return t;
             }
         }
     }
@@ -224,6 +250,7 @@ void env_insert_with_doc(Env *table, const char *name, Type *type,
         e->kind      = ENV_VAR;
         e->type      = type;
         e->value     = value;
+        e->worker_ref = NULL;
         e->docstring = docstring ? strdup(docstring) : NULL;
         e->module_name = NULL;
         e->is_exported = true; //  local symbols are "exported" by default
@@ -324,6 +351,7 @@ void env_insert_func(Env *table, const char *name,
     e->param_count = param_count;
     e->return_type = return_type;
     e->func_ref    = func_ref;
+    e->worker_ref  = NULL;
     e->arity_min   = param_count;
     e->arity_max   = param_count;
     e->docstring   = docstring ? strdup(docstring) : NULL;
@@ -338,27 +366,44 @@ void env_insert_func(Env *table, const char *name,
 }
 
 EnvEntry *env_lookup(Env *table, const char *name) {
+    const char *key = intern_find(name);
+    if (!key) return NULL;
     while (table) {
-        EnvEntry *e = find(table, name);
-        if (e) return e;
+        EnvEntry *e = find_key(table, key);
+        if (e) {
+            if (table->on_lookup) table->on_lookup(e, table->on_lookup_data);
+            return e;
+        }
         table = table->parent;
     }
     return NULL;
 }
 
 void env_remove(Env *table, const char *name) {
-    unsigned int idx = hash(name) % table->size;
-    EnvEntry **pp = &table->buckets[idx];
-    while (*pp) {
-        if (strcmp((*pp)->name, name) == 0) {
-            EnvEntry *dead = *pp;
-            *pp = dead->next;
-            free_entry_fields(dead);
-            free(dead);
-            table->count--;
-            return;
+    const char *key = intern_find(name);
+    if (!key) return;
+    EnvEntry **slot = probe(table, key);
+    if (*slot) {
+        free_entry_fields(*slot);
+        free(*slot);
+        table->count--;
+        /* Backward-shift deletion: pull later members of the probe run
+         * into the hole so no lookup stops early at it. */
+        size_t mask = table->size - 1;
+        size_t hole = (size_t)(slot - table->slots);
+        size_t i    = hole;
+        table->slots[hole] = NULL;
+        for (;;) {
+            i = (i + 1) & mask;
+            EnvEntry *e = table->slots[i];
+            if (!e) return;
+            size_t home = intern_hash(e->key) & mask;
+            // Leave `e` if its home lies cyclically in (hole, i].
+            if (((i - home) & mask) < ((i - hole) & mask)) continue;
+            table->slots[hole] = e;
+            table->slots[i]    = NULL;
+            hole = i;
         }
-        pp = &(*pp)->next;
     }
     /* Not in this table — check parent */
     if (table->parent) env_remove(table->parent, name);
@@ -457,27 +502,25 @@ void env_print(Env *table) {
      * qualified form so each symbol appears exactly once.              */
     int total = 0;
     for (size_t i = 0; i < table->size; i++)
-        for (EnvEntry *e = table->buckets[i]; e; e = e->next)
-            if (e->name) total++;
+        if (table->slots[i] && table->slots[i]->name) total++;
 
     if (total == 0) { printf("  (empty)\n"); return; }
 
     EnvEntry **entries = malloc(total * sizeof(EnvEntry *));
     int n = 0;
     for (size_t i = 0; i < table->size; i++) {
-        for (EnvEntry *e = table->buckets[i]; e; e = e->next) {
-            if (!e->name) continue;
-            /* Skip unqualified aliases: module entries whose name does
-             * not start with "ModuleName." are bare-name copies kept
-             * only for unqualified lookup — don't display them.        */
-            if (e->module_name) {
-                size_t mlen = strlen(e->module_name);
-                if (!(strncmp(e->name, e->module_name, mlen) == 0
-                      && e->name[mlen] == '.'))
-                    continue;
-            }
-            entries[n++] = e;
+        EnvEntry *e = table->slots[i];
+        if (!e || !e->name) continue;
+        /* Skip unqualified aliases: module entries whose name does
+         * not start with "ModuleName." are bare-name copies kept
+         * only for unqualified lookup — don't display them.        */
+        if (e->module_name) {
+            size_t mlen = strlen(e->module_name);
+            if (!(strncmp(e->name, e->module_name, mlen) == 0
+                  && e->name[mlen] == '.'))
+                continue;
         }
+        entries[n++] = e;
     }
 
     if (n == 0) { printf("  (empty)\n"); free(entries); return; }
@@ -642,11 +685,309 @@ static void normalize_vars(Type *t, int *map, int *next_id) {
     }
 }
 
+/* The signature a define's EnvEntry declares, instantiated in `ctx`, or
+ * NULL when there is nothing to check the inferred type against.
+ *
+ * Instance method implementations are skipped: they are registered with
+ * params that have no type annotations (type_name = NULL) because the
+ * class type variable (e.g. 'm') has not been substituted with the
+ * concrete type (e.g. 'Maybe').  A sig built from NULL param types is a
+ * chain of fresh vars that cannot meaningfully constrain the inferred
+ * type, and any mismatch error message would be misleading.  The dep
+ * checker already verified the instance body is well-typed. */
+static Type *hm_entry_signature(InferCtx *ctx, Env *env, const char *name) {
+    EnvEntry *ee = env_lookup(env, name);
+    if (!ee || strncmp(name, "__impl_", 7) == 0) return NULL;
+
+    bool has_concrete_params = true;
+    for (int i = 0; i < ee->param_count; i++) {
+        if (!ee->params[i].type) { has_concrete_params = false; break; }
+        if (ee->params[i].type->kind == TYPE_UNKNOWN) { has_concrete_params = false; break; }
+    }
+    if (!has_concrete_params && !ee->return_type) return NULL;
+
+    Type *sig = ee->return_type ? type_clone(ee->return_type) : infer_fresh(ctx);
+    for (int i = ee->param_count - 1; i >= 0; i--) {
+        Type *p = ee->params[i].type ? type_clone(ee->params[i].type) : infer_fresh(ctx);
+        sig = type_arrow(p, sig);
+    }
+
+    TypeScheme *sig_sc = infer_generalise(ctx, sig, ctx->env);
+    Type *inst_sig = infer_instantiate(ctx, sig_sc);
+    scheme_free(sig_sc);
+    return inst_sig;
+}
+
+/// Define scheme cache
+//
+// Codegen infers every top-level define twice -- once to predeclare its
+// LLVM function and once when the define itself is emitted -- and the
+// REPL re-emits defines it has already predeclared.  A define's scheme
+// depends only on its lambda, the schemes of the names its body mentions
+// and the signature its EnvEntry declares, so the root Env keeps each
+// define's last scheme under a hash of the first two and reuses it while
+// that hash holds and the declared signature adds nothing to it.
+//
+// The walk that produced a scheme also left node types on the lambda,
+// and codegen reads those.  An entry is therefore tied to the lambda it
+// was inferred from and to the inferred_type that walk left on it: a
+// re-read or rewritten lambda is always inferred again.
+// MONAD_INFER_CACHE=0 turns the cache off.
+
+typedef struct HmDefEntry {
+    const char *name;     // interned; NULL marks an empty slot
+    AST        *lambda;
+    Type       *annot;    // lambda->inferred_type after inference
+    uint64_t    key;
+    TypeScheme *scheme;   // owned
+} HmDefEntry;
+
+typedef struct HmDefCache {
+    HmDefEntry *slots;
+    size_t      size;     // power of two
+    size_t      count;
+} HmDefCache;
+
+static bool hm_cache_enabled(void) {
+    static int enabled = -1;
+    if (enabled < 0) {
+        const char *v = getenv("MONAD_INFER_CACHE");
+        enabled = !v || strcmp(v, "0") != 0;
+    }
+    return enabled;
+}
+
+static void hm_cache_free(HmDefCache *c) {
+    if (!c) return;
+    for (size_t i = 0; i < c->size; i++)
+        if (c->slots[i].name) scheme_free(c->slots[i].scheme);
+    free(c->slots);
+    free(c);
+}
+
+static HmDefEntry *hm_cache_probe(HmDefCache *c, const char *key) {
+    size_t mask = c->size - 1;
+    size_t i    = intern_hash(key) & mask;
+    while (c->slots[i].name && c->slots[i].name != key)
+        i = (i + 1) & mask;
+    return &c->slots[i];
+}
+
+static HmDefEntry *hm_cache_slot(Env *env, const char *name) {
+    while (env && !env->infer_env) env = env->parent;
+    if (!env) return NULL;
+    HmDefCache *c = env->hm_defs;
+    if (!c) {
+        c = env->hm_defs = calloc(1, sizeof(HmDefCache));
+        c->size  = 64;
+        c->slots = calloc(c->size, sizeof(HmDefEntry));
+    }
+    const char *key = intern(name);
+    if ((c->count + 1) * 10 > c->size * 7) {
+        HmDefEntry *old = c->slots;
+        size_t old_size = c->size;
+        c->size *= 2;
+        c->slots = calloc(c->size, sizeof(HmDefEntry));
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].name) *hm_cache_probe(c, old[i].name) = old[i];
+        free(old);
+    }
+    HmDefEntry *e = hm_cache_probe(c, key);
+    if (!e->name) {
+        e->name = key;
+        c->count++;
+    }
+    return e;
+}
+
+static uint64_t hm_mix(uint64_t h, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        h ^= v & 0xFF;
+        h *= 1099511628211ull;
+        v >>= 8;
+    }
+    return h;
+}
+
+static uint64_t hm_mix_str(uint64_t h, const char *s) {
+    if (!s) return hm_mix(h, 0x9E37u);
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ull;
+    }
+    return hm_mix(h, 1);
+}
+
+static uint64_t hm_mix_type(uint64_t h, Type *t, int depth) {
+    if (!t) return hm_mix(h, 0);
+    h = hm_mix(h, (uint64_t)t->kind + 1);
+    if (depth > 32) return h;
+
+    switch (t->kind) {
+    case TYPE_VAR:
+        return hm_mix(h, (uint64_t)(uint32_t)t->var_id);
+    case TYPE_ARROW:
+        h = hm_mix_type(h, t->arrow_param, depth + 1);
+        return hm_mix_type(h, t->arrow_ret, depth + 1);
+    case TYPE_FN:
+        h = hm_mix(h, (uint64_t)t->param_count);
+        for (int i = 0; i < t->param_count; i++)
+            h = hm_mix_type(h, t->params[i].type, depth + 1);
+        return hm_mix_type(h, t->return_type, depth + 1);
+    case TYPE_LIST:
+        h = hm_mix(h, (uint64_t)t->list_count);
+        for (int i = 0; i < t->list_count; i++)
+            h = hm_mix_type(h, t->list_types[i], depth + 1);
+        return hm_mix_type(h, t->element_type, depth + 1);
+    case TYPE_ARR:
+        h = hm_mix(h, (uint64_t)t->arr_size);
+        h = hm_mix(h, (uint64_t)t->arr_is_fat | (uint64_t)t->arr_is_heap << 1);
+        return hm_mix_type(h, t->arr_element_type, depth + 1);
+    case TYPE_MAP:
+        h = hm_mix_type(h, t->map_key_type, depth + 1);
+        return hm_mix_type(h, t->map_value_type, depth + 1);
+    case TYPE_LAYOUT:
+        return hm_mix_str(h, t->layout_name);
+    case TYPE_INT_ARBITRARY:
+        return hm_mix(h, (uint64_t)t->numeric_width << 1 | t->numeric_signed);
+    case TYPE_APP:
+        h = hm_mix_str(h, t->app_constructor);
+        return hm_mix_type(h, t->app_arg, depth + 1);
+    case TYPE_FINITE_SET:
+        h = hm_mix_str(h, t->finite_name);
+        return hm_mix(h, (uint64_t)t->finite_member_count);
+    default:
+        return hm_mix_type(h, t->element_type, depth + 1);
+    }
+}
+
+typedef struct HmKeyWalk {
+    uint64_t    h;
+    InferEnv   *ienv;
+    const char *self;   // pre-bound in the define's own scope
+} HmKeyWalk;
+
+static void hm_key_visit(AST *node, void *data) {
+    HmKeyWalk *w = data;
+    uint64_t   h = hm_mix(w->h, (uint64_t)node->type + 1);
+    h = hm_mix(h, ((uint64_t)(uint32_t)node->line << 32) | (uint32_t)node->column);
+    h = hm_mix(h, (uint64_t)(uint32_t)node->end_column);
+
+    switch (node->type) {
+    case AST_NUMBER: {
+        uint64_t bits;
+        memcpy(&bits, &node->number, sizeof(bits));
+        h = hm_mix(h, bits);
+        h = hm_mix_str(h, node->literal_str);
+        break;
+    }
+    case AST_SYMBOL: {
+        h = hm_mix_str(h, node->symbol);
+        if (node->symbol && strcmp(node->symbol, w->self) == 0) break;
+        TypeScheme *sc = infer_env_find(w->ienv, node->symbol);
+        if (!sc) { h = hm_mix(h, 0); break; }
+        h = hm_mix(h, (uint64_t)sc->quantified_count + 1);
+        for (int i = 0; i < sc->quantified_count; i++)
+            h = hm_mix(h, (uint64_t)(uint32_t)sc->quantified[i]);
+        h = hm_mix_type(h, sc->type, 0);
+        break;
+    }
+    case AST_STRING:
+    case AST_PATH:
+        h = hm_mix_str(h, node->string);
+        break;
+    case AST_KEYWORD:
+        h = hm_mix_str(h, node->keyword);
+        break;
+    case AST_CHAR:
+        h = hm_mix(h, (unsigned char)node->character);
+        break;
+    case AST_RATIO:
+        h = hm_mix(h, (uint64_t)node->ratio.numerator);
+        h = hm_mix(h, (uint64_t)node->ratio.denominator);
+        break;
+    case AST_LIST:
+        h = hm_mix(h, node->list.count);
+        break;
+    case AST_ARRAY:
+        h = hm_mix(h, node->array.element_count << 1 | node->array.is_heap);
+        break;
+    case AST_SET:
+        h = hm_mix(h, node->set.element_count);
+        break;
+    case AST_MAP:
+        h = hm_mix(h, node->map.count);
+        break;
+    case AST_TYPE_SET:
+        h = hm_mix_str(h, node->type_set.name);
+        h = hm_mix(h, node->type_set.member_count);
+        break;
+    case AST_LAMBDA:
+        h = hm_mix(h, (uint64_t)node->lambda.param_count);
+        for (int i = 0; i < node->lambda.param_count; i++) {
+            ASTParam *p = &node->lambda.params[i];
+            h = hm_mix_str(h, p->name);
+            h = hm_mix_str(h, p->type_name);
+            h = hm_mix(h, (uint64_t)p->is_rest << 1 | p->is_anon);
+        }
+        h = hm_mix_str(h, node->lambda.return_type);
+        h = hm_mix_str(h, node->lambda.docstring);
+        h = hm_mix(h, (uint64_t)node->lambda.body_count);
+        break;
+    default:
+        break;
+    }
+    w->h = h;
+}
+
+static uint64_t hm_define_key(InferEnv *ienv, const char *name, AST *lambda_ast) {
+    HmKeyWalk w = { 14695981039346656037ull, ienv, name };
+    w.h = hm_mix(w.h, (uint64_t)(uintptr_t)lambda_ast);
+    infer_each_node(lambda_ast, hm_key_visit, &w);
+    return w.h;
+}
+
+/* True when the signature the define's EnvEntry now declares holds for
+ * `scheme` without narrowing it: unifying the two leaves every
+ * quantified variable free and distinct. */
+static bool hm_signature_implied(Env *env, InferEnv *ienv, const char *name,
+                                 TypeScheme *scheme) {
+    InferCtx *ctx = infer_ctx_create(ienv, env_get_dep(env), "<define-cache>");
+    Type *inst_sig = hm_entry_signature(ctx, env, name);
+    bool implied = true;
+    if (inst_sig) {
+        TypeSubst ts = {0};
+        Type *inst = infer_instantiate_with_subst(ctx, scheme, &ts);
+        implied = infer_unify_one(ctx, inst, inst_sig, 0, 0) && !ctx->had_error;
+        for (int i = 0; implied && i < ts.count; i++) {
+            int root = subst_find(ctx->subst, ts.to[i]->var_id);
+            if (ctx->subst->bound[root]) implied = false;
+            for (int j = 0; implied && j < i; j++)
+                if (subst_find(ctx->subst, ts.to[j]->var_id) == root) implied = false;
+        }
+        free(ts.from);
+        free(ts.to);
+    }
+    infer_ctx_free(ctx);
+    return implied;
+}
+
 struct TypeScheme *env_hm_infer_define(Env *env, const char *name,
                                        AST *lambda_ast, const char *filename) {
     InferEnv *ienv = env_get_infer(env);
     if (!ienv) return NULL;
 
+    HmDefEntry *cached = hm_cache_enabled() ? hm_cache_slot(env, name) : NULL;
+    uint64_t    key    = cached ? hm_define_key(ienv, name, lambda_ast) : 0;
+    if (cached && cached->scheme && cached->lambda == lambda_ast &&
+        cached->annot == lambda_ast->inferred_type && cached->key == key &&
+        hm_signature_implied(env, ienv, name, cached->scheme)) {
+        TypeScheme *scheme = scheme_clone(cached->scheme);
+        infer_env_insert(ienv, name, scheme);
+        env_set_scheme(env, name, scheme);
+        return scheme;
+    }
+
     InferEnv *child = infer_env_create_child(ienv);
     InferCtx *ctx   = infer_ctx_create(child, env_get_dep(env), filename ? filename : "<unknown>");
     /* Pre-bind recursive self references.
@@ -725,51 +1066,18 @@ struct TypeScheme *env_hm_infer_define(Env *env, const char *name,
     } else {
         infer_unify_one(ctx, self_t, inferred, lambda_ast->line, lambda_ast->column);
 
-        EnvEntry *ee = env_lookup(env, name);
-        if (ee) {
-            /* Skip signature check for instance method implementations.
-             * Instance methods are registered with params that have no
-             * type annotations (type_name = NULL) because the class type
-             * variable (e.g. 'm') has not been substituted with the
-             * concrete type (e.g. 'Maybe'). Attempting to build a sig
-             * from NULL param types produces a chain of fresh vars that
-             * cannot meaningfully constrain the inferred type, and any
-             * mismatch error message would be misleading. The dep checker
-             * already verified the instance body is well-typed. */
-            bool is_instance_method = (strncmp(name, "__impl_", 7) == 0);
-
-            if (!is_instance_method) {
-                /* Build expected signature from registered param types */
-                bool has_concrete_params = true;
-                for (int i = 0; i < ee->param_count; i++) {
-                    if (!ee->params[i].type) { has_concrete_params = false; break; }
-                    if (ee->params[i].type->kind == TYPE_UNKNOWN) { has_concrete_params = false; break; }
-                }
-
-                if (has_concrete_params || ee->return_type) {
-                    Type *sig = ee->return_type ? type_clone(ee->return_type) : infer_fresh(ctx);
-                    for (int i = ee->param_count - 1; i >= 0; i--) {
-                        Type *p = ee->params[i].type ? type_clone(ee->params[i].type) : infer_fresh(ctx);
-                        sig = type_arrow(p, sig);
-                    }
-
-                    TypeScheme *sig_sc = infer_generalise(ctx, sig, ienv);
-                    Type *inst_sig = infer_instantiate(ctx, sig_sc);
-                    scheme_free(sig_sc);
-
-                    if (!infer_unify_one(ctx, inferred, inst_sig, lambda_ast->line, lambda_ast->column)) {
-                        Type *show_exp = subst_apply(ctx->subst, inst_sig);
-                        Type *show_inf = subst_apply(ctx->subst, inferred);
-                        READER_ERROR(lambda_ast->line, lambda_ast->column,
-                            "\n"
-                            "    • Signature mismatch for definition '%s'\n"
-                            "    • Expected type: %s\n"
-                            "    • Inferred type: %s\n"
-                            "    • Details: %s",
-                            name, type_to_string(show_exp), type_to_string(show_inf), ctx->error_msg);
-                    }
-                }
-            }
+        Type *inst_sig = hm_entry_signature(ctx, env, name);
+        if (inst_sig &&
+            !infer_unify_one(ctx, inferred, inst_sig, lambda_ast->line, lambda_ast->column)) {
+            Type *show_exp = subst_apply(ctx->subst, inst_sig);
+            Type *show_inf = subst_apply(ctx->subst, inferred);
+            READER_ERROR(lambda_ast->line, lambda_ast->column,
+                "\n"
+                "    • Signature mismatch for definition '%s'\n"
+                "    • Expected type: %s\n"
+                "    • Inferred type: %s\n"
+                "    • Details: %s",
+                name, type_to_string(show_exp), type_to_string(show_inf), ctx->error_msg);
         }
 
         Type *declared_t = hm_signature_from_lambda(ctx, lambda_ast);
@@ -822,6 +1130,14 @@ struct TypeScheme *env_hm_infer_define(Env *env, const char *name,
 
         infer_env_insert(ienv, name, scheme);
         env_set_scheme(env, name, scheme_clone(scheme));
+
+        if (cached) {
+            if (cached->scheme) scheme_free(cached->scheme);
+            cached->scheme = scheme_clone(scheme);
+            cached->lambda = lambda_ast;
+            cached->annot  = lambda_ast->inferred_type;
+            cached->key    = key;
+        }
     }
 
     infer_ctx_free(ctx);
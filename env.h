@@ -24,55 +24,79 @@ typedef struct EnvParam {
     Type *type;
 } EnvParam;
 
+/* Fields are grouped by how often codegen touches them: the first block
+ * is what a symbol reference reads after env_lookup returns, the rest is
+ * declaration metadata read by the REPL, module export and diagnostics. */
 typedef struct EnvEntry {
-    char *name;
-    char *docstring;  // NULL if none
+    const char *key;  // intern(name): tables match entries by this pointer
     EnvEntryKind kind;
+    bool is_mutable;
+    bool is_closure_abi;
+    bool is_ffi;
+    bool is_exported;  // Whether this symbol is exported
 
     // Variables
     Type *type;
     LLVMValueRef value;
-    bool is_mutable;
-
-    /* HM type scheme — set after inference, NULL if not yet inferred.
-     * Richer than `type`: carries quantified type variables for
-     * polymorphic definitions.  Used by infer_instantiate at call sites. */
-    struct TypeScheme *scheme;
-
-    // Arity  (-1 = variadic)
-    int arity_min;
-    int arity_max;
-    ParamKind param_kinds[WISP_MAX_PARAMS]; // per-param: PARAM_FUNC if slot expects a function
 
     // Functions (ENV_FUNC)
     LLVMValueRef func_ref;
+    LLVMValueRef worker_ref; // unboxed worker behind a closure-ABI function, or NULL
     EnvParam *params;  // array of named+typed params
     int param_count;
     int lifted_count;  // number of hidden captured params (lambda lifting)
-    bool is_closure_abi;
-    bool is_ffi;
     Type *return_type;
 
+    // Arity  (-1 = variadic)
+    int arity_min;
+    int arity_max;
+
+    int   adt_tag;     // tag index for ADT constructors (-1 if not an ADT ctor)
+
+    /* HM type scheme — set after inference, NULL if not yet inferred.
+     * Richer than `type`: carries quantified type variables for
+     * polymorphic definitions.  Used by infer_instantiate at call sites. */
+    struct TypeScheme *scheme;
+
+    char *name;
     char *module_name; // Which module this symbol belongs to (NULL for local)
-    bool is_exported;  // Whether this symbol is exported
-    char *llvm_name;   // mangled LLVM symbol name, snapshot while module is alive
 
+    // Cold: declaration metadata
+    char *docstring;  // NULL if none
+    char *llvm_name;   // mangled LLVM symbol name, snapshot while module is alive
     AST *source_ast;   // original define AST, NULL if not available
-
     char *source_text; // original define Source code, NULL if not available
     char *header_path; // path to C header for FFI symbols, NULL if not FFI
-    int   adt_tag;     // tag index for ADT constructors (-1 if not an ADT ctor)
-
-    struct EnvEntry *next;
+    unsigned decl_epoch; // REPL: module generation this entry was last declared into
+    ParamKind param_kinds[WISP_MAX_PARAMS]; // per-param: PARAM_FUNC if slot expects a function
 } EnvEntry;
 
+/* Each scope is an open-addressed table of entry pointers: `slots` has
+ * `size` (a power of two) cells, probed linearly from intern_hash(key),
+ * and doubles before it passes 70% load.  Entries are allocated one by
+ * one, so an EnvEntry * stays valid while the table grows; iterate with
+ *
+ *     for (size_t i = 0; i < env->size; i++) {
+ *         EnvEntry *e = env->slots[i];
+ *         if (!e) continue;
+ *         ...
+ *     }
+ *
+ * and do not insert into the table being walked. */
 typedef struct Env {
-    EnvEntry **buckets;
+    EnvEntry **slots;
     size_t size;
     size_t count;
     struct Env *parent;
     struct InferEnv *infer_env;  // owned by root Env only; NULL on child scopes
+    struct HmDefCache *hm_defs;  // define schemes for reuse (env_hm_infer_define); root only
     struct DepCtx *dep_ctx;      // TT Master Global Scope (owned by main)
+
+    /* Called on every env_lookup hit in this table, not its parents.  The
+     * REPL uses it to declare an entry into the module being generated
+     * only when codegen actually asks for it. */
+    void (*on_lookup)(EnvEntry *entry, void *userdata);
+    void *on_lookup_data;
 } Env;
 
 Env *env_create(void);
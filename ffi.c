@@ -12,10 +12,13 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <sys/stat.h>
+#include <time.h>
 #if !defined(_WIN32)
 #include <dlfcn.h>
 #endif
 #include <llvm-c/Core.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
 
 /// Helpers
 
@@ -84,6 +87,7 @@ void ffi_context_free(FFIContext *ctx) {
     for (int i = 0; i < ctx->included_count; i++)
         free(ctx->included[i]);
     free(ctx->included);
+    free(ctx->pch_path);
     for (int i = 0; i < ctx->injected_into_count; i++)
         free(ctx->injected_into[i]);
     free(ctx->injected_into);
@@ -222,6 +226,16 @@ static bool already_included(FFIContext *ctx, const char *name) {
     return false;
 }
 
+/* Append an owned path to ctx->included, growing it as needed */
+static void ffi_note_included(FFIContext *ctx, char *path) {
+    if (ctx->included_count >= ctx->included_cap) {
+        ctx->included_cap *= 2;
+        ctx->included = realloc(ctx->included,
+                                sizeof(char *) * ctx->included_cap);
+    }
+    ctx->included[ctx->included_count++] = path;
+}
+
 static bool already_have_function(FFIContext *ctx, const char *name) {
     for (int i = 0; i < ctx->function_count; i++)
         if (strcmp(ctx->functions[i].name, name) == 0) return true;
@@ -289,6 +303,19 @@ static enum CXChildVisitResult field_visitor(CXCursor cursor,
 
     fs->s->fields[fs->idx].name = my_strdup(clang_getCString(fname));
 
+    /* Keep libclang's own placement so the layout can be checked against
+     * what LLVM derives from the field types.  A field below its natural
+     * alignment means #pragma pack or __attribute__((packed)). */
+    long long off_bits = clang_Cursor_getOffsetOfField(cursor);
+    long long falign   = clang_Type_getAlignOf(canon);
+    fs->s->fields[fs->idx].offset    = (off_bits >= 0 && off_bits % 8 == 0)
+                                       ? (int)(off_bits / 8) : -1;
+    fs->s->fields[fs->idx].bit_width = clang_Cursor_isBitField(cursor)
+                                       ? clang_getFieldDeclBitWidth(cursor) : 0;
+    if (fs->s->fields[fs->idx].offset > 0 && falign > 1 &&
+        fs->s->fields[fs->idx].offset % falign != 0)
+        fs->s->packed = true;
+
     /* Use the canonical type kind directly for accurate size mapping.
      * Spelling-based mapping fails for enums ("enum VkStructureType" → unknown)
      * and for typedefs that resolve to primitive sizes. */
@@ -371,7 +398,7 @@ static enum CXChildVisitResult visitor(CXCursor cursor,
             CXString fname = clang_getFileName(file);
             const char *fpath = clang_getCString(fname);
             if (fpath && fpath[0] && !already_included(state->ffi, fpath))
-                state->ffi->included[state->ffi->included_count++] = my_strdup(fpath);
+                ffi_note_included(state->ffi, my_strdup(fpath));
             clang_disposeString(fname);
         }
     }
@@ -591,6 +618,7 @@ static enum CXChildVisitResult visitor(CXCursor cursor,
                 CXType    cx_type = clang_getCursorType(cursor);
                 CXType    canon   = clang_getCanonicalType(cx_type);
                 long long sz      = clang_Type_getSizeOf(canon);
+                long long al      = clang_Type_getAlignOf(canon);
 
                 /* Build a temporary struct on the stack — do NOT take a
                  * pointer into ffi->structs until after field_visitor runs,
@@ -604,6 +632,7 @@ static enum CXChildVisitResult visitor(CXCursor cursor,
                 tmp.fields      = calloc(n_fields, sizeof(FFIStructField));
                 tmp.packed      = false;
                 tmp.size_bytes  = (sz > 0) ? (int)sz : 0;
+                tmp.align_bytes = (al > 0) ? (int)al : 0;
 
                 FieldVisitState fs = { &tmp, 0 };
                 clang_visitChildren(cursor, field_visitor, &fs);
@@ -812,47 +841,19 @@ static char *extract_doc_for_function(const char *src, const char *fname) {
     return NULL;
 }
 
-/// Main parse entry point
-
-bool ffi_parse_header(FFIContext *ctx, const char *header_path,
-                      bool system_include) {
-    /* Avoid double-parsing — check both the raw name and resolved path */
-    if (already_included(ctx, header_path)) return true;
-    char *resolved_early = ffi_resolve_header(header_path, system_include);
-    bool already = already_included(ctx, resolved_early);
-    free(resolved_early);
-    if (already) return true;
-
-    /* Record as included — use a larger initial cap since sub-headers
-     * will be added during the visitor pass */
-    if (ctx->included_count >= ctx->included_cap) {
-        ctx->included_cap *= 2;
-        ctx->included = realloc(ctx->included,
-                                sizeof(char *) * ctx->included_cap);
-    }
-
-    char *resolved_path = ffi_resolve_header(header_path, system_include);
-    ctx->included[ctx->included_count++] = resolved_path;
-
-    /* Try cache first */
-    struct timespec t0, t1;
-    clock_gettime(CLOCK_MONOTONIC, &t0);
-    if (ffi_cache_load(ctx, resolved_path)) {
-        clock_gettime(CLOCK_MONOTONIC, &t1);
-        double ms = (t1.tv_sec - t0.tv_sec) * 1000.0 +
-                    (t1.tv_nsec - t0.tv_nsec) / 1e6;
-        printf("FFI: cache loaded in %.1f ms\n", ms);
-        return true;
-    }
-
-    /* Build a small translation unit that just #includes the header */
-    char tu_src[512];
-    if (system_include)
-        snprintf(tu_src, sizeof(tu_src), "#include <%s>\n", header_path);
-    else
-        snprintf(tu_src, sizeof(tu_src), "#include \"%s\"\n", header_path);
+/// Shared clang state
+//
+// One CXIndex serves every header the process parses.  It is created
+// with excludeDeclarationsFromPCH, so a parse that starts from the
+// previous header's PCH visits only the declarations it adds.
+//
+static CXIndex ffi_index(void) {
+    static CXIndex index;
+    if (!index) index = clang_createIndex(1, 0);
+    return index;
+}
 
-    /* clang args — enable macros, system includes */
+static const char *ffi_resource_arg(void) {
     /* Find clang resource dir for builtins like stddef.h */
     static char resource_arg[256] = {0};
     static bool resource_found = false;
@@ -892,42 +893,137 @@ bool ffi_parse_header(FFIContext *ctx, const char *header_path,
             }
         }
     }
+    return resource_found && resource_arg[0] ? resource_arg : NULL;
+}
 
-    /* Build -include args for all previously parsed headers so that
-     * guards like #ifdef VK_VERSION_1_0 evaluate correctly when
-     * a later header (glfw3.h) depends on a prior one (vulkan.h). */
-    int n_prior = ctx->included_count;
-    /* Each prior header needs 2 slots: "-include" + path.
-     * Plus 16 for fixed args. */
-    const char **clang_args = malloc(sizeof(char*) * (16 + n_prior * 2));
+/* clang args — enable macros, system includes.  Every previously parsed
+ * header is force-included so guards like #ifdef VK_VERSION_1_0 evaluate
+ * correctly when a later header (glfw3.h) depends on a prior one
+ * (vulkan.h).  With `use_pch` the headers the context PCH already covers
+ * come from it instead.  `args` needs 18 + 2 * n_prior slots. */
+static int ffi_clang_args(FFIContext *ctx, const char *header_path,
+                          int n_prior, bool use_pch, const char **args) {
     int n_args = 0;
-    clang_args[n_args++] = "-x";
-    clang_args[n_args++] = "c";
-    clang_args[n_args++] = "-std=gnu11";
-    clang_args[n_args++] = "-D_GNU_SOURCE";
-    clang_args[n_args++] = "-D__STDC_CONSTANT_MACROS";
-    clang_args[n_args++] = "-D__STDC_LIMIT_MACROS";
-    for (int pi = 0; pi < n_prior; pi++) {
-        clang_args[n_args++] = "-include";
-        clang_args[n_args++] = ctx->included[pi];
+    args[n_args++] = "-x";
+    args[n_args++] = "c";
+    args[n_args++] = "-std=gnu11";
+    args[n_args++] = "-D_GNU_SOURCE";
+    args[n_args++] = "-D__STDC_CONSTANT_MACROS";
+    args[n_args++] = "-D__STDC_LIMIT_MACROS";
+    int first = 0;
+    if (use_pch) {
+        args[n_args++] = "-include-pch";
+        args[n_args++] = ctx->pch_path;
+        first = ctx->pch_covers < n_prior ? ctx->pch_covers : n_prior;
+    }
+    for (int pi = first; pi < n_prior; pi++) {
+        args[n_args++] = "-include";
+        args[n_args++] = ctx->included[pi];
     }
 
     /* Add FreeType include directory directly */
-    clang_args[n_args++] = "-I/usr/include/freetype2";
+    args[n_args++] = "-I/usr/include/freetype2";
 
     /* FreeType fix: ft2build.h MUST be present for freetype.h to parse in C */
     if (strstr(header_path, "freetype/")) {
-        clang_args[n_args++] = "-include";
-        clang_args[n_args++] = "ft2build.h";
-        clang_args[n_args++] = "-Dconst="; // Optional: prevents some Clang parser skips
+        args[n_args++] = "-include";
+        args[n_args++] = "ft2build.h";
+        args[n_args++] = "-Dconst="; // Optional: prevents some Clang parser skips
+    }
+
+    const char *resource = ffi_resource_arg();
+    if (resource) args[n_args++] = resource;
+    return n_args;
+}
+
+static bool ffi_has_fatal(CXTranslationUnit tu) {
+    bool fatal = false;
+    unsigned n_diag = clang_getNumDiagnostics(tu);
+    for (unsigned i = 0; i < n_diag && !fatal; i++) {
+        CXDiagnostic diag = clang_getDiagnostic(tu, i);
+        fatal = clang_getDiagnosticSeverity(diag) == CXDiagnostic_Fatal;
+        clang_disposeDiagnostic(diag);
+    }
+    return fatal;
+}
+
+/* Cache key: the TU source and every argument that reaches clang */
+static uint64_t ffi_cache_key(const char *tu_src, const char **args, int n_args) {
+    uint64_t h = module_hash_update(MODULE_HASH_SEED, tu_src, strlen(tu_src) + 1);
+    for (int i = 0; i < n_args; i++)
+        h = module_hash_update(h, args[i], strlen(args[i]) + 1);
+    return h;
+}
+
+typedef struct {
+    char **paths;
+    int    count;
+    int    cap;
+} FFIDeps;
+
+static void ffi_deps_add(FFIDeps *deps, const char *path) {
+    for (int i = 0; i < deps->count; i++)
+        if (strcmp(deps->paths[i], path) == 0) return;
+    if (deps->count >= deps->cap) {
+        deps->cap   = deps->cap ? deps->cap * 2 : 64;
+        deps->paths = realloc(deps->paths, sizeof(char *) * deps->cap);
     }
+    deps->paths[deps->count++] = my_strdup(path);
+}
+
+static void ffi_collect_inclusion(CXFile file, CXSourceLocation *stack,
+                                  unsigned depth, CXClientData data) {
+    (void)stack; (void)depth;
+    CXString name = clang_getFileName(file);
+    const char *path = clang_getCString(name);
+    /* The in-memory TU has no file to stamp */
+    if (path && path[0] && strcmp(path, "__ffi_include__.c") != 0)
+        ffi_deps_add((FFIDeps *)data, path);
+    clang_disposeString(name);
+}
+
+static char *ffi_cache_path(const char *header_path, uint64_t key, const char *ext);
+static void  ffi_cache_mkdir(void);
+
+/// Main parse entry point
+
+bool ffi_parse_header(FFIContext *ctx, const char *header_path,
+                      bool system_include) {
+    /* Avoid double-parsing — check both the raw name and resolved path */
+    if (already_included(ctx, header_path)) return true;
+    char *resolved_early = ffi_resolve_header(header_path, system_include);
+    bool already = already_included(ctx, resolved_early);
+    free(resolved_early);
+    if (already) return true;
 
-    if (resource_found && resource_arg[0])
-        clang_args[n_args++] = resource_arg;
-    /* n_args is now final — clang_args was heap-allocated above */
+    char *resolved_path = ffi_resolve_header(header_path, system_include);
+    ffi_note_included(ctx, resolved_path);
 
+    /* Build a small translation unit that just #includes the header */
+    char tu_src[512];
+    if (system_include)
+        snprintf(tu_src, sizeof(tu_src), "#include <%s>\n", header_path);
+    else
+        snprintf(tu_src, sizeof(tu_src), "#include \"%s\"\n", header_path);
+
+    /* Each prior header needs 2 slots: "-include" + path, plus 2 for
+     * -include-pch and 16 for fixed args. */
+    int n_prior = ctx->included_count;
+    const char **clang_args = malloc(sizeof(char*) * (18 + n_prior * 2));
+    int n_args = ffi_clang_args(ctx, header_path, n_prior, false, clang_args);
+
+    /* Try cache first */
+    uint64_t key = ffi_cache_key(tu_src, clang_args, n_args);
+    struct timespec t0, t1;
     clock_gettime(CLOCK_MONOTONIC, &t0);
-    CXIndex index = clang_createIndex(0, 0);
+    if (ffi_cache_load(ctx, resolved_path, key)) {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = (t1.tv_sec - t0.tv_sec) * 1000.0 +
+                    (t1.tv_nsec - t0.tv_nsec) / 1e6;
+        printf("FFI: cache loaded in %.1f ms\n", ms);
+        free(clang_args);
+        return true;
+    }
 
     /* Parse from an in-memory buffer */
     struct CXUnsavedFile unsaved = {
@@ -935,19 +1031,37 @@ bool ffi_parse_header(FFIContext *ctx, const char *header_path,
         .Contents = tu_src,
         .Length   = strlen(tu_src)
     };
+    /* Bodies are never needed for bindings; ForSerialization lets the TU
+     * be saved as the PCH the next header starts from. */
+    unsigned options = CXTranslationUnit_DetailedPreprocessingRecord |
+                       CXTranslationUnit_SkipFunctionBodies |
+                       CXTranslationUnit_ForSerialization;
 
-    CXTranslationUnit tu = clang_parseTranslationUnit(
-        index,
-        "__ffi_include__.c",
-        clang_args, n_args,
-        &unsaved, 1,
-        CXTranslationUnit_DetailedPreprocessingRecord |
-        CXTranslationUnit_SkipFunctionBodies
-    );
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    CXTranslationUnit tu = NULL;
+    if (ctx->pch_path && file_exists(ctx->pch_path)) {
+        int n_pch = ffi_clang_args(ctx, header_path, n_prior, true, clang_args);
+        tu = clang_parseTranslationUnit(ffi_index(), "__ffi_include__.c",
+                                        clang_args, n_pch, &unsaved, 1, options);
+        if (tu && ffi_has_fatal(tu)) {
+            /* Stale or incompatible PCH: parse everything from source */
+            clang_disposeTranslationUnit(tu);
+            tu = NULL;
+        }
+        if (!tu) {
+            free(ctx->pch_path);
+            ctx->pch_path   = NULL;
+            ctx->pch_covers = 0;
+        }
+        n_args = ffi_clang_args(ctx, header_path, n_prior, false, clang_args);
+    }
+    if (!tu)
+        tu = clang_parseTranslationUnit(ffi_index(), "__ffi_include__.c",
+                                        clang_args, n_args, &unsaved, 1, options);
 
     if (!tu) {
         fprintf(stderr, "ffi: failed to parse header '%s'\n", header_path);
-        clang_disposeIndex(index);
+        free(clang_args);
         return false;
     }
 
@@ -969,8 +1083,24 @@ bool ffi_parse_header(FFIContext *ctx, const char *header_path,
     CXCursor root = clang_getTranslationUnitCursor(tu);
     clang_visitChildren(root, visitor, &state);
 
+    /* The include closure: every file this TU read, plus everything the
+     * context already holds (a PCH hides the files it was built from) */
+    FFIDeps deps = {0};
+    clang_getInclusions(tu, ffi_collect_inclusion, &deps);
+    for (int i = 0; i < ctx->included_count; i++)
+        ffi_deps_add(&deps, ctx->included[i]);
+
+    char *pch = ffi_cache_path(resolved_path, key, "pch");
+    ffi_cache_mkdir();
+    if (clang_saveTranslationUnit(tu, pch, clang_defaultSaveOptions(tu)) == CXSaveError_None) {
+        free(ctx->pch_path);
+        ctx->pch_path   = pch;
+        ctx->pch_covers = ctx->included_count;
+    } else {
+        free(pch);
+    }
+
     clang_disposeTranslationUnit(tu);
-    clang_disposeIndex(index);
     free(clang_args);
 
     /* Post-parse: read source text once and extract docstrings for all
@@ -1005,7 +1135,9 @@ bool ffi_parse_header(FFIContext *ctx, const char *header_path,
         ffi_parse_struct_macros(ctx, ctx->included[i]);
 
     /* Save to cache for next time */
-    ffi_cache_save(ctx, resolved_path);
+    ffi_cache_save(ctx, resolved_path, key, deps.paths, deps.count);
+    for (int i = 0; i < deps.count; i++) free(deps.paths[i]);
+    free(deps.paths);
     clock_gettime(CLOCK_MONOTONIC, &t1);
     double ms = (t1.tv_sec - t0.tv_sec) * 1000.0 +
                 (t1.tv_nsec - t0.tv_nsec) / 1e6;
@@ -1369,6 +1501,69 @@ static const char *strip_prefix(FFIContext *ffi, const char *name) {
     return NULL; /* no match */
 }
 
+/// Layout ABI check
+//
+// A layout is handed to C by pointer, so its LLVM struct must place every
+// field where the C compiler does.  LLVM derives the placement from the
+// field types; libclang reports what C actually uses.  They disagree for
+// bitfields, over-aligned members and anything ffi_map_c_type sized wrong,
+// and such a layout is only safe to pass through as an opaque pointer.
+
+static LLVMTargetDataRef ffi_host_target_data(void) {
+    static LLVMTargetDataRef data;
+    static bool              tried;
+    if (tried) return data;
+    tried = true;
+
+    LLVMInitializeNativeTarget();
+    char          *triple = LLVMGetDefaultTargetTriple();
+    LLVMTargetRef  target = NULL;
+    char          *err    = NULL;
+    if (triple && LLVMGetTargetFromTriple(triple, &target, &err) == 0 && target) {
+        LLVMTargetMachineRef tm = LLVMCreateTargetMachine(
+            target, triple, "generic", "", LLVMCodeGenLevelNone,
+            LLVMRelocDefault, LLVMCodeModelDefault);
+        if (tm) {
+            data = LLVMCreateTargetDataLayout(tm);
+            LLVMDisposeTargetMachine(tm);
+        }
+    }
+    if (err) LLVMDisposeMessage(err);
+    if (triple) LLVMDisposeMessage(triple);
+    return data;
+}
+
+static void ffi_check_layout_abi(CodegenContext *cg, FFIStruct *s) {
+    char sname[256];
+    snprintf(sname, sizeof(sname), "layout.%s", s->name);
+    LLVMTypeRef       st = LLVMGetTypeByName2(cg->context, sname);
+    LLVMTargetDataRef td = ffi_host_target_data();
+    if (!st || !td || LLVMIsOpaqueStruct(st)) return;
+
+    for (int j = 0; j < s->field_count; j++) {
+        FFIStructField *f = &s->fields[j];
+        if (f->bit_width > 0) {
+            fprintf(stderr, "FFI: warning: layout %s: bitfield %s has no "
+                    "Monad field type; pass %s by pointer only\n",
+                    s->name, f->name ? f->name : "?", s->name);
+            return;
+        }
+        if (f->offset < 0) continue;
+        unsigned long long off = LLVMOffsetOfElement(td, st, (unsigned)j);
+        if (off != (unsigned long long)f->offset) {
+            fprintf(stderr, "FFI: warning: layout %s: field %s is at offset "
+                    "%llu, C puts it at %d; pass %s by pointer only\n",
+                    s->name, f->name ? f->name : "?", off, f->offset, s->name);
+            return;
+        }
+    }
+    unsigned long long size = LLVMABISizeOfType(td, st);
+    if (s->size_bytes > 0 && size != (unsigned long long)s->size_bytes)
+        fprintf(stderr, "FFI: warning: layout %s is %llu bytes, C has %d; "
+                "pass %s by pointer only\n",
+                s->name, size, s->size_bytes, s->name);
+}
+
 void ffi_inject_into_env(FFIContext *ffi, CodegenContext *cg) {
     /* Guard: skip entirely if nothing new to inject into this module */
     const char *mod_name = (cg->module_ctx && cg->module_ctx->decl)
@@ -1459,9 +1654,11 @@ void ffi_inject_into_env(FFIContext *ffi, CodegenContext *cg) {
             }
             fields[j].size = sz;
         }
-        layout_compute_offsets(fields, s->field_count, false, NULL);
+        layout_compute_offsets(fields, s->field_count, s->packed, NULL);
+        for (int j = 0; j < s->field_count; j++)
+            if (s->fields[j].offset >= 0) fields[j].offset = s->fields[j].offset;
         Type *layout_type = type_layout(s->name, fields, s->field_count,
-                                        s->size_bytes, false, 0);
+                                        s->size_bytes, s->packed, s->align_bytes);
         env_insert_layout(cg->env, s->name, layout_type, NULL);
         printf("FFI: layout %s (%d fields, %d bytes)\n",
                s->name, s->field_count, s->size_bytes);
@@ -1471,7 +1668,9 @@ void ffi_inject_into_env(FFIContext *ffi, CodegenContext *cg) {
         FFIStruct *s = &ffi->structs[i];
         if (!s->name || s->alias_of || s->field_count == 0) continue;
         Type *lt = env_lookup_layout(cg->env, s->name);
-        if (lt) type_to_llvm(cg, lt);
+        if (!lt) continue;
+        type_to_llvm(cg, lt);
+        ffi_check_layout_abi(cg, s);
     }
 
     /* ── PASS 2: Typedef aliases (loop until stable) ─────────────────────── */
@@ -1799,14 +1998,17 @@ void ffi_dump(FFIContext *ctx) {
 
 /// FFI cache
 //
-// Cache is stored in ~/.cache/monad/<escaped_header_path>.ffic
-// Format: magic + mtime + serialized functions/constants/structs.
-// If the header mtime matches, we skip the clang parse entirely.
+// Cache is stored in ~/.cache/monad/<escaped_header_path>-<key>.ffic,
+// next to the .pch of the same parse.  The key hashes the clang arguments,
+// so the same header parsed after different priors gets its own entry.
+// Format: magic + version + key + include closure (path, size, mtime per
+// file) + serialized functions/constants/structs.  If every file of the
+// closure is unchanged, we skip the clang parse entirely.
 //
 #define FFI_CACHE_MAGIC 0x464649C0  /* "FFI\xC0" */
-#define FFI_CACHE_VERSION 1
+#define FFI_CACHE_VERSION 3
 
-static char *ffi_cache_path(const char *header_path) {
+static char *ffi_cache_path(const char *header_path, uint64_t key, const char *ext) {
     const char *home = getenv("HOME");
     if (!home) home = "/tmp";
     /* escape the header path: replace / with _ */
@@ -1818,15 +2020,18 @@ static char *ffi_cache_path(const char *header_path) {
         p++;
     }
     escaped[ei] = '\0';
-    char *result = malloc(512);
-    snprintf(result, 512, "%s/.cache/monad/%s.ffic", home, escaped);
+    char *result = malloc(640);
+    snprintf(result, 640, "%s/.cache/monad/%s-%016llx.%s", home, escaped,
+             (unsigned long long)key, ext);
     return result;
 }
 
-static time_t ffi_header_mtime(const char *header_path) {
+/* Size and mtime of a closure file; both -1 when it is gone */
+static void ffi_file_stamp(const char *path, int64_t *size, int64_t *mtime) {
     struct stat st;
-    if (stat(header_path, &st) != 0) return 0;
-    return st.st_mtime;
+    if (stat(path, &st) != 0) { *size = -1; *mtime = -1; return; }
+    *size  = (int64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
 }
 
 static void ffi_cache_mkdir(void) {
@@ -1915,9 +2120,10 @@ static Type *read_type(FILE *f) {
     return t;
 }
 
-bool ffi_cache_save(FFIContext *ctx, const char *header_path) {
+bool ffi_cache_save(FFIContext *ctx, const char *header_path, uint64_t key,
+                    char **deps, int dep_count) {
     ffi_cache_mkdir();
-    char *path = ffi_cache_path(header_path);
+    char *path = ffi_cache_path(header_path, key, "ffic");
     FILE *f = fopen(path, "wb");
     free(path);
     if (!f) return false;
@@ -1925,10 +2131,20 @@ bool ffi_cache_save(FFIContext *ctx, const char *header_path) {
     /* Header */
     uint32_t magic = FFI_CACHE_MAGIC;
     uint32_t ver   = FFI_CACHE_VERSION;
-    int64_t  mtime = (int64_t)ffi_header_mtime(header_path);
     fwrite(&magic, 4, 1, f);
     fwrite(&ver,   4, 1, f);
-    fwrite(&mtime, 8, 1, f);
+    fwrite(&key,   8, 1, f);
+
+    /* Include closure */
+    uint32_t nd = dep_count;
+    fwrite(&nd, 4, 1, f);
+    for (int i = 0; i < dep_count; i++) {
+        int64_t size, mtime;
+        ffi_file_stamp(deps[i], &size, &mtime);
+        write_str(f, deps[i]);
+        fwrite(&size,  8, 1, f);
+        fwrite(&mtime, 8, 1, f);
+    }
 
     /* Functions */
     uint32_t nfn = ctx->function_count;
@@ -1972,15 +2188,21 @@ bool ffi_cache_save(FFIContext *ctx, const char *header_path) {
         write_str(f, s->alias_of);
         uint32_t nf = s->field_count;
         int32_t  sb = s->size_bytes;
+        int32_t  al = s->align_bytes;
         uint8_t  pk = s->packed ? 1 : 0;
         uint8_t  sc = s->is_scalar_typedef ? 1 : 0;
         fwrite(&nf, 4, 1, f);
         fwrite(&sb, 4, 1, f);
+        fwrite(&al, 4, 1, f);
         fwrite(&pk, 1, 1, f);
         fwrite(&sc, 1, 1, f);
         for (int j = 0; j < s->field_count; j++) {
+            int32_t off = s->fields[j].offset;
+            int32_t bw  = s->fields[j].bit_width;
             write_str(f, s->fields[j].name);
             write_type(f, s->fields[j].type);
+            fwrite(&off, 4, 1, f);
+            fwrite(&bw,  4, 1, f);
         }
     }
 
@@ -1996,22 +2218,30 @@ bool ffi_cache_save(FFIContext *ctx, const char *header_path) {
     return true;
 }
 
-bool ffi_cache_load(FFIContext *ctx, const char *header_path) {
-    char *path = ffi_cache_path(header_path);
+bool ffi_cache_load(FFIContext *ctx, const char *header_path, uint64_t key) {
+    char *path = ffi_cache_path(header_path, key, "ffic");
     FILE *f = fopen(path, "rb");
     free(path);
     if (!f) return false;
 
-    uint32_t magic, ver;
-    int64_t  cached_mtime;
+    uint32_t magic, ver, nd;
+    uint64_t cached_key;
     if (fread(&magic, 4, 1, f) != 1 || magic != FFI_CACHE_MAGIC) { fclose(f); return false; }
     if (fread(&ver,   4, 1, f) != 1 || ver   != FFI_CACHE_VERSION) { fclose(f); return false; }
-    if (fread(&cached_mtime, 8, 1, f) != 1) { fclose(f); return false; }
-
-    /* Check mtime of the top-level header */
-    int64_t current_mtime = (int64_t)ffi_header_mtime(header_path);
-    if (current_mtime != cached_mtime) {
-        fclose(f); return false; /* stale */
+    if (fread(&cached_key, 8, 1, f) != 1 || cached_key != key) { fclose(f); return false; }
+
+    /* Every file of the include closure must be unchanged */
+    if (fread(&nd, 4, 1, f) != 1) { fclose(f); return false; }
+    for (uint32_t i = 0; i < nd; i++) {
+        char   *dep = read_str(f);
+        int64_t size, mtime, cur_size, cur_mtime;
+        bool ok = dep && fread(&size, 8, 1, f) == 1 && fread(&mtime, 8, 1, f) == 1;
+        if (ok) {
+            ffi_file_stamp(dep, &cur_size, &cur_mtime);
+            ok = cur_size == size && cur_mtime == mtime;
+        }
+        free(dep);
+        if (!ok) { fclose(f); return false; } /* stale */
     }
 
     /* Functions */
@@ -2060,19 +2290,26 @@ bool ffi_cache_load(FFIContext *ctx, const char *header_path) {
         FFIStruct s = {0};
         s.name     = read_str(f);
         s.alias_of = read_str(f);
-        uint32_t nf; int32_t sb; uint8_t pk;
+        uint32_t nf; int32_t sb, al; uint8_t pk;
         fread(&nf, 4, 1, f);
         fread(&sb, 4, 1, f);
+        fread(&al, 4, 1, f);
         fread(&pk, 1, 1, f);
         uint8_t sc; fread(&sc, 1, 1, f);
         s.field_count      = nf;
         s.size_bytes       = sb;
+        s.align_bytes      = al;
         s.packed           = pk;
         s.is_scalar_typedef = sc;
         s.fields = nf > 0 ? calloc(nf, sizeof(FFIStructField)) : NULL;
         for (uint32_t j = 0; j < nf; j++) {
+            int32_t off, bw;
             s.fields[j].name = read_str(f);
             s.fields[j].type = read_type(f);
+            fread(&off, 4, 1, f);
+            fread(&bw,  4, 1, f);
+            s.fields[j].offset    = off;
+            s.fields[j].bit_width = bw;
         }
         if (ctx->struct_count >= ctx->struct_cap) {
             ctx->struct_cap *= 2;
@@ -2086,13 +2323,8 @@ bool ffi_cache_load(FFIContext *ctx, const char *header_path) {
     if (fread(&ni, 4, 1, f) != 1) { fclose(f); return false; }
     for (uint32_t i = 0; i < ni; i++) {
         char *inc = read_str(f);
-        if (inc) {
-            if (ctx->included_count >= ctx->included_cap) {
-                ctx->included_cap *= 2;
-                ctx->included = realloc(ctx->included, sizeof(char*) * ctx->included_cap);
-            }
-            ctx->included[ctx->included_count++] = inc;
-        }
+        if (inc && !already_included(ctx, inc)) ffi_note_included(ctx, inc);
+        else free(inc);
     }
 
     fclose(f);
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "types.h"
 #include "codegen.h"
 #include "env.h"
@@ -42,6 +43,8 @@ typedef struct FFIConstant {
 typedef struct FFIStructField {
     char *name;
     Type *type;
+    int   offset;    /* byte offset libclang reports, -1 if not byte-aligned */
+    int   bit_width; /* > 0 for bitfields */
 } FFIStructField;
 
 /// FFI Struct
@@ -52,7 +55,8 @@ typedef struct FFIStruct {
     FFIStructField *fields;
     int             field_count;
     int             size_bytes;
-    bool            packed;
+    int             align_bytes;
+    bool            packed;     /* some field sits below its natural alignment */
     bool            is_scalar_typedef; /* true for uint64_t/pointer typedefs */
 } FFIStruct;
 
@@ -78,6 +82,11 @@ typedef struct FFIContext {
     char        **included;
     int           included_count;
     int           included_cap;
+    /* PCH of the last full parse, and how many `included` entries it
+     * already covers; later parses start from it instead of re-reading
+     * those headers through -include */
+    char         *pch_path;
+    int           pch_covers;
     /* Prefixes to strip when injecting symbols (from :unprefix) */
     char        **strip_prefixes;
     int           strip_prefix_count;
@@ -122,7 +131,11 @@ Type *ffi_map_c_type(const char *c_type_spelling);
 void ffi_dump(FFIContext *ctx);
 
 
-bool ffi_cache_save(FFIContext *ctx, const char *header_path);
-bool ffi_cache_load(FFIContext *ctx, const char *header_path);
+/* Header cache.  `key` hashes the clang arguments of the parse; an entry
+ * is valid only while every file of its include closure, `deps`, keeps
+ * the size and mtime recorded at save time. */
+bool ffi_cache_save(FFIContext *ctx, const char *header_path, uint64_t key,
+                    char **deps, int dep_count);
+bool ffi_cache_load(FFIContext *ctx, const char *header_path, uint64_t key);
 
 #endif /* FFI_H */
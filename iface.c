@@ -0,0 +1,1042 @@
+/// iface.c — Module interface serialization
+//
+//  See iface.h for the format contract.  Type and AST encoders mirror
+//  type_clone/ast_clone field for field: whatever a clone preserves, a
+//  round trip through an interface file preserves too.
+
+#include "iface.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Interface data is produced by the compiler, but a corrupt or hostile file
+// must not be able to blow the C stack through deeply nested types/ASTs.
+#define IFACE_MAX_DEPTH 4096
+
+// Arrays longer than this are rejected on read before anything is allocated.
+#define IFACE_MAX_COUNT (1u << 24)
+
+
+/// Writer
+
+void iface_writer_init(IfaceWriter *w) {
+    w->cap = 4096;
+    w->len = 0;
+    w->buf = malloc(w->cap);
+    w->ok  = w->buf != NULL;
+}
+
+void iface_writer_free(IfaceWriter *w) {
+    free(w->buf);
+    w->buf = NULL;
+    w->len = w->cap = 0;
+}
+
+void iface_put_bytes(IfaceWriter *w, const void *data, size_t len) {
+    if (!w->ok) return;
+    if (w->len + len > w->cap) {
+        size_t cap = w->cap ? w->cap : 4096;
+        while (cap < w->len + len) cap *= 2;
+        unsigned char *grown = realloc(w->buf, cap);
+        if (!grown) { w->ok = false; return; }
+        w->buf = grown;
+        w->cap = cap;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+void iface_put_u8(IfaceWriter *w, uint8_t v) {
+    iface_put_bytes(w, &v, 1);
+}
+
+void iface_put_u32(IfaceWriter *w, uint32_t v) {
+    unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8),
+                           (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+    iface_put_bytes(w, b, 4);
+}
+
+void iface_put_i64(IfaceWriter *w, int64_t v) {
+    uint64_t u = (uint64_t)v;
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) b[i] = (unsigned char)(u >> (8 * i));
+    iface_put_bytes(w, b, 8);
+}
+
+void iface_put_f64(IfaceWriter *w, double v) {
+    int64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    iface_put_i64(w, bits);
+}
+
+// Strings are a u32 length + bytes; 0xFFFFFFFF encodes NULL.
+void iface_put_str(IfaceWriter *w, const char *s) {
+    if (!s) { iface_put_u32(w, 0xFFFFFFFFu); return; }
+    size_t n = strlen(s);
+    iface_put_u32(w, (uint32_t)n);
+    iface_put_bytes(w, s, n);
+}
+
+static void put_bool(IfaceWriter *w, bool b) { iface_put_u8(w, b ? 1 : 0); }
+static void put_int (IfaceWriter *w, int v)  { iface_put_i64(w, v); }
+
+bool iface_writer_save(const IfaceWriter *w, const char *path) {
+    if (!w->ok) return false;
+    char tmp[1100];
+#if defined(_WIN32)
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+#else
+    snprintf(tmp, sizeof(tmp), "%s.tmp%ld", path, (long)getpid());
+#endif
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(w->buf, 1, w->len, f) == w->len;
+    if (fclose(f) != 0) ok = false;
+#if defined(_WIN32)
+    if (ok) remove(path);
+#endif
+    if (!ok || rename(tmp, path) != 0) { remove(tmp); return false; }
+    return true;
+}
+
+
+/// Types
+
+static void put_type_depth(IfaceWriter *w, const Type *t, int depth);
+
+static void put_layout_fields(IfaceWriter *w, const Type *t, int depth) {
+    int n = t->layout_fields ? t->layout_field_count : 0;
+    put_int(w, n);
+    for (int i = 0; i < n; i++) {
+        const LayoutField *f = &t->layout_fields[i];
+        iface_put_str(w, f->name);
+        put_type_depth(w, f->type, depth + 1);
+        put_int(w, f->offset);
+        put_int(w, f->size);
+    }
+}
+
+static void put_type_depth(IfaceWriter *w, const Type *t, int depth) {
+    if (depth > IFACE_MAX_DEPTH) { w->ok = false; return; }
+    if (!t) { iface_put_u8(w, 0); return; }
+    iface_put_u8(w, 1);
+    put_int(w, t->kind);
+
+    switch (t->kind) {
+    case TYPE_VAR:
+        put_int(w, t->var_id);
+        break;
+    case TYPE_ARROW:
+        put_type_depth(w, t->arrow_param, depth + 1);
+        put_type_depth(w, t->arrow_ret, depth + 1);
+        break;
+    case TYPE_FN: {
+        int n = t->params ? t->param_count : 0;
+        put_int(w, t->param_count);
+        put_int(w, n);
+        for (int i = 0; i < n; i++) {
+            iface_put_str(w, t->params[i].name);
+            put_type_depth(w, t->params[i].type, depth + 1);
+            put_bool(w, t->params[i].optional);
+            put_bool(w, t->params[i].rest);
+        }
+        put_type_depth(w, t->return_type, depth + 1);
+        break;
+    }
+    case TYPE_LIST:
+        put_int(w, t->list_types ? t->list_count : 0);
+        for (int i = 0; t->list_types && i < t->list_count; i++)
+            put_type_depth(w, t->list_types[i], depth + 1);
+        put_type_depth(w, t->list_elem, depth + 1);
+        break;
+    case TYPE_PTR:
+    case TYPE_OPTIONAL:
+    case TYPE_COLL:
+        put_type_depth(w, t->element_type, depth + 1);
+        break;
+    case TYPE_ARR:
+        put_type_depth(w, t->arr_element_type, depth + 1);
+        iface_put_i64(w, t->arr_size);
+        put_bool(w, t->arr_is_fat);
+        put_bool(w, t->arr_is_heap);
+        break;
+    case TYPE_MAP:
+        put_type_depth(w, t->map_key_type, depth + 1);
+        put_type_depth(w, t->map_value_type, depth + 1);
+        break;
+    case TYPE_LAYOUT:
+        iface_put_str(w, t->layout_name);
+        put_layout_fields(w, t, depth);
+        put_int(w, t->layout_total_size);
+        put_bool(w, t->layout_packed);
+        put_int(w, t->layout_align);
+        put_bool(w, t->layout_is_scalar);
+        put_bool(w, t->layout_is_inline);
+        break;
+    case TYPE_INT_ARBITRARY:
+        put_int(w, t->numeric_width);
+        put_bool(w, t->numeric_signed);
+        break;
+    case TYPE_APP:
+        iface_put_str(w, t->app_constructor);
+        put_type_depth(w, t->app_arg, depth + 1);
+        break;
+    case TYPE_FINITE_SET:
+        iface_put_str(w, t->finite_name);
+        iface_put_i64(w, (int64_t)t->finite_member_count);
+        break;
+    default:
+        break;
+    }
+}
+
+void iface_put_type(IfaceWriter *w, const Type *t) {
+    put_type_depth(w, t, 0);
+}
+
+
+/// AST
+
+static void put_ast_depth(IfaceWriter *w, const AST *ast, int depth);
+
+static void put_ast_array(IfaceWriter *w, AST *const *items, size_t n, int depth) {
+    iface_put_i64(w, (int64_t)(items ? n : 0));
+    for (size_t i = 0; items && i < n; i++)
+        put_ast_depth(w, items[i], depth + 1);
+}
+
+static void put_str_array(IfaceWriter *w, char *const *items, int n) {
+    put_int(w, items ? n : 0);
+    for (int i = 0; items && i < n; i++)
+        iface_put_str(w, items[i]);
+}
+
+static void put_pattern(IfaceWriter *w, const ASTPattern *p, int depth) {
+    if (depth > IFACE_MAX_DEPTH) { w->ok = false; return; }
+    put_int(w, p->kind);
+    iface_put_str(w, p->var_name);
+    iface_put_f64(w, p->lit_value);
+    iface_put_f64(w, p->range_end);
+    put_int(w, p->elements ? p->element_count : 0);
+    for (int i = 0; p->elements && i < p->element_count; i++)
+        put_pattern(w, &p->elements[i], depth + 1);
+    put_bool(w, p->tail != NULL);
+    if (p->tail) put_pattern(w, p->tail, depth + 1);
+    put_int(w, p->ctor_fields ? p->ctor_field_count : 0);
+    for (int i = 0; p->ctor_fields && i < p->ctor_field_count; i++)
+        put_pattern(w, &p->ctor_fields[i], depth + 1);
+}
+
+static void put_ast_depth(IfaceWriter *w, const AST *ast, int depth) {
+    if (depth > IFACE_MAX_DEPTH) { w->ok = false; return; }
+    if (!ast) { iface_put_u8(w, 0); return; }
+    iface_put_u8(w, 1);
+    put_int(w, ast->type);
+    put_int(w, ast->line);
+    put_int(w, ast->column);
+    put_int(w, ast->end_column);
+    iface_put_str(w, (ast->type == AST_NUMBER || ast->type == AST_SYMBOL)
+                     ? ast->literal_str : NULL);
+    put_bool(w, ast->has_raw_int);
+    iface_put_i64(w, (int64_t)ast->raw_int);
+    put_type_depth(w, ast->inferred_type, depth + 1);
+
+    switch (ast->type) {
+    case AST_NUMBER:
+        iface_put_f64(w, ast->number);
+        break;
+    case AST_CHAR:
+        iface_put_u8(w, (uint8_t)ast->character);
+        break;
+    case AST_SYMBOL:
+        iface_put_str(w, ast->symbol);
+        break;
+    case AST_STRING:
+    case AST_PATH:
+        iface_put_str(w, ast->string);
+        break;
+    case AST_KEYWORD:
+        iface_put_str(w, ast->keyword);
+        break;
+    case AST_RATIO:
+        iface_put_i64(w, ast->ratio.numerator);
+        iface_put_i64(w, ast->ratio.denominator);
+        break;
+    case AST_LIST:
+    case AST_ADDRESS_OF:
+        put_ast_array(w, ast->list.items, ast->list.count, depth);
+        break;
+    case AST_ARRAY:
+        put_ast_array(w, ast->array.elements, ast->array.element_count, depth);
+        put_bool(w, ast->array.is_heap);
+        break;
+    case AST_SET:
+        put_ast_array(w, ast->set.elements, ast->set.element_count, depth);
+        break;
+    case AST_MAP:
+        put_ast_array(w, ast->map.keys, ast->map.count, depth);
+        put_ast_array(w, ast->map.vals, ast->map.count, depth);
+        break;
+    case AST_LAMBDA:
+        put_int(w, ast->lambda.params ? ast->lambda.param_count : 0);
+        for (int i = 0; ast->lambda.params && i < ast->lambda.param_count; i++) {
+            const ASTParam *p = &ast->lambda.params[i];
+            iface_put_str(w, p->name);
+            iface_put_str(w, p->type_name);
+            put_bool(w, p->is_rest);
+            put_bool(w, p->is_anon);
+        }
+        iface_put_str(w, ast->lambda.return_type);
+        iface_put_str(w, ast->lambda.docstring);
+        iface_put_str(w, ast->lambda.alias_name);
+        put_bool(w, ast->lambda.naked);
+        put_ast_array(w, ast->lambda.body_exprs, (size_t)ast->lambda.body_count, depth);
+        /* body normally aliases the last body expression; only a bodiless
+         * lambda needs it spelled out. */
+        if (ast->lambda.body_count <= 0) put_ast_depth(w, ast->lambda.body, depth + 1);
+        put_ast_depth(w, ast->lambda.pattern_match, depth + 1);
+        break;
+    case AST_ASM:
+        put_ast_array(w, ast->asm_block.instructions,
+                      ast->asm_block.instruction_count, depth);
+        break;
+    case AST_REFINEMENT:
+        iface_put_str(w, ast->refinement.name);
+        iface_put_str(w, ast->refinement.var);
+        iface_put_str(w, ast->refinement.base_type);
+        put_ast_depth(w, ast->refinement.predicate, depth + 1);
+        iface_put_str(w, ast->refinement.docstring);
+        iface_put_str(w, ast->refinement.alias_name);
+        break;
+    case AST_TYPE_SET:
+        iface_put_str(w, ast->type_set.name);
+        put_ast_array(w, ast->type_set.members, ast->type_set.member_count, depth);
+        break;
+    case AST_TESTS:
+        put_ast_array(w, ast->tests.assertions, (size_t)ast->tests.count, depth);
+        break;
+    case AST_RANGE:
+        put_ast_depth(w, ast->range.start, depth + 1);
+        put_ast_depth(w, ast->range.step, depth + 1);
+        put_ast_depth(w, ast->range.end, depth + 1);
+        put_bool(w, ast->range.is_array);
+        break;
+    case AST_LAYOUT:
+        iface_put_str(w, ast->layout.name);
+        put_int(w, ast->layout.fields ? ast->layout.field_count : 0);
+        for (int i = 0; ast->layout.fields && i < ast->layout.field_count; i++) {
+            const ASTLayoutField *f = &ast->layout.fields[i];
+            iface_put_str(w, f->name);
+            iface_put_str(w, f->type_name);
+            put_bool(w, f->is_array);
+            put_bool(w, f->is_ptr);
+            iface_put_str(w, f->array_elem);
+            put_int(w, f->array_size);
+        }
+        put_bool(w, ast->layout.packed);
+        put_int(w, ast->layout.align);
+        break;
+    case AST_PMATCH:
+        put_int(w, ast->pmatch.clauses ? ast->pmatch.clause_count : 0);
+        for (int i = 0; ast->pmatch.clauses && i < ast->pmatch.clause_count; i++) {
+            const ASTPMatchClause *c = &ast->pmatch.clauses[i];
+            put_int(w, c->patterns ? c->pattern_count : 0);
+            for (int j = 0; c->patterns && j < c->pattern_count; j++)
+                put_pattern(w, &c->patterns[j], depth + 1);
+            put_ast_depth(w, c->body, depth + 1);
+            put_int(w, c->guard_count);
+            for (int j = 0; j < c->guard_count; j++) {
+                put_ast_depth(w, c->guard_conds[j], depth + 1);
+                put_ast_depth(w, c->guard_bodies[j], depth + 1);
+            }
+        }
+        break;
+    case AST_DATA:
+        iface_put_str(w, ast->data.name);
+        put_str_array(w, ast->data.type_params, ast->data.type_param_count);
+        put_int(w, ast->data.constructors ? ast->data.constructor_count : 0);
+        for (int i = 0; ast->data.constructors && i < ast->data.constructor_count; i++) {
+            iface_put_str(w, ast->data.constructors[i].name);
+            put_str_array(w, ast->data.constructors[i].field_types,
+                          ast->data.constructors[i].field_count);
+        }
+        put_str_array(w, ast->data.deriving, ast->data.deriving_count);
+        break;
+    case AST_CLASS:
+        iface_put_str(w, ast->class_decl.name);
+        iface_put_str(w, ast->class_decl.type_var);
+        put_str_array(w, ast->class_decl.superclass_names, ast->class_decl.superclass_count);
+        put_str_array(w, ast->class_decl.superclass_type_vars, ast->class_decl.superclass_count);
+        put_str_array(w, ast->class_decl.assoc_types, ast->class_decl.assoc_count);
+        put_str_array(w, ast->class_decl.method_names, ast->class_decl.method_count);
+        put_str_array(w, ast->class_decl.method_types, ast->class_decl.method_count);
+        put_str_array(w, ast->class_decl.default_names, ast->class_decl.default_count);
+        put_ast_array(w, ast->class_decl.default_bodies,
+                      (size_t)ast->class_decl.default_count, depth);
+        put_str_array(w, ast->class_decl.law_names, ast->class_decl.law_count);
+        put_str_array(w, ast->class_decl.law_types, ast->class_decl.law_count);
+        put_ast_array(w, ast->class_decl.law_bodies,
+                      (size_t)ast->class_decl.law_count, depth);
+        break;
+    case AST_INSTANCE:
+        iface_put_str(w, ast->instance_decl.class_name);
+        iface_put_str(w, ast->instance_decl.type_name);
+        put_str_array(w, ast->instance_decl.assoc_names, ast->instance_decl.assoc_count);
+        put_str_array(w, ast->instance_decl.assoc_values, ast->instance_decl.assoc_count);
+        put_str_array(w, ast->instance_decl.method_names, ast->instance_decl.method_count);
+        put_ast_array(w, ast->instance_decl.method_bodies,
+                      (size_t)ast->instance_decl.method_count, depth);
+        break;
+    default:
+        /* TOK_LAMBDA_LIT and friends carry no owned payload; ast_clone
+         * shallow-copies them too.  Refuse rather than guess. */
+        w->ok = false;
+        break;
+    }
+}
+
+void iface_put_ast(IfaceWriter *w, const AST *ast) {
+    put_ast_depth(w, ast, 0);
+}
+
+
+/// Typeclasses, finite sets, refinements
+
+void iface_put_tc_registry(IfaceWriter *w, const TypeClassRegistry *reg) {
+    int nc = reg ? reg->class_count : 0;
+    put_int(w, nc);
+    for (int i = 0; i < nc; i++) {
+        const TCClass *c = &reg->classes[i];
+        iface_put_str(w, c->name);
+        iface_put_str(w, c->type_var);
+        put_str_array(w, c->superclass_names, c->superclass_count);
+        put_str_array(w, c->superclass_type_vars, c->superclass_count);
+        put_str_array(w, c->assoc_types, c->assoc_count);
+        put_int(w, c->method_count);
+        for (int j = 0; j < c->method_count; j++) {
+            iface_put_str(w, c->methods[j].name);
+            iface_put_str(w, c->methods[j].type_str);
+        }
+        put_str_array(w, c->default_names, c->default_count);
+        put_ast_array(w, c->default_bodies, (size_t)c->default_count, 0);
+        put_str_array(w, c->law_names, c->law_count);
+        put_str_array(w, c->law_types, c->law_count);
+        put_ast_array(w, c->law_bodies, (size_t)c->law_count, 0);
+    }
+
+    int ni = reg ? reg->instance_count : 0;
+    put_int(w, ni);
+    for (int i = 0; i < ni; i++) {
+        const TCInstance *inst = &reg->instances[i];
+        iface_put_str(w, inst->class_name);
+        iface_put_str(w, inst->type_name);
+        put_str_array(w, inst->assoc_names, inst->assoc_count);
+        put_str_array(w, inst->assoc_values, inst->assoc_count);
+        put_str_array(w, inst->method_names, inst->method_count);
+        put_str_array(w, inst->method_symbols, inst->method_count);
+    }
+}
+
+void iface_put_finite_set(IfaceWriter *w, const FiniteTypeSetEntry *e) {
+    iface_put_str(w, e->name);
+    iface_put_i64(w, (int64_t)e->member_count);
+    for (size_t i = 0; i < e->member_count; i++) {
+        const FiniteTypeMember *m = &e->members[i];
+        put_int(w, m->kind);
+        iface_put_str(w, m->spelling);
+        iface_put_f64(w, m->number);
+        iface_put_u32(w, m->character);
+    }
+}
+
+void iface_put_refinement(IfaceWriter *w, const RefinementEntry *e) {
+    iface_put_str(w, e->name);
+    iface_put_str(w, e->pred_name);
+    iface_put_str(w, e->base_type);
+    put_ast_depth(w, e->predicate_ast, 0);
+    iface_put_str(w, e->var);
+}
+
+
+/// Reader
+
+bool iface_file_open(IfaceFile *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return false; }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p != MAP_FAILED) {
+        f->data   = p;
+        f->size   = (size_t)st.st_size;
+        f->mapped = true;
+        return true;
+    }
+#endif
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+    fseek(fp, 0, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (sz <= 0) { fclose(fp); return false; }
+    unsigned char *buf = malloc((size_t)sz);
+    size_t n = buf ? fread(buf, 1, (size_t)sz, fp) : 0;
+    fclose(fp);
+    if (n != (size_t)sz) { free(buf); return false; }
+    f->data = buf;
+    f->size = n;
+    return true;
+}
+
+void iface_file_close(IfaceFile *f) {
+    if (!f->data) return;
+#if !defined(_WIN32)
+    if (f->mapped) munmap((void *)f->data, f->size);
+    else
+#endif
+    free((void *)f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+IfaceReader iface_reader(const IfaceFile *f) {
+    IfaceReader r = { f->data, f->data + f->size, f->data != NULL };
+    return r;
+}
+
+bool iface_get_bytes(IfaceReader *r, void *out, size_t len) {
+    if (!r->ok || (size_t)(r->end - r->p) < len) {
+        r->ok = false;
+        memset(out, 0, len);
+        return false;
+    }
+    memcpy(out, r->p, len);
+    r->p += len;
+    return true;
+}
+
+uint8_t iface_get_u8(IfaceReader *r) {
+    uint8_t v;
+    iface_get_bytes(r, &v, 1);
+    return v;
+}
+
+uint32_t iface_get_u32(IfaceReader *r) {
+    unsigned char b[4];
+    iface_get_bytes(r, b, 4);
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+           ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+int64_t iface_get_i64(IfaceReader *r) {
+    unsigned char b[8];
+    iface_get_bytes(r, b, 8);
+    uint64_t u = 0;
+    for (int i = 0; i < 8; i++) u |= (uint64_t)b[i] << (8 * i);
+    return (int64_t)u;
+}
+
+double iface_get_f64(IfaceReader *r) {
+    int64_t bits = iface_get_i64(r);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+char *iface_get_str(IfaceReader *r) {
+    uint32_t n = iface_get_u32(r);
+    if (!r->ok || n == 0xFFFFFFFFu) return NULL;
+    if ((size_t)(r->end - r->p) < n) { r->ok = false; return NULL; }
+    char *s = malloc((size_t)n + 1);
+    memcpy(s, r->p, n);
+    s[n] = '\0';
+    r->p += n;
+    return s;
+}
+
+static bool get_bool(IfaceReader *r) { return iface_get_u8(r) != 0; }
+static int  get_int (IfaceReader *r) { return (int)iface_get_i64(r); }
+
+// Reads an element count and rejects anything implausible for the bytes
+// that remain, so a corrupt count cannot trigger a huge allocation.
+static size_t get_count(IfaceReader *r) {
+    int64_t n = iface_get_i64(r);
+    if (!r->ok || n < 0 || n > (int64_t)IFACE_MAX_COUNT ||
+        (size_t)n > (size_t)(r->end - r->p)) {
+        if (n != 0) r->ok = false;
+        return 0;
+    }
+    return (size_t)n;
+}
+
+// Parallel arrays share one count field; a mismatch means a corrupt file.
+// Clamp so the free paths never index past the shorter array.
+static void clamp_count(IfaceReader *r, int *count, size_t other) {
+    if ((size_t)*count != other) {
+        r->ok = false;
+        if (other < (size_t)*count) *count = (int)other;
+    }
+}
+
+static char **get_str_array(IfaceReader *r, int *count) {
+    size_t n = get_count(r);
+    char **items = malloc(sizeof(char *) * (n ? n : 1));
+    for (size_t i = 0; i < n; i++) items[i] = iface_get_str(r);
+    if (count) *count = (int)n;
+    return items;
+}
+
+
+/// Types (read)
+
+static Type *get_type_depth(IfaceReader *r, int depth);
+
+static Type *new_type(TypeKind kind) {
+    Type *t = calloc(1, sizeof(Type));
+    t->kind = kind;
+    t->arr_size = -1;
+    return t;
+}
+
+static Type *get_type_depth(IfaceReader *r, int depth) {
+    if (depth > IFACE_MAX_DEPTH) { r->ok = false; return NULL; }
+    if (!get_bool(r) || !r->ok) return NULL;
+    int kind = get_int(r);
+    if (kind < 0 || kind > TYPE_FINITE_SET) { r->ok = false; return NULL; }
+    Type *t = new_type((TypeKind)kind);
+
+    switch (t->kind) {
+    case TYPE_VAR:
+        t->var_id = get_int(r);
+        break;
+    case TYPE_ARROW:
+        t->arrow_param = get_type_depth(r, depth + 1);
+        t->arrow_ret   = get_type_depth(r, depth + 1);
+        break;
+    case TYPE_FN: {
+        t->param_count = get_int(r);
+        size_t n = get_count(r);
+        if (n > 0) {
+            t->params = calloc(n, sizeof(FnParam));
+            for (size_t i = 0; i < n; i++) {
+                t->params[i].name     = iface_get_str(r);
+                t->params[i].type     = get_type_depth(r, depth + 1);
+                t->params[i].optional = get_bool(r);
+                t->params[i].rest     = get_bool(r);
+            }
+        }
+        t->return_type = get_type_depth(r, depth + 1);
+        break;
+    }
+    case TYPE_LIST: {
+        size_t n = get_count(r);
+        t->list_count = (int)n;
+        if (n > 0) {
+            t->list_types = malloc(sizeof(Type *) * n);
+            for (size_t i = 0; i < n; i++)
+                t->list_types[i] = get_type_depth(r, depth + 1);
+        }
+        t->list_elem = get_type_depth(r, depth + 1);
+        break;
+    }
+    case TYPE_PTR:
+    case TYPE_OPTIONAL:
+    case TYPE_COLL:
+        t->element_type = get_type_depth(r, depth + 1);
+        break;
+    case TYPE_ARR:
+        t->arr_element_type = get_type_depth(r, depth + 1);
+        t->arr_size         = iface_get_i64(r);
+        t->arr_is_fat       = get_bool(r);
+        t->arr_is_heap      = get_bool(r);
+        break;
+    case TYPE_MAP:
+        t->map_key_type   = get_type_depth(r, depth + 1);
+        t->map_value_type = get_type_depth(r, depth + 1);
+        break;
+    case TYPE_LAYOUT: {
+        t->layout_name = iface_get_str(r);
+        size_t n = get_count(r);
+        t->layout_field_count = (int)n;
+        if (n > 0) {
+            /* Like the registry's copy, these fields are shared by every
+             * clone of the layout and live for the rest of the process. */
+            t->layout_fields = calloc(n, sizeof(LayoutField));
+            for (size_t i = 0; i < n; i++) {
+                t->layout_fields[i].name   = iface_get_str(r);
+                t->layout_fields[i].type   = get_type_depth(r, depth + 1);
+                t->layout_fields[i].offset = get_int(r);
+                t->layout_fields[i].size   = get_int(r);
+            }
+        }
+        t->layout_total_size = get_int(r);
+        t->layout_packed     = get_bool(r);
+        t->layout_align      = get_int(r);
+        t->layout_is_scalar  = get_bool(r);
+        t->layout_is_inline  = get_bool(r);
+        break;
+    }
+    case TYPE_INT_ARBITRARY:
+        t->numeric_width  = get_int(r);
+        t->numeric_signed = get_bool(r);
+        break;
+    case TYPE_APP:
+        t->app_constructor = iface_get_str(r);
+        t->app_arg         = get_type_depth(r, depth + 1);
+        break;
+    case TYPE_FINITE_SET:
+        t->finite_name         = iface_get_str(r);
+        t->finite_member_count = (size_t)iface_get_i64(r);
+        break;
+    default:
+        break;
+    }
+    return t;
+}
+
+Type *iface_get_type(IfaceReader *r) {
+    return get_type_depth(r, 0);
+}
+
+
+/// AST (read)
+
+static AST *get_ast_depth(IfaceReader *r, int depth);
+
+static AST **get_ast_array(IfaceReader *r, size_t *count, int depth) {
+    size_t n = get_count(r);
+    AST **items = malloc(sizeof(AST *) * (n ? n : 1));
+    for (size_t i = 0; i < n; i++) items[i] = get_ast_depth(r, depth + 1);
+    *count = n;
+    return items;
+}
+
+static ASTPattern get_pattern(IfaceReader *r, int depth) {
+    ASTPattern p;
+    memset(&p, 0, sizeof(p));
+    if (depth > IFACE_MAX_DEPTH) { r->ok = false; return p; }
+    p.kind      = (PatternKind)get_int(r);
+    p.var_name  = iface_get_str(r);
+    p.lit_value = iface_get_f64(r);
+    p.range_end = iface_get_f64(r);
+    size_t n = get_count(r);
+    p.element_count = (int)n;
+    if (n > 0) {
+        p.elements = malloc(sizeof(ASTPattern) * n);
+        for (size_t i = 0; i < n; i++) p.elements[i] = get_pattern(r, depth + 1);
+    }
+    if (get_bool(r)) {
+        p.tail = malloc(sizeof(ASTPattern));
+        *p.tail = get_pattern(r, depth + 1);
+    }
+    n = get_count(r);
+    p.ctor_field_count = (int)n;
+    if (n > 0) {
+        p.ctor_fields = malloc(sizeof(ASTPattern) * n);
+        for (size_t i = 0; i < n; i++) p.ctor_fields[i] = get_pattern(r, depth + 1);
+    }
+    return p;
+}
+
+static AST *get_ast_depth(IfaceReader *r, int depth) {
+    if (depth > IFACE_MAX_DEPTH) { r->ok = false; return NULL; }
+    if (!get_bool(r) || !r->ok) return NULL;
+    AST *a = ast_node_alloc();
+    a->type          = (ASTType)get_int(r);
+    a->line          = get_int(r);
+    a->column        = get_int(r);
+    a->end_column    = get_int(r);
+    a->literal_str   = iface_get_str(r);
+    a->has_raw_int   = get_bool(r);
+    a->raw_int       = (uint64_t)iface_get_i64(r);
+    a->inferred_type = get_type_depth(r, depth + 1);
+
+    size_t n;
+    switch (a->type) {
+    case AST_NUMBER:
+        a->number = iface_get_f64(r);
+        break;
+    case AST_CHAR:
+        a->character = (char)iface_get_u8(r);
+        break;
+    case AST_SYMBOL:
+        a->symbol = iface_get_str(r);
+        break;
+    case AST_STRING:
+    case AST_PATH:
+        a->string = iface_get_str(r);
+        break;
+    case AST_KEYWORD:
+        a->keyword = iface_get_str(r);
+        break;
+    case AST_RATIO:
+        a->ratio.numerator   = iface_get_i64(r);
+        a->ratio.denominator = iface_get_i64(r);
+        break;
+    case AST_LIST:
+    case AST_ADDRESS_OF:
+        a->list.items    = get_ast_array(r, &n, depth);
+        a->list.count    = n;
+        a->list.capacity = n ? n : 1;
+        break;
+    case AST_ARRAY:
+        a->array.elements         = get_ast_array(r, &n, depth);
+        a->array.element_count    = n;
+        a->array.element_capacity = n ? n : 1;
+        a->array.is_heap          = get_bool(r);
+        break;
+    case AST_SET:
+        a->set.elements         = get_ast_array(r, &n, depth);
+        a->set.element_count    = n;
+        a->set.element_capacity = n ? n : 1;
+        break;
+    case AST_MAP: {
+        size_t nv;
+        a->map.keys = get_ast_array(r, &n, depth);
+        a->map.vals = get_ast_array(r, &nv, depth);
+        if (nv != n) r->ok = false;
+        a->map.count    = n < nv ? n : nv;
+        a->map.capacity = n ? n : 1;
+        break;
+    }
+    case AST_LAMBDA: {
+        n = get_count(r);
+        a->lambda.param_count = (int)n;
+        a->lambda.params = malloc(sizeof(ASTParam) * (n ? n : 1));
+        for (size_t i = 0; i < n; i++) {
+            a->lambda.params[i].name      = iface_get_str(r);
+            a->lambda.params[i].type_name = iface_get_str(r);
+            a->lambda.params[i].is_rest   = get_bool(r);
+            a->lambda.params[i].is_anon   = get_bool(r);
+        }
+        a->lambda.return_type = iface_get_str(r);
+        a->lambda.docstring   = iface_get_str(r);
+        a->lambda.alias_name  = iface_get_str(r);
+        a->lambda.naked       = get_bool(r);
+        a->lambda.body_exprs  = get_ast_array(r, &n, depth);
+        a->lambda.body_count  = (int)n;
+        a->lambda.body = n > 0 ? a->lambda.body_exprs[n - 1]
+                               : get_ast_depth(r, depth + 1);
+        a->lambda.pattern_match = get_ast_depth(r, depth + 1);
+        break;
+    }
+    case AST_ASM:
+        a->asm_block.instructions      = get_ast_array(r, &n, depth);
+        a->asm_block.instruction_count = n;
+        break;
+    case AST_REFINEMENT:
+        a->refinement.name       = iface_get_str(r);
+        a->refinement.var        = iface_get_str(r);
+        a->refinement.base_type  = iface_get_str(r);
+        a->refinement.predicate  = get_ast_depth(r, depth + 1);
+        a->refinement.docstring  = iface_get_str(r);
+        a->refinement.alias_name = iface_get_str(r);
+        break;
+    case AST_TYPE_SET:
+        a->type_set.name         = iface_get_str(r);
+        a->type_set.members      = get_ast_array(r, &n, depth);
+        a->type_set.member_count = n;
+        break;
+    case AST_TESTS:
+        a->tests.assertions = get_ast_array(r, &n, depth);
+        a->tests.count      = (int)n;
+        break;
+    case AST_RANGE:
+        a->range.start    = get_ast_depth(r, depth + 1);
+        a->range.step     = get_ast_depth(r, depth + 1);
+        a->range.end      = get_ast_depth(r, depth + 1);
+        a->range.is_array = get_bool(r);
+        break;
+    case AST_LAYOUT:
+        a->layout.name = iface_get_str(r);
+        n = get_count(r);
+        a->layout.field_count = (int)n;
+        a->layout.fields = calloc(n ? n : 1, sizeof(ASTLayoutField));
+        for (size_t i = 0; i < n; i++) {
+            ASTLayoutField *f = &a->layout.fields[i];
+            f->name       = iface_get_str(r);
+            f->type_name  = iface_get_str(r);
+            f->is_array   = get_bool(r);
+            f->is_ptr     = get_bool(r);
+            f->array_elem = iface_get_str(r);
+            f->array_size = get_int(r);
+        }
+        a->layout.packed = get_bool(r);
+        a->layout.align  = get_int(r);
+        break;
+    case AST_PMATCH:
+        n = get_count(r);
+        a->pmatch.clause_count = (int)n;
+        a->pmatch.clauses = calloc(n ? n : 1, sizeof(ASTPMatchClause));
+        for (size_t i = 0; i < n; i++) {
+            ASTPMatchClause *c = &a->pmatch.clauses[i];
+            size_t np = get_count(r);
+            c->pattern_count = (int)np;
+            c->patterns = malloc(sizeof(ASTPattern) * (np ? np : 1));
+            for (size_t j = 0; j < np; j++) c->patterns[j] = get_pattern(r, depth + 1);
+            c->body = get_ast_depth(r, depth + 1);
+            size_t ng = get_count(r);
+            c->guard_count  = (int)ng;
+            c->guard_conds  = malloc(sizeof(AST *) * (ng ? ng : 1));
+            c->guard_bodies = malloc(sizeof(AST *) * (ng ? ng : 1));
+            for (size_t j = 0; j < ng; j++) {
+                c->guard_conds[j]  = get_ast_depth(r, depth + 1);
+                c->guard_bodies[j] = get_ast_depth(r, depth + 1);
+            }
+        }
+        break;
+    case AST_DATA:
+        a->data.name        = iface_get_str(r);
+        a->data.type_params = get_str_array(r, &a->data.type_param_count);
+        n = get_count(r);
+        a->data.constructor_count = (int)n;
+        a->data.constructors = calloc(n ? n : 1, sizeof(ASTDataConstructor));
+        for (size_t i = 0; i < n; i++) {
+            a->data.constructors[i].name = iface_get_str(r);
+            a->data.constructors[i].field_types =
+                get_str_array(r, &a->data.constructors[i].field_count);
+        }
+        a->data.deriving = get_str_array(r, &a->data.deriving_count);
+        break;
+    case AST_CLASS: {
+        int cnt;
+        a->class_decl.name     = iface_get_str(r);
+        a->class_decl.type_var = iface_get_str(r);
+        a->class_decl.superclass_names     = get_str_array(r, &a->class_decl.superclass_count);
+        a->class_decl.superclass_type_vars = get_str_array(r, &cnt);
+        clamp_count(r, &a->class_decl.superclass_count, (size_t)cnt);
+        a->class_decl.assoc_types  = get_str_array(r, &a->class_decl.assoc_count);
+        a->class_decl.method_names = get_str_array(r, &a->class_decl.method_count);
+        a->class_decl.method_types = get_str_array(r, &cnt);
+        clamp_count(r, &a->class_decl.method_count, (size_t)cnt);
+        a->class_decl.default_names  = get_str_array(r, &a->class_decl.default_count);
+        a->class_decl.default_bodies = get_ast_array(r, &n, depth);
+        clamp_count(r, &a->class_decl.default_count, n);
+        a->class_decl.law_names  = get_str_array(r, &a->class_decl.law_count);
+        a->class_decl.law_types  = get_str_array(r, &cnt);
+        clamp_count(r, &a->class_decl.law_count, (size_t)cnt);
+        a->class_decl.law_bodies = get_ast_array(r, &n, depth);
+        clamp_count(r, &a->class_decl.law_count, n);
+        break;
+    }
+    case AST_INSTANCE: {
+        int cnt;
+        a->instance_decl.class_name    = iface_get_str(r);
+        a->instance_decl.type_name     = iface_get_str(r);
+        a->instance_decl.assoc_names   = get_str_array(r, &a->instance_decl.assoc_count);
+        a->instance_decl.assoc_values  = get_str_array(r, &cnt);
+        clamp_count(r, &a->instance_decl.assoc_count, (size_t)cnt);
+        a->instance_decl.method_names  = get_str_array(r, &a->instance_decl.method_count);
+        a->instance_decl.method_bodies = get_ast_array(r, &n, depth);
+        clamp_count(r, &a->instance_decl.method_count, n);
+        break;
+    }
+    default:
+        r->ok = false;
+        break;
+    }
+    return a;
+}
+
+AST *iface_get_ast(IfaceReader *r) {
+    return get_ast_depth(r, 0);
+}
+
+
+/// Typeclasses, finite sets, refinements (read)
+
+void iface_get_tc_registry(IfaceReader *r, TypeClassRegistry *dst) {
+    TypeClassRegistry *tmp = tc_registry_create();
+    size_t n;
+
+    size_t nc = get_count(r);
+    free(tmp->classes);
+    tmp->classes   = calloc(nc ? nc : 1, sizeof(TCClass));
+    tmp->class_cap = (int)(nc ? nc : 1);
+    for (size_t i = 0; i < nc && r->ok; i++) {
+        TCClass *c = &tmp->classes[tmp->class_count++];
+        int cnt;
+        c->name     = iface_get_str(r);
+        c->type_var = iface_get_str(r);
+        c->superclass_names     = get_str_array(r, &c->superclass_count);
+        c->superclass_type_vars = get_str_array(r, &cnt);
+        clamp_count(r, &c->superclass_count, (size_t)cnt);
+        c->assoc_types = get_str_array(r, &c->assoc_count);
+        size_t nm = get_count(r);
+        c->method_count = (int)nm;
+        c->methods = calloc(nm ? nm : 1, sizeof(TCMethod));
+        for (size_t j = 0; j < nm; j++) {
+            c->methods[j].name     = iface_get_str(r);
+            c->methods[j].type_str = iface_get_str(r);
+        }
+        c->default_names  = get_str_array(r, &c->default_count);
+        c->default_bodies = get_ast_array(r, &n, 0);
+        clamp_count(r, &c->default_count, n);
+        c->law_names  = get_str_array(r, &c->law_count);
+        c->law_types  = get_str_array(r, &cnt);
+        clamp_count(r, &c->law_count, (size_t)cnt);
+        c->law_bodies = get_ast_array(r, &n, 0);
+        clamp_count(r, &c->law_count, n);
+    }
+
+    size_t ni = r->ok ? get_count(r) : 0;
+    free(tmp->instances);
+    tmp->instances    = calloc(ni ? ni : 1, sizeof(TCInstance));
+    tmp->instance_cap = (int)(ni ? ni : 1);
+    for (size_t i = 0; i < ni && r->ok; i++) {
+        TCInstance *inst = &tmp->instances[tmp->instance_count++];
+        int cnt;
+        inst->class_name   = iface_get_str(r);
+        inst->type_name    = iface_get_str(r);
+        inst->assoc_names  = get_str_array(r, &inst->assoc_count);
+        inst->assoc_values = get_str_array(r, &cnt);
+        clamp_count(r, &inst->assoc_count, (size_t)cnt);
+        inst->method_names = get_str_array(r, &inst->method_count);
+        inst->method_symbols = get_str_array(r, &cnt);
+        clamp_count(r, &inst->method_count, (size_t)cnt);
+        inst->method_funcs = calloc(inst->method_count ? inst->method_count : 1,
+                                    sizeof(LLVMValueRef));
+    }
+
+    if (r->ok) tc_registry_merge(dst, tmp);
+    tc_registry_free(tmp);
+}
+
+bool iface_get_finite_set(IfaceReader *r) {
+    char *name = iface_get_str(r);
+    size_t n = get_count(r);
+    FiniteTypeMember *members = calloc(n ? n : 1, sizeof(*members));
+    for (size_t i = 0; i < n; i++) {
+        members[i].kind      = (FiniteMemberKind)get_int(r);
+        members[i].spelling  = iface_get_str(r);
+        members[i].number    = iface_get_f64(r);
+        members[i].character = iface_get_u32(r);
+    }
+    bool ok = r->ok && name && finite_type_set_register_members(name, members, n);
+    for (size_t i = 0; i < n; i++) free(members[i].spelling);
+    free(members);
+    free(name);
+    return ok;
+}
+
+bool iface_get_refinement(IfaceReader *r) {
+    char *name = iface_get_str(r);
+    char *pred = iface_get_str(r);
+    char *base = iface_get_str(r);
+    AST  *ast  = get_ast_depth(r, 0);
+    char *var  = iface_get_str(r);
+    bool ok = r->ok && name && pred && base;
+    if (ok) refinement_register(name, pred, base, ast, var);
+    ast_free(ast);
+    free(name); free(pred); free(base); free(var);
+    return ok;
+}
@@ -0,0 +1,104 @@
+#ifndef IFACE_H
+#define IFACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "reader.h"
+#include "types.h"
+#include "typeclass.h"
+
+///  Module interface serialization
+//
+//  A small binary encoding for the compile-time facts one module exports
+//  to its importers: types, AST fragments (inlinable bodies, class default
+//  methods), typeclass registries and finite type sets.  main.c builds its
+//  interface files (the prelude bundle and per-module .moni files) out of
+//  these primitives; nothing here knows about CompiledModule.
+//
+//  The encoding is little-endian, length-prefixed and versioned by the
+//  caller.  Readers never trust the input: every get checks bounds and a
+//  failed read latches `ok = false` and returns zero/NULL from then on, so
+//  callers can decode a whole record and check `ok` once at the end.
+//
+//    IfaceWriter w;
+//    iface_writer_init(&w);
+//    iface_put_str(&w, "Data.Maybe");
+//    iface_put_type(&w, t);
+//    iface_writer_save(&w, path);        // atomic: tmp file + rename
+//    iface_writer_free(&w);
+//
+//    IfaceFile f;
+//    if (iface_file_open(&f, path)) {    // mmap where available
+//        IfaceReader r = iface_reader(&f);
+//        char *name = iface_get_str(&r);
+//        Type *t    = iface_get_type(&r);
+//        if (!r.ok) ...                  // truncated / corrupt
+//        iface_file_close(&f);
+//    }
+
+typedef struct {
+    unsigned char *buf;
+    size_t         len;
+    size_t         cap;
+    bool           ok;     // false once a value could not be encoded
+} IfaceWriter;
+
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+    bool                 ok;
+} IfaceReader;
+
+typedef struct {
+    const unsigned char *data;
+    size_t               size;
+    bool                 mapped;  // data came from mmap, not malloc
+} IfaceFile;
+
+/// Writer
+
+void iface_writer_init(IfaceWriter *w);
+void iface_writer_free(IfaceWriter *w);
+bool iface_writer_save(const IfaceWriter *w, const char *path);
+
+void iface_put_bytes(IfaceWriter *w, const void *data, size_t len);
+void iface_put_u8  (IfaceWriter *w, uint8_t v);
+void iface_put_u32 (IfaceWriter *w, uint32_t v);
+void iface_put_i64 (IfaceWriter *w, int64_t v);
+void iface_put_f64 (IfaceWriter *w, double v);
+void iface_put_str (IfaceWriter *w, const char *s);   // NULL-preserving
+
+void iface_put_type       (IfaceWriter *w, const Type *t);
+void iface_put_ast        (IfaceWriter *w, const AST *ast);
+void iface_put_tc_registry(IfaceWriter *w, const TypeClassRegistry *reg);
+void iface_put_finite_set (IfaceWriter *w, const FiniteTypeSetEntry *e);
+void iface_put_refinement (IfaceWriter *w, const RefinementEntry *e);
+
+/// Reader
+
+bool        iface_file_open (IfaceFile *f, const char *path);
+void        iface_file_close(IfaceFile *f);
+IfaceReader iface_reader    (const IfaceFile *f);
+
+bool     iface_get_bytes(IfaceReader *r, void *out, size_t len);
+uint8_t  iface_get_u8  (IfaceReader *r);
+uint32_t iface_get_u32 (IfaceReader *r);
+int64_t  iface_get_i64 (IfaceReader *r);
+double   iface_get_f64 (IfaceReader *r);
+char    *iface_get_str (IfaceReader *r);               // malloc'd or NULL
+
+Type *iface_get_type(IfaceReader *r);
+AST  *iface_get_ast (IfaceReader *r);
+
+// Decodes a registry written by iface_put_tc_registry and merges it into
+// `dst`.  Instances come back with method_symbols but no LLVM values, the
+// same shape tc_registry_clone leaves behind once a module is disposed.
+void iface_get_tc_registry(IfaceReader *r, TypeClassRegistry *dst);
+
+// Decode one entry and register it in the process-wide tables.
+bool iface_get_finite_set(IfaceReader *r);
+bool iface_get_refinement(IfaceReader *r);
+
+#endif
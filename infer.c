@@ -6,6 +6,7 @@
 #include "types.h"
 #include "reader.h"
 #include "dep.h"
+#include "intern.h"
 
 extern int g_trace_depth;
 extern bool g_trace_enabled;
@@ -147,18 +148,12 @@ static Type *infer_normalize_annotation_type(Type *t) {
 
 /// InferEnv
 
-#define INFER_ENV_BUCKETS 64
-
-static size_t infer_env_hash(const char *name) {
-    size_t h = 5381;
-    for (; *name; name++) h = h * 33 ^ (unsigned char)*name;
-    return h % INFER_ENV_BUCKETS;
-}
+#define INFER_ENV_INITIAL 16   // power of two
 
 InferEnv *infer_env_create(void) {
     InferEnv *e  = calloc(1, sizeof(InferEnv));
-    e->buckets   = calloc(INFER_ENV_BUCKETS, sizeof(InferEnvEntry *));
-    e->size      = INFER_ENV_BUCKETS;
+    e->slots     = calloc(INFER_ENV_INITIAL, sizeof(InferEnvEntry));
+    e->size      = INFER_ENV_INITIAL;
     e->parent    = NULL;
     return e;
 }
@@ -171,48 +166,65 @@ InferEnv *infer_env_create_child(InferEnv *parent) {
 
 void infer_env_free(InferEnv *env) {
     if (!env) return;
-    for (size_t i = 0; i < env->size; i++) {
-        InferEnvEntry *e = env->buckets[i];
-        while (e) {
-            InferEnvEntry *next = e->next;
-            free(e->name);
-            /* schemes are owned by the context — do not free here */
-            free(e);
-            e = next;
-        }
-    }
-    free(env->buckets);
+    /* schemes are owned by the context — do not free here */
+    free(env->slots);
     free(env);
 }
 
+// Slot holding `key`, or the empty slot that ends its probe run.
+static InferEnvEntry *infer_env_probe(InferEnv *env, const char *key) {
+    size_t mask = env->size - 1;
+    size_t i    = intern_hash(key) & mask;
+    while (env->slots[i].name && env->slots[i].name != key)
+        i = (i + 1) & mask;
+    return &env->slots[i];
+}
+
+static void infer_env_grow(InferEnv *env) {
+    size_t         size  = env->size * 2;
+    InferEnvEntry *slots = calloc(size, sizeof(InferEnvEntry));
+    for (size_t i = 0; i < env->size; i++) {
+        if (!env->slots[i].name) continue;
+        size_t j = intern_hash(env->slots[i].name) & (size - 1);
+        while (slots[j].name) j = (j + 1) & (size - 1);
+        slots[j] = env->slots[i];
+    }
+    free(env->slots);
+    env->slots = slots;
+    env->size  = size;
+}
+
 void infer_env_insert(InferEnv *env, const char *name, TypeScheme *scheme) {
-    size_t         idx = infer_env_hash(name);
+    const char    *key = intern(name);
+    InferEnvEntry *e   = infer_env_probe(env, key);
     /* Overwrite existing entry for this name if present */
-    for (InferEnvEntry *e = env->buckets[idx]; e; e = e->next) {
-        if (strcmp(e->name, name) == 0) {
-            e->scheme = scheme;   /* old scheme freed by caller or ctx   */
-            return;
-        }
+    if (e->name) {
+        e->scheme = scheme;   /* old scheme freed by caller or ctx   */
+        return;
     }
-    /* Not found — prepend new entry */
-    InferEnvEntry *e = calloc(1, sizeof(InferEnvEntry));
-    e->name          = strdup(name);
-    e->scheme        = scheme;
-    e->next          = env->buckets[idx];
-    env->buckets[idx] = e;
+    if ((env->count + 1) * 10 > env->size * 7) {
+        infer_env_grow(env);
+        e = infer_env_probe(env, key);
+    }
+    e->name   = key;
+    e->scheme = scheme;
+    env->count++;
+}
+
+TypeScheme *infer_env_find(InferEnv *env, const char *name) {
+    const char *key = name ? intern_find(name) : NULL;
+    for (InferEnv *cur = key ? env : NULL; cur; cur = cur->parent) {
+        InferEnvEntry *e = infer_env_probe(cur, key);
+        if (e->name) return e->scheme;
+    }
+    return NULL;
 }
 
 TypeScheme *infer_env_lookup(InferCtx *ctx, const char *name) {
     if (!ctx || !name) return NULL;
     // 1. Check local HM environment (for lambda params, local lets)
-    for (InferEnv *cur = ctx->env; cur; cur = cur->parent) {
-        size_t idx = infer_env_hash(name);
-        InferEnvEntry *e = cur->buckets[idx];
-        while (e) {
-            if (strcmp(e->name, name) == 0) return e->scheme;
-            e = e->next;
-        }
-    }
+    TypeScheme *sc = infer_env_find(ctx->env, name);
+    if (sc) return sc;
     // 2. Fallback to TT Global Environment (The Idris Bridge)
     // DISABLED: The LLVM Codegen phase occasionally passes a stale/freed dctx pointer,
     // leading to severe Use-After-Free segfaults.
@@ -230,9 +242,15 @@ Substitution *subst_create(void) {
     s->capacity     = INFER_MAX_VARS;
     s->union_find   = malloc(sizeof(int)   * INFER_MAX_VARS);
     s->bound        = calloc(INFER_MAX_VARS, sizeof(Type *));
+    s->level        = malloc(sizeof(int)   * INFER_MAX_VARS);
+    s->mark         = calloc(INFER_MAX_VARS, sizeof(int));
+    s->mark_epoch   = 0;
+    s->current_level = 1;
     s->next_id      = 0;
-    for (int i = 0; i < INFER_MAX_VARS; i++)
+    for (int i = 0; i < INFER_MAX_VARS; i++) {
         s->union_find[i] = i;          /* each var is its own root         */
+        s->level[i]      = INFER_GENERIC_LEVEL;
+    }
     return s;
 }
 
@@ -240,6 +258,8 @@ void subst_free(Substitution *s) {
     if (!s) return;
     free(s->union_find);
     free(s->bound);
+    free(s->level);
+    free(s->mark);
     free(s);
 }
 
@@ -251,6 +271,7 @@ int subst_fresh(Substitution *s) {
     int id            = s->next_id++;
     s->union_find[id] = id;
     s->bound[id]      = NULL;
+    s->level[id]      = s->current_level;
     return id;
 }
 
@@ -263,6 +284,49 @@ int subst_find(Substitution *s, int id) {
     return id;
 }
 
+/* Lower every free variable reachable from t to at most `level`: they
+ * are now reachable from a variable of that level.  Same cycle guard as
+ * subst_apply_depth. */
+static void subst_lower_levels(Substitution *s, Type *t, int level, int depth) {
+    if (!t || depth > 64) return;
+    t = subst_apply_shallow(s, t);
+    if (!t) return;
+
+    switch (t->kind) {
+    case TYPE_VAR: {
+        int root = subst_find(s, t->var_id);
+        if (s->level[root] > level)
+            s->level[root] = level;
+        break;
+    }
+    case TYPE_LIST:
+        for (int i = 0; i < t->list_count; i++)
+            subst_lower_levels(s, t->list_types[i], level, depth + 1);
+        break;
+    case TYPE_OPTIONAL:
+    case TYPE_PTR:
+    case TYPE_COLL:
+        subst_lower_levels(s, t->element_type, level, depth + 1);
+        break;
+    case TYPE_ARR:
+        subst_lower_levels(s, t->arr_element_type, level, depth + 1);
+        break;
+    case TYPE_APP:
+        subst_lower_levels(s, t->app_arg, level, depth + 1);
+        break;
+    case TYPE_MAP:
+        subst_lower_levels(s, t->map_key_type, level, depth + 1);
+        subst_lower_levels(s, t->map_value_type, level, depth + 1);
+        break;
+    case TYPE_ARROW:
+        subst_lower_levels(s, t->arrow_param, level, depth + 1);
+        subst_lower_levels(s, t->arrow_ret,   level, depth + 1);
+        break;
+    default:
+        break;
+    }
+}
+
 void subst_bind(Substitution *s, int id, Type *t) {
     int root = subst_find(s, id);
     /* Never overwrite an existing concrete binding — doing so loses
@@ -270,6 +334,7 @@ void subst_bind(Substitution *s, int id, Type *t) {
      * subst_apply_depth chases var -> type -> var -> type forever. */
     if (s->bound[root]) return;
     s->bound[root] = t;
+    subst_lower_levels(s, t, s->level[root], 0);
 }
 
 bool subst_union(Substitution *s, int a, int b) {
@@ -283,6 +348,7 @@ bool subst_union(Substitution *s, int a, int b) {
     if (s->bound[ra] && s->bound[rb]) return true;
     /* merge rb into ra */
     s->union_find[rb] = ra;
+    if (s->level[rb] < s->level[ra]) s->level[ra] = s->level[rb];
     /* if rb had a concrete binding, carry it to ra */
     if (!s->bound[ra] && s->bound[rb])
         s->bound[ra] = s->bound[rb];
@@ -302,25 +368,35 @@ Type *subst_apply_shallow(Substitution *s, Type *t) {
 static Type *subst_apply_depth(Substitution *s, Type *t, int depth) {
     if (!t) return NULL;
     if (depth > 64) return t;  /* cycle guard: stop recursion */
-    t = subst_apply_shallow(s, t);
-    if (!t) return NULL;
 
-    switch (t->kind) {
-    case TYPE_VAR:
-        return t;   /* unresolved free variable — leave as-is */
+    if (t->kind == TYPE_VAR) {
+        int   root  = subst_find(s, t->var_id);
+        Type *bound = s->bound[root];
+        if (!bound) {
+            t->var_id = root;
+            return t;   /* unresolved free variable — leave as-is */
+        }
+        /* Keep the resolved binding so the next apply of any variable in
+         * this class returns it without rebuilding.  It denotes the same
+         * type, so levels and later unifications are unaffected. */
+        Type *resolved = subst_apply_depth(s, bound, depth + 1);
+        if (resolved && resolved != bound) s->bound[root] = resolved;
+        return resolved;
+    }
 
+    switch (t->kind) {
     case TYPE_LIST: {
         if (t->list_count == 0) return t;
-        bool changed = false;
-        Type **new_types = malloc(t->list_count * sizeof(Type*));
+        Type **new_types = NULL;
         for (int i = 0; i < t->list_count; i++) {
-            new_types[i] = subst_apply_depth(s, t->list_types[i], depth + 1);
-            if (new_types[i] != t->list_types[i]) changed = true;
-        }
-        if (!changed) {
-            free(new_types);
-            return t;
+            Type *item = subst_apply_depth(s, t->list_types[i], depth + 1);
+            if (!new_types && item != t->list_types[i]) {
+                new_types = malloc(t->list_count * sizeof(Type*));
+                memcpy(new_types, t->list_types, i * sizeof(Type*));
+            }
+            if (new_types) new_types[i] = item;
         }
+        if (!new_types) return t;
         Type *ret = type_list(new_types, t->list_count);
         free(new_types);
         return ret;
@@ -908,8 +984,9 @@ static bool int_array_contains(int *arr, int count, int v) {
     return false;
 }
 
-void infer_free_vars_type(Substitution *s, Type *t, int *out, int *count, int cap) {
-    if (!t) return;
+/* Roots already collected carry the walk's stamp in s->mark, so the
+ * set stays O(1) per variable however many the type holds. */
+static void infer_free_vars_walk(Substitution *s, Type *t, int *out, int *count, int cap) {
     if (!t || (uintptr_t)t < 0x1000) return;
     t = subst_apply_shallow(s, t);
     if (!t) return;
@@ -917,99 +994,83 @@ void infer_free_vars_type(Substitution *s, Type *t, int *out, int *count, int ca
     switch (t->kind) {
     case TYPE_VAR: {
         int root = subst_find(s, t->var_id);
-        if (!int_array_contains(out, *count, root) && *count < cap)
+        if (s->mark[root] != s->mark_epoch && *count < cap) {
+            s->mark[root] = s->mark_epoch;
             out[(*count)++] = root;
+        }
         break;
     }
     case TYPE_LIST:
         for (int i = 0; i < t->list_count; i++) {
-            infer_free_vars_type(s, t->list_types[i], out, count, cap);
+            infer_free_vars_walk(s, t->list_types[i], out, count, cap);
         }
         break;
     case TYPE_OPTIONAL:
     case TYPE_PTR:
     case TYPE_COLL:
-        infer_free_vars_type(s, t->element_type, out, count, cap);
+        infer_free_vars_walk(s, t->element_type, out, count, cap);
         break;
     case TYPE_ARR:
-        infer_free_vars_type(s, t->arr_element_type, out, count, cap);
+        infer_free_vars_walk(s, t->arr_element_type, out, count, cap);
         break;
     case TYPE_APP:
-        infer_free_vars_type(s, t->app_arg, out, count, cap);
+        infer_free_vars_walk(s, t->app_arg, out, count, cap);
         break;
     case TYPE_MAP:
-        infer_free_vars_type(s, t->map_key_type, out, count, cap);
-        infer_free_vars_type(s, t->map_value_type, out, count, cap);
+        infer_free_vars_walk(s, t->map_key_type, out, count, cap);
+        infer_free_vars_walk(s, t->map_value_type, out, count, cap);
         break;
     case TYPE_ARROW:
-        infer_free_vars_type(s, t->arrow_param, out, count, cap);
-        infer_free_vars_type(s, t->arrow_ret,   out, count, cap);
+        infer_free_vars_walk(s, t->arrow_param, out, count, cap);
+        infer_free_vars_walk(s, t->arrow_ret,   out, count, cap);
         break;
     default:
         break;
     }
 }
 
-void infer_free_vars_env(InferCtx *ctx, InferEnv *env, int *out, int *count, int cap) {
-    if (!env) return;
-    /* Only walk the single env level passed — do NOT follow parent chain.
-     * Parent envs contain schemes from previous InferCtx runs whose type
-     * var IDs belong to foreign substitutions and cannot be safely
-     * dereferenced with the current ctx->subst.
-     * This is safe because:
-     * - Built-in schemes are fully generalised (quantified_count > 0)
-     * - Previously defined schemes are fully generalised
-     * - Only the current definition's child scope has monomorphic
-     *   pre-bind schemes that matter for generalisation                */
-    for (size_t i = 0; i < env->size; i++) {
-        for (InferEnvEntry *e = env->buckets[i]; e; e = e->next) {
-            TypeScheme *sc = e->scheme;
-            /* Guard against NULL or corrupt pointers from stale entries */
-            if (!sc || (uintptr_t)sc < 0x1000) continue;
-            if (!sc->type || (uintptr_t)sc->type < 0x1000) continue;
-            /* Skip fully generalised schemes — their type vars belong to
-             * outer or previous substitutions and must not be examined   */
-            if (sc->quantified_count > 0) continue;
-            /* Only consider type vars within the current substitution range */
-            int body_free[INFER_MAX_VARS];
-            int body_count = 0;
-            infer_free_vars_type(ctx->subst, sc->type,
-                                 body_free, &body_count, INFER_MAX_VARS);
-            for (int j = 0; j < body_count; j++) {
-                if (body_free[j] < ctx->subst->next_id &&
-                    !int_array_contains(out, *count, body_free[j]) &&
-                    *count < cap) {
-                    out[(*count)++] = body_free[j];
-                }
-            }
-        }
-    }
+void infer_free_vars_type(Substitution *s, Type *t, int *out, int *count, int cap) {
+    if (++s->mark_epoch == 0) {
+        memset(s->mark, 0, sizeof(int) * s->capacity);
+        s->mark_epoch = 1;
+    }
+    /* Roots already in `out` stay unique across calls. */
+    for (int i = 0; i < *count; i++)
+        s->mark[subst_find(s, out[i])] = s->mark_epoch;
+    infer_free_vars_walk(s, t, out, count, cap);
 }
 
 /// Generalisation and Instantiation
 
+void infer_enter_level(InferCtx *ctx) {
+    ctx->subst->current_level++;
+}
+
+void infer_leave_level(InferCtx *ctx) {
+    ctx->subst->current_level--;
+}
+
 TypeScheme *infer_generalise(InferCtx *ctx, Type *t, InferEnv *outer_env) {
+    (void)outer_env;
+    Substitution *s = ctx->subst;
+
     /* Apply substitution fully first */
-    t = subst_apply(ctx->subst, t);
+    t = subst_apply(s, t);
 
     /* Collect free vars in t */
     int type_free[INFER_MAX_VARS];
     int type_free_count = 0;
-    infer_free_vars_type(ctx->subst, t, type_free, &type_free_count, INFER_MAX_VARS);
-
-    /* Collect free vars in the outer environment */
-    int env_free[INFER_MAX_VARS];
-    int env_free_count = 0;
-    infer_free_vars_env(ctx, outer_env, env_free, &env_free_count, INFER_MAX_VARS);
+    infer_free_vars_type(s, t, type_free, &type_free_count, INFER_MAX_VARS);
 
-    /* Quantify vars that are free in t but not free in the environment */
+    /* Quantify vars no enclosing binding can reach: their level was never
+     * lowered below the one this right-hand side was inferred at. */
     TypeScheme *sc       = calloc(1, sizeof(TypeScheme));
     sc->quantified       = malloc(sizeof(int) * type_free_count);
     sc->quantified_count = 0;
     sc->type             = t;
 
     for (int i = 0; i < type_free_count; i++) {
-        if (!int_array_contains(env_free, env_free_count, type_free[i]))
+        if (s->level[type_free[i]] >= s->current_level)
             sc->quantified[sc->quantified_count++] = type_free[i];
     }
 
@@ -1181,52 +1242,87 @@ void scheme_free(TypeScheme *s) {
 
 /// Zonking
 //
-//  Walk the AST and replace every node's inferred_type with its
+//  Walk the AST once and replace every node's inferred_type with its
 //  fully-substituted form.  After this pass, no TYPE_VAR nodes
 //  remain in any inferred_type (unless the type is genuinely
 //  polymorphic in a let-binding, which codegen handles via
 //  monomorphization).
 //
-void infer_zonk_ast(InferCtx *ctx, AST *ast) {
+//  The same walk validates call sites: a node's children are zonked
+//  before the node is checked, and the node is checked before its
+//  children are visited, so checks see concrete argument types and run
+//  in the order the separate validation pass used to.
+//
+static void infer_validate_call(InferCtx *ctx, AST *ast);
+
+static void infer_zonk_type(InferCtx *ctx, AST *ast) {
     if (!ast) return;
 
     if (ast->inferred_type)
         ast->inferred_type = subst_apply(ctx->subst, ast->inferred_type);
 
-    /* Resolve symbol types from env so validate_calls can see them */
+    /* Resolve symbol types from env so call validation can see them */
     if (ast->type == AST_SYMBOL && !ast->inferred_type) {
         TypeScheme *sc = infer_env_lookup(ctx, ast->symbol);
         if (sc) ast->inferred_type = infer_instantiate(ctx, sc);
     }
+}
+
+static bool infer_is_check_laws(AST *ast) {
+    return ast->list.count > 0 &&
+           ast->list.items[0] &&
+           ast->list.items[0]->type == AST_SYMBOL &&
+           (strcmp(ast->list.items[0]->symbol, "check-laws") == 0 ||
+            strcmp(ast->list.items[0]->symbol, "check-laws-seeded") == 0);
+}
+
+// Zonk and visit the children of `ast`, whose own type is already zonked.
+// `validate` is false under sets, maps and check-laws forms.
+static void infer_zonk_children(InferCtx *ctx, AST *ast, bool validate) {
+    if (!ast) return;
 
     switch (ast->type) {
-    case AST_LIST:
+    case AST_LIST: {
+        for (size_t i = 0; i < ast->list.count; i++)
+            infer_zonk_type(ctx, ast->list.items[i]);
+        if (validate) infer_validate_call(ctx, ast);
+        bool inner = validate && !infer_is_check_laws(ast);
         for (size_t i = 0; i < ast->list.count; i++)
-            infer_zonk_ast(ctx, ast->list.items[i]);
+            infer_zonk_children(ctx, ast->list.items[i], inner);
         break;
+    }
     case AST_ARRAY:
         for (size_t i = 0; i < ast->array.element_count; i++)
-            infer_zonk_ast(ctx, ast->array.elements[i]);
+            infer_zonk_type(ctx, ast->array.elements[i]);
+        for (size_t i = 0; i < ast->array.element_count; i++)
+            infer_zonk_children(ctx, ast->array.elements[i], validate);
         break;
     case AST_SET:
-        for (size_t i = 0; i < ast->set.element_count; i++)
-            infer_zonk_ast(ctx, ast->set.elements[i]);
+        for (size_t i = 0; i < ast->set.element_count; i++) {
+            infer_zonk_type(ctx, ast->set.elements[i]);
+            infer_zonk_children(ctx, ast->set.elements[i], false);
+        }
         break;
     case AST_MAP:
         for (size_t i = 0; i < ast->map.count; i++) {
-            infer_zonk_ast(ctx, ast->map.keys[i]);
-            infer_zonk_ast(ctx, ast->map.vals[i]);
+            infer_zonk_type(ctx, ast->map.keys[i]);
+            infer_zonk_children(ctx, ast->map.keys[i], false);
+            infer_zonk_type(ctx, ast->map.vals[i]);
+            infer_zonk_children(ctx, ast->map.vals[i], false);
         }
         break;
     case AST_LAMBDA: {
         InferEnv *child = infer_env_create_child(ctx->env);
         InferEnv *saved = ctx->env;
         ctx->env = child;
+        TypeScheme *param_sc = scheme_mono(type_unknown());
         for (int i = 0; i < ast->lambda.param_count; i++) {
-            infer_env_insert(child, ast->lambda.params[i].name, scheme_mono(type_unknown()));
+            infer_env_insert(child, ast->lambda.params[i].name, param_sc);
         }
         for (int i = 0; i < ast->lambda.body_count; i++)
-            infer_zonk_ast(ctx, ast->lambda.body_exprs[i]);
+            infer_zonk_type(ctx, ast->lambda.body_exprs[i]);
+        for (int i = 0; i < ast->lambda.body_count; i++)
+            infer_zonk_children(ctx, ast->lambda.body_exprs[i], validate);
         ctx->env = saved;
         infer_env_free(child);
         break;
@@ -1236,6 +1332,11 @@ void infer_zonk_ast(InferCtx *ctx, AST *ast) {
     }
 }
 
+void infer_zonk_ast(InferCtx *ctx, AST *ast) {
+    infer_zonk_type(ctx, ast);
+    infer_zonk_children(ctx, ast, true);
+}
+
 
 /// Type Inference — Expression Walk
 
@@ -1262,19 +1363,25 @@ static bool infer_ast_was_postfix_index(AST *call, AST *receiver) {
 
 static void infer_env_remove(InferEnv *env, const char *name) {
     if (!env || !name) return;
-    size_t idx = infer_env_hash(name);
-    InferEnvEntry *prev = NULL;
-    for (InferEnvEntry *e = env->buckets[idx]; e; e = e->next) {
-        if (strcmp(e->name, name) == 0) {
-            if (prev) prev->next = e->next;
-            else       env->buckets[idx] = e->next;
-            scheme_free(e->scheme);
-            free((char*)e->name);
-            free(e);
-            env->size--;
-            return;
-        }
-        prev = e;
+    const char *key = intern_find(name);
+    if (!key) return;
+    InferEnvEntry *e = infer_env_probe(env, key);
+    if (!e->name) return;
+    scheme_free(e->scheme);
+    env->count--;
+    /* Backward-shift deletion, as in env_remove. */
+    size_t mask = env->size - 1;
+    size_t hole = (size_t)(e - env->slots);
+    size_t i    = hole;
+    env->slots[hole].name = NULL;
+    for (;;) {
+        i = (i + 1) & mask;
+        if (!env->slots[i].name) return;
+        size_t home = intern_hash(env->slots[i].name) & mask;
+        if (((i - home) & mask) < ((i - hole) & mask)) continue;
+        env->slots[hole]      = env->slots[i];
+        env->slots[i].name    = NULL;
+        hole = i;
     }
 }
 
@@ -1661,6 +1768,7 @@ Type *infer_expr(InferCtx *ctx, AST *ast) {
             InferEnv *def_child = infer_env_create_child(ctx->env);
             InferEnv *saved_env = ctx->env;
             ctx->env = def_child;
+            infer_enter_level(ctx);
 
             Type *self_t = infer_fresh(ctx);
             infer_env_insert(def_child, name, scheme_mono(self_t));
@@ -1698,10 +1806,11 @@ Type *infer_expr(InferCtx *ctx, AST *ast) {
             ctx->constraint_count = 0;
             ctx->had_error = false;
 
-            /* Remove stale scheme for this name from outer env before generalising
-             * to prevent old type vars from corrupting infer_free_vars_env        */
+            /* Drop the stale scheme for this name from the outer env; the
+             * generalised one below replaces it. */
             infer_env_remove(saved_env, name);
             TypeScheme *sc = infer_generalise(ctx, val_t, saved_env);
+            infer_leave_level(ctx);
             ctx->env = saved_env;
             infer_env_free(def_child);
             /* Insert the fully-solved generalised scheme into the real outer env */
@@ -2611,6 +2720,47 @@ void infer_register_builtins(InferCtx *ctx) {
         type_arrow(type_map_of(find_key, find_value),
                    type_arrow(find_key, find_value)), ctx->env));
 
+    /* ∀a b. (a → b) → Coll a → Coll b, and the filter and fold forms */
+    Type *pmap_a = infer_fresh(ctx);
+    Type *pmap_b = infer_fresh(ctx);
+    Type *pmap_in = type_coll();
+    pmap_in->element_type = type_clone(pmap_a);
+    Type *pmap_out = type_coll();
+    pmap_out->element_type = type_clone(pmap_b);
+    infer_env_insert(ctx->env, "__rt_par_map", infer_generalise(ctx,
+        type_arrow(type_arrow(pmap_a, pmap_b),
+                   type_arrow(pmap_in, pmap_out)), ctx->env));
+    Type *pfilter_a = infer_fresh(ctx);
+    Type *pfilter_in = type_coll();
+    pfilter_in->element_type = type_clone(pfilter_a);
+    infer_env_insert(ctx->env, "__rt_par_filter", infer_generalise(ctx,
+        type_arrow(type_arrow(pfilter_a, type_bool()),
+                   type_arrow(pfilter_in, type_clone(pfilter_in))), ctx->env));
+    Type *pfold_a = infer_fresh(ctx);
+    Type *pfold_in = type_coll();
+    pfold_in->element_type = type_clone(pfold_a);
+    infer_env_insert(ctx->env, "__rt_par_fold", infer_generalise(ctx,
+        type_arrow(type_arrow(pfold_a, type_arrow(pfold_a, pfold_a)),
+                   type_arrow(pfold_a, type_arrow(pfold_in, pfold_a))), ctx->env));
+
+    /* Fibers: ∀a. (Int → a) → Int for spawn and run, ∀a. a → a for
+     * yield, and the raw syscall shapes for the I/O wrappers.          */
+    Type *fiber_a = infer_fresh(ctx);
+    TypeScheme *fiber_spawn_sc = infer_generalise(ctx,
+        type_arrow(type_arrow(type_int(), fiber_a), type_int()), ctx->env);
+    infer_env_insert(ctx->env, "__rt_fiber_spawn", fiber_spawn_sc);
+    infer_env_insert(ctx->env, "__rt_fiber_run",   fiber_spawn_sc);
+    Type *yield_a = infer_fresh(ctx);
+    infer_env_insert(ctx->env, "__rt_fiber_yield", infer_generalise(ctx,
+        type_arrow(yield_a, yield_a), ctx->env));
+    TypeScheme *fiber_io_sc = infer_generalise(ctx,
+        type_arrow(type_int(), type_arrow(type_ptr(type_u8()),
+                   type_arrow(type_int(), type_int()))), ctx->env);
+    infer_env_insert(ctx->env, "__rt_fiber_read",  fiber_io_sc);
+    infer_env_insert(ctx->env, "__rt_fiber_write", fiber_io_sc);
+    infer_env_insert(ctx->env, "__rt_fiber_accept", infer_generalise(ctx,
+        type_arrow(type_int(), type_int()), ctx->env));
+
     /* ADT internal primitives — typed by codegen_data at runtime,
      * registered here as opaque so HM doesn't reject them          */
     Type *adt_a = infer_fresh(ctx);
@@ -2622,7 +2772,7 @@ void infer_register_builtins(InferCtx *ctx) {
 
 /// Top-level Entry Point
 
-static void infer_validate_calls(InferCtx *ctx, AST *ast) {
+static void infer_validate_call(InferCtx *ctx, AST *ast) {
     if (!ast) return;
 
     if (ast->type == AST_LIST && ast->list.count >= 2) {
@@ -2703,39 +2853,6 @@ static void infer_validate_calls(InferCtx *ctx, AST *ast) {
             }
         }
     }
-
-    /* Recurse into all children */
-    switch (ast->type) {
-    case AST_LIST:
-        if (ast->list.count > 0 &&
-            ast->list.items[0] &&
-            ast->list.items[0]->type == AST_SYMBOL &&
-            (strcmp(ast->list.items[0]->symbol, "check-laws") == 0 ||
-             strcmp(ast->list.items[0]->symbol, "check-laws-seeded") == 0))
-            break;
-        for (size_t i = 0; i < ast->list.count; i++)
-            infer_validate_calls(ctx, ast->list.items[i]);
-        break;
-    case AST_LAMBDA: {
-        InferEnv *child = infer_env_create_child(ctx->env);
-        InferEnv *saved = ctx->env;
-        ctx->env = child;
-        for (int i = 0; i < ast->lambda.param_count; i++) {
-            infer_env_insert(child, ast->lambda.params[i].name, scheme_mono(type_unknown()));
-        }
-        for (int i = 0; i < ast->lambda.body_count; i++)
-            infer_validate_calls(ctx, ast->lambda.body_exprs[i]);
-        ctx->env = saved;
-        infer_env_free(child);
-        break;
-    }
-    case AST_ARRAY:
-        for (size_t i = 0; i < ast->array.element_count; i++)
-            infer_validate_calls(ctx, ast->array.elements[i]);
-        break;
-    default:
-        break;
-    }
 }
 
 void infer_report_holes(InferCtx *ctx) {
@@ -2765,18 +2882,191 @@ Type *infer_toplevel(InferCtx *ctx, AST *ast) {
     struct DepCtx *saved_dctx = ctx->dctx;
     ctx->dctx = NULL;
 
-    /* 3. Zonking — apply substitution to all AST nodes */
+    /* 3. Zonking — apply substitution to all AST nodes, checking call
+     *    sites against the now-concrete types on the way */
     infer_zonk_ast(ctx, ast);
 
-    /* 4. Post-zonk validation — check call sites with concrete types */
-    infer_validate_calls(ctx, ast);
-
     ctx->dctx = saved_dctx;
 
     return subst_apply(ctx->subst, t);
 }
 
 
+/// Definition Dependency Graph
+
+void infer_each_node(AST *ast, void (*visit)(AST *node, void *data), void *data) {
+    if (!ast) return;
+    visit(ast, data);
+
+    switch (ast->type) {
+    case AST_LIST:
+        for (size_t i = 0; i < ast->list.count; i++)
+            infer_each_node(ast->list.items[i], visit, data);
+        break;
+    case AST_ARRAY:
+        for (size_t i = 0; i < ast->array.element_count; i++)
+            infer_each_node(ast->array.elements[i], visit, data);
+        break;
+    case AST_SET:
+        for (size_t i = 0; i < ast->set.element_count; i++)
+            infer_each_node(ast->set.elements[i], visit, data);
+        break;
+    case AST_MAP:
+        for (size_t i = 0; i < ast->map.count; i++) {
+            infer_each_node(ast->map.keys[i], visit, data);
+            infer_each_node(ast->map.vals[i], visit, data);
+        }
+        break;
+    case AST_LAMBDA:
+        for (int i = 0; i < ast->lambda.body_count; i++)
+            infer_each_node(ast->lambda.body_exprs[i], visit, data);
+        break;
+    default:
+        break;
+    }
+}
+
+// Definition index by interned name: open-addressed, twice the
+// definition count rounded up to a power of two, -1 for empty.
+typedef struct DefIndex {
+    const char **keys;
+    int         *defs;
+    size_t       mask;
+} DefIndex;
+
+static int *def_index_slot(DefIndex *ix, const char *key) {
+    size_t i = intern_hash(key) & ix->mask;
+    while (ix->defs[i] >= 0 && ix->keys[i] != key)
+        i = (i + 1) & ix->mask;
+    return &ix->defs[i];
+}
+
+typedef struct DefEdges {
+    DefIndex *index;
+    int       from;
+    int      *seen;    // seen[j] == from once the edge from -> j is added
+    int      *out;
+    int       count;
+    int       cap;
+} DefEdges;
+
+static void def_edges_visit(AST *node, void *data) {
+    DefEdges *ed = data;
+    if (node->type != AST_SYMBOL || !node->symbol) return;
+    const char *key = intern_find(node->symbol);
+    if (!key) return;
+    int to = *def_index_slot(ed->index, key);
+    if (to < 0 || to == ed->from || ed->seen[to] == ed->from) return;
+    ed->seen[to] = ed->from;
+    if (ed->count == ed->cap) {
+        ed->cap = ed->cap ? ed->cap * 2 : 64;
+        ed->out = realloc(ed->out, sizeof(int) * ed->cap);
+    }
+    ed->out[ed->count++] = to;
+}
+
+static int def_int_cmp(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+void infer_def_graph_build(InferDefGraph *g, const char **names, AST **bodies, int count) {
+    g->count     = count;
+    g->order     = malloc(sizeof(int) * (count ? count : 1));
+    g->scc       = malloc(sizeof(int) * (count ? count : 1));
+    g->scc_count = 0;
+    if (count <= 0) return;
+
+    size_t cap = 16;
+    while (cap < (size_t)count * 2) cap *= 2;
+    DefIndex ix = { calloc(cap, sizeof(char *)), malloc(sizeof(int) * cap), cap - 1 };
+    for (size_t i = 0; i < cap; i++) ix.defs[i] = -1;
+    for (int i = 0; i < count; i++) {
+        const char *key = intern(names[i]);
+        int *slot = def_index_slot(&ix, key);
+        if (*slot >= 0) continue;        // first definition wins
+        ix.keys[slot - ix.defs] = key;
+        *slot = i;
+    }
+
+    /* Edges in CSR form: def i depends on adj[start[i] .. start[i+1]). */
+    int *start = malloc(sizeof(int) * (count + 1));
+    DefEdges ed = { &ix, 0, malloc(sizeof(int) * count), NULL, 0, 0 };
+    for (int i = 0; i < count; i++) ed.seen[i] = -1;
+    for (int i = 0; i < count; i++) {
+        start[i] = ed.count;
+        ed.from  = i;
+        infer_each_node(bodies[i], def_edges_visit, &ed);
+    }
+    start[count] = ed.count;
+
+    /* Tarjan's algorithm, iterative so a long chain of definitions cannot
+     * overflow the C stack.  A component is emitted once everything it
+     * reaches has been, so emission order is dependency order. */
+    int *index   = malloc(sizeof(int) * count);
+    int *low     = malloc(sizeof(int) * count);
+    int *next    = malloc(sizeof(int) * count);   // next edge to explore
+    int *call    = malloc(sizeof(int) * count);   // DFS path
+    int *stack   = malloc(sizeof(int) * count);   // Tarjan stack
+    bool *on     = calloc(count, sizeof(bool));
+    int counter = 0, depth = 0, sp = 0, emitted = 0;
+    for (int i = 0; i < count; i++) index[i] = -1;
+
+    for (int root = 0; root < count; root++) {
+        if (index[root] >= 0) continue;
+        call[depth++] = root;
+        index[root] = low[root] = counter++;
+        next[root] = start[root];
+        stack[sp++] = root;
+        on[root] = true;
+
+        while (depth > 0) {
+            int v = call[depth - 1];
+            if (next[v] < start[v + 1]) {
+                int w = ed.out[next[v]++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    next[w] = start[w];
+                    stack[sp++] = w;
+                    on[w] = true;
+                    call[depth++] = w;
+                } else if (on[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            depth--;
+            if (depth > 0 && low[v] < low[call[depth - 1]])
+                low[call[depth - 1]] = low[v];
+            if (low[v] != index[v]) continue;
+
+            int first = emitted, w;
+            do {
+                w = stack[--sp];
+                on[w] = false;
+                g->scc[w] = g->scc_count;
+                g->order[emitted++] = w;
+            } while (w != v);
+            qsort(g->order + first, emitted - first, sizeof(int), def_int_cmp);
+            g->scc_count++;
+        }
+    }
+
+    free(index); free(low); free(next); free(call); free(stack); free(on);
+    free(start); free(ed.seen); free(ed.out);
+    free(ix.keys); free(ix.defs);
+}
+
+void infer_def_graph_free(InferDefGraph *g) {
+    if (!g) return;
+    free(g->order);
+    free(g->scc);
+    g->order = g->scc = NULL;
+    g->count = g->scc_count = 0;
+}
+
+
 /// Pretty Printing
 
 void infer_print_type(Type *t, Substitution *s) {
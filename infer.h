@@ -66,17 +66,19 @@ void infer_set_trace(bool enabled);
 //  Maps names to their type schemes.  Separate from the codegen Env —
 //  the infer env is purely for type-level bookkeeping and is discarded
 //  after inference.  It forms a singly-linked scope chain exactly like
-//  the codegen Env.
+//  the codegen Env, and each scope is likewise open-addressed: `slots`
+//  holds the entries inline, probed linearly from the name's interned
+//  hash, with name == NULL marking an empty slot.
 //
 typedef struct InferEnvEntry {
-    char                 *name;
+    const char           *name;   // interned; compared by pointer
     TypeScheme           *scheme;
-    struct InferEnvEntry *next;
 } InferEnvEntry;
 
 typedef struct InferEnv {
-    InferEnvEntry  **buckets;
-    size_t           size;
+    InferEnvEntry   *slots;
+    size_t           size;   // power of two
+    size_t           count;
     struct InferEnv *parent;
 } InferEnv;
 
@@ -85,6 +87,7 @@ InferEnv *infer_env_create_child(InferEnv *parent);
 void      infer_env_free(InferEnv *env);
 void      infer_env_insert(InferEnv *env, const char *name, TypeScheme *scheme);
 TypeScheme *infer_env_lookup(InferCtx *ctx, const char *name);
+TypeScheme *infer_env_find(InferEnv *env, const char *name);  // scope chain only
 
 
 /// Substitution
@@ -96,10 +99,24 @@ TypeScheme *infer_env_lookup(InferCtx *ctx, const char *name);
 //  union_find[id] = id means the variable is its own root (free).
 //  union_find[id] = other_id means the variable is aliased to other_id.
 //  bound[id] is non-NULL only at root nodes, and holds the concrete type.
+//  subst_apply writes the resolved form back into bound[], so applying
+//  the same variable again does not rebuild its type.
 //
+//  level[id] is the let depth the variable was created at (Rémy levels).
+//  Unification lowers a variable's level to that of anything it becomes
+//  reachable from, so a root whose level is still >= the current level
+//  cannot occur in the enclosing environment and may be generalised.
+//  Slots no fresh variable has claimed stay at INFER_GENERIC_LEVEL.
+//
+#define INFER_GENERIC_LEVEL 0x7fffffff
+
 typedef struct Substitution {
     int   *union_find;   // parent pointers for union-find
     Type **bound;        // concrete type bound at each root
+    int   *level;        // creation level, meaningful at roots
+    int   *mark;         // visit stamps for free-variable walks
+    int    mark_epoch;
+    int    current_level; // level given to fresh variables (1 at top)
     int    capacity;     // number of slots allocated
     int    next_id;      // next fresh variable ID
 } Substitution;
@@ -196,13 +213,26 @@ Type *infer_expr(InferCtx *ctx, AST *ast);
 
 /// Generalisation and Instantiation
 //
-//  generalise takes a type and the outer environment and returns a
-//  TypeScheme that universally quantifies all type variables that are
-//  free in the type but not free in the environment.
+//  A let-bound right-hand side is inferred one level deeper than its
+//  context:
+//
+//    infer_enter_level(ctx);
+//    Type *t = infer_expr(ctx, rhs);
+//    infer_unify_all(ctx);
+//    TypeScheme *sc = infer_generalise(ctx, t, outer_env);
+//    infer_leave_level(ctx);
+//
+//  generalise quantifies the free variables of t whose level is still at
+//  least the current one, which are exactly those not free in the
+//  enclosing environment, so it costs O(size of t) and never scans the
+//  environment.  `outer_env` is kept for callers and is not read.  At
+//  the top level of a context every free variable is quantified.
 //
 //  instantiate takes a TypeScheme and replaces each quantified variable
 //  with a fresh type variable, returning a new monomorphic Type.
 //
+void        infer_enter_level(InferCtx *ctx);
+void        infer_leave_level(InferCtx *ctx);
 TypeScheme *infer_generalise(InferCtx *ctx, Type *t, InferEnv *outer_env);
 Type       *infer_instantiate(InferCtx *ctx, TypeScheme *scheme);
 
@@ -216,17 +246,17 @@ void        scheme_free(TypeScheme *s);
 
 /// Free Variables
 //
-//  Collect the set of free type-variable IDs in a type or environment.
-//  Used by generalise to determine which variables to quantify.
+//  Collect the distinct free type-variable roots of a type, in first-seen
+//  order.  Used by generalise to determine which variables to quantify.
 //
 void infer_free_vars_type(Substitution *s, Type *t, int *out, int *count, int cap);
-void infer_free_vars_env(InferCtx *ctx, InferEnv *env, int *out, int *count, int cap);
 
 
 /// Apply Substitution to AST
 //
-//  After unification, walk the AST and replace every inferred_type with
-//  its fully-substituted form.  This is the "zonking" pass.
+//  After unification, walk the AST once, replacing every inferred_type
+//  with its fully-substituted form and checking each call's arguments
+//  against its callee's parameter types.  This is the "zonking" pass.
 //
 void infer_zonk_ast(InferCtx *ctx, AST *ast);
 
@@ -253,6 +283,42 @@ void infer_register_builtins(InferCtx *ctx);
 Type *infer_toplevel(InferCtx *ctx, AST *ast);
 
 
+/// Definition Dependency Graph
+//
+//  Top-level definitions linked by the names their bodies mention, split
+//  into strongly connected components.  `order` lists the definitions so
+//  that each component comes after every component it calls into, which
+//  is the order to infer them in: a definition then sees the finished
+//  schemes of everything it uses, wherever that appears in the file.
+//  Definitions in one component (mutual recursion) keep source order.
+//
+//  Names are collected syntactically over the nodes infer_expr walks, so
+//  a local that shadows a definition adds an edge it does not need; that
+//  can only merge or reorder components.  A name defined twice resolves
+//  to its first definition.
+//
+//    InferDefGraph g;
+//    infer_def_graph_build(&g, names, bodies, n);
+//    for (int k = 0; k < g.count; k++)
+//        infer_one(names[g.order[k]], bodies[g.order[k]]);
+//    infer_def_graph_free(&g);
+//
+typedef struct InferDefGraph {
+    int  count;
+    int *order;      // definition indices, dependencies first
+    int *scc;        // component of each definition, by definition index
+    int  scc_count;  // components are numbered as they appear in `order`
+} InferDefGraph;
+
+void infer_def_graph_build(InferDefGraph *g, const char **names, AST **bodies, int count);
+void infer_def_graph_free(InferDefGraph *g);
+
+//  Visit `ast` and every node below it that infer_expr descends into
+//  (list items, array, set and map elements, lambda bodies), parents
+//  first.
+void infer_each_node(AST *ast, void (*visit)(AST *node, void *data), void *data);
+
+
 /// Pretty Printing (debug)
 
 void infer_print_type(Type *t, Substitution *s);
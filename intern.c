@@ -0,0 +1,117 @@
+#include "intern.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+///  Storage
+//
+//  Each string is stored once in an arena behind a small header carrying
+//  its hash, so rehashing the table and intern_hash() never touch the
+//  text.  The table itself is open-addressed with linear probing over a
+//  power-of-two array of header pointers, grown at 70% load.
+
+typedef struct InternSym {
+    uint32_t hash;
+    uint32_t len;
+    char     text[];
+} InternSym;
+
+#define INTERN_INITIAL_CAP 4096
+#define INTERN_ARENA_BLOCK (256u * 1024u)
+
+static Arena       g_intern_arena;
+static InternSym **g_intern_slots;
+static size_t      g_intern_cap;
+static size_t      g_intern_count;
+
+static uint32_t intern_hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static InternSym *intern_header(const char *sym) {
+    return (InternSym *)(sym - offsetof(InternSym, text));
+}
+
+static void intern_grow(void) {
+    size_t      cap   = g_intern_cap ? g_intern_cap * 2 : INTERN_INITIAL_CAP;
+    InternSym **slots = calloc(cap, sizeof(InternSym *));
+    if (!slots) {
+        fprintf(stderr, "intern: out of memory growing to %zu slots\n", cap);
+        abort();
+    }
+    for (size_t i = 0; i < g_intern_cap; i++) {
+        InternSym *s = g_intern_slots[i];
+        if (!s) continue;
+        size_t j = s->hash & (cap - 1);
+        while (slots[j]) j = (j + 1) & (cap - 1);
+        slots[j] = s;
+    }
+    free(g_intern_slots);
+    g_intern_slots = slots;
+    g_intern_cap   = cap;
+}
+
+// Slot holding `s[0..len)` or the empty slot where it would go.
+static InternSym **intern_probe(const char *s, size_t len, uint32_t h) {
+    size_t i = h & (g_intern_cap - 1);
+    for (;;) {
+        InternSym **slot = &g_intern_slots[i];
+        InternSym  *sym  = *slot;
+        if (!sym) return slot;
+        if (sym->hash == h && sym->len == len && memcmp(sym->text, s, len) == 0)
+            return slot;
+        i = (i + 1) & (g_intern_cap - 1);
+    }
+}
+
+///  API
+
+const char *intern_n(const char *s, size_t len) {
+    if (!s) return NULL;
+    if (len > UINT32_MAX) {
+        fprintf(stderr, "intern: %zu-byte name is too long\n", len);
+        abort();
+    }
+    if ((g_intern_count + 1) * 10 >= g_intern_cap * 7) {
+        if (!g_intern_cap) arena_init(&g_intern_arena, INTERN_ARENA_BLOCK);
+        intern_grow();
+    }
+
+    uint32_t    h    = intern_hash_bytes(s, len);
+    InternSym **slot = intern_probe(s, len, h);
+    if (*slot) return (*slot)->text;
+
+    InternSym *sym = arena_alloc(&g_intern_arena, sizeof(InternSym) + len + 1);
+    sym->hash = h;
+    sym->len  = (uint32_t)len;
+    memcpy(sym->text, s, len);
+    sym->text[len] = '\0';
+    *slot = sym;
+    g_intern_count++;
+    return sym->text;
+}
+
+const char *intern(const char *s) {
+    return s ? intern_n(s, strlen(s)) : NULL;
+}
+
+const char *intern_find(const char *s) {
+    if (!s || !g_intern_cap) return NULL;
+    size_t      len  = strlen(s);
+    InternSym **slot = intern_probe(s, len, intern_hash_bytes(s, len));
+    return *slot ? (*slot)->text : NULL;
+}
+
+uint32_t intern_hash(const char *sym) {
+    return intern_header(sym)->hash;
+}
+
+size_t intern_count(void) {
+    return g_intern_count;
+}
@@ -0,0 +1,42 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+///  Symbol interner
+//
+//  One process-wide table that maps every distinct name to a single
+//  canonical, immutable copy.  Two interned pointers are equal iff their
+//  strings are, so symbol tables key on the pointer: a lookup pays for one
+//  hash and one probe here, then compares pointers down bucket chains and
+//  up parent scopes instead of re-hashing and strcmp'ing at every level.
+//
+//  Interned strings are never freed and never move.  Callers that own a
+//  `char *name` keep owning it; the interned copy lives beside it.
+//
+//    const char *k = intern("map");          // insert side
+//    const char *q = intern_find(user_name);  // lookup side, never inserts
+//    if (q == k) ...                          // same name
+//
+//  The table is not locked: it is only touched by the front end and
+//  codegen, which run on the main thread.
+
+// Canonical copy of `s`, inserting it on first use.  NULL -> NULL.
+const char *intern(const char *s);
+
+// Same for the first `len` bytes of `s` (need not be NUL-terminated).
+const char *intern_n(const char *s, size_t len);
+
+// Canonical copy of `s` if it was ever interned, otherwise NULL.  Lookups
+// use this so a miss does not grow the table.
+const char *intern_find(const char *s);
+
+// Hash cached with an interned string.  `sym` must come from intern().
+uint32_t intern_hash(const char *sym);
+
+// Number of distinct strings interned so far.
+size_t intern_count(void);
+
+#endif // INTERN_H
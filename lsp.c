@@ -42,6 +42,7 @@
 //
 
 #include "lsp.h"
+#include "compat.h"
 
 #include <assert.h>
 #include <ctype.h>
@@ -50,6 +51,19 @@
 #include <string.h>
 #include <time.h>
 #include <inttypes.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if !defined(_WIN32)
+#include <pthread.h>
+#define LSP_ANALYZER_THREAD 1
+#else
+#define LSP_ANALYZER_THREAD 0
+#endif
 
 
 /// Forward declaration
@@ -842,6 +856,17 @@ static char *json_get_object(const char *obj, const char *field)
     return result;
 }
 
+/* Step through a raw JSON array: pass the array first, then the returned
+   cursor.  Returns NULL after the last element. */
+static const char *json_array_next(const char *p, char **out)
+{
+    if (!p) return NULL;
+    p = json_skip_ws(p);
+    if (*p == '[' || *p == ',') p = json_skip_ws(p + 1);
+    if (*p == ']' || *p == '\0') return NULL;
+    return json_capture_value(p, out);
+}
+
 
 /// §7  Message construction
 
@@ -986,10 +1011,11 @@ LspPosition lsp_document_position(const LspDocument *doc, uint32_t offset)
     return pos;
 }
 
-/* Determine whether a byte is a valid identifier character for Monad. */
+/* Determine whether a byte is a valid identifier character for Monad.
+   Lisp-style names such as prime? and sum-range are one word. */
 static bool is_ident_char(char c)
 {
-    return isalnum((unsigned char)c) || c == '_' || c == '\'';
+    return isalnum((unsigned char)c) || (c && strchr("_'-?!*<>=+", c));
 }
 
 static bool is_ident_start(char c)
@@ -1080,6 +1106,236 @@ void lsp_document_build_line_index(LspDocument *doc)
 }
 
 
+//// Rope
+ //
+ //  An AVL-balanced rope of byte leaves.  Each node caches its byte and
+ //  newline counts, so an LSP position resolves to an offset in O(log n)
+ //  without a flat copy, and a splice is a split plus two joins.  split
+ //  and join consume their arguments.
+ //
+ //  Leaves hold at most LSP_ROPE_LEAF bytes; join merges adjacent small
+ //  leaves so a run of single-character inserts does not leave one node
+ //  per keystroke behind.
+ //
+#define LSP_ROPE_LEAF 1024
+
+struct LspRope {
+    LspRope  *left, *right;   /* both NULL for a leaf        */
+    uint32_t  len;            /* bytes in this subtree       */
+    uint32_t  lines;          /* '\n' bytes in this subtree  */
+    uint32_t  height;         /* 1 for a leaf                */
+    char      text[];         /* leaf bytes, len of them     */
+};
+
+static uint32_t rope_height(const LspRope *r) { return r ? r->height : 0; }
+
+static LspRope *rope_leaf(const char *s, uint32_t n)
+{
+    LspRope *r = lsp_xmalloc(sizeof(*r) + n);
+    r->left = r->right = NULL;
+    r->len    = n;
+    r->lines  = 0;
+    r->height = 1;
+    memcpy(r->text, s, n);
+    for (const char *p = s; (p = memchr(p, '\n', (size_t)(s + n - p))); p++)
+        r->lines++;
+    return r;
+}
+
+static void rope_fix(LspRope *r)
+{
+    r->len    = r->left->len   + r->right->len;
+    r->lines  = r->left->lines + r->right->lines;
+    uint32_t hl = r->left->height, hr = r->right->height;
+    r->height = (hl > hr ? hl : hr) + 1;
+}
+
+static LspRope *rope_node(LspRope *l, LspRope *r)
+{
+    LspRope *n = lsp_xmalloc(sizeof(*n));
+    n->left  = l;
+    n->right = r;
+    rope_fix(n);
+    return n;
+}
+
+static LspRope *rope_rotate_right(LspRope *r)
+{
+    LspRope *l = r->left;
+    r->left  = l->right;
+    rope_fix(r);
+    l->right = r;
+    rope_fix(l);
+    return l;
+}
+
+static LspRope *rope_rotate_left(LspRope *r)
+{
+    LspRope *rt = r->right;
+    r->right = rt->left;
+    rope_fix(r);
+    rt->left = r;
+    rope_fix(rt);
+    return rt;
+}
+
+static LspRope *rope_balance(LspRope *r)
+{
+    uint32_t hl = rope_height(r->left), hr = rope_height(r->right);
+    if (hl > hr + 1) {
+        if (rope_height(r->left->left) < rope_height(r->left->right))
+            r->left = rope_rotate_left(r->left);
+        return rope_rotate_right(r);
+    }
+    if (hr > hl + 1) {
+        if (rope_height(r->right->right) < rope_height(r->right->left))
+            r->right = rope_rotate_right(r->right);
+        return rope_rotate_left(r);
+    }
+    return r;
+}
+
+static LspRope *rope_join(LspRope *l, LspRope *r)
+{
+    if (!l || l->len == 0) { free(l); return r; }
+    if (!r || r->len == 0) { free(r); return l; }
+
+    if (l->height == 1 && r->height == 1 && l->len + r->len <= LSP_ROPE_LEAF) {
+        LspRope *m = lsp_xrealloc(l, sizeof(*l) + l->len + r->len);
+        memcpy(m->text + m->len, r->text, r->len);
+        m->len   += r->len;
+        m->lines += r->lines;
+        free(r);
+        return m;
+    }
+    if (l->height > r->height + 1) {
+        l->right = rope_join(l->right, r);
+        rope_fix(l);
+        return rope_balance(l);
+    }
+    if (r->height > l->height + 1) {
+        r->left = rope_join(l, r->left);
+        rope_fix(r);
+        return rope_balance(r);
+    }
+    return rope_node(l, r);
+}
+
+// Split r into [0, off) and [off, len).
+static void rope_split(LspRope *r, uint32_t off, LspRope **a, LspRope **b)
+{
+    if (!r)             { *a = NULL; *b = NULL; return; }
+    if (off == 0)       { *a = NULL; *b = r;    return; }
+    if (off >= r->len)  { *a = r;    *b = NULL; return; }
+
+    if (r->height == 1) {
+        *a = rope_leaf(r->text, off);
+        *b = rope_leaf(r->text + off, r->len - off);
+        free(r);
+        return;
+    }
+
+    LspRope *l = r->left, *rt = r->right, *m;
+    free(r);
+    if (off < l->len) {
+        rope_split(l, off, a, &m);
+        *b = rope_join(m, rt);
+    } else {
+        rope_split(rt, off - l->len, &m, b);
+        *a = rope_join(l, m);
+    }
+}
+
+static LspRope *rope_build(const char *s, uint32_t n)
+{
+    if (n <= LSP_ROPE_LEAF) return rope_leaf(s, n);
+    uint32_t leaves = (n + LSP_ROPE_LEAF - 1) / LSP_ROPE_LEAF;
+    uint32_t mid    = (leaves / 2) * LSP_ROPE_LEAF;
+    return rope_node(rope_build(s, mid), rope_build(s + mid, n - mid));
+}
+
+static void rope_free(LspRope *r)
+{
+    if (!r) return;
+    rope_free(r->left);
+    rope_free(r->right);
+    free(r);
+}
+
+// Replace [start, end) with n bytes of text.
+static LspRope *rope_splice(LspRope *r, uint32_t start, uint32_t end,
+                            const char *text, uint32_t n)
+{
+    LspRope *head, *mid, *tail;
+    rope_split(r, end, &mid, &tail);
+    rope_split(mid, start, &head, &mid);
+    rope_free(mid);
+    return rope_join(rope_join(head, n ? rope_build(text, n) : NULL), tail);
+}
+
+// Copy [off, off + n) into dst.
+static void rope_copy(const LspRope *r, uint32_t off, uint32_t n, char *dst)
+{
+    while (r && n) {
+        if (r->height == 1) {
+            memcpy(dst, r->text + off, n);
+            return;
+        }
+        uint32_t ll = r->left->len;
+        if (off < ll) {
+            uint32_t take = ll - off < n ? ll - off : n;
+            rope_copy(r->left, off, take, dst);
+            dst += take;
+            n   -= take;
+            off  = 0;
+        } else {
+            off -= ll;
+        }
+        r = r->right;
+    }
+}
+
+// Byte offset of the start of line `line`, or len past the last line.
+static uint32_t rope_line_start(const LspRope *r, uint32_t line)
+{
+    if (line == 0) return 0;
+    if (!r || line > r->lines) return r ? r->len : 0;
+
+    uint32_t base = 0;
+    while (r->height > 1) {
+        if (line <= r->left->lines) {
+            r = r->left;
+        } else {
+            line -= r->left->lines;
+            base += r->left->len;
+            r     = r->right;
+        }
+    }
+    const char *p = r->text;
+    while (line--) p = memchr(p, '\n', (size_t)(r->text + r->len - p)) + 1;
+    return base + (uint32_t)(p - r->text);
+}
+
+// Byte offset of an LSP position, clamped to the end of its line.
+static uint32_t rope_offset(const LspRope *r, LspPosition pos)
+{
+    uint32_t len   = r ? r->len : 0;
+    uint32_t start = rope_line_start(r, pos.line);
+    if (start >= len) return len;
+
+    uint32_t stop = pos.line < r->lines ? rope_line_start(r, pos.line + 1) - 1
+                                        : len;
+    char  small[256];
+    char *line = stop - start < sizeof(small) ? small
+                                               : lsp_xmalloc(stop - start + 1);
+    rope_copy(r, start, stop - start, line);
+    line[stop - start] = '\0';
+    uint32_t col = lsp_utf16_to_utf8(line, pos.character);
+    if (line != small) free(line);
+    return start + col;
+}
+
+
 /// §10  Document management
 
 //// Document management
@@ -1117,6 +1373,10 @@ LspDocument *lsp_document_create(const char *uri, const char *source,
     doc->fold_cap = 64;
     doc->folds    = lsp_xmalloc(doc->fold_cap * sizeof(LspFoldRange));
 
+    doc->rope       = rope_build(doc->source, (uint32_t)doc->source_len);
+    doc->reparse_lo = 0;
+    doc->reparse_hi = (uint32_t)doc->source_len;
+
     lsp_document_build_line_index(doc);
     return doc;
 }
@@ -1128,9 +1388,197 @@ void lsp_document_update(LspDocument *doc, const char *source, int version)
     doc->source_len = strlen(doc->source);
     doc->version    = version;
     doc->state      = LSP_DOC_DIRTY;
+
+    rope_free(doc->rope);
+    doc->rope         = rope_build(doc->source, (uint32_t)doc->source_len);
+    doc->source_stale = false;
+    doc->form_count   = 0;
+    doc->reparse_lo   = 0;
+    doc->reparse_hi   = (uint32_t)doc->source_len;
     lsp_document_build_line_index(doc);
 }
 
+//// Top-level forms
+ //
+ //  A form is either a bracketed expression, which ends at its matching
+ //  close, or a bare top-level line.  The scanner skips strings, char
+ //  literals and ';' comments so brackets inside them do not count.
+ //
+static uint32_t form_skip_blank(const char *s, uint32_t len, uint32_t p)
+{
+    while (p < len) {
+        if (s[p] == ';')
+            while (p < len && s[p] != '\n') p++;
+        else if (isspace((unsigned char)s[p]))
+            p++;
+        else
+            break;
+    }
+    return p;
+}
+
+// One past the end of the form starting at p.  A char literal looks up to
+// LSP_FORM_LOOKAHEAD bytes ahead, so an edit that close to a form's end
+// can change where it stops.
+#define LSP_FORM_LOOKAHEAD 6
+
+static uint32_t form_scan(const char *s, uint32_t len, uint32_t p)
+{
+    int depth = 0;
+    while (p < len) {
+        char c = s[p];
+        if (c == '"') {
+            for (p++; p < len && s[p] != '"'; p++)
+                if (s[p] == '\\') p++;
+            p = p < len ? p + 1 : len;
+            continue;
+        }
+        if (c == ';') {
+            while (p < len && s[p] != '\n') p++;
+            continue;
+        }
+        if (c == '\'' && p + 2 < len) {
+            uint32_t q = p + 1;
+            if (s[q] == '\\')
+                for (q += 2; q < len && q < p + 6 && s[q] != '\''; q++) {}
+            else
+                q++;
+            if (q < len && s[q] == '\'') { p = q + 1; continue; }
+        }
+        if (c == '(' || c == '[' || c == '{') {
+            depth++;
+        } else if (c == ')' || c == ']' || c == '}') {
+            if (--depth <= 0) return p + 1;
+        } else if (c == '\n' && depth == 0) {
+            return p;
+        }
+        p++;
+    }
+    return len;
+}
+
+// Rescan [reparse_lo, reparse_hi) of the flat source.  Forms outside it
+// are still valid; a scan that runs past hi (an unclosed bracket or
+// string, or a new ';') swallows the old forms it covers.
+static void document_rescan_forms(LspDocument *doc)
+{
+    doc->forms_rescanned = 0;
+    if (doc->reparse_lo > doc->reparse_hi) return;
+
+    const char *s   = doc->source;
+    uint32_t    len = (uint32_t)doc->source_len;
+    uint32_t    p   = doc->reparse_lo < len ? doc->reparse_lo : len;
+    uint32_t    hi  = doc->reparse_hi < len ? doc->reparse_hi : len;
+
+    size_t first = 0;
+    while (first < doc->form_count && doc->forms[first].end <= p) first++;
+    size_t keep = first;   /* first old form not yet swallowed */
+
+    /* Restart from a point known to be outside any comment: the start of
+       the line, or the end of the form before it if that is later. */
+    uint32_t floor = first ? doc->forms[first - 1].end : 0;
+    while (p > floor && s[p - 1] != '\n') p--;
+
+    LspForm *fresh = NULL;
+    size_t   n = 0, cap = 0;
+    for (;;) {
+        p = form_skip_blank(s, len, p);
+        while (keep < doc->form_count && doc->forms[keep].start < p) {
+            if (doc->forms[keep].end > hi) hi = doc->forms[keep].end;
+            keep++;
+        }
+        /* Done once the scan is back in step with the old parse. */
+        if (p >= len) break;
+        if (p >= hi && keep < doc->form_count && doc->forms[keep].start == p)
+            break;
+        LSP_GROW(fresh, n, cap, LspForm);
+        fresh[n].start = p;
+        fresh[n].end   = p = form_scan(s, len, p);
+        n++;
+    }
+
+    size_t tail = doc->form_count - keep;
+    size_t need = first + n + tail;
+    if (need > doc->form_cap) {
+        doc->form_cap = need;
+        doc->forms    = lsp_xrealloc(doc->forms, need * sizeof(LspForm));
+    }
+    if (tail) memmove(doc->forms + first + n, doc->forms + keep, tail * sizeof(LspForm));
+    if (n) memcpy(doc->forms + first, fresh, n * sizeof(LspForm));
+    free(fresh);
+
+    doc->form_count      = need;
+    doc->forms_rescanned = n;
+    doc->reparse_lo      = UINT32_MAX;
+    doc->reparse_hi      = 0;
+}
+
+static void document_mark_forms(LspDocument *doc, uint32_t start, uint32_t end,
+                                uint32_t n)
+{
+    int64_t delta = (int64_t)n - (int64_t)(end - start);
+
+    /* Carry an earlier pending span through this edit. */
+    uint32_t lo = start, hi = start + n;
+    if (doc->reparse_lo <= doc->reparse_hi) {
+        uint32_t plo = doc->reparse_lo, phi = doc->reparse_hi;
+        plo = plo <= start ? plo : plo >= end ? (uint32_t)(plo + delta) : start;
+        phi = phi <  start ? phi : phi >= end ? (uint32_t)(phi + delta) : start + n;
+        if (plo < lo) lo = plo;
+        if (phi > hi) hi = phi;
+    }
+
+    /* Drop every form the edit touches; shift the ones after it. */
+    size_t w = 0;
+    for (size_t i = 0; i < doc->form_count; i++) {
+        LspForm f = doc->forms[i];
+        if (f.end + LSP_FORM_LOOKAHEAD < start) {
+            doc->forms[w++] = f;
+        } else if (f.start > end) {
+            f.start = (uint32_t)(f.start + delta);
+            f.end   = (uint32_t)(f.end + delta);
+            doc->forms[w++] = f;
+        } else {
+            if (f.start < lo) lo = f.start;
+            if ((uint32_t)(f.end + delta) > hi) hi = (uint32_t)(f.end + delta);
+        }
+    }
+    doc->form_count = w;
+    doc->reparse_lo = lo;
+    doc->reparse_hi = hi;
+}
+
+// Apply one contentChanges entry.  The range is in the document's current
+// coordinates, i.e. after any earlier change in the same notification.
+void lsp_document_edit(LspDocument *doc, LspRange range, const char *text)
+{
+    uint32_t start = rope_offset(doc->rope, range.start);
+    uint32_t end   = rope_offset(doc->rope, range.end);
+    if (end < start) { uint32_t t = start; start = end; end = t; }
+
+    uint32_t n = (uint32_t)strlen(text ? text : "");
+    doc->rope = rope_splice(doc->rope, start, end, text, n);
+    document_mark_forms(doc, start, end, n);
+    doc->source_stale = true;
+    doc->state        = LSP_DOC_DIRTY;
+}
+
+// Bring source, the line index and the form table up to date with the rope.
+void lsp_document_sync(LspDocument *doc)
+{
+    if (doc->source_stale) {
+        uint32_t len = doc->rope ? doc->rope->len : 0;
+        free(doc->source);
+        doc->source = lsp_xmalloc((size_t)len + 1);
+        rope_copy(doc->rope, 0, len, doc->source);
+        doc->source[len]  = '\0';
+        doc->source_len   = len;
+        doc->source_stale = false;
+        lsp_document_build_line_index(doc);
+    }
+    document_rescan_forms(doc);
+}
+
 void lsp_document_add_diagnostic(LspDocument *doc, LspDiagnostic diag)
 {
     LSP_GROW(doc->diagnostics, doc->diag_count, doc->diag_cap, LspDiagnostic);
@@ -1148,6 +1596,7 @@ void lsp_document_clear_diagnostics(LspDocument *doc)
 void lsp_document_analyze(LspDocument *doc)
 {
     if (!doc || !doc->workspace) return;
+    lsp_document_sync(doc);
     doc->state = LSP_DOC_ANALYZING;
 
     LspAnalysisResult *r = lsp_analyze_file(doc->path, doc->source,
@@ -1186,6 +1635,8 @@ void lsp_document_free(LspDocument *doc)
     free(doc->folds);
 
     free(doc->line_offsets);
+    rope_free(doc->rope);
+    free(doc->forms);
     free(doc);
 }
 
@@ -1202,6 +1653,10 @@ void lsp_document_free(LspDocument *doc)
  //  Fuzzy matching uses a simple subsequence filter followed by a
  //  Levenshtein-distance sort.
  //
+ //  The table holds the files indexed in this session.  Queries fall
+ //  through to the persistent index (see "Persistent index" below) for
+ //  every other file of the workspace.
+ //
 static uint32_t fnv1a(const char *s)
 {
     uint32_t h = 2166136261u;
@@ -1212,6 +1667,18 @@ static uint32_t fnv1a(const char *s)
     return h;
 }
 
+typedef struct LspStore LspStore;
+static void           store_close(LspStore *st);
+static void           store_set_shadow(LspStore *st, const char *uri, bool on);
+static LspIndexEntry *store_lookup(LspStore *st, const char *name);
+static void           store_prefix(LspStore *st, const char *prefix,
+                                   LspIndexEntry ***out, size_t *count, size_t *cap);
+static void           store_fuzzy(LspStore *st, const char *query,
+                                  LspIndexEntry ***out, size_t *count, size_t *cap);
+static void           store_references(const LspStore *st, const char *name,
+                                       LspLocation **out, size_t *count, size_t *cap);
+static void           index_file_free(LspIndexFile *f);
+
 LspIndex *lsp_index_create(void)
 {
     LspIndex *idx = lsp_xcalloc(1, sizeof(*idx));
@@ -1268,7 +1735,7 @@ LspIndexEntry *lsp_index_lookup(LspIndex *idx, const char *name)
         if (strcmp(e->name, name) == 0)
             return e;
     }
-    return NULL;
+    return store_lookup(idx->store, name);
 }
 
 static int entry_name_cmp(const void *a, const void *b)
@@ -1312,6 +1779,7 @@ LspIndexEntry **lsp_index_prefix(LspIndex *idx, const char *prefix,
         LSP_GROW(results, *count, cap, LspIndexEntry *);
         results[(*count)++] = idx->sorted[i];
     }
+    store_prefix(idx->store, prefix, &results, count, &cap);
     return results;
 }
 
@@ -1346,10 +1814,34 @@ LspIndexEntry **lsp_index_fuzzy(LspIndex *idx, const char *query, size_t *count)
             }
         }
     }
+    store_fuzzy(idx->store, query, &results, count, &cap);
 done:
     return results;
 }
 
+// Every recorded use of name across the workspace, declarations excluded.
+LspLocation *lsp_index_references(LspIndex *idx, const char *name, size_t *count)
+{
+    *count = 0;
+    if (!name) return NULL;
+
+    size_t       cap  = 16;
+    LspLocation *locs = lsp_xmalloc(cap * sizeof(LspLocation));
+    for (size_t f = 0; f < idx->file_count; f++) {
+        const LspIndexFile *file = &idx->files[f];
+        for (size_t i = 0; i < file->ref_count && *count < LSP_MAX_REFERENCES; i++) {
+            if (strcmp(file->refs[i].name, name) != 0) continue;
+            LSP_GROW(locs, *count, cap, LspLocation);
+            locs[*count].uri   = lsp_xstrdup(file->uri);
+            locs[*count].range = file->refs[i].range;
+            (*count)++;
+        }
+    }
+    store_references(idx->store, name, &locs, count, &cap);
+    if (*count == 0) { free(locs); return NULL; }
+    return locs;
+}
+
 void lsp_index_remove_file(LspIndex *idx, const char *uri)
 {
     for (size_t b = 0; b < LSP_INDEX_BUCKETS; b++) {
@@ -1373,6 +1865,13 @@ void lsp_index_remove_file(LspIndex *idx, const char *uri)
             }
         }
     }
+    for (size_t i = 0; i < idx->file_count; i++) {
+        if (strcmp(idx->files[i].uri, uri) != 0) continue;
+        index_file_free(&idx->files[i]);
+        idx->files[i] = idx->files[--idx->file_count];
+        store_set_shadow(idx->store, uri, false);
+        break;
+    }
 }
 
 void lsp_index_free(LspIndex *idx)
@@ -1387,10 +1886,970 @@ void lsp_index_free(LspIndex *idx)
         }
     }
     free(idx->sorted);
+    for (size_t i = 0; i < idx->file_count; i++)
+        index_file_free(&idx->files[i]);
+    free(idx->files);
+    store_close(idx->store);
     free(idx);
 }
 
 
+//// Declaration scanner
+ //
+ //  lsp_index_scan_source() indexes one file without running the compiler.
+ //  A top-level form that starts in column 0 with define, data, type,
+ //  newtype or class, bracketed or wisp, defines the name that follows its
+ //  head; every other identifier outside strings and comments is recorded
+ //  as a reference.  Names are unqualified, like the words
+ //  lsp_document_word_at() returns, and a `module` line sets the module of
+ //  every entry in the file.
+ //
+static uint64_t hash_bytes(const char *s, size_t n)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint64_t)(unsigned char)s[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static LspIndexFile *index_find_file(LspIndex *idx, const char *uri)
+{
+    for (size_t i = 0; i < idx->file_count; i++)
+        if (strcmp(idx->files[i].uri, uri) == 0) return &idx->files[i];
+    return NULL;
+}
+
+static void index_file_free(LspIndexFile *f)
+{
+    for (size_t i = 0; i < f->ref_count; i++) free(f->refs[i].name);
+    free(f->refs);
+    free(f->uri);
+}
+
+typedef struct ScanCursor {
+    const char *s;
+    uint32_t    line;         /* line that starts at line_start */
+    uint32_t    line_start;
+} ScanCursor;
+
+// Position of byte p, which must not precede the cursor's line.
+static LspPosition scan_position(ScanCursor *c, uint32_t p)
+{
+    const char *nl;
+    while (p > c->line_start &&
+           (nl = memchr(c->s + c->line_start, '\n', p - c->line_start))) {
+        c->line++;
+        c->line_start = (uint32_t)(nl - c->s) + 1;
+    }
+    LspPosition pos = { c->line,
+                        lsp_utf8_to_utf16(c->s + c->line_start, p - c->line_start) };
+    return pos;
+}
+
+static LspSymbolKind scan_def_kind(const char *w, size_t n)
+{
+    if (n == 6 && memcmp(w, "define", 6) == 0)  return LSP_SYMBOL_FUNCTION;
+    if (n == 4 && memcmp(w, "data", 4) == 0)    return LSP_SYMBOL_ENUM;
+    if (n == 4 && memcmp(w, "type", 4) == 0)    return LSP_SYMBOL_STRUCT;
+    if (n == 7 && memcmp(w, "newtype", 7) == 0) return LSP_SYMBOL_STRUCT;
+    if (n == 5 && memcmp(w, "class", 5) == 0)   return LSP_SYMBOL_INTERFACE;
+    return 0;
+}
+
+static bool scan_is_keyword(const char *w, size_t n)
+{
+    size_t count;
+    const char **kw = lsp_keywords(&count);
+    for (size_t i = 0; i < count; i++)
+        if (strlen(kw[i]) == n && memcmp(kw[i], w, n) == 0) return true;
+    return scan_def_kind(w, n) != 0;
+}
+
+// End of the definition starting at p: its bracketed form, or a wisp line
+// and the indented lines under it, up to the last non-blank one.
+static uint32_t scan_def_end(const char *s, uint32_t len, uint32_t p)
+{
+    if (s[p] == '(' || s[p] == '[') return form_scan(s, len, p);
+    uint32_t end = p;
+    for (uint32_t q = p; q < len; ) {
+        uint32_t eol = q;
+        while (eol < len && s[eol] != '\n') eol++;
+        uint32_t k = q;
+        while (k < eol && isspace((unsigned char)s[k])) k++;
+        if (q > p && k == q && k < eol) break;    /* next column-0 form */
+        if (k < eol) end = eol;
+        q = eol + 1;
+    }
+    return end;
+}
+
+// The ';' lines directly above the line starting at p, semicolons dropped.
+static char *scan_doc_comment(const char *s, uint32_t p)
+{
+    uint32_t top = p;
+    while (top > 0) {
+        uint32_t ls = top - 1;
+        while (ls > 0 && s[ls - 1] != '\n') ls--;
+        if (s[ls] != ';') break;
+        top = ls;
+    }
+    if (top == p) return NULL;
+
+    char  *doc = lsp_xmalloc(p - top + 1);
+    size_t n   = 0;
+    for (uint32_t q = top; q < p; ) {
+        while (s[q] == ';') q++;
+        if (s[q] == ' ') q++;
+        uint32_t eol = q;
+        while (eol < p && s[eol] != '\n') eol++;
+        if (n) doc[n++] = '\n';
+        memcpy(doc + n, s + q, eol - q);
+        n += eol - q;
+        q = eol + 1;
+    }
+    doc[n] = '\0';
+    return doc;
+}
+
+// `name :: T` or `[name :: T]` after a defined name: T, trimmed.
+static char *scan_type_sig(const char *s, uint32_t len, uint32_t p, char closer)
+{
+    while (p < len && (s[p] == ' ' || s[p] == '\t')) p++;
+    if (p + 1 >= len || s[p] != ':' || s[p + 1] != ':') return NULL;
+    p += 2;
+    while (p < len && (s[p] == ' ' || s[p] == '\t')) p++;
+    uint32_t e = p;
+    while (e < len && s[e] != '\n' && s[e] != closer && s[e] != ';') e++;
+    while (e > p && isspace((unsigned char)s[e - 1])) e--;
+    return e > p ? lsp_xstrndup(s + p, e - p) : NULL;
+}
+
+void lsp_index_scan_source(LspIndex *idx, const char *uri,
+                           const char *source, size_t len)
+{
+    if (index_find_file(idx, uri)) lsp_index_remove_file(idx, uri);
+    LSP_GROW(idx->files, idx->file_count, idx->file_cap, LspIndexFile);
+    LspIndexFile *file = &idx->files[idx->file_count++];
+    memset(file, 0, sizeof(*file));
+    file->uri  = lsp_xstrdup(uri);
+    file->hash = hash_bytes(source, len);
+    store_set_shadow(idx->store, uri, true);
+
+    const char *s = source;
+    uint32_t    n = (uint32_t)len;
+    ScanCursor  cur = { s, 0, 0 };
+
+    LspIndexEntry **mine = NULL;
+    size_t          mine_count = 0, mine_cap = 0;
+    char           *module = NULL;
+
+    uint32_t      form_start = 0;
+    LspSymbolKind def_kind   = 0;
+    char          opener     = 0;   /* bracket between head and name */
+    bool          head_next = false, name_next = false, module_next = false;
+
+    for (uint32_t p = 0; p < n; ) {
+        char c = s[p];
+        if (c == ';') {
+            while (p < n && s[p] != '\n') p++;
+            continue;
+        }
+        if (c == '"') {
+            for (p++; p < n && s[p] != '"'; p++)
+                if (s[p] == '\\') p++;
+            p = p < n ? p + 1 : n;
+            head_next = name_next = false;
+            continue;
+        }
+        if (c == '\'' && p + 2 < n) {
+            uint32_t q = p + 1;
+            if (s[q] == '\\')
+                for (q += 2; q < n && q < p + LSP_FORM_LOOKAHEAD && s[q] != '\''; q++) {}
+            else
+                q++;
+            if (q < n && s[q] == '\'') { p = q + 1; continue; }
+        }
+        if ((p == 0 || s[p - 1] == '\n') && !isspace((unsigned char)c)) {
+            form_start = p;
+            head_next  = true;
+            name_next  = module_next = false;
+        }
+
+        if (!is_ident_start(c)) {
+            if ((c == '(' || c == '[') && (name_next || p == form_start))
+                opener = c;
+            else if (!isspace((unsigned char)c))
+                head_next = name_next = false;
+            p++;
+            continue;
+        }
+
+        uint32_t e = p;
+        while (e < n && is_ident_char(s[e])) e++;
+        size_t wl = e - p;
+
+        if (head_next) {
+            head_next = false;
+            def_kind  = scan_def_kind(s + p, wl);
+            name_next = def_kind != 0;
+            opener    = 0;
+            module_next = wl == 6 && memcmp(s + p, "module", 6) == 0;
+            p = e;
+            continue;
+        }
+        if (name_next) {
+            name_next = false;
+            LspIndexEntry *en = lsp_index_entry_create();
+            en->name        = lsp_xstrndup(s + p, wl);
+            en->short_name  = lsp_xstrdup(en->name);
+            en->uri         = lsp_xstrdup(uri);
+            en->range.start = scan_position(&cur, form_start);
+            en->name_range.start = scan_position(&cur, p);
+            en->name_range.end   = scan_position(&cur, e);
+            ScanCursor ahead = cur;
+            en->range.end   = scan_position(&ahead, scan_def_end(s, n, form_start));
+            en->type_sig      = scan_type_sig(s, n, e, opener == '[' ? ']' : '\n');
+            en->documentation = scan_doc_comment(s, form_start);
+            en->kind = def_kind;
+            if (def_kind == LSP_SYMBOL_FUNCTION && opener != '(' &&
+                !(en->type_sig && (strstr(en->type_sig, "->") ||
+                                   strstr(en->type_sig, "\xe2\x86\x92"))))
+                en->kind = LSP_SYMBOL_VARIABLE;
+            lsp_index_insert(idx, en);
+            LSP_GROW(mine, mine_count, mine_cap, LspIndexEntry *);
+            mine[mine_count++] = en;
+            p = e;
+            continue;
+        }
+        if (module_next) {
+            module_next = false;
+            free(module);
+            module = lsp_xstrndup(s + p, wl);
+        }
+        if (!scan_is_keyword(s + p, wl)) {
+            LSP_GROW(file->refs, file->ref_count, file->ref_cap, LspIndexRef);
+            LspIndexRef *r = &file->refs[file->ref_count++];
+            r->name        = lsp_xstrndup(s + p, wl);
+            r->range.start = scan_position(&cur, p);
+            r->range.end   = scan_position(&cur, e);
+        }
+        p = e;
+    }
+
+    for (size_t i = 0; module && i < mine_count; i++)
+        mine[i]->module = lsp_xstrdup(module);
+    free(module);
+    free(mine);
+}
+
+
+//// Persistent index
+ //
+ //  The workspace index outlives the server in one file per workspace,
+ //  mapped read-only on startup so queries are answered before any file is
+ //  rescanned.  Records are fixed-size and host-endian, strings are offsets
+ //  into a pool whose first byte is NUL (offset 0 is "no string"), and each
+ //  table is sorted for binary search:
+ //
+ //    header    magic, version, counts, section offsets, total size
+ //    files     uri, content hash, mtime, size            (by uri)
+ //    symbols   one per definition, with a character mask  (by name)
+ //    refs      identifier occurrences             (by name, file, position)
+ //    trigrams  lower-cased name trigram -> run of postings  (by trigram)
+ //    postings  symbol indices, ascending within a run
+ //    strings
+ //
+ //  A wrong magic or version, a size mismatch or any index out of range
+ //  makes lsp_index_open() fail, and the next refresh rewrites the file.
+ //  Entries for on-disk symbols are built on first use and owned by the
+ //  store, so they stay valid until the index is reopened.
+ //
+#define LSP_STORE_MAGIC   "MONADIDX"
+#define LSP_STORE_VERSION 1u
+#define LSP_STORE_DROP    INT64_MIN
+
+typedef struct LspStoreHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t file_count, sym_count, ref_count, tri_count, post_count;
+    uint32_t files_off, syms_off, refs_off, tris_off, posts_off;
+    uint32_t strings_off, strings_len;
+    uint64_t total_size;
+} LspStoreHeader;
+
+typedef struct LspStoreFile {
+    uint32_t uri, reserved;
+    uint64_t hash;
+    int64_t  mtime, size;
+} LspStoreFile;
+
+typedef struct LspStoreSym {
+    uint32_t name, module, type_sig, doc, file, kind;
+    LspRange range, name_range;
+    uint64_t mask;      /* characters present in the lower-cased name */
+} LspStoreSym;
+
+typedef struct LspStoreRef {
+    uint32_t name, file;
+    LspRange range;
+} LspStoreRef;
+
+typedef struct LspStoreTri {
+    uint32_t key, first, count;
+} LspStoreTri;
+
+typedef struct LspStore {
+    const unsigned char  *data;
+    size_t                size;
+    bool                  mapped;
+    const LspStoreHeader *hdr;
+    const LspStoreFile   *files;
+    const LspStoreSym    *syms;
+    const LspStoreRef    *refs;
+    const LspStoreTri    *tris;
+    const uint32_t       *posts;
+    const char           *strings;
+    bool                 *shadow;    /* per file: indexed in memory instead */
+    LspIndexEntry       **entries;   /* per symbol, built lazily            */
+} LspStore;
+
+static const char *store_str(const LspStore *st, uint32_t off)
+{
+    return st->strings + off;
+}
+
+static void store_release(const unsigned char *data, size_t size, bool mapped)
+{
+#if !defined(_WIN32)
+    if (mapped) munmap((void *)data, size);
+    else
+#endif
+    free((void *)data);
+    (void)size; (void)mapped;
+}
+
+static void store_close(LspStore *st)
+{
+    if (!st) return;
+    for (uint32_t i = 0; i < st->hdr->sym_count; i++)
+        lsp_index_entry_free(st->entries[i]);
+    free(st->entries);
+    free(st->shadow);
+    store_release(st->data, st->size, st->mapped);
+    free(st);
+}
+
+static bool store_section_ok(size_t size, uint32_t off, uint32_t count,
+                             size_t rec)
+{
+    return off % 8 == 0 && off <= size && count <= (size - off) / rec;
+}
+
+static bool store_check(const unsigned char *data, size_t size)
+{
+    const LspStoreHeader *h = (const LspStoreHeader *)data;
+    if (size < sizeof(*h) || memcmp(h->magic, LSP_STORE_MAGIC, 8) != 0 ||
+        h->version != LSP_STORE_VERSION || h->total_size != size)
+        return false;
+    if (!store_section_ok(size, h->files_off, h->file_count, sizeof(LspStoreFile)) ||
+        !store_section_ok(size, h->syms_off,  h->sym_count,  sizeof(LspStoreSym))  ||
+        !store_section_ok(size, h->refs_off,  h->ref_count,  sizeof(LspStoreRef))  ||
+        !store_section_ok(size, h->tris_off,  h->tri_count,  sizeof(LspStoreTri))  ||
+        !store_section_ok(size, h->posts_off, h->post_count, sizeof(uint32_t))     ||
+        !store_section_ok(size, h->strings_off, h->strings_len, 1))
+        return false;
+
+    uint32_t sl = h->strings_len;
+    const char *strings = (const char *)data + h->strings_off;
+    if (sl == 0 || strings[0] != '\0' || strings[sl - 1] != '\0') return false;
+
+    const LspStoreFile *files = (const void *)(data + h->files_off);
+    for (uint32_t i = 0; i < h->file_count; i++)
+        if (files[i].uri >= sl) return false;
+    const LspStoreSym *syms = (const void *)(data + h->syms_off);
+    for (uint32_t i = 0; i < h->sym_count; i++) {
+        const LspStoreSym *y = &syms[i];
+        if (y->name >= sl || y->module >= sl || y->type_sig >= sl ||
+            y->doc >= sl || y->file >= h->file_count)
+            return false;
+    }
+    const LspStoreRef *refs = (const void *)(data + h->refs_off);
+    for (uint32_t i = 0; i < h->ref_count; i++)
+        if (refs[i].name >= sl || refs[i].file >= h->file_count) return false;
+    const LspStoreTri *tris = (const void *)(data + h->tris_off);
+    for (uint32_t i = 0; i < h->tri_count; i++)
+        if (tris[i].first > h->post_count ||
+            tris[i].count > h->post_count - tris[i].first)
+            return false;
+    const uint32_t *posts = (const void *)(data + h->posts_off);
+    for (uint32_t i = 0; i < h->post_count; i++)
+        if (posts[i] >= h->sym_count) return false;
+    return true;
+}
+
+static LspStore *store_open(const char *path)
+{
+    const unsigned char *data = NULL;
+    size_t size   = 0;
+    bool   mapped = false;
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void *p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data   = p;
+            size   = (size_t)sb.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+#endif
+    if (!data) {
+        FILE *fp = fopen(path, "rb");
+        if (!fp) return NULL;
+        fseek(fp, 0, SEEK_END);
+        long sz = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        unsigned char *buf = sz > 0 ? malloc((size_t)sz) : NULL;
+        size_t n = buf ? fread(buf, 1, (size_t)sz, fp) : 0;
+        fclose(fp);
+        if (!buf || n != (size_t)sz) { free(buf); return NULL; }
+        data = buf;
+        size = n;
+    }
+
+    if (!store_check(data, size)) {
+        store_release(data, size, mapped);
+        return NULL;
+    }
+    LspStore *st = lsp_xcalloc(1, sizeof(*st));
+    st->data   = data;
+    st->size   = size;
+    st->mapped = mapped;
+    const LspStoreHeader *h = st->hdr = (const LspStoreHeader *)data;
+    st->files   = (const void *)(data + h->files_off);
+    st->syms    = (const void *)(data + h->syms_off);
+    st->refs    = (const void *)(data + h->refs_off);
+    st->tris    = (const void *)(data + h->tris_off);
+    st->posts   = (const void *)(data + h->posts_off);
+    st->strings = (const char *)data + h->strings_off;
+    st->shadow  = lsp_xcalloc(h->file_count + 1, sizeof(bool));
+    st->entries = lsp_xcalloc(h->sym_count + 1, sizeof(LspIndexEntry *));
+    return st;
+}
+
+static int64_t store_find_file(const LspStore *st, const char *uri)
+{
+    if (!st) return -1;
+    size_t lo = 0, hi = st->hdr->file_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = strcmp(store_str(st, st->files[mid].uri), uri);
+        if (c == 0) return (int64_t)mid;
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return -1;
+}
+
+static void store_set_shadow(LspStore *st, const char *uri, bool on)
+{
+    int64_t f = store_find_file(st, uri);
+    if (f >= 0) st->shadow[f] = on;
+}
+
+static LspIndexEntry *store_entry(LspStore *st, uint32_t i)
+{
+    if (st->entries[i]) return st->entries[i];
+    const LspStoreSym *y = &st->syms[i];
+    LspIndexEntry *e = lsp_index_entry_create();
+    e->name          = lsp_xstrdup(store_str(st, y->name));
+    e->short_name    = lsp_xstrdup(e->name);
+    e->uri           = lsp_xstrdup(store_str(st, st->files[y->file].uri));
+    e->range         = y->range;
+    e->name_range    = y->name_range;
+    e->kind          = (LspSymbolKind)y->kind;
+    if (y->module)   e->module        = lsp_xstrdup(store_str(st, y->module));
+    if (y->type_sig) e->type_sig      = lsp_xstrdup(store_str(st, y->type_sig));
+    if (y->doc)      e->documentation = lsp_xstrdup(store_str(st, y->doc));
+    return st->entries[i] = e;
+}
+
+// First symbol whose name is not below key in its first n bytes.
+static uint32_t store_sym_bound(const LspStore *st, const char *key, size_t n)
+{
+    uint32_t lo = 0, hi = st->hdr->sym_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (strncmp(store_str(st, st->syms[mid].name), key, n) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static LspIndexEntry *store_lookup(LspStore *st, const char *name)
+{
+    if (!st) return NULL;
+    size_t n = strlen(name) + 1;
+    for (uint32_t i = store_sym_bound(st, name, n); i < st->hdr->sym_count; i++) {
+        if (strcmp(store_str(st, st->syms[i].name), name) != 0) break;
+        if (!st->shadow[st->syms[i].file]) return store_entry(st, i);
+    }
+    return NULL;
+}
+
+static void store_prefix(LspStore *st, const char *prefix,
+                         LspIndexEntry ***out, size_t *count, size_t *cap)
+{
+    if (!st) return;
+    size_t n = strlen(prefix);
+    for (uint32_t i = store_sym_bound(st, prefix, n); i < st->hdr->sym_count; i++) {
+        if (strncmp(store_str(st, st->syms[i].name), prefix, n) != 0) break;
+        if (st->shadow[st->syms[i].file]) continue;
+        LSP_GROW(*out, *count, *cap, LspIndexEntry *);
+        (*out)[(*count)++] = store_entry(st, i);
+    }
+}
+
+static uint64_t name_mask(const char *s)
+{
+    uint64_t m = 0;
+    for (; *s; s++) {
+        unsigned c = (unsigned)tolower((unsigned char)*s);
+        if (c >= 'a' && c <= 'z')      m |= 1ull << (c - 'a');
+        else if (c >= '0' && c <= '9') m |= 1ull << (26 + c - '0');
+        else                           m |= 1ull << (36 + c % 28);
+    }
+    return m;
+}
+
+static uint32_t trigram_key(const char *s)
+{
+    return (uint32_t)tolower((unsigned char)s[0]) << 16 |
+           (uint32_t)tolower((unsigned char)s[1]) << 8  |
+           (uint32_t)tolower((unsigned char)s[2]);
+}
+
+static const LspStoreTri *store_trigram(const LspStore *st, uint32_t key)
+{
+    uint32_t lo = 0, hi = st->hdr->tri_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (st->tris[mid].key == key) return &st->tris[mid];
+        if (st->tris[mid].key < key) lo = mid + 1; else hi = mid;
+    }
+    return NULL;
+}
+
+static bool posting_has(const LspStore *st, const LspStoreTri *t, uint32_t sym)
+{
+    const uint32_t *p = st->posts + t->first;
+    uint32_t lo = 0, hi = t->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (p[mid] == sym) return true;
+        if (p[mid] < sym) lo = mid + 1; else hi = mid;
+    }
+    return false;
+}
+
+// Names holding every trigram of the query come first; they are the
+// substring matches.  The rest of the subsequence matches follow, found
+// by a scan that the character mask keeps to a word test per symbol.
+static void store_fuzzy(LspStore *st, const char *query,
+                        LspIndexEntry ***out, size_t *count, size_t *cap)
+{
+    if (!st || *count >= LSP_MAX_COMPLETIONS) return;
+    uint32_t nsym = st->hdr->sym_count;
+    bool    *seen = lsp_xcalloc(nsym + 1, sizeof(bool));
+    size_t   qlen = strlen(query);
+
+    if (qlen >= 3) {
+        const LspStoreTri *rare = NULL;
+        bool               none = false;
+        for (size_t i = 0; i + 3 <= qlen && !none; i++) {
+            const LspStoreTri *t = store_trigram(st, trigram_key(query + i));
+            if (!t) none = true;
+            else if (!rare || t->count < rare->count) rare = t;
+        }
+        for (uint32_t k = 0; !none && rare && k < rare->count; k++) {
+            uint32_t sym = st->posts[rare->first + k];
+            bool hit = !st->shadow[st->syms[sym].file];
+            for (size_t i = 0; hit && i + 3 <= qlen; i++)
+                hit = posting_has(st, store_trigram(st, trigram_key(query + i)), sym);
+            if (!hit || !is_subsequence(store_str(st, st->syms[sym].name), query))
+                continue;
+            seen[sym] = true;
+            LSP_GROW(*out, *count, *cap, LspIndexEntry *);
+            (*out)[(*count)++] = store_entry(st, sym);
+            if (*count >= LSP_MAX_COMPLETIONS) goto done;
+        }
+    }
+
+    uint64_t qmask = name_mask(query);
+    for (uint32_t i = 0; i < nsym; i++) {
+        const LspStoreSym *y = &st->syms[i];
+        if (seen[i] || (qmask & ~y->mask) || st->shadow[y->file]) continue;
+        if (!is_subsequence(store_str(st, y->name), query)) continue;
+        LSP_GROW(*out, *count, *cap, LspIndexEntry *);
+        (*out)[(*count)++] = store_entry(st, i);
+        if (*count >= LSP_MAX_COMPLETIONS) break;
+    }
+done:
+    free(seen);
+}
+
+static void store_references(const LspStore *st, const char *name,
+                             LspLocation **out, size_t *count, size_t *cap)
+{
+    if (!st) return;
+    uint32_t lo = 0, hi = st->hdr->ref_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (strcmp(store_str(st, st->refs[mid].name), name) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    for (uint32_t i = lo; i < st->hdr->ref_count && *count < LSP_MAX_REFERENCES; i++) {
+        const LspStoreRef *r = &st->refs[i];
+        if (strcmp(store_str(st, r->name), name) != 0) break;
+        if (st->shadow[r->file]) continue;
+        LSP_GROW(*out, *count, *cap, LspLocation);
+        (*out)[*count].uri   = lsp_xstrdup(store_str(st, st->files[r->file].uri));
+        (*out)[*count].range = r->range;
+        (*count)++;
+    }
+}
+
+//// Persistent index writer
+ //
+ //  store_write() merges the records of old the caller keeps with every
+ //  scanned file of fresh, interning strings into one pool, and replaces
+ //  path atomically through a temporary file.  keep[i] is the mtime to
+ //  record for old file i, or LSP_STORE_DROP.
+ //
+typedef struct StorePool {
+    char     *buf;
+    size_t    len, cap;
+    uint32_t *slots;    /* offset + 1, open addressing */
+    size_t    slot_cap, used;
+} StorePool;
+
+static uint32_t pool_add(StorePool *p, const char *s)
+{
+    if (!s || !*s) return 0;
+    if ((p->used + 1) * 2 > p->slot_cap) {
+        size_t    ncap  = p->slot_cap ? p->slot_cap * 2 : 1024;
+        uint32_t *slots = lsp_xcalloc(ncap, sizeof(uint32_t));
+        for (size_t i = 0; i < p->slot_cap; i++) {
+            if (!p->slots[i]) continue;
+            size_t j = fnv1a(p->buf + p->slots[i] - 1) & (ncap - 1);
+            while (slots[j]) j = (j + 1) & (ncap - 1);
+            slots[j] = p->slots[i];
+        }
+        free(p->slots);
+        p->slots    = slots;
+        p->slot_cap = ncap;
+    }
+    size_t j = fnv1a(s) & (p->slot_cap - 1);
+    for (; p->slots[j]; j = (j + 1) & (p->slot_cap - 1))
+        if (strcmp(p->buf + p->slots[j] - 1, s) == 0) return p->slots[j] - 1;
+
+    size_t n = strlen(s) + 1;
+    while (p->len + n > p->cap) {
+        p->cap = p->cap ? p->cap * 2 : 4096;
+        p->buf = lsp_xrealloc(p->buf, p->cap);
+    }
+    uint32_t off = (uint32_t)p->len;
+    memcpy(p->buf + p->len, s, n);
+    p->len += n;
+    p->slots[j] = off + 1;
+    p->used++;
+    return off;
+}
+
+typedef struct StoreFileRow {
+    LspStoreFile rec;
+    const char  *uri;
+    int64_t      old;     /* index in the old store, or -1 */
+    int64_t      fresh;   /* index in fresh->files, or -1  */
+} StoreFileRow;
+
+static int file_row_cmp(const void *a, const void *b)
+{
+    const StoreFileRow *x = a, *y = b;
+    int c = strcmp(x->uri, y->uri);
+    return c ? c : (x->fresh >= 0) - (y->fresh >= 0);   /* fresh last */
+}
+
+typedef struct SortedSym { const char *key; LspStoreSym rec; } SortedSym;
+typedef struct SortedRef { const char *key; LspStoreRef rec; } SortedRef;
+
+typedef struct UriSlot { const char *uri; size_t at; } UriSlot;
+
+static int uri_slot_cmp(const void *a, const void *b)
+{
+    return strcmp(((const UriSlot *)a)->uri, ((const UriSlot *)b)->uri);
+}
+
+static int sym_cmp(const void *a, const void *b)
+{
+    const SortedSym *x = a, *y = b;
+    int c = strcmp(x->key, y->key);
+    if (c) return c;
+    if (x->rec.file != y->rec.file) return x->rec.file < y->rec.file ? -1 : 1;
+    return (x->rec.range.start.line > y->rec.range.start.line) -
+           (x->rec.range.start.line < y->rec.range.start.line);
+}
+
+static int ref_cmp(const void *a, const void *b)
+{
+    const SortedRef *x = a, *y = b;
+    int c = strcmp(x->key, y->key);
+    if (c) return c;
+    const LspRange *p = &x->rec.range, *q = &y->rec.range;
+    if (x->rec.file != y->rec.file) return x->rec.file < y->rec.file ? -1 : 1;
+    if (p->start.line != q->start.line) return p->start.line < q->start.line ? -1 : 1;
+    return (p->start.character > q->start.character) -
+           (p->start.character < q->start.character);
+}
+
+static int u64_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t store_align(size_t n) { return (uint32_t)((n + 7) & ~(size_t)7); }
+
+static bool store_write(const char *path, const LspStore *old,
+                        const int64_t *keep, LspIndex *fresh)
+{
+    StorePool pool = {0};
+    pool.buf = lsp_xmalloc(pool.cap = 4096);
+    pool.buf[pool.len++] = '\0';
+
+    /* Files: rows from both sides, sorted by uri; a fresh scan of a uri
+       replaces the old record. */
+    size_t nold = old ? old->hdr->file_count : 0;
+    StoreFileRow *rows = lsp_xmalloc((nold + fresh->file_count + 1) * sizeof(*rows));
+    size_t nrows = 0;
+    for (size_t i = 0; i < nold; i++) {
+        if (keep[i] == LSP_STORE_DROP) continue;
+        StoreFileRow *r = &rows[nrows++];
+        r->rec       = old->files[i];
+        r->rec.mtime = keep[i];
+        r->uri       = store_str(old, old->files[i].uri);
+        r->old = (int64_t)i; r->fresh = -1;
+    }
+    for (size_t i = 0; i < fresh->file_count; i++) {
+        StoreFileRow *r = &rows[nrows++];
+        memset(&r->rec, 0, sizeof(r->rec));
+        r->rec.hash  = fresh->files[i].hash;
+        r->rec.mtime = fresh->files[i].mtime;
+        r->rec.size  = fresh->files[i].size;
+        r->uri       = fresh->files[i].uri;
+        r->old = -1; r->fresh = (int64_t)i;
+    }
+    qsort(rows, nrows, sizeof(*rows), file_row_cmp);
+
+    uint32_t *old_map   = lsp_xmalloc((nold + 1) * sizeof(uint32_t));
+    uint32_t *fresh_map = lsp_xmalloc((fresh->file_count + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < nold; i++) old_map[i] = UINT32_MAX;
+    size_t nfiles = 0;
+    for (size_t i = 0; i < nrows; i++) {
+        if (i + 1 < nrows && strcmp(rows[i].uri, rows[i + 1].uri) == 0)
+            continue;                       /* superseded by the next row */
+        rows[nfiles] = rows[i];
+        if (rows[nfiles].old >= 0) old_map[rows[nfiles].old] = (uint32_t)nfiles;
+        else fresh_map[rows[nfiles].fresh] = (uint32_t)nfiles;
+        rows[nfiles].rec.uri = pool_add(&pool, rows[nfiles].uri);
+        nfiles++;
+    }
+
+    /* Symbols and references, strings interned as they are copied. */
+    LspStoreSym *syms = NULL;
+    size_t       nsyms = 0, sym_cap = 0;
+    LspStoreRef *refs = NULL;
+    size_t       nrefs = 0, ref_cap = 0;
+    for (uint32_t i = 0; old && i < old->hdr->sym_count; i++) {
+        const LspStoreSym *y = &old->syms[i];
+        if (old_map[y->file] == UINT32_MAX) continue;
+        LSP_GROW(syms, nsyms, sym_cap, LspStoreSym);
+        LspStoreSym *d = &syms[nsyms++];
+        *d = *y;
+        d->file     = old_map[y->file];
+        d->name     = pool_add(&pool, store_str(old, y->name));
+        d->module   = pool_add(&pool, store_str(old, y->module));
+        d->type_sig = pool_add(&pool, store_str(old, y->type_sig));
+        d->doc      = pool_add(&pool, store_str(old, y->doc));
+    }
+    for (uint32_t i = 0; old && i < old->hdr->ref_count; i++) {
+        const LspStoreRef *r = &old->refs[i];
+        if (old_map[r->file] == UINT32_MAX) continue;
+        LSP_GROW(refs, nrefs, ref_cap, LspStoreRef);
+        refs[nrefs].name  = pool_add(&pool, store_str(old, r->name));
+        refs[nrefs].file  = old_map[r->file];
+        refs[nrefs].range = r->range;
+        nrefs++;
+    }
+    UriSlot *by_uri = lsp_xmalloc((fresh->file_count + 1) * sizeof(UriSlot));
+    for (size_t i = 0; i < fresh->file_count; i++)
+        by_uri[i] = (UriSlot){ fresh->files[i].uri, i };
+    qsort(by_uri, fresh->file_count, sizeof(UriSlot), uri_slot_cmp);
+    for (size_t b = 0; b < LSP_INDEX_BUCKETS; b++) {
+        for (LspIndexEntry *e = fresh->buckets[b]; e; e = e->next) {
+            UriSlot  key = { e->uri, 0 };
+            UriSlot *hit = e->uri ? bsearch(&key, by_uri, fresh->file_count,
+                                            sizeof(UriSlot), uri_slot_cmp) : NULL;
+            if (!hit) continue;               /* not from the scanner */
+            LSP_GROW(syms, nsyms, sym_cap, LspStoreSym);
+            LspStoreSym *d = &syms[nsyms++];
+            memset(d, 0, sizeof(*d));
+            d->file       = fresh_map[hit->at];
+            d->kind       = (uint32_t)e->kind;
+            d->range      = e->range;
+            d->name_range = e->name_range;
+            d->mask       = name_mask(e->name);
+            d->name       = pool_add(&pool, e->name);
+            d->module     = pool_add(&pool, e->module);
+            d->type_sig   = pool_add(&pool, e->type_sig);
+            d->doc        = pool_add(&pool, e->documentation);
+        }
+    }
+    for (size_t i = 0; i < fresh->file_count; i++) {
+        const LspIndexFile *f = &fresh->files[i];
+        for (size_t k = 0; k < f->ref_count; k++) {
+            LSP_GROW(refs, nrefs, ref_cap, LspStoreRef);
+            refs[nrefs].name  = pool_add(&pool, f->refs[k].name);
+            refs[nrefs].file  = fresh_map[i];
+            refs[nrefs].range = f->refs[k].range;
+            nrefs++;
+        }
+    }
+    /* The pool is final now, so its strings can key the sorts. */
+    SortedSym *ssyms = lsp_xmalloc((nsyms + 1) * sizeof(SortedSym));
+    for (size_t i = 0; i < nsyms; i++)
+        ssyms[i] = (SortedSym){ pool.buf + syms[i].name, syms[i] };
+    qsort(ssyms, nsyms, sizeof(SortedSym), sym_cmp);
+    for (size_t i = 0; i < nsyms; i++) syms[i] = ssyms[i].rec;
+    free(ssyms);
+    SortedRef *srefs = lsp_xmalloc((nrefs + 1) * sizeof(SortedRef));
+    for (size_t i = 0; i < nrefs; i++)
+        srefs[i] = (SortedRef){ pool.buf + refs[i].name, refs[i] };
+    qsort(srefs, nrefs, sizeof(SortedRef), ref_cmp);
+    for (size_t i = 0; i < nrefs; i++) refs[i] = srefs[i].rec;
+    free(srefs);
+
+    /* Trigram postings over the sorted symbols: (key << 32 | symbol),
+       sorted and deduplicated, then split into runs. */
+    uint64_t *pairs = NULL;
+    size_t    npairs = 0, pair_cap = 0;
+    for (size_t i = 0; i < nsyms; i++) {
+        const char *name = pool.buf + syms[i].name;
+        for (size_t k = 0; name[k] && name[k + 1] && name[k + 2]; k++) {
+            LSP_GROW(pairs, npairs, pair_cap, uint64_t);
+            pairs[npairs++] = (uint64_t)trigram_key(name + k) << 32 | i;
+        }
+    }
+    qsort(pairs, npairs, sizeof(uint64_t), u64_cmp);
+    LspStoreTri *tris  = lsp_xmalloc((npairs + 1) * sizeof(LspStoreTri));
+    uint32_t    *posts = lsp_xmalloc((npairs + 1) * sizeof(uint32_t));
+    size_t       ntris = 0, nposts = 0;
+    for (size_t i = 0; i < npairs; i++) {
+        if (i && pairs[i] == pairs[i - 1]) continue;
+        uint32_t key = (uint32_t)(pairs[i] >> 32);
+        if (!ntris || tris[ntris - 1].key != key)
+            tris[ntris++] = (LspStoreTri){ key, (uint32_t)nposts, 0 };
+        posts[nposts++] = (uint32_t)pairs[i];
+        tris[ntris - 1].count++;
+    }
+
+    LspStoreHeader h = {0};
+    memcpy(h.magic, LSP_STORE_MAGIC, 8);
+    h.version     = LSP_STORE_VERSION;
+    h.file_count  = (uint32_t)nfiles;
+    h.sym_count   = (uint32_t)nsyms;
+    h.ref_count   = (uint32_t)nrefs;
+    h.tri_count   = (uint32_t)ntris;
+    h.post_count  = (uint32_t)nposts;
+    size_t at     = store_align(sizeof(h));
+    h.files_off   = (uint32_t)at; at = store_align(at + nfiles * sizeof(LspStoreFile));
+    h.syms_off    = (uint32_t)at; at = store_align(at + nsyms  * sizeof(LspStoreSym));
+    h.refs_off    = (uint32_t)at; at = store_align(at + nrefs  * sizeof(LspStoreRef));
+    h.tris_off    = (uint32_t)at; at = store_align(at + ntris  * sizeof(LspStoreTri));
+    h.posts_off   = (uint32_t)at; at = store_align(at + nposts * sizeof(uint32_t));
+    h.strings_off = (uint32_t)at;
+    h.strings_len = (uint32_t)pool.len;
+    at += pool.len;
+    h.total_size  = at;
+
+    bool ok = at <= UINT32_MAX;
+    char tmp[4200];
+#if defined(_WIN32)
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+#else
+    snprintf(tmp, sizeof(tmp), "%s.tmp%ld", path, (long)getpid());
+#endif
+    FILE *f = ok ? fopen(tmp, "wb") : NULL;
+    if (f) {
+        unsigned char *buf = lsp_xcalloc(1, at);
+        memcpy(buf, &h, sizeof(h));
+        for (size_t i = 0; i < nfiles; i++)
+            memcpy(buf + h.files_off + i * sizeof(LspStoreFile), &rows[i].rec,
+                   sizeof(LspStoreFile));
+        if (nsyms)  memcpy(buf + h.syms_off,  syms,  nsyms  * sizeof(LspStoreSym));
+        if (nrefs)  memcpy(buf + h.refs_off,  refs,  nrefs  * sizeof(LspStoreRef));
+        if (ntris)  memcpy(buf + h.tris_off,  tris,  ntris  * sizeof(LspStoreTri));
+        if (nposts) memcpy(buf + h.posts_off, posts, nposts * sizeof(uint32_t));
+        memcpy(buf + h.strings_off, pool.buf, pool.len);
+        ok = fwrite(buf, 1, at, f) == at;
+        if (fclose(f) != 0) ok = false;
+        free(buf);
+#if defined(_WIN32)
+        if (ok) remove(path);
+#endif
+        if (!ok || rename(tmp, path) != 0) { remove(tmp); ok = false; }
+    } else {
+        ok = false;
+    }
+
+    free(rows); free(old_map); free(fresh_map); free(by_uri);
+    free(syms); free(refs); free(pairs); free(tris); free(posts);
+    free(pool.buf); free(pool.slots);
+    return ok;
+}
+
+bool lsp_index_open(LspIndex *idx, const char *path)
+{
+    LspStore *st = store_open(path);
+    if (!st) return false;
+    store_close(idx->store);
+    idx->store = st;
+    for (size_t i = 0; i < idx->file_count; i++)
+        store_set_shadow(st, idx->files[i].uri, true);
+    return true;
+}
+
+// Everything the index knows: the unshadowed on-disk records and every
+// file scanned in memory.
+bool lsp_index_save(LspIndex *idx, const char *path)
+{
+    LspStore *st   = idx->store;
+    size_t    n    = st ? st->hdr->file_count : 0;
+    int64_t  *keep = lsp_xmalloc((n + 1) * sizeof(int64_t));
+    for (size_t i = 0; i < n; i++)
+        keep[i] = st->shadow[i] ? LSP_STORE_DROP : st->files[i].mtime;
+    bool ok = store_write(path, st, keep, idx);
+    free(keep);
+    return ok;
+}
+
+
 /// §12  Workspace management
 
 //// Workspace management
@@ -1420,14 +2879,16 @@ void lsp_workspace_free(LspWorkspace *ws)
     lsp_index_free(ws->index);
     free(ws->root_uri);
     free(ws->root_path);
+    free(ws->index_path);
     free(ws->package_name);
     free(ws->source_dir);
     free(ws->main_file);
     free(ws);
 }
 
-LspDocument *lsp_workspace_get_doc(LspWorkspace *ws, const char *uri)
+static LspDocument *workspace_find_doc(LspWorkspace *ws, const char *uri)
 {
+    if (!uri) return NULL;
     for (size_t i = 0; i < ws->doc_count; i++) {
         if (strcmp(ws->docs[i]->uri, uri) == 0)
             return ws->docs[i];
@@ -1435,10 +2896,18 @@ LspDocument *lsp_workspace_get_doc(LspWorkspace *ws, const char *uri)
     return NULL;
 }
 
+// Feature handlers read the flat source, so hand them a synced document.
+LspDocument *lsp_workspace_get_doc(LspWorkspace *ws, const char *uri)
+{
+    LspDocument *doc = workspace_find_doc(ws, uri);
+    if (doc) lsp_document_sync(doc);
+    return doc;
+}
+
 LspDocument *lsp_workspace_open_doc(LspWorkspace *ws, const char *uri,
                                      const char *source, int version)
 {
-    LspDocument *existing = lsp_workspace_get_doc(ws, uri);
+    LspDocument *existing = workspace_find_doc(ws, uri);
     if (existing) {
         lsp_document_update(existing, source, version);
         return existing;
@@ -1453,14 +2922,16 @@ LspDocument *lsp_workspace_open_doc(LspWorkspace *ws, const char *uri,
 void lsp_workspace_update_doc(LspWorkspace *ws, const char *uri,
                                const char *source, int version)
 {
-    LspDocument *doc = lsp_workspace_get_doc(ws, uri);
+    LspDocument *doc = workspace_find_doc(ws, uri);
     if (doc) lsp_document_update(doc, source, version);
 }
 
+// The on-disk record of a closed file takes over from its buffer again.
 void lsp_workspace_close_doc(LspWorkspace *ws, const char *uri)
 {
     for (size_t i = 0; i < ws->doc_count; i++) {
         if (strcmp(ws->docs[i]->uri, uri) == 0) {
+            lsp_index_remove_file(ws->index, uri);
             lsp_document_free(ws->docs[i]);
             ws->docs[i] = ws->docs[--ws->doc_count];
             return;
@@ -1489,6 +2960,165 @@ void lsp_workspace_index(LspWorkspace *ws)
     }
 }
 
+//// Persistent index location and refresh
+ //
+ //  Each workspace root gets $MONAD_CACHE_DIR/lsp/<hash of root>.idx, or
+ //  ~/.cache/monad/lsp/… by default; MONAD_CACHE_DIR=off disables it.
+ //  A refresh walks the root for .mon files.  A file whose mtime and size
+ //  match its record is kept without being read, one whose content hash
+ //  still matches is kept with its new mtime, and only the rest are
+ //  rescanned before the merged index is written back.
+ //
+#define LSP_INDEX_MAX_DEPTH 32
+
+static char *workspace_index_path(const char *root_path)
+{
+    const char *env = getenv("MONAD_CACHE_DIR");
+    char dir[4096];
+    if (env && *env) {
+        if (strcmp(env, "off") == 0 || strcmp(env, "0") == 0) return NULL;
+        snprintf(dir, sizeof(dir), "%s", env);
+        monad_mkdir(dir);
+    } else {
+        const char *home = getenv("HOME");
+        if (!home || !*home) return NULL;
+        snprintf(dir, sizeof(dir), "%s/.cache", home);
+        monad_mkdir(dir);
+        snprintf(dir, sizeof(dir), "%s/.cache/monad", home);
+        monad_mkdir(dir);
+    }
+    size_t n = strlen(dir);
+    snprintf(dir + n, sizeof(dir) - n, "/lsp");
+    monad_mkdir(dir);
+
+    char path[4200];
+    snprintf(path, sizeof(path), "%s/%016" PRIx64 ".idx", dir,
+             hash_bytes(root_path, strlen(root_path)));
+    return lsp_xstrdup(path);
+}
+
+void lsp_workspace_set_root(LspWorkspace *ws, const char *root_uri)
+{
+    free(ws->root_uri);
+    free(ws->root_path);
+    free(ws->index_path);
+    ws->root_uri  = lsp_xstrdup(root_uri);
+    ws->root_path = (strncmp(root_uri, "file://", 7) == 0)
+                    ? lsp_xstrdup(root_uri + 7)
+                    : lsp_xstrdup(root_uri);
+    ws->index_path = workspace_index_path(ws->root_path);
+    if (ws->index_path) lsp_index_open(ws->index, ws->index_path);
+}
+
+typedef struct LspIndexRefresh {
+    const LspStore *old;
+    int64_t        *keep;      /* per old file, see store_write */
+    LspIndex       *fresh;
+    size_t          rescanned;
+} LspIndexRefresh;
+
+#if !defined(_WIN32)
+static int64_t stat_mtime_ns(const struct stat *st)
+{
+#if defined(__linux__)
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+#else
+    return (int64_t)st->st_mtime * 1000000000;
+#endif
+}
+
+static void refresh_file(LspIndexRefresh *r, const char *path,
+                         const struct stat *st)
+{
+    char *uri = lsp_xmalloc(strlen(path) + 8);
+    sprintf(uri, "file://%s", path);
+    int64_t mtime = stat_mtime_ns(st);
+    int64_t f     = store_find_file(r->old, uri);
+    if (f >= 0 && r->old->files[f].mtime == mtime &&
+        r->old->files[f].size == (int64_t)st->st_size) {
+        r->keep[f] = mtime;
+        free(uri);
+        return;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    char *buf = fp ? lsp_xmalloc((size_t)st->st_size + 1) : NULL;
+    size_t n  = fp ? fread(buf, 1, (size_t)st->st_size, fp) : 0;
+    if (fp) fclose(fp);
+    if (buf) {
+        buf[n] = '\0';
+        if (f >= 0 && r->old->files[f].hash == hash_bytes(buf, n)) {
+            r->keep[f] = mtime;
+        } else {
+            lsp_index_scan_source(r->fresh, uri, buf, n);
+            LspIndexFile *rec = &r->fresh->files[r->fresh->file_count - 1];
+            rec->mtime = mtime;
+            rec->size  = (int64_t)n;
+            r->rescanned++;
+        }
+    }
+    free(buf);
+    free(uri);
+}
+
+static void refresh_walk(LspIndexRefresh *r, const char *dir, int depth)
+{
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        if (de->d_name[0] == '.') continue;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", strcmp(dir, "/") ? dir : "", de->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+        size_t n = strlen(de->d_name);
+        if (S_ISDIR(st.st_mode)) {
+            if (depth < LSP_INDEX_MAX_DEPTH) refresh_walk(r, path, depth + 1);
+        } else if (S_ISREG(st.st_mode) && n > 4 &&
+                   strcmp(de->d_name + n - 4, ".mon") == 0) {
+            refresh_file(r, path, &st);
+        }
+    }
+    closedir(d);
+}
+#endif
+
+// Scan root against old, which the caller keeps open, and write the merged
+// index to path unless nothing changed.  Takes no locks.  Returns the
+// number of files rescanned, or -1 when the index could not be written.
+static int refresh_build(const char *root, const char *path, const LspStore *old,
+                         bool *wrote)
+{
+    size_t n = old ? old->hdr->file_count : 0;
+    LspIndexRefresh r = { old, lsp_xmalloc((n + 1) * sizeof(int64_t)),
+                          lsp_index_create(), 0 };
+    for (size_t i = 0; i < n; i++) r.keep[i] = LSP_STORE_DROP;
+#if !defined(_WIN32)
+    refresh_walk(&r, root, 0);
+#else
+    (void)root;   /* no directory walk: keep what is already indexed */
+    for (size_t i = 0; i < n; i++) r.keep[i] = old->files[i].mtime;
+#endif
+    bool changed = !old || r.rescanned > 0;
+    for (size_t i = 0; i < n && !changed; i++)
+        changed = r.keep[i] != old->files[i].mtime;
+    bool ok = !changed || store_write(path, old, r.keep, r.fresh);
+    *wrote = changed && ok;
+    free(r.keep);
+    lsp_index_free(r.fresh);
+    return ok ? (int)r.rescanned : -1;
+}
+
+int lsp_workspace_refresh_index(LspWorkspace *ws)
+{
+    if (!ws->index_path) return -1;
+    bool wrote;
+    int  n = refresh_build(ws->root_path, ws->index_path, ws->index->store, &wrote);
+    if (wrote && !lsp_index_open(ws->index, ws->index_path)) n = -1;
+    return n;
+}
+
 
 /// §13  Analysis integration
 
@@ -1517,6 +3147,13 @@ void lsp_analysis_result_apply(LspDocument *doc, LspAnalysisResult *r)
 {
     if (!r) return;
 
+    /* The workspace index follows the analyzed buffer */
+    if (doc->workspace) {
+        lsp_document_sync(doc);
+        lsp_index_scan_source(doc->workspace->index, doc->uri,
+                              doc->source, doc->source_len);
+    }
+
     /* Swap in diagnostics */
     lsp_document_clear_diagnostics(doc);
     for (size_t i = 0; i < r->diag_count; i++)
@@ -1860,10 +3497,13 @@ LspLocation *lsp_references(LspDocument *doc, LspPosition pos,
     char *word = lsp_document_word_at(doc, pos);
     if (!word) return NULL;
     LspIndexEntry *e = lsp_index_lookup(doc->workspace->index, word);
+    if (!e) { free(word); return NULL; }
+
+    size_t       nuses = 0;
+    LspLocation *uses  = lsp_index_references(doc->workspace->index, word, &nuses);
     free(word);
-    if (!e) return NULL;
 
-    size_t total = e->ref_count + (include_declaration ? 1 : 0);
+    size_t total = e->ref_count + nuses + (include_declaration ? 1 : 0);
     if (total == 0) return NULL;
 
     LspLocation *locs = lsp_xmalloc(total * sizeof(LspLocation));
@@ -1879,6 +3519,8 @@ LspLocation *lsp_references(LspDocument *doc, LspPosition pos,
         locs[idx].range = e->references[i].range;
         idx++;
     }
+    if (nuses) memcpy(locs + idx, uses, nuses * sizeof(LspLocation));
+    free(uses);
     *count = total;
     return locs;
 }
@@ -2315,8 +3957,29 @@ LspWorkspaceEdit *lsp_rename(LspDocument *doc, LspPosition pos,
  //
  //  Returns a copy of the pre-computed fold ranges stored on the document.
  //  The analysis pass populates these by walking the AST for top-level
- //  definitions, import blocks, and comment regions.
+ //  definitions, import blocks, and comment regions.  When it reports
+ //  none, every multi-line top-level form folds as a region.
  //
+// Region folds for the document's multi-line top-level forms.
+static LspFoldRange *document_form_folds(LspDocument *doc, size_t *count)
+{
+    LspFoldRange *out = NULL;
+    size_t        n = 0, cap = 0;
+    for (size_t i = 0; i < doc->form_count; i++) {
+        uint32_t first = lsp_document_position(doc, doc->forms[i].start).line;
+        uint32_t last  = lsp_document_position(doc, doc->forms[i].end - 1).line;
+        if (last <= first) continue;
+        LSP_GROW(out, n, cap, LspFoldRange);
+        out[n].start_line     = first;
+        out[n].end_line       = last;
+        out[n].kind           = LSP_FOLD_REGION;
+        out[n].collapsed_text = NULL;
+        n++;
+    }
+    *count = n;
+    return out;
+}
+
 LspFoldRange *lsp_folding_ranges(LspDocument *doc, size_t *count)
 {
     *count = 0;
@@ -3137,11 +4800,19 @@ char *lsp_server_info(void)
  //
 //// Lifecycle
 
+// The index open on return answers queries at once; a refresh against
+// the files on disk follows in the background.
 static char *handle_initialize(LspServer *server, const char *params)
 {
-    (void)params;
     server->initialized = true;
 
+    char *root = json_get_string(params, "rootUri");
+    if (root && strncmp(root, "file://", 7) == 0) {
+        lsp_workspace_set_root(server->workspace, root);
+        lsp_server_refresh_index(server);
+    }
+    free(root);
+
     char *caps = lsp_server_capabilities(server);
     char *info = lsp_server_info();
     StrBuf b;
@@ -3180,36 +4851,45 @@ static char *handle_textDocument_didOpen(LspServer *server, const char *params)
     char *txt = json_get_string(td, "text");
     int   ver = (int)json_get_int(td, "version");
 
-    LspDocument *doc = lsp_workspace_open_doc(
-        server->workspace, uri, txt, ver);
-    lsp_document_analyze(doc);
-    lsp_publish_diagnostics(server, doc);
+    if (uri) {
+        lsp_workspace_open_doc(server->workspace, uri, txt, ver);
+        lsp_server_schedule_analysis(server, uri, 0);
+    }
 
     free(td); free(uri); free(txt);
     return NULL;
 }
 
+// Changes apply in order, each against the text the previous one left.
+// A change without a range replaces the whole document.
 static char *handle_textDocument_didChange(LspServer *server, const char *params)
 {
     char *td  = json_get_object(params, "textDocument");
     char *uri = json_get_string(td, "uri");
     int   ver = (int)json_get_int(td, "version");
 
-    /* Use the last content change */
-    char *changes = json_get_object(params, "contentChanges");
-    /* For simplicity, treat the whole text as a single replacement. */
-    char *text = json_get_string(changes, "text");
-
-    if (text) {
-        lsp_workspace_update_doc(server->workspace, uri, text, ver);
-        LspDocument *doc = lsp_workspace_get_doc(server->workspace, uri);
-        if (doc) {
-            lsp_document_analyze(doc);
-            lsp_publish_diagnostics(server, doc);
+    char        *changes = json_get_object(params, "contentChanges");
+    LspDocument *doc     = workspace_find_doc(server->workspace, uri);
+
+    if (doc && changes) {
+        const char *cursor = changes;
+        char       *change = NULL;
+        while ((cursor = json_array_next(cursor, &change))) {
+            char *text  = json_get_string(change, "text");
+            char *range = json_get_object(change, "range");
+            if (range)
+                lsp_document_edit(doc, json_parse_range(range), text);
+            else
+                lsp_document_update(doc, text, ver);
+            free(text); free(range); free(change);
+            change = NULL;
         }
+        doc->version = ver;
+        if (server->config.check_on_change)
+            lsp_server_schedule_analysis(server, uri, server->config.debounce_ms);
     }
 
-    free(td); free(uri); free(changes); free(text);
+    free(td); free(uri); free(changes);
     return NULL;
 }
 
@@ -3217,13 +4897,9 @@ static char *handle_textDocument_didSave(LspServer *server, const char *params)
 {
     char *td  = json_get_object(params, "textDocument");
     char *uri = json_get_string(td, "uri");
-    if (server->config.check_on_save) {
-        LspDocument *doc = lsp_workspace_get_doc(server->workspace, uri);
-        if (doc) {
-            lsp_document_analyze(doc);
-            lsp_publish_diagnostics(server, doc);
-        }
-    }
+    if (server->config.check_on_save && workspace_find_doc(server->workspace, uri))
+        lsp_server_schedule_analysis(server, uri, 0);
+    lsp_server_refresh_index(server);
     free(td); free(uri);
     return NULL;
 }
@@ -3232,7 +4908,7 @@ static char *handle_textDocument_didClose(LspServer *server, const char *params)
 {
     char *td  = json_get_object(params, "textDocument");
     char *uri = json_get_string(td, "uri");
-    lsp_workspace_close_doc(server->workspace, uri);
+    if (uri) lsp_workspace_close_doc(server->workspace, uri);
     free(td); free(uri);
     return NULL;
 }
@@ -3862,6 +5538,273 @@ static void dispatch(LspServer *server, LspMessage *msg)
 
 /// §32  Server lifecycle
 
+//// Background analysis
+ //
+ //  One analysis thread drains a queue of URIs, each with a due time.
+ //  Scheduling a URI that is already queued only pushes its due time back,
+ //  so a burst of keystrokes costs one analysis once the typing pauses for
+ //  debounce_ms.  The thread snapshots the document under the server lock,
+ //  analyzes with the lock released, and applies and publishes only if the
+ //  document is still at the snapshot's version; a superseded result is
+ //  dropped, since a newer job is already queued behind it.
+ //
+ //  Builds without pthreads run each analysis inline when it is scheduled.
+ //
+ //  A second thread refreshes the persistent index on initialize and on
+ //  every save.  It scans with no lock held and takes the lock only to map
+ //  the new file; the store it reads meanwhile is replaced by nothing but
+ //  the refresh itself.
+ //
+typedef struct LspAnalysisJob {
+    char    *uri;      /* owned */
+    int64_t  due_ms;
+} LspAnalysisJob;
+
+typedef struct LspAnalyzer {
+#if LSP_ANALYZER_THREAD
+    pthread_mutex_t lock;      /* the server lock                  */
+    pthread_cond_t  wake;      /* queue changed or a job finished  */
+    pthread_t       thread;
+    bool            started;
+    pthread_t       indexer;
+    bool            indexer_started;
+#endif
+    bool            stopping;
+    bool            busy;      /* a job is between snapshot and publish */
+    bool            indexing;  /* an index refresh is running           */
+    bool            reindex;   /* and another was asked for meanwhile   */
+    LspAnalysisJob *jobs;
+    size_t          job_count;
+    size_t          job_cap;
+} LspAnalyzer;
+
+static void analyzer_lock(LspAnalyzer *a)
+{
+#if LSP_ANALYZER_THREAD
+    pthread_mutex_lock(&a->lock);
+#else
+    (void)a;
+#endif
+}
+
+static void analyzer_unlock(LspAnalyzer *a)
+{
+#if LSP_ANALYZER_THREAD
+    pthread_mutex_unlock(&a->lock);
+#else
+    (void)a;
+#endif
+}
+
+// Analyze uri.  Called and returns with the server lock held.
+static void analyzer_run(LspServer *server, const char *uri)
+{
+    LspAnalyzer *a   = server->analyzer;
+    LspDocument *doc = workspace_find_doc(server->workspace, uri);
+    if (!doc) return;
+
+    lsp_document_sync(doc);
+    int           version = doc->version;
+    char         *path    = lsp_xstrdup(doc->path);
+    char         *source  = lsp_xstrndup(doc->source, doc->source_len);
+    size_t        fold_count;
+    LspFoldRange *folds   = document_form_folds(doc, &fold_count);
+    doc->state = LSP_DOC_ANALYZING;
+
+    analyzer_unlock(a);
+    LspAnalysisResult *r = lsp_analyze_file(path, source, server->workspace);
+    analyzer_lock(a);
+
+    doc = workspace_find_doc(server->workspace, uri);
+    if (doc && doc->version == version && !a->stopping) {
+        if (!r) {
+            doc->state = LSP_DOC_ERROR;
+        } else {
+            if (r->fold_count == 0) {
+                free(r->folds);
+                r->folds      = folds;
+                r->fold_count = fold_count;
+                folds         = NULL;
+            }
+            lsp_analysis_result_apply(doc, r);
+            doc->state = LSP_DOC_CLEAN;
+            lsp_publish_diagnostics(server, doc);
+        }
+    }
+
+    lsp_analysis_result_free(r);
+    lsp_fold_range_list_free(folds, folds ? fold_count : 0);
+    free(path);
+    free(source);
+}
+
+#if LSP_ANALYZER_THREAD
+static int64_t analyzer_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void *analyzer_main(void *arg)
+{
+    LspServer   *server = arg;
+    LspAnalyzer *a      = server->analyzer;
+
+    pthread_mutex_lock(&a->lock);
+    while (!a->stopping) {
+        if (a->job_count == 0) {
+            pthread_cond_wait(&a->wake, &a->lock);
+            continue;
+        }
+        size_t next = 0;
+        for (size_t i = 1; i < a->job_count; i++)
+            if (a->jobs[i].due_ms < a->jobs[next].due_ms) next = i;
+
+        int64_t due = a->jobs[next].due_ms;
+        if (due > analyzer_now_ms()) {
+            struct timespec ts = { (time_t)(due / 1000),
+                                   (long)(due % 1000) * 1000000 };
+            pthread_cond_timedwait(&a->wake, &a->lock, &ts);
+            continue;
+        }
+
+        char *uri = a->jobs[next].uri;
+        a->jobs[next] = a->jobs[--a->job_count];
+        a->busy = true;
+        analyzer_run(server, uri);
+        a->busy = false;
+        free(uri);
+        pthread_cond_broadcast(&a->wake);
+    }
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+static void *indexer_main(void *arg)
+{
+    LspServer    *server = arg;
+    LspAnalyzer  *a      = server->analyzer;
+    LspWorkspace *ws     = server->workspace;
+
+    pthread_mutex_lock(&a->lock);
+    do {
+        a->reindex = false;
+        char     *root = lsp_xstrdup(ws->root_path);
+        char     *path = lsp_xstrdup(ws->index_path);
+        LspStore *old  = ws->index->store;
+        pthread_mutex_unlock(&a->lock);
+        bool wrote;
+        int  n = refresh_build(root, path, old, &wrote);
+        pthread_mutex_lock(&a->lock);
+        if (wrote && !a->stopping && lsp_index_open(ws->index, path))
+            lsp_log(server, LSP_LOG_DEBUG, "index: %d file(s) rescanned", n);
+        free(root);
+        free(path);
+    } while (a->reindex && !a->stopping);
+    a->indexing = false;
+    pthread_cond_broadcast(&a->wake);
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+#endif
+
+// Call from a handler: the server lock is already held.
+void lsp_server_refresh_index(LspServer *server)
+{
+    LspAnalyzer *a = server->analyzer;
+    if (!server->workspace->index_path) return;
+#if LSP_ANALYZER_THREAD
+    if (a->indexing) {
+        a->reindex = true;
+        return;
+    }
+    if (a->indexer_started) pthread_join(a->indexer, NULL);
+    a->indexing = a->indexer_started =
+        pthread_create(&a->indexer, NULL, indexer_main, server) == 0;
+    if (a->indexing) return;
+#endif
+    (void)a;
+    lsp_workspace_refresh_index(server->workspace);
+}
+
+// Call from a handler: the server lock is already held.
+void lsp_server_schedule_analysis(LspServer *server, const char *uri,
+                                  int delay_ms)
+{
+    LspAnalyzer *a = server->analyzer;
+#if LSP_ANALYZER_THREAD
+    if (!a->started) {
+        if (pthread_create(&a->thread, NULL, analyzer_main, server) != 0) {
+            analyzer_run(server, uri);
+            return;
+        }
+        a->started = true;
+    }
+
+    int64_t due = analyzer_now_ms() + (delay_ms > 0 ? delay_ms : 0);
+    for (size_t i = 0; i < a->job_count; i++) {
+        if (strcmp(a->jobs[i].uri, uri) == 0) {
+            a->jobs[i].due_ms = due;
+            pthread_cond_broadcast(&a->wake);
+            return;
+        }
+    }
+    LSP_GROW(a->jobs, a->job_count, a->job_cap, LspAnalysisJob);
+    a->jobs[a->job_count].uri    = lsp_xstrdup(uri);
+    a->jobs[a->job_count].due_ms = due;
+    a->job_count++;
+    pthread_cond_broadcast(&a->wake);
+#else
+    (void)delay_ms;
+    analyzer_run(server, uri);
+    (void)a;
+#endif
+}
+
+void lsp_server_wait_idle(LspServer *server)
+{
+#if LSP_ANALYZER_THREAD
+    LspAnalyzer *a = server->analyzer;
+    pthread_mutex_lock(&a->lock);
+    while (!a->stopping &&
+           ((a->started && (a->job_count || a->busy)) || a->indexing))
+        pthread_cond_wait(&a->wake, &a->lock);
+    pthread_mutex_unlock(&a->lock);
+#else
+    (void)server;
+#endif
+}
+
+static LspAnalyzer *analyzer_create(void)
+{
+    LspAnalyzer *a = lsp_xcalloc(1, sizeof(*a));
+#if LSP_ANALYZER_THREAD
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->wake, NULL);
+#endif
+    return a;
+}
+
+static void analyzer_free(LspAnalyzer *a)
+{
+    if (!a) return;
+#if LSP_ANALYZER_THREAD
+    pthread_mutex_lock(&a->lock);
+    a->stopping = true;
+    pthread_cond_broadcast(&a->wake);
+    pthread_mutex_unlock(&a->lock);
+    if (a->started) pthread_join(a->thread, NULL);
+    if (a->indexer_started) pthread_join(a->indexer, NULL);
+    pthread_cond_destroy(&a->wake);
+    pthread_mutex_destroy(&a->lock);
+#endif
+    for (size_t i = 0; i < a->job_count; i++)
+        free(a->jobs[i].uri);
+    free(a->jobs);
+    free(a);
+}
+
 //// Server lifecycle
  //
  //  lsp_server_run() is the main event loop.  It blocks the calling thread
@@ -3909,8 +5852,7 @@ LspServer *lsp_server_create(LspConfig config)
     s->pending_cap = 16;
     s->pending_ids = lsp_xmalloc(s->pending_cap * sizeof(LspId));
 
-    s->dirty_cap  = 16;
-    s->dirty_uris = lsp_xmalloc(s->dirty_cap * sizeof(char *));
+    s->analyzer = analyzer_create();
 
     return s;
 }
@@ -3918,14 +5860,12 @@ LspServer *lsp_server_create(LspConfig config)
 void lsp_server_free(LspServer *server)
 {
     if (!server) return;
+    analyzer_free(server->analyzer);
     lsp_transport_free(server->transport);
     lsp_workspace_free(server->workspace);
     for (size_t i = 0; i < server->pending_count; i++)
         lsp_id_free(&server->pending_ids[i]);
     free(server->pending_ids);
-    for (size_t i = 0; i < server->dirty_count; i++)
-        free(server->dirty_uris[i]);
-    free(server->dirty_uris);
     free(server);
 }
 
@@ -3939,7 +5879,7 @@ int lsp_server_run(LspServer *server)
         }
 
         lsp_log(server, LSP_LOG_DEBUG, "← %s", msg->method ? msg->method : "<response>");
-        dispatch(server, msg);
+        lsp_server_handle(server, msg);
         lsp_message_free(msg);
 
         if (server->shutdown_requested) {
@@ -3961,6 +5901,13 @@ void lsp_server_stop(LspServer *server)
     server->shutdown_requested = true;
 }
 
+void lsp_server_handle(LspServer *server, LspMessage *msg)
+{
+    analyzer_lock(server->analyzer);
+    dispatch(server, msg);
+    analyzer_unlock(server->analyzer);
+}
+
 
 /// §33  Logging
 
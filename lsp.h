@@ -24,17 +24,20 @@
 //
 //    LspServer  ->  LspTransport  ->  stdin/stdout (JSON-RPC 2.0)
 //       │
-//       ├── LspDocument   (per-file state: source, AST, env, diagnostics)
+//       ├── LspDocument   (per-file state: rope, forms, AST, diagnostics)
 //       ├── LspWorkspace  (project-wide index: all modules, symbols)
 //       ├── LspIndex      (symbol table for fast lookup)
 //       └── LspAnalyzer   (drives compilation pipeline for analysis)
 //
 //  Threading model:
 //    · Main thread: JSON-RPC I/O loop (read → dispatch → write)
-//    · Analysis thread: background reanalysis on document change
-//    · Index thread: workspace-wide symbol indexing
+//    · Analysis thread: debounced background reanalysis on document
+//      change; results for a superseded version are dropped
+//    · Index thread: refreshes the persistent workspace index from disk
 //
-//  All public functions are thread-safe unless noted otherwise.
+//  The server lock serialises dispatch with the analysis thread's
+//  snapshot and publish steps.  Document and workspace functions are not
+//  thread-safe on their own; call them from a handler or under the lock.
 //
 
 #include <stdbool.h>
@@ -64,6 +67,7 @@ typedef struct LspAction         LspAction;
 typedef struct LspInlayHint      LspInlayHint;
 typedef struct LspSemanticTokens LspSemanticTokens;
 typedef struct LspSignatureHelp  LspSignatureHelp;
+typedef struct LspRope           LspRope;
 
 
 /// Position and Range
@@ -401,14 +405,38 @@ typedef enum {
     LSP_DOC_ERROR    = 3,  /* last analysis failed hard */
 } LspDocState;
 
+//  Edits splice the rope, which is the authoritative text.  source and
+//  line_offsets are a flat view of it, rebuilt by lsp_document_sync()
+//  once per burst of edits rather than once per keystroke.
+//
+//  forms holds the byte span of every top-level form.  An edit drops the
+//  forms it touches and widens [reparse_lo, reparse_hi) over them; the
+//  next sync rescans only that span and shifts everything after it.
+//
+typedef struct LspForm {
+    uint32_t      start;          /* first byte of the form            */
+    uint32_t      end;            /* one past its last byte            */
+} LspForm;
+
 typedef struct LspDocument {
     char         *uri;            /* file:// URI, owned                */
     char         *path;           /* filesystem path, owned            */
-    char         *source;         /* current source text, owned        */
+    char         *source;         /* flat view of rope, owned          */
     size_t        source_len;
     int           version;        /* LSP document version counter      */
     LspDocState   state;
 
+    LspRope      *rope;           /* current text, owned               */
+    bool          source_stale;   /* rope edited since the last sync   */
+
+    /* Top-level forms, sorted by offset */
+    LspForm      *forms;
+    size_t        form_count;
+    size_t        form_cap;
+    uint32_t      reparse_lo;     /* span to rescan; lo > hi when none */
+    uint32_t      reparse_hi;
+    size_t        forms_rescanned; /* forms the last sync rescanned    */
+
     /* Analysis results — rebuilt on each reanalysis */
     LspDiagnostic   *diagnostics;
     size_t           diag_count;
@@ -464,6 +492,23 @@ typedef struct LspIndexEntry {
 
 #define LSP_INDEX_BUCKETS 4096
 
+/* One identifier occurrence, recorded by the declaration scanner */
+typedef struct LspIndexRef {
+    char         *name;          /* owned                              */
+    LspRange      range;
+} LspIndexRef;
+
+/* A file indexed in this session, with its reference postings */
+typedef struct LspIndexFile {
+    char         *uri;           /* owned                              */
+    uint64_t      hash;          /* content hash of the scanned text   */
+    int64_t       mtime;         /* on-disk stat, 0 for editor buffers */
+    int64_t       size;
+    LspIndexRef  *refs;
+    size_t        ref_count;
+    size_t        ref_cap;
+} LspIndexFile;
+
 typedef struct LspIndex {
     LspIndexEntry  *buckets[LSP_INDEX_BUCKETS];
     size_t          entry_count;
@@ -473,6 +518,15 @@ typedef struct LspIndex {
     size_t          sorted_count;
     size_t          sorted_cap;
     bool            sorted_dirty;
+
+    /* Files whose entries live in the table above */
+    LspIndexFile   *files;
+    size_t          file_count;
+    size_t          file_cap;
+
+    /* Mapped on-disk index for everything else; a file indexed in
+       memory shadows its on-disk record (opaque; managed in lsp.c)   */
+    void           *store;
 } LspIndex;
 
 
@@ -493,6 +547,9 @@ typedef struct LspWorkspace {
     /* Cross-file symbol index */
     LspIndex     *index;
 
+    /* Persistent index location, NULL when caching is off */
+    char         *index_path;
+
     /* Package config (from package.yaml) */
     char         *package_name;
     char         *source_dir;
@@ -664,10 +721,9 @@ typedef struct LspServer {
     size_t         pending_count;
     size_t         pending_cap;
 
-    /* Background analysis queue */
-    char          **dirty_uris;     /* URIs needing reanalysis */
-    size_t          dirty_count;
-    size_t          dirty_cap;
+    /* Server lock, analysis thread and its debounced queue */
+    /* (opaque to this header; managed in lsp.c)            */
+    void          *analyzer;
 } LspServer;
 
 
@@ -677,6 +733,17 @@ LspServer    *lsp_server_create(LspConfig config);
 void          lsp_server_free(LspServer *server);
 int           lsp_server_run(LspServer *server);   /* blocks until exit */
 void          lsp_server_stop(LspServer *server);
+void          lsp_server_handle(LspServer *server, LspMessage *msg);
+
+/* Queue uri for reanalysis after delay_ms; a later call for the same
+   uri replaces the pending one.  wait_idle blocks until the queue drains. */
+void          lsp_server_schedule_analysis(LspServer *server, const char *uri,
+                                           int delay_ms);
+void          lsp_server_wait_idle(LspServer *server);
+
+/* Bring the persistent index up to date with the files on disk, on the
+   index thread when there is one.  wait_idle also waits for it. */
+void          lsp_server_refresh_index(LspServer *server);
 
 
 /// Transport
@@ -715,6 +782,8 @@ void  lsp_message_free(LspMessage *msg);
 LspWorkspace *lsp_workspace_create(const char *root_uri);
 void          lsp_workspace_free(LspWorkspace *ws);
 void          lsp_workspace_index(LspWorkspace *ws);   /* full re-index */
+void          lsp_workspace_set_root(LspWorkspace *ws, const char *root_uri);
+int           lsp_workspace_refresh_index(LspWorkspace *ws); /* files rescanned */
 LspDocument  *lsp_workspace_get_doc(LspWorkspace *ws, const char *uri);
 LspDocument  *lsp_workspace_open_doc(LspWorkspace *ws, const char *uri,
                                       const char *source, int version);
@@ -730,6 +799,8 @@ void          lsp_workspace_analyze_all(LspWorkspace *ws);
 LspDocument  *lsp_document_create(const char *uri, const char *source, int version);
 void          lsp_document_free(LspDocument *doc);
 void          lsp_document_update(LspDocument *doc, const char *source, int version);
+void          lsp_document_edit(LspDocument *doc, LspRange range, const char *text);
+void          lsp_document_sync(LspDocument *doc);
 void          lsp_document_analyze(LspDocument *doc);
 void          lsp_document_add_diagnostic(LspDocument *doc, LspDiagnostic diag);
 void          lsp_document_clear_diagnostics(LspDocument *doc);
@@ -752,6 +823,11 @@ LspIndexEntry **lsp_index_prefix(LspIndex *idx, const char *prefix, size_t *coun
 LspIndexEntry **lsp_index_fuzzy(LspIndex *idx, const char *query, size_t *count);
 void           lsp_index_remove_file(LspIndex *idx, const char *uri);
 void           lsp_index_rebuild_sorted(LspIndex *idx);
+void           lsp_index_scan_source(LspIndex *idx, const char *uri,
+                                     const char *source, size_t len);
+LspLocation   *lsp_index_references(LspIndex *idx, const char *name, size_t *count);
+bool           lsp_index_open(LspIndex *idx, const char *path);
+bool           lsp_index_save(LspIndex *idx, const char *path);
 LspIndexEntry *lsp_index_entry_create(void);
 void           lsp_index_entry_free(LspIndexEntry *e);
 
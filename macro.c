@@ -1,5 +1,6 @@
 #include "macro.h"
 #include "reader.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -164,9 +165,16 @@ static const char *rt_lookup(RenameTable *rt, const char *name) {
 //
 typedef struct {
     char     *name;
+    const char *key;      // intern(name); buckets match on this pointer
     ASTParam *params;
     int       param_count;
     AST      *body;       // NOT owned — points into a live lambda node
+    /* Names the body introduces (see collect_introduced).  They depend
+     * only on the body and the parameter names, so they are collected on
+     * the first expansion and reused by every later one. */
+    char    **intro;
+    int       intro_count;
+    bool      intro_ready;
 } MacroDef;
 
 #define MACRO_BUCKETS 64
@@ -180,16 +188,15 @@ typedef struct {
     MacroEntry *buckets[MACRO_BUCKETS];
     /* Keep the original lambda AST nodes alive so body pointers stay valid */
     AST       **lambdas;
+    char      **lambda_names;   // parallel to lambdas: the macro each one defines
     int         lambda_count;
     int         lambda_cap;
 } MacroRegistry;
 
 static MacroRegistry g_reg = {0};
 
-static unsigned int macro_hash(const char *s) {
-    unsigned int h = 5381;
-    while (*s) h = ((h << 5) + h) + (unsigned char)*s++;
-    return h % MACRO_BUCKETS;
+static unsigned int macro_hash(const char *key) {
+    return intern_hash(key) % MACRO_BUCKETS;
 }
 
 void macro_clear(void) {
@@ -203,25 +210,35 @@ void macro_clear(void) {
                 free(e->def.params[j].type_name);
             }
             free(e->def.params);
+            for (int j = 0; j < e->def.intro_count; j++)
+                free(e->def.intro[j]);
+            free(e->def.intro);
             free(e);
             e = next;
         }
         g_reg.buckets[i] = NULL;
     }
     /* Free the kept lambda ASTs */
-    for (int i = 0; i < g_reg.lambda_count; i++)
+    for (int i = 0; i < g_reg.lambda_count; i++) {
         ast_free(g_reg.lambdas[i]);
+        free(g_reg.lambda_names[i]);
+    }
     free(g_reg.lambdas);
+    free(g_reg.lambda_names);
     g_reg.lambdas      = NULL;
+    g_reg.lambda_names = NULL;
     g_reg.lambda_count = 0;
     g_reg.lambda_cap   = 0;
 }
 
-static void registry_keep_lambda(AST *lam) {
+static void registry_keep_lambda(const char *name, AST *lam) {
     if (g_reg.lambda_count >= g_reg.lambda_cap) {
         g_reg.lambda_cap = g_reg.lambda_cap ? g_reg.lambda_cap * 2 : 8;
         g_reg.lambdas = realloc(g_reg.lambdas, sizeof(AST*) * g_reg.lambda_cap);
+        g_reg.lambda_names = realloc(g_reg.lambda_names,
+                                     sizeof(char*) * g_reg.lambda_cap);
     }
+    g_reg.lambda_names[g_reg.lambda_count] = xstrdup(name);
     g_reg.lambdas[g_reg.lambda_count++] = lam;
 }
 
@@ -238,26 +255,32 @@ static void registry_add(const char *name, AST *lambda) {
         params[i].is_anon   = lambda->lambda.params[i].is_anon;
     }
 
-    unsigned int h = macro_hash(name);
-    MacroEntry *e  = malloc(sizeof(MacroEntry));
+    const char *key = intern(name);
+    unsigned int h  = macro_hash(key);
+    MacroEntry *e   = malloc(sizeof(MacroEntry));
     e->def.name        = xstrdup(name);
+    e->def.key         = key;
     e->def.params      = params;
     e->def.param_count = n;
     e->def.body        = lambda->lambda.body; // pointer into lambda; lambda kept alive
+    e->def.intro       = NULL;
+    e->def.intro_count = 0;
+    e->def.intro_ready = false;
     e->next            = g_reg.buckets[h];
     g_reg.buckets[h]   = e;
 
     /* Keep the lambda alive so body stays valid */
-    registry_keep_lambda(lambda);
+    registry_keep_lambda(name, lambda);
     fprintf(stderr, "[macro] registered '%s' (%d param%s%s)\n",
             name, n, n == 1 ? "" : "s",
             (n > 0 && params[n-1].is_rest) ? " + rest" : "");
 }
 
 static MacroDef *registry_lookup(const char *name) {
-    unsigned int h = macro_hash(name);
-    for (MacroEntry *e = g_reg.buckets[h]; e; e = e->next)
-        if (strcmp(e->def.name, name) == 0)
+    const char *key = intern_find(name);
+    if (!key) return NULL;
+    for (MacroEntry *e = g_reg.buckets[macro_hash(key)]; e; e = e->next)
+        if (e->def.key == key)
             return &e->def;
     return NULL;
 }
@@ -266,6 +289,24 @@ int macro_is_registered(const char *name) {
     return registry_lookup(name) != NULL ? 1 : 0;
 }
 
+size_t macro_count(void) {
+    return (size_t)g_reg.lambda_count;
+}
+
+const AST *macro_at(size_t index, const char **name) {
+    if (index >= (size_t)g_reg.lambda_count) return NULL;
+    if (name) *name = g_reg.lambda_names[index];
+    return g_reg.lambdas[index];
+}
+
+void macro_register(const char *name, AST *lambda) {
+    if (!name || !lambda || lambda->type != AST_LAMBDA) {
+        ast_free(lambda);
+        return;
+    }
+    registry_add(name, lambda);
+}
+
 /// Introduced-name scan
 //
 // Collect every name *introduced* by a macro body — lambda params,
@@ -460,7 +501,7 @@ static AST *subst(AST *node, BindTable *bt, RenameTable *rt,
     /* ---- Lambda: rename introduced params, substitute body -------- */
     case AST_LAMBDA: {
         /* Shallow copy first so all scalar fields are right */
-        AST *lam = calloc(1, sizeof(AST));
+        AST *lam = ast_node_alloc();
         *lam = *node;
         lam->literal_str = node->literal_str ? xstrdup(node->literal_str) : NULL;
 
@@ -545,7 +586,7 @@ static AST *subst(AST *node, BindTable *bt, RenameTable *rt,
             node->range.is_array);
 
     case AST_REFINEMENT: {
-        AST *r = calloc(1, sizeof(AST));
+        AST *r = ast_node_alloc();
         *r = *node;
         r->refinement.name       = xstrdup(node->refinement.name);
         r->refinement.var        = xstrdup(node->refinement.var);
@@ -565,11 +606,16 @@ static AST *subst(AST *node, BindTable *bt, RenameTable *rt,
 
 /// Argument binding
 //
+// g_macro_bind_failures counts rejected call sites so the expansion cache
+// can tell whether an expansion printed a diagnostic.
+//
 // Bind call-site arguments args[0..argc-1] to the macro's parameter list.
 // Fixed params get individual bindings; the rest param (if any) gets a
 // splice binding covering all remaining args.
 // Returns false and prints an error on arity mismatch.
 //
+static unsigned long g_macro_bind_failures = 0;
+
 static bool bind_args(MacroDef *def, AST **args, int argc, BindTable *bt) {
     /* Split params into fixed and optional rest */
     int  fixed   = 0;
@@ -583,12 +629,14 @@ static bool bind_args(MacroDef *def, AST **args, int argc, BindTable *bt) {
         fprintf(stderr,
                 "[macro] '%s': expected at least %d arg(s), got %d\n",
                 def->name, fixed, argc);
+        g_macro_bind_failures++;
         return false;
     }
     if (rest_at < 0 && argc != fixed) {
         fprintf(stderr,
                 "[macro] '%s': expected exactly %d arg(s), got %d\n",
                 def->name, fixed, argc);
+        g_macro_bind_failures++;
         return false;
     }
 
@@ -606,34 +654,273 @@ static bool bind_args(MacroDef *def, AST **args, int argc, BindTable *bt) {
     return true;
 }
 
+/// Expansion cache
+//
+// An expansion that renamed nothing and rejected no call site is a pure
+// function of the macro and its argument trees, source positions
+// included.  Such results are kept, keyed on the macro and a structural
+// hash of the arguments, so a call repeated verbatim -- a zero-argument
+// macro, or a call written inside another macro's template -- is cloned
+// instead of substituted and walked again.  Only plain data nodes
+// (atoms, lists, arrays) take part; anything else is never cached.
+//
+// Most call sites are unique, so the first sighting only records the key
+// (the call's own argument nodes, moved rather than copied).  The result
+// is cloned into the cache when the same key comes round a second time.
+// The cache lives for one macro_expand_all.
+
+#define MACRO_CACHE_INITIAL_BUCKETS 256
+
+typedef struct MacroCacheEntry {
+    MacroDef  *def;
+    uint32_t   hash;
+    int        argc;
+    AST      **args;     // owned: moved out of the first call site
+    AST       *result;   // owned, fully expanded; NULL until seen twice
+    struct MacroCacheEntry *next;
+} MacroCacheEntry;
+
+static MacroCacheEntry **g_macro_cache;
+static size_t            g_macro_cache_buckets;
+static size_t            g_macro_cache_count;
+
+static uint32_t cache_mix(uint32_t h, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        h ^= (uint32_t)(v & 0xFF);
+        h *= 16777619u;
+        v >>= 8;
+    }
+    return h;
+}
+
+static uint32_t cache_mix_str(uint32_t h, const char *s) {
+    if (!s) return cache_mix(h, 0x9E37u);
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return cache_mix(h, 1);
+}
+
+static bool str_eq(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* Folds `node` into *h.  Returns false for node kinds the cache skips. */
+static bool cache_hash_node(const AST *node, uint32_t *h) {
+    if (!node) { *h = cache_mix(*h, 0); return true; }
+
+    uint32_t k = cache_mix(*h, (uint64_t)node->type + 1);
+    k = cache_mix(k, ((uint64_t)(uint32_t)node->line << 32) |
+                     (uint32_t)node->column);
+    k = cache_mix(k, (uint64_t)(uint32_t)node->end_column);
+
+    switch (node->type) {
+    case AST_NUMBER: {
+        uint64_t bits;
+        memcpy(&bits, &node->number, sizeof(bits));
+        k = cache_mix(k, bits);
+        k = cache_mix_str(k, node->literal_str);
+        k = cache_mix(k, node->has_raw_int ? node->raw_int : 0);
+        break;
+    }
+    case AST_SYMBOL:
+        k = cache_mix_str(k, node->symbol);
+        k = cache_mix_str(k, node->literal_str);
+        break;
+    case AST_STRING:
+    case AST_PATH:
+        k = cache_mix_str(k, node->string);
+        break;
+    case AST_KEYWORD:
+        k = cache_mix_str(k, node->keyword);
+        break;
+    case AST_CHAR:
+        k = cache_mix(k, (unsigned char)node->character);
+        break;
+    case AST_RATIO:
+        k = cache_mix(k, (uint64_t)node->ratio.numerator);
+        k = cache_mix(k, (uint64_t)node->ratio.denominator);
+        break;
+    case AST_LIST:
+        k = cache_mix(k, node->list.count);
+        for (size_t i = 0; i < node->list.count; i++)
+            if (!cache_hash_node(node->list.items[i], &k)) return false;
+        break;
+    case AST_ARRAY:
+        k = cache_mix(k, node->array.element_count);
+        k = cache_mix(k, node->array.is_heap);
+        for (size_t i = 0; i < node->array.element_count; i++)
+            if (!cache_hash_node(node->array.elements[i], &k)) return false;
+        break;
+    default:
+        return false;
+    }
+    if (node->inferred_type) return false;
+    *h = k;
+    return true;
+}
+
+/* Structural equality over the node kinds cache_hash_node accepts. */
+static bool cache_node_eq(const AST *a, const AST *b) {
+    if (!a || !b) return a == b;
+    if (a->type != b->type || a->line != b->line ||
+        a->column != b->column || a->end_column != b->end_column)
+        return false;
+
+    switch (a->type) {
+    case AST_NUMBER:
+        return memcmp(&a->number, &b->number, sizeof(a->number)) == 0 &&
+               str_eq(a->literal_str, b->literal_str) &&
+               a->has_raw_int == b->has_raw_int &&
+               (!a->has_raw_int || a->raw_int == b->raw_int);
+    case AST_SYMBOL:
+        return str_eq(a->symbol, b->symbol) &&
+               str_eq(a->literal_str, b->literal_str);
+    case AST_STRING:
+    case AST_PATH:
+        return str_eq(a->string, b->string);
+    case AST_KEYWORD:
+        return str_eq(a->keyword, b->keyword);
+    case AST_CHAR:
+        return a->character == b->character;
+    case AST_RATIO:
+        return a->ratio.numerator == b->ratio.numerator &&
+               a->ratio.denominator == b->ratio.denominator;
+    case AST_LIST:
+        if (a->list.count != b->list.count) return false;
+        for (size_t i = 0; i < a->list.count; i++)
+            if (!cache_node_eq(a->list.items[i], b->list.items[i])) return false;
+        return true;
+    case AST_ARRAY:
+        if (a->array.element_count != b->array.element_count ||
+            a->array.is_heap != b->array.is_heap)
+            return false;
+        for (size_t i = 0; i < a->array.element_count; i++)
+            if (!cache_node_eq(a->array.elements[i], b->array.elements[i]))
+                return false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool cache_key(MacroDef *def, AST **args, int argc, uint32_t *out) {
+    uint32_t h = cache_mix(2166136261u, (uint64_t)(uintptr_t)def);
+    h = cache_mix(h, (uint64_t)argc);
+    for (int i = 0; i < argc; i++)
+        if (!cache_hash_node(args[i], &h)) return false;
+    *out = h;
+    return true;
+}
+
+static MacroCacheEntry *cache_find(MacroDef *def, uint32_t h,
+                                   AST **args, int argc) {
+    if (!g_macro_cache) return NULL;
+    for (MacroCacheEntry *e = g_macro_cache[h % g_macro_cache_buckets]; e; e = e->next) {
+        if (e->def != def || e->hash != h || e->argc != argc) continue;
+        bool same = true;
+        for (int i = 0; i < argc && same; i++)
+            same = cache_node_eq(e->args[i], args[i]);
+        if (same) return e;
+    }
+    return NULL;
+}
+
+static void cache_grow(void) {
+    size_t n = g_macro_cache_buckets ? g_macro_cache_buckets * 2
+                                     : MACRO_CACHE_INITIAL_BUCKETS;
+    MacroCacheEntry **buckets = calloc(n, sizeof(MacroCacheEntry *));
+    for (size_t b = 0; b < g_macro_cache_buckets; b++) {
+        MacroCacheEntry *e = g_macro_cache[b];
+        while (e) {
+            MacroCacheEntry *next = e->next;
+            e->next = buckets[e->hash % n];
+            buckets[e->hash % n] = e;
+            e = next;
+        }
+    }
+    free(g_macro_cache);
+    g_macro_cache         = buckets;
+    g_macro_cache_buckets = n;
+}
+
+/* Records the key of `call`, taking its argument nodes (leaving NULLs
+ * behind). */
+static void cache_insert(MacroDef *def, uint32_t h, AST *call) {
+    if (g_macro_cache_count >= g_macro_cache_buckets)
+        cache_grow();
+    int argc = (int)call->list.count - 1;
+    MacroCacheEntry *e = malloc(sizeof(MacroCacheEntry));
+    e->def    = def;
+    e->hash   = h;
+    e->argc   = argc;
+    e->args   = malloc(sizeof(AST*) * (argc ? argc : 1));
+    for (int i = 0; i < argc; i++) {
+        e->args[i] = call->list.items[i + 1];
+        call->list.items[i + 1] = NULL;
+    }
+    e->result = NULL;
+    e->next   = g_macro_cache[h % g_macro_cache_buckets];
+    g_macro_cache[h % g_macro_cache_buckets] = e;
+    g_macro_cache_count++;
+}
+
+static void cache_clear(void) {
+    for (size_t b = 0; b < g_macro_cache_buckets; b++) {
+        MacroCacheEntry *e = g_macro_cache[b];
+        while (e) {
+            MacroCacheEntry *next = e->next;
+            for (int i = 0; i < e->argc; i++)
+                ast_free(e->args[i]);
+            free(e->args);
+            ast_free(e->result);
+            free(e);
+            e = next;
+        }
+    }
+    free(g_macro_cache);
+    g_macro_cache         = NULL;
+    g_macro_cache_buckets = 0;
+    g_macro_cache_count   = 0;
+}
+
 /// Expansion engine
+//
+// One outside-in walk.  A macro call is expanded where it is met and its
+// result is expanded again at once, so a chain of macros reaches its
+// fixpoint locally and nothing already expanded is walked twice.  Each
+// nested expansion counts towards MACRO_MAX_DEPTH, which is what stops a
+// macro that keeps expanding into itself.
+
+#define MACRO_MAX_DEPTH 1024
+
+static int g_macro_depth = 0;
 
 /* Forward declaration */
-static AST *expand_node(AST *node, bool *changed);
+static AST *expand_node(AST *node);
+
+static MacroDef *macro_call_def(AST *node) {
+    if (!node || node->type != AST_LIST || node->list.count < 1)
+        return NULL;
+    AST *head = node->list.items[0];
+    if (!head || head->type != AST_SYMBOL)
+        return NULL;
+    return registry_lookup(head->symbol);
+}
 
 /*
- * try_expand(node, changed)
+ * try_expand(def, node)
  *
- * If node is a list call whose head is a registered macro, expand it:
+ * Expand one call site of `def` without freeing it:
  *   1. bind call-site args → BindTable
- *   2. collect introduced names → RenameTable
+ *   2. rename the body's introduced names → RenameTable
  *   3. subst() the body
- *   4. free the original call node (carefully — args are referenced by bt)
  *
- * Returns the expansion result (a new AST).
- * Returns node unchanged if it's not a macro call.
+ * Returns the expansion (a new AST), or NULL when the arguments do not
+ * fit the macro's parameters.
  */
-static AST *try_expand(AST *node, bool *changed) {
-    if (!node || node->type != AST_LIST || node->list.count < 1)
-        return node;
-
-    AST *head = node->list.items[0];
-    if (!head || head->type != AST_SYMBOL)
-        return node;
-
-    MacroDef *def = registry_lookup(head->symbol);
-    if (!def) return node;
-
+static AST *try_expand(MacroDef *def, AST *node) {
     int   argc = (int)node->list.count - 1;
     AST **args = node->list.items + 1;   /* pointers into node's items array */
 
@@ -642,23 +929,22 @@ static AST *try_expand(AST *node, bool *changed) {
     bt_init(&bt);
     if (!bind_args(def, args, argc, &bt)) {
         bt_free(&bt);
-        return node;
+        return NULL;
     }
 
-    /* §5 — collect introduced names */
-    char **intro     = NULL;
-    int    intro_n   = 0;
-    int    intro_cap = 0;
-    collect_introduced(def->body, &bt, &intro, &intro_n, &intro_cap);
+    /* §5 — collect introduced names, once per macro */
+    if (!def->intro_ready) {
+        int intro_cap = 0;
+        collect_introduced(def->body, &bt, &def->intro, &def->intro_count,
+                           &intro_cap);
+        def->intro_ready = true;
+    }
 
     /* §3 — build rename table from collected names */
     RenameTable rt;
     rt_init(&rt);
-    for (int i = 0; i < intro_n; i++) {
-        rt_rename(&rt, intro[i], def->name);
-        free(intro[i]);
-    }
-    free(intro);
+    for (int i = 0; i < def->intro_count; i++)
+        rt_rename(&rt, def->intro[i], def->name);
 
     /* §6 — substitute */
     AST *result = subst(def->body, &bt, &rt, def->name);
@@ -666,49 +952,86 @@ static AST *try_expand(AST *node, bool *changed) {
     bt_free(&bt);
     rt_free(&rt);
 
-    /*
-     * Free the call-site node carefully.
-     * The items array contains:
-     *   items[0] = head symbol  → free normally via ast_free
-     *   items[1..] = args       → they have been *cloned* inside subst(),
-     *                             so we must free the originals too.
-     * We free the whole node via ast_free which recursively frees children.
-     */
-    ast_free(node);
-
-    *changed = true;
     fprintf(stderr, "[macro] expanded '%s'\n", def->name);
     return result;
 }
 
 /*
- * expand_node(node, changed)
+ * expand_call(def, node)
+ *
+ * Expand the call site `node` to its local fixpoint and free it.  The
+ * arguments were cloned into the result by subst(), so the whole call
+ * node goes, unless the cache keeps its arguments as the key.
+ */
+static AST *expand_call(MacroDef *def, AST *node) {
+    int      argc = (int)node->list.count - 1;
+    AST    **args = node->list.items + 1;
+    uint32_t h    = 0;
+    bool cacheable = cache_key(def, args, argc, &h);
+
+    MacroCacheEntry *seen = cacheable ? cache_find(def, h, args, argc) : NULL;
+    if (seen && seen->result) {
+        fprintf(stderr, "[macro] expanded '%s'\n", def->name);
+        ast_free(node);
+        return ast_clone(seen->result);
+    }
+
+    unsigned long gensyms  = g_macro_gensym;
+    unsigned long failures = g_macro_bind_failures;
+
+    AST *expanded = try_expand(def, node);
+    if (!expanded) return NULL;
+
+    if (++g_macro_depth > MACRO_MAX_DEPTH) {
+        fprintf(stderr,
+                "[macro] error: macro expansion nested more than %d levels "
+                "deep in '%s' — recursive macro detected, aborting\n",
+                MACRO_MAX_DEPTH, def->name);
+        exit(1);
+    }
+    AST *result = expand_node(expanded);
+    g_macro_depth--;
+
+    if (cacheable && gensyms == g_macro_gensym &&
+        failures == g_macro_bind_failures) {
+        if (seen)
+            seen->result = ast_clone(result);
+        else
+            cache_insert(def, h, node);
+    }
+    ast_free(node);
+    return result;
+}
+
+/*
+ * expand_node(node)
  *
  * Recursively walk node, expanding any macro call sites found.
  * May return a different pointer if the node itself was a macro call.
  * Mutates list/lambda children in place for everything else.
  */
-static AST *expand_node(AST *node, bool *changed) {
+static AST *expand_node(AST *node) {
     if (!node) return NULL;
 
-    /* Try expanding this node first; if it was a macro call we get
-     * a fresh node back and immediately recurse into it. */
-    AST *expanded = try_expand(node, changed);
-    if (expanded != node)
-        return expand_node(expanded, changed);
+    MacroDef *def = macro_call_def(node);
+    if (def) {
+        AST *expanded = expand_call(def, node);
+        if (expanded) return expanded;
+        /* Rejected call: leave it and expand inside its arguments. */
+    }
 
     /* Not a macro call — descend into children */
     switch (node->type) {
 
     case AST_LIST:
         for (size_t i = 0; i < node->list.count; i++)
-            node->list.items[i] = expand_node(node->list.items[i], changed);
+            node->list.items[i] = expand_node(node->list.items[i]);
         break;
 
     case AST_LAMBDA:
         for (int i = 0; i < node->lambda.body_count; i++)
             node->lambda.body_exprs[i] =
-                expand_node(node->lambda.body_exprs[i], changed);
+                expand_node(node->lambda.body_exprs[i]);
         if (node->lambda.body_count > 0)
             node->lambda.body =
                 node->lambda.body_exprs[node->lambda.body_count - 1];
@@ -717,37 +1040,37 @@ static AST *expand_node(AST *node, bool *changed) {
     case AST_ARRAY:
         for (size_t i = 0; i < node->array.element_count; i++)
             node->array.elements[i] =
-                expand_node(node->array.elements[i], changed);
+                expand_node(node->array.elements[i]);
         break;
 
     case AST_SET:
         for (size_t i = 0; i < node->set.element_count; i++)
             node->set.elements[i] =
-                expand_node(node->set.elements[i], changed);
+                expand_node(node->set.elements[i]);
         break;
 
     case AST_MAP:
         for (size_t i = 0; i < node->map.count; i++) {
-            node->map.keys[i] = expand_node(node->map.keys[i], changed);
-            node->map.vals[i] = expand_node(node->map.vals[i], changed);
+            node->map.keys[i] = expand_node(node->map.keys[i]);
+            node->map.vals[i] = expand_node(node->map.vals[i]);
         }
         break;
 
     case AST_RANGE:
-        node->range.start = expand_node(node->range.start, changed);
-        node->range.step  = expand_node(node->range.step,  changed);
-        node->range.end   = expand_node(node->range.end,   changed);
+        node->range.start = expand_node(node->range.start);
+        node->range.step  = expand_node(node->range.step);
+        node->range.end   = expand_node(node->range.end);
         break;
 
     case AST_REFINEMENT:
         node->refinement.predicate =
-            expand_node(node->refinement.predicate, changed);
+            expand_node(node->refinement.predicate);
         break;
 
     case AST_TESTS:
         for (int i = 0; i < node->tests.count; i++)
             node->tests.assertions[i] =
-                expand_node(node->tests.assertions[i], changed);
+                expand_node(node->tests.assertions[i]);
         break;
 
     default:
@@ -828,22 +1151,10 @@ ASTList macro_expand_all(AST **exprs, size_t count) {
         }
     }
 
-    /* ---- Phase 2: expand to fixpoint ---- */
-    int  rounds  = 0;
-    bool changed = true;
-    while (changed && rounds < 64) {
-        changed = false;
-        for (size_t i = 0; i < kept_count; i++)
-            kept[i] = expand_node(kept[i], &changed);
-        rounds++;
-    }
-
-    if (rounds >= 64) {
-        fprintf(stderr,
-                "[macro] error: macro expansion did not reach fixpoint after "
-                "64 rounds — recursive macro detected, aborting\n");
-        exit(1);
-    }
+    /* ---- Phase 2: expand, each call site to its own fixpoint ---- */
+    for (size_t i = 0; i < kept_count; i++)
+        kept[i] = expand_node(kept[i]);
+    cache_clear();
 
     ASTList result;
     result.exprs = kept;
@@ -29,8 +29,8 @@
  * this expander walks and substitutes into like any other body.
  *
  * Expansion runs after parse_all / wisp_parse_all, before type-checking
- * and codegen.  It repeats to a fixpoint so macros can expand into other
- * macro calls.
+ * and codegen.  Each call site is expanded to its own fixpoint in a single
+ * outside-in walk, so macros can expand into other macro calls.
  *
  * Hygiene
  * -------
@@ -68,8 +68,9 @@
  *
  *   1. Scan for defines whose lambda has return_type "Syntax" → register
  *      them and remove them from the output (macros are compile-time only).
- *   2. Walk every remaining AST looking for macro call sites → expand.
- *   3. Repeat step 2 to fixpoint (capped at 1 024 rounds).
+ *   2. Walk every remaining AST once; each macro call site is expanded
+ *      and its result expanded again until no macro call is left there.
+ *      More than 1 024 nested expansions is a recursive macro: exit(1).
  *
  * Returns a new ASTList.  The caller owns the returned exprs array
  * and should free() it after use; individual AST nodes are live.
@@ -85,6 +86,25 @@ ASTList macro_expand_all(AST **exprs, size_t count);
  */
 int macro_is_registered(const char *name);
 
+/*
+ * macro_count() / macro_at(index, &name)
+ *
+ * Registered macros in registration order: macro_at returns the defining
+ * lambda of the index-th macro (and its name), or NULL past the end.  A
+ * caller can note macro_count() before a compilation unit and read back
+ * the macros it defined.
+ */
+size_t macro_count(void);
+const AST *macro_at(size_t index, const char **name);
+
+/*
+ * macro_register(name, lambda)
+ *
+ * Register a macro from its Syntax-returning lambda exactly as if its
+ * define had been seen by macro_expand_all.  Takes ownership of lambda.
+ */
+void macro_register(const char *name, AST *lambda);
+
 /*
  * macro_clear()
  *
@@ -8,11 +8,16 @@
 #include <dirent.h>
 #if defined(_WIN32)
 #include <stdlib.h>
+#else
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
 #include "reader.h"
 #include "compat.h"
 #include "cli.h"
+#include "time_trace.h"
 #include "types.h"
 #include "env.h"
 #include "repl.h"
@@ -25,15 +30,23 @@
 #include "ffi.h"
 #include "wisp.h"
 #include "dep.h"
+#include "infer.h"
 #include "typst_emit.h"
 #include "optimizations.h"
 #include "bytecode.h"
+#include "bytecode_lower.h"
+#include "iface.h"
+#include "macro.h"
+#include "daemon.h"
+#include "config.h"
 
 #include <llvm-c/Core.h>
 #include <llvm-c/Target.h>
 #include <llvm-c/Analysis.h>
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/TargetMachine.h>
+#include <llvm-c/Support.h>
+#include <llvm-c/Transforms/PassBuilder.h>
 
 // In-memory compiled-module registry
 
@@ -59,6 +72,7 @@ typedef struct CompiledModule {
     char           *obj_path;
     bool            was_skipped;    // compiled from .o timestamp, no LLVMValueRef
     bool            compiling;      // reserved during recursive dependency scan
+    char            cache_key[MODULE_HASH_HEX_LEN + 1]; // object cache key, "" until emitted
     CompiledExport *exports;
     size_t          export_count;
     size_t          export_cap;
@@ -66,6 +80,13 @@ typedef struct CompiledModule {
     size_t          layout_count;
     size_t          layout_cap;
     TypeClassRegistry *tc_registry;
+    char           *source_path;    // as passed to compile_one; NULL until compiled
+    bool            uses_ffi;       // touched the global FFI context while compiling
+    // Process-wide finite type sets / refinements this module registered:
+    // the list nodes from *_first up to (not including) *_end.
+    const FiniteTypeSetEntry *finite_first, *finite_end;
+    const RefinementEntry    *refine_first, *refine_end;
+    size_t          macro_first, macro_end;  // macro_at() indices it registered
     struct CompiledModule *next;
 } CompiledModule;
 
@@ -242,8 +263,9 @@ static CompiledModule *registry_find_by_obj(const char *obj_path) {
  * There is no ExprArray type and no AST_METHOD node in main.c.
  */
 
-static CompiledModule *registry_new(const char *name, const char *obj,
-                                     bool skipped) {
+// An entry not yet visible to lookups; registry_link publishes it.
+static CompiledModule *registry_alloc(const char *name, const char *obj,
+                                      bool skipped) {
     CompiledModule *m = calloc(1, sizeof(CompiledModule));
     m->module_name  = strdup(name);
     m->obj_path     = strdup(obj);
@@ -254,8 +276,18 @@ static CompiledModule *registry_new(const char *name, const char *obj,
     m->layout_cap   = 8;
     m->layouts      = malloc(sizeof(CompiledLayout) * 8);
     m->tc_registry  = tc_registry_create();
-    m->next         = g_compiled;
-    g_compiled      = m;
+    return m;
+}
+
+static void registry_link(CompiledModule *m) {
+    m->next    = g_compiled;
+    g_compiled = m;
+}
+
+static CompiledModule *registry_new(const char *name, const char *obj,
+                                     bool skipped) {
+    CompiledModule *m = registry_alloc(name, obj, skipped);
+    registry_link(m);
     return m;
 }
 
@@ -355,35 +387,54 @@ static void register_compiled_module_wisp_arities(CompiledModule *m) {
     }
 }
 
+static void registry_clear_module(CompiledModule *m) {
+    free(m->module_name);
+    free(m->obj_path);
+    for (size_t i = 0; i < m->export_count; i++) {
+        CompiledExport *e = &m->exports[i];
+        free(e->local_name);
+        free(e->mangled_name);
+        type_free(e->type);
+        type_free(e->return_type);
+        ast_free(e->source_ast);
+        if (e->params) {
+            for (int j = 0; j < e->param_count; j++) {
+                free(e->params[j].name);
+                type_free(e->params[j].type);
+            }
+            free(e->params);
+        }
+    }
+    free(m->exports);
+    for (size_t i = 0; i < m->layout_count; i++) {
+        free(m->layouts[i].name);
+        type_free(m->layouts[i].type);
+    }
+    free(m->layouts);
+    tc_registry_free(m->tc_registry);
+    free(m->source_path);
+}
+
+static void registry_free_module(CompiledModule *m) {
+    registry_clear_module(m);
+    free(m);
+}
+
+// Moves an unlinked entry into `slot` (e.g. a placeholder reserved by
+// compile_one), keeping slot's place in the registry list.
+static void registry_adopt(CompiledModule *slot, CompiledModule *m) {
+    CompiledModule *next = slot->next;
+    registry_clear_module(slot);
+    *slot = *m;
+    slot->next = next;
+    free(m);
+}
+
 static void registry_free_all(void) {
     CompiledModule *m = g_compiled;
     while (m) {
         CompiledModule *next = m->next;
-        free(m->module_name);
-        free(m->obj_path);
-        for (size_t i = 0; i < m->export_count; i++) {
-            CompiledExport *e = &m->exports[i];
-            free(e->local_name);
-            free(e->mangled_name);
-            type_free(e->type);
-            type_free(e->return_type);
-            ast_free(e->source_ast);
-            if (e->params) {
-                for (int j = 0; j < e->param_count; j++) {
-                    free(e->params[j].name);
-                    type_free(e->params[j].type);
-                }
-                free(e->params);
-            }
-        }
-        free(m->exports);
-        for (size_t i = 0; i < m->layout_count; i++) {
-            free(m->layouts[i].name);
-            type_free(m->layouts[i].type);
-        }
-        free(m->layouts);
-        tc_registry_free(m->tc_registry);
-        free(m);
+        registry_free_module(m);
         m = next;
     }
     g_compiled = NULL;
@@ -402,7 +453,44 @@ const char **repl_get_compiled_obj_paths(void) {
 
 /// Helpers
 
+// Sources are mapped read-only rather than copied, so a large generated
+// module costs page cache instead of heap and is paged in as the reader
+// walks it.  The text must stay NUL-terminated: the tail of the last page
+// past EOF reads as zeros, so a file whose size is an exact multiple of
+// the page size (or one that cannot be mapped) is read into the heap as
+// before.  Nothing may write through the returned pointer; release it
+// with free_source.
+typedef struct MappedSource {
+    char                *text;
+    size_t               len;
+    struct MappedSource *next;
+} MappedSource;
+
+static MappedSource *g_mapped_sources;
+
 static char *read_file(const char *path) {
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        long page = sysconf(_SC_PAGESIZE);
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            page > 0 && st.st_size % page != 0) {
+            void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                close(fd);
+                madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+                MappedSource *m = malloc(sizeof(*m));
+                m->text = p;
+                m->len  = (size_t)st.st_size;
+                m->next = g_mapped_sources;
+                g_mapped_sources = m;
+                return m->text;
+            }
+        }
+        close(fd);
+    }
+#endif
     FILE *f = fopen(path, "rb");
     if (!f) { fprintf(stderr, "Cannot open file: %s\n", path); exit(1); }
     fseek(f, 0, SEEK_END); long sz = ftell(f); fseek(f, 0, SEEK_SET);
@@ -412,6 +500,21 @@ static char *read_file(const char *path) {
     return src;
 }
 
+static void free_source(char *src) {
+    if (!src) return;
+    for (MappedSource **mp = &g_mapped_sources; *mp; mp = &(*mp)->next) {
+        if ((*mp)->text != src) continue;
+        MappedSource *m = *mp;
+        *mp = m->next;
+#if !defined(_WIN32)
+        munmap(m->text, m->len);
+#endif
+        free(m);
+        return;
+    }
+    free(src);
+}
+
 static time_t file_mtime(const char *path) {
     struct stat st;
     return (stat(path, &st) == 0) ? st.st_mtime : 0;
@@ -466,30 +569,83 @@ static char *host_realpath(const char *path, char *resolved)
 #endif
 }
 
+/* Spawning llvm-config costs more than most links, and its answer only
+ * changes with the LLVM install.  Remember it per process, and on disk as
+ * ~/.cache/monad/llvm-config-<hash>.flags keyed by the llvm-config found
+ * on PATH (its path, size and mtime). */
 static char *llvm_config_link_flags(void)
 {
-    FILE *pipe = popen("llvm-config --ldflags --libs core orcjit native passes", "r");
-    if (!pipe)
-        return strdup("");
-
-    char buf[1024];
-    size_t used = 0;
-    while (used + 1 < sizeof(buf)) {
-        size_t n = fread(buf + used, 1, sizeof(buf) - used - 1, pipe);
-        used += n;
-        if (n == 0)
-            break;
+    static char *memo = NULL;
+    if (memo)
+        return strdup(memo);
+
+    char cache_path[1200] = "";
+    const char *home = getenv("HOME");
+    const char *path_env = getenv("PATH");
+    if (home && *home && path_env) {
+#if defined(_WIN32)
+        const char sep = ';';
+        const char *exe = "llvm-config.exe";
+#else
+        const char sep = ':';
+        const char *exe = "llvm-config";
+#endif
+        for (const char *p = path_env; *p; ) {
+            const char *end = strchr(p, sep);
+            size_t len = end ? (size_t)(end - p) : strlen(p);
+            char candidate[1024];
+            struct stat st;
+            if (len > 0 && len + strlen(exe) + 2 < sizeof(candidate)) {
+                snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)len, p, exe);
+                if (stat(candidate, &st) == 0) {
+                    char stamp[64];
+                    snprintf(stamp, sizeof(stamp), " %lld %lld",
+                             (long long)st.st_size, (long long)st.st_mtime);
+                    uint64_t h = module_hash_update(MODULE_HASH_SEED, candidate,
+                                                    strlen(candidate));
+                    h = module_hash_update(h, stamp, strlen(stamp));
+                    ensure_cache_dir(home);
+                    snprintf(cache_path, sizeof(cache_path),
+                             "%s/.cache/monad/llvm-config-%016llx.flags",
+                             home, (unsigned long long)h);
+                    break;
+                }
+            }
+            if (!end) break;
+            p = end + 1;
+        }
     }
-    pclose(pipe);
-    buf[used] = '\0';
 
-    for (size_t i = 0; i < used; i++) {
-        if (buf[i] == '\r' || buf[i] == '\n')
-            buf[i] = ' ';
+    if (cache_path[0]) {
+        FILE *f = fopen(cache_path, "rb");
+        if (f) {
+            char buf[8192];
+            size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+            bool complete = feof(f);
+            fclose(f);
+            if (complete) {
+                buf[n] = '\0';
+                memo = strdup(buf);
+                return strdup(memo);
+            }
+        }
+    }
+
+    memo = strdup(build_llvm_link_flags());
+    if (cache_path[0] && memo[0]) {
+        char tmp[1300];
+        snprintf(tmp, sizeof(tmp), "%s.tmp%ld", cache_path, (long)getpid());
+        FILE *f = fopen(tmp, "wb");
+        if (f) {
+            bool ok = fputs(memo, f) >= 0;
+            if (fclose(f) != 0) ok = false;
+#if defined(_WIN32)
+            if (ok) remove(cache_path);
+#endif
+            if (!ok || rename(tmp, cache_path) != 0) remove(tmp);
+        }
     }
-    while (used > 0 && (buf[used - 1] == ' ' || buf[used - 1] == '\t'))
-        buf[--used] = '\0';
-    return strdup(buf);
+    return strdup(memo);
 }
 
 static bool dir_prefix_matches(const char *path, const char *dir) {
@@ -591,31 +747,53 @@ static char *monad_core_dir(void) {
     return strdup("/usr/local/lib/monad/core");
 }
 
-static char *runtime_archive_path(void) {
-    const char *env_runtime = getenv("MONAD_RUNTIME_LIB");
+// Environment override, then the checkout, then beside the binary, then
+// the install prefix relative to it.  NULL when none of them exist.
+static char *runtime_archive_find(const char *env_name, const char *file_name) {
+    const char *env_runtime = getenv(env_name);
     if (env_runtime && *env_runtime)
         return strdup(env_runtime);
 
-    if (file_exists("libmonad.a"))
-        return strdup("libmonad.a");
+    if (file_exists(file_name))
+        return strdup(file_name);
 
     if (g_program_path) {
         char *bin_dir = dirname_dup(g_program_path);
-        char *beside_binary = path_join_dup(bin_dir, "libmonad.a");
+        char *beside_binary = path_join_dup(bin_dir, file_name);
         if (file_exists(beside_binary)) {
             free(bin_dir);
             return beside_binary;
         }
         free(beside_binary);
 
-        char *installed = path_join_dup(bin_dir, "../lib/libmonad.a");
+        char *rel = malloc(strlen(file_name) + 8);
+        sprintf(rel, "../lib/%s", file_name);
+        char *installed = path_join_dup(bin_dir, rel);
+        free(rel);
         free(bin_dir);
         if (file_exists(installed))
             return installed;
         free(installed);
     }
 
-    return strdup("/usr/local/lib/libmonad.a");
+    return NULL;
+}
+
+static char *runtime_archive_path(void) {
+    char *path = runtime_archive_find("MONAD_RUNTIME_LIB", "libmonad.a");
+    return path ? path : strdup("/usr/local/lib/libmonad.a");
+}
+
+// The runtime built as bitcode (make install puts it next to libmonad.a),
+// so --lto can inline rt_* helpers into Monad code.  Without it the link
+// still works, the runtime just stays outside the optimizer's view.
+static char *runtime_lto_archive_path(void) {
+    char *path = runtime_archive_find("MONAD_RUNTIME_LTO_LIB", "libmonad-lto.a");
+    if (path) return path;
+    if (file_exists("/usr/local/lib/libmonad-lto.a"))
+        return strdup("/usr/local/lib/libmonad-lto.a");
+    fprintf(stderr, "note: libmonad-lto.a not found, linking the native runtime\n");
+    return runtime_archive_path();
 }
 
 static char *base_no_ext(const char *path) {
@@ -674,27 +852,542 @@ static LLVMCodeGenOptLevel codegen_opt_level(int level) {
     return LLVMCodeGenLevelAggressive;
 }
 
-static bool emit_object(LLVMModuleRef mod, const char *obj_path, int opt_level) {
+// What a module's emission needs from the command line, copied into each
+// EmitJob so pool workers never read CompilerFlags.
+typedef struct {
+    int         opt_level;
+    LtoMode     lto;
+    const char *cpu;          // NULL = "generic", "native" = host CPU + features
+    bool        time_passes;
+    bool        report_escapes;
+    bool        profile_generate;
+    bool        profile_use;  // the file itself is a process-wide LLVM option
+} EmitOptions;
+
+static EmitOptions emit_options(const CompilerFlags *flags) {
+    EmitOptions o;
+    o.opt_level   = flags->optimization_level;
+    o.lto         = flags->lto;
+    o.cpu         = flags->target_cpu;
+    o.time_passes = flags->time_passes;
+    o.report_escapes   = flags->report_escapes;
+    o.profile_generate = flags->profile_generate;
+    o.profile_use      = flags->profile_use != NULL;
+    return o;
+}
+
+// The host triple, target and CPU description never change within a process.
+// Emit-pool workers read them concurrently, so compile() fills the cache
+// before starting the pool; the compile server fills it once for every
+// request it serves.
+static struct {
+    char         *triple;
+    LLVMTargetRef target;
+    char         *cpu;
+    char         *features;
+} g_host;
+
+static bool host_target_warm(void) {
+    if (g_host.triple) return true;
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+    LLVMInitializeNativeAsmParser();
     char *triple = LLVMGetDefaultTargetTriple();
     char *error  = NULL;
-    LLVMTargetRef target;
-    if (LLVMGetTargetFromTriple(triple, &target, &error) != 0) {
+    if (LLVMGetTargetFromTriple(triple, &g_host.target, &error) != 0) {
         fprintf(stderr, "target error: %s\n", error);
         LLVMDisposeMessage(error); LLVMDisposeMessage(triple); return false;
     }
-    LLVMTargetMachineRef tm = LLVMCreateTargetMachine(
-        target, triple, "generic", "",
+    g_host.cpu      = LLVMGetHostCPUName();
+    g_host.features = LLVMGetHostCPUFeatures();
+    g_host.triple   = triple;
+    return true;
+}
+
+// The CPU name and feature string a -mcpu value resolves to.  "native" is
+// this host's CPU; cache keys hash the resolved pair so a shared cache never
+// hands one host's ISA to another.
+static void host_target_cpu(const char *cpu, const char **name, const char **features) {
+    if (cpu && strcmp(cpu, "native") == 0 && host_target_warm()) {
+        *name     = g_host.cpu;
+        *features = g_host.features;
+        return;
+    }
+    *name     = cpu ? cpu : "generic";
+    *features = "";
+}
+
+static LLVMTargetMachineRef host_target_machine(int opt_level, const char *cpu) {
+    if (!host_target_warm()) return NULL;
+    const char *name, *features;
+    host_target_cpu(cpu, &name, &features);
+    return LLVMCreateTargetMachine(
+        g_host.target, g_host.triple, name, features,
         codegen_opt_level(opt_level), LLVMRelocPIC, LLVMCodeModelDefault);
+}
+
+static double elapsed_ms(const struct timespec *t0, const struct timespec *t1) {
+    return (t1->tv_sec - t0->tv_sec) * 1000.0 + (t1->tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+// Process-wide LLVM options, set once before any worker starts:
+// -time-passes makes every LLVMRunPasses print its own per-pass report, and
+// pgo-instr-use reads its profile from -pgo-test-profile-file.
+static void llvm_configure_options(const CompilerFlags *flags, const char *profdata) {
+    static bool configured = false;
+    if (configured || (!flags->time_passes && !profdata)) return;
+    configured = true;
+    static char profile_opt[1100];
+    const char *argv[3] = { "monad", NULL, NULL };
+    int argc = 1;
+    if (flags->time_passes) argv[argc++] = "-time-passes";
+    if (profdata) {
+        snprintf(profile_opt, sizeof(profile_opt), "-pgo-test-profile-file=%s", profdata);
+        argv[argc++] = profile_opt;
+    }
+    LLVMParseCommandLineOptions(argc, argv, NULL);
+}
+
+// Points the target triple and data layout at the machine we emit for, so
+// the optimizer sees real type sizes and vector widths.
+static void module_set_target(LLVMModuleRef mod, LLVMTargetMachineRef tm) {
+    char *triple = LLVMGetTargetMachineTriple(tm);
+    LLVMSetTarget(mod, triple);
+    LLVMDisposeMessage(triple);
+    LLVMTargetDataRef data = LLVMCreateTargetDataLayout(tm);
+    char *layout = LLVMCopyStringRepOfTargetData(data);
+    LLVMSetDataLayout(mod, layout);
+    LLVMDisposeMessage(layout);
+    LLVMDisposeTargetData(data);
+}
+
+/* Runs after the pipeline, when inlining has exposed which closures are
+ * only ever called in the frame that builds them. */
+static void demote_allocations(LLVMModuleRef mod, const EmitOptions *o,
+                               const char *obj_path) {
+    DemotionStats ds = {0};
+    codegen_demote_allocations(mod, &ds);
+    if (o->report_escapes)
+        fprintf(stderr, "[escape] %s: %d/%d closures, %d/%d argument arrays on the stack\n",
+                obj_path, ds.closures_demoted, ds.closures,
+                ds.arg_arrays_demoted, ds.arg_arrays);
+}
+
+/* optimizations.c works on the AST; this is the LLVM half of -O: the
+ * standard default<On> pipeline (mem2reg/SROA, inlining, GVN, loop and SLP
+ * vectorization).  LTO objects get the pre-link pipeline instead, leaving
+ * cross-module inlining to the link-time optimizer. */
+/* PGO runs first, on the IR exactly as codegen produced it, so the CFG the
+ * counters were taken on is the CFG the profile is matched against.  The
+ * counters cover every branch (pmatch clause tests included) and value-
+ * profile indirect calls; with a profile the branch weights drive block
+ * layout and pgo-icall-prom devirtualizes hot indirect calls. */
+static bool run_pass_pipeline(LLVMModuleRef mod, LLVMTargetMachineRef tm,
+                              const EmitOptions *o, const char *obj_path) {
+    char pipeline[96] = "";
+    if (o->profile_generate)
+        strcpy(pipeline, "pgo-instr-gen,instrprof");
+    else if (o->profile_use)
+        strcpy(pipeline, "pgo-instr-use,pgo-icall-prom");
+    if (o->opt_level > 0) {
+        size_t len = strlen(pipeline);
+        snprintf(pipeline + len, sizeof(pipeline) - len, "%s%s<O%d>",
+                 len ? "," : "",
+                 o->lto == LTO_THIN ? "thinlto-pre-link" :
+                 o->lto == LTO_FULL ? "lto-pre-link" : "default",
+                 o->opt_level);
+    }
+    if (!pipeline[0]) return true;
+
+    struct timespec t0, t1;
+    time_trace_begin("llvm passes", obj_path);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
+    LLVMPassBuilderOptionsSetLoopVectorization(opts, o->opt_level >= 2);
+    LLVMPassBuilderOptionsSetSLPVectorization(opts, o->opt_level >= 2);
+    LLVMPassBuilderOptionsSetLoopUnrolling(opts, o->opt_level >= 2);
+    LLVMErrorRef err = LLVMRunPasses(mod, pipeline, tm, opts);
+    LLVMDisposePassBuilderOptions(opts);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    time_trace_end();
+    if (err) {
+        char *msg = LLVMGetErrorMessage(err);
+        fprintf(stderr, "pass pipeline %s failed for %s: %s\n", pipeline, obj_path, msg);
+        LLVMDisposeErrorMessage(msg);
+        return false;
+    }
+    if (o->time_passes)
+        fprintf(stderr, "[passes] %s: %s %.1f ms\n", obj_path, pipeline,
+                elapsed_ms(&t0, &t1));
+    if (o->opt_level > 0) {
+        time_trace_begin("escape demotion", obj_path);
+        demote_allocations(mod, o, obj_path);
+        time_trace_end();
+    }
+    return true;
+}
+
+static bool emit_object(LLVMModuleRef mod, const char *obj_path, const EmitOptions *o) {
+    LLVMTargetMachineRef tm = host_target_machine(o->opt_level, o->cpu);
+    if (!tm) return false;
+    module_set_target(mod, tm);
+    if (!run_pass_pipeline(mod, tm, o, obj_path)) {
+        LLVMDisposeTargetMachine(tm);
+        return false;
+    }
+    char *error = NULL;
     char buf[512]; strncpy(buf, obj_path, sizeof(buf)-1); buf[511] = '\0';
     bool ok = true;
+    struct timespec t0, t1;
+    time_trace_begin("llvm codegen", obj_path);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     if (LLVMTargetMachineEmitToFile(tm, mod, buf, LLVMObjectFile, &error) != 0) {
         fprintf(stderr, "emit error for %s: %s\n", obj_path, error);
         LLVMDisposeMessage(error); ok = false;
     }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    time_trace_end();
+    if (o->time_passes)
+        fprintf(stderr, "[passes] %s: codegen %.1f ms\n", obj_path, elapsed_ms(&t0, &t1));
     LLVMDisposeTargetMachine(tm);
+    return ok;
+}
+
+static bool file_is_bitcode(const char *path) {
+    unsigned char magic[4] = {0};
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    return n == 4 && magic[0] == 'B' && magic[1] == 'C' &&
+           magic[2] == 0xC0 && magic[3] == 0xDE;
+}
+
+/* With --lto the module's "object" is bitcode for the link-time optimizer.
+ * ThinLTO also needs a module summary, which only the C++ bitcode writer
+ * produces, so thin mode writes plain bitcode and lets clang re-emit it
+ * with a summary. */
+static bool emit_lto_bitcode(LLVMModuleRef mod, const char *obj_path,
+                             const EmitOptions *o) {
+    LLVMTargetMachineRef tm = host_target_machine(o->opt_level, o->cpu);
+    if (!tm) return false;
+    module_set_target(mod, tm);
+    bool piped = run_pass_pipeline(mod, tm, o, obj_path);
+    LLVMDisposeTargetMachine(tm);
+    if (!piped) return false;
+
+    if (o->lto == LTO_FULL) {
+        if (LLVMWriteBitcodeToFile(mod, obj_path) != 0) {
+            fprintf(stderr, "emit error for %s: cannot write bitcode\n", obj_path);
+            return false;
+        }
+        return true;
+    }
+
+    char *pre = malloc(strlen(obj_path) + 8);
+    sprintf(pre, "%s.pre.bc", obj_path);
+    bool ok = LLVMWriteBitcodeToFile(mod, pre) == 0;
+    if (ok) {
+        /* Already optimized above; clang only adds the summary. */
+        char *cmd = malloc(strlen(pre) + strlen(obj_path) + 64);
+        sprintf(cmd, "clang -flto=thin -O0 -c -x ir \"%s\" -o \"%s\"", pre, obj_path);
+        ok = system(cmd) == 0;
+        free(cmd);
+    }
+    if (!ok)
+        fprintf(stderr, "emit error for %s: cannot write ThinLTO bitcode\n", obj_path);
+    remove(pre);
+    free(pre);
+    return ok;
+}
+
+static bool emit_module_file(LLVMModuleRef mod, const char *obj_path,
+                             const EmitOptions *o) {
+    return o->lto == LTO_OFF ? emit_object(mod, obj_path, o)
+                             : emit_lto_bitcode(mod, obj_path, o);
+}
+
+/// Content-addressed object cache
+//
+// mtime-based skipping only helps within one checkout.  Every emitted object
+// is also stored under $MONAD_CACHE_DIR (default ~/.cache/monad/objects),
+// named by a hash of everything that can change its bytes: the source text,
+// the keys of every module compiled before it (deps, the prelude and the
+// primitive type modules it may auto-import), the compiler binary, the
+// optimization level, test mode and the target triple.  A fresh worktree or
+// CI runner with the same inputs copies objects instead of re-emitting them.
+// MONAD_CACHE_DIR=off disables the cache.
+
+static char *object_cache_dir(void) {
+    const char *env = getenv("MONAD_CACHE_DIR");
+    char dir[1024];
+    if (env && *env) {
+        if (strcmp(env, "off") == 0 || strcmp(env, "0") == 0) return NULL;
+        snprintf(dir, sizeof(dir), "%s", env);
+        monad_mkdir(dir);
+    } else {
+        const char *home = getenv("HOME");
+        if (!home || !*home) return NULL;
+        ensure_cache_dir(home);
+        snprintf(dir, sizeof(dir), "%s/.cache/monad/objects", home);
+        monad_mkdir(dir);
+    }
+    return dir_exists(dir) ? strdup(dir) : NULL;
+}
+
+// Hash of the running compiler's executable, computed once.  Falls back to
+// the build timestamp when the binary cannot be located or read.
+const char *compiler_identity_hash(void) {
+    static char id[MODULE_HASH_HEX_LEN + 1];
+    if (id[0]) return id;
+
+    const char *self = g_program_path;
+#if defined(__linux__)
+    if (access("/proc/self/exe", R_OK) == 0) self = "/proc/self/exe";
+#endif
+    uint64_t h = MODULE_HASH_SEED;
+    FILE *f = self ? fopen(self, "rb") : NULL;
+    if (f) {
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            h = module_hash_update(h, buf, n);
+        fclose(f);
+    } else {
+        const char *stamp = __DATE__ " " __TIME__;
+        h = module_hash_update(h, stamp, strlen(stamp));
+    }
+    snprintf(id, sizeof(id), "%016llx", (unsigned long long)h);
+    return id;
+}
+
+static uint64_t hash_str(uint64_t h, const char *s) {
+    return module_hash_update(h, s, strlen(s) + 1);  /* include the NUL as separator */
+}
+
+// Objects built against a profile depend on its contents; size and mtime
+// stand in for a content hash of what is usually a multi-megabyte file.
+static void profile_identity(const CompilerFlags *flags, char *out, size_t size) {
+    struct stat st;
+    if (flags->profile_generate)
+        snprintf(out, size, "pgo-gen");
+    else if (flags->profile_use && stat(flags->profile_use, &st) == 0)
+        snprintf(out, size, "pgo-use %s %lld %lld", flags->profile_use,
+                 (long long)st.st_size, (long long)st.st_mtime);
+    else
+        snprintf(out, size, "%s", flags->profile_use ? flags->profile_use : "");
+}
+
+static void object_cache_key(const CompiledModule *self, const char *source,
+                             const CompilerFlags *flags, char *out) {
+    uint64_t h = hash_str(MODULE_HASH_SEED, "monad-object-v1");
+    h = hash_str(h, compiler_identity_hash());
+    char *triple = LLVMGetDefaultTargetTriple();
+    h = hash_str(h, triple);
     LLVMDisposeMessage(triple);
+    char opts[32];
+    snprintf(opts, sizeof(opts), "O%d t%d lto%d s%d", flags->optimization_level,
+             flags->test_mode ? 1 : 0, (int)flags->lto, flags->profile_sites ? 1 : 0);
+    h = hash_str(h, opts);
+    const char *cpu, *features;
+    host_target_cpu(flags->target_cpu, &cpu, &features);
+    h = hash_str(hash_str(h, cpu), features);
+    char profile[1200];
+    profile_identity(flags, profile, sizeof(profile));
+    h = hash_str(h, profile);
+    for (int i = 0; i < flags->breakpoint_count; i++)
+        h = hash_str(hash_str(h, "break"), flags->breakpoints[i]);
+    for (int i = 0; i < flags->watch_count; i++)
+        h = hash_str(hash_str(h, "watch"), flags->watches[i]);
+    h = hash_str(h, self->module_name);
+    h = hash_str(h, source);
+    for (const CompiledModule *m = g_compiled; m; m = m->next) {
+        if (m == self || !m->cache_key[0]) continue;
+        h = hash_str(h, m->module_name);
+        h = hash_str(h, m->cache_key);
+    }
+    snprintf(out, MODULE_HASH_HEX_LEN + 1, "%016llx", (unsigned long long)h);
+}
+
+// Copies via a temporary and rename so concurrent builds never observe a
+// partially written object.
+static bool copy_file_atomic(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    if (!in) return false;
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.tmp%ld", to, (long)getpid());
+    FILE *out = fopen(tmp, "wb");
+    if (!out) { fclose(in); return false; }
+    char buf[65536];
+    size_t n;
+    bool ok = true;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        if (fwrite(buf, 1, n, out) != n) { ok = false; break; }
+    if (ferror(in)) ok = false;
+    fclose(in);
+    if (fclose(out) != 0) ok = false;
+#if defined(_WIN32)
+    if (ok) remove(to);
+#endif
+    if (!ok || rename(tmp, to) != 0) { remove(tmp); return false; }
+    return true;
+}
+
+static char *object_cache_path(const char *key) {
+    char *dir = object_cache_dir();
+    if (!dir) return NULL;
+    char *path = malloc(strlen(dir) + MODULE_HASH_HEX_LEN + 4);
+    sprintf(path, "%s/%s.o", dir, key);
+    free(dir);
+    return path;
+}
+
+/// Parallel object emission
+//
+// Parsing, inference and IR generation share process-wide state (the module
+// registry, wisp arities, the FFI context), so modules are still lowered one
+// at a time in dependency order.  Machine-code generation, which dominates
+// cold builds, only touches a module's own LLVMContext: once a module is
+// verified its context is handed to a pool of -jN workers and the front-end
+// moves on to the next module.  compile() drains the pool before linking.
+
+typedef struct EmitJob {
+    LLVMContextRef  context;
+    LLVMModuleRef   module;
+    char           *obj_path;
+    char           *source_path;
+    char           *cache_path;     // store the object here once written, or NULL
+    IfaceWriter    *moni;           // interface to save once the object exists, or NULL
+    char           *moni_path;
+    EmitOptions     opts;
+    bool            verbose;
+    struct EmitJob *next;
+} EmitJob;
+
+static void moni_save(IfaceWriter *w, const char *path);
+
+#if !defined(_WIN32)
+typedef struct {
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    pthread_t      *workers;
+    int             worker_count;
+    EmitJob        *head;
+    EmitJob        *tail;
+    bool            closing;
+    bool            failed;
+} EmitPool;
+
+static EmitPool g_emit_pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    NULL, 0, NULL, NULL, false, false
+};
+
+static void emit_job_run(EmitJob *job, bool *failed) {
+    if (!emit_module_file(job->module, job->obj_path, &job->opts)) {
+        fprintf(stderr, "failed to emit object for %s\n", job->source_path);
+        *failed = true;
+    } else {
+        if (job->cache_path) copy_file_atomic(job->obj_path, job->cache_path);
+        if (job->verbose) printf("  wrote object: %s\n", job->obj_path);
+        moni_save(job->moni, job->moni_path);
+        job->moni = NULL;
+    }
+    if (job->moni) {
+        iface_writer_free(job->moni);
+        free(job->moni);
+    }
+    LLVMDisposeModule(job->module);
+    LLVMContextDispose(job->context);
+    free(job->obj_path);
+    free(job->source_path);
+    free(job->cache_path);
+    free(job->moni_path);
+    free(job);
+}
+
+static void *emit_worker(void *arg) {
+    EmitPool *pool = arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->mu);
+        while (!pool->head && !pool->closing)
+            pthread_cond_wait(&pool->cv, &pool->mu);
+        EmitJob *job = pool->head;
+        if (!job) { pthread_mutex_unlock(&pool->mu); return NULL; }
+        pool->head = job->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->mu);
+
+        bool failed = false;
+        emit_job_run(job, &failed);
+        if (failed) {
+            pthread_mutex_lock(&pool->mu);
+            pool->failed = true;
+            pthread_mutex_unlock(&pool->mu);
+        }
+    }
+}
+
+static int host_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+// Starts `jobs` emit workers (0 = one per online CPU).  With a single job the
+// pool stays empty and emit_pool_submit() emits inline, as before.
+static void emit_pool_start(int jobs) {
+    EmitPool *pool = &g_emit_pool;
+    if (jobs <= 0) jobs = host_cpu_count();
+    if (jobs <= 1) return;
+    pool->workers = malloc(sizeof(pthread_t) * jobs);
+    pool->closing = false;
+    pool->failed  = false;
+    for (int i = 0; i < jobs; i++) {
+        if (pthread_create(&pool->workers[i], NULL, emit_worker, pool) != 0) break;
+        pool->worker_count++;
+    }
+    if (pool->worker_count == 0) { free(pool->workers); pool->workers = NULL; }
+}
+
+static bool emit_pool_active(void) {
+    return g_emit_pool.worker_count > 0;
+}
+
+static void emit_pool_submit(EmitJob *job) {
+    EmitPool *pool = &g_emit_pool;
+    job->next = NULL;
+    pthread_mutex_lock(&pool->mu);
+    if (pool->tail) pool->tail->next = job; else pool->head = job;
+    pool->tail = job;
+    pthread_cond_signal(&pool->cv);
+    pthread_mutex_unlock(&pool->mu);
+}
+
+// Waits for every queued module to be written and stops the workers.
+// Returns false if any object failed to emit.
+static bool emit_pool_finish(void) {
+    EmitPool *pool = &g_emit_pool;
+    if (pool->worker_count == 0) return true;
+    pthread_mutex_lock(&pool->mu);
+    pool->closing = true;
+    pthread_cond_broadcast(&pool->cv);
+    pthread_mutex_unlock(&pool->mu);
+    for (int i = 0; i < pool->worker_count; i++)
+        pthread_join(pool->workers[i], NULL);
+    free(pool->workers);
+    pool->workers      = NULL;
+    pool->worker_count = 0;
+    pool->closing      = false;
+    bool ok = !pool->failed;
+    pool->failed = false;
     return ok;
 }
+#else
+static void emit_pool_start(int jobs)       { (void)jobs; }
+static bool emit_pool_active(void)          { return false; }
+static void emit_pool_submit(EmitJob *job)  { (void)job; }
+static bool emit_pool_finish(void)          { return true; }
+#endif
 
 static void declare_externals(CodegenContext *ctx,
                                CompiledModule *dep,
@@ -775,7 +1468,9 @@ static void declare_externals(CodegenContext *ctx,
                 EnvEntry *ent2 = env_lookup(ctx->env, e->local_name);
                 if (ent2) { ent2->module_name = strdup(dep->module_name);
                             ent2->llvm_name   = strdup(e->mangled_name);
-                            ent2->source_ast  = ast_clone(e->source_ast); }
+                            // Same read-only snapshot as the qualified entry.
+                            ent2->source_ast  = ent ? ent->source_ast
+                                                    : ast_clone(e->source_ast); }
             }
         }
     }
@@ -937,6 +1632,315 @@ static void core_module_list_free(CoreModuleList *modules)
     modules->count = 0;
 }
 
+/// Module interface files
+//
+// Next to every library object compile_one writes <module>.moni: the
+// module's registry record plus what it was built against -- the compiler,
+// target and options, a hash of its source, and the name, source path and
+// object cache key of every module whose exports it declared.  When a
+// later compile finds a .moni that still matches all of that, it adopts
+// the record instead of parsing, inferring and lowering the module again,
+// so a module is only re-run when its own source or something it imports
+// changed.  Modules that declare FFI headers get no .moni: importers read
+// those declarations from the global FFI context, which only a full
+// compile populates.
+
+#define MONI_MAGIC   "monad-moni"
+#define MONI_VERSION 2u
+
+// Compiler, target and options: everything besides sources that decides
+// what a cached interface or object contains.  Covers the same inputs as
+// object_cache_key.
+static void build_header_put(IfaceWriter *w, const char *magic, uint32_t version,
+                             const CompilerFlags *flags) {
+    iface_put_str(w, magic);
+    iface_put_u32(w, version);
+    iface_put_str(w, compiler_identity_hash());
+    char *triple = LLVMGetDefaultTargetTriple();
+    iface_put_str(w, triple);
+    LLVMDisposeMessage(triple);
+    iface_put_u32(w, (uint32_t)flags->optimization_level);
+    iface_put_u8(w, flags->test_mode ? 1 : 0);
+    iface_put_u8(w, (uint8_t)flags->lto);
+    iface_put_u8(w, flags->profile_sites ? 1 : 0);
+    const char *cpu, *features;
+    host_target_cpu(flags->target_cpu, &cpu, &features);
+    iface_put_str(w, cpu);
+    iface_put_str(w, features);
+    char profile[1200];
+    profile_identity(flags, profile, sizeof(profile));
+    iface_put_str(w, profile);
+    iface_put_u32(w, (uint32_t)flags->breakpoint_count);
+    for (int i = 0; i < flags->breakpoint_count; i++)
+        iface_put_str(w, flags->breakpoints[i]);
+    iface_put_u32(w, (uint32_t)flags->watch_count);
+    for (int i = 0; i < flags->watch_count; i++)
+        iface_put_str(w, flags->watches[i]);
+}
+
+static bool build_header_check(IfaceReader *r, const char *magic, uint32_t version,
+                               const CompilerFlags *flags) {
+    IfaceWriter expect;
+    iface_writer_init(&expect);
+    build_header_put(&expect, magic, version, flags);
+    unsigned char *got = malloc(expect.len ? expect.len : 1);
+    bool ok = iface_get_bytes(r, got, expect.len) &&
+              memcmp(got, expect.buf, expect.len) == 0;
+    free(got);
+    iface_writer_free(&expect);
+    return ok;
+}
+
+static bool source_content_hash(const char *path, char *out) {
+    if (!file_exists(path)) return false;
+    char *src = read_file(path);
+    module_hash_buffer(src, strlen(src), out);
+    free_source(src);
+    return true;
+}
+
+static void module_record_put(IfaceWriter *w, const CompiledModule *m) {
+    iface_put_str(w, m->module_name);
+    iface_put_str(w, m->obj_path);
+    iface_put_str(w, m->cache_key);
+
+    iface_put_u32(w, (uint32_t)m->export_count);
+    for (size_t i = 0; i < m->export_count; i++) {
+        const CompiledExport *e = &m->exports[i];
+        iface_put_str(w, e->local_name);
+        iface_put_str(w, e->mangled_name);
+        iface_put_u8(w, (uint8_t)e->kind);
+        iface_put_type(w, e->type);
+        iface_put_type(w, e->return_type);
+        iface_put_u32(w, (uint32_t)e->param_count);
+        iface_put_u8(w, e->params ? 1 : 0);
+        for (int j = 0; e->params && j < e->param_count; j++) {
+            iface_put_str(w, e->params[j].name);
+            iface_put_type(w, e->params[j].type);
+        }
+        iface_put_ast(w, e->source_ast);
+    }
+
+    iface_put_u32(w, (uint32_t)m->layout_count);
+    for (size_t i = 0; i < m->layout_count; i++) {
+        iface_put_str(w, m->layouts[i].name);
+        iface_put_type(w, m->layouts[i].type);
+    }
+
+    iface_put_tc_registry(w, m->tc_registry);
+
+    /* The global lists are newest-first; write oldest-first so replaying
+     * them rebuilds the same order. */
+    size_t n = 0;
+    for (const FiniteTypeSetEntry *e = m->finite_first; e && e != m->finite_end; e = e->next) n++;
+    iface_put_u32(w, (uint32_t)n);
+    for (size_t k = n; k > 0; k--) {
+        const FiniteTypeSetEntry *e = m->finite_first;
+        for (size_t i = 1; i < k; i++) e = e->next;
+        iface_put_finite_set(w, e);
+    }
+
+    n = 0;
+    for (const RefinementEntry *e = m->refine_first; e && e != m->refine_end; e = e->next) n++;
+    iface_put_u32(w, (uint32_t)n);
+    for (size_t k = n; k > 0; k--) {
+        const RefinementEntry *e = m->refine_first;
+        for (size_t i = 1; i < k; i++) e = e->next;
+        iface_put_refinement(w, e);
+    }
+
+    iface_put_u32(w, (uint32_t)(m->macro_end - m->macro_first));
+    for (size_t i = m->macro_first; i < m->macro_end; i++) {
+        const char *name = NULL;
+        const AST *lambda = macro_at(i, &name);
+        iface_put_str(w, name);
+        iface_put_ast(w, lambda);
+    }
+}
+
+// Decodes one record into an unlinked registry entry, registering its finite
+// type sets and refinements as it goes.  Returns NULL on a corrupt record.
+static CompiledModule *module_record_get(IfaceReader *r) {
+    char *name = iface_get_str(r);
+    char *obj  = iface_get_str(r);
+    char *key  = iface_get_str(r);
+    if (!r->ok || !name || !obj || !key || strlen(key) > MODULE_HASH_HEX_LEN) {
+        free(name); free(obj); free(key);
+        return NULL;
+    }
+    CompiledModule *m = registry_alloc(name, obj, false);
+    snprintf(m->cache_key, sizeof(m->cache_key), "%s", key);
+    free(name); free(obj); free(key);
+
+    uint32_t count = iface_get_u32(r);
+    for (uint32_t i = 0; r->ok && i < count; i++) {
+        registry_grow(m);
+        CompiledExport *e = &m->exports[m->export_count++];
+        memset(e, 0, sizeof(*e));
+        e->local_name   = iface_get_str(r);
+        e->mangled_name = iface_get_str(r);
+        uint8_t kind    = iface_get_u8(r);
+        e->kind         = (EnvEntryKind)kind;
+        e->type         = iface_get_type(r);
+        e->return_type  = iface_get_type(r);
+        uint32_t params = iface_get_u32(r);
+        if (iface_get_u8(r) && r->ok) {
+            if (params > 4096) { r->ok = false; break; }
+            e->params = calloc(params ? params : 1, sizeof(EnvParam));
+            e->param_count = (int)params;
+            for (uint32_t j = 0; j < params; j++) {
+                e->params[j].name = iface_get_str(r);
+                e->params[j].type = iface_get_type(r);
+            }
+        } else {
+            e->param_count = (int)params;
+        }
+        e->source_ast = iface_get_ast(r);
+        if (kind > ENV_ADT_CTOR || !e->local_name || !e->mangled_name)
+            r->ok = false;
+    }
+
+    count = iface_get_u32(r);
+    for (uint32_t i = 0; r->ok && i < count; i++) {
+        if (m->layout_count >= m->layout_cap) {
+            m->layout_cap *= 2;
+            m->layouts = realloc(m->layouts, sizeof(CompiledLayout) * m->layout_cap);
+        }
+        CompiledLayout *l = &m->layouts[m->layout_count++];
+        l->name = iface_get_str(r);
+        l->type = iface_get_type(r);
+        if (!l->name) r->ok = false;
+    }
+
+    if (r->ok) iface_get_tc_registry(r, m->tc_registry);
+
+    m->finite_end = g_finite_type_sets;
+    count = iface_get_u32(r);
+    for (uint32_t i = 0; r->ok && i < count; i++)
+        if (!iface_get_finite_set(r)) r->ok = false;
+    m->finite_first = g_finite_type_sets;
+
+    m->refine_end = g_refinements;
+    count = iface_get_u32(r);
+    for (uint32_t i = 0; r->ok && i < count; i++)
+        if (!iface_get_refinement(r)) r->ok = false;
+    m->refine_first = g_refinements;
+
+    m->macro_first = macro_count();
+    count = iface_get_u32(r);
+    for (uint32_t i = 0; r->ok && i < count; i++) {
+        char *name = iface_get_str(r);
+        AST *lambda = iface_get_ast(r);
+        if (r->ok && name && lambda && lambda->type == AST_LAMBDA)
+            macro_register(name, lambda);
+        else {
+            ast_free(lambda);
+            r->ok = false;
+        }
+        free(name);
+    }
+    m->macro_end = macro_count();
+
+    if (!r->ok) {
+        registry_free_module(m);
+        return NULL;
+    }
+    return m;
+}
+
+static char *moni_path_for(const char *obj_path) {
+    char *base = base_no_ext(obj_path);
+    char *path = malloc(strlen(base) + 6);
+    sprintf(path, "%s.moni", base);
+    free(base);
+    return path;
+}
+
+static IfaceWriter *moni_build(const CompiledModule *m, const char *source,
+                               CompiledModule **deps, size_t dep_count,
+                               const CompilerFlags *flags) {
+    IfaceWriter *w = malloc(sizeof(IfaceWriter));
+    iface_writer_init(w);
+    build_header_put(w, MONI_MAGIC, MONI_VERSION, flags);
+    char hash[MODULE_HASH_HEX_LEN + 1];
+    module_hash_buffer(source, strlen(source), hash);
+    iface_put_str(w, hash);
+    iface_put_str(w, m->cache_key);
+    iface_put_u32(w, (uint32_t)dep_count);
+    for (size_t i = 0; i < dep_count; i++) {
+        iface_put_str(w, deps[i]->module_name);
+        iface_put_str(w, deps[i]->source_path);
+        iface_put_str(w, deps[i]->cache_key);
+    }
+    module_record_put(w, m);
+    return w;
+}
+
+static void moni_save(IfaceWriter *w, const char *path) {
+    if (!w) return;
+    if (!w->ok || !iface_writer_save(w, path)) remove(path);
+    iface_writer_free(w);
+    free(w);
+}
+
+// Fills the placeholder `slot` from source_path's .moni when it is still
+// valid, compiling any recorded dependency that is not loaded yet.  Returns
+// false, with slot untouched, when the module has to be compiled.
+static bool moni_load(CompiledModule *slot, const char *source_path,
+                      const char *obj_path, CompilerFlags *flags) {
+    char *path = moni_path_for(obj_path);
+    IfaceFile file;
+    if (!iface_file_open(&file, path)) { free(path); return false; }
+    IfaceReader r = iface_reader(&file);
+
+    bool ok = build_header_check(&r, MONI_MAGIC, MONI_VERSION, flags);
+    char *hash = iface_get_str(&r);
+    char *key  = iface_get_str(&r);
+    char now[MODULE_HASH_HEX_LEN + 1];
+    ok = ok && r.ok && hash && key &&
+         source_content_hash(source_path, now) && strcmp(now, hash) == 0;
+
+    uint32_t n = ok ? iface_get_u32(&r) : 0;
+    if (n > 4096) { ok = false; n = 0; }
+    for (uint32_t i = 0; ok && i < n; i++) {
+        char *dep_name = iface_get_str(&r);
+        char *dep_src  = iface_get_str(&r);
+        char *dep_key  = iface_get_str(&r);
+        ok = r.ok && dep_name && dep_key;
+        CompiledModule *dep = ok ? registry_find(dep_name) : NULL;
+        if (ok && !dep && dep_src && file_exists(dep_src))
+            dep = compile_one(dep_src, flags, false);
+        ok = ok && dep && !dep->compiling && strcmp(dep->cache_key, dep_key) == 0;
+        if (!ok && (flags->verbose_level > 0 || flags->trace_codegen))
+            printf("[moni]    %s: dependency %s changed\n", source_path,
+                   dep_name ? dep_name : "?");
+        free(dep_name); free(dep_src); free(dep_key);
+    }
+
+    if (ok && (!file_exists(obj_path) ||
+               file_is_bitcode(obj_path) != (flags->lto != LTO_OFF))) {
+        char *cached = object_cache_path(key);
+        ok = cached && file_exists(cached) && copy_file_atomic(cached, obj_path);
+        free(cached);
+    }
+
+    CompiledModule *m = ok ? module_record_get(&r) : NULL;
+    if (m) {
+        registry_adopt(slot, m);
+        free(slot->obj_path);
+        slot->obj_path    = strdup(obj_path);
+        slot->source_path = strdup(source_path);
+        register_compiled_module_wisp_arities(slot);
+        if (flags->verbose_level > 0 || flags->trace_codegen)
+            printf("[moni]    %s (interface is up to date)\n", source_path);
+    }
+    free(hash);
+    free(key);
+    iface_file_close(&file);
+    free(path);
+    return m != NULL;
+}
+
 static void compile_prelude_dir(const char *dir, const char *current_source,
                                 CompilerFlags *flags, const char *source)
 {
@@ -975,28 +1979,17 @@ static void compile_prelude_dir(const char *dir, const char *current_source,
 }
 
 static void compile_prelude_modules(const char *current_source,
-                                    CompilerFlags *flags, const char *source)
+                                    CompilerFlags *flags, const char *source,
+                                    const ModuleHeader *header)
 {
     if (source_is_prelude_file(current_source))
         return;
 
+    /* Core library files that import anything manage their own deps. */
     char *core_dir = monad_core_dir();
-    bool is_core_library = dir_prefix_matches(current_source, core_dir);
-
-    if (is_core_library) {
-        const char *p = source;
-        while (*p) {
-            while (*p == ' ' || *p == '\t') p++;
-            if ((strncmp(p, "import", 6) == 0 &&
-                 (p[6] == ' ' || p[6] == '\t')) ||
-                (*p == '(' && strncmp(p + 1, "import", 6) == 0 &&
-                 (p[7] == ' ' || p[7] == '\t'))) {
-                free(core_dir);
-                return;
-            }
-            while (*p && *p != '\n') p++;
-            if (*p == '\n') p++;
-        }
+    if (header->import_count > 0 && dir_prefix_matches(current_source, core_dir)) {
+        free(core_dir);
+        return;
     }
 
     char path[1024];
@@ -1005,9 +1998,202 @@ static void compile_prelude_modules(const char *current_source,
     free(core_dir);
 }
 
-static CompiledModule *compile_one(const char *source_path,
-                                    CompilerFlags *flags,
-                                    bool is_main_module) {
+/* A layout-style import expands its importer through wisp before the
+ * dependency's headers are in this module's FFI view, so re-parse the
+ * dependency's `include` lines into a scratch context and register the
+ * arities of what they declare (types like VkApplicationInfo included). */
+static void register_dep_include_arities(const char *dep_src)
+{
+    char *dep_source = read_file(dep_src);
+    FFIContext *dep_ffi = ffi_context_create();
+    const char *dp = dep_source;
+    while (*dp) {
+        while (*dp == ' ' || *dp == '\t') dp++;
+        bool is_include = false;
+        if (strncmp(dp, "include", 7) == 0 &&
+            (dp[7] == ' ' || dp[7] == '\t' || dp[7] == '<'))
+            is_include = true;
+        if (*dp == '(' && strncmp(dp+1, "include", 7) == 0)
+            is_include = true;
+        if (is_include) {
+            const char *q = strchr(dp, '<');
+            const char *qq = strchr(dp, '"');
+            bool sys = false;
+            const char *hstart = NULL, *hend = NULL;
+            if (q && (!qq || q < qq)) {
+                sys = true; hstart = q+1;
+                hend = strchr(hstart, '>');
+            } else if (qq) {
+                sys = false; hstart = qq+1;
+                hend = strchr(hstart, '"');
+            }
+            if (hstart && hend) {
+                char hdr[256];
+                size_t hl = hend - hstart;
+                if (hl < sizeof(hdr)) {
+                    memcpy(hdr, hstart, hl);
+                    hdr[hl] = '\0';
+                    ffi_parse_header(dep_ffi, hdr, sys);
+                }
+            }
+        }
+        while (*dp && *dp != '\n') dp++;
+        if (*dp == '\n') dp++;
+    }
+    for (int fi = 0; fi < dep_ffi->function_count; fi++)
+        wisp_register_arity(dep_ffi->functions[fi].name,
+                            dep_ffi->functions[fi].param_count);
+    for (int si = 0; si < dep_ffi->struct_count; si++)
+        if (!dep_ffi->structs[si].alias_of)
+            wisp_register_arity(dep_ffi->structs[si].name,
+                                dep_ffi->structs[si].field_count);
+    ffi_context_free(dep_ffi);
+    free_source(dep_source);
+}
+
+/// Bytecode tier
+//
+// A main module all of whose forms are in the bytecode subset (see
+// bytecode_lower.h) can run on the register VM with no LLVM module at all.
+// The lowering runs on clones, so a module that does not lower reaches
+// codegen exactly as parsed.  A first untyped pass rejects most programs
+// before HM runs; the ones that pass are inferred against a private
+// InferEnv and lowered again from the typed AST.
+
+static bool bytecode_lower_forms(BcProgram *program, AST **forms, size_t count,
+                                 const char *source_path, BcError *error) {
+    BcLowerOptions options = bc_lower_options_default();
+    options.file = source_path;
+    bc_program_init(program, source_path);
+    return bc_lower_module(program, forms, count, &options, error);
+}
+
+static bool bytecode_emit_file(const BcProgram *program, const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (!out) { perror(path); return false; }
+    BcError error;
+    bool ok = bc_write_binary(program, out, &error);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) fprintf(stderr, "bytecode: cannot write %s: %s\n", path, error.message);
+    return ok;
+}
+
+static void bytecode_dump_sections(const BcProgram *program) {
+    FILE *tmp = tmpfile();
+    if (!tmp) { perror("tmpfile"); return; }
+    BcError error;
+    if (!bc_write_binary(program, tmp, &error) || fseek(tmp, 0, SEEK_SET) != 0 ||
+        !bc_dump_binary_sections(tmp, stdout, &error))
+        fprintf(stderr, "bytecode: %s\n", error.message);
+    fclose(tmp);
+}
+
+/* Returns true when the module ran on the VM (--bc or -jit), or -jit
+ * could not lower it; false when it is left to the LLVM compile. */
+static bool bytecode_tier_run(const ASTList *exprs, const char *source_path,
+                              const CompilerFlags *flags) {
+    bool run = flags->run_bytecode || flags->jit;
+    AST **forms = malloc(sizeof(AST *) * (exprs->count ? exprs->count : 1));
+    for (size_t i = 0; i < exprs->count; i++) forms[i] = ast_clone(exprs->exprs[i]);
+
+    BcProgram program;
+    BcError error;
+    bool lowered = bytecode_lower_forms(&program, forms, exprs->count, source_path, &error);
+    if (lowered) {
+        InferEnv *ienv = infer_env_create();
+        InferCtx *bctx = infer_ctx_create(ienv, NULL, "<builtins>");
+        infer_register_builtins(bctx);
+        infer_ctx_free(bctx);
+        /* Non-fatal, as in the REPL: the lowering checks every operand
+         * type itself and only uses HM to settle what it cannot see. */
+        for (size_t i = 0; i < exprs->count; i++) {
+            InferCtx *ictx = infer_ctx_create(ienv, NULL, source_path);
+            infer_toplevel(ictx, forms[i]);
+            infer_ctx_free(ictx);
+        }
+        bc_program_free(&program);
+        lowered = bytecode_lower_forms(&program, forms, exprs->count, source_path, &error);
+        infer_env_free(ienv);
+    }
+    for (size_t i = 0; i < exprs->count; i++) ast_free(forms[i]);
+    free(forms);
+
+    if (!lowered) {
+        /* -jit never compiles dependencies, so it has no LLVM fallback. */
+        fprintf(stderr, "bytecode: %s:%u:%u: %s; %s\n",
+                source_path, error.span.line, error.span.column, error.message,
+                flags->jit ? "-jit skips the LLVM compile"
+                : run ? "compiling with LLVM instead" : "nothing to emit");
+        bc_program_free(&program);
+        return flags->jit;
+    }
+
+    if (flags->bytecode_verify && !bc_verify_trace(&program, stdout, &error))
+        fprintf(stderr, "bytecode: %s\n", error.message);
+    if (flags->bytecode_disassemble) bc_disassemble(&program, stdout);
+    if (flags->bytecode_decompile) bc_decompile_monad(&program, stdout);
+    if (flags->bytecode_dump_sections) bytecode_dump_sections(&program);
+    if (flags->emit_bytecode && !flags->jit) {
+        char bdc_path[512];
+        if (flags->output_name)
+            snprintf(bdc_path, sizeof(bdc_path), "%s.bdc", flags->output_name);
+        else {
+            strncpy(bdc_path, source_path, sizeof(bdc_path) - 5);
+            bdc_path[sizeof(bdc_path) - 5] = '\0';
+            char *dot = strrchr(bdc_path, '.');
+            if (dot) strcpy(dot, ".bdc");
+            else strcat(bdc_path, ".bdc");
+        }
+        if (bytecode_emit_file(&program, bdc_path) && flags->verbose_level > 0)
+            printf("  wrote bytecode: %s\n", bdc_path);
+    }
+
+    if (run) {
+        BcVM vm;
+        bc_vm_init(&vm);
+        vm.trace = flags->bytecode_trace;
+        vm.trace_out = stderr;
+        /* -jit compiles on the first run rather than waiting for the
+         * program to turn hot; a program the JIT rejects interprets. */
+        if (flags->bytecode_baseline_jit) vm.tier.call_hot_threshold = 0;
+        BcValue result;
+        bool ok = bc_vm_run(&vm, &program, &result, &error);
+        fflush(stdout);
+        if (flags->verbose_level > 0)
+            fprintf(stderr, "bytecode: ran %s on the %s VM%s\n", source_path,
+                    bc_vm_dispatch_name(), vm.jit_runs ? " (baseline JIT)" : "");
+        bc_vm_free(&vm);
+        bc_program_free(&program);
+        if (!ok) {
+            fprintf(stderr, "bytecode: %s:%u:%u: runtime error: %s\n",
+                    source_path, error.span.line, error.span.column, error.message);
+            exit(1);
+        }
+        return true;
+    }
+    bc_program_free(&program);
+    return false;
+}
+
+// Span detail for a top-level form: the name a define binds, else the
+// head symbol.
+static const char *toplevel_form_name(const AST *expr) {
+    if (expr->type != AST_LIST || expr->list.count == 0 ||
+        expr->list.items[0]->type != AST_SYMBOL)
+        return NULL;
+    const char *head = expr->list.items[0]->symbol;
+    if (strcmp(head, "define") == 0 && expr->list.count > 1) {
+        const AST *target = expr->list.items[1];
+        if (target->type == AST_LIST && target->list.count > 0)
+            target = target->list.items[0];
+        if (target->type == AST_SYMBOL) return target->symbol;
+    }
+    return head;
+}
+
+static CompiledModule *compile_module(const char *source_path,
+                                      CompilerFlags *flags,
+                                      bool is_main_module) {
 
     /* Resolve the checkout/install core once and expose the same path to the
      * module resolver. Without this, prelude discovery can find a core beside
@@ -1021,9 +2207,13 @@ static CompiledModule *compile_one(const char *source_path,
     }
 
     struct timespec _phase_t0, _phase_t1;
-    #define PHASE_START() clock_gettime(CLOCK_MONOTONIC, &_phase_t0)
+    #define PHASE_START(name) do { \
+        time_trace_begin(name, NULL); \
+        clock_gettime(CLOCK_MONOTONIC, &_phase_t0); \
+    } while(0)
     #define PHASE_END(name) do { \
         clock_gettime(CLOCK_MONOTONIC, &_phase_t1); \
+        time_trace_end(); \
         double _ms = (_phase_t1.tv_sec - _phase_t0.tv_sec) * 1000.0 + \
                      (_phase_t1.tv_nsec - _phase_t0.tv_nsec) / 1e6; \
         if ((flags->verbose_level > 0 || flags->trace_codegen) && _ms > 50.0) \
@@ -1085,6 +2275,13 @@ static CompiledModule *compile_one(const char *source_path,
         }
         /* If _existing but was_skipped=true, fall through to run full codegen
          * so exports get populated, then update it in Phase 9. */
+
+        /* An up-to-date interface file stands in for the whole front-end. */
+        CompiledModule *slot = registry_find_by_obj(obj_path);
+        if (slot && moni_load(slot, my_source_path, obj_path, flags)) {
+            free(base); free(obj_path); free(my_source_path);
+            return slot;
+        }
     }
 
     // Check if we can skip emitting a new .o (but we still run full codegen
@@ -1092,7 +2289,8 @@ static CompiledModule *compile_one(const char *source_path,
     time_t src_t = file_mtime(my_source_path);
 
     time_t obj_t = file_mtime(obj_path);
-    bool skip_emit = !is_main_module && (obj_t > 0 && obj_t > src_t);
+    bool skip_emit = !is_main_module && (obj_t > 0 && obj_t > src_t) &&
+                     file_is_bitcode(obj_path) == (flags->lto != LTO_OFF);
 
     if (flags->verbose_level > 0 || flags->trace_codegen) {
         if (skip_emit)
@@ -1109,7 +2307,7 @@ static CompiledModule *compile_one(const char *source_path,
     // Read + parse
     char *source = read_file(my_source_path);
 
-    PHASE_START();
+    PHASE_START("ffi pre-pass");
 
     /* Pre-pass: parse FFI includes to populate wisp arity table before
      * the full wisp expansion runs. We create a temporary FFI context,
@@ -1190,6 +2388,7 @@ static CompiledModule *compile_one(const char *source_path,
         ffi_context_free(pre_ffi);
     }
     PHASE_END("ffi pre-pass");
+    PHASE_START("wisp+parse");
 
     /* Register builtin arities before wisp parse so forms like
      * define/until/if are known to the arity-driven expander. */
@@ -1309,125 +2508,34 @@ skip_primitive_type_autoload:
         ;
     }
 
-    /* Pre-scan imports and compile dependencies BEFORE wisp expansion
+    /* Scan the header and compile dependencies BEFORE wisp expansion
      * so their FFI arities are available when we expand this module. */
     {
-        compile_prelude_modules(my_source_path, flags, source);
-
-        const char *p = source;
-        while (*p) {
-            while (*p == ' ' || *p == '\t') p++;
-            /* Match: (import ModuleName) or (import qualified ModuleName) */
-            if (*p == '(' &&
-                strncmp(p + 1, "import", 6) == 0 &&
-                (p[7] == ' ' || p[7] == '\t')) {
-                const char *q = p + 7;
-                while (*q == ' ' || *q == '\t') q++;
-                /* skip optional 'qualified' */
-                if (strncmp(q, "qualified", 9) == 0 &&
-                    (q[9] == ' ' || q[9] == '\t'))
-                    q += 9;
-                while (*q == ' ' || *q == '\t') q++;
-                /* read module name: letters, digits, dots */
-                const char *mstart = q;
-                while (*q && (isalnum((unsigned char)*q) || *q == '.')) q++;
-                if (q > mstart) {
-                    char mod_name[256];
-                    size_t mlen = q - mstart;
-                    if (mlen < sizeof(mod_name)) {
-                        memcpy(mod_name, mstart, mlen);
-                        mod_name[mlen] = '\0';
-                        char *dep_src = module_name_to_path(mod_name);
-                        if (dep_src && file_exists(dep_src)) {
-                            CompiledModule *dep_cm = compile_one(dep_src, flags, false);
-                            register_compiled_module_wisp_arities(dep_cm);
-                            parser_set_context(my_source_path, source);
-                            /* dep headers already in global FFI context */
-                        }
-                        free(dep_src);
-                    }
-                }
-            }
-            /* also match bare wisp-style: import ModuleName */
-            else if (strncmp(p, "import", 6) == 0 &&
-                     (p[6] == ' ' || p[6] == '\t')) {
-                const char *q = p + 6;
-                while (*q == ' ' || *q == '\t') q++;
-                if (strncmp(q, "qualified", 9) == 0 &&
-                    (q[9] == ' ' || q[9] == '\t'))
-                    q += 9;
-                while (*q == ' ' || *q == '\t') q++;
-                const char *mstart = q;
-                while (*q && (isalnum((unsigned char)*q) || *q == '.')) q++;
-                if (q > mstart) {
-                    char mod_name[256];
-                    size_t mlen = q - mstart;
-                    if (mlen < sizeof(mod_name)) {
-                        memcpy(mod_name, mstart, mlen);
-                        mod_name[mlen] = '\0';
-                        char *dep_src = module_name_to_path(mod_name);
-                        if (dep_src && file_exists(dep_src)) {
-                            CompiledModule *dep_cm = compile_one(dep_src, flags, false);
-                            register_compiled_module_wisp_arities(dep_cm);
-                            parser_set_context(my_source_path, source);
-                            /* Re-parse dep's headers into our FFI context
-                             * so types like VkApplicationInfo are visible */
-                            char *dep_source = read_file(dep_src);
-                            FFIContext *dep_ffi = ffi_context_create();
-                            const char *dp = dep_source;
-                            while (*dp) {
-                                while (*dp == ' ' || *dp == '\t') dp++;
-                                const char *line = dp;
-                                bool is_include = false;
-                                if (strncmp(dp, "include", 7) == 0 &&
-                                    (dp[7] == ' ' || dp[7] == '\t' || dp[7] == '<'))
-                                    is_include = true;
-                                if (*dp == '(' && strncmp(dp+1, "include", 7) == 0)
-                                    is_include = true;
-                                if (is_include) {
-                                    const char *q = strchr(dp, '<');
-                                    const char *qq = strchr(dp, '"');
-                                    bool sys = false;
-                                    const char *hstart = NULL, *hend = NULL;
-                                    if (q && (!qq || q < qq)) {
-                                        sys = true; hstart = q+1;
-                                        hend = strchr(hstart, '>');
-                                    } else if (qq) {
-                                        sys = false; hstart = qq+1;
-                                        hend = strchr(hstart, '"');
-                                    }
-                                    if (hstart && hend) {
-                                        char hdr[256];
-                                        size_t hl = hend - hstart;
-                                        if (hl < sizeof(hdr)) {
-                                            memcpy(hdr, hstart, hl);
-                                            hdr[hl] = '\0';
-                                            ffi_parse_header(dep_ffi, hdr, sys);
-                                        }
-                                    }
-                                }
-                                while (*dp && *dp != '\n') dp++;
-                                if (*dp == '\n') dp++;
-                            }
-                            for (int fi = 0; fi < dep_ffi->function_count; fi++)
-                                wisp_register_arity(dep_ffi->functions[fi].name,
-                                                    dep_ffi->functions[fi].param_count);
-                            for (int si = 0; si < dep_ffi->struct_count; si++)
-                                if (!dep_ffi->structs[si].alias_of)
-                                    wisp_register_arity(dep_ffi->structs[si].name,
-                                                        dep_ffi->structs[si].field_count);
-                            ffi_context_free(dep_ffi);
-                            free(dep_source);
-                        }
-                        free(dep_src);
-                    }
-                }
+        ModuleHeader header;
+        module_scan_header(source, &header);
+        compile_prelude_modules(my_source_path, flags, source, &header);
+
+        for (size_t i = 0; i < header.import_count; i++) {
+            char *dep_src = module_name_to_path(header.imports[i].module_name);
+            if (dep_src && file_exists(dep_src)) {
+                CompiledModule *dep_cm = compile_one(dep_src, flags, false);
+                register_compiled_module_wisp_arities(dep_cm);
+                parser_set_context(my_source_path, source);
+                /* paren imports: dep headers already in global FFI context */
+                if (header.imports[i].layout)
+                    register_dep_include_arities(dep_src);
             }
-            while (*p && *p != '\n') p++;
-            if (*p == '\n') p++;
+            free(dep_src);
         }
+        module_header_free(&header);
     }
 
+    /* Finite type sets and refinements are process-wide; remember where the
+     * lists stood so Phase 9 can record the ones this module adds. */
+    const FiniteTypeSetEntry *finite_mark = g_finite_type_sets;
+    const RefinementEntry    *refine_mark = g_refinements;
+    size_t                    macro_mark  = macro_count();
+
     parser_set_context(my_source_path, source);
     AST *_feat_early = detect_features();
     ast_free(_feat_early);
@@ -1441,9 +2549,12 @@ skip_primitive_type_autoload:
             : OPT_LEVEL_BASIC;
         opt_options.print_stats = flags->verbose_level > 0 && !flags->trace_semantic;
         opt_options.trace_semantic = flags->trace_semantic;
+        opt_options.fuse_sequences = true;
         opt_options.source_name = my_source_path;
         OptimizationStats opt_stats = {0};
+        time_trace_begin("optimize", my_source_path);
         optimize_ast_list(&exprs, &opt_options, &opt_stats);
+        time_trace_end();
     }
 
     /* Surface AST for typst emission — parsed before wisp desugaring.
@@ -1469,27 +2580,22 @@ skip_primitive_type_autoload:
     }
 
     if (is_main_module &&
-        (flags->emit_bytecode || flags->bytecode_verify ||
+        (flags->run_bytecode || flags->emit_bytecode || flags->bytecode_verify ||
          flags->bytecode_disassemble || flags->bytecode_decompile ||
          flags->bytecode_dump_sections || flags->bytecode_trace ||
-         flags->bytecode_baseline_jit)) {
-        fprintf(stderr,
-                "bytecode: register VM substrate v%u.%u is available; "
-                "AST-to-bytecode lowering is not wired into compile yet\n",
-                BC_VERSION_MAJOR, BC_VERSION_MINOR);
-        if (flags->bytecode_baseline_jit)
-            fprintf(stderr, "bytecode: baseline JIT flag accepted; backend lowering is pending\n");
-        if (flags->jit) {
-            fprintf(stderr, "bytecode: -jit requested; skipping LLVM compile because bytecode lowering is pending\n");
-            for (size_t i = 0; i < exprs.count; i++) ast_free(exprs.exprs[i]);
-            free(exprs.exprs);
-            for (size_t i = 0; i < surface_exprs.count; i++) ast_free(surface_exprs.exprs[i]);
-            free(surface_exprs.exprs);
-            free(my_source_path);
-            free(source);
-            type_alias_free_all();
-            return NULL;
-        }
+         flags->bytecode_baseline_jit) &&
+        bytecode_tier_run(&exprs, my_source_path, flags)) {
+        for (size_t i = 0; i < exprs.count; i++) ast_free(exprs.exprs[i]);
+        free(exprs.exprs);
+        for (size_t i = 0; i < surface_exprs.count; i++) ast_free(surface_exprs.exprs[i]);
+        free(surface_exprs.exprs);
+        free_source(source);
+        free(obj_path);
+        free(base);
+        free(my_source_path);
+        wisp_clear_arities();
+        type_alias_free_all();
+        return NULL;
     }
 
     if (flags->emit_json) {
@@ -1521,7 +2627,7 @@ skip_primitive_type_autoload:
         /* JSON-only mode: clean up and stop — no codegen, no binary */
         for (size_t i = 0; i < exprs.count; i++) ast_free(exprs.exprs[i]);
         free(exprs.exprs);
-        free(source);
+        free_source(source);
         free(obj_path);
         free(base);
         free(my_source_path);
@@ -1576,7 +2682,7 @@ skip_primitive_type_autoload:
          * NULL tells compile() there is intentionally nothing to link, just
          * like the existing emit-only success paths. */
         free(exprs.exprs);
-        free(source);
+        free_source(source);
         free(obj_path);
         free(base);
         free(my_source_path);
@@ -1661,7 +2767,7 @@ skip_primitive_type_autoload:
 
 /// Phase 3: LLVM setup
 
-    PHASE_START();
+    PHASE_START("llvm init");
     LLVMInitializeNativeTarget();
     LLVMInitializeNativeAsmPrinter();
     LLVMInitializeNativeAsmParser();
@@ -1672,13 +2778,14 @@ skip_primitive_type_autoload:
     ctx.test_mode  = flags->test_mode;
     ctx.optimization_level = flags->optimization_level;
     ctx.ffi        = get_global_ffi();
+    int ffi_mark   = ctx.ffi->included_count + ctx.ffi->function_count;
 
     DepCtx *dep_ctx = dep_ctx_create(my_source_path);
     dep_register_builtins(dep_ctx);
     ctx.env->dep_ctx = dep_ctx;
 
     PHASE_END("llvm init");
-    PHASE_START();
+    PHASE_START("llvm init + builtins");
     register_builtins(&ctx);
     wisp_register_arities_from_env(ctx.env);
     declare_runtime_functions(&ctx);
@@ -1686,6 +2793,10 @@ skip_primitive_type_autoload:
 
 /// Phase 4: Declare externals from compiled deps
 
+    /* Every module declared here is an input of this module's .moni. */
+    CompiledModule **moni_deps = NULL;
+    size_t moni_dep_count = 0;
+
     for (size_t i = 0; i < mod_ctx->import_count; i++) {
         ImportDecl *imp = mod_ctx->imports[i];
         CompiledModule *dep = registry_find(imp->module_name);
@@ -1694,6 +2805,8 @@ skip_primitive_type_autoload:
                     imp->module_name); exit(1);
         }
         declare_externals(&ctx, dep, imp);
+        moni_deps = realloc(moni_deps, sizeof(*moni_deps) * (moni_dep_count + 1));
+        moni_deps[moni_dep_count++] = dep;
 
         /* Headers from imported modules are already in the global FFI context
          * (parsed when that module was compiled) — nothing to do here. */
@@ -1749,6 +2862,8 @@ skip_primitive_type_autoload:
             ImportDecl *syn = import_decl_create(stem2, NULL, IMPORT_UNQUALIFIED);
             declare_externals(&ctx, type_mod, syn);
             import_decl_free(syn);
+            moni_deps = realloc(moni_deps, sizeof(*moni_deps) * (moni_dep_count + 1));
+            moni_deps[moni_dep_count++] = type_mod;
 
             type_mod->module_name = old_mn;  /* restore */
         }
@@ -1779,6 +2894,26 @@ skip_primitive_type_autoload:
     ctx.init_fn = init_fn;
     ctx.top_level_fn = init_fn;
 
+    // Hand main's frame to the collector as the stack base (a no-op
+    // unless the program runs with MONAD_GC=1), then start the profiler
+    // (a no-op unless MONAD_PROF is set).
+    if (is_main_module) {
+        LLVMTypeRef  ptr   = LLVMPointerType(LLVMInt8TypeInContext(ctx.context), 0);
+        unsigned     fa_id = LLVMLookupIntrinsicID("llvm.frameaddress",
+                                                   strlen("llvm.frameaddress"));
+        LLVMValueRef fa_fn = LLVMGetIntrinsicDeclaration(ctx.module, fa_id, &ptr, 1);
+        LLVMValueRef level = LLVMConstInt(LLVMInt32TypeInContext(ctx.context), 0, 0);
+        LLVMValueRef base  = LLVMBuildCall2(ctx.builder,
+            LLVMIntrinsicGetType(ctx.context, fa_id, &ptr, 1),
+            fa_fn, &level, 1, "stack_base");
+        LLVMValueRef gc_init = get_rt_gc_init(&ctx);
+        LLVMBuildCall2(ctx.builder, LLVMGlobalGetValueType(gc_init),
+                       gc_init, &base, 1, "");
+        LLVMValueRef prof_init = get_rt_prof_init(&ctx);
+        LLVMBuildCall2(ctx.builder, LLVMGlobalGetValueType(prof_init),
+                       prof_init, NULL, 0, "");
+    }
+
 /// Phase 6: *features* global
 
     AST *feat_ast = detect_features();
@@ -1824,6 +2959,7 @@ skip_primitive_type_autoload:
         printf("[dep] running bidirectional type checker...\n");
     bool dep_failed = false;
 
+    time_trace_begin("dep check", my_source_path);
     for (size_t i = first_code; i < exprs.count; i++) {
         AST *expr = exprs.exprs[i];
 
@@ -1853,6 +2989,7 @@ skip_primitive_type_autoload:
         term_free(elaborated);
         term_free(out_type);
     }
+    time_trace_end();
 
     if (dep_failed) {
         dep_error_print(dep_ctx);
@@ -1863,9 +3000,11 @@ skip_primitive_type_autoload:
 
 /// Phase 7: Codegen top-level expressions
 
-    PHASE_START();
+    PHASE_START("codegen");
+    time_trace_begin("predeclare", my_source_path);
     codegen_predeclare_toplevel_functions(&ctx, exprs.exprs, exprs.count,
                                            first_code);
+    time_trace_end();
 
     // For the main module: call each imported library's init function first
     // so their top-level variable stores (e.g. phi = 3.14) run before we use them.
@@ -1904,7 +3043,21 @@ skip_primitive_type_autoload:
                         my_source_path, expr->line); exit(1);
             }
         }
-        last = codegen_expr(&ctx, expr);
+        if (time_trace_active()) {
+            time_trace_begin("codegen form", toplevel_form_name(expr));
+            last = codegen_expr(&ctx, expr);
+            time_trace_end();
+        } else {
+            last = codegen_expr(&ctx, expr);
+        }
+        // Codegen clones whatever it keeps of a form (env source_ast,
+        // specialization snapshots), so an emitted form is dead.  Freeing it
+        // here keeps peak memory near one form's AST plus the IR rather than
+        // every AST plus the IR.  The last form stays: `last` may point into it.
+        if (i + 1 < exprs.count) {
+            ast_free(expr);
+            exprs.exprs[i] = NULL;
+        }
     }
 
     PHASE_END("codegen");
@@ -1959,190 +3112,202 @@ skip_primitive_type_autoload:
     }
     tc_registry_free(cm->tc_registry);
     cm->tc_registry = tc_registry_clone(ctx.tc_registry);
+    free(cm->source_path);
+    cm->source_path  = strdup(my_source_path);
+    cm->uses_ffi     = ctx.ffi->included_count + ctx.ffi->function_count != ffi_mark;
+    cm->finite_first = g_finite_type_sets;
+    cm->finite_end   = finite_mark;
+    cm->refine_first = g_refinements;
+    cm->refine_end   = refine_mark;
+    cm->macro_first  = macro_mark;
+    cm->macro_end    = macro_count();
     for (size_t bi = 0; bi < ctx.env->size; bi++) {
-        EnvEntry *ent = ctx.env->buckets[bi];
-        while (ent) {
-            if (ent->kind == ENV_BUILTIN || ent->module_name != NULL ||
-                ent->name[0] == '*') { ent = ent->next; continue; }
-
-            /* A class method declaration is registry metadata, not an
-             * ordinary linkable function. Instance implementation symbols
-             * and dictionaries are emitted separately. */
-            if (ent->kind == ENV_FUNC && ent->func_ref == NULL &&
-                tc_is_method(ctx.tc_registry, ent->name)) {
-                ent = ent->next;
-                continue;
-            }
+        EnvEntry *ent = ctx.env->slots[bi];
+        if (!ent) continue;
+        if (ent->kind == ENV_BUILTIN || ent->module_name != NULL ||
+            ent->name[0] == '*') continue;
+
+        /* A class method declaration is registry metadata, not an
+         * ordinary linkable function. Instance implementation symbols
+         * and dictionaries are emitted separately. */
+        if (ent->kind == ENV_FUNC && ent->func_ref == NULL &&
+            tc_is_method(ctx.tc_registry, ent->name)) {
+            continue;
+        }
 
-            /* Canonicalize the public export name before export filtering.
-             *
-             * Type-module methods are defined internally as "Char.upcase",
-             * but the module export list contains the member name "upcase".
-             * Therefore export filtering must accept either spelling:
-             * the internal implementation name or the public member name.
-             */
-            const char *_local_name = ent->name;
-            {
-                const char *_dot = strrchr(ent->name, '.');
-                if (_dot && _dot[1]) _local_name = _dot + 1;
-            }
+        /* Canonicalize the public export name before export filtering.
+         *
+         * Type-module methods are defined internally as "Char.upcase",
+         * but the module export list contains the member name "upcase".
+         * Therefore export filtering must accept either spelling:
+         * the internal implementation name or the public member name.
+         */
+        const char *_local_name = ent->name;
+        {
+            const char *_dot = strrchr(ent->name, '.');
+            if (_dot && _dot[1]) _local_name = _dot + 1;
+        }
 
-            /* Force-export closure-ABI functions so inner closures work in .so */
-            bool force_export = (ent->kind == ENV_FUNC && ent->is_closure_abi);
-            if (!force_export &&
-                !module_decl_is_exported(module_decl, ent->name) &&
-                !module_decl_is_exported(module_decl, _local_name)) {
-                /* Also check if this is an alias for an exported symbol. */
-                bool alias_exported = false;
-                if (ent->llvm_name) {
-                    const char *base = strstr(ent->llvm_name, "__");
-                    if (base) base += 2;
-                    else base = ent->llvm_name;
-
-                    if (module_decl_is_exported(module_decl, base))
-                        alias_exported = true;
-
-                    const char *base_dot = strrchr(base, '.');
-                    if (base_dot && base_dot[1] &&
-                        module_decl_is_exported(module_decl, base_dot + 1))
-                        alias_exported = true;
-                }
-                if (!alias_exported) { ent = ent->next; continue; }
+        /* Force-export closure-ABI functions so inner closures work in .so */
+        bool force_export = (ent->kind == ENV_FUNC && ent->is_closure_abi);
+        if (!force_export &&
+            !module_decl_is_exported(module_decl, ent->name) &&
+            !module_decl_is_exported(module_decl, _local_name)) {
+            /* Also check if this is an alias for an exported symbol. */
+            bool alias_exported = false;
+            if (ent->llvm_name) {
+                const char *base = strstr(ent->llvm_name, "__");
+                if (base) base += 2;
+                else base = ent->llvm_name;
+
+                if (module_decl_is_exported(module_decl, base))
+                    alias_exported = true;
+
+                const char *base_dot = strrchr(base, '.');
+                if (base_dot && base_dot[1] &&
+                    module_decl_is_exported(module_decl, base_dot + 1))
+                    alias_exported = true;
             }
+            if (!alias_exported) continue;
+        }
 
-            char *ms = NULL;
-            if (ent->kind == ENV_FUNC && ent->func_ref) {
+        char *ms = NULL;
+        if (ent->kind == ENV_FUNC && ent->func_ref) {
+            const char *implementation_name = LLVMGetValueName(ent->func_ref);
+            if (implementation_name &&
+                strncmp(implementation_name, "__impl_", 7) == 0) {
+                /* Public class-method entries point at the instance
+                 * implementation. Keep that stable symbol: renaming it
+                 * to Module__method breaks the instance metadata used by
+                 * importing modules. */
+                ms = strdup(implementation_name);
+            }
+        }
+        if (!ms)
+            ms = mangle(mod_name, _local_name);
+
+        if (ent->kind == ENV_FUNC || ent->kind == ENV_ADT_CTOR) {
+            /* Never rename FFI functions — they must keep their original
+             * symbol names so the linker can find them in libraylib etc. */
+            if (ent->is_ffi) { free(ms); continue; }
+            EnvEntry *export_signature = ent;
+            if (ent->func_ref) {
                 const char *implementation_name = LLVMGetValueName(ent->func_ref);
                 if (implementation_name &&
                     strncmp(implementation_name, "__impl_", 7) == 0) {
-                    /* Public class-method entries point at the instance
-                     * implementation. Keep that stable symbol: renaming it
-                     * to Module__method breaks the instance metadata used by
-                     * importing modules. */
-                    ms = strdup(implementation_name);
+                    EnvEntry *implementation =
+                        env_lookup(ctx.env, implementation_name);
+                    if (implementation)
+                        export_signature = implementation;
                 }
             }
-            if (!ms)
-                ms = mangle(mod_name, _local_name);
-
-            if (ent->kind == ENV_FUNC || ent->kind == ENV_ADT_CTOR) {
-                /* Never rename FFI functions — they must keep their original
-                 * symbol names so the linker can find them in libraylib etc. */
-                if (ent->is_ffi) { free(ms); ent = ent->next; continue; }
-                EnvEntry *export_signature = ent;
-                if (ent->func_ref) {
-                    const char *implementation_name = LLVMGetValueName(ent->func_ref);
-                    if (implementation_name &&
-                        strncmp(implementation_name, "__impl_", 7) == 0) {
-                        EnvEntry *implementation =
-                            env_lookup(ctx.env, implementation_name);
-                        if (implementation)
-                            export_signature = implementation;
-                    }
-                }
-                registry_push_func(cm, _local_name, ms,
-                                   export_signature->return_type
-                                       ? export_signature->return_type
-                                       : export_signature->type,
-                                   export_signature->params,
-                                   export_signature->param_count,
-                                   ent->func_ref,
-                                   export_signature->source_ast);
-                if (ent->func_ref) {
-                    const char *cur = LLVMGetValueName(ent->func_ref);
-                    if (!cur || strcmp(cur, ms) != 0)
-                        LLVMSetValueName2(ent->func_ref, ms, strlen(ms));
-                }
-                /* Push aliases for functions too */
-                for (size_t bj = 0; bj < ctx.env->size; bj++) {
-                    for (EnvEntry *other = ctx.env->buckets[bj]; other; other = other->next) {
-                        if (other != ent &&
-                            (other->kind == ENV_FUNC ||
-                             other->kind == ENV_ADT_CTOR) &&
-                            other->module_name == NULL &&
-                            other->func_ref == ent->func_ref &&
-                            strcmp(other->name, ent->name) != 0) {
-                            const char *other_local_name = other->name;
-                            const char *other_dot = strrchr(other->name, '.');
-                            if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
-                            registry_push_func(cm, other_local_name, ms,
-                                               ent->return_type ? ent->return_type : ent->type,
-                                               ent->params, ent->param_count,
-                                               ent->func_ref,
-                                               other->source_ast
-                                                   ? other->source_ast
-                                                   : ent->source_ast);
-                        }
-                    }
-                }
-            } else {
-                if (!ent->type) { free(ms); ent = ent->next; continue; }
-                registry_push_var(cm, _local_name, ms, ent->type);
-                LLVMValueRef gv = ent->value;
-                if (gv && LLVMIsAGlobalVariable(gv)) {
-                    const char *cur = LLVMGetValueName(gv);
-                    if (!cur || strcmp(cur, ms) != 0)
-                        LLVMSetValueName2(gv, ms, strlen(ms));
-                    LLVMSetLinkage(gv, LLVMExternalLinkage);
+            registry_push_func(cm, _local_name, ms,
+                               export_signature->return_type
+                                   ? export_signature->return_type
+                                   : export_signature->type,
+                               export_signature->params,
+                               export_signature->param_count,
+                               ent->func_ref,
+                               export_signature->source_ast);
+            if (ent->func_ref) {
+                const char *cur = LLVMGetValueName(ent->func_ref);
+                if (!cur || strcmp(cur, ms) != 0)
+                    LLVMSetValueName2(ent->func_ref, ms, strlen(ms));
+            }
+            /* Push aliases for functions too */
+            for (size_t bj = 0; bj < ctx.env->size; bj++) {
+                EnvEntry *other = ctx.env->slots[bj];
+                if (!other) continue;
+                if (other != ent &&
+                    (other->kind == ENV_FUNC ||
+                     other->kind == ENV_ADT_CTOR) &&
+                    other->module_name == NULL &&
+                    other->func_ref == ent->func_ref &&
+                    strcmp(other->name, ent->name) != 0) {
+                    const char *other_local_name = other->name;
+                    const char *other_dot = strrchr(other->name, '.');
+                    if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
+                    registry_push_func(cm, other_local_name, ms,
+                                       ent->return_type ? ent->return_type : ent->type,
+                                       ent->params, ent->param_count,
+                                       ent->func_ref,
+                                       other->source_ast
+                                           ? other->source_ast
+                                           : ent->source_ast);
                 }
-                /* Push aliases — entries sharing the same llvm_name */
-                for (size_t bj = 0; bj < ctx.env->size; bj++) {
-                    for (EnvEntry *other = ctx.env->buckets[bj]; other; other = other->next) {
-                        if (other == ent) continue;
-                        if (other->kind != ENV_VAR) continue;
-                        if (other->module_name != NULL) continue;
-                        if (strcmp(other->name, ent->name) == 0) continue;
-                        /* Compare by LLVM global name before mangling */
-                        const char *other_llvm = other->llvm_name ? other->llvm_name : other->name;
-                        const char *ent_llvm   = ent->name; /* before Phase 9 rename, ent->name IS the llvm name */
-                        if (strcmp(other_llvm, ent_llvm) == 0) {
-                            const char *other_local_name = other->name;
-                            const char *other_dot = strrchr(other->name, '.');
-                            if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
-                            registry_push_var(cm, other_local_name, ms,
-                                              other->type ? other->type : ent->type);
-                        }
-                    }
+            }
+        } else {
+            if (!ent->type) { free(ms); continue; }
+            registry_push_var(cm, _local_name, ms, ent->type);
+            LLVMValueRef gv = ent->value;
+            if (gv && LLVMIsAGlobalVariable(gv)) {
+                const char *cur = LLVMGetValueName(gv);
+                if (!cur || strcmp(cur, ms) != 0)
+                    LLVMSetValueName2(gv, ms, strlen(ms));
+                LLVMSetLinkage(gv, LLVMExternalLinkage);
+            }
+            /* Push aliases — entries sharing the same llvm_name */
+            for (size_t bj = 0; bj < ctx.env->size; bj++) {
+                EnvEntry *other = ctx.env->slots[bj];
+                if (!other) continue;
+                if (other == ent) continue;
+                if (other->kind != ENV_VAR) continue;
+                if (other->module_name != NULL) continue;
+                if (strcmp(other->name, ent->name) == 0) continue;
+                /* Compare by LLVM global name before mangling */
+                const char *other_llvm = other->llvm_name ? other->llvm_name : other->name;
+                const char *ent_llvm   = ent->name; /* before Phase 9 rename, ent->name IS the llvm name */
+                if (strcmp(other_llvm, ent_llvm) == 0) {
+                    const char *other_local_name = other->name;
+                    const char *other_dot = strrchr(other->name, '.');
+                    if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
+                    registry_push_var(cm, other_local_name, ms,
+                                      other->type ? other->type : ent->type);
                 }
-                for (size_t bj = 0; bj < ctx.env->size; bj++) {
-                    EnvEntry *other = ctx.env->buckets[bj];
-                    while (other) {
-                        if (other != ent &&
-                            other->kind == ENV_VAR &&
-                            other->module_name == NULL &&
-                            other->value == ent->value &&
-                            strcmp(other->name, ent->name) != 0) {
-                            const char *other_local_name = other->name;
-                            const char *other_dot = strrchr(other->name, '.');
-                            if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
-                            registry_push_var(cm, other_local_name, ms, other->type ? other->type : ent->type);
-                        }
-                        other = other->next;
-                    }
+            }
+            for (size_t bj = 0; bj < ctx.env->size; bj++) {
+                EnvEntry *other = ctx.env->slots[bj];
+                if (!other) continue;
+                if (other != ent &&
+                    other->kind == ENV_VAR &&
+                    other->module_name == NULL &&
+                    other->value == ent->value &&
+                    strcmp(other->name, ent->name) != 0) {
+                    const char *other_local_name = other->name;
+                    const char *other_dot = strrchr(other->name, '.');
+                    if (other_dot && other_dot[1]) other_local_name = other_dot + 1;
+                    registry_push_var(cm, other_local_name, ms, other->type ? other->type : ent->type);
                 }
             }
-            free(ms);
-            ent = ent->next;
         }
+        free(ms);
     }
 
     /* Save all ENV_LAYOUT entries into the compiled module registry */
     for (size_t bi = 0; bi < ctx.env->size; bi++) {
-        for (EnvEntry *ent = ctx.env->buckets[bi]; ent; ent = ent->next) {
-            if (ent->kind != ENV_LAYOUT || !ent->name || !ent->type) continue;
-            if (cm->layout_count >= cm->layout_cap) {
-                cm->layout_cap *= 2;
-                cm->layouts = realloc(cm->layouts,
-                                      sizeof(CompiledLayout) * cm->layout_cap);
-            }
-            cm->layouts[cm->layout_count].name = strdup(ent->name);
-            cm->layouts[cm->layout_count].type = type_clone(ent->type);
-            cm->layout_count++;
+        EnvEntry *ent = ctx.env->slots[bi];
+        if (!ent) continue;
+        if (ent->kind != ENV_LAYOUT || !ent->name || !ent->type) continue;
+        if (cm->layout_count >= cm->layout_cap) {
+            cm->layout_cap *= 2;
+            cm->layouts = realloc(cm->layouts,
+                                  sizeof(CompiledLayout) * cm->layout_cap);
         }
+        cm->layouts[cm->layout_count].name = strdup(ent->name);
+        cm->layouts[cm->layout_count].type = type_clone(ent->type);
+        cm->layout_count++;
     }
 
 /// Phase 10: Verify + optional IR/asm output
 
+    /* Before verification, so the verifier checks every musttail and
+     * --emit-ir shows the loops; at -O0 this is the only thing keeping
+     * deep recursion off the stack. */
+    TailCallStats tail_stats = {0};
+    codegen_lower_tail_calls(ctx.module, &tail_stats,
+                             flags->report_tail_calls ? stderr : NULL,
+                             my_source_path);
+
     char *error = NULL;
     if (LLVMVerifyModule(ctx.module, LLVMPrintMessageAction, &error) != 0) {
         fprintf(stderr, "IR verification failed for %s:\n%s\n",
@@ -2169,32 +3334,72 @@ skip_primitive_type_autoload:
     }
     if (flags->emit_asm) {
         char as[512]; snprintf(as, sizeof(as), "%s.s", base);
-        char *triple = LLVMGetDefaultTargetTriple();
-        LLVMTargetRef tgt; error = NULL;
-        LLVMGetTargetFromTriple(triple, &tgt, &error);
-        if (error) LLVMDisposeMessage(error);
-        LLVMTargetMachineRef mach = LLVMCreateTargetMachine(
-            tgt, triple, "generic", "",
-            codegen_opt_level(flags->optimization_level), LLVMRelocPIC, LLVMCodeModelDefault);
-        char asbuf[512]; strncpy(asbuf, as, 511);
-        error = NULL;
-        LLVMTargetMachineEmitToFile(mach, ctx.module, asbuf,
-                                    LLVMAssemblyFile, &error);
-        if (error) LLVMDisposeMessage(error);
-        LLVMDisposeTargetMachine(mach); LLVMDisposeMessage(triple);
+        LLVMTargetMachineRef mach = host_target_machine(flags->optimization_level,
+                                                        flags->target_cpu);
+        if (mach) {
+            char asbuf[512]; strncpy(asbuf, as, 511); asbuf[511] = '\0';
+            error = NULL;
+            LLVMTargetMachineEmitToFile(mach, ctx.module, asbuf,
+                                        LLVMAssemblyFile, &error);
+            if (error) LLVMDisposeMessage(error);
+            LLVMDisposeTargetMachine(mach);
+        }
     }
 
 /// Phase 11: Emit object file (skipped if .o is already up to date)
 
-    PHASE_START();
-    if (!skip_emit) {
-        if (!emit_object(ctx.module, obj_path, flags->optimization_level)) {
+    PHASE_START("emit object");
+    object_cache_key(cm, source, flags, cm->cache_key);
+    char *cache_path = skip_emit ? NULL : object_cache_path(cm->cache_key);
+    IfaceWriter *moni = NULL;
+    char *moni_path = NULL;
+    if (!is_main_module && !cm->uses_ffi) {
+        moni      = moni_build(cm, source, moni_deps, moni_dep_count, flags);
+        moni_path = moni_path_for(obj_path);
+    }
+    if (cache_path && file_exists(cache_path) &&
+        copy_file_atomic(cache_path, obj_path)) {
+        if (flags->verbose_level > 0 || flags->trace_codegen)
+            printf("  cached object: %s (%s)\n", obj_path, cm->cache_key);
+        free(cache_path);
+        cache_path = NULL;
+        skip_emit  = true;
+    }
+    if (!skip_emit && emit_pool_active()) {
+        /* The builder may still track debug metadata in the context, so drop
+         * it here before a worker takes ownership of module + context. */
+        LLVMDisposeBuilder(ctx.builder);
+        EmitJob *job = calloc(1, sizeof(EmitJob));
+        job->context     = ctx.context;
+        job->module      = ctx.module;
+        job->obj_path    = strdup(obj_path);
+        job->source_path = strdup(my_source_path);
+        job->cache_path  = cache_path;
+        job->moni        = moni;
+        job->moni_path   = moni_path;
+        cache_path = NULL;
+        moni       = NULL;
+        moni_path  = NULL;
+        job->opts        = emit_options(flags);
+        job->verbose     = flags->verbose_level > 0 || flags->trace_codegen;
+        ctx.builder = NULL;
+        ctx.module  = NULL;
+        ctx.context = NULL;
+        emit_pool_submit(job);
+    } else if (!skip_emit) {
+        EmitOptions opts = emit_options(flags);
+        if (!emit_module_file(ctx.module, obj_path, &opts)) {
             fprintf(stderr, "failed to emit object for %s\n", my_source_path);
             exit(1);
         }
+        if (cache_path) copy_file_atomic(obj_path, cache_path);
         if (flags->verbose_level > 0 || flags->trace_codegen)
             printf("  wrote object: %s\n", obj_path);
     }
+    moni_save(moni, moni_path);
+    free(moni_path);
+    free(cache_path);
+    free(moni_deps);
 
     PHASE_END("emit object");
 
@@ -2207,7 +3412,7 @@ skip_primitive_type_autoload:
     module_context_free(mod_ctx);
     for (size_t i = 0; i < exprs.count; i++) ast_free(exprs.exprs[i]);
     free(exprs.exprs);
-    free(source);
+    free_source(source);
     free(obj_path);
     free(base);
     free(my_source_path);
@@ -2215,14 +3420,316 @@ skip_primitive_type_autoload:
     return cm;
 }
 
+// One "module" span per call.  compile_module returns from several phases,
+// so the span stack is unwound to where it stood rather than popped once.
+static CompiledModule *compile_one(const char *source_path,
+                                    CompilerFlags *flags,
+                                    bool is_main_module) {
+    int depth = time_trace_depth();
+    time_trace_begin("module", source_path);
+    CompiledModule *cm = compile_module(source_path, flags, is_main_module);
+    time_trace_unwind(depth);
+    return cm;
+}
+
+/// Precompiled prelude bundle
+//
+// Every program compiles against the same prelude, so `monad prelude` (run
+// by `make install`) compiles it once and writes what importers need from
+// each module to a single file beside the cached core objects: exports with
+// their types and inlinable bodies, layouts, typeclass registries, the
+// finite type sets and refinements the module registered, and its object
+// cache key.  compile() loads that file instead of running the front-end
+// over core/prelude again.  The bundle is only used when the compiler,
+// target, options and the content of every prelude source still match what
+// it was built from; otherwise the sources are compiled as before.
+
+#define PRELUDE_BUNDLE_MAGIC   "monad-prelude"
+#define PRELUDE_BUNDLE_VERSION 3u
+
+static bool core_real_dir(char *out) {
+    char *core = monad_core_dir();
+    bool ok = core && dir_exists(core) && host_realpath(core, out);
+    free(core);
+    return ok;
+}
+
+static char *prelude_bundle_path(const char *core_real, const CompilerFlags *flags) {
+    const char *home = getenv("HOME");
+    if (!home || !*home) return NULL;
+    ensure_cache_dir(home);
+    uint64_t h = hash_str(MODULE_HASH_SEED, core_real);
+    char path[1200];
+    static const char *const lto_suffix[] = { "", "-thinlto", "-lto" };
+    snprintf(path, sizeof(path), "%s/.cache/monad/core/prelude-%016llx-O%d%s%s.bundle",
+             home, (unsigned long long)h, flags->optimization_level,
+             flags->test_mode ? "-test" : "", lto_suffix[flags->lto]);
+    return strdup(path);
+}
+
+// Loads the bundle for the current core directory and options into the
+// registry.  Returns false, leaving the registry untouched, when there is no
+// usable bundle.
+static bool prelude_bundle_load(const CompilerFlags *flags) {
+    if (flags->jit || g_compiled) return false;
+    /* The bundle's objects are neither instrumented nor profile-optimized. */
+    if (flags->profile_generate || flags->profile_use) return false;
+
+    char core_real[1024];
+    if (!core_real_dir(core_real)) return false;
+    if (dir_prefix_matches(flags->input_file, core_real) ||
+        source_is_prelude_file(flags->input_file))
+        return false;
+
+    char *path = prelude_bundle_path(core_real, flags);
+    IfaceFile file;
+    if (!path || !iface_file_open(&file, path)) { free(path); return false; }
+    IfaceReader r = iface_reader(&file);
+
+    bool ok = build_header_check(&r, PRELUDE_BUNDLE_MAGIC, PRELUDE_BUNDLE_VERSION, flags);
+    uint32_t n = ok ? iface_get_u32(&r) : 0;
+    if (n > 4096) { ok = false; n = 0; }
+
+    /* Module table: everything a record depends on outside the bundle is
+     * validated here, before any record touches global state. */
+    char **sources = calloc(n ? n : 1, sizeof(*sources));
+    for (uint32_t i = 0; ok && i < n; i++) {
+        char *rel  = iface_get_str(&r);
+        char *hash = iface_get_str(&r);
+        char *obj  = iface_get_str(&r);
+        char *key  = iface_get_str(&r);
+        int64_t obj_size  = iface_get_i64(&r);
+        int64_t obj_mtime = iface_get_i64(&r);
+        ok = r.ok && rel && hash && obj && key;
+
+        char src[1100], now[MODULE_HASH_HEX_LEN + 1];
+        if (ok) {
+            snprintf(src, sizeof(src), "%s/%s", core_real, rel);
+            ok = source_content_hash(src, now) && strcmp(now, hash) == 0;
+            sources[i] = strdup(src);
+        }
+        if (ok) {
+            /* Another checkout may have rewritten the shared object path;
+             * fall back to the content-addressed copy when it no longer
+             * matches. */
+            struct stat st;
+            bool same = stat(obj, &st) == 0 && (int64_t)st.st_size == obj_size &&
+                        (int64_t)st.st_mtime == obj_mtime;
+            if (!same) {
+                char *cached = object_cache_path(key);
+                ok = cached && file_exists(cached) && copy_file_atomic(cached, obj);
+                free(cached);
+            }
+        }
+        if (!ok && (flags->verbose_level > 0 || flags->trace_codegen))
+            printf("[prelude] bundle is stale (%s)\n", rel ? rel : path);
+        free(rel); free(hash); free(obj); free(key);
+    }
+
+    CompiledModule **mods = calloc(n ? n : 1, sizeof(*mods));
+    for (uint32_t i = 0; ok && i < n; i++) {
+        mods[i] = module_record_get(&r);
+        ok = mods[i] != NULL;
+    }
+    if (ok) {
+        for (uint32_t i = 0; i < n; i++) {
+            mods[i]->source_path = sources[i];
+            sources[i] = NULL;
+            registry_link(mods[i]);
+            register_compiled_module_wisp_arities(mods[i]);
+        }
+        if (flags->verbose_level > 0 || flags->trace_codegen)
+            printf("[prelude] loaded %u modules from %s\n", n, path);
+    } else {
+        for (uint32_t i = 0; i < n; i++)
+            if (mods[i]) registry_free_module(mods[i]);
+    }
+    for (uint32_t i = 0; i < n; i++) free(sources[i]);
+    free(sources);
+    free(mods);
+    iface_file_close(&file);
+    free(path);
+    return ok;
+}
+
+static bool prelude_bundle_write(const char *path, const char *core_real,
+                                 const CompilerFlags *flags) {
+    size_t n = 0;
+    for (CompiledModule *m = g_compiled; m; m = m->next)
+        if (dir_prefix_matches(m->source_path, core_real)) n++;
+
+    /* Registry order is newest-first; the bundle stores oldest-first so
+     * linking the records back reproduces it. */
+    CompiledModule **mods = calloc(n ? n : 1, sizeof(*mods));
+    size_t k = n;
+    for (CompiledModule *m = g_compiled; m; m = m->next)
+        if (dir_prefix_matches(m->source_path, core_real)) mods[--k] = m;
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < n; i++) {
+        if (mods[i]->uses_ffi) {
+            /* FFI declarations live in the global FFI context, which the
+             * bundle does not capture. */
+            fprintf(stderr, "prelude: %s uses (include ...); not bundling\n",
+                    mods[i]->source_path);
+            ok = false;
+        } else if (!mods[i]->cache_key[0] || !file_exists(mods[i]->obj_path)) {
+            fprintf(stderr, "prelude: no object for %s\n", mods[i]->source_path);
+            ok = false;
+        }
+    }
+
+    IfaceWriter w;
+    iface_writer_init(&w);
+    build_header_put(&w, PRELUDE_BUNDLE_MAGIC, PRELUDE_BUNDLE_VERSION, flags);
+    iface_put_u32(&w, (uint32_t)n);
+    for (size_t i = 0; ok && i < n; i++) {
+        const CompiledModule *m = mods[i];
+        char src_real[1024], hash[MODULE_HASH_HEX_LEN + 1];
+        struct stat st;
+        ok = host_realpath(m->source_path, src_real) &&
+             source_content_hash(src_real, hash) &&
+             stat(m->obj_path, &st) == 0;
+        if (!ok) break;
+        const char *rel = src_real + strlen(core_real);
+        while (*rel == '/' || *rel == '\\') rel++;
+        iface_put_str(&w, rel);
+        iface_put_str(&w, hash);
+        iface_put_str(&w, m->obj_path);
+        iface_put_str(&w, m->cache_key);
+        iface_put_i64(&w, (int64_t)st.st_size);
+        iface_put_i64(&w, (int64_t)st.st_mtime);
+    }
+    for (size_t i = 0; ok && i < n; i++)
+        module_record_put(&w, mods[i]);
+
+    ok = ok && w.ok && iface_writer_save(&w, path);
+    if (ok)
+        printf("prelude: %zu modules -> %s\n", n, path);
+    iface_writer_free(&w);
+    free(mods);
+    return ok;
+}
+
+// `monad prelude [-O<n>] [--test]`: compile the prelude the way any program
+// outside core/ sees it and write the bundle for those options.
+void cmd_prelude(const CompilerFlags *in) {
+    char core_real[1024];
+    if (!core_real_dir(core_real)) {
+        fprintf(stderr, "prelude: core library not found (set MONAD_CORE)\n");
+        exit(1);
+    }
+    char *bundle = prelude_bundle_path(core_real, in);
+    if (!bundle) {
+        fprintf(stderr, "prelude: $HOME not set\n");
+        exit(1);
+    }
+
+    /* A throwaway main module outside core/ pulls in exactly the modules a
+     * user program would get implicitly. */
+    char stub[1200];
+    snprintf(stub, sizeof(stub), "%s.stub.mon", bundle);
+    FILE *f = fopen(stub, "wb");
+    if (!f) { perror(stub); free(bundle); exit(1); }
+    fputs("(module Main)\n(show 0)\n", f);
+    fclose(f);
+
+    CompilerFlags flags = *in;
+    flags.mode       = CMD_COMPILE;
+    flags.input_file = stub;
+    flags.emit_obj   = true;
+    flags.jit        = false;
+    flags.profile_generate = false;
+    flags.profile_use      = NULL;
+
+    emit_pool_start(flags.jobs);
+    CompiledModule *main_mod = compile_one(stub, &flags, true);
+    bool ok = emit_pool_finish() && main_mod;
+    if (main_mod) remove(main_mod->obj_path);
+    remove(stub);
+
+    ok = ok && prelude_bundle_write(bundle, core_real, &flags);
+    free(bundle);
+    registry_free_all();
+    exit(ok ? 0 : 1);
+}
+
+// The .profdata pgo-instr-use should read.  A raw profile straight from an
+// instrumented run is merged beside it first, so `--profile-use=default.profraw`
+// works without a manual llvm-profdata step.
+static char *profile_use_resolve(const char *path) {
+    if (!file_exists(path)) {
+        fprintf(stderr, "error: profile %s not found\n", path);
+        return NULL;
+    }
+    size_t len = strlen(path);
+    if (len < 8 || strcmp(path + len - 8, ".profraw") != 0)
+        return strdup(path);
+
+    char *base = base_no_ext(path);
+    char *merged = malloc(strlen(base) + 10);
+    sprintf(merged, "%s.profdata", base);
+    free(base);
+    if (file_mtime(merged) >= file_mtime(path))
+        return merged;
+    char *cmd = malloc(strlen(path) + strlen(merged) + 48);
+    sprintf(cmd, "llvm-profdata merge -o \"%s\" \"%s\"", merged, path);
+    int rc = system(cmd);
+    free(cmd);
+    if (rc != 0) {
+        fprintf(stderr, "error: llvm-profdata could not merge %s\n", path);
+        free(merged);
+        return NULL;
+    }
+    return merged;
+}
+
+// --time-trace=FILE, or <input>.time-trace.json for a bare --time-trace.
+static char *time_trace_path(const CompilerFlags *flags) {
+    if (flags->time_trace[0]) return strdup(flags->time_trace);
+    char *base = base_no_ext(flags->input_file);
+    char *path = malloc(strlen(base) + 17);
+    sprintf(path, "%s.time-trace.json", base);
+    free(base);
+    return path;
+}
+
 static bool compile(CompilerFlags *flags) {
     g_ffi_link_libs[0]  = '\0';
     g_ffi_link_libs_len = 0;
     codegen_set_trace(flags->trace_codegen || flags->verbose_level > 0);
+    // The JIT cannot resolve the thread-local __monad_prof_site.
+    codegen_set_profile_sites(flags->profile_sites && !flags->jit);
+    codegen_clear_debug_points();
+    for (int i = 0; i < flags->breakpoint_count; i++)
+        if (!codegen_add_breakpoint(flags->breakpoints[i], flags->input_file)) exit(1);
+    for (int i = 0; i < flags->watch_count; i++)
+        if (!codegen_add_watch(flags->watches[i])) exit(1);
     infer_set_trace(flags->trace_dep || flags->verbose_level > 1);
 
+    char *profdata = NULL;
+    if (flags->profile_use && !(profdata = profile_use_resolve(flags->profile_use)))
+        exit(1);
+    llvm_configure_options(flags, profdata);
+    free(profdata);
+    if (flags->time_trace) {
+        char *trace_path = time_trace_path(flags);
+        time_trace_start(trace_path);
+        free(trace_path);
+    }
+    if (!host_target_warm()) exit(1);
+    emit_pool_start(flags->jobs);
+    time_trace_begin("prelude bundle", NULL);
+    prelude_bundle_load(flags);
+    time_trace_end();
     CompiledModule *main_mod = compile_one(flags->input_file, flags, true);
-    if (!main_mod) return true;  /* emit-json/JIT mode, no linking needed */
+    time_trace_begin("emit wait", NULL);
+    if (!emit_pool_finish()) exit(1);
+    time_trace_end();
+    if (!main_mod) {  /* emit-json/JIT mode, no linking needed */
+        time_trace_finish(stderr);
+        return true;
+    }
 
     // Collect .o files: registry is prepend (newest first), reverse to get
     // deps first so linker resolves symbols correctly. Deduplicate by realpath
@@ -2299,36 +3806,74 @@ static bool compile(CompilerFlags *flags) {
         }
     }
 
+    /* LTO needs a linker that loads the LLVM plugin; lld always does. */
     const char *ld_flag = "";
-    if (access("/usr/bin/mold", X_OK) == 0 ||
+    if (flags->lto != LTO_OFF)
+        ld_flag = " -fuse-ld=lld";
+    else if (access("/usr/bin/mold", X_OK) == 0 ||
         access("/usr/local/bin/mold", X_OK) == 0)
         ld_flag = " -fuse-ld=mold";
     else if (access("/usr/bin/ld.lld", X_OK) == 0 ||
              access("/usr/local/bin/ld.lld", X_OK) == 0)
         ld_flag = " -fuse-ld=lld";
 
-    char cmd[4096];
-    int w = snprintf(cmd, sizeof(cmd), "clang%s", ld_flag);
-    for (size_t i = 0; i < n; i++)
-        w += snprintf(cmd + w, sizeof(cmd) - w, " %s", objs[i]);
-
-    char *runtime_archive = runtime_archive_path();
+    /* Objects and flags go through a response file, so the shell command
+     * stays short however many modules the program links. */
+    char *runtime_archive = flags->lto != LTO_OFF ? runtime_lto_archive_path()
+                                                  : runtime_archive_path();
     char *llvm_flags = llvm_config_link_flags();
-    w += snprintf(cmd + w, sizeof(cmd) - w,
-                  " -o %s %s"
-                  " %s -lm -lgmp%s%s",
-                  exec_name, runtime_archive,
-                  llvm_flags,
-                  host_no_pie_flag(), g_ffi_link_libs);
+    char *rsp_path = malloc(strlen(exec_name) + 5);
+    sprintf(rsp_path, "%s.rsp", exec_name);
+    bool rsp_ok = false;
+    FILE *rsp = fopen(rsp_path, "w");
+    if (rsp) {
+        for (size_t i = 0; i < n; i++)
+            build_rsp_put_path(rsp, objs[i]);
+        fputs("-o\n", rsp);
+        build_rsp_put_path(rsp, exec_name);
+        build_rsp_put_path(rsp, runtime_archive);
+        if (flags->lto == LTO_FULL) {
+            fputs("-flto=full\n-O2\n", rsp);
+        } else if (flags->lto == LTO_THIN) {
+            fputs("-flto=thin\n-O2\n", rsp);
+            const char *home = getenv("HOME");
+            if (home && *home) {
+                char cache_dir[1024];
+                snprintf(cache_dir, sizeof(cache_dir),
+                         "-Wl,--thinlto-cache-dir=%s/.cache/monad/thinlto", home);
+                build_rsp_put_path(rsp, cache_dir);
+            }
+        }
+        if (flags->profile_generate)
+            fputs("-fprofile-generate\n", rsp);
+        fprintf(rsp, "%s -lm -lgmp -lpthread%s%s\n", llvm_flags, host_no_pie_flag(),
+                g_ffi_link_libs);
+        rsp_ok = !ferror(rsp);
+        if (fclose(rsp) != 0) rsp_ok = false;
+    }
     free(llvm_flags);
 
+    char *cmd = malloc(strlen(ld_flag) + strlen(rsp_path) + 16);
+    sprintf(cmd, "clang%s \"@%s\"", ld_flag, rsp_path);
 
-    if (flags->verbose_level > 0 || flags->trace_codegen)
+    if (flags->verbose_level > 0 || flags->trace_codegen) {
         printf("\n[link] %s\n", cmd);
+        FILE *dump = fopen(rsp_path, "r");
+        if (dump) {
+            char line[1024];
+            while (fgets(line, sizeof(line), dump)) printf("[link]   %s", line);
+            fclose(dump);
+        }
+    }
     struct timespec _lt0, _lt1;
+    time_trace_begin("link", exec_name);
     clock_gettime(CLOCK_MONOTONIC, &_lt0);
-    int rc = system(cmd);
+    int rc = rsp_ok ? system(cmd) : -1;
     clock_gettime(CLOCK_MONOTONIC, &_lt1);
+    time_trace_end();
+    remove(rsp_path);
+    free(rsp_path);
+    free(cmd);
     double _lms = (_lt1.tv_sec - _lt0.tv_sec) * 1000.0 +
                   (_lt1.tv_nsec - _lt0.tv_nsec) / 1e6;
     if (flags->verbose_level > 0 || flags->trace_codegen)
@@ -2351,6 +3896,7 @@ static bool compile(CompilerFlags *flags) {
     registry_free_all();
     wisp_clear_arities();
     if (g_ffi) { ffi_context_free(g_ffi); g_ffi = NULL; }
+    time_trace_finish(stderr);
     return rc == 0;
 }
 
@@ -2426,24 +3972,114 @@ void cmd_eval(const char *code) {
 }
 
 
-int main(int argc, char **argv) {
-    if (argc > 0)
-        g_program_path = argv[0];
-    CompilerFlags flags = parse_flags(argc, argv);
-    switch (flags.mode) {
+/// Compile server hooks (daemon.c)
+
+// What the server's warm registry was loaded from.  A worker keeps it only
+// when its own request would load the same, unchanged bundle.
+static struct {
+    char        *bundle;
+    struct stat  bundle_st;
+    char       **sources;
+    time_t      *mtimes;
+    size_t       count;
+} g_warm;
+
+char *daemon_warm_state(void) {
+    host_target_warm();
+    get_global_ffi();
+
+    CompilerFlags flags = {0};
+    flags.mode = CMD_COMPILE;
+    config_apply_default_flags(&flags);
+    flags.input_file = "Main.mon";
+
+    char core_real[1024];
+    if (!core_real_dir(core_real))
+        return strdup("no core directory");
+    g_warm.bundle = prelude_bundle_path(core_real, &flags);
+    if (!g_warm.bundle || stat(g_warm.bundle, &g_warm.bundle_st) != 0 ||
+        !prelude_bundle_load(&flags)) {
+        free(g_warm.bundle);
+        g_warm.bundle = NULL;
+        return strdup("no prelude bundle (run `monad prelude`)");
+    }
+
+    for (CompiledModule *m = g_compiled; m; m = m->next) g_warm.count++;
+    g_warm.sources = calloc(g_warm.count ? g_warm.count : 1, sizeof(*g_warm.sources));
+    g_warm.mtimes  = calloc(g_warm.count ? g_warm.count : 1, sizeof(*g_warm.mtimes));
+    size_t i = 0;
+    for (CompiledModule *m = g_compiled; m; m = m->next, i++) {
+        g_warm.sources[i] = m->source_path ? strdup(m->source_path) : NULL;
+        g_warm.mtimes[i]  = m->source_path ? file_mtime(m->source_path) : 0;
+    }
+
+    char summary[1400];
+    snprintf(summary, sizeof(summary), "prelude: %zu modules, -O%d, %s",
+             g_warm.count, flags.optimization_level, g_warm.bundle);
+    return strdup(summary);
+}
+
+static bool warm_state_usable(const CompilerFlags *flags) {
+    if (!g_warm.bundle || flags->mode != CMD_COMPILE) return false;
+    if (flags->jit || flags->profile_generate || flags->profile_use) return false;
+
+    char core_real[1024];
+    if (!core_real_dir(core_real)) return false;
+    if (dir_prefix_matches(flags->input_file, core_real) ||
+        source_is_prelude_file(flags->input_file))
+        return false;
+    char *path = prelude_bundle_path(core_real, flags);
+    bool same = path && strcmp(path, g_warm.bundle) == 0;
+    free(path);
+
+    struct stat st;
+    same = same && stat(g_warm.bundle, &st) == 0 &&
+           st.st_ino == g_warm.bundle_st.st_ino &&
+           st.st_size == g_warm.bundle_st.st_size &&
+           st.st_mtime == g_warm.bundle_st.st_mtime;
+    for (size_t i = 0; same && i < g_warm.count; i++)
+        same = !g_warm.sources[i] || file_mtime(g_warm.sources[i]) == g_warm.mtimes[i];
+    return same;
+}
+
+static int run_command(CompilerFlags *flags) {
+    switch (flags->mode) {
     case CMD_REPL:    repl_run();                        return 0;
-    case CMD_NEW:     cmd_new(flags.package_name);       return 0;
-    case CMD_BUILD:   cmd_build(&flags);                 return 0;
-    case CMD_RUN:     cmd_run(&flags);                   return 0;
+    case CMD_NEW:     cmd_new(flags->package_name);      return 0;
+    case CMD_BUILD:   cmd_build(flags);                  return 0;
+    case CMD_RUN:     cmd_run(flags);                    return 0;
     case CMD_CLEAN:   cmd_clean();                       return 0;
     case CMD_INSTALL: cmd_install();                     return 0;
-    case CMD_TEST:    cmd_test(&flags);                  return 0;
-    case CMD_CHECK:   cmd_check(flags.input_file);       return 0;
+    case CMD_TEST:    cmd_test(flags);                   return 0;
+    case CMD_CHECK:   cmd_check(flags->input_file);      return 0;
     case CMD_LSP:     cmd_lsp();                         return 0;
-    case CMD_EVAL:    cmd_eval(flags.eval_code);         return 0;
-    case CMD_DEBUG:   cmd_debug(&flags);                 return 0;
+    case CMD_EVAL:    cmd_eval(flags->eval_code);        return 0;
+    case CMD_DEBUG:   cmd_debug(flags);                  return 0;
+    case CMD_PRELUDE: cmd_prelude(flags);                return 0;
+    case CMD_BENCH:   cmd_bench(flags);                  return 0;
+    case CMD_DAEMON:  return daemon_main(flags);
     case CMD_COMPILE:
     default:
-        return compile(&flags) ? 0 : 1;
+        return compile(flags) ? 0 : 1;
+    }
+}
+
+int daemon_run_request(int argc, char **argv) {
+    g_program_path = argv[0];
+    CompilerFlags flags = parse_flags(argc, argv);
+    if (!warm_state_usable(&flags)) {
+        registry_free_all();
+        wisp_clear_arities();
     }
+    return run_command(&flags);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 0)
+        g_program_path = argv[0];
+    CompilerFlags flags = parse_flags(argc, argv);
+    int forwarded;
+    if (daemon_wants(&flags) && daemon_forward(argc, argv, &forwarded))
+        return forwarded;
+    return run_command(&flags);
 }
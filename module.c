@@ -3,6 +3,7 @@
 //  See module.h for the section map. This file mirrors it 1:1.
 
 #include "module.h"
+#include "scan.h"
 
 #include <ctype.h>
 #include <dirent.h>
@@ -449,24 +450,117 @@ ImportDecl *module_context_find_import(ModuleContext *ctx, const char *prefix)
 
 /// §6  Module registry (global, content-addressed)
 
-//// FNV-1a hashing
+//// Content hashing
  //
- //  Used both for the registry hash table (32-bit, for bucket selection)
- //  and for content-hashing source files for the build cache (64-bit,
- //  hex-encoded). FNV-1a is not cryptographically strong, but it is more
- //  than adequate for "did this file change" cache invalidation and has
- //  negligible cost.
+ //  Source files are content-hashed for the build cache (64-bit,
+ //  hex-encoded) with XXH64.  It is not cryptographically strong, but
+ //  "did this file change" only needs a well-mixed 64-bit digest, and at
+ //  several GB/s the hash is cheaper than the read that feeds it, so a
+ //  no-op build is bound by stat and I/O.  Incremental callers fold one
+ //  chunk at a time, using the running digest as the next chunk's seed.
  //
-static uint64_t fnv1a64(const char *data, size_t len)
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t xxh_rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t xxh_read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
 {
-    uint64_t h = 0xcbf29ce484222325ULL;
-    for (size_t i = 0; i < len; i++) {
-        h ^= (unsigned char)data[i];
-        h *= 0x100000001b3ULL;
+    acc += input * XXH_PRIME64_2;
+    acc  = xxh_rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val)
+{
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static uint64_t xxh64(const void *data, size_t len, uint64_t seed)
+{
+    const unsigned char *p   = data;
+    const unsigned char *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const unsigned char *limit = end - 32;
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        do {
+            v1 = xxh_round(v1, xxh_read64(p));      p += 8;
+            v2 = xxh_round(v2, xxh_read64(p));      p += 8;
+            v3 = xxh_round(v3, xxh_read64(p));      p += 8;
+            v4 = xxh_round(v4, xxh_read64(p));      p += 8;
+        } while (p <= limit);
+        h = xxh_rotl64(v1, 1) + xxh_rotl64(v2, 7) +
+            xxh_rotl64(v3, 12) + xxh_rotl64(v4, 18);
+        h = xxh_merge_round(h, v1);
+        h = xxh_merge_round(h, v2);
+        h = xxh_merge_round(h, v3);
+        h = xxh_merge_round(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+
+    h += (uint64_t)len;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h  = xxh_rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)xxh_read32(p) * XXH_PRIME64_1;
+        h  = xxh_rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t)*p * XXH_PRIME64_5;
+        h  = xxh_rotl64(h, 11) * XXH_PRIME64_1;
     }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
     return h;
 }
 
+uint64_t module_hash_update(uint64_t h, const void *data, size_t len)
+{
+    return xxh64(data, len, h);
+}
+
+// Registry bucket selection only needs a cheap string hash: FNV-1a 32.
 static uint32_t fnv1a32_str(const char *s)
 {
     uint32_t h = 2166136261u;
@@ -479,7 +573,7 @@ static uint32_t fnv1a32_str(const char *s)
 
 void module_hash_buffer(const char *data, size_t len, char *out)
 {
-    uint64_t h = fnv1a64(data, len);
+    uint64_t h = module_hash_update(MODULE_HASH_SEED, data, len);
     snprintf(out, MODULE_HASH_HEX_LEN + 1, "%016" PRIx64, h);
 }
 
@@ -1168,3 +1262,255 @@ ImportDecl *parse_import_decl(AST *ast)
     decl->qualified = false;
     return decl;
 }
+
+
+/// §11  Header scanning
+
+//// Lexical helpers
+ //
+ //  Offsets into a NUL-terminated source; every helper stops at the
+ //  terminator.  Comment rules mirror the reader's comment map and wisp's
+ //  commentary, drawer and metadata stripping.
+ //
+typedef enum { HDR_OTHER, HDR_MODULE, HDR_IMPORT, HDR_EXPORT } HdrKind;
+
+static size_t hdr_next_line(const char *s, size_t i)
+{
+    i += scan_to_any(s + i, "\n");
+    return s[i] ? i + 1 : i;
+}
+
+static size_t hdr_comment_marker_len(const char *s)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    if (p[0] == ';') return 1;
+    if (p[0] == 0xE2 && p[1] == 0x95 && p[2] >= 0xAD && p[2] <= 0xB0) return 3;
+    return 0;
+}
+
+// `;;; Commentary:` or `;;; Code:` on the line starting at `i`.
+static bool hdr_section_marker(const char *s, size_t i, const char *marker)
+{
+    i += scan_blank(s + i);
+    if (s[i] != ';') return false;
+    while (s[i] == ';') i++;
+    i += scan_blank(s + i);
+    size_t n = strlen(marker);
+    if (strncmp(s + i, marker, n) != 0) return false;
+    char c = s[i + n];
+    return c == '\0' || c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+// Past a `-|` at `i`: a block comment runs to its `|-`; one whose `|-`
+// is missing (another `-|` comes first) is a paragraph comment ending at
+// the next blank line.
+static size_t hdr_skip_dash_comment(const char *s, size_t i)
+{
+    size_t j = i + 2;
+    for (;;) {
+        j += scan_to_any(s + j, "|-");
+        if (!s[j] || (s[j] == '-' && s[j + 1] == '|')) break;
+        if (s[j] == '|' && s[j + 1] == '-') return j + 2;
+        j++;
+    }
+    for (j = i + 2; s[j]; j++) {
+        j += scan_to_any(s + j, "\n");
+        if (!s[j]) break;
+        size_t k = j + 1;
+        k += scan_blank(s + k);
+        if (!s[k] || s[k] == '\n') return j;
+    }
+    return j;
+}
+
+// Past the string, character literal or comment at `i`, or `i` itself
+// when none starts there.
+static size_t hdr_skip_literal(const char *s, size_t i)
+{
+    if (s[i] == '"') {
+        for (i++; s[i]; i += 2) {
+            i += scan_to_any(s + i, "\"\\");
+            if (s[i] != '\\') break;
+            if (!s[i + 1]) return i + 1;
+        }
+        return s[i] ? i + 1 : i;
+    }
+    if (s[i] == '\'') {
+        if (s[i + 1] && s[i + 1] != '\\' && s[i + 2] == '\'') return i + 3;
+        if (s[i + 1] == '\\')
+            for (size_t k = i + 3; s[k] && k < i + 8; k++)
+                if (s[k] == '\'') return k + 1;
+        return i;
+    }
+    if (hdr_comment_marker_len(s + i)) return i + scan_to_any(s + i, "\n");
+    if (s[i] == '-' && s[i + 1] == '|') return hdr_skip_dash_comment(s, i);
+    return i;
+}
+
+// Past the bracketed form opening at `i`.
+static size_t hdr_skip_form(const char *s, size_t i)
+{
+    int depth = 0;
+    while (s[i]) {
+        size_t k = hdr_skip_literal(s, i);
+        if (k != i) { i = k; continue; }
+        char c = s[i++];
+        if (c == '(' || c == '[' || c == '{') depth++;
+        else if ((c == ')' || c == ']' || c == '}') && --depth <= 0) break;
+    }
+    return i;
+}
+
+// Past the layout form whose head is on the line at `i`: the rest of that
+// line, then every line inside an open bracket or indented under it.
+// Returns the start of the next top-level line.
+static size_t hdr_skip_layout_form(const char *s, size_t i)
+{
+    int depth = 0;
+    for (;;) {
+        while (s[i] && s[i] != '\n') {
+            size_t k = hdr_skip_literal(s, i);
+            if (k != i) { i = k; continue; }
+            char c = s[i++];
+            if (c == '(' || c == '[' || c == '{') depth++;
+            else if ((c == ')' || c == ']' || c == '}') && depth > 0) depth--;
+        }
+        if (!s[i]) return i;
+        size_t next = ++i;
+        if (depth > 0) continue;
+        while (s[i + scan_blank(s + i)] == '\n')
+            i += scan_blank(s + i) + 1;
+        if (s[i] != ' ' && s[i] != '\t') return next;
+    }
+}
+
+// `:NAME:` alone on the line at `i` opens a drawer closed by the next
+// `:NAME:` line.  Returns the offset past the closing line, or 0.
+static size_t hdr_skip_drawer(const char *s, size_t i)
+{
+    size_t p = i + scan_blank(s + i);
+    if (s[p] != ':') return 0;
+    size_t name = p + 1, n = 0;
+    while (s[name + n] && s[name + n] != ':' &&
+           (isalnum((unsigned char)s[name + n]) || s[name + n] == '_' ||
+            s[name + n] == '-'))
+        n++;
+    if (n == 0 || s[name + n] != ':') return 0;
+    size_t after = name + n + 1;
+    after += scan_blank(s + after);
+    if (s[after] && s[after] != '\n') return 0;
+
+    for (size_t l = hdr_next_line(s, p); s[l]; l = hdr_next_line(s, l)) {
+        size_t q = l + scan_blank(s + l);
+        if (s[q] == ':' && strncmp(s + q + 1, s + name, n) == 0 &&
+            s[q + 1 + n] == ':') {
+            size_t r = q + n + 2;
+            r += scan_blank(s + r);
+            if (!s[r] || s[r] == '\n') return hdr_next_line(s, q);
+        }
+    }
+    return 0;
+}
+
+static size_t hdr_name_len(const char *s)
+{
+    size_t n = 0;
+    while (s[n] && !isspace((unsigned char)s[n]) && !strchr("()[]{}\";", s[n]))
+        n++;
+    return n;
+}
+
+static HdrKind hdr_kind(const char *s, size_t len)
+{
+    if (len == 6 && strncmp(s, "module", 6) == 0) return HDR_MODULE;
+    if (len == 6 && strncmp(s, "import", 6) == 0) return HDR_IMPORT;
+    if (len == 6 && strncmp(s, "export", 6) == 0) return HDR_EXPORT;
+    return HDR_OTHER;
+}
+
+//// Prologue scan
+ //
+ //  Walks top-level lines, skipping trivia and stepping over each header
+ //  form whole, so a multi-line export list or import filter is never
+ //  mistaken for the start of the body.
+ //
+bool module_scan_header(const char *source, ModuleHeader *out)
+{
+    memset(out, 0, sizeof(*out));
+    const char *s = source;
+    size_t i = 0;
+    bool in_commentary = false;
+
+    while (s[i]) {
+        size_t p = i + scan_blank(s + i);
+
+        if (in_commentary) {
+            if (hdr_section_marker(s, i, "Code:")) in_commentary = false;
+            i = hdr_next_line(s, i);
+            continue;
+        }
+        if (s[p] == '\n') { i = p + 1; continue; }
+        if (!s[p]) { i = p; break; }
+        if (hdr_comment_marker_len(s + p)) {
+            if (hdr_section_marker(s, i, "Commentary:")) in_commentary = true;
+            i = hdr_next_line(s, p);
+            continue;
+        }
+        if (s[p] == '-' && s[p + 1] == '|') {
+            i = hdr_skip_dash_comment(s, p);
+            continue;
+        }
+        if (s[p] == ':') {
+            size_t past = hdr_skip_drawer(s, i);
+            if (past) { i = past; continue; }
+            if (p == i && s[p + 1] && s[p + 1] != ':' &&
+                !isspace((unsigned char)s[p + 1])) {
+                i = hdr_skip_layout_form(s, p);   /* `:key value` metadata */
+                continue;
+            }
+        }
+
+        bool paren = s[p] == '(';
+        size_t h = paren ? p + 1 + scan_blank(s + p + 1) : p;
+        size_t hl = hdr_name_len(s + h);
+        HdrKind kind = hdr_kind(s + h, hl);
+        if (kind == HDR_OTHER) break;
+
+        size_t a = h + hl;
+        a += scan_blank(s + a);
+        size_t al = hdr_name_len(s + a);
+        if (kind == HDR_IMPORT && al == 9 && strncmp(s + a, "qualified", 9) == 0) {
+            a += al;
+            a += scan_blank(s + a);
+            al = hdr_name_len(s + a);
+        }
+        if (al > 0 && kind == HDR_MODULE && !out->module_name) {
+            out->module_name = mod_xmalloc(al + 1);
+            memcpy(out->module_name, s + a, al);
+            out->module_name[al] = '\0';
+        } else if (al > 0 && kind == HDR_IMPORT) {
+            MOD_GROW(out->imports, out->import_count, out->import_capacity,
+                     ModuleHeaderImport);
+            ModuleHeaderImport *imp = &out->imports[out->import_count++];
+            imp->module_name = mod_xmalloc(al + 1);
+            memcpy(imp->module_name, s + a, al);
+            imp->module_name[al] = '\0';
+            imp->layout = !paren;
+        }
+
+        i = paren ? hdr_skip_form(s, p) : hdr_skip_layout_form(s, p);
+    }
+
+    out->end = i;
+    return out->module_name != NULL || out->import_count > 0;
+}
+
+void module_header_free(ModuleHeader *header)
+{
+    if (!header) return;
+    for (size_t i = 0; i < header->import_count; i++)
+        free(header->imports[i].module_name);
+    free(header->imports);
+    free(header->module_name);
+    memset(header, 0, sizeof(*header));
+}
@@ -16,6 +16,7 @@
 //    §8   Symbol resolution
 //    §9   Module file path resolution
 //    §10  Parsing module/import/export forms
+//    §11  Header scanning
 //
 
 #ifndef MODULE_H
@@ -51,7 +52,8 @@
  //    (import Std.Math hiding [sqrt log])   ; hiding
  //
 #define MODULE_INDEX_BUCKETS 256
-#define MODULE_HASH_HEX_LEN  16   /* 64-bit FNV-1a, hex-encoded */
+#define MODULE_HASH_HEX_LEN  16   /* 64-bit XXH64, hex-encoded */
+#define MODULE_HASH_SEED     0ULL  /* XXH64 seed of the first chunk */
 
 /// §2 Export lists and module declarations
 
@@ -202,7 +204,7 @@ ImportDecl *module_context_find_import(ModuleContext *ctx, const char *prefix);
 typedef struct ModuleRegistryEntry {
     ModuleDecl *decl;
     char *source_path;
-    char content_hash[MODULE_HASH_HEX_LEN + 1];  // FNV-1a 64, hex
+    char content_hash[MODULE_HASH_HEX_LEN + 1];  // XXH64, hex
     char **dep_names;       // Direct dependency module names
     size_t dep_count;
     size_t dep_capacity;
@@ -234,8 +236,13 @@ ModuleRegistryEntry *module_registry_find(ModuleRegistry *registry, const char *
 ModuleDecl *module_registry_find_decl(ModuleRegistry *registry, const char *name);
 void module_registry_remove(ModuleRegistry *registry, const char *name);
 
-// FNV-1a 64-bit hash of a buffer, hex-encoded into `out` (>= 17 bytes).
+// XXH64 of a buffer, hex-encoded into `out` (>= 17 bytes).  Matches
+// `xxhsum -H64` for the same bytes.
 void module_hash_buffer(const char *data, size_t len, char *out);
+// Folds `len` bytes into a running hash, seeding XXH64 with the previous
+// digest; start from MODULE_HASH_SEED.  Equal inputs split into equal
+// chunks hash equally, which is all the caches rely on.
+uint64_t module_hash_update(uint64_t h, const void *data, size_t len);
 
 /// §7 Dependency graph
 
@@ -292,4 +299,43 @@ ModuleDecl *parse_module_decl(AST *ast);
 ImportDecl *parse_import_decl(AST *ast);
 ReExportDecl *parse_export_decl(AST *ast);
 
+/// §11 Header scanning
+
+//// Module header
+ //
+ //  The prologue of a source file: the leading `module`, `import` and
+ //  `export` forms, in either paren or layout syntax, together with the
+ //  comments, commentary sections, drawers and `:keyword` metadata lines
+ //  around them.  The prologue ends at the first other top-level form, so
+ //  dependency discovery never reads past it.
+ //
+ //    ;;; Main.mon --- entry point
+ //    :author "Laluxx"
+ //    import Data.Bool
+ //    (import qualified Std.Math :as M)
+ //    module Main                       ; <- still the prologue
+ //    define main ...                   ; <- `end` points here
+ //
+ //  The scan is lexical.  It records names only; the import filters and
+ //  export lists come from parsing `source[0, end)` (see
+ //  build_extract_module_context).
+ //
+typedef struct ModuleHeaderImport {
+    char *module_name;     // "Std.Math"
+    bool layout;           // `import X` rather than `(import X)`
+} ModuleHeaderImport;
+
+typedef struct ModuleHeader {
+    size_t end;                   // Offset of the first non-prologue form
+    char *module_name;            // From `module`, or NULL
+    ModuleHeaderImport *imports;  // In source order
+    size_t import_count;
+    size_t import_capacity;
+} ModuleHeader;
+
+// Scan the prologue of NUL-terminated `source` into `out`.  Returns true
+// when the file declares a module or imports anything.
+bool module_scan_header(const char *source, ModuleHeader *out);
+void module_header_free(ModuleHeader *header);
+
 #endif // MODULE_H
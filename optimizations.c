@@ -35,6 +35,7 @@
 
 #define _POSIX_C_SOURCE 200809L
 #include "optimizations.h"
+#include "time_trace.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -78,6 +79,8 @@ typedef struct Optimizer {
     const OptDataType          *data_types;   /* borrowed; may be NULL */
     size_t                      data_type_count;
     bool                        changed;       /* any rewrite fired this pass */
+    bool                        fuse;          /* sequence fusion enabled */
+    unsigned                    fuse_counter;  /* next fresh __fuse_ suffix */
 } Optimizer;
 
 
@@ -96,6 +99,7 @@ OptimizationOptions optimization_options_default(void) {
     o.fold_strings       = false;
     o.warn_unreachable   = false;
     o.warn_nonexhaustive = false;
+    o.fuse_sequences     = false;
     o.source_name        = NULL;
     return o;
 }
@@ -124,7 +128,7 @@ void opt_stats_print(const OptimizationStats *stats,
         "folded=%zu branches=%zu strings=%zu identities=%zu "
         "ctor_eq=%zu switch_candidates=%zu "
         "pmatch_clauses=%zu unreachable=%zu nonexhaustive=%zu "
-        "tail_calls=%zu\n",
+        "tail_calls=%zu fused=%zu\n",
         options ? optimization_level_name(options->level) : "?",
         stats->passes_run,
         stats->constants_registered,
@@ -138,7 +142,8 @@ void opt_stats_print(const OptimizationStats *stats,
         stats->pmatch_clauses_seen,
         stats->pmatch_unreachable,
         stats->pmatch_nonexhaustive,
-        stats->tail_calls_marked);
+        stats->tail_calls_marked,
+        stats->sequences_fused);
 }
 
 void opt_stats_reset(OptimizationStats *stats) {
@@ -1318,6 +1323,293 @@ static void analyze_pmatch(Optimizer *opt, AST *ast) {
     }
 }
 
+/// Sequence fusion — map / filter / foldl / range chains
+//
+//  Rewrites producer → transformer → consumer chains over the core
+//  Sequence functions so that no intermediate list is built:
+//
+//    (map g (map h s))         -> (map (λx. g (h x)) s)
+//    (filter p (filter q s))   -> (filter (λx. and (q x) (p x)) s)
+//    (foldl f z (map g s))     -> (foldl (λa x. f a (g x)) z s)
+//    (foldl f z (filter p s))  -> (foldl (λa x. if (p x) (f a x) a) z s)
+//    (foldl f z (lo .. hi))    -> (with [a z]
+//                                   (for [i lo hi+1] (set! a (f a i)))
+//                                   a)
+//
+//  Rules are retried on the node they produce, so a whole
+//  (foldl f z (map g (filter p (lo .. hi)))) chain collapses into one
+//  loop.  Functions are inlined as ((lambda …) args) applications, which
+//  codegen binds in place, or as direct calls when they are symbols.
+//
+//  Safety:
+//    · Every function in the chain is a symbol or a lambda of the right
+//      arity, so moving or copying it cannot move an effect, and none
+//      mentions an impure (`…!`) name, so per-element evaluation order
+//      is unobservable.
+//    · The rewrites rely on the list meaning of map/filter/foldl.  They
+//      are disabled for a module that defines or declares any of those
+//      names itself (the prelude modules that implement them) and under
+//      a lambda parameter of the same name.
+//    · Only a finite paren range whose element type is known to be Int
+//      (an integer literal endpoint) becomes a counted loop; a stepped
+//      range also needs a literal step, since `for` picks its loop
+//      direction from the step's sign at compile time.
+//    · Introduced binders are fresh `__fuse_` names, so no free name of
+//      the moved functions can be captured.
+//
+
+static const char *const FUSE_NAMES[] = { "map", "filter", "foldl" };
+
+typedef enum { FUSE_NONE = -1, FUSE_MAP, FUSE_FILTER, FUSE_FOLDL } FuseKind;
+
+static FuseKind fuse_kind(Optimizer *opt, AST *ast) {
+    if (!ast || ast->type != AST_LIST || ast->list.count < 3) return FUSE_NONE;
+    AST *head = ast->list.items[0];
+    if (!head || head->type != AST_SYMBOL) return FUSE_NONE;
+    for (int k = 0; k < 3; k++) {
+        if (strcmp(head->symbol, FUSE_NAMES[k]) != 0) continue;
+        size_t want = k == FUSE_FOLDL ? 4 : 3;
+        if (ast->list.count != want || is_shadowed(&opt->shadows, head->symbol))
+            return FUSE_NONE;
+        return (FuseKind)k;
+    }
+    return FUSE_NONE;
+}
+
+/*  fuse_pure: no sub-expression names an impure (`…!`) function.  Forms
+ *  this walk does not model are rejected. */
+static bool fuse_pure(AST *ast) {
+    if (!ast) return true;
+    switch (ast->type) {
+    case AST_SYMBOL: {
+        size_t n = strlen(ast->symbol);
+        return n == 0 || ast->symbol[n - 1] != '!';
+    }
+    case AST_NUMBER:
+    case AST_STRING:
+    case AST_CHAR:
+    case AST_KEYWORD:
+    case AST_RATIO:
+        return true;
+    case AST_LIST:
+        for (size_t i = 0; i < ast->list.count; i++)
+            if (!fuse_pure(ast->list.items[i])) return false;
+        return true;
+    case AST_ARRAY:
+        for (size_t i = 0; i < ast->array.element_count; i++)
+            if (!fuse_pure(ast->array.elements[i])) return false;
+        return true;
+    case AST_LAMBDA:
+        for (int i = 0; i < ast->lambda.body_count; i++)
+            if (!fuse_pure(ast->lambda.body_exprs[i])) return false;
+        return true;
+    case AST_RANGE:
+        return fuse_pure(ast->range.start) && fuse_pure(ast->range.step) &&
+               fuse_pure(ast->range.end);
+    default:
+        return false;
+    }
+}
+
+static bool fuse_fn_ok(AST *fn, int arity) {
+    if (!fn) return false;
+    if (fn->type == AST_SYMBOL) return fuse_pure(fn);
+    if (fn->type != AST_LAMBDA || fn->lambda.param_count != arity ||
+        fn->lambda.body_count == 0)
+        return false;
+    for (int i = 0; i < arity; i++)
+        if (fn->lambda.params[i].is_rest) return false;
+    return fuse_pure(fn);
+}
+
+static char *fuse_fresh(Optimizer *opt, const char *stem) {
+    char buf[48];
+    snprintf(buf, sizeof buf, "__fuse_%s%u", stem, opt->fuse_counter++);
+    return strdup(buf);
+}
+
+static AST *fuse_call(AST *fn, AST *a, AST *b) {
+    AST *call = ast_new_list();
+    ast_list_append(call, ast_clone(fn));
+    ast_list_append(call, a);
+    if (b) ast_list_append(call, b);
+    return call;
+}
+
+static AST *fuse_call3(const char *head, AST *a, AST *b, AST *c) {
+    AST *call = ast_new_list();
+    ast_list_append(call, ast_new_symbol(head));
+    ast_list_append(call, a);
+    ast_list_append(call, b);
+    if (c) ast_list_append(call, c);
+    return call;
+}
+
+/* Takes ownership of names (n of them) and body. */
+static AST *fuse_lambda(char **names, int n, AST *body) {
+    ASTParam *params = calloc((size_t)n, sizeof *params);
+    for (int i = 0; i < n; i++) params[i].name = names[i];
+    AST **exprs = malloc(sizeof *exprs);
+    exprs[0] = body;
+    return ast_new_lambda(params, n, NULL, NULL, NULL, false, body, exprs, 1);
+}
+
+static bool fuse_int_literal(AST *ast) {
+    return ast && ast->type == AST_NUMBER && number_is_integer(ast->number);
+}
+
+/*  fuse_range_loop: (foldl f z (lo .. hi)) as a counted loop, or NULL
+ *  when the range is not a finite Int range `for` can express.  The
+ *  range is inclusive; `for` stops before its end. */
+static AST *fuse_range_loop(Optimizer *opt, AST *f, AST *z, AST *range) {
+    if (range->type != AST_RANGE || range->range.is_array ||
+        !range->range.end)
+        return NULL;
+    AST *lo = range->range.start;
+    AST *hi = range->range.end;
+    if (!fuse_int_literal(lo) && !fuse_int_literal(hi)) return NULL;
+    if (!fuse_pure(lo) || !fuse_pure(hi)) return NULL;
+
+    double step = 1.0;
+    if (range->range.step) {
+        /* The range stores the second element, not the step. */
+        AST *next = range->range.step;
+        if (!fuse_int_literal(lo) || !fuse_int_literal(next)) return NULL;
+        step = next->number - lo->number;
+        if (step == 0.0) return NULL;
+    }
+
+    double bias = step > 0 ? 1.0 : -1.0;
+    AST *end = fuse_int_literal(hi)
+        ? number_ast(hi->number + bias)
+        : fuse_call3("+", ast_clone(hi), number_ast(bias), NULL);
+
+    char *acc = fuse_fresh(opt, "acc");
+    char *i   = fuse_fresh(opt, "i");
+
+    AST *binding = ast_new_array();
+    ast_array_append(binding, ast_new_symbol(i));
+    ast_array_append(binding, ast_clone(lo));
+    ast_array_append(binding, end);
+    if (range->range.step) ast_array_append(binding, number_ast(step));
+
+    AST *update = fuse_call3("set!", ast_new_symbol(acc),
+                             fuse_call(f, ast_new_symbol(acc),
+                                       ast_new_symbol(i)),
+                             NULL);
+    AST *loop = ast_new_list();
+    ast_list_append(loop, ast_new_symbol("for"));
+    ast_list_append(loop, binding);
+    ast_list_append(loop, update);
+
+    AST *init = ast_new_array();
+    ast_array_append(init, ast_new_symbol(acc));
+    ast_array_append(init, ast_clone(z));
+
+    AST *with = ast_new_list();
+    ast_list_append(with, ast_new_symbol("with"));
+    ast_list_append(with, init);
+    ast_list_append(with, loop);
+    ast_list_append(with, ast_new_symbol(acc));
+
+    free(acc);
+    free(i);
+    return with;
+}
+
+/*  fuse_step: one rewrite at ast, or ast itself when no rule applies. */
+static AST *fuse_step(Optimizer *opt, AST *ast) {
+    FuseKind outer = fuse_kind(opt, ast);
+    if (outer == FUSE_NONE) return ast;
+
+    AST *fn  = ast->list.items[1];
+    AST *src = ast->list.items[ast->list.count - 1];
+    if (!fuse_fn_ok(fn, outer == FUSE_FOLDL ? 2 : 1)) return ast;
+
+    if (outer == FUSE_FOLDL && src && src->type == AST_RANGE) {
+        AST *loop = fuse_range_loop(opt, fn, ast->list.items[2], src);
+        return loop ? loop : ast;
+    }
+
+    FuseKind inner = fuse_kind(opt, src);
+    if (inner == FUSE_NONE || inner == FUSE_FOLDL) return ast;
+    if (outer != FUSE_FOLDL && inner != outer) return ast;
+
+    AST *inner_fn = src->list.items[1];
+    AST *rest     = src->list.items[2];
+    if (!fuse_fn_ok(inner_fn, 1)) return ast;
+
+    if (outer == FUSE_MAP || outer == FUSE_FILTER) {
+        char *x = fuse_fresh(opt, "x");
+        AST *body = outer == FUSE_MAP
+            ? fuse_call(fn, fuse_call(inner_fn, ast_new_symbol(x), NULL), NULL)
+            : fuse_call3("and",
+                         fuse_call(inner_fn, ast_new_symbol(x), NULL),
+                         fuse_call(fn, ast_new_symbol(x), NULL),
+                         NULL);
+        char *names[] = { x };
+        return fuse_call3(FUSE_NAMES[outer], fuse_lambda(names, 1, body),
+                          ast_clone(rest), NULL);
+    }
+
+    char *a = fuse_fresh(opt, "a");
+    char *x = fuse_fresh(opt, "x");
+    AST *body;
+    if (inner == FUSE_MAP) {
+        body = fuse_call(fn, ast_new_symbol(a),
+                         fuse_call(inner_fn, ast_new_symbol(x), NULL));
+    } else {
+        body = fuse_call3("if",
+                          fuse_call(inner_fn, ast_new_symbol(x), NULL),
+                          fuse_call(fn, ast_new_symbol(a), ast_new_symbol(x)),
+                          ast_new_symbol(a));
+    }
+    char *names[] = { a, x };
+    return fuse_call3("foldl", fuse_lambda(names, 2, body),
+                      ast_clone(ast->list.items[2]), ast_clone(rest));
+}
+
+static AST *fuse_sequence_call(AST *ast, Optimizer *opt) {
+    if (!opt->fuse) return ast;
+    for (;;) {
+        AST *next = fuse_step(opt, ast);
+        if (next == ast) return ast;
+        next->line   = ast->line;
+        next->column = ast->column;
+        if (opt->stats) opt->stats->sequences_fused++;
+        ast = replace_node(ast, next, opt);
+    }
+}
+
+/*  module_defines_sequence_fn: a top-level define or class method that
+ *  (re)binds one of the fused names. */
+static bool module_defines_sequence_fn(ASTList *exprs) {
+    for (size_t i = 0; i < exprs->count; i++) {
+        AST *e = exprs->exprs[i];
+        if (!e) continue;
+        const char *name = NULL;
+        if (e->type == AST_LIST && e->list.count >= 2 &&
+            is_symbol(e->list.items[0], "define")) {
+            AST *target = e->list.items[1];
+            if (target && target->type == AST_SYMBOL)
+                name = target->symbol;
+            else if (target && target->type == AST_LIST &&
+                     target->list.count > 0 && target->list.items[0] &&
+                     target->list.items[0]->type == AST_SYMBOL)
+                name = target->list.items[0]->symbol;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (name && strcmp(name, FUSE_NAMES[k]) == 0) return true;
+            if (e->type != AST_CLASS) continue;
+            for (int m = 0; m < e->class_decl.method_count; m++)
+                if (strcmp(e->class_decl.method_names[m], FUSE_NAMES[k]) == 0)
+                    return true;
+        }
+    }
+    return false;
+}
+
+
 /*  head_op_tag: map a symbol string to an OpTag in O(1).
  *
  *  Implementation: trie on first character, disambiguated by length and
@@ -1411,7 +1703,7 @@ optimize_children:
     case OP_STR_APPEND:
         return fold_string_append(ast, opt);
     case OP_UNKNOWN:
-        return ast;
+        return fuse_sequence_call(ast, opt);
     }
     return ast;
 }
@@ -1638,16 +1930,25 @@ void optimize_ast_list(ASTList *exprs,
     opt.options         = options;
     opt.data_types      = data_types;
     opt.data_type_count = data_type_count;
+    opt.fuse            = options->fuse_sequences &&
+                          options->level >= OPT_LEVEL_AGGRESSIVE &&
+                          !module_defines_sequence_fn(exprs);
 
     int max_passes = (options->level == OPT_LEVEL_AGGRESSIVE) ? 4 : 2;
 
     trace_semantic_begin(options, exprs);
 
     for (int pass = 0; pass < max_passes; pass++) {
+        char pass_name[16];
+        snprintf(pass_name, sizeof(pass_name), "pass %d", pass + 1);
         opt.changed = false;
+        time_trace_begin("opt: collect constants", pass_name);
         collect_constants(&opt, exprs);
+        time_trace_end();
+        time_trace_begin("opt: rewrite", pass_name);
         for (size_t i = 0; i < exprs->count; i++)
             exprs->exprs[i] = optimize_expr(&opt, exprs->exprs[i]);
+        time_trace_end();
         stats->passes_run++;
         trace_semantic_pass(options, stats, pass, opt.changed, exprs);
         if (!opt.changed) break;
@@ -1705,6 +2006,7 @@ AST *optimize_expr_standalone(AST *expr,
         .fold_strings       = false,
         .warn_unreachable   = false,
         .warn_nonexhaustive = false,
+        .fuse_sequences     = false,
         .source_name        = NULL,
     };
     if (!options) options = &default_opts;
@@ -1719,7 +2021,9 @@ AST *optimize_expr_standalone(AST *expr,
     /* No enclosing program: no data registry available. Constructor
      * equality folding and pmatch exhaustiveness are simply inert here,
      * which is the correct conservative behaviour for an isolated
-     * expression with no visible `data` declarations. */
+     * expression with no visible `data` declarations.  Sequence fusion
+     * stays off for the same reason: nothing shows whether map, filter
+     * and foldl still have their prelude meaning. */
 
     int max_passes = (options->level == OPT_LEVEL_AGGRESSIVE) ? 4 : 2;
     for (int pass = 0; pass < max_passes; pass++) {
@@ -5,9 +5,10 @@
  *
  *  Implements semantic-level optimization passes over the desugared AST,
  *  running after parsing and desugaring but before dependent checking and
- *  codegen.  The pipeline is purely rewriting-based: it never introduces
- *  new names, never changes observable semantics, and is safe jto skip
- *  entirely (OPT_LEVEL_NONE).
+ *  codegen.  The pipeline is purely rewriting-based: it never changes
+ *  observable semantics and is safe jto skip entirely (OPT_LEVEL_NONE).
+ *  The only new names it introduces are the fresh `__fuse_` binders of
+ *  sequence fusion.
  *
  *  Passes (in order within each fixed-point iteration):
  *    · Constant registration   — immutable top-level "::" bindings
@@ -23,6 +24,8 @@
  *    · Switch-shape detection  — (if (= x k1) … (if (= x k2) …)) chains
  *    · Pattern-match analysis  — clause reachability + exhaustiveness
  *    · Tail-position annotation — marks tail calls inside lambda bodies
+ *    · Sequence fusion         — map/filter/foldl/range chains become one
+ *                                traversal or loop (AGGRESSIVE only)
  *
  *  Coverage:
  *    Every ASTType in reader.h is visited by optimize_expr.  Forms with
@@ -104,6 +107,9 @@ const char *optimization_level_name(OptimizationLevel level);
 //  warn_nonexhaustive — print a diagnostic when a pmatch over a known
 //                        `data` type does not cover all constructors and
 //                        has no trailing wildcard/var clause.
+//  fuse_sequences     — fuse map/filter/foldl chains and fold ranges into
+//                        counted loops (AGGRESSIVE only).  Skipped for a
+//                        module that defines any of those names itself.
 //  source_name        — file name shown in trace/diagnostic output, NULL ok.
 //
 typedef struct OptimizationOptions {
@@ -113,6 +119,7 @@ typedef struct OptimizationOptions {
     bool               fold_strings;
     bool               warn_unreachable;
     bool               warn_nonexhaustive;
+    bool               fuse_sequences;
     const char        *source_name;
 } OptimizationOptions;
 
@@ -139,6 +146,7 @@ OptimizationOptions optimization_options_default(void);
 //  pmatch_unreachable     — clauses proven unreachable by an earlier clause.
 //  pmatch_nonexhaustive   — pmatch expressions found non-exhaustive.
 //  tail_calls_marked      — lambda-body call sites annotated as tail calls.
+//  sequences_fused        — map/filter/foldl/range links fused away.
 //  passes_run             — total fixed-point passes executed.
 //
 typedef struct OptimizationStats {
@@ -154,6 +162,7 @@ typedef struct OptimizationStats {
     size_t pmatch_unreachable;
     size_t pmatch_nonexhaustive;
     size_t tail_calls_marked;
+    size_t sequences_fused;
     size_t passes_run;
 } OptimizationStats;
 
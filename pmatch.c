@@ -1,6 +1,7 @@
 #include "pmatch.h"
 #include "reader.h"
 #include "types.h"
+#include "optimizations.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -1385,17 +1386,323 @@ void pmatch_validate_ignored_signature_params(AST *pm,
     }
 }
 
+/// Decision tree
+//
+//  Each clause becomes a row: the tests build_pattern_conditions produced,
+//  in order, over the clause body.  Rather than testing every row in turn,
+//  the compiler takes the first test of the first row and the run of rows
+//  after it whose first test is on the same scrutinee, and branches once
+//  for the whole run:
+//
+//    · equality with a pattern constant (ADT tag, literal, finite member,
+//      fixed count): rows are grouped by constant and the groups become a
+//      single same-selector equality chain;
+//    · any other pattern test (emptiness, has-at-least): rows sharing that
+//      exact test are compiled together under one `if`.
+//
+//  Each branch goes on with the remaining tests of its rows and falls
+//  through to the rows after the run, which are compiled once and cloned
+//  into every branch that can fail.  When that tail is large, the first
+//  row is tested on its own instead, so code size stays linear.  Tests
+//  within a row keep their order, since later ones index what earlier
+//  ones checked, and guard conditions are never shared: they may have
+//  effects.
+//
+//    0 0 -> a     (if (= x 0)
+//    0 _ -> b         (if (= y 0) a b)
+//    1 y -> y         (if (= x 1) y c))
+//    _ _ -> c
+//
+//  pattern_subsumes drops clauses an earlier unguarded clause already
+//  covers, and pmatch_is_exhaustive lets a chain over a finite type skip
+//  its last comparison, so a complete match never reaches `undefined`.
+
+// Tails above this many AST nodes are not duplicated across branches.
+#define PMATCH_TREE_SHARE_LIMIT 64
+
+typedef struct PMatchTest {
+    AST               *expr;
+    const ASTPattern  *pat;   // top-level pattern this test checks, or NULL
+    const OptDataType *type;  // finite type of that pattern's column, or NULL
+} PMatchTest;
+
+typedef struct PMatchRow {
+    PMatchTest *tests;
+    int         test_count;
+    int         shared_count; // leading tests from patterns; the rest are guards
+    AST        *body;
+} PMatchRow;
+
+static bool pmatch_ast_equal(AST *a, AST *b) {
+    if (!a || !b || a->type != b->type) return false;
+    switch (a->type) {
+    case AST_SYMBOL:  return strcmp(a->symbol, b->symbol) == 0;
+    case AST_STRING:  return strcmp(a->string, b->string) == 0;
+    case AST_KEYWORD: return strcmp(a->keyword, b->keyword) == 0;
+    case AST_NUMBER:  return a->number == b->number;
+    case AST_CHAR:    return a->character == b->character;
+    case AST_LIST:
+        if (a->list.count != b->list.count) return false;
+        for (size_t i = 0; i < a->list.count; i++)
+            if (!pmatch_ast_equal(a->list.items[i], b->list.items[i]))
+                return false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Node count of `ast`, saturating just above `limit`.
+static int pmatch_ast_size(AST *ast, int limit) {
+    if (!ast) return 0;
+    if (ast->type != AST_LIST) return 1;
+    int n = 1;
+    for (size_t i = 0; i < ast->list.count && n <= limit; i++)
+        n += pmatch_ast_size(ast->list.items[i], limit - n);
+    return n;
+}
+
+// (= S K) with K a literal or constant symbol — the shape of every
+// equality build_pattern_conditions emits.  Only pattern tests are asked,
+// so a symbol K is always a tag or finite member, never a variable.
+static AST *pmatch_const_eq_selector(AST *t) {
+    if (!t || t->type != AST_LIST || t->list.count != 3) return NULL;
+    AST *head = t->list.items[0];
+    if (head->type != AST_SYMBOL || strcmp(head->symbol, "=") != 0) return NULL;
+    switch (t->list.items[2]->type) {
+    case AST_NUMBER: case AST_STRING: case AST_CHAR:
+    case AST_KEYWORD: case AST_SYMBOL:
+        return t->list.items[1];
+    default:
+        return NULL;
+    }
+}
+
+// A group whose rows all test further can fall through to the tail.
+static bool pmatch_rows_can_fail(const PMatchRow *rows, int n) {
+    for (int i = 0; i < n; i++)
+        if (rows[i].test_count == 0) return false;
+    return true;
+}
+
+static PMatchRow pmatch_row_drop_first(const PMatchRow *row) {
+    PMatchRow r = *row;
+    r.tests++;
+    r.test_count--;
+    r.shared_count--;
+    return r;
+}
+
+static AST *make_if(AST *cond, AST *then, AST *otherwise) {
+    AST *items[] = {sym("if"), cond, then, otherwise};
+    return make_list(items, 4);
+}
+
+static AST *pmatch_tree_compile(const PMatchRow *rows, int n, AST *fail);
+
+// `rows[0]` alone: (if (and its tests...) body <rest>).
+static AST *pmatch_tree_sequential(const PMatchRow *rows, int n, AST *fail) {
+    const PMatchRow *r0 = &rows[0];
+    AST **parts = malloc(sizeof(AST *) * (size_t)r0->test_count);
+    for (int i = 0; i < r0->test_count; i++)
+        parts[i] = ast_clone(r0->tests[i].expr);
+    AST *cond = make_and(parts, r0->test_count);
+    free(parts);
+    return make_if(cond, ast_clone(r0->body),
+                   pmatch_tree_compile(rows + 1, n - 1, fail));
+}
+
+// Whether `tail` may be cloned into the branches of a run.
+static bool pmatch_tail_shareable(AST *tail) {
+    return pmatch_ast_size(tail, PMATCH_TREE_SHARE_LIMIT) <= PMATCH_TREE_SHARE_LIMIT;
+}
+
+// Run of rows whose first test is an equality on `sel`: one chain of
+// comparisons, one branch per distinct constant.
+static AST *pmatch_tree_switch(const PMatchRow *rows, int n, AST *fail,
+                               AST *sel) {
+    int end = 1;
+    while (end < n && rows[end].shared_count > 0 &&
+           pmatch_ast_equal(pmatch_const_eq_selector(rows[end].tests[0].expr), sel))
+        end++;
+    if (end == 1) return pmatch_tree_sequential(rows, n, fail);
+
+    /* Group the run by constant, keeping first-appearance order.  Rows with
+     * different constants exclude each other, so regrouping them cannot
+     * change which clause matches first. */
+    int *group_of   = malloc(sizeof(int) * (size_t)end);
+    int *group_head = malloc(sizeof(int) * (size_t)end);
+    int  groups = 0;
+    for (int i = 0; i < end; i++) {
+        AST *key = rows[i].tests[0].expr->list.items[2];
+        int g = 0;
+        while (g < groups &&
+               !pmatch_ast_equal(rows[group_head[g]].tests[0].expr->list.items[2], key))
+            g++;
+        if (g == groups) group_head[groups++] = i;
+        group_of[i] = g;
+    }
+
+    /* A run covering every member of a finite type needs no final test. */
+    const OptDataType *type = rows[0].tests[0].type;
+    const ASTPattern **pats = malloc(sizeof(ASTPattern *) * (size_t)end);
+    bool exhaustive = type != NULL;
+    for (int i = 0; i < end && exhaustive; i++) {
+        pats[i] = rows[i].tests[0].pat;
+        exhaustive = pats[i] && rows[i].tests[0].type == type;
+    }
+    exhaustive = exhaustive && pmatch_is_exhaustive(pats, end, type);
+    free(pats);
+
+    AST       *rest  = pmatch_tree_compile(rows + end, n - end, fail);
+    PMatchRow *group = malloc(sizeof(PMatchRow) * (size_t)end);
+    AST      **arms  = malloc(sizeof(AST *) * (size_t)groups);
+    bool       share = pmatch_tail_shareable(rest);
+    for (int g = 0; g < groups; g++) {
+        int count = 0;
+        for (int i = 0; i < end; i++)
+            if (group_of[i] == g) group[count++] = pmatch_row_drop_first(&rows[i]);
+        if (!share && pmatch_rows_can_fail(group, count)) {
+            for (int k = 0; k < g; k++) ast_free(arms[k]);
+            free(arms); free(group); free(group_of); free(group_head);
+            ast_free(rest);
+            return pmatch_tree_sequential(rows, n, fail);
+        }
+        arms[g] = pmatch_tree_compile(group, count, rest);
+    }
+
+    AST *chain = exhaustive ? NULL : rest;
+    for (int g = groups - 1; g >= 0; g--) {
+        if (!chain) {
+            chain = arms[g];
+            continue;
+        }
+        chain = make_if(ast_clone(rows[group_head[g]].tests[0].expr), arms[g], chain);
+    }
+    if (exhaustive) ast_free(rest);
+
+    free(arms);
+    free(group);
+    free(group_of);
+    free(group_head);
+    return chain;
+}
+
+// Run of rows sharing their first test exactly: test it once.
+static AST *pmatch_tree_shared(const PMatchRow *rows, int n, AST *fail) {
+    AST *test = rows[0].tests[0].expr;
+    int end = 1;
+    while (end < n && rows[end].shared_count > 0 &&
+           pmatch_ast_equal(rows[end].tests[0].expr, test))
+        end++;
+    if (end == 1) return pmatch_tree_sequential(rows, n, fail);
+
+    PMatchRow *group = malloc(sizeof(PMatchRow) * (size_t)end);
+    for (int i = 0; i < end; i++) group[i] = pmatch_row_drop_first(&rows[i]);
+
+    AST *rest = pmatch_tree_compile(rows + end, n - end, fail);
+    if (pmatch_rows_can_fail(group, end) && !pmatch_tail_shareable(rest)) {
+        free(group);
+        ast_free(rest);
+        return pmatch_tree_sequential(rows, n, fail);
+    }
+    AST *then = pmatch_tree_compile(group, end, rest);
+    free(group);
+    return make_if(ast_clone(test), then, rest);
+}
+
+// Compile `rows` to nested ifs; `fail` is cloned wherever no row matches.
+static AST *pmatch_tree_compile(const PMatchRow *rows, int n, AST *fail) {
+    if (n == 0) return ast_clone(fail);
+    const PMatchRow *r0 = &rows[0];
+    if (r0->test_count == 0) return ast_clone(r0->body);
+    if (r0->shared_count == 0) return pmatch_tree_sequential(rows, n, fail);
+
+    AST *sel = pmatch_const_eq_selector(r0->tests[0].expr);
+    if (sel) return pmatch_tree_switch(rows, n, fail, sel);
+    return pmatch_tree_shared(rows, n, fail);
+}
+
+// `otherwise`, or the `| True` wisp appends to every unguarded method
+// clause: a guard that always holds and so tests nothing.
+static bool pmatch_guard_trivial(const AST *cond) {
+    return cond && cond->type == AST_SYMBOL &&
+           (strcmp(cond->symbol, "otherwise") == 0 ||
+            strcmp(cond->symbol, "True") == 0);
+}
+
+// A clause matches whenever its patterns do.
+static bool pmatch_clause_total(const ASTPMatchClause *cl) {
+    if (cl->guard_count == 0) return true;
+    for (int g = 0; g < cl->guard_count; g++)
+        if (pmatch_guard_trivial(cl->guard_conds[g])) return true;
+    return false;
+}
+
+// Clause `ci` can never match: an earlier unguarded clause's patterns
+// subsume its own in every column.
+static bool pmatch_clause_dead(AST *node, int ci) {
+    const ASTPMatchClause *cl = &node->pmatch.clauses[ci];
+    for (int j = 0; j < ci; j++) {
+        const ASTPMatchClause *prior = &node->pmatch.clauses[j];
+        if (!pmatch_clause_total(prior) || prior->pattern_count != cl->pattern_count)
+            continue;
+        bool covered = true;
+        for (int k = 0; k < cl->pattern_count && covered; k++)
+            covered = pattern_subsumes(&prior->patterns[k], &cl->patterns[k]);
+        if (covered) return true;
+    }
+    return false;
+}
+
+// Constructor view of a finite-set parameter type, for pmatch_is_exhaustive.
+// Only all-symbol sets qualify, since those are what constructor patterns
+// name.  The names are borrowed from the finite-set registry.
+static bool pmatch_column_type(const char *type_name, OptDataType *out) {
+    const FiniteTypeSetEntry *finite = finite_type_set_lookup(type_name);
+    if (!finite || finite->member_count == 0) return false;
+    for (size_t i = 0; i < finite->member_count; i++)
+        if (finite->members[i].kind != FINITE_MEMBER_SYMBOL) return false;
+    out->type_name    = finite->name;
+    out->ctor_names   = malloc(sizeof(char *) * finite->member_count);
+    out->ctor_arities = NULL;
+    out->ctor_count   = (int)finite->member_count;
+    for (size_t i = 0; i < finite->member_count; i++)
+        out->ctor_names[i] = finite->members[i].spelling;
+    return true;
+}
+
+static void pmatch_push_row(PMatchRow **rows, int *count, int *cap,
+                            PMatchTest *tests, int test_count,
+                            int shared_count, AST *body) {
+    if (*count >= *cap) {
+        *cap  = *cap ? *cap * 2 : 8;
+        *rows = realloc(*rows, sizeof(PMatchRow) * (size_t)*cap);
+    }
+    (*rows)[*count] = (PMatchRow){tests, test_count, shared_count, body};
+    (*count)++;
+}
+
 AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
     if (!node || node->type != AST_PMATCH) return node;
 
-    // Build (cond [guard body] ... [else (undefined)]) then desugar
-    // into if-chains via desugar_cond_ast. make_let already calls
-    // desugar_let_ast so bindings are handled correctly.
-    AST *cond_list = ast_new_list();
-    ast_list_append(cond_list, sym("cond"));
+    // Build one row of tests per clause (per guard, for guarded clauses),
+    // then compile the rows to a decision tree of nested ifs.  make_let
+    // substitutes bindings straight into guards and bodies.
+    PMatchRow *rows      = NULL;
+    int        row_count = 0;
+    int        row_cap   = 0;
+
+    OptDataType *col_types = calloc(param_count > 0 ? (size_t)param_count : 1,
+                                    sizeof(OptDataType));
+    bool        *col_known = calloc(param_count > 0 ? (size_t)param_count : 1,
+                                    sizeof(bool));
+    for (int j = 0; j < param_count; j++)
+        col_known[j] = pmatch_column_type(params[j].type_name, &col_types[j]);
 
     for (int i = 0; i < node->pmatch.clause_count; i++) {
         ASTPMatchClause *cl = &node->pmatch.clauses[i];
+        if (pmatch_clause_dead(node, i)) continue;
 
         AST    **guard_parts = NULL;
         int      guard_count = 0;
@@ -1404,8 +1711,13 @@ AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
         int          bind_count = 0;
         int          bind_cap   = 0;
 
+        // The first test each column pushes is its top-level one.
+        const ASTPattern  **test_pats  = NULL;
+        const OptDataType **test_types = NULL;
+
         for (int j = 0; j < cl->pattern_count && j < param_count; j++) {
             const char *elem_type = params[j].type_name;
+            int before = guard_count;
 
             build_pattern_conditions(
                 &cl->patterns[j],
@@ -1414,15 +1726,19 @@ AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
                 &guard_parts, &guard_count,
                 &bind_names,  &bind_exprs,
                 &bind_count,  &bind_cap);
+
+            test_pats  = realloc(test_pats,  sizeof(ASTPattern *)  * (size_t)(guard_count + 1));
+            test_types = realloc(test_types, sizeof(OptDataType *) * (size_t)(guard_count + 1));
+            for (int t = before; t < guard_count; t++) {
+                bool top = t == before;
+                test_pats[t]  = top ? &cl->patterns[j] : NULL;
+                test_types[t] = top && col_known[j] ? &col_types[j] : NULL;
+            }
         }
 
         if (cl->guard_count > 0) {
-            // Guarded clause: pattern conditions are shared across all guards.
-            // Build the pattern guard once, then AND it with each guard cond.
-            AST *pattern_guard = (guard_count == 0)
-                ? NULL
-                : make_and(guard_parts, guard_count);
-
+            // Guarded clause: every guard gets its own row, repeating the
+            // pattern tests so the tree can share them across rows.
             for (int gi = 0; gi < cl->guard_count; gi++) {
                 AST *gcond = ast_clone(cl->guard_conds[gi]);
                 AST *gbody = ast_clone(cl->guard_bodies[gi]);
@@ -1432,18 +1748,16 @@ AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
                     gbody = make_let(bind_names, bind_exprs, bind_count, gbody);
                 }
 
-                bool is_otherwise = (gcond->type == AST_SYMBOL &&
-                                     strcmp(gcond->symbol, "otherwise") == 0);
-                AST *combined;
-                if (is_otherwise) {
+                bool is_otherwise = pmatch_guard_trivial(cl->guard_conds[gi]);
+                PMatchTest *tests = malloc(sizeof(PMatchTest) * (size_t)(guard_count + 1));
+                int         test_count = 0;
+                for (int t = 0; t < guard_count; t++)
+                    tests[test_count++] = (PMatchTest){
+                        ast_clone(guard_parts[t]), test_pats[t], test_types[t]};
+                if (is_otherwise)
                     ast_free(gcond);
-                    combined = pattern_guard ? ast_clone(pattern_guard) : sym("else");
-                } else if (pattern_guard) {
-                    AST *parts[2] = { ast_clone(pattern_guard), gcond };
-                    combined = make_and(parts, 2);
-                } else {
-                    combined = gcond;
-                }
+                else
+                    tests[test_count++] = (PMatchTest){gcond, NULL, NULL};
 
                 /* Polymorphic empty collection in guard body: [] -> (rt_coll_empty __p_N) */
                 if ((gbody->type == AST_LIST  && gbody->list.count == 0) ||
@@ -1469,16 +1783,14 @@ AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
                     gbody = app;
                 }
 
-                AST *branch = ast_new_list();
-                ast_list_append(branch, combined);
-                ast_list_append(branch, gbody);
-                ast_list_append(cond_list, branch);
+                pmatch_push_row(&rows, &row_count, &row_cap,
+                                tests, test_count, guard_count, gbody);
             }
-            if (pattern_guard) ast_free(pattern_guard);
+            for (int t = 0; t < guard_count; t++) ast_free(guard_parts[t]);
         } else {
-            AST *guard = (guard_count == 0)
-                ? sym("else")
-                : make_and(guard_parts, guard_count);
+            PMatchTest *tests = malloc(sizeof(PMatchTest) * (size_t)(guard_count + 1));
+            for (int t = 0; t < guard_count; t++)
+                tests[t] = (PMatchTest){guard_parts[t], test_pats[t], test_types[t]};
 
             AST *body = ast_clone(cl->body);
 
@@ -1545,39 +1857,35 @@ AST *pmatch_desugar(AST *node, ASTParam *params, int param_count) {
                 }
             }
 
-            AST *clause = ast_new_list();
-            ast_list_append(clause, guard);
-            ast_list_append(clause, body);
-            ast_list_append(cond_list, clause);
+            pmatch_push_row(&rows, &row_count, &row_cap,
+                            tests, guard_count, guard_count, body);
         }
 
         free(guard_parts);
+        free(test_pats);
+        free(test_types);
         free(bind_names);
         free(bind_exprs);
     }
 
     // Fallthrough: non-exhaustive pattern match
-    // Only add if the last clause wasn't already a wildcard (else)
-    bool has_else = false;
-    if (cond_list->list.count > 1) {
-        AST *last_clause = cond_list->list.items[cond_list->list.count - 1];
-        if (last_clause && last_clause->type == AST_LIST && last_clause->list.count > 0) {
-            AST *last_guard  = last_clause->list.items[0];
-            if (last_guard && last_guard->type == AST_SYMBOL && last_guard->symbol) {
-                has_else = (strcmp(last_guard->symbol, "else") == 0);
-            }
-        }
-    }
-    if (!has_else) {
-        AST *undef_call = ast_new_list();
-        ast_list_append(undef_call, sym("undefined"));
-        AST *else_clause = ast_new_list();
-        ast_list_append(else_clause, sym("else"));
-        ast_list_append(else_clause, undef_call);
-        ast_list_append(cond_list, else_clause);
-    }
+    AST *undef_call = ast_new_list();
+    ast_list_append(undef_call, sym("undefined"));
 
-    return desugar_cond_ast(cond_list);
+    AST *tree = pmatch_tree_compile(rows, row_count, undef_call);
+
+    ast_free(undef_call);
+    for (int r = 0; r < row_count; r++) {
+        for (int t = 0; t < rows[r].test_count; t++) ast_free(rows[r].tests[t].expr);
+        free(rows[r].tests);
+        ast_free(rows[r].body);
+    }
+    free(rows);
+    for (int j = 0; j < param_count; j++)
+        if (col_known[j]) free(col_types[j].ctor_names);
+    free(col_types);
+    free(col_known);
+    return tree;
 }
 
 void pattern_free(ASTPattern *p) {
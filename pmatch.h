@@ -40,12 +40,12 @@ void pmatch_validate_ignored_signature_params(AST *pm,
 // Transform an AST_PMATCH node into an equivalent conditional AST
 // given the function's parameter list.
 //
-// Discrete constructor and integer-literal clauses are emitted as
-// same-selector equality chains.  codegen.c recognizes that shape and
-// lowers it with LLVMBuildSwitch, giving pmatch-backed constructor
-// dispatch the same jump-table-friendly IR as explicit switch forms.
-// Guarded clauses and structural/list/string matches keep conditional
-// lowering because their predicates are not single-tag dispatch.
+// Clauses are compiled to a decision tree: clauses that begin with the
+// same test share one evaluation of it, and constructor, literal and
+// fixed-length clauses on one scrutinee become a single same-selector
+// equality chain, one comparison per distinct constant.  That is the
+// shape codegen.c's switch lowering recognizes, and LLVM folds such
+// chains into a switch on its own.  Guard conditions are never shared.
 // The returned AST is freshly allocated and owned by the caller.
 // Called from codegen before the lambda body is compiled.
 AST *pmatch_desugar(AST *pmatch_node, ASTParam *params, int param_count);
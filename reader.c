@@ -1,4 +1,6 @@
 #include "reader.h"
+#include "arena.h"
+#include "scan.h"
 #include "features.h"
 #include "pmatch.h"
 #include "types.h"
@@ -289,9 +291,7 @@ void drawer_map_build(const char *source) {
     int len = (int)strlen(source);
     int line_start = 0;
     while (line_start < len) {
-        int line_end = line_start;
-        while (line_end < len && source[line_end] != '\n')
-            line_end++;
+        int line_end = line_start + (int)scan_to_any(source + line_start, "\n");
 
         int marker_pos = -1;
         char *name = NULL;
@@ -305,9 +305,7 @@ void drawer_map_build(const char *source) {
         int close_end = -1;
         int scan_line = scan_start;
         while (scan_line < len) {
-            int scan_line_end = scan_line;
-            while (scan_line_end < len && source[scan_line_end] != '\n')
-                scan_line_end++;
+            int scan_line_end = scan_line + (int)scan_to_any(source + scan_line, "\n");
 
             int close_marker_pos = -1;
             char *close_name = NULL;
@@ -336,10 +334,17 @@ void drawer_map_build(const char *source) {
     }
 }
 
+/* Spans are recorded in source order, so lookups bisect on open_pos.
+ * The lexer asks at every token. */
 static DrawerSpan *drawer_map_lookup(int pos) {
-    for (int i = 0; i < g_drawer_count; i++)
-        if (g_drawer_spans[i].open_pos == pos)
-            return &g_drawer_spans[i];
+    int lo = 0, hi = g_drawer_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (g_drawer_spans[mid].open_pos < pos) lo = mid + 1;
+        else                                    hi = mid;
+    }
+    if (lo < g_drawer_count && g_drawer_spans[lo].open_pos == pos)
+        return &g_drawer_spans[lo];
     return NULL;
 }
 
@@ -354,17 +359,22 @@ void comment_map_build(const char *source) {
     int len = (int)strlen(source);
     int i   = 0;
     while (i < len - 1) {
+        /* Only ';', '"', '-' and the lead byte of the box-drawing comment
+         * markers can start anything this pass cares about. */
+        i += (int)scan_to_any(source + i, ";\"-\xE2");
+        if (i >= len - 1) break;
         /* Skip line comments so we do not find -| inside them. */
         if (line_comment_marker_len_at(source + i) > 0) {
-            while (i < len && source[i] != '\n') i++;
+            i += (int)scan_to_any(source + i, "\n");
             continue;
         }
         /* Skip string literals */
         if (source[i] == '"') {
             i++;
-            while (i < len && source[i] != '"') {
-                if (source[i] == '\\') i++;
-                i++;
+            while (i < len) {
+                i += (int)scan_to_any(source + i, "\"\\");
+                if (i >= len || source[i] == '"') break;
+                i += 2; /* backslash and the byte it escapes */
             }
             if (i < len) i++; /* skip closing " */
             continue;
@@ -380,6 +390,8 @@ void comment_map_build(const char *source) {
              * processes it next.                                             */
             int close_pos = -1;
             while (i < len - 1) {
+                i += (int)scan_to_any(source + i, "|-");
+                if (i >= len - 1) break;
                 if (source[i] == '|' && source[i+1] == '-') {
                     close_pos = i;
                     i += 2;
@@ -403,6 +415,8 @@ void comment_map_build(const char *source) {
                 int para_end = len; /* default: to EOF */
                 int j = open_pos + 2;
                 while (j < len) {
+                    j += (int)scan_to_any(source + j, "\n");
+                    if (j >= len) break;
                     if (source[j] == '\n') {
                         /* Check if next line is blank (empty or whitespace only) */
                         int k = j + 1;
@@ -427,9 +441,14 @@ void comment_map_build(const char *source) {
 /* Look up position in comment map — returns the CommentSpan if pos
  * is at an open_pos, NULL otherwise. */
 static CommentSpan *comment_map_lookup(int pos) {
-    for (int i = 0; i < g_comment_count; i++)
-        if (g_comment_spans[i].open_pos == pos)
-            return &g_comment_spans[i];
+    int lo = 0, hi = g_comment_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (g_comment_spans[mid].open_pos < pos) lo = mid + 1;
+        else                                     hi = mid;
+    }
+    if (lo < g_comment_count && g_comment_spans[lo].open_pos == pos)
+        return &g_comment_spans[lo];
     return NULL;
 }
 
@@ -446,7 +465,7 @@ void parser_set_original_source(const char *orig_source) {
         comment_map_build(orig_source);
 }
 
-void parser_set_context(const char *filename, const char *source) {
+static void parser_reset_context(const char *filename, const char *source) {
     current_filename   = filename;
     current_source     = source;
     original_source    = NULL;
@@ -458,12 +477,28 @@ void parser_set_context(const char *filename, const char *source) {
             free(g_local_funcs[i].name);
         g_local_func_count = 0;
     }
+}
+
+void parser_set_context(const char *filename, const char *source) {
+    parser_reset_context(filename, source);
     if (source) {
         comment_map_build(source);
         drawer_map_build(source);
     }
 }
 
+void parser_set_lowered_context(const char *filename, const char *source,
+                                const char *orig_source) {
+    parser_reset_context(filename, source);
+    original_source = orig_source;
+    if (source)
+        drawer_map_build(source);
+    if (orig_source)
+        comment_map_build(orig_source);
+    else if (source)
+        comment_map_build(source);
+}
+
 const char *parser_get_filename(void) {
     return current_filename ? current_filename : "<input>";
 }
@@ -580,10 +615,38 @@ static char *expand_ptr_type(const char *s) {
     return my_strdup(buf);
 }
 
+/// AST node pool
+//
+//  Parsing a module allocates tens of thousands of same-sized nodes and
+//  ast_free hands most of them back during desugaring, so they are carved
+//  from one ArenaPool: allocation is a free-list pop or a bump, release is
+//  a push, and the nodes of a tree sit next to each other in memory.  The
+//  compiler is single-threaded up to codegen; the emit and REPL workers
+//  never touch ASTs.
+
+#define AST_POOL_BLOCK (256u * 1024u)
+
+static ArenaPool g_ast_pool;
+static bool      g_ast_pool_ready;
+
+AST *ast_node_alloc(void) {
+    if (!g_ast_pool_ready) {
+        arena_pool_init(&g_ast_pool, sizeof(AST), AST_POOL_BLOCK);
+        g_ast_pool_ready = true;
+    }
+    AST *a = arena_pool_alloc(&g_ast_pool);
+    memset(a, 0, sizeof(AST));
+    return a;
+}
+
+void ast_node_release(AST *node) {
+    if (node) arena_pool_release(&g_ast_pool, node);
+}
+
 /// AST constructors
 
 AST *ast_new_number(double value, const char *literal) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type        = AST_NUMBER;
     a->number      = value;
     a->literal_str = literal ? my_strdup(literal) : NULL;
@@ -591,7 +654,7 @@ AST *ast_new_number(double value, const char *literal) {
 }
 
 AST *ast_new_symbol(const char *name) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type   = AST_SYMBOL;
     /* ++ is surface syntax for the core-owned Semigroup.append method.
      * Canonicalize before inference/codegen so the compiler does not acquire
@@ -602,21 +665,21 @@ AST *ast_new_symbol(const char *name) {
 }
 
 AST *ast_new_string(const char *value) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type   = AST_STRING;
     a->string = my_strdup(value);
     return a;
 }
 
 AST *ast_new_char(char value) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type      = AST_CHAR;
     a->character = value;
     return a;
 }
 
 AST *ast_new_list(void) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type           = AST_LIST;
     a->list.capacity  = 4;
     a->list.items     = malloc(sizeof(AST *) * 4);
@@ -631,7 +694,7 @@ AST *ast_new_lambda(ASTParam *params, int param_count,
                     AST *body,
                     AST **body_exprs,
                     int body_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                = AST_LAMBDA;
     a->lambda.params       = params;
     a->lambda.param_count  = param_count;
@@ -646,7 +709,7 @@ AST *ast_new_lambda(ASTParam *params, int param_count,
 }
 
 AST *ast_new_asm(AST **instructions, size_t instruction_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_ASM;
     a->asm_block.instructions = instructions;
     a->asm_block.instruction_count = instruction_count;
@@ -654,21 +717,21 @@ AST *ast_new_asm(AST **instructions, size_t instruction_count) {
 }
 
 AST *ast_new_keyword(const char *name) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_KEYWORD;
     a->keyword = my_strdup(name);
     return a;
 }
 
 AST *ast_new_path(const char *value) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type   = AST_PATH;
     a->string = my_strdup(value); // reuse string field — same semantics
     return a;
 }
 
 AST *ast_new_ratio(long long numerator, long long denominator) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_RATIO;
     a->ratio.numerator = numerator;
     a->ratio.denominator = denominator;
@@ -676,7 +739,7 @@ AST *ast_new_ratio(long long numerator, long long denominator) {
 }
 
 AST *ast_new_array(void) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_ARRAY;
     a->array.element_capacity = 4;
     a->array.elements = malloc(sizeof(AST *) * 4);
@@ -687,7 +750,7 @@ AST *ast_new_array(void) {
 AST *ast_new_refinement(const char *name, const char *var,
                         const char *base_type, AST *predicate,
                         const char *docstring, const char *alias_name) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                    = AST_REFINEMENT;
     a->refinement.name         = name      ? my_strdup(name)      : NULL;
     a->refinement.var          = var       ? my_strdup(var)        : NULL;
@@ -699,7 +762,7 @@ AST *ast_new_refinement(const char *name, const char *var,
 }
 
 AST *ast_new_address_of(AST *operand) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_ADDRESS_OF;
     a->list.items = malloc(sizeof(AST*) * 1);
     a->list.items[0] = operand;
@@ -709,7 +772,7 @@ AST *ast_new_address_of(AST *operand) {
 }
 
 AST *ast_new_range(AST *start, AST *step, AST *end, bool is_array) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type        = AST_RANGE;
     a->range.start = start;
     a->range.step  = step;
@@ -721,7 +784,7 @@ AST *ast_new_range(AST *start, AST *step, AST *end, bool is_array) {
 AST *ast_new_layout(const char *name,
                     ASTLayoutField *fields, int field_count,
                     bool packed, int align) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                = AST_LAYOUT;
     a->layout.name         = my_strdup(name);
     a->layout.fields       = fields;
@@ -732,7 +795,7 @@ AST *ast_new_layout(const char *name,
 }
 
 AST *ast_new_set(void) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type              = AST_SET;
     a->set.element_capacity = 4;
     a->set.elements      = malloc(sizeof(AST*) * 4);
@@ -741,7 +804,7 @@ AST *ast_new_set(void) {
 }
 
 AST *ast_new_type_set(const char *name, AST **members, size_t member_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type = AST_TYPE_SET;
     a->type_set.name = my_strdup(name);
     a->type_set.members = members;
@@ -750,7 +813,7 @@ AST *ast_new_type_set(const char *name, AST **members, size_t member_count) {
 }
 
 AST *ast_new_map(void) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type         = AST_MAP;
     a->map.capacity = 4;
     a->map.keys     = malloc(sizeof(AST*) * 4);
@@ -809,7 +872,7 @@ AST *ast_new_data(const char *name,
                   char **type_params, int type_param_count,
                   ASTDataConstructor *constructors, int constructor_count,
                   char **deriving, int deriving_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                     = AST_DATA;
     a->data.name                = my_strdup(name);
     a->data.type_params         = type_params;
@@ -829,7 +892,7 @@ AST *ast_new_class(const char *name, const char *type_var,
                    char **default_names, AST **default_bodies, int default_count,
                    char **law_names, char **law_types, AST **law_bodies,
                    int law_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                          = AST_CLASS;
     a->class_decl.name               = my_strdup(name);
     a->class_decl.type_var           = my_strdup(type_var);
@@ -854,7 +917,7 @@ AST *ast_new_class(const char *name, const char *type_var,
 AST *ast_new_instance(const char *class_name, const char *type_name,
                       char **assoc_names, char **assoc_values, int assoc_count,
                       char **method_names, AST **method_bodies, int method_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                            = AST_INSTANCE;
     a->instance_decl.class_name        = my_strdup(class_name);
     a->instance_decl.type_name         = my_strdup(type_name);
@@ -868,7 +931,7 @@ AST *ast_new_instance(const char *class_name, const char *type_name,
 }
 
 AST *ast_new_pmatch(ASTPMatchClause *clauses, int clause_count) {
-    AST *a = calloc(1, sizeof(AST));
+    AST *a = ast_node_alloc();
     a->type                = AST_PMATCH;
     a->pmatch.clauses      = clauses;
     a->pmatch.clause_count = clause_count;
@@ -895,7 +958,7 @@ void ast_list_append(AST *list, AST *item) {
 
 AST *ast_clone(AST *ast) {
     if (!ast) return NULL;
-    AST *c = calloc(1, sizeof(AST));
+    AST *c = ast_node_alloc();
     *c = *ast;  /* shallow copy all fields */
     c->literal_str = NULL;
     if ((ast->type == AST_NUMBER || ast->type == AST_SYMBOL) &&
@@ -932,6 +995,7 @@ AST *ast_clone(AST *ast) {
             c->lambda.params[i].type_name = ast->lambda.params[i].type_name
                                           ? strdup(ast->lambda.params[i].type_name) : NULL;
             c->lambda.params[i].is_rest   = ast->lambda.params[i].is_rest;
+            c->lambda.params[i].is_anon   = ast->lambda.params[i].is_anon;
         }
         c->lambda.return_type = ast->lambda.return_type ? strdup(ast->lambda.return_type) : NULL;
         c->lambda.docstring   = ast->lambda.docstring   ? strdup(ast->lambda.docstring)   : NULL;
@@ -1345,7 +1409,7 @@ void ast_free(AST *ast) {
     }
     if (ast->type == AST_NUMBER || ast->type == AST_SYMBOL)
         free(ast->literal_str);
-    free(ast);
+    ast_node_release(ast);
 }
 
 
@@ -1680,15 +1744,22 @@ static char advance(Lexer *lex) {
     return c;
 }
 
+/* Consume `n` bytes known to contain no newline. */
+static void advance_run(Lexer *lex, size_t n) {
+    lex->pos    += n;
+    lex->column += (int)n;
+}
+
 static void skip_whitespace(Lexer *lex) {
-    while (peek(lex) == ' '  || peek(lex) == '\t' ||
-           peek(lex) == '\n' || peek(lex) == '\r')
+    for (;;) {
+        advance_run(lex, scan_blank(lex->source + lex->pos));
+        if (peek(lex) != '\n') break;
         advance(lex);
+    }
 }
 
 static void skip_line_comment(Lexer *lex) {
-    while (peek(lex) != '\n' && peek(lex) != '\0')
-        advance(lex);
+    advance_run(lex, scan_to_any(lex->source + lex->pos, "\n"));
 }
 
 static bool is_digit(char c)     { return c >= '0' && c <= '9'; }
@@ -2049,8 +2120,11 @@ Token lexer_next_token(Lexer *lex) {
         int string_column = lex->column;
         advance(lex);
         size_t start = lex->pos;
-        while (peek(lex) != '"' && peek(lex) != '\0') {
-            if (peek(lex) == '\\') advance(lex);
+        for (;;) {
+            advance_run(lex, scan_to_any(lex->source + lex->pos, "\"\\\n"));
+            char sc = peek(lex);
+            if (sc == '"' || sc == '\0') break;
+            if (sc == '\\' && peek_ahead(lex, 1) != '\0') advance(lex);
             advance(lex);
         }
         if (peek(lex) == '\0') {
@@ -2528,6 +2602,12 @@ Token lexer_next_token(Lexer *lex) {
            when it is followed by a letter/digit (module-access dot), not
            when it might be trailing punctuation. */
         while (true) {
+            size_t word = scan_word(lex->source + lex->pos);
+            if (word) {
+                advance_run(lex, word);
+                continue;
+            }
+
             char nc = peek(lex);
             if (nc == '\0') break;
 
@@ -3820,7 +3900,7 @@ static AST *parse_lambda(Parser *p) {
             free(cl->patterns);
         }
         free(pm->pmatch.clauses);
-        free(pm);
+        ast_node_release(pm);
         body_exprs    = malloc(sizeof(AST*));
         body_exprs[0] = desugared;
         body_count    = 1;
@@ -4715,7 +4795,7 @@ static AST *parse_list(Parser *p) {
             free(cl->patterns);
         }
         free(pm->pmatch.clauses);
-        free(pm);
+        ast_node_release(pm);
 
         AST **body_exprs = malloc(sizeof(AST*));
         body_exprs[0] = desugared;
@@ -5182,7 +5262,7 @@ static AST *parse_list(Parser *p) {
                         free(cl->patterns);
                     }
                     free(pm->pmatch.clauses);
-                    free(pm);
+                    ast_node_release(pm);
                     body_cap = 1;
                     body_exprs = malloc(sizeof(AST*) * body_cap);
                     body_exprs[0] = desugared;
@@ -6745,7 +6825,7 @@ static AST *parse_list(Parser *p) {
             /* Do NOT ast_free(pm) — pmatch_desugar takes ownership of
              * clause bodies. Just free the container without freeing
              * the clauses themselves.                                  */
-            free(pm); /* free only the AST node, not via ast_free */
+            ast_node_release(pm); /* free only the AST node, not via ast_free */
 
             /* pmatch_desugar forcefully sets untyped params to "Coll".
              * We must clear this so tc_register_instance can inject the
@@ -7892,7 +7972,7 @@ static AST *parse_list(Parser *p) {
                 free(cl->patterns);
             }
             free(pm->pmatch.clauses);
-            free(pm);
+            ast_node_release(pm);
         } else {
             body_expr = parse_expr(p);
         }
@@ -8161,7 +8241,7 @@ static AST *parse_list(Parser *p) {
         strcmp(p->current.value, "tests") == 0) {
         p->current = lexer_next_token(p->lexer);
 
-        AST *node = calloc(1, sizeof(AST));
+        AST *node = ast_node_alloc();
         node->type = AST_TESTS;
         node->tests.assertions = NULL;
         node->tests.count = 0;
@@ -8523,7 +8603,7 @@ static AST *parse_list(Parser *p) {
                         p->current  = lexer_next_token(p->lexer);
                         /* list was never appended to — safe to free the empty shell */
                         free(list->list.items);
-                        free(list);
+                        ast_node_release(list);
                         acc->line       = start_line;
                         acc->column     = start_column;
                         acc->end_column = end_col;
@@ -8541,7 +8621,7 @@ static AST *parse_list(Parser *p) {
                 int end_col = p->current.column + 1;
                 p->current = lexer_next_token(p->lexer);
                 free(list->list.items);
-                free(list);
+                ast_node_release(list);
                 first->line = start_line;
                 first->column = start_column;
                 first->end_column = end_col;
@@ -8658,7 +8738,7 @@ static AST *parse_list(Parser *p) {
                     free(positional);
                     /* free the old list shell (items already stolen/freed) */
                     free(list->list.items);
-                    free(list);
+                    ast_node_release(list);
                     list = reordered;
                 }
             }
@@ -8674,7 +8754,7 @@ static AST *parse_list(Parser *p) {
 
             AST *inner = list->list.items[0];
             free(list->list.items);
-            free(list);
+            ast_node_release(list);
 
             inner->line = start_line;
             inner->column = start_column;
@@ -8764,7 +8844,7 @@ static AST *parse_bracket_list(Parser *p) {
             result->column     = start_column;
             result->end_column = end_col;
             free(list->list.items);
-            free(list);
+            ast_node_release(list);
             return result;
         }
     }
@@ -8876,7 +8956,7 @@ static AST *parse_bracket_list(Parser *p) {
 
         ast_free(list->list.items[pipe_index]);
         free(list->list.items);
-        free(list);
+        ast_node_release(list);
         result->line = start_line;
         result->column = start_column;
         result->end_column = end_column;
@@ -8887,7 +8967,7 @@ static AST *parse_bracket_list(Parser *p) {
     for (size_t i = 0; i < list->list.count; i++)
         ast_array_append(array, list->list.items[i]);
     free(list->list.items);
-    free(list);
+    ast_node_release(list);
     array->line = start_line;
     array->column = start_column;
     array->end_column = end_column;
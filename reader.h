@@ -15,6 +15,10 @@ extern const char *current_source;
 extern const char *original_source;
 
 void parser_set_original_source(const char *orig_source);
+// parser_set_context + parser_set_original_source in one step, without
+// first building the comment map for `source` only to replace it.
+void parser_set_lowered_context(const char *filename, const char *source,
+                                const char *orig_source);
 
 /* Replace all exit(1) calls in the reader/parser.
  * If a recovery point is set (we're inside repl_eval_line), longjmp back.
@@ -387,6 +391,15 @@ AST *ast_new_instance(const char *class_name, const char *type_name,
 void ast_pattern_free(ASTPattern *p);
 
 
+// AST nodes come from a process-wide ArenaPool, not malloc: a raw node is
+// zeroed by ast_node_alloc and its shell (children already moved or freed)
+// goes back with ast_node_release.  Never free() a node.  ast_free releases
+// the whole tree.  Nodes recycle through the pool's free list; the backing
+// blocks live until exit because macros, interfaces and Env source_ast
+// snapshots keep trees alive across compilation units.
+AST *ast_node_alloc(void);
+void ast_node_release(AST *node);
+
 void ast_list_append(AST *list, AST *item);
 void ast_array_append(AST *array, AST *item);
 AST *ast_clone(AST *ast);
@@ -25,6 +25,7 @@
 #include "ffi.h"
 #include "features.h"
 #include "wisp.h"
+#include "bytecode_lower.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,12 +33,14 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <setjmp.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #if !defined(_WIN32)
 #include <dlfcn.h>
+#include <pthread.h>
 #else
 /* winnt.h declares an enum member named TokenType, which collides with the
  * compiler's TokenType typedef.  Keep the Windows SDK name out of this TU. */
@@ -72,8 +75,11 @@ static const char *dlerror(void) {
 #include <llvm-c/Error.h>
 #include <llvm-c/LLJIT.h>
 #include <llvm-c/Orc.h>
+#include <llvm-c/Object.h>
 #include <llvm-c/Target.h>
 #include <llvm-c/Analysis.h>
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
 #include <llvm-c/TargetMachine.h>
 #include <llvm-c/Support.h>
 #include <llvm-c/Transforms/PassBuilder.h>
@@ -310,7 +316,7 @@ static void rt_sym_table_init(void) {
     ADD(rt_thunk_create); ADD(rt_force);             ADD(rt_list_range);
     ADD(rt_list_from);    ADD(rt_list_from_step);    ADD(rt_list_take);
     ADD(rt_list_drop);    ADD(rt_value_thunk);
-    ADD(rt_string_take);
+    ADD(rt_string_take);  ADD(rt_string_concat);
 
     // Map
     ADD(rt_map_new);      ADD(rt_map_assoc);      ADD(rt_map_assoc_mut);
@@ -328,6 +334,8 @@ static void rt_sym_table_init(void) {
 
     ADD(rt_set_foldl);   ADD(rt_set_map);      ADD(rt_set_filter);
     ADD(rt_closure_calln); ADD(rt_value_closure);
+    ADD(rt_value_closure_direct); ADD(rt_value_closure_init);
+    ADD(rt_closure_call1); ADD(rt_closure_call2); ADD(rt_closure_call3);
 
 
     ADD(__layout_ptr_set);
@@ -355,6 +363,9 @@ static void rt_sym_table_init(void) {
     ADD(rt_value_ratio);
     ADD(rt_ratio_add); ADD(rt_ratio_sub); ADD(rt_ratio_mul); ADD(rt_ratio_div);
     ADD(rt_ratio_to_int); ADD(rt_ratio_to_float);
+    ADD(rt_bignum_add); ADD(rt_bignum_sub); ADD(rt_bignum_mul); ADD(rt_bignum_div);
+    ADD(rt_bignum_acc_new); ADD(rt_bignum_acc_add); ADD(rt_bignum_acc_mul);
+    ADD(rt_bignum_acc_finish);
     /* C stdlib used by codegen */
     ADD(printf); ADD(sprintf); ADD(fprintf);
     ADD(strlen);  ADD(strcmp);  ADD(strdup);
@@ -374,7 +385,8 @@ static bool repl_orc_define_host_symbols(REPLContext *ctx) {
     return true;
 }
 
-static LLVMTargetMachineRef repl_orc_create_target_machine(LLVMCodeGenOptLevel level) {
+static LLVMTargetMachineRef repl_orc_create_target_machine(LLVMCodeGenOptLevel level,
+                                                           LLVMCodeModel code_model) {
     char *triple = LLVMGetDefaultTargetTriple();
     if (!triple) return NULL;
 
@@ -393,7 +405,7 @@ static LLVMTargetMachineRef repl_orc_create_target_machine(LLVMCodeGenOptLevel l
         target, triple,
         cpu ? cpu : "generic",
         features ? features : "",
-        level, LLVMRelocDefault, LLVMCodeModelDefault);
+        level, LLVMRelocDefault, code_model);
 
     if (features) LLVMDisposeMessage(features);
     if (cpu) LLVMDisposeMessage(cpu);
@@ -432,12 +444,13 @@ static void repl_orc_configure_module(REPLContext *ctx, LLVMModuleRef mod,
 }
 
 static bool repl_orc_run_pass_pipeline(LLVMModuleRef mod,
-                                       LLVMTargetMachineRef tm) {
+                                       LLVMTargetMachineRef tm,
+                                       const char *pipeline) {
     LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
     if (!opts) return true;
 
     LLVMPassBuilderOptionsSetVerifyEach(opts, 1);
-    LLVMErrorRef err = LLVMRunPasses(mod, "default<O0>", tm, opts);
+    LLVMErrorRef err = LLVMRunPasses(mod, pipeline, tm, opts);
     LLVMDisposePassBuilderOptions(opts);
     if (err) {
         repl_report_llvm_error("REPL: ORC pass pipeline failed", err);
@@ -620,151 +633,171 @@ static bool repl_name_needs_unicode_mangle(const char *name) {
     return false;
 }
 
-static void redeclare_env_symbols(REPLContext *ctx) {
-    Env *env = ctx->cg.env;
-    for (size_t bi = 0; bi < env->size; bi++) {
-        for (EnvEntry *e = env->buckets[bi]; e; e = e->next) {
-            if (e->kind == ENV_VAR) {
+/* Declare one env global/func from a previous module in the current one.
+ * ORC resolves the declaration from the persistent main JITDylib. */
+static void redeclare_env_entry(REPLContext *ctx, EnvEntry *e) {
+    if (e->kind == ENV_VAR) {
 
-                const char *name = (e->llvm_name && e->llvm_name[0])
-                                   ? e->llvm_name : e->name;
+        const char *name = (e->llvm_name && e->llvm_name[0])
+                           ? e->llvm_name : e->name;
 
-                LLVMValueRef existing = LLVMGetNamedGlobal(ctx->cg.module, name);
-                if (existing) {
-                    e->value = existing;
-                    continue;
-                }
+        LLVMValueRef existing = LLVMGetNamedGlobal(ctx->cg.module, name);
+        if (existing) {
+            e->value = existing;
+            return;
+        }
 
-                // Layout variables are stored as i8* globals (holding heap ptr)
-                LLVMTypeRef lt;
-                if (e->type && e->type->kind == TYPE_LAYOUT) {
-                    lt = LLVMPointerType(LLVMInt8TypeInContext(ctx->cg.context), 0);
-                } else {
-                    lt = type_to_llvm(&ctx->cg, e->type);
-                }
-                LLVMValueRef gv = LLVMAddGlobal(ctx->cg.module, lt, name);
-                LLVMSetLinkage(gv, LLVMExternalLinkage);
-                e->value = gv;
-
-                char getter_name[512];
-                monad_repl_global_getter_name(name, getter_name, sizeof(getter_name));
-                if (!LLVMGetNamedFunction(ctx->cg.module, getter_name)) {
-                    LLVMTypeRef ft = LLVMFunctionType(lt, NULL, 0, 0);
-                    LLVMValueRef getter = LLVMAddFunction(ctx->cg.module, getter_name, ft);
-                    LLVMSetLinkage(getter, LLVMExternalLinkage);
-                }
+        // Layout variables are stored as i8* globals (holding heap ptr)
+        LLVMTypeRef lt;
+        if (e->type && e->type->kind == TYPE_LAYOUT) {
+            lt = LLVMPointerType(LLVMInt8TypeInContext(ctx->cg.context), 0);
+        } else {
+            lt = type_to_llvm(&ctx->cg, e->type);
+        }
+        LLVMValueRef gv = LLVMAddGlobal(ctx->cg.module, lt, name);
+        LLVMSetLinkage(gv, LLVMExternalLinkage);
+        e->value = gv;
+
+        char getter_name[512];
+        monad_repl_global_getter_name(name, getter_name, sizeof(getter_name));
+        if (!LLVMGetNamedFunction(ctx->cg.module, getter_name)) {
+            LLVMTypeRef ft = LLVMFunctionType(lt, NULL, 0, 0);
+            LLVMValueRef getter = LLVMAddFunction(ctx->cg.module, getter_name, ft);
+            LLVMSetLinkage(getter, LLVMExternalLinkage);
+        }
+    }
+    else if (e->kind == ENV_FUNC && e->func_ref) {
+        const char *name = (e->llvm_name && e->llvm_name[0])
+                           ? e->llvm_name : e->name;
+
+        /* Only real non-ASCII names need alias mangling here.
+         * ASCII names such as char-upcase are legal LLVM names and
+         * must keep their typed ABI across REPL modules. */
+        char *mangled_name = NULL;
+        if (repl_name_needs_unicode_mangle(name)) {
+            mangled_name = mangle_unicode_name(name);
+            if (mangled_name) {
+                name = mangled_name;
             }
-            else if (e->kind == ENV_FUNC && e->func_ref) {
-                const char *name = (e->llvm_name && e->llvm_name[0])
-                                   ? e->llvm_name : e->name;
-
-                /* Only real non-ASCII names need alias mangling here.
-                 * ASCII names such as char-upcase are legal LLVM names and
-                 * must keep their typed ABI across REPL modules. */
-                char *mangled_name = NULL;
-                if (repl_name_needs_unicode_mangle(name)) {
-                    mangled_name = mangle_unicode_name(name);
-                    if (mangled_name) {
-                        name = mangled_name;
-                    }
-                }
+        }
 
-                LLVMValueRef existing = LLVMGetNamedFunction(ctx->cg.module, name);
-                if (existing) {
-                    /* For FFI functions, do NOT update func_ref — the stored
-                     * func_ref has the correct type (i32 for Color etc.).
-                     * Just use the existing declaration as-is.            */
-                    if (!e->is_ffi)
-                        e->func_ref = existing;
-                    if (mangled_name) free(mangled_name);
-                    continue;
-                }
+        LLVMValueRef existing = LLVMGetNamedFunction(ctx->cg.module, name);
+        if (existing) {
+            /* For FFI functions, do NOT update func_ref — the stored
+             * func_ref has the correct type (i32 for Color etc.).
+             * Just use the existing declaration as-is.            */
+            if (!e->is_ffi)
+                e->func_ref = existing;
+            if (mangled_name) free(mangled_name);
+            return;
+        }
 
-                LLVMTypeRef ft;
-                if (e->is_closure_abi) {
-                    /* Closure ABI: always (ptr env, i32 n, ptr args) -> ptr */
-                    LLVMTypeRef ptr_t = LLVMPointerType(
-                        LLVMInt8TypeInContext(ctx->cg.context), 0);
-                    LLVMTypeRef i32_t = LLVMInt32TypeInContext(ctx->cg.context);
-                    LLVMTypeRef params[] = {ptr_t, i32_t, ptr_t};
-                    ft = LLVMFunctionType(ptr_t, params, 3, 0);
-                } else {
-                    if (e->is_ffi) {
-                        /* For FFI functions, rebuild the type using the
-                         * same ABI rules as ffi_inject_into_env — layout
-                         * params become packed integers, not pointers.  */
-                        LLVMTypeRef *pt = e->param_count > 0
-                            ? malloc(sizeof(LLVMTypeRef) * e->param_count) : NULL;
-                        for (int i = 0; i < e->param_count; i++) {
-                            Type *ptype = e->params[i].type;
-                            if (!ptype) {
-                                pt[i] = LLVMPointerType(
-                                    LLVMInt8TypeInContext(ctx->cg.context), 0);
-                            } else if (ptype->kind == TYPE_I32 ||
-                                       ptype->kind == TYPE_U32) {
-                                pt[i] = LLVMInt32TypeInContext(ctx->cg.context);
-                            } else if (ptype->kind == TYPE_LAYOUT) {
-                                Type *full = env_lookup_layout(ctx->cg.env,
-                                                 ptype->layout_name);
-                                int sz = full ? full->layout_total_size : 0;
-                                if      (sz > 0 && sz <= 4)
-                                    pt[i] = LLVMInt32TypeInContext(ctx->cg.context);
-                                else if (sz > 4 && sz <= 8)
-                                    pt[i] = LLVMInt64TypeInContext(ctx->cg.context);
-                                else
-                                    pt[i] = LLVMPointerType(
-                                        LLVMInt8TypeInContext(ctx->cg.context), 0);
-                            } else {
-                                pt[i] = type_to_llvm(&ctx->cg, ptype);
-                            }
-                        }
-                        LLVMTypeRef ret_t = e->return_type
-                            ? type_to_llvm(&ctx->cg, e->return_type)
-                            : LLVMVoidTypeInContext(ctx->cg.context);
-                        ft = LLVMFunctionType(ret_t, pt, e->param_count, 0);
-                        if (pt) free(pt);
+        LLVMTypeRef ft;
+        if (e->is_closure_abi) {
+            /* Closure ABI: always (ptr env, i32 n, ptr args) -> ptr */
+            LLVMTypeRef ptr_t = LLVMPointerType(
+                LLVMInt8TypeInContext(ctx->cg.context), 0);
+            LLVMTypeRef i32_t = LLVMInt32TypeInContext(ctx->cg.context);
+            LLVMTypeRef params[] = {ptr_t, i32_t, ptr_t};
+            ft = LLVMFunctionType(ptr_t, params, 3, 0);
+        } else {
+            if (e->is_ffi) {
+                /* For FFI functions, rebuild the type using the
+                 * same ABI rules as ffi_inject_into_env — layout
+                 * params become packed integers, not pointers.  */
+                LLVMTypeRef *pt = e->param_count > 0
+                    ? malloc(sizeof(LLVMTypeRef) * e->param_count) : NULL;
+                for (int i = 0; i < e->param_count; i++) {
+                    Type *ptype = e->params[i].type;
+                    if (!ptype) {
+                        pt[i] = LLVMPointerType(
+                            LLVMInt8TypeInContext(ctx->cg.context), 0);
+                    } else if (ptype->kind == TYPE_I32 ||
+                               ptype->kind == TYPE_U32) {
+                        pt[i] = LLVMInt32TypeInContext(ctx->cg.context);
+                    } else if (ptype->kind == TYPE_LAYOUT) {
+                        Type *full = env_lookup_layout(ctx->cg.env,
+                                         ptype->layout_name);
+                        int sz = full ? full->layout_total_size : 0;
+                        if      (sz > 0 && sz <= 4)
+                            pt[i] = LLVMInt32TypeInContext(ctx->cg.context);
+                        else if (sz > 4 && sz <= 8)
+                            pt[i] = LLVMInt64TypeInContext(ctx->cg.context);
+                        else
+                            pt[i] = LLVMPointerType(
+                                LLVMInt8TypeInContext(ctx->cg.context), 0);
                     } else {
-                        LLVMTypeRef *pt = e->param_count > 0
-                            ? malloc(sizeof(LLVMTypeRef) * e->param_count)
-                            : NULL;
-
-                        for (int i = 0; i < e->param_count; i++) {
-                            Type *ptype = e->params[i].type;
-                            pt[i] = ptype
-                                ? type_to_llvm(&ctx->cg, ptype)
-                                : LLVMPointerType(LLVMInt8TypeInContext(ctx->cg.context), 0);
-                        }
-
-                        LLVMTypeRef ret_t = e->return_type
-                            ? type_to_llvm(&ctx->cg, e->return_type)
-                            : LLVMVoidTypeInContext(ctx->cg.context);
-
-                        ft = LLVMFunctionType(ret_t, pt, e->param_count, 0);
-
-                        if (pt) free(pt);
+                        pt[i] = type_to_llvm(&ctx->cg, ptype);
                     }
                 }
+                LLVMTypeRef ret_t = e->return_type
+                    ? type_to_llvm(&ctx->cg, e->return_type)
+                    : LLVMVoidTypeInContext(ctx->cg.context);
+                ft = LLVMFunctionType(ret_t, pt, e->param_count, 0);
+                if (pt) free(pt);
+            } else {
+                LLVMTypeRef *pt = e->param_count > 0
+                    ? malloc(sizeof(LLVMTypeRef) * e->param_count)
+                    : NULL;
+
+                for (int i = 0; i < e->param_count; i++) {
+                    Type *ptype = e->params[i].type;
+                    pt[i] = ptype
+                        ? type_to_llvm(&ctx->cg, ptype)
+                        : LLVMPointerType(LLVMInt8TypeInContext(ctx->cg.context), 0);
+                }
+
+                LLVMTypeRef ret_t = e->return_type
+                    ? type_to_llvm(&ctx->cg, e->return_type)
+                    : LLVMVoidTypeInContext(ctx->cg.context);
+
+                ft = LLVMFunctionType(ret_t, pt, e->param_count, 0);
 
-                LLVMValueRef fn = LLVMAddFunction(ctx->cg.module, name, ft);
-                LLVMSetLinkage(fn, LLVMExternalLinkage);
-                /* For FFI functions, do NOT update func_ref — keep the
-                 * original declaration with correct ABI types (i32 etc.) */
-                if (!e->is_ffi)
-                    e->func_ref = fn;
-                if (mangled_name) free(mangled_name);
+                if (pt) free(pt);
             }
         }
+
+        LLVMValueRef fn = LLVMAddFunction(ctx->cg.module, name, ft);
+        LLVMSetLinkage(fn, LLVMExternalLinkage);
+        /* For FFI functions, do NOT update func_ref — keep the
+         * original declaration with correct ABI types (i32 etc.) */
+        if (!e->is_ffi)
+            e->func_ref = fn;
+        if (mangled_name) free(mangled_name);
     }
+}
 
+/* Module generation: bumped by fresh_module, so an entry is declared at
+ * most once per module, on the first lookup that reaches it. */
+static unsigned g_decl_epoch = 1;
+
+/* Env lookup hook.  Declaring every global and function up front made
+ * each expression pay for the size of the whole session; this declares
+ * only what codegen asks for.  MONAD_REPL_EAGER_DECLS=1 restores the
+ * full walk in fresh_module. */
+static void repl_declare_on_lookup(EnvEntry *e, void *userdata) {
+    REPLContext *ctx = userdata;
+    if (e->kind != ENV_VAR && e->kind != ENV_FUNC) return;
+    if (!ctx->cg.module || e->decl_epoch == g_decl_epoch) return;
+    e->decl_epoch = g_decl_epoch;
+    redeclare_env_entry(ctx, e);
+}
+
+static bool repl_eager_decls(void) {
+    const char *value = getenv("MONAD_REPL_EAGER_DECLS");
+    return value && value[0] && strcmp(value, "0") != 0;
+}
+
+static void redeclare_env_symbols(REPLContext *ctx) {
+    Env *env = ctx->cg.env;
+    for (size_t bi = 0; bi < env->size; bi++)
+        if (env->slots[bi])
+            repl_declare_on_lookup(env->slots[bi], ctx);
 }
 
 /// Module lifecycle
 
 static void fresh_module(REPLContext *ctx, const char *mod_name) {
-    if (ctx->cg.builder) {
-        LLVMDisposeBuilder(ctx->cg.builder);
-        ctx->cg.builder = NULL;
-    }
     /* close_and_run clears module after transferring ownership to ORC.
      * A non-NULL module here is an unused pre-created or recovered module,
      * so retaining it would leak an LLVM module on every REPL expression. */
@@ -775,20 +808,20 @@ static void fresh_module(REPLContext *ctx, const char *mod_name) {
 
     ctx->cg.module  = LLVMModuleCreateWithNameInContext(mod_name,
                                                         ctx->cg.context);
-    ctx->cg.builder = LLVMCreateBuilderInContext(ctx->cg.context);
+    /* One builder serves every input; recover_module drops it after an
+     * error. */
+    if (ctx->cg.builder) LLVMClearInsertionPosition(ctx->cg.builder);
+    else ctx->cg.builder = LLVMCreateBuilderInContext(ctx->cg.context);
     repl_orc_configure_module(ctx, ctx->cg.module, NULL);
 
-    /* Reset cached format strings */
-    ctx->cg.fmt_str = ctx->cg.fmt_char = ctx->cg.fmt_int =
-    ctx->cg.fmt_float = ctx->cg.fmt_hex = ctx->cg.fmt_bin =
-    ctx->cg.fmt_oct = NULL;
-
-    /* 1. Declare runtime functions in this module */
+    /* 1. Forget the previous module's runtime declarations and formats;
+     * both are declared in this one on first use. */
     declare_runtime_functions(&ctx->cg);
 
-    /* 2. Re-declare env globals/funcs from previous modules as declarations.
-     * ORC resolves them from the persistent main JITDylib. */
-    redeclare_env_symbols(ctx);
+    /* 2. Env globals/funcs from previous modules are declared lazily, on
+     * the first lookup in this module (repl_declare_on_lookup). */
+    g_decl_epoch++;
+    if (repl_eager_decls()) redeclare_env_symbols(ctx);
 }
 
 static void repl_define_value_getter(REPLContext *ctx, EnvEntry *e) {
@@ -1682,6 +1715,692 @@ static void emit_proc_print(REPLContext *ctx, EnvEntry *e) {
     LLVMBuildCall2(ctx->cg.builder, LLVMGlobalGetValueType(pf), pf, a, 2, "");
 }
 
+/// Lazy function bodies
+//
+// A module that defines functions reaches ORC in two parts.  The bodies
+// move to an impl module under "<name>.impl"; the module itself keeps
+// declarations, and a lazy reexport defines each name as a call-through
+// stub.  Running the wrapper then compiles only the wrapper, and a body
+// compiles the first time something calls it -- a session that loads big
+// modules stops paying for code it never runs.  MONAD_REPL_LAZY=0 adds
+// modules whole, as before.
+
+#define REPL_IMPL_SUFFIX ".impl"
+
+static void repl_lazy_compile_failed(void) {
+    fprintf(stderr, "Error: REPL function failed to compile on first call\n");
+    if (g_in_eval) {
+        g_in_eval = false;
+        repl_longjmp(g_repl_escape, 98);
+    }
+    abort();
+}
+
+static void repl_lazy_init(REPLContext *ctx) {
+    ctx->lctm = NULL;
+    ctx->ism  = NULL;
+    const char *lazy = getenv("MONAD_REPL_LAZY");
+    if (lazy && strcmp(lazy, "0") == 0) return;
+
+    /* The call-through manager fails cleanly on targets ORC has no
+     * trampolines for; the stubs manager would not. */
+    const char *triple = LLVMOrcLLJITGetTripleString(ctx->jit);
+    LLVMErrorRef err = LLVMOrcCreateLocalLazyCallThroughManager(
+        triple, LLVMOrcLLJITGetExecutionSession(ctx->jit),
+        (LLVMOrcJITTargetAddress)(uintptr_t)repl_lazy_compile_failed,
+        &ctx->lctm);
+    if (err) {
+        LLVMConsumeError(err);
+        ctx->lctm = NULL;
+        return;
+    }
+    ctx->ism = LLVMOrcCreateLocalIndirectStubsManager(triple);
+}
+
+/* Replace a definition with a declaration of the same name and type. */
+static void repl_definition_to_decl(LLVMModuleRef mod, LLVMValueRef def) {
+    size_t len = 0;
+    const char *cname = LLVMGetValueName2(def, &len);
+    char *name = malloc(len + 1);
+    memcpy(name, cname, len);
+    name[len] = '\0';
+
+    LLVMValueRef decl;
+    if (LLVMIsAFunction(def)) {
+        decl = LLVMAddFunction(mod, "", LLVMGlobalGetValueType(def));
+        LLVMSetFunctionCallConv(decl, LLVMGetFunctionCallConv(def));
+    } else {
+        decl = LLVMAddGlobal(mod, LLVMGlobalGetValueType(def), "");
+        LLVMSetThreadLocal(decl, LLVMIsThreadLocal(def));
+    }
+    LLVMSetLinkage(decl, LLVMExternalLinkage);
+    LLVMReplaceAllUsesWith(def, decl);
+    if (LLVMIsAFunction(def)) LLVMDeleteFunction(def);
+    else                      LLVMDeleteGlobal(def);
+    LLVMSetValueName2(decl, name, len);
+    free(name);
+}
+
+static bool repl_linkage_is_local(LLVMValueRef v) {
+    LLVMLinkage linkage = LLVMGetLinkage(v);
+    return linkage == LLVMPrivateLinkage || linkage == LLVMInternalLinkage;
+}
+
+/// Background O2
+//
+// Lazy bodies compile at O0, which keeps a prompt responsive but leaves
+// hot loops slow.  With the pool running, a lazily defined `f` is a small
+// trampoline in the defining module that calls through "f.slot" -- a host
+// cell, defined as an absolute symbol like the host globals -- and the
+// lazy stub is named "f.lazy" instead.  The cell starts at the stub.  A
+// worker re-reads the impl module from bitcode in a context of its own,
+// runs default<O2> and emits an object with its own target machine;
+// nothing on the worker touches the LLJIT, whose compiler is not thread
+// safe.  The next prompt adds the object, looks up "f.o2" and stores it
+// in the cell, so every later call -- from older modules too -- runs the
+// optimized body.  MONAD_REPL_BACKGROUND_O2=0 keeps the O0 code; a
+// positive value sets the worker count.
+
+#define REPL_LAZY_SUFFIX ".lazy"
+#define REPL_SLOT_SUFFIX ".slot"
+#define REPL_O2_SUFFIX   ".o2"
+#define REPL_O2_MAX_WORKERS 4
+
+typedef struct ReplO2Slot {
+    struct ReplO2Slot *next;
+    void              *target;   // what the trampoline calls
+    char               name[256];
+} ReplO2Slot;
+
+typedef struct ReplO2Job {
+    struct ReplO2Job   *next;
+    LLVMMemoryBufferRef bitcode;  // impl module, bodies named "<name>.impl"
+    LLVMMemoryBufferRef object;   // the O2 object; NULL if it failed
+    char               *layout;
+    int                 count;
+    char              (*names)[256];
+    ReplO2Slot        **slots;    // per name; NULL = no trampoline
+    char               *store_path; // JIT object cache entry to write instead
+} ReplO2Job;
+
+static ReplO2Slot *g_o2_slots = NULL;  // every cell, freed after the JIT
+
+static void repl_o2_job_free(ReplO2Job *job) {
+    if (job->bitcode) LLVMDisposeMemoryBuffer(job->bitcode);
+    if (job->object)  LLVMDisposeMemoryBuffer(job->object);
+    free(job->layout);
+    free(job->names);
+    free(job->slots);
+    free(job->store_path);
+    free(job);
+}
+
+static void repl_jit_cache_write(const char *path, LLVMMemoryBufferRef object);
+
+/* Runs on a worker: everything here lives in the job's own context. */
+static void repl_o2_compile(ReplO2Job *job) {
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef mod = NULL;
+    bool ok = LLVMParseBitcodeInContext2(context, job->bitcode, &mod) == 0;
+    LLVMDisposeMemoryBuffer(job->bitcode);
+    job->bitcode = NULL;
+
+    LLVMTargetMachineRef tm = NULL;
+    if (ok) {
+        for (int i = 0; i < job->count; i++) {
+            char impl_name[256 + sizeof(REPL_IMPL_SUFFIX)];
+            char o2_name[256 + sizeof(REPL_O2_SUFFIX)];
+            snprintf(impl_name, sizeof(impl_name), "%s" REPL_IMPL_SUFFIX, job->names[i]);
+            snprintf(o2_name, sizeof(o2_name), "%s" REPL_O2_SUFFIX, job->names[i]);
+            LLVMValueRef fn = LLVMGetNamedFunction(mod, impl_name);
+            if (fn) LLVMSetValueName2(fn, o2_name, strlen(o2_name));
+        }
+        if (job->layout) LLVMSetDataLayout(mod, job->layout);
+        /* JITDefault: the large code model on x86-64, so absolute
+         * addresses of host cells and runtime symbols always fit. */
+        tm = repl_orc_create_target_machine(LLVMCodeGenLevelAggressive,
+                                            LLVMCodeModelJITDefault);
+        ok = tm && repl_orc_run_pass_pipeline(mod, tm, "default<O2>");
+    }
+    if (ok) {
+        char *msg = NULL;
+        if (LLVMTargetMachineEmitToMemoryBuffer(tm, mod, LLVMObjectFile,
+                                                &msg, &job->object) != 0) {
+            job->object = NULL;
+        }
+        if (msg) LLVMDisposeMessage(msg);
+    }
+    if (job->object && job->store_path) {
+        repl_jit_cache_write(job->store_path, job->object);
+        LLVMDisposeMemoryBuffer(job->object);
+        job->object = NULL;
+    }
+    if (tm)  LLVMDisposeTargetMachine(tm);
+    if (mod) LLVMDisposeModule(mod);
+    LLVMContextDispose(context);
+}
+
+#if !defined(_WIN32)
+typedef struct {
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    pthread_t       workers[REPL_O2_MAX_WORKERS];
+    int             worker_count;
+    ReplO2Job      *head;   // waiting for a worker
+    ReplO2Job      *tail;
+    ReplO2Job      *done;   // compiled, waiting for the next prompt
+    bool            closing;
+} ReplO2Pool;
+
+static ReplO2Pool g_o2_pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    {0}, 0, NULL, NULL, NULL, false
+};
+
+static void *repl_o2_worker(void *arg) {
+    ReplO2Pool *pool = arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->mu);
+        while (!pool->head && !pool->closing)
+            pthread_cond_wait(&pool->cv, &pool->mu);
+        ReplO2Job *job = pool->head;
+        if (!job) { pthread_mutex_unlock(&pool->mu); return NULL; }
+        pool->head = job->next;
+        if (!pool->head) pool->tail = NULL;
+        bool closing = pool->closing;
+        pthread_mutex_unlock(&pool->mu);
+
+        /* After close, only cache entries are still worth compiling. */
+        if (!closing || job->store_path) repl_o2_compile(job);
+        if (closing || job->store_path) {
+            repl_o2_job_free(job);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->mu);
+        job->next  = pool->done;
+        pool->done = job;
+        pthread_mutex_unlock(&pool->mu);
+    }
+}
+
+static void repl_o2_start(void) {
+    ReplO2Pool *pool = &g_o2_pool;
+    const char *env = getenv("MONAD_REPL_BACKGROUND_O2");
+    int workers = 0;
+    if (env && *env) {
+        workers = atoi(env);
+        if (workers <= 0) return;
+    } else {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 1 ? (int)cpus - 1 : 1;
+    }
+    if (workers > REPL_O2_MAX_WORKERS) workers = REPL_O2_MAX_WORKERS;
+    pool->closing = false;
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&pool->workers[i], NULL, repl_o2_worker, pool) != 0) break;
+        pool->worker_count++;
+    }
+}
+
+static bool repl_o2_active(void) {
+    return g_o2_pool.worker_count > 0;
+}
+
+static void repl_o2_submit(ReplO2Job *job) {
+    ReplO2Pool *pool = &g_o2_pool;
+    job->next = NULL;
+    pthread_mutex_lock(&pool->mu);
+    if (pool->tail) pool->tail->next = job; else pool->head = job;
+    pool->tail = job;
+    pthread_cond_signal(&pool->cv);
+    pthread_mutex_unlock(&pool->mu);
+}
+
+static ReplO2Job *repl_o2_take_done(void) {
+    ReplO2Pool *pool = &g_o2_pool;
+    if (pool->worker_count == 0) return NULL;
+    pthread_mutex_lock(&pool->mu);
+    ReplO2Job *done = pool->done;
+    pool->done = NULL;
+    pthread_mutex_unlock(&pool->mu);
+    return done;
+}
+
+// Stops the workers once the queue is empty.  Queued upgrades are dropped
+// -- the O0 code they would have replaced is still live -- but queued JIT
+// cache entries are still written, or a short session would never fill
+// the cache.
+static void repl_o2_stop(void) {
+    ReplO2Pool *pool = &g_o2_pool;
+    if (pool->worker_count == 0) return;
+    pthread_mutex_lock(&pool->mu);
+    pool->closing = true;
+    pthread_cond_broadcast(&pool->cv);
+    pthread_mutex_unlock(&pool->mu);
+    for (int i = 0; i < pool->worker_count; i++)
+        pthread_join(pool->workers[i], NULL);
+    pool->worker_count = 0;
+    for (ReplO2Job *job = pool->done, *next; job; job = next) {
+        next = job->next;
+        repl_o2_job_free(job);
+    }
+    pool->done = NULL;
+}
+#else
+static void       repl_o2_start(void)            {}
+static bool       repl_o2_active(void)           { return false; }
+static void       repl_o2_submit(ReplO2Job *job) { repl_o2_job_free(job); }
+static ReplO2Job *repl_o2_take_done(void)        { return NULL; }
+static void       repl_o2_stop(void)             {}
+#endif
+
+/* Adds the objects the workers finished and points their cells at the O2
+ * bodies.  Runs on the input thread between evaluations, so no JIT code
+ * is executing and the LLJIT is only ever driven from one thread. */
+static void repl_o2_install_ready(REPLContext *ctx) {
+    for (ReplO2Job *job = repl_o2_take_done(), *next; job; job = next) {
+        next = job->next;
+        if (job->object) {
+            LLVMErrorRef err = LLVMOrcLLJITAddObjectFile(ctx->jit, ctx->jd, job->object);
+            job->object = NULL;
+            for (int i = 0; !err && i < job->count; i++) {
+                if (!job->slots[i]) continue;
+                char o2_name[256 + sizeof(REPL_O2_SUFFIX)];
+                snprintf(o2_name, sizeof(o2_name), "%s" REPL_O2_SUFFIX, job->names[i]);
+                LLVMOrcExecutorAddress addr = 0;
+                err = LLVMOrcLLJITLookup(ctx->jit, &addr, o2_name);
+                if (!err && addr) job->slots[i]->target = (void *)(uintptr_t)addr;
+            }
+            /* The O0 code keeps working; a failed upgrade is not worth
+             * interrupting the session for. */
+            if (err) LLVMConsumeError(err);
+        }
+        repl_o2_job_free(job);
+    }
+}
+
+/* A trampoline forwards its arguments unchanged, which is only sound for
+ * plain signatures. */
+static bool repl_o2_can_trampoline(LLVMValueRef fn) {
+    if (LLVMIsFunctionVarArg(LLVMGlobalGetValueType(fn))) return false;
+    unsigned params = LLVMCountParams(fn);
+    for (unsigned i = 1; i <= params; i++)
+        if (LLVMGetAttributeCountAtIndex(fn, i) != 0) return false;
+    return true;
+}
+
+/* Give the declaration `decl` a body that calls through `slot`. */
+static void repl_o2_build_trampoline(LLVMModuleRef mod, LLVMValueRef decl,
+                                     const char *slot_name) {
+    LLVMTypeRef fn_type  = LLVMGlobalGetValueType(decl);
+    LLVMTypeRef ptr_type = LLVMPointerType(fn_type, 0);
+    LLVMValueRef slot = LLVMAddGlobal(mod, ptr_type, slot_name);
+    LLVMSetLinkage(slot, LLVMExternalLinkage);
+
+    LLVMContextRef context = LLVMGetModuleContext(mod);
+    LLVMBuilderRef b = LLVMCreateBuilderInContext(context);
+    LLVMPositionBuilderAtEnd(b, LLVMAppendBasicBlockInContext(context, decl, "entry"));
+    LLVMValueRef target = LLVMBuildLoad2(b, ptr_type, slot, "target");
+
+    unsigned n = LLVMCountParams(decl);
+    LLVMValueRef *args = malloc(sizeof(LLVMValueRef) * (n ? n : 1));
+    for (unsigned i = 0; i < n; i++) args[i] = LLVMGetParam(decl, i);
+    bool is_void = LLVMGetTypeKind(LLVMGetReturnType(fn_type)) == LLVMVoidTypeKind;
+    LLVMValueRef call = LLVMBuildCall2(b, fn_type, target, args, n, "");
+    LLVMSetInstructionCallConv(call, LLVMGetFunctionCallConv(decl));
+    LLVMSetTailCall(call, 1);
+    if (is_void) LLVMBuildRetVoid(b);
+    else         LLVMBuildRet(b, call);
+    free(args);
+    LLVMDisposeBuilder(b);
+}
+
+/* Duplicating a module-local variable would give the O0 and O2 bodies
+ * different copies of it; constants are fine. */
+static bool repl_o2_module_ok(LLVMModuleRef impl) {
+    for (LLVMValueRef g = LLVMGetFirstGlobal(impl); g; g = LLVMGetNextGlobal(g))
+        if (LLVMGetInitializer(g) && repl_linkage_is_local(g) && !LLVMIsGlobalConstant(g))
+            return false;
+    return true;
+}
+
+/// JIT object cache
+//
+// An evaluated module is keyed by its bitcode after the O0 pipeline, the
+// compiler build and the host CPU, and its object lives in
+// <cache>/jit/<key>.o.  A hit adds that object straight to the JITDylib,
+// so the module is neither split nor compiled; a miss hands the bitcode
+// to the background pool, which compiles it at O2 and writes the entry.
+// The wrapper name and module identifier are part of the bitcode, so an
+// entry matches the same form at the same point of a session -- the
+// startup modules and a ,load'ed file.  The Monad front-end still runs:
+// evaluating a form is what fills the Env.  MONAD_CACHE=0 turns this off
+// along with the import cache.
+
+#define MONAD_REPL_JIT_CACHE_ABI "monad-repl-jit-v1"
+
+static bool     repl_cache_prepare_dir(char *dir, size_t capacity);
+static uint64_t repl_cache_hash_bytes(uint64_t hash, const void *data, size_t size);
+static uint64_t repl_cache_hash_string(uint64_t hash, const char *value);
+static bool     repl_cache_trace_enabled(void);
+
+/* The entry for `mod`, with the bitcode it was keyed by in *bitcode.
+ * False when the cache is off. */
+static bool repl_jit_cache_path(LLVMModuleRef mod, char *path, size_t capacity,
+                                LLVMMemoryBufferRef *bitcode) {
+    *bitcode = NULL;
+    char dir[1024];
+    if (!repl_cache_prepare_dir(dir, sizeof(dir))) return false;
+    char jit_dir[1100];
+    snprintf(jit_dir, sizeof(jit_dir), "%s/jit", dir);
+    monad_mkdir(jit_dir);
+
+    LLVMMemoryBufferRef bc = LLVMWriteBitcodeToMemoryBuffer(mod);
+    if (!bc) return false;
+    uint64_t hash = UINT64_C(1469598103934665603);
+    hash = repl_cache_hash_string(hash, MONAD_REPL_JIT_CACHE_ABI);
+    hash = repl_cache_hash_string(hash, compiler_identity_hash());
+    char *cpu = LLVMGetHostCPUName();
+    char *features = LLVMGetHostCPUFeatures();
+    hash = repl_cache_hash_string(hash, cpu ? cpu : "");
+    hash = repl_cache_hash_string(hash, features ? features : "");
+    if (features) LLVMDisposeMessage(features);
+    if (cpu) LLVMDisposeMessage(cpu);
+    hash = repl_cache_hash_bytes(hash, LLVMGetBufferStart(bc), LLVMGetBufferSize(bc));
+
+    snprintf(path, capacity, "%s/%016llx.o", jit_dir, (unsigned long long)hash);
+    *bitcode = bc;
+    return true;
+}
+
+/* Add the entry at `path` if there is a usable one; a damaged entry is
+ * removed so the next miss rewrites it. */
+static bool repl_jit_cache_load(REPLContext *ctx, const char *path) {
+    if (access(path, R_OK) != 0) return false;
+    LLVMMemoryBufferRef object = NULL;
+    char *msg = NULL;
+    if (LLVMCreateMemoryBufferWithContentsOfFile(path, &object, &msg) != 0) {
+        if (msg) LLVMDisposeMessage(msg);
+        return false;
+    }
+    bool ok = true;
+#if !defined(_WIN32)
+    ok = LLVMGetBufferSize(object) >= 4 &&
+         memcmp(LLVMGetBufferStart(object), "\x7f" "ELF", 4) == 0;
+#endif
+    if (ok) {
+        LLVMErrorRef err = LLVMOrcLLJITAddObjectFile(ctx->jit, ctx->jd, object);
+        if (err) {
+            LLVMConsumeError(err);
+            ok = false;
+        }
+    } else {
+        LLVMDisposeMemoryBuffer(object);
+    }
+    if (!ok) {
+        remove(path);
+        if (repl_cache_trace_enabled())
+            fprintf(stderr, "[monad-cache] repair jit %s\n", path);
+        return false;
+    }
+    if (repl_cache_trace_enabled())
+        fprintf(stderr, "[monad-cache] hit jit %s\n", path);
+    return true;
+}
+
+/* Runs on a worker.  Entries appear whole or not at all. */
+static void repl_jit_cache_write(const char *path, LLVMMemoryBufferRef object) {
+    char tmp[1500];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.%p.tmp", path, (long)getpid(), (void *)object);
+    FILE *file = fopen(tmp, "wb");
+    if (!file) return;
+    size_t size = LLVMGetBufferSize(object);
+    bool ok = fwrite(LLVMGetBufferStart(object), 1, size, file) == size;
+    if (fclose(file) != 0) ok = false;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return;
+    }
+    if (repl_cache_trace_enabled())
+        fprintf(stderr, "[monad-cache] store jit %s\n", path);
+}
+
+/* Queue a store for a missed entry; takes `bitcode`.  Without the pool
+ * nothing is stored, as a synchronous compile would cost every miss the
+ * laziness it has. */
+static void repl_jit_cache_store(REPLContext *ctx, LLVMMemoryBufferRef bitcode,
+                                 const char *path) {
+    if (!repl_o2_active()) {
+        LLVMDisposeMemoryBuffer(bitcode);
+        return;
+    }
+    ReplO2Job *job = calloc(1, sizeof(*job));
+    job->bitcode = bitcode;
+    const char *layout = LLVMOrcLLJITGetDataLayoutStr(ctx->jit);
+    job->layout = layout ? strdup(layout) : NULL;
+    job->store_path = strdup(path);
+    repl_o2_submit(job);
+}
+
+/* Split `mod` and add its function bodies behind lazy reexports.  Returns
+ * false without touching `mod` when the module cannot be split. */
+static bool repl_lazy_add_bodies(REPLContext *ctx, LLVMModuleRef mod,
+                                 char names[][256], int count, bool *failed) {
+    *failed = false;
+    if (!ctx->lctm || !ctx->ism || count == 0) return false;
+    for (LLVMValueRef g = LLVMGetFirstGlobal(mod); g; g = LLVMGetNextGlobal(g))
+        if (LLVMGetLinkage(g) == LLVMAppendingLinkage) return false;
+
+    /* impl: the bodies, renamed, and declarations for everything else
+     * the module exports -- the wrapper, getters and value globals stay
+     * defined in `mod` only. */
+    LLVMModuleRef impl = LLVMCloneModule(mod);
+    size_t cap = 16, n = 0;
+    LLVMValueRef *defs = malloc(cap * sizeof(LLVMValueRef));
+    for (LLVMValueRef f = LLVMGetFirstFunction(impl); f; f = LLVMGetNextFunction(f)) {
+        if (LLVMCountBasicBlocks(f) == 0 || repl_linkage_is_local(f)) continue;
+        bool lazy = false;
+        for (int i = 0; i < count && !lazy; i++)
+            lazy = strcmp(LLVMGetValueName(f), names[i]) == 0;
+        if (lazy) continue;
+        if (n == cap) defs = realloc(defs, (cap *= 2) * sizeof(LLVMValueRef));
+        defs[n++] = f;
+    }
+    for (LLVMValueRef g = LLVMGetFirstGlobal(impl); g; g = LLVMGetNextGlobal(g)) {
+        if (!LLVMGetInitializer(g) || repl_linkage_is_local(g)) continue;
+        if (n == cap) defs = realloc(defs, (cap *= 2) * sizeof(LLVMValueRef));
+        defs[n++] = g;
+    }
+    for (size_t i = 0; i < n; i++) repl_definition_to_decl(impl, defs[i]);
+    free(defs);
+
+    /* With the O2 pool, trampolines take the names and the stubs become
+     * "<name>.lazy"; see Background O2. */
+    bool o2 = repl_o2_active() && repl_o2_module_ok(impl);
+    bool *tramp = calloc((size_t)count, sizeof(bool));
+    LLVMOrcCSymbolAliasMapPair *aliases = malloc(sizeof(*aliases) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        char impl_name[256 + sizeof(REPL_IMPL_SUFFIX)];
+        char stub_name[256 + sizeof(REPL_LAZY_SUFFIX)];
+        snprintf(impl_name, sizeof(impl_name), "%s" REPL_IMPL_SUFFIX, names[i]);
+        LLVMValueRef body = LLVMGetNamedFunction(impl, names[i]);
+        tramp[i] = o2 && repl_o2_can_trampoline(body);
+        snprintf(stub_name, sizeof(stub_name), "%s%s", names[i],
+                 tramp[i] ? REPL_LAZY_SUFFIX : "");
+        LLVMSetValueName2(body, impl_name, strlen(impl_name));
+        aliases[i].Name = LLVMOrcLLJITMangleAndIntern(ctx->jit, stub_name);
+        aliases[i].Entry.Name = LLVMOrcLLJITMangleAndIntern(ctx->jit, impl_name);
+        aliases[i].Entry.Flags.GenericFlags =
+            LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable;
+        aliases[i].Entry.Flags.TargetFlags = 0;
+    }
+
+    /* mod: declarations the stubs resolve, or trampolines. */
+    for (int i = 0; i < count; i++) {
+        repl_definition_to_decl(mod, LLVMGetNamedFunction(mod, names[i]));
+        if (!tramp[i]) continue;
+        char slot_name[256 + sizeof(REPL_SLOT_SUFFIX)];
+        snprintf(slot_name, sizeof(slot_name), "%s" REPL_SLOT_SUFFIX, names[i]);
+        repl_o2_build_trampoline(mod, LLVMGetNamedFunction(mod, names[i]), slot_name);
+    }
+
+    ReplO2Job *job = NULL;
+    if (o2) {
+        job = calloc(1, sizeof(*job));
+        job->bitcode = LLVMWriteBitcodeToMemoryBuffer(impl);
+        const char *layout = LLVMOrcLLJITGetDataLayoutStr(ctx->jit);
+        job->layout = layout ? strdup(layout) : NULL;
+        job->count  = count;
+        job->names  = malloc(sizeof(*job->names) * (size_t)count);
+        memcpy(job->names, names, sizeof(*job->names) * (size_t)count);
+        job->slots  = calloc((size_t)count, sizeof(ReplO2Slot *));
+    }
+
+    LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModule(
+        ctx->jit, ctx->jd, LLVMOrcCreateNewThreadSafeModule(impl, ctx->tsc));
+    if (!err) {
+        LLVMOrcMaterializationUnitRef mu =
+            LLVMOrcLazyReexports(ctx->lctm, ctx->ism, ctx->jd, aliases, (size_t)count);
+        err = LLVMOrcJITDylibDefine(ctx->jd, mu);
+        if (err) LLVMOrcDisposeMaterializationUnit(mu);
+    } else {
+        for (int i = 0; i < count; i++) {
+            LLVMOrcReleaseSymbolStringPoolEntry(aliases[i].Name);
+            LLVMOrcReleaseSymbolStringPoolEntry(aliases[i].Entry.Name);
+        }
+    }
+    free(aliases);
+
+    /* Each cell starts at its stub; looking a stub up does not compile
+     * the body behind it. */
+    for (int i = 0; !err && job && i < count; i++) {
+        if (!tramp[i]) continue;
+        char stub_name[256 + sizeof(REPL_LAZY_SUFFIX)];
+        char slot_name[256 + sizeof(REPL_SLOT_SUFFIX)];
+        snprintf(stub_name, sizeof(stub_name), "%s" REPL_LAZY_SUFFIX, names[i]);
+        snprintf(slot_name, sizeof(slot_name), "%s" REPL_SLOT_SUFFIX, names[i]);
+        LLVMOrcExecutorAddress stub = 0;
+        err = LLVMOrcLLJITLookup(ctx->jit, &stub, stub_name);
+        if (err) break;
+        ReplO2Slot *slot = calloc(1, sizeof(*slot));
+        slot->target = (void *)(uintptr_t)stub;
+        memcpy(slot->name, names[i], sizeof(slot->name));
+        slot->next = g_o2_slots;
+        g_o2_slots = slot;
+        job->slots[i] = slot;
+        if (!repl_orc_define_absolute(ctx, slot_name, &slot->target, false)) {
+            *failed = true;
+            break;
+        }
+    }
+    free(tramp);
+    if (err) {
+        repl_report_llvm_error("Error: ORC could not add lazy REPL functions", err);
+        *failed = true;
+    }
+    if (job) {
+        if (*failed) repl_o2_job_free(job);
+        else         repl_o2_submit(job);
+    }
+    return true;
+}
+
+/// perf map
+//
+//  With MONAD_PROF set, an object transform records the function symbols
+//  of every object the LLJIT links, including background O2 upgrades.  It
+//  runs under ORC's session lock, so it only collects names;
+//  repl_perf_map_flush resolves them between evaluations and hands them
+//  to rt_prof_jit_symbol, which appends them to /tmp/perf-<pid>.map.
+
+#if !defined(_WIN32)
+typedef struct {
+    char    *name;
+    uint64_t size;
+} ReplPerfSym;
+
+static pthread_mutex_t g_perf_lock = PTHREAD_MUTEX_INITIALIZER;
+static ReplPerfSym    *g_perf_pending;
+static size_t          g_perf_pending_count, g_perf_pending_cap;
+
+static void repl_perf_map_note(const char *name, uint64_t size) {
+    pthread_mutex_lock(&g_perf_lock);
+    if (g_perf_pending_count == g_perf_pending_cap) {
+        size_t cap = g_perf_pending_cap ? g_perf_pending_cap * 2 : 64;
+        ReplPerfSym *grown = realloc(g_perf_pending, cap * sizeof(ReplPerfSym));
+        if (grown) {
+            g_perf_pending     = grown;
+            g_perf_pending_cap = cap;
+        }
+    }
+    if (g_perf_pending_count < g_perf_pending_cap) {
+        g_perf_pending[g_perf_pending_count].name = strdup(name);
+        g_perf_pending[g_perf_pending_count].size = size;
+        g_perf_pending_count++;
+    }
+    pthread_mutex_unlock(&g_perf_lock);
+}
+
+static LLVMErrorRef repl_perf_map_transform(void *unused, LLVMMemoryBufferRef *obj) {
+    (void)unused;
+    char *msg = NULL;
+    LLVMBinaryRef bin = LLVMCreateBinary(*obj, NULL, &msg);
+    if (!bin) {
+        if (msg) LLVMDisposeMessage(msg);
+        return NULL;   // never fail a link over the perf map
+    }
+    LLVMSectionIteratorRef sect = LLVMObjectFileCopySectionIterator(bin);
+    LLVMSymbolIteratorRef  sym  = LLVMObjectFileCopySymbolIterator(bin);
+    for (; sect && sym && !LLVMObjectFileIsSymbolIteratorAtEnd(bin, sym);
+         LLVMMoveToNextSymbol(sym)) {
+        const char *name = LLVMGetSymbolName(sym);
+        uint64_t    size = LLVMGetSymbolSize(sym);
+        if (!name || !*name || size == 0) continue;
+        LLVMMoveToContainingSection(sect, sym);
+        if (LLVMObjectFileIsSectionIteratorAtEnd(bin, sect)) continue;
+        const char *sname = LLVMGetSectionName(sect);
+        if (sname && (strncmp(sname, ".text", 5) == 0 || strcmp(sname, "__text") == 0))
+            repl_perf_map_note(name, size);
+    }
+    if (sym)  LLVMDisposeSymbolIterator(sym);
+    if (sect) LLVMDisposeSectionIterator(sect);
+    LLVMDisposeBinary(bin);
+    return NULL;
+}
+
+static void repl_perf_map_install(REPLContext *ctx) {
+    if (!rt_prof_perf_map_enabled()) return;
+    LLVMOrcObjectTransformLayerSetTransform(
+        LLVMOrcLLJITGetObjTransformLayer(ctx->jit), repl_perf_map_transform, NULL);
+}
+
+static void repl_perf_map_flush(REPLContext *ctx) {
+    pthread_mutex_lock(&g_perf_lock);
+    ReplPerfSym *syms  = g_perf_pending;
+    size_t       count = g_perf_pending_count;
+    g_perf_pending       = NULL;
+    g_perf_pending_count = g_perf_pending_cap = 0;
+    pthread_mutex_unlock(&g_perf_lock);
+
+    char prefix = LLVMOrcLLJITGetGlobalPrefix(ctx->jit);
+    for (size_t i = 0; i < count; i++) {
+        const char *name = syms[i].name;
+        if (prefix && name[0] == prefix) name++;
+        LLVMOrcExecutorAddress addr = 0;
+        LLVMErrorRef err = LLVMOrcLLJITLookup(ctx->jit, &addr, name);
+        /* Internal symbols are not in the JITDylib; leave them out. */
+        if (err) LLVMConsumeError(err);
+        else if (addr) rt_prof_jit_symbol((uintptr_t)addr, (size_t)syms[i].size, name);
+        free(syms[i].name);
+    }
+    free(syms);
+}
+#else
+static void repl_perf_map_install(REPLContext *ctx) { (void)ctx; }
+static void repl_perf_map_flush(REPLContext *ctx)   { (void)ctx; }
+#endif
+
 /// JIT compile and run
 
 static bool close_and_run(REPLContext *ctx) {
@@ -1711,9 +2430,9 @@ static bool close_and_run(REPLContext *ctx) {
     ctx->cg.module = NULL;
 
     LLVMTargetMachineRef tm =
-        repl_orc_create_target_machine(LLVMCodeGenLevelNone);
+        repl_orc_create_target_machine(LLVMCodeGenLevelNone, LLVMCodeModelDefault);
     repl_orc_configure_module(ctx, mod, tm);
-    if (!repl_orc_run_pass_pipeline(mod, tm)) {
+    if (!repl_orc_run_pass_pipeline(mod, tm, "default<O0>")) {
         if (tm) LLVMDisposeTargetMachine(tm);
         LLVMDisposeModule(mod);
         return false;
@@ -1744,13 +2463,48 @@ static bool close_and_run(REPLContext *ctx) {
      * cross-module data lookups in this REPL shape; value definitions expose
      * exported getter functions instead, and those are covered above. */
 
-    LLVMOrcThreadSafeModuleRef tsm =
-        LLVMOrcCreateNewThreadSafeModule(mod, ctx->tsc);
-    LLVMErrorRef add_err =
-        LLVMOrcLLJITAddLLVMIRModule(ctx->jit, ctx->jd, tsm);
-    if (add_err) {
-        repl_report_llvm_error("Error: ORC could not add REPL module", add_err);
-        return false;
+    LLVMMemoryBufferRef cache_bitcode = NULL;
+    char cache_path[1400];
+    bool cached =
+        repl_jit_cache_path(mod, cache_path, sizeof(cache_path), &cache_bitcode) &&
+        repl_jit_cache_load(ctx, cache_path);
+    if (cached) {
+        LLVMDisposeMemoryBuffer(cache_bitcode);
+        LLVMDisposeModule(mod);
+    } else {
+        if (cache_bitcode) repl_jit_cache_store(ctx, cache_bitcode, cache_path);
+
+        /* Getters stay eager: they are one load, and the registration lookups
+         * below would only turn a stub into the same code.  Partition them to
+         * the back; the front lazy_count names get stubs. */
+        int lazy_count = 0;
+        if (defined_count < 512) {  /* a full table may have missed a body */
+            for (int i = 0; i < defined_count; i++) {
+                if (strncmp(defined_names[i], "__monad_repl_get", 16) == 0) continue;
+                if (i != lazy_count) {
+                    char tmp[256];
+                    memcpy(tmp, defined_names[lazy_count], sizeof(tmp));
+                    memcpy(defined_names[lazy_count], defined_names[i], sizeof(tmp));
+                    memcpy(defined_names[i], tmp, sizeof(tmp));
+                }
+                lazy_count++;
+            }
+        }
+        bool lazy_failed = false;
+        repl_lazy_add_bodies(ctx, mod, defined_names, lazy_count, &lazy_failed);
+        if (lazy_failed) {
+            LLVMDisposeModule(mod);
+            return false;
+        }
+
+        LLVMOrcThreadSafeModuleRef tsm =
+            LLVMOrcCreateNewThreadSafeModule(mod, ctx->tsc);
+        LLVMErrorRef add_err =
+            LLVMOrcLLJITAddLLVMIRModule(ctx->jit, ctx->jd, tsm);
+        if (add_err) {
+            repl_report_llvm_error("Error: ORC could not add REPL module", add_err);
+            return false;
+        }
     }
 
     LLVMOrcExecutorAddress wrapper_addr = 0;
@@ -1769,6 +2523,7 @@ static bool close_and_run(REPLContext *ctx) {
     }
 
     fn();
+    repl_perf_map_flush(ctx);
 
     for (int i = 0; i < defined_count; i++) {
         LLVMOrcExecutorAddress addr = 0;
@@ -1797,6 +2552,8 @@ static void recover_module(REPLContext *ctx) {
         LLVMDisposeBuilder(ctx->cg.builder);
         ctx->cg.builder = NULL;
     }
+    /* Loop frames lived on the stack the error unwound */
+    ctx->cg.loop = NULL;
 }
 
 /// Import support
@@ -1834,17 +2591,22 @@ static bool repl_cache_hash_file(uint64_t *hash, const char *path) {
     return ok;
 }
 
-static void repl_cache_compiler_path(char *path, size_t capacity) {
-#if defined(_WIN32)
-    DWORD count = GetModuleFileNameA(NULL, path, (DWORD)capacity);
-    if (count == 0 || count >= capacity) path[0] = '\0';
-#elif defined(__linux__)
-    ssize_t count = readlink("/proc/self/exe", path, capacity - 1);
-    if (count < 0) path[0] = '\0';
-    else path[count] = '\0';
-#else
-    path[0] = '\0';
-#endif
+/* `llvm-config --ldflags --libs core`, run once per session: every import
+ * hashes and links with it. */
+static const char *repl_cache_llvm_flags(void) {
+    static char flags[2048];
+    static bool loaded = false;
+    if (loaded) return flags;
+    loaded = true;
+    FILE *pipe = popen("llvm-config --ldflags --libs core", "r");
+    if (!pipe) return flags;
+    size_t used = fread(flags, 1, sizeof(flags) - 1, pipe);
+    pclose(pipe);
+    flags[used] = '\0';
+    for (size_t i = 0; i < used; i++)
+        if (flags[i] == '\r' || flags[i] == '\n')
+            flags[i] = ' ';
+    return flags;
 }
 
 static bool repl_cache_artifact_sane(const char *path) {
@@ -1986,10 +2748,11 @@ static time_t file_mtime_r(const char *p) {
 
 static bool module_already_loaded(REPLContext *ctx, const char *mod_name) {
     Env *env = ctx->cg.env;
-    for (size_t bi = 0; bi < env->size; bi++)
-        for (EnvEntry *e = env->buckets[bi]; e; e = e->next)
-            if (e->module_name && strcmp(e->module_name, mod_name) == 0)
-                return true;
+    for (size_t bi = 0; bi < env->size; bi++) {
+        EnvEntry *e = env->slots[bi];
+        if (e && e->module_name && strcmp(e->module_name, mod_name) == 0)
+            return true;
+    }
     return false;
 }
 
@@ -2246,17 +3009,7 @@ static bool handle_import(REPLContext *ctx, AST *ast, bool announce) {
     {
         const char **all_objs = repl_get_compiled_obj_paths();
         char *runtime_archive = repl_runtime_archive_path();
-        char llvm_flags[2048] = "";
-        FILE *llvm_pipe = popen("llvm-config --ldflags --libs core", "r");
-        if (llvm_pipe) {
-            size_t used = fread(llvm_flags, 1, sizeof(llvm_flags) - 1,
-                                llvm_pipe);
-            pclose(llvm_pipe);
-            llvm_flags[used] = '\0';
-            for (size_t i = 0; i < used; i++)
-                if (llvm_flags[i] == '\r' || llvm_flags[i] == '\n')
-                    llvm_flags[i] = ' ';
-        }
+        const char *llvm_flags = repl_cache_llvm_flags();
 
         uint64_t cache_hash = UINT64_C(1469598103934665603);
         cache_hash = repl_cache_hash_string(cache_hash, MONAD_REPL_CACHE_ABI);
@@ -2272,11 +3025,7 @@ static bool handle_import(REPLContext *ctx, AST *ast, bool announce) {
         if (!repl_cache_hash_file(&cache_hash, runtime_archive))
             hash_ok = false;
 
-        char compiler_path[1024];
-        repl_cache_compiler_path(compiler_path, sizeof(compiler_path));
-        if (!compiler_path[0] ||
-            !repl_cache_hash_file(&cache_hash, compiler_path))
-            hash_ok = false;
+        cache_hash = repl_cache_hash_string(cache_hash, compiler_identity_hash());
 
         char cache_dir[1024];
         char cache_path[1400] = "";
@@ -2369,29 +3118,29 @@ static bool handle_import(REPLContext *ctx, AST *ast, bool announce) {
     {
         Env *env = ctx->cg.env;
         for (size_t bi = 0; bi < env->size; bi++) {
-            for (EnvEntry *e = env->buckets[bi]; e; e = e->next) {
-                if (!e->module_name ||
-                    strcmp(e->module_name, mod_name) != 0) continue;
-                /* Try to find the symbol by its mangled llvm_name */
-                const char *lname = (e->llvm_name && e->llvm_name[0])
-                                  ? e->llvm_name : e->name;
-                void *addr = dlsym(handle, lname);
-                if (!addr) {
-                    /* Try mangled version of the name */
-                    char *mangled = mangle_unicode_name(lname);
-                    if (mangled) {
-                        addr = dlsym(handle, mangled);
-                        if (addr) register_imported_sym(mangled, addr);
-                        free(mangled);
-                    }
-                }
-                if (addr) {
-                    register_imported_sym(lname, addr);
-                    /* Also register under the original name */
-                    if (strcmp(lname, e->name) != 0)
-                        register_imported_sym(e->name, addr);
+            EnvEntry *e = env->slots[bi];
+            if (!e) continue;
+            if (!e->module_name ||
+                strcmp(e->module_name, mod_name) != 0) continue;
+            /* Try to find the symbol by its mangled llvm_name */
+            const char *lname = (e->llvm_name && e->llvm_name[0])
+                              ? e->llvm_name : e->name;
+            void *addr = dlsym(handle, lname);
+            if (!addr) {
+                /* Try mangled version of the name */
+                char *mangled = mangle_unicode_name(lname);
+                if (mangled) {
+                    addr = dlsym(handle, mangled);
+                    if (addr) register_imported_sym(mangled, addr);
+                    free(mangled);
                 }
             }
+            if (addr) {
+                register_imported_sym(lname, addr);
+                /* Also register under the original name */
+                if (strcmp(lname, e->name) != 0)
+                    register_imported_sym(e->name, addr);
+            }
         }
     }
 
@@ -2518,13 +3267,13 @@ void repl_init(REPLContext *ctx) {
     ctx->cg.module     = NULL;
     ctx->cg.builder    = NULL;
     ctx->cg.env        = env_create();
+    ctx->cg.env->on_lookup      = repl_declare_on_lookup;
+    ctx->cg.env->on_lookup_data = ctx;
     env_init_infer(ctx->cg.env);
     ctx->cg.module_ctx = NULL;
     ctx->cg.init_fn    = NULL;
     ctx->cg.test_mode  = false;
-    ctx->cg.fmt_str = ctx->cg.fmt_char = ctx->cg.fmt_int =
-    ctx->cg.fmt_float = ctx->cg.fmt_hex = ctx->cg.fmt_bin =
-    ctx->cg.fmt_oct = NULL;
+    ctx->cg.cache_module = NULL;
     ctx->cg.error_jmp_set = false;
     ctx->cg.repl_host_globals = true;
     memset(ctx->cg.error_msg, 0, sizeof(ctx->cg.error_msg));
@@ -2549,9 +3298,14 @@ void repl_init(REPLContext *ctx) {
     }
     LLVMOrcJITDylibAddGenerator(ctx->jd, process_gen);
 
+    rt_prof_init();
+    repl_perf_map_install(ctx);
+
     if (!repl_orc_define_host_symbols(ctx)) {
         _Exit(1);
     }
+    repl_lazy_init(ctx);
+    if (ctx->lctm) repl_o2_start();
 
     ctx->cg.ffi = ffi_context_create();
     register_builtins(&ctx->cg);
@@ -2630,6 +3384,7 @@ void repl_init(REPLContext *ctx) {
 }
 
 void repl_dispose(REPLContext *ctx) {
+    repl_o2_stop();
     if (ctx->cg.builder) LLVMDisposeBuilder(ctx->cg.builder);
     if (ctx->cg.module)  LLVMDisposeModule(ctx->cg.module);
     if (ctx->jit) {
@@ -2637,6 +3392,19 @@ void repl_dispose(REPLContext *ctx) {
         if (err) repl_report_llvm_error("REPL: ORC LLJIT disposal failed", err);
         ctx->jit = NULL;
     }
+    if (ctx->ism) {
+        LLVMOrcDisposeIndirectStubsManager(ctx->ism);
+        ctx->ism = NULL;
+    }
+    if (ctx->lctm) {
+        LLVMOrcDisposeLazyCallThroughManager(ctx->lctm);
+        ctx->lctm = NULL;
+    }
+    while (g_o2_slots) {
+        ReplO2Slot *next = g_o2_slots->next;
+        free(g_o2_slots);
+        g_o2_slots = next;
+    }
     if (ctx->tsc) {
         LLVMOrcDisposeThreadSafeContext(ctx->tsc);
         ctx->tsc = NULL;
@@ -2730,29 +3498,29 @@ static void repl_seed_wisp_arities(REPLContext *ctx) {
 
     Env *env = ctx->cg.env;
     for (size_t bi = 0; bi < env->size; bi++) {
-        for (EnvEntry *e = env->buckets[bi]; e; e = e->next) {
-            if (!e || !e->name) continue;
+        EnvEntry *e = env->slots[bi];
+        if (!e) continue;
+        if (!e || !e->name) continue;
 
-            switch (e->kind) {
-            case ENV_VAR:
-                wisp_register_arity(e->name, 0);
-                break;
-
-            case ENV_FUNC:
-                wisp_register_arity(e->name, e->param_count);
-                break;
+        switch (e->kind) {
+        case ENV_VAR:
+            wisp_register_arity(e->name, 0);
+            break;
 
-            case ENV_BUILTIN:
-                if (e->arity_min >= 0 && e->arity_max == e->arity_min) {
-                    wisp_register_arity(e->name, e->arity_min);
-                } else {
-                    wisp_register_arity(e->name, -1);
-                }
-                break;
+        case ENV_FUNC:
+            wisp_register_arity(e->name, e->param_count);
+            break;
 
-            default:
-                break;
+        case ENV_BUILTIN:
+            if (e->arity_min >= 0 && e->arity_max == e->arity_min) {
+                wisp_register_arity(e->name, e->arity_min);
+            } else {
+                wisp_register_arity(e->name, -1);
             }
+            break;
+
+        default:
+            break;
         }
     }
 
@@ -2781,8 +3549,82 @@ static bool repl_infer(REPLContext *ctx, AST *ast) {
 }
 
 
+/* -------------------------------------------------------------------------
+ * Bytecode tier
+ *
+ * A one-shot expression in the bytecode subset (bytecode_lower.h) runs on
+ * the register VM instead of costing an LLVM module, an ORC lookup and a
+ * materialization.  An untyped lowering rejects most lines before HM
+ * runs; a line that passes is inferred and lowered again.  Names the
+ * session has defined are outside the subset, so anything that touches
+ * the Env still takes the JIT.  MONAD_REPL_BYTECODE=0 turns it off.
+ * ------------------------------------------------------------------------- */
+
+static bool repl_bytecode_enabled(void) {
+    const char *value = getenv("MONAD_REPL_BYTECODE");
+    return !value || strcmp(value, "0") != 0;
+}
+
+static bool repl_names_builtin(const char *name, void *userdata) {
+    REPLContext *ctx = userdata;
+    EnvEntry *e = env_lookup(ctx->cg.env, name);
+    return !e || e->kind == ENV_BUILTIN;
+}
+
+static bool repl_bytecode_lower(REPLContext *ctx, BcProgram *program,
+                                const AST *ast, BcError *error) {
+    BcLowerOptions options = bc_lower_options_default();
+    options.file       = parser_get_filename();
+    options.is_builtin = repl_names_builtin;
+    options.userdata   = ctx;
+    bc_program_init(program, "<repl>");
+    if (bc_lower_expr(program, ast, &options, error)) return true;
+    bc_program_free(program);
+    return false;
+}
+
+/* Returns true when the line ran on the VM; *inferred says whether HM
+ * already annotated `ast` for the JIT path that runs otherwise. */
+static bool repl_bytecode_eval(REPLContext *ctx, AST *ast, bool silent,
+                               bool *inferred) {
+    *inferred = false;
+    if (!repl_bytecode_enabled()) return false;
+
+    BcProgram program;
+    BcError error;
+    if (!repl_bytecode_lower(ctx, &program, ast, &error)) return false;
+    bc_program_free(&program);
+
+    *inferred = true;
+    if (!repl_infer(ctx, ast)) return false;
+    if (!repl_bytecode_lower(ctx, &program, ast, &error)) return false;
+
+    BcVM vm;
+    bc_vm_init(&vm);
+    BcValue value;
+    bool ok = bc_vm_run(&vm, &program, &value, &error);
+    bc_vm_free(&vm);
+    bc_program_free(&program);
+    if (!ok) {
+        fprintf(stderr, "%u:%u: runtime error: %s\n",
+                error.span.line, error.span.column, error.message);
+        return true;
+    }
+    if (silent) return true;
+    switch (value.kind) {
+    case BC_VALUE_I64:  printf("%" PRId64 "\n", value.as.i64); break;
+    case BC_VALUE_F64:  printf("%.16g\n", value.as.f64); break;
+    case BC_VALUE_BOOL: printf(value.as.boolean ? "True\n" : "False\n"); break;
+    default: break;
+    }
+    fflush(stdout);
+    return true;
+}
+
 bool repl_eval_line(REPLContext *ctx, const char *line) {
     if (!line) return true;
+    repl_o2_install_ready(ctx);
+    repl_perf_map_flush(ctx);
     const char *p = line;
     while (*p && isspace((unsigned char)*p)) p++;
     if (!*p) return true;
@@ -3042,6 +3884,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
                     g_assert_jmp_ptr = NULL;
                     g_in_eval = false;
                     rt_interrupted = 0;
+                    rt_thunk_unwind();
                     recover_module(ctx);
                     free(src);
                     return false;
@@ -3051,6 +3894,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
                 g_in_eval = false;
                 g_assert_jmp_ptr = NULL;
                 rt_interrupted = 0;
+                rt_thunk_unwind();
 
                 if (ran) {
                     ctx->expr_count++;
@@ -3080,86 +3924,86 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
 
             Env *env = ctx->cg.env;
             for (size_t bi = 0; bi < env->size; bi++) {
-                for (EnvEntry *e = env->buckets[bi]; e; e = e->next) {
-                    if (!e->name) continue;
-                    if (strncmp(e->name, prefix, plen) != 0) continue;
-
-                    char sig[256] = "";
-                    switch (e->kind) {
-                    case ENV_VAR:
-                        printf("%s\tvar\t%s\t%s\n",
-                               e->name,
-                               e->type ? type_to_string(e->type) : "?",
-                               e->docstring ? e->docstring : "");
-                        break;
-                    case ENV_BUILTIN: {
-                        int mn = e->arity_min > 0 ? e->arity_min : 0;
-                        int mx = e->arity_max;
-                        if (mn == 0 && mx == -1) {
-                            strcpy(sig, "Fn _");
-                        } else {
-                            strcpy(sig, "Fn (");
-                            for (int i = 0; i < mn; i++) {
-                                if (i > 0) strncat(sig, " ", sizeof(sig)-strlen(sig)-1);
-                                strncat(sig, "_", sizeof(sig)-strlen(sig)-1);
-                            }
-                            if (mx > mn && mx != -1) {
-                                strncat(sig, mn > 0 ? " =>" : "=>", sizeof(sig)-strlen(sig)-1);
-                                for (int i = mn; i < mx; i++)
-                                    strncat(sig, " _", sizeof(sig)-strlen(sig)-1);
-                            }
-                            if (mx == -1 && mn > 0)
-                                strncat(sig, " => _ . _", sizeof(sig)-strlen(sig)-1);
-                            strncat(sig, ")", sizeof(sig)-strlen(sig)-1);
-                        }
-                        printf("%s\tbuiltin\t%s\t%s\n",
-                               e->name, sig,
-                               e->docstring ? e->docstring : "");
-                        break;
-                    }
-                    case ENV_FUNC: {
-                        snprintf(sig, sizeof(sig), "(%s", e->name);
-                        for (int i = 0; i < e->param_count; i++) {
-                            const char *pn = (e->params[i].name && e->params[i].name[0])
-                                ? e->params[i].name : "_";
-                            char param[128] = "";
-                            if (e->params[i].type)
-                                snprintf(param, sizeof(param), " [%s :: %s]",
-                                         pn, type_to_string(e->params[i].type));
-                            else
-                                snprintf(param, sizeof(param), " [%s]", pn);
-                            strncat(sig, param, sizeof(sig)-strlen(sig)-1);
+                EnvEntry *e = env->slots[bi];
+                if (!e) continue;
+                if (!e->name) continue;
+                if (strncmp(e->name, prefix, plen) != 0) continue;
+
+                char sig[256] = "";
+                switch (e->kind) {
+                case ENV_VAR:
+                    printf("%s\tvar\t%s\t%s\n",
+                           e->name,
+                           e->type ? type_to_string(e->type) : "?",
+                           e->docstring ? e->docstring : "");
+                    break;
+                case ENV_BUILTIN: {
+                    int mn = e->arity_min > 0 ? e->arity_min : 0;
+                    int mx = e->arity_max;
+                    if (mn == 0 && mx == -1) {
+                        strcpy(sig, "Fn _");
+                    } else {
+                        strcpy(sig, "Fn (");
+                        for (int i = 0; i < mn; i++) {
+                            if (i > 0) strncat(sig, " ", sizeof(sig)-strlen(sig)-1);
+                            strncat(sig, "_", sizeof(sig)-strlen(sig)-1);
                         }
-                        if (e->return_type) {
-                            strncat(sig, " -> ", sizeof(sig)-strlen(sig)-1);
-                            strncat(sig, type_to_string(e->return_type),
-                                    sizeof(sig)-strlen(sig)-1);
+                        if (mx > mn && mx != -1) {
+                            strncat(sig, mn > 0 ? " =>" : "=>", sizeof(sig)-strlen(sig)-1);
+                            for (int i = mn; i < mx; i++)
+                                strncat(sig, " _", sizeof(sig)-strlen(sig)-1);
                         }
+                        if (mx == -1 && mn > 0)
+                            strncat(sig, " => _ . _", sizeof(sig)-strlen(sig)-1);
                         strncat(sig, ")", sizeof(sig)-strlen(sig)-1);
-                        {
-                            /* Escape newlines in docstring so the tab-separated
-                             * protocol stays on one line per entry */
-                            char esc_doc[2048] = {0};
-                            if (e->docstring) {
-                                int di = 0;
-                                for (const char *dp = e->docstring;
-                                     *dp && di < (int)sizeof(esc_doc) - 3; dp++) {
-                                    if (*dp == '\n') {
-                                        esc_doc[di++] = '\\';
-                                        esc_doc[di++] = 'n';
-                                    } else {
-                                        esc_doc[di++] = *dp;
-                                    }
+                    }
+                    printf("%s\tbuiltin\t%s\t%s\n",
+                           e->name, sig,
+                           e->docstring ? e->docstring : "");
+                    break;
+                }
+                case ENV_FUNC: {
+                    snprintf(sig, sizeof(sig), "(%s", e->name);
+                    for (int i = 0; i < e->param_count; i++) {
+                        const char *pn = (e->params[i].name && e->params[i].name[0])
+                            ? e->params[i].name : "_";
+                        char param[128] = "";
+                        if (e->params[i].type)
+                            snprintf(param, sizeof(param), " [%s :: %s]",
+                                     pn, type_to_string(e->params[i].type));
+                        else
+                            snprintf(param, sizeof(param), " [%s]", pn);
+                        strncat(sig, param, sizeof(sig)-strlen(sig)-1);
+                    }
+                    if (e->return_type) {
+                        strncat(sig, " -> ", sizeof(sig)-strlen(sig)-1);
+                        strncat(sig, type_to_string(e->return_type),
+                                sizeof(sig)-strlen(sig)-1);
+                    }
+                    strncat(sig, ")", sizeof(sig)-strlen(sig)-1);
+                    {
+                        /* Escape newlines in docstring so the tab-separated
+                         * protocol stays on one line per entry */
+                        char esc_doc[2048] = {0};
+                        if (e->docstring) {
+                            int di = 0;
+                            for (const char *dp = e->docstring;
+                                 *dp && di < (int)sizeof(esc_doc) - 3; dp++) {
+                                if (*dp == '\n') {
+                                    esc_doc[di++] = '\\';
+                                    esc_doc[di++] = 'n';
+                                } else {
+                                    esc_doc[di++] = *dp;
                                 }
                             }
-                            printf("%s\tfunc\t%s\t%s\t%s\n",
-                                   e->name, sig,
-                                   esc_doc,
-                                   e->header_path ? e->header_path : "");
                         }
-                        break;
-                    }
+                        printf("%s\tfunc\t%s\t%s\t%s\n",
+                               e->name, sig,
+                               esc_doc,
+                               e->header_path ? e->header_path : "");
                     }
+                    break;
+                }
                 }
             }
 
@@ -3304,6 +4148,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
                 ran = close_and_run(ctx);
             g_in_eval = false;
             rt_interrupted = 0;
+            rt_thunk_unwind();
 
             if (ran) ctx->expr_count++;
             char next[64];
@@ -3313,6 +4158,19 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
         }
     }
 
+    /* -----------------------------------------------------------------------
+     * Fast path: scalar expression on the bytecode VM
+     * ----------------------------------------------------------------------- */
+    bool inferred = false;
+    bool is_define = ast->type == AST_LIST && ast->list.count >= 1 &&
+                     ast->list.items[0]->type == AST_SYMBOL &&
+                     strcmp(ast->list.items[0]->symbol, "define") == 0;
+    if (!is_define && ast->type != AST_LAYOUT &&
+        repl_bytecode_eval(ctx, ast, silent, &inferred)) {
+        ast_free(ast);
+        return true;
+    }
+
     /* -----------------------------------------------------------------------
      * Normal path: codegen + JIT
      * ----------------------------------------------------------------------- */
@@ -3352,7 +4210,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
     /* Run HM type inference — annotates ast->inferred_type on every node.
      * This is non-fatal: if inference fails we emit a warning but still
      * proceed with codegen so the REPL stays usable during development.  */
-    if (ast) {
+    if (ast && !inferred) {
         repl_infer(ctx, ast);
         /* NOTE: we continue even on inference failure — codegen has its own
          * type propagation and can often still produce correct code.
@@ -3455,6 +4313,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
         g_assert_jmp_ptr = NULL;
         g_in_eval = false;
         rt_interrupted = 0;
+        rt_thunk_unwind();
         recover_module(ctx);
         return false;
     }
@@ -3463,6 +4322,7 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
     g_in_eval = false;
     g_assert_jmp_ptr = NULL;
     rt_interrupted = 0;
+    rt_thunk_unwind();
 
     if (ran) {
         ctx->expr_count++;
@@ -3487,19 +4347,13 @@ bool repl_eval_line(REPLContext *ctx, const char *line) {
 /* -------------------------------------------------------------------------
  * repl_completion_generator — readline tab-completion.
  *
- * FIX: The original state machine advanced `cur = cur->next` at the TOP of
- * the function, before the entry was checked.  This caused two bugs:
- *   1. The very first entry in each bucket was skipped (cur started NULL,
- *      was set to buckets[bi] inside the inner loop, then immediately
- *      advanced past it on the next call).
- *   2. When an imported symbol had a NULL or short name, strncmp crashed.
- *
- * New approach: initialize cur = buckets[0] on reset, advance AFTER match,
- * null-check e->name before comparing.
+ * `bi` is the next env slot to examine; it is advanced past an entry
+ * before that entry is returned, so the next call resumes after it.
+ * Entries with a NULL name (imported placeholders) are skipped rather
+ * than passed to strncmp.
  * ------------------------------------------------------------------------- */
 char *repl_completion_generator(const char *text, int state) {
     static size_t    bi;
-    static EnvEntry *cur;
     static size_t    len;
     static int       ki;
 
@@ -3518,23 +4372,16 @@ char *repl_completion_generator(const char *text, int state) {
 
     if (!state) {
         bi  = 0;
-        cur = env->buckets[0];   /* FIX: start at first bucket entry */
         len = strlen(text);
         ki  = 0;
     }
 
     /* Walk env hash table */
     while (bi < env->size) {
-        while (cur) {
-            EnvEntry *e = cur;
-            cur = cur->next;     /* advance BEFORE returning so next call is safe */
-            if (!e->name) continue;  /* FIX: null-check */
-            if (strncmp(e->name, text, len) == 0)
-                return strdup(e->name);
-        }
-        /* Move to next bucket */
-        bi++;
-        cur = (bi < env->size) ? env->buckets[bi] : NULL;
+        EnvEntry *e = env->slots[bi++];
+        if (!e || !e->name) continue;
+        if (strncmp(e->name, text, len) == 0)
+            return strdup(e->name);
     }
 
     /* Walk static keyword list */
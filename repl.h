@@ -13,6 +13,8 @@ typedef struct {
     LLVMOrcLLJITRef        jit;         // persistent ORC LLJIT across expressions
     LLVMOrcJITDylibRef     jd;          // main JITDylib owned by jit
     LLVMOrcThreadSafeContextRef tsc;    // owns the LLVM context used by modules
+    LLVMOrcLazyCallThroughManagerRef lctm; // lazy function bodies; NULL = eager
+    LLVMOrcIndirectStubsManagerRef   ism;  // call-through stubs for lctm
     CodegenContext         cg;          // module/builder replaced per expr
     unsigned int           expr_count;
     InferEnv              *infer_env;   // persistent HM type environment
@@ -33,5 +35,7 @@ char  *repl_completion_generator(const char *text, int state);
  */
 bool repl_compile_module(CodegenContext *ctx, ImportDecl *imp);
 const char **repl_get_compiled_obj_paths(void);
+/* Content hash of the running compiler binary, computed once (main.c). */
+const char *compiler_identity_hash(void);
 
 #endif
@@ -1,12 +1,650 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <setjmp.h>
+#include <time.h>
 #include "arena.h"
 #include "runtime.h"
 
-static inline ConsCell     *heap_cons_cell(void)    { return malloc(sizeof(ConsCell));     }
-static inline RuntimeList  *heap_list_wrapper(void) { return malloc(sizeof(RuntimeList));  }
-static inline RuntimeValue *heap_value(void)        { return malloc(sizeof(RuntimeValue)); }
+///  Size-classed slab allocator
+//
+//  Long-lived fixed-size runtime objects (RuntimeValue, ConsCell,
+//  RuntimeList, RuntimeClosure, range/map/filter env records) come from
+//  thread-local pools, one per RT_SLAB_GRANULE size class up to
+//  RT_SLAB_MAX bytes.  Each pool carves objects out of its own arena blocks
+//  and recycles released objects through a free list (see ArenaPool).
+//
+//  Unlike g_eval_arena the pools are never reset, so these objects outlive
+//  REPL expressions exactly like the malloc'd objects they replace.  Pool
+//  blocks are never handed back to the OS either, which is what makes it
+//  safe for a value allocated on one thread to be released on another: it
+//  simply joins the releasing thread's free list.
+//
+//  Requests larger than RT_SLAB_MAX go straight to malloc.  While the
+//  collector below is running they get a tracking header instead.
+//
+//  Environment:
+//    MONAD_ALLOC=malloc    route every request through malloc (baseline)
+//    MONAD_ALLOC_STATS=1   print allocation counters to stderr at exit
+//
+#if defined(_MSC_VER)
+#define RT_THREAD_LOCAL __declspec(thread)
+#else
+#define RT_THREAD_LOCAL __thread
+#endif
+
+#define RT_SLAB_GRANULE 8
+#define RT_SLAB_CLASSES RT_ALLOC_CLASS_COUNT
+#define RT_SLAB_MAX     (RT_SLAB_CLASSES * RT_SLAB_GRANULE)
+#define RT_SLAB_BLOCK   (256u * 1024u)
+
+enum { RT_ALLOC_MODE_UNSET = -1, RT_ALLOC_MODE_SLAB = 0, RT_ALLOC_MODE_MALLOC = 1 };
+
+static int g_rt_alloc_mode = RT_ALLOC_MODE_UNSET;
+
+static RT_THREAD_LOCAL ArenaPool g_rt_slabs[RT_SLAB_CLASSES];
+static RT_THREAD_LOCAL int       g_rt_slabs_ready;
+static RT_THREAD_LOCAL size_t    g_rt_large_allocs;   // > RT_SLAB_MAX, malloc'd
+static RT_THREAD_LOCAL size_t    g_rt_malloc_allocs;  // MONAD_ALLOC=malloc
+static RT_THREAD_LOCAL size_t    g_rt_malloc_frees;
+
+// Collector hooks (see "Tracing garbage collector" below).
+static int                       g_rt_gc_enabled;
+static RT_THREAD_LOCAL int       g_rt_gc_mutator;     // thread that owns the GC heap
+static void *gc_alloc(size_t size);
+static int   gc_free_large(void *p);
+
+static void rt_alloc_report_at_exit(void) {
+    rt_alloc_print_stats("exit");
+}
+
+static int rt_alloc_mode(void) {
+    if (g_rt_alloc_mode == RT_ALLOC_MODE_UNSET) {
+        const char *mode  = getenv("MONAD_ALLOC");
+        const char *stats = getenv("MONAD_ALLOC_STATS");
+        g_rt_alloc_mode = (mode && strcmp(mode, "malloc") == 0)
+            ? RT_ALLOC_MODE_MALLOC : RT_ALLOC_MODE_SLAB;
+        if (stats && *stats && strcmp(stats, "0") != 0)
+            atexit(rt_alloc_report_at_exit);
+    }
+    return g_rt_alloc_mode;
+}
+
+static void rt_slabs_init(void) {
+    for (size_t i = 0; i < RT_SLAB_CLASSES; i++)
+        arena_pool_init(&g_rt_slabs[i], (i + 1) * RT_SLAB_GRANULE, RT_SLAB_BLOCK);
+    g_rt_slabs_ready = 1;
+}
+
+static inline size_t rt_slab_class(size_t size) {
+    return (size + RT_SLAB_GRANULE - 1) / RT_SLAB_GRANULE - 1;
+}
+
+void *rt_alloc(size_t size) {
+    if (size == 0) size = 1;
+    if (g_rt_prof_alloc) rt_prof_note_alloc(size);
+    if (rt_alloc_mode() == RT_ALLOC_MODE_MALLOC) {
+        g_rt_malloc_allocs++;
+        return malloc(size);
+    }
+    if (g_rt_gc_enabled && g_rt_gc_mutator) return gc_alloc(size);
+    if (size > RT_SLAB_MAX) {
+        g_rt_large_allocs++;
+        return malloc(size);
+    }
+    if (!g_rt_slabs_ready) rt_slabs_init();
+    return arena_pool_alloc(&g_rt_slabs[rt_slab_class(size)]);
+}
+
+void rt_free_sized(void *p, size_t size) {
+    if (!p) return;
+    if (size == 0) size = 1;
+    if (rt_alloc_mode() == RT_ALLOC_MODE_MALLOC) {
+        g_rt_malloc_frees++;
+        free(p);
+        return;
+    }
+    if (size > RT_SLAB_MAX) {
+        if (!(g_rt_gc_enabled && gc_free_large(p))) free(p);
+        return;
+    }
+    if (!g_rt_slabs_ready) rt_slabs_init();
+    arena_pool_release(&g_rt_slabs[rt_slab_class(size)], p);
+}
+
+void rt_alloc_stats(RuntimeAllocStats *out) {
+    memset(out, 0, sizeof(*out));
+    out->malloc_mode = rt_alloc_mode() == RT_ALLOC_MODE_MALLOC;
+    out->large       = g_rt_large_allocs;
+    if (out->malloc_mode) {
+        out->allocs   = g_rt_malloc_allocs;
+        out->releases = g_rt_malloc_frees;
+        return;
+    }
+    if (!g_rt_slabs_ready) return;
+    for (size_t i = 0; i < RT_SLAB_CLASSES; i++) {
+        ArenaPool *p = &g_rt_slabs[i];
+        out->class_allocs[i] = p->allocs;
+        out->allocs         += p->allocs;
+        out->releases       += p->releases;
+        out->reused         += p->reused;
+        out->reserved_bytes += p->arena.total_allocated;
+        out->used_bytes     += p->arena.total_used;
+    }
+}
+
+void rt_alloc_print_stats(const char *label) {
+    RuntimeAllocStats st;
+    rt_alloc_stats(&st);
+    if (st.malloc_mode) {
+        fprintf(stderr, "[alloc] %s: malloc baseline, %zu alloc(s), %zu free(s)\n",
+                label ? label : "?", st.allocs, st.releases);
+        return;
+    }
+    fprintf(stderr,
+            "[alloc] %s: %zu alloc(s), %zu release(s), %zu reused, %zu large, "
+            "%zu KiB reserved, %zu KiB used\n",
+            label ? label : "?", st.allocs, st.releases, st.reused, st.large,
+            st.reserved_bytes / 1024, st.used_bytes / 1024);
+    for (size_t i = 0; i < RT_SLAB_CLASSES; i++) {
+        if (!st.class_allocs[i]) continue;
+        fprintf(stderr, "[alloc]   %3zu B: %zu\n",
+                (i + 1) * (size_t)RT_SLAB_GRANULE, st.class_allocs[i]);
+    }
+}
+
+///  Tracing garbage collector
+//
+//  Opt-in (MONAD_GC=1) non-moving mark-sweep collector for compiled
+//  programs.  Generated main() calls rt_gc_init() with its frame address;
+//  the REPL and the compiler never do, so their heaps keep the explicit
+//  lifetime rules used everywhere else in this file.
+//
+//  The GC heap is everything rt_alloc hands out on the mutator thread once
+//  the collector is on: slab slots plus large objects, which then carry an
+//  RtGcLarge header.  While it is on, the g_eval_arena paths (values,
+//  thunks, cons cells) go through rt_alloc too, as do the buffers that hold
+//  RuntimeValue pointers: closure and lazy-tail envs, ADT payloads, args
+//  arrays, map/set buckets, array elements, and GMP limbs.
+//
+//  Roots are found conservatively: the stack from the collecting frame up
+//  to the base passed to rt_gc_init (callee-saved registers are spilled
+//  onto it first) and the executable's .data/.bss.  Any aligned word that
+//  points into an allocated object — interior pointers included — keeps
+//  it alive, and objects are scanned the same way, so no per-type layout
+//  tables are needed.
+//
+//  Collections are triggered from rt_alloc once MONAD_GC_NURSERY bytes
+//  (default 8 MiB) have been allocated since the previous one, or the live
+//  heap size if that is larger.  The small budget recycles short-lived
+//  cons cells and boxed ints while their slots are still cache-warm; the
+//  live-size floor keeps big steady-state heaps from being re-marked on
+//  every budget tick.  Freed slab slots rejoin their pool's free list and
+//  large objects go back to malloc.
+//
+//  Limitations: one mutator thread, the one that called rt_gc_init.  Only
+//  its allocations enter the GC heap and only its stack is scanned, so
+//  rt_pool_for runs bodies inline while the collector is on, and fibers
+//  (which share that thread) have their stacks scanned as roots.  Threads
+//  a program starts itself must not hold the only reference to a runtime
+//  value.  Pointers kept only in memory the runtime cannot see (malloc'd C
+//  buffers, FFI libraries) are not roots; string payloads stay malloc'd and
+//  are not reclaimed.
+//
+//  Environment:
+//    MONAD_GC=1            enable the collector (Linux, compiled programs)
+//    MONAD_GC_NURSERY=N    bytes between collections, K/M suffix accepted
+//    MONAD_GC_STATS=1      pause/heap summary at exit; 2 = every collection
+//
+#if defined(__linux__) && defined(__GNUC__)
+#define RT_GC_SUPPORTED 1
+extern char __data_start[] __attribute__((weak));
+extern char _end[]         __attribute__((weak));
+#else
+#define RT_GC_SUPPORTED 0
+#endif
+
+#define RT_GC_DEFAULT_NURSERY (8u * 1024u * 1024u)
+#define RT_GC_LARGE_MAGIC     ((size_t)0x6d6f6e6164474300ull)  // "monadGC\0"
+
+enum { RT_GC_MARK = 1, RT_GC_FREE = 2 };
+
+typedef struct RtGcLarge {
+    struct RtGcLarge *prev;
+    struct RtGcLarge *next;
+    size_t            size;
+    size_t            tag;       // RT_GC_LARGE_MAGIC | RT_GC_MARK
+} RtGcLarge;
+
+typedef struct {
+    char    *lo;                 // first slot
+    char    *hi;                 // one past the last carved slot
+    size_t   obj_size;
+    size_t   cls;
+    uint8_t *bits;               // RT_GC_MARK / RT_GC_FREE per slot
+} RtGcSpan;
+
+static struct {
+    int         collecting;
+    int         stats_level;
+    char       *stack_base;
+    size_t      nursery;
+    size_t      budget;
+    size_t      allocated;       // bytes since the last collection
+    RtGcLarge  *large;
+    size_t      large_count;
+    size_t      large_bytes;
+    size_t      collections;
+    size_t      freed_objects;
+    size_t      freed_bytes;
+    size_t      live_bytes;
+    double      total_pause_ms;
+    double      max_pause_ms;
+    // Scratch, rebuilt by every collection.
+    RtGcSpan   *spans;
+    size_t      span_count, span_cap;
+    RtGcLarge **larges;
+    size_t      larges_cap;
+    uintptr_t   heap_lo, heap_hi;
+    char      **work;            // mark stack of (object, size) pairs
+    size_t      work_len, work_cap;
+} g_rt_gc;
+
+
+static void *gc_xrealloc(void *p, size_t size) {
+    void *q = realloc(p, size);
+    if (!q) {
+        fprintf(stderr, "gc: out of memory requesting %zu bytes\n", size);
+        abort();
+    }
+    return q;
+}
+
+static void *gc_alloc_large(size_t size) {
+    RtGcLarge *l = malloc(sizeof(RtGcLarge) + size);
+    if (!l) {
+        fprintf(stderr, "gc: out of memory requesting %zu bytes\n", size);
+        abort();
+    }
+    l->size = size;
+    l->tag  = RT_GC_LARGE_MAGIC;
+    l->prev = NULL;
+    l->next = g_rt_gc.large;
+    if (l->next) l->next->prev = l;
+    g_rt_gc.large = l;
+    g_rt_gc.large_count++;
+    g_rt_gc.large_bytes += size;
+    return l + 1;
+}
+
+static void gc_unlink_large(RtGcLarge *l) {
+    if (l->prev) l->prev->next = l->next;
+    else         g_rt_gc.large = l->next;
+    if (l->next) l->next->prev = l->prev;
+    g_rt_gc.large_count--;
+    g_rt_gc.large_bytes -= l->size;
+    free(l);
+}
+
+// Returns 1 if p was a tracked large object (and is now freed), 0 if it
+// was malloc'd before the collector started or on another thread.
+static int gc_free_large(void *p) {
+    RtGcLarge *l = (RtGcLarge *)p - 1;
+    if ((l->tag & ~(size_t)RT_GC_MARK) != RT_GC_LARGE_MAGIC) return 0;
+    gc_unlink_large(l);
+    return 1;
+}
+
+static void *gc_alloc(size_t size) {
+    if (g_rt_gc.allocated >= g_rt_gc.budget) rt_gc_collect();
+    g_rt_gc.allocated += size;
+    if (size > RT_SLAB_MAX) {
+        g_rt_large_allocs++;
+        return gc_alloc_large(size);
+    }
+    if (!g_rt_slabs_ready) rt_slabs_init();
+    return arena_pool_alloc(&g_rt_slabs[rt_slab_class(size)]);
+}
+
+// GMP limbs live in the GC heap so a dead bignum takes them with it.
+//
+// GMP frees and reallocates limbs with whatever functions are installed at
+// that moment, so the hooks must be in place before the first mpz_init:
+// installed later, they would hand malloc'd limbs to rt_free_sized.  When
+// MONAD_GC asks for the collector they are installed at load time (the
+// hooks go through rt_alloc, so limbs from before rt_gc_init are slab or
+// plain malloc blocks that rt_free_sized already knows how to release).
+// Without constructor support the limbs stay on malloc and are not
+// collected.
+
+static void *gc_gmp_alloc(size_t size) { return rt_alloc(size); }
+
+static void *gc_gmp_realloc(void *p, size_t old_size, size_t new_size) {
+    void *q = rt_alloc(new_size);
+    memcpy(q, p, old_size < new_size ? old_size : new_size);
+    rt_free_sized(p, old_size);
+    return q;
+}
+
+static void gc_gmp_free(void *p, size_t size) { rt_free_sized(p, size); }
+
+#if RT_GC_SUPPORTED
+__attribute__((constructor(101)))
+static void gc_gmp_hook_early(void) {
+    const char *on = getenv("MONAD_GC");
+    if (!on || !*on || strcmp(on, "0") == 0) return;
+    mp_set_memory_functions(gc_gmp_alloc, gc_gmp_realloc, gc_gmp_free);
+}
+#endif
+
+static size_t gc_parse_size(const char *s, size_t fallback) {
+    if (!s || !*s) return fallback;
+    char *end = NULL;
+    unsigned long long n = strtoull(s, &end, 10);
+    if (end && (*end == 'k' || *end == 'K')) n *= 1024ull;
+    if (end && (*end == 'm' || *end == 'M')) n *= 1024ull * 1024ull;
+    return n ? (size_t)n : fallback;
+}
+
+static void rt_gc_report_at_exit(void) {
+    rt_gc_print_stats("exit");
+}
+
+void rt_gc_init(void *stack_base) {
+    const char *on = getenv("MONAD_GC");
+    if (g_rt_gc_enabled || !on || !*on || strcmp(on, "0") == 0) return;
+    if (!RT_GC_SUPPORTED || !stack_base ||
+        rt_alloc_mode() == RT_ALLOC_MODE_MALLOC) {
+        fprintf(stderr, "[gc] collector unavailable here; running without it\n");
+        return;
+    }
+    const char *stats = getenv("MONAD_GC_STATS");
+    g_rt_gc.stats_level = stats && *stats ? atoi(stats) : 0;
+    g_rt_gc.nursery     = gc_parse_size(getenv("MONAD_GC_NURSERY"),
+                                        RT_GC_DEFAULT_NURSERY);
+    g_rt_gc.budget      = g_rt_gc.nursery;
+    g_rt_gc.stack_base  = stack_base;
+    if (!g_rt_slabs_ready) rt_slabs_init();
+    g_rt_gc_mutator = 1;
+    g_rt_gc_enabled = 1;
+    if (g_rt_gc.stats_level > 0) atexit(rt_gc_report_at_exit);
+}
+
+int rt_gc_enabled(void) {
+    return g_rt_gc_enabled;
+}
+
+//  Mark phase
+
+static void gc_add_span(char *lo, char *hi, size_t obj_size, size_t cls) {
+    if (g_rt_gc.span_count == g_rt_gc.span_cap) {
+        g_rt_gc.span_cap = g_rt_gc.span_cap ? g_rt_gc.span_cap * 2 : 64;
+        g_rt_gc.spans    = gc_xrealloc(g_rt_gc.spans,
+                                       g_rt_gc.span_cap * sizeof(RtGcSpan));
+    }
+    RtGcSpan *s = &g_rt_gc.spans[g_rt_gc.span_count++];
+    s->lo       = lo;
+    s->hi       = hi;
+    s->obj_size = obj_size;
+    s->cls      = cls;
+    s->bits     = NULL;
+}
+
+static int gc_span_cmp(const void *a, const void *b) {
+    const RtGcSpan *x = a, *y = b;
+    return x->lo < y->lo ? -1 : x->lo > y->lo;
+}
+
+static int gc_large_cmp(const void *a, const void *b) {
+    const RtGcLarge *x = *(RtGcLarge *const *)a, *y = *(RtGcLarge *const *)b;
+    return x < y ? -1 : x > y;
+}
+
+static RtGcSpan *gc_find_span(uintptr_t w) {
+    size_t lo = 0, hi = g_rt_gc.span_count;
+    while (lo < hi) {
+        size_t    mid = lo + (hi - lo) / 2;
+        RtGcSpan *s   = &g_rt_gc.spans[mid];
+        if (w < (uintptr_t)s->lo)       hi = mid;
+        else if (w >= (uintptr_t)s->hi) lo = mid + 1;
+        else                            return s;
+    }
+    return NULL;
+}
+
+static RtGcLarge *gc_find_large(uintptr_t w) {
+    size_t lo = 0, hi = g_rt_gc.large_count;
+    while (lo < hi) {
+        size_t     mid  = lo + (hi - lo) / 2;
+        RtGcLarge *l    = g_rt_gc.larges[mid];
+        uintptr_t  base = (uintptr_t)(l + 1);
+        if (w < base)                 hi = mid;
+        else if (w >= base + l->size) lo = mid + 1;
+        else                          return l;
+    }
+    return NULL;
+}
+
+static void gc_build_heap_map(void) {
+    g_rt_gc.span_count = 0;
+    for (size_t c = 0; c < RT_SLAB_CLASSES; c++) {
+        ArenaPool *p = &g_rt_slabs[c];
+        for (ArenaBlock *b = p->arena.current; b; b = b->next) {
+            size_t slots = b->used / p->obj_size;
+            if (slots) gc_add_span(b->base, b->base + slots * p->obj_size,
+                                   p->obj_size, c);
+        }
+    }
+    qsort(g_rt_gc.spans, g_rt_gc.span_count, sizeof(RtGcSpan), gc_span_cmp);
+    for (size_t i = 0; i < g_rt_gc.span_count; i++) {
+        RtGcSpan *s = &g_rt_gc.spans[i];
+        s->bits = calloc((size_t)(s->hi - s->lo) / s->obj_size, 1);
+        if (!s->bits) { fprintf(stderr, "gc: out of memory\n"); abort(); }
+    }
+
+    // Slots on a free list must neither be marked nor swept again.
+    for (size_t c = 0; c < RT_SLAB_CLASSES; c++) {
+        for (ArenaPoolFree *f = g_rt_slabs[c].free_list; f; f = f->next) {
+            RtGcSpan *s = gc_find_span((uintptr_t)f);
+            if (s) s->bits[((char *)f - s->lo) / s->obj_size] = RT_GC_FREE;
+        }
+    }
+
+    if (g_rt_gc.large_count > g_rt_gc.larges_cap) {
+        g_rt_gc.larges_cap = g_rt_gc.large_count * 2;
+        g_rt_gc.larges     = gc_xrealloc(g_rt_gc.larges,
+                                         g_rt_gc.larges_cap * sizeof(RtGcLarge *));
+    }
+    size_t n = 0;
+    for (RtGcLarge *l = g_rt_gc.large; l; l = l->next) g_rt_gc.larges[n++] = l;
+    qsort(g_rt_gc.larges, n, sizeof(RtGcLarge *), gc_large_cmp);
+
+    g_rt_gc.heap_lo = UINTPTR_MAX;
+    g_rt_gc.heap_hi = 0;
+    if (g_rt_gc.span_count) {
+        g_rt_gc.heap_lo = (uintptr_t)g_rt_gc.spans[0].lo;
+        g_rt_gc.heap_hi = (uintptr_t)g_rt_gc.spans[g_rt_gc.span_count - 1].hi;
+    }
+    if (n) {
+        uintptr_t lo = (uintptr_t)(g_rt_gc.larges[0] + 1);
+        uintptr_t hi = (uintptr_t)(g_rt_gc.larges[n - 1] + 1) + g_rt_gc.larges[n - 1]->size;
+        if (lo < g_rt_gc.heap_lo) g_rt_gc.heap_lo = lo;
+        if (hi > g_rt_gc.heap_hi) g_rt_gc.heap_hi = hi;
+    }
+}
+
+static void gc_push(char *obj, size_t size) {
+    if (g_rt_gc.work_len + 2 > g_rt_gc.work_cap) {
+        g_rt_gc.work_cap = g_rt_gc.work_cap ? g_rt_gc.work_cap * 2 : 1024;
+        g_rt_gc.work     = gc_xrealloc(g_rt_gc.work,
+                                       g_rt_gc.work_cap * sizeof(char *));
+    }
+    g_rt_gc.work[g_rt_gc.work_len++] = obj;
+    g_rt_gc.work[g_rt_gc.work_len++] = (char *)(uintptr_t)size;
+}
+
+static inline void gc_mark_word(uintptr_t w) {
+    if (w < g_rt_gc.heap_lo || w >= g_rt_gc.heap_hi) return;
+    RtGcSpan *s = gc_find_span(w);
+    if (s) {
+        size_t   idx  = (w - (uintptr_t)s->lo) / s->obj_size;
+        uint8_t *bits = &s->bits[idx];
+        if (*bits) return;                      // already marked, or free
+        *bits = RT_GC_MARK;
+        gc_push(s->lo + idx * s->obj_size, s->obj_size);
+        return;
+    }
+    RtGcLarge *l = gc_find_large(w);
+    if (l && !(l->tag & RT_GC_MARK)) {
+        l->tag |= RT_GC_MARK;
+        gc_push((char *)(l + 1), l->size);
+    }
+}
+
+// Conservative scanning reads whole stack frames and .bss, redzones
+// included, so it is exempt from AddressSanitizer.
+static __attribute__((no_sanitize_address))
+void gc_scan_range(const char *lo, const char *hi) {
+    const uintptr_t align = sizeof(void *);
+    uintptr_t p = ((uintptr_t)lo + align - 1) & ~(align - 1);
+    for (; p + align <= (uintptr_t)hi; p += align) {
+        gc_mark_word(*(const uintptr_t *)p);
+    }
+}
+
+static void gc_drain(void) {
+    while (g_rt_gc.work_len) {
+        size_t size = (size_t)(uintptr_t)g_rt_gc.work[--g_rt_gc.work_len];
+        char  *obj  = g_rt_gc.work[--g_rt_gc.work_len];
+        gc_scan_range(obj, obj + size);
+    }
+}
+
+static int fiber_gc_scan(const char *top);
+
+static __attribute__((noinline)) void gc_scan_stack(void) {
+    volatile char top = 0;
+    if (fiber_gc_scan((const char *)&top)) return;
+    gc_scan_range((const char *)&top, g_rt_gc.stack_base);
+}
+
+static __attribute__((noinline)) void gc_mark_roots(void) {
+    // Spill callee-saved registers into this frame, which gc_scan_stack
+    // then covers because it runs below it.
+    jmp_buf regs;
+    __builtin_unwind_init();
+    if (setjmp(regs) == 0) gc_scan_stack();
+    gc_drain();
+
+#if RT_GC_SUPPORTED
+    if (__data_start && _end)
+        gc_scan_range(__data_start, _end);
+#endif
+    gc_drain();
+}
+
+//  Sweep phase
+
+static size_t gc_sweep(size_t *freed_bytes) {
+    size_t freed = 0, live = 0;
+    for (size_t i = 0; i < g_rt_gc.span_count; i++) {
+        RtGcSpan  *s     = &g_rt_gc.spans[i];
+        ArenaPool *p     = &g_rt_slabs[s->cls];
+        size_t     slots = (size_t)(s->hi - s->lo) / s->obj_size;
+        for (size_t k = 0; k < slots; k++) {
+            if (s->bits[k] == RT_GC_MARK) { live += s->obj_size; continue; }
+            if (s->bits[k] == RT_GC_FREE) continue;
+            arena_pool_release(p, s->lo + k * s->obj_size);
+            freed++;
+            *freed_bytes += s->obj_size;
+        }
+        free(s->bits);
+        s->bits = NULL;
+    }
+    for (RtGcLarge *l = g_rt_gc.large, *next; l; l = next) {
+        next = l->next;
+        if (l->tag & RT_GC_MARK) {
+            l->tag &= ~(size_t)RT_GC_MARK;
+            live += l->size;
+            continue;
+        }
+        freed++;
+        *freed_bytes += l->size;
+        gc_unlink_large(l);
+    }
+    g_rt_gc.live_bytes = live;
+    return freed;
+}
+
+void rt_gc_collect(void) {
+    if (!g_rt_gc_enabled || !g_rt_gc_mutator || g_rt_gc.collecting) return;
+    g_rt_gc.collecting = 1;
+    clock_t start = clock();
+
+    gc_build_heap_map();
+    gc_mark_roots();
+    size_t freed_bytes = 0;
+    size_t freed       = gc_sweep(&freed_bytes);
+
+    double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    g_rt_gc.collections++;
+    g_rt_gc.freed_objects  += freed;
+    g_rt_gc.freed_bytes    += freed_bytes;
+    g_rt_gc.total_pause_ms += ms;
+    if (ms > g_rt_gc.max_pause_ms) g_rt_gc.max_pause_ms = ms;
+    g_rt_gc.allocated = 0;
+    g_rt_gc.budget    = g_rt_gc.live_bytes > g_rt_gc.nursery
+                      ? g_rt_gc.live_bytes : g_rt_gc.nursery;
+    g_rt_gc.collecting = 0;
+
+    if (g_rt_gc.stats_level > 1)
+        fprintf(stderr, "[gc] #%zu: freed %zu object(s) (%zu KiB), live %zu KiB, "
+                "pause %.3f ms\n", g_rt_gc.collections, freed,
+                freed_bytes / 1024, g_rt_gc.live_bytes / 1024, ms);
+}
+
+void rt_gc_stats(RuntimeGCStats *out) {
+    memset(out, 0, sizeof(*out));
+    out->enabled        = g_rt_gc_enabled;
+    out->collections    = g_rt_gc.collections;
+    out->freed_objects  = g_rt_gc.freed_objects;
+    out->freed_bytes    = g_rt_gc.freed_bytes;
+    out->live_bytes     = g_rt_gc.live_bytes;
+    out->large_bytes    = g_rt_gc.large_bytes;
+    out->total_pause_ms = g_rt_gc.total_pause_ms;
+    out->max_pause_ms   = g_rt_gc.max_pause_ms;
+    if (g_rt_slabs_ready) {
+        for (size_t i = 0; i < RT_SLAB_CLASSES; i++)
+            out->heap_bytes += g_rt_slabs[i].arena.total_allocated;
+    }
+    out->heap_bytes += g_rt_gc.large_bytes;
+}
+
+void rt_gc_print_stats(const char *label) {
+    RuntimeGCStats st;
+    rt_gc_stats(&st);
+    if (!st.enabled) {
+        fprintf(stderr, "[gc] %s: collector off\n", label ? label : "?");
+        return;
+    }
+    fprintf(stderr,
+            "[gc] %s: %zu collection(s), pause %.3f ms total, %.3f ms max, "
+            "heap %zu KiB, live %zu KiB, freed %zu object(s) (%zu KiB)\n",
+            label ? label : "?", st.collections, st.total_pause_ms,
+            st.max_pause_ms, st.heap_bytes / 1024, st.live_bytes / 1024,
+            st.freed_objects, st.freed_bytes / 1024);
+}
+
+static inline ConsCell     *heap_cons_cell(void)    { return rt_alloc(sizeof(ConsCell));     }
+static inline RuntimeList  *heap_list_wrapper(void) { return rt_alloc(sizeof(RuntimeList));  }
+static inline RuntimeValue *heap_value(void)        { return rt_alloc(sizeof(RuntimeValue)); }
+
+// calloc for buffers of runtime pointers, so the collector can trace them.
+static void *rt_alloc_zeroed(size_t size) {
+    void *p = rt_alloc(size);
+    memset(p, 0, size ? size : 1);
+    return p;
+}
 
 
 volatile int rt_interrupted = 0;
@@ -51,27 +689,13 @@ void *__layout_ptr_get(const char *name) {
 //
 Arena g_eval_arena;
 
-///  Step 2 — Integer interning cache
+///  Step 2 — Immediate scalars
 //
-//  For the extremely common case of small integers (0..INT_CACHE_MAX inclusive)
-//  we return a pointer into a static array that is initialised once.
-//  rt_value_int() for these values does zero allocations.
+//  Ints, floats, chars and nil are encoded in the pointer word itself (see
+//  "Immediate values" in runtime.h).  rt_value_int() and friends allocate
+//  nothing, except for ints beyond +-2^49, which are boxed as before.  This
+//  replaces the old 0..65536 interning table.
 //
-#define INT_CACHE_MIN 0
-#define INT_CACHE_MAX 65536
-#define INT_CACHE_SIZE (INT_CACHE_MAX - INT_CACHE_MIN + 1)
-
-static RuntimeValue  g_int_cache_storage[INT_CACHE_SIZE];
-static int           g_int_cache_ready = 0;
-
-static void int_cache_init(void) {
-    if (g_int_cache_ready) return;
-    for (int i = 0; i < INT_CACHE_SIZE; i++) {
-        g_int_cache_storage[i].type         = RT_INT;
-        g_int_cache_storage[i].data.int_val = (int64_t)(i + INT_CACHE_MIN);
-    }
-    g_int_cache_ready = 1;
-}
 
 ///  Step 3 — Fused ConsCell
 //
@@ -97,100 +721,248 @@ static RuntimeList _empty_list_val = { NULL };
 static RuntimeList *_empty_list    = &_empty_list_val;
 
 ///  Internal allocation helpers
+//
+//  A compiled program never resets g_eval_arena, so with the collector on
+//  these come from the GC heap instead.  g_eval_arena belongs to the main
+//  thread; work-stealing pool workers use their own slab pools.
+
+static RT_THREAD_LOCAL int g_rt_pool_worker;   // set on pool worker threads
+
+static inline void *eval_alloc(size_t size) {
+    if (g_rt_gc_enabled || g_rt_pool_worker) return rt_alloc(size);
+    if (g_rt_prof_alloc) rt_prof_note_alloc(size);
+    return arena_alloc(&g_eval_arena, size);
+}
 
 static inline ConsCell *alloc_cons_cell(void) {
-    return arena_alloc(&g_eval_arena, sizeof(ConsCell));
+    return eval_alloc(sizeof(ConsCell));
 }
 
 static inline RuntimeList *alloc_list_wrapper(void) {
-    return arena_alloc(&g_eval_arena, sizeof(RuntimeList));
+    return eval_alloc(sizeof(RuntimeList));
 }
 
 static inline RuntimeValue *alloc_value(void) {
-    return arena_alloc(&g_eval_arena, sizeof(RuntimeValue));
+    return eval_alloc(sizeof(RuntimeValue));
 }
 
 /// Closure
 
-RuntimeValue *rt_value_closure(void *fn_ptr, void **env, int env_size, int arity) {
-    RuntimeClosure *c = malloc(sizeof(RuntimeClosure));
+RuntimeValue *rt_value_closure_init(void *mem, void *fn_ptr, void *direct, void **env,
+                                    int env_size, int arity, const char *name) {
+    if (!env) env_size = 0;
+    RuntimeValue   *v = mem;
+    RuntimeClosure *c = (RuntimeClosure *)((char *)v + RT_CLOSURE_OFFSET);
     c->fn_ptr   = fn_ptr;
+    c->direct   = direct;
     c->env_size = env_size;
     c->arity    = arity;
-    c->name     = NULL;
-    if (env_size > 0 && env) {
-        c->env = malloc(sizeof(void*) * env_size);
-        memcpy(c->env, env, sizeof(void*) * env_size);
+    c->name     = name;
+    if (g_rt_prof_active && name) rt_prof_note_closure(fn_ptr, direct, name);
+    if (env_size > 0) {
+        memcpy(c->captures, env, sizeof(void *) * env_size);
+        c->env = c->captures;
     } else {
         c->env = NULL;
     }
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
     v->type = RT_CLOSURE;
     v->data.closure_val = c;
     return v;
 }
 
+RuntimeValue *rt_value_closure_direct(void *fn_ptr, void *direct, void **env, int env_size,
+                                      int arity, const char *name) {
+    if (!env) env_size = 0;
+    void *mem = rt_alloc(RT_CLOSURE_BLOCK_SIZE(env_size > 0 ? env_size : 0));
+    return rt_value_closure_init(mem, fn_ptr, direct, env, env_size, arity, name);
+}
+
+RuntimeValue *rt_value_closure(void *fn_ptr, void **env, int env_size, int arity) {
+    return rt_value_closure_direct(fn_ptr, NULL, env, env_size, arity, NULL);
+}
+
 RuntimeValue *rt_value_closure_named(void *fn_ptr, void **env, int env_size, int arity, const char *name) {
-    RuntimeValue *v = rt_value_closure(fn_ptr, env, env_size, arity);
-    if (name) v->data.closure_val->name = strdup(name);
-    return v;
+    return rt_value_closure_direct(fn_ptr, NULL, env, env_size, arity, name);
 }
 
+typedef RuntimeValue *(*ClosureFn)(void *, int, RuntimeValue **);
+
 RuntimeValue *rt_closure_calln(RuntimeValue *closure, int n, RuntimeValue **args) {
-    if (!closure || closure->type != RT_CLOSURE) return rt_value_nil();
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return rt_value_nil();
+    RuntimeClosure *c = closure->data.closure_val;
+    return ((ClosureFn)c->fn_ptr)(c->env, n, args);
+}
+
+RuntimeValue *rt_closure_call1(RuntimeValue *closure, RuntimeValue *a) {
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return rt_value_nil();
+    RuntimeClosure *c = closure->data.closure_val;
+    typedef RuntimeValue *(*Fn)(void *, RuntimeValue *);
+    if (c->direct && c->arity == 1) return ((Fn)c->direct)(c->env, a);
+    RuntimeValue *args[1] = {a};
+    return ((ClosureFn)c->fn_ptr)(c->env, 1, args);
+}
+
+RuntimeValue *rt_closure_call2(RuntimeValue *closure, RuntimeValue *a, RuntimeValue *b) {
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return rt_value_nil();
     RuntimeClosure *c = closure->data.closure_val;
-    typedef RuntimeValue *(*Fn)(void *, int, RuntimeValue **);
-    return ((Fn)c->fn_ptr)(c->env, n, args);
+    typedef RuntimeValue *(*Fn)(void *, RuntimeValue *, RuntimeValue *);
+    if (c->direct && c->arity == 2) return ((Fn)c->direct)(c->env, a, b);
+    RuntimeValue *args[2] = {a, b};
+    return ((ClosureFn)c->fn_ptr)(c->env, 2, args);
+}
+
+RuntimeValue *rt_closure_call3(RuntimeValue *closure, RuntimeValue *a, RuntimeValue *b,
+                               RuntimeValue *c3) {
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return rt_value_nil();
+    RuntimeClosure *c = closure->data.closure_val;
+    typedef RuntimeValue *(*Fn)(void *, RuntimeValue *, RuntimeValue *, RuntimeValue *);
+    if (c->direct && c->arity == 3) return ((Fn)c->direct)(c->env, a, b, c3);
+    RuntimeValue *args[3] = {a, b, c3};
+    return ((ClosureFn)c->fn_ptr)(c->env, 3, args);
 }
 
 void *rt_closure_get_env(RuntimeValue *closure) {
-    if (!closure || closure->type != RT_CLOSURE) return NULL;
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return NULL;
     return closure->data.closure_val->env;
 }
 
 void *rt_closure_get_fn_ptr(RuntimeValue *closure) {
-    if (!closure || closure->type != RT_CLOSURE) return NULL;
+    if (!closure || rt_type_of(closure) != RT_CLOSURE) return NULL;
     return closure->data.closure_val->fn_ptr;
 }
 
 ///  Thunk forcing
-// two specialised versions for head and tail (Step 3)
+//
+//  Thunks update in place.  While one is being evaluated its fn is swapped
+//  for thunk_blackhole, so a value that demands itself reports <<loop>>
+//  instead of recursing until the stack runs out.  Once forced, fn and env
+//  are cleared so the captured environment can be reclaimed, and the stored
+//  value is never an RT_THUNK: a result that is itself a thunk is forced in
+//  the same loop (and updated too), so chains collapse to one indirection.
+//
+//  The rt_par_* combinators run user code on pool workers, which can reach
+//  the same suspension.  The blackhole is therefore installed with a CAS,
+//  and the value is published before fn is cleared (release), so a reader
+//  that sees the forced flag or a NULL fn also sees the value.  A thread
+//  that meets a blackhole looks for the slot in its own pending stack: if
+//  it is there the value really depends on itself; otherwise another thread
+//  owns the evaluation and this one waits for it to publish.  (Two threads
+//  each waiting on the other's suspension is a cross-thread loop and hangs
+//  instead of reporting <<loop>>.)
+//
+//  The suspensions under evaluation are kept in g_thunk_pending.  A caller
+//  that longjmps out of an evaluation (the REPL) calls rt_thunk_unwind() to
+//  put their code back.
+
+#if !defined(_MSC_VER)
+#include <sched.h>
+#define thunk_yield() sched_yield()
+#else
+#define thunk_yield() ((void)0)
+#endif
+
+typedef struct {
+    ThunkFn       *slot;    // where the blackhole was written
+    ThunkFn        fn;      // what was there
+    void         **env;     // cleared with fn once the value is published
+    RuntimeValue **value;   // where the result goes
+    int           *forced;
+} ThunkPending;
+
+static RT_THREAD_LOCAL ThunkPending *g_thunk_pending;
+static RT_THREAD_LOCAL size_t        g_thunk_pending_len;
+static RT_THREAD_LOCAL size_t        g_thunk_pending_cap;
+
+static RuntimeValue *thunk_blackhole(void *env) {
+    (void)env;
+    __monad_runtime_error(NULL, 0, 0, "<<loop>>: a lazy value depends on itself");
+    return NULL;
+}
 
-static RuntimeValue *_force_head(ConsCell *c) {
-    if (c->head_forced) return c->head_val;
-    RuntimeValue *result = c->head_fn(c->head_env);
-    // Unwrap nested RT_THUNK wrappers
-    while (result && result->type == RT_THUNK) {
-        RuntimeThunk *inner = result->data.thunk_val;
-        if (inner->forced) { result = inner->value; break; }
-        result        = inner->fn(inner->env);
-        inner->value  = result;
-        inner->forced = 1;
+static int thunk_pending_has(const ThunkFn *slot) {
+    for (size_t i = g_thunk_pending_len; i > 0; i--)
+        if (g_thunk_pending[i - 1].slot == slot) return 1;
+    return 0;
+}
+
+// Claims the suspension at *slot for this thread and returns its code, or
+// returns NULL once some thread has published the value.
+static ThunkFn thunk_claim(ThunkFn *slot, void **env, RuntimeValue **value,
+                           int *forced) {
+    for (;;) {
+        ThunkFn fn = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (!fn) return NULL;
+        if (fn == thunk_blackhole) {
+            if (thunk_pending_has(slot)) thunk_blackhole(NULL);
+            while (__atomic_load_n(slot, __ATOMIC_ACQUIRE) == thunk_blackhole)
+                thunk_yield();
+            continue;
+        }
+        if (!__atomic_compare_exchange_n(slot, &fn, thunk_blackhole, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            continue;
+        if (g_thunk_pending_len == g_thunk_pending_cap) {
+            g_thunk_pending_cap = g_thunk_pending_cap ? g_thunk_pending_cap * 2 : 64;
+            g_thunk_pending     = realloc(g_thunk_pending,
+                                          g_thunk_pending_cap * sizeof(ThunkPending));
+            if (!g_thunk_pending) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
+        }
+        g_thunk_pending[g_thunk_pending_len++] =
+            (ThunkPending){slot, fn, env, value, forced};
+        return fn;
     }
-    c->head_val    = result;
-    c->head_forced = 1;
-    return result;
 }
 
-static RuntimeValue *_force_tail(ConsCell *c) {
-    if (c->tail_forced) return c->tail_val;
-    RuntimeValue *result = c->tail_fn(c->tail_env);
-    while (result && result->type == RT_THUNK) {
+// Evaluates the suspension at *slot down to a non-thunk value, publishes it
+// to *value / *forced (and to every thunk collapsed on the way) and returns
+// it.  If another thread got there first, returns what it published.
+static RuntimeValue *thunk_run(ThunkFn *slot, void **env, RuntimeValue **value,
+                               int *forced) {
+    size_t  base = g_thunk_pending_len;
+    ThunkFn fn   = thunk_claim(slot, env, value, forced);
+    if (!fn) return *value;
+    RuntimeValue *result = fn(*env);
+    while (result && rt_type_of(result) == RT_THUNK) {
         RuntimeThunk *inner = result->data.thunk_val;
-        if (inner->forced) { result = inner->value; break; }
-        result        = inner->fn(inner->env);
-        inner->value  = result;
-        inner->forced = 1;
+        if (__atomic_load_n(&inner->forced, __ATOMIC_ACQUIRE)) {
+            result = inner->value;
+            continue;
+        }
+        ThunkFn inner_fn = thunk_claim(&inner->fn, &inner->env, &inner->value,
+                                       &inner->forced);
+        result = inner_fn ? inner_fn(inner->env) : inner->value;
+    }
+    while (g_thunk_pending_len > base) {
+        ThunkPending *p = &g_thunk_pending[--g_thunk_pending_len];
+        *p->value = result;
+        *p->env   = NULL;
+        __atomic_store_n(p->forced, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(p->slot, (ThunkFn)NULL, __ATOMIC_RELEASE);
     }
-    c->tail_val    = result;
-    c->tail_forced = 1;
     return result;
 }
 
+void rt_thunk_unwind(void) {
+    while (g_thunk_pending_len > 0) {
+        ThunkPending *p = &g_thunk_pending[--g_thunk_pending_len];
+        __atomic_store_n(p->slot, p->fn, __ATOMIC_RELEASE);
+    }
+}
+
+static RuntimeValue *_force_head(ConsCell *c) {
+    if (__atomic_load_n(&c->head_forced, __ATOMIC_ACQUIRE)) return c->head_val;
+    return thunk_run(&c->head_fn, &c->head_env, &c->head_val, &c->head_forced);
+}
+
+static RuntimeValue *_force_tail(ConsCell *c) {
+    if (__atomic_load_n(&c->tail_forced, __ATOMIC_ACQUIRE)) return c->tail_val;
+    return thunk_run(&c->tail_fn, &c->tail_env, &c->tail_val, &c->tail_forced);
+}
+
 //  Legacy RuntimeThunk API  (used by rt_force, rt_thunk_of_value, etc.)
 //  These are kept for compatibility with generated code that calls rt_force().
 RuntimeThunk *rt_thunk_of_value(RuntimeValue *val) {
-    RuntimeThunk *t = arena_alloc(&g_eval_arena, sizeof(RuntimeThunk));
+    RuntimeThunk *t = eval_alloc(sizeof(RuntimeThunk));
     t->fn     = NULL;
     t->env    = NULL;
     t->value  = val;
@@ -199,7 +971,7 @@ RuntimeThunk *rt_thunk_of_value(RuntimeValue *val) {
 }
 
 RuntimeThunk *rt_thunk_create(ThunkFn fn, void *env) {
-    RuntimeThunk *t = arena_alloc(&g_eval_arena, sizeof(RuntimeThunk));
+    RuntimeThunk *t = eval_alloc(sizeof(RuntimeThunk));
     t->fn     = fn;
     t->env    = env;
     t->value  = NULL;
@@ -209,21 +981,117 @@ RuntimeThunk *rt_thunk_create(ThunkFn fn, void *env) {
 
 RuntimeValue *rt_force(RuntimeThunk *thunk) {
     if (!thunk) return rt_value_nil();
-    if (thunk->forced) return thunk->value;
+    if (__atomic_load_n(&thunk->forced, __ATOMIC_ACQUIRE)) return thunk->value;
+    return thunk_run(&thunk->fn, &thunk->env, &thunk->value, &thunk->forced);
+}
 
-    RuntimeValue *result = thunk->fn(thunk->env);
+///  Chunked strict lists
+//
+//  See ListChunk in runtime.h.  Chunks come from rt_alloc like strict cons
+//  cells; builders start small and double up to RT_LIST_CHUNK so short
+//  lists stay short.
 
-    while (result && result->type == RT_THUNK) {
-        RuntimeThunk *inner = result->data.thunk_val;
-        if (inner->forced) { result = inner->value; break; }
-        result        = inner->fn(inner->env);
-        inner->value  = result;
-        inner->forced = 1;
+#define LIST_CHUNK_TAG   ((uintptr_t)1)
+#define LIST_CHUNK_FIRST 4
+
+static inline int list_is_chunk(const RuntimeList *l) {
+    return ((uintptr_t)l->cell & LIST_CHUNK_TAG) != 0;
+}
+
+static inline ListChunk *list_chunk(const RuntimeList *l) {
+    return (ListChunk *)((uintptr_t)l->cell & ~LIST_CHUNK_TAG);
+}
+
+// Slot a chunk-tagged list starts at: its own slot, or 0 when free-standing.
+static inline uint32_t list_chunk_index(const RuntimeList *l, const ListChunk *ch) {
+    const ListSlot *s = (const ListSlot *)(const void *)l;
+    return (s >= ch->slots && s < ch->slots + ch->count)
+         ? (uint32_t)(s - ch->slots) : 0;
+}
+
+static inline RuntimeList *list_chunk_at(ListChunk *ch, uint32_t i) {
+    return &ch->slots[i].link;
+}
+
+static ListChunk *list_chunk_new(uint32_t capacity) {
+    ListChunk *ch = rt_alloc(sizeof(ListChunk) + capacity * sizeof(ListSlot));
+    ch->count    = 0;
+    ch->capacity = capacity;
+    ch->next     = NULL;
+    ch->next_fn  = NULL;
+    ch->next_env = NULL;
+    return ch;
+}
+
+static inline void list_chunk_push(ListChunk *ch, RuntimeValue *v) {
+    ListSlot *slot  = &ch->slots[ch->count++];
+    slot->link.cell = (ConsCell *)((uintptr_t)ch | LIST_CHUNK_TAG);
+    slot->value     = v;
+}
+
+static inline uint32_t list_chunk_grow(const ListChunk *prev) {
+    if (!prev) return LIST_CHUNK_FIRST;
+    return prev->capacity >= RT_LIST_CHUNK / 2 ? RT_LIST_CHUNK : prev->capacity * 2;
+}
+
+static inline int list_chunk_has_rest(const ListChunk *ch) {
+    return ch->next_fn || ch->next;
+}
+
+// The list after the chunk's last slot, forcing a lazy rest once.
+static RuntimeList *list_chunk_rest(ListChunk *ch) {
+    if (ch->next_fn) {
+        RuntimeList *rest = ch->next_fn(ch->next_env);
+        ch->next     = rest;
+        ch->next_fn  = NULL;
+        ch->next_env = NULL;
     }
+    return ch->next ? ch->next : _empty_list;
+}
 
-    thunk->value  = result;
-    thunk->forced = 1;
-    return result;
+//  Builder for a fresh strict list: appends in O(1) by remembering the tail
+//  chunk, where rt_list_append has to walk the spine.
+
+typedef struct {
+    RuntimeList *list;
+    ListChunk   *tail;
+} ListBuilder;
+
+static void list_builder_init(ListBuilder *b) {
+    b->list       = heap_list_wrapper();
+    b->list->cell = NULL;
+    b->tail       = NULL;
+}
+
+static void list_builder_push(ListBuilder *b, RuntimeValue *v) {
+    ListChunk *t = b->tail;
+    if (t && t->count < t->capacity) {
+        list_chunk_push(t, v);
+        return;
+    }
+    ListChunk *ch = list_chunk_new(list_chunk_grow(t));
+    list_chunk_push(ch, v);
+    if (t) t->next        = list_chunk_at(ch, 0);
+    else   b->list->cell  = ch->slots[0].link.cell;
+    b->tail = ch;
+}
+
+// Advance up to n elements, a chunk at a time where possible.
+static RuntimeList *list_skip(RuntimeList *cur, int64_t n) {
+    while (n > 0 && !rt_list_is_empty_list(cur)) {
+        if (list_is_chunk(cur)) {
+            ListChunk *ch   = list_chunk(cur);
+            uint32_t   i    = list_chunk_index(cur, ch);
+            int64_t    left = (int64_t)(ch->count - i);
+            if (n < left) return list_chunk_at(ch, i + (uint32_t)n);
+            n  -= left;
+            cur = list_chunk_rest(ch);
+        } else {
+            cur = rt_list_cdr(cur);
+            n--;
+        }
+    }
+    return cur;
 }
 
 ///  Lazy list public API
@@ -245,8 +1113,8 @@ int rt_list_is_empty_list(RuntimeList *list) {
 int rt_is_pair(RuntimeValue *v) {
     if ((uintptr_t)v < 0x10000) return 0;
     if (!v) return 0;
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (!v || v->type != RT_LIST) return 0;
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (!v || rt_type_of(v) != RT_LIST) return 0;
     RuntimeList *l = v->data.list_val;
     return !rt_list_is_empty_list(l);
 }
@@ -336,15 +1204,24 @@ RuntimeList *rt_list_cons(RuntimeValue *head_val, RuntimeList *tail_list) {
 
 RuntimeValue *rt_list_car(RuntimeList *list) {
     if (rt_list_is_empty_list(list)) return rt_value_nil();
+    if (list_is_chunk(list)) {
+        ListChunk *ch = list_chunk(list);
+        return ch->slots[list_chunk_index(list, ch)].value;
+    }
     return _force_head(list->cell);
 }
 
 RuntimeList *rt_list_cdr(RuntimeList *list) {
     if (rt_list_is_empty_list(list)) return rt_list_empty();
+    if (list_is_chunk(list)) {
+        ListChunk *ch = list_chunk(list);
+        uint32_t   i  = list_chunk_index(list, ch) + 1;
+        return i < ch->count ? list_chunk_at(ch, i) : list_chunk_rest(ch);
+    }
 
     RuntimeValue *tv = _force_tail(list->cell);
-    if (!tv || tv->type == RT_NIL)  return rt_list_empty();
-    if (tv->type == RT_LIST)        return tv->data.list_val;
+    if (!tv || rt_type_of(tv) == RT_NIL)  return rt_list_empty();
+    if (rt_type_of(tv) == RT_LIST)        return tv->data.list_val;
     return rt_list_empty();
 }
 
@@ -353,18 +1230,13 @@ RuntimeValue *rt_list_nth(RuntimeList *list, int64_t index) {
     if (index < 0) return rt_value_nil();
     /* Auto-unbox RuntimeValue* → RuntimeList* */
     {
-        int tag = (int)((RuntimeValue *)list)->type;
+        int tag = (int)rt_type_of((RuntimeValue *)list);
         if (tag == RT_LIST)
             list = ((RuntimeValue *)list)->data.list_val;
         else if (tag == RT_NIL || (tag >= 0 && tag <= RT_CLOSURE && tag != RT_LIST))
             return rt_value_nil();
     }
-    RuntimeList *cur = list;
-    for (int64_t i = 0; i < index; i++) {
-        if (rt_list_is_empty_list(cur)) return rt_value_nil();
-        cur = rt_list_cdr(cur);
-    }
-    return rt_list_car(cur);
+    return rt_list_car(list_skip(list, index));
 }
 
 int64_t rt_list_length(RuntimeList *list) {
@@ -372,7 +1244,7 @@ int64_t rt_list_length(RuntimeList *list) {
      * tag at offset 0), unbox it first so callers that pass a RuntimeValue*
      * directly don't crash.                                                 */
     if (list) {
-        int tag = (int)((RuntimeValue *)list)->type;
+        int tag = (int)rt_type_of((RuntimeValue *)list);
         if (tag == RT_LIST)
             list = ((RuntimeValue *)list)->data.list_val;
         else if (tag == RT_NIL || (tag >= 0 && tag <= RT_CLOSURE && tag != RT_LIST))
@@ -381,6 +1253,12 @@ int64_t rt_list_length(RuntimeList *list) {
     int64_t len = 0;
     RuntimeList *cur = list;
     while (!rt_list_is_empty_list(cur)) {
+        if (list_is_chunk(cur)) {
+            ListChunk *ch = list_chunk(cur);
+            len += ch->count - list_chunk_index(cur, ch);
+            cur  = list_chunk_rest(ch);
+            continue;
+        }
         len++;
         cur = rt_list_cdr(cur);
     }
@@ -388,71 +1266,51 @@ int64_t rt_list_length(RuntimeList *list) {
 }
 
 // Destructive append of an already-evaluated value.
-// Walks the spine and attaches a new strict cons cell at the end.
+// Walks the spine and fills the last chunk, or attaches a new one at the end.
 // Used by printing helpers and rt_list_take.
 void rt_list_append(RuntimeList *list, RuntimeValue *value) {
     if (!list) return;
 
-    ConsCell *new_c    = heap_cons_cell();
-    new_c->head_fn     = NULL;
-    new_c->head_env    = NULL;
-    new_c->head_val    = value;
-    new_c->head_forced = 1;
-    new_c->tail_fn     = NULL;
-    new_c->tail_env    = NULL;
-    new_c->tail_val    = NULL;
-    new_c->tail_forced = 1;
-
-    RuntimeList *new_cell = heap_list_wrapper();
-    new_cell->cell = new_c;
-
     // If list is empty (cell == NULL), seed it in-place.
     // IMPORTANT: callers must NEVER pass the global _empty_list singleton here —
     // they must pass their own heap_list_wrapper() with cell=NULL.
     if (list->cell == NULL) {
-        list->cell = new_c;
+        ListChunk *ch = list_chunk_new(LIST_CHUNK_FIRST);
+        list_chunk_push(ch, value);
+        list->cell = ch->slots[0].link.cell;
         return;
     }
 
     RuntimeList *cur = list;
     while (1) {
-        ConsCell *cc = cur->cell;
-        if (!cc) break;
-
-        if (!cc->tail_forced) {
-            RuntimeValue *tv = _force_tail(cc);
-            if (!tv || tv->type == RT_NIL ||
-                (tv->type == RT_LIST && rt_list_is_empty_list(tv->data.list_val))) {
-                RuntimeValue *link  = heap_value();
-                link->type          = RT_LIST;
-                link->data.list_val = new_cell;
-                cc->tail_val    = link;
-                cc->tail_forced = 1;
+        if (list_is_chunk(cur)) {
+            ListChunk *ch = list_chunk(cur);
+            if (list_chunk_has_rest(ch)) {
+                RuntimeList *rest = list_chunk_rest(ch);
+                if (!rt_list_is_empty_list(rest)) { cur = rest; continue; }
+            }
+            if (ch->count < ch->capacity) {
+                list_chunk_push(ch, value);
                 return;
             }
-            if (tv->type == RT_LIST) { cur = tv->data.list_val; continue; }
-            RuntimeValue *link  = heap_value();
-            link->type          = RT_LIST;
-            link->data.list_val = new_cell;
-            cc->tail_val    = link;
-            cc->tail_forced = 1;
+            ListChunk *nc = list_chunk_new(list_chunk_grow(ch));
+            list_chunk_push(nc, value);
+            ch->next = list_chunk_at(nc, 0);
             return;
         }
 
-        RuntimeValue *tv = cc->tail_val;
-        if (!tv || tv->type == RT_NIL ||
-            (tv->type == RT_LIST && rt_list_is_empty_list(tv->data.list_val))) {
-            RuntimeValue *link  = heap_value();
-            link->type          = RT_LIST;
-            link->data.list_val = new_cell;
-            cc->tail_val    = link;
-            cc->tail_forced = 1;
-            return;
+        ConsCell     *cc = cur->cell;
+        RuntimeValue *tv = cc->tail_forced ? cc->tail_val : _force_tail(cc);
+        if (tv && rt_type_of(tv) == RT_LIST && !rt_list_is_empty_list(tv->data.list_val)) {
+            cur = tv->data.list_val;
+            continue;
         }
-        if (tv->type == RT_LIST) { cur = tv->data.list_val; continue; }
+        // End of the spine (or an improper tail, which is replaced).
+        ListChunk *nc = list_chunk_new(LIST_CHUNK_FIRST);
+        list_chunk_push(nc, value);
         RuntimeValue *link  = heap_value();
         link->type          = RT_LIST;
-        link->data.list_val = new_cell;
+        link->data.list_val = list_chunk_at(nc, 0);
         cc->tail_val    = link;
         cc->tail_forced = 1;
         return;
@@ -463,18 +1321,37 @@ void rt_list_append(RuntimeList *list, RuntimeValue *value) {
 
 typedef struct { RuntimeList *rest; RuntimeList *b; } AppendEnv;
 static RuntimeValue *_rt_append_tail_fn(void *e);
+static RuntimeList  *_rt_append_chunk_rest_fn(void *e);
 
 // Internal: both a and b are guaranteed raw RuntimeList* — no unboxing needed.
 static RuntimeList *_rt_list_append_lists_raw(RuntimeList *a, RuntimeList *b) {
     if (rt_list_is_empty_list(a)) return b;
 
+    // Copy the rest of a's chunk at once; b is shared, not copied.
+    if (list_is_chunk(a)) {
+        ListChunk *src = list_chunk(a);
+        uint32_t   i   = list_chunk_index(a, src);
+        ListChunk *out = list_chunk_new(src->count - i);
+        for (; i < src->count; i++) list_chunk_push(out, src->slots[i].value);
+        if (list_chunk_has_rest(src)) {
+            AppendEnv *env = eval_alloc(sizeof(AppendEnv));
+            env->rest     = list_chunk_at(src, src->count - 1);
+            env->b        = b;
+            out->next_fn  = _rt_append_chunk_rest_fn;
+            out->next_env = env;
+        } else {
+            out->next = b;
+        }
+        return list_chunk_at(out, 0);
+    }
+
     ConsCell *c    = alloc_cons_cell();
     c->head_fn     = NULL;
     c->head_env    = NULL;
     c->head_val    = _force_head(a->cell);
     c->head_forced = 1;
 
-    AppendEnv *env = arena_alloc(&g_eval_arena, sizeof(AppendEnv));
+    AppendEnv *env = eval_alloc(sizeof(AppendEnv));
     env->rest = rt_list_cdr(a);
     env->b    = b;
     c->tail_fn     = _rt_append_tail_fn;
@@ -504,35 +1381,55 @@ static RuntimeValue *_rt_append_tail_fn(void *e) {
     return rv;
 }
 
+// env->rest is the last slot of a's chunk; its cdr is forced only now.
+static RuntimeList *_rt_append_chunk_rest_fn(void *e) {
+    AppendEnv *env = (AppendEnv *)e;
+    return _rt_list_append_lists_raw(rt_list_cdr(env->rest), env->b);
+}
+
 RuntimeList *rt_list_copy(RuntimeList *src) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
+    ListBuilder out;
+    list_builder_init(&out);
     RuntimeList *cur = src;
     while (!rt_list_is_empty_list(cur)) {
-        rt_list_append(out, rt_list_car(cur));
+        list_builder_push(&out, rt_list_car(cur));
         cur = rt_list_cdr(cur);
     }
-    return out;
+    return out.list;
 }
 
 RuntimeList *rt_make_list(int64_t n, RuntimeValue *fill_val) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    for (int64_t i = 0; i < n; i++)
-        rt_list_append(out, fill_val);
+    if (n <= 0) return rt_list_new();
+    RuntimeList *out  = heap_list_wrapper();
+    ListChunk   *prev = NULL;
+    while (n > 0) {
+        uint32_t   cnt = n < RT_LIST_CHUNK ? (uint32_t)n : RT_LIST_CHUNK;
+        ListChunk *ch  = list_chunk_new(cnt);
+        for (uint32_t i = 0; i < cnt; i++) list_chunk_push(ch, fill_val);
+        if (prev) prev->next = list_chunk_at(ch, 0);
+        else      out->cell  = ch->slots[0].link.cell;
+        prev = ch;
+        n   -= cnt;
+    }
     return out;
 }
 
+// Arithmetic sequences are produced RT_LIST_CHUNK values at a time; the
+// rest of the sequence stays a lazy chunk tail, so infinite ones are fine.
+static ListChunk *list_chunk_arith(int64_t lo, int64_t step, uint32_t cnt) {
+    ListChunk *ch = list_chunk_new(cnt);
+    for (uint32_t i = 0; i < cnt; i++)
+        list_chunk_push(ch, rt_value_int((int64_t)((uint64_t)lo + (uint64_t)step * i)));
+    return ch;
+}
+
 // --- [lo .. hi] range ---
 typedef struct { int64_t lo; int64_t hi; } RangeEnv;
 
 
-static RuntimeValue *_rt_range_tail_fn(void *e) {
+static RuntimeList *_rt_range_rest_fn(void *e) {
     RangeEnv *env = (RangeEnv *)e;
-    RuntimeValue *rv = malloc(sizeof(RuntimeValue)); // was: alloc_value()
-    rv->type          = RT_LIST;
-    rv->data.list_val = rt_list_range(env->lo, env->hi);
-    return rv;
+    return rt_list_range(env->lo, env->hi);
 }
 
 // Head thunk function: env is a pointer to int64_t (the value itself)
@@ -543,108 +1440,258 @@ static RuntimeValue *_rt_int_head_fn(void *e) {
 
 RuntimeList *rt_list_range(int64_t lo, int64_t hi) {
     if (lo > hi) return rt_list_empty();
-    RuntimeValue *head_val = rt_value_int(lo);
+    uint64_t   span = (uint64_t)hi - (uint64_t)lo;   // element count - 1
+    uint32_t   cnt  = span < RT_LIST_CHUNK ? (uint32_t)span + 1 : RT_LIST_CHUNK;
+    ListChunk *ch   = list_chunk_arith(lo, 1, cnt);
+
+    if (span >= cnt) {
+        RangeEnv *env = rt_alloc(sizeof(RangeEnv));
+        env->lo       = lo + cnt;
+        env->hi       = hi;
+        ch->next_fn   = _rt_range_rest_fn;
+        ch->next_env  = env;
+    }
+    return list_chunk_at(ch, 0);
+}
 
-    ConsCell *c    = heap_cons_cell();
-    c->head_fn     = NULL;
-    c->head_env    = NULL;
-    c->head_val    = head_val;
-    c->head_forced = 1;
+// --- [lo, next ..] arithmetic sequence ---
+typedef struct { int64_t n; int64_t step; } FromStepEnv;
 
-    RangeEnv *env  = malloc(sizeof(RangeEnv)); // was: arena_alloc
-    env->lo        = lo + 1;
-    env->hi        = hi;
-    c->tail_fn     = _rt_range_tail_fn;
-    c->tail_env    = env;
-    c->tail_val    = NULL;
-    c->tail_forced = 0;
 
-    RuntimeList *lst = heap_list_wrapper();
-    lst->cell = c;
-    return lst;
+static RuntimeList *_rt_from_step_rest_fn(void *e) {
+    FromStepEnv *env = (FromStepEnv *)e;
+    return rt_list_from_step(env->n, env->step);
 }
 
-// --- [lo ..] infinite ---
-typedef struct { int64_t n; } FromEnv;
-
-
-static RuntimeValue *_rt_from_tail_fn(void *e) {
-    FromEnv *env = (FromEnv *)e;
-    RuntimeList *result = rt_list_from(env->n); // now heap-allocates recursively
-    RuntimeValue *rv = malloc(sizeof(RuntimeValue)); // was: alloc_value()
-    rv->type          = RT_LIST;
-    rv->data.list_val = result;
-    return rv;
+RuntimeList *rt_list_from_step(int64_t lo, int64_t step) {
+    ListChunk   *ch  = list_chunk_arith(lo, step, RT_LIST_CHUNK);
+    FromStepEnv *env = rt_alloc(sizeof(FromStepEnv));
+    env->n           = (int64_t)((uint64_t)lo + (uint64_t)step * RT_LIST_CHUNK);
+    env->step        = step;
+    ch->next_fn      = _rt_from_step_rest_fn;
+    ch->next_env     = env;
+    return list_chunk_at(ch, 0);
 }
 
 // --- [lo ..] infinite ---
 RuntimeList *rt_list_from(int64_t lo) {
-    RuntimeValue *head_val = rt_value_int(lo);
+    return rt_list_from_step(lo, 1);
+}
 
-    ConsCell *c    = heap_cons_cell();        // was: alloc_cons_cell()
-    c->head_fn     = NULL;
-    c->head_env    = NULL;
-    c->head_val    = head_val;
-    c->head_forced = 1;
+// --- take / drop ---
 
-    FromEnv *env   = malloc(sizeof(FromEnv)); // was: arena_alloc(...)
-    env->n         = lo + 1;
-    c->tail_fn     = _rt_from_tail_fn;
-    c->tail_env    = env;
-    c->tail_val    = NULL;
-    c->tail_forced = 0;
+RuntimeList *rt_list_take(RuntimeList *list, int64_t n) {
+    if (n <= 0 || rt_list_is_empty_list(list)) return rt_list_empty();
+    ListBuilder out;
+    list_builder_init(&out);
+    RuntimeList *cur = list;
+    for (int64_t i = 0; i < n && !rt_list_is_empty_list(cur); i++) {
+        list_builder_push(&out, rt_list_car(cur));
+        cur = rt_list_cdr(cur);
+    }
+    return out.list;
+}
 
-    RuntimeList *lst = heap_list_wrapper();   // was: alloc_list_wrapper()
-    lst->cell = c;
-    return lst;
+///  Strings
+//
+//  See RuntimeString in runtime.h.  Flat strings are one rt_alloc block:
+//  header, chars, NUL.  A rope node keeps its two halves in front of an
+//  empty header until rt_string_chars flattens it; interned names live in
+//  malloc memory for the life of the process.
+
+typedef struct {
+    RuntimeValue *left;
+    RuntimeValue *right;
+} StringRope;
+
+static inline size_t string_flat_size(size_t length) {
+    return sizeof(RuntimeString) + length + 1;
+}
+
+static inline StringRope *string_rope(RuntimeString *h) {
+    return (StringRope *)(void *)h - 1;
+}
+
+// A flat string of `length` bytes with the first `copy` taken from s; the
+// caller fills the rest.
+static RuntimeString *string_alloc_prefix(const char *s, size_t copy, size_t length) {
+    RuntimeString *h = rt_alloc(string_flat_size(length));
+    h->length   = length;
+    h->hash     = 0;
+    h->flags    = 0;
+    h->reserved = 0;
+    if (copy) memcpy(h->chars, s, copy);
+    h->chars[length] = '\0';
+    return h;
 }
 
-// --- [lo, next ..] arithmetic sequence ---
-typedef struct { int64_t n; int64_t step; } FromStepEnv;
+static RuntimeString *string_alloc(const char *s, size_t length) {
+    return string_alloc_prefix(s, length, length);
+}
 
+static RuntimeValue *string_value(RuntimeValueType type, RuntimeString *h) {
+    RuntimeValue *v = heap_value();
+    v->type            = type;
+    v->data.string_val = h->chars;
+    return v;
+}
 
-static RuntimeValue *_rt_from_step_tail_fn(void *e) {
-    FromStepEnv *env = (FromStepEnv *)e;
-    RuntimeValue *rv = malloc(sizeof(RuntimeValue)); // was: alloc_value()
-    rv->type          = RT_LIST;
-    rv->data.list_val = rt_list_from_step(env->n, env->step);
-    return rv;
+// Write a rope's leaves back to front into one flat block.  Iterative:
+// loops that append (or prepend) build ropes as deep as they are long.
+// Outside a pool job the rope value is updated to point at the block, so
+// it is flattened once.  Inside one, other workers may be reading the same
+// value, so the block is returned and the rope left as it was.
+static char *string_flatten(RuntimeValue *v) {
+    RuntimeString *h   = rt_string_header(v->data.string_val);
+    RuntimeString *out = rt_alloc(string_flat_size(h->length));
+    out->length   = h->length;
+    out->hash     = h->hash;
+    out->flags    = 0;
+    out->reserved = 0;
+    out->chars[h->length] = '\0';
+
+    size_t         cap   = 16, top = 0, pos = h->length;
+    RuntimeValue **stack = malloc(cap * sizeof(RuntimeValue *));
+    stack[top++] = v;
+    while (top) {
+        RuntimeValue  *x  = stack[--top];
+        RuntimeString *xh = rt_string_header(x->data.string_val);
+        if (!(xh->flags & RT_STR_ROPE)) {
+            pos -= xh->length;
+            memcpy(out->chars + pos, xh->chars, xh->length);
+            continue;
+        }
+        if (top + 2 > cap) {
+            cap  *= 2;
+            stack = realloc(stack, cap * sizeof(RuntimeValue *));
+        }
+        stack[top++] = string_rope(xh)->left;
+        stack[top++] = string_rope(xh)->right;
+    }
+    free(stack);
+    if (!g_rt_pool_worker) v->data.string_val = out->chars;
+    return out->chars;
 }
 
-RuntimeList *rt_list_from_step(int64_t lo, int64_t step) {
-    RuntimeValue *head_val = rt_value_int(lo);
+char *rt_string_chars(RuntimeValue *v) {
+    if (rt_string_header(v->data.string_val)->flags & RT_STR_ROPE)
+        return string_flatten(v);
+    return v->data.string_val;
+}
 
-    ConsCell *c    = heap_cons_cell();
-    c->head_fn     = NULL;
-    c->head_env    = NULL;
-    c->head_val    = head_val;
-    c->head_forced = 1;
+size_t rt_string_length(RuntimeValue *v) {
+    return rt_string_header(v->data.string_val)->length;
+}
 
-    FromStepEnv *env = malloc(sizeof(FromStepEnv)); // was: arena_alloc
-    env->n           = lo + step;
-    env->step        = step;
-    c->tail_fn       = _rt_from_step_tail_fn;
-    c->tail_env      = env;
-    c->tail_val      = NULL;
-    c->tail_forced   = 0;
+static uint64_t fnv1a(const char *s, size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) { h ^= (uint8_t)s[i]; h *= 1099511628211ULL; }
+    return h ? h : 1;   // 0 marks "not hashed yet"
+}
 
-    RuntimeList *lst = heap_list_wrapper();
-    lst->cell = c;
-    return lst;
+static uint64_t string_hash(RuntimeValue *v) {
+    RuntimeString *h = rt_string_header(v->data.string_val);
+    if (h->hash) return h->hash;
+    const char *s = rt_string_chars(v);
+    h->hash = fnv1a(s, h->length);
+    rt_string_header(s)->hash = h->hash;
+    return h->hash;
 }
 
-// --- take / drop ---
+static int string_equal(RuntimeValue *a, RuntimeValue *b) {
+    if (a->data.string_val == b->data.string_val) return 1;
+    RuntimeString *ha = rt_string_header(a->data.string_val);
+    RuntimeString *hb = rt_string_header(b->data.string_val);
+    if ((ha->flags & hb->flags) & RT_STR_INTERNED) return 0;
+    if (ha->length != hb->length) return 0;
+    if (ha->hash && hb->hash && ha->hash != hb->hash) return 0;
+    return memcmp(rt_string_chars(a), rt_string_chars(b), ha->length) == 0;
+}
 
-RuntimeList *rt_list_take(RuntimeList *list, int64_t n) {
-    if (n <= 0 || rt_list_is_empty_list(list)) return rt_list_empty();
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    RuntimeList *cur = list;
-    for (int64_t i = 0; i < n && !rt_list_is_empty_list(cur); i++) {
-        rt_list_append(out, rt_list_car(cur));
-        cur = rt_list_cdr(cur);
+RuntimeValue *rt_value_string_n(const char *val, size_t length) {
+    return string_value(RT_STRING, string_alloc(val, length));
+}
+
+RuntimeValue *rt_string_append(RuntimeValue *a, RuntimeValue *b) {
+    size_t la = rt_string_length(a), lb = rt_string_length(b);
+    if (!lb) return a;
+    if (!la) return b;
+    if (la + lb < RT_STRING_ROPE_MIN) {
+        RuntimeString *h = string_alloc_prefix(rt_string_chars(a), la, la + lb);
+        memcpy(h->chars + la, rt_string_chars(b), lb);
+        return string_value(RT_STRING, h);
     }
-    return out;
+    StringRope    *r = rt_alloc(sizeof(StringRope) + string_flat_size(0));
+    RuntimeString *h = (RuntimeString *)(void *)(r + 1);
+    r->left     = a;
+    r->right    = b;
+    h->length   = la + lb;
+    h->hash     = 0;
+    h->flags    = RT_STR_ROPE;
+    h->reserved = 0;
+    h->chars[0] = '\0';
+    return string_value(RT_STRING, h);
+}
+
+//  Intern table for symbols and keywords: open addressing over the values
+//  themselves, keyed by (type, name).  Pool workers intern too (rt_par_*
+//  bodies are user code), so lookups and inserts hold intern_mu.
+
+#if !defined(_MSC_VER)
+#include <pthread.h>
+static pthread_mutex_t intern_mu = PTHREAD_MUTEX_INITIALIZER;
+#define intern_lock()   pthread_mutex_lock(&intern_mu)
+#define intern_unlock() pthread_mutex_unlock(&intern_mu)
+#else
+#define intern_lock()   ((void)0)
+#define intern_unlock() ((void)0)
+#endif
+
+static RuntimeValue **intern_slots;
+static size_t         intern_cap, intern_count;
+
+static void intern_grow(void) {
+    size_t         cap   = intern_cap ? intern_cap * 2 : 1024;
+    RuntimeValue **slots = calloc(cap, sizeof(RuntimeValue *));
+    for (size_t i = 0; i < intern_cap; i++) {
+        RuntimeValue *v = intern_slots[i];
+        if (!v) continue;
+        size_t j = rt_string_header(v->data.symbol_val)->hash & (cap - 1);
+        while (slots[j]) j = (j + 1) & (cap - 1);
+        slots[j] = v;
+    }
+    free(intern_slots);
+    intern_slots = slots;
+    intern_cap   = cap;
+}
+
+static RuntimeValue *intern(RuntimeValueType type, const char *name) {
+    size_t   n = strlen(name);
+    uint64_t h = fnv1a(name, n);
+    intern_lock();
+    if (intern_count * 2 >= intern_cap) intern_grow();
+    size_t i = h & (intern_cap - 1);
+    for (RuntimeValue *v; (v = intern_slots[i]); i = (i + 1) & (intern_cap - 1)) {
+        RuntimeString *vh = rt_string_header(v->data.symbol_val);
+        if (vh->hash == h && v->type == type && vh->length == n &&
+            memcmp(vh->chars, name, n) == 0) {
+            intern_unlock();
+            return v;
+        }
+    }
+    RuntimeString *sh = malloc(string_flat_size(n));
+    sh->length   = n;
+    sh->hash     = h;
+    sh->flags    = RT_STR_INTERNED;
+    sh->reserved = 0;
+    memcpy(sh->chars, name, n + 1);
+    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    v->type            = type;
+    v->data.symbol_val = sh->chars;
+    intern_slots[i] = v;
+    intern_count++;
+    intern_unlock();
+    return v;
 }
 
 char *rt_string_take(const char *s, int64_t n) {
@@ -671,7 +1718,7 @@ char *rt_string_concat(const char *a, const char *b) {
 
 void *rt_arr_concat(void *d1, int64_t l1, void *d2, int64_t l2, int64_t elem_size) {
     if (l1 <= 0 && l2 <= 0) return NULL;
-    void *result = calloc(l1 + l2, elem_size);
+    void *result = rt_alloc_zeroed((size_t)(l1 + l2) * (size_t)elem_size);
     if (l1 > 0 && d1) memcpy(result, d1, l1 * elem_size);
     if (l2 > 0 && d2) memcpy((char*)result + (l1 * elem_size), d2, l2 * elem_size);
     return result;
@@ -679,40 +1726,44 @@ void *rt_arr_concat(void *d1, int64_t l1, void *d2, int64_t l2, int64_t elem_siz
 
 RuntimeValue *rt_coll_wrap(RuntimeValue *coll, RuntimeValue *item) {
     if (!coll) return rt_value_list(rt_list_cons(item, rt_list_empty()));
-    if (coll->type == RT_STRING) {
+    if (rt_type_of(coll) == RT_STRING) {
         char buf[2] = { (char)rt_unbox_char(item), '\0' };
         return rt_value_string(buf);
     }
-    if (coll->type == RT_ARRAY) {
+    if (rt_type_of(coll) == RT_ARRAY) {
         RuntimeValue *arr = rt_value_array(1);
         rt_array_set(arr, 0, item);
         return arr;
     }
+    if (rt_type_of(coll) == RT_VECTOR)
+        return rt_value_vector(rt_vector_conj(rt_vector_new(), item));
     return rt_value_list(rt_list_cons(item, rt_list_empty()));
 }
 
 RuntimeValue *rt_coll_empty(RuntimeValue *coll) {
     if (!coll) return rt_value_list(rt_list_empty());
     if ((uintptr_t)coll >= 0x10000) {
-        int _tag = (int)coll->type;
+        int _tag = (int)rt_type_of(coll);
         if (_tag < 0 || _tag > RT_CLOSURE)
             return rt_value_list(rt_list_empty());
     }
-    if (coll->type == RT_STRING) return rt_value_string("");
-    if (coll->type == RT_ARRAY) return rt_value_array(0);
+    if (rt_type_of(coll) == RT_STRING) return rt_value_string("");
+    if (rt_type_of(coll) == RT_ARRAY) return rt_value_array(0);
+    if (rt_type_of(coll) == RT_VECTOR) return rt_value_vector(rt_vector_new());
     return rt_value_list(rt_list_empty());
 }
 
 int rt_coll_is_empty(RuntimeValue *coll) {
     if (!coll) return 1;
     if ((uintptr_t)coll >= 0x10000) {
-        int tag = (int)coll->type;
+        int tag = (int)rt_type_of(coll);
         if (tag < 0 || tag > RT_CLOSURE)
             return rt_list_is_empty_list((RuntimeList *)coll);
     }
-    if (coll->type == RT_STRING) return coll->data.string_val[0] == '\0';
-    if (coll->type == RT_ARRAY)  return coll->data.array_val.length == 0;
-    if (coll->type == RT_LIST)   return rt_list_is_empty_list(coll->data.list_val);
+    if (rt_type_of(coll) == RT_STRING) return rt_string_length(coll) == 0;
+    if (rt_type_of(coll) == RT_ARRAY)  return coll->data.array_val.length == 0;
+    if (rt_type_of(coll) == RT_VECTOR) return rt_vector_count(coll->data.vector_val) == 0;
+    if (rt_type_of(coll) == RT_LIST)   return rt_list_is_empty_list(coll->data.list_val);
     return 1;
 }
 
@@ -735,32 +1786,49 @@ RuntimeValue *rt_coll_concat(RuntimeValue *a, RuntimeValue *b) {
     if (!b) return a;
 
     /* Coerce RT_CHAR to single-char RT_STRING */
-    if (a->type == RT_CHAR) {
-        char buf[2] = { a->data.char_val, '\0' };
+    if (rt_type_of(a) == RT_CHAR) {
+        char buf[2] = { rt_char_val(a), '\0' };
         a = rt_value_string(buf);
     }
-    if (b->type == RT_CHAR) {
-        char buf[2] = { b->data.char_val, '\0' };
+    if (rt_type_of(b) == RT_CHAR) {
+        char buf[2] = { rt_char_val(b), '\0' };
         b = rt_value_string(buf);
     }
 
     /* String + String */
-    if (a->type == RT_STRING && b->type == RT_STRING) {
-        char *s = rt_string_concat(a->data.string_val, b->data.string_val);
-        RuntimeValue *v = rt_value_string(s);
-        free(s);
-        return v;
+    if (rt_type_of(a) == RT_STRING && rt_type_of(b) == RT_STRING)
+        return rt_string_append(a, b);
+
+    /* Vector context: the other side joins as a vector, scalars as one
+     * element; appending a scalar is a conj rather than a concat. */
+    if (rt_type_of(a) == RT_VECTOR || rt_type_of(b) == RT_VECTOR) {
+        if (rt_type_of(a) == RT_VECTOR && rt_type_of(b) != RT_VECTOR &&
+            rt_type_of(b) != RT_ARRAY && rt_type_of(b) != RT_LIST)
+            return rt_value_vector(rt_vector_conj(a->data.vector_val, b));
+        RuntimeVector *va, *vb;
+        switch (rt_type_of(a)) {
+            case RT_VECTOR: va = a->data.vector_val;                   break;
+            case RT_ARRAY:  va = rt_vector_from_array(a);              break;
+            case RT_LIST:   va = rt_vector_from_list(a->data.list_val); break;
+            default:        va = rt_vector_conj(rt_vector_new(), a);   break;
+        }
+        switch (rt_type_of(b)) {
+            case RT_VECTOR: vb = b->data.vector_val;                   break;
+            case RT_ARRAY:  vb = rt_vector_from_array(b);              break;
+            default:        vb = rt_vector_from_list(b->data.list_val); break;
+        }
+        return rt_value_vector(rt_vector_concat(va, vb));
     }
 
     /* Array context: if either side is an array, produce an array */
-    if (a->type == RT_ARRAY || b->type == RT_ARRAY) {
+    if (rt_type_of(a) == RT_ARRAY || rt_type_of(b) == RT_ARRAY) {
         /* Coerce non-array side to single-element array */
         RuntimeValue *av = a, *bv = b;
-        if (a->type != RT_ARRAY) {
+        if (rt_type_of(a) != RT_ARRAY) {
             av = rt_value_array(1);
             av->data.array_val.elements[0] = a;
         }
-        if (b->type != RT_ARRAY) {
+        if (rt_type_of(b) != RT_ARRAY) {
             bv = rt_value_array(1);
             bv->data.array_val.elements[0] = b;
         }
@@ -779,7 +1847,7 @@ RuntimeValue *rt_coll_concat(RuntimeValue *a, RuntimeValue *b) {
      * so prepending a single element doesn't silently downcast to List. */
 
     /* Scalar ++ Array → Array */
-    if (b->type == RT_ARRAY) {
+    if (rt_type_of(b) == RT_ARRAY) {
         size_t lb = b->data.array_val.length;
         RuntimeValue *v = rt_value_array(1 + lb);
         v->data.array_val.elements[0] = a;
@@ -789,27 +1857,24 @@ RuntimeValue *rt_coll_concat(RuntimeValue *a, RuntimeValue *b) {
     }
 
     /* Scalar ++ String → String: a must be RT_CHAR */
-    if (b->type == RT_STRING) {
-        char prefix[2] = { (a->type == RT_CHAR) ? a->data.char_val : (char)rt_unbox_int(a), '\0' };
-        char *s = rt_string_concat(prefix, b->data.string_val);
-        RuntimeValue *v = rt_value_string(s);
-        free(s);
-        return v;
+    if (rt_type_of(b) == RT_STRING) {
+        char prefix[2] = { (rt_type_of(a) == RT_CHAR) ? rt_char_val(a) : (char)rt_unbox_int(a), '\0' };
+        return rt_string_append(rt_value_string_n(prefix, 1), b);
     }
 
     /* Scalar ++ List → lazy cons */
-    if (a->type != RT_LIST && b->type == RT_LIST)
+    if (rt_type_of(a) != RT_LIST && rt_type_of(b) == RT_LIST)
         return rt_value_list(rt_list_cons(a, b->data.list_val));
 
     /* List ++ List → lazy append */
-    if (a->type == RT_LIST && b->type == RT_LIST)
+    if (rt_type_of(a) == RT_LIST && rt_type_of(b) == RT_LIST)
         return rt_value_list(_rt_list_append_lists_raw(
             a->data.list_val, b->data.list_val));
 
     /* List fallback: coerce scalars to single-element lists */
     RuntimeList *la_list, *lb_list;
 
-    if (a->type == RT_LIST) {
+    if (rt_type_of(a) == RT_LIST) {
         la_list = a->data.list_val;
     } else {
         la_list = heap_list_wrapper();
@@ -817,7 +1882,7 @@ RuntimeValue *rt_coll_concat(RuntimeValue *a, RuntimeValue *b) {
         rt_list_append(la_list, a);
     }
 
-    if (b->type == RT_LIST) {
+    if (rt_type_of(b) == RT_LIST) {
         lb_list = b->data.list_val;
     } else {
         lb_list = heap_list_wrapper();
@@ -832,16 +1897,20 @@ RuntimeValue *rt_coll_drop(RuntimeValue *coll, int64_t n) {
     if (!coll) return rt_value_list(rt_list_empty());
     if (n < 0) n = 0;
     if ((uintptr_t)coll >= 0x10000) {
-        int _tag = (int)coll->type;
+        int _tag = (int)rt_type_of(coll);
         if (_tag < 0 || _tag > RT_CLOSURE)
             return rt_value_list(rt_list_drop((RuntimeList *)coll, n));
     }
-    if (coll->type == RT_STRING) {
-        int64_t len = strlen(coll->data.string_val);
+    if (rt_type_of(coll) == RT_STRING) {
+        int64_t len = (int64_t)rt_string_length(coll);
         if (n >= len) return rt_value_string("");
-        return rt_value_string(coll->data.string_val + n);
+        return rt_value_string_n(rt_string_chars(coll) + n, (size_t)(len - n));
+    }
+    if (rt_type_of(coll) == RT_VECTOR) {
+        RuntimeVector *v = coll->data.vector_val;
+        return rt_value_vector(rt_vector_slice(v, n, rt_vector_count(v)));
     }
-    if (coll->type == RT_ARRAY) {
+    if (rt_type_of(coll) == RT_ARRAY) {
         int64_t len = coll->data.array_val.length;
         if (n >= len) return rt_value_array(0);
         size_t new_len = len - n;
@@ -856,15 +1925,16 @@ RuntimeValue *rt_coll_drop(RuntimeValue *coll, int64_t n) {
 int64_t rt_coll_count(RuntimeValue *coll) {
     if (!coll) return 0;
     if ((uintptr_t)coll >= 0x10000) {
-        int tag = (int)coll->type;
+        int tag = (int)rt_type_of(coll);
         if (tag < 0 || tag > RT_CLOSURE)
             return rt_list_length((RuntimeList *)coll);
     }
-    if (coll->type == RT_STRING) return strlen(coll->data.string_val);
-    if (coll->type == RT_ARRAY)  return coll->data.array_val.length;
-    if (coll->type == RT_MAP)    return rt_map_count(coll->data.map_val);
-    if (coll->type == RT_SET)    return rt_set_count(coll->data.set_val);
-    if (coll->type == RT_LIST)   return rt_list_length(coll->data.list_val);
+    if (rt_type_of(coll) == RT_STRING) return (int64_t)rt_string_length(coll);
+    if (rt_type_of(coll) == RT_ARRAY)  return coll->data.array_val.length;
+    if (rt_type_of(coll) == RT_VECTOR) return rt_vector_count(coll->data.vector_val);
+    if (rt_type_of(coll) == RT_MAP)    return rt_map_count(coll->data.map_val);
+    if (rt_type_of(coll) == RT_SET)    return rt_set_count(coll->data.set_val);
+    if (rt_type_of(coll) == RT_LIST)   return rt_list_length(coll->data.list_val);
     return 0;
 }
 
@@ -876,22 +1946,28 @@ int64_t __rt_count(RuntimeValue *coll) {
 }
 
 bool __rt_set_singleton(RuntimeValue *set) {
-    return set && set->type == RT_SET &&
+    return set && rt_type_of(set) == RT_SET &&
            rt_set_count(set->data.set_val) == 1;
 }
 
 int rt_coll_contains(RuntimeValue *coll, RuntimeValue *value) {
     if (!coll) return 0;
-    if (coll->type == RT_SET)
+    if (rt_type_of(coll) == RT_SET)
         return rt_set_contains(coll->data.set_val, value);
-    if (coll->type == RT_MAP)
+    if (rt_type_of(coll) == RT_MAP)
         return rt_map_contains(coll->data.map_val, value);
-    if (coll->type == RT_ARRAY) {
+    if (rt_type_of(coll) == RT_ARRAY) {
         for (size_t i = 0; i < coll->data.array_val.length; i++)
             if (rt_equal_p(coll->data.array_val.elements[i], value)) return 1;
         return 0;
     }
-    if (coll->type == RT_LIST) {
+    if (rt_type_of(coll) == RT_VECTOR) {
+        RuntimeList *xs = rt_vector_seq(coll->data.vector_val);
+        for (; !rt_list_is_empty_list(xs); xs = rt_list_cdr(xs))
+            if (rt_equal_p(rt_list_car(xs), value)) return 1;
+        return 0;
+    }
+    if (rt_type_of(coll) == RT_LIST) {
         RuntimeList *xs = coll->data.list_val;
         while (!rt_list_is_empty_list(xs)) {
             if (rt_equal_p(rt_list_car(xs), value)) return 1;
@@ -899,23 +1975,26 @@ int rt_coll_contains(RuntimeValue *coll, RuntimeValue *value) {
         }
         return 0;
     }
-    if (coll->type == RT_STRING && value && value->type == RT_STRING)
-        return strstr(coll->data.string_val, value->data.string_val) != NULL;
-    if (coll->type == RT_STRING && value && value->type == RT_CHAR)
-        return strchr(coll->data.string_val, value->data.char_val) != NULL;
+    if (rt_type_of(coll) == RT_STRING && value && rt_type_of(value) == RT_STRING)
+        return strstr(rt_string_chars(coll), rt_string_chars(value)) != NULL;
+    if (rt_type_of(coll) == RT_STRING && value && rt_type_of(value) == RT_CHAR)
+        return strchr(rt_string_chars(coll), rt_char_val(value)) != NULL;
     return 0;
 }
 
 static RuntimeValue *rt_coll_nth_value(RuntimeValue *coll, size_t index) {
     if (!coll) return NULL;
-    if (coll->type == RT_ARRAY)
+    if (rt_type_of(coll) == RT_ARRAY)
         return index < coll->data.array_val.length
             ? coll->data.array_val.elements[index] : NULL;
-    if (coll->type == RT_LIST)
+    if (rt_type_of(coll) == RT_VECTOR)
+        return (int64_t)index < rt_vector_count(coll->data.vector_val)
+            ? rt_vector_nth(coll->data.vector_val, (int64_t)index) : NULL;
+    if (rt_type_of(coll) == RT_LIST)
         return rt_list_nth(coll->data.list_val, (int64_t)index);
-    if (coll->type == RT_STRING) {
-        size_t length = strlen(coll->data.string_val);
-        return index < length ? rt_value_char(coll->data.string_val[index]) : NULL;
+    if (rt_type_of(coll) == RT_STRING) {
+        size_t length = rt_string_length(coll);
+        return index < length ? rt_value_char(rt_string_chars(coll)[index]) : NULL;
     }
     if (index == 0) return coll;
     return NULL;
@@ -925,8 +2004,8 @@ static int rt_coll_affix(RuntimeValue *coll, RuntimeValue *affix, int at_end) {
     int64_t coll_count = rt_coll_count(coll);
     int64_t affix_count = rt_coll_count(affix);
     if (affix && affix_count == 0 &&
-        affix->type != RT_LIST && affix->type != RT_ARRAY &&
-        affix->type != RT_STRING)
+        rt_type_of(affix) != RT_LIST && rt_type_of(affix) != RT_ARRAY &&
+        rt_type_of(affix) != RT_VECTOR && rt_type_of(affix) != RT_STRING)
         affix_count = 1;
     if (coll_count < affix_count) return 0;
     size_t offset = at_end ? (size_t)(coll_count - affix_count) : 0;
@@ -947,128 +2026,670 @@ int rt_coll_ends_with(RuntimeValue *coll, RuntimeValue *suffix) {
 }
 
 RuntimeList *rt_list_drop(RuntimeList *list, int64_t n) {
-    RuntimeList *cur = list;
-    for (int64_t i = 0; i < n && !rt_list_is_empty_list(cur); i++)
-        cur = rt_list_cdr(cur);
-    return cur;
+    return list_skip(list, n);
 }
 
 
-/// Map
+/// Persistent hash array mapped trie
+//
+//  RuntimeMap and RuntimeSet switch to this representation once a
+//  persistent operation (assoc, dissoc, conj, disj, merge, the set
+//  builders) produces more than COLL_TABLE_MAX entries.  Each node keeps a
+//  32-way bitmap of inline entries and one of child nodes (CHAMP layout):
+//  the entries come first, then the child pointers, both packed in bitmap
+//  order.  An update copies only the path from the root to the node it
+//  touches, so every version shares the rest of the trie and assoc/conj
+//  are O(log32 n) instead of a full table copy.  Keys whose 64-bit hashes
+//  are identical land in a collision node, a flat entry array below the
+//  last level.  Sets store their elements as keys with a NULL value.
+//
+//  Builders (rt_set_of, rt_set_from_list, rt_map_merge, ...) pass an edit
+//  token: nodes created under it are updated in place while the builder
+//  runs, and the token is never handed out again afterwards, which is
+//  what freezes them.
+//
+//  Small collections and every _mut operation keep the open-addressing
+//  tables further down, which are faster to probe and to mutate in place.
+//  A _mut call on a trie-backed value converts that value back to a table.
 
-#define MAP_INITIAL_CAP 8
-#define MAP_LOAD_NUM    7
-#define MAP_LOAD_DEN    10
+#define HAMT_BITS      5
+#define HAMT_MASK      31u
+#define HAMT_MAX_SHIFT 64   // at or past this, keys go into collision nodes
+#define HAMT_MAX_DEPTH 16
+#define COLL_TABLE_MAX 8
 
-static RuntimeMapEntry MAP_TOMBSTONE_ENTRY = {NULL, NULL};
-#define MAP_TOMBSTONE (&MAP_TOMBSTONE_ENTRY)
+typedef struct HamtNode {
+    uint32_t        datamap;     // bitmap of inline entries
+    uint32_t        nodemap;     // bitmap of child nodes
+    uint32_t        collisions;  // entry count of a collision node, else 0
+    uint32_t        reserved;
+    uint64_t        edit;        // owning builder, 0 = shared
+    RuntimeMapEntry entries[];   // inline entries, then HamtNode * children
+} HamtNode;
 
-static RuntimeMap *map_alloc(size_t cap) {
-    RuntimeMap *m  = malloc(sizeof(RuntimeMap));
-    m->buckets     = calloc(cap, sizeof(RuntimeMapEntry));
-    m->capacity    = cap;
-    m->count       = 0;
-    m->tombstones  = 0;
-    return m;
+static uint64_t g_hamt_edit_seq = 0;
+
+// Pool workers build tries too, so edit tokens are handed out atomically.
+static inline uint64_t hamt_new_edit(void) {
+    return __atomic_add_fetch(&g_hamt_edit_seq, 1, __ATOMIC_RELAXED);
 }
 
-static size_t map_probe(RuntimeMap *m, RuntimeValue *key) {
-    uint64_t h    = rt_hash_value(key);
-    size_t   mask = m->capacity - 1;
-    return (size_t)(h & mask);
+static inline uint32_t hamt_popcount(uint32_t x) { return (uint32_t)__builtin_popcount(x); }
+
+static inline uint32_t hamt_ndata(const HamtNode *n) {
+    return n->collisions ? n->collisions : hamt_popcount(n->datamap);
+}
+
+static inline uint32_t hamt_nchild(const HamtNode *n) {
+    return hamt_popcount(n->nodemap);
 }
 
-static void map_insert_noresize(RuntimeMap *m, RuntimeValue *key, RuntimeValue *val) {
-    size_t mask       = m->capacity - 1;
-    size_t idx        = map_probe(m, key);
-    size_t first_tomb = SIZE_MAX;
+static inline HamtNode **hamt_children(HamtNode *n) {
+    return (HamtNode **)(n->entries + hamt_ndata(n));
+}
 
-    for (size_t i = 0; i < m->capacity; i++) {
-        size_t          slot = (idx + i) & mask;
-        RuntimeMapEntry *e   = &m->buckets[slot];
-
-        if (!e->key) {
-            size_t write = (first_tomb != SIZE_MAX) ? first_tomb : slot;
-            m->buckets[write].key = key;
-            m->buckets[write].val = val;
-            m->count++;
-            if (first_tomb != SIZE_MAX) m->tombstones--;
-            return;
+static inline size_t hamt_node_size(uint32_t ndata, uint32_t nchild) {
+    return sizeof(HamtNode) + ndata * sizeof(RuntimeMapEntry)
+                            + nchild * sizeof(HamtNode *);
+}
+
+static inline uint32_t hamt_bit(uint64_t hash, int shift) {
+    return 1u << ((hash >> shift) & HAMT_MASK);
+}
+
+static inline uint32_t hamt_index(uint32_t bitmap, uint32_t bit) {
+    return hamt_popcount(bitmap & (bit - 1));
+}
+
+static HamtNode *hamt_node_new(uint32_t datamap, uint32_t nodemap,
+                               uint32_t collisions, uint64_t edit) {
+    uint32_t  nd = collisions ? collisions : hamt_popcount(datamap);
+    HamtNode *n  = rt_alloc(hamt_node_size(nd, hamt_popcount(nodemap)));
+    n->datamap    = datamap;
+    n->nodemap    = nodemap;
+    n->collisions = collisions;
+    n->reserved   = 0;
+    n->edit       = edit;
+    return n;
+}
+
+static HamtNode *hamt_copy(HamtNode *n, uint64_t edit) {
+    size_t    size = hamt_node_size(hamt_ndata(n), hamt_nchild(n));
+    HamtNode *out  = rt_alloc(size);
+    memcpy(out, n, size);
+    out->edit = edit;
+    return out;
+}
+
+// A node replaced inside its own builder is referenced by nothing else.
+static void hamt_release(HamtNode *n, uint64_t edit) {
+    if (edit && n->edit == edit)
+        rt_free_sized(n, hamt_node_size(hamt_ndata(n), hamt_nchild(n)));
+}
+
+static inline int hamt_is_singleton(const HamtNode *n) {
+    return n->collisions ? n->collisions == 1
+                         : n->nodemap == 0 && hamt_popcount(n->datamap) == 1;
+}
+
+static RuntimeMapEntry *hamt_find(HamtNode *n, uint64_t hash, RuntimeValue *key) {
+    int shift = 0;
+    while (n) {
+        if (n->collisions) {
+            for (uint32_t i = 0; i < n->collisions; i++)
+                if (rt_equal_p(n->entries[i].key, key)) return &n->entries[i];
+            return NULL;
+        }
+        uint32_t bit = hamt_bit(hash, shift);
+        if (n->datamap & bit) {
+            RuntimeMapEntry *e = &n->entries[hamt_index(n->datamap, bit)];
+            return rt_equal_p(e->key, key) ? e : NULL;
         }
-        if (e == MAP_TOMBSTONE) {
-            if (first_tomb == SIZE_MAX) first_tomb = slot;
+        if (!(n->nodemap & bit)) return NULL;
+        n      = hamt_children(n)[hamt_index(n->nodemap, bit)];
+        shift += HAMT_BITS;
+    }
+    return NULL;
+}
+
+static HamtNode *hamt_merge_two(RuntimeMapEntry a, uint64_t ha,
+                                RuntimeMapEntry b, uint64_t hb,
+                                int shift, uint64_t edit) {
+    if (shift >= HAMT_MAX_SHIFT) {
+        HamtNode *n = hamt_node_new(0, 0, 2, edit);
+        n->entries[0] = a;
+        n->entries[1] = b;
+        return n;
+    }
+    uint32_t ba = hamt_bit(ha, shift), bb = hamt_bit(hb, shift);
+    if (ba == bb) {
+        HamtNode *n = hamt_node_new(0, ba, 0, edit);
+        hamt_children(n)[0] = hamt_merge_two(a, ha, b, hb, shift + HAMT_BITS, edit);
+        return n;
+    }
+    HamtNode *n = hamt_node_new(ba | bb, 0, 0, edit);
+    n->entries[ba < bb ? 0 : 1] = a;
+    n->entries[ba < bb ? 1 : 0] = b;
+    return n;
+}
+
+static HamtNode *hamt_assoc(HamtNode *n, int shift, uint64_t hash,
+                            RuntimeValue *key, RuntimeValue *val,
+                            uint64_t edit, int *added) {
+    RuntimeMapEntry kv = { key, val };
+    if (!n) {
+        n = hamt_node_new(hamt_bit(hash, shift), 0, 0, edit);
+        n->entries[0] = kv;
+        *added = 1;
+        return n;
+    }
+    int owned = edit && n->edit == edit;
+
+    if (n->collisions) {
+        uint32_t cnt = n->collisions;
+        for (uint32_t i = 0; i < cnt; i++) {
+            if (!rt_equal_p(n->entries[i].key, key)) continue;
+            if (n->entries[i].val == val) return n;
+            HamtNode *out = owned ? n : hamt_copy(n, edit);
+            out->entries[i].val = val;
+            return out;
+        }
+        HamtNode *out = hamt_node_new(0, 0, cnt + 1, edit);
+        memcpy(out->entries, n->entries, cnt * sizeof(RuntimeMapEntry));
+        out->entries[cnt] = kv;
+        hamt_release(n, edit);
+        *added = 1;
+        return out;
+    }
+
+    uint32_t bit = hamt_bit(hash, shift);
+    uint32_t nd  = hamt_popcount(n->datamap);
+    uint32_t nc  = hamt_popcount(n->nodemap);
+
+    if (n->datamap & bit) {
+        uint32_t        idx = hamt_index(n->datamap, bit);
+        RuntimeMapEntry cur = n->entries[idx];
+        if (rt_equal_p(cur.key, key)) {
+            if (cur.val == val) return n;
+            HamtNode *out = owned ? n : hamt_copy(n, edit);
+            out->entries[idx].val = val;
+            return out;
+        }
+        // Push the resident entry and the new one down into a child.
+        HamtNode *child = hamt_merge_two(cur, rt_hash_value(cur.key), kv, hash,
+                                         shift + HAMT_BITS, edit);
+        uint32_t  cidx  = hamt_index(n->nodemap, bit);
+        HamtNode *out   = hamt_node_new(n->datamap & ~bit, n->nodemap | bit, 0, edit);
+        HamtNode **oc   = hamt_children(out);
+        HamtNode **ic   = hamt_children(n);
+        memcpy(out->entries, n->entries, idx * sizeof(RuntimeMapEntry));
+        memcpy(out->entries + idx, n->entries + idx + 1,
+               (nd - idx - 1) * sizeof(RuntimeMapEntry));
+        memcpy(oc, ic, cidx * sizeof(HamtNode *));
+        oc[cidx] = child;
+        memcpy(oc + cidx + 1, ic + cidx, (nc - cidx) * sizeof(HamtNode *));
+        hamt_release(n, edit);
+        *added = 1;
+        return out;
+    }
+
+    if (n->nodemap & bit) {
+        uint32_t  cidx  = hamt_index(n->nodemap, bit);
+        HamtNode *child = hamt_children(n)[cidx];
+        HamtNode *nchild = hamt_assoc(child, shift + HAMT_BITS, hash, key, val,
+                                      edit, added);
+        if (nchild == child) return n;
+        HamtNode *out = owned ? n : hamt_copy(n, edit);
+        hamt_children(out)[cidx] = nchild;
+        return out;
+    }
+
+    uint32_t  idx = hamt_index(n->datamap, bit);
+    HamtNode *out = hamt_node_new(n->datamap | bit, n->nodemap, 0, edit);
+    memcpy(out->entries, n->entries, idx * sizeof(RuntimeMapEntry));
+    out->entries[idx] = kv;
+    memcpy(out->entries + idx + 1, n->entries + idx,
+           (nd - idx) * sizeof(RuntimeMapEntry));
+    memcpy(hamt_children(out), hamt_children(n), nc * sizeof(HamtNode *));
+    hamt_release(n, edit);
+    *added = 1;
+    return out;
+}
+
+// Persistent removal.  Returns NULL for an empty result; a child that
+// shrinks to a single entry is folded back into its parent.
+static HamtNode *hamt_dissoc(HamtNode *n, int shift, uint64_t hash,
+                             RuntimeValue *key, int *removed) {
+    if (!n) return NULL;
+
+    if (n->collisions) {
+        uint32_t cnt = n->collisions;
+        for (uint32_t i = 0; i < cnt; i++) {
+            if (!rt_equal_p(n->entries[i].key, key)) continue;
+            *removed = 1;
+            if (cnt == 1) return NULL;
+            HamtNode *out = hamt_node_new(0, 0, cnt - 1, 0);
+            memcpy(out->entries, n->entries, i * sizeof(RuntimeMapEntry));
+            memcpy(out->entries + i, n->entries + i + 1,
+                   (cnt - i - 1) * sizeof(RuntimeMapEntry));
+            return out;
+        }
+        return n;
+    }
+
+    uint32_t bit = hamt_bit(hash, shift);
+    uint32_t nd  = hamt_popcount(n->datamap);
+    uint32_t nc  = hamt_popcount(n->nodemap);
+
+    if (n->datamap & bit) {
+        uint32_t idx = hamt_index(n->datamap, bit);
+        if (!rt_equal_p(n->entries[idx].key, key)) return n;
+        *removed = 1;
+        if (nd == 1 && nc == 0) return NULL;
+        HamtNode *out = hamt_node_new(n->datamap & ~bit, n->nodemap, 0, 0);
+        memcpy(out->entries, n->entries, idx * sizeof(RuntimeMapEntry));
+        memcpy(out->entries + idx, n->entries + idx + 1,
+               (nd - idx - 1) * sizeof(RuntimeMapEntry));
+        memcpy(hamt_children(out), hamt_children(n), nc * sizeof(HamtNode *));
+        return out;
+    }
+
+    if (!(n->nodemap & bit)) return n;
+
+    uint32_t   cidx   = hamt_index(n->nodemap, bit);
+    HamtNode **ic     = hamt_children(n);
+    HamtNode  *nchild = hamt_dissoc(ic[cidx], shift + HAMT_BITS, hash, key, removed);
+    if (nchild == ic[cidx]) return n;
+
+    if (!nchild) {
+        if (nd == 0 && nc == 1) return NULL;
+        HamtNode *out = hamt_node_new(n->datamap, n->nodemap & ~bit, 0, 0);
+        HamtNode **oc = hamt_children(out);
+        memcpy(out->entries, n->entries, nd * sizeof(RuntimeMapEntry));
+        memcpy(oc, ic, cidx * sizeof(HamtNode *));
+        memcpy(oc + cidx, ic + cidx + 1, (nc - cidx - 1) * sizeof(HamtNode *));
+        return out;
+    }
+
+    if (hamt_is_singleton(nchild)) {
+        uint32_t  idx = hamt_index(n->datamap, bit);
+        HamtNode *out = hamt_node_new(n->datamap | bit, n->nodemap & ~bit, 0, 0);
+        HamtNode **oc = hamt_children(out);
+        memcpy(out->entries, n->entries, idx * sizeof(RuntimeMapEntry));
+        out->entries[idx] = nchild->entries[0];
+        memcpy(out->entries + idx + 1, n->entries + idx,
+               (nd - idx) * sizeof(RuntimeMapEntry));
+        memcpy(oc, ic, cidx * sizeof(HamtNode *));
+        memcpy(oc + cidx, ic + cidx + 1, (nc - cidx - 1) * sizeof(HamtNode *));
+        return out;
+    }
+
+    HamtNode *out = hamt_copy(n, 0);
+    hamt_children(out)[cidx] = nchild;
+    return out;
+}
+
+///  Collection iteration
+//
+//  One cursor for both representations: a table scan, or a depth-first
+//  walk of the trie with an explicit stack (the trie is at most
+//  HAMT_MAX_DEPTH levels deep).
+
+typedef struct {
+    RuntimeMapEntry *map_table;
+    RuntimeValue   **set_table;
+    size_t           capacity;
+    size_t           index;
+    int              depth;
+    HamtNode        *path[HAMT_MAX_DEPTH];
+    uint32_t         pos[HAMT_MAX_DEPTH];
+} CollIter;
+
+static void coll_iter_trie(CollIter *it, HamtNode *root) {
+    memset(it, 0, sizeof(*it));
+    if (root) {
+        it->path[0] = root;
+        it->depth   = 1;
+    }
+}
+
+static RuntimeMapEntry *coll_iter_trie_next(CollIter *it) {
+    while (it->depth > 0) {
+        HamtNode *n  = it->path[it->depth - 1];
+        uint32_t  nd = hamt_ndata(n);
+        uint32_t  p  = it->pos[it->depth - 1]++;
+        if (p < nd) return &n->entries[p];
+        if (p < nd + hamt_nchild(n)) {
+            it->path[it->depth] = hamt_children(n)[p - nd];
+            it->pos[it->depth]  = 0;
+            it->depth++;
             continue;
         }
-        if (rt_equal_p(e->key, key)) {
-            e->val = val;  /* update existing */
-            return;
+        it->depth--;
+    }
+    return NULL;
+}
+
+///  Group-probed hash tables
+//
+//  The tables behind small maps and sets and every _mut update.  Each slot
+//  has a control byte: CTRL_EMPTY, CTRL_DELETED, or 0x80 | the top 7 bits
+//  of the mixed hash when full.  A probe loads a whole group of control
+//  bytes and compares all of them against those 7 bits at once (SSE2 or
+//  NEON, a byte loop otherwise), then checks the cached full hash of each
+//  hit, so rt_equal_p only runs on keys that almost certainly match.
+//  Groups are probed triangularly, which visits every group of a
+//  power-of-two table, and a lookup stops at the first group that still
+//  has an empty slot.
+//
+//  Removing a key from a group that still has an empty slot makes the
+//  slot empty again: no lookup ever probed past that group, because it has
+//  never been full since the last rehash.  Only slots in groups that were
+//  full become CTRL_DELETED, and a rehash at the same capacity clears them
+//  when they outnumber the live keys.
+//
+//  Slots hold the key pointer (the element of a set, the entry key of a
+//  map) or NULL, so iteration never looks at the control bytes.  hashes
+//  caches rt_hash_value per slot and shares one allocation with ctrl.
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define RT_TABLE_SSE2 1
+#  define TABLE_GROUP   16
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define RT_TABLE_NEON 1
+#  define TABLE_GROUP   16
+#else
+#  define TABLE_GROUP   8
+#endif
+
+#define CTRL_EMPTY    0x00
+#define CTRL_DELETED  0x01
+
+// Bit mask of the lanes of group g equal to b, lowest lane first.
+#if defined(RT_TABLE_SSE2)
+#  define TABLE_BPB 1
+static inline uint64_t table_match(const uint8_t *g, uint8_t b) {
+    __m128i v = _mm_loadu_si128((const __m128i *)g);
+    return (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)b)));
+}
+#elif defined(RT_TABLE_NEON)
+#  define TABLE_BPB 4
+static inline uint64_t table_match(const uint8_t *g, uint8_t b) {
+    uint8x16_t eq  = vceqq_u8(vld1q_u8(g), vdupq_n_u8(b));
+    uint8x8_t  nib = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nib), 0) & 0x1111111111111111ULL;
+}
+#else
+#  define TABLE_BPB 1
+static inline uint64_t table_match(const uint8_t *g, uint8_t b) {
+    uint64_t m = 0;
+    for (int i = 0; i < TABLE_GROUP; i++)
+        m |= (uint64_t)(g[i] == b) << i;
+    return m;
+}
+#endif
+
+static inline size_t table_lane(uint64_t m) {
+    return (size_t)__builtin_ctzll(m) / TABLE_BPB;
+}
+
+// The group index keeps rt_hash_value's low bits, which the multiplicative
+// Int hash spreads evenly over sequential keys, and folds the high half in
+// for hashes whose low bits are all zero (Floats of small integers).
+static inline size_t table_h1(uint64_t h) {
+    return (size_t)(h ^ (h >> 32));
+}
+
+// The control byte needs 7 bits independent of the index, and small Ints
+// leave the top of their hash clear: take them from a full mix (murmur3
+// finaliser).
+static inline uint8_t table_h2(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return 0x80 | (uint8_t)(h >> 57);
+}
+
+static inline RuntimeValue *table_key(const void *slots, size_t stride, size_t i) {
+    return *(RuntimeValue *const *)((const char *)slots + i * stride);
+}
+
+// Slot of key (whose rt_hash_value is h), or SIZE_MAX.
+static size_t table_find(const uint8_t *ctrl, const uint64_t *hashes,
+                         const void *slots, size_t stride, size_t cap,
+                         uint64_t h, RuntimeValue *key) {
+    uint8_t  h2     = table_h2(h);
+    size_t   gmask  = cap / TABLE_GROUP - 1;
+    size_t   g      = table_h1(h) & gmask;
+    for (size_t step = 1; step <= gmask + 1; step++) {
+        const uint8_t *grp = ctrl + g * TABLE_GROUP;
+        for (uint64_t m = table_match(grp, h2); m; m &= m - 1) {
+            size_t        slot = g * TABLE_GROUP + table_lane(m);
+            RuntimeValue *k    = table_key(slots, stride, slot);
+            if (k == key || (hashes[slot] == h && rt_equal_p(k, key)))
+                return slot;
         }
+        if (table_match(grp, CTRL_EMPTY)) return SIZE_MAX;
+        g = (g + step) & gmask;
+    }
+    return SIZE_MAX;
+}
+
+// First empty or deleted slot on h's probe sequence.  The caller has
+// checked the key is absent and that the table has room.
+static size_t table_free_slot(const uint8_t *ctrl, size_t cap, uint64_t h) {
+    size_t   gmask = cap / TABLE_GROUP - 1;
+    size_t   g     = table_h1(h) & gmask;
+    for (size_t step = 1;; step++) {
+        const uint8_t *grp = ctrl + g * TABLE_GROUP;
+        uint64_t m = table_match(grp, CTRL_EMPTY) | table_match(grp, CTRL_DELETED);
+        if (m) return g * TABLE_GROUP + table_lane(m);
+        g = (g + step) & gmask;
     }
-    if (first_tomb != SIZE_MAX) {
-        m->buckets[first_tomb].key = key;
-        m->buckets[first_tomb].val = val;
-        m->count++;
-        m->tombstones--;
+}
+
+// Claim slot for a key hashed h.  Returns 1 when it reused a deleted slot.
+static inline int table_fill(uint8_t *ctrl, uint64_t *hashes, size_t slot, uint64_t h) {
+    int was_deleted = ctrl[slot] == CTRL_DELETED;
+    ctrl[slot]   = table_h2(h);
+    hashes[slot] = h;
+    return was_deleted;
+}
+
+// Release slot.  Returns 1 when it had to leave a CTRL_DELETED marker.
+static inline int table_clear(uint8_t *ctrl, size_t slot) {
+    const uint8_t *grp = ctrl + slot / TABLE_GROUP * TABLE_GROUP;
+    if (table_match(grp, CTRL_EMPTY)) {
+        ctrl[slot] = CTRL_EMPTY;
+        return 0;
     }
+    ctrl[slot] = CTRL_DELETED;
+    return 1;
 }
 
-static void map_resize(RuntimeMap *m) {
-    size_t          new_cap = m->capacity * 2;
-    RuntimeMapEntry *old    = m->buckets;
-    size_t          old_cap = m->capacity;
+// Capacity for the next rehash: the same when deleted slots are what
+// filled the table, which clears them, otherwise double.
+static inline size_t table_grow_cap(size_t cap, size_t count) {
+    return count * 2 >= cap * 7 / 8 ? cap * 2 : cap;
+}
+
+// hashes and ctrl for cap slots, in one block.
+static uint64_t *table_meta_alloc(size_t cap, uint8_t **ctrl) {
+    uint64_t *hashes = rt_alloc_zeroed(cap * (sizeof(uint64_t) + 1));
+    *ctrl = (uint8_t *)(hashes + cap);
+    return hashes;
+}
 
-    m->buckets    = calloc(new_cap, sizeof(RuntimeMapEntry));
-    m->capacity   = new_cap;
+static inline void table_meta_free(uint64_t *hashes, size_t cap) {
+    rt_free_sized(hashes, cap * (sizeof(uint64_t) + 1));
+}
+
+/// Map
+
+#define MAP_INITIAL_CAP TABLE_GROUP
+#define MAP_LOAD_NUM    7
+#define MAP_LOAD_DEN    8
+
+static inline int map_is_trie(const RuntimeMap *m) { return m->buckets == NULL; }
+
+static inline int map_entry_live(const RuntimeMapEntry *e) {
+    return e->key != NULL;
+}
+
+static void map_iter(CollIter *it, RuntimeMap *m) {
+    coll_iter_trie(it, m && map_is_trie(m) ? m->root : NULL);
+    if (m && !map_is_trie(m)) {
+        it->map_table = m->buckets;
+        it->capacity  = m->capacity;
+    }
+}
+
+static RuntimeMapEntry *map_iter_next(CollIter *it) {
+    if (!it->map_table) return coll_iter_trie_next(it);
+    while (it->index < it->capacity) {
+        RuntimeMapEntry *e = &it->map_table[it->index++];
+        if (map_entry_live(e)) return e;
+    }
+    return NULL;
+}
+
+// Fresh table storage of cap slots for m.
+static void map_table_init(RuntimeMap *m, size_t cap) {
+    m->buckets    = rt_alloc_zeroed(cap * sizeof(RuntimeMapEntry));
+    m->hashes     = table_meta_alloc(cap, &m->ctrl);
+    m->capacity   = cap;
     m->count      = 0;
     m->tombstones = 0;
+}
 
-    for (size_t i = 0; i < old_cap; i++) {
-        RuntimeMapEntry *e = &old[i];
-        if (e->key && e != MAP_TOMBSTONE)
-            map_insert_noresize(m, e->key, e->val);
-    }
-    free(old);
+static void map_table_free(RuntimeMap *m) {
+    rt_free_sized(m->buckets, m->capacity * sizeof(RuntimeMapEntry));
+    table_meta_free(m->hashes, m->capacity);
+    m->buckets = NULL;
+    m->hashes  = NULL;
+    m->ctrl    = NULL;
+}
+
+static RuntimeMap *map_alloc(size_t cap) {
+    RuntimeMap *m  = rt_alloc(sizeof(RuntimeMap));
+    map_table_init(m, cap);
+    m->root        = NULL;
+    return m;
+}
+
+static RuntimeMap *map_trie_new(HamtNode *root, size_t count) {
+    RuntimeMap *m  = rt_alloc(sizeof(RuntimeMap));
+    m->buckets     = NULL;
+    m->ctrl        = NULL;
+    m->hashes      = NULL;
+    m->capacity    = 0;
+    m->count       = count;
+    m->tombstones  = 0;
+    m->root        = root;
+    return m;
+}
+
+static size_t map_find_slot(RuntimeMap *m, RuntimeValue *key, uint64_t h) {
+    return table_find(m->ctrl, m->hashes, m->buckets, sizeof(RuntimeMapEntry),
+                      m->capacity, h, key);
+}
+
+// Store a key known to be absent.  The caller has made room.
+static void map_put_new(RuntimeMap *m, RuntimeValue *key, RuntimeValue *val, uint64_t h) {
+    size_t slot = table_free_slot(m->ctrl, m->capacity, h);
+    m->tombstones -= (size_t)table_fill(m->ctrl, m->hashes, slot, h);
+    m->buckets[slot].key = key;
+    m->buckets[slot].val = val;
+    m->count++;
+}
+
+// Rehash into new_cap slots from the cached hashes; keys are never
+// rehashed or compared.
+static void map_rehash(RuntimeMap *m, size_t new_cap) {
+    RuntimeMapEntry *old      = m->buckets;
+    uint64_t        *old_hash = m->hashes;
+    size_t           old_cap  = m->capacity;
+
+    map_table_init(m, new_cap);
+    for (size_t i = 0; i < old_cap; i++)
+        if (map_entry_live(&old[i]))
+            map_put_new(m, old[i].key, old[i].val, old_hash[i]);
+    rt_free_sized(old, old_cap * sizeof(RuntimeMapEntry));
+    table_meta_free(old_hash, old_cap);
 }
 
 static RuntimeMap *map_insert(RuntimeMap *m, RuntimeValue *key, RuntimeValue *val) {
-    if (!key || key->type == RT_NIL) return m;
+    if (!key || rt_type_of(key) == RT_NIL) return m;
+    uint64_t h    = rt_hash_value(key);
+    size_t   slot = map_find_slot(m, key, h);
+    if (slot != SIZE_MAX) {
+        m->buckets[slot].val = val;  /* update existing */
+        return m;
+    }
     if ((m->count + m->tombstones + 1) * MAP_LOAD_DEN
          >= m->capacity * MAP_LOAD_NUM)
-        map_resize(m);
-    map_insert_noresize(m, key, val);
+        map_rehash(m, table_grow_cap(m->capacity, m->count));
+    map_put_new(m, key, val, h);
     return m;
 }
 
 static RuntimeMap *map_remove(RuntimeMap *m, RuntimeValue *key) {
     if (!m || !key) return m;
-    size_t mask = m->capacity - 1;
-    size_t idx  = map_probe(m, key);
-
-    for (size_t i = 0; i < m->capacity; i++) {
-        size_t          slot = (idx + i) & mask;
-        RuntimeMapEntry *e   = &m->buckets[slot];
-        if (!e->key) return m;
-        if (e == MAP_TOMBSTONE) continue;
-        if (rt_equal_p(e->key, key)) {
-            e->key = MAP_TOMBSTONE->key;
-            e->val = MAP_TOMBSTONE->val;
-            m->buckets[slot] = *MAP_TOMBSTONE;
-            m->count--;
-            m->tombstones++;
-            return m;
-        }
-    }
+    size_t slot = map_find_slot(m, key, rt_hash_value(key));
+    if (slot == SIZE_MAX) return m;
+    m->buckets[slot].key = NULL;
+    m->buckets[slot].val = NULL;
+    m->tombstones += (size_t)table_clear(m->ctrl, slot);
+    m->count--;
     return m;
 }
 
+// Same capacity, so the slots, hashes and control bytes copy as they are.
 static RuntimeMap *map_copy(RuntimeMap *m) {
     RuntimeMap *copy = map_alloc(m->capacity);
+    memcpy(copy->buckets, m->buckets, m->capacity * sizeof(RuntimeMapEntry));
+    memcpy(copy->hashes, m->hashes, m->capacity * (sizeof(uint64_t) + 1));
+    copy->count      = m->count;
+    copy->tombstones = m->tombstones;
+    return copy;
+}
+
+static RuntimeMapEntry *map_lookup(RuntimeMap *m, RuntimeValue *key) {
+    uint64_t h = rt_hash_value(key);
+    if (map_is_trie(m)) return hamt_find(m->root, h, key);
+    size_t slot = map_find_slot(m, key, h);
+    return slot == SIZE_MAX ? NULL : &m->buckets[slot];
+}
+
+// The trie for m's entries.  A table-backed map is copied into a fresh
+// trie built under `edit`; m itself is left as it was.
+static HamtNode *map_trie_root(RuntimeMap *m, uint64_t edit) {
+    if (map_is_trie(m)) return m->root;
+    HamtNode *root = NULL;
+    int       added;
     for (size_t i = 0; i < m->capacity; i++) {
         RuntimeMapEntry *e = &m->buckets[i];
-        if (e->key && e != MAP_TOMBSTONE)
-            map_insert_noresize(copy, e->key, e->val);
+        if (map_entry_live(e))
+            root = hamt_assoc(root, 0, m->hashes[i], e->key, e->val,
+                              edit, &added);
     }
-    return copy;
+    return root;
+}
+
+// _mut operations work on tables: convert a trie-backed map in place.
+static void map_make_table(RuntimeMap *m) {
+    if (!map_is_trie(m)) return;
+    size_t cap = MAP_INITIAL_CAP;
+    while ((m->count + 1) * MAP_LOAD_DEN >= cap * MAP_LOAD_NUM) cap *= 2;
+
+    CollIter it;
+    coll_iter_trie(&it, m->root);
+    map_table_init(m, cap);
+    m->root       = NULL;
+    for (RuntimeMapEntry *e; (e = coll_iter_trie_next(&it)); )
+        map_put_new(m, e->key, e->val, rt_hash_value(e->key));
 }
 
 RuntimeMap *rt_map_new(void) {
@@ -1076,74 +2697,61 @@ RuntimeMap *rt_map_new(void) {
 }
 
 RuntimeMap *rt_map_assoc(RuntimeMap *m, RuntimeValue *key, RuntimeValue *val) {
-    RuntimeMap *copy = map_copy(m);
-    return map_insert(copy, key, val);
+    if (!map_is_trie(m) && m->count < COLL_TABLE_MAX)
+        return map_insert(map_copy(m), key, val);
+    if (!key || rt_type_of(key) == RT_NIL)
+        return map_trie_new(map_trie_root(m, hamt_new_edit()), m->count);
+    uint64_t  edit  = map_is_trie(m) ? 0 : hamt_new_edit();
+    int       added = 0;
+    HamtNode *root  = hamt_assoc(map_trie_root(m, edit), 0, rt_hash_value(key),
+                                 key, val, edit, &added);
+    return map_trie_new(root, m->count + (size_t)added);
 }
 
 RuntimeMap *rt_map_assoc_mut(RuntimeMap *m, RuntimeValue *key, RuntimeValue *val) {
+    map_make_table(m);
     return map_insert(m, key, val);
 }
 
 RuntimeMap *rt_map_dissoc(RuntimeMap *m, RuntimeValue *key) {
     if (!rt_map_contains(m, key)) return m;
-    return map_remove(map_copy(m), key);
+    if (!map_is_trie(m) && m->count <= COLL_TABLE_MAX)
+        return map_remove(map_copy(m), key);
+    int       removed = 0;
+    HamtNode *root    = hamt_dissoc(map_trie_root(m, hamt_new_edit()), 0,
+                                    rt_hash_value(key), key, &removed);
+    return map_trie_new(root, m->count - (size_t)removed);
 }
 
 RuntimeMap *rt_map_dissoc_mut(RuntimeMap *m, RuntimeValue *key) {
+    if (!m) return m;
+    map_make_table(m);
     return map_remove(m, key);
 }
 
 RuntimeValue *rt_map_get(RuntimeMap *m, RuntimeValue *key, RuntimeValue *default_val) {
-    if (!m || !key) return default_val ? default_val : rt_value_nil();
-    size_t mask = m->capacity - 1;
-    size_t idx  = map_probe(m, key);
-
-    for (size_t i = 0; i < m->capacity; i++) {
-        size_t          slot = (idx + i) & mask;
-        RuntimeMapEntry *e   = &m->buckets[slot];
-        if (!e->key) return default_val ? default_val : rt_value_nil();
-        if (e == MAP_TOMBSTONE) continue;
-        if (rt_equal_p(e->key, key)) return e->val;
-    }
+    RuntimeMapEntry *e = (m && key) ? map_lookup(m, key) : NULL;
+    if (e) return e->val;
     return default_val ? default_val : rt_value_nil();
 }
 
 int rt_map_contains(RuntimeMap *m, RuntimeValue *key) {
     if (!m || !key) return 0;
-    size_t mask = m->capacity - 1;
-    size_t idx  = map_probe(m, key);
-
-    for (size_t i = 0; i < m->capacity; i++) {
-        size_t          slot = (idx + i) & mask;
-        RuntimeMapEntry *e   = &m->buckets[slot];
-        if (!e->key) return 0;
-        if (e == MAP_TOMBSTONE) continue;
-        if (rt_equal_p(e->key, key)) return 1;
-    }
-    return 0;
+    return map_lookup(m, key) != NULL;
 }
 
 RuntimeValue *rt_map_find(RuntimeMap *m, RuntimeValue *key) {
     if (!m || !key) return rt_value_nil();
-    size_t mask = m->capacity - 1;
-    size_t idx  = map_probe(m, key);
-    for (size_t i = 0; i < m->capacity; i++) {
-        size_t          slot = (idx + i) & mask;
-        RuntimeMapEntry *e   = &m->buckets[slot];
-        if (!e->key)              return rt_value_nil();
-        if (e == MAP_TOMBSTONE)   continue;
-        if (rt_equal_p(e->key, key)) {
-            RuntimeList *pair = heap_list_wrapper();
-            pair->cell = NULL;
-            rt_list_append(pair, e->key);
-            rt_list_append(pair, e->val);
-            RuntimeValue *v = malloc(sizeof(RuntimeValue));
-            v->type          = RT_LIST;
-            v->data.list_val = pair;
-            return v;
-        }
-    }
-    return rt_value_nil();
+    RuntimeMapEntry *e = map_lookup(m, key);
+    if (!e) return rt_value_nil();
+    RuntimeList *pair = heap_list_wrapper();
+    pair->cell = NULL;
+    rt_list_append(pair, e->key);
+    rt_list_append(pair, e->val);
+    RuntimeValue *v = heap_value();
+    v->type          = RT_LIST;
+    v->data.list_val = pair;
+    return v;
 }
 
 int64_t rt_map_count(RuntimeMap *m) {
@@ -1151,135 +2759,167 @@ int64_t rt_map_count(RuntimeMap *m) {
 }
 
 RuntimeList *rt_map_keys(RuntimeMap *m) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    if (!m) return out;
-    for (size_t i = 0; i < m->capacity; i++) {
-        RuntimeMapEntry *e = &m->buckets[i];
-        if (e->key && e != MAP_TOMBSTONE)
-            rt_list_append(out, e->key);
-    }
-    return out;
+    ListBuilder out;
+    list_builder_init(&out);
+    CollIter it;
+    map_iter(&it, m);
+    for (RuntimeMapEntry *e; (e = map_iter_next(&it)); )
+        list_builder_push(&out, e->key);
+    return out.list;
 }
 
 RuntimeList *rt_map_vals(RuntimeMap *m) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    if (!m) return out;
-    for (size_t i = 0; i < m->capacity; i++) {
-        RuntimeMapEntry *e = &m->buckets[i];
-        if (e->key && e != MAP_TOMBSTONE)
-            rt_list_append(out, e->val);
-    }
-    return out;
+    ListBuilder out;
+    list_builder_init(&out);
+    CollIter it;
+    map_iter(&it, m);
+    for (RuntimeMapEntry *e; (e = map_iter_next(&it)); )
+        list_builder_push(&out, e->val);
+    return out.list;
 }
 
 RuntimeMap *rt_map_merge(RuntimeMap *a, RuntimeMap *b) {
-    RuntimeMap *out = map_copy(a);
-    for (size_t i = 0; i < b->capacity; i++) {
-        RuntimeMapEntry *e = &b->buckets[i];
-        if (e->key && e != MAP_TOMBSTONE)
+    CollIter it;
+    map_iter(&it, b);
+    if (!map_is_trie(a) && a->count + b->count <= COLL_TABLE_MAX) {
+        RuntimeMap *out = map_copy(a);
+        for (RuntimeMapEntry *e; (e = map_iter_next(&it)); )
             map_insert(out, e->key, e->val);
+        return out;
     }
-    return out;
+    uint64_t  edit  = hamt_new_edit();
+    HamtNode *root  = map_trie_root(a, edit);
+    size_t    count = a->count;
+    for (RuntimeMapEntry *e; (e = map_iter_next(&it)); ) {
+        int added = 0;
+        root   = hamt_assoc(root, 0, rt_hash_value(e->key), e->key, e->val,
+                            edit, &added);
+        count += (size_t)added;
+    }
+    return map_trie_new(root, count);
 }
 
 RuntimeMap *rt_map_merge_with(RuntimeMap *a, RuntimeMap *b,
                                RuntimeValue *(*fn)(RuntimeValue *, RuntimeValue *)) {
-    RuntimeMap *out = map_copy(a);
-    for (size_t i = 0; i < b->capacity; i++) {
-        RuntimeMapEntry *e = &b->buckets[i];
-        if (!e->key || e == MAP_TOMBSTONE) continue;
-        RuntimeValue *existing = rt_map_get(out, e->key, NULL);
-        if (existing && existing->type != RT_NIL)
-            map_insert(out, e->key, fn(existing, e->val));
-        else
-            map_insert(out, e->key, e->val);
+    uint64_t  edit  = hamt_new_edit();
+    HamtNode *root  = map_trie_root(a, edit);
+    size_t    count = a->count;
+    CollIter  it;
+    map_iter(&it, b);
+    for (RuntimeMapEntry *e; (e = map_iter_next(&it)); ) {
+        uint64_t         h        = rt_hash_value(e->key);
+        RuntimeMapEntry *existing = hamt_find(root, h, e->key);
+        RuntimeValue    *val      = e->val;
+        if (existing && existing->val && rt_type_of(existing->val) != RT_NIL)
+            val = fn(existing->val, e->val);
+        int added = 0;
+        root   = hamt_assoc(root, 0, h, e->key, val, edit, &added);
+        count += (size_t)added;
     }
-    return out;
+    return map_trie_new(root, count);
 }
 
 int rt_map_equal(RuntimeMap *a, RuntimeMap *b) {
     if (!a && !b) return 1;
     if (!a || !b) return 0;
     if (a->count != b->count) return 0;
-    for (size_t i = 0; i < a->capacity; i++) {
-        RuntimeMapEntry *e = &a->buckets[i];
-        if (!e->key || e == MAP_TOMBSTONE) continue;
+    CollIter it;
+    map_iter(&it, a);
+    for (RuntimeMapEntry *e; (e = map_iter_next(&it)); ) {
         RuntimeValue *bval = rt_map_get(b, e->key, NULL);
-        if (!bval || bval->type == RT_NIL) return 0;
+        if (!bval || rt_type_of(bval) == RT_NIL) return 0;
         if (!rt_equal_p(e->val, bval)) return 0;
     }
     return 1;
 }
 
+// Trie nodes may be shared with other versions, so only a table is freed.
 void rt_map_free(RuntimeMap *m) {
     if (!m) return;
-    free(m->buckets);
-    free(m);
+    if (!map_is_trie(m))
+        map_table_free(m);
+    rt_free_sized(m, sizeof(RuntimeMap));
 }
 
 RuntimeValue *rt_value_map(RuntimeMap *m) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    RuntimeValue *v = heap_value();
     v->type         = RT_MAP;
     v->data.map_val = m;
     return v;
 }
 
 RuntimeMap *rt_unbox_map(RuntimeValue *v) {
-    if (!v || v->type != RT_MAP) return rt_map_new();
+    if (!v || rt_type_of(v) != RT_MAP) return rt_map_new();
     return v->data.map_val;
 }
 
-/// Set — heap-allocated open-addressing hash set
+/// Set — heap-allocated group-probed hash set
 
-// Sentinel: a static TOMBSTONE pointer marks deleted slots.
-// Load factor threshold: 0.7 (count + tombstones).
-// Capacity is always a power of two so slot = hash & (cap-1).
+// Same table layout as the map, with the element itself in each slot.
+// Large persistent sets live in the trie above (buckets == NULL).
 
-#define SET_INITIAL_CAP 8
+#define SET_INITIAL_CAP TABLE_GROUP
 #define SET_LOAD_NUM    7
-#define SET_LOAD_DEN    10
+#define SET_LOAD_DEN    8
 
-static RuntimeValue _tombstone_val = { .type = RT_NIL };
-static RuntimeValue *TOMBSTONE = &_tombstone_val;
+static inline int set_is_trie(const RuntimeSet *s) { return s->buckets == NULL; }
 
-static uint64_t fnv1a(const char *s) {
-    uint64_t h = 14695981039346656037ULL;
-    for (; *s; s++) { h ^= (uint8_t)*s; h *= 1099511628211ULL; }
-    return h;
+static void set_iter(CollIter *it, RuntimeSet *s) {
+    coll_iter_trie(it, s && set_is_trie(s) ? s->root : NULL);
+    if (s && !set_is_trie(s)) {
+        it->set_table = s->buckets;
+        it->capacity  = s->capacity;
+    }
+}
+
+static RuntimeValue *set_iter_next(CollIter *it) {
+    if (!it->set_table) {
+        RuntimeMapEntry *e = coll_iter_trie_next(it);
+        return e ? e->key : NULL;
+    }
+    while (it->index < it->capacity) {
+        RuntimeValue *v = it->set_table[it->index++];
+        if (v) return v;
+    }
+    return NULL;
 }
 
 static uint64_t rt_hash_value(RuntimeValue *v) {
-    if (!v || v->type == RT_NIL) return 0;
+    if (!v || rt_type_of(v) == RT_NIL) return 0;
 
-    switch (v->type) {
+    switch (rt_type_of(v)) {
 
     case RT_INT:
-        return (uint64_t)v->data.int_val * 2654435761ULL;
+        return (uint64_t)rt_int_val(v) * 2654435761ULL;
 
     case RT_FLOAT: {
+        double   d = rt_float_val(v);
         uint64_t bits;
-        memcpy(&bits, &v->data.float_val, sizeof(bits));
+        memcpy(&bits, &d, sizeof(bits));
         return bits * 2654435761ULL;
     }
 
     case RT_CHAR:
-        return (uint64_t)(unsigned char)v->data.char_val * 2654435761ULL;
+        return (uint64_t)(unsigned char)rt_char_val(v) * 2654435761ULL;
 
     case RT_STRING:
-        return fnv1a(v->data.string_val);
-
     case RT_SYMBOL:
-        return fnv1a(v->data.symbol_val);
-
     case RT_KEYWORD:
-        return fnv1a(v->data.keyword_val);
+        return string_hash(v);
 
     case RT_RATIO:
         return (uint64_t)v->data.ratio_val.numerator   * 2654435761ULL
              ^ (uint64_t)v->data.ratio_val.denominator * 40503ULL;
 
+    case RT_BIGNUM: {
+        mpz_srcptr z = v->data.bignum_val;
+        size_t     n = mpz_size(z);
+        uint64_t   h = (uint64_t)mpz_sgn(z);
+        for (size_t i = 0; i < n; i++)
+            h = h * 31 + (uint64_t)mpz_getlimbn(z, i) * 2654435761ULL;
+        return h;
+    }
+
     case RT_LIST: {
         uint64_t h = 0;
         RuntimeList *cur = v->data.list_val;
@@ -1291,27 +2931,29 @@ static uint64_t rt_hash_value(RuntimeValue *v) {
         return h;
     }
 
+    case RT_VECTOR: {
+        uint64_t h = 0;
+        int64_t  n = rt_vector_count(v->data.vector_val);
+        for (int64_t i = 0; i < n && i < 8; i++)
+            h = h * 31 + rt_hash_value(rt_vector_nth(v->data.vector_val, i));
+        return h;
+    }
+
     case RT_SET: {
         uint64_t h = 0;
-        RuntimeSet *s = v->data.set_val;
-        if (!s) return 0;
-        for (size_t i = 0; i < s->capacity; i++) {
-            RuntimeValue *elem = s->buckets[i];
-            if (elem && elem != TOMBSTONE)
-                h ^= rt_hash_value(elem);
-        }
+        CollIter it;
+        set_iter(&it, v->data.set_val);
+        for (RuntimeValue *elem; (elem = set_iter_next(&it)); )
+            h ^= rt_hash_value(elem);
         return h;
     }
 
     case RT_MAP: {
         uint64_t h = 0;
-        RuntimeMap *m = v->data.map_val;
-        if (!m) return 0;
-        for (size_t i = 0; i < m->capacity; i++) {
-            RuntimeMapEntry *e = &m->buckets[i];
-            if (e->key && e != MAP_TOMBSTONE)
-                h ^= rt_hash_value(e->key) * 31 + rt_hash_value(e->val);
-        }
+        CollIter it;
+        map_iter(&it, v->data.map_val);
+        for (RuntimeMapEntry *e; (e = map_iter_next(&it)); )
+            h ^= rt_hash_value(e->key) * 31 + rt_hash_value(e->val);
         return h;
     }
 
@@ -1320,64 +2962,110 @@ static uint64_t rt_hash_value(RuntimeValue *v) {
     }
 }
 
+static void set_table_init(RuntimeSet *s, size_t cap) {
+    s->buckets    = rt_alloc_zeroed(cap * sizeof(RuntimeValue *));
+    s->hashes     = table_meta_alloc(cap, &s->ctrl);
+    s->capacity   = cap;
+    s->count      = 0;
+    s->tombstones = 0;
+}
+
+static void set_table_free(RuntimeSet *s) {
+    rt_free_sized(s->buckets, s->capacity * sizeof(RuntimeValue *));
+    table_meta_free(s->hashes, s->capacity);
+    s->buckets = NULL;
+    s->hashes  = NULL;
+    s->ctrl    = NULL;
+}
+
 static RuntimeSet *set_alloc(size_t cap) {
-    RuntimeSet *s   = malloc(sizeof(RuntimeSet));
-    s->buckets      = calloc(cap, sizeof(RuntimeValue *));
-    s->capacity     = cap;
-    s->count        = 0;
-    s->tombstones   = 0;
+    RuntimeSet *s   = rt_alloc(sizeof(RuntimeSet));
+    set_table_init(s, cap);
     s->membership_predicate = NULL;
+    s->root         = NULL;
     return s;
 }
 
-static void set_insert_noresize(RuntimeSet *s, RuntimeValue *val) {
-    uint64_t h    = rt_hash_value(val);
-    size_t   mask = s->capacity - 1;
-    size_t   idx  = (size_t)(h & mask);
-    size_t   first_tomb = SIZE_MAX;
+static RuntimeSet *set_trie_new(HamtNode *root, size_t count, RuntimeValue *pred) {
+    RuntimeSet *s   = rt_alloc(sizeof(RuntimeSet));
+    s->buckets      = NULL;
+    s->ctrl         = NULL;
+    s->hashes       = NULL;
+    s->capacity     = 0;
+    s->count        = count;
+    s->tombstones   = 0;
+    s->membership_predicate = pred;
+    s->root         = root;
+    return s;
+}
 
-    for (size_t i = 0; i < s->capacity; i++) {
-        size_t slot = (idx + i) & mask;
-        RuntimeValue *cur = s->buckets[slot];
-
-        if (!cur) {
-            /* empty slot */
-            size_t write = (first_tomb != SIZE_MAX) ? first_tomb : slot;
-            s->buckets[write] = val;
-            s->count++;
-            if (first_tomb != SIZE_MAX) s->tombstones--;
-            return;
-        }
-        if (cur == TOMBSTONE) {
-            if (first_tomb == SIZE_MAX) first_tomb = slot;
-            continue;
-        }
-        if (rt_equal_p(cur, val)) return; /* already present */
-    }
-    /* table full (shouldn't happen if resize works) */
-    if (first_tomb != SIZE_MAX) {
-        s->buckets[first_tomb] = val;
-        s->count++;
-        s->tombstones--;
-    }
+static size_t set_find_slot(RuntimeSet *s, RuntimeValue *val, uint64_t h) {
+    return table_find(s->ctrl, s->hashes, s->buckets, sizeof(RuntimeValue *),
+                      s->capacity, h, val);
 }
 
-static void set_resize(RuntimeSet *s) {
-    size_t     new_cap  = s->capacity * 2;
-    RuntimeValue **old  = s->buckets;
-    size_t     old_cap  = s->capacity;
+/* Internal: store an element known to be absent.  The caller has made
+ * room.                                                                  */
+static void set_put_new(RuntimeSet *s, RuntimeValue *val, uint64_t h) {
+    size_t slot = table_free_slot(s->ctrl, s->capacity, h);
+    s->tombstones -= (size_t)table_fill(s->ctrl, s->hashes, slot, h);
+    s->buckets[slot] = val;
+    s->count++;
+}
 
-    s->buckets    = calloc(new_cap, sizeof(RuntimeValue *));
-    s->capacity   = new_cap;
-    s->count      = 0;
-    s->tombstones = 0;
+/* Internal: rehash into new_cap slots from the cached hashes.           */
+static void set_rehash(RuntimeSet *s, size_t new_cap) {
+    RuntimeValue **old      = s->buckets;
+    uint64_t      *old_hash = s->hashes;
+    size_t         old_cap  = s->capacity;
+
+    set_table_init(s, new_cap);
+    for (size_t i = 0; i < old_cap; i++)
+        if (old[i]) set_put_new(s, old[i], old_hash[i]);
+    rt_free_sized(old, old_cap * sizeof(RuntimeValue *));
+    table_meta_free(old_hash, old_cap);
+}
+
+/* Internal: the element equal to val (whose hash is h), or NULL. */
+static RuntimeValue *set_lookup_hashed(RuntimeSet *s, RuntimeValue *val, uint64_t h) {
+    if (set_is_trie(s)) {
+        RuntimeMapEntry *e = hamt_find(s->root, h, val);
+        return e ? e->key : NULL;
+    }
+    size_t slot = set_find_slot(s, val, h);
+    return slot == SIZE_MAX ? NULL : s->buckets[slot];
+}
+
+static RuntimeValue *set_lookup(RuntimeSet *s, RuntimeValue *val) {
+    return set_lookup_hashed(s, val, rt_hash_value(val));
+}
 
-    for (size_t i = 0; i < old_cap; i++) {
-        RuntimeValue *v = old[i];
-        if (v && v != TOMBSTONE)
-            set_insert_noresize(s, v);
+/* Internal: s's elements as a trie.  A table-backed set is copied into a
+ * fresh trie built under edit; s itself is left as it was.               */
+static HamtNode *set_trie_root(RuntimeSet *s, uint64_t edit) {
+    if (set_is_trie(s)) return s->root;
+    HamtNode *root = NULL;
+    int       added;
+    for (size_t i = 0; i < s->capacity; i++) {
+        RuntimeValue *v = s->buckets[i];
+        if (v)
+            root = hamt_assoc(root, 0, s->hashes[i], v, NULL, edit, &added);
     }
-    free(old);
+    return root;
+}
+
+/* Internal: _mut operations work on tables; convert a trie in place. */
+static void set_make_table(RuntimeSet *s) {
+    if (!set_is_trie(s)) return;
+    size_t cap = SET_INITIAL_CAP;
+    while ((s->count + 1) * SET_LOAD_DEN >= cap * SET_LOAD_NUM) cap *= 2;
+
+    CollIter it;
+    coll_iter_trie(&it, s->root);
+    set_table_init(s, cap);
+    s->root       = NULL;
+    for (RuntimeMapEntry *e; (e = coll_iter_trie_next(&it)); )
+        set_put_new(s, e->key, rt_hash_value(e->key));
 }
 
 RuntimeSet *rt_set_new(void) {
@@ -1386,7 +3074,7 @@ RuntimeSet *rt_set_new(void) {
 
 RuntimeSet *rt_set_from_predicate(RuntimeValue *predicate) {
     RuntimeSet *set = rt_set_new();
-    if (predicate && predicate->type == RT_CLOSURE)
+    if (predicate && rt_type_of(predicate) == RT_CLOSURE)
         set->membership_predicate = predicate;
     return set;
 }
@@ -1394,99 +3082,111 @@ RuntimeSet *rt_set_from_predicate(RuntimeValue *predicate) {
 int rt_set_contains(RuntimeSet *s, RuntimeValue *val) {
     if (!s || !val) return 0;
     if (s->membership_predicate) {
-        RuntimeValue *args[] = {val};
-        RuntimeValue *result = rt_closure_calln(s->membership_predicate, 1, args);
+        RuntimeValue *result = rt_closure_call1(s->membership_predicate, val);
         if (rt_unbox_int(result) != 0) return 1;
     }
-    uint64_t h    = rt_hash_value(val);
-    size_t   mask = s->capacity - 1;
-    size_t   idx  = (size_t)(h & mask);
-
-    for (size_t i = 0; i < s->capacity; i++) {
-        size_t        slot = (idx + i) & mask;
-        RuntimeValue *cur  = s->buckets[slot];
-        if (!cur)          return 0;
-        if (cur == TOMBSTONE) continue;
-        if (rt_equal_p(cur, val)) return 1;
-    }
-    return 0;
+    return set_lookup(s, val) != NULL;
 }
 
 RuntimeValue *rt_set_get(RuntimeSet *s, RuntimeValue *key) {
     if (!s || !key) return rt_value_nil();
-    uint64_t h    = rt_hash_value(key);
-    size_t   mask = s->capacity - 1;
-    size_t   idx  = (size_t)(h & mask);
-
-    for (size_t i = 0; i < s->capacity; i++) {
-        size_t        slot = (idx + i) & mask;
-        RuntimeValue *cur  = s->buckets[slot];
-        if (!cur)          return rt_value_nil();
-        if (cur == TOMBSTONE) continue;
-        if (rt_equal_p(cur, key)) return cur;
-    }
-    return rt_value_nil();
+    RuntimeValue *found = set_lookup(s, key);
+    return found ? found : rt_value_nil();
 }
 
-/* Internal: insert val into s without copying. Resizes in place if needed.
- * Returns s. Caller owns s.                                               */
-static RuntimeSet *set_insert(RuntimeSet *s, RuntimeValue *val) {
-    if (!val || val->type == RT_NIL) return s;
+/* Internal: insert val (whose hash is h) into s without copying.
+ * Rehashes in place if needed.  Returns s. Caller owns s.                */
+static RuntimeSet *set_insert_hashed(RuntimeSet *s, RuntimeValue *val, uint64_t h) {
+    if (set_find_slot(s, val, h) != SIZE_MAX) return s; /* already present */
     if ((s->count + s->tombstones + 1) * SET_LOAD_DEN
          >= s->capacity * SET_LOAD_NUM)
-        set_resize(s);
-    set_insert_noresize(s, val);
+        set_rehash(s, table_grow_cap(s->capacity, s->count));
+    set_put_new(s, val, h);
     return s;
 }
 
+static RuntimeSet *set_insert(RuntimeSet *s, RuntimeValue *val) {
+    if (!val || rt_type_of(val) == RT_NIL) return s;
+    return set_insert_hashed(s, val, rt_hash_value(val));
+}
+
 /* Internal: remove val from s without copying.
  * Returns s. Caller owns s.                                               */
 static RuntimeSet *set_remove(RuntimeSet *s, RuntimeValue *val) {
     if (!s || !val) return s;
-    uint64_t h    = rt_hash_value(val);
-    size_t   mask = s->capacity - 1;
-    size_t   idx  = (size_t)(h & mask);
-    for (size_t i = 0; i < s->capacity; i++) {
-        size_t        slot = (idx + i) & mask;
-        RuntimeValue *cur  = s->buckets[slot];
-        if (!cur) return s;
-        if (cur == TOMBSTONE) continue;
-        if (rt_equal_p(cur, val)) {
-            s->buckets[slot] = TOMBSTONE;
-            s->count--;
-            s->tombstones++;
-            return s;
-        }
-    }
+    size_t slot = set_find_slot(s, val, rt_hash_value(val));
+    if (slot == SIZE_MAX) return s;
+    s->buckets[slot] = NULL;
+    s->tombstones += (size_t)table_clear(s->ctrl, slot);
+    s->count--;
     return s;
 }
 
-/* Internal: shallow copy of s into a new set of the same capacity. */
+/* Internal: shallow copy of a table-backed s into a new set of the same
+ * capacity; slots, hashes and control bytes copy as they are.            */
 static RuntimeSet *set_copy(RuntimeSet *s) {
     RuntimeSet *copy = set_alloc(s->capacity);
     copy->membership_predicate = s->membership_predicate;
-    for (size_t i = 0; i < s->capacity; i++) {
-        RuntimeValue *v = s->buckets[i];
-        if (v && v != TOMBSTONE)
-            set_insert_noresize(copy, v);
-    }
+    memcpy(copy->buckets, s->buckets, s->capacity * sizeof(RuntimeValue *));
+    memcpy(copy->hashes, s->hashes, s->capacity * (sizeof(uint64_t) + 1));
+    copy->count      = s->count;
+    copy->tombstones = s->tombstones;
     return copy;
 }
 
-/* Immutable — return a new set */
-RuntimeSet *rt_set_conj(RuntimeSet *s, RuntimeValue *val)
- {return set_insert(set_copy(s), val);}
+/* Internal: add val (whose hash is h) to a set the caller is still
+ * building.  Stays a table up to COLL_TABLE_MAX elements, then moves to a
+ * trie edited in place.                                                  */
+static void set_build_add_hashed(RuntimeSet *s, RuntimeValue *val, uint64_t h,
+                                 uint64_t edit) {
+    if (!set_is_trie(s)) {
+        if (s->count < COLL_TABLE_MAX) { set_insert_hashed(s, val, h); return; }
+        HamtNode *root = set_trie_root(s, edit);
+        set_table_free(s);
+        s->capacity   = 0;
+        s->tombstones = 0;
+        s->root       = root;
+    }
+    int added = 0;
+    s->root   = hamt_assoc(s->root, 0, h, val, NULL, edit, &added);
+    s->count += (size_t)added;
+}
+
+static void set_build_add(RuntimeSet *s, RuntimeValue *val, uint64_t edit) {
+    if (!val || rt_type_of(val) == RT_NIL) return;
+    set_build_add_hashed(s, val, rt_hash_value(val), edit);
+}
 
-RuntimeSet *rt_set_disj(RuntimeSet *s, RuntimeValue *val)
-{if (!rt_set_contains(s, val)) return s;
-    return set_remove(set_copy(s), val);}
+/* Immutable — return a new set */
+RuntimeSet *rt_set_conj(RuntimeSet *s, RuntimeValue *val) {
+    if (!set_is_trie(s) && s->count < COLL_TABLE_MAX)
+        return set_insert(set_copy(s), val);
+    if (!val || rt_type_of(val) == RT_NIL)
+        return set_trie_new(set_trie_root(s, hamt_new_edit()), s->count,
+                            s->membership_predicate);
+    uint64_t  edit  = set_is_trie(s) ? 0 : hamt_new_edit();
+    int       added = 0;
+    HamtNode *root  = hamt_assoc(set_trie_root(s, edit), 0, rt_hash_value(val),
+                                 val, NULL, edit, &added);
+    return set_trie_new(root, s->count + (size_t)added, s->membership_predicate);
+}
+
+RuntimeSet *rt_set_disj(RuntimeSet *s, RuntimeValue *val) {
+    if (!rt_set_contains(s, val)) return s;
+    if (!set_is_trie(s) && s->count <= COLL_TABLE_MAX)
+        return set_remove(set_copy(s), val);
+    int       removed = 0;
+    HamtNode *root    = hamt_dissoc(set_trie_root(s, hamt_new_edit()), 0,
+                                    rt_hash_value(val), val, &removed);
+    return set_trie_new(root, s->count - (size_t)removed, s->membership_predicate);
+}
 
 /* Mutable — modify in place, return s */
 RuntimeSet *rt_set_conj_mut(RuntimeSet *s, RuntimeValue *val)
-{return set_insert(s, val);}
+{set_make_table(s); return set_insert(s, val);}
 
 RuntimeSet *rt_set_disj_mut(RuntimeSet *s, RuntimeValue *val)
-{return set_remove(s, val);}
+{if (!s) return s; set_make_table(s); return set_remove(s, val);}
 
 
 
@@ -1497,19 +3197,17 @@ int64_t rt_set_count(RuntimeSet *s) {
 }
 
 RuntimeList *rt_set_seq(RuntimeSet *s) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    if (!s) return out;
-    for (size_t i = 0; i < s->capacity; i++) {
-        RuntimeValue *v = s->buckets[i];
-        if (v && v != TOMBSTONE)
-            rt_list_append(out, v);
-    }
-    return out;
+    ListBuilder out;
+    list_builder_init(&out);
+    CollIter it;
+    set_iter(&it, s);
+    for (RuntimeValue *v; (v = set_iter_next(&it)); )
+        list_builder_push(&out, v);
+    return out.list;
 }
 
 RuntimeValue *__rt_set_intersection(RuntimeValue *left, RuntimeValue *right) {
-    if (!left || !right || left->type != RT_SET || right->type != RT_SET)
+    if (!left || !right || rt_type_of(left) != RT_SET || rt_type_of(right) != RT_SET)
         return rt_value_set(rt_set_new());
 
     RuntimeSet *result = rt_set_new();
@@ -1518,11 +3216,29 @@ RuntimeValue *__rt_set_intersection(RuntimeValue *left, RuntimeValue *right) {
     if (!source || !membership)
         return rt_value_set(result);
 
-    for (size_t i = 0; i < source->capacity; i++) {
-        RuntimeValue *value = source->buckets[i];
-        if (value && value != TOMBSTONE &&
-            rt_set_contains(membership, value))
-            rt_set_conj_mut(result, value);
+    uint64_t edit = hamt_new_edit();
+    CollIter it;
+    if (membership->membership_predicate) {
+        set_iter(&it, source);
+        for (RuntimeValue *value; (value = set_iter_next(&it)); )
+            if (rt_set_contains(membership, value))
+                set_build_add(result, value, edit);
+        return rt_value_set(result);
+    }
+
+    /* Walk the smaller side and probe the other with the walked table's
+     * cached hashes (slot it.index - 1), so a table element is never
+     * rehashed.  The result keeps the left operand's elements.           */
+    int         swap  = membership->count < source->count;
+    RuntimeSet *walk  = swap ? membership : source;
+    RuntimeSet *other = swap ? source : membership;
+    set_iter(&it, walk);
+    for (RuntimeValue *value; (value = set_iter_next(&it)); ) {
+        uint64_t      h     = set_is_trie(walk) ? rt_hash_value(value)
+                                                : walk->hashes[it.index - 1];
+        RuntimeValue *found = set_lookup_hashed(other, value, h);
+        if (found)
+            set_build_add_hashed(result, swap ? found : value, h, edit);
     }
     return rt_value_set(result);
 }
@@ -1533,26 +3249,27 @@ int rt_set_equal(RuntimeSet *a, RuntimeSet *b) {
     if (a->membership_predicate || b->membership_predicate)
         return a == b;
     if (a->count != b->count) return 0;
-    for (size_t i = 0; i < a->capacity; i++) {
-        RuntimeValue *v = a->buckets[i];
-        if (v && v != TOMBSTONE)
-            if (!rt_set_contains(b, v)) return 0;
-    }
+    CollIter it;
+    set_iter(&it, a);
+    for (RuntimeValue *v; (v = set_iter_next(&it)); )
+        if (!rt_set_contains(b, v)) return 0;
     return 1;
 }
 
 RuntimeSet *rt_set_of(RuntimeValue **vals, size_t n) {
-    RuntimeSet *s = rt_set_new();
+    RuntimeSet *s    = rt_set_new();
+    uint64_t    edit = hamt_new_edit();
     for (size_t i = 0; i < n; i++)
-        rt_set_conj(s, vals[i]);
+        set_build_add(s, vals[i], edit);
     return s;
 }
 
 RuntimeSet *rt_set_from_list(RuntimeList *list) {
-    RuntimeSet  *s   = rt_set_new();
-    RuntimeList *cur = list;
+    RuntimeSet  *s    = rt_set_new();
+    uint64_t     edit = hamt_new_edit();
+    RuntimeList *cur  = list;
     while (!rt_list_is_empty_list(cur)) {
-        set_insert(s, rt_list_car(cur));
+        set_build_add(s, rt_list_car(cur), edit);
         cur = rt_list_cdr(cur);
     }
     return s;
@@ -1560,11 +3277,10 @@ RuntimeSet *rt_set_from_list(RuntimeList *list) {
 
 RuntimeSet *rt_set_from_array(RuntimeValue *array_rv) {
     RuntimeSet *s = rt_set_new();
-    if (!array_rv || array_rv->type != RT_ARRAY) return s;
-    for (size_t i = 0; i < array_rv->data.array_val.length; i++) {
-        RuntimeValue *v = array_rv->data.array_val.elements[i];
-        if (v) set_insert(s, v);
-    }
+    if (!array_rv || rt_type_of(array_rv) != RT_ARRAY) return s;
+    uint64_t edit = hamt_new_edit();
+    for (size_t i = 0; i < array_rv->data.array_val.length; i++)
+        set_build_add(s, array_rv->data.array_val.elements[i], edit);
     return s;
 }
 
@@ -1573,60 +3289,467 @@ RuntimeSet *rt_set_from_array(RuntimeValue *array_rv) {
 RuntimeValue *rt_set_foldl(RuntimeSet *s, RuntimeValue *init,
                             void *env, RT_BinaryFn fn) {
     RuntimeValue *acc = init;
-    if (!s) return acc;
-    for (size_t i = 0; i < s->capacity; i++) {
-        RuntimeValue *v = s->buckets[i];
-        if (v && v != TOMBSTONE)
-            { RuntimeValue *_a[] = {acc, v}; acc = fn(env, 2, _a); }
-    }
+    CollIter it;
+    set_iter(&it, s);
+    for (RuntimeValue *v; (v = set_iter_next(&it)); )
+        { RuntimeValue *_a[] = {acc, v}; acc = fn(env, 2, _a); }
     return acc;
 }
 
 RuntimeList *rt_set_map(RuntimeSet *s, void *env, RT_UnaryFn fn) {
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
-    if (!s) return out;
-    for (size_t i = 0; i < s->capacity; i++) {
-        RuntimeValue *v = s->buckets[i];
-        if (v && v != TOMBSTONE)
-            { RuntimeValue *_a[] = {v}; rt_list_append(out, fn(env, 1, _a)); }
-    }
-    return out;
+    ListBuilder out;
+    list_builder_init(&out);
+    CollIter it;
+    set_iter(&it, s);
+    for (RuntimeValue *v; (v = set_iter_next(&it)); )
+        { RuntimeValue *_a[] = {v}; list_builder_push(&out, fn(env, 1, _a)); }
+    return out.list;
 }
 
 RuntimeSet *rt_set_filter(RuntimeSet *s, void *env, RT_UnaryFn pred) {
-    RuntimeSet *out = rt_set_new();
-    if (!s) return out;
-    for (size_t i = 0; i < s->capacity; i++) {
-        RuntimeValue *v = s->buckets[i];
-        if (v && v != TOMBSTONE) {
-            RuntimeValue *_pa[] = {v}; RuntimeValue *result = pred(env, 1, _pa);
-            if (rt_unbox_int(result) != 0)
-                set_insert(out, v);
-        }
+    RuntimeSet *out  = rt_set_new();
+    uint64_t    edit = hamt_new_edit();
+    CollIter    it;
+    set_iter(&it, s);
+    for (RuntimeValue *v; (v = set_iter_next(&it)); ) {
+        RuntimeValue *_pa[] = {v}; RuntimeValue *result = pred(env, 1, _pa);
+        if (rt_unbox_int(result) != 0)
+            set_build_add(out, v, edit);
     }
     return out;
 }
 
+/* Trie nodes may be shared with other versions, so only a table is freed. */
 void rt_set_free(RuntimeSet *s) {
     if (!s) return;
-    free(s->buckets);
-    free(s);
+    if (!set_is_trie(s))
+        set_table_free(s);
+    rt_free_sized(s, sizeof(RuntimeSet));
 }
 
 RuntimeValue *rt_value_set(RuntimeSet *s) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    RuntimeValue *v = heap_value();
     v->type         = RT_SET;
     v->data.set_val = s;
     return v;
 }
 
 RuntimeSet *rt_unbox_set(RuntimeValue *v) {
-    if (!v || v->type != RT_SET) return rt_set_new();
+    if (!v || rt_type_of(v) != RT_SET) return rt_set_new();
     return v->data.set_val;
 }
 
 
+/// Persistent vector (RRB tree)
+//
+//  See RuntimeVector in runtime.h.  Leaves hold values; internal nodes hold
+//  children followed by their cumulative subtree sizes, so any internal
+//  node may be relaxed and a lookup is a radix guess plus a short forward
+//  scan.  concat merges the right spine of one tree with the left spine of
+//  the other and redistributes the nodes on the seam with Bagwell and
+//  Rompf's concatenation plan, keeping at most VEC_EXTRA more nodes than
+//  the optimum.  Edit tokens work as in the HAMT: a node stamped with the
+//  caller's token is updated in place, anything else is copied.
+
+#define VEC_BITS  5
+#define VEC_WIDTH RT_VECTOR_WIDTH
+#define VEC_EXTRA 2
+
+typedef struct VecNode {
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t edit;
+    void    *slots[VEC_WIDTH];
+    // internal nodes only: size_t sizes[VEC_WIDTH];
+} VecNode;
+
+static inline size_t *vec_sizes(VecNode *n) {
+    return (size_t *)(void *)(n->slots + VEC_WIDTH);
+}
+
+static VecNode *vec_node_new(uint32_t shift, uint64_t edit) {
+    VecNode *n = rt_alloc(sizeof(VecNode) + (shift ? VEC_WIDTH * sizeof(size_t) : 0));
+    n->count    = 0;
+    n->reserved = 0;
+    n->edit     = edit;
+    return n;
+}
+
+static VecNode *vec_copy(VecNode *n, uint32_t shift, uint64_t edit) {
+    VecNode *out = vec_node_new(shift, edit);
+    out->count = n->count;
+    memcpy(out->slots, n->slots, n->count * sizeof(void *));
+    if (shift) memcpy(vec_sizes(out), vec_sizes(n), n->count * sizeof(size_t));
+    return out;
+}
+
+static inline VecNode *vec_editable(VecNode *n, uint32_t shift, uint64_t edit) {
+    return edit && n->edit == edit ? n : vec_copy(n, shift, edit);
+}
+
+static inline size_t vec_size(VecNode *n, uint32_t shift) {
+    return shift ? vec_sizes(n)[n->count - 1] : n->count;
+}
+
+// Child of internal node n holding *i; *i becomes the index inside it.
+// A child holds at most 1 << shift values, so i >> shift never overshoots.
+static inline uint32_t vec_locate(VecNode *n, uint32_t shift, size_t *i) {
+    size_t  *sizes = vec_sizes(n);
+    uint32_t j     = (uint32_t)(*i >> shift);
+    while (sizes[j] <= *i) j++;
+    if (j) *i -= sizes[j - 1];
+    return j;
+}
+
+static void vec_append_child(VecNode *p, VecNode *child, uint32_t child_shift) {
+    size_t before = p->count ? vec_sizes(p)[p->count - 1] : 0;
+    p->slots[p->count]     = child;
+    vec_sizes(p)[p->count] = before + vec_size(child, child_shift);
+    p->count++;
+}
+
+static RuntimeVector *vec_header(size_t count, uint32_t shift, VecNode *root) {
+    RuntimeVector *v = rt_alloc(sizeof(RuntimeVector));
+    v->count    = count;
+    v->shift    = shift;
+    v->reserved = 0;
+    v->edit     = 0;
+    v->root     = root;
+    return v;
+}
+
+static VecNode *vec_assoc(VecNode *n, uint32_t shift, size_t i,
+                          RuntimeValue *val, uint64_t edit) {
+    VecNode *out = vec_editable(n, shift, edit);
+    if (!shift) {
+        out->slots[i] = val;
+        return out;
+    }
+    uint32_t j = vec_locate(n, shift, &i);
+    out->slots[j] = vec_assoc(n->slots[j], shift - VEC_BITS, i, val, edit);
+    return out;
+}
+
+// A fresh spine from height `shift` down to a leaf holding val.
+static VecNode *vec_path(uint32_t shift, RuntimeValue *val, uint64_t edit) {
+    VecNode *n = vec_node_new(0, edit);
+    n->slots[n->count++] = val;
+    for (uint32_t s = VEC_BITS; s <= shift; s += VEC_BITS) {
+        VecNode *p = vec_node_new(s, edit);
+        vec_append_child(p, n, s - VEC_BITS);
+        n = p;
+    }
+    return n;
+}
+
+// Append along the right spine; NULL when every node on it is full.
+static VecNode *vec_push(VecNode *n, uint32_t shift, RuntimeValue *val, uint64_t edit) {
+    if (!shift) {
+        if (n->count == VEC_WIDTH) return NULL;
+        VecNode *out = vec_editable(n, 0, edit);
+        out->slots[out->count++] = val;
+        return out;
+    }
+    uint32_t last  = n->count - 1;
+    VecNode *child = vec_push(n->slots[last], shift - VEC_BITS, val, edit);
+    if (!child && n->count == VEC_WIDTH) return NULL;
+    VecNode *out = vec_editable(n, shift, edit);
+    if (child) {
+        out->slots[last] = child;
+        vec_sizes(out)[last]++;
+    } else {
+        vec_append_child(out, vec_path(shift - VEC_BITS, val, edit), shift - VEC_BITS);
+    }
+    return out;
+}
+
+static void vec_conj_into(RuntimeVector *v, RuntimeValue *val, uint64_t edit) {
+    if (!v->root) {
+        v->root  = vec_path(0, val, edit);
+        v->shift = 0;
+    } else {
+        VecNode *r = vec_push(v->root, v->shift, val, edit);
+        if (!r) {
+            r = vec_node_new(v->shift + VEC_BITS, edit);
+            vec_append_child(r, v->root, v->shift);
+            vec_append_child(r, vec_path(v->shift, val, edit), v->shift);
+            v->shift += VEC_BITS;
+        }
+        v->root = r;
+    }
+    v->count++;
+}
+
+// First `end` (>= 1) values of n's subtree.
+static VecNode *vec_take(VecNode *n, uint32_t shift, size_t end) {
+    if (end == vec_size(n, shift)) return n;
+    if (!shift) {
+        VecNode *out = vec_copy(n, 0, 0);
+        out->count = (uint32_t)end;
+        return out;
+    }
+    size_t   i = end - 1;
+    uint32_t j = vec_locate(n, shift, &i);
+    VecNode *out = vec_copy(n, shift, 0);
+    out->count          = j + 1;
+    out->slots[j]       = vec_take(n->slots[j], shift - VEC_BITS, i + 1);
+    vec_sizes(out)[j]   = end;
+    return out;
+}
+
+// n's subtree without its first `start` values (start < its size).
+static VecNode *vec_skip(VecNode *n, uint32_t shift, size_t start) {
+    if (!start) return n;
+    VecNode *out = vec_node_new(shift, 0);
+    if (!shift) {
+        out->count = n->count - (uint32_t)start;
+        memcpy(out->slots, n->slots + start, out->count * sizeof(void *));
+        return out;
+    }
+    size_t   i = start;
+    uint32_t j = vec_locate(n, shift, &i);
+    out->count    = n->count - j;
+    out->slots[0] = vec_skip(n->slots[j], shift - VEC_BITS, i);
+    memcpy(out->slots + 1, n->slots + j + 1, (out->count - 1) * sizeof(void *));
+    for (uint32_t k = 0; k < out->count; k++)
+        vec_sizes(out)[k] = vec_sizes(n)[j + k] - start;
+    return out;
+}
+
+// Gather the children of l (all but its last), mid and r (all but its
+// first), all of height `shift` - VEC_BITS, redistribute their slots when
+// there are more than VEC_EXTRA nodes over the optimum, and pack the result
+// into a node of height shift + VEC_BITS holding one or two children.
+static VecNode *vec_rebalance(VecNode *l, VecNode *mid, VecNode *r, uint32_t shift) {
+    uint32_t cs = shift - VEC_BITS;           // height of the gathered nodes
+    VecNode *all[3 * VEC_WIDTH];
+    uint32_t plan[3 * VEC_WIDTH];
+    uint32_t n = 0, total = 0;
+
+    if (l)  for (uint32_t k = 0; k + 1 < l->count; k++) all[n++] = l->slots[k];
+    for (uint32_t k = 0; k < mid->count; k++)          all[n++] = mid->slots[k];
+    if (r)  for (uint32_t k = 1; k < r->count; k++)     all[n++] = r->slots[k];
+    for (uint32_t k = 0; k < n; k++) total += plan[k] = all[k]->count;
+
+    uint32_t len = n, opt = (total + VEC_WIDTH - 1) / VEC_WIDTH;
+    for (uint32_t i = 0; len > opt + VEC_EXTRA; ) {
+        while (plan[i] > VEC_WIDTH - VEC_EXTRA / 2) i++;
+        uint32_t rem = plan[i];
+        do {
+            uint32_t fill = rem + plan[i + 1] < VEC_WIDTH ? rem + plan[i + 1] : VEC_WIDTH;
+            rem     = rem + plan[i + 1] - fill;
+            plan[i] = fill;
+            i++;
+        } while (rem);
+        for (uint32_t k = i; k + 1 < len; k++) plan[k] = plan[k + 1];
+        len--;
+        i--;
+    }
+
+    VecNode *nodes[3 * VEC_WIDTH];
+    if (len == n) {
+        memcpy(nodes, all, n * sizeof(VecNode *));
+    } else {
+        uint32_t src = 0, off = 0;
+        for (uint32_t k = 0; k < len; k++) {
+            if (!off && all[src]->count == plan[k]) {
+                nodes[k] = all[src++];
+                continue;
+            }
+            VecNode *node = vec_node_new(cs, 0);
+            while (node->count < plan[k]) {
+                VecNode *s    = all[src];
+                uint32_t take = plan[k] - node->count;
+                if (take > s->count - off) take = s->count - off;
+                if (cs) {
+                    for (uint32_t t = 0; t < take; t++)
+                        vec_append_child(node, s->slots[off + t], cs - VEC_BITS);
+                } else {
+                    memcpy(node->slots + node->count, s->slots + off, take * sizeof(void *));
+                    node->count += take;
+                }
+                off += take;
+                if (off == s->count) { src++; off = 0; }
+            }
+            nodes[k] = node;
+        }
+    }
+
+    VecNode *top = vec_node_new(shift + VEC_BITS, 0);
+    for (uint32_t k = 0; k < len; k += VEC_WIDTH) {
+        VecNode *p = vec_node_new(shift, 0);
+        for (uint32_t t = k; t < len && t < k + VEC_WIDTH; t++)
+            vec_append_child(p, nodes[t], cs);
+        vec_append_child(top, p, shift);
+    }
+    return top;
+}
+
+// Node of height max(ls, rs) + VEC_BITS with one or two children holding
+// l's values followed by r's.
+static VecNode *vec_concat_sub(VecNode *l, uint32_t ls, VecNode *r, uint32_t rs) {
+    if (ls > rs) {
+        VecNode *mid = vec_concat_sub(l->slots[l->count - 1], ls - VEC_BITS, r, rs);
+        return vec_rebalance(l, mid, NULL, ls);
+    }
+    if (ls < rs) {
+        VecNode *mid = vec_concat_sub(l, ls, r->slots[0], rs - VEC_BITS);
+        return vec_rebalance(NULL, mid, r, rs);
+    }
+    if (ls) {
+        VecNode *mid = vec_concat_sub(l->slots[l->count - 1], ls - VEC_BITS,
+                                      r->slots[0], rs - VEC_BITS);
+        return vec_rebalance(l, mid, r, ls);
+    }
+    VecNode *top = vec_node_new(VEC_BITS, 0);
+    if (l->count + r->count <= VEC_WIDTH) {
+        VecNode *leaf = vec_copy(l, 0, 0);
+        memcpy(leaf->slots + leaf->count, r->slots, r->count * sizeof(void *));
+        leaf->count += r->count;
+        vec_append_child(top, leaf, 0);
+    } else {
+        vec_append_child(top, l, 0);
+        vec_append_child(top, r, 0);
+    }
+    return top;
+}
+
+static void vec_seq_into(VecNode *n, uint32_t shift, ListBuilder *out) {
+    for (uint32_t k = 0; k < n->count; k++) {
+        if (shift) vec_seq_into(n->slots[k], shift - VEC_BITS, out);
+        else       list_builder_push(out, n->slots[k]);
+    }
+}
+
+RuntimeVector *rt_vector_new(void) {
+    return vec_header(0, 0, NULL);
+}
+
+RuntimeVector *rt_vector_of(RuntimeValue **vals, size_t n) {
+    RuntimeVector *v = rt_vector_transient(rt_vector_new());
+    for (size_t i = 0; i < n; i++) rt_vector_conj_mut(v, vals[i]);
+    return rt_vector_persistent(v);
+}
+
+RuntimeVector *rt_vector_from_list(RuntimeList *list) {
+    RuntimeVector *v = rt_vector_transient(rt_vector_new());
+    for (RuntimeList *cur = list; !rt_list_is_empty_list(cur); cur = rt_list_cdr(cur))
+        rt_vector_conj_mut(v, rt_list_car(cur));
+    return rt_vector_persistent(v);
+}
+
+RuntimeVector *rt_vector_from_array(RuntimeValue *array_rv) {
+    if (!array_rv || rt_type_of(array_rv) != RT_ARRAY) return rt_vector_new();
+    return rt_vector_of(array_rv->data.array_val.elements, array_rv->data.array_val.length);
+}
+
+int64_t rt_vector_count(RuntimeVector *v) {
+    return v ? (int64_t)v->count : 0;
+}
+
+RuntimeValue *rt_vector_nth(RuntimeVector *v, int64_t index) {
+    if (!v || index < 0 || (size_t)index >= v->count) return rt_value_nil();
+    size_t   i = (size_t)index;
+    VecNode *n = v->root;
+    for (uint32_t s = v->shift; s; s -= VEC_BITS)
+        n = n->slots[vec_locate(n, s, &i)];
+    return n->slots[i];
+}
+
+RuntimeVector *rt_vector_assoc(RuntimeVector *v, int64_t index, RuntimeValue *val) {
+    if (!v) v = rt_vector_new();
+    if (index == (int64_t)v->count) return rt_vector_conj(v, val);
+    if (index < 0 || (size_t)index > v->count) {
+        fprintf(stderr, "Error: vector index out of bounds\n"); exit(1);
+    }
+    return vec_header(v->count, v->shift, vec_assoc(v->root, v->shift, (size_t)index, val, 0));
+}
+
+RuntimeVector *rt_vector_conj(RuntimeVector *v, RuntimeValue *val) {
+    RuntimeVector *out = v ? vec_header(v->count, v->shift, v->root) : rt_vector_new();
+    vec_conj_into(out, val, 0);
+    return out;
+}
+
+RuntimeVector *rt_vector_concat(RuntimeVector *a, RuntimeVector *b) {
+    if (!a || !a->count) return b ? b : rt_vector_new();
+    if (!b || !b->count) return a;
+    VecNode *top   = vec_concat_sub(a->root, a->shift, b->root, b->shift);
+    uint32_t shift = (a->shift > b->shift ? a->shift : b->shift) + VEC_BITS;
+    if (top->count == 1) {
+        top    = top->slots[0];
+        shift -= VEC_BITS;
+    }
+    return vec_header(a->count + b->count, shift, top);
+}
+
+RuntimeVector *rt_vector_slice(RuntimeVector *v, int64_t start, int64_t end) {
+    if (!v) return rt_vector_new();
+    if (start < 0) start = 0;
+    if (end > (int64_t)v->count) end = (int64_t)v->count;
+    if (start >= end) return rt_vector_new();
+    if (start == 0 && end == (int64_t)v->count) return v;
+    VecNode *root  = vec_take(v->root, v->shift, (size_t)end);
+    uint32_t shift = v->shift;
+    root = vec_skip(root, shift, (size_t)start);
+    while (shift && root->count == 1) {
+        root   = root->slots[0];
+        shift -= VEC_BITS;
+    }
+    return vec_header((size_t)(end - start), shift, root);
+}
+
+RuntimeVector *rt_vector_transient(RuntimeVector *v) {
+    RuntimeVector *out = v ? vec_header(v->count, v->shift, v->root) : rt_vector_new();
+    out->edit = hamt_new_edit();
+    return out;
+}
+
+RuntimeVector *rt_vector_assoc_mut(RuntimeVector *v, int64_t index, RuntimeValue *val) {
+    if (index == (int64_t)v->count) return rt_vector_conj_mut(v, val);
+    if (index < 0 || (size_t)index > v->count) {
+        fprintf(stderr, "Error: vector index out of bounds\n"); exit(1);
+    }
+    v->root = vec_assoc(v->root, v->shift, (size_t)index, val, v->edit);
+    return v;
+}
+
+RuntimeVector *rt_vector_conj_mut(RuntimeVector *v, RuntimeValue *val) {
+    vec_conj_into(v, val, v->edit);
+    return v;
+}
+
+RuntimeVector *rt_vector_persistent(RuntimeVector *v) {
+    v->edit = 0;
+    return v;
+}
+
+RuntimeList *rt_vector_seq(RuntimeVector *v) {
+    ListBuilder out;
+    list_builder_init(&out);
+    if (v && v->root) vec_seq_into(v->root, v->shift, &out);
+    return out.list;
+}
+
+int rt_vector_equal(RuntimeVector *a, RuntimeVector *b) {
+    if (rt_vector_count(a) != rt_vector_count(b)) return 0;
+    for (int64_t i = 0; i < rt_vector_count(a); i++)
+        if (!rt_equal_p(rt_vector_nth(a, i), rt_vector_nth(b, i))) return 0;
+    return 1;
+}
+
+RuntimeValue *rt_value_vector(RuntimeVector *v) {
+    RuntimeValue *out = heap_value();
+    out->type            = RT_VECTOR;
+    out->data.vector_val = v;
+    return out;
+}
+
+RuntimeVector *rt_unbox_vector(RuntimeValue *v) {
+    if (!v || rt_type_of(v) != RT_VECTOR) return rt_vector_new();
+    return v->data.vector_val;
+}
+
 ///  Equality
 
 int rt_equal_p(RuntimeValue *a, RuntimeValue *b) {
@@ -1634,21 +3757,21 @@ int rt_equal_p(RuntimeValue *a, RuntimeValue *b) {
     if (!a || !b) return 0;
     // Normalize: if a pointer has an out-of-range type tag, treat as raw RuntimeList*
     {
-        int ta = (int)a->type;
+        int ta = (int)rt_type_of(a);
         if (ta < 0 || ta > RT_CLOSURE) {
             RuntimeValue tmp_a = {.type = RT_LIST, .data = {.list_val = (RuntimeList*)a}};
             return rt_equal_p(&tmp_a, b);
         }
-        int tb = (int)b->type;
+        int tb = (int)rt_type_of(b);
         if (tb < 0 || tb > RT_CLOSURE) {
             RuntimeValue tmp_b = {.type = RT_LIST, .data = {.list_val = (RuntimeList*)b}};
             return rt_equal_p(a, &tmp_b);
         }
     }
-    if (a->type == RT_THUNK) a = rt_force(a->data.thunk_val);
-    if (b->type == RT_THUNK) b = rt_force(b->data.thunk_val);
-    if (a->type == RT_NIL && b->type == RT_NIL) return 1;
-    if (a->type == RT_ARRAY && b->type == RT_LIST) {
+    if (rt_type_of(a) == RT_THUNK) a = rt_force(a->data.thunk_val);
+    if (rt_type_of(b) == RT_THUNK) b = rt_force(b->data.thunk_val);
+    if (rt_type_of(a) == RT_NIL && rt_type_of(b) == RT_NIL) return 1;
+    if (rt_type_of(a) == RT_ARRAY && rt_type_of(b) == RT_LIST) {
         RuntimeList *lb = b->data.list_val;
         for (size_t i = 0; i < a->data.array_val.length; i++) {
             if (rt_list_is_empty_list(lb)) return 0;
@@ -1657,26 +3780,29 @@ int rt_equal_p(RuntimeValue *a, RuntimeValue *b) {
         }
         return rt_list_is_empty_list(lb);
     }
-    if (a->type == RT_LIST && b->type == RT_ARRAY) {
+    if (rt_type_of(a) == RT_LIST && rt_type_of(b) == RT_ARRAY) {
         return rt_equal_p(b, a);
     }
-    if (a->type != b->type) return 0;
-    switch (a->type) {
-        case RT_INT:     return a->data.int_val   == b->data.int_val;
-        case RT_FLOAT:   return a->data.float_val == b->data.float_val;
-        case RT_CHAR:    return a->data.char_val  == b->data.char_val;
-        case RT_STRING:  return strcmp(a->data.string_val,  b->data.string_val)  == 0;
-        case RT_SYMBOL:  return strcmp(a->data.symbol_val,  b->data.symbol_val)  == 0;
-        case RT_KEYWORD: return strcmp(a->data.keyword_val, b->data.keyword_val) == 0;
+    if (rt_type_of(a) != rt_type_of(b)) return 0;
+    switch (rt_type_of(a)) {
+        case RT_INT:     return rt_int_val(a)   == rt_int_val(b);
+        case RT_BIGNUM:  return mpz_cmp(a->data.bignum_val, b->data.bignum_val) == 0;
+        case RT_FLOAT:   return rt_float_val(a) == rt_float_val(b);
+        case RT_CHAR:    return rt_char_val(a)  == rt_char_val(b);
+        case RT_STRING:
+        case RT_SYMBOL:
+        case RT_KEYWORD: return string_equal(a, b);
         case RT_NIL:     return 1;
         case RT_SET:     return rt_set_equal(a->data.set_val, b->data.set_val);
         case RT_MAP:
-            if (b->type != RT_MAP) return 0;
+            if (rt_type_of(b) != RT_MAP) return 0;
             return rt_map_equal(a->data.map_val, b->data.map_val);
         case RT_OPAQUE:
             return a->data.opaque_val == b->data.opaque_val;
+        case RT_VECTOR:
+            return rt_vector_equal(a->data.vector_val, b->data.vector_val);
         case RT_ARRAY: {
-            if (b->type != RT_ARRAY) return 0;
+            if (rt_type_of(b) != RT_ARRAY) return 0;
             if (a->data.array_val.length != b->data.array_val.length) return 0;
             for (size_t i = 0; i < a->data.array_val.length; i++) {
                 if (!rt_equal_p(a->data.array_val.elements[i], b->data.array_val.elements[i])) return 0;
@@ -1704,62 +3830,64 @@ int64_t rt_unbox_int(RuntimeValue *v) {
     /* Raw integer values (e.g. I4, U15) are passed directly as iN —
      * any pointer below the minimum heap address is the value itself. */
     if ((uintptr_t)v < 0x10000) return (int64_t)(uintptr_t)v;
-    if (!v || v->type == RT_NIL) return 0;
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (v->type == RT_INT)   return v->data.int_val;
-    if (v->type == RT_FLOAT) return (int64_t)v->data.float_val;
-    if (v->type == RT_CHAR)  return (int64_t)v->data.char_val;
+    if (!v || rt_type_of(v) == RT_NIL) return 0;
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_INT)   return rt_int_val(v);
+    if (rt_type_of(v) == RT_FLOAT) return (int64_t)rt_float_val(v);
+    if (rt_type_of(v) == RT_CHAR)  return (int64_t)rt_char_val(v);
     return 0;
 }
 
 double rt_unbox_float(RuntimeValue *v) {
-    if (!v || v->type == RT_NIL) return 0.0;
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (v->type == RT_FLOAT) return v->data.float_val;
-    if (v->type == RT_INT)   return (double)v->data.int_val;
-    if (v->type == RT_CHAR)  return (double)v->data.char_val;
+    if (!v || rt_type_of(v) == RT_NIL) return 0.0;
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_FLOAT) return rt_float_val(v);
+    if (rt_type_of(v) == RT_INT)   return (double)rt_int_val(v);
+    if (rt_type_of(v) == RT_CHAR)  return (double)rt_char_val(v);
     return 0.0;
 }
 
 char rt_unbox_char(RuntimeValue *v) {
-    if (!v || v->type == RT_NIL) return 0;
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (v->type == RT_CHAR) return v->data.char_val;
-    if (v->type == RT_INT)  return (char)v->data.int_val;
+    if (!v || rt_type_of(v) == RT_NIL) return 0;
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_CHAR) return rt_char_val(v);
+    if (rt_type_of(v) == RT_INT)  return (char)rt_int_val(v);
     return 0;
 }
 
 char *rt_unbox_string(RuntimeValue *v) {
-    if (!v || v->type == RT_NIL) return "";
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (v->type == RT_STRING) return v->data.string_val;
+    if (!v || rt_type_of(v) == RT_NIL) return "";
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_STRING) return rt_string_chars(v);
     return "";
 }
 
 RuntimeList *rt_unbox_list(RuntimeValue *v) {
     if (!v) return rt_list_empty();
     if ((uintptr_t)v < 0x10000) return rt_list_empty(); /* Protect against unboxed integers */
-    int tag = (int)v->type;
+    int tag = (int)rt_type_of(v);
     if (tag < 0 || tag > RT_CLOSURE) {
         /* Treat as raw RuntimeList* */
         return (RuntimeList *)v;
     }
-    if (v->type == RT_NIL) return rt_list_empty();
-    if (v->type == RT_THUNK) v = rt_force(v->data.thunk_val);
-    if (v->type == RT_LIST) return v->data.list_val;
-    if (v->type == RT_SET)  return rt_set_seq(v->data.set_val);
-    if (v->type == RT_ARRAY) {
-        RuntimeList *lst = rt_list_new();
+    if (rt_type_of(v) == RT_NIL) return rt_list_empty();
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_LIST) return v->data.list_val;
+    if (rt_type_of(v) == RT_SET)  return rt_set_seq(v->data.set_val);
+    if (rt_type_of(v) == RT_VECTOR) return rt_vector_seq(v->data.vector_val);
+    if (rt_type_of(v) == RT_ARRAY) {
+        ListBuilder out;
+        list_builder_init(&out);
         for (size_t i = 0; i < v->data.array_val.length; i++) {
-            rt_list_append(lst, v->data.array_val.elements[i]);
+            list_builder_push(&out, v->data.array_val.elements[i]);
         }
-        return lst;
+        return out.list;
     }
     return rt_list_empty();
 }
 
 int rt_value_is_nil(RuntimeValue *v) {
-    return (!v || v->type == RT_NIL) ? 1 : 0;
+    return (!v || rt_type_of(v) == RT_NIL) ? 1 : 0;
 }
 
 void rt_print_value_newline(RuntimeValue *v) {
@@ -1773,22 +3901,23 @@ void rt_print_value_newline(RuntimeValue *v) {
 //  LONG-LIVED (heap): string, symbol, keyword, ratio, array
 //
 RuntimeValue *rt_value_int(int64_t val) {
-    // Step 2: integer interning — zero allocations for 0..65536
-    int_cache_init();
-    if (val >= INT_CACHE_MIN && val <= INT_CACHE_MAX)
-        return &g_int_cache_storage[val - INT_CACHE_MIN];
+    // Step 2: immediate unless the payload does not fit in 50 bits
+    if (val >= RT_IMM_INT_MIN && val <= RT_IMM_INT_MAX)
+        return (RuntimeValue *)(uintptr_t)
+            (RT_IMM_INT | ((uint64_t)val & ((1ULL << RT_IMM_INT_BITS) - 1)));
     RuntimeValue *v = alloc_value();
     v->type = RT_INT; v->data.int_val = val; return v;
 }
 
 RuntimeValue *rt_value_float(double val) {
-    RuntimeValue *v = alloc_value();
-    v->type = RT_FLOAT; v->data.float_val = val; return v;
+    uint64_t bits;
+    if (val != val) bits = 0x7ff8000000000000ULL;  // one NaN keeps the range free
+    else            memcpy(&bits, &val, sizeof(bits));
+    return (RuntimeValue *)(uintptr_t)(bits + RT_IMM_FLOAT);
 }
 
 RuntimeValue *rt_value_char(char val) {
-    RuntimeValue *v = alloc_value();
-    v->type = RT_CHAR; v->data.char_val = val; return v;
+    return (RuntimeValue *)(uintptr_t)(RT_IMM_CHAR | (unsigned char)val);
 }
 
 RuntimeValue *rt_value_opaque(void *p) {
@@ -1804,8 +3933,7 @@ RuntimeValue *rt_value_list(RuntimeList *val) {
 }
 
 RuntimeValue *rt_value_nil(void) {
-    RuntimeValue *v = alloc_value();
-    v->type = RT_NIL; return v;
+    return (RuntimeValue *)(uintptr_t)RT_IMM_NIL;
 }
 
 RuntimeValue *rt_value_thunk(RuntimeThunk *thunk) {
@@ -1815,16 +3943,13 @@ RuntimeValue *rt_value_thunk(RuntimeThunk *thunk) {
 
 // Heap-allocated (long-lived)
 RuntimeValue *rt_value_string(const char *val) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
-    v->type = RT_STRING; v->data.string_val = strdup(val); return v;
+    return rt_value_string_n(val, strlen(val));
 }
 RuntimeValue *rt_value_symbol(const char *val) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
-    v->type = RT_SYMBOL; v->data.symbol_val = strdup(val); return v;
+    return intern(RT_SYMBOL, val);
 }
 RuntimeValue *rt_value_keyword(const char *val) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
-    v->type = RT_KEYWORD; v->data.keyword_val = strdup(val); return v;
+    return intern(RT_KEYWORD, val);
 }
 
 ///  Printing
@@ -1836,11 +3961,11 @@ static void rt_print_list_indent(RuntimeList *list, int indent);
 // Estimate if a value prints short enough to stay inline
 static bool rt_value_is_short(RuntimeValue *val, int budget) {
     if (!val || budget <= 0) return false;
-    switch (val->type) {
+    switch (rt_type_of(val)) {
         case RT_INT:    return true;
         case RT_FLOAT:  return true;
-        case RT_SYMBOL: return (int)strlen(val->data.symbol_val) < budget;
-        case RT_STRING: return (int)strlen(val->data.string_val) + 2 < budget;
+        case RT_SYMBOL: return (int)rt_string_length(val) < budget;
+        case RT_STRING: return (int)rt_string_length(val) + 2 < budget;
         case RT_NIL:    return true;
         case RT_LIST: {
             // Short if all elements are atoms and total is under budget
@@ -1849,13 +3974,13 @@ static bool rt_value_is_short(RuntimeValue *val, int budget) {
             while (!rt_list_is_empty_list(cur)) {
                 RuntimeValue *h = rt_list_car(cur);
                 if (!h) return false;
-                if (h->type == RT_LIST) {
+                if (rt_type_of(h) == RT_LIST) {
                     // Allow one level of nesting if it's short
                     if (!rt_value_is_short(h, budget / 2)) return false;
                     total += budget / 2;
-                } else if (h->type == RT_SYMBOL) {
-                    total += strlen(h->data.symbol_val) + 1;
-                } else if (h->type == RT_INT || h->type == RT_FLOAT) {
+                } else if (rt_type_of(h) == RT_SYMBOL) {
+                    total += rt_string_length(h) + 1;
+                } else if (rt_type_of(h) == RT_INT || rt_type_of(h) == RT_FLOAT) {
                     total += 8;
                 } else {
                     return false;
@@ -1889,6 +4014,19 @@ static void rt_print_list_indent(RuntimeList *list, int indent) {
         if (!first) printf(" ");
         first = 0;
 
+        // Chunked run: print the remaining slots, then step to the rest
+        if (list_is_chunk(cur)) {
+            ListChunk *ch    = list_chunk(cur);
+            uint32_t   start = list_chunk_index(cur, ch);
+            for (uint32_t i = start; i < ch->count; i++) {
+                if (i > start) printf(" ");
+                rt_print_value_indent(ch->slots[i].value, indent + 2);
+                if (++count % 64 == 0) fflush(stdout);
+            }
+            cur = list_chunk_rest(ch);
+            continue;
+        }
+
         // Force and print the head
         RuntimeValue *h = _force_head(cur->cell);
         rt_print_value_indent(h, indent + 2);
@@ -1896,10 +4034,10 @@ static void rt_print_list_indent(RuntimeList *list, int indent) {
         // Force and inspect the tail
         RuntimeValue *tail_v = _force_tail(cur->cell);
 
-        if (!tail_v || tail_v->type == RT_NIL) {
+        if (!tail_v || rt_type_of(tail_v) == RT_NIL) {
             // Proper list end
             break;
-        } else if (tail_v->type == RT_LIST) {
+        } else if (rt_type_of(tail_v) == RT_LIST) {
             // Continue traversal for proper lists
             cur = tail_v->data.list_val;
         } else {
@@ -1920,15 +4058,15 @@ static void rt_print_list_indent(RuntimeList *list, int indent) {
 
 static void rt_print_value_indent(RuntimeValue *val, int indent) {
     if (!val) { printf("nil"); return; }
-    if (val->type == RT_THUNK) {
+    if (rt_type_of(val) == RT_THUNK) {
         val = rt_force(val->data.thunk_val);
         if (!val) { printf("nil"); return; }
     }
-    switch (val->type) {
-        case RT_INT:     printf("%ld",  val->data.int_val);   break;
-        case RT_FLOAT:   printf("%g",   val->data.float_val); break;
-        case RT_CHAR:    printf("'%c'", val->data.char_val);  break;
-        case RT_STRING:  printf("\"%s\"", val->data.string_val); break;
+    switch (rt_type_of(val)) {
+        case RT_INT:     printf("%ld",  rt_int_val(val));   break;
+        case RT_FLOAT:   printf("%g",   rt_float_val(val)); break;
+        case RT_CHAR:    printf("'%c'", rt_char_val(val));  break;
+        case RT_STRING:  printf("\"%s\"", rt_string_chars(val)); break;
         case RT_SYMBOL:  printf("%s",   val->data.symbol_val);   break;
         case RT_KEYWORD: printf(":%s", val->data.keyword_val);  break;
         case RT_NIL:     printf("nil"); break;
@@ -1959,17 +4097,26 @@ static void rt_print_value_indent(RuntimeValue *val, int indent) {
             }
             printf("]");
             break;
+        case RT_VECTOR: {
+            RuntimeVector *vec = val->data.vector_val;
+            printf("[");
+            for (int64_t i = 0; i < rt_vector_count(vec); i++) {
+                if (i > 0) printf(" ");
+                rt_print_value_indent(rt_vector_nth(vec, i), indent);
+            }
+            printf("]");
+            break;
+        }
         case RT_SET: {
             RuntimeSet *s = val->data.set_val;
             printf("{");
             int first = 1;
-            for (size_t i = 0; i < s->capacity; i++) {
-                RuntimeValue *elem = s->buckets[i];
-                if (elem && elem != TOMBSTONE) {
-                    if (!first) printf(" ");
-                    rt_print_value_indent(elem, indent);
-                    first = 0;
-                }
+            CollIter it;
+            set_iter(&it, s);
+            for (RuntimeValue *elem; (elem = set_iter_next(&it)); ) {
+                if (!first) printf(" ");
+                rt_print_value_indent(elem, indent);
+                first = 0;
             }
             printf("}");
             break;
@@ -1981,11 +4128,10 @@ static void rt_print_value_indent(RuntimeValue *val, int indent) {
             /* Collect live entries */
             RuntimeMapEntry *entries[4096];
             int count = 0;
-            for (size_t i = 0; i < m->capacity && count < 4095; i++) {
-                RuntimeMapEntry *e = &m->buckets[i];
-                if (e->key && e != MAP_TOMBSTONE)
-                    entries[count++] = e;
-            }
+            CollIter it;
+            map_iter(&it, m);
+            for (RuntimeMapEntry *e; count < 4095 && (e = map_iter_next(&it)); )
+                entries[count++] = e;
 
             /* Measure max key width using snprintf into a scratch buffer */
             int max_key_w = 0;
@@ -1993,12 +4139,12 @@ static void rt_print_value_indent(RuntimeValue *val, int indent) {
                 char buf[256];
                 int  w = 0;
                 RuntimeValue *k = entries[i]->key;
-                switch (k->type) {
-                case RT_STRING:  w = snprintf(buf, sizeof(buf), "\"%s\"", k->data.string_val);  break;
+                switch (rt_type_of(k)) {
+                case RT_STRING:  w = snprintf(buf, sizeof(buf), "\"%s\"", rt_string_chars(k)); break;
                 case RT_KEYWORD: w = snprintf(buf, sizeof(buf), "%s",     k->data.keyword_val); break;
                 case RT_SYMBOL:  w = snprintf(buf, sizeof(buf), "%s",     k->data.symbol_val);  break;
-                case RT_INT:     w = snprintf(buf, sizeof(buf), "%ld",    k->data.int_val);     break;
-                case RT_FLOAT:   w = snprintf(buf, sizeof(buf), "%g",     k->data.float_val);   break;
+                case RT_INT:     w = snprintf(buf, sizeof(buf), "%ld",    rt_int_val(k));     break;
+                case RT_FLOAT:   w = snprintf(buf, sizeof(buf), "%g",     rt_float_val(k));   break;
                 default:         w = 4; break;
                 }
                 if (w > max_key_w) max_key_w = w;
@@ -2012,12 +4158,12 @@ static void rt_print_value_indent(RuntimeValue *val, int indent) {
                 }
                 RuntimeValue *k = entries[i]->key;
                 int w = 0;
-                switch (k->type) {
-                case RT_STRING:  w = printf("\"%s\"", k->data.string_val);  break;
+                switch (rt_type_of(k)) {
+                case RT_STRING:  w = printf("\"%s\"", rt_string_chars(k)); break;
                 case RT_KEYWORD: w = printf("%s",     k->data.keyword_val); break;
                 case RT_SYMBOL:  w = printf("%s",     k->data.symbol_val);  break;
-                case RT_INT:     w = printf("%ld",    k->data.int_val);     break;
-                case RT_FLOAT:   w = printf("%g",     k->data.float_val);   break;
+                case RT_INT:     w = printf("%ld",    rt_int_val(k));     break;
+                case RT_FLOAT:   w = printf("%g",     rt_float_val(k));   break;
                 default:
                     rt_print_value_indent(k, indent);
                     w = 4;
@@ -2033,9 +4179,12 @@ static void rt_print_value_indent(RuntimeValue *val, int indent) {
         }
 
         case RT_BIGNUM: {
+            // The string comes from GMP's allocator, which may be the GC heap
+            void (*gmp_free)(void *, size_t);
+            mp_get_memory_functions(NULL, NULL, &gmp_free);
             char *s = mpz_get_str(NULL, 10, val->data.bignum_val);
             printf("%s", s);
-            free(s);
+            gmp_free(s, strlen(s) + 1);
             break;
         }
         case RT_THUNK: printf("<thunk>"); break;
@@ -2077,15 +4226,24 @@ void rt_value_free(RuntimeValue *val) {
     if (!val) return;
     // Only free the heap-allocated payload inside the value.
     // The RuntimeValue struct itself is arena memory — do NOT free(val).
-    switch (val->type) {
-        case RT_STRING:  free(val->data.string_val);  break;
-        case RT_SYMBOL:  free(val->data.symbol_val);  break;
-        case RT_KEYWORD: free(val->data.keyword_val); break;
+    switch (rt_type_of(val)) {
+        case RT_STRING: {
+            // A flattened rope's node is left to the collector.
+            RuntimeString *h = rt_string_header(val->data.string_val);
+            if (h->flags & RT_STR_ROPE)
+                rt_free_sized(string_rope(h), sizeof(StringRope) + string_flat_size(0));
+            else
+                rt_free_sized(h, string_flat_size(h->length));
+            break;
+        }
+        case RT_SYMBOL:
+        case RT_KEYWORD: break;   // interned
         case RT_ARRAY:
             if (val->data.array_val.elements) {
                 for (size_t i = 0; i < val->data.array_val.length; i++)
                     rt_value_free(val->data.array_val.elements[i]);
-                free(val->data.array_val.elements);
+                rt_free_sized(val->data.array_val.elements,
+                              val->data.array_val.length * sizeof(RuntimeValue *));
             }
             break;
         case RT_MAP:
@@ -2093,7 +4251,7 @@ void rt_value_free(RuntimeValue *val) {
             break;
         case RT_BIGNUM:
             mpz_clear(val->data.bignum_val);
-            free(val);  // bignum is always heap-allocated
+            rt_free_sized(val, sizeof(RuntimeValue));  // bignum is always heap-allocated
             break;
         default: break;
     }
@@ -2105,65 +4263,265 @@ void rt_list_free(RuntimeList *list) {
     (void)list;
 }
 
-/// Bignum
+/// Bignum
+//
+//  Integer arithmetic that cannot lose precision.  Operands may be RT_INT or
+//  RT_BIGNUM in any mix; two ints take an __builtin_*_overflow fast path and
+//  only reach GMP when it trips.  Results that fit an int64 come back as
+//  RT_INT (usually an immediate), so a value is RT_BIGNUM only when it must
+//  be — rt_equal_p can then compare bignums structurally.  Mixed operations
+//  view the int operand as a read-only mpz on the stack; nothing is
+//  allocated for it.
+
+typedef struct { mpz_t z; mp_limb_t limbs[2]; } BignumView;
+
+static mpz_srcptr bignum_view_i64(BignumView *t, int64_t n) {
+    uint64_t  mag = n < 0 ? -(uint64_t)n : (uint64_t)n;
+    mp_size_t size;
+    t->limbs[0] = (mp_limb_t)mag;
+    if (GMP_NUMB_BITS >= 64) {
+        size = mag != 0;
+    } else {
+        t->limbs[1] = (mp_limb_t)(mag >> (GMP_NUMB_BITS % 64));
+        size = t->limbs[1] ? 2 : t->limbs[0] != 0;
+    }
+    return mpz_roinit_n(t->z, t->limbs, n < 0 ? -size : size);
+}
+
+static mpz_srcptr bignum_operand(BignumView *t, RuntimeValue *v) {
+    if (rt_type_of(v) == RT_THUNK) v = rt_force(v->data.thunk_val);
+    if (rt_type_of(v) == RT_BIGNUM) return v->data.bignum_val;
+    return bignum_view_i64(t, rt_type_of(v) == RT_INT ? rt_int_val(v) : 0);
+}
+
+static int bignum_fits_i64(mpz_srcptr z) {
+    if (mpz_sizeinbase(z, 2) <= 63) return 1;
+    // INT64_MIN is the one 64-bit magnitude that still fits
+    return mpz_sgn(z) < 0 && mpz_sizeinbase(z, 2) == 64 && mpz_scan1(z, 0) == 63;
+}
+
+static int64_t bignum_get_i64(mpz_srcptr z) {
+    uint64_t mag = 0;
+    size_t   n   = 0;
+    if (mpz_sgn(z) == 0) return 0;
+    mpz_export(&mag, &n, -1, sizeof(mag), 0, 0, z);
+    return mpz_sgn(z) < 0 ? (int64_t)(0 - mag) : (int64_t)mag;
+}
+
+// Box or demote a freshly computed value; takes ownership of v.
+static RuntimeValue *bignum_normalize(RuntimeValue *v) {
+    if (!bignum_fits_i64(v->data.bignum_val)) return v;
+    int64_t n = bignum_get_i64(v->data.bignum_val);
+    mpz_clear(v->data.bignum_val);
+    rt_free_sized(v, sizeof(RuntimeValue));
+    return rt_value_int(n);
+}
+
+static RuntimeValue *bignum_new(void) {
+    RuntimeValue *v = heap_value();
+    v->type = RT_BIGNUM;
+    mpz_init(v->data.bignum_val);
+    return v;
+}
+
+static int bignum_small(RuntimeValue *v, int64_t *out) {
+    if (rt_type_of(v) != RT_INT) return 0;
+    *out = rt_int_val(v);
+    return 1;
+}
 
 RuntimeValue *rt_value_bignum_from_i64(int64_t n) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
-    v->type = RT_BIGNUM;
-    mpz_init_set_si(v->data.bignum_val, n);
+    RuntimeValue *v = bignum_new();
+    mpz_set(v->data.bignum_val, bignum_view_i64(&(BignumView){0}, n));
     return v;
 }
 
 RuntimeValue *rt_value_bignum_from_str(const char *s) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    RuntimeValue *v = heap_value();
     v->type = RT_BIGNUM;
     mpz_init_set_str(v->data.bignum_val, s, 10);
-    return v;
+    return bignum_normalize(v);
 }
 
-static inline RuntimeValue *rt_int_add_safe(RuntimeValue *a, RuntimeValue *b) {
-    // both RT_INT: check overflow via __builtin_add_overflow
-    int64_t result;
-    if (!__builtin_add_overflow(a->data.int_val, b->data.int_val, &result))
-        return rt_value_int(result);
-    // overflow — promote both to bignum and add
-    RuntimeValue *ba = rt_value_bignum_from_i64(a->data.int_val);
-    RuntimeValue *bb = rt_value_bignum_from_i64(b->data.int_val);
-    return rt_bignum_add(ba, bb);
+RuntimeValue *rt_promote_to_bignum(RuntimeValue *v) {
+    if (rt_value_is_bignum(v)) return v;
+    return rt_value_bignum_from_i64(rt_type_of(v) == RT_INT ? rt_int_val(v) : 0);
 }
 
-RuntimeValue *rt_bignum_add(RuntimeValue *a, RuntimeValue *b) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
-    v->type = RT_BIGNUM;
-    mpz_init(v->data.bignum_val);
-    mpz_add(v->data.bignum_val, a->data.bignum_val, b->data.bignum_val);
+int rt_value_is_bignum(RuntimeValue *v) {
+    return v && rt_type_of(v) == RT_BIGNUM;
+}
+
+#define BIGNUM_BINOP(name, builtin, mpz_op)                                  \
+    RuntimeValue *name(RuntimeValue *a, RuntimeValue *b) {                   \
+        int64_t x, y, r;                                                     \
+        if (bignum_small(a, &x) && bignum_small(b, &y) &&                    \
+            !builtin(x, y, &r))                                              \
+            return rt_value_int(r);                                          \
+        BignumView ta, tb;                                                   \
+        RuntimeValue *v = bignum_new();                                      \
+        mpz_op(v->data.bignum_val, bignum_operand(&ta, a),                   \
+               bignum_operand(&tb, b));                                      \
+        return bignum_normalize(v);                                          \
+    }
+
+BIGNUM_BINOP(rt_bignum_add, __builtin_add_overflow, mpz_add)
+BIGNUM_BINOP(rt_bignum_sub, __builtin_sub_overflow, mpz_sub)
+BIGNUM_BINOP(rt_bignum_mul, __builtin_mul_overflow, mpz_mul)
+
+#undef BIGNUM_BINOP
+
+// Truncating division, like int64 `/`.  Division by zero raises.
+RuntimeValue *rt_bignum_div(RuntimeValue *a, RuntimeValue *b) {
+    int64_t    x, y;
+    BignumView ta, tb;
+    mpz_srcptr d = bignum_operand(&tb, b);
+    if (mpz_sgn(d) == 0) { fprintf(stderr, "Error: division by zero\n"); exit(1); }
+    if (bignum_small(a, &x) && bignum_small(b, &y) && !(x == INT64_MIN && y == -1))
+        return rt_value_int(x / y);
+    RuntimeValue *v = bignum_new();
+    mpz_tdiv_q(v->data.bignum_val, bignum_operand(&ta, a), d);
+    return bignum_normalize(v);
+}
+
+/// Bignum accumulator
+//
+//  Folds like (foldl * 1 xs) allocate a fresh bignum per step when going
+//  through rt_bignum_mul.  An accumulator owns one mpz and updates it in
+//  place, staying in an int64 while the running value fits; rt_bignum_acc_finish
+//  boxes (or demotes) the result and releases the accumulator.
+
+struct RuntimeBignumAcc {
+    int     big;    // 0: value is in small, 1: value is in z
+    int64_t small;
+    mpz_t   z;
+};
+
+RuntimeBignumAcc *rt_bignum_acc_new(RuntimeValue *init) {
+    RuntimeBignumAcc *acc = rt_alloc(sizeof(RuntimeBignumAcc));
+    acc->big   = 0;
+    acc->small = 0;
+    if (init && rt_value_is_bignum(init)) {
+        mpz_init_set(acc->z, init->data.bignum_val);
+        acc->big = 1;
+    } else {
+        mpz_init(acc->z);
+        if (init && rt_type_of(init) == RT_INT) acc->small = rt_int_val(init);
+    }
+    return acc;
+}
+
+static void bignum_acc_spill(RuntimeBignumAcc *acc) {
+    if (acc->big) return;
+    mpz_set(acc->z, bignum_view_i64(&(BignumView){0}, acc->small));
+    acc->big = 1;
+}
+
+void rt_bignum_acc_add(RuntimeBignumAcc *acc, RuntimeValue *x) {
+    int64_t n, r;
+    if (!acc->big && bignum_small(x, &n) && !__builtin_add_overflow(acc->small, n, &r)) {
+        acc->small = r;
+        return;
+    }
+    BignumView t;
+    bignum_acc_spill(acc);
+    mpz_add(acc->z, acc->z, bignum_operand(&t, x));
+}
+
+void rt_bignum_acc_mul(RuntimeBignumAcc *acc, RuntimeValue *x) {
+    int64_t n, r;
+    if (!acc->big && bignum_small(x, &n) && !__builtin_mul_overflow(acc->small, n, &r)) {
+        acc->small = r;
+        return;
+    }
+    BignumView t;
+    bignum_acc_spill(acc);
+    mpz_mul(acc->z, acc->z, bignum_operand(&t, x));
+}
+
+RuntimeValue *rt_bignum_acc_finish(RuntimeBignumAcc *acc) {
+    RuntimeValue *v;
+    if (!acc->big) {
+        mpz_clear(acc->z);
+        v = rt_value_int(acc->small);
+    } else {
+        v = heap_value();
+        v->type = RT_BIGNUM;
+        memcpy(v->data.bignum_val, acc->z, sizeof(mpz_t));  // hand the limbs over
+        v = bignum_normalize(v);
+    }
+    rt_free_sized(acc, sizeof(RuntimeBignumAcc));
     return v;
 }
 
+RuntimeValue *rt_bignum_sum_list(RuntimeList *xs) {
+    RuntimeBignumAcc *acc = rt_bignum_acc_new(NULL);
+    for (; !rt_list_is_empty_list(xs); xs = rt_list_cdr(xs))
+        rt_bignum_acc_add(acc, rt_list_car(xs));
+    return rt_bignum_acc_finish(acc);
+}
+
+RuntimeValue *rt_bignum_product_list(RuntimeList *xs) {
+    RuntimeBignumAcc *acc = rt_bignum_acc_new(rt_value_int(1));
+    for (; !rt_list_is_empty_list(xs); xs = rt_list_cdr(xs))
+        rt_bignum_acc_mul(acc, rt_list_car(xs));
+    return rt_bignum_acc_finish(acc);
+}
+
 /// Higher-order list operations
 
-typedef struct { RuntimeList *rest; RT_UnaryFn fn; void *env; } LazyMapEnv;
+//  map and filter apply fn to an element when the cell holding its result
+//  is built, one cell at a time.  The _total variants are for callers that
+//  know fn terminates without errors or effects: over a chunked source
+//  they map (or test) the rest of the source chunk in one go, which may
+//  run fn on elements nobody demands.
+
+typedef struct { RuntimeList *rest; RT_UnaryFn fn; void *env; int total; } LazyMapEnv;
 static RuntimeValue *_rt_lazy_map_tail_fn(void *e);
+static RuntimeList  *_rt_lazy_map_chunk_fn(void *e);
 
-RuntimeList *rt_list_map(RuntimeList *list, void *env, RT_UnaryFn fn) {
+static RuntimeList *list_map(RuntimeList *list, void *env, RT_UnaryFn fn, int total) {
     /* Accept RuntimeValue*(RT_LIST) or raw RuntimeList* */
     {
-        int _tag = (int)((RuntimeValue *)list)->type;
+        int _tag = (int)rt_type_of((RuntimeValue *)list);
         if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
             list = ((RuntimeValue *)list)->data.list_val;
     }
     if (rt_list_is_empty_list(list)) return rt_list_empty();
 
+    // Chunked evaluation: map the rest of a source chunk in one go and
+    // keep only the step to the next chunk lazy.
+    if (total && list_is_chunk(list)) {
+        ListChunk *src = list_chunk(list);
+        uint32_t   i   = list_chunk_index(list, src);
+        ListChunk *out = list_chunk_new(src->count - i);
+        for (; i < src->count; i++) {
+            RuntimeValue *_a[] = {src->slots[i].value};
+            list_chunk_push(out, fn(env, 1, _a));
+        }
+        if (list_chunk_has_rest(src)) {
+            LazyMapEnv *lenv = rt_alloc(sizeof(LazyMapEnv));
+            lenv->rest    = list_chunk_at(src, src->count - 1);
+            lenv->fn      = fn;
+            lenv->env     = env;
+            lenv->total   = 1;
+            out->next_fn  = _rt_lazy_map_chunk_fn;
+            out->next_env = lenv;
+        }
+        return list_chunk_at(out, 0);
+    }
+
     ConsCell *c    = heap_cons_cell();
     c->head_fn     = NULL;
     c->head_env    = NULL;
     { RuntimeValue *_a[] = {rt_list_car(list)}; c->head_val = fn(env, 1, _a); }
     c->head_forced = 1;
 
-    LazyMapEnv *lenv = malloc(sizeof(LazyMapEnv));
-    lenv->rest = rt_list_cdr(list);
-    lenv->fn   = fn;
-    lenv->env  = env;
+    LazyMapEnv *lenv = rt_alloc(sizeof(LazyMapEnv));
+    lenv->rest  = rt_list_cdr(list);
+    lenv->fn    = fn;
+    lenv->env   = env;
+    lenv->total = total;
     c->tail_fn     = _rt_lazy_map_tail_fn;
     c->tail_env    = lenv;
     c->tail_val    = NULL;
@@ -2174,17 +4532,31 @@ RuntimeList *rt_list_map(RuntimeList *list, void *env, RT_UnaryFn fn) {
     return lst;
 }
 
+RuntimeList *rt_list_map(RuntimeList *list, void *env, RT_UnaryFn fn) {
+    return list_map(list, env, fn, 0);
+}
+
+RuntimeList *rt_list_map_total(RuntimeList *list, void *env, RT_UnaryFn fn) {
+    return list_map(list, env, fn, 1);
+}
+
 static RuntimeValue *_rt_lazy_map_tail_fn(void *e) {
     LazyMapEnv *env = (LazyMapEnv *)e;
-    RuntimeValue *rv = malloc(sizeof(RuntimeValue));
+    RuntimeValue *rv = heap_value();
     rv->type          = RT_LIST;
-    rv->data.list_val = rt_list_map(env->rest, env->env, env->fn);
+    rv->data.list_val = list_map(env->rest, env->env, env->fn, env->total);
     return rv;
 }
 
+// env->rest is the source chunk's last slot.
+static RuntimeList *_rt_lazy_map_chunk_fn(void *e) {
+    LazyMapEnv *env = (LazyMapEnv *)e;
+    return list_map(rt_list_cdr(env->rest), env->env, env->fn, 1);
+}
+
 RuntimeValue *rt_list_foldl(RuntimeList *list, RuntimeValue *init,
                              void *env, RT_BinaryFn fn) {
-    { int _tag = (int)((RuntimeValue *)list)->type;
+    { int _tag = (int)rt_type_of((RuntimeValue *)list);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           list = ((RuntimeValue *)list)->data.list_val; }
     RuntimeValue *acc = init;
@@ -2203,8 +4575,12 @@ RuntimeValue *rt_list_foldr(RuntimeList *list, RuntimeValue *init,
     RuntimeList *cur = list;
     while (!rt_list_is_empty_list(cur)) {
         if (count >= cap) {
-            cap = cap ? cap * 2 : 16;
-            stack = realloc(stack, cap * sizeof(RuntimeValue *));
+            size_t         new_cap = cap ? cap * 2 : 16;
+            RuntimeValue **grown   = rt_alloc(new_cap * sizeof(RuntimeValue *));
+            if (count) memcpy(grown, stack, count * sizeof(RuntimeValue *));
+            rt_free_sized(stack, cap * sizeof(RuntimeValue *));
+            stack = grown;
+            cap   = new_cap;
         }
         stack[count++] = rt_list_car(cur);
         cur = rt_list_cdr(cur);
@@ -2212,19 +4588,48 @@ RuntimeValue *rt_list_foldr(RuntimeList *list, RuntimeValue *init,
     RuntimeValue *acc = init;
     for (size_t i = count; i-- > 0; )
         { RuntimeValue *_a[] = {stack[i], acc}; acc = fn(env, 2, _a); }
-    free(stack);
+    rt_free_sized(stack, cap * sizeof(RuntimeValue *));
     return acc;
 }
 
-typedef struct { RuntimeList *rest; RT_UnaryFn fn; void *env; } LazyFilterEnv;
+typedef struct { RuntimeList *rest; RT_UnaryFn fn; void *env; int total; } LazyFilterEnv;
 static RuntimeValue *_rt_lazy_filter_tail_fn(void *e);
+static RuntimeList  *_rt_lazy_filter_chunk_fn(void *e);
 
-RuntimeList *rt_list_filter(RuntimeList *list, void *env, RT_UnaryFn pred) {
-    { int _tag = (int)((RuntimeValue *)list)->type;
+static RuntimeList *list_filter(RuntimeList *list, void *env, RT_UnaryFn pred, int total) {
+    { int _tag = (int)rt_type_of((RuntimeValue *)list);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           list = ((RuntimeValue *)list)->data.list_val; }
     RuntimeList *cur = list;
     while (!rt_list_is_empty_list(cur)) {
+        // Chunked evaluation, as in list_map; a chunk with no survivors
+        // falls through to the next one.
+        if (total && list_is_chunk(cur)) {
+            ListChunk *src = list_chunk(cur);
+            uint32_t   i   = list_chunk_index(cur, src);
+            ListChunk *out = NULL;
+            for (; i < src->count; i++) {
+                RuntimeValue *val   = src->slots[i].value;
+                RuntimeValue *_pa[] = {val};
+                if (rt_unbox_int(pred(env, 1, _pa)) == 0) continue;
+                if (!out) out = list_chunk_new(src->count - i);
+                list_chunk_push(out, val);
+            }
+            if (!out) {
+                cur = list_chunk_rest(src);
+                continue;
+            }
+            if (list_chunk_has_rest(src)) {
+                LazyFilterEnv *fenv = rt_alloc(sizeof(LazyFilterEnv));
+                fenv->rest    = list_chunk_at(src, src->count - 1);
+                fenv->fn      = pred;
+                fenv->env     = env;
+                fenv->total   = 1;
+                out->next_fn  = _rt_lazy_filter_chunk_fn;
+                out->next_env = fenv;
+            }
+            return list_chunk_at(out, 0);
+        }
         RuntimeValue *val    = rt_list_car(cur);
         RuntimeValue *_pa[] = {val}; RuntimeValue *result = pred(env, 1, _pa);
         if (rt_unbox_int(result) != 0) {
@@ -2234,10 +4639,11 @@ RuntimeList *rt_list_filter(RuntimeList *list, void *env, RT_UnaryFn pred) {
             c->head_val    = val;
             c->head_forced = 1;
 
-            LazyFilterEnv *fenv = malloc(sizeof(LazyFilterEnv));
-            fenv->rest = rt_list_cdr(cur);
-            fenv->fn   = pred;
-            fenv->env  = env;
+            LazyFilterEnv *fenv = rt_alloc(sizeof(LazyFilterEnv));
+            fenv->rest  = rt_list_cdr(cur);
+            fenv->fn    = pred;
+            fenv->env   = env;
+            fenv->total = total;
             c->tail_fn     = _rt_lazy_filter_tail_fn;
             c->tail_env    = fenv;
             c->tail_val    = NULL;
@@ -2252,56 +4658,68 @@ RuntimeList *rt_list_filter(RuntimeList *list, void *env, RT_UnaryFn pred) {
     return rt_list_empty();
 }
 
+RuntimeList *rt_list_filter(RuntimeList *list, void *env, RT_UnaryFn pred) {
+    return list_filter(list, env, pred, 0);
+}
+
+RuntimeList *rt_list_filter_total(RuntimeList *list, void *env, RT_UnaryFn pred) {
+    return list_filter(list, env, pred, 1);
+}
+
 static RuntimeValue *_rt_lazy_filter_tail_fn(void *e) {
     LazyFilterEnv *fenv = (LazyFilterEnv *)e;
-    RuntimeValue *rv = malloc(sizeof(RuntimeValue));
+    RuntimeValue *rv = heap_value();
     rv->type          = RT_LIST;
-    rv->data.list_val = rt_list_filter(fenv->rest, fenv->env, fenv->fn);
+    rv->data.list_val = list_filter(fenv->rest, fenv->env, fenv->fn, fenv->total);
     return rv;
 }
 
+static RuntimeList *_rt_lazy_filter_chunk_fn(void *e) {
+    LazyFilterEnv *fenv = (LazyFilterEnv *)e;
+    return list_filter(rt_list_cdr(fenv->rest), fenv->env, fenv->fn, 1);
+}
+
 RuntimeList *rt_list_zip(RuntimeList *a, RuntimeList *b) {
-    { int _tag = (int)((RuntimeValue *)a)->type;
+    { int _tag = (int)rt_type_of((RuntimeValue *)a);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           a = ((RuntimeValue *)a)->data.list_val; }
-    { int _tag = (int)((RuntimeValue *)b)->type;
+    { int _tag = (int)rt_type_of((RuntimeValue *)b);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           b = ((RuntimeValue *)b)->data.list_val; }
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
+    ListBuilder out;
+    list_builder_init(&out);
     RuntimeList *ca = a, *cb = b;
     while (!rt_list_is_empty_list(ca) && !rt_list_is_empty_list(cb)) {
         // each element is a 2-element list: (a_i b_i)
-        RuntimeList *pair = heap_list_wrapper();
-        pair->cell = NULL;
-        rt_list_append(pair, rt_list_car(ca));
-        rt_list_append(pair, rt_list_car(cb));
-        rt_list_append(out, rt_value_list(pair));
+        ListBuilder pair;
+        list_builder_init(&pair);
+        list_builder_push(&pair, rt_list_car(ca));
+        list_builder_push(&pair, rt_list_car(cb));
+        list_builder_push(&out, rt_value_list(pair.list));
         ca = rt_list_cdr(ca);
         cb = rt_list_cdr(cb);
     }
-    return out;
+    return out.list;
 }
 
 RuntimeList *rt_list_zipwith(RuntimeList *a, RuntimeList *b,
                               void *env, RT_BinaryFn fn) {
-    { int _tag = (int)((RuntimeValue *)a)->type;
+    { int _tag = (int)rt_type_of((RuntimeValue *)a);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           a = ((RuntimeValue *)a)->data.list_val; }
-    { int _tag = (int)((RuntimeValue *)b)->type;
+    { int _tag = (int)rt_type_of((RuntimeValue *)b);
       if (_tag >= 0 && _tag <= RT_CLOSURE && _tag == RT_LIST)
           b = ((RuntimeValue *)b)->data.list_val; }
-    RuntimeList *out = heap_list_wrapper();
-    out->cell = NULL;
+    ListBuilder out;
+    list_builder_init(&out);
     RuntimeList *ca = a, *cb = b;
     while (!rt_list_is_empty_list(ca) && !rt_list_is_empty_list(cb)) {
         RuntimeValue *_a[] = {rt_list_car(ca), rt_list_car(cb)};
-        RuntimeValue *val = fn(env, 2, _a);
-        rt_list_append(out, val);
+        list_builder_push(&out, fn(env, 2, _a));
         ca = rt_list_cdr(ca);
         cb = rt_list_cdr(cb);
     }
-    return out;
+    return out.list;
 }
 
 
@@ -2320,7 +4738,7 @@ RuntimeValue *rt_value_ratio(int64_t n, int64_t d) {
     if (d < 0)  { n = -n; d = -d; }
     int64_t g = gcd(n, d);
     if (g > 1) { n /= g; d /= g; }
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    RuntimeValue *v = heap_value();
     v->type = RT_RATIO;
     v->data.ratio_val.numerator   = n;
     v->data.ratio_val.denominator = d;
@@ -2328,15 +4746,15 @@ RuntimeValue *rt_value_ratio(int64_t n, int64_t d) {
 }
 
 RuntimeValue *rt_value_array(size_t length) {
-    RuntimeValue *v = malloc(sizeof(RuntimeValue));
+    RuntimeValue *v = heap_value();
     v->type = RT_ARRAY;
     v->data.array_val.length   = length;
-    v->data.array_val.elements = calloc(length, sizeof(RuntimeValue *));
+    v->data.array_val.elements = rt_alloc_zeroed(length * sizeof(RuntimeValue *));
     return v;
 }
 
 void rt_array_set(RuntimeValue *array, size_t index, RuntimeValue *value) {
-    if (!array || array->type != RT_ARRAY) return;
+    if (!array || rt_type_of(array) != RT_ARRAY) return;
     if (index >= array->data.array_val.length) {
         fprintf(stderr, "Error: array index out of bounds\n"); exit(1);
     }
@@ -2344,14 +4762,14 @@ void rt_array_set(RuntimeValue *array, size_t index, RuntimeValue *value) {
 }
 
 RuntimeValue *rt_array_get(RuntimeValue *array, size_t index) {
-    if (!array || array->type != RT_ARRAY) return rt_value_nil();
+    if (!array || rt_type_of(array) != RT_ARRAY) return rt_value_nil();
     if (index >= array->data.array_val.length) return rt_value_nil();
     RuntimeValue *v = array->data.array_val.elements[index];
     return v ? v : rt_value_nil();
 }
 
 int64_t rt_array_length(RuntimeValue *array) {
-    if (!array || array->type != RT_ARRAY) return 0;
+    if (!array || rt_type_of(array) != RT_ARRAY) return 0;
     return (int64_t)array->data.array_val.length;
 }
 
@@ -2411,13 +4829,13 @@ void __print_u128(unsigned __int128 v) {
 // Called directly from JIT code — builds a RuntimeValue* list from an AST*
 // entirely in C so all allocations use heap (survive arena reset).
 
-#define HEAP_VAL()      ((RuntimeValue*)malloc(sizeof(RuntimeValue)))
-#define HEAP_LIST()     ({ RuntimeList *_l = malloc(sizeof(RuntimeList)); _l->cell = NULL; _l; })
+#define HEAP_VAL()      heap_value()
+#define HEAP_LIST()     ({ RuntimeList *_l = heap_list_wrapper(); _l->cell = NULL; _l; })
 #define WRAP_LIST(lst)  ({ RuntimeValue *_v = HEAP_VAL(); _v->type = RT_LIST; _v->data.list_val = (lst); _v; })
-#define HEAP_SYM(s)     ({ RuntimeValue *_v = HEAP_VAL(); _v->type = RT_SYMBOL; _v->data.symbol_val = strdup(s); _v; })
+#define HEAP_SYM(s)     rt_value_symbol(s)
 
 static void heap_list_append(RuntimeList *list, RuntimeValue *value) {
-    ConsCell *new_c    = malloc(sizeof(ConsCell));
+    ConsCell *new_c    = heap_cons_cell();
     new_c->head_fn     = NULL;
     new_c->head_env    = NULL;
     new_c->head_val    = value;
@@ -2437,27 +4855,23 @@ static void heap_list_append(RuntimeList *list, RuntimeValue *value) {
         ConsCell *cc = cur->cell;
         if (!cc) break;
         RuntimeValue *tv = cc->tail_val;
-        if (!tv || tv->type == RT_NIL ||
-            (tv->type == RT_LIST && rt_list_is_empty_list(tv->data.list_val))) {
-            RuntimeValue *link  = malloc(sizeof(RuntimeValue));
+        if (!tv || rt_type_of(tv) == RT_NIL ||
+            (rt_type_of(tv) == RT_LIST && rt_list_is_empty_list(tv->data.list_val))) {
+            RuntimeValue *link  = heap_value();
             link->type          = RT_LIST;
-            link->data.list_val = malloc(sizeof(RuntimeList));
+            link->data.list_val = heap_list_wrapper();
             link->data.list_val->cell = new_c;
             cc->tail_val    = link;
             cc->tail_forced = 1;
             return;
         }
-        if (tv->type == RT_LIST) { cur = tv->data.list_val; continue; }
+        if (rt_type_of(tv) == RT_LIST) { cur = tv->data.list_val; continue; }
         break;
     }
 }
 
 RuntimeValue *rt_ast_to_runtime_value(AST *ast) {
-    if (!ast) {
-        RuntimeValue *v = HEAP_VAL();
-        v->type = RT_NIL;
-        return v;
-    }
+    if (!ast) return rt_value_nil();
 
     switch (ast->type) {
     case AST_NUMBER: {
@@ -2471,35 +4885,13 @@ RuntimeValue *rt_ast_to_runtime_value(AST *ast) {
             } else {
                 is_float = (ast->number != (double)(int64_t)ast->number);
             }
-            RuntimeValue *v = HEAP_VAL();
-            if (is_float) {
-                v->type = RT_FLOAT;
-                v->data.float_val = ast->number;
-            } else {
-                v->type = RT_INT;
-                v->data.int_val = (int64_t)ast->number;
-            }
-            return v;
+            return is_float ? rt_value_float(ast->number)
+                            : rt_value_int((int64_t)ast->number);
         }
         case AST_SYMBOL:  return HEAP_SYM(ast->symbol);
-        case AST_STRING: {
-            RuntimeValue *v = HEAP_VAL();
-            v->type = RT_STRING;
-            v->data.string_val = strdup(ast->string);
-            return v;
-        }
-        case AST_CHAR: {
-            RuntimeValue *v = HEAP_VAL();
-            v->type = RT_CHAR;
-            v->data.char_val = ast->character;
-            return v;
-        }
-        case AST_KEYWORD: {
-            RuntimeValue *v = HEAP_VAL();
-            v->type = RT_KEYWORD;
-            v->data.keyword_val = strdup(ast->keyword);
-            return v;
-        }
+        case AST_STRING:  return rt_value_string(ast->string);
+        case AST_CHAR:    return rt_value_char(ast->character);
+        case AST_KEYWORD: return rt_value_keyword(ast->keyword);
         case AST_RATIO: {
             RuntimeValue *v = HEAP_VAL();
             v->type = RT_RATIO;
@@ -2578,22 +4970,21 @@ RuntimeValue *rt_ast_to_runtime_value(AST *ast) {
                 // patterns
                 for (int j = 0; j < cl->pattern_count; j++) {
                     ASTPattern *pat = &cl->patterns[j];
-                    RuntimeValue *pv = HEAP_VAL();
-                    pv->type = RT_SYMBOL;
+                    RuntimeValue *pv;
                     switch (pat->kind) {
-                    case PAT_WILDCARD: pv->data.symbol_val = strdup("_"); break;
-                    case PAT_VAR:      pv->data.symbol_val = strdup(pat->var_name); break;
+                    case PAT_WILDCARD: pv = HEAP_SYM("_"); break;
+                    case PAT_VAR:      pv = HEAP_SYM(pat->var_name); break;
                     case PAT_LITERAL_INT: {
                         char buf[32];
                         snprintf(buf, sizeof(buf), "%lld", (long long)pat->lit_value);
-                        pv->data.symbol_val = strdup(buf);
+                        pv = HEAP_SYM(buf);
                         break;
                     }
                     case PAT_LIST_EMPTY:
-                        pv->data.symbol_val = strdup("[]");
+                        pv = HEAP_SYM("[]");
                         break;
                     default:
-                        pv->data.symbol_val = strdup("_");
+                        pv = HEAP_SYM("_");
                         break;
                     }
                     heap_list_append(clause, pv);
@@ -2616,199 +5007,1373 @@ RuntimeValue *rt_ast_to_runtime_value(AST *ast) {
 #undef WRAP_LIST
 #undef HEAP_SYM
 
-///  LLVM Integration — declare_runtime_functions
+///  Work-stealing pool
+//
+//  rt_pool_for(n, grain, body, ctx) runs body over [0, n) on a pool of
+//  worker threads started on first use.  The caller takes part as worker
+//  0.  Each worker owns a Chase-Lev deque of index ranges.  It pops from
+//  the bottom of its own deque and splits a range in half until it is at
+//  most `grain` long, pushing the upper halves.  Idle workers steal from
+//  the top of a random victim.  The call returns once every index has run.
+//
+//  Ranges are split by halving, so a deque never holds more than one
+//  entry per level (at most 64) and the fixed ring never wraps onto a
+//  live slot.
+//
+//  The pool runs one job at a time.  A call made while a job is running
+//  on another thread, from inside a job body, or with the collector on
+//  (it traces one mutator) runs body(ctx, 0, n) directly.
+//
+//  Environment:
+//    MONAD_THREADS=N   pool size including the caller (default: CPUs,
+//                      1 disables the pool)
+//
+#if !defined(_MSC_VER)
+#define RT_POOL_SUPPORTED 1
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#else
+#define RT_POOL_SUPPORTED 0
+#endif
+
+#define RT_POOL_MAX   64
+#define RT_DEQUE_SIZE 128   // power of two, > 2 * 64 levels
+
+typedef struct { int64_t lo, hi; } RtRange;
+
+typedef struct {
+    int64_t top;                      // thieves CAS this
+    char    pad0[64 - sizeof(int64_t)];
+    int64_t bottom;                   // owner only writes this
+    char    pad1[64 - sizeof(int64_t)];
+    RtRange ring[RT_DEQUE_SIZE];
+} RtDeque;
+
+typedef struct {
+    RtPoolBody body;
+    void      *ctx;
+    int64_t    grain;
+    int64_t    remaining;             // indices not yet run
+} RtPoolJob;
+
+static int g_rt_pool_threads = -1;    // -1 = not started, else pool size
+
+#if RT_POOL_SUPPORTED
+
+static RtDeque         g_rt_deques[RT_POOL_MAX];
+static RtPoolJob      *g_rt_pool_job;
+static uint64_t        g_rt_pool_gen;
+static int             g_rt_pool_busy;    // workers inside the current job
+static pthread_mutex_t g_rt_pool_mu   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_rt_pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  g_rt_pool_done = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t g_rt_pool_run  = PTHREAD_MUTEX_INITIALIZER;  // one job at a time
+static pthread_mutex_t g_rt_pool_init = PTHREAD_MUTEX_INITIALIZER;
+
+static void deque_push(RtDeque *d, RtRange r) {
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    RtRange *slot = &d->ring[b & (RT_DEQUE_SIZE - 1)];
+    __atomic_store_n(&slot->lo, r.lo, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->hi, r.hi, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+}
+
+static int deque_take(RtDeque *d, RtRange *out) {
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+    if (t > b) {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    RtRange *slot = &d->ring[b & (RT_DEQUE_SIZE - 1)];
+    out->lo = __atomic_load_n(&slot->lo, __ATOMIC_RELAXED);
+    out->hi = __atomic_load_n(&slot->hi, __ATOMIC_RELAXED);
+    if (t == b) {
+        // Last entry: race the thieves for it.
+        int won = __atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+                                              __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return won;
+    }
+    return 1;
+}
+
+static int deque_steal(RtDeque *d, RtRange *out) {
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return 0;
+    RtRange *slot = &d->ring[t & (RT_DEQUE_SIZE - 1)];
+    out->lo = __atomic_load_n(&slot->lo, __ATOMIC_RELAXED);
+    out->hi = __atomic_load_n(&slot->hi, __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(&d->top, &t, t + 1, 0,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static void pool_run_range(RtPoolJob *job, RtDeque *own, RtRange r) {
+    while (r.hi - r.lo > job->grain) {
+        int64_t mid = r.lo + (r.hi - r.lo) / 2;
+        deque_push(own, (RtRange){mid, r.hi});
+        r.hi = mid;
+    }
+    job->body(job->ctx, r.lo, r.hi);
+    __atomic_sub_fetch(&job->remaining, r.hi - r.lo, __ATOMIC_RELEASE);
+}
+
+static void pool_work(RtPoolJob *job, int self) {
+    RtDeque *own  = &g_rt_deques[self];
+    uint32_t seed = 2654435761u * (uint32_t)(self + 1);
+    int      n    = g_rt_pool_threads;
+    RtRange  r;
+    while (__atomic_load_n(&job->remaining, __ATOMIC_ACQUIRE) > 0) {
+        if (deque_take(own, &r)) { pool_run_range(job, own, r); continue; }
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        int victim = (int)(seed % (uint32_t)n);
+        if (victim != self && deque_steal(&g_rt_deques[victim], &r))
+            pool_run_range(job, own, r);
+        else
+            sched_yield();
+    }
+}
+
+static void *pool_worker_main(void *arg) {
+    int      self = (int)(intptr_t)arg;
+    uint64_t seen = 0;
+    g_rt_pool_worker = 1;
+    pthread_mutex_lock(&g_rt_pool_mu);
+    for (;;) {
+        while (g_rt_pool_gen == seen)
+            pthread_cond_wait(&g_rt_pool_wake, &g_rt_pool_mu);
+        seen = g_rt_pool_gen;
+        RtPoolJob *job = g_rt_pool_job;
+        if (!job) continue;
+        g_rt_pool_busy++;
+        pthread_mutex_unlock(&g_rt_pool_mu);
+        pool_work(job, self);
+        pthread_mutex_lock(&g_rt_pool_mu);
+        if (--g_rt_pool_busy == 0)
+            pthread_cond_signal(&g_rt_pool_done);
+    }
+    return NULL;
+}
+
+static void pool_start(void) {
+    pthread_mutex_lock(&g_rt_pool_init);
+    if (g_rt_pool_threads < 0) {
+        long        n   = sysconf(_SC_NPROCESSORS_ONLN);
+        const char *env = getenv("MONAD_THREADS");
+        if (env && *env) n = strtol(env, NULL, 10);
+        if (n < 1) n = 1;
+        if (n > RT_POOL_MAX) n = RT_POOL_MAX;
+        rt_alloc_mode();   // settle the lazily read allocator mode first
+        int started = 1;
+        for (; started < n; started++) {
+            pthread_t tid;
+            if (pthread_create(&tid, NULL, pool_worker_main,
+                               (void *)(intptr_t)started) != 0)
+                break;
+            pthread_detach(tid);
+        }
+        __atomic_store_n(&g_rt_pool_threads, started, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_rt_pool_init);
+}
+
+#endif /* RT_POOL_SUPPORTED */
+
+int rt_pool_size(void) {
+#if RT_POOL_SUPPORTED
+    if (__atomic_load_n(&g_rt_pool_threads, __ATOMIC_ACQUIRE) < 0) pool_start();
+    return g_rt_pool_threads;
+#else
+    return 1;
+#endif
+}
+
+void rt_pool_for(int64_t n, int64_t grain, RtPoolBody body, void *ctx) {
+    if (n <= 0) return;
+    if (grain < 1) grain = 1;
+#if RT_POOL_SUPPORTED
+    if (n > grain && !g_rt_pool_worker && !g_rt_gc_enabled && rt_pool_size() > 1 &&
+        pthread_mutex_trylock(&g_rt_pool_run) == 0) {
+        RtPoolJob job = {body, ctx, grain, n};
+        deque_push(&g_rt_deques[0], (RtRange){0, n});
+
+        pthread_mutex_lock(&g_rt_pool_mu);
+        g_rt_pool_job = &job;
+        g_rt_pool_gen++;
+        pthread_cond_broadcast(&g_rt_pool_wake);
+        pthread_mutex_unlock(&g_rt_pool_mu);
+
+        g_rt_pool_worker = 1;   // nested calls from body run inline
+        pool_work(&job, 0);
+        g_rt_pool_worker = 0;
+
+        pthread_mutex_lock(&g_rt_pool_mu);
+        g_rt_pool_job = NULL;
+        while (g_rt_pool_busy > 0)
+            pthread_cond_wait(&g_rt_pool_done, &g_rt_pool_mu);
+        pthread_mutex_unlock(&g_rt_pool_mu);
+        pthread_mutex_unlock(&g_rt_pool_run);
+        return;
+    }
+#endif
+    body(ctx, 0, n);
+}
+
+///  Parallel collection operations
+//
+//  pmap, pfilter and pfold from the prelude.  The input list, array or set
+//  is forced into a flat buffer on the calling thread, the function runs
+//  on the pool, and the result is assembled in order on the calling
+//  thread, so a result never depends on the schedule.  pmap and pfilter
+//  return an array for an array, a set from pfilter on a set, and a list
+//  otherwise.  pfold folds fixed chunks separately and then folds the
+//  chunk results left to right, so f must be associative; init is used
+//  once, at the very front, and need not be an identity.
+//
+//  The function must be pure.  Lazy values it shares with the calls for
+//  other elements are forced once (see "Thunk forcing").
+
+#define RT_PAR_MIN_ITEMS 32   // below this the pool is not worth waking
+
+typedef struct {
+    RuntimeValue  *fn;
+    RuntimeValue  *init;
+    RuntimeValue **items;
+    RuntimeValue **out;
+    int64_t        n;
+    int64_t        chunk;          // pfold: items per chunk
+} RtParJob;
+
+// Forces coll into a fresh buffer of *count items; *bytes is its size.
+static RuntimeValue **par_items(RuntimeValue *coll, int64_t *count, size_t *bytes,
+                                int *shape) {
+    int tag = (int)rt_type_of(coll);
+    size_t n = 0, cap = 0;
+    RuntimeValue **items = NULL;
+    *shape = RT_LIST;
+
+    if (tag == RT_ARRAY) {
+        *shape = RT_ARRAY;
+        n      = coll->data.array_val.length;
+        cap    = n;
+        items  = rt_alloc_zeroed((cap ? cap : 1) * sizeof(RuntimeValue *));
+        for (size_t i = 0; i < n; i++) {
+            RuntimeValue *v = coll->data.array_val.elements[i];
+            items[i] = v ? v : rt_value_nil();
+        }
+    } else if (tag == RT_SET) {
+        *shape = RT_SET;
+        RuntimeSet *set = coll->data.set_val;
+        cap   = set ? set->count : 0;
+        items = rt_alloc_zeroed((cap ? cap : 1) * sizeof(RuntimeValue *));
+        CollIter it;
+        set_iter(&it, set);
+        for (RuntimeValue *v; n < cap && (v = set_iter_next(&it)); )
+            items[n++] = v;
+    } else {
+        RuntimeList *list = tag == RT_LIST ? coll->data.list_val : (RuntimeList *)coll;
+        for (; !rt_list_is_empty_list(list); list = rt_list_cdr(list)) {
+            if (n == cap) {
+                size_t ncap = cap ? cap * 2 : 64;
+                RuntimeValue **grown = rt_alloc_zeroed(ncap * sizeof(RuntimeValue *));
+                if (n) memcpy(grown, items, n * sizeof(RuntimeValue *));
+                if (items) rt_free_sized(items, cap * sizeof(RuntimeValue *));
+                items = grown;
+                cap   = ncap;
+            }
+            items[n++] = rt_list_car(list);
+        }
+        if (!items) items = rt_alloc_zeroed(sizeof(RuntimeValue *));
+    }
+    *count = (int64_t)n;
+    *bytes = (cap ? cap : 1) * sizeof(RuntimeValue *);
+    return items;
+}
+
+static int64_t par_grain(int64_t n) {
+    int64_t g = n / ((int64_t)rt_pool_size() * 8);
+    return g < 1 ? 1 : g;
+}
+
+static void par_map_body(void *ctx, int64_t lo, int64_t hi) {
+    RtParJob *job = ctx;
+    for (int64_t i = lo; i < hi; i++)
+        job->out[i] = rt_closure_call1(job->fn, job->items[i]);
+}
+
+RuntimeValue *rt_par_map(RuntimeValue *fn, RuntimeValue *coll) {
+    int64_t n;
+    size_t  bytes;
+    int     shape;
+    RuntimeValue **items = par_items(coll, &n, &bytes, &shape);
+    RuntimeValue **out   = rt_alloc_zeroed((size_t)(n ? n : 1) * sizeof(RuntimeValue *));
+    RtParJob job = {fn, NULL, items, out, n, 0};
+    rt_pool_for(n, n < RT_PAR_MIN_ITEMS ? n : par_grain(n), par_map_body, &job);
+
+    RuntimeValue *result;
+    if (shape == RT_ARRAY) {
+        result = rt_value_array((size_t)n);
+        memcpy(result->data.array_val.elements, out, (size_t)n * sizeof(RuntimeValue *));
+    } else {
+        ListBuilder b;
+        list_builder_init(&b);
+        for (int64_t i = 0; i < n; i++) list_builder_push(&b, out[i]);
+        result = rt_value_list(b.list);
+    }
+    rt_free_sized(out,   (size_t)(n ? n : 1) * sizeof(RuntimeValue *));
+    rt_free_sized(items, bytes);
+    return result;
+}
+
+static void par_filter_body(void *ctx, int64_t lo, int64_t hi) {
+    RtParJob *job = ctx;
+    for (int64_t i = lo; i < hi; i++)
+        job->out[i] = rt_unbox_int(rt_closure_call1(job->fn, job->items[i]))
+                    ? job->items[i] : NULL;
+}
+
+RuntimeValue *rt_par_filter(RuntimeValue *pred, RuntimeValue *coll) {
+    int64_t n;
+    size_t  bytes;
+    int     shape;
+    RuntimeValue **items = par_items(coll, &n, &bytes, &shape);
+    RuntimeValue **out   = rt_alloc_zeroed((size_t)(n ? n : 1) * sizeof(RuntimeValue *));
+    RtParJob job = {pred, NULL, items, out, n, 0};
+    rt_pool_for(n, n < RT_PAR_MIN_ITEMS ? n : par_grain(n), par_filter_body, &job);
+
+    int64_t kept = 0;
+    for (int64_t i = 0; i < n; i++)
+        if (out[i]) out[kept++] = out[i];
+
+    RuntimeValue *result;
+    if (shape == RT_ARRAY) {
+        result = rt_value_array((size_t)kept);
+        memcpy(result->data.array_val.elements, out, (size_t)kept * sizeof(RuntimeValue *));
+    } else if (shape == RT_SET) {
+        RuntimeSet *set  = rt_set_new();
+        uint64_t    edit = hamt_new_edit();
+        for (int64_t i = 0; i < kept; i++) set_build_add(set, out[i], edit);
+        result = rt_value_set(set);
+    } else {
+        ListBuilder b;
+        list_builder_init(&b);
+        for (int64_t i = 0; i < kept; i++) list_builder_push(&b, out[i]);
+        result = rt_value_list(b.list);
+    }
+    rt_free_sized(out,   (size_t)(n ? n : 1) * sizeof(RuntimeValue *));
+    rt_free_sized(items, bytes);
+    return result;
+}
+
+static void par_fold_body(void *ctx, int64_t lo, int64_t hi) {
+    RtParJob *job = ctx;
+    for (int64_t c = lo; c < hi; c++) {
+        int64_t       i   = c * job->chunk;
+        int64_t       end = i + job->chunk < job->n ? i + job->chunk : job->n;
+        RuntimeValue *acc = job->items[i];
+        for (i++; i < end; i++)
+            acc = rt_closure_call2(job->fn, acc, job->items[i]);
+        job->out[c] = acc;
+    }
+}
+
+RuntimeValue *rt_par_fold(RuntimeValue *fn, RuntimeValue *init, RuntimeValue *coll) {
+    int64_t n;
+    size_t  bytes;
+    int     shape;
+    RuntimeValue **items = par_items(coll, &n, &bytes, &shape);
+    int64_t chunks = n < RT_PAR_MIN_ITEMS ? (n ? 1 : 0) : (int64_t)rt_pool_size() * 4;
+    if (chunks > n) chunks = n;
+    int64_t chunk = chunks ? (n + chunks - 1) / chunks : 0;
+    if (chunk) chunks = (n + chunk - 1) / chunk;
+    RuntimeValue **out = rt_alloc_zeroed((size_t)(chunks ? chunks : 1) * sizeof(RuntimeValue *));
+    RtParJob job = {fn, init, items, out, n, chunk};
+    rt_pool_for(chunks, 1, par_fold_body, &job);
+
+    RuntimeValue *acc = init;
+    for (int64_t c = 0; c < chunks; c++)
+        acc = rt_closure_call2(fn, acc, out[c]);
+    rt_free_sized(out,   (size_t)(chunks ? chunks : 1) * sizeof(RuntimeValue *));
+    rt_free_sized(items, bytes);
+    return acc;
+}
+
+///  Fiber scheduler
+//
+//  Green threads for I/O-bound programs.  rt_fiber_spawn(fn) queues a
+//  fiber that runs fn applied to its id; rt_fiber_run drives the ready
+//  queue on the calling thread until every fiber has finished.  A fiber
+//  gives up the thread only in rt_fiber_yield, or when rt_fiber_read,
+//  rt_fiber_write or rt_fiber_accept would block: the fd is made
+//  non-blocking, registered with the reactor (epoll on Linux, poll
+//  elsewhere) and the fiber parks until the fd is ready.  The scheduler
+//  puts those fds back in blocking mode when it finishes.  Outside a fiber
+//  the same calls simply block.  Every fiber waiting on an fd is woken
+//  when it becomes ready and retries, so many fibers can share a listener.
+//
+//  Stacks are mmap'd reservations with a guard page below them.  Pages
+//  are committed as the fiber touches them, so an idle connection costs a
+//  few KiB, and finished stacks are kept for the next spawn.  Each fiber
+//  carries its own thunk-pending stack, and the collector scans every
+//  parked fiber's stack and saved registers (fiber_gc_scan).
+//
+//  Environment:
+//    MONAD_FIBER_STACK=N   stack reservation per fiber in bytes
+//                          (default 256 KiB, at least 16 KiB)
+//
+#if defined(__unix__) && !defined(__ANDROID__)
+#define RT_FIBER_SUPPORTED 1
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include <unistd.h>
+#if defined(__linux__)
+#define RT_FIBER_EPOLL 1
+#include <sys/epoll.h>
+#else
+#define RT_FIBER_EPOLL 0
+#endif
+#else
+#define RT_FIBER_SUPPORTED 0
+#endif
+
+#if RT_FIBER_SUPPORTED
+
+#define RT_FIBER_STACK_DEFAULT (256 * 1024)
+#define RT_FIBER_STACK_MIN     (16 * 1024)
+
+typedef struct RtFiber {
+    ucontext_t      uc;
+    struct RtFiber *next;             // ready queue or spare list
+    RuntimeValue   *fn;
+    int64_t         id;
+    size_t          slot;             // index in g_rt_fibers.live
+    char           *stack;            // mapping, guard page first
+    size_t          stack_size;
+    char           *sp;               // stack top while parked, NULL before start
+    int             done;
+    int             wait_fd;          // -1 unless parked on the reactor
+    int             wait_write;
+    struct RtFiber *wait_next;        // same-fd waiters (epoll reactor)
+    ThunkPending   *pending;          // swapped with g_thunk_pending on switch
+    size_t          pending_len, pending_cap;
+} RtFiber;
+
+static RT_THREAD_LOCAL struct {
+    ucontext_t  main_uc;
+    char       *main_sp;
+    RtFiber    *current;
+    RtFiber    *ready_head, *ready_tail;
+    RtFiber    *spare;
+    RtFiber   **live;                 // spawned and not yet finished
+    size_t      live_len, live_cap;
+    RtFiber   **waiting;              // parked on an fd (poll reactor)
+    size_t      wait_len, wait_cap;   // wait_len counts parked fibers either way
+    int         epfd;
+    struct { RtFiber *readers, *writers; } *fds;   // epoll reactor, by fd
+    size_t      fd_cap;
+    struct { int fd; dev_t dev; ino_t ino; } *nonblock;   // fds we made non-blocking
+    size_t      nonblock_len, nonblock_cap;
+    size_t      page, stack_size;
+    int64_t     next_id;
+    int         running;
+} g_rt_fibers;
+
+static void fiber_push_ready(RtFiber *f) {
+    f->next = NULL;
+    if (g_rt_fibers.ready_tail) g_rt_fibers.ready_tail->next = f;
+    else                        g_rt_fibers.ready_head       = f;
+    g_rt_fibers.ready_tail = f;
+}
+
+static RtFiber *fiber_pop_ready(void) {
+    RtFiber *f = g_rt_fibers.ready_head;
+    if (f && !(g_rt_fibers.ready_head = f->next)) g_rt_fibers.ready_tail = NULL;
+    return f;
+}
+
+static void *fiber_grow(void *items, size_t *cap, size_t elem) {
+    *cap  = *cap ? *cap * 2 : 64;
+    items = realloc(items, *cap * elem);
+    if (!items) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
+    return items;
+}
+
+static void fiber_swap_pending(RtFiber *f) {
+    ThunkPending *p = g_thunk_pending;
+    size_t len = g_thunk_pending_len, cap = g_thunk_pending_cap;
+    g_thunk_pending     = f->pending;
+    g_thunk_pending_len = f->pending_len;
+    g_thunk_pending_cap = f->pending_cap;
+    f->pending = p; f->pending_len = len; f->pending_cap = cap;
+}
+
+static void fiber_entry(void) {
+    RtFiber *f = g_rt_fibers.current;
+    rt_closure_call1(f->fn, rt_value_int(f->id));
+    f->done = 1;
+    // uc_link returns to the scheduler in fiber_resume.
+}
+
+static RtFiber *fiber_new(RuntimeValue *fn) {
+    if (!g_rt_fibers.page) {
+        long page = sysconf(_SC_PAGESIZE);
+        const char *env = getenv("MONAD_FIBER_STACK");
+        long long want  = env ? atoll(env) : 0;
+        g_rt_fibers.page       = page > 0 ? (size_t)page : 4096;
+        g_rt_fibers.stack_size = want >= RT_FIBER_STACK_MIN ? (size_t)want
+                                                            : RT_FIBER_STACK_DEFAULT;
+        g_rt_fibers.epfd       = -1;
+    }
+    RtFiber *f = g_rt_fibers.spare;
+    if (f) {
+        g_rt_fibers.spare = f->next;
+    } else {
+        f = calloc(1, sizeof *f);
+        if (!f) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
+        size_t page = g_rt_fibers.page;
+        size_t size = (g_rt_fibers.stack_size + page - 1) / page * page + page;
+        void  *m    = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (m == MAP_FAILED) {
+            fprintf(stderr, "Error: cannot map a fiber stack\n");
+            exit(1);
+        }
+        mprotect(m, page, PROT_NONE);   // stacks grow down onto the guard
+        f->stack      = m;
+        f->stack_size = size;
+    }
+    f->fn      = fn;
+    f->id      = ++g_rt_fibers.next_id;
+    f->sp      = NULL;
+    f->done    = 0;
+    f->wait_fd = -1;
+    getcontext(&f->uc);
+    f->uc.uc_stack.ss_sp   = f->stack + g_rt_fibers.page;
+    f->uc.uc_stack.ss_size = f->stack_size - g_rt_fibers.page;
+    f->uc.uc_link          = &g_rt_fibers.main_uc;
+    makecontext(&f->uc, fiber_entry, 0);
+
+    if (g_rt_fibers.live_len == g_rt_fibers.live_cap)
+        g_rt_fibers.live = fiber_grow(g_rt_fibers.live, &g_rt_fibers.live_cap,
+                                      sizeof(RtFiber *));
+    f->slot = g_rt_fibers.live_len;
+    g_rt_fibers.live[g_rt_fibers.live_len++] = f;
+    return f;
+}
+
+static void fiber_release(RtFiber *f) {
+    RtFiber *last = g_rt_fibers.live[--g_rt_fibers.live_len];
+    g_rt_fibers.live[f->slot] = last;
+    last->slot = f->slot;
+    f->fn   = NULL;
+    f->sp   = NULL;
+    f->next = g_rt_fibers.spare;
+    g_rt_fibers.spare = f;
+}
+
+static void fiber_resume(RtFiber *f) {
+    volatile char top = 0;
+    g_rt_fibers.main_sp = (char *)&top;
+    g_rt_fibers.current = f;
+    fiber_swap_pending(f);
+    swapcontext(&g_rt_fibers.main_uc, &f->uc);
+    fiber_swap_pending(f);
+    g_rt_fibers.current = NULL;
+}
+
+static void fiber_park(void) {
+    RtFiber *f = g_rt_fibers.current;
+    volatile char top = 0;
+    f->sp = (char *)&top;
+    swapcontext(&f->uc, &g_rt_fibers.main_uc);
+}
+
+#if RT_FIBER_EPOLL
+static void fiber_wake_all(RtFiber *f) {
+    while (f) {
+        RtFiber *next = f->wait_next;
+        f->wait_fd = -1;
+        g_rt_fibers.wait_len--;
+        fiber_push_ready(f);
+        f = next;
+    }
+}
+
+// (Re-)arm fd for whatever its remaining waiters need.  One-shot, so an
+// event is delivered once per arming.
+static int fiber_arm(int fd) {
+    uint32_t want = (g_rt_fibers.fds[fd].readers ? EPOLLIN  : 0) |
+                    (g_rt_fibers.fds[fd].writers ? EPOLLOUT : 0);
+    if (!want) return 0;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events  = want | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(g_rt_fibers.epfd, EPOLL_CTL_MOD, fd, &ev) == 0) return 0;
+    return epoll_ctl(g_rt_fibers.epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+#endif
+
+// Park the current fiber until fd is readable (or writable).
+static void fiber_wait(int fd, int want_write) {
+    RtFiber *f = g_rt_fibers.current;
+    if (!f) {
+        struct pollfd p = {fd, (short)(want_write ? POLLOUT : POLLIN), 0};
+        poll(&p, 1, -1);
+        return;
+    }
+    f->wait_fd    = fd;
+    f->wait_write = want_write;
+#if RT_FIBER_EPOLL
+    if (g_rt_fibers.epfd < 0 && (g_rt_fibers.epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        fprintf(stderr, "Error: epoll_create1 failed\n");
+        exit(1);
+    }
+    if ((size_t)fd >= g_rt_fibers.fd_cap) {
+        size_t cap = g_rt_fibers.fd_cap ? g_rt_fibers.fd_cap : 64;
+        while (cap <= (size_t)fd) cap *= 2;
+        g_rt_fibers.fds = realloc(g_rt_fibers.fds, cap * sizeof *g_rt_fibers.fds);
+        if (!g_rt_fibers.fds) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
+        memset(g_rt_fibers.fds + g_rt_fibers.fd_cap, 0,
+               (cap - g_rt_fibers.fd_cap) * sizeof *g_rt_fibers.fds);
+        g_rt_fibers.fd_cap = cap;
+    }
+    RtFiber **list = want_write ? &g_rt_fibers.fds[fd].writers
+                                : &g_rt_fibers.fds[fd].readers;
+    f->wait_next = *list;
+    *list        = f;
+    if (fiber_arm(fd) < 0) {
+        // Regular files cannot be polled; they are always ready.
+        *list      = f->wait_next;
+        f->wait_fd = -1;
+        return;
+    }
+    g_rt_fibers.wait_len++;
+#else
+    if (g_rt_fibers.wait_len == g_rt_fibers.wait_cap)
+        g_rt_fibers.waiting = fiber_grow(g_rt_fibers.waiting, &g_rt_fibers.wait_cap,
+                                         sizeof(RtFiber *));
+    g_rt_fibers.waiting[g_rt_fibers.wait_len++] = f;
+#endif
+    fiber_park();
+}
+
+// Move fibers whose fd is ready onto the ready queue.
+static void fiber_poll(int timeout_ms) {
+#if RT_FIBER_EPOLL
+    struct epoll_event ev[64];
+    int n = epoll_wait(g_rt_fibers.epfd, ev, 64, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        int      fd  = ev[i].data.fd;
+        uint32_t got = ev[i].events;
+        if (got & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            fiber_wake_all(g_rt_fibers.fds[fd].readers);
+            g_rt_fibers.fds[fd].readers = NULL;
+        }
+        if (got & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            fiber_wake_all(g_rt_fibers.fds[fd].writers);
+            g_rt_fibers.fds[fd].writers = NULL;
+        }
+        fiber_arm(fd);
+    }
+#else
+    size_t n = g_rt_fibers.wait_len;
+    struct pollfd *p = malloc(n * sizeof *p);
+    if (!p) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
+    for (size_t i = 0; i < n; i++) {
+        RtFiber *f = g_rt_fibers.waiting[i];
+        p[i] = (struct pollfd){f->wait_fd, (short)(f->wait_write ? POLLOUT : POLLIN), 0};
+    }
+    if (poll(p, (nfds_t)n, timeout_ms) > 0) {
+        size_t keep = 0;
+        for (size_t i = 0; i < n; i++) {
+            RtFiber *f = g_rt_fibers.waiting[i];
+            if (p[i].revents) {
+                f->wait_fd = -1;
+                fiber_push_ready(f);
+            } else {
+                g_rt_fibers.waiting[keep++] = f;
+            }
+        }
+        g_rt_fibers.wait_len = keep;
+    }
+    free(p);
+#endif
+}
+
+// O_NONBLOCK lives on the open file description, which a shell shares
+// with the program's stdio, so every fd switched here is remembered and
+// switched back when the outermost rt_fiber_run returns (or at exit).
+// An fd closed and reused for another file in between is left alone.
+static void fiber_restore_blocking(void) {
+    for (size_t i = 0; i < g_rt_fibers.nonblock_len; i++) {
+        int         fd = g_rt_fibers.nonblock[i].fd;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_dev != g_rt_fibers.nonblock[i].dev ||
+            st.st_ino != g_rt_fibers.nonblock[i].ino)
+            continue;
+        int fl = fcntl(fd, F_GETFL);
+        if (fl >= 0) fcntl(fd, F_SETFL, fl & ~O_NONBLOCK);
+    }
+    g_rt_fibers.nonblock_len = 0;
+}
+
+static void fiber_nonblock(int fd) {
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || (fl & O_NONBLOCK)) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) != 0) return;
+    static RT_THREAD_LOCAL int at_exit;
+    if (!at_exit) {
+        atexit(fiber_restore_blocking);
+        at_exit = 1;
+    }
+    if (g_rt_fibers.nonblock_len == g_rt_fibers.nonblock_cap)
+        g_rt_fibers.nonblock = fiber_grow(g_rt_fibers.nonblock, &g_rt_fibers.nonblock_cap,
+                                          sizeof *g_rt_fibers.nonblock);
+    g_rt_fibers.nonblock[g_rt_fibers.nonblock_len].fd  = fd;
+    g_rt_fibers.nonblock[g_rt_fibers.nonblock_len].dev = st.st_dev;
+    g_rt_fibers.nonblock[g_rt_fibers.nonblock_len].ino = st.st_ino;
+    g_rt_fibers.nonblock_len++;
+}
+
+// Conservative roots for the collector while fibers exist: every fiber
+// record, each parked stack, and — when a fiber is running — its stack
+// from `top` plus the scheduler's stack and saved registers.  Returns 1
+// when it has covered the running stack itself.
+static int fiber_gc_scan(const char *top) {
+    for (size_t i = 0; i < g_rt_fibers.live_len; i++) {
+        RtFiber *f = g_rt_fibers.live[i];
+        gc_scan_range((const char *)f, (const char *)(f + 1));
+        if (f != g_rt_fibers.current && f->sp)
+            gc_scan_range(f->sp, f->stack + f->stack_size);
+    }
+    RtFiber *cur = g_rt_fibers.current;
+    if (!cur) return 0;
+    gc_scan_range(top, cur->stack + cur->stack_size);
+    gc_scan_range((const char *)&g_rt_fibers.main_uc,
+                  (const char *)(&g_rt_fibers.main_uc + 1));
+    gc_scan_range(g_rt_fibers.main_sp, g_rt_gc.stack_base);
+    return 1;
+}
+
+int64_t rt_fiber_spawn(RuntimeValue *fn) {
+    RtFiber *f = fiber_new(fn);
+    fiber_push_ready(f);
+    return f->id;
+}
+
+RuntimeValue *rt_fiber_yield(RuntimeValue *value) {
+    if (g_rt_fibers.current) {
+        fiber_push_ready(g_rt_fibers.current);
+        fiber_park();
+    }
+    return value;
+}
+
+int64_t rt_fiber_run(RuntimeValue *fn) {
+    if (fn) rt_fiber_spawn(fn);
+    if (g_rt_fibers.current || g_rt_fibers.running) return 0;   // the outer loop drives
+    g_rt_fibers.running = 1;
+    int64_t finished = 0;
+    for (;;) {
+        // Check I/O before every ready fiber runs, so a busy queue cannot
+        // starve parked connections; block only when nothing is ready.
+        if (g_rt_fibers.wait_len) fiber_poll(g_rt_fibers.ready_head ? 0 : -1);
+        RtFiber *f = fiber_pop_ready();
+        if (!f) {
+            if (g_rt_fibers.wait_len) continue;
+            break;
+        }
+        fiber_resume(f);
+        if (f->done) {
+            fiber_release(f);
+            finished++;
+        }
+    }
+    g_rt_fibers.running = 0;
+    fiber_restore_blocking();
+    return finished;
+}
+
+int64_t rt_fiber_read(int64_t fd, void *buf, int64_t len) {
+    if (g_rt_fibers.current) fiber_nonblock((int)fd);
+    for (;;) {
+        ssize_t n = read((int)fd, buf, (size_t)len);
+        if (n >= 0) return (int64_t)n;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -(int64_t)errno;
+        fiber_wait((int)fd, 0);
+    }
+}
+
+int64_t rt_fiber_write(int64_t fd, const void *buf, int64_t len) {
+    if (g_rt_fibers.current) fiber_nonblock((int)fd);
+    for (;;) {
+        ssize_t n = write((int)fd, buf, (size_t)len);
+        if (n >= 0) return (int64_t)n;
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -(int64_t)errno;
+        fiber_wait((int)fd, 1);
+    }
+}
+
+int64_t rt_fiber_accept(int64_t fd) {
+    if (g_rt_fibers.current) fiber_nonblock((int)fd);
+    for (;;) {
+        int c = accept((int)fd, NULL, NULL);
+        if (c >= 0) return c;
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -(int64_t)errno;
+        fiber_wait((int)fd, 0);
+    }
+}
+
+#else /* !RT_FIBER_SUPPORTED: spawn runs to completion, I/O blocks */
+
+static int fiber_gc_scan(const char *top) { (void)top; return 0; }
+
+static int64_t g_rt_fiber_next_id;
+
+int64_t rt_fiber_spawn(RuntimeValue *fn) {
+    int64_t id = ++g_rt_fiber_next_id;
+    rt_closure_call1(fn, rt_value_int(id));
+    return id;
+}
+
+RuntimeValue *rt_fiber_yield(RuntimeValue *value) { return value; }
+
+int64_t rt_fiber_run(RuntimeValue *fn) {
+    if (fn) rt_fiber_spawn(fn);
+    return fn ? 1 : 0;
+}
+
+int64_t rt_fiber_read(int64_t fd, void *buf, int64_t len) {
+    (void)fd; (void)buf; (void)len;
+    return -1;
+}
+
+int64_t rt_fiber_write(int64_t fd, const void *buf, int64_t len) {
+    (void)fd; (void)buf; (void)len;
+    return -1;
+}
+
+int64_t rt_fiber_accept(int64_t fd) { (void)fd; return -1; }
+
+#endif
+
+///  Unboxed array kernels
+//
+//  An Arr :: Int or Arr :: Float in compiled code is already unboxed: the
+//  arr.fat data pointer addresses contiguous int64_t or double elements.
+//  array-sum, array-dot, array-affine, array-min, array-max and array-scan
+//  lower to these loops.  Float sums and dots keep four partial sums (two
+//  registers of two lanes) combined as (s0 + s2) + (s1 + s3); the scalar
+//  path adds in the same order, so a result never depends on the host's
+//  vector unit.  Int arithmetic wraps, as it does in compiled code.
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define RT_KERNEL_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define RT_KERNEL_NEON 1
+#endif
+
+#if defined(RT_KERNEL_SSE2)
+
+typedef __m128d RtF64x2;
+typedef __m128i RtI64x2;
+
+static inline RtF64x2 rt_f64x2_load(const double *p)          { return _mm_loadu_pd(p); }
+static inline void    rt_f64x2_store(double *p, RtF64x2 v)    { _mm_storeu_pd(p, v); }
+static inline RtF64x2 rt_f64x2_splat(double x)                { return _mm_set1_pd(x); }
+static inline RtF64x2 rt_f64x2_add(RtF64x2 a, RtF64x2 b)      { return _mm_add_pd(a, b); }
+static inline RtF64x2 rt_f64x2_mul(RtF64x2 a, RtF64x2 b)      { return _mm_mul_pd(a, b); }
+// minpd/maxpd are exactly a < b ? a : b and a > b ? a : b, NaNs included
+static inline RtF64x2 rt_f64x2_min(RtF64x2 a, RtF64x2 b)      { return _mm_min_pd(a, b); }
+static inline RtF64x2 rt_f64x2_max(RtF64x2 a, RtF64x2 b)      { return _mm_max_pd(a, b); }
+static inline double  rt_f64x2_hsum(RtF64x2 v) {
+    return _mm_cvtsd_f64(v) + _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+}
+
+static inline RtI64x2 rt_i64x2_load(const int64_t *p)         { return _mm_loadu_si128((const __m128i *)p); }
+static inline void    rt_i64x2_store(int64_t *p, RtI64x2 v)   { _mm_storeu_si128((__m128i *)p, v); }
+static inline RtI64x2 rt_i64x2_zero(void)                     { return _mm_setzero_si128(); }
+static inline RtI64x2 rt_i64x2_add(RtI64x2 a, RtI64x2 b)      { return _mm_add_epi64(a, b); }
+// (a0, a1) -> (0, a0)
+static inline RtI64x2 rt_i64x2_shift(RtI64x2 a)               { return _mm_slli_si128(a, 8); }
+// (a0, a1) -> (a1, a1)
+static inline RtI64x2 rt_i64x2_high(RtI64x2 a)                { return _mm_unpackhi_epi64(a, a); }
+static inline uint64_t rt_i64x2_hsum(RtI64x2 v) {
+    int64_t lanes[2];
+    rt_i64x2_store(lanes, v);
+    return (uint64_t)lanes[0] + (uint64_t)lanes[1];
+}
+
+#elif defined(RT_KERNEL_NEON)
+
+typedef float64x2_t RtF64x2;
+typedef int64x2_t   RtI64x2;
+
+static inline RtF64x2 rt_f64x2_load(const double *p)          { return vld1q_f64(p); }
+static inline void    rt_f64x2_store(double *p, RtF64x2 v)    { vst1q_f64(p, v); }
+static inline RtF64x2 rt_f64x2_splat(double x)                { return vdupq_n_f64(x); }
+static inline RtF64x2 rt_f64x2_add(RtF64x2 a, RtF64x2 b)      { return vaddq_f64(a, b); }
+static inline RtF64x2 rt_f64x2_mul(RtF64x2 a, RtF64x2 b)      { return vmulq_f64(a, b); }
+// fmin/fmax would propagate NaNs differently from the scalar path
+static inline RtF64x2 rt_f64x2_min(RtF64x2 a, RtF64x2 b)      { return vbslq_f64(vcltq_f64(a, b), a, b); }
+static inline RtF64x2 rt_f64x2_max(RtF64x2 a, RtF64x2 b)      { return vbslq_f64(vcgtq_f64(a, b), a, b); }
+static inline double  rt_f64x2_hsum(RtF64x2 v) {
+    return vgetq_lane_f64(v, 0) + vgetq_lane_f64(v, 1);
+}
+
+static inline RtI64x2 rt_i64x2_load(const int64_t *p)         { return vld1q_s64(p); }
+static inline void    rt_i64x2_store(int64_t *p, RtI64x2 v)   { vst1q_s64(p, v); }
+static inline RtI64x2 rt_i64x2_zero(void)                     { return vdupq_n_s64(0); }
+static inline RtI64x2 rt_i64x2_add(RtI64x2 a, RtI64x2 b)      { return vaddq_s64(a, b); }
+static inline RtI64x2 rt_i64x2_shift(RtI64x2 a)               { return vextq_s64(vdupq_n_s64(0), a, 1); }
+static inline RtI64x2 rt_i64x2_high(RtI64x2 a)                { return vdupq_laneq_s64(a, 1); }
+static inline uint64_t rt_i64x2_hsum(RtI64x2 v) {
+    return (uint64_t)vgetq_lane_s64(v, 0) + (uint64_t)vgetq_lane_s64(v, 1);
+}
+
+#endif
+
+#if defined(RT_KERNEL_SSE2) || defined(RT_KERNEL_NEON)
+#  define RT_KERNEL_VECTOR 1
+#endif
+
+int64_t rt_arr_sum_i64(const int64_t *xs, int64_t n) {
+    uint64_t s = 0;
+    int64_t  i = 0;
+#if defined(RT_KERNEL_VECTOR)
+    RtI64x2 a0 = rt_i64x2_zero(), a1 = rt_i64x2_zero();
+    for (; i + 4 <= n; i += 4) {
+        a0 = rt_i64x2_add(a0, rt_i64x2_load(xs + i));
+        a1 = rt_i64x2_add(a1, rt_i64x2_load(xs + i + 2));
+    }
+    s = rt_i64x2_hsum(rt_i64x2_add(a0, a1));
+#endif
+    for (; i < n; i++) s += (uint64_t)xs[i];
+    return (int64_t)s;
+}
+
+double rt_arr_sum_f64(const double *xs, int64_t n) {
+    int64_t i = 0;
+    double  s;
+#if defined(RT_KERNEL_VECTOR)
+    RtF64x2 a0 = rt_f64x2_splat(0.0), a1 = rt_f64x2_splat(0.0);
+    for (; i + 4 <= n; i += 4) {
+        a0 = rt_f64x2_add(a0, rt_f64x2_load(xs + i));
+        a1 = rt_f64x2_add(a1, rt_f64x2_load(xs + i + 2));
+    }
+    s = rt_f64x2_hsum(rt_f64x2_add(a0, a1));
+#else
+    double p[4] = {0.0, 0.0, 0.0, 0.0};
+    for (; i + 4 <= n; i += 4)
+        for (int k = 0; k < 4; k++) p[k] += xs[i + k];
+    s = (p[0] + p[2]) + (p[1] + p[3]);
+#endif
+    for (; i < n; i++) s += xs[i];
+    return s;
+}
+
+int64_t rt_arr_dot_i64(const int64_t *a, const int64_t *b, int64_t n) {
+    uint64_t s = 0;
+    for (int64_t i = 0; i < n; i++) s += (uint64_t)a[i] * (uint64_t)b[i];
+    return (int64_t)s;
+}
+
+double rt_arr_dot_f64(const double *a, const double *b, int64_t n) {
+    int64_t i = 0;
+    double  s;
+#if defined(RT_KERNEL_VECTOR)
+    RtF64x2 a0 = rt_f64x2_splat(0.0), a1 = rt_f64x2_splat(0.0);
+    for (; i + 4 <= n; i += 4) {
+        a0 = rt_f64x2_add(a0, rt_f64x2_mul(rt_f64x2_load(a + i),     rt_f64x2_load(b + i)));
+        a1 = rt_f64x2_add(a1, rt_f64x2_mul(rt_f64x2_load(a + i + 2), rt_f64x2_load(b + i + 2)));
+    }
+    s = rt_f64x2_hsum(rt_f64x2_add(a0, a1));
+#else
+    double p[4] = {0.0, 0.0, 0.0, 0.0};
+    for (; i + 4 <= n; i += 4)
+        for (int k = 0; k < 4; k++) p[k] += a[i + k] * b[i + k];
+    s = (p[0] + p[2]) + (p[1] + p[3]);
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+void rt_arr_affine_i64(int64_t *dst, const int64_t *xs, int64_t n,
+                       int64_t scale, int64_t offset) {
+    for (int64_t i = 0; i < n; i++)
+        dst[i] = (int64_t)((uint64_t)xs[i] * (uint64_t)scale + (uint64_t)offset);
+}
+
+void rt_arr_affine_f64(double *dst, const double *xs, int64_t n,
+                       double scale, double offset) {
+    int64_t i = 0;
+#if defined(RT_KERNEL_VECTOR)
+    RtF64x2 vs = rt_f64x2_splat(scale), vo = rt_f64x2_splat(offset);
+    for (; i + 2 <= n; i += 2)
+        rt_f64x2_store(dst + i, rt_f64x2_add(rt_f64x2_mul(rt_f64x2_load(xs + i), vs), vo));
+#endif
+    for (; i < n; i++) dst[i] = xs[i] * scale + offset;
+}
+
+void rt_arr_min_i64(int64_t *dst, const int64_t *a, const int64_t *b, int64_t n) {
+    for (int64_t i = 0; i < n; i++) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+void rt_arr_max_i64(int64_t *dst, const int64_t *a, const int64_t *b, int64_t n) {
+    for (int64_t i = 0; i < n; i++) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+void rt_arr_min_f64(double *dst, const double *a, const double *b, int64_t n) {
+    int64_t i = 0;
+#if defined(RT_KERNEL_VECTOR)
+    for (; i + 2 <= n; i += 2)
+        rt_f64x2_store(dst + i, rt_f64x2_min(rt_f64x2_load(a + i), rt_f64x2_load(b + i)));
+#endif
+    for (; i < n; i++) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+void rt_arr_max_f64(double *dst, const double *a, const double *b, int64_t n) {
+    int64_t i = 0;
+#if defined(RT_KERNEL_VECTOR)
+    for (; i + 2 <= n; i += 2)
+        rt_f64x2_store(dst + i, rt_f64x2_max(rt_f64x2_load(a + i), rt_f64x2_load(b + i)));
+#endif
+    for (; i < n; i++) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+// Inclusive prefix sums.  Each pair is scanned in-register, (x0, x1) ->
+// (x0, x0 + x1), then offset by the running total.
+void rt_arr_scan_i64(int64_t *dst, const int64_t *xs, int64_t n) {
+    uint64_t run = 0;
+    int64_t  i   = 0;
+#if defined(RT_KERNEL_VECTOR)
+    RtI64x2 carry = rt_i64x2_zero();
+    for (; i + 2 <= n; i += 2) {
+        RtI64x2 v = rt_i64x2_load(xs + i);
+        v = rt_i64x2_add(v, rt_i64x2_shift(v));
+        v = rt_i64x2_add(v, carry);
+        rt_i64x2_store(dst + i, v);
+        carry = rt_i64x2_high(v);
+    }
+    if (i) run = (uint64_t)dst[i - 1];
+#endif
+    for (; i < n; i++) {
+        run += (uint64_t)xs[i];
+        dst[i] = (int64_t)run;
+    }
+}
+
+// Float scans stay sequential: any regrouping changes the rounding of
+// every later prefix.
+void rt_arr_scan_f64(double *dst, const double *xs, int64_t n) {
+    double run = 0.0;
+    for (int64_t i = 0; i < n; i++) {
+        run += xs[i];
+        dst[i] = run;
+    }
+}
 
-void declare_runtime_functions(CodegenContext *ctx) {
-    LLVMTypeRef ptr    = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
-    LLVMTypeRef i64    = LLVMInt64TypeInContext(ctx->context);
-    LLVMTypeRef i32    = LLVMInt32TypeInContext(ctx->context);
-    LLVMTypeRef i8     = LLVMInt8TypeInContext(ctx->context);
-    LLVMTypeRef dbl    = LLVMDoubleTypeInContext(ctx->context);
-    LLVMTypeRef void_t = LLVMVoidTypeInContext(ctx->context);
 
+///  LLVM Integration — runtime declarations
+//
+//  Runtime signatures live in one static table.  Nothing is added to a
+//  module up front: the first get_rt_* call for a function declares it in
+//  ctx->module and caches it in ctx->rt_fns, a dense array indexed by the
+//  function's row here.  Each getter finds its row by name once per
+//  process.  A module therefore carries only the runtime it calls, and a
+//  lookup after the first is an array load instead of a symbol-table hash.
+
+enum { RT_T_VOID, RT_T_PTR, RT_T_I64, RT_T_I32, RT_T_I8, RT_T_DBL };
+
+typedef struct {
+    const char    *name;
+    unsigned char  ret;
+    unsigned char  argc;
+    unsigned char  args[7];
+} RuntimeDecl;
+
+#define void_t RT_T_VOID
+#define ptr    RT_T_PTR
+#define i64    RT_T_I64
+#define i32    RT_T_I32
+#define i8     RT_T_I8
+#define dbl    RT_T_DBL
 #define DECL(name, ret, ...) \
-    do { \
-        LLVMTypeRef _p[] = { __VA_ARGS__ }; \
-        int _n = sizeof(_p)/sizeof(_p[0]); \
-        LLVMAddFunction(ctx->module, name, LLVMFunctionType(ret, _n ? _p : NULL, _n, 0)); \
-    } while(0)
-#define DECL0(name, ret) \
-    LLVMAddFunction(ctx->module, name, LLVMFunctionType(ret, NULL, 0, 0))
+    { name, ret, sizeof((unsigned char[]){ __VA_ARGS__ }), { __VA_ARGS__ } }
+#define DECL0(name, ret) { name, ret, 0, { 0 } }
 
-    DECL("rt_ast_to_runtime_value", ptr, ptr);
+static const RuntimeDecl g_runtime_decls[] = {
+    DECL("rt_ast_to_runtime_value", ptr, ptr),
 
     // --- Closure ---
-    DECL("rt_value_closure", ptr, ptr, ptr, i32, i32);  // fn_ptr, env, env_size, arity
-    DECL("rt_value_closure_named", ptr, ptr, ptr, i32, i32, ptr);  // fn_ptr, env, env_size, arity, name
-    DECL("rt_closure_calln", ptr, ptr, i32, ptr);       // closure, n, args_array
-    DECL("rt_closure_get_env", ptr, ptr);               // closure -> env ptr
-    DECL("rt_closure_get_fn_ptr", ptr, ptr);            // closure -> function ptr
+    DECL("rt_value_closure", ptr, ptr, ptr, i32, i32),  // fn_ptr, env, env_size, arity
+    DECL("rt_value_closure_named", ptr, ptr, ptr, i32, i32, ptr),  // fn_ptr, env, env_size, arity, name
+    DECL("rt_value_closure_direct", ptr, ptr, ptr, ptr, i32, i32, ptr),  // fn_ptr, direct, env, env_size, arity, name
+    DECL("rt_closure_calln", ptr, ptr, i32, ptr),       // closure, n, args_array
+    DECL("rt_closure_call1", ptr, ptr, ptr),            // closure, a
+    DECL("rt_closure_call2", ptr, ptr, ptr, ptr),       // closure, a, b
+    DECL("rt_closure_call3", ptr, ptr, ptr, ptr, ptr),  // closure, a, b, c
+    DECL("rt_closure_get_env", ptr, ptr),               // closure -> env ptr
+    DECL("rt_closure_get_fn_ptr", ptr, ptr),            // closure -> function ptr
 
     // --- Thunks ---
-    DECL("rt_thunk_of_value", ptr, ptr);
-    DECL("rt_thunk_create", ptr, ptr, ptr);
-    DECL("rt_force", ptr, ptr);
+    DECL("rt_thunk_of_value", ptr, ptr),
+    DECL("rt_thunk_create", ptr, ptr, ptr),
+    DECL("rt_force", ptr, ptr),
 
     // --- List constructors ---
-    DECL0("rt_list_new", ptr);
-    DECL0("rt_list_empty", ptr);
-    DECL("rt_list_lazy_cons", ptr, ptr, ptr);
-    DECL("rt_list_cons", ptr, ptr, ptr);
-    DECL("rt_list_is_empty_list", i32, ptr);
-    DECL("rt_is_pair", i32, ptr);
+    DECL0("rt_list_new", ptr),
+    DECL0("rt_list_empty", ptr),
+    DECL("rt_list_lazy_cons", ptr, ptr, ptr),
+    DECL("rt_list_cons", ptr, ptr, ptr),
+    DECL("rt_list_is_empty_list", i32, ptr),
+    DECL("rt_is_pair", i32, ptr),
 
     // --- List accessors ---
-    DECL("rt_list_car",    ptr, ptr);
-    DECL("rt_list_cdr",    ptr, ptr);
-    DECL("rt_list_nth",    ptr, ptr, i64);
-    DECL("rt_list_length", i64, ptr);
+    DECL("rt_list_car",    ptr, ptr),
+    DECL("rt_list_cdr",    ptr, ptr),
+    DECL("rt_list_nth",    ptr, ptr, i64),
+    DECL("rt_list_length", i64, ptr),
 
     // --- List mutation/construction ---
-    DECL("rt_list_append",       void_t, ptr, ptr);
-    DECL("rt_list_append_lists", ptr, ptr, ptr);
-    DECL("rt_list_copy",         ptr, ptr);
-    DECL("rt_make_list",         ptr, i64, ptr);
+    DECL("rt_list_append",       void_t, ptr, ptr),
+    DECL("rt_list_append_lists", ptr, ptr, ptr),
+    DECL("rt_list_copy",         ptr, ptr),
+    DECL("rt_make_list",         ptr, i64, ptr),
 
     // --- Range / infinite lists ---
-    DECL("rt_list_range",     ptr, i64, i64);
-    DECL("rt_list_from",      ptr, i64);
-    DECL("rt_list_from_step", ptr, i64, i64);
-    DECL("rt_list_take",      ptr, ptr, i64);
-    DECL("rt_list_drop",      ptr, ptr, i64);
+    DECL("rt_list_range",     ptr, i64, i64),
+    DECL("rt_list_from",      ptr, i64),
+    DECL("rt_list_from_step", ptr, i64, i64),
+    DECL("rt_list_take",      ptr, ptr, i64),
+    DECL("rt_list_drop",      ptr, ptr, i64),
 
     // --- Higher-order list ops ---
-    DECL("rt_list_map",     ptr, ptr, ptr, ptr);        /* list, env, fn */
-    DECL("rt_list_foldl",   ptr, ptr, ptr, ptr, ptr);   /* list, init, env, fn */
-    DECL("rt_list_foldr",   ptr, ptr, ptr, ptr, ptr);   /* list, init, env, fn */
-    DECL("rt_list_filter",  ptr, ptr, ptr, ptr);        /* list, env, pred */
-    DECL("rt_list_zipwith", ptr, ptr, ptr, ptr, ptr);   /* a, b, env, fn */
-    DECL("rt_list_zip",     ptr, ptr, ptr);       // (a, b) -> list
+    DECL("rt_list_map",     ptr, ptr, ptr, ptr),        /* list, env, fn */
+    DECL("rt_list_foldl",   ptr, ptr, ptr, ptr, ptr),   /* list, init, env, fn */
+    DECL("rt_list_foldr",   ptr, ptr, ptr, ptr, ptr),   /* list, init, env, fn */
+    DECL("rt_list_filter",  ptr, ptr, ptr, ptr),        /* list, env, pred */
+    DECL("rt_list_zipwith", ptr, ptr, ptr, ptr, ptr),   /* a, b, env, fn */
+    DECL("rt_list_zip",     ptr, ptr, ptr),       // (a, b) -> list
 
 
 
     // --- Equality ---
-    DECL("rt_equal_p", i32, ptr, ptr);
+    DECL("rt_equal_p", i32, ptr, ptr),
 
     // --- Unboxing ---
-    DECL("rt_unbox_int",    i64,    ptr);
-    DECL("rt_unbox_float",  dbl,    ptr);
-    DECL("rt_unbox_char",   i8,     ptr);
-    DECL("rt_unbox_string", ptr,    ptr);
-    DECL("rt_unbox_list",   ptr,    ptr);
-    DECL("rt_value_is_nil", i32,    ptr);
-    DECL("rt_print_value_newline", void_t, ptr);
+    DECL("rt_unbox_int",    i64,    ptr),
+    DECL("rt_unbox_float",  dbl,    ptr),
+    DECL("rt_unbox_char",   i8,     ptr),
+    DECL("rt_unbox_string", ptr,    ptr),
+    DECL("rt_unbox_list",   ptr,    ptr),
+    DECL("rt_value_is_nil", i32,    ptr),
+    DECL("rt_print_value_newline", void_t, ptr),
 
     // --- Value construction ---
-    DECL("rt_value_int",     ptr, i64);
-    DECL("rt_value_float",   ptr, dbl);
-    DECL("rt_value_char",    ptr, i8);
-    DECL("rt_value_string",  ptr, ptr);
-    DECL("rt_value_symbol",  ptr, ptr);
-    DECL("rt_value_keyword", ptr, ptr);
-    DECL("rt_value_list",    ptr, ptr);
-    DECL0("rt_value_nil",    ptr);
-    DECL("rt_value_thunk",   ptr, ptr);
+    DECL("rt_value_int",     ptr, i64),
+    DECL("rt_value_float",   ptr, dbl),
+    DECL("rt_value_char",    ptr, i8),
+    DECL("rt_value_string",  ptr, ptr),
+    DECL("rt_value_symbol",  ptr, ptr),
+    DECL("rt_value_keyword", ptr, ptr),
+    DECL("rt_value_list",    ptr, ptr),
+    DECL0("rt_value_nil",    ptr),
+    DECL("rt_value_thunk",   ptr, ptr),
 
     // --- Ratio ---
-    DECL("rt_value_ratio",    ptr, i64, i64);
-    DECL("rt_ratio_from_int", ptr, i64);
-    DECL("rt_ratio_add",      ptr, ptr, ptr);
-    DECL("rt_ratio_sub",      ptr, ptr, ptr);
-    DECL("rt_ratio_mul",      ptr, ptr, ptr);
-    DECL("rt_ratio_div",      ptr, ptr, ptr);
-    DECL("rt_ratio_to_int",   i64, ptr);
-    DECL("rt_ratio_to_float", dbl, ptr);
+    DECL("rt_value_ratio",    ptr, i64, i64),
+    DECL("rt_ratio_from_int", ptr, i64),
+    DECL("rt_ratio_add",      ptr, ptr, ptr),
+    DECL("rt_ratio_sub",      ptr, ptr, ptr),
+    DECL("rt_ratio_mul",      ptr, ptr, ptr),
+    DECL("rt_ratio_div",      ptr, ptr, ptr),
+    DECL("rt_ratio_to_int",   i64, ptr),
+    DECL("rt_ratio_to_float", dbl, ptr),
 
     // --- Array ---
-    DECL("rt_value_array",  ptr, i64);
-    DECL("rt_value_opaque", ptr, ptr);
-    DECL("rt_array_set",    void_t, ptr, i64, ptr);
-    DECL("rt_array_get",    ptr, ptr, i64);
-    DECL("rt_array_length", i64, ptr);
+    DECL("rt_value_array",  ptr, i64),
+    DECL("rt_value_opaque", ptr, ptr),
+    DECL("rt_array_set",    void_t, ptr, i64, ptr),
+    DECL("rt_array_get",    ptr, ptr, i64),
+    DECL("rt_array_length", i64, ptr),
+
+    // --- Unboxed array kernels ---
+    DECL("rt_arr_sum_i64",    i64,    ptr, i64),
+    DECL("rt_arr_sum_f64",    dbl,    ptr, i64),
+    DECL("rt_arr_dot_i64",    i64,    ptr, ptr, i64),
+    DECL("rt_arr_dot_f64",    dbl,    ptr, ptr, i64),
+    DECL("rt_arr_affine_i64", void_t, ptr, ptr, i64, i64, i64),
+    DECL("rt_arr_affine_f64", void_t, ptr, ptr, i64, dbl, dbl),
+    DECL("rt_arr_min_i64",    void_t, ptr, ptr, ptr, i64),
+    DECL("rt_arr_max_i64",    void_t, ptr, ptr, ptr, i64),
+    DECL("rt_arr_min_f64",    void_t, ptr, ptr, ptr, i64),
+    DECL("rt_arr_max_f64",    void_t, ptr, ptr, ptr, i64),
+    DECL("rt_arr_scan_i64",   void_t, ptr, ptr, i64),
+    DECL("rt_arr_scan_f64",   void_t, ptr, ptr, i64),
+
+    // --- Parallel collection operations ---
+    DECL("rt_par_map",        ptr, ptr, ptr),        /* fn, coll */
+    DECL("rt_par_filter",     ptr, ptr, ptr),        /* pred, coll */
+    DECL("rt_par_fold",       ptr, ptr, ptr, ptr),   /* fn, init, coll */
+
+    // --- Fiber scheduler ---
+    DECL("rt_fiber_spawn",    i64, ptr),             /* fn */
+    DECL("rt_fiber_yield",    ptr, ptr),
+    DECL("rt_fiber_run",      i64, ptr),             /* fn */
+    DECL("rt_fiber_read",     i64, i64, ptr, i64),   /* fd, buf, len */
+    DECL("rt_fiber_write",    i64, i64, ptr, i64),
+    DECL("rt_fiber_accept",   i64, i64),
 
     // --- Set ---
-    DECL0("rt_set_new",        ptr);
-    DECL("rt_set_from_predicate", ptr, ptr);
-    DECL("rt_set_of",          ptr, ptr, i64);
-    DECL("rt_set_from_list",   ptr, ptr);
-    DECL("rt_set_from_array",  ptr, ptr);
-    DECL("rt_set_contains",    i32, ptr, ptr);
-    DECL("rt_set_conj",        ptr, ptr, ptr);
-    DECL("rt_set_disj",        ptr, ptr, ptr);
-    DECL("rt_set_conj_mut",    ptr, ptr, ptr);
-    DECL("rt_set_disj_mut",    ptr, ptr, ptr);
-    DECL("rt_set_get",         ptr, ptr, ptr);
-    DECL("rt_set_count",       i64, ptr);
-    DECL("rt_set_seq",         ptr, ptr);
-    DECL("rt_value_set",       ptr, ptr);
-    DECL("rt_unbox_set",       ptr, ptr);
-    DECL("rt_set_foldl",  ptr, ptr, ptr, ptr, ptr);   /* set, init, env, fn */
-    DECL("rt_set_map",    ptr, ptr, ptr, ptr);         /* set, env, fn */
-    DECL("rt_set_filter", ptr, ptr, ptr, ptr);         /* set, env, pred */
+    DECL0("rt_set_new",        ptr),
+    DECL("rt_set_from_predicate", ptr, ptr),
+    DECL("rt_set_of",          ptr, ptr, i64),
+    DECL("rt_set_from_list",   ptr, ptr),
+    DECL("rt_set_from_array",  ptr, ptr),
+    DECL("rt_set_contains",    i32, ptr, ptr),
+    DECL("rt_set_conj",        ptr, ptr, ptr),
+    DECL("rt_set_disj",        ptr, ptr, ptr),
+    DECL("rt_set_conj_mut",    ptr, ptr, ptr),
+    DECL("rt_set_disj_mut",    ptr, ptr, ptr),
+    DECL("rt_set_get",         ptr, ptr, ptr),
+    DECL("rt_set_count",       i64, ptr),
+    DECL("rt_set_seq",         ptr, ptr),
+    DECL("rt_value_set",       ptr, ptr),
+    DECL("rt_unbox_set",       ptr, ptr),
+    DECL("rt_set_foldl",  ptr, ptr, ptr, ptr, ptr),   /* set, init, env, fn */
+    DECL("rt_set_map",    ptr, ptr, ptr, ptr),         /* set, env, fn */
+    DECL("rt_set_filter", ptr, ptr, ptr, ptr),         /* set, env, pred */
 
     // --- Map ---
-    DECL0("rt_map_new",        ptr);
-    DECL("rt_map_assoc",       ptr, ptr, ptr, ptr);
-    DECL("rt_map_assoc_mut",   ptr, ptr, ptr, ptr);
-    DECL("rt_map_dissoc",      ptr, ptr, ptr);
-    DECL("rt_map_dissoc_mut",  ptr, ptr, ptr);
-    DECL("rt_map_get",         ptr, ptr, ptr, ptr);
-    DECL("rt_map_contains",    i32, ptr, ptr);
-    DECL("rt_map_find",        ptr, ptr, ptr);
-    DECL("rt_map_count",       i64, ptr);
-    DECL("rt_map_keys",        ptr, ptr);
-    DECL("rt_map_vals",        ptr, ptr);
-    DECL("rt_map_merge",       ptr, ptr, ptr);
-    DECL("rt_value_map",       ptr, ptr);
-    DECL("rt_unbox_map",       ptr, ptr);
+    DECL0("rt_map_new",        ptr),
+    DECL("rt_map_assoc",       ptr, ptr, ptr, ptr),
+    DECL("rt_map_assoc_mut",   ptr, ptr, ptr, ptr),
+    DECL("rt_map_dissoc",      ptr, ptr, ptr),
+    DECL("rt_map_dissoc_mut",  ptr, ptr, ptr),
+    DECL("rt_map_get",         ptr, ptr, ptr, ptr),
+    DECL("rt_map_contains",    i32, ptr, ptr),
+    DECL("rt_map_find",        ptr, ptr, ptr),
+    DECL("rt_map_count",       i64, ptr),
+    DECL("rt_map_keys",        ptr, ptr),
+    DECL("rt_map_vals",        ptr, ptr),
+    DECL("rt_map_merge",       ptr, ptr, ptr),
+    DECL("rt_value_map",       ptr, ptr),
+    DECL("rt_unbox_map",       ptr, ptr),
+
+    // --- Memory ---
+    DECL("rt_alloc",               ptr, i64),
+    DECL("rt_free_sized",          void_t, ptr, i64),
+    DECL("rt_gc_init",             void_t, ptr),
+    DECL0("rt_prof_init",          void_t),
+    DECL("rt_debug_break",         void_t, i32, ptr),                 // id, site
+    DECL("rt_debug_watch",         void_t, i32, ptr, ptr, i64, i32),  // id, name, addr, size, kind
 
     // --- Print ---
-    DECL("rt_print_value",         void_t, ptr);
-    DECL("rt_print_list",          void_t, ptr);
+    DECL("rt_print_value",         void_t, ptr),
+    DECL("rt_print_list",          void_t, ptr),
 
     // --- String & Array Helpers ---
-    DECL("rt_string_concat",  ptr, ptr, ptr);
-    DECL("rt_arr_concat",     ptr, ptr, i64, ptr, i64, i64);
-    DECL("rt_coll_wrap",      ptr, ptr, ptr);
-    DECL("rt_coll_empty",     ptr, ptr);
-    DECL("rt_coll_concat",    ptr, ptr, ptr);
-    DECL("rt_coll_lazy_cons", ptr, ptr, ptr);
-    DECL("rt_coll_drop",      ptr, ptr, i64);
-    DECL("rt_coll_count",     i64, ptr);
-    DECL("rt_coll_contains",  i32, ptr, ptr);
-    DECL("rt_coll_starts_with", i32, ptr, ptr);
-    DECL("rt_coll_ends_with",   i32, ptr, ptr);
-    DECL("rt_coll_is_empty",  i32, ptr);
+    DECL("rt_string_concat",  ptr, ptr, ptr),
+    DECL("rt_arr_concat",     ptr, ptr, i64, ptr, i64, i64),
+    DECL("rt_coll_wrap",      ptr, ptr, ptr),
+    DECL("rt_coll_empty",     ptr, ptr),
+    DECL("rt_coll_concat",    ptr, ptr, ptr),
+    DECL("rt_coll_lazy_cons", ptr, ptr, ptr),
+    DECL("rt_coll_drop",      ptr, ptr, i64),
+    DECL("rt_coll_count",     i64, ptr),
+    DECL("rt_coll_contains",  i32, ptr, ptr),
+    DECL("rt_coll_starts_with", i32, ptr, ptr),
+    DECL("rt_coll_ends_with",   i32, ptr, ptr),
+    DECL("rt_coll_is_empty",  i32, ptr),
+    DECL("rt_string_take",    ptr, ptr, i64),
 
     // --- Assert ---
-    {
-        LLVMTypeRef ft = LLVMFunctionType(void_t, &ptr, 1, 0);
-        LLVMAddFunction(ctx->module, "__monad_assert_fail", ft);
-    }
+    DECL("__monad_assert_fail",    void_t, ptr),
+};
 
 #undef DECL
 #undef DECL0
+#undef void_t
+#undef ptr
+#undef i64
+#undef i32
+#undef i8
+#undef dbl
+
+#define RUNTIME_DECL_COUNT ((int)(sizeof(g_runtime_decls) / sizeof(g_runtime_decls[0])))
+_Static_assert(sizeof(g_runtime_decls) / sizeof(g_runtime_decls[0]) <= CODEGEN_RUNTIME_FN_MAX,
+               "raise CODEGEN_RUNTIME_FN_MAX in codegen.h");
+
+static LLVMTypeRef runtime_decl_type(CodegenContext *ctx, unsigned char code) {
+    switch (code) {
+    case RT_T_PTR: return LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
+    case RT_T_I64: return LLVMInt64TypeInContext(ctx->context);
+    case RT_T_I32: return LLVMInt32TypeInContext(ctx->context);
+    case RT_T_I8:  return LLVMInt8TypeInContext(ctx->context);
+    case RT_T_DBL: return LLVMDoubleTypeInContext(ctx->context);
+    default:       return LLVMVoidTypeInContext(ctx->context);
+    }
+}
+
+static int runtime_decl_index(const char *name) {
+    for (int i = 0; i < RUNTIME_DECL_COUNT; i++)
+        if (strcmp(g_runtime_decls[i].name, name) == 0) return i;
+    fprintf(stderr, "Runtime function %s not found\n", name);
+    exit(1);
 }
 
-LLVMValueRef get_rt_string_take(CodegenContext *ctx) {
-    LLVMValueRef fn = LLVMGetNamedFunction(ctx->module, "rt_string_take");
+// *slot is the getter's cached row in g_runtime_decls, -1 until first use.
+static LLVMValueRef runtime_function(CodegenContext *ctx, int *slot, const char *name) {
+    if (*slot < 0) *slot = runtime_decl_index(name);
+    if (ctx->cache_module != ctx->module) declare_runtime_functions(ctx);
+    LLVMValueRef fn = ctx->rt_fns[*slot];
+    if (fn) return fn;
+
+    const RuntimeDecl *d = &g_runtime_decls[*slot];
+    fn = LLVMGetNamedFunction(ctx->module, d->name);
     if (!fn) {
-        LLVMTypeRef ptr = LLVMPointerType(LLVMInt8TypeInContext(ctx->context), 0);
-        LLVMTypeRef i64 = LLVMInt64TypeInContext(ctx->context);
-        LLVMTypeRef args[] = {ptr, i64};
-        LLVMTypeRef ft = LLVMFunctionType(ptr, args, 2, 0);
-        fn = LLVMAddFunction(ctx->module, "rt_string_take", ft);
+        LLVMTypeRef params[7];
+        for (int i = 0; i < d->argc; i++) params[i] = runtime_decl_type(ctx, d->args[i]);
+        fn = LLVMAddFunction(ctx->module, d->name,
+                             LLVMFunctionType(runtime_decl_type(ctx, d->ret),
+                                              d->argc ? params : NULL, d->argc, 0));
     }
-    return fn;
+    return ctx->rt_fns[*slot] = fn;
+}
+
+// Callers run this on every new module.  It declares nothing; it drops
+// the declarations and format strings cached for the previous module.
+// Getters also call it when they notice ctx->module has changed.
+void declare_runtime_functions(CodegenContext *ctx) {
+    memset(ctx->fmt, 0, sizeof(ctx->fmt));
+    memset(ctx->rt_fns, 0, sizeof(ctx->rt_fns));
+    ctx->cache_module = ctx->module;
 }
 
 ///  GET_RUNTIME_FUNCTION macro + definitions
 
 #define GET_RUNTIME_FUNCTION(name) \
     LLVMValueRef get_##name(CodegenContext *ctx) { \
-        LLVMValueRef fn = LLVMGetNamedFunction(ctx->module, #name); \
-        if (!fn) { fprintf(stderr, "Runtime function " #name " not found\n"); exit(1); } \
-        return fn; \
+        static int slot = -1; \
+        return runtime_function(ctx, &slot, #name); \
     }
 
 GET_RUNTIME_FUNCTION(rt_thunk_of_value)
@@ -2823,17 +6388,22 @@ GET_RUNTIME_FUNCTION(rt_list_is_empty_list)
 GET_RUNTIME_FUNCTION(rt_is_pair)
 
 LLVMValueRef get_rt_list_is_empty(CodegenContext *ctx) {
-    LLVMValueRef fn = LLVMGetNamedFunction(ctx->module, "rt_list_is_empty_list");
-    if (!fn) { fprintf(stderr, "Runtime function rt_list_is_empty_list not found\n"); exit(1); }
-    return fn;
+    static int slot = -1;
+    return runtime_function(ctx, &slot, "rt_list_is_empty_list");
 }
 
 GET_RUNTIME_FUNCTION(rt_ast_to_runtime_value)
 
 GET_RUNTIME_FUNCTION(rt_value_closure)
 GET_RUNTIME_FUNCTION(rt_value_closure_named)
+GET_RUNTIME_FUNCTION(rt_value_closure_direct)
 GET_RUNTIME_FUNCTION(rt_closure_calln)
+GET_RUNTIME_FUNCTION(rt_closure_call1)
+GET_RUNTIME_FUNCTION(rt_closure_call2)
+GET_RUNTIME_FUNCTION(rt_closure_call3)
 GET_RUNTIME_FUNCTION(rt_closure_get_fn_ptr)
+GET_RUNTIME_FUNCTION(rt_closure_get_env)
+GET_RUNTIME_FUNCTION(rt_string_take)
 
 GET_RUNTIME_FUNCTION(rt_list_car)
 GET_RUNTIME_FUNCTION(rt_list_cdr)
@@ -2870,6 +6440,13 @@ GET_RUNTIME_FUNCTION(rt_value_list)
 GET_RUNTIME_FUNCTION(rt_value_nil)
 GET_RUNTIME_FUNCTION(rt_value_thunk)
 
+GET_RUNTIME_FUNCTION(rt_alloc)
+GET_RUNTIME_FUNCTION(rt_free_sized)
+GET_RUNTIME_FUNCTION(rt_gc_init)
+GET_RUNTIME_FUNCTION(rt_prof_init)
+GET_RUNTIME_FUNCTION(rt_debug_break)
+GET_RUNTIME_FUNCTION(rt_debug_watch)
+
 GET_RUNTIME_FUNCTION(rt_print_value)
 GET_RUNTIME_FUNCTION(rt_print_list)
 
@@ -2888,6 +6465,28 @@ GET_RUNTIME_FUNCTION(rt_array_set)
 GET_RUNTIME_FUNCTION(rt_array_get)
 GET_RUNTIME_FUNCTION(rt_array_length)
 
+GET_RUNTIME_FUNCTION(rt_arr_sum_i64)
+GET_RUNTIME_FUNCTION(rt_arr_sum_f64)
+GET_RUNTIME_FUNCTION(rt_arr_dot_i64)
+GET_RUNTIME_FUNCTION(rt_arr_dot_f64)
+GET_RUNTIME_FUNCTION(rt_arr_affine_i64)
+GET_RUNTIME_FUNCTION(rt_arr_affine_f64)
+GET_RUNTIME_FUNCTION(rt_arr_min_i64)
+GET_RUNTIME_FUNCTION(rt_arr_max_i64)
+GET_RUNTIME_FUNCTION(rt_arr_min_f64)
+GET_RUNTIME_FUNCTION(rt_arr_max_f64)
+GET_RUNTIME_FUNCTION(rt_arr_scan_i64)
+GET_RUNTIME_FUNCTION(rt_arr_scan_f64)
+GET_RUNTIME_FUNCTION(rt_par_map)
+GET_RUNTIME_FUNCTION(rt_par_filter)
+GET_RUNTIME_FUNCTION(rt_par_fold)
+GET_RUNTIME_FUNCTION(rt_fiber_spawn)
+GET_RUNTIME_FUNCTION(rt_fiber_yield)
+GET_RUNTIME_FUNCTION(rt_fiber_run)
+GET_RUNTIME_FUNCTION(rt_fiber_read)
+GET_RUNTIME_FUNCTION(rt_fiber_write)
+GET_RUNTIME_FUNCTION(rt_fiber_accept)
+
 GET_RUNTIME_FUNCTION(rt_list_map)
 GET_RUNTIME_FUNCTION(rt_list_foldl)
 GET_RUNTIME_FUNCTION(rt_list_foldr)
@@ -31,6 +31,7 @@ typedef enum {
     RT_SET,
     RT_MAP,
     RT_OPAQUE,
+    RT_VECTOR,
     RT_CLOSURE,
 } RuntimeValueType;
 
@@ -42,6 +43,9 @@ struct ConsCell;
 struct RuntimeList;
 struct RuntimeSet;
 struct RuntimeMap;
+struct RuntimeVector;
+struct HamtNode;
+struct VecNode;
 
 typedef struct RuntimeValue *(*ThunkFn)(void *env);
 
@@ -56,12 +60,22 @@ typedef struct RuntimeThunk {
 
 /// RuntimeValue
 
+//  A closure is one allocation: the RuntimeValue, this header, then the
+//  captures inline (env points at them).  name is not copied — codegen
+//  passes a string from the module's rodata.  direct, when set, is an
+//  arity-specialised entry (env, a0[, a1[, a2]]) that rt_closure_call1/2/3
+//  use instead of building an argv for fn_ptr.
+
+#define RT_CLOSURE_DIRECT_MAX 3
+
 typedef struct {
-    void  *fn_ptr;    // LLVM-compiled function pointer
-    void **env;       // heap array of captured RuntimeValue* pointers
-    int    env_size;  // number of captured variables
-    int    arity;     // number of declared (non-captured) parameters
-    char  *name;      // optional debug name, NULL if anonymous
+    void       *fn_ptr;    // LLVM-compiled function pointer, (env, n, argv) ABI
+    void       *direct;    // optional (env, a0, ...) entry for exactly arity args
+    void      **env;       // captured RuntimeValue* pointers, stored inline
+    int         env_size;  // number of captured variables
+    int         arity;     // number of declared (non-captured) parameters
+    const char *name;      // optional debug name, NULL if anonymous
+    void       *captures[];
 } RuntimeClosure;
 
 typedef struct RuntimeValue {
@@ -77,6 +91,7 @@ typedef struct RuntimeValue {
         struct RuntimeList  *list_val;
         struct RuntimeSet   *set_val;
         struct RuntimeMap   *map_val;
+        struct RuntimeVector *vector_val;
         RuntimeThunk        *thunk_val;
         RuntimeClosure      *closure_val;
         void                *opaque_val;
@@ -93,12 +108,120 @@ typedef struct RuntimeValue {
     } data;
 } RuntimeValue;
 
+/// Immediate values
+//
+//  A RuntimeValue * is a 64-bit word.  Below 2^48 it is an ordinary pointer
+//  to a heap RuntimeValue (or, under 0x10000, a raw iN that codegen passed
+//  through unboxed).  Above it, the word carries the value itself:
+//
+//    0001 0000 0000 01cc   char, byte in the low 8 bits
+//    0001 0000 0000 0200   nil
+//    0002 .... - fff2 ...  float: IEEE bits + 2^49, NaNs canonicalised
+//    fffc .... - ffff ...  int: 50-bit two's complement payload
+//
+//  rt_value_int/float/char/nil return immediates and never allocate; only
+//  ints outside +-2^49 are boxed.  Heap RT_INT, RT_FLOAT, RT_CHAR and RT_NIL
+//  values stay valid, so read the tag with rt_type_of() and the payload with
+//  rt_int_val/rt_float_val/rt_char_val — never v->type or v->data directly
+//  unless the value is known to be heap-allocated.  Relies on user-space
+//  addresses fitting in 48 bits (x86-64 and AArch64 Linux, macOS, Windows).
+
+#define RT_IMM_BASE     0x0001000000000000ULL
+#define RT_IMM_CHAR     0x0001000000000100ULL
+#define RT_IMM_NIL      0x0001000000000200ULL
+#define RT_IMM_FLOAT    0x0002000000000000ULL  // offset added to the bits
+#define RT_IMM_INT      0xfffc000000000000ULL
+#define RT_IMM_INT_BITS 50
+#define RT_IMM_INT_MAX  (((int64_t)1 << (RT_IMM_INT_BITS - 1)) - 1)
+#define RT_IMM_INT_MIN  (-((int64_t)1 << (RT_IMM_INT_BITS - 1)))
+
+static inline int rt_is_immediate(const RuntimeValue *v) {
+    return (uint64_t)(uintptr_t)v >= RT_IMM_BASE;
+}
+
+static inline RuntimeValueType rt_type_of(const RuntimeValue *v) {
+    uint64_t w = (uint64_t)(uintptr_t)v;
+    if (w < RT_IMM_BASE)   return v->type;
+    if (w >= RT_IMM_INT)   return RT_INT;
+    if (w >= RT_IMM_FLOAT) return RT_FLOAT;
+    return w == RT_IMM_NIL ? RT_NIL : RT_CHAR;
+}
+
+// Payload of a value whose rt_type_of() is RT_INT.
+static inline int64_t rt_int_val(const RuntimeValue *v) {
+    uint64_t w = (uint64_t)(uintptr_t)v;
+    if (w < RT_IMM_BASE) return v->data.int_val;
+    return (int64_t)(w << (64 - RT_IMM_INT_BITS)) >> (64 - RT_IMM_INT_BITS);
+}
+
+// Payload of a value whose rt_type_of() is RT_FLOAT.
+static inline double rt_float_val(const RuntimeValue *v) {
+    uint64_t w = (uint64_t)(uintptr_t)v;
+    if (w < RT_IMM_BASE) return v->data.float_val;
+    uint64_t bits = w - RT_IMM_FLOAT;
+    double   d;
+    __builtin_memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// Payload of a value whose rt_type_of() is RT_CHAR.
+static inline char rt_char_val(const RuntimeValue *v) {
+    uint64_t w = (uint64_t)(uintptr_t)v;
+    if (w < RT_IMM_BASE) return v->data.char_val;
+    return (char)(unsigned char)(w & 0xff);
+}
+
+/// RuntimeString
+//
+//  Header in front of the chars of every RT_STRING, RT_SYMBOL and RT_KEYWORD
+//  payload.  data.string_val still points at NUL-terminated chars, so it can
+//  go to C unchanged, but the length and hash are cached in the header.
+//  Symbols and keywords are interned — one value per name — and compare by
+//  pointer.  Concatenations reaching RT_STRING_ROPE_MIN bytes build a rope
+//  node instead of copying, so repeated appends stay linear; the chars are
+//  flattened the first time they are needed.  Use rt_string_chars() for a
+//  string's chars, not data.string_val directly.
+
+#define RT_STRING_ROPE_MIN 64
+
+enum {
+    RT_STR_INTERNED = 1,    // symbol/keyword owned by the intern table
+    RT_STR_ROPE     = 2,    // chars not materialised yet
+};
+
+typedef struct RuntimeString {
+    size_t   length;        // bytes, excluding the NUL
+    uint64_t hash;          // 0 until first hashed
+    uint32_t flags;
+    uint32_t reserved;
+    char     chars[];
+} RuntimeString;
+
+static inline RuntimeString *rt_string_header(const char *chars) {
+    return (RuntimeString *)(void *)(chars - sizeof(RuntimeString));
+}
+
 
 /// Closure
 
+// Header and closure share one block; the closure starts pointer-aligned.
+#define RT_CLOSURE_OFFSET ((sizeof(RuntimeValue) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define RT_CLOSURE_BLOCK_SIZE(env_size) \
+    (RT_CLOSURE_OFFSET + sizeof(RuntimeClosure) + sizeof(void *) * (size_t)(env_size))
+
+// Builds a closure in caller-owned storage of RT_CLOSURE_BLOCK_SIZE(env_size)
+// bytes.  Compiled code uses it for closures that never outlive the frame
+// that creates them, with an alloca as the block (see codegen_demote_allocations).
+RuntimeValue *rt_value_closure_init(void *mem, void *fn_ptr, void *direct, void **env,
+                                    int env_size, int arity, const char *name);
+
 RuntimeValue *rt_value_closure(void *fn_ptr, void **env, int env_size, int arity);
 RuntimeValue *rt_value_closure_named(void *fn_ptr, void **env, int env_size, int arity, const char *name);
+RuntimeValue *rt_value_closure_direct(void *fn_ptr, void *direct, void **env, int env_size, int arity, const char *name);
 RuntimeValue *rt_closure_calln(RuntimeValue *closure, int n, RuntimeValue **args);
+RuntimeValue *rt_closure_call1(RuntimeValue *closure, RuntimeValue *a);
+RuntimeValue *rt_closure_call2(RuntimeValue *closure, RuntimeValue *a, RuntimeValue *b);
+RuntimeValue *rt_closure_call3(RuntimeValue *closure, RuntimeValue *a, RuntimeValue *b, RuntimeValue *c);
 void         *rt_closure_get_env(RuntimeValue *closure);
 void         *rt_closure_get_fn_ptr(RuntimeValue *closure);
 
@@ -131,31 +254,73 @@ typedef struct ConsCell {
 
 /// RuntimeList
 //
-//  Thin wrapper around ConsCell*.  NULL cell == empty list.
+//  Thin wrapper around ConsCell*.  NULL cell == empty list.  A cell with the
+//  low bit set points at a ListChunk instead (see below).
 
 typedef struct RuntimeList {
     ConsCell *cell;
 } RuntimeList;
 
 
+/// ListChunk
+//
+//  Strict lists (ranges, make-list, builders, and map/filter_total over
+//  strict input) store up to RT_LIST_CHUNK forced values per node instead of
+//  one ConsCell each.  Every slot starts with a RuntimeList whose cell is the
+//  owning chunk tagged with bit 0, so a pointer to slot i *is* the list from
+//  element i: car reads the slot and cdr inside a chunk is &slots[i + 1],
+//  with no allocation.  A free-standing RuntimeList tagged this way means
+//  slot 0.
+//  After the last slot the list continues at `next` (any list, cells or
+//  chunks), or at next_fn(next_env) the first time it is needed.
+
+#define RT_LIST_CHUNK 32
+
+typedef struct ListSlot {
+    RuntimeList   link;
+    RuntimeValue *value;
+} ListSlot;
+
+typedef struct ListChunk {
+    uint32_t             count;      // slots in use, always >= 1
+    uint32_t             capacity;
+    RuntimeList         *next;       // rest of the list, NULL = end
+    RuntimeList       *(*next_fn)(void *env);   // lazy rest, NULL once forced
+    void                *next_env;
+    ListSlot             slots[];
+} ListChunk;
+
+
 /// RuntimeSet
 //
-//  Heap-allocated hash set using open addressing with linear probing.
-//  Tombstones mark deleted slots so probe chains remain intact after disj.
-//  Capacity is always a power of two.  Load factor threshold: 0.7.
+//  Heap-allocated hash set: open addressing over groups of slots, one
+//  control byte per slot holding 7 hash bits, so a probe checks a whole
+//  group with one vector compare.  hashes caches each slot's full hash;
+//  tombstones counts slots marked deleted.  Capacity is always a power of
+//  two and a multiple of the group width.  Load factor threshold: 7/8.
+//
+//  Persistent updates on sets larger than a handful of elements switch to a
+//  hash array mapped trie shared between versions: buckets is then NULL and
+//  root holds the trie.  _mut operations always work on the table.
 
 typedef struct RuntimeSet {
-    RuntimeValue **buckets;
-    size_t         capacity;
-    size_t         count;
-    size_t         tombstones;
-    RuntimeValue  *membership_predicate;
+    RuntimeValue    **buckets;
+    uint8_t          *ctrl;      // control byte per slot, after hashes
+    uint64_t         *hashes;    // rt_hash_value per slot
+    size_t            capacity;
+    size_t            count;
+    size_t            tombstones;
+    RuntimeValue     *membership_predicate;
+    struct HamtNode  *root;      // trie when buckets == NULL
 } RuntimeSet;
 
 
-/// RuntimeSet
+/// RuntimeMap
 //
-// TODO Write description
+//  Hash map with the same two representations as RuntimeSet: a
+//  group-probed table of key/value entries for small maps and in-place
+//  (_mut) updates, and a persistent trie (buckets == NULL) that assoc and
+//  dissoc path-copy so older versions stay valid without a full copy.
 
 typedef struct RuntimeMapEntry {
     RuntimeValue *key;
@@ -164,17 +329,46 @@ typedef struct RuntimeMapEntry {
 
 typedef struct RuntimeMap {
     RuntimeMapEntry *buckets;
+    uint8_t         *ctrl;       // control byte per slot, after hashes
+    uint64_t        *hashes;     // rt_hash_value per slot
     size_t           capacity;
     size_t           count;
     size_t           tombstones;
+    struct HamtNode *root;       // trie when buckets == NULL
 } RuntimeMap;
 
 
+/// RuntimeVector
+//
+//  Persistent vector: a relaxed radix balanced (RRB) tree of
+//  RT_VECTOR_WIDTH-way nodes.  nth and assoc touch one node per level
+//  (O(log32 n)); concat and slice rebuild only the nodes along the seam or
+//  the cut (O(log n)), so older versions stay valid without a full copy.
+//  rt_vector_transient and rt_vector_persistent bracket a batch of _mut
+//  updates that modify nodes created by the batch in place.
+
+#define RT_VECTOR_WIDTH 32
+
+typedef struct RuntimeVector {
+    size_t          count;
+    uint32_t        shift;       // levels above the leaves * 5
+    uint32_t        reserved;
+    uint64_t        edit;        // owning batch while transient, else 0
+    struct VecNode *root;        // NULL when empty
+} RuntimeVector;
+
+
 /// Thunks
+//
+//  Forcing updates a thunk in place and drops its fn/env.  Re-entering a
+//  thunk that is still being evaluated raises <<loop>> through
+//  __monad_runtime_error.  Code that longjmps out of an evaluation must
+//  call rt_thunk_unwind() before forcing anything again.
 
 RuntimeThunk *rt_thunk_of_value(RuntimeValue *val);
 RuntimeThunk *rt_thunk_create(ThunkFn fn, void *env);
 RuntimeValue *rt_force(RuntimeThunk *thunk);
+void          rt_thunk_unwind(void);
 
 
 /// List
@@ -206,6 +400,11 @@ RuntimeList  *rt_list_map(RuntimeList *list, void *env, RT_UnaryFn fn);
 RuntimeValue *rt_list_foldl(RuntimeList *list, RuntimeValue *init, void *env, RT_BinaryFn fn);
 RuntimeValue *rt_list_foldr(RuntimeList *list, RuntimeValue *init, void *env, RT_BinaryFn fn);
 RuntimeList  *rt_list_filter(RuntimeList *list, void *env, RT_UnaryFn pred);
+// As rt_list_map / rt_list_filter, for a fn that always terminates without
+// errors or effects: over a chunked list they may apply it to the rest of
+// the current chunk before those elements are demanded.
+RuntimeList  *rt_list_map_total(RuntimeList *list, void *env, RT_UnaryFn fn);
+RuntimeList  *rt_list_filter_total(RuntimeList *list, void *env, RT_UnaryFn pred);
 RuntimeList  *rt_list_zipwith(RuntimeList *a, RuntimeList *b, void *env, RT_BinaryFn fn);
 
 
@@ -254,6 +453,26 @@ int           rt_map_equal(RuntimeMap *a, RuntimeMap *b);
 void          rt_map_free(RuntimeMap *m);
 
 
+/// Vector
+
+RuntimeVector *rt_vector_new(void);
+RuntimeVector *rt_vector_of(RuntimeValue **vals, size_t n);
+RuntimeVector *rt_vector_from_list(RuntimeList *list);
+RuntimeVector *rt_vector_from_array(RuntimeValue *array_rv);
+int64_t        rt_vector_count(RuntimeVector *v);
+RuntimeValue  *rt_vector_nth(RuntimeVector *v, int64_t index);
+RuntimeVector *rt_vector_assoc(RuntimeVector *v, int64_t index, RuntimeValue *val);
+RuntimeVector *rt_vector_conj(RuntimeVector *v, RuntimeValue *val);
+RuntimeVector *rt_vector_concat(RuntimeVector *a, RuntimeVector *b);
+RuntimeVector *rt_vector_slice(RuntimeVector *v, int64_t start, int64_t end);
+RuntimeVector *rt_vector_transient(RuntimeVector *v);
+RuntimeVector *rt_vector_assoc_mut(RuntimeVector *v, int64_t index, RuntimeValue *val);
+RuntimeVector *rt_vector_conj_mut(RuntimeVector *v, RuntimeValue *val);
+RuntimeVector *rt_vector_persistent(RuntimeVector *v);
+RuntimeList   *rt_vector_seq(RuntimeVector *v);
+int            rt_vector_equal(RuntimeVector *a, RuntimeVector *b);
+
+
 
 /// Equality
 
@@ -269,6 +488,7 @@ RuntimeValue *rt_value_int(int64_t val);
 RuntimeValue *rt_value_float(double val);
 RuntimeValue *rt_value_char(char val);
 RuntimeValue *rt_value_string(const char *val);
+RuntimeValue *rt_value_string_n(const char *val, size_t length);
 RuntimeValue *rt_value_symbol(const char *val);
 RuntimeValue *rt_value_keyword(const char *val);
 RuntimeValue *rt_value_list(RuntimeList *val);
@@ -278,6 +498,7 @@ RuntimeValue *rt_value_ratio(int64_t numerator, int64_t denominator);
 RuntimeValue *rt_value_array(size_t length);
 RuntimeValue *rt_value_set(RuntimeSet *s);
 RuntimeValue *rt_value_map(RuntimeMap *m);
+RuntimeValue *rt_value_vector(RuntimeVector *v);
 RuntimeValue *rt_value_opaque(void *p);
 
 
@@ -287,9 +508,12 @@ int64_t      rt_unbox_int(RuntimeValue *v);
 double       rt_unbox_float(RuntimeValue *v);
 char         rt_unbox_char(RuntimeValue *v);
 char        *rt_unbox_string(RuntimeValue *v);
+char        *rt_string_chars(RuntimeValue *v);     // RT_STRING/SYMBOL/KEYWORD
+size_t       rt_string_length(RuntimeValue *v);
 RuntimeList *rt_unbox_list(RuntimeValue *v);
 RuntimeSet  *rt_unbox_set(RuntimeValue *v);
 RuntimeMap  *rt_unbox_map(RuntimeValue *v);
+RuntimeVector *rt_unbox_vector(RuntimeValue *v);
 int          rt_value_is_nil(RuntimeValue *v);
 
 
@@ -300,6 +524,62 @@ RuntimeValue *rt_array_get(RuntimeValue *array, size_t index);
 int64_t       rt_array_length(RuntimeValue *array);
 
 
+/// Unboxed array kernels
+//
+//  Over the int64_t / double storage of an Arr :: Int / Arr :: Float.
+//  Output arrays hold n elements and may be the input itself.
+
+int64_t rt_arr_sum_i64(const int64_t *xs, int64_t n);
+double  rt_arr_sum_f64(const double *xs, int64_t n);
+int64_t rt_arr_dot_i64(const int64_t *a, const int64_t *b, int64_t n);
+double  rt_arr_dot_f64(const double *a, const double *b, int64_t n);
+void    rt_arr_affine_i64(int64_t *dst, const int64_t *xs, int64_t n,
+                          int64_t scale, int64_t offset);      // xs * scale + offset
+void    rt_arr_affine_f64(double *dst, const double *xs, int64_t n,
+                          double scale, double offset);
+void    rt_arr_min_i64(int64_t *dst, const int64_t *a, const int64_t *b, int64_t n);
+void    rt_arr_max_i64(int64_t *dst, const int64_t *a, const int64_t *b, int64_t n);
+void    rt_arr_min_f64(double *dst, const double *a, const double *b, int64_t n);
+void    rt_arr_max_f64(double *dst, const double *a, const double *b, int64_t n);
+void    rt_arr_scan_i64(int64_t *dst, const int64_t *xs, int64_t n);  // inclusive
+void    rt_arr_scan_f64(double *dst, const double *xs, int64_t n);
+
+
+/// Work-stealing pool
+//
+//  rt_pool_for runs body over [0, n) in ranges of at most grain indices,
+//  spread over the pool, and returns when all have run.  MONAD_THREADS
+//  sets the pool size; rt_pool_size() starts the pool if needed.
+
+typedef void (*RtPoolBody)(void *ctx, int64_t lo, int64_t hi);
+
+int  rt_pool_size(void);
+void rt_pool_for(int64_t n, int64_t grain, RtPoolBody body, void *ctx);
+
+
+/// Parallel collection operations
+//
+//  fn must be pure; pfold's fn must also be associative.
+
+RuntimeValue *rt_par_map(RuntimeValue *fn, RuntimeValue *coll);
+RuntimeValue *rt_par_filter(RuntimeValue *pred, RuntimeValue *coll);
+RuntimeValue *rt_par_fold(RuntimeValue *fn, RuntimeValue *init, RuntimeValue *coll);
+
+
+/// Fiber scheduler
+//
+//  Spawned fibers run fn applied to their id once rt_fiber_run drives the
+//  queue.  The I/O calls return the count or fd, or -errno, like the raw
+//  syscalls they replace; inside a fiber they park instead of blocking.
+
+int64_t       rt_fiber_spawn(RuntimeValue *fn);
+RuntimeValue *rt_fiber_yield(RuntimeValue *value);
+int64_t       rt_fiber_run(RuntimeValue *fn);
+int64_t       rt_fiber_read(int64_t fd, void *buf, int64_t len);
+int64_t       rt_fiber_write(int64_t fd, const void *buf, int64_t len);
+int64_t       rt_fiber_accept(int64_t fd);
+
+
 /// Ratio
 
 RuntimeValue *rt_ratio_from_int(int64_t n);
@@ -322,6 +602,15 @@ RuntimeValue *rt_bignum_sub(RuntimeValue *a, RuntimeValue *b);
 RuntimeValue *rt_bignum_mul(RuntimeValue *a, RuntimeValue *b);
 RuntimeValue *rt_bignum_div(RuntimeValue *a, RuntimeValue *b);
 
+// In-place accumulation for folds over RT_INT/RT_BIGNUM values.
+typedef struct RuntimeBignumAcc RuntimeBignumAcc;
+RuntimeBignumAcc *rt_bignum_acc_new(RuntimeValue *init);
+void              rt_bignum_acc_add(RuntimeBignumAcc *acc, RuntimeValue *x);
+void              rt_bignum_acc_mul(RuntimeBignumAcc *acc, RuntimeValue *x);
+RuntimeValue     *rt_bignum_acc_finish(RuntimeBignumAcc *acc);
+RuntimeValue     *rt_bignum_sum_list(RuntimeList *xs);
+RuntimeValue     *rt_bignum_product_list(RuntimeList *xs);
+
 
 /// Printing
 
@@ -339,6 +628,96 @@ void rt_list_free(RuntimeList *list);
 void rt_thunk_free(RuntimeThunk *thunk);
 void rt_set_free(RuntimeSet *s);
 
+/// Allocation
+//
+//  Fixed-size runtime objects come from thread-local size-classed pools
+//  (8-byte classes up to 8 * RT_ALLOC_CLASS_COUNT bytes); anything larger
+//  falls back to malloc.  rt_free_sized must be given the size that was
+//  passed to rt_alloc.  Counters are per thread.
+
+#define RT_ALLOC_CLASS_COUNT 8
+
+typedef struct {
+    size_t allocs;          // total rt_alloc calls served
+    size_t releases;        // total rt_free_sized calls
+    size_t reused;          // allocations satisfied from a free list
+    size_t large;           // requests above the largest class (malloc'd)
+    size_t reserved_bytes;  // pool block capacity
+    size_t used_bytes;      // pool bytes carved from blocks
+    size_t class_allocs[RT_ALLOC_CLASS_COUNT];
+    int    malloc_mode;     // MONAD_ALLOC=malloc baseline active
+} RuntimeAllocStats;
+
+void *rt_alloc(size_t size);
+void  rt_free_sized(void *p, size_t size);
+void  rt_alloc_stats(RuntimeAllocStats *out);
+void  rt_alloc_print_stats(const char *label);
+
+/// Garbage collection
+//
+//  Opt-in (MONAD_GC=1) conservative mark-sweep collector over the rt_alloc
+//  heap.  rt_gc_init must be called once, from main, with an address at or
+//  above every stack frame that can hold heap pointers; it does nothing
+//  unless MONAD_GC is set.  Collections then run automatically from
+//  rt_alloc; rt_gc_collect forces one.
+
+typedef struct {
+    size_t collections;
+    size_t freed_objects;
+    size_t freed_bytes;
+    size_t live_bytes;      // surviving bytes after the last collection
+    size_t heap_bytes;      // pool capacity plus large objects
+    size_t large_bytes;     // tracked large objects
+    double total_pause_ms;
+    double max_pause_ms;
+    int    enabled;
+} RuntimeGCStats;
+
+void rt_gc_init(void *stack_base);
+int  rt_gc_enabled(void);
+void rt_gc_collect(void);
+void rt_gc_stats(RuntimeGCStats *out);
+void rt_gc_print_stats(const char *label);
+
+/// Profiling
+//
+//  MONAD_PROF=cpu|alloc|perf (see runtime_prof.c).  rt_prof_init is called
+//  once from main, next to rt_gc_init, and does nothing unless MONAD_PROF
+//  is set.  Code built with --profile-sites stores a pointer to a constant
+//  RtProfSite in __monad_prof_site before each runtime call, which is how
+//  allocations are attributed to source spans.
+
+typedef struct {
+    const char *file;
+    const char *fn;     // enclosing define, NULL at top level
+    int32_t     line;
+    int32_t     col;
+} RtProfSite;
+
+extern int g_rt_prof_active;  // set while MONAD_PROF=cpu or alloc runs
+extern int g_rt_prof_alloc;   // set while the allocation profiler runs
+
+void rt_prof_init(void);
+void rt_prof_note_alloc(size_t size);
+void rt_prof_note_closure(void *fn_ptr, void *direct, const char *name);
+int  rt_prof_perf_map_enabled(void);
+void rt_prof_jit_symbol(uintptr_t addr, size_t size, const char *name);
+
+/// Breakpoints and watchpoints
+//
+//  Code built with --break calls rt_debug_break(id, site) when a
+//  breakpoint's condition holds; code built with --watch calls
+//  rt_debug_watch once a watched top-level variable is defined.  ids are
+//  0-based and below RT_DEBUG_MAX_POINTS.  MONAD_BREAK=log|trap|count
+//  picks what a hit does (see runtime_debug.c).
+
+#define RT_DEBUG_MAX_POINTS 64
+
+enum { RT_WATCH_INT, RT_WATCH_FLOAT, RT_WATCH_PTR };
+
+void rt_debug_break(int32_t id, const RtProfSite *site);
+void rt_debug_watch(int32_t id, const char *name, void *addr, int64_t size, int32_t kind);
+
 /// Layout pointer registry
 void  __layout_ptr_set(const char *name, void *ptr);
 void *__layout_ptr_get(const char *name);
@@ -355,6 +734,7 @@ void __monad_runtime_error(const char *file, long line, long col, const char *ms
 RuntimeValue *rt_ast_to_runtime_value(AST *ast);
 char         *rt_string_take(const char *s, int64_t n);
 char         *rt_string_concat(const char *a, const char *b);
+RuntimeValue *rt_string_append(RuntimeValue *a, RuntimeValue *b);
 void         *rt_arr_concat(void *d1, int64_t l1, void *d2, int64_t l2, int64_t elem_size);
 RuntimeValue *rt_coll_wrap(RuntimeValue *coll, RuntimeValue *item);
 RuntimeValue *rt_coll_empty(RuntimeValue *coll);
@@ -386,8 +766,13 @@ LLVMValueRef get___monad_runtime_error(CodegenContext *ctx);
 
 LLVMValueRef get_rt_value_closure(CodegenContext *ctx);
 LLVMValueRef get_rt_value_closure_named(CodegenContext *ctx);
+LLVMValueRef get_rt_value_closure_direct(CodegenContext *ctx);
 LLVMValueRef get_rt_closure_calln(CodegenContext *ctx);
+LLVMValueRef get_rt_closure_call1(CodegenContext *ctx);
+LLVMValueRef get_rt_closure_call2(CodegenContext *ctx);
+LLVMValueRef get_rt_closure_call3(CodegenContext *ctx);
 LLVMValueRef get_rt_closure_get_fn_ptr(CodegenContext *ctx);
+LLVMValueRef get_rt_closure_get_env(CodegenContext *ctx);
 
 //// Thunks
 
@@ -497,6 +882,27 @@ LLVMValueRef get_rt_value_opaque(CodegenContext *ctx);
 LLVMValueRef get_rt_array_set(CodegenContext *ctx);
 LLVMValueRef get_rt_array_get(CodegenContext *ctx);
 LLVMValueRef get_rt_array_length(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_sum_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_sum_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_dot_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_dot_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_affine_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_affine_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_min_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_max_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_min_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_max_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_scan_i64(CodegenContext *ctx);
+LLVMValueRef get_rt_arr_scan_f64(CodegenContext *ctx);
+LLVMValueRef get_rt_par_map(CodegenContext *ctx);
+LLVMValueRef get_rt_par_filter(CodegenContext *ctx);
+LLVMValueRef get_rt_par_fold(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_spawn(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_yield(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_run(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_read(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_write(CodegenContext *ctx);
+LLVMValueRef get_rt_fiber_accept(CodegenContext *ctx);
 
 //// Ratio
 
@@ -508,6 +914,15 @@ LLVMValueRef get_rt_ratio_div(CodegenContext *ctx);
 LLVMValueRef get_rt_ratio_to_int(CodegenContext *ctx);
 LLVMValueRef get_rt_ratio_to_float(CodegenContext *ctx);
 
+//// Memory
+
+LLVMValueRef get_rt_alloc(CodegenContext *ctx);
+LLVMValueRef get_rt_free_sized(CodegenContext *ctx);
+LLVMValueRef get_rt_gc_init(CodegenContext *ctx);
+LLVMValueRef get_rt_prof_init(CodegenContext *ctx);
+LLVMValueRef get_rt_debug_break(CodegenContext *ctx);
+LLVMValueRef get_rt_debug_watch(CodegenContext *ctx);
+
 //// Print
 
 LLVMValueRef get_rt_print_value(CodegenContext *ctx);
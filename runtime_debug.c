@@ -0,0 +1,369 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "runtime.h"
+
+///  Compiled breakpoints and watchpoints (--break, --watch)
+//
+//  A program built with --break FILE:LINE[ if COND] evaluates COND inline,
+//  in the scope of the first form on that line, and calls rt_debug_break
+//  only when it holds.  A conditional breakpoint in a hot loop therefore
+//  costs a compare and a not-taken branch per iteration; nothing leaves
+//  the process until the condition is true.
+//
+//  --watch NAME arms a hardware watchpoint on the top-level variable NAME
+//  once its definition has run: perf_event_open(PERF_TYPE_BREAKPOINT) on
+//  the variable's address, reported through a signal on the thread that
+//  defined it (the main thread).  Threads started after that inherit the
+//  watchpoint on Linux 5.13 and later; threads already running when it is
+//  armed are not watched.  Loads and unrelated stores run at full speed;
+//  only a store to the variable traps.  Linux only.
+//
+//  MONAD_BREAK chooses what a hit does:
+//
+//    log    (default) one line on stderr per hit; if a debugger is
+//           attached, also raise SIGTRAP so it stops there
+//    trap   raise SIGTRAP on every hit
+//    count  stay quiet and print hit counts at exit
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/hw_breakpoint.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#define RT_DEBUG_HW_WATCH 1
+#endif
+
+enum { BREAK_LOG, BREAK_TRAP, BREAK_COUNT };
+
+typedef struct {
+    const RtProfSite *site;
+    uint64_t          hits;
+} BreakSlot;
+
+typedef struct {
+    const char   *name;
+    void         *addr;
+    int64_t       size;
+    int32_t       kind;       // RT_WATCH_INT, RT_WATCH_FLOAT, RT_WATCH_PTR
+    int           fd;
+    uint64_t      writes;
+    unsigned char last[8];
+} WatchSlot;
+
+static BreakSlot g_breaks[RT_DEBUG_MAX_POINTS];
+static WatchSlot g_watches[RT_DEBUG_MAX_POINTS];
+static int       g_break_mode = -1;
+
+static void debug_report_at_exit(void);
+
+static int debug_mode(void) {
+    if (g_break_mode >= 0) return g_break_mode;
+    const char *mode = getenv("MONAD_BREAK");
+    if (mode && strcmp(mode, "trap") == 0)       g_break_mode = BREAK_TRAP;
+    else if (mode && strcmp(mode, "count") == 0) g_break_mode = BREAK_COUNT;
+    else {
+        if (mode && *mode && strcmp(mode, "log") != 0)
+            fprintf(stderr, "[break] unknown MONAD_BREAK=%s, using log\n", mode);
+        g_break_mode = BREAK_LOG;
+    }
+    if (g_break_mode == BREAK_COUNT)
+        atexit(debug_report_at_exit);
+    return g_break_mode;
+}
+
+// Only true hits get here, so reading /proc per hit is fine.  The watch
+// signal handler calls this too, so it sticks to open/read.
+static int debugger_attached(void) {
+#if defined(_WIN32)
+    return IsDebuggerPresent();
+#elif defined(__linux__)
+    int fd = open("/proc/self/status", O_RDONLY);
+    if (fd < 0) return 0;
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    const char *p = strstr(buf, "TracerPid:");
+    if (!p) return 0;
+    for (p += 10; *p == ' ' || *p == '\t'; p++) {}
+    return *p >= '1' && *p <= '9';
+#else
+    return 0;
+#endif
+}
+
+static void debug_stop(void) {
+#if defined(_WIN32)
+    DebugBreak();
+#else
+    raise(SIGTRAP);
+#endif
+}
+
+static void debug_write(const char *text, size_t len) {
+#if defined(_WIN32)
+    fwrite(text, 1, len, stderr);
+#else
+    ssize_t n = write(STDERR_FILENO, text, len);
+    (void)n;
+#endif
+}
+
+/// Breakpoints
+
+void rt_debug_break(int32_t id, const RtProfSite *site) {
+    if (id < 0 || id >= RT_DEBUG_MAX_POINTS) return;
+    BreakSlot *slot = &g_breaks[id];
+    slot->site = site;
+    uint64_t hits = __atomic_add_fetch(&slot->hits, 1, __ATOMIC_RELAXED);
+
+    int mode = debug_mode();
+    if (mode == BREAK_COUNT) return;
+    if (mode == BREAK_LOG) {
+        char line[512];
+        int n = snprintf(line, sizeof(line), "[break %d] %s:%d:%d%s%s (hit %llu)\n",
+                         id + 1, site ? site->file : "?", site ? site->line : 0,
+                         site ? site->col : 0,
+                         site && site->fn ? " in " : "", site && site->fn ? site->fn : "",
+                         (unsigned long long)hits);
+        if (n > 0) debug_write(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+        if (!debugger_attached()) return;
+    }
+    debug_stop();
+}
+
+/// Watchpoints
+
+// The watch report is built inside a signal handler, where snprintf is not
+// safe, so these writers format into a caller's stack buffer by hand.
+// Floats print as exact hexadecimal (the %a form): decimal shortest-round-
+// trip output needs more machinery than a handler should carry.
+
+typedef struct {
+    char *p, *end;
+} SigBuf;
+
+static void sig_put(SigBuf *b, const char *s) {
+    while (*s && b->p < b->end) *b->p++ = *s++;
+}
+
+static void sig_put_digits(SigBuf *b, uint64_t v, unsigned base, int min_digits) {
+    char tmp[24];
+    int  n = 0;
+    do {
+        tmp[n++] = "0123456789abcdef"[v % base];
+        v /= base;
+    } while (v || n < min_digits);
+    while (n > 0 && b->p < b->end) *b->p++ = tmp[--n];
+}
+
+static void sig_put_int(SigBuf *b, int64_t v) {
+    if (v < 0) {
+        sig_put(b, "-");
+        sig_put_digits(b, 0 - (uint64_t)v, 10, 1);
+    } else {
+        sig_put_digits(b, (uint64_t)v, 10, 1);
+    }
+}
+
+static void sig_put_hexfloat(SigBuf *b, double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, 8);
+    if (bits >> 63) sig_put(b, "-");
+    int      exp  = (int)((bits >> 52) & 0x7ff);
+    uint64_t frac = bits & ((1ULL << 52) - 1);
+    if (exp == 0x7ff) { sig_put(b, frac ? "nan" : "inf"); return; }
+    if (exp == 0 && frac == 0) { sig_put(b, "0x0p+0"); return; }
+    sig_put(b, exp ? "0x1" : "0x0");
+    if (frac) {
+        int digits = 13;
+        while ((frac & 0xf) == 0) { frac >>= 4; digits--; }
+        sig_put(b, ".");
+        sig_put_digits(b, frac, 16, digits);
+    }
+    int e = exp ? exp - 1023 : -1022;
+    sig_put(b, e < 0 ? "p" : "p+");
+    sig_put_int(b, e);
+}
+
+static void watch_format(SigBuf *b, const WatchSlot *w, const unsigned char *bytes) {
+    if (w->kind == RT_WATCH_FLOAT && w->size == 8) {
+        double d; memcpy(&d, bytes, 8);
+        sig_put_hexfloat(b, d);
+        return;
+    }
+    if (w->kind == RT_WATCH_FLOAT && w->size == 4) {
+        float f; memcpy(&f, bytes, 4);
+        sig_put_hexfloat(b, (double)f);
+        return;
+    }
+    uint64_t v = 0;
+    memcpy(&v, bytes, (size_t)w->size);
+    if (w->kind == RT_WATCH_PTR) {
+        sig_put(b, "0x");
+        sig_put_digits(b, v, 16, 1);
+        return;
+    }
+    if (w->size < 8 && (v >> (w->size * 8 - 1)) & 1)
+        v |= ~0ULL << (w->size * 8);                  /* sign-extend */
+    sig_put_int(b, (int64_t)v);
+}
+
+#if defined(RT_DEBUG_HW_WATCH)
+
+#define RT_WATCH_SIGNAL (SIGRTMIN + 4)
+
+static void watch_signal(int sig, siginfo_t *info, void *uctx) {
+    (void)sig; (void)uctx;
+    WatchSlot *w = NULL;
+    for (int i = 0; i < RT_DEBUG_MAX_POINTS; i++)
+        if (g_watches[i].addr && g_watches[i].fd == info->si_fd) { w = &g_watches[i]; break; }
+    if (!w) return;
+
+    unsigned char now[8] = {0};
+    memcpy(now, w->addr, (size_t)w->size);
+    w->writes++;
+
+    int mode = debug_mode();
+    if (mode != BREAK_COUNT && memcmp(now, w->last, (size_t)w->size) != 0) {
+        char    line[256];
+        SigBuf  b = { line, line + sizeof(line) - 1 };
+        sig_put(&b, "[watch] ");
+        sig_put(&b, w->name);
+        sig_put(&b, ": ");
+        watch_format(&b, w, w->last);
+        sig_put(&b, " -> ");
+        watch_format(&b, w, now);
+        sig_put(&b, " (write ");
+        sig_put_digits(&b, w->writes, 10, 1);
+        sig_put(&b, ")");
+        *b.p++ = '\n';
+        debug_write(line, (size_t)(b.p - line));
+    }
+    memcpy(w->last, now, (size_t)w->size);
+
+    if (mode == BREAK_TRAP || (mode == BREAK_LOG && debugger_attached()))
+        debug_stop();
+}
+
+static int watch_arm(WatchSlot *w) {
+    static int handler_installed;
+    if (!handler_installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = watch_signal;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(RT_WATCH_SIGNAL, &sa, NULL) != 0) return -1;
+        handler_installed = 1;
+    }
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_BREAKPOINT;
+    attr.size = sizeof(attr);
+    attr.bp_type = HW_BREAKPOINT_W;
+    attr.bp_addr = (uintptr_t)w->addr;
+    attr.bp_len = w->size == 1 ? HW_BREAKPOINT_LEN_1 :
+                  w->size == 2 ? HW_BREAKPOINT_LEN_2 :
+                  w->size == 4 ? HW_BREAKPOINT_LEN_4 : HW_BREAKPOINT_LEN_8;
+    attr.sample_period = 1;
+    attr.wakeup_events = 1;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+#if defined(PERF_ATTR_SIZE_VER7)
+    // Threads spawned after arming (pool workers, fibers' threads) inherit
+    // the watchpoint; their hits still signal the arming thread.  Forked
+    // and exec'd children do not.  Kernels before 5.13 reject these bits,
+    // and there the watchpoint covers only the arming thread.
+    attr.inherit = 1;
+    attr.inherit_thread = 1;
+    attr.remove_on_exec = 1;
+#endif
+
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#if defined(PERF_ATTR_SIZE_VER7)
+    if (fd < 0 && errno == EINVAL) {
+        attr.inherit = attr.inherit_thread = attr.remove_on_exec = 0;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+    if (fd < 0) return -1;
+
+    struct f_owner_ex owner = { F_OWNER_TID, (pid_t)syscall(SYS_gettid) };
+    if (fcntl(fd, F_SETFL, O_ASYNC) != 0 ||
+        fcntl(fd, F_SETSIG, RT_WATCH_SIGNAL) != 0 ||
+        fcntl(fd, F_SETOWN_EX, &owner) != 0 ||
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0) != 0 ||
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    w->fd = fd;
+    return 0;
+}
+
+#endif // RT_DEBUG_HW_WATCH
+
+void rt_debug_watch(int32_t id, const char *name, void *addr, int64_t size, int32_t kind) {
+    if (id < 0 || id >= RT_DEBUG_MAX_POINTS || !addr) return;
+    if (size != 1 && size != 2 && size != 4 && size != 8) return;
+    WatchSlot *w = &g_watches[id];
+    if (w->addr) return;                       /* already armed */
+
+    w->name = name;
+    w->size = size;
+    w->kind = kind;
+    w->fd   = -1;
+    memcpy(w->last, addr, (size_t)size);
+    debug_mode();
+
+#if defined(RT_DEBUG_HW_WATCH)
+    w->addr = addr;
+    if (watch_arm(w) != 0) {
+        fprintf(stderr, "[watch] %s: hardware watchpoint unavailable: %s\n",
+                name, strerror(errno));
+        w->addr = NULL;
+    }
+#else
+    fprintf(stderr, "[watch] %s: hardware watchpoints are not supported on this platform\n",
+            name);
+#endif
+}
+
+/// Exit report (MONAD_BREAK=count)
+
+static void debug_report_at_exit(void) {
+    for (int i = 0; i < RT_DEBUG_MAX_POINTS; i++) {
+        const BreakSlot *b = &g_breaks[i];
+        if (b->hits)
+            fprintf(stderr, "[break %d] %s:%d:%d  %llu hits\n", i + 1,
+                    b->site ? b->site->file : "?", b->site ? b->site->line : 0,
+                    b->site ? b->site->col : 0, (unsigned long long)b->hits);
+    }
+    for (int i = 0; i < RT_DEBUG_MAX_POINTS; i++) {
+        const WatchSlot *w = &g_watches[i];
+        if (w->addr)
+            fprintf(stderr, "[watch] %s  %llu writes\n", w->name,
+                    (unsigned long long)w->writes);
+    }
+}
@@ -0,0 +1,743 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "runtime.h"
+
+///  Runtime profiler (MONAD_PROF)
+//
+//  Sampling CPU profiler and allocation profiler for compiled Monad
+//  programs, reported in Monad terms.  rt_prof_init() reads the
+//  environment once; generated main() calls it next to rt_gc_init and the
+//  REPL calls it at startup.
+//
+//    MONAD_PROF=cpu        SIGPROF sampler -> <prefix>.cpu.folded
+//    MONAD_PROF=alloc      allocation profile -> <prefix>.alloc.folded
+//    MONAD_PROF=perf       JIT symbols only, in /tmp/perf-<pid>.map
+//    MONAD_PROF=cpu,alloc  modes combine
+//    MONAD_PROF_HZ         sampling rate (default 1000)
+//    MONAD_PROF_ALLOC_RATE mean bytes between allocation stack samples
+//                          (default 512K)
+//    MONAD_PROF_FILE       output prefix (default monad-<pid>)
+//
+//  Both outputs use the folded-stack format ("main;f;g 42", root first),
+//  which flamegraph.pl, speedscope and inferno read directly.  Frames are
+//  named from the closure names codegen passes to rt_value_closure_named
+//  and friends, then from the ELF symbol tables of the executable and its
+//  libraries, then from JIT symbols registered with rt_prof_jit_symbol.
+//
+//  Every runtime allocation (rt_alloc and the eval arena) is counted
+//  against the source span in __monad_prof_site, which code built with
+//  --profile-sites stores before each runtime call.  Those counters are
+//  exact; stacks are sampled every MONAD_PROF_ALLOC_RATE bytes on average
+//  and weighted by the bytes they stand for, with the span as the leaf.
+//
+//  Any MONAD_PROF mode also makes the JIT write a perf map, so
+//  `perf record` can name REPL frames.
+
+#if defined(_MSC_VER)
+#define RT_THREAD_LOCAL __declspec(thread)
+#else
+#define RT_THREAD_LOCAL __thread
+#endif
+
+RT_THREAD_LOCAL const RtProfSite *__monad_prof_site;
+int g_rt_prof_active;
+int g_rt_prof_alloc;
+
+#if !defined(_WIN32) && (defined(__GLIBC__) || defined(__APPLE__))
+#define RT_PROF_SUPPORTED 1
+#endif
+
+#if !defined(RT_PROF_SUPPORTED)
+
+void rt_prof_init(void) {
+    const char *mode = getenv("MONAD_PROF");
+    if (mode && *mode)
+        fprintf(stderr, "[prof] MONAD_PROF is not supported on this platform\n");
+}
+
+void rt_prof_note_alloc(size_t size) { (void)size; }
+
+void rt_prof_note_closure(void *fn_ptr, void *direct, const char *name) {
+    (void)fn_ptr; (void)direct; (void)name;
+}
+
+int rt_prof_perf_map_enabled(void) { return 0; }
+
+void rt_prof_jit_symbol(uintptr_t addr, size_t size, const char *name) {
+    (void)addr; (void)size; (void)name;
+}
+
+#else
+
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#define PROF_DEPTH        48
+#define PROF_CPU_SAMPLES  (1u << 17)   // ~2 minutes of CPU at 1000 Hz
+#define PROF_ALLOC_SAMPLES (1u << 16)
+#define PROF_SITE_SLOTS   4096u        // power of two
+#define PROF_CLOSURE_SLOTS 16384u      // power of two
+#define PROF_TOP_SITES    10
+
+enum { PROF_CPU = 1, PROF_ALLOC = 2, PROF_PERF = 4 };
+
+typedef struct {
+    uint64_t          weight;
+    const RtProfSite *site;
+    int               depth;
+    void             *pc[PROF_DEPTH];
+} ProfSample;
+
+typedef struct {
+    ProfSample *samples;
+    uint32_t    cap;
+    uint32_t    next;       // claimed slots, may run past cap
+} ProfBuffer;
+
+typedef struct {
+    const RtProfSite *site;
+    uint64_t          count;
+    uint64_t          bytes;
+} ProfSiteSlot;
+
+typedef struct {
+    void       *code;
+    const char *name;
+} ProfClosureSlot;
+
+typedef struct {
+    uintptr_t   start;
+    uintptr_t   end;
+    const char *name;
+    int         monad;      // name came from the closure registry or JIT
+} ProfSym;
+
+static int          g_prof_mode = -1;
+static const char  *g_prof_prefix;
+static char         g_prof_prefix_buf[64];
+static long         g_prof_hz = 1000;
+static uint64_t     g_prof_alloc_rate = 512u * 1024u;
+
+static ProfBuffer   g_prof_cpu;
+static ProfBuffer   g_prof_alloc;
+static ProfSiteSlot g_prof_sites[PROF_SITE_SLOTS];
+static uint64_t     g_prof_other_count, g_prof_other_bytes;   // no site / table full
+static ProfClosureSlot g_prof_closures[PROF_CLOSURE_SLOTS];
+
+static RT_THREAD_LOCAL uint64_t tl_alloc_since;
+static RT_THREAD_LOCAL uint64_t tl_alloc_next;
+static RT_THREAD_LOCAL uint64_t tl_alloc_rng;
+
+static pthread_mutex_t g_prof_jit_lock = PTHREAD_MUTEX_INITIALIZER;
+static ProfSym        *g_prof_jit_syms;
+static size_t          g_prof_jit_count, g_prof_jit_cap;
+static FILE           *g_prof_perf_map;
+
+static int prof_mode(void) {
+    if (g_prof_mode >= 0) return g_prof_mode;
+    int mode = 0;
+    const char *env = getenv("MONAD_PROF");
+    while (env && *env) {
+        size_t n = strcspn(env, ",+");
+        if      (n == 3 && strncmp(env, "cpu", 3) == 0)   mode |= PROF_CPU;
+        else if (n == 5 && strncmp(env, "alloc", 5) == 0) mode |= PROF_ALLOC;
+        else if (n == 4 && strncmp(env, "perf", 4) == 0)  mode |= PROF_PERF;
+        else if (n > 0)
+            fprintf(stderr, "[prof] ignoring unknown MONAD_PROF mode '%.*s'\n",
+                    (int)n, env);
+        env += n;
+        if (*env) env++;
+    }
+    g_prof_mode = mode;
+    return mode;
+}
+
+static uint64_t prof_env_size(const char *name, uint64_t dflt) {
+    const char *s = getenv(name);
+    if (!s || !*s) return dflt;
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*end == 'k' || *end == 'K') v <<= 10;
+    else if (*end == 'm' || *end == 'M') v <<= 20;
+    return v ? (uint64_t)v : dflt;
+}
+
+static int prof_buffer_init(ProfBuffer *b, uint32_t cap) {
+    // calloc of this size is mmap'd zero pages, so only the slots a run
+    // actually fills cost memory.
+    b->samples = calloc(cap, sizeof(ProfSample));
+    b->cap     = b->samples ? cap : 0;
+    b->next    = 0;
+    return b->samples != NULL;
+}
+
+static ProfSample *prof_buffer_claim(ProfBuffer *b) {
+    uint32_t i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED);
+    return i < b->cap ? &b->samples[i] : NULL;
+}
+
+static uint32_t prof_buffer_count(const ProfBuffer *b) {
+    uint32_t n = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
+    return n < b->cap ? n : b->cap;
+}
+
+static int prof_skip_frames(void **pc, int n, int skip) {
+    if (n <= skip) return 0;
+    memmove(pc, pc + skip, sizeof(void *) * (size_t)(n - skip));
+    return n - skip;
+}
+
+/// CPU sampler
+
+static void prof_on_sigprof(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    ProfSample *s = prof_buffer_claim(&g_prof_cpu);
+    if (s) {
+        // Frames 0 and 1 are this handler and the kernel's signal
+        // trampoline; frame 2 is the interrupted function.
+        void *pc[PROF_DEPTH + 2];
+        int n = backtrace(pc, PROF_DEPTH + 2);
+        n = prof_skip_frames(pc, n, 2);
+        memcpy(s->pc, pc, sizeof(void *) * (size_t)n);
+        s->site   = __monad_prof_site;
+        s->weight = 1;
+        __atomic_store_n(&s->depth, n, __ATOMIC_RELEASE);
+    }
+    errno = saved_errno;
+}
+
+static void prof_cpu_start(void) {
+    if (!prof_buffer_init(&g_prof_cpu, PROF_CPU_SAMPLES)) return;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = prof_on_sigprof;
+    sa.sa_flags   = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+
+    long usec = 1000000L / (g_prof_hz > 0 ? g_prof_hz : 1000);
+    if (usec < 1) usec = 1;
+    struct itimerval it;
+    it.it_interval.tv_sec  = usec / 1000000L;
+    it.it_interval.tv_usec = usec % 1000000L;
+    it.it_value            = it.it_interval;
+    setitimer(ITIMER_PROF, &it, NULL);
+}
+
+static void prof_cpu_stop(void) {
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+    signal(SIGPROF, SIG_IGN);
+}
+
+/// Allocation profiler
+
+static uint64_t prof_next_interval(void) {
+    // Uniform in [rate/2, 3*rate/2): the mean is the rate, and the jitter
+    // keeps a loop whose allocations repeat with the sampling period from
+    // always landing on the same site.
+    uint64_t x = tl_alloc_rng ? tl_alloc_rng : (uint64_t)(uintptr_t)&tl_alloc_rng | 1;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    tl_alloc_rng = x;
+    return g_prof_alloc_rate / 2 + x % (g_prof_alloc_rate ? g_prof_alloc_rate : 1);
+}
+
+static void prof_count_site(const RtProfSite *site, size_t size) {
+    if (site) {
+        size_t h = (size_t)((((uintptr_t)site >> 3) * 0x9E3779B97F4A7C15ull) >> 20);
+        for (size_t probe = 0; probe < 64; probe++) {
+            ProfSiteSlot *slot = &g_prof_sites[(h + probe) & (PROF_SITE_SLOTS - 1)];
+            const RtProfSite *cur = __atomic_load_n(&slot->site, __ATOMIC_ACQUIRE);
+            if (!cur) {
+                const RtProfSite *expected = NULL;
+                if (__atomic_compare_exchange_n(&slot->site, &expected, site, 0,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    cur = site;
+                else
+                    cur = expected;
+            }
+            if (cur == site) {
+                __atomic_fetch_add(&slot->count, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&slot->bytes, size, __ATOMIC_RELAXED);
+                return;
+            }
+        }
+    }
+    __atomic_fetch_add(&g_prof_other_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_prof_other_bytes, size, __ATOMIC_RELAXED);
+}
+
+__attribute__((noinline))
+void rt_prof_note_alloc(size_t size) {
+    const RtProfSite *site = __monad_prof_site;
+    prof_count_site(site, size);
+
+    if (!tl_alloc_next) tl_alloc_next = prof_next_interval();
+    tl_alloc_since += size;
+    if (tl_alloc_since < tl_alloc_next) return;
+
+    ProfSample *s = prof_buffer_claim(&g_prof_alloc);
+    if (s) {
+        // Frame 0 is this function; frame 1 is the allocator it was
+        // called from, which is worth keeping as the leaf.
+        void *pc[PROF_DEPTH + 1];
+        int n = backtrace(pc, PROF_DEPTH + 1);
+        n = prof_skip_frames(pc, n, 1);
+        memcpy(s->pc, pc, sizeof(void *) * (size_t)n);
+        s->site   = site;
+        s->weight = tl_alloc_since;
+        __atomic_store_n(&s->depth, n, __ATOMIC_RELEASE);
+    }
+    tl_alloc_since = 0;
+    tl_alloc_next  = prof_next_interval();
+}
+
+/// Closure names
+
+void rt_prof_note_closure(void *fn_ptr, void *direct, const char *name) {
+    if (!name || !*name) return;
+    void *codes[2] = { fn_ptr, direct };
+    for (int k = 0; k < 2; k++) {
+        void *code = codes[k];
+        if (!code) continue;
+        size_t h = (size_t)((((uintptr_t)code >> 4) * 0x9E3779B97F4A7C15ull) >> 18);
+        for (size_t probe = 0; probe < 32; probe++) {
+            ProfClosureSlot *slot =
+                &g_prof_closures[(h + probe) & (PROF_CLOSURE_SLOTS - 1)];
+            void *cur = __atomic_load_n(&slot->code, __ATOMIC_ACQUIRE);
+            if (cur == code) break;
+            if (cur) continue;
+            void *expected = NULL;
+            if (__atomic_compare_exchange_n(&slot->code, &expected, code, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&slot->name, name, __ATOMIC_RELEASE);
+                break;
+            }
+            if (expected == code) break;
+        }
+    }
+}
+
+static const char *prof_closure_name(uintptr_t code) {
+    size_t h = (size_t)(((code >> 4) * 0x9E3779B97F4A7C15ull) >> 18);
+    for (size_t probe = 0; probe < 32; probe++) {
+        ProfClosureSlot *slot = &g_prof_closures[(h + probe) & (PROF_CLOSURE_SLOTS - 1)];
+        void *cur = __atomic_load_n(&slot->code, __ATOMIC_ACQUIRE);
+        if (!cur) return NULL;
+        if ((uintptr_t)cur == code) return __atomic_load_n(&slot->name, __ATOMIC_ACQUIRE);
+    }
+    return NULL;
+}
+
+/// JIT symbols and the perf map
+
+int rt_prof_perf_map_enabled(void) {
+    return prof_mode() != 0;
+}
+
+void rt_prof_jit_symbol(uintptr_t addr, size_t size, const char *name) {
+    if (!addr || !name || !rt_prof_perf_map_enabled()) return;
+    pthread_mutex_lock(&g_prof_jit_lock);
+    if (!g_prof_perf_map) {
+        // perf looks for exactly this path; see tools/perf/Documentation/jit-interface.txt.
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+        g_prof_perf_map = fopen(path, "a");
+    }
+    if (g_prof_perf_map) {
+        fprintf(g_prof_perf_map, "%llx %llx %s\n", (unsigned long long)addr,
+                (unsigned long long)size, name);
+        fflush(g_prof_perf_map);
+    }
+    if (g_prof_jit_count == g_prof_jit_cap) {
+        size_t cap = g_prof_jit_cap ? g_prof_jit_cap * 2 : 64;
+        ProfSym *grown = realloc(g_prof_jit_syms, cap * sizeof(ProfSym));
+        if (grown) {
+            g_prof_jit_syms = grown;
+            g_prof_jit_cap  = cap;
+        }
+    }
+    if (g_prof_jit_count < g_prof_jit_cap) {
+        ProfSym *s = &g_prof_jit_syms[g_prof_jit_count++];
+        s->start = addr;
+        s->end   = addr + size;
+        s->name  = strdup(name);
+        s->monad = 1;
+    }
+    pthread_mutex_unlock(&g_prof_jit_lock);
+}
+
+/// Symbolization
+
+typedef struct {
+    ProfSym *syms;
+    size_t   count, cap;
+} ProfSymTab;
+
+static void prof_sym_add(ProfSymTab *t, uintptr_t start, uintptr_t end,
+                         const char *name, int monad) {
+    if (t->count == t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 1024;
+        ProfSym *grown = realloc(t->syms, cap * sizeof(ProfSym));
+        if (!grown) return;
+        t->syms = grown;
+        t->cap  = cap;
+    }
+    ProfSym *s = &t->syms[t->count++];
+    s->start = start;
+    s->end   = end;
+    s->name  = name;
+    s->monad = monad;
+}
+
+#if defined(__linux__)
+
+// Adds the function symbols of one loaded ELF object.  The file stays
+// mapped: symbol names point into its string table.
+static void prof_load_elf(ProfSymTab *t, const char *path, uintptr_t bias) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        return;
+    }
+    const unsigned char *base =
+        mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return;
+
+    size_t size = (size_t)st.st_size;
+    const ElfW(Ehdr) *eh = (const ElfW(Ehdr) *)base;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_shoff == 0 ||
+        eh->e_shoff + (size_t)eh->e_shnum * sizeof(ElfW(Shdr)) > size) {
+        munmap((void *)base, size);
+        return;
+    }
+    const ElfW(Shdr) *sh = (const ElfW(Shdr) *)(base + eh->e_shoff);
+
+    // Prefer the full .symtab; stripped libraries still have .dynsym.
+    int want[2] = { SHT_SYMTAB, SHT_DYNSYM };
+    for (int w = 0; w < 2; w++) {
+        int found = 0;
+        for (unsigned i = 0; i < eh->e_shnum; i++) {
+            if ((int)sh[i].sh_type != want[w] || sh[i].sh_link >= eh->e_shnum) continue;
+            const ElfW(Shdr) *strs = &sh[sh[i].sh_link];
+            if (sh[i].sh_offset + sh[i].sh_size > size ||
+                strs->sh_offset + strs->sh_size > size) continue;
+            const ElfW(Sym) *sym = (const ElfW(Sym) *)(base + sh[i].sh_offset);
+            size_t nsym = sh[i].sh_size / sizeof(ElfW(Sym));
+            const char *names = (const char *)(base + strs->sh_offset);
+            for (size_t k = 0; k < nsym; k++) {
+                if (ELF64_ST_TYPE(sym[k].st_info) != STT_FUNC) continue;
+                if (sym[k].st_value == 0 || sym[k].st_name >= strs->sh_size) continue;
+                uintptr_t start = bias + (uintptr_t)sym[k].st_value;
+                prof_sym_add(t, start, start + (uintptr_t)sym[k].st_size,
+                             names + sym[k].st_name, 0);
+            }
+            found = 1;
+        }
+        if (found) return;
+    }
+}
+
+static int prof_on_object(struct dl_phdr_info *info, size_t len, void *data) {
+    (void)len;
+    const char *path = info->dlpi_name;
+    if (!path || !*path) path = "/proc/self/exe";
+    prof_load_elf(data, path, (uintptr_t)info->dlpi_addr);
+    return 0;
+}
+
+#endif
+
+static int prof_sym_cmp(const void *a, const void *b) {
+    const ProfSym *x = a, *y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return y->monad - x->monad;   // JIT names win on ties
+}
+
+static void prof_symtab_build(ProfSymTab *t) {
+#if defined(__linux__)
+    dl_iterate_phdr(prof_on_object, t);
+#endif
+    pthread_mutex_lock(&g_prof_jit_lock);
+    for (size_t i = 0; i < g_prof_jit_count; i++)
+        prof_sym_add(t, g_prof_jit_syms[i].start, g_prof_jit_syms[i].end,
+                     g_prof_jit_syms[i].name, 1);
+    pthread_mutex_unlock(&g_prof_jit_lock);
+
+    if (t->count == 0) return;
+    qsort(t->syms, t->count, sizeof(ProfSym), prof_sym_cmp);
+    // Symbols without a size run to the next higher address.
+    for (size_t i = 0; i < t->count; i++) {
+        if (t->syms[i].end > t->syms[i].start) continue;
+        size_t j = i + 1;
+        while (j < t->count && t->syms[j].start == t->syms[i].start) j++;
+        t->syms[i].end = j < t->count ? t->syms[j].start : t->syms[i].start + 1;
+    }
+}
+
+static const ProfSym *prof_sym_find(const ProfSymTab *t, uintptr_t pc) {
+    size_t lo = 0, hi = t->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t->syms[mid].start <= pc) lo = mid + 1;
+        else                          hi = mid;
+    }
+    if (lo == 0) return NULL;
+    // Aliases share a start address; the sort put the preferred one first.
+    size_t i = lo - 1;
+    while (i > 0 && t->syms[i - 1].start == t->syms[i].start) i--;
+    for (size_t k = i; k < lo; k++)
+        if (pc < t->syms[k].end) return &t->syms[k];
+    return NULL;
+}
+
+static void prof_append(char **buf, size_t *len, size_t *cap, const char *s, size_t n) {
+    if (*len + n + 1 > *cap) {
+        size_t c = *cap ? *cap : 256;
+        while (*len + n + 1 > c) c *= 2;
+        char *grown = realloc(*buf, c);
+        if (!grown) return;
+        *buf = grown;
+        *cap = c;
+    }
+    memcpy(*buf + *len, s, n);
+    *len += n;
+    (*buf)[*len] = '\0';
+}
+
+// Appends one frame name, with the separators of the folded format
+// replaced so they cannot split a frame.
+static void prof_append_frame(char **buf, size_t *len, size_t *cap, const char *name) {
+    size_t start = *len;
+    prof_append(buf, len, cap, name, strlen(name));
+    for (size_t i = start; i < *len; i++)
+        if ((*buf)[i] == ';' || (*buf)[i] == '\n') (*buf)[i] = ':';
+}
+
+static const char *prof_frame_name(const ProfSymTab *t, void *frame, int leaf,
+                                   char *scratch, size_t scratch_len) {
+    // Return addresses point after the call; look up the call itself.
+    uintptr_t pc = (uintptr_t)frame - (leaf ? 0 : 1);
+    const ProfSym *s = prof_sym_find(t, pc);
+    if (s) {
+        const char *monad = prof_closure_name(s->start);
+        return monad ? monad : s->name;
+    }
+    const char *monad = prof_closure_name((uintptr_t)frame);
+    if (monad) return monad;
+#if !defined(__linux__)
+    Dl_info info;
+    if (dladdr((void *)pc, &info) && info.dli_sname) {
+        monad = prof_closure_name((uintptr_t)info.dli_saddr);
+        return monad ? monad : info.dli_sname;
+    }
+#endif
+    snprintf(scratch, scratch_len, "0x%llx", (unsigned long long)pc);
+    return scratch;
+}
+
+typedef struct {
+    char    *stack;
+    uint64_t weight;
+} ProfLine;
+
+static int prof_line_cmp(const void *a, const void *b) {
+    return strcmp(((const ProfLine *)a)->stack, ((const ProfLine *)b)->stack);
+}
+
+static void prof_site_label(const RtProfSite *site, char *out, size_t len) {
+    snprintf(out, len, "%s:%d:%d", site->file ? site->file : "?",
+             (int)site->line, (int)site->col);
+}
+
+// Writes the samples of `b` as folded stacks; `cpu_leaf` marks buffers
+// whose first frame is an interrupted pc rather than a return address.
+static size_t prof_write_folded(const ProfSymTab *t, const ProfBuffer *b,
+                                const char *path, int cpu_leaf, int site_leaf) {
+    uint32_t n = prof_buffer_count(b);
+    ProfLine *lines = calloc(n ? n : 1, sizeof(ProfLine));
+    if (!lines) return 0;
+
+    size_t count = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const ProfSample *s = &b->samples[i];
+        int depth = __atomic_load_n(&s->depth, __ATOMIC_ACQUIRE);
+        if (depth <= 0) continue;   // claimed but never filled
+        char  *buf = NULL;
+        size_t len = 0, cap = 0;
+        char   scratch[32];
+        for (int f = depth - 1; f >= 0; f--) {
+            const char *name = prof_frame_name(t, s->pc[f], cpu_leaf && f == 0,
+                                               scratch, sizeof(scratch));
+            if (len) prof_append(&buf, &len, &cap, ";", 1);
+            prof_append_frame(&buf, &len, &cap, name);
+        }
+        if (site_leaf && s->site) {
+            char label[512];
+            prof_site_label(s->site, label, sizeof(label));
+            prof_append(&buf, &len, &cap, ";[", 2);
+            prof_append_frame(&buf, &len, &cap, label);
+            prof_append(&buf, &len, &cap, "]", 1);
+        }
+        if (!buf) continue;
+        lines[count].stack  = buf;
+        lines[count].weight = s->weight;
+        count++;
+    }
+
+    qsort(lines, count, sizeof(ProfLine), prof_line_cmp);
+    FILE *out = fopen(path, "w");
+    if (!out) fprintf(stderr, "[prof] cannot write %s\n", path);
+    size_t distinct = 0;
+    for (size_t i = 0; i < count; ) {
+        uint64_t w = 0;
+        size_t j = i;
+        while (j < count && strcmp(lines[j].stack, lines[i].stack) == 0)
+            w += lines[j++].weight;
+        if (out) fprintf(out, "%s %llu\n", lines[i].stack, (unsigned long long)w);
+        distinct++;
+        i = j;
+    }
+    if (out) fclose(out);
+    for (size_t i = 0; i < count; i++) free(lines[i].stack);
+    free(lines);
+    return distinct;
+}
+
+static void prof_format_bytes(uint64_t bytes, char *out, size_t len) {
+    if      (bytes >= (1ull << 30)) snprintf(out, len, "%.1f GiB", bytes / 1073741824.0);
+    else if (bytes >= (1ull << 20)) snprintf(out, len, "%.1f MiB", bytes / 1048576.0);
+    else if (bytes >= (1ull << 10)) snprintf(out, len, "%.1f KiB", bytes / 1024.0);
+    else                            snprintf(out, len, "%llu B", (unsigned long long)bytes);
+}
+
+static int prof_site_cmp(const void *a, const void *b) {
+    const ProfSiteSlot *x = a, *y = b;
+    if (x->bytes != y->bytes) return x->bytes > y->bytes ? -1 : 1;
+    return 0;
+}
+
+static void prof_report_sites(const char *path) {
+    ProfSiteSlot *sites = malloc(sizeof(g_prof_sites));
+    if (!sites) return;
+    size_t n = 0;
+    uint64_t total_bytes = g_prof_other_bytes, total_count = g_prof_other_count;
+    for (size_t i = 0; i < PROF_SITE_SLOTS; i++) {
+        if (!g_prof_sites[i].site) continue;
+        sites[n++] = g_prof_sites[i];
+        total_bytes += g_prof_sites[i].bytes;
+        total_count += g_prof_sites[i].count;
+    }
+    qsort(sites, n, sizeof(ProfSiteSlot), prof_site_cmp);
+
+    char total[32];
+    prof_format_bytes(total_bytes, total, sizeof(total));
+    fprintf(stderr, "[prof] alloc: %s in %llu allocations at %zu sites -> %s\n",
+            total, (unsigned long long)total_count, n, path);
+    if (n == 0) {
+        free(sites);
+        return;
+    }
+    fprintf(stderr, "  %12s %12s  %s\n", "bytes", "count", "site");
+    for (size_t i = 0; i < n && i < PROF_TOP_SITES; i++) {
+        char bytes[32], label[512];
+        prof_format_bytes(sites[i].bytes, bytes, sizeof(bytes));
+        prof_site_label(sites[i].site, label, sizeof(label));
+        fprintf(stderr, "  %12s %12llu  %s (%s)\n", bytes,
+                (unsigned long long)sites[i].count, label,
+                sites[i].site->fn && *sites[i].site->fn ? sites[i].site->fn : "top level");
+    }
+    if (g_prof_other_count) {
+        char bytes[32];
+        prof_format_bytes(g_prof_other_bytes, bytes, sizeof(bytes));
+        fprintf(stderr, "  %12s %12llu  (no site)\n", bytes,
+                (unsigned long long)g_prof_other_count);
+    }
+    free(sites);
+}
+
+static void prof_report_at_exit(void) {
+    int mode = prof_mode();
+    if (mode & PROF_CPU) prof_cpu_stop();
+    g_rt_prof_alloc  = 0;
+    g_rt_prof_active = 0;
+
+    ProfSymTab t = {0};
+    prof_symtab_build(&t);
+
+    char path[sizeof(g_prof_prefix_buf) + 256];
+    if (mode & PROF_CPU) {
+        snprintf(path, sizeof(path), "%s.cpu.folded", g_prof_prefix);
+        uint32_t claimed = __atomic_load_n(&g_prof_cpu.next, __ATOMIC_ACQUIRE);
+        size_t stacks = prof_write_folded(&t, &g_prof_cpu, path, 1, 0);
+        fprintf(stderr, "[prof] cpu: %u samples at %ld Hz, %zu stacks",
+                prof_buffer_count(&g_prof_cpu), g_prof_hz, stacks);
+        if (claimed > g_prof_cpu.cap)
+            fprintf(stderr, ", %u dropped", claimed - g_prof_cpu.cap);
+        fprintf(stderr, " -> %s\n", path);
+    }
+    if (mode & PROF_ALLOC) {
+        snprintf(path, sizeof(path), "%s.alloc.folded", g_prof_prefix);
+        prof_write_folded(&t, &g_prof_alloc, path, 0, 1);
+        prof_report_sites(path);
+    }
+    free(t.syms);
+}
+
+void rt_prof_init(void) {
+    static int started;
+    if (started) return;
+    started = 1;
+
+    int mode = prof_mode();
+    if (!(mode & (PROF_CPU | PROF_ALLOC))) return;
+
+    const char *prefix = getenv("MONAD_PROF_FILE");
+    if (prefix && *prefix && strlen(prefix) < sizeof(g_prof_prefix_buf) + 200) {
+        g_prof_prefix = prefix;
+    } else {
+        snprintf(g_prof_prefix_buf, sizeof(g_prof_prefix_buf), "monad-%ld", (long)getpid());
+        g_prof_prefix = g_prof_prefix_buf;
+    }
+    g_prof_hz         = (long)prof_env_size("MONAD_PROF_HZ", 1000);
+    g_prof_alloc_rate = prof_env_size("MONAD_PROF_ALLOC_RATE", 512u * 1024u);
+
+    // The first backtrace() loads the unwinder with dlopen, which must not
+    // happen inside a signal handler or an allocation.
+    void *warm[4];
+    backtrace(warm, 4);
+
+    atexit(prof_report_at_exit);
+    g_rt_prof_active = 1;
+    if ((mode & PROF_ALLOC) && prof_buffer_init(&g_prof_alloc, PROF_ALLOC_SAMPLES))
+        g_rt_prof_alloc = 1;
+    if (mode & PROF_CPU) prof_cpu_start();
+}
+
+#endif
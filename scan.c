@@ -0,0 +1,159 @@
+#include "scan.h"
+#include <stdint.h>
+#include <string.h>
+
+/* Sanitizer builds take the scalar path: the intrinsic wrappers are
+ * instrumented even when inlined into an excluded function. */
+#if defined(__SANITIZE_ADDRESS__)
+#  define SCAN_ASAN 1
+#elif defined(__has_feature)
+#  if __has_feature(address_sanitizer)
+#    define SCAN_ASAN 1
+#  endif
+#endif
+
+#if defined(__SSE2__) && !defined(SCAN_ASAN)
+#  include <emmintrin.h>
+#  define SCAN_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(SCAN_ASAN)
+#  include <arm_neon.h>
+#  define SCAN_NEON 1
+#endif
+
+#if defined(SCAN_SSE2) || defined(SCAN_NEON)
+
+///  Vector primitives
+//
+//  A "hit" mask has 0xFF in every lane whose byte ends the scan.  scan_bits
+//  packs it into an integer with SCAN_BPB bits per lane, so the first hit
+//  is ctz / SCAN_BPB.
+
+#define SCAN_WIDTH 16
+
+#if defined(SCAN_SSE2)
+
+typedef __m128i ScanVec;
+#define SCAN_BPB 1
+
+static inline ScanVec scan_load(const unsigned char *p) {
+    return _mm_load_si128((const __m128i *)p);
+}
+static inline ScanVec scan_eq(ScanVec v, unsigned char c) {
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8((char)c));
+}
+static inline ScanVec scan_or(ScanVec a, ScanVec b) { return _mm_or_si128(a, b); }
+static inline ScanVec scan_not(ScanVec a) {
+    return _mm_xor_si128(a, _mm_set1_epi8((char)0xFF));
+}
+// lo <= v <= hi, unsigned: (v - lo) <= (hi - lo)
+static inline ScanVec scan_range(ScanVec v, unsigned char lo, unsigned char hi) {
+    ScanVec d    = _mm_sub_epi8(v, _mm_set1_epi8((char)lo));
+    ScanVec span = _mm_set1_epi8((char)(hi - lo));
+    return _mm_cmpeq_epi8(_mm_max_epu8(d, span), span);
+}
+static inline uint64_t scan_bits(ScanVec m) {
+    return (uint64_t)(uint32_t)_mm_movemask_epi8(m);
+}
+
+#else /* SCAN_NEON */
+
+typedef uint8x16_t ScanVec;
+#define SCAN_BPB 4
+
+static inline ScanVec scan_load(const unsigned char *p) { return vld1q_u8(p); }
+static inline ScanVec scan_eq(ScanVec v, unsigned char c) {
+    return vceqq_u8(v, vdupq_n_u8(c));
+}
+static inline ScanVec scan_or(ScanVec a, ScanVec b) { return vorrq_u8(a, b); }
+static inline ScanVec scan_not(ScanVec a) { return vmvnq_u8(a); }
+static inline ScanVec scan_range(ScanVec v, unsigned char lo, unsigned char hi) {
+    return vcleq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8((uint8_t)(hi - lo)));
+}
+static inline uint64_t scan_bits(ScanVec m) {
+    uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nib), 0);
+}
+
+#endif
+
+typedef ScanVec (*ScanStopFn)(ScanVec v, const unsigned char *stops);
+
+static inline ScanVec scan_stop_blank(ScanVec v, const unsigned char *stops) {
+    (void)stops;
+    return scan_not(scan_or(scan_or(scan_eq(v, ' '), scan_eq(v, '\t')),
+                            scan_eq(v, '\r')));
+}
+
+static inline ScanVec scan_stop_word(ScanVec v, const unsigned char *stops) {
+    (void)stops;
+    ScanVec word = scan_or(scan_or(scan_range(v, 'a', 'z'), scan_range(v, 'A', 'Z')),
+                           scan_or(scan_range(v, '0', '9'), scan_eq(v, '_')));
+    return scan_not(word);
+}
+
+static inline ScanVec scan_stop_any(ScanVec v, const unsigned char *stops) {
+    ScanVec hit = scan_eq(v, 0);
+    for (; *stops; stops++) hit = scan_or(hit, scan_eq(v, *stops));
+    return hit;
+}
+
+// Offset of the first lane `stop` flags, starting at `s`.  The first load
+// is the aligned block containing `s`; lanes before `s` are shifted out.
+static inline size_t scan_run(const char *s, ScanStopFn stop,
+                                           const unsigned char *stops) {
+    const unsigned char *p     = (const unsigned char *)s;
+    size_t               off   = (uintptr_t)p & (SCAN_WIDTH - 1);
+    const unsigned char *block = p - off;
+
+    uint64_t bits = scan_bits(stop(scan_load(block), stops)) >> (off * SCAN_BPB);
+    if (bits) return (size_t)__builtin_ctzll(bits) / SCAN_BPB;
+
+    size_t n = SCAN_WIDTH - off;
+    for (block += SCAN_WIDTH;; block += SCAN_WIDTH, n += SCAN_WIDTH) {
+        bits = scan_bits(stop(scan_load(block), stops));
+        if (bits) return n + (size_t)__builtin_ctzll(bits) / SCAN_BPB;
+    }
+}
+
+size_t scan_blank(const char *s) {
+    return scan_run(s, scan_stop_blank, NULL);
+}
+
+size_t scan_word(const char *s) {
+    return scan_run(s, scan_stop_word, NULL);
+}
+
+size_t scan_to_any(const char *s, const char *stops) {
+    return scan_run(s, scan_stop_any, (const unsigned char *)stops);
+}
+
+#else
+
+///  Scalar fallback
+
+static inline int scan_is_blank(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline int scan_is_word(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+size_t scan_blank(const char *s) {
+    size_t n = 0;
+    while (scan_is_blank((unsigned char)s[n])) n++;
+    return n;
+}
+
+size_t scan_word(const char *s) {
+    size_t n = 0;
+    while (scan_is_word((unsigned char)s[n])) n++;
+    return n;
+}
+
+size_t scan_to_any(const char *s, const char *stops) {
+    return strcspn(s, stops);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+///  Byte scanning
+//
+//  Vectorized fast paths for the reader's inner loops.  Each function
+//  returns how many bytes from `s` belong to the run it names, and every
+//  scan stops at the NUL terminator, so the result is always within the
+//  string.  On x86-64 (SSE2) and AArch64 (NEON) sixteen bytes are tested
+//  per step; other targets use the scalar loops.
+//
+//  The vector paths load whole aligned 16-byte blocks, which may include a
+//  few bytes before `s` or after its terminator.  An aligned block never
+//  crosses a page, so this cannot fault.  AddressSanitizer builds use the
+//  scalar loops, since the sanitizer would report those bytes.
+//
+//    size_t n = scan_blank(lex->source + lex->pos);   // spaces, tabs, CRs
+//    size_t m = scan_to_any(src + i, "\"\\\n");       // string body chunk
+
+// Run of ' ', '\t' and '\r'.  Newlines end the run so callers can count
+// lines.
+size_t scan_blank(const char *s);
+
+// Run of ASCII letters, digits and '_'.
+size_t scan_word(const char *s);
+
+// Bytes before the first occurrence of any byte in `stops` (at most four
+// bytes, NUL-terminated), or before the terminator.
+size_t scan_to_any(const char *s, const char *stops);
+
+#endif // SCAN_H
@@ -40,6 +40,19 @@ SUITES: dict[str, Suite] = {
             py("tests/test_tail_calls.py"),
             py("tests/test_how_to_examples.py"),
             py("tests/test_bytecode.py"),
+            py("tests/test_runtime.py"),
+            py("tests/test_env.py"),
+            py("tests/test_infer.py"),
+            py("tests/test_intern.py"),
+            py("tests/test_scan.py"),
+            py("tests/test_module_header.py"),
+            py("tests/test_macro.py"),
+            py("tests/test_dep.py"),
+            py("tests/test_wisp.py"),
+            py("tests/test_pmatch.py"),
+            py("tests/test_optimizations.py"),
+            py("tests/test_bench.py"),
+            py("tests/test_daemon.py"),
         ),
     ),
     "core": Suite(
@@ -80,6 +93,11 @@ SUITES: dict[str, Suite] = {
         "Bytecode VM, verifier, serialization, and visual diagnostics.",
         (py("tests/test_bytecode.py"),),
     ),
+    "runtime": Suite(
+        "runtime",
+        "libmonad runtime harnesses: allocation, collections, and laziness.",
+        (py("tests/test_runtime.py"),),
+    ),
 }
 
 
@@ -0,0 +1,107 @@
+import importlib.util
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+from monad_binary import resolve_monad_binary
+
+
+ROOT = Path(__file__).resolve().parents[1]
+MONAD = resolve_monad_binary()
+
+_spec = importlib.util.spec_from_file_location("monad_bench", ROOT / "bench" / "main.py")
+bench = importlib.util.module_from_spec(_spec)
+_spec.loader.exec_module(bench)
+
+
+def entry(samples: list[float]) -> dict:
+    return {"median": bench.median(samples), "samples": samples}
+
+
+class BenchStatisticsTests(unittest.TestCase):
+    def test_rank_test_separates_disjoint_samples(self):
+        self.assertLess(bench.mann_whitney_p([1, 2, 3, 4, 5, 6], [7, 8, 9, 10, 11, 12]), 0.01)
+
+    def test_rank_test_accepts_identical_samples(self):
+        self.assertEqual(bench.mann_whitney_p([1.0, 1.0, 1.0], [1.0, 1.0, 1.0]), 1.0)
+
+    def test_compare_reports_regression_and_improvement(self):
+        slow = entry([1.20, 1.21, 1.19, 1.22, 1.18, 1.20, 1.21, 1.19])
+        fast = entry([1.00, 1.01, 0.99, 1.02, 0.98, 1.00, 1.01, 0.99])
+        self.assertEqual(bench.compare(slow, fast, 0.05), "regression")
+        self.assertEqual(bench.compare(fast, slow, 0.05), "improvement")
+        self.assertEqual(bench.compare(fast, fast, 0.05), "unchanged")
+
+    def test_compare_ignores_changes_below_threshold(self):
+        a = entry([1.00, 1.01, 1.00, 1.01, 1.00, 1.01, 1.00, 1.01])
+        b = entry([1.02, 1.03, 1.02, 1.03, 1.02, 1.03, 1.02, 1.03])
+        self.assertEqual(bench.compare(b, a, 0.05), "unchanged")
+
+    def test_summary_is_robust_to_one_outlier(self):
+        s = bench.summarize([1.0, 1.0, 1.1, 1.0, 9.0])
+        self.assertEqual(s["median"], 1.0)
+        self.assertEqual(s["mad"], 0.0)
+        self.assertEqual(s["max"], 9.0)
+
+    def test_every_corpus_program_has_expected_output(self):
+        for b in bench.BENCHMARKS.values():
+            source = bench.CORPUS / b.source
+            self.assertTrue(source.exists(), source)
+            self.assertTrue(source.with_suffix(".stdout").exists(), b.name)
+
+
+class BenchCommandTests(unittest.TestCase):
+    def test_monad_bench_list_forwards_to_harness(self):
+        result = subprocess.run(
+            [str(MONAD), "bench", "list"],
+            cwd=ROOT, text=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+            check=False, timeout=30,
+        )
+        self.assertEqual(result.returncode, 0, result.stdout)
+        for name in bench.BENCHMARKS:
+            self.assertIn(name, result.stdout)
+
+    def test_unknown_benchmark_is_a_usage_error(self):
+        result = subprocess.run(
+            [str(MONAD), "bench", "no-such-benchmark", "--no-baseline"],
+            cwd=ROOT, text=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+            check=False, timeout=30,
+        )
+        self.assertEqual(result.returncode, 2, result.stdout)
+
+    def test_corpus_runs_and_round_trips_as_baseline(self):
+        with tempfile.TemporaryDirectory(prefix="monadc-bench-") as td:
+            baseline = Path(td) / "baseline.json"
+            env = os.environ.copy()
+            env["MONAD_BINARY"] = str(MONAD)
+            first = subprocess.run(
+                [sys.executable, str(ROOT / "bench" / "main.py"),
+                 "--runs", "1", "--warmup", "0", "--no-baseline",
+                 "--save-baseline", str(baseline), "--json", "-"],
+                cwd=ROOT, env=env, text=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                check=False, timeout=900,
+            )
+            self.assertEqual(first.returncode, 0, first.stdout + first.stderr)
+            document = json.loads(first.stdout)
+            self.assertEqual(document["schema"], bench.SCHEMA)
+            self.assertEqual(document["failures"], {})
+            self.assertEqual(set(document["benchmarks"]), set(bench.BENCHMARKS))
+
+            second = subprocess.run(
+                [sys.executable, str(ROOT / "bench" / "main.py"), "nbody",
+                 "--runs", "2", "--warmup", "1", "--baseline", str(baseline),
+                 "--threshold", "1000"],
+                cwd=ROOT, env=env, text=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                check=False, timeout=300,
+            )
+            self.assertEqual(second.returncode, 0, second.stdout + second.stderr)
+            self.assertIn("nbody", second.stdout)
+            self.assertIn("unchanged", second.stdout)
+
+
+if __name__ == "__main__":
+    unittest.main()
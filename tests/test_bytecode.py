@@ -21,7 +21,7 @@ def host_supports_baseline_jit() -> bool:
 
 
 class BytecodeModuleTests(unittest.TestCase):
-    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+    def compile_and_run(self, source: str, cflags=(), sources=("bytecode.c",)) -> subprocess.CompletedProcess:
         with tempfile.TemporaryDirectory() as td:
             harness = Path(td) / "bytecode_harness.c"
             exe = Path(td) / "bytecode_harness"
@@ -33,9 +33,10 @@ class BytecodeModuleTests(unittest.TestCase):
                     "-std=c99",
                     "-Wall",
                     "-Wextra",
+                    *cflags,
                     "-iquote",
                     str(ROOT),
-                    str(ROOT / "bytecode.c"),
+                    *(str(ROOT / src) for src in sources),
                     str(harness),
                     "-o",
                     str(exe),
@@ -232,11 +233,10 @@ class BytecodeModuleTests(unittest.TestCase):
 
                 BcProgram jit_program;
                 bc_program_init(&jit_program, "jit-boundary");
-                uint32_t c = bc_program_add_const(&jit_program, bc_value_i64(7));
+                uint32_t c = bc_program_add_const(&jit_program, bc_value_f64(7.5));
                 bc_emit_const(&jit_program, 0, c, bc_span("<jit>", 1, 1));
-                bc_emit(&jit_program, (BcInstr){BC_OP_LOOP, 0, 0, 0, 0}, bc_span("<jit>", 1, 3));
-                bc_emit(&jit_program, (BcInstr){BC_OP_END, 0, 0, 0, 0}, bc_span("<jit>", 1, 4));
-                bc_emit_return(&jit_program, 0, bc_span("<jit>", 1, 5));
+                bc_emit_abc(&jit_program, BC_OP_ADD, 1, 0, 0, bc_span("<jit>", 1, 3));
+                bc_emit_return(&jit_program, 1, bc_span("<jit>", 1, 5));
 
                 BcJitOptions options = bc_jit_options_default();
                 BcJitArtifact artifact;
@@ -838,6 +838,573 @@ class BytecodeModuleTests(unittest.TestCase):
 
         self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
 
+    def test_baseline_jit_compiles_control_flow_and_vm_tiers_up_when_hot(self):
+        """TEST-ID: tests.bytecode.baseline-jit-tier-up
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: baseline JIT compiles if/else/loop and native-call bytecode with per-path register types, and bc_vm_run moves a program to native code once call_hot_threshold or loop_hot_threshold trips; a path-dependent operand without a deopt map is rejected.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        if not host_supports_baseline_jit():
+            self.skipTest("baseline JIT is available only on Linux x86_64")
+
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static bool identity(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)argc; (void)ud;
+                *out = args[0];
+                return true;
+            }
+
+            /* r3 = 5 < 3 ? 5 - 3 : 5 * 3; loop r4 (2) { r3 += r4 }; return r3 -> 17 */
+            static void build(BcProgram *p, bool with_native) {
+                BcSourceSpan s = bc_span("tier.mon", 1, 1);
+                bc_emit_const(p, 0, bc_program_add_const(p, bc_value_i64(5)), s);
+                bc_emit_const(p, 1, bc_program_add_const(p, bc_value_i64(3)), s);
+                bc_emit_abc(p, BC_OP_LT, 2, 0, 1, s);
+                bc_emit(p, (BcInstr){BC_OP_IF, 2, 0, 0, 0}, s);
+                bc_emit_abc(p, BC_OP_SUB, 3, 0, 1, s);
+                bc_emit(p, (BcInstr){BC_OP_ELSE, 0, 0, 0, 0}, s);
+                bc_emit_abc(p, BC_OP_MUL, 3, 0, 1, s);
+                bc_emit(p, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                bc_emit_const(p, 4, bc_program_add_const(p, bc_value_i64(2)), s);
+                bc_emit(p, (BcInstr){BC_OP_LOOP, 4, 0, 0, 0}, s);
+                bc_emit_abc(p, BC_OP_ADD, 3, 3, 4, s);
+                bc_emit(p, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                if (with_native) {
+                    uint32_t n = bc_program_add_native_typed(p, "identity", identity, NULL, BC_TYPE_I64, 1, 1);
+                    bc_emit(p, (BcInstr){BC_OP_CALL_NATIVE, 3, 3, 1, n}, s);
+                }
+                bc_emit_return(p, 3, s);
+            }
+
+            static int run_n(BcVM *vm, BcProgram *p, int n) {
+                for (int i = 0; i < n; i++) {
+                    BcValue result = bc_value_nil();
+                    BcError error;
+                    if (!bc_vm_run(vm, p, &result, &error)) { fprintf(stderr, "%s\n", error.message); return 1; }
+                    if (result.kind != BC_VALUE_I64 || result.as.i64 != 17) {
+                        fprintf(stderr, "run %d: kind=%d value=%lld\n", i, result.kind, (long long)result.as.i64);
+                        return 1;
+                    }
+                }
+                return 0;
+            }
+
+            int main(void) {
+                BcProgram program;
+                bc_program_init(&program, "tier-up");
+                build(&program, false);
+
+                BcJitOptions options = bc_jit_options_default();
+                BcJitArtifact artifact;
+                BcError error;
+                if (!bc_jit_compile_baseline(&program, &options, &artifact, &error)) {
+                    fprintf(stderr, "jit failed: %s\n", error.message);
+                    return 1;
+                }
+                if (artifact.result_type != BC_TYPE_I64 || ((BcJitEntry)artifact.entry)() != 17) return 2;
+                bc_jit_artifact_free(&artifact);
+
+                BcVM vm;
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 3;
+                vm.tier.loop_hot_threshold = 1000;
+                if (run_n(&vm, &program, 5)) return 3;
+                printf("calls: interpreted=%zu native=%zu\n", vm.calls, vm.jit_runs);
+                bc_vm_free(&vm);
+
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 1000;
+                vm.tier.loop_hot_threshold = 2;
+                if (run_n(&vm, &program, 5)) return 4;
+                printf("loops: interpreted=%zu native=%zu\n", vm.calls, vm.jit_runs);
+                bc_vm_free(&vm);
+
+                BcProgram native;
+                bc_program_init(&native, "tier-native");
+                build(&native, true);
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 1;
+                if (run_n(&vm, &native, 3)) return 5;
+                printf("native: interpreted=%zu native=%zu rejected=%d\n", vm.calls, vm.jit_runs, vm.jit_rejected);
+                bc_vm_free(&vm);
+
+                /* r1 is set on one path only: nil or i64 at the return. */
+                BcProgram split;
+                bc_program_init(&split, "tier-split");
+                BcSourceSpan s = bc_span("split.mon", 1, 1);
+                bc_emit(&split, (BcInstr){BC_OP_BOOL, 0, 0, 0, 0}, s);
+                bc_emit(&split, (BcInstr){BC_OP_IF, 0, 0, 0, 0}, s);
+                bc_emit_const(&split, 1, bc_program_add_const(&split, bc_value_i64(1)), s);
+                bc_emit(&split, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                bc_emit_abc(&split, BC_OP_ADD, 2, 1, 1, s);
+                bc_emit_return(&split, 2, s);
+                if (bc_jit_compile_baseline(&split, &options, &artifact, &error)) return 6;
+                printf("split: %s\n", error.message);
+
+                bc_program_free(&split);
+                bc_program_free(&native);
+                bc_program_free(&program);
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("calls: interpreted=3 native=2", result.stdout)
+        self.assertIn("loops: interpreted=2 native=3", result.stdout)
+        self.assertIn("native: interpreted=1 native=2 rejected=0", result.stdout)
+        self.assertIn("split: baseline JIT needs r1 to be I64 on every path into bc.add; it is Unknown", result.stdout)
+
+    def test_osr_enters_hot_loops_and_ic_miss_deoptimizes(self):
+        """TEST-ID: tests.bytecode.osr-and-deopt
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: a loop header that trips loop_hot_threshold mid-run continues in compiled code through its BcDeoptPoint, and a call whose receiver misses the inline cache it was speculated from deoptimizes back to the interpreter, which re-learns the cache before the program is recompiled.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        if not host_supports_baseline_jit():
+            self.skipTest("baseline JIT is available only on Linux x86_64")
+
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static bool flip(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)args; (void)argc;
+                *out = bc_value_bool(++*(int *)ud > 5);
+                return true;
+            }
+
+            static bool kind_of(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)argc; (void)ud;
+                *out = bc_value_i64(args[0].kind);
+                return true;
+            }
+
+            /* acc = 0; eight times: loop 1 { acc += 1 }; return acc */
+            static void build_loops(BcProgram *p, bool maps) {
+                BcSourceSpan s = bc_span("osr.mon", 1, 1);
+                bc_emit_const(p, 0, bc_program_add_const(p, bc_value_i64(1)), s);
+                bc_emit_const(p, 1, bc_program_add_const(p, bc_value_i64(0)), s);
+                for (int i = 0; i < 8; i++) {
+                    size_t header = bc_emit(p, (BcInstr){BC_OP_LOOP, 0, 0, 0, 0}, s);
+                    bc_emit_abc(p, BC_OP_ADD, 1, 1, 0, s);
+                    bc_emit(p, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                    if (maps) bc_program_add_deopt_point(p, (uint32_t)header, 0, 2, (uint32_t)i);
+                }
+                bc_emit_return(p, 1, s);
+            }
+
+            static int expect_i64(BcVM *vm, BcProgram *p, long long want) {
+                BcValue result = bc_value_nil();
+                BcError error;
+                if (!bc_vm_run(vm, p, &result, &error)) { fprintf(stderr, "%s\n", error.message); return 1; }
+                return result.kind == BC_VALUE_I64 && result.as.i64 == want ? 0 : 1;
+            }
+
+            int main(void) {
+                BcProgram loops;
+                bc_program_init(&loops, "osr-loops");
+                build_loops(&loops, true);
+                BcVM vm;
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 1000;
+                vm.tier.loop_hot_threshold = 3;
+                if (expect_i64(&vm, &loops, 8) || expect_i64(&vm, &loops, 8)) return 1;
+                printf("osr: entries=%zu at=%zu native=%zu\n", vm.osr_entries, vm.jit.osr_instr, vm.jit_runs);
+                bc_vm_free(&vm);
+
+                BcProgram unmapped;
+                bc_program_init(&unmapped, "osr-unmapped");
+                build_loops(&unmapped, false);
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 1000;
+                vm.tier.loop_hot_threshold = 3;
+                if (expect_i64(&vm, &unmapped, 8) || expect_i64(&vm, &unmapped, 8)) return 2;
+                printf("osr-unmapped: entries=%zu native=%zu\n", vm.osr_entries, vm.jit_runs);
+                bc_vm_free(&vm);
+
+                /* r0 = flip(); r1 = r0 ? nil : 7; return kind_of(r1) */
+                BcProgram poly;
+                bc_program_init(&poly, "deopt-ic");
+                BcSourceSpan s = bc_span("deopt.mon", 1, 1);
+                int flips = 0;
+                uint32_t nf = bc_program_add_native_typed(&poly, "flip", flip, &flips, BC_TYPE_BOOL, 0, 0);
+                uint32_t nk = bc_program_add_native_typed(&poly, "kind-of", kind_of, NULL, BC_TYPE_I64, 1, 1);
+                bc_emit(&poly, (BcInstr){BC_OP_CALL_NATIVE, 0, 0, 0, nf}, s);
+                bc_emit(&poly, (BcInstr){BC_OP_IF, 0, 0, 0, 0}, s);
+                bc_emit(&poly, (BcInstr){BC_OP_NIL, 1, 0, 0, 0}, s);
+                bc_emit(&poly, (BcInstr){BC_OP_ELSE, 0, 0, 0, 0}, s);
+                bc_emit_const(&poly, 1, bc_program_add_const(&poly, bc_value_i64(7)), s);
+                bc_emit(&poly, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                size_t site = bc_emit(&poly, (BcInstr){BC_OP_CALL_NATIVE, 2, 1, 1, nk}, s);
+                bc_emit_return(&poly, 2, s);
+                bc_program_add_inline_cache(&poly, (uint32_t)site);
+                bc_program_add_deopt_point(&poly, (uint32_t)site, 0, 3, 1);
+
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 2;
+                char results[64] = {0};
+                for (int i = 0; i < 9; i++) {
+                    BcValue result = bc_value_nil();
+                    BcError error;
+                    if (!bc_vm_run(&vm, &poly, &result, &error)) { fprintf(stderr, "%s\n", error.message); return 3; }
+                    snprintf(results + strlen(results), sizeof(results) - strlen(results), "%s%lld",
+                             i ? "," : "", (long long)result.as.i64);
+                }
+                printf("deopt: results=%s deopts=%zu misses=%u ic=%s/%u native=%zu flips=%d guards=%zu\n",
+                       results, vm.deopts, poly.inline_caches[0].misses,
+                       bc_ic_state_name(poly.inline_caches[0].state), poly.inline_caches[0].entry_count,
+                       vm.jit_runs, flips, vm.jit.guards);
+                bc_vm_free(&vm);
+
+                bc_program_free(&poly);
+                bc_program_free(&unmapped);
+                bc_program_free(&loops);
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("osr: entries=1 at=11 native=2", result.stdout)
+        self.assertIn("osr-unmapped: entries=0 native=1", result.stdout)
+        self.assertIn("deopt: results=2,2,2,2,2,0,0,0,0 deopts=1 misses=1 ic=polymorphic/2 native=4 flips=9 guards=1",
+                      result.stdout)
+
+    def test_polymorphic_inline_caches_link_variants_and_reload_primed(self):
+        """TEST-ID: tests.bytecode.polymorphic-inline-cache
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: a call site's inline cache goes monomorphic, polymorphic and megamorphic as receiver types arrive; a monomorphic site is patched to call the receiver type's native variant directly, compiled code dispatches over a polymorphic cache, and a program written with bc_write_binary reads back with its caches primed.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            typedef struct { int i64, boolean, generic; } Calls;
+            typedef struct { const int *seq; int at; } Picks;
+
+            static bool pick(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)args; (void)argc;
+                Picks *p = ud;
+                *out = bc_value_i64(p->seq[p->at++]);
+                return true;
+            }
+
+            static bool describe(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)argc;
+                ((Calls *)ud)->generic++;
+                *out = bc_value_i64(100 + args[0].kind);
+                return true;
+            }
+
+            static bool describe_i64(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)args; (void)argc;
+                ((Calls *)ud)->i64++;
+                *out = bc_value_i64(1);
+                return true;
+            }
+
+            static bool describe_bool(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)args; (void)argc;
+                ((Calls *)ud)->boolean++;
+                *out = bc_value_i64(2);
+                return true;
+            }
+
+            static void add_natives(BcProgram *p, Calls *calls, Picks *picks) {
+                bc_program_add_native_typed(p, "pick", pick, picks, BC_TYPE_I64, 0, 0);
+                uint32_t nd = bc_program_add_native_typed(p, "describe", describe, calls, BC_TYPE_I64, 1, 1);
+                bc_program_add_native_variant(p, nd, BC_TYPE_I64, "describe.i64", describe_i64, calls);
+                bc_program_add_native_variant(p, nd, BC_TYPE_BOOL, "describe.bool", describe_bool, calls);
+            }
+
+            /* r0 = pick(); r1 = values[r0]; r2 = describe(r1); return r2 */
+            static void build(BcProgram *p, const BcValue *values, int count) {
+                BcSourceSpan s = bc_span("pic.mon", 1, 1);
+                bc_emit(p, (BcInstr){BC_OP_CALL_NATIVE, 0, 0, 0, 0}, s);
+                for (int j = 0; j + 1 < count; j++) {
+                    bc_emit_const(p, 3, bc_program_add_const(p, bc_value_i64(j)), s);
+                    bc_emit_abc(p, BC_OP_EQ, 4, 0, 3, s);
+                    bc_emit(p, (BcInstr){BC_OP_IF, 4, 0, 0, 0}, s);
+                    bc_emit_const(p, 1, bc_program_add_const(p, values[j]), s);
+                    bc_emit(p, (BcInstr){BC_OP_ELSE, 0, 0, 0, 0}, s);
+                }
+                bc_emit_const(p, 1, bc_program_add_const(p, values[count - 1]), s);
+                for (int j = 0; j + 1 < count; j++) bc_emit(p, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                size_t site = bc_emit(p, (BcInstr){BC_OP_CALL_NATIVE, 2, 1, 1, 1}, s);
+                bc_emit_return(p, 2, s);
+                bc_program_add_inline_cache(p, (uint32_t)site);
+                bc_program_add_deopt_point(p, (uint32_t)site, 0, 5, 0);
+            }
+
+            static int run_all(BcVM *vm, BcProgram *p, int runs, char *out, size_t size) {
+                for (int i = 0; i < runs; i++) {
+                    BcValue result = bc_value_nil();
+                    BcError error;
+                    if (!bc_vm_run(vm, p, &result, &error)) { fprintf(stderr, "%s\n", error.message); return 1; }
+                    snprintf(out + strlen(out), size - strlen(out), "%s%lld", *out ? "," : "", (long long)result.as.i64);
+                }
+                return 0;
+            }
+
+            static void print_ic(const char *label, const BcProgram *p, const BcVM *vm, const Calls *calls) {
+                const BcInlineCache *ic = &p->inline_caches[0];
+                printf("%s: ic=%s/%u misses=%u links=%zu i64=%d bool=%d generic=%d\n", label,
+                       bc_ic_state_name(ic->state), ic->entry_count, ic->misses, vm->ic_links,
+                       calls->i64, calls->boolean, calls->generic);
+            }
+
+            int main(void) {
+                static int ptr_target;
+                BcValue five[5] = {bc_value_i64(7), bc_value_bool(true), bc_value_f64(1.5),
+                                   bc_value_nil(), bc_value_ptr(&ptr_target)};
+                const int seq[] = {0, 0, 0, 1, 2, 3, 4, 0};
+                Calls calls = {0, 0, 0};
+                Picks picks = {seq, 0};
+                char results[128] = {0};
+
+                BcProgram program;
+                bc_program_init(&program, "pic");
+                add_natives(&program, &calls, &picks);
+                build(&program, five, 5);
+                BcVM vm;
+                bc_vm_init(&vm);
+                vm.tier.enable_baseline_jit = false;
+                if (run_all(&vm, &program, 3, results, sizeof(results))) return 1;
+                print_ic("mono", &program, &vm, &calls);
+                if (run_all(&vm, &program, 5, results, sizeof(results))) return 2;
+                printf("results=%s\n", results);
+                print_ic("mega", &program, &vm, &calls);
+                bc_vm_free(&vm);
+                bc_program_free(&program);
+
+                /* Prime a cache, write the program out and read it back. */
+                const int warm_seq[] = {0, 0, 0};
+                Calls warm = {0, 0, 0};
+                Picks warm_picks = {warm_seq, 0};
+                BcProgram written;
+                bc_program_init(&written, "pic-written");
+                add_natives(&written, &warm, &warm_picks);
+                build(&written, five, 5);
+                bc_vm_init(&vm);
+                vm.tier.enable_baseline_jit = false;
+                results[0] = '\0';
+                if (run_all(&vm, &written, 2, results, sizeof(results))) return 3;
+                bc_vm_free(&vm);
+                FILE *bin = tmpfile();
+                BcError error;
+                if (!bin || !bc_write_binary(&written, bin, &error)) return 4;
+                rewind(bin);
+                BcProgram loaded;
+                bc_program_init(&loaded, "pic-loaded");
+                if (!bc_read_binary(bin, &loaded, &error)) { fprintf(stderr, "%s\n", error.message); return 5; }
+                fclose(bin);
+                const BcInlineCache *ic = &loaded.inline_caches[0];
+                int same = loaded.code_count == written.code_count;
+                for (size_t i = 0; same && i < written.code_count; i++) {
+                    BcInstr x = loaded.code[i], y = written.code[i];
+                    same = x.op == y.op && x.a == y.a && x.b == y.b && x.c == y.c && x.imm == y.imm;
+                }
+                printf("loaded: same=%d ic=%s/%u receiver=%s site=%s span=%s:%u\n", same,
+                       bc_ic_state_name(ic->state), ic->entry_count, bc_type_name(ic->entries[0].receiver_type),
+                       ic->callsite == written.inline_caches[0].callsite ? "same" : "moved",
+                       loaded.spans[0].file, loaded.spans[0].line);
+                Calls reloaded = {0, 0, 0};
+                Picks reloaded_picks = {warm_seq, 0};
+                add_natives(&loaded, &reloaded, &reloaded_picks);
+                bc_vm_init(&vm);
+                vm.tier.enable_baseline_jit = false;
+                if (run_all(&vm, &loaded, 1, results, sizeof(results))) return 6;
+                print_ic("reloaded", &loaded, &vm, &reloaded);
+                bc_vm_free(&vm);
+                bc_program_free(&loaded);
+                bc_program_free(&written);
+
+                if (!PIC_JIT) return 0;
+
+                /* Compiled code dispatches over a polymorphic cache. */
+                BcValue three[3] = {bc_value_i64(7), bc_value_bool(false), bc_value_nil()};
+                const int jit_seq[] = {0, 1, 0, 1, 2, 0};
+                Calls jit_calls = {0, 0, 0};
+                Picks jit_picks = {jit_seq, 0};
+                BcProgram poly;
+                bc_program_init(&poly, "pic-jit");
+                add_natives(&poly, &jit_calls, &jit_picks);
+                build(&poly, three, 3);
+                bc_vm_init(&vm);
+                vm.tier.call_hot_threshold = 2;
+                results[0] = '\0';
+                if (run_all(&vm, &poly, 4, results, sizeof(results))) return 7;
+                printf("jit-poly: native=%zu guards=%zu\n", vm.jit_runs, vm.jit.guards);
+                if (run_all(&vm, &poly, 2, results, sizeof(results))) return 8;
+                printf("jit: results=%s native=%zu deopts=%zu misses=%u ic=%s/%u\n", results,
+                       vm.jit_runs, vm.deopts, poly.inline_caches[0].misses,
+                       bc_ic_state_name(poly.inline_caches[0].state), poly.inline_caches[0].entry_count);
+                bc_vm_free(&vm);
+                bc_program_free(&poly);
+                return 0;
+            }
+            '''
+        )
+
+        jit = host_supports_baseline_jit()
+        result = self.compile_and_run(harness, cflags=("-DPIC_JIT=%d" % (1 if jit else 0),))
+
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("mono: ic=monomorphic/1 misses=0 links=1 i64=3 bool=0 generic=0", result.stdout)
+        self.assertIn("results=1,1,1,2,103,100,104,102", result.stdout)
+        self.assertIn("mega: ic=megamorphic/0 misses=4 links=1 i64=3 bool=1 generic=4", result.stdout)
+        self.assertIn("loaded: same=1 ic=monomorphic/1 receiver=I64 site=same span=pic.mon:1", result.stdout)
+        self.assertIn("reloaded: ic=monomorphic/1 misses=0 links=1 i64=1 bool=0 generic=0", result.stdout)
+        if jit:
+            self.assertIn("jit-poly: native=2 guards=1", result.stdout)
+            self.assertIn("jit: results=1,2,1,2,100,1 native=2 deopts=1 misses=2 ic=polymorphic/3", result.stdout)
+
+    def test_program_map_points_into_image_and_pages_in_lazily(self):
+        """TEST-ID: tests.bytecode.program-map
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: bc_program_map runs a bc_write_binary_image file with code, constants and register types pointing into the mapping, primed inline caches read back, debug and deopt sections decoded only on first use, and truncated files rejected; growing a mapped program copies it out of the mapping.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static bool twice(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)argc; (void)ud;
+                *out = bc_value_i64(args[0].as.i64 * 2);
+                return true;
+            }
+
+            static void add_natives(BcProgram *p) {
+                bc_program_add_native_typed(p, "twice", twice, NULL, BC_TYPE_I64, 1, 1);
+            }
+
+            static long long run(BcProgram *p) {
+                BcVM vm;
+                bc_vm_init(&vm);
+                BcValue result = bc_value_nil();
+                BcError error;
+                long long value = bc_vm_run(&vm, p, &result, &error) ? (long long)result.as.i64 : -1;
+                if (value < 0) fprintf(stderr, "%s\n", error.message);
+                bc_vm_free(&vm);
+                return value;
+            }
+
+            int main(void) {
+                BcProgram program;
+                bc_program_init(&program, "image");
+                add_natives(&program);
+                bc_emit_const(&program, 0, bc_program_add_const(&program, bc_value_i64(2)), bc_span("image.mon", 1, 1));
+                bc_emit_const(&program, 1, bc_program_add_const(&program, bc_value_i64(19)), bc_span("image.mon", 2, 1));
+                bc_emit_abc(&program, BC_OP_ADD, 2, 0, 1, bc_span("image.mon", 3, 5));
+                size_t site = bc_emit(&program, (BcInstr){BC_OP_CALL_NATIVE, 3, 2, 1, 0}, bc_span("image.mon", 4, 7));
+                bc_emit_return(&program, 3, bc_span("image.mon", 5, 1));
+                bc_program_add_inline_cache(&program, (uint32_t)site);
+                bc_program_add_deopt_point(&program, (uint32_t)site, 0, 4, 9);
+                if (run(&program) != 42) return 1;
+
+                FILE *out = fopen(IMAGE_PATH, "wb");
+                BcError error;
+                if (!out || !bc_write_binary_image(&program, out, &error)) return 2;
+                fclose(out);
+
+                FILE *in = fopen(IMAGE_PATH, "rb");
+                if (!in || !bc_dump_binary_sections(in, stdout, &error)) return 3;
+                fclose(in);
+
+                BcProgram mapped;
+                bc_program_init(&mapped, "mapped");
+                if (!bc_program_map(&mapped, IMAGE_PATH, &error)) { fprintf(stderr, "%s\n", error.message); return 4; }
+                BcProgramMemoryStats stats = bc_program_memory_stats(&mapped);
+                printf("mapped: code=%zu consts=%zu regs=%zu code_bytes=%zu const_bytes=%zu mapped=%d aligned=%d\n",
+                       mapped.code_count, mapped.const_count, mapped.register_count, stats.code_bytes,
+                       stats.constant_bytes, stats.mapped_bytes > 0,
+                       (size_t)mapped.code % BC_IMAGE_ALIGN == 0 && (size_t)mapped.constants % BC_IMAGE_ALIGN == 0);
+                printf("lazy: deopts=%zu spans=%s ic=%s/%u\n", mapped.deopt_count, mapped.spans ? "decoded" : "pending",
+                       bc_ic_state_name(mapped.inline_caches[0].state), mapped.inline_caches[0].entry_count);
+                add_natives(&mapped);
+                printf("run: %lld misses=%u\n", run(&mapped), mapped.inline_caches[0].misses);
+                if (!bc_program_page_in(&mapped, &error)) return 5;
+                printf("paged: deopts=%zu source=%u span=%s:%u:%u\n", mapped.deopt_count, mapped.deopts[0].source_id,
+                       mapped.spans[site].file, mapped.spans[site].line, mapped.spans[site].column);
+                bc_emit_return(&mapped, 0, bc_span("image.mon", 6, 1));
+                stats = bc_program_memory_stats(&mapped);
+                printf("owned: code=%zu mapped=%zu code_bytes=%d\n", mapped.code_count, stats.mapped_bytes,
+                       stats.code_bytes > 0);
+                bc_program_free(&mapped);
+
+                BcProgram copied;
+                bc_program_init(&copied, "copied");
+                in = fopen(IMAGE_PATH, "rb");
+                if (!in || !bc_read_binary(in, &copied, &error)) { fprintf(stderr, "%s\n", error.message); return 6; }
+                fclose(in);
+                add_natives(&copied);
+                printf("read: %lld deopts=%zu\n", run(&copied), copied.deopt_count);
+                bc_program_free(&copied);
+
+                in = fopen(IMAGE_PATH, "rb");
+                unsigned char bytes[4096];
+                size_t n = fread(bytes, 1, sizeof(bytes), in);
+                fclose(in);
+                out = fopen(IMAGE_PATH, "wb");
+                fwrite(bytes, 1, n / 2, out);
+                fclose(out);
+                BcProgram truncated;
+                bc_program_init(&truncated, "truncated");
+                bool ok = bc_program_map(&truncated, IMAGE_PATH, &error);
+                printf("truncated: ok=%d code=%zu error=%s\n", ok, truncated.code_count, error.message);
+                bc_program_free(&truncated);
+                bc_program_free(&program);
+                return 0;
+            }
+            '''
+        )
+
+        with tempfile.TemporaryDirectory() as td:
+            image = Path(td) / "program.bdc"
+            result = self.compile_and_run(harness, cflags=('-DIMAGE_PATH="%s"' % image,))
+
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("section 7 code-image", result.stdout)
+        self.assertIn("section 8 const-image", result.stdout)
+        self.assertIn("section 9 types-image", result.stdout)
+        self.assertIn("mapped: code=5 consts=2 regs=4 code_bytes=0 const_bytes=0 mapped=1 aligned=1", result.stdout)
+        self.assertIn("lazy: deopts=0 spans=pending ic=monomorphic/1", result.stdout)
+        self.assertIn("run: 42 misses=0", result.stdout)
+        self.assertIn("paged: deopts=1 source=9 span=image.mon:4:7", result.stdout)
+        self.assertIn("owned: code=6 mapped=0 code_bytes=1", result.stdout)
+        self.assertIn("read: 42 deopts=1", result.stdout)
+        self.assertIn("truncated: ok=0 code=0 error=truncated bytecode section payload", result.stdout)
+
     def test_tier_osr_visual_plan_marks_loops_and_safepoints(self):
         """TEST-ID: tests.bytecode.tier-osr-visual-plan
         TEST-CONTEXT: monadc.context.bytecode.core
@@ -977,6 +1544,128 @@ class BytecodeModuleTests(unittest.TestCase):
 
         self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
 
+    def test_optimizer_fuses_superinstructions_forwards_moves_and_coalesces(self):
+        """TEST-ID: tests.bytecode.optimizer-superinstructions
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: the optimizer reads through mov chains and drops the dead movs, fuses const+add/sub into addk/subk and a compare feeding an if into if.lt/if.le, moves deopt safepoints with the instructions they named, and coalesces registers with disjoint live ranges; the result agrees with the original program in the generic and quickened interpreter and in baseline code.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static bool arg(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *out, void *ud) {
+                (void)vm; (void)args; (void)argc;
+                *out = bc_value_i64(*(const long long *)ud);
+                return true;
+            }
+
+            /* x = arg() + 10; y = x; z = y; if z > 20 then z - 1 else { w = z; w * w } */
+            static void build(BcProgram *p, long long *input) {
+                BcSourceSpan s = bc_span("fuse.mon", 1, 1);
+                uint32_t n = bc_program_add_native_typed(p, "arg", arg, input, BC_TYPE_I64, 0, 0);
+                bc_emit(p, (BcInstr){BC_OP_CALL_NATIVE, 0, 0, 0, n}, s);
+                bc_emit_const(p, 1, bc_program_add_const(p, bc_value_i64(10)), s);
+                bc_emit_abc(p, BC_OP_ADD, 2, 0, 1, s);
+                bc_emit_abc(p, BC_OP_MOV, 3, 2, 0, s);
+                bc_emit_abc(p, BC_OP_MOV, 4, 3, 0, s);
+                bc_emit_const(p, 5, bc_program_add_const(p, bc_value_i64(20)), s);
+                bc_emit_abc(p, BC_OP_GT, 6, 4, 5, s);
+                bc_emit(p, (BcInstr){BC_OP_IF, 6, 0, 0, 0}, s);
+                bc_emit_const(p, 7, bc_program_add_const(p, bc_value_i64(1)), s);
+                bc_emit_abc(p, BC_OP_SUB, 10, 4, 7, s);
+                bc_emit(p, (BcInstr){BC_OP_ELSE, 0, 0, 0, 0}, s);
+                bc_emit_abc(p, BC_OP_MOV, 9, 4, 0, s);
+                bc_emit_abc(p, BC_OP_MUL, 10, 9, 9, s);
+                bc_emit(p, (BcInstr){BC_OP_END, 0, 0, 0, 0}, s);
+                bc_emit_return(p, 10, s);
+                bc_program_add_inline_cache(p, 0);
+                bc_program_add_deopt_point(p, 6, 4, 3, 0);
+            }
+
+            static int run(BcProgram *p, bool quicken, unsigned hot, long long *input, long long x, long long want) {
+                BcVM vm;
+                bc_vm_init(&vm);
+                vm.quicken = quicken;
+                vm.tier.call_hot_threshold = hot;
+                *input = x;
+                for (int i = 0; i < 3; i++) {
+                    BcValue result = bc_value_nil();
+                    BcError error;
+                    if (!bc_vm_run(&vm, p, &result, &error)) { fprintf(stderr, "%s\n", error.message); return 1; }
+                    if (result.kind != BC_VALUE_I64 || result.as.i64 != want) {
+                        fprintf(stderr, "arg %lld: kind=%d value=%lld want %lld\n", x, result.kind,
+                                (long long)result.as.i64, want);
+                        return 1;
+                    }
+                }
+                if (hot == 1 && (vm.jit_runs != 2 || vm.jit_rejected)) {
+                    fprintf(stderr, "baseline code: runs=%zu rejected=%d\n", vm.jit_runs, vm.jit_rejected);
+                    return 1;
+                }
+                bc_vm_free(&vm);
+                return 0;
+            }
+
+            static bool has_op(const BcProgram *p, BcOp op) {
+                for (size_t i = 0; i < p->code_count; i++)
+                    if (p->code[i].op == op) return true;
+                return false;
+            }
+
+            int main(void) {
+                long long input = 0;
+                BcProgram program;
+                bc_program_init(&program, "opt-fuse");
+                build(&program, &input);
+
+                BcOptimizeOptions options = bc_optimize_options_default();
+                BcOptimizeReport report;
+                BcError error;
+                if (!bc_optimize_program(&program, &options, &report, &error)) {
+                    fprintf(stderr, "optimize failed: %s\n", error.message);
+                    return 2;
+                }
+                printf("report: instructions=%zu->%zu forwarded=%zu moves=%zu fused=%zu registers=%zu->%zu\n",
+                       report.before_instructions, report.after_instructions, report.moves_forwarded,
+                       report.moves_eliminated, report.superinstructions_fused, report.registers_before,
+                       report.registers_after);
+                if (!has_op(&program, BC_OP_ADDK) || !has_op(&program, BC_OP_SUBK) || !has_op(&program, BC_OP_IF_LT) ||
+                    has_op(&program, BC_OP_GT) || program.register_count != report.registers_after) return 3;
+                printf("deopt: safepoint=%s r%u+%u ic=%s\n",
+                       program.code[program.deopts[0].safepoint].op == BC_OP_IF_LT ? "if.lt" : "moved-wrong",
+                       program.deopts[0].first_register, program.deopts[0].register_count,
+                       program.code[program.inline_caches[0].callsite].op == BC_OP_CALL_NATIVE ? "call" : "lost");
+
+                for (int q = 0; q < 2; q++) {
+                    if (run(&program, q, 1000, &input, 7, 289)) return 4;
+                    if (run(&program, q, 1000, &input, 15, 24)) return 5;
+                }
+            #if FUSE_JIT
+                if (run(&program, true, 1, &input, 7, 289)) return 6;
+                if (run(&program, true, 1, &input, 15, 24)) return 7;
+            #endif
+
+                bc_decompile_monad(&program, stdout);
+                bc_program_free(&program);
+                return 0;
+            }
+            '''
+        )
+
+        jit = host_supports_baseline_jit()
+        result = self.compile_and_run(harness, cflags=("-DFUSE_JIT=%d" % (1 if jit else 0),))
+
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("report: instructions=15->10 forwarded=4 moves=2 fused=3 registers=11->3", result.stdout)
+        self.assertIn("deopt: safepoint=if.lt r1+2 ic=call", result.stdout)
+        self.assertIn("(if (< 20 (+ (arg ...) 10))", result.stdout)
+
     def test_visual_output_is_emacs_location_first_and_colored(self):
         """TEST-ID: tests.bytecode.visual-emacs-color
         TEST-CONTEXT: monadc.context.bytecode.core
@@ -1056,6 +1745,381 @@ class BytecodeModuleTests(unittest.TestCase):
 
         self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
 
+    def test_vm_quickens_typed_arithmetic_and_reverts_on_mixed_kinds(self):
+        """TEST-ID: tests.bytecode.quickening
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: bc_vm_run rewrites generic add/lt into I64/F64 forms in its private code copy (from observed operands or declared register_types), keeps them across runs of an unchanged program, and reverts for good when a quickened op meets other kinds.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        harness = textwrap.dedent(
+            r"""
+            #include "bytecode.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static bool want_float = false;
+
+            static bool native_num(BcVM *vm, const BcValue *args, uint8_t argc, BcValue *result, void *userdata) {
+                (void)vm; (void)args; (void)argc; (void)userdata;
+                *result = want_float ? bc_value_f64(1.5) : bc_value_i64(2);
+                return true;
+            }
+
+            int main(void) {
+                BcProgram program;
+                bc_program_init(&program, "quicken");
+                BcSourceSpan s = bc_span("quicken.mon", 1, 1);
+                uint32_t c40 = bc_program_add_const(&program, bc_value_i64(40));
+                uint32_t num = bc_program_add_native_typed(&program, "num", native_num, NULL, BC_TYPE_I64, 0, 0);
+                bc_emit_const(&program, 0, c40, s);
+                bc_emit(&program, (BcInstr){BC_OP_CALL_NATIVE, 1, 0, 0, num}, s);
+                bc_emit(&program, (BcInstr){BC_OP_CALL_NATIVE, 2, 0, 0, num}, s);
+                bc_emit_abc(&program, BC_OP_ADD, 3, 1, 2, s);
+                bc_emit_abc(&program, BC_OP_LT, 4, 1, 0, s);
+                bc_emit_abc(&program, BC_OP_ADD, 5, 0, 3, s);
+                bc_emit_return(&program, 3, s);
+
+                BcVM vm;
+                BcError error;
+                BcValue result;
+                bc_vm_init(&vm);
+                if (!bc_vm_run(&vm, &program, &result, &error)) return 1;
+                printf("first=%lld quickened=%zu ops=%s,%s,%s\n", (long long)result.as.i64, vm.quickened,
+                       bc_op_name((BcOp)vm.code[3].op), bc_op_name((BcOp)vm.code[4].op),
+                       bc_op_name((BcOp)vm.code[5].op));
+                printf("program=%s generic=%s\n", bc_op_name((BcOp)program.code[3].op),
+                       bc_op_name(bc_op_generic(BC_OP_LT_I64)));
+                if (!bc_vm_run(&vm, &program, &result, &error)) return 2;
+                printf("second=%lld quickened=%zu\n", (long long)result.as.i64, vm.quickened);
+
+                want_float = true;
+                if (!bc_vm_run(&vm, &program, &result, &error)) return 3;
+                printf("float=%g dequickened=%zu op=%s\n", result.as.f64, vm.dequickened,
+                       bc_op_name((BcOp)vm.code[3].op));
+                want_float = false;
+                if (!bc_vm_run(&vm, &program, &result, &error)) return 4;
+                printf("again=%lld op=%s\n", (long long)result.as.i64, bc_op_name((BcOp)vm.code[3].op));
+
+                BcVM plain;
+                bc_vm_init(&plain);
+                plain.quicken = false;
+                if (!bc_vm_run(&plain, &program, &result, &error)) return 5;
+                printf("plain=%lld quickened=%zu\n", (long long)result.as.i64, plain.quickened);
+
+                BcProgram typed;
+                bc_program_init(&typed, "declared");
+                uint32_t f1 = bc_program_add_const(&typed, bc_value_f64(1.25));
+                bc_emit_const(&typed, 0, f1, s);
+                bc_emit_abc(&typed, BC_OP_ADD, 1, 0, 0, s);
+                bc_emit_return(&typed, 1, s);
+                typed.register_types[0] = BC_TYPE_F64;
+                BcVM tvm;
+                bc_vm_init(&tvm);
+                if (!bc_vm_run(&tvm, &typed, &result, &error)) return 6;
+                printf("declared=%g op=%s\n", result.as.f64, bc_op_name((BcOp)tvm.code[1].op));
+
+                BcProgram bad;
+                bc_program_init(&bad, "bad-quick");
+                bc_emit_const(&bad, 0, bc_program_add_const(&bad, bc_value_f64(1.0)), s);
+                bc_emit_abc(&bad, BC_OP_ADD_I64, 1, 0, 0, s);
+                bc_emit_return(&bad, 1, s);
+                printf("verify-quick=%d\n", bc_verify(&bad, &error));
+
+                bc_vm_free(&tvm);
+                bc_vm_free(&plain);
+                bc_vm_free(&vm);
+                bc_program_free(&bad);
+                bc_program_free(&typed);
+                bc_program_free(&program);
+                return 0;
+            }
+            """
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("first=4 quickened=3 ops=bc.add.i64,bc.lt.i64,bc.add.i64", result.stdout)
+        self.assertIn("program=bc.add generic=bc.lt", result.stdout)
+        self.assertIn("second=4 quickened=3", result.stdout)
+        self.assertIn("float=3 dequickened=3 op=bc.add", result.stdout)
+        self.assertIn("again=4 op=bc.add", result.stdout)
+        self.assertIn("plain=4 quickened=0", result.stdout)
+        self.assertIn("declared=2.5 op=bc.add.f64", result.stdout)
+        self.assertIn("verify-quick=0", result.stdout)
+
+    def test_ast_lowering_runs_scalar_monad_and_reports_fallbacks(self):
+        """TEST-ID: tests.bytecode.ast-lowering
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: bc_lower_expr and bc_lower_module turn let, if, and/or, n-ary arithmetic with Float promotion, comparisons, value defines and show into verified bytecode that runs on the VM with codegen's print formats; an inferred Float settles an integer-spelled literal, and forms outside the subset, an unsafe integer divisor, a disagreeing HM type and a shadowed builtin fail with the node's span instead of lowering.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode_lower.h, bytecode_lower.c, bytecode.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "bytecode_lower.h"
+            #include "types.h"
+            #include <stdarg.h>
+            #include <stdio.h>
+            #include <stdlib.h>
+            #include <string.h>
+
+            static int line = 1;
+
+            static AST *node(ASTType type) {
+                AST *a = calloc(1, sizeof(AST));
+                a->type = type;
+                a->line = line;
+                a->column = 1;
+                return a;
+            }
+            static AST *num(const char *spelling) {
+                AST *a = node(AST_NUMBER);
+                a->number = strtod(spelling, NULL);
+                a->literal_str = (char *)spelling;
+                return a;
+            }
+            static AST *sym(const char *name) {
+                AST *a = node(AST_SYMBOL);
+                a->symbol = (char *)name;
+                return a;
+            }
+            static AST *list(size_t n, ...) {
+                AST *a = node(AST_LIST);
+                a->list.items = calloc(n, sizeof(AST *));
+                a->list.count = a->list.capacity = n;
+                va_list ap;
+                va_start(ap, n);
+                for (size_t i = 0; i < n; i++) a->list.items[i] = va_arg(ap, AST *);
+                va_end(ap);
+                return a;
+            }
+            /* (let ((x a) (y b)) body) as the reader desugars it. */
+            static AST *let2(const char *x, AST *a, const char *y, AST *b, AST *body) {
+                AST *lam = node(AST_LAMBDA);
+                lam->lambda.params = calloc(2, sizeof(ASTParam));
+                lam->lambda.params[0].name = (char *)x;
+                lam->lambda.params[1].name = (char *)y;
+                lam->lambda.param_count = 2;
+                lam->lambda.body_exprs = calloc(1, sizeof(AST *));
+                lam->lambda.body_exprs[0] = lam->lambda.body = body;
+                lam->lambda.body_count = 1;
+                return list(3, lam, a, b);
+            }
+            static Type *type_of(TypeKind kind) {
+                Type *t = calloc(1, sizeof(Type));
+                t->kind = kind;
+                return t;
+            }
+
+            static void run(const char *label, const AST *expr, const BcLowerOptions *o) {
+                BcProgram p;
+                BcError e;
+                BcValue v;
+                bc_program_init(&p, label);
+                if (!bc_lower_expr(&p, expr, o, &e)) {
+                    printf("%s: fallback %u:%u %s\n", label, e.span.line, e.span.column, e.message);
+                    bc_program_free(&p);
+                    return;
+                }
+                BcVM vm;
+                bc_vm_init(&vm);
+                if (!bc_vm_run(&vm, &p, &v, &e)) printf("%s: runtime %s\n", label, e.message);
+                else if (v.kind == BC_VALUE_I64) printf("%s: int %lld\n", label, (long long)v.as.i64);
+                else if (v.kind == BC_VALUE_F64) printf("%s: float %.16g\n", label, v.as.f64);
+                else if (v.kind == BC_VALUE_BOOL) printf("%s: bool %s\n", label, v.as.boolean ? "True" : "False");
+                else printf("%s: nil\n", label);
+                bc_vm_free(&vm);
+                bc_program_free(&p);
+            }
+
+            static bool no_plus(const char *name, void *userdata) {
+                (void)userdata;
+                return strcmp(name, "+") != 0;
+            }
+
+            int main(void) {
+                BcLowerOptions o = bc_lower_options_default();
+                o.file = "lower.mon";
+
+                run("let", let2("x", num("6"), "y", num("7"), list(3, sym("*"), sym("x"), sym("y"))), &o);
+                run("promote", list(4, sym("+"), num("1"), num("2.5"), num("3")), &o);
+                run("divide", list(3, sym("/"), num("7"), num("2")), &o);
+                run("logic", list(4, sym("if"),
+                                  list(3, sym("and"), list(3, sym("<"), num("1"), num("2")),
+                                       list(3, sym("or"), sym("False"), sym("True"))),
+                                  num("10"), num("20")), &o);
+                run("ne", list(2, sym("not"), list(3, sym("!="), num("4"), num("4"))), &o);
+
+                AST *two = num("2");
+                two->inferred_type = type_of(TYPE_FLOAT);
+                run("hm-float", list(3, sym("*"), two, num("3")), &o);
+
+                line = 7;
+                run("call", list(2, sym("f"), num("1")), &o);
+                run("div0", list(3, sym("/"), num("1"), num("0")), &o);
+                AST *wrong = list(3, sym("+"), num("1"), num("2"));
+                wrong->inferred_type = type_of(TYPE_BOOL);
+                run("hm-wrong", wrong, &o);
+                BcLowerOptions shadow = o;
+                shadow.is_builtin = no_plus;
+                run("shadowed", list(3, sym("+"), num("1"), num("2")), &shadow);
+                run("string", list(2, sym("show"), node(AST_STRING)), &o);
+
+                /* (define n 5) (show (+ n 1)) (show (> n 3)) (show 0.5) */
+                FILE *out = tmpfile();
+                BcLowerOptions mo = o;
+                mo.out = out;
+                AST *forms[] = {
+                    list(2, sym("module"), sym("Main")),
+                    list(3, sym("define"), sym("n"), num("5")),
+                    list(2, sym("show"), list(3, sym("+"), sym("n"), num("1"))),
+                    list(2, sym("show"), list(3, sym(">"), sym("n"), num("3"))),
+                    list(2, sym("show"), num("0.5")),
+                };
+                BcProgram m;
+                BcError e;
+                BcValue v;
+                BcVM vm;
+                bc_program_init(&m, "module");
+                if (!bc_lower_module(&m, forms, 5, &mo, &e)) { printf("module: %s\n", e.message); return 1; }
+                bc_vm_init(&vm);
+                if (!bc_vm_run(&vm, &m, &v, &e)) { printf("module: %s\n", e.message); return 1; }
+                char buf[128] = {0};
+                rewind(out);
+                size_t got = fread(buf, 1, sizeof(buf) - 1, out);
+                printf("module: %s nil=%d [%.*s]\n", v.kind == BC_VALUE_NIL ? "ok" : "bad", v.kind == BC_VALUE_NIL,
+                       (int)got, buf);
+                bc_vm_free(&vm);
+                bc_program_free(&m);
+
+                AST *fn = node(AST_LAMBDA);
+                AST *defn[] = {list(3, sym("define"), sym("f"), fn)};
+                bc_program_init(&m, "module");
+                if (!bc_lower_module(&m, defn, 1, &mo, &e)) printf("defn: fallback %s\n", e.message);
+                bc_program_free(&m);
+                fclose(out);
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness, sources=("bytecode.c", "bytecode_lower.c"))
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        lines = result.stdout.splitlines()
+        self.assertEqual(lines[:6], [
+            "let: int 42",
+            "promote: float 6.5",
+            "divide: int 3",
+            "logic: int 10",
+            "ne: bool True",
+            "hm-float: float 6",
+        ], result.stdout)
+        self.assertEqual(lines[6], "call: fallback 7:1 `(f ...)` is outside the bytecode subset")
+        self.assertIn("div0: fallback 7:1 integer `/` needs a literal divisor other than 0 and -1", lines)
+        self.assertIn("hm-wrong: fallback 7:1 HM inferred a type this Int value does not have", lines)
+        self.assertIn("shadowed: fallback 7:1 `(+ ...)` is outside the bytecode subset", lines)
+        self.assertIn("string: fallback 7:1 only `show` of one Int, Float or Bool lowers to bytecode", lines)
+        self.assertIn("module: ok nil=1 [6\nTrue\n0.5\n]", result.stdout)
+        self.assertIn("defn: fallback function defines are outside the bytecode subset", lines)
+
+    def test_dispatch_microbenchmark_threaded_and_switch_agree(self):
+        """TEST-ID: tests.bytecode.dispatch-microbenchmark
+        TEST-CONTEXT: monadc.context.bytecode.core
+        TEST-PURPOSE: the threaded and switch dispatch builds of bc_vm_run compute the same result on the dispatch microbenchmark, as does the baseline JIT tier; BYTECODE_BENCH=1 prints their timings side by side.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: bytecode.h, bytecode.c
+        """
+        runs = run_dispatch_benchmark(self, iterations=20)
+        self.assertEqual([r["dispatch"] for r in runs], ["threaded", "switch"])
+        self.assertEqual(len({r["result"] for r in runs}), 1, runs)
+        self.assertEqual(len(set(runs[0]["result"].split(","))), 1, runs)
+
+
+DISPATCH_BENCHMARK = textwrap.dedent(
+    r"""
+    #define _POSIX_C_SOURCE 199309L
+    #include "bytecode.h"
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <time.h>
+
+    /* A long straight-line chain of i64 add/sub/mul/lt, run many times, so
+     * dispatch and operand-kind checks dominate. */
+    static double run(BcProgram *program, bool quicken, bool jit, int iterations, long long *out) {
+        BcVM vm;
+        BcError error;
+        BcValue result = bc_value_nil();
+        bc_vm_init(&vm);
+        vm.quicken = quicken;
+        vm.tier.enable_baseline_jit = jit;
+        vm.tier.call_hot_threshold = 0;
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < iterations; i++)
+            if (!bc_vm_run(&vm, program, &result, &error)) { fprintf(stderr, "%s\n", error.message); exit(1); }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        bc_vm_free(&vm);
+        *out = result.as.i64;
+        double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+        return ns / ((double)iterations * (double)program->code_count);
+    }
+
+    int main(int argc, char **argv) {
+        int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+        BcProgram program;
+        bc_program_init(&program, "dispatch-bench");
+        BcSourceSpan s = bc_span("bench.mon", 1, 1);
+        bc_emit_const(&program, 0, bc_program_add_const(&program, bc_value_i64(1)), s);
+        bc_emit_const(&program, 1, bc_program_add_const(&program, bc_value_i64(3)), s);
+        bc_emit_const(&program, 2, bc_program_add_const(&program, bc_value_i64(0)), s);
+        for (int i = 0; i < 4096; i++) {
+            bc_emit_abc(&program, BC_OP_ADD, 2, 2, 1, s);
+            bc_emit_abc(&program, i % 2 ? BC_OP_SUB : BC_OP_MUL, 2, 2, 0, s);
+            bc_emit_abc(&program, BC_OP_LT, 3, 2, 1, s);
+            bc_emit_abc(&program, BC_OP_MOV, 4, 2, 0, s);
+        }
+        bc_emit_return(&program, 2, s);
+
+        long long generic = 0, quick = 0, native = 0;
+        double g = run(&program, false, false, iterations, &generic);
+        double q = run(&program, true, false, iterations, &quick);
+        double n = run(&program, true, true, iterations, &native);
+        printf("dispatch=%s generic_ns=%.3f quickened_ns=%.3f baseline_ns=%.3f result=%lld,%lld,%lld\n",
+               bc_vm_dispatch_name(), g, q, n, generic, quick, native);
+        bc_program_free(&program);
+        return 0;
+    }
+    """
+)
+
+
+def run_dispatch_benchmark(test, iterations=2000):
+    runs = []
+    for cflags in (("-O2",), ("-O2", "-DBC_SWITCH_DISPATCH")):
+        result = test.compile_and_run(
+            DISPATCH_BENCHMARK.replace("argc > 1 ? atoi(argv[1]) : 2000", f"argc > 1 ? atoi(argv[1]) : {iterations}"),
+            cflags=cflags,
+        )
+        test.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        fields = dict(part.split("=", 1) for part in result.stdout.split())
+        runs.append(fields)
+    return runs
+
+
+def emit_dispatch_benchmark() -> int:
+    runs = run_dispatch_benchmark(BytecodeModuleTests())
+    for r in runs:
+        print(f"  {r['dispatch']:<8}  generic {r['generic_ns']} ns/instr  "
+              f"quickened {r['quickened_ns']} ns/instr  baseline JIT {r['baseline_ns']} ns/instr  "
+              f"result {r['result']}")
+    return 0
+
 
 def emit_visual_bytecode_report() -> int:
     harness = textwrap.dedent(
@@ -1114,6 +2178,8 @@ if __name__ == "__main__":
         rc = emit_visual_bytecode_report()
         if rc != 0:
             raise SystemExit(rc)
+    if os.environ.get("BYTECODE_BENCH") == "1":
+        raise SystemExit(emit_dispatch_benchmark())
 
     import io
 
@@ -0,0 +1,102 @@
+import os
+import subprocess
+import tempfile
+import time
+import unittest
+from pathlib import Path
+
+from monad_binary import generated_executable, resolve_monad_binary
+
+
+ROOT = Path(__file__).resolve().parents[1]
+MONAD = resolve_monad_binary()
+
+SOURCE = """\
+(module Main)
+(define (square [x : Int] -> Int) (* x x))
+(show (square 12))
+"""
+
+
+@unittest.skipIf(os.name == "nt", "the compile server needs Unix sockets")
+class DaemonTests(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory(prefix="monadc-daemon-")
+        self.temp = Path(self.tmp.name)
+        home = self.temp / "home"
+        home.mkdir()
+        self.env = os.environ.copy()
+        self.env["HOME"] = str(home)
+        self.env["MONAD_CORE"] = str(ROOT / "core")
+        self.env["MONAD_DAEMON_SOCKET"] = str(self.temp / "daemon.sock")
+        self.env.pop("MONAD_DAEMON", None)
+
+    def tearDown(self):
+        self.monad("daemon", "stop")
+        self.tmp.cleanup()
+
+    def monad(self, *args, env=None, timeout=120):
+        return subprocess.run(
+            [str(MONAD), *args],
+            cwd=self.temp,
+            env=env or self.env,
+            text=True,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            check=False,
+            timeout=timeout,
+        )
+
+    def compile_and_run(self, name, env):
+        src = self.temp / f"{name}.mon"
+        src.write_text(SOURCE, encoding="utf-8")
+        result = self.monad(str(src), "-o", name, env=env)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        run = subprocess.run(
+            [str(generated_executable(self.temp / name))],
+            cwd=self.temp, text=True, stdout=subprocess.PIPE, check=False, timeout=30,
+        )
+        return run.stdout
+
+    def test_client_falls_back_without_a_server(self):
+        env = dict(self.env, MONAD_DAEMON="1")
+        self.assertEqual(self.compile_and_run("fallback", env), "144\n")
+
+    def test_forwarded_compile_matches_in_process_compile(self):
+        start = self.monad("daemon", "start")
+        self.assertEqual(start.returncode, 0, start.stdout + start.stderr)
+        self.assertIn("started", start.stdout)
+
+        env = dict(self.env, MONAD_DAEMON="1")
+        self.assertEqual(self.compile_and_run("served", env), "144\n")
+        self.assertEqual(self.compile_and_run("local", self.env), "144\n")
+
+        status = self.monad("daemon", "status")
+        self.assertEqual(status.returncode, 0, status.stdout)
+        self.assertIn("1 requests", status.stdout)
+
+    def test_forwarded_compile_reports_errors_and_status(self):
+        self.assertEqual(self.monad("daemon", "start").returncode, 0)
+        bad = self.temp / "bad.mon"
+        bad.write_text("(module Main)\n(show (undefined-name 1))\n", encoding="utf-8")
+        env = dict(self.env, MONAD_DAEMON="1")
+        served = self.monad(str(bad), "-o", "bad", env=env)
+        local = self.monad(str(bad), "-o", "bad", env=self.env)
+        self.assertNotEqual(served.returncode, 0)
+        self.assertEqual(served.returncode, local.returncode)
+        self.assertEqual(served.stdout + served.stderr, local.stdout + local.stderr)
+
+    def test_stop_removes_the_socket(self):
+        self.assertEqual(self.monad("daemon", "start").returncode, 0)
+        self.assertTrue((self.temp / "daemon.sock").exists())
+        self.monad("daemon", "stop")
+        for _ in range(100):
+            if not (self.temp / "daemon.sock").exists():
+                break
+            time.sleep(0.05)
+        self.assertFalse((self.temp / "daemon.sock").exists())
+        self.assertEqual(self.monad("daemon", "status").returncode, 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
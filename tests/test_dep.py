@@ -0,0 +1,189 @@
+import os
+import shlex
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+DEP_SOURCES = (
+    "dep.c",
+    "types.c",
+    "reader.c",
+    "features.c",
+    "pmatch.c",
+    "optimizations.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+    "arena.c",
+)
+
+
+def llvm_config(*args: str) -> list[str]:
+    result = subprocess.run(
+        [os.environ.get("LLVM_CONFIG", "llvm-config"), *args],
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    return shlex.split(result.stdout)
+
+
+class DepTests(unittest.TestCase):
+    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "dep_harness.c"
+            exe = Path(td) / "dep_harness"
+            harness.write_text(source, encoding="utf-8")
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    *llvm_config("--cflags"),
+                    "-iquote",
+                    str(ROOT),
+                    *(str(ROOT / src) for src in DEP_SOURCES),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                    *llvm_config("--ldflags", "--libs", "core"),
+                    *llvm_config("--system-libs"),
+                    "-lm",
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_conversion_memo_and_lazy_unfolding(self):
+        """TEST-ID: tests.dep.conv-memo
+        TEST-CONTEXT: monadc.context.dep.convctx
+        TEST-PURPOSE: dep_conv answers a repeated successful check from the memo without spending fuel, unfolds a global neutral once and keeps the result on it, unfolds the later of two different heads first, forgets stored results when a definition is replaced, and does not reuse a memo entry or glued unfolding after evaluation extends a shared neutral's spine in place.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: dep.h, dep.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "dep.h"
+            #include <stdio.h>
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\\n", #c); return 1; } } while (0)
+
+            static Value *app1(const char *f, Value *arg) {
+                Spine sp = val_spine_empty();
+                val_spine_push(&sp, arg);
+                return val_neutral(f, -1, sp);
+            }
+
+            static void define(DepCtx *ctx, const char *name, Term *body) {
+                dep_env_define(ctx->globals, name, NULL, body,
+                               dep_eval(body, ctx->env, ctx->mctx), false);
+            }
+
+            int main(void) {
+                DepCtx *ctx = dep_ctx_create("<test>");
+
+                /* The same value converts with itself without a walk. */
+                Value *pi = dep_eval(term_pi("x", term_nat(), term_nat(), IMPLICIT_EXPLICIT),
+                                     ctx->env, ctx->mctx);
+                ConvCtx self = conv_ctx_make(ctx, 0);
+                CHECK(dep_conv(&self, pi, pi, NULL));
+                CHECK(self.fuel == DEP_CONV_FUEL - 1);
+
+                /* id := λ(x:Nat). x, compared as `id n` against `n`. */
+                define(ctx, "id", term_lam("x", term_nat(), term_bvar(0)));
+                Value *n    = val_neutral("n", 0, val_spine_empty());
+                Value *call = app1("id", n);
+
+                ConvCtx first = conv_ctx_make(ctx, 1);
+                CHECK(dep_conv(&first, call, n, NULL));
+                CHECK(call->glue == n);
+
+                ConvCtx again = conv_ctx_make(ctx, 1);
+                CHECK(dep_conv(&again, call, n, NULL));
+                CHECK(again.fuel == DEP_CONV_FUEL);
+
+                /* wrap := λ(x:Nat). id x is defined later, so it unfolds
+                 * first and the heads then agree without unfolding id. */
+                define(ctx, "wrap", term_lam("x", term_nat(),
+                                             term_app1(term_fvar("id"), term_bvar(0))));
+                Value *wrap_n = app1("wrap", n);
+                Value *id_n   = app1("id", n);
+                ConvCtx heads = conv_ctx_make(ctx, 1);
+                CHECK(dep_conv(&heads, wrap_n, id_n, NULL));
+                CHECK(wrap_n->glue != NULL);
+                CHECK(id_n->glue == NULL);
+
+                /* Applying a neutral extends its spine in place; the longer
+                 * value must not inherit what the memo or glue said about
+                 * the shorter one. */
+                Value   *f     = val_neutral("f", 0, val_spine_empty());
+                Value   *f_ref = val_neutral("f", 0, val_spine_empty());
+                EvalEnv *fenv  = eval_env_extend(ctx->env, f);
+                ConvCtx  bare  = conv_ctx_make(ctx, 1);
+                CHECK(dep_conv(&bare, f, f_ref, NULL));
+                Value *f0 = dep_eval(term_app1(term_bvar(0), term_zero()), fenv, ctx->mctx);
+                CHECK(f0->spine.count == 1);
+                ConvCtx applied = conv_ctx_make(ctx, 1);
+                CHECK(!dep_conv(&applied, f0, f_ref, NULL));
+
+                Value   *id_fn   = val_neutral("id", -1, val_spine_empty());
+                EvalEnv *idenv   = eval_env_extend(eval_env_extend(ctx->env, n), id_fn);
+                Term    *id_n_tm = term_app1(term_bvar(0), term_bvar(1));
+                Value   *id_once = dep_eval(id_n_tm, idenv, ctx->mctx);
+                ConvCtx  unfold  = conv_ctx_make(ctx, 1);
+                CHECK(dep_conv(&unfold, id_once, n, NULL));
+                CHECK(id_once->glue == n);
+                Value *id_twice = dep_eval(id_n_tm, idenv, ctx->mctx);
+                CHECK(id_twice == id_once && id_twice->glue == NULL);
+                ConvCtx twice = conv_ctx_make(ctx, 1);
+                CHECK(!dep_conv(&twice, id_twice, n, NULL));
+
+                /* Replacing id's body invalidates what the memo stored. */
+                define(ctx, "id", term_lam("x", term_nat(), term_succ(term_bvar(0))));
+                ConvCtx after = conv_ctx_make(ctx, 1);
+                CHECK(!dep_conv(&after, call, n, NULL));
+
+                /* The global table grows instead of chaining. */
+                char name[32];
+                for (int i = 0; i < 5000; i++) {
+                    snprintf(name, sizeof(name), "g%d", i);
+                    dep_env_declare(ctx->globals, name, val_nat());
+                }
+                CHECK(ctx->globals->size >= 4096);
+                for (int i = 0; i < 5000; i++) {
+                    snprintf(name, sizeof(name), "g%d", i);
+                    DepEnvEntry *e = dep_env_lookup(ctx->globals, name);
+                    CHECK(e && strcmp(e->name, name) == 0);
+                }
+                CHECK(dep_env_lookup(ctx->globals, "id") != NULL);
+
+                dep_ctx_free(ctx);
+                printf("ok\\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout, "ok\\n")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,152 @@
+import os
+import shlex
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+ENV_SOURCES = (
+    "env.c",
+    "infer.c",
+    "types.c",
+    "reader.c",
+    "features.c",
+    "pmatch.c",
+    "optimizations.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+    "arena.c",
+)
+
+
+def llvm_config(*args: str) -> list[str]:
+    result = subprocess.run(
+        [os.environ.get("LLVM_CONFIG", "llvm-config"), *args],
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    return shlex.split(result.stdout)
+
+
+class EnvTableTests(unittest.TestCase):
+    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "env_harness.c"
+            exe = Path(td) / "env_harness"
+            harness.write_text(source, encoding="utf-8")
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    *llvm_config("--cflags"),
+                    "-iquote",
+                    str(ROOT),
+                    *(str(ROOT / src) for src in ENV_SOURCES),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                    *llvm_config("--ldflags", "--libs", "core"),
+                    *llvm_config("--system-libs"),
+                    "-lm",
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_open_addressed_scopes_grow_and_delete(self):
+        """TEST-ID: tests.env.open-addressing
+        TEST-CONTEXT: monadc.context.env.table
+        TEST-PURPOSE: a scope grows past its initial slots without moving entries, removal keeps every other probe run reachable, and lookups fall through to the parent.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: env.h, env.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "env.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            /* infer.c traces through dep.c's indentation helpers. */
+            int  g_trace_depth   = 0;
+            bool g_trace_enabled = false;
+            void shared_trace_indent(void) {}
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            int main(void) {
+                Env *root  = env_create();
+                Env *scope = env_create_child(root);
+                char name[32];
+
+                env_insert(root, "outer", NULL, NULL);
+                EnvEntry *outer = env_lookup(root, "outer");
+                CHECK(outer && env_lookup(scope, "outer") == outer);
+
+                EnvEntry *first = NULL;
+                for (int i = 0; i < 500; i++) {
+                    snprintf(name, sizeof(name), "v%d", i);
+                    env_insert(scope, name, NULL, NULL);
+                    if (i == 0) first = env_lookup(scope, "v0");
+                }
+                CHECK(scope->count == 500);
+                CHECK(scope->size >= 512 && (scope->size & (scope->size - 1)) == 0);
+                CHECK(scope->count * 10 <= scope->size * 7);
+                CHECK(env_lookup(scope, "v0") == first);
+
+                for (int i = 0; i < 500; i += 3) {
+                    snprintf(name, sizeof(name), "v%d", i);
+                    env_remove(scope, name);
+                }
+                for (int i = 0; i < 500; i++) {
+                    snprintf(name, sizeof(name), "v%d", i);
+                    EnvEntry *e = env_lookup(scope, name);
+                    CHECK((e != NULL) == (i % 3 != 0));
+                    CHECK(!e || strcmp(e->name, name) == 0);
+                }
+
+                size_t seen = 0;
+                for (size_t i = 0; i < scope->size; i++)
+                    if (scope->slots[i]) seen++;
+                CHECK(seen == scope->count && seen == 333);
+
+                env_insert(scope, "outer", NULL, NULL);
+                CHECK(env_lookup(scope, "outer") != outer);
+                env_remove(scope, "outer");
+                CHECK(env_lookup(scope, "outer") == outer);
+                env_remove(scope, "outer");
+                CHECK(env_lookup(scope, "outer") == NULL);
+                CHECK(env_lookup(scope, "never-inserted") == NULL);
+
+                env_free(scope);
+                env_free(root);
+                printf("ok\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout, "ok\n")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,286 @@
+import os
+import shlex
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+INFER_SOURCES = (
+    "env.c",
+    "infer.c",
+    "types.c",
+    "reader.c",
+    "features.c",
+    "pmatch.c",
+    "optimizations.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+    "arena.c",
+)
+
+
+def llvm_config(*args: str) -> list[str]:
+    result = subprocess.run(
+        [os.environ.get("LLVM_CONFIG", "llvm-config"), *args],
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    return shlex.split(result.stdout)
+
+
+class InferTests(unittest.TestCase):
+    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "infer_harness.c"
+            exe = Path(td) / "infer_harness"
+            harness.write_text(source, encoding="utf-8")
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    *llvm_config("--cflags"),
+                    "-iquote",
+                    str(ROOT),
+                    *(str(ROOT / src) for src in INFER_SOURCES),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                    *llvm_config("--ldflags", "--libs", "core"),
+                    *llvm_config("--system-libs"),
+                    "-lm",
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_generalise_skips_variables_reachable_from_outer_levels(self):
+        """TEST-ID: tests.infer.levels
+        TEST-CONTEXT: monadc.context.infer.generalization-instantiation
+        TEST-PURPOSE: generalise quantifies only variables created inside the let level that unification did not tie to an outer variable, and quantifies those outer variables once their own level is left.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: infer.h, infer.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "infer.h"
+            #include <stdio.h>
+
+            /* infer.c traces through dep.c's indentation helpers. */
+            int  g_trace_depth   = 0;
+            bool g_trace_enabled = false;
+            void shared_trace_indent(void) {}
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            int main(void) {
+                InferEnv *env = infer_env_create();
+                InferCtx *ctx = infer_ctx_create(env, NULL, "<test>");
+                Substitution *s = ctx->subst;
+
+                /* `a` plays an outer lambda parameter. */
+                Type *a = infer_fresh(ctx);
+
+                infer_enter_level(ctx);
+                Type *b = infer_fresh(ctx);
+                Type *c = infer_fresh(ctx);
+                Type *d = infer_fresh(ctx);
+                CHECK(infer_unify_one(ctx, b, type_arrow(a, c), 0, 0));
+                CHECK(infer_unify_one(ctx, d, a, 0, 0));
+
+                /* b := a -> c; d is now an alias of a. */
+                TypeScheme *sc = infer_generalise(ctx, type_arrow(b, d), env);
+                CHECK(sc->quantified_count == 1);
+                CHECK(sc->quantified[0] == subst_find(s, c->var_id));
+                infer_leave_level(ctx);
+
+                int fv[8], n = 0;
+                infer_free_vars_type(s, type_arrow(d, type_arrow(a, c)), fv, &n, 8);
+                CHECK(n == 2);
+
+                TypeScheme *top = infer_generalise(ctx, type_arrow(a, d), env);
+                CHECK(top->quantified_count == 1);
+                CHECK(top->quantified[0] == subst_find(s, a->var_id));
+
+                scheme_free(sc);
+                scheme_free(top);
+                infer_ctx_free(ctx);
+                infer_env_free(env);
+                printf("ok\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout, "ok\n")
+
+    def test_definition_graph_orders_components_by_dependency(self):
+        """TEST-ID: tests.infer.def-graph
+        TEST-CONTEXT: monadc.context.infer.top-level-pipeline
+        TEST-PURPOSE: the definition graph puts forward-referenced definitions first, keeps mutually recursive definitions together in source order, and handles a long chain without recursion.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: infer.h, infer.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "infer.h"
+            #include <stdio.h>
+            #include <stdlib.h>
+
+            int  g_trace_depth   = 0;
+            bool g_trace_enabled = false;
+            void shared_trace_indent(void) {}
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            /* (lambda () (callees...)) */
+            static AST *body(const char *a, const char *b) {
+                AST *call = ast_new_list();
+                ast_list_append(call, ast_new_symbol("+"));
+                if (a) ast_list_append(call, ast_new_symbol(a));
+                if (b) ast_list_append(call, ast_new_symbol(b));
+                AST **exprs = malloc(sizeof(AST *));
+                exprs[0] = call;
+                return ast_new_lambda(NULL, 0, NULL, NULL, NULL, false, call, exprs, 1);
+            }
+
+            int main(void) {
+                const char *names[] = { "a", "b", "c", "d", "e" };
+                AST *bodies[] = {
+                    body("b", NULL),      /* a -> b, defined later */
+                    body(NULL, NULL),
+                    body("d", NULL),      /* c <-> d */
+                    body("c", "b"),
+                    body("c", "e"),       /* e -> c, and itself */
+                };
+                InferDefGraph g;
+                infer_def_graph_build(&g, names, bodies, 5);
+                int want[] = { 1, 0, 2, 3, 4 };
+                for (int i = 0; i < 5; i++) CHECK(g.order[i] == want[i]);
+                CHECK(g.scc_count == 4);
+                CHECK(g.scc[2] == g.scc[3] && g.scc[1] < g.scc[0] && g.scc[0] < g.scc[2]);
+                CHECK(g.scc[4] == 3);
+                infer_def_graph_free(&g);
+
+                enum { N = 100000 };
+                const char **chain = malloc(sizeof(char *) * N);
+                AST **chain_bodies = malloc(sizeof(AST *) * N);
+                for (int i = 0; i < N; i++) {
+                    char *name = malloc(16), *next = malloc(16);
+                    snprintf(name, 16, "f%d", i);
+                    snprintf(next, 16, "f%d", i + 1);
+                    chain[i] = name;
+                    chain_bodies[i] = body(i + 1 < N ? next : NULL, NULL);
+                }
+                infer_def_graph_build(&g, chain, chain_bodies, N);
+                CHECK(g.scc_count == N);
+                for (int i = 0; i < N; i++) CHECK(g.order[i] == N - 1 - i);
+                infer_def_graph_free(&g);
+
+                printf("ok\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout, "ok\n")
+
+    def test_define_cache_reuses_schemes_until_a_dependency_changes(self):
+        """TEST-ID: tests.infer.define-cache
+        TEST-CONTEXT: monadc.context.infer.top-level-pipeline
+        TEST-PURPOSE: inferring the same define again reuses its scheme and node types, and a new scheme for a name it mentions forces a fresh inference.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: env.c, infer.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "env.h"
+            #include "infer.h"
+            #include <stdio.h>
+            #include <stdlib.h>
+
+            int  g_trace_depth   = 0;
+            bool g_trace_enabled = false;
+            void shared_trace_indent(void) {}
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            /* (lambda (x) (callee x)) */
+            static AST *call_with_x(const char *callee) {
+                ASTParam *params = calloc(1, sizeof(ASTParam));
+                params[0].name = "x";
+                AST *call = ast_new_list();
+                ast_list_append(call, ast_new_symbol(callee));
+                ast_list_append(call, ast_new_symbol("x"));
+                AST **exprs = malloc(sizeof(AST *));
+                exprs[0] = call;
+                return ast_new_lambda(params, 1, NULL, NULL, NULL, false, call, exprs, 1);
+            }
+
+            static Type *ret_of(TypeScheme *sc) {
+                Type *t = sc->type;
+                while (t && t->kind == TYPE_ARROW) t = t->arrow_ret;
+                return t;
+            }
+
+            int main(void) {
+                Env *root = env_create();
+                env_init_infer(root);
+                InferEnv *ienv = env_get_infer(root);
+
+                infer_env_insert(ienv, "g", scheme_mono(type_arrow(type_int(), type_int())));
+                AST *f = call_with_x("g");
+
+                TypeScheme *first = env_hm_infer_define(root, "f", f, "<test>");
+                CHECK(first && ret_of(first)->kind == TYPE_INT);
+                Type *annot = f->inferred_type;
+                CHECK(annot != NULL);
+
+                TypeScheme *again = env_hm_infer_define(root, "f", f, "<test>");
+                CHECK(again && ret_of(again)->kind == TYPE_INT);
+                CHECK(f->inferred_type == annot);
+
+                infer_env_insert(ienv, "g", scheme_mono(type_arrow(type_int(), type_bool())));
+                TypeScheme *changed = env_hm_infer_define(root, "f", f, "<test>");
+                CHECK(changed && f->inferred_type != annot);
+
+                AST *reread = call_with_x("g");
+                env_hm_infer_define(root, "f", reread, "<test>");
+                CHECK(reread->inferred_type != NULL);
+
+                printf("ok\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout, "ok\n")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,103 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+
+class InternTests(unittest.TestCase):
+    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "intern_harness.c"
+            exe = Path(td) / "intern_harness"
+            harness.write_text(source, encoding="utf-8")
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    "-Wall",
+                    "-Wextra",
+                    "-iquote",
+                    str(ROOT),
+                    str(ROOT / "intern.c"),
+                    str(ROOT / "arena.c"),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_interned_names_are_canonical_pointers(self):
+        """TEST-ID: tests.intern.canonical-pointers
+        TEST-CONTEXT: monadc.context.env.interned-keys
+        TEST-PURPOSE: equal names intern to one stable pointer, lookups never insert, and growth keeps earlier pointers and hashes valid.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: intern.h, intern.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "intern.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            int main(void) {
+                char buf[32];
+                CHECK(intern_find("map") == NULL);
+                CHECK(intern_count() == 0);
+
+                const char *map = intern("map");
+                strcpy(buf, "map");
+                CHECK(intern(buf) == map);
+                CHECK(intern_find(buf) == map);
+                CHECK(intern_n("mapping", 3) == map);
+                CHECK(intern("map") != buf);
+                CHECK(strcmp(map, "map") == 0);
+                CHECK(intern_find("filter") == NULL);
+                CHECK(intern_count() == 1);
+                CHECK(intern(NULL) == NULL && intern_find(NULL) == NULL);
+                CHECK(intern("") != NULL && intern("") == intern_n("x", 0));
+
+                uint32_t h = intern_hash(map);
+                const char *first = NULL;
+                for (int i = 0; i < 20000; i++) {
+                    snprintf(buf, sizeof(buf), "sym%d", i);
+                    const char *s = intern(buf);
+                    if (i == 0) first = s;
+                    CHECK(intern_find(buf) == s);
+                }
+                CHECK(intern_count() == 20002);
+                CHECK(intern_find("map") == map && intern_hash(map) == h);
+                CHECK(intern("sym0") == first);
+                CHECK(intern_find("sym20000") == NULL);
+                puts("ok");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(result.stdout.strip(), "ok")
+
+
+if __name__ == "__main__":
+    unittest.main()
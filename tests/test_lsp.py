@@ -0,0 +1,370 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+PRELUDE = r'''
+#include "lsp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+LspMessage *lsp_message_parse(const char *json, size_t len);
+LspConfig   lsp_default_config(void);
+
+static LspServer *S;
+
+static void handle(const char *json) {
+    LspMessage *m = lsp_message_parse(json, strlen(json));
+    lsp_server_handle(S, m);
+    lsp_message_free(m);
+}
+
+static void change(int version, const char *changes) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf),
+             "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\","
+             "\"params\":{\"textDocument\":{\"uri\":\"file:///t.mon\","
+             "\"version\":%d},\"contentChanges\":[%s]}}", version, changes);
+    handle(buf);
+}
+
+static LspDocument *doc(void) {
+    return lsp_workspace_get_doc(S->workspace, "file:///t.mon");
+}
+'''
+
+
+class IncrementalSyncTests(unittest.TestCase):
+    def run_harness(self, body: str) -> list:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "lsp_harness.c"
+            exe = Path(td) / "lsp_harness"
+            harness.write_text(PRELUDE + textwrap.dedent(body), encoding="utf-8")
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-Wall", "-iquote", str(ROOT),
+                 str(ROOT / "lsp.c"), str(harness), "-o", str(exe), "-lpthread"],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            result = subprocess.run(
+                [str(exe), td],
+                check=False,
+                cwd=ROOT,
+                stdin=subprocess.DEVNULL,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                timeout=60,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+            return result.stdout.splitlines()
+
+    def test_ranged_changes_splice_and_rescan_touched_forms(self):
+        """TEST-ID: tests.lsp.incremental-sync
+        TEST-CONTEXT: monadc.context.lsp.structures
+        TEST-PURPOSE: ranged didChange entries apply in order against the rope with UTF-16 columns, an edit inside one top-level form rescans only that form, an unclosed bracket swallows the forms after it, and a change without a range replaces the text.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: lsp.h, lsp.c
+        """
+        lines = self.run_harness(
+            r'''
+            int main(void) {
+                LspConfig cfg = lsp_default_config();
+                cfg.check_on_change = false;
+                cfg.log_level       = 0;
+                S = lsp_server_create(cfg);
+                S->transport->out = tmpfile();
+                handle("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+                handle("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":"
+                       "{\"textDocument\":{\"uri\":\"file:///t.mon\",\"version\":1,\"text\":"
+                       "\"(define (f x)\\n  (+ x 1))\\n\\n(define y 2)\\n(define (g)\\n  (f y))\\n\"}}}");
+                lsp_server_wait_idle(S);
+                printf("open forms=%zu\n", doc()->form_count);
+
+                change(2, "{\"range\":{\"start\":{\"line\":1,\"character\":7},"
+                          "\"end\":{\"line\":1,\"character\":8}},\"rangeLength\":1,\"text\":\"10\"},"
+                          "{\"range\":{\"start\":{\"line\":3,\"character\":0},"
+                          "\"end\":{\"line\":3,\"character\":0}},\"text\":\"; (note\\n\"}");
+                LspDocument *d = doc();
+                printf("v2 text=%d forms=%zu rescanned=%zu version=%d\n",
+                       strcmp(d->source, "(define (f x)\n  (+ x 10))\n\n; (note\n"
+                                         "(define y 2)\n(define (g)\n  (f y))\n") == 0,
+                       d->form_count, d->forms_rescanned, d->version);
+
+                change(3, "{\"range\":{\"start\":{\"line\":6,\"character\":5},"
+                          "\"end\":{\"line\":6,\"character\":6}},\"text\":\"y y\"}");
+                d = doc();
+                printf("v3 forms=%zu rescanned=%zu g=%.*s\n", d->form_count,
+                       d->forms_rescanned,
+                       (int)(d->forms[2].end - d->forms[2].start),
+                       d->source + d->forms[2].start);
+
+                change(4, "{\"text\":\"(define s \\\"\xc3\xa9\xf0\x9f\x98\x80\\\") (x)\\n\"}");
+                change(5, "{\"range\":{\"start\":{\"line\":0,\"character\":15},"
+                          "\"end\":{\"line\":0,\"character\":15}},\"text\":\"!\"}");
+                d = doc();
+                printf("utf16 ok=%d forms=%zu\n",
+                       strcmp(d->source, "(define s \"\xc3\xa9\xf0\x9f\x98\x80\"!) (x)\n") == 0,
+                       d->form_count);
+
+                change(6, "{\"range\":{\"start\":{\"line\":0,\"character\":0},"
+                          "\"end\":{\"line\":0,\"character\":0}},\"text\":\"(\"}");
+                printf("unclosed forms=%zu\n", doc()->form_count);
+                lsp_server_free(S);
+                return 0;
+            }
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "open forms=3",
+                "v2 text=1 forms=3 rescanned=2 version=2",
+                "v3 forms=3 rescanned=1 g=(define (g)",
+                "  (f y y))",
+                "utf16 ok=1 forms=2",
+                "unclosed forms=1",
+            ],
+        )
+
+    def test_changes_are_debounced_onto_the_analysis_thread(self):
+        """TEST-ID: tests.lsp.debounced-analysis
+        TEST-CONTEXT: monadc.context.lsp.architecture
+        TEST-PURPOSE: didChange returns without analyzing, a burst of changes is analyzed once on the background thread at the final version, and multi-line top-level forms come back as folding ranges.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: lsp.h, lsp.c
+        """
+        lines = self.run_harness(
+            r'''
+            static int count(FILE *f, const char *needle) {
+                fflush(f);
+                long len = ftell(f);
+                char *buf = calloc(1, (size_t)len + 1);
+                rewind(f);
+                fread(buf, 1, (size_t)len, f);
+                int n = 0;
+                for (char *p = buf; (p = strstr(p, needle)); p++) n++;
+                free(buf);
+                fseek(f, 0, SEEK_END);
+                return n;
+            }
+
+            int main(void) {
+                LspConfig cfg = lsp_default_config();
+                cfg.debounce_ms = 100;
+                cfg.log_level   = 0;
+                S = lsp_server_create(cfg);
+                FILE *out = tmpfile();
+                S->transport->out = out;
+                handle("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{}}");
+                handle("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":"
+                       "{\"textDocument\":{\"uri\":\"file:///t.mon\",\"version\":1,\"text\":"
+                       "\"(define (f x)\\n  x)\\n(define y 2)\\n\"}}}");
+                lsp_server_wait_idle(S);
+
+                for (int v = 2; v <= 6; v++)
+                    change(v, "{\"range\":{\"start\":{\"line\":2,\"character\":11},"
+                              "\"end\":{\"line\":2,\"character\":11}},\"text\":\"0\"}");
+                int during = count(out, "publishDiagnostics");
+                lsp_server_wait_idle(S);
+                printf("published during=%d v1=%d v2=%d v5=%d v6=%d\n", during,
+                       count(out, "\"version\":1"), count(out, "\"version\":2"),
+                       count(out, "\"version\":5"), count(out, "\"version\":6"));
+
+                size_t nfold;
+                LspFoldRange *folds = lsp_folding_ranges(doc(), &nfold);
+                printf("folds=%zu first=%u-%u y=%s\n", nfold,
+                       nfold ? folds[0].start_line : 0, nfold ? folds[0].end_line : 0,
+                       strstr(doc()->source, "(define y 200000)") ? "ok" : doc()->source);
+                lsp_fold_range_list_free(folds, nfold);
+                lsp_server_free(S);
+                return 0;
+            }
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "published during=1 v1=1 v2=0 v5=0 v6=1",
+                "folds=1 first=0-1 y=ok",
+            ],
+        )
+
+
+    def test_workspace_index_persists_and_refreshes_by_hash(self):
+        """TEST-ID: tests.lsp.persistent-index
+        TEST-CONTEXT: monadc.context.lsp.structures
+        TEST-PURPOSE: definitions, doc comments and references scanned from the workspace are written to a mapped index file that a new server answers from before its refresh, a refresh rescans only files whose content hash changed, an open buffer shadows its file's on-disk record until closed, and a corrupt index file is rejected and rebuilt.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: lsp.h, lsp.c
+        """
+        lines = self.run_harness(
+            r'''
+            #include <sys/stat.h>
+            #include <unistd.h>
+            #include <utime.h>
+
+            static char root[256], uri_a[300], uri_b[300];
+
+            static void put(const char *name, const char *text) {
+                char path[300];
+                snprintf(path, sizeof(path), "%s/%s", root, name);
+                FILE *f = fopen(path, "w");
+                fputs(text, f);
+                fclose(f);
+            }
+
+            static void start(void) {
+                LspConfig cfg = lsp_default_config();
+                cfg.log_level = 0;
+                S = lsp_server_create(cfg);
+                S->transport->out = tmpfile();
+                char buf[512];
+                snprintf(buf, sizeof(buf), "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\","
+                         "\"params\":{\"rootUri\":\"file://%s\"}}", root);
+                handle(buf);
+            }
+
+            static void show(const char *name) {
+                LspIndexEntry *e = lsp_index_lookup(S->workspace->index, name);
+                size_t n = 0;
+                LspLocation *refs = lsp_index_references(S->workspace->index, name, &n);
+                if (!e) { printf("%s: none refs=%zu\n", name, n); }
+                else printf("%s: %s kind=%d sig=%s doc=%s module=%s line=%u-%u refs=%zu\n", name,
+                       strcmp(e->uri, uri_a) == 0 ? "a" : strcmp(e->uri, uri_b) == 0 ? "b" : e->uri,
+                       e->kind, e->type_sig ? e->type_sig : "-",
+                       e->documentation ? e->documentation : "-", e->module ? e->module : "-",
+                       e->range.start.line, e->range.end.line, n);
+                for (size_t i = 0; i < n; i++) free(refs[i].uri);
+                free(refs);
+            }
+
+            static void fuzzy(const char *q) {
+                size_t n = 0;
+                LspIndexEntry **r = lsp_index_fuzzy(S->workspace->index, q, &n);
+                printf("fuzzy %s:", q);
+                for (size_t i = 0; i < n; i++) printf(" %s", r[i]->name);
+                printf("\n");
+                free(r);
+            }
+
+            int main(int argc, char **argv) {
+                const char *base = argc > 1 ? argv[1] : ".";
+                snprintf(root, sizeof(root), "%s/ws", base);
+                mkdir(root, 0755);
+                char cache[300];
+                snprintf(cache, sizeof(cache), "%s/cache", base);
+                setenv("MONAD_CACHE_DIR", cache, 1);
+                snprintf(uri_a, sizeof(uri_a), "file://%s/a.mon", root);
+                snprintf(uri_b, sizeof(uri_b), "file://%s/lib/b.mon", root);
+
+                put("a.mon", "module Math\n  [factorial]\n\n;; n!\n;; for small n\n"
+                             "define factorial :: Int -> Int\n  n | n <= 1    -> 1\n"
+                             "    | otherwise -> n * (factorial (n - 1))\n\n"
+                             "define [tau :: Float] 6.28\n");
+                char lib[300];
+                snprintf(lib, sizeof(lib), "%s/lib", root);
+                mkdir(lib, 0755);
+                put("lib/b.mon", "(define (fact-sum n)\n  (+ (factorial n) tau))\n"
+                                 "(data Shape Circle Int | Pt)\n; \"(factorial\"\n");
+
+                start();
+                lsp_server_wait_idle(S);
+                show("factorial"); show("tau"); show("fact-sum"); show("Shape");
+                fuzzy("fct"); fuzzy("act");
+                lsp_server_free(S);
+
+                start();
+                show("factorial");
+                lsp_server_wait_idle(S);
+                printf("unchanged rescanned=%d\n", lsp_workspace_refresh_index(S->workspace));
+                struct utimbuf tb = { 1000000000, 1000000000 };
+                char path[300];
+                snprintf(path, sizeof(path), "%s/a.mon", root);
+                utime(path, &tb);
+                printf("touched rescanned=%d\n", lsp_workspace_refresh_index(S->workspace));
+                put("lib/b.mon", "(define (fact-sum n)\n  (+ (factorial n) tau))\n"
+                                 "(define (twice n) (* 2 (factorial n)))\n");
+                printf("edited rescanned=%d\n", lsp_workspace_refresh_index(S->workspace));
+                show("factorial"); show("twice"); show("Shape");
+
+                char open_msg[1024];
+                snprintf(open_msg, sizeof(open_msg),
+                         "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":"
+                         "{\"textDocument\":{\"uri\":\"%s\",\"version\":1,\"text\":"
+                         "\"(define (fact n) n)\\n\"}}}", uri_a);
+                handle(open_msg);
+                lsp_server_wait_idle(S);
+                show("fact"); show("factorial");
+                snprintf(open_msg, sizeof(open_msg),
+                         "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didClose\",\"params\":"
+                         "{\"textDocument\":{\"uri\":\"%s\"}}}", uri_a);
+                handle(open_msg);
+                show("fact"); show("factorial");
+
+                char idx_path[4200];
+                snprintf(idx_path, sizeof(idx_path), "%s", S->workspace->index_path);
+                lsp_server_free(S);
+                FILE *f = fopen(idx_path, "r+b");
+                fseek(f, 8, SEEK_SET);
+                fputc(99, f);
+                fclose(f);
+                LspIndex *probe = lsp_index_create();
+                printf("corrupt open=%d\n", lsp_index_open(probe, idx_path));
+                lsp_index_free(probe);
+
+                start();
+                lsp_server_wait_idle(S);
+                show("factorial");
+                lsp_server_free(S);
+                return 0;
+            }
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "factorial: a kind=12 sig=Int -> Int doc=n!",
+                "for small n module=Math line=5-7 refs=3",
+                "tau: a kind=13 sig=Float doc=- module=Math line=9-9 refs=1",
+                "fact-sum: b kind=12 sig=- doc=- module=- line=0-1 refs=0",
+                "Shape: b kind=10 sig=- doc=- module=- line=2-2 refs=0",
+                "fuzzy fct: fact-sum factorial",
+                "fuzzy act: fact-sum factorial",
+                "factorial: a kind=12 sig=Int -> Int doc=n!",
+                "for small n module=Math line=5-7 refs=3",
+                "unchanged rescanned=0",
+                "touched rescanned=0",
+                "edited rescanned=1",
+                "factorial: a kind=12 sig=Int -> Int doc=n!",
+                "for small n module=Math line=5-7 refs=4",
+                "twice: b kind=12 sig=- doc=- module=- line=2-2 refs=0",
+                "Shape: none refs=0",
+                "fact: a kind=12 sig=- doc=- module=- line=0-0 refs=0",
+                "factorial: none refs=2",
+                "fact: none refs=0",
+                "factorial: a kind=12 sig=Int -> Int doc=n!",
+                "for small n module=Math line=5-7 refs=4",
+                "corrupt open=0",
+                "factorial: a kind=12 sig=Int -> Int doc=n!",
+                "for small n module=Math line=5-7 refs=4",
+            ],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,131 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+SOURCES = [
+    "macro.c",
+    "reader.c",
+    "arena.c",
+    "features.c",
+    "pmatch.c",
+    "optimizations.c",
+    "types.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+]
+
+PRELUDE = r'''
+#include "macro.h"
+#include "reader.h"
+#include <stdio.h>
+
+static void expand_and_print(const char *src) {
+    parser_set_context("macro_harness.mon", src);
+    ASTList l = parse_all(src);
+    l = macro_expand_all(l.exprs, l.count);
+    for (size_t i = 0; i < l.count; i++) {
+        ast_print(l.exprs[i]);
+        printf("\n");
+    }
+}
+'''
+
+
+class MacroExpansionTests(unittest.TestCase):
+    def compile_and_run(self, body: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "macro_harness.c"
+            exe = Path(td) / "macro_harness"
+            harness.write_text(PRELUDE + textwrap.dedent(body), encoding="utf-8")
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-iquote", str(ROOT)]
+                + [str(ROOT / s) for s in SOURCES]
+                + [str(harness), "-o", str(exe), "-lm"],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                timeout=60,
+            )
+
+    def test_nested_and_repeated_calls_expand_in_one_walk(self):
+        """TEST-ID: tests.macro.local-fixpoint
+        TEST-CONTEXT: monadc.context.macro.fixpoint
+        TEST-PURPOSE: macros expanding into macro calls resolve in place, repeated pure calls expand identically through the cache, and hygienic calls still draw fresh names per site.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: macro.c, macro.h
+        """
+        result = self.compile_and_run(
+            r'''
+            int main(void) {
+                expand_and_print(
+                    "(define (when [test] . body -> Syntax) (if test (begin . body) (begin)))\n"
+                    "(define (two -> Syntax) (+ 1 1))\n"
+                    "(define (twice [flag] -> Syntax) (when flag (two) (two)))\n"
+                    "(define (swap! [left] [right] -> Syntax)"
+                    " (let [tmp left] (set! left right) (set! right tmp)))\n"
+                    "(twice ok)\n(twice ok)\n(two)\n(two)\n(two)\n"
+                    "(swap! p q)\n(swap! p q)\n");
+                return 0;
+            }
+            '''
+        )
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(
+            result.stdout.splitlines(),
+            [
+                "(if ok (begin (+ 1 1) (+ 1 1)) (begin))",
+                "(if ok (begin (+ 1 1) (+ 1 1)) (begin))",
+                "(+ 1 1)",
+                "(+ 1 1)",
+                "(+ 1 1)",
+                "((lambda ([swap!__tmp__0]) (set! p q) (set! q swap!__tmp__0)) p)",
+                "((lambda ([swap!__tmp__1]) (set! p q) (set! q swap!__tmp__1)) p)",
+            ],
+        )
+        self.assertEqual(result.stderr.count("[macro] expanded 'two'"), 7)
+
+    def test_self_expanding_macro_is_reported(self):
+        """TEST-ID: tests.macro.recursive-depth-limit
+        TEST-CONTEXT: monadc.context.macro.fixpoint
+        TEST-PURPOSE: a macro that keeps expanding into itself stops at the nesting limit with a recursive-macro error instead of overflowing the stack.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: macro.c
+        """
+        result = self.compile_and_run(
+            r'''
+            int main(void) {
+                expand_and_print(
+                    "(define (forever [x] -> Syntax) (list (forever x)))\n"
+                    "(forever 1)\n");
+                puts("unreachable");
+                return 0;
+            }
+            '''
+        )
+        self.assertEqual(result.returncode, 1, result.stdout + result.stderr[-400:])
+        self.assertNotIn("unreachable", result.stdout)
+        self.assertIn("recursive macro detected", result.stderr)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,213 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+HARNESS = textwrap.dedent(
+    r'''
+    #include "module.h"
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+
+    static char *slurp(const char *path) {
+        FILE *f = fopen(path, "rb");
+        if (!f) { perror(path); exit(2); }
+        fseek(f, 0, SEEK_END);
+        long n = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char *buf = malloc((size_t)n + 1);
+        buf[fread(buf, 1, (size_t)n, f)] = '\0';
+        fclose(f);
+        return buf;
+    }
+
+    int main(int argc, char **argv) {
+        if (argc == 2 && argv[1][0] == '=') {
+            char hex[MODULE_HASH_HEX_LEN + 1];
+            module_hash_buffer(argv[1] + 1, strlen(argv[1] + 1), hex);
+            puts(hex);
+            return 0;
+        }
+        for (int a = 1; a < argc; a++) {
+            char *source = slurp(argv[a]);
+            ModuleHeader h;
+            bool any = module_scan_header(source, &h);
+            printf("any %d\nmodule %s\n", any, h.module_name ? h.module_name : "-");
+            for (size_t i = 0; i < h.import_count; i++)
+                printf("import %s %s\n", h.imports[i].module_name,
+                       h.imports[i].layout ? "layout" : "paren");
+            printf("rest %.12s\n", source + h.end);
+            module_header_free(&h);
+            free(source);
+        }
+        return 0;
+    }
+    '''
+)
+
+
+class ModuleHeaderTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.tmp = tempfile.TemporaryDirectory()
+        harness = Path(cls.tmp.name) / "header_harness.c"
+        cls.exe = Path(cls.tmp.name) / "header_harness"
+        harness.write_text(HARNESS, encoding="utf-8")
+        subprocess.run(
+            [
+                "gcc",
+                "-std=gnu11",
+                "-O2",
+                "-Wall",
+                "-iquote",
+                str(ROOT),
+                str(ROOT / "module.c"),
+                str(ROOT / "scan.c"),
+                str(harness),
+                "-o",
+                str(cls.exe),
+            ],
+            check=True,
+            cwd=ROOT,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            text=True,
+        )
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.tmp.cleanup()
+
+    def scan(self, source: str) -> list[str]:
+        path = Path(self.tmp.name) / "input.mon"
+        path.write_text(textwrap.dedent(source).lstrip("\n"), encoding="utf-8")
+        result = subprocess.run(
+            [str(self.exe), str(path)],
+            check=True,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+        return result.stdout.splitlines()
+
+    def test_mixed_prologue_stops_at_first_body_form(self):
+        """TEST-ID: tests.module-header.mixed-prologue
+        TEST-CONTEXT: monadc.context.modules.header-scan
+        TEST-PURPOSE: the header scanner collects paren and layout imports through comments, metadata, commentary sections and multi-line export lists, and ends at the first body form.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: module.h, module.c
+        """
+        lines = self.scan(
+            """
+            ;;; Main.mon --- entry point
+            :author "Laluxx"
+            :keywords "import Fake"
+
+            ;;; Commentary:
+
+             import NotCode
+
+            ;;; Code:
+            -| import AlsoNotCode |-
+            import Data.Bool
+            (import qualified Std.Math :as M)
+            (import Std.List
+              [map filter])
+            module Main
+              [main
+               helper]
+            define main ...
+            import Late
+            """
+        )
+        self.assertEqual(
+            lines,
+            [
+                "any 1",
+                "module Main",
+                "import Data.Bool layout",
+                "import Std.Math paren",
+                "import Std.List paren",
+                "rest define main ",
+            ],
+        )
+
+    def test_file_without_header(self):
+        """TEST-ID: tests.module-header.no-header
+        TEST-CONTEXT: monadc.context.modules.header-scan
+        TEST-PURPOSE: a file whose first form is not a header form has an empty prologue.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: module.c
+        """
+        lines = self.scan(
+            """
+            ; "(import X)" in a comment
+            (define x 1)
+            (import Y)
+            """
+        )
+        self.assertEqual(lines, ["any 0", "module -", "rest (define x 1)"])
+
+    def test_scanner_agrees_with_core_library(self):
+        """TEST-ID: tests.module-header.core-library
+        TEST-CONTEXT: monadc.context.modules.header-scan
+        TEST-PURPOSE: every import line in the core library is inside the prologue the scanner finds.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: module.c, core
+        """
+        sources = sorted((ROOT / "core").rglob("*.mon"))
+        self.assertTrue(sources)
+        result = subprocess.run(
+            [str(self.exe), *map(str, sources)],
+            check=True,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+        found = sorted(
+            line.split()[1] for line in result.stdout.splitlines() if line.startswith("import ")
+        )
+        expected = []
+        for source in sources:
+            for line in source.read_text(encoding="utf-8").splitlines():
+                words = line.strip().lstrip("(").split()
+                if len(words) >= 2 and words[0] == "import":
+                    name = words[2] if words[1] == "qualified" else words[1]
+                    expected.append(name.rstrip(")"))
+        self.assertEqual(found, sorted(expected))
+
+    def test_content_hash_is_xxh64(self):
+        """TEST-ID: tests.module-header.content-hash
+        TEST-CONTEXT: monadc.context.modules.content-hash
+        TEST-PURPOSE: module_hash_buffer produces the reference XXH64 digests that build freshness checks compare.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: module.c
+        """
+        vectors = {
+            "": "ef46db3751d8e999",
+            "abc": "44bc2cf5ad770999",
+            "Nobody inspects the spammish repetition": "fbcea83c8a378bf1",
+        }
+        for text, digest in vectors.items():
+            result = subprocess.run(
+                [str(self.exe), "=" + text],
+                check=True,
+                stdout=subprocess.PIPE,
+                text=True,
+            )
+            self.assertEqual(result.stdout.strip(), digest, text)
+
+
+if __name__ == "__main__":
+    unittest.main()
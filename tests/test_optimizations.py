@@ -0,0 +1,149 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+SOURCES = [
+    "optimizations.c",
+    "pmatch.c",
+    "reader.c",
+    "arena.c",
+    "features.c",
+    "types.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+]
+
+PRELUDE = r'''
+#include "optimizations.h"
+#include <stdio.h>
+
+static void optimize_and_print(const char *src) {
+    parser_set_context("opt_harness.mon", src);
+    ASTList l = parse_all(src);
+    OptimizationOptions o = optimization_options_default();
+    o.level          = OPT_LEVEL_AGGRESSIVE;
+    o.fuse_sequences = true;
+    OptimizationStats st = {0};
+    optimize_ast_list(&l, &o, &st);
+    for (size_t i = 0; i < l.count; i++) {
+        ast_print(l.exprs[i]);
+        printf("\n");
+    }
+    printf("fused=%zu\n", st.sequences_fused);
+}
+'''
+
+
+class SequenceFusionTests(unittest.TestCase):
+    def optimize(self, src: str) -> list:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "opt_harness.c"
+            exe = Path(td) / "opt_harness"
+            harness.write_text(
+                PRELUDE
+                + textwrap.dedent(
+                    r'''
+                    int main(int argc, char **argv) {
+                        (void)argc;
+                        optimize_and_print(argv[1]);
+                        return 0;
+                    }
+                    '''
+                ),
+                encoding="utf-8",
+            )
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-iquote", str(ROOT)]
+                + [str(ROOT / s) for s in SOURCES]
+                + [str(harness), "-o", str(exe), "-lm"],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            result = subprocess.run(
+                [str(exe), textwrap.dedent(src)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                timeout=60,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+            return result.stdout.splitlines()
+
+    def test_chains_fuse_into_one_traversal(self):
+        """TEST-ID: tests.optimizations.sequence-fusion
+        TEST-CONTEXT: monadc.context.main.compile-one
+        TEST-PURPOSE: at -O2 map over map and filter over filter become one pass with a composed function, and a foldl over map, filter and a finite Int range becomes a single counted loop with no intermediate list.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: optimizations.h, optimizations.c
+        """
+        lines = self.optimize(
+            r'''
+            (define (t xs) (map inc (map dec xs)))
+            (define (u xs) (filter odd? (filter pos? xs)))
+            (define (s [n : Int] -> Int) (foldl + 0 (map sq (filter even? (0 .. n)))))
+            (define (v) (foldl + 0 (10, 8 .. 0)))
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "(define t (lambda ([xs :: a])"
+                " (map (lambda ([__fuse_x0]) (inc (dec __fuse_x0))) xs)))",
+                "(define u (lambda ([xs :: a])"
+                " (filter (lambda ([__fuse_x1]) (and (pos? __fuse_x1) (odd? __fuse_x1))) xs)))",
+                "(define s (lambda ([n :: Int] -> Int)"
+                " (with [__fuse_acc6 0] (for [__fuse_i7 0 (+ n 1)]"
+                " (set! __fuse_acc6 ((lambda ([__fuse_a4] [__fuse_x5])"
+                " (if (even? __fuse_x5) ((lambda ([__fuse_a2] [__fuse_x3])"
+                " (+ __fuse_a2 (sq __fuse_x3))) __fuse_a4 __fuse_x5) __fuse_a4))"
+                " __fuse_acc6 __fuse_i7))) __fuse_acc6)))",
+                "(define v (lambda () (with [__fuse_acc8 0]"
+                " (for [__fuse_i9 10 -1 -2] (set! __fuse_acc8 (+ __fuse_acc8 __fuse_i9)))"
+                " __fuse_acc8)))",
+                "fused=6",
+            ],
+        )
+
+    def test_fusion_keeps_unsafe_chains(self):
+        """TEST-ID: tests.optimizations.sequence-fusion-guards
+        TEST-CONTEXT: monadc.context.main.compile-one
+        TEST-PURPOSE: chains with an impure function, a shadowed map, a call-valued function argument or a range of unknown element type are left alone, and a module that defines map itself is never fused.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: optimizations.c
+        """
+        lines = self.optimize(
+            r'''
+            (define (w xs) (map print! (map inc xs)))
+            (define (q map xs) (map inc (map inc xs)))
+            (define (c xs) (map (adder 1) (map inc xs)))
+            (define (r a b) (foldl + 0 (a .. b)))
+            '''
+        )
+        self.assertEqual(lines[-1], "fused=0")
+
+        lines = self.optimize(
+            r'''
+            (define (map f xs) xs)
+            (define (t xs) (map inc (map dec xs)))
+            '''
+        )
+        self.assertEqual(lines[-1], "fused=0")
+
+
+if __name__ == "__main__":
+    unittest.main()
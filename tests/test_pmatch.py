@@ -0,0 +1,180 @@
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+SOURCES = [
+    "pmatch.c",
+    "optimizations.c",
+    "reader.c",
+    "arena.c",
+    "features.c",
+    "types.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+]
+
+PRELUDE = r'''
+#include "reader.h"
+#include <stdio.h>
+
+static void desugar_and_print(const char *src) {
+    parser_set_context("pmatch_harness.mon", src);
+    ASTList l = parse_all(src);
+    for (size_t i = 0; i < l.count; i++) {
+        ast_print(l.exprs[i]);
+        printf("\n");
+    }
+}
+'''
+
+
+class DecisionTreeTests(unittest.TestCase):
+    def desugar(self, src: str) -> list:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "pmatch_harness.c"
+            exe = Path(td) / "pmatch_harness"
+            harness.write_text(
+                PRELUDE
+                + textwrap.dedent(
+                    r'''
+                    int main(int argc, char **argv) {
+                        (void)argc;
+                        desugar_and_print(argv[1]);
+                        return 0;
+                    }
+                    '''
+                ),
+                encoding="utf-8",
+            )
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-iquote", str(ROOT)]
+                + [str(ROOT / s) for s in SOURCES]
+                + [str(harness), "-o", str(exe), "-lm"],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            result = subprocess.run(
+                [str(exe), textwrap.dedent(src)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                timeout=60,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+            return result.stdout.splitlines()
+
+    def test_leading_tests_are_shared(self):
+        """TEST-ID: tests.pmatch.decision-tree
+        TEST-CONTEXT: monadc.context.pmatch.desugarer
+        TEST-PURPOSE: clauses that open with the same scrutinee test it once, constructor clauses become one tag chain, subsumed clauses are dropped, and a complete match over a finite type never reaches undefined.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: pmatch.c, optimizations.c
+        """
+        lines = self.desugar(
+            r'''
+            (define (f [x : Int] [y : Int] -> Int)
+              0 0 -> 1
+              0 _ -> 2
+              1 y -> y
+              1 _ -> 4
+              _ _ -> 3)
+            (data Shape Circle Int | Sq Int | Pt)
+            (define (g [s : Shape] -> Int)
+              [Circle 0] -> 1
+              [Sq w]     -> w
+              [Circle r] -> r
+              _          -> 0)
+            (define (c [k : {Red Green Blue}] [n : Int] -> Int)
+              Red 0 -> 1
+              Red n -> n
+              Green _ -> 2
+              Blue _  -> 3)
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "(define f (lambda ([x :: Int] [y :: Int] -> Int)"
+                " (if (= x 0) (if (= y 0) 1 2) (if (= x 1) y 3))))",
+                "(data Shape Circle Int | Sq Int | Pt)",
+                "(define g (lambda ([s :: Shape] -> Int)"
+                " (if (= s.__tag __adt_tag_Circle)"
+                " (if (= (__field_Circle_0 s) 0) 1 (__field_Circle_0 s))"
+                " (if (= s.__tag __adt_tag_Sq) (__field_Sq_0 s) 0))))",
+                "(define c (lambda ([k :: {Red Green Blue}] [n :: Int] -> Int)"
+                " (if (= k Red) (if (= n 0) 1 n) (if (= k Green) 2 3))))",
+            ],
+        )
+
+    def test_guards_are_never_shared(self):
+        """TEST-ID: tests.pmatch.decision-tree-guards
+        TEST-CONTEXT: monadc.context.pmatch.desugarer
+        TEST-PURPOSE: rows that differ only after a shared pattern test keep one evaluation of each guard, in clause order, and a failing branch still falls through to the later clauses.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: pmatch.c
+        """
+        lines = self.desugar(
+            r'''
+            (define (h [xs : [Int]] [n : Int] -> Int)
+              [a b] n | (pred n) -> a
+              [a b] n | (pred n) -> b
+              [a]   _            -> a
+              _     n            -> n)
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "(define h (lambda ([xs :: ([ Int ])] [n :: Int] -> Int)"
+                " (if (= (count xs) 2)"
+                " (if (pred n) (rt_coll_head xs)"
+                " (if (pred n) (rt_coll_head (rt_coll_drop xs 1)) n))"
+                " (if (= (count xs) 1) (rt_coll_head xs) n))))",
+            ],
+        )
+
+
+    def test_trivial_guards_share_tests(self):
+        """TEST-ID: tests.pmatch.decision-tree-trivial-guards
+        TEST-CONTEXT: monadc.context.pmatch.desugarer
+        TEST-PURPOSE: a `| True` guard, which wisp appends to every unguarded method clause, is treated like no guard, so its clause still shares pattern tests and subsumes later clauses.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: pmatch.c
+        """
+        lines = self.desugar(
+            r'''
+            (define (h [xs : [Int]] [n : Int] -> Int)
+              [a|r] 0 | True -> a
+              [a|r] n | True -> n
+              _     n | True -> 0)
+            '''
+        )
+        self.assertEqual(
+            lines,
+            [
+                "(define h (lambda ([xs :: ([ Int ])] [n :: Int] -> Int)"
+                " (if (if (rt_coll_is_empty xs) False True)"
+                " (if (= n 0) (rt_coll_head xs) n) 0)))",
+            ],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -21,12 +21,13 @@ def clean_output(value: str) -> str:
 
 class ReplTests(unittest.TestCase):
     def run_repl(
-        self, source: str, timeout: int = 15
+        self, source: str, timeout: int = 15, extra_env=None
     ) -> subprocess.CompletedProcess[str]:
         with tempfile.TemporaryDirectory(prefix="monadc-repl-") as td:
             env = os.environ.copy()
             env["HOME"] = td
             env["MONAD_NO_PROMPT"] = "1"
+            env.update(extra_env or {})
             return subprocess.run(
                 [str(MONAD), "repl"],
                 input=source,
@@ -142,6 +143,32 @@ class ReplTests(unittest.TestCase):
         self.assertEqual(result.returncode, 0, result.stdout)
         self.assertIn("42", clean_output(result.stdout).splitlines())
 
+    def test_repl_lazy_function_bodies_match_eager_compilation(self):
+        source = (
+            "define add2 :: Int -> Int\n"
+            "  x -> x + 2\n"
+            "\n"
+            "define add4 :: Int -> Int\n"
+            "  x -> (add2 (add2 x))\n"
+            "\n"
+            "define unused :: Int -> Int\n"
+            "  x -> x * 3\n"
+            "\n"
+            "show (add4 38)\n"
+            "show (add2 1)\n"
+        )
+        runs = [
+            self.run_repl(source),
+            self.run_repl(source, extra_env={"MONAD_REPL_BACKGROUND_O2": "0"}),
+            self.run_repl(source, extra_env={"MONAD_REPL_LAZY": "0", "MONAD_REPL_EAGER_DECLS": "1"}),
+        ]
+
+        for result in runs:
+            self.assertEqual(result.returncode, 0, result.stdout)
+            self.assertNotIn("ORC", result.stdout)
+            self.assertNotIn("IR verification failed", result.stdout)
+            self.assertEqual(clean_output(result.stdout).splitlines()[-2:], ["42", "3"])
+
     def test_repl_evaluates_general_indented_wisp_application(self):
         result = self.run_repl(
             "show\n"
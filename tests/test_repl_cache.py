@@ -58,6 +58,28 @@ class ReplCacheTests(unittest.TestCase):
             self.assertTrue(repaired.stdout.rstrip().endswith("3"), repaired.stdout)
             self.assertGreater(artifacts[0].stat().st_size, len(b"corrupt"))
 
+    def test_repl_jit_objects_are_reused_by_the_next_session(self):
+        with tempfile.TemporaryDirectory(prefix="monadc-repl-jit-cache-") as td:
+            home = Path(td)
+            jit_dir = home / ".cache" / "monad" / "repl" / "v1" / "jit"
+
+            cold = self.run_repl(home)
+            self.assertEqual(cold.returncode, 0, cold.stdout)
+            self.assertIn("[monad-cache] store jit", cold.stdout)
+            self.assertTrue(list(jit_dir.glob("*.o")), cold.stdout)
+
+            warm = self.run_repl(home)
+            self.assertEqual(warm.returncode, 0, warm.stdout)
+            self.assertIn("[monad-cache] hit jit", warm.stdout)
+            self.assertTrue(warm.stdout.rstrip().endswith("3"), warm.stdout)
+
+            for entry in jit_dir.glob("*.o"):
+                entry.write_bytes(b"corrupt")
+            repaired = self.run_repl(home)
+            self.assertEqual(repaired.returncode, 0, repaired.stdout)
+            self.assertIn("[monad-cache] repair jit", repaired.stdout)
+            self.assertTrue(repaired.stdout.rstrip().endswith("3"), repaired.stdout)
+
     def test_concurrent_cold_repls_publish_one_complete_artifact(self):
         with tempfile.TemporaryDirectory(prefix="monadc-repl-cache-race-") as td:
             home = Path(td)
@@ -0,0 +1,1669 @@
+import os
+import shlex
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+RUNTIME_SOURCES = ("runtime.c", "runtime_errors.c", "runtime_prof.c", "runtime_debug.c", "arena.c")
+
+
+def llvm_config(*args: str) -> list[str]:
+    result = subprocess.run(
+        [os.environ.get("LLVM_CONFIG", "llvm-config"), *args],
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    return shlex.split(result.stdout)
+
+
+class RuntimeLibraryTests(unittest.TestCase):
+    def compile_and_run(self, source: str, env=None, cflags=()) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "runtime_harness.c"
+            exe = Path(td) / "runtime_harness"
+            harness.write_text(source, encoding="utf-8")
+
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    "-Wall",
+                    "-Wextra",
+                    *llvm_config("--cflags"),
+                    "-iquote",
+                    str(ROOT),
+                    *cflags,
+                    *(str(ROOT / src) for src in RUNTIME_SOURCES),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                    *llvm_config("--ldflags", "--libs", "core"),
+                    *llvm_config("--system-libs"),
+                    "-lgmp",
+                    "-lm",
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+            run_env = os.environ.copy()
+            run_env.update(env or {})
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                env=run_env,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_slab_allocator_recycles_and_counts_runtime_objects(self):
+        """TEST-ID: tests.runtime.slab-allocator
+        TEST-CONTEXT: monadc.context.runtime.memory
+        TEST-PURPOSE: fixed-size runtime objects come from size-classed pools that recycle released slots and report counters.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c, arena.h, arena.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            static RuntimeValue *twice(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) * 2);
+            }
+
+            int main(void) {
+                RuntimeList *xs = rt_list_map(rt_list_range(1, 1000), NULL, twice);
+                printf("len=%lld last=%lld\n",
+                       (long long)rt_list_length(xs),
+                       (long long)rt_unbox_int(rt_list_nth(xs, 999)));
+
+                RuntimeAllocStats before;
+                rt_alloc_stats(&before);
+                void *a = rt_alloc(sizeof(RuntimeValue));
+                rt_free_sized(a, sizeof(RuntimeValue));
+                void *b = rt_alloc(sizeof(RuntimeValue));
+                printf("recycled=%d\n", before.malloc_mode ? 1 : a == b);
+
+                RuntimeAllocStats after;
+                rt_alloc_stats(&after);
+                printf("allocs=%d releases=%zu\n",
+                       after.allocs >= before.allocs + 2,
+                       after.releases - before.releases);
+                printf("large=%zu\n", after.large - before.large);
+                void *big = rt_alloc(4096);
+                rt_free_sized(big, 4096);
+                rt_alloc_stats(&after);
+                printf("large_after=%zu\n", after.large - before.large);
+                return 0;
+            }
+            '''
+        )
+
+        slab = self.compile_and_run(harness, {"MONAD_ALLOC_STATS": "1"})
+        self.assertEqual(slab.returncode, 0, slab.stderr)
+        self.assertIn("len=1000 last=2000", slab.stdout)
+        self.assertIn("recycled=1", slab.stdout)
+        self.assertIn("allocs=1 releases=1", slab.stdout)
+        self.assertIn("large_after=1", slab.stdout)
+        self.assertIn("[alloc] exit:", slab.stderr)
+        self.assertIn("reused", slab.stderr)
+
+        baseline = self.compile_and_run(
+            harness, {"MONAD_ALLOC": "malloc", "MONAD_ALLOC_STATS": "1"}
+        )
+        self.assertEqual(baseline.returncode, 0, baseline.stderr)
+        self.assertIn("len=1000 last=2000", baseline.stdout)
+        self.assertIn("malloc baseline", baseline.stderr)
+
+    def test_gc_reclaims_garbage_and_keeps_reachable_values(self):
+        """TEST-ID: tests.runtime.tracing-gc
+        TEST-CONTEXT: monadc.context.runtime.memory
+        TEST-PURPOSE: with MONAD_GC=1 the conservative collector recycles unreachable lists and bignums while stack- and global-rooted values survive intact, and GMP numbers created before rt_gc_init can still be resized and cleared.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            static RuntimeValue *twice(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) * 2);
+            }
+
+            static RuntimeMap *g_table;   // rooted through .bss
+
+            int main(void) {
+                // Limbs allocated before rt_gc_init and resized or freed after it.
+                mpz_t early[64];
+                for (int i = 0; i < 64; i++) mpz_init_set_si(early[i], i + 1);
+
+                rt_gc_init(__builtin_frame_address(0));
+
+                size_t early_bits = 0;
+                for (int i = 0; i < 64; i++) {
+                    mpz_mul_2exp(early[i], early[i], 4096);
+                    early_bits += mpz_sizeinbase(early[i], 2);
+                    mpz_clear(early[i]);
+                }
+
+                RuntimeList *keep = rt_list_map(rt_list_range(1, 2000), NULL, twice);
+                rt_list_length(keep);
+                g_table = rt_map_new();
+                for (int i = 0; i < 100; i++)
+                    g_table = rt_map_assoc(g_table, rt_value_int(i), rt_value_int(i * 3));
+
+                long long total = 0;
+                for (int round = 0; round < 300; round++) {
+                    RuntimeList *xs = rt_list_map(rt_list_range(1, 1000), NULL, twice);
+                    total += rt_unbox_int(rt_list_nth(xs, 999));
+                    RuntimeValue *big = rt_value_bignum_from_i64(INT64_MAX);
+                    for (int k = 0; k < 20; k++) big = rt_bignum_add(big, big);
+                }
+                rt_gc_collect();
+
+                RuntimeGCStats st;
+                rt_gc_stats(&st);
+                printf("enabled=%d\n", st.enabled);
+                printf("early=%zu\n", early_bits);
+                printf("total=%lld\n", total);
+                printf("keep=%lld,%lld\n", (long long)rt_list_length(keep),
+                       (long long)rt_unbox_int(rt_list_nth(keep, 1999)));
+                printf("table=%lld\n",
+                       (long long)rt_unbox_int(rt_map_get(g_table, rt_value_int(77), NULL)));
+                printf("collected=%d freed=%d\n", st.collections > 1, st.freed_bytes > 4u * 1024u * 1024u);
+                printf("bounded=%d\n", st.heap_bytes < 16u * 1024u * 1024u);
+                return 0;
+            }
+            '''
+        )
+
+        gc = self.compile_and_run(
+            harness,
+            {"MONAD_GC": "1", "MONAD_GC_NURSERY": "512K", "MONAD_GC_STATS": "1"},
+        )
+        self.assertEqual(gc.returncode, 0, gc.stderr)
+        self.assertIn("enabled=1", gc.stdout)
+        self.assertIn("early=262472", gc.stdout)
+        self.assertIn("total=600000", gc.stdout)
+        self.assertIn("keep=2000,4000", gc.stdout)
+        self.assertIn("table=231", gc.stdout)
+        self.assertIn("collected=1 freed=1", gc.stdout)
+        self.assertIn("bounded=1", gc.stdout)
+        self.assertIn("[gc] exit:", gc.stderr)
+        self.assertIn("pause", gc.stderr)
+
+        off = self.compile_and_run(harness)
+        self.assertEqual(off.returncode, 0, off.stderr)
+        self.assertIn("enabled=0", off.stdout)
+        self.assertIn("keep=2000,4000", off.stdout)
+
+
+    def test_prof_samples_cpu_and_attributes_allocations_to_sites(self):
+        """TEST-ID: tests.runtime.profiler
+        TEST-CONTEXT: monadc.context.runtime.memory
+        TEST-PURPOSE: MONAD_PROF=cpu,alloc writes folded stacks whose frames carry closure names, counts every allocation against the RtProfSite in __monad_prof_site with that span as the leaf of sampled stacks, and JIT symbols land in the perf map.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c, runtime_prof.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+            #include <time.h>
+            #include <unistd.h>
+
+            extern __thread const RtProfSite *__monad_prof_site;
+            static const RtProfSite g_site = { "Main.mon", "build", 3, 5 };
+
+            static RuntimeValue *twice(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) * 2);
+            }
+
+            __attribute__((noinline))
+            static RuntimeValue *spin(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n; (void)args;
+                volatile uint64_t x = 0;
+                clock_t end = clock() + CLOCKS_PER_SEC / 2;
+                while (clock() < end)
+                    for (int i = 0; i < 20000; i++) x += (uint64_t)i;
+                return rt_value_int((int64_t)(x & 0xff));
+            }
+
+            typedef RuntimeValue *(*Entry)(void *, int, RuntimeValue **);
+
+            int main(void) {
+                rt_prof_init();
+                rt_prof_init();
+                RuntimeValue *c = rt_value_closure_named((void *)spin, NULL, 0, 0, "monad-spin");
+                ((Entry)c->data.closure_val->fn_ptr)(NULL, 0, NULL);
+
+                __monad_prof_site = &g_site;
+                long long total = 0;
+                for (int r = 0; r < 50; r++)
+                    total += rt_list_length(rt_list_map(rt_list_range(1, 1000), NULL, twice));
+                __monad_prof_site = NULL;
+
+                rt_prof_jit_symbol(0x1000, 0x20, "jit_fn");
+                printf("total=%lld pid=%ld\n", total, (long)getpid());
+                return 0;
+            }
+            '''
+        )
+
+        with tempfile.TemporaryDirectory() as td:
+            prefix = str(Path(td) / "out")
+            prof = self.compile_and_run(
+                harness,
+                {"MONAD_PROF": "cpu,alloc", "MONAD_PROF_FILE": prefix,
+                 "MONAD_PROF_ALLOC_RATE": "4K"},
+            )
+            self.assertEqual(prof.returncode, 0, prof.stderr)
+            self.assertIn("total=50000", prof.stdout)
+            cpu = Path(prefix + ".cpu.folded").read_text(encoding="utf-8").splitlines()
+            alloc = Path(prefix + ".alloc.folded").read_text(encoding="utf-8").splitlines()
+
+        pid = prof.stdout.split("pid=")[1].strip()
+        perf_map = Path(f"/tmp/perf-{pid}.map")
+        try:
+            self.assertIn("1000 20 jit_fn", perf_map.read_text(encoding="utf-8"))
+        finally:
+            perf_map.unlink(missing_ok=True)
+
+        spin = [l for l in cpu if "main;monad-spin" in l]
+        self.assertTrue(spin, cpu)
+        self.assertGreater(sum(int(l.rsplit(" ", 1)[1]) for l in spin), 100)
+        self.assertFalse([l for l in cpu if "prof_on_sigprof" in l], cpu)
+
+        sited = [l for l in alloc if ";[Main.mon:3:5] " in l]
+        self.assertTrue(sited, alloc)
+        # Lazy tails re-enter through the static list_map, not rt_list_map.
+        self.assertTrue(any(";list_map;" in l for l in sited), sited)
+        self.assertIn("[prof] cpu:", prof.stderr)
+        self.assertIn("[prof] alloc:", prof.stderr)
+        self.assertIn("Main.mon:3:5 (build)", prof.stderr)
+        self.assertIn("(no site)", prof.stderr)
+
+        off = self.compile_and_run(harness)
+        self.assertEqual(off.returncode, 0, off.stderr)
+        self.assertNotIn("[prof]", off.stderr)
+        pid = off.stdout.split("pid=")[1].strip()
+        self.assertFalse(Path(f"/tmp/perf-{pid}.map").exists())
+
+    def test_breakpoints_report_hits_and_watchpoints_trap_stores(self):
+        """TEST-ID: tests.runtime.debug-points
+        TEST-CONTEXT: monadc.context.runtime.debugger
+        TEST-PURPOSE: rt_debug_break logs each hit with its site under MONAD_BREAK=log and only counts hits under MONAD_BREAK=count; rt_debug_watch reports stores to a watched variable through a hardware watchpoint where the kernel allows one, formats floats as exact hex without stdio in the handler, and catches stores from a thread started after arming.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime_debug.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <pthread.h>
+            #include <stdio.h>
+
+            static const RtProfSite g_site = { "Loop.mon", "step", 7, 3 };
+            volatile int64_t counter = 1;
+            volatile double ratio = 0.5;
+
+            static void *store_from_thread(void *arg) {
+                (void)arg;
+                counter = -7;
+                return NULL;
+            }
+
+            int main(void) {
+                for (int i = 0; i < 10; i++)
+                    if (i % 4 == 1) rt_debug_break(0, &g_site);
+                rt_debug_break(RT_DEBUG_MAX_POINTS, &g_site);
+                rt_debug_watch(0, "counter", (void *)&counter, 8, RT_WATCH_INT);
+                rt_debug_watch(1, "ratio", (void *)&ratio, 8, RT_WATCH_FLOAT);
+                counter = 2;
+                counter = counter + 40;
+                ratio = 3.0;
+                pthread_t t;
+                pthread_create(&t, NULL, store_from_thread, NULL);
+                pthread_join(t, NULL);
+                printf("counter=%lld\n", (long long)counter);
+                return 0;
+            }
+            '''
+        )
+
+        log = self.compile_and_run(harness, {"MONAD_BREAK": "log"})
+        self.assertEqual(log.returncode, 0, log.stderr)
+        self.assertIn("counter=-7", log.stdout)
+        self.assertIn("[break 1] Loop.mon:7:3 in step (hit 1)", log.stderr)
+        self.assertIn("[break 1] Loop.mon:7:3 in step (hit 3)", log.stderr)
+        self.assertNotIn("(hit 4)", log.stderr)
+        if "unavailable" not in log.stderr:
+            self.assertIn("[watch] counter: 1 -> 2 (write 1)", log.stderr)
+            self.assertIn("[watch] counter: 2 -> 42 (write 2)", log.stderr)
+            self.assertIn("[watch] ratio: 0x1p-1 -> 0x1.8p+1 (write 1)", log.stderr)
+            self.assertIn("[watch] counter: 42 -> -7 (write 3)", log.stderr)
+
+        count = self.compile_and_run(harness, {"MONAD_BREAK": "count"})
+        self.assertEqual(count.returncode, 0, count.stderr)
+        self.assertNotIn("(hit", count.stderr)
+        self.assertIn("[break 1] Loop.mon:7:3  3 hits", count.stderr)
+
+    def test_runtime_declarations_are_lazy_and_cached_per_module(self):
+        """TEST-ID: tests.runtime.lazy-declarations
+        TEST-CONTEXT: monadc.context.runtime.llvm-declarations
+        TEST-PURPOSE: get_rt_* getters declare a runtime function in the current module on first use with its table signature, return the cached declaration afterwards, and start over when the context moves to a new module.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c, codegen.h
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include "codegen.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            static int count_functions(LLVMModuleRef m) {
+                int n = 0;
+                for (LLVMValueRef f = LLVMGetFirstFunction(m); f; f = LLVMGetNextFunction(f)) n++;
+                return n;
+            }
+
+            int main(void) {
+                static CodegenContext ctx;
+                ctx.context = LLVMContextCreate();
+                ctx.module  = LLVMModuleCreateWithNameInContext("a", ctx.context);
+                declare_runtime_functions(&ctx);
+                printf("fresh=%d\n", count_functions(ctx.module));
+
+                LLVMValueRef map = get_rt_list_map(&ctx);
+                printf("same=%d\n", map == get_rt_list_map(&ctx));
+                printf("alias=%d\n", get_rt_list_is_empty(&ctx) == get_rt_list_is_empty_list(&ctx));
+                get_rt_prof_init(&ctx);
+                printf("declared=%d\n", count_functions(ctx.module));
+
+                LLVMTypeRef ft = LLVMGlobalGetValueType(get_rt_debug_watch(&ctx));
+                LLVMTypeRef params[5];
+                LLVMGetParamTypes(ft, params);
+                printf("watch=%u %d %u %u\n", LLVMCountParamTypes(ft),
+                       LLVMGetTypeKind(LLVMGetReturnType(ft)) == LLVMVoidTypeKind,
+                       LLVMGetIntTypeWidth(params[0]), LLVMGetIntTypeWidth(params[3]));
+
+                LLVMModuleRef b = LLVMModuleCreateWithNameInContext("b", ctx.context);
+                ctx.module = b;
+                LLVMValueRef map_b = get_rt_list_map(&ctx);
+                printf("moved=%d parent=%d count=%d\n", map_b != map,
+                       LLVMGetGlobalParent(map_b) == b, count_functions(b));
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(
+            result.stdout.splitlines(),
+            ["fresh=0", "same=1", "alias=1", "declared=3", "watch=5 1 32 64",
+             "moved=1 parent=1 count=1"],
+        )
+
+    def test_persistent_maps_and_sets_share_structure_between_versions(self):
+        """TEST-ID: tests.runtime.persistent-collections
+        TEST-CONTEXT: monadc.context.runtime.runtime-set
+        TEST-PURPOSE: assoc/dissoc/conj/disj on large maps and sets return new trie-backed versions while every older version keeps its own contents, and _mut updates still work on trie-backed values.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            #define N 5000
+
+            int main(void) {
+                RuntimeMap *versions[N + 1];
+                versions[0] = rt_map_new();
+                for (int i = 0; i < N; i++)
+                    versions[i + 1] = rt_map_assoc(versions[i], rt_value_int(i),
+                                                   rt_value_int(i * 10));
+
+                int ok = 1;
+                for (int v = 0; v <= N; v += 250) {
+                    if (rt_map_count(versions[v]) != v) ok = 0;
+                    if (v > 0 && rt_unbox_int(rt_map_get(versions[v],
+                            rt_value_int(v - 1), NULL)) != (v - 1) * 10) ok = 0;
+                    if (rt_map_contains(versions[v], rt_value_int(v))) ok = 0;
+                }
+                printf("map_versions=%d\n", ok);
+
+                RuntimeMap *full = versions[N];
+                RuntimeMap *upd  = rt_map_assoc(full, rt_value_int(7), rt_value_int(-1));
+                printf("update=%lld,%lld count=%lld\n",
+                       (long long)rt_unbox_int(rt_map_get(full, rt_value_int(7), NULL)),
+                       (long long)rt_unbox_int(rt_map_get(upd, rt_value_int(7), NULL)),
+                       (long long)rt_map_count(upd));
+
+                RuntimeMap *less = full;
+                for (int i = 0; i < N; i += 2)
+                    less = rt_map_dissoc(less, rt_value_int(i));
+                printf("dissoc=%lld has0=%d has1=%d orig=%lld\n",
+                       (long long)rt_map_count(less),
+                       rt_map_contains(less, rt_value_int(0)),
+                       rt_map_contains(less, rt_value_int(1)),
+                       (long long)rt_map_count(full));
+                printf("keys=%lld equal=%d\n",
+                       (long long)rt_list_length(rt_map_keys(less)),
+                       rt_map_equal(full, rt_map_merge(less, full)));
+
+                RuntimeMap *m = rt_map_assoc(full, rt_value_string("k"), rt_value_int(1));
+                rt_map_assoc_mut(m, rt_value_string("k"), rt_value_int(2));
+                rt_map_dissoc_mut(m, rt_value_int(3));
+                printf("mut=%lld,%lld shared=%lld\n",
+                       (long long)rt_unbox_int(rt_map_get(m, rt_value_string("k"), NULL)),
+                       (long long)rt_map_count(m),
+                       (long long)rt_map_count(full));
+
+                RuntimeValue *vals[100];
+                for (int i = 0; i < 100; i++) vals[i] = rt_value_int(i % 50);
+                RuntimeSet *s = rt_set_of(vals, 100);
+                RuntimeSet *t = rt_set_from_list(rt_list_range(0, 999));
+                RuntimeSet *u = rt_set_disj(rt_set_conj(t, rt_value_int(-5)), rt_value_int(10));
+                printf("set_of=%lld from_list=%lld conj_disj=%lld,%d,%d orig=%d\n",
+                       (long long)rt_set_count(s), (long long)rt_set_count(t),
+                       (long long)rt_set_count(u),
+                       rt_set_contains(u, rt_value_int(-5)),
+                       rt_set_contains(u, rt_value_int(10)),
+                       rt_set_contains(t, rt_value_int(10)));
+                printf("seq=%lld subset_equal=%d\n",
+                       (long long)rt_list_length(rt_set_seq(t)),
+                       rt_set_equal(s, rt_set_from_list(rt_list_range(0, 49))));
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("map_versions=1", result.stdout)
+        self.assertIn("update=70,-1 count=5000", result.stdout)
+        self.assertIn("dissoc=2500 has0=0 has1=1 orig=5000", result.stdout)
+        self.assertIn("keys=2500 equal=1", result.stdout)
+        self.assertIn("mut=2,5000 shared=5000", result.stdout)
+        self.assertIn("set_of=50 from_list=1000 conj_disj=1000,1,0 orig=1", result.stdout)
+        self.assertIn("seq=1000 subset_equal=1", result.stdout)
+
+    def test_mut_tables_reuse_slots_and_probe_by_cached_hash(self):
+        """TEST-ID: tests.runtime.group-probed-tables
+        TEST-CONTEXT: monadc.context.runtime.runtime-set
+        TEST-PURPOSE: _mut churn on maps and sets keeps the table at the size its live keys need instead of filling it with deleted slots, every key stays findable through rehashes, and set intersection walks the smaller side but keeps the left operand's elements.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            int main(void) {
+                RuntimeMap *m = rt_map_new();
+                for (int round = 0; round < 2000; round++) {
+                    for (int i = 0; i < 64; i++)
+                        rt_map_assoc_mut(m, rt_value_int(round * 64 + i), rt_value_int(i));
+                    for (int i = 0; i < 64; i++)
+                        rt_map_dissoc_mut(m, rt_value_int(round * 64 + i));
+                }
+                printf("churn small=%d\n", m->capacity <= 256);
+                for (int i = 0; i < 1000; i++)
+                    rt_map_assoc_mut(m, rt_value_int(i), rt_value_int(-i));
+                int ok = rt_map_count(m) == 1000;
+                for (int i = 0; i < 1000; i++)
+                    if (rt_unbox_int(rt_map_get(m, rt_value_int(i), NULL)) != -i) ok = 0;
+                if (rt_map_contains(m, rt_value_int(1000))) ok = 0;
+                printf("map ok=%d small=%d\n", ok, m->capacity <= 2048);
+
+                RuntimeSet *s = rt_set_new();
+                for (int round = 0; round < 2000; round++) {
+                    char key[32];
+                    snprintf(key, sizeof(key), "k%d", round);
+                    rt_set_conj_mut(s, rt_value_string(key));
+                    if (round >= 20) {
+                        snprintf(key, sizeof(key), "k%d", round - 20);
+                        rt_set_disj_mut(s, rt_value_string(key));
+                    }
+                }
+                printf("set count=%lld small=%d has=%d,%d\n",
+                       (long long)rt_set_count(s), s->capacity <= 64,
+                       rt_set_contains(s, rt_value_string("k1999")),
+                       rt_set_contains(s, rt_value_string("k1979")));
+
+                RuntimeValue *left_a = rt_value_string("a");
+                RuntimeSet   *big    = rt_set_from_list(rt_list_range(0, 499));
+                rt_set_conj_mut(big, left_a);
+                RuntimeSet   *small  = rt_set_new();
+                rt_set_conj_mut(small, rt_value_string("a"));
+                rt_set_conj_mut(small, rt_value_int(7));
+                rt_set_conj_mut(small, rt_value_int(-7));
+                RuntimeValue *both = __rt_set_intersection(rt_value_set(big), rt_value_set(small));
+                RuntimeValue *a    = rt_set_get(both->data.set_val, rt_value_string("a"));
+                printf("inter=%lld left_elem=%d\n",
+                       (long long)rt_set_count(both->data.set_val), a == left_a);
+                return 0;
+            }
+            '''
+        )
+
+        for env in ({}, {"MONAD_GC": "1"}):
+            result = self.compile_and_run(harness, env=env)
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertIn("churn small=1", result.stdout)
+            self.assertIn("map ok=1 small=1", result.stdout)
+            self.assertIn("set count=20 small=1 has=1,0", result.stdout)
+            self.assertIn("inter=2 left_elem=1", result.stdout)
+
+    def test_scalars_are_immediate_and_round_trip(self):
+        """TEST-ID: tests.runtime.immediate-scalars
+        TEST-CONTEXT: monadc.context.runtime.values
+        TEST-PURPOSE: ints, floats, chars and nil are encoded in the pointer word, round-trip through the unbox accessors, compare equal to boxed forms, and a numeric fold allocates nothing per element.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <math.h>
+            #include <stdio.h>
+
+            static RuntimeValue *plus(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) + rt_unbox_int(args[1]));
+            }
+
+            int main(void) {
+                const int64_t ints[] = {0, 1, -1, 42, RT_IMM_INT_MAX, RT_IMM_INT_MIN,
+                                        RT_IMM_INT_MAX + 1, INT64_MAX, INT64_MIN};
+                int ok = 1, imm = 0;
+                for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+                    RuntimeValue *v = rt_value_int(ints[i]);
+                    imm += rt_is_immediate(v);
+                    ok &= rt_type_of(v) == RT_INT && rt_unbox_int(v) == ints[i];
+                }
+                printf("ints=%d immediate=%d\n", ok, imm);
+
+                const double flts[] = {0.0, -0.0, 1.5, -3.25, 1e300, -1e-300, 5e-324,
+                                       INFINITY, -INFINITY};
+                ok = 1;
+                for (size_t i = 0; i < sizeof(flts) / sizeof(flts[0]); i++) {
+                    RuntimeValue *v = rt_value_float(flts[i]);
+                    double back = rt_unbox_float(v);
+                    ok &= rt_is_immediate(v) && rt_type_of(v) == RT_FLOAT &&
+                          back == flts[i] && signbit(back) == signbit(flts[i]);
+                }
+                RuntimeValue *nan = rt_value_float(NAN);
+                printf("floats=%d nan=%d\n", ok,
+                       rt_type_of(nan) == RT_FLOAT && isnan(rt_unbox_float(nan)));
+
+                ok = 1;
+                for (int c = -128; c < 128; c++) {
+                    RuntimeValue *v = rt_value_char((char)c);
+                    ok &= rt_type_of(v) == RT_CHAR && rt_unbox_char(v) == (char)c;
+                }
+                RuntimeValue *nil = rt_value_nil();
+                printf("chars=%d nil=%d,%d\n", ok, rt_value_is_nil(nil),
+                       rt_type_of(nil) == RT_NIL);
+
+                RuntimeValue *big = rt_value_int(INT64_MAX);
+                printf("equal=%d,%d hash=%d\n",
+                       rt_equal_p(rt_value_int(7), rt_value_int(7)),
+                       rt_equal_p(big, rt_value_int(INT64_MAX)),
+                       rt_map_contains(rt_map_assoc(rt_map_new(), big, nil),
+                                       rt_value_int(INT64_MAX)));
+
+                RuntimeList *xs = rt_list_range(1, 10000);
+                rt_list_length(xs);
+                RuntimeAllocStats before, after;
+                rt_alloc_stats(&before);
+                RuntimeValue *sum = rt_list_foldl(xs, rt_value_int(0), NULL, plus);
+                rt_alloc_stats(&after);
+                printf("sum=%lld allocs=%zu\n", (long long)rt_unbox_int(sum),
+                       after.allocs - before.allocs);
+
+                printf("print=");
+                rt_print_value(rt_value_list(rt_list_cons(rt_value_int(-5),
+                               rt_list_cons(rt_value_float(2.5),
+                               rt_list_cons(rt_value_char('x'), rt_list_empty())))));
+                printf("\n");
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("ints=1 immediate=6", result.stdout)
+        self.assertIn("floats=1 nan=1", result.stdout)
+        self.assertIn("chars=1 nil=1,1", result.stdout)
+        self.assertIn("equal=1,1 hash=1", result.stdout)
+        self.assertIn("sum=50005000 allocs=0", result.stdout)
+        self.assertIn("print=(-5 2.5 'x')", result.stdout)
+    def test_strict_lists_are_chunked_behind_the_list_api(self):
+        """TEST-ID: tests.runtime.chunked-lists
+        TEST-CONTEXT: monadc.context.runtime.lists
+        TEST-PURPOSE: ranges, make-list, map, filter, append and builders store values in chunks, indexing and dropping work across chunk boundaries, infinite sequences stay lazy, map and filter only run fn on demanded elements unless fn is declared total, and forcing a range allocates per chunk rather than per element.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            static RuntimeValue *square(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                int64_t x = rt_unbox_int(args[0]);
+                return rt_value_int(x * x);
+            }
+
+            static RuntimeValue *odd(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) & 1);
+            }
+
+            static RuntimeValue *over(void *env, int n, RuntimeValue **args) {
+                (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) > *(int64_t *)env);
+            }
+
+            static int calls;
+            static RuntimeValue *counted(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                calls++;
+                return args[0];
+            }
+
+            static int64_t sum(RuntimeList *l) {
+                int64_t s = 0;
+                for (; !rt_list_is_empty_list(l); l = rt_list_cdr(l))
+                    s += rt_unbox_int(rt_list_car(l));
+                return s;
+            }
+
+            int main(void) {
+                RuntimeAllocStats before, after;
+                rt_alloc_stats(&before);
+                RuntimeList *xs = rt_list_range(1, 10000);
+                int64_t len = rt_list_length(xs);
+                rt_alloc_stats(&after);
+                printf("range=%lld sum=%lld cheap=%d\n", (long long)len,
+                       (long long)sum(xs), after.allocs - before.allocs < 1000);
+
+                int ok = 1;
+                for (int64_t i = 0; i < 100; i++) {
+                    ok &= rt_unbox_int(rt_list_nth(xs, i)) == i + 1;
+                    ok &= rt_unbox_int(rt_list_car(rt_list_drop(xs, i))) == i + 1;
+                    ok &= rt_list_length(rt_list_drop(xs, i)) == 10000 - i;
+                }
+                printf("nth_drop=%d past=%d\n", ok,
+                       rt_list_is_empty_list(rt_list_drop(xs, 10000)));
+
+                RuntimeList *nat   = rt_list_from(0);
+                RuntimeList *evens = rt_list_from_step(0, 2);
+                printf("from=%lld step=%lld take=%lld\n",
+                       (long long)rt_unbox_int(rt_list_nth(nat, 100000)),
+                       (long long)rt_unbox_int(rt_list_nth(evens, 33)),
+                       (long long)rt_list_length(rt_list_take(nat, 70)));
+
+                RuntimeList *ms = rt_make_list(100, rt_value_int(3));
+                printf("make=%lld,%lld\n", (long long)rt_list_length(ms),
+                       (long long)sum(ms));
+
+                int64_t bound = 9990;
+                RuntimeList *sq  = rt_list_map(rt_list_range(1, 100), NULL, square);
+                RuntimeList *od  = rt_list_filter(xs, NULL, odd);
+                RuntimeList *hi  = rt_list_filter(xs, &bound, over);
+                RuntimeList *big = rt_list_take(rt_list_map(nat, NULL, square), 40);
+                printf("map=%lld,%lld filter=%lld,%lld late=%lld lazy=%lld\n",
+                       (long long)rt_list_length(sq), (long long)sum(sq),
+                       (long long)rt_list_length(od), (long long)sum(od),
+                       (long long)rt_list_length(hi), (long long)sum(big));
+
+                rt_list_car(rt_list_map(xs, NULL, counted));
+                int map_calls = calls;
+                calls = 0;
+                rt_list_car(rt_list_filter(xs, NULL, counted));
+                printf("demand=%d,%d\n", map_calls, calls);
+                RuntimeList *tsq = rt_list_map_total(rt_list_range(1, 100), NULL, square);
+                RuntimeList *tod = rt_list_filter_total(xs, NULL, odd);
+                printf("total=%lld,%lld,%lld,%lld\n",
+                       (long long)rt_list_length(tsq), (long long)sum(tsq),
+                       (long long)rt_list_length(tod), (long long)sum(tod));
+
+                RuntimeList *ap = rt_list_append_lists(rt_list_drop(xs, 9990),
+                                                       rt_list_range(1, 40));
+                printf("append=%lld,%lld\n", (long long)rt_list_length(ap),
+                       (long long)sum(ap));
+
+                RuntimeList *b = rt_list_new();
+                for (int64_t i = 0; i < 50; i++) rt_list_append(b, rt_value_int(i));
+                RuntimeList *mixed = rt_list_cons(rt_value_int(-1), rt_list_empty());
+                rt_list_append(mixed, rt_value_int(-2));
+                for (int64_t i = 0; i < 40; i++) rt_list_append(mixed, rt_value_int(i));
+                printf("builder=%lld,%lld mixed=%lld,%lld\n",
+                       (long long)rt_list_length(b), (long long)sum(b),
+                       (long long)rt_list_length(mixed), (long long)sum(mixed));
+
+                printf("print=");
+                rt_print_value(rt_value_list(rt_list_take(rt_list_drop(xs, 28), 6)));
+                printf(" ");
+                rt_print_value(rt_value_list(rt_list_drop(rt_list_range(1, 34), 30)));
+                printf("\n");
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("range=10000 sum=50005000 cheap=1", result.stdout)
+        self.assertIn("nth_drop=1 past=1", result.stdout)
+        self.assertIn("from=100000 step=66 take=70", result.stdout)
+        self.assertIn("make=100,300", result.stdout)
+        self.assertIn("map=100,338350 filter=5000,25000000 late=10 lazy=20540", result.stdout)
+        self.assertIn("demand=1,1", result.stdout)
+        self.assertIn("total=100,338350,5000,25000000", result.stdout)
+        self.assertIn("append=50,100775", result.stdout)
+        self.assertIn("builder=50,1225 mixed=42,777", result.stdout)
+        self.assertIn("print=(29 30 31 32 33 34) (31 32 33 34)", result.stdout)
+
+    def test_strings_cache_length_hash_and_intern_names(self):
+        """TEST-ID: tests.runtime.string-representation
+        TEST-CONTEXT: monadc.context.runtime.values
+        TEST-PURPOSE: strings carry their length and hash, repeated appends and prepends build ropes that flatten once and stay linear, and symbols and keywords are interned so equal names are the same value.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            int main(void) {
+                RuntimeValue *s = rt_value_string("hello");
+                printf("len=%zu count=%lld chars=%s\n", rt_string_length(s),
+                       (long long)rt_coll_count(s), rt_string_chars(s));
+
+                RuntimeValue *acc = rt_value_string("");
+                for (int i = 0; i < 200000; i++)
+                    acc = rt_coll_concat(acc, rt_value_char((char)('a' + i % 26)));
+                RuntimeString *h = rt_string_header(acc->data.string_val);
+                int rope = (h->flags & RT_STR_ROPE) != 0;
+                size_t len = rt_string_length(acc);
+                const char *chars = rt_string_chars(acc);
+                int ok = strlen(chars) == 200000;
+                for (int i = 0; i < 200000; i++) ok &= chars[i] == 'a' + i % 26;
+                printf("append=%zu rope=%d flat=%d ok=%d\n", len, rope,
+                       !(rt_string_header(acc->data.string_val)->flags & RT_STR_ROPE), ok);
+
+                RuntimeValue *pre = rt_value_string("!");
+                for (int i = 0; i < 100000; i++)
+                    pre = rt_coll_concat(rt_value_char('x'), pre);
+                chars = rt_unbox_string(pre);
+                printf("prepend=%zu last=%c first=%c\n", strlen(chars),
+                       chars[100000], chars[0]);
+
+                RuntimeValue *a = rt_value_string("abcdefghijklmnopqrstuvwxyz0123456789");
+                RuntimeValue *b = rt_value_string("ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()");
+                RuntimeValue *ab = rt_string_append(a, b);
+                RuntimeValue *flat = rt_value_string(rt_unbox_string(rt_string_append(a, b)));
+                RuntimeMap *m = rt_map_assoc(rt_map_new(), ab, rt_value_int(1));
+                printf("equal=%d found=%d has=%d,%d drop=%s\n", rt_equal_p(ab, flat),
+                       rt_map_contains(m, flat),
+                       rt_coll_contains(rt_string_append(a, b), rt_value_char('E')),
+                       rt_coll_ends_with(rt_string_append(a, b), rt_value_string("&*()")),
+                       rt_unbox_string(rt_coll_drop(rt_string_append(a, b), 66)));
+
+                RuntimeValue *s1 = rt_value_symbol("foo");
+                RuntimeValue *s2 = rt_value_symbol("foo");
+                RuntimeValue *k1 = rt_value_keyword("foo");
+                printf("interned=%d,%d distinct=%d,%d\n", s1 == s2,
+                       rt_value_keyword("foo") == k1, s1 == k1, rt_equal_p(s1, k1));
+
+                printf("print=");
+                rt_print_value(rt_string_append(a, b));
+                printf("\n");
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("len=5 count=5 chars=hello", result.stdout)
+        self.assertIn("append=200000 rope=1 flat=1 ok=1", result.stdout)
+        self.assertIn("prepend=100001 last=! first=x", result.stdout)
+        self.assertIn("equal=1 found=1 has=1,1 drop=%^&*()", result.stdout)
+        self.assertIn("interned=1,1 distinct=0,0", result.stdout)
+        self.assertIn('print="abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()"',
+                      result.stdout)
+
+        # Short appends copy into one flat block; with every rt_alloc a
+        # separate malloc, ASan sees any read past the left operand.
+        short = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            int main(void) {
+                RuntimeValue *s = rt_value_string("ab");
+                for (int i = 0; i < 20; i++) s = rt_string_append(s, rt_value_string("c"));
+                printf("short=%s\n", rt_string_chars(rt_string_append(rt_value_string("x"), s)));
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(short, env={"MONAD_ALLOC": "malloc",
+                                                  "ASAN_OPTIONS": "detect_leaks=0"},
+                                      cflags=("-fsanitize=address",))
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("short=xabcccccccccccccccccccc", result.stdout)
+
+    def test_persistent_vectors_index_concat_and_slice(self):
+        """TEST-ID: tests.runtime.rrb-vectors
+        TEST-CONTEXT: monadc.context.runtime.runtime-set
+        TEST-PURPOSE: RRB vectors index, assoc, conj, concat and slice correctly across node boundaries, leave older versions intact, build through transients, and are accepted by the generic rt_coll_* entry points.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            static int matches(RuntimeVector *v, int64_t lo, int64_t n) {
+                if (rt_vector_count(v) != n) return 0;
+                for (int64_t i = 0; i < n; i++)
+                    if (rt_unbox_int(rt_vector_nth(v, i)) != lo + i) return 0;
+                return 1;
+            }
+
+            int main(void) {
+                RuntimeVector *v = rt_vector_new();
+                for (int64_t i = 0; i < 5000; i++) v = rt_vector_conj(v, rt_value_int(i));
+                RuntimeVector *w = rt_vector_assoc(v, 1234, rt_value_int(-1));
+                printf("conj=%d assoc=%lld,%lld\n", matches(v, 0, 5000),
+                       (long long)rt_unbox_int(rt_vector_nth(w, 1234)),
+                       (long long)rt_unbox_int(rt_vector_nth(v, 1234)));
+
+                RuntimeVector *cat = rt_vector_new();
+                int64_t next = 0;
+                for (int piece = 0; piece < 3000; piece++) {
+                    RuntimeVector *p = rt_vector_new();
+                    for (int k = 0; k < piece % 7; k++) p = rt_vector_conj(p, rt_value_int(next++));
+                    cat = rt_vector_concat(cat, p);
+                }
+                printf("concat=%d,%lld shallow=%d\n", matches(cat, 0, next),
+                       (long long)rt_vector_count(cat), cat->shift <= 15);
+
+                RuntimeVector *mid = rt_vector_slice(cat, 333, 7777);
+                RuntimeVector *joined = rt_vector_concat(rt_vector_slice(cat, 0, 333),
+                                                         rt_vector_slice(cat, 333, next));
+                printf("slice=%d rejoin=%d\n", matches(mid, 333, 7777 - 333),
+                       matches(joined, 0, next));
+
+                RuntimeVector *t = rt_vector_transient(v);
+                for (int64_t i = 5000; i < 6000; i++) rt_vector_conj_mut(t, rt_value_int(i));
+                rt_vector_assoc_mut(t, 0, rt_value_int(0));
+                RuntimeVector *built = rt_vector_persistent(t);
+                printf("transient=%d,%d\n", matches(built, 0, 6000), matches(v, 0, 5000));
+
+                RuntimeValue *a = rt_value_vector(rt_vector_slice(v, 0, 40));
+                RuntimeValue *b = rt_value_vector(rt_vector_slice(v, 40, 100));
+                RuntimeValue *ab = rt_coll_concat(a, b);
+                RuntimeValue *more = rt_coll_concat(ab, rt_value_int(100));
+                RuntimeValue *dropped = rt_coll_drop(more, 90);
+                printf("coll=%d,%lld,%lld contains=%d starts=%d\n",
+                       rt_type_of(ab) == RT_VECTOR, (long long)rt_coll_count(more),
+                       (long long)rt_coll_count(dropped),
+                       rt_coll_contains(more, rt_value_int(77)),
+                       rt_coll_starts_with(dropped, rt_value_vector(rt_vector_slice(v, 90, 92))));
+
+                RuntimeValue *same = rt_value_vector(rt_vector_slice(v, 0, 100));
+                RuntimeMap *m = rt_map_assoc(rt_map_new(), ab, rt_value_int(1));
+                printf("equal=%d found=%d list=%lld\n", rt_equal_p(ab, same),
+                       rt_map_contains(m, same),
+                       (long long)rt_list_length(rt_unbox_list(dropped)));
+
+                printf("print=");
+                rt_print_value(dropped);
+                printf("\n");
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("conj=1 assoc=-1,1234", result.stdout)
+        self.assertIn("concat=1,8994 shallow=1", result.stdout)
+        self.assertIn("slice=1 rejoin=1", result.stdout)
+        self.assertIn("transient=1,1", result.stdout)
+        self.assertIn("coll=1,101,11 contains=1 starts=1", result.stdout)
+        self.assertIn("equal=1 found=1 list=11", result.stdout)
+        self.assertIn("print=[90 91 92 93 94 95 96 97 98 99 100]", result.stdout)
+
+
+    def test_bignum_arithmetic_promotes_and_demotes(self):
+        """TEST-ID: tests.runtime.bignum-fast-path
+        TEST-CONTEXT: monadc.context.runtime.numbers
+        TEST-PURPOSE: Integer arithmetic stays on int64 until it overflows, promotes to GMP only then, demotes results that fit back to RT_INT, and the in-place accumulator agrees with repeated boxed multiplication.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdint.h>
+            #include <stdio.h>
+
+            static const char *kind(RuntimeValue *v) {
+                return rt_type_of(v) == RT_INT ? "int" : rt_value_is_bignum(v) ? "big" : "?";
+            }
+
+            int main(void) {
+                RuntimeValue *max = rt_value_int(INT64_MAX);
+                RuntimeValue *up = rt_bignum_add(max, rt_value_int(1));
+                RuntimeValue *down = rt_bignum_sub(up, rt_value_int(1));
+                printf("add=%s sub=%s,%d\n", kind(up), kind(down), rt_int_val(down) == INT64_MAX);
+                printf("small=%s,%lld\n", kind(rt_bignum_mul(rt_value_int(-7), rt_value_int(6))),
+                       (long long)rt_int_val(rt_bignum_mul(rt_value_int(-7), rt_value_int(6))));
+
+                RuntimeValue *neg = rt_bignum_div(rt_value_int(INT64_MIN), rt_value_int(-1));
+                printf("minneg=%s ", kind(neg));
+                rt_print_value(neg);
+                printf("\n");
+
+                RuntimeValue *f = rt_value_int(1);
+                for (int64_t i = 1; i <= 30; i++) f = rt_bignum_mul(f, rt_value_int(i));
+                RuntimeValue *g = rt_bignum_product_list(rt_list_range(1, 30));
+                RuntimeValue *h = rt_bignum_product_list(rt_list_range(1, 29));
+                RuntimeValue *q = rt_bignum_div(g, h);
+                printf("fact=%d,%d quot=%s,%lld\n", rt_equal_p(f, g), rt_equal_p(f, rt_value_bignum_from_str("265252859812191058636308480000000")),
+                       kind(q), (long long)rt_int_val(q));
+                printf("fact30=");
+                rt_print_value(g);
+                printf("\n");
+
+                RuntimeBignumAcc *acc = rt_bignum_acc_new(g);
+                rt_bignum_acc_add(acc, rt_bignum_sub(rt_value_int(0), g));
+                rt_bignum_acc_add(acc, rt_value_int(5));
+                RuntimeValue *five = rt_bignum_acc_finish(acc);
+                RuntimeValue *sum = rt_bignum_sum_list(rt_list_range(1, 100));
+                printf("acc=%s,%lld sum=%lld str=%s\n", kind(five), (long long)rt_int_val(five),
+                       (long long)rt_int_val(sum), kind(rt_value_bignum_from_str("-42")));
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("add=big sub=int,1", result.stdout)
+        self.assertIn("small=int,-42", result.stdout)
+        self.assertIn("minneg=big 9223372036854775808", result.stdout)
+        self.assertIn("fact=1,1 quot=int,30", result.stdout)
+        self.assertIn("fact30=265252859812191058636308480000000", result.stdout)
+        self.assertIn("acc=int,5 sum=5050 str=int", result.stdout)
+
+
+    def test_closures_are_single_blocks_with_direct_entries(self):
+        """TEST-ID: tests.runtime.closure-direct-calls
+        TEST-CONTEXT: monadc.context.runtime.closures
+        TEST-PURPOSE: Closures keep their captures inline and their name uncopied, rt_value_closure_init builds one in caller storage, and rt_closure_call1/2/3 enter the direct entry when the arity matches while falling back to the argv entry otherwise.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            static int argv_calls = 0;
+
+            static RuntimeValue *sum_argv(void *env, int n, RuntimeValue **args) {
+                void **captures = env;
+                int64_t total = captures ? rt_unbox_int(captures[0]) : 0;
+                argv_calls++;
+                for (int i = 0; i < n; i++) total += rt_unbox_int(args[i]);
+                return rt_value_int(total);
+            }
+
+            static RuntimeValue *sum2_direct(void *env, RuntimeValue *a, RuntimeValue *b) {
+                void **captures = env;
+                return rt_value_int(rt_unbox_int(captures[0]) + rt_unbox_int(a) + rt_unbox_int(b));
+            }
+
+            int main(void) {
+                static const char name[] = "adder";
+                void *env[] = {rt_value_int(100)};
+                RuntimeValue *add = rt_value_closure_direct((void *)sum_argv, (void *)sum2_direct,
+                                                            env, 1, 2, name);
+                RuntimeClosure *c = add->data.closure_val;
+                env[0] = rt_value_int(0);
+                printf("inline=%d same_block=%d name=%d\n", c->env == c->captures,
+                       (char *)c > (char *)add && (char *)c < (char *)add + 64, c->name == name);
+
+                RuntimeValue *two = rt_closure_call2(add, rt_value_int(1), rt_value_int(2));
+                printf("direct=%lld argv_calls=%d\n", (long long)rt_unbox_int(two), argv_calls);
+                RuntimeValue *one = rt_closure_call1(add, rt_value_int(5));
+                RuntimeValue *three = rt_closure_call3(add, rt_value_int(1), rt_value_int(2),
+                                                       rt_value_int(3));
+                printf("fallback=%lld,%lld argv_calls=%d\n", (long long)rt_unbox_int(one),
+                       (long long)rt_unbox_int(three), argv_calls);
+
+                RuntimeValue *plain = rt_value_closure((void *)sum_argv, NULL, 0, 1);
+                RuntimeValue *args[] = {rt_value_int(7)};
+                printf("plain=%lld,%lld nil=%d\n",
+                       (long long)rt_unbox_int(rt_closure_call1(plain, rt_value_int(7))),
+                       (long long)rt_unbox_int(rt_closure_calln(plain, 1, args)),
+                       rt_type_of(rt_closure_call1(rt_value_int(1), rt_value_int(1))) == RT_NIL);
+                printf("print=");
+                rt_print_value(add);
+                printf("\n");
+
+                void *block[RT_CLOSURE_BLOCK_SIZE(1) / sizeof(void *) + 1];
+                env[0] = rt_value_int(100);
+                RuntimeValue *stack = rt_value_closure_init(block, (void *)sum_argv,
+                                                            (void *)sum2_direct, env, 1, 2, NULL);
+                printf("stack=%d,%lld\n", (void *)stack == (void *)block,
+                       (long long)rt_unbox_int(rt_closure_call2(stack, rt_value_int(1),
+                                                                rt_value_int(2))));
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("inline=1 same_block=1 name=1", result.stdout)
+        self.assertIn("direct=103 argv_calls=0", result.stdout)
+        self.assertIn("fallback=105,106 argv_calls=2", result.stdout)
+        self.assertIn("plain=7,7 nil=1", result.stdout)
+        self.assertIn("print=adder/2", result.stdout)
+        self.assertIn("stack=1,103", result.stdout)
+
+
+    def test_thunks_update_in_place_and_blackhole(self):
+        """TEST-ID: tests.runtime.thunk-blackholing
+        TEST-CONTEXT: monadc.context.runtime.laziness
+        TEST-PURPOSE: Forcing a thunk or lazy cons slot drops its fn/env, collapses thunk-returning-thunk chains to one value, reports <<loop>> for a self-dependent thunk, and rt_thunk_unwind restores thunks abandoned by a longjmp.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c, repl.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <setjmp.h>
+            #include <stdio.h>
+            #include <stdlib.h>
+
+            static int calls = 0;
+            static jmp_buf escape;
+            static int escape_armed = 0;
+            static RuntimeThunk *self_ref;
+
+            static RuntimeValue *answer(void *env) { (void)env; calls++; return rt_value_int(42); }
+            static RuntimeValue *wrap(void *env) {
+                calls++;
+                return rt_value_thunk(rt_thunk_create(env ? wrap : answer, NULL));
+            }
+            static RuntimeValue *nothing(void *env) {
+                (void)env;
+                return rt_value_list(rt_list_empty());
+            }
+            static RuntimeValue *tail(void *env) {
+                (void)env;
+                return rt_value_thunk(rt_thunk_create(nothing, NULL));
+            }
+            static RuntimeValue *loop(void *env) { (void)env; return rt_force(self_ref); }
+            static RuntimeValue *flaky(void *env) {
+                (void)env;
+                if (escape_armed) longjmp(escape, 1);
+                return rt_value_int(7);
+            }
+
+            int main(void) {
+                if (getenv("THUNK_LOOP")) {
+                    self_ref = rt_thunk_create(loop, NULL);
+                    rt_force(self_ref);
+                    return 0;
+                }
+
+                RuntimeThunk *outer = rt_thunk_create(wrap, (void *)1);
+                RuntimeValue *v = rt_force(outer);
+                printf("chain=%lld calls=%d cleared=%d\n", (long long)rt_unbox_int(v), calls,
+                       !outer->fn && !outer->env && rt_type_of(outer->value) == RT_INT);
+                rt_force(outer);
+                printf("again=%d\n", calls);
+
+                RuntimeList *xs = rt_list_lazy_cons(rt_thunk_of_value(rt_value_int(1)),
+                                                    rt_thunk_create(tail, NULL));
+                RuntimeList *rest = rt_list_cdr(xs);
+                RuntimeValue *t = xs->cell->tail_val;
+                printf("cell=%d,%d type=%d empty=%d\n", xs->cell->tail_fn == NULL,
+                       xs->cell->tail_env == NULL, t && rt_type_of(t) == RT_LIST,
+                       rt_list_is_empty_list(rest));
+
+                RuntimeThunk *f = rt_thunk_create(flaky, NULL);
+                escape_armed = 1;
+                if (setjmp(escape) == 0) rt_force(f);
+                rt_thunk_unwind();
+                escape_armed = 0;
+                printf("unwind=%lld\n", (long long)rt_unbox_int(rt_force(f)));
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("chain=42 calls=3 cleared=1", result.stdout)
+        self.assertIn("again=3", result.stdout)
+        self.assertIn("cell=1,1 type=1 empty=1", result.stdout)
+        self.assertIn("unwind=7", result.stdout)
+
+        looped = self.compile_and_run(harness, env={"THUNK_LOOP": "1"})
+        self.assertNotEqual(looped.returncode, 0)
+        self.assertIn("<<loop>>", looped.stderr)
+
+
+    def test_unboxed_array_kernels_match_the_scalar_loops(self):
+        """TEST-ID: tests.runtime.array-kernels
+        TEST-CONTEXT: monadc.context.runtime.array-ops
+        TEST-PURPOSE: the sum, dot, affine, min/max and prefix-scan kernels over unboxed Int and Float storage handle vector tails and wrap Int overflow, and the SIMD build returns bit-identical Float results to the scalar build.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            int main(void) {
+                int64_t a[7] = {1, -2, 3, 4, 5, 6, INT64_MAX};
+                int64_t b[7] = {7, 6, 5, 4, 3, 2, 1};
+                int64_t o[7];
+                double  x[9], y[9], z[9];
+                for (int i = 0; i < 9; i++) {
+                    x[i] = 1.0 / (i + 1);
+                    y[i] = i * 0.1 - 0.35;
+                }
+
+                printf("isum=%lld\n", (long long)rt_arr_sum_i64(a, 6));
+                printf("iwrap=%d\n", rt_arr_sum_i64(a, 7) == INT64_MIN + 16);
+                printf("idot=%lld\n", (long long)rt_arr_dot_i64(a, b, 6));
+                rt_arr_affine_i64(o, a, 6, 3, -1);
+                printf("iaff=%lld,%lld,%lld\n", (long long)o[0], (long long)o[1], (long long)o[5]);
+                rt_arr_min_i64(o, a, b, 7);
+                printf("imin=%lld,%lld,%lld\n", (long long)o[0], (long long)o[3], (long long)o[6]);
+                rt_arr_max_i64(o, a, b, 7);
+                printf("imax=%lld,%lld\n", (long long)o[0], (long long)o[2]);
+                rt_arr_scan_i64(o, a, 6);
+                printf("iscan=%lld,%lld,%lld,%lld,%lld,%lld\n", (long long)o[0], (long long)o[1],
+                       (long long)o[2], (long long)o[3], (long long)o[4], (long long)o[5]);
+                rt_arr_scan_i64(o, b, 5);
+                printf("iscan5=%lld\n", (long long)o[4]);
+
+                printf("fsum=%a\n", rt_arr_sum_f64(x, 9));
+                printf("fdot=%a\n", rt_arr_dot_f64(x, y, 9));
+                rt_arr_affine_f64(z, x, 9, 2.0, 0.5);
+                printf("faff=%g,%g\n", z[0], z[8]);
+                rt_arr_min_f64(z, x, y, 9);
+                printf("fmin=%g,%g\n", z[0], z[8]);
+                rt_arr_max_f64(z, x, y, 9);
+                printf("fmax=%g,%g\n", z[0], z[8]);
+                rt_arr_scan_f64(z, x, 9);
+                printf("fscan=%a\n", z[8]);
+                printf("empty=%lld,%g\n", (long long)rt_arr_sum_i64(a, 0), rt_arr_sum_f64(x, 0));
+                return 0;
+            }
+            '''
+        )
+
+        vector = self.compile_and_run(harness)
+        self.assertEqual(vector.returncode, 0, vector.stderr)
+        lines = vector.stdout.splitlines()
+        self.assertIn("isum=17", lines)
+        self.assertIn("iwrap=1", lines)
+        self.assertIn("idot=53", lines)
+        self.assertIn("iaff=2,-7,17", lines)
+        self.assertIn("imin=1,4,1", lines)
+        self.assertIn("imax=7,5", lines)
+        self.assertIn("iscan=1,-1,2,6,11,17", lines)
+        self.assertIn("iscan5=25", lines)
+        self.assertIn("faff=2.5,0.722222", lines)
+        self.assertIn("fmin=-0.35,0.111111", lines)
+        self.assertIn("fmax=1,0.45", lines)
+        self.assertIn("empty=0,0", lines)
+
+        scalar = self.compile_and_run(harness, cflags=("-U__SSE2__", "-U__ARM_NEON"))
+        self.assertEqual(scalar.returncode, 0, scalar.stderr)
+        self.assertEqual(scalar.stdout, vector.stdout)
+
+    def test_pool_runs_every_index_once_and_parallel_ops_keep_order(self):
+        """TEST-ID: tests.runtime.work-stealing-pool
+        TEST-CONTEXT: monadc.context.runtime.list-ops
+        TEST-PURPOSE: rt_pool_for visits each index exactly once across workers, runs nested calls inline, and rt_par_map/filter/fold return the same ordered results as a sequential pass for lists, arrays and sets.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+
+            #define N 100000
+            static int hits[N];
+            static int nested_inline = 1;
+
+            static void inner(void *ctx, int64_t lo, int64_t hi) {
+                (void)ctx;
+                if (lo != 0 || hi != 10) nested_inline = 0;
+            }
+
+            static void mark(void *ctx, int64_t lo, int64_t hi) {
+                (void)ctx;
+                for (int64_t i = lo; i < hi; i++) __atomic_add_fetch(&hits[i], 1, __ATOMIC_RELAXED);
+                rt_pool_for(10, 1, inner, NULL);
+            }
+
+            static RuntimeValue *sq(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                int64_t x = rt_unbox_int(args[0]);
+                return rt_value_int(x * x);
+            }
+
+            static RuntimeValue *odd(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) & 1);
+            }
+
+            static RuntimeValue *add(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) + rt_unbox_int(args[1]));
+            }
+
+            // Associative but not commutative: only the order decides the result.
+            static RuntimeValue *last(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return args[1];
+            }
+
+            int main(void) {
+                rt_pool_for(N, 64, mark, NULL);
+                int once = 1;
+                for (int i = 0; i < N; i++) once &= hits[i] == 1;
+                printf("pool=%d once=%d nested=%d\n", rt_pool_size(), once, nested_inline);
+
+                RuntimeValue *xs  = rt_value_list(rt_list_range(0, 4999));
+                RuntimeValue *map = rt_par_map(rt_value_closure((void *)sq, NULL, 0, 1), xs);
+                RuntimeList  *ml  = map->data.list_val;
+                int64_t sum = 0, ordered = 1, i = 0;
+                for (RuntimeList *l = ml; !rt_list_is_empty_list(l); l = rt_list_cdr(l), i++) {
+                    int64_t v = rt_unbox_int(rt_list_car(l));
+                    ordered &= v == i * i;
+                    sum += v;
+                }
+                printf("map=%lld ordered=%lld sum=%lld\n", (long long)i, (long long)ordered,
+                       (long long)sum);
+
+                RuntimeValue *flt = rt_par_filter(rt_value_closure((void *)odd, NULL, 0, 1), xs);
+                RuntimeList  *fl  = flt->data.list_val;
+                printf("filter=%lld first=%lld\n", (long long)rt_list_length(fl),
+                       (long long)rt_unbox_int(rt_list_car(fl)));
+
+                RuntimeValue *plus = rt_value_closure((void *)add, NULL, 0, 2);
+                RuntimeValue *step = rt_value_closure((void *)last, NULL, 0, 2);
+                printf("fold=%lld,%lld\n",
+                       (long long)rt_unbox_int(rt_par_fold(plus, rt_value_int(7), xs)),
+                       (long long)rt_unbox_int(rt_par_fold(step, rt_value_int(7), xs)));
+
+                RuntimeValue *arr = rt_value_array(100);
+                for (size_t k = 0; k < 100; k++) rt_array_set(arr, k, rt_value_int((int64_t)k));
+                RuntimeValue *amap = rt_par_map(rt_value_closure((void *)sq, NULL, 0, 1), arr);
+                printf("array=%d len=%lld last=%lld\n", rt_type_of(amap) == RT_ARRAY,
+                       (long long)rt_array_length(amap),
+                       (long long)rt_unbox_int(rt_array_get(amap, 99)));
+
+                RuntimeValue *set  = rt_value_set(rt_set_from_list(rt_list_range(0, 199)));
+                RuntimeValue *sodd = rt_par_filter(rt_value_closure((void *)odd, NULL, 0, 1), set);
+                printf("set=%d count=%lld\n", rt_type_of(sodd) == RT_SET,
+                       (long long)rt_set_count(sodd->data.set_val));
+
+                RuntimeValue *none = rt_par_fold(step, rt_value_int(3), rt_value_list(rt_list_empty()));
+                printf("empty=%lld\n", (long long)rt_unbox_int(none));
+                return 0;
+            }
+            '''
+        )
+
+        for threads in ("4", "1"):
+            result = self.compile_and_run(harness, env={"MONAD_THREADS": threads})
+            self.assertEqual(result.returncode, 0, result.stderr)
+            lines = result.stdout.splitlines()
+            self.assertIn(f"pool={threads} once=1 nested=1", lines)
+            self.assertIn("map=5000 ordered=1 sum=41654167500", lines)
+            self.assertIn("filter=2500 first=1", lines)
+            self.assertIn("fold=12497507,4999", lines)
+            self.assertIn("array=1 len=100 last=9801", lines)
+            self.assertIn("set=1 count=100", lines)
+            self.assertIn("empty=3", lines)
+
+    def test_shared_thunk_forced_from_pool_workers(self):
+        """TEST-ID: tests.runtime.thunk-shared-across-workers
+        TEST-CONTEXT: monadc.context.runtime.laziness
+        TEST-PURPOSE: pool workers that force the same suspension through rt_par_map wait for the thread evaluating it instead of reporting <<loop>>, the suspension runs once, and every worker sees its value.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+            #include <time.h>
+
+            static RuntimeThunk *shared;
+            static int evaluations;
+
+            static RuntimeValue *slow(void *env) {
+                (void)env;
+                __atomic_add_fetch(&evaluations, 1, __ATOMIC_RELAXED);
+                struct timespec ts = {0, 20 * 1000 * 1000};
+                nanosleep(&ts, NULL);
+                return rt_value_int(1000);
+            }
+
+            static RuntimeValue *plus_shared(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                return rt_value_int(rt_unbox_int(args[0]) + rt_unbox_int(rt_force(shared)));
+            }
+
+            int main(void) {
+                shared = rt_thunk_create(slow, NULL);
+                RuntimeValue *xs  = rt_value_list(rt_list_range(0, 4999));
+                RuntimeValue *map = rt_par_map(rt_value_closure((void *)plus_shared, NULL, 0, 1), xs);
+                int64_t sum = 0;
+                for (RuntimeList *l = map->data.list_val; !rt_list_is_empty_list(l); l = rt_list_cdr(l))
+                    sum += rt_unbox_int(rt_list_car(l));
+                printf("evaluations=%d sum=%lld\n", evaluations, (long long)sum);
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness, env={"MONAD_THREADS": "4"})
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertNotIn("<<loop>>", result.stderr)
+        self.assertIn("evaluations=1 sum=17497500", result.stdout.splitlines())
+
+    def test_pool_workers_share_ropes_and_the_intern_table(self):
+        """TEST-ID: tests.runtime.pool-strings
+        TEST-CONTEXT: monadc.context.runtime.list-ops
+        TEST-PURPOSE: rt_par_map bodies that read one shared rope and intern overlapping symbol names all see the same text, get one value per name, and leave the shared rope unmodified.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            #define NAMES 5000
+            static RuntimeValue *rope;
+            static RuntimeValue *seen[NAMES];
+            static int mismatched;
+
+            static RuntimeValue *touch(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                int64_t x = rt_unbox_int(args[0]);
+                const char *text = rt_string_chars(rope);
+                if (strlen(text) != rt_string_length(rope) || text[0] != 'a')
+                    __atomic_store_n(&mismatched, 1, __ATOMIC_RELAXED);
+                char name[32];
+                snprintf(name, sizeof(name), "sym%lld", (long long)(x % NAMES));
+                RuntimeValue *sym = rt_value_symbol(name);
+                RuntimeValue *expect = NULL;
+                if (!__atomic_compare_exchange_n(&seen[x % NAMES], &expect, sym, 0,
+                                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+                    expect != sym)
+                    __atomic_store_n(&mismatched, 1, __ATOMIC_RELAXED);
+                return rt_value_int((int64_t)rt_string_length(rope));
+            }
+
+            int main(void) {
+                rope = rt_value_string("a");
+                for (int i = 0; i < 2000; i++)
+                    rope = rt_string_append(rope, rt_value_string("bcdefghijklmnopqrstuvwxyz0123456789"));
+                RuntimeValue *xs  = rt_value_list(rt_list_range(0, 19999));
+                RuntimeValue *map = rt_par_map(rt_value_closure((void *)touch, NULL, 0, 1), xs);
+                int64_t total = 0;
+                for (RuntimeList *l = map->data.list_val; !rt_list_is_empty_list(l); l = rt_list_cdr(l))
+                    total += rt_unbox_int(rt_list_car(l));
+                int same = 1;
+                for (int i = 0; i < NAMES; i++) {
+                    char name[32];
+                    snprintf(name, sizeof(name), "sym%d", i);
+                    same &= rt_value_symbol(name) == seen[i];
+                }
+                printf("mismatched=%d same=%d total=%lld\n", mismatched, same, (long long)total);
+                return 0;
+            }
+            '''
+        )
+
+        result = self.compile_and_run(harness, env={"MONAD_THREADS": "4"})
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertIn("mismatched=0 same=1 total=1400020000", result.stdout.splitlines())
+
+    def test_fibers_interleave_on_io_and_keep_their_roots(self):
+        """TEST-ID: tests.runtime.fiber-scheduler
+        TEST-CONTEXT: monadc.context.runtime.fibers
+        TEST-PURPOSE: hundreds of fibers on one thread ping-pong over socket pairs and an accepting listener through rt_fiber_read/write/accept, rt_fiber_yield round-robins, values rooted only on parked fiber stacks survive collections, and the fds the scheduler made non-blocking are blocking again once it returns.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: runtime.h, runtime.c
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "runtime.h"
+            #include <fcntl.h>
+            #include <stdio.h>
+            #include <string.h>
+            #include <sys/socket.h>
+            #include <sys/un.h>
+            #include <unistd.h>
+
+            #define PAIRS  300
+            #define ROUNDS 40
+            #define CONNS  20
+
+            static int     fds[PAIRS][2];
+            static int64_t first_id;
+            static long    echoed, kept = 1;
+            static char    trace[64];
+            static int     trace_len;
+            static int     listener;
+            static struct sockaddr_un addr;
+            static long    served;
+
+            static int64_t list_sum(RuntimeList *xs) {
+                int64_t s = 0;
+                for (; !rt_list_is_empty_list(xs); xs = rt_list_cdr(xs)) s += rt_unbox_int(rt_list_car(xs));
+                return s;
+            }
+
+            static RuntimeValue *peer(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                int64_t k = rt_unbox_int(args[0]) - first_id;
+                int     pair = (int)(k / 2), client = (int)(k % 2);
+                int     fd = fds[pair][client];
+                RuntimeList *mine = rt_list_range(k * 100, k * 100 + 99);
+                for (int r = 0; r < ROUNDS; r++) {
+                    int v = r, got = -1;
+                    if (client) {
+                        rt_fiber_write(fd, &v, sizeof v);
+                        rt_fiber_read(fd, &got, sizeof got);
+                        if (got == r + 1) echoed++;
+                    } else {
+                        rt_fiber_read(fd, &got, sizeof got);
+                        got++;
+                        rt_fiber_write(fd, &got, sizeof got);
+                    }
+                    rt_list_length(rt_list_range(0, 300));   // churn for the collector
+                }
+                kept &= list_sum(mine) == 100 * k * 100 + 4950;
+                return rt_value_int(0);
+            }
+
+            static RuntimeValue *ticker(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                for (int i = 0; i < 3; i++) {
+                    trace[trace_len++] = (char)('0' + rt_unbox_int(args[0]) % 3);
+                    rt_fiber_yield(args[0]);
+                }
+                return args[0];
+            }
+
+            static RuntimeValue *handler(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n; (void)args;
+                int c = (int)rt_fiber_accept(listener), v = 0;
+                if (c >= 0 && rt_fiber_read(c, &v, sizeof v) == sizeof v) {
+                    v *= 2;
+                    rt_fiber_write(c, &v, sizeof v);
+                    served++;
+                }
+                if (c >= 0) close(c);
+                return rt_value_int(0);
+            }
+
+            static RuntimeValue *dialer(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n;
+                int s = socket(AF_UNIX, SOCK_STREAM, 0), v = (int)rt_unbox_int(args[0]), got = 0;
+                connect(s, (struct sockaddr *)&addr, sizeof addr);
+                rt_fiber_write(s, &v, sizeof v);
+                rt_fiber_read(s, &got, sizeof got);
+                close(s);
+                return rt_value_int(got == 2 * v);
+            }
+
+            static RuntimeValue *acceptor(void *env, int n, RuntimeValue **args) {
+                (void)env; (void)n; (void)args;
+                for (int i = 0; i < CONNS; i++)
+                    rt_fiber_spawn(rt_value_closure((void *)handler, NULL, 0, 1));
+                for (int i = 0; i < CONNS; i++)
+                    rt_fiber_spawn(rt_value_closure((void *)dialer, NULL, 0, 1));
+                return rt_value_int(0);
+            }
+
+            int main(void) {
+                rt_gc_init(__builtin_frame_address(0));
+
+                RuntimeValue *fn = rt_value_closure((void *)peer, NULL, 0, 1);
+                for (int p = 0; p < PAIRS; p++) {
+                    socketpair(AF_UNIX, SOCK_STREAM, 0, fds[p]);
+                    int64_t a = rt_fiber_spawn(fn);
+                    rt_fiber_spawn(fn);
+                    if (p == 0) first_id = a;
+                }
+                int64_t done = rt_fiber_run(NULL);
+                printf("fibers=%lld echoed=%ld kept=%ld\n", (long long)done, echoed, kept);
+
+                RuntimeValue *tick = rt_value_closure((void *)ticker, NULL, 0, 1);
+                for (int i = 0; i < 3; i++) rt_fiber_spawn(tick);
+                rt_fiber_run(NULL);
+                trace[trace_len] = 0;
+                printf("trace=%s\n", trace);
+
+                listener = socket(AF_UNIX, SOCK_STREAM, 0);
+                addr.sun_family = AF_UNIX;
+                snprintf(addr.sun_path + 1, sizeof addr.sun_path - 1, "monad-fiber-%d", (int)getpid());
+                bind(listener, (struct sockaddr *)&addr, sizeof addr);
+                listen(listener, CONNS);
+                int64_t conns = rt_fiber_run(rt_value_closure((void *)acceptor, NULL, 0, 1));
+                printf("accept=%lld served=%ld\n", (long long)conns, served);
+                printf("nonblocking=%d\n",
+                       !!(fcntl(fds[0][0], F_GETFL) & O_NONBLOCK) +
+                       !!(fcntl(listener, F_GETFL) & O_NONBLOCK));
+
+                printf("outside=%lld yield=%lld\n",
+                       (long long)rt_fiber_write(fds[0][0], "x", 1),
+                       (long long)rt_unbox_int(rt_fiber_yield(rt_value_int(9))));
+                return 0;
+            }
+            '''
+        )
+
+        for env in ({}, {"MONAD_GC": "1", "MONAD_GC_NURSERY": "256K", "MONAD_FIBER_STACK": "65536"}):
+            result = self.compile_and_run(harness, env=env)
+            self.assertEqual(result.returncode, 0, result.stderr)
+            lines = result.stdout.splitlines()
+            self.assertIn(f"fibers={2 * 300} echoed={300 * 40} kept=1", lines)
+            self.assertIn("trace=120120120", lines)
+            self.assertIn("accept=41 served=20", lines)
+            self.assertIn("nonblocking=0", lines)
+            self.assertIn("outside=1 yield=9", lines)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -65,6 +65,45 @@ class TailCallTests(unittest.TestCase):
                 ),
             )
 
+    def test_self_tail_calls_loop_and_report_lists_the_rest(self):
+        source = """\
+(module Main)
+(define (count-down [n : Int] [acc : Int] -> Int)
+  (if (= n 0) acc (count-down (- n 1) (+ acc 1))))
+(define (fib [n : Int] -> Int)
+  (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+(show (count-down 10000000 0))
+(show (fib 10))
+"""
+        with tempfile.TemporaryDirectory(prefix="monadc-tailloop-") as tmp:
+            src = Path(tmp) / "tailloop.mon"
+            out = Path(tmp) / "tailloop"
+            src.write_text(source)
+
+            compile_result = self.run_monad(
+                [str(src), "-O0", "--emit-ir", "--report-tail-calls", "-o", str(out)]
+            )
+            self.assertEqual(compile_result.returncode, 0, compile_result.stdout)
+            self.assertRegex(
+                compile_result.stdout,
+                r"\[tail\] [^\n]*fib[^:\n]*: 2 recursive calls not in tail position",
+            )
+            self.assertNotRegex(compile_result.stdout, r"\[tail\] [^\n]*count-down")
+
+            run_result = subprocess.run(
+                [str(out)],
+                text=True,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.STDOUT,
+                check=False,
+                timeout=10,
+            )
+            self.assertEqual(run_result.returncode, 0, run_result.stdout)
+            self.assertEqual(run_result.stdout.splitlines()[:2], ["10000000", "55"])
+
+            ir = src.with_suffix(".ll").read_text()
+            self.assertIn("tail_loop:", ir)
+
 
 if __name__ == "__main__":
     unittest.main()
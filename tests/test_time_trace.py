@@ -0,0 +1,172 @@
+import json
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+
+HARNESS = textwrap.dedent(
+    r'''
+    #include "time_trace.h"
+    #include <pthread.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <time.h>
+
+    static void sleep_ms(long ms) {
+        struct timespec ts = { 0, ms * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+
+    static void *worker(void *arg) {
+        (void)arg;
+        time_trace_begin("worker", "emit");
+        sleep_ms(5);
+        time_trace_end();
+        return NULL;
+    }
+
+    int main(int argc, char **argv) {
+        (void)argc;
+        time_trace_begin("before", NULL);   /* no session yet */
+        time_trace_end();
+
+        time_trace_start(argv[1]);
+        time_trace_begin("outer", NULL);
+        char *volatile block = malloc(1 << 20);
+        memset(block, 1, 1 << 20);
+        free(block);
+        time_trace_begin("inner", "a \"quoted\" path\\x");
+        char *volatile aligned = aligned_alloc(64, 1 << 16);
+        memset(aligned, 1, 1 << 16);
+        free(aligned);
+        sleep_ms(20);
+        time_trace_end();
+        time_trace_end();
+
+        pthread_t t;
+        pthread_create(&t, NULL, worker, NULL);
+        pthread_join(t, NULL);
+
+        int depth = time_trace_depth();
+        time_trace_begin("module", "Main.mon");
+        time_trace_begin("module", "Dep.mon");
+        sleep_ms(5);
+        time_trace_begin("unclosed", NULL);
+        time_trace_unwind(depth);
+
+        return time_trace_finish(stdout) ? 0 : 1;
+    }
+    '''
+)
+
+
+class TimeTraceTests(unittest.TestCase):
+    def run_harness(self, *cflags):
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "trace_harness.c"
+            exe = Path(td) / "trace_harness"
+            trace = Path(td) / "out.time-trace.json"
+            harness.write_text(HARNESS, encoding="utf-8")
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-O2", "-Wall", "-Wextra", "-iquote", str(ROOT),
+                 *cflags, str(ROOT / "time_trace.c"), str(harness), "-o", str(exe),
+                 "-lpthread"],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            result = subprocess.run(
+                [str(exe), str(trace)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+                timeout=60,
+            )
+            self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+            doc = json.loads(trace.read_text(encoding="utf-8"))
+        return doc, result
+
+    def test_spans_become_chrome_trace_and_summary(self):
+        """TEST-ID: tests.time-trace.chrome-trace
+        TEST-CONTEXT: monadc.context.main.compile-one
+        TEST-PURPOSE: --time-trace spans nest per thread into Chrome trace-event JSON with escaped details, per-span allocation bytes (aligned allocations included) and peak RSS in a MONAD_TIME_TRACE_ALLOC build, unwinding closes spans left open, and the summary counts a phase nested in itself once in its total.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: time_trace.h, time_trace.c
+        """
+        doc, result = self.run_harness("-DMONAD_TIME_TRACE_ALLOC")
+
+        spans = [e for e in doc["traceEvents"] if e["ph"] == "X"]
+        by_name = {}
+        for e in spans:
+            by_name.setdefault(e["name"], []).append(e)
+
+        self.assertNotIn("before", by_name)
+        self.assertEqual(sorted(by_name),
+                         ["inner", "module", "outer", "unclosed", "worker"])
+
+        outer, inner = by_name["outer"][0], by_name["inner"][0]
+        self.assertEqual(inner["args"]["detail"], 'a "quoted" path\\x')
+        self.assertGreaterEqual(inner["dur"], 20000)
+        self.assertLessEqual(outer["ts"], inner["ts"])
+        self.assertGreaterEqual(outer["ts"] + outer["dur"], inner["ts"] + inner["dur"])
+        self.assertGreaterEqual(outer["args"]["alloc_bytes"], (1 << 20) + (1 << 16))
+        self.assertGreaterEqual(inner["args"]["alloc_bytes"], 1 << 16)
+        self.assertGreater(outer["args"]["peak_rss_kb"], 0)
+
+        self.assertNotEqual(by_name["worker"][0]["tid"], outer["tid"])
+        threads = {e["tid"]: e["args"]["name"]
+                   for e in doc["traceEvents"] if e["ph"] == "M"}
+        self.assertEqual(threads[outer["tid"]], "monad")
+
+        self.assertEqual(len(by_name["module"]), 2)
+        rows = {line.split()[0]: line.split()
+                for line in result.stdout.splitlines()[2:]}
+        module = rows["module"]
+        self.assertEqual(module[1], "2")
+        outer_module = max(by_name["module"], key=lambda e: e["dur"])
+        self.assertAlmostEqual(float(module[3]), outer_module["dur"] / 1000, delta=0.2)
+        self.assertIn("wall", rows)
+        self.assertTrue(result.stdout.startswith("[time-trace] "))
+
+    def test_default_build_leaves_the_allocator_alone(self):
+        """TEST-ID: tests.time-trace.no-interposition
+        TEST-CONTEXT: monadc.context.main.compile-one
+        TEST-PURPOSE: Without MONAD_TIME_TRACE_ALLOC, time_trace.c defines no allocator symbols, so spans carry no allocation bytes and the summary's allocation column reads "-".
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: time_trace.c
+        """
+        doc, result = self.run_harness()
+        outer = next(e for e in doc["traceEvents"]
+                     if e["ph"] == "X" and e["name"] == "outer")
+        self.assertNotIn("alloc_bytes", outer["args"])
+        self.assertGreater(outer["args"]["peak_rss_kb"], 0)
+        rows = {line.split()[0]: line.split()
+                for line in result.stdout.splitlines()[2:]}
+        self.assertEqual(rows["outer"][4], "-")
+        with tempfile.TemporaryDirectory() as td:
+            obj = Path(td) / "time_trace.o"
+            subprocess.run(
+                ["gcc", "-std=gnu99", "-O2", "-iquote", str(ROOT), "-c",
+                 str(ROOT / "time_trace.c"), "-o", str(obj)],
+                check=True, cwd=ROOT)
+            symbols = subprocess.run(
+                ["nm", "--defined-only", str(obj)],
+                check=True, stdout=subprocess.PIPE, text=True).stdout.split()
+        for name in ("malloc", "calloc", "realloc", "aligned_alloc"):
+            self.assertNotIn(name, symbols)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,150 @@
+import os
+import shlex
+import subprocess
+import tempfile
+import textwrap
+import unittest
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+WISP_SOURCES = (
+    "wisp.c",
+    "reader.c",
+    "macro.c",
+    "types.c",
+    "features.c",
+    "pmatch.c",
+    "optimizations.c",
+    "scan.c",
+    "intern.c",
+    "time_trace.c",
+    "arena.c",
+)
+
+
+def llvm_config(*args: str) -> list[str]:
+    result = subprocess.run(
+        [os.environ.get("LLVM_CONFIG", "llvm-config"), *args],
+        check=True,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    return shlex.split(result.stdout)
+
+
+class WispTests(unittest.TestCase):
+    def compile_and_run(self, source: str) -> subprocess.CompletedProcess:
+        with tempfile.TemporaryDirectory() as td:
+            harness = Path(td) / "wisp_harness.c"
+            exe = Path(td) / "wisp_harness"
+            harness.write_text(source, encoding="utf-8")
+            subprocess.run(
+                [
+                    "gcc",
+                    "-std=c99",
+                    *llvm_config("--cflags"),
+                    "-iquote",
+                    str(ROOT),
+                    *(str(ROOT / src) for src in WISP_SOURCES),
+                    str(harness),
+                    "-o",
+                    str(exe),
+                    *llvm_config("--ldflags", "--libs", "core"),
+                    *llvm_config("--system-libs"),
+                    "-lm",
+                ],
+                check=True,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            return subprocess.run(
+                [str(exe)],
+                check=False,
+                cwd=ROOT,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+
+    def test_arity_table_is_keyed_on_interned_names(self):
+        """TEST-ID: tests.wisp.interned-arities
+        TEST-CONTEXT: monadc.context.wisp.arity-table
+        TEST-PURPOSE: the global Wisp arity table finds a name by its text whatever buffer it arrives in, answers unknown for a name that was never interned without interning it, overwrites an existing arity on re-registration instead of shadowing it, keeps thousands of names apart, and the registered arity decides how wisp_parse_all groups an application and when wisp_classify_input waits for more operands.
+        TEST-EXPECT: c-unit
+        TEST-TIER: regression
+        TEST-STATUS: active
+        TEST-COVERAGE: wisp.h, wisp.c, intern.h
+        """
+        harness = textwrap.dedent(
+            r'''
+            #include "wisp.h"
+            #include "intern.h"
+            #include "reader.h"
+            #include <stdio.h>
+            #include <string.h>
+
+            #define CHECK(c) do { if (!(c)) { printf("FAIL %s\n", #c); return 1; } } while (0)
+
+            static void show(const char *src) {
+                ASTList l = wisp_parse_all(src, "<test>");
+                for (size_t i = 0; i < l.count; i++) {
+                    ast_print(l.exprs[i]);
+                    printf(i + 1 < l.count ? " " : "\n");
+                }
+            }
+
+            int main(void) {
+                CHECK(wisp_get_arity("send3") == -99);      /* no table yet */
+
+                wisp_register_arity("send3", 3);
+                char copy[16];
+                strcpy(copy, "send3");
+                CHECK(wisp_get_arity(copy) == 3);
+
+                /* Unknown names miss without entering the intern table. */
+                CHECK(wisp_get_arity("never-registered-name") == -2);
+                CHECK(intern_find("never-registered-name") == NULL);
+                CHECK(wisp_get_arity("") == -2);
+
+                CHECK(wisp_classify_input("send3 a b", false) == WISP_INPUT_INCOMPLETE);
+                CHECK(wisp_classify_input("send3 a b c", false) == WISP_INPUT_COMPLETE);
+                show("show send3 1 2 3 4\n");
+
+                /* Re-registering replaces the arity in place. */
+                wisp_register_arity("send3", 2);
+                CHECK(wisp_get_arity("send3") == 2);
+                CHECK(wisp_classify_input("send3 a b", false) == WISP_INPUT_COMPLETE);
+                show("show send3 1 2 3 4\n");
+
+                char name[32];
+                for (int i = 0; i < 5000; i++) {
+                    snprintf(name, sizeof(name), "ffi_%d", i);
+                    wisp_register_arity(name, i % 7);
+                }
+                for (int i = 0; i < 5000; i++) {
+                    snprintf(name, sizeof(name), "ffi_%d", i);
+                    CHECK(wisp_get_arity(name) == i % 7);
+                }
+                CHECK(wisp_get_arity("send3") == 2);
+
+                wisp_clear_arities();
+                CHECK(wisp_get_arity("send3") == -99);
+                printf("ok\n");
+                return 0;
+            }
+            '''
+        )
+        result = self.compile_and_run(harness)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertEqual(
+            result.stdout.splitlines(),
+            ["(show (send3 1 2 3)) 4", "(show (send3 1 2)) 3 4", "ok"],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
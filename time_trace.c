@@ -0,0 +1,372 @@
+#include "time_trace.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#  define TIME_TRACE_SANITIZED 1
+#elif defined(__has_feature)
+#  if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#    define TIME_TRACE_SANITIZED 1
+#  endif
+#endif
+
+///  Allocation counter
+//
+//  Off by default: a compiler binary that defines its own malloc takes
+//  over the allocator for every library it links, whether or not a trace
+//  is running.  Builds that want the allocation column opt in with
+//  MONAD_TIME_TRACE_ALLOC (the CMake option or `make TIME_TRACE_ALLOC=1`).
+//
+//  glibc exports its allocator as __libc_malloc and friends, so that build
+//  wraps every public entry point that hands out memory -- malloc, calloc,
+//  realloc and the aligned ones -- and forwards to glibc, which keeps
+//  glibc's free correct for all of them.  Bytes are counted per thread
+//  only while a session is open.  free is left alone: the counter measures
+//  what a phase asked for, not what it still holds.  Sanitizers install
+//  their own malloc, so those builds report no allocation column.
+
+#if defined(MONAD_TIME_TRACE_ALLOC) && defined(__GLIBC__) && !defined(TIME_TRACE_SANITIZED)
+#define TIME_TRACE_ALLOC 1
+#include <errno.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+
+static bool g_tt_on;    // session flag, declared again with the state below
+static __thread uint64_t tt_alloc_bytes;
+
+static inline void count_alloc(uint64_t size) {
+    if (__atomic_load_n(&g_tt_on, __ATOMIC_RELAXED)) tt_alloc_bytes += size;
+}
+
+void *malloc(size_t size) {
+    count_alloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    count_alloc((uint64_t)count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t align, size_t size) {
+    count_alloc(size);
+    return __libc_memalign(align, size);
+}
+
+void *aligned_alloc(size_t align, size_t size) {
+    count_alloc(size);
+    return __libc_memalign(align, size);
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    if (align < sizeof(void *) || (align & (align - 1)) != 0) return EINVAL;
+    count_alloc(size);
+    void *p = __libc_memalign(align, size);
+    if (!p && size) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+static uint64_t alloc_bytes(void) { return tt_alloc_bytes; }
+#else
+static uint64_t alloc_bytes(void) { return 0; }
+#endif
+
+///  Session state
+
+#define TT_MAX_DEPTH 64
+
+typedef struct {
+    const char *name;
+    char       *detail;
+    int         tid;
+    bool        nested;    // inside another span of the same name
+    uint64_t    start_ns;  // since the session started
+    uint64_t    dur_ns;
+    uint64_t    self_ns;
+    uint64_t    alloc;     // bytes the thread allocated while the span was open
+    uint64_t    self_alloc;
+    long        rss_kb;    // process peak RSS when the span closed
+} TraceEvent;
+
+typedef struct {
+    const char *name;
+    char       *detail;
+    bool        nested;
+    uint64_t    t0;
+    uint64_t    alloc0;
+    uint64_t    child_ns;
+    uint64_t    child_alloc;
+} TraceFrame;
+
+static bool        g_tt_on;
+static char       *g_tt_path;
+static uint64_t    g_tt_t0;
+static TraceEvent *g_tt_events;
+static size_t      g_tt_count, g_tt_cap;
+static int         g_tt_threads;
+#if !defined(_WIN32)
+static pthread_mutex_t g_tt_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TT_LOCK()   pthread_mutex_lock(&g_tt_lock)
+#define TT_UNLOCK() pthread_mutex_unlock(&g_tt_lock)
+#else
+#define TT_LOCK()   ((void)0)
+#define TT_UNLOCK() ((void)0)
+#endif
+
+static __thread TraceFrame tt_stack[TT_MAX_DEPTH];
+static __thread int        tt_depth;    // may exceed TT_MAX_DEPTH; extra frames are dropped
+static __thread int        tt_tid = -1;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+#endif
+}
+
+static int thread_id(void) {
+    if (tt_tid < 0) {
+        TT_LOCK();
+        tt_tid = g_tt_threads++;
+        TT_UNLOCK();
+    }
+    return tt_tid;
+}
+
+///  Public: recording
+
+void time_trace_start(const char *path) {
+    TT_LOCK();
+    free(g_tt_path);
+    g_tt_path    = strdup(path);
+    g_tt_t0      = now_ns();
+    g_tt_count   = 0;
+    g_tt_threads = 0;
+    tt_tid       = g_tt_threads++;
+    g_tt_on      = true;
+    TT_UNLOCK();
+}
+
+bool time_trace_active(void) {
+    return g_tt_on;
+}
+
+void time_trace_begin(const char *name, const char *detail) {
+    if (!g_tt_on) return;
+    int d = tt_depth++;
+    if (d >= TT_MAX_DEPTH) return;
+    TraceFrame *f = &tt_stack[d];
+    f->name   = name;
+    f->detail = detail ? strdup(detail) : NULL;
+    f->nested = false;
+    for (int i = 0; i < d; i++)
+        if (strcmp(tt_stack[i].name, name) == 0) { f->nested = true; break; }
+    f->child_ns    = 0;
+    f->child_alloc = 0;
+    f->alloc0      = alloc_bytes();
+    f->t0          = now_ns();
+}
+
+void time_trace_end(void) {
+    if (tt_depth == 0) return;
+    int d = --tt_depth;
+    if (d >= TT_MAX_DEPTH) return;
+    uint64_t    t1    = now_ns();
+    uint64_t    alloc = alloc_bytes();
+    TraceFrame *f     = &tt_stack[d];
+
+    TraceEvent e;
+    e.name       = f->name;
+    e.detail     = f->detail;
+    e.tid        = thread_id();
+    e.nested     = f->nested;
+    e.start_ns   = f->t0 - g_tt_t0;
+    e.dur_ns     = t1 - f->t0;
+    e.self_ns    = e.dur_ns > f->child_ns ? e.dur_ns - f->child_ns : 0;
+    e.alloc      = alloc - f->alloc0;
+    e.self_alloc = e.alloc > f->child_alloc ? e.alloc - f->child_alloc : 0;
+    e.rss_kb     = peak_rss_kb();
+    if (d > 0) {
+        tt_stack[d - 1].child_ns    += e.dur_ns;
+        tt_stack[d - 1].child_alloc += e.alloc;
+    }
+
+    TT_LOCK();
+    if (!g_tt_on) {
+        TT_UNLOCK();
+        free(e.detail);
+        return;
+    }
+    if (g_tt_count == g_tt_cap) {
+        g_tt_cap    = g_tt_cap ? g_tt_cap * 2 : 1024;
+        g_tt_events = realloc(g_tt_events, sizeof(TraceEvent) * g_tt_cap);
+    }
+    g_tt_events[g_tt_count++] = e;
+    TT_UNLOCK();
+}
+
+int time_trace_depth(void) {
+    return tt_depth;
+}
+
+void time_trace_unwind(int depth) {
+    while (tt_depth > depth) time_trace_end();
+}
+
+///  Public: output
+
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20)         fprintf(f, "\\u%04x", c);
+        else                       fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static bool write_trace(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    for (int t = 0; t < g_tt_threads; t++)
+        fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+                   "\"args\":{\"name\":\"%s%.0d\"}},\n",
+                t, t == 0 ? "monad" : "emit ", t);
+    for (size_t i = 0; i < g_tt_count; i++) {
+        const TraceEvent *e = &g_tt_events[i];
+        fprintf(f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                   "\"cat\":\"monad\",\"name\":",
+                e->tid, e->start_ns / 1e3, e->dur_ns / 1e3);
+        json_string(f, e->name);
+        fputs(",\"args\":{", f);
+        if (e->detail) {
+            fputs("\"detail\":", f);
+            json_string(f, e->detail);
+            fputc(',', f);
+        }
+#if defined(TIME_TRACE_ALLOC)
+        fprintf(f, "\"alloc_bytes\":%llu,", (unsigned long long)e->alloc);
+#endif
+        fprintf(f, "\"peak_rss_kb\":%ld}}%s\n", e->rss_kb,
+                i + 1 < g_tt_count ? "," : "");
+    }
+    fputs("]}\n", f);
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+typedef struct {
+    const char *name;
+    size_t      count;
+    uint64_t    self_ns, total_ns;
+    uint64_t    self_alloc;
+    long        rss_kb;
+} PhaseRow;
+
+static int phase_row_cmp(const void *a, const void *b) {
+    const PhaseRow *x = a, *y = b;
+    if (x->self_ns != y->self_ns) return x->self_ns < y->self_ns ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+static void format_bytes(char *buf, size_t n, double bytes) {
+    if      (bytes >= 1024.0 * 1024 * 1024) snprintf(buf, n, "%.1f GB", bytes / (1024.0 * 1024 * 1024));
+    else if (bytes >= 1024.0 * 1024)        snprintf(buf, n, "%.1f MB", bytes / (1024.0 * 1024));
+    else if (bytes >= 1024.0)               snprintf(buf, n, "%.1f KB", bytes / 1024.0);
+    else                                    snprintf(buf, n, "%.0f B", bytes);
+}
+
+static void print_summary(FILE *out, uint64_t wall_ns) {
+    PhaseRow *rows = calloc(g_tt_count ? g_tt_count : 1, sizeof(PhaseRow));
+    size_t    nrows = 0;
+    for (size_t i = 0; i < g_tt_count; i++) {
+        const TraceEvent *e = &g_tt_events[i];
+        PhaseRow *r = NULL;
+        for (size_t k = 0; k < nrows; k++)
+            if (strcmp(rows[k].name, e->name) == 0) { r = &rows[k]; break; }
+        if (!r) { r = &rows[nrows++]; r->name = e->name; }
+        r->count++;
+        r->self_ns    += e->self_ns;
+        r->self_alloc += e->self_alloc;
+        if (!e->nested) r->total_ns += e->dur_ns;
+        if (e->rss_kb > r->rss_kb) r->rss_kb = e->rss_kb;
+    }
+    qsort(rows, nrows, sizeof(PhaseRow), phase_row_cmp);
+
+    fprintf(out, "%-22s %7s %11s %11s %11s %10s\n",
+            "phase", "count", "self ms", "total ms", "self alloc", "peak RSS");
+    for (size_t k = 0; k < nrows; k++) {
+        const PhaseRow *r = &rows[k];
+        char alloc[32] = "-", rss[32] = "-";
+#if defined(TIME_TRACE_ALLOC)
+        format_bytes(alloc, sizeof(alloc), (double)r->self_alloc);
+#endif
+        if (r->rss_kb > 0) format_bytes(rss, sizeof(rss), r->rss_kb * 1024.0);
+        fprintf(out, "%-22s %7zu %11.1f %11.1f %11s %10s\n",
+                r->name, r->count, r->self_ns / 1e6, r->total_ns / 1e6, alloc, rss);
+    }
+    char rss[32] = "-";
+    long peak = peak_rss_kb();
+    if (peak > 0) format_bytes(rss, sizeof(rss), peak * 1024.0);
+    fprintf(out, "%-22s %7s %11s %11.1f %11s %10s\n",
+            "wall", "", "", wall_ns / 1e6, "", rss);
+    free(rows);
+}
+
+bool time_trace_finish(FILE *summary) {
+    if (!g_tt_on) return true;
+    time_trace_unwind(0);
+    uint64_t wall_ns = now_ns() - g_tt_t0;
+
+    TT_LOCK();
+    g_tt_on = false;
+    TT_UNLOCK();
+
+    bool ok = write_trace(g_tt_path);
+    if (summary) {
+        if (ok)
+            fprintf(summary, "[time-trace] %s (%zu spans)\n", g_tt_path, g_tt_count);
+        else
+            fprintf(summary, "[time-trace] could not write %s\n", g_tt_path);
+        print_summary(summary, wall_ns);
+    }
+
+    for (size_t i = 0; i < g_tt_count; i++) free(g_tt_events[i].detail);
+    free(g_tt_events);
+    g_tt_events = NULL;
+    g_tt_count  = g_tt_cap = 0;
+    free(g_tt_path);
+    g_tt_path = NULL;
+    return ok;
+}
@@ -0,0 +1,53 @@
+#ifndef TIME_TRACE_H
+#define TIME_TRACE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+///  Phase tracing (--time-trace)
+//
+//  Scoped wall-clock and memory spans across the compiler pipeline.  Each
+//  span records its start, duration, the bytes its thread allocated and the
+//  process's peak RSS when it closed.  time_trace_finish() writes every span
+//  as a Chrome trace-event file (load it in chrome://tracing or Perfetto)
+//  and prints a per-phase summary.
+//
+//  Spans nest per thread.  Self time and self allocation subtract the
+//  spans nested inside, so a module compiled while its importer is still
+//  parsing is not counted twice.  Emit-pool workers keep their own stacks
+//  and appear as separate threads in the trace.
+//
+//  Allocation bytes come from a counter in the wrapped glibc malloc family,
+//  compiled in only with MONAD_TIME_TRACE_ALLOC outside sanitizer builds;
+//  otherwise the column reads "-".  Every call is a no-op until
+//  time_trace_start().
+//
+//    time_trace_start("Main.time-trace.json");
+//    time_trace_begin("llvm passes", obj_path);
+//    ...
+//    time_trace_end();
+//    time_trace_finish(stderr);
+
+// Starts a session that time_trace_finish() writes to `path`.
+void time_trace_start(const char *path);
+
+bool time_trace_active(void);
+
+// Opens a span on the calling thread.  `name` groups spans in the summary
+// and must outlive the session (a literal); `detail` is copied.
+void time_trace_begin(const char *name, const char *detail);
+
+// Closes the innermost open span on the calling thread.
+void time_trace_end(void);
+
+// Open spans on the calling thread, and closing every span above `depth`,
+// for functions with several return paths.
+int  time_trace_depth(void);
+void time_trace_unwind(int depth);
+
+// Writes the trace file, prints the summary table to `summary` (NULL
+// skips it) and ends the session.  Returns false if the file could not be
+// written.  Call once every worker that records spans has been joined.
+bool time_trace_finish(FILE *summary);
+
+#endif // TIME_TRACE_H
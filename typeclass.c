@@ -2,6 +2,7 @@
 #include "codegen.h"
 #include "env.h"
 #include "types.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -88,6 +89,7 @@ void tc_registry_free(TypeClassRegistry *reg) {
         free(inst->method_symbols);
     }
     free(reg->instances);
+    free(reg->instance_index);
     free(reg);
 }
 
@@ -113,6 +115,7 @@ static void tc_copy_class_into(TypeClassRegistry *dst, const TCClass *src) {
     memset(c, 0, sizeof(*c));
 
     c->name = src->name ? strdup(src->name) : NULL;
+    c->name_key = intern(c->name);
     c->type_var = src->type_var ? strdup(src->type_var) : NULL;
 
     c->superclass_count = src->superclass_count;
@@ -132,6 +135,7 @@ static void tc_copy_class_into(TypeClassRegistry *dst, const TCClass *src) {
     c->methods = malloc(sizeof(TCMethod) * (src->method_count ? src->method_count : 1));
     for (int i = 0; i < src->method_count; i++) {
         c->methods[i].name = src->methods[i].name ? strdup(src->methods[i].name) : NULL;
+        c->methods[i].name_key = intern(c->methods[i].name);
         c->methods[i].type_str = src->methods[i].type_str ? strdup(src->methods[i].type_str) : NULL;
     }
 
@@ -165,6 +169,8 @@ static void tc_copy_instance_into(TypeClassRegistry *dst,
 
     inst->class_name = src->class_name ? strdup(src->class_name) : NULL;
     inst->type_name = src->type_name ? strdup(src->type_name) : NULL;
+    inst->class_key = intern(inst->class_name);
+    inst->type_key  = intern(inst->type_name);
     inst->dict_global = src->dict_global;
 
     inst->assoc_count = src->assoc_count;
@@ -220,12 +226,71 @@ void tc_method_name(const char *class_name, const char *type_name,
 }
 
 /// Lookup
+//
+// Names are compared by their interned pointers.  Registries filled
+// straight from a .mi file leave the keys NULL, so they are interned the
+// first time a lookup needs them.
+
+static const char *tc_class_key(TCClass *c) {
+    if (!c->name_key) c->name_key = intern(c->name);
+    return c->name_key;
+}
+
+static const char *tc_method_key(TCMethod *m) {
+    if (!m->name_key) m->name_key = intern(m->name);
+    return m->name_key;
+}
+
+static void tc_instance_keys(TCInstance *inst) {
+    if (!inst->class_key) inst->class_key = intern(inst->class_name);
+    if (!inst->type_key)  inst->type_key  = intern(inst->type_name);
+}
+
+static size_t tc_instance_slot(const TypeClassRegistry *reg,
+                               const char *class_key, const char *type_key) {
+    uint32_t h = intern_hash(class_key) * 31u ^ intern_hash(type_key);
+    return h & (size_t)(reg->instance_index_cap - 1);
+}
+
+static void tc_instance_index_put(TypeClassRegistry *reg, int i) {
+    TCInstance *inst = &reg->instances[i];
+    tc_instance_keys(inst);
+    if (!inst->class_key || !inst->type_key) return;
+    size_t mask = (size_t)reg->instance_index_cap - 1;
+    for (size_t s = tc_instance_slot(reg, inst->class_key, inst->type_key);;
+         s = (s + 1) & mask) {
+        int j = reg->instance_index[s];
+        if (j < 0) { reg->instance_index[s] = i; return; }
+        // The first registration wins, as with a linear scan.
+        if (reg->instances[j].class_key == inst->class_key &&
+            reg->instances[j].type_key  == inst->type_key)
+            return;
+    }
+}
+
+static void tc_instance_index_sync(TypeClassRegistry *reg) {
+    if (reg->instance_indexed == reg->instance_count) return;
+    if (reg->instance_count * 2 > reg->instance_index_cap) {
+        int cap = reg->instance_index_cap ? reg->instance_index_cap : 64;
+        while (reg->instance_count * 2 > cap) cap *= 2;
+        free(reg->instance_index);
+        reg->instance_index     = malloc(sizeof(int) * cap);
+        reg->instance_index_cap = cap;
+        for (int i = 0; i < cap; i++) reg->instance_index[i] = -1;
+        reg->instance_indexed   = 0;
+    }
+    for (int i = reg->instance_indexed; i < reg->instance_count; i++)
+        tc_instance_index_put(reg, i);
+    reg->instance_indexed = reg->instance_count;
+}
 
 TCClass *tc_find_class(TypeClassRegistry *reg, const char *class_name) {
     if (!reg || !class_name) return NULL;
 
+    const char *key = intern_find(class_name);
+    if (!key) return NULL;
     for (int i = 0; i < reg->class_count; i++)
-        if (strcmp(reg->classes[i].name, class_name) == 0)
+        if (tc_class_key(&reg->classes[i]) == key)
             return &reg->classes[i];
     return NULL;
 }
@@ -234,18 +299,30 @@ TCInstance *tc_find_instance(TypeClassRegistry *reg, const char *class_name,
                              const char *type_name) {
     if (!reg || !class_name || !type_name) return NULL;
 
-    TCInstance *subtype_match = NULL;
+    const char *class_key = intern_find(class_name);
+    if (!class_key) return NULL;
+
+    tc_instance_index_sync(reg);
+    const char *type_key = intern_find(type_name);
+    if (type_key && reg->instance_index_cap) {
+        size_t mask = (size_t)reg->instance_index_cap - 1;
+        for (size_t s = tc_instance_slot(reg, class_key, type_key);;
+             s = (s + 1) & mask) {
+            int j = reg->instance_index[s];
+            if (j < 0) break;
+            if (reg->instances[j].class_key == class_key &&
+                reg->instances[j].type_key  == type_key)
+                return &reg->instances[j];
+        }
+    }
+
     for (int i = 0; i < reg->instance_count; i++) {
         TCInstance *inst = &reg->instances[i];
-        if (strcmp(inst->class_name, class_name) == 0 &&
-            strcmp(inst->type_name,  type_name)  == 0)
-            return inst;
-        if (!subtype_match &&
-            strcmp(inst->class_name, class_name) == 0 &&
+        if (inst->class_key == class_key &&
             type_name_is_subtype(type_name, inst->type_name))
-            subtype_match = inst;
+            return inst;
     }
-    return subtype_match;
+    return NULL;
 }
 
 bool tc_is_method(TypeClassRegistry *reg, const char *method_name) {
@@ -255,10 +332,12 @@ bool tc_is_method(TypeClassRegistry *reg, const char *method_name) {
 const char *tc_method_class(TypeClassRegistry *reg, const char *method_name) {
     if (!reg || !method_name) return NULL;
 
+    const char *key = intern_find(method_name);
+    if (!key) return NULL;
     for (int i = 0; i < reg->class_count; i++) {
         TCClass *c = &reg->classes[i];
         for (int j = 0; j < c->method_count; j++)
-            if (strcmp(c->methods[j].name, method_name) == 0)
+            if (tc_method_key(&c->methods[j]) == key)
                 return c->name;
     }
     return NULL;
@@ -330,6 +409,7 @@ void tc_register_class(TypeClassRegistry *reg, AST *ast, CodegenContext *ctx) {
 
     TCClass *c = &reg->classes[reg->class_count++];
     c->name       = strdup(ast->class_decl.name);
+    c->name_key   = intern(c->name);
     c->type_var   = strdup(ast->class_decl.type_var);
 
     c->superclass_count = ast->class_decl.superclass_count;
@@ -352,6 +432,7 @@ void tc_register_class(TypeClassRegistry *reg, AST *ast, CodegenContext *ctx) {
     c->methods = malloc(sizeof(TCMethod) * (c->method_count ? c->method_count : 1));
     for (int i = 0; i < c->method_count; i++) {
         c->methods[i].name     = strdup(ast->class_decl.method_names[i]);
+        c->methods[i].name_key = intern(c->methods[i].name);
         c->methods[i].type_str = strdup(ast->class_decl.method_types[i]);
     }
 
@@ -519,6 +600,8 @@ void tc_register_instance(TypeClassRegistry *reg, AST *ast,
     TCInstance *inst = &reg->instances[reg->instance_count++];
     inst->class_name   = strdup(class_name);
     inst->type_name    = strdup(type_name);
+    inst->class_key    = intern(inst->class_name);
+    inst->type_key     = intern(inst->type_name);
 
     /* Connect associated values */
     inst->assoc_count  = ast->instance_decl.assoc_count;
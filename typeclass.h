@@ -16,6 +16,7 @@ typedef struct CodegenContext CodegenContext;
 //
 typedef struct TCMethod {
     char *name;      // "=", "!="
+    const char *name_key; // intern(name)
     char *type_str;  // "a -> a -> Bool"
 } TCMethod;
 
@@ -26,6 +27,7 @@ typedef struct TCMethod {
 //
 typedef struct TCClass {
     char      *name;             // "Eq"
+    const char *name_key;        // intern(name)
     char      *type_var;         // "a"
     char     **superclass_names;     // Required parent classes, e.g. ["Eq"] for Ord
     char     **superclass_type_vars; // Usually the same variable as type_var
@@ -53,6 +55,8 @@ typedef struct TCClass {
 typedef struct TCInstance {
     char         *class_name;    // "Monad"
     char         *type_name;     // "Maybe" (constructor name, not applied type)
+    const char   *class_key;     // intern(class_name)
+    const char   *type_key;      // intern(type_name)
     char        **assoc_names;   // e.g. ["Result"]
     char        **assoc_values;  // e.g. ["Float"]
     int           assoc_count;
@@ -76,6 +80,12 @@ typedef struct TypeClassRegistry {
     TCInstance *instances;
     int         instance_count;
     int         instance_cap;
+    /* Open-addressed (class_key, type_key) -> instance slot index, -1 when
+     * empty.  tc_find_instance indexes instances[instance_indexed..] on
+     * demand, so entries appended by any path are picked up. */
+    int        *instance_index;
+    int         instance_index_cap;
+    int         instance_indexed;
 } TypeClassRegistry;
 
 /// Lifecycle
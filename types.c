@@ -315,10 +315,12 @@ static bool finite_members_equal(const FiniteTypeMember *a,
     return strcmp(a->spelling, b->spelling) == 0;
 }
 
-static bool finite_type_set_register_members(const char *name,
-                                             FiniteTypeMember *members,
-                                             size_t member_count) {
+bool finite_type_set_register_members(const char *name,
+                                      FiniteTypeMember *members,
+                                      size_t member_count) {
     if (!name || !members || member_count == 0) return false;
+    for (size_t i = 0; i < member_count; i++)
+        if (!members[i].spelling) return false;
     for (size_t i = 0; i < member_count; i++)
         for (size_t j = 0; j < i; j++)
             if (finite_members_equal(&members[i], &members[j])) return false;
@@ -181,6 +181,9 @@ bool finite_type_set_register(const char *name, const char **members,
                               size_t member_count);
 bool finite_type_set_register_ast(const char *name, struct AST **members,
                                   size_t member_count);
+bool finite_type_set_register_members(const char *name,
+                                      FiniteTypeMember *members,
+                                      size_t member_count);
 const FiniteTypeSetEntry *finite_type_set_lookup(const char *name);
 const FiniteTypeSetEntry *finite_type_set_lookup_member(const char *member,
                                                          size_t *ordinal);
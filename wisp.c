@@ -2,6 +2,8 @@
 #include "compat.h"
 #include "reader.h"
 #include "macro.h"
+#include "intern.h"
+#include "time_trace.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,16 +11,21 @@
 #include <stdbool.h>
 
 /// Arity table
+//
+// Entries are keyed on interned names (intern.h), so a probe costs one
+// intern_find and then pointer compares down the chain.  Names the
+// interner has never seen cannot be in any table, which makes the common
+// miss (a local variable, a literal) a single hash.
 
 typedef struct ArityEntry {
-    char      *name;
+    const char *name;  // interned
     int        arity;
     ParamKind  param_kinds[WISP_MAX_PARAMS];
     int        param_fn_arities[WISP_MAX_PARAMS]; // arity of fn params, -1 if unknown
     struct ArityEntry *next;
 } ArityEntry;
 
-#define ARITY_BUCKETS 128
+#define ARITY_BUCKETS 1024
 
 typedef struct {
     ArityEntry *buckets[ARITY_BUCKETS];
@@ -27,30 +34,35 @@ typedef struct {
 static ArityTable *g_active_wisp_arities = NULL;
 static bool g_wisp_trace_enabled = false;
 
+/* Read once: wts_push asks on every token. */
 static bool wisp_debug_enabled(void) {
-    const char *v = getenv("MONAD_WISP_DEBUG");
-    return v && v[0] && strcmp(v, "0") != 0;
-}
-
-static unsigned int arity_hash(const char *s) {
-    unsigned int h = 5381;
-    if (!s) return 0;
-    while (*s) h = ((h << 5) + h) + (unsigned char)*s++;
-    return h % ARITY_BUCKETS;
+    static int enabled = -1;
+    if (enabled < 0) {
+        const char *v = getenv("MONAD_WISP_DEBUG");
+        enabled = v && v[0] && strcmp(v, "0") != 0;
+    }
+    return enabled;
 }
 
 static bool arity_name_valid(const char *name) {
     return name && name[0] != '\0';
 }
 
+static ArityEntry *arity_find_key(ArityTable *t, const char *key) {
+    for (ArityEntry *e = t->buckets[intern_hash(key) % ARITY_BUCKETS]; e; e = e->next)
+        if (e->name == key) return e;
+    return NULL;
+}
+
 static void arity_set(ArityTable *t, const char *name, int arity) {
     if (!t || !arity_name_valid(name)) return;
 
-    unsigned int h = arity_hash(name);
-    for (ArityEntry *e = t->buckets[h]; e; e = e->next)
-        if (strcmp(e->name, name) == 0) { e->arity = arity; return; }
-    ArityEntry *e = malloc(sizeof(ArityEntry));
-    e->name  = strdup(name);
+    const char *key = intern(name);
+    ArityEntry *e   = arity_find_key(t, key);
+    if (e) { e->arity = arity; return; }
+    unsigned int h = intern_hash(key) % ARITY_BUCKETS;
+    e = malloc(sizeof(ArityEntry));
+    e->name  = key;
     e->arity = arity;
     memset(e->param_kinds, PARAM_VALUE, sizeof(e->param_kinds));
     memset(e->param_fn_arities, -1, sizeof(e->param_fn_arities));
@@ -58,43 +70,33 @@ static void arity_set(ArityTable *t, const char *name, int arity) {
     t->buckets[h] = e;
 }
 
+static ArityEntry *arity_get_entry(ArityTable *t, const char *name) {
+    if (!t || !arity_name_valid(name)) return NULL;
+
+    const char *key = intern_find(name);
+    return key ? arity_find_key(t, key) : NULL;
+}
+
 static void arity_set_with_kinds(ArityTable *t, const char *name, int arity,
                                   const ParamKind *kinds) {
     if (!t || !arity_name_valid(name)) return;
 
     arity_set(t, name, arity);
     if (!kinds) return;
-    unsigned int h = arity_hash(name);
-    for (ArityEntry *e = t->buckets[h]; e; e = e->next)
-        if (strcmp(e->name, name) == 0) {
-            for (int i = 0; i < arity && i < WISP_MAX_PARAMS; i++)
-                e->param_kinds[i] = kinds[i];
-            return;
-        }
+    ArityEntry *e = arity_get_entry(t, name);
+    for (int i = 0; i < arity && i < WISP_MAX_PARAMS; i++)
+        e->param_kinds[i] = kinds[i];
 }
 
 static int arity_get(ArityTable *t, const char *name) {
-    if (!t || !arity_name_valid(name)) return -2;
-
-    unsigned int h = arity_hash(name);
-    for (ArityEntry *e = t->buckets[h]; e; e = e->next)
-        if (strcmp(e->name, name) == 0) return e->arity;
-    return -2; /* unknown */
-}
-
-static ArityEntry *arity_get_entry(ArityTable *t, const char *name) {
-    if (!t || !arity_name_valid(name)) return NULL;
-
-    unsigned int h = arity_hash(name);
-    for (ArityEntry *e = t->buckets[h]; e; e = e->next)
-        if (strcmp(e->name, name) == 0) return e;
-    return NULL;
+    ArityEntry *e = arity_get_entry(t, name);
+    return e ? e->arity : -2; /* unknown */
 }
 
 static void arity_free(ArityTable *t) {
     for (int i = 0; i < ARITY_BUCKETS; i++) {
         ArityEntry *e = t->buckets[i];
-        while (e) { ArityEntry *n = e->next; free(e->name); free(e); e = n; }
+        while (e) { ArityEntry *n = e->next; free(e); e = n; }
         t->buckets[i] = NULL;
     }
 }
@@ -681,12 +683,9 @@ static void arity_prescan(ArityTable *t, const char *source) {
                     if (found_arrow) {
                         arity_set_with_kinds(t, fname, arity, kinds);
                         /* store per-param fn arities */
-                        unsigned int h = arity_hash(fname);
-                        for (ArityEntry *e = t->buckets[h]; e; e = e->next)
-                            if (strcmp(e->name, fname) == 0) {
-                                memcpy(e->param_fn_arities, fn_arities, sizeof(fn_arities));
-                                break;
-                            }
+                        ArityEntry *e = arity_get_entry(t, fname);
+                        if (e)
+                            memcpy(e->param_fn_arities, fn_arities, sizeof(fn_arities));
                     } else {
                         /* define name :: ?  — hole type, treat as arity -1 (unknown) */
                         Lexer _peek = lex;
@@ -1052,6 +1051,10 @@ static char *wisp_rewrite_postfix_index_token(const char *text) {
         }
     }
 
+    /* Only name[digits] is rewritten below; most tokens have no '['. */
+    if (!strchr(text, '['))
+        return strdup(text);
+
     SB out;
     sb_init(&out);
 
@@ -4627,14 +4630,26 @@ static bool wisp_token_is_infix_name(const char *text) {
             strcmp(text, "mod") == 0);
 }
 
-static char *wisp_rewrite_grouped_infix(ArityTable *t, const char *text) {
-    size_t len = strlen(text);
-    if (len < 2 || text[0] != '(' || text[len - 1] != ')')
-        return strdup(text);
+static void wisp_sb_put_range(SB *out, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) sb_putc(out, s[i]);
+}
+
+/* Rewrites `(a op b)` to `(op a b)` at every nesting level, appending the
+ * result to `out`.  Items are split in place and nested groups are
+ * rewritten straight into `out`, so each byte is scanned once per level
+ * and nothing is copied but the op name. */
+static void wisp_rewrite_grouped_infix_into(ArityTable *t, const char *text,
+                                            size_t len, SB *out) {
+    if (len < 2 || text[0] != '(' || text[len - 1] != ')') {
+        wisp_sb_put_range(out, text, len);
+        return;
+    }
 
-    char **items = NULL;
+    typedef struct { const char *start; size_t len; } Item;
+    Item  local[8];
+    Item *items = local;
     int count = 0;
-    int cap = 0;
+    int cap = 8;
     const char *inner = text + 1;
     const char *end = text + len - 1;
     const char *item_start = NULL;
@@ -4671,10 +4686,17 @@ static char *wisp_rewrite_grouped_infix(ArityTable *t, const char *text) {
         if ((c == ' ' || c == '\t' || c == '\n' || c == '\r') && depth == 0) {
             if (item_start) {
                 if (count >= cap) {
-                    cap = cap ? cap * 2 : 8;
-                    items = realloc(items, sizeof(char *) * cap);
+                    cap *= 2;
+                    if (items == local) {
+                        items = malloc(sizeof(Item) * cap);
+                        memcpy(items, local, sizeof(local));
+                    } else {
+                        items = realloc(items, sizeof(Item) * cap);
+                    }
                 }
-                items[count++] = strndup(item_start, (size_t)(p - item_start));
+                items[count].start = item_start;
+                items[count].len   = (size_t)(p - item_start);
+                count++;
                 item_start = NULL;
             }
             continue;
@@ -4684,47 +4706,38 @@ static char *wisp_rewrite_grouped_infix(ArityTable *t, const char *text) {
     }
 
     if (count == 0) {
-        free(items);
-        return strdup(text);
+        wisp_sb_put_range(out, text, len);
+        return;
     }
 
-    char **rewritten = calloc((size_t)count, sizeof(char *));
-    for (int i = 0; i < count; i++) {
-        rewritten[i] = (items[i][0] == '(')
-                           ? wisp_rewrite_grouped_infix(t, items[i])
-                           : strdup(items[i]);
+    char *op = NULL;
+    bool can_rewrite = false;
+    if (count == 3) {
+        op = strndup(items[1].start, items[1].len);
+        int op_arity = wisp_lookup_arity(t, op);
+        can_rewrite =
+            wisp_token_is_infix_name(op) &&
+            (op_arity >= 2 || op_arity == -1 || strcmp(op, "&") == 0);
     }
 
-    int op_arity = count == 3 ? wisp_lookup_arity(t, items[1]) : -2;
-    bool can_rewrite =
-        count == 3 &&
-        wisp_token_is_infix_name(items[1]) &&
-        (op_arity >= 2 || op_arity == -1 || strcmp(items[1], "&") == 0);
-
-    SB out;
-    sb_init(&out);
-    sb_putc(&out, '(');
+    sb_putc(out, '(');
     if (can_rewrite) {
-        sb_puts(&out, items[1]);
-        sb_putc(&out, ' ');
-        sb_puts(&out, rewritten[0]);
-        sb_putc(&out, ' ');
-        sb_puts(&out, rewritten[2]);
+        sb_puts(out, op);
+        sb_putc(out, ' ');
+        wisp_rewrite_grouped_infix_into(t, items[0].start, items[0].len, out);
+        sb_putc(out, ' ');
+        wisp_rewrite_grouped_infix_into(t, items[2].start, items[2].len, out);
     } else {
         for (int i = 0; i < count; i++) {
-            if (i) sb_putc(&out, ' ');
-            sb_puts(&out, rewritten[i]);
+            if (i) sb_putc(out, ' ');
+            wisp_rewrite_grouped_infix_into(t, items[i].start, items[i].len, out);
         }
     }
-    sb_putc(&out, ')');
+    sb_putc(out, ')');
 
-    for (int i = 0; i < count; i++) {
-        free(items[i]);
-        free(rewritten[i]);
-    }
-    free(items);
-    free(rewritten);
-    return sb_take(&out);
+    free(op);
+    if (items != local)
+        free(items);
 }
 
 static int g_infix_fence = -1; /* stream pos: infix promotion stops before this */
@@ -5906,10 +5919,7 @@ static WTokenStream build_token_stream(const char *source, ArityTable *at) {
                             }
                         }
                         if (found_def) {
-                            unsigned int _h = arity_hash(def_name);
-                            ArityEntry *_de = NULL;
-                            for (ArityEntry *_e = at->buckets[_h]; _e; _e = _e->next)
-                                if (strcmp(_e->name, def_name) == 0) { _de = _e; break; }
+                            ArityEntry *_de = arity_get_entry(at, def_name);
                             if (_de) {
                                 /* Walk pattern tokens and assign arities */
                                 const char *_ps = lscan;
@@ -10906,9 +10916,7 @@ static void wisp_parse_expr(ArityTable *t, WTokenStream *s, SB *out, int parent_
         } else {
             if (is_grouped && text[0] == '(' &&
                 !wisp_group_contains_quote_form(text)) {
-                char *rewritten = wisp_rewrite_grouped_infix(t, text);
-                sb_puts(&prefix_sb, rewritten);
-                free(rewritten);
+                wisp_rewrite_grouped_infix_into(t, text, strlen(text), &prefix_sb);
             } else {
                 sb_puts(&prefix_sb, text);
             }
@@ -11047,25 +11055,25 @@ static void wisp_parse_expr(ArityTable *t, WTokenStream *s, SB *out, int parent_
 
 void wisp_register_arities_from_env(Env *env) {
     for (size_t i = 0; i < env->size; i++) {
-        for (EnvEntry *e = env->buckets[i]; e; e = e->next) {
-            if (e->kind != ENV_BUILTIN && e->kind != ENV_FUNC) continue;
-            int arity;
-            if (e->arity_max == -1) {
-                arity = -1;
-            } else if (e->arity_max == 0) {
-                arity = e->arity_min;
-            } else {
-                arity = e->arity_max;
-            }
-            if (strcmp(e->name, "show") == 0)
-                arity = 1;
+        EnvEntry *e = env->slots[i];
+        if (!e) continue;
+        if (e->kind != ENV_BUILTIN && e->kind != ENV_FUNC) continue;
+        int arity;
+        if (e->arity_max == -1) {
+            arity = -1;
+        } else if (e->arity_max == 0) {
+            arity = e->arity_min;
+        } else {
+            arity = e->arity_max;
+        }
+        if (strcmp(e->name, "show") == 0)
+            arity = 1;
 
-            if (!g_ffi_arities_init) {
-                memset(&g_ffi_arities, 0, sizeof(g_ffi_arities));
-                g_ffi_arities_init = true;
-            }
-            arity_set_with_kinds(&g_ffi_arities, e->name, arity, e->param_kinds);
+        if (!g_ffi_arities_init) {
+            memset(&g_ffi_arities, 0, sizeof(g_ffi_arities));
+            g_ffi_arities_init = true;
         }
+        arity_set_with_kinds(&g_ffi_arities, e->name, arity, e->param_kinds);
     }
 }
 
@@ -11599,6 +11607,15 @@ static char *wisp_fraction_group_operand(const char *src) {
 }
 
 static char *desugar_fractions(char *source) {
+    /* No fraction bar: the rejoin below would only drop one trailing
+     * newline, so do just that instead of splitting every line. */
+    if (!strstr(source, "\xE2\x94\x80")) {
+        size_t len = strlen(source);
+        if (len > 0 && source[len - 1] == '\n')
+            source[len - 1] = '\0';
+        return source;
+    }
+
     int line_count = 0;
     int cap = 16;
     char **lines = malloc(sizeof(char*) * cap);
@@ -11787,6 +11804,10 @@ static void wisp_normalize_newlines_in_place(char *source) {
  * Wisp's indentation grammar a concise, extensible surface syntax.
  */
 static char *desugar_contextual_law_checks(char *source) {
+    /* Every rewrite below starts at a "laws " or "seeded " line. */
+    if (!strstr(source, "laws ") && !strstr(source, "seeded "))
+        return source;
+
     SB out;
     sb_init(&out);
     const char *cursor = source;
@@ -11854,6 +11875,7 @@ static char *desugar_contextual_law_checks(char *source) {
 }
 
 ASTList wisp_parse_all(const char *source, const char *filename) {
+    time_trace_begin("wisp", filename);
     wisp_pending_type_clear();
 
     /* Commentary sections are documentation, not code. Strip them before
@@ -11891,10 +11913,15 @@ ASTList wisp_parse_all(const char *source, const char *filename) {
         if (*p) p++;
     }
     if (!has_wisp) {
+        time_trace_end();
         g_is_known_function = pure_is_known_function;
         parser_set_context(filename, stripped);
+        time_trace_begin("parse", filename);
         ASTList result = parse_all(stripped);
+        time_trace_end();
+        time_trace_begin("macro expand", filename);
         result = macro_expand_all(result.exprs, result.count);
+        time_trace_end();
         g_is_known_function = NULL;
         free(stripped);
         return result;
@@ -11957,6 +11984,13 @@ ASTList wisp_parse_all(const char *source, const char *filename) {
 
     char *transformed = sb_take(&out);
 
+    /* The reader only sees `transformed` (and `source`, for comments);
+     * drop the intermediate copies before it builds the ASTs, so a large
+     * module never holds all of them at once. */
+    free(stripped);
+    stripped = NULL;
+    wts_free(&s);
+
     if (g_wisp_trace_enabled) {
         fprintf(stderr, "\n=== wisp expanded (%s) ===\n%s\n=== end ===\n\n",
                 filename ? filename : "<input>", transformed);
@@ -11979,18 +12013,20 @@ ASTList wisp_parse_all(const char *source, const char *filename) {
     g_param_kind_is_func  = wisp_param_kind_is_func;
     g_is_known_function   = wisp_is_known_function;
 
-    parser_set_context(filename, transformed);
-    parser_set_original_source(source);
+    time_trace_end();
+    parser_set_lowered_context(filename, transformed, source);
+    time_trace_begin("parse", filename);
     ASTList result = parse_all(transformed);
+    time_trace_end();
+    time_trace_begin("macro expand", filename);
     result = macro_expand_all(result.exprs, result.count);
+    time_trace_end();
 
     g_param_kind_is_func  = NULL;
     g_is_known_function   = NULL;
     g_active_wisp_arities = NULL;
 
     free(transformed);
-    free(stripped);
-    wts_free(&s);
 
     // Persist all discovered arities back into g_ffi_arities so that
     // modules imported later inherit everything this module knew about,